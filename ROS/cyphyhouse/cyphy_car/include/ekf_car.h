@@ -9,6 +9,10 @@
  *  Author: Joao Paulo Jansch Porto <janschp2(at)illinois.edu>
  *
  *  Changelog:
+ *      v0.7 - Sparse covariance propagation in the predict, one sincos per step
+ *      v0.6 - Selector-matrix IMU/position updates with Cholesky solves
+ *      v0.5 - Public dt-scaled process noise and position update with covariance for the fusion core
+ *      v0.4 - Templated on scalar type, same precision policy as the TDOA filter
  *      v0.3 - Added extra library functions (06/26/2017)
  *      v0.2 - initial release (06/19/2017)
  *
@@ -37,6 +41,10 @@
 
 #define MAX_NR_ANCHORS 8
 
+#define CAR_WHEELBASE 0.33 // m, distance between front and rear axle
+
+#define PROCESS_NOISE_STEP 0.01 // s, time step the process noise matrix Q is given for
+
 #define MAX_COVARIANCE 100
 #define MIN_COVARIANCE 1e-6f
 
@@ -47,18 +55,29 @@ typedef struct vec3d_s
     double   z;
 }vec3d_t;
 
-class EKF
+/*
+ * Scalar selects the precision of state, covariance and all intermediate math,
+ * as in TDOAFilter. ekf_car.cpp instantiates float and double.
+ */
+template <typename Scalar = double>
+class EKFCar
 {
 public:
     
+    typedef Eigen::Matrix<Scalar, STATE_DIM, 1> StateVector;
+    typedef Eigen::Matrix<Scalar, STATE_DIM, STATE_DIM> StateMatrix;
+    typedef Eigen::Matrix<Scalar, 1, STATE_DIM> MeasurementRow;
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> DynamicMatrix;
+    typedef Eigen::Matrix<Scalar, 3, 3> PositionCovariance;
+    
     // Contructor
-    EKF();
-    EKF(const Eigen::MatrixXf transition_mat, const Eigen::MatrixXd prediction_mat, const Eigen::MatrixXd covariance_mat, const vec3d_t init_pos);
+    EKFCar();
+    EKFCar(const DynamicMatrix &transition_mat, const DynamicMatrix &prediction_mat, const DynamicMatrix &covariance_mat, const vec3d_t init_pos);
     
     // Set Functions
-    void setTransitionMat(const Eigen::MatrixXd transition_mat);
-    void setPredictionMat(const Eigen::MatrixXd prediction_mat);
-    void setCovarianceMat(const Eigen::MatrixXd covariance_mat);
+    void setTransitionMat(const DynamicMatrix &transition_mat);
+    void setPredictionMat(const DynamicMatrix &prediction_mat);
+    void setCovarianceMat(const DynamicMatrix &covariance_mat);
     
     void setAncPosition(const int anc_num, const vec3d_t anc_pos);
     void setAncPosition(const int anc_num, const double x, const double y, const double z);
@@ -71,7 +90,9 @@ public:
     void scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff);
     void IMUUpdate(double gyro, double acc);
     void ViconUpdate(double x, double y, double z);
+    void PositionUpdate(double x, double y, double z, const PositionCovariance &R);
     void stateEstimatorPredict(const double dt, const double u1, const double u2);
+    void stateEstimatorAddProcessNoise(const double dt);
     
     
     // Get functions
@@ -80,31 +101,41 @@ public:
     double getAngle();
     vec3d_t getAncPosition(const int anc_num);
     
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    
 private:
     
     //variables
     uint32_t tdoaCount;
-    uint32_t nr_states;
-    double stdDevTDOA, stdDevGyro, stdDevAcc;
+    Scalar stdDevTDOA, stdDevGyro, stdDevAcc;
     
     vec3d_t anchorPosition[MAX_NR_ANCHORS];
     
     // Matrices used by the kalman filter
-    Eigen::VectorXd S;
-    Eigen::MatrixXd P;
-    Eigen::MatrixXd A;
-    Eigen::MatrixXd Q;
+    StateVector S;
+    StateMatrix P;
+    StateMatrix A;
+    StateMatrix Q;
+    // A is the identity but the Jacobian entries, see propagateCovariance
+    bool sparseTransition;
     
     //Functions
-    void stateEstimatorScalarUpdate(Eigen::RowVectorXf H, double error, double stdMeasNoise);
+    void stateEstimatorScalarUpdate(const MeasurementRow &H, Scalar error, Scalar stdMeasNoise);
+    template <int M>
+    void stateEstimatorUpdate(const Eigen::Matrix<Scalar, M, STATE_DIM> &H, const Eigen::Matrix<Scalar, M, 1> &error, const Eigen::Matrix<Scalar, M, M> &R);
+    template <int M>
+    void stateEstimatorSelectorUpdate(const int (&idx)[M], const Eigen::Matrix<Scalar, M, 1> &error, const Eigen::Matrix<Scalar, M, M> &R);
     
-    void stateEstimatorAddProcessNoise();
     void stateEstimatorFinalize();
     
+    static bool jacobianEntry(int r, int c);
+    void propagateCovariance();
     void PredictionBound();
-    double AngleBound(const double angle);
+    Scalar AngleBound(const Scalar angle);
 
 };
 
-#endif
+// Default engine used by the estimator node
+typedef EKFCar<double> EKF;
 
+#endif
@@ -0,0 +1,112 @@
+/*************************************************
+ *
+ *  Event-driven multi-rate fusion around the car EKF.
+ *  Every input (control, IMU, Vicon, decaPos pose, raw TDOA) is a stamped
+ *  measurement. The filter is predicted exactly to each stamp, with the
+ *  control input that was active at that time, and then updated.
+ *
+ *  Measurements that arrive out of order are handled with a short history:
+ *  before each measurement is applied the filter is saved, so a late one
+ *  rolls back to the last state before its stamp and everything after it
+ *  is re-applied in order. Anything older than the history is dropped.
+ *
+ *  All calls are expected from one thread (the ROS spinner), so nothing is
+ *  locked.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FUSION_CORE_h
+#define _FUSION_CORE_h
+
+#include <cstdint>
+#include <deque>
+#include <Eigen/Dense>
+#include <Eigen/StdDeque>
+
+#include "ekf_car.h"
+
+#define FUSION_HISTORY_LEN 0.25 // s, how late a measurement may arrive
+#define FUSION_MAX_STEP    0.01 // s, longest single prediction step
+
+typedef enum
+{
+    FUSION_CONTROL = 0,     // value: speed, steering angle. Held until the next control
+    FUSION_IMU,             // value: yaw rate, forward acceleration
+    FUSION_VICON,           // value: x, y, z
+    FUSION_POSITION,        // value: x, y, z with covariance, e.g. decaPose
+    FUSION_TDOA,            // value[0]: distance difference between anchors Ar and An
+} fusion_meas_type_t;
+
+typedef struct fusion_meas_s
+{
+    double  stamp;          // s, time of validity
+    fusion_meas_type_t type;
+    double  value[3];
+    double  cov[6];         // FUSION_POSITION only, upper triangle xx, xy, xz, yy, yz, zz
+    uint8_t Ar;
+    uint8_t An;
+}fusion_meas_t;
+
+template <typename Scalar = double>
+class FusionCore
+{
+public:
+
+    typedef EKFCar<Scalar> Filter;
+
+    explicit FusionCore(const Filter &initial, double history_len = FUSION_HISTORY_LEN);
+
+    // Applies a measurement in time order. False if it is older than the history and was dropped
+    bool add(const fusion_meas_t &meas);
+
+    // Copy of the filter predicted to t (not before the last measurement), the core itself is not changed
+    Filter stateAt(double t) const;
+
+    Filter filter() const { return current.filter; }
+    double getTime() const { return current.time; }
+    uint32_t getDropCount() const { return drops; }
+    uint32_t getRollbackCount() const { return rollbacks; }
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+    // Everything a rollback has to restore
+    struct Snapshot
+    {
+        Filter filter;
+        double time;
+        bool timeValid;
+        double control[2];
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    // A measurement that was applied, with the state just before it
+    struct HistoryEntry
+    {
+        fusion_meas_t meas;
+        Snapshot before;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    static void predictTo(Snapshot &s, double t);
+    static void apply(Snapshot &s, const fusion_meas_t &meas);
+    void applyAndRecord(const fusion_meas_t &meas);
+
+    Snapshot current;
+    std::deque<HistoryEntry, Eigen::aligned_allocator<HistoryEntry> > history;
+    double historyLen;
+
+    uint32_t drops;
+    uint32_t rollbacks;
+};
+
+// Default engine used by the estimator node
+typedef FusionCore<double> Fusion;
+
+#endif
@@ -0,0 +1,50 @@
+/*************************************************
+ *
+ *  Positioning stage of the closed-loop car simulation (car_sim): the
+ *  synthetic TDOA stream of decawave (TDOASimulator) for the true position
+ *  of the car, run through the TDOA filter of the positioning node. Only
+ *  plain types cross this header, tdoa.h and ekf_car.h both define vec3d_t
+ *  and STATE_DIM and cannot be included into the same file.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _SIM_POSITIONING_h
+#define _SIM_POSITIONING_h
+
+#include <cstdint>
+#include <memory>
+
+#define SIM_MAX_ANCHORS 8
+
+typedef struct sim_position_s
+{
+    double t;               // s
+    double pos[3];          // m
+    double cov[6];          // Upper triangle xx, xy, xz, yy, yz, zz, as fusion_meas_t
+}sim_position_t;
+
+class SimPositioning
+{
+public:
+
+    // count anchors at anchors[i] = x, y, z, measurements of the default decawave simulation with seed
+    SimPositioning(const double anchors[][3], int count, unsigned seed);
+    ~SimPositioning();
+
+    // Length of one TDMA slot, s
+    double slotTime() const;
+    double getTime() const;
+
+    // Advances one TDMA slot with the tag at pos. True if a TDMA rotation ended and the filter has a position for it
+    bool step(const double pos[3], sim_position_t &out);
+
+private:
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+#endif
@@ -0,0 +1,332 @@
+/*************************************************
+ *
+ *  Microbenchmarks of the hot paths of the car stack: the EKF of the
+ *  estimator, the MPC of cyphy_car_mpc, cyphy_car_mpc2 and rrt_car and the
+ *  cubic fit of cyphy_car_mpc2. The inputs are the poses of a recorded
+ *  trajectory (TrajectoryRecorder, record_trajectory of the waypoint nodes),
+ *  or of a simulated circle without one. The TDOA filter, checksum and frame
+ *  decoding of the tag link are in tdoa_microbench of decawave.
+ *
+ *  Usage: cyphyhouse_bench [trajectory] [--json <file>] [--min-time <s>]
+ *
+ *************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <new>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "ekf_car.h"
+#include "CubicFit.h"
+#include "cyphy_control/CarMpc.h"
+#include "cyphy_control/CostTerms.h"
+#include "cyphy_control/MicroBench.h"
+
+#define POSE_DT         0.01    // s, Vicon rate of the simulated circle
+#define CIRCLE_RADIUS   1.0     // m
+#define CIRCLE_SPEED    1.0     // m/s
+#define CIRCLE_POSES    2000
+#define MAX_POSES       20000   // Of a recording, one sample in every stride is kept beyond
+#define INPUTS          64      // Fixed inputs each case steps through
+#define LOOKAHEAD       50      // Poses from the car to its waypoint
+#define FIT_POINTS      20      // Path points of a cubic fit
+
+typedef struct pose_s
+{
+    double t;       // s
+    double x, y, psi;
+}pose_t;
+
+// Heap allocations of the whole process, Ipopt and CppAD included, to report those of every MPC solve
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+// Mean heap allocations of solve(i) over INPUTS calls, after a round of them has sized the buffers
+template <class Solve>
+static double allocationsPerCall(Solve solve)
+{
+    for (uint64_t i = 0; i < INPUTS; i++)
+    {
+        solve(i);
+    }
+    const uint64_t before = allocations.load();
+    for (uint64_t i = 0; i < INPUTS; i++)
+    {
+        solve(i);
+    }
+    return double(allocations.load() - before) / INPUTS;
+}
+
+// Lab layout (anchorPos_hotdec.txt)
+static const double ANCHORS[MAX_NR_ANCHORS][3] = {
+    {4.495, 0.600, 2.181}, {0.155, 0.190, 2.190}, {4.498, 4.342, 2.174}, {0.155, 4.240, 2.179},
+    {4.498, 0.670, 0.180}, {0.159, 0.780, 0.175}, {4.500, 4.332, 0.180}, {0.159, 4.360, 0.175}};
+
+// x and y of the first two fields of every sample, the layout of TrajectoryRecorder
+static bool loadTrajectory(const std::string &path, std::vector<pose_t> &poses)
+{
+    gzFile gz = gzopen(path.c_str(), "rb");
+    if (!gz)
+    {
+        return false;
+    }
+    char line[1024];
+    size_t fields = 0;
+    bool valid = gzgets(gz, line, sizeof(line)) && (strcmp(line, "CYTRJ1\n") == 0);
+    while (valid && gzgets(gz, line, sizeof(line)) && (strcmp(line, "\n") != 0))
+    {
+        if (strncmp(line, "fields: ", 8) == 0)
+        {
+            fields = 0;
+            for (const char *c = line; *c; c++)
+            {
+                fields += (*c == ',');
+            }
+        }
+    }
+    if (!valid || (fields < 2) || (fields > 8))
+    {
+        gzclose(gz);
+        return false;
+    }
+
+    std::vector<pose_t> all;
+    uint32_t n;
+    while (gzread(gz, &n, sizeof(n)) == (int)sizeof(n))
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int64_t stamp;
+            double values[8];
+            if ((gzread(gz, &stamp, sizeof(stamp)) != (int)sizeof(stamp)) ||
+                (gzread(gz, values, fields * sizeof(double)) != (int)(fields * sizeof(double))))
+            {
+                break;
+            }
+            pose_t p = {stamp * 1e-9, values[0], values[1], 0};
+            all.push_back(p);
+        }
+    }
+    gzclose(gz);
+
+    const size_t stride = all.size() / MAX_POSES + 1;
+    for (size_t i = 0; i < all.size(); i += stride)
+    {
+        poses.push_back(all[i]);
+    }
+    return poses.size() > LOOKAHEAD + FIT_POINTS;
+}
+
+static void simulateCircle(std::vector<pose_t> &poses)
+{
+    for (int i = 0; i < CIRCLE_POSES; i++)
+    {
+        const double a = CIRCLE_SPEED / CIRCLE_RADIUS * POSE_DT * i;
+        pose_t p = {POSE_DT * i, 2.3 + CIRCLE_RADIUS * cos(a), 2.3 + CIRCLE_RADIUS * sin(a), 0};
+        poses.push_back(p);
+    }
+}
+
+// Heading along the path, the recordings only hold positions
+static void setHeadings(std::vector<pose_t> &poses)
+{
+    for (size_t i = 0; i + 1 < poses.size(); i++)
+    {
+        poses[i].psi = atan2(poses[i + 1].y - poses[i].y, poses[i + 1].x - poses[i].x);
+    }
+    poses.back().psi = poses[poses.size() - 2].psi;
+}
+
+static double anchorDistance(const pose_t &p, int a)
+{
+    return std::sqrt(std::pow(p.x - ANCHORS[a][0], 2) + std::pow(p.y - ANCHORS[a][1], 2) + std::pow(ANCHORS[a][2], 2));
+}
+
+// Waypoints and fitted paths are in the frame of the car at pose i, as the controllers see them
+static void toCar(const pose_t &car, const pose_t &p, double &x, double &y)
+{
+    const double dx = p.x - car.x, dy = p.y - car.y;
+    x = dx * cos(car.psi) + dy * sin(car.psi);
+    y = -dx * sin(car.psi) + dy * cos(car.psi);
+}
+
+static void usage()
+{
+    printf("Usage: cyphyhouse_bench [trajectory] [--json file] [--min-time s]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::string trajectoryFile, jsonFile;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--json") && (i + 1 < argc))
+        {
+            jsonFile = argv[++i];
+        }
+        else if ((arg == "--min-time") && (i + 1 < argc))
+        {
+            minTime = atof(argv[++i]);
+        }
+        else if ((arg[0] != '-') && trajectoryFile.empty())
+        {
+            trajectoryFile = arg;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<pose_t> poses;
+    if (trajectoryFile.empty())
+    {
+        simulateCircle(poses);
+    }
+    else if (!loadTrajectory(trajectoryFile, poses))
+    {
+        printf("Could not read trajectory %s\n", trajectoryFile.c_str());
+        return 1;
+    }
+    setHeadings(poses);
+    const size_t usable = poses.size() - LOOKAHEAD - FIT_POINTS;
+    printf("%zu poses of %s\n", poses.size(), trajectoryFile.empty() ? "a simulated circle" : trajectoryFile.c_str());
+
+    // Fixed inputs, spread over the trajectory
+    std::vector<size_t> at(INPUTS);
+    for (size_t k = 0; k < INPUTS; k++)
+    {
+        at[k] = k * usable / INPUTS;
+    }
+    std::vector<std::vector<double> > waypoint(INPUTS), crossTrack(INPUTS), reference(INPUTS);
+    std::vector<Eigen::Vector4d> coeffs(INPUTS);
+    const CarProblem defaults;
+    for (size_t k = 0; k < INPUTS; k++)
+    {
+        const pose_t &car = poses[at[k]];
+        double x, y;
+        toCar(car, poses[at[k] + LOOKAHEAD], x, y);
+        waypoint[k] = {x, y};
+
+        CubicFit fit;
+        for (size_t j = 0; j < FIT_POINTS; j++)
+        {
+            toCar(car, poses[at[k] + LOOKAHEAD * j / FIT_POINTS], x, y);
+            fit.add(x, y);
+        }
+        coeffs[k] = fit.solve();
+        crossTrack[k] = {coeffs[k][0], coeffs[k][1], coeffs[k][2], coeffs[k][3], coeffs[k][0], -atan(coeffs[k][1])};
+
+        reference[k].resize(2 * defaults.N);
+        for (size_t j = 0; j < defaults.N; j++)
+        {
+            toCar(car, poses[at[k] + LOOKAHEAD * (j + 1) / defaults.N], reference[k][j], reference[k][defaults.N + j]);
+        }
+    }
+
+    MicroBench bench(minTime);
+
+    EKF ekf;
+    for (int a = 0; a < MAX_NR_ANCHORS; a++)
+    {
+        ekf.setAncPosition(a, ANCHORS[a][0], ANCHORS[a][1], ANCHORS[a][2]);
+    }
+    vec3d_t init = {poses[0].x, poses[0].y, 0};
+    ekf.setInitPos(init);
+    bench.run("EKF::stateEstimatorPredict", [&](uint64_t i) {
+        const pose_t &p = poses[at[i % INPUTS]];
+        ekf.stateEstimatorPredict(POSE_DT, 0, 0.1 * sin(p.psi));
+        ekf.stateEstimatorAddProcessNoise(POSE_DT);
+    });
+    // The vector updates go through the selector update, which replaced stateEstimatorUpdate
+    const EKF::PositionCovariance R = EKF::PositionCovariance::Identity() * 1e-4;
+    bench.run("EKF::PositionUpdate", [&](uint64_t i) {
+        const pose_t &p = poses[at[i % INPUTS]];
+        ekf.PositionUpdate(p.x, p.y, 0, R);
+    });
+    bench.run("EKF::scalarTDOADistUpdate", [&](uint64_t i) {
+        const pose_t &p = poses[at[(i / MAX_NR_ANCHORS) % INPUTS]];
+        const int Ar = i % MAX_NR_ANCHORS, An = (i + 1) % MAX_NR_ANCHORS;
+        ekf.scalarTDOADistUpdate(Ar, An, anchorDistance(p, An) - anchorDistance(p, Ar));
+    });
+    MicroBench::keep(ekf.getLocation());
+
+    bench.run("CubicFit::solve", [&](uint64_t i) {
+        const size_t k = at[i % INPUTS];
+        CubicFit fit;
+        for (size_t j = 0; j < FIT_POINTS; j++)
+        {
+            fit.add(poses[k + j].x, poses[k + j].y);
+        }
+        MicroBench::keep(fit.solve());
+    });
+    bench.run("CubicFit::eval", [&](uint64_t i) {
+        MicroBench::keep(CubicFit::eval(coeffs[i % INPUTS], 0.01 * (i % 100)));
+    });
+
+    // The weights of the MpcProblem of each package
+    CarMpc::Terms waypointTerms, crossTrackTerms, referenceTerms;
+    waypointTerms.emplace_back(new WaypointCost(400, 400));
+    waypointTerms.emplace_back(new InputCost(200, 250, 50, 200));
+    crossTrackTerms.emplace_back(new CrossTrackCost(1, 1, defaults.dt, defaults.lr));
+    crossTrackTerms.emplace_back(new InputCost(200, 250, 50, 200));
+    referenceTerms.emplace_back(new ReferenceCost(50, 50));
+    referenceTerms.emplace_back(new InputCost(10, 25, 5, 20));
+    CarProblem crossTrackProblem, referenceProblem;
+    crossTrackProblem.x_bound = crossTrackProblem.y_bound = 1.0e19;
+    referenceProblem.lr = 0.33;
+
+    CarMpc waypointMpc(defaults, waypointTerms, "cyphy_car_mpc");
+    CarMpc crossTrackMpc(crossTrackProblem, crossTrackTerms, "cyphy_car_mpc2");
+    CarMpc referenceMpc(referenceProblem, referenceTerms, "rrt_car");
+    // Into one Solution each, as the solver threads of the nodes do, and the allocations left per solve. CarMpc
+    // makes none of its own then, those counted are of Ipopt and the CppAD sweeps
+    CarMpc::Solution solution;
+    const struct
+    {
+        const char *name;
+        CarMpc *mpc;
+        const std::vector<std::vector<double> > *inputs;
+    } solves[] = {{"MPC::Solve/waypoint", &waypointMpc, &waypoint},
+                  {"MPC::Solve/cross_track", &crossTrackMpc, &crossTrack},
+                  {"MPC::Solve/reference", &referenceMpc, &reference}};
+    for (const auto &c : solves)
+    {
+        const auto solve = [&](uint64_t i) {
+            const std::vector<double> &params = (*c.inputs)[i % INPUTS];
+            c.mpc->Solve(0, 0, 0, params.data(), params.size(), solution);
+            MicroBench::keep(solution.delta);
+        };
+        bench.run(c.name, solve);
+        printf("%-36s %12.1f heap allocations per solve\n", c.name, allocationsPerCall(solve));
+    }
+
+    if (!jsonFile.empty() && !bench.write_json(jsonFile, argv[0]))
+    {
+        printf("Could not write %s\n", jsonFile.c_str());
+        return 1;
+    }
+    return 0;
+}
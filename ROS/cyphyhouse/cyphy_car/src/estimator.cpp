@@ -1,102 +1,237 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
-#include <thread>
 #include <ctime>
 #include <cstdbool>
 #include <fstream>
+#include <memory>
 
 #include "ekf_car.h"
+#include "fusion_core.h"
 
 #include "ros/ros.h"
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include <std_msgs/String.h>
+#include "geometry_msgs/Pose.h"
 #include "geometry_msgs/PoseStamped.h"
 #include "geometry_msgs/PointStamped.h"
+#include "geometry_msgs/PoseWithCovarianceStamped.h"
+#include "geometry_msgs/TwistStamped.h"
+#include "sensor_msgs/Imu.h"
 #include <ackermann_msgs/AckermannDriveStamped.h>
 #include "ros/package.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Metrics.h"
 
-#define EKF_RATE 100 //Hz
 #define PRINT_RATE 100 //Hz
+#define FUSION_TYPES (FUSION_TDOA + 1)
 
+/*
+ * All callbacks run on one thread and hand their stamped measurement to the
+ * fusion core, which orders them and predicts to each stamp. No mutex; the
+ * subscriptions and timers share a CallbackThread of their own (sensor_priority,
+ * sensor_cpus), so the measurements never wait behind the callbacks of the
+ * other nodelets in the manager.
+ */
+Fusion *fusion;
 
-double v_in, phi_in;
+ros::Publisher state_pub, vel_pub;
 
-//std::string bot_num, vicon_obj;
+std::string vicon_obj, deca_topic;
+bool use_vicon, use_deca;
 
-EKF car_ekf;
-std::mutex ekf_mutex;
-std::thread ekf_thread;
-
-ros::Publisher state_pub;
+// Served on metrics_port, indexed by fusion_meas_t type
+MetricCounter *meas_metric[FUSION_TYPES];
+MetricHistogram *publish_metric;
+MetricGauge *drops_metric, *rollbacks_metric;
 
+void addMeasurement(const fusion_meas_t &meas)
+{
+    meas_metric[meas.type]->add();
+    addMeasurement(meas);
+}
 
-std::string dir_path;
-char time_buffer[80];
 
+// Messages without a stamp are taken as received now
+double stampOf(const ros::Time &stamp)
+{
+    return stamp.isZero() ? ros::Time::now().toSec() : stamp.toSec();
+}
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
 {
-    geometry_msgs::Point point = pose.pose.position;
-    
-    ekf_mutex.lock();
-    car_ekf.ViconUpdate(point.x, point.y, point.z);
-    ekf_mutex.unlock();
+    fusion_meas_t meas;
+    meas.stamp = stampOf(pose.header.stamp);
+    meas.type = FUSION_VICON;
+    meas.value[0] = pose.pose.position.x;
+    meas.value[1] = pose.pose.position.y;
+    meas.value[2] = pose.pose.position.z;
+    addMeasurement(meas);
 }
 
-void getIMUdata()
+void getDecaPosition(const geometry_msgs::PoseWithCovarianceStamped& pose)
 {
-    ekf_mutex.lock();
-    car_ekf.IMUUpdate(gyro, acc);
-    ekf_mutex.unlock();
+    fusion_meas_t meas;
+    meas.stamp = stampOf(pose.header.stamp);
+    meas.type = FUSION_POSITION;
+    meas.value[0] = pose.pose.pose.position.x;
+    meas.value[1] = pose.pose.pose.position.y;
+    meas.value[2] = pose.pose.pose.position.z;
+    
+    // Position block of the row-major 6x6 pose covariance
+    const int idx[6] = {0, 1, 2, 7, 8, 14};
+    for (int i = 0; i < 6; i++)
+    {
+        meas.cov[i] = pose.pose.covariance[idx[i]];
+    }
+    addMeasurement(meas);
 }
 
-void getInputs(const AckermannMsgPtr& cmd)
+void getIMUdata(const sensor_msgs::Imu& imu)
 {
-    v_in = cmd->drive.speed;
-    theta_in = cmd->drive.steering_angle;
+    fusion_meas_t meas;
+    meas.stamp = stampOf(imu.header.stamp);
+    meas.type = FUSION_IMU;
+    meas.value[0] = imu.angular_velocity.z;
+    meas.value[1] = imu.linear_acceleration.x;
+    addMeasurement(meas);
 }
 
-/* Idea: add measurements to a vector (or augment matrix), and only update ekf once after the prediction step */
-void estimator()
+void getInputs(const ackermann_msgs::AckermannDriveStamped& cmd)
 {
-    ros::Rate r(EKF_RATE);
+    fusion_meas_t meas;
+    meas.stamp = stampOf(cmd.header.stamp);
+    meas.type = FUSION_CONTROL;
+    meas.value[0] = cmd.drive.speed;
+    meas.value[1] = cmd.drive.steering_angle;
+    addMeasurement(meas);
+}
 
-    while(ros::ok())
-    {
-        ekf_mutex.lock();
-        car_ekf.stateEstimatorPredict(1./EKF_RATE, v_in, phi_in);
-		
-        vec3d_t pos = car_ekf.getLocation();
-        // Need to convert phi into quaternion (assume roll=pitch=0, and yaw=phi)
-        ekf_mutex.unlock();
-        
-        r.sleep();
-    }
+// Publishes the fused state brought up to now, without touching the filter
+void publishState(const ros::TimerEvent&)
+{
+    const ros::WallTime start = ros::WallTime::now();
+    const ros::Time stamp = ros::Time::now();
+    EKF now = fusion->stateAt(stamp.toSec());
+    vec3d_t pos = now.getLocation();
+    double phi = now.getAngle();
     
+    // Need to convert phi into quaternion (assume roll=pitch=0, and yaw=phi)
+    // A shared pointer, subscribers in the same nodelet manager get it without a copy
+    geometry_msgs::PosePtr pose_msg(new geometry_msgs::Pose);
+    pose_msg->position.x = pos.x;
+    pose_msg->position.y = pos.y;
+    pose_msg->position.z = pos.z;
+    pose_msg->orientation.z = std::sin(phi/2);
+    pose_msg->orientation.w = std::cos(phi/2);
+    state_pub.publish(pose_msg);
+
+    // Filtered forward speed, what the speed loops of the controllers close on
+    geometry_msgs::TwistStampedPtr vel_msg(new geometry_msgs::TwistStamped);
+    vel_msg->header.stamp = stamp;
+    vel_msg->header.frame_id = "base_link";
+    vel_msg->twist.linear.x = now.getVelocity();
+    vel_pub.publish(vel_msg);
+    
+    publish_metric->record((ros::WallTime::now() - start).toSec());
+    drops_metric->set(fusion->getDropCount());
+    rollbacks_metric->set(fusion->getRollbackCount());
 }
 
-int main(int argc, char **argv)
+namespace cyphy_car
 {
-    current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
-    ros::init(argc, argv, "waypoint");
-    ros::NodeHandle n("~");
-    
-    //n.param<std::string>("vicon_obj", vicon_obj, "f1car");
-    //n.param<std::string>("bot_num", bot_num, "bot0");
 
-    state_pub = n.advertise<geometry_msgs::Pose>("/carPose", 1);
+/*
+ * The estimator as a nodelet, so that the positioning and the controllers in
+ * the same manager exchange messages with it as shared pointers instead of
+ * over TCPROS. Its state is global, one per process. estimator_node loads it
+ * into a manager of its own.
+ */
+class EstimatorNodelet : public nodelet::Nodelet
+{
+public:
+    ~EstimatorNodelet()
+    {
+        if (sensors)
+        {
+            sensors->stop();
+        }
+        if (core)
+        {
+            NODELET_INFO("Dropped %u late measurements, %u rollbacks", core->getDropCount(), core->getRollbackCount());
+        }
+        if (metrics_started)
+        {
+            stopMetricsServer();
+        }
+    }
 
-    ros::Subscriber vicon_sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
-    ros::Subscriber imu_sub = n.subscribe("/imu/data", 1, getIMUdata);
-    ros::Subscriber inputs = n.subscribe("/ackermann_cmd", 1, getInputs); 
+private:
+    void onInit()
+    {
+        ros::NodeHandle &n = getPrivateNodeHandle();
+
+        n.param<std::string>("vicon_obj", vicon_obj, "f1car");
+        n.param<std::string>("deca_topic", deca_topic, "/positioning/decaPose");
+        n.param<bool>("use_vicon", use_vicon, true);
+        n.param<bool>("use_deca", use_deca, true);
+        int metrics_port;
+        n.param<int>("metrics_port", metrics_port, 0); // Prometheus endpoint of the process, 0 disables
+        
+        MetricsRegistry &metrics = MetricsRegistry::instance();
+        static const char *const SENSORS[FUSION_TYPES] = {"control", "imu", "vicon", "position", "tdoa"};
+        for (int k = 0; k < FUSION_TYPES; k++)
+        {
+            meas_metric[k] = &metrics.counter("estimator_measurements_total", "Measurements handed to the fusion core",
+                                              metricLabel("sensor", SENSORS[k]));
+        }
+        publish_metric = &metrics.histogram("estimator_publish_seconds", "State brought up to now and published");
+        drops_metric = &metrics.gauge("estimator_late_drops", "Measurements older than the fusion history");
+        rollbacks_metric = &metrics.gauge("estimator_rollbacks", "Out of order measurements replayed into the history");
+        metrics_started = startMetricsServer(metrics_port);
+
+        EKF car_ekf;
+        core.reset(new Fusion(car_ekf));
+        fusion = core.get();
+
+        state_pub = n.advertise<geometry_msgs::Pose>("/carPose", 1);
+        vel_pub = n.advertise<geometry_msgs::TwistStamped>("/carVel", 1);
+
+        sensors.reset(new CallbackThread(n, "sensor"));
+        ros::NodeHandle &q = sensors->node();
+        if (use_vicon)
+        {
+            vicon_sub = q.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 10, getViconPosition);
+        }
+        if (use_deca)
+        {
+            deca_sub = q.subscribe(deca_topic, 50, getDecaPosition);
+        }
+        imu_sub = q.subscribe("/imu/data", 50, getIMUdata);
+        inputs = q.subscribe("/ackermann_cmd", 10, getInputs);
+
+        // As fast as the fastest loop closing on the state, the fused state is brought up to each tick. The ticks
+        // fall publish_phase [s] into their period on the schedule of PeriodicLoop, so the control loops can be
+        // phased right behind them; the timer keeps its phase once started on it
+        double publish_rate, publish_phase;
+        n.param<double>("publish_rate", publish_rate, PRINT_RATE);
+        n.param<double>("publish_phase", publish_phase, 0.0);
+        print_timer = q.createTimer(ros::Duration(1./publish_rate), publishState, false, false);
+        const double now = ros::WallTime::now().toSec();
+        const double start = PeriodicLoop::next_deadline(now, 1./publish_rate, publish_phase);
+        align_timer = q.createWallTimer(ros::WallDuration(start - now),
+                                        [this](const ros::WallTimerEvent&) { print_timer.start(); }, true);
+    }
 
-    
-    ekf_thread = std::thread(estimator);
+    bool metrics_started = false;
+    std::unique_ptr<Fusion> core;
+    std::unique_ptr<CallbackThread> sensors;
+    ros::Subscriber vicon_sub, deca_sub, imu_sub, inputs;
+    ros::Timer print_timer;
+    ros::WallTimer align_timer;
+};
 
-    ros::spin();
-    
-    ekf_thread.join();
-    
-    
-    return 0;
 }
+
+PLUGINLIB_EXPORT_CLASS(cyphy_car::EstimatorNodelet, nodelet::Nodelet)
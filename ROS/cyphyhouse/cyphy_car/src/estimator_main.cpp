@@ -0,0 +1,16 @@
+#include "ros/ros.h"
+#include <nodelet/loader.h>
+
+// estimator_node, the estimator nodelet in a manager of its own with the name, parameters and remappings of the node
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "estimator");
+    nodelet::Loader manager(false);
+    nodelet::V_string my_argv(argv + 1, argv + argc);
+    if (!manager.load(ros::this_node::getName(), "cyphy_car/Estimator", ros::names::getRemappings(), my_argv))
+    {
+        return 1;
+    }
+    ros::spin();
+    return 0;
+}
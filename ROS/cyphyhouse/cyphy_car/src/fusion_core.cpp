@@ -0,0 +1,137 @@
+/*************************************************
+ *
+ *  Event-driven multi-rate fusion, see fusion_core.h
+ *
+ *************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include "fusion_core.h"
+
+template <typename Scalar>
+FusionCore<Scalar>::FusionCore(const Filter &initial, double history_len)
+    : historyLen(history_len), drops(0), rollbacks(0)
+{
+    current.filter = initial;
+    current.time = 0;
+    current.timeValid = false;
+    current.control[0] = current.control[1] = 0;
+}
+
+template <typename Scalar>
+void FusionCore<Scalar>::predictTo(Snapshot &s, double t)
+{
+    if (!s.timeValid)
+    {
+        s.time = t;
+        s.timeValid = true;
+        return;
+    }
+
+    // Long gaps are split so the linearization of the car model stays close
+    while (t > s.time)
+    {
+        double dt = std::min(t - s.time, (double)FUSION_MAX_STEP);
+        s.filter.stateEstimatorPredict(dt, s.control[0], s.control[1]);
+        s.filter.stateEstimatorAddProcessNoise(dt);
+        s.time += dt;
+    }
+}
+
+template <typename Scalar>
+void FusionCore<Scalar>::apply(Snapshot &s, const fusion_meas_t &meas)
+{
+    predictTo(s, meas.stamp);
+
+    switch (meas.type)
+    {
+        case FUSION_CONTROL:
+            s.control[0] = meas.value[0];
+            s.control[1] = meas.value[1];
+            break;
+        case FUSION_IMU:
+            s.filter.IMUUpdate(meas.value[0], meas.value[1]);
+            break;
+        case FUSION_VICON:
+            s.filter.ViconUpdate(meas.value[0], meas.value[1], meas.value[2]);
+            break;
+        case FUSION_POSITION:
+        {
+            typename Filter::PositionCovariance R;
+            R << meas.cov[0], meas.cov[1], meas.cov[2],
+                 meas.cov[1], meas.cov[3], meas.cov[4],
+                 meas.cov[2], meas.cov[4], meas.cov[5];
+            s.filter.PositionUpdate(meas.value[0], meas.value[1], meas.value[2], R);
+            break;
+        }
+        case FUSION_TDOA:
+            s.filter.scalarTDOADistUpdate(meas.Ar, meas.An, meas.value[0]);
+            break;
+    }
+}
+
+template <typename Scalar>
+void FusionCore<Scalar>::applyAndRecord(const fusion_meas_t &meas)
+{
+    HistoryEntry entry;
+    entry.meas = meas;
+    entry.before = current;
+    history.push_back(entry);
+
+    apply(current, meas);
+
+    while (!history.empty() && (history.front().meas.stamp < current.time - historyLen))
+    {
+        history.pop_front();
+    }
+}
+
+template <typename Scalar>
+bool FusionCore<Scalar>::add(const fusion_meas_t &meas)
+{
+    if (!current.timeValid || (meas.stamp >= current.time))
+    {
+        applyAndRecord(meas);
+        return true;
+    }
+
+    if (history.empty() || (meas.stamp < history.front().meas.stamp))
+    {
+        drops++;
+        return false;
+    }
+
+    // First applied measurement after the late one, the filter goes back to just before it
+    auto it = std::upper_bound(history.begin(), history.end(), meas.stamp,
+        [](double t, const HistoryEntry &e){ return t < e.meas.stamp; });
+
+    std::vector<fusion_meas_t> replay;
+    replay.push_back(meas);
+    for (auto r = it; r != history.end(); ++r)
+    {
+        replay.push_back(r->meas);
+    }
+
+    current = it->before;
+    history.erase(it, history.end());
+    rollbacks++;
+
+    for (size_t i = 0; i < replay.size(); i++)
+    {
+        applyAndRecord(replay[i]);
+    }
+    return true;
+}
+
+template <typename Scalar>
+typename FusionCore<Scalar>::Filter FusionCore<Scalar>::stateAt(double t) const
+{
+    Snapshot s = current;
+    predictTo(s, t);
+    return s.filter;
+}
+
+// Supported filter configurations
+template class FusionCore<float>;
+template class FusionCore<double>;
@@ -0,0 +1,432 @@
+/*************************************************
+ *
+ *  Closed-loop simulation of the car stack in one process, without ROS
+ *  time: the kinematic bicycle of the MPC drives the true car, the
+ *  positioning stage (sim_positioning.h) turns its position into synthetic
+ *  TDOA pairs and runs them through the TDOA filter, the estimator fuses
+ *  those positions, a simulated IMU and the commands (FusionCore), and the
+ *  MPC of cyphy_car_mpc closes the loop on the fused pose at WP_RATE with
+ *  the waypoint logic of its node. Everything steps on one simulated clock,
+ *  as fast as the CPU allows, and the runs are deterministic for a seed.
+ *
+ *  Each mission is a file of "x, y" waypoints. The car starts on the first,
+ *  facing +x, and has to reach the last within the timeout. Reported per
+ *  mission: time to complete, RMS and largest distance of the true car from
+ *  the leg it is on, RMS error of the fused position and the wall time of
+ *  every stage. Exits 1 if any mission did not complete.
+ *
+ *  Usage: car_sim [mission files] [options]
+ *      --anchors <file>      anchor positions, "x, y, z" lines (default the lab layout)
+ *      --rate <Hz>           MPC rate (default 50, WP_RATE of cyphy_car_mpc)
+ *      --timeout <s>         per mission (default 60)
+ *      --feedback <source>   fused (default) or truth, the pose the MPC closes on
+ *      --lag <s>             time constant of the speed and steering response (default 0.1)
+ *      --seed <n>
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+
+#include "ekf_car.h"
+#include "fusion_core.h"
+#include "sim_positioning.h"
+#include "cyphy_control/CarMpc.h"
+#include "cyphy_control/CostTerms.h"
+
+#define MODEL_DT        0.001   // s, integration step of the true car
+#define IMU_RATE        100.0   // Hz
+#define STATE_RATE      100.0   // Hz, PRINT_RATE of the estimator
+#define TAG_HEIGHT      0.15    // m
+#define GYRO_NOISE      0.01    // rad/s
+#define ACC_NOISE       0.05    // m/s^2
+
+// Waypoint logic of cyphy_car_mpc/src/waypoint.cpp
+#define EPSILON_RADIUS  0.25
+#define STOP_SPEED      0.15
+
+typedef struct car_state_s
+{
+    double x, y, psi;
+    double v, delta;        // Actual speed and steering, behind the commands by the lag
+}car_state_t;
+
+// Wall time of one stage of the loop
+typedef struct stage_timer_s
+{
+    const char *name;
+    uint64_t calls;
+    double total;           // s
+    double max;             // s
+}stage_timer_t;
+
+typedef struct sim_options_s
+{
+    std::vector<std::string> missions;
+    std::string anchorFile;
+    double rate;
+    double timeout;
+    bool truthFeedback;
+    double lag;
+    unsigned seed;
+}sim_options_t;
+
+typedef struct mission_result_s
+{
+    bool completed;
+    double time;            // s, simulated
+    double wall;            // s
+    double trackRms, trackMax;      // m, true car to its leg
+    double estimateRms;     // m, fused to true position
+    uint32_t mpcMisses;     // Solves longer than the MPC period
+}mission_result_t;
+
+// Lab layout (anchorPos_hotdec.txt)
+static double anchors[SIM_MAX_ANCHORS][3] = {
+    {4.495, 0.600, 2.181}, {0.155, 0.190, 2.190}, {4.498, 4.342, 2.174}, {0.155, 4.240, 2.179},
+    {4.498, 0.670, 0.180}, {0.159, 0.780, 0.175}, {4.500, 4.332, 0.180}, {0.159, 4.360, 0.175}};
+static int anchorCount = SIM_MAX_ANCHORS;
+
+// Square inside the anchors and the +-3 m bounds of the MPC
+static const double DEFAULT_MISSION[][2] = {{1.0, 1.0}, {2.5, 1.0}, {2.5, 2.5}, {1.0, 2.5}, {1.0, 1.0}};
+
+class StageClock
+{
+public:
+    explicit StageClock(stage_timer_t &timer) : timer(timer), start(std::chrono::steady_clock::now()) {}
+    ~StageClock()
+    {
+        const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        timer.calls++;
+        timer.total += t;
+        timer.max = std::max(timer.max, t);
+    }
+
+private:
+    stage_timer_t &timer;
+    std::chrono::steady_clock::time_point start;
+};
+
+static bool loadPoints(const std::string &path, int columns, std::vector<std::vector<double> > &points)
+{
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        double v[3];
+        if (sscanf(line.c_str(), "%lf, %lf, %lf", &v[0], &v[1], &v[2]) >= columns)
+        {
+            points.push_back(std::vector<double>(v, v + columns));
+        }
+    }
+    return !points.empty();
+}
+
+// Distance of (x, y) from the segment a-b
+static double legDistance(double x, double y, const double a[2], const double b[2])
+{
+    const double dx = b[0] - a[0], dy = b[1] - a[1];
+    const double len2 = dx*dx + dy*dy;
+    const double s = (len2 > 0) ? std::max(0.0, std::min(1.0, ((x - a[0])*dx + (y - a[1])*dy) / len2)) : 0;
+    return std::hypot(x - a[0] - s*dx, y - a[1] - s*dy);
+}
+
+static mission_result_t runMission(const std::vector<std::vector<double> > &mission, const sim_options_t &opt,
+                                   stage_timer_t *stages)
+{
+    enum { STAGE_MODEL, STAGE_POSITIONING, STAGE_FUSION, STAGE_MPC };
+
+    const double wheelbase = CAR_WHEELBASE;
+    std::mt19937 gen(opt.seed);
+    std::normal_distribution<double> normal(0, 1);
+
+    car_state_t car = {mission[0][0], mission[0][1], 0, 0, 0};
+    double speedCmd = 0, steerCmd = 0;
+
+    SimPositioning positioning(anchors, anchorCount, opt.seed);
+
+    EKF initial;
+    vec3d_t init = {car.x, car.y, TAG_HEIGHT};
+    initial.setInitPos(init);
+    Fusion fusion(initial);
+
+    // The weights of the MpcProblem of cyphy_car_mpc
+    CarMpc::Terms terms;
+    terms.emplace_back(new WaypointCost(400, 400));
+    terms.emplace_back(new InputCost(200, 250, 50, 200));
+    CarMpc mpc(CarProblem(), terms, "cyphy_car_mpc");
+
+    // Waypoints still to reach and the leg the car is on
+    std::vector<std::vector<double> > waypoints(mission.begin() + 1, mission.end());
+    double legStart[2] = {car.x, car.y};
+    double fused[3] = {car.x, car.y, 0};    // x, y, psi
+
+    mission_result_t res = {false, 0, 0, 0, 0, 0, 0};
+    double trackSq = 0, estimateSq = 0;
+    uint64_t trackN = 0, estimateN = 0;
+
+    const double mpcPeriod = 1.0 / opt.rate;
+    double t = 0, nextSlot = positioning.slotTime(), nextImu = 0, nextState = 0, nextMpc = 0;
+    const auto wallStart = std::chrono::steady_clock::now();
+    while (!waypoints.empty() && (t < opt.timeout))
+    {
+        double dv;
+        {
+            StageClock clock(stages[STAGE_MODEL]);
+            const double a = std::min(1.0, opt.lag > 0 ? MODEL_DT / opt.lag : 1.0);
+            dv = a * (speedCmd - car.v);
+            car.v += dv;
+            car.delta += a * (steerCmd - car.delta);
+            car.x += car.v * cos(car.psi) * MODEL_DT;
+            car.y += car.v * sin(car.psi) * MODEL_DT;
+            car.psi += car.v * tan(car.delta) * MODEL_DT / wheelbase;
+            t += MODEL_DT;
+        }
+
+        if (t >= nextImu)
+        {
+            nextImu += 1.0 / IMU_RATE;
+            fusion_meas_t meas;
+            meas.stamp = t;
+            meas.type = FUSION_IMU;
+            meas.value[0] = car.v * tan(car.delta) / wheelbase + GYRO_NOISE * normal(gen);
+            meas.value[1] = dv / MODEL_DT + ACC_NOISE * normal(gen);
+            StageClock clock(stages[STAGE_FUSION]);
+            fusion.add(meas);
+        }
+
+        while (nextSlot <= t)
+        {
+            sim_position_t p;
+            const double pos[3] = {car.x, car.y, TAG_HEIGHT};
+            bool ready;
+            {
+                StageClock clock(stages[STAGE_POSITIONING]);
+                ready = positioning.step(pos, p);
+            }
+            nextSlot += positioning.slotTime();
+            if (ready)
+            {
+                fusion_meas_t meas;
+                meas.stamp = p.t;
+                meas.type = FUSION_POSITION;
+                for (int k = 0; k < 3; k++)
+                {
+                    meas.value[k] = p.pos[k];
+                }
+                for (int k = 0; k < 6; k++)
+                {
+                    meas.cov[k] = p.cov[k];
+                }
+                StageClock clock(stages[STAGE_FUSION]);
+                fusion.add(meas);
+            }
+        }
+
+        if (t >= nextState)
+        {
+            nextState += 1.0 / STATE_RATE;
+            StageClock clock(stages[STAGE_FUSION]);
+            EKF now = fusion.stateAt(t);
+            const vec3d_t loc = now.getLocation();
+            fused[0] = loc.x;
+            fused[1] = loc.y;
+            fused[2] = now.getAngle();
+            estimateSq += std::pow(loc.x - car.x, 2) + std::pow(loc.y - car.y, 2);
+            estimateN++;
+        }
+
+        const double track = legDistance(car.x, car.y, legStart, waypoints.front().data());
+        trackSq += track * track;
+        trackN++;
+        res.trackMax = std::max(res.trackMax, track);
+
+        if (t >= nextMpc)
+        {
+            nextMpc += mpcPeriod;
+            const double x = opt.truthFeedback ? car.x : fused[0];
+            const double y = opt.truthFeedback ? car.y : fused[1];
+            const double psi = opt.truthFeedback ? car.psi : fused[2];
+
+            const std::vector<double> &wp = waypoints.front();
+            if ((std::hypot(x - wp[0], y - wp[1]) < EPSILON_RADIUS) || ((std::fabs(speedCmd) < STOP_SPEED) && (t >= 1.0)))
+            {
+                legStart[0] = wp[0];
+                legStart[1] = wp[1];
+                waypoints.erase(waypoints.begin());
+                if (waypoints.empty())
+                {
+                    speedCmd = steerCmd = 0;
+                    res.completed = true;
+                    break;
+                }
+            }
+
+            const std::vector<double> &target = waypoints.front();
+            const auto solveStart = std::chrono::steady_clock::now();
+            std::vector<double> solution;
+            {
+                StageClock clock(stages[STAGE_MPC]);
+                solution = mpc.Solve(x, y, psi, {target[0], target[1]});
+            }
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - solveStart).count() > mpcPeriod)
+            {
+                res.mpcMisses++;
+            }
+            steerCmd = solution.at(0);
+            speedCmd = solution.at(1);
+
+            fusion_meas_t meas;
+            meas.stamp = t;
+            meas.type = FUSION_CONTROL;
+            meas.value[0] = speedCmd;
+            meas.value[1] = steerCmd;
+            StageClock clock(stages[STAGE_FUSION]);
+            fusion.add(meas);
+        }
+    }
+
+    res.time = t;
+    res.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    res.trackRms = trackN ? std::sqrt(trackSq / trackN) : 0;
+    res.estimateRms = estimateN ? std::sqrt(estimateSq / estimateN) : 0;
+    return res;
+}
+
+static void usage()
+{
+    printf("Usage: car_sim [mission files] [--anchors file] [--rate Hz] [--timeout s] [--feedback fused|truth]\n"
+           "               [--lag s] [--seed n]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], sim_options_t &opt)
+{
+    opt.rate = 50;
+    opt.timeout = 60;
+    opt.truthFeedback = false;
+    opt.lag = 0.1;
+    opt.seed = 42;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg[0] != '-')
+        {
+            opt.missions.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string val = argv[++i];
+        if (arg == "--anchors")
+        {
+            opt.anchorFile = val;
+        }
+        else if (arg == "--rate")
+        {
+            opt.rate = atof(val.c_str());
+        }
+        else if (arg == "--timeout")
+        {
+            opt.timeout = atof(val.c_str());
+        }
+        else if ((arg == "--feedback") && ((val == "fused") || (val == "truth")))
+        {
+            opt.truthFeedback = (val == "truth");
+        }
+        else if (arg == "--lag")
+        {
+            opt.lag = atof(val.c_str());
+        }
+        else if (arg == "--seed")
+        {
+            opt.seed = strtoul(val.c_str(), NULL, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return (opt.rate > 0) && (opt.timeout > 0) && (opt.lag >= 0);
+}
+
+int main(int argc, char *argv[])
+{
+    sim_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    if (!opt.anchorFile.empty())
+    {
+        std::vector<std::vector<double> > points;
+        if (!loadPoints(opt.anchorFile, 3, points))
+        {
+            printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+            return 1;
+        }
+        anchorCount = std::min<int>(points.size(), SIM_MAX_ANCHORS);
+        for (int i = 0; i < anchorCount; i++)
+        {
+            std::copy(points[i].begin(), points[i].end(), anchors[i]);
+        }
+    }
+
+    std::vector<std::vector<std::vector<double> > > missions;
+    std::vector<std::string> names;
+    for (size_t m = 0; m < opt.missions.size(); m++)
+    {
+        std::vector<std::vector<double> > points;
+        if (!loadPoints(opt.missions[m], 2, points) || (points.size() < 2))
+        {
+            printf("Could not read at least two waypoints from %s\n", opt.missions[m].c_str());
+            return 1;
+        }
+        missions.push_back(points);
+        names.push_back(opt.missions[m]);
+    }
+    if (missions.empty())
+    {
+        std::vector<std::vector<double> > points;
+        for (size_t k = 0; k < sizeof(DEFAULT_MISSION) / sizeof(DEFAULT_MISSION[0]); k++)
+        {
+            points.push_back(std::vector<double>(DEFAULT_MISSION[k], DEFAULT_MISSION[k] + 2));
+        }
+        missions.push_back(points);
+        names.push_back("square");
+    }
+
+    stage_timer_t stages[4] = {{"model", 0, 0, 0}, {"positioning", 0, 0, 0}, {"fusion", 0, 0, 0}, {"mpc", 0, 0, 0}};
+    double simulated = 0;
+    bool allCompleted = true;
+    printf("mission               done  time s   x real  track rms  track max  est rms  mpc misses\n");
+    for (size_t m = 0; m < missions.size(); m++)
+    {
+        const mission_result_t r = runMission(missions[m], opt, stages);
+        simulated += r.time;
+        allCompleted = allCompleted && r.completed;
+        printf("%-20s  %-4s  %-7.2f  %-6.1f  %-9.3f  %-9.3f  %-7.3f  %u\n", names[m].c_str(), r.completed ? "yes" : "no",
+               r.time, r.time / std::max(r.wall, 1e-9), r.trackRms, r.trackMax, r.estimateRms, r.mpcMisses);
+    }
+
+    // Compute budget: wall time of each stage per simulated second, and per call
+    printf("\nstage        ms per s  mean us  max us   calls\n");
+    for (int s = 0; s < 4; s++)
+    {
+        const stage_timer_t &st = stages[s];
+        printf("%-11s  %-8.2f  %-7.1f  %-7.1f  %llu\n", st.name, 1e3 * st.total / std::max(simulated, 1e-9),
+               st.calls ? 1e6 * st.total / st.calls : 0.0, 1e6 * st.max, (unsigned long long)st.calls);
+    }
+    return allCompleted ? 0 : 1;
+}
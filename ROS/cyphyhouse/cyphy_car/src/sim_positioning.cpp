@@ -0,0 +1,125 @@
+/*************************************************
+ *
+ *  Positioning stage of car_sim, see sim_positioning.h
+ *
+ *************************************************/
+
+#include <vector>
+
+#include "sim_positioning.h"
+#include "tdoa.h"
+#include "tdoa_sim.h"
+
+static anchor_layout_t makeLayout(const double anchors[][3], int count)
+{
+    anchor_layout_t layout;
+    layout.count = std::min(count, SIM_MAX_ANCHORS);
+    for (int i = 0; i < layout.count; i++)
+    {
+        layout.pos[i].x = anchors[i][0];
+        layout.pos[i].y = anchors[i][1];
+        layout.pos[i].z = anchors[i][2];
+    }
+    return layout;
+}
+
+static tdoa_sim_config_t makeConfig(unsigned seed)
+{
+    tdoa_sim_config_t config = defaultSimConfig();
+    config.seed = seed;
+    return config;
+}
+
+struct SimPositioning::Impl
+{
+    Impl(const anchor_layout_t &layout, unsigned seed)
+        : layout(layout), sim(layout, makeConfig(seed)), hold(1), bootstrapped(false), slots(0)
+    {
+        for (int i = 0; i < layout.count; i++)
+        {
+            filter.setAncPosition(i, layout.pos[i]);
+        }
+    }
+
+    anchor_layout_t layout;
+    TDOASimulator sim;
+    TDOA filter;
+    std::vector<sim_waypoint_t> hold;   // The car position, held by the simulator
+    std::vector<tdoa_meas_t> frame;     // Pairs of the rotation until the filter is bootstrapped
+    bool bootstrapped;
+    int slots;
+};
+
+SimPositioning::SimPositioning(const double anchors[][3], int count, unsigned seed)
+    : impl(new Impl(makeLayout(anchors, count), seed))
+{
+}
+
+SimPositioning::~SimPositioning()
+{
+}
+
+double SimPositioning::slotTime() const
+{
+    return defaultSimConfig().slotTime;
+}
+
+double SimPositioning::getTime() const
+{
+    return impl->sim.getTime();
+}
+
+bool SimPositioning::step(const double pos[3], sim_position_t &out)
+{
+    Impl &s = *impl;
+    s.hold[0].t = s.sim.getTime();
+    for (int k = 0; k < 3; k++)
+    {
+        s.hold[0].pos[k] = pos[k];
+    }
+    s.sim.setTrajectory(s.hold);
+
+    tdoa_meas_t m;
+    double truth[3];
+    if (s.sim.step(m, truth))
+    {
+        // As the replay: the first rotation bootstraps, every later pair is one scalar update
+        if (!s.bootstrapped)
+        {
+            s.frame.push_back(m);
+        }
+        else
+        {
+            s.filter.stateEstimatorPredictTo(m.timestamp);
+            s.filter.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+        }
+    }
+    if (++s.slots % s.layout.count != 0)
+    {
+        return false;
+    }
+
+    if (!s.bootstrapped)
+    {
+        s.bootstrapped = s.filter.initFromFrame(s.frame.data(), s.frame.size());
+        s.frame.clear();
+        if (!s.bootstrapped)
+        {
+            return false;
+        }
+    }
+    s.filter.stateEstimatorPredictTo(s.sim.getTime());
+
+    const vec3d_t p = s.filter.getLocation();
+    const TDOA::StateMatrix P = s.filter.getCovariance();
+    out.t = s.sim.getTime();
+    out.pos[0] = p.x;
+    out.pos[1] = p.y;
+    out.pos[2] = p.z;
+    const int idx[6][2] = {{0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2}};
+    for (int i = 0; i < 6; i++)
+    {
+        out.cov[i] = P(STATE_X + idx[i][0], STATE_X + idx[i][1]);
+    }
+    return true;
+}
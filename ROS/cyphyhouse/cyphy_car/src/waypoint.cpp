@@ -2,21 +2,31 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <memory>
 #include <ctime>
 #include <cstdbool>
 #include <fstream>
 #include <deque>
+#include <atomic>
 
 
 #include "ros/ros.h"
 #include <std_msgs/String.h>
 #include "geometry_msgs/PoseStamped.h"
+#include "nav_msgs/Path.h"
 #include "geometry_msgs/PointStamped.h"
 #include <ackermann_msgs/AckermannDriveStamped.h>
 #include "ros/package.h"
+#include "cyphy_control/AsyncLog.h"
+#include "cyphy_control/FixedRatePid.h"
+#include "cyphy_control/LatestBuffer.h"
+#include "cyphy_control/PathTracker.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/TrajectoryRecorder.h"
 
 #define WP_RATE          100.0 //Hz
-#define PRINT_RATE       100.0 //Hz
 
 #define DELTA_DIRECTION  0.01
 #define DELTA_SPEED      0.25
@@ -26,31 +36,57 @@
 #define MAX_SPEED        4.0
 #define MAX_ANGLE        0.35
 
-bool isDriving = false;
+#define WP_QUEUE_SIZE    64 // Must be a power of two
+
+std::atomic<bool> isDriving(false);
 bool gotWP = false;
 double speed = 0, direction = 0;
 geometry_msgs::Point prev_loc, curr_loc;
 
 std::string bot_num, vicon_obj;
+// Waypoints still to reach, drive owns them
 std::deque<geometry_msgs::Point> waypoints;
 
+// A waypoint as getWP received it, last if it is the final point of its path
+struct QueuedWaypoint
+{
+    geometry_msgs::Point point;
+    bool last;
+};
+
+// Waypoints from getWP to drive
+SPSCQueue<QueuedWaypoint, WP_QUEUE_SIZE> wp_queue;
+
+// Paths from getPath to drive, a newer one replaces one drive has not taken yet
+LatestBuffer<nav_msgs::PathConstPtr> new_path;
+
 ros::Publisher drive_pub;
 ros::Publisher reached_pub;
 
-geometry_msgs::Point vicon_position;
+// Latest VICON pose, written by getViconPosition and read by the threads
+Snapshot<geometry_msgs::Pose> vicon_pose;
 geometry_msgs::Point current_waypoint;  // VICON coords
-geometry_msgs::Quaternion quat; //Get orientation
+
+// Log of the drive loop, printed and written by the background thread of async_log
+LogChannel drive_log("drive");
+
+// Trajectory of the drive, recorded by getViconPosition while driving if record_trajectory is set
+std::unique_ptr<TrajectoryRecorder> trajectory;
 
 std::string dir_path;
 char time_buffer[80];
-std::thread drive_thread, print_thread;
+std::thread drive_thread;
+double drive_phase;
 
 int vel_sign, dir_sign;
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
 {
-    vicon_position = pose.pose.position;
-    quat = pose.pose.orientation;
+    vicon_pose.store(pose.pose);
+    if (trajectory && isDriving)
+    {
+        trajectory->record(ros::Time::now().toNSec(), pose.pose.position.x, pose.pose.position.y, pose.pose.position.z);
+    }
 }
 
 inline double goalDist(const geometry_msgs::Point pos, const geometry_msgs::Point goal)
@@ -66,63 +102,117 @@ double get_angle_error(geometry_msgs::Point center, geometry_msgs::Point waypoin
     //double abs_v = sqrt(v_x * v_x + v_y * v_y);
     //double wp_ang = acos((v_x)/(abs_v)); // angle between next wp and x axis.
     double wp_ang = atan2(v_y, v_x);
-    std::cout << curr_ang << ", " << wp_ang-curr_ang << std::endl;
+    drive_log.info("angle: %f, error: %f", curr_ang, wp_ang-curr_ang);
     return wp_ang - curr_ang;
 }
 
 double a_error = 0;
-double a_integral = 0;
-double a_prev = 0;
 double d_target = 0;
-double d_prev = 0;
-double d_integral = 0;
-double a_diff = 0;
-double d_diff = 0;
 
-double get_pid_distance(double d_err_curr, double d_err_prev)
+// Distance to the waypoint to speed, and heading error to steering, owned by drive
+FixedRatePid distance_pid(1.2, 0.01, 0.01, WP_RATE, MAX_SPEED, 0.8);
+FixedRatePid angle_pid(1, 0.01, 0.1, WP_RATE, MAX_ANGLE, 0.7);
+
+// Pure pursuit or Stanley along the waypoints in place of the PIDs (controller), owned by drive
+bool use_tracker = false;
+bool path_changed = false;  // The waypoints changed since the tracker took them
+PathTracker tracker;
+
+
+// Takes the waypoints getWP queued, driving starts once the final point of a path is in. A path from getPath
+// replaces the waypoints left
+void receiveWaypoints()
 {
-    static double Kp = 1.2;
-    static double Kd = 0.01;
-    static double Ki = 0.01;
-    static double i_limit = 2.0;
-    d_integral += d_err_curr*(1.0/WP_RATE);
-    d_integral = fmin(d_integral, i_limit);
-    
-    double diff = (d_err_curr - d_err_prev)*WP_RATE;
-    d_diff = 0.2*d_diff + 0.8*diff;
-    
-    return Kp*d_err_curr + Kd*d_diff + Ki*d_integral;
+    QueuedWaypoint wp;
+    while (wp_queue.pop(wp))
+    {
+        waypoints.push_back(wp.point);
+
+        // wait until we get the final point
+        if (wp.last)
+        {
+            current_waypoint = waypoints.front();
+            gotWP = true;
+            path_changed = true;
+        }
+    }
+
+    nav_msgs::PathConstPtr path;
+    if (new_path.read(path))
+    {
+        waypoints.clear();
+        for (size_t i = 0; i < path->poses.size(); i++)
+        {
+            waypoints.push_back(path->poses[i].pose.position);
+        }
+        current_waypoint = waypoints.front();
+        gotWP = true;
+        path_changed = true;
+    }
 }
 
-double get_pid_angle(double a_err_curr, double a_err_prev)
+// Tells STARL the final point is reached and stops
+void reachedGoal()
 {
-    static double Kp = 1;
-    static double Kd = 0.1;
-    static double Ki = 0.01;
-    static double a_limit = 0.2;
-    a_integral += a_err_curr*(1.0/WP_RATE);
-    a_integral = fmin(fmax(a_integral,-a_limit),a_limit);
-    
-    double diff = (a_err_curr - a_err_prev)*WP_RATE;
-    a_diff = 0.3*a_diff + 0.7*diff;
-    
-    return Kp*a_err_curr + Kd*a_diff + Ki*a_integral;
+    std_msgs::String wp_reached;
+    wp_reached.data = "TRUE";
+    reached_pub.publish(wp_reached);
+
+    gotWP = false;
+    speed = 0;
+    direction = 0;
+    a_error = 0;
+    d_target = 0;
+    distance_pid.reset();
+    angle_pid.reset();
 }
 
+// One cycle of the tracker along all waypoints left, they are dropped once the final one is reached
+void trackPath(const geometry_msgs::Quaternion& q)
+{
+    if (path_changed)
+    {
+        std::vector<TrackPoint> points;
+        points.reserve(waypoints.size());
+        for (const geometry_msgs::Point& p : waypoints)
+        {
+            points.push_back(TrackPoint{p.x, p.y});
+        }
+        tracker.setPath(points);
+        path_changed = false;
+    }
 
+    const double yaw = atan2(2 * (q.x * q.y + q.w * q.z), pow(q.w,2) + pow(q.x,2) - pow(q.y,2) - pow(q.z,2));
+    if (!tracker.update(curr_loc.x, curr_loc.y, yaw, speed, direction))
+    {
+        waypoints.clear();
+        tracker.reset();
+        reachedGoal();
+        return;
+    }
+    current_waypoint = waypoints[std::min(tracker.getSegment(), waypoints.size() - 1)];
+    drive_log.info("segment: %zu, speed: %f, steering: %f", tracker.getSegment(), speed, direction);
+}
 
 void drive()
 {
-    ros::Rate r(WP_RATE);
+    PeriodicLoop r(1.0 / WP_RATE, drive_phase);
 
     while(ros::ok())
     {
-        
-        curr_loc = vicon_position;
-        
-        // Acknowledge that we reached the desired waypoint
-        if (gotWP)
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        const geometry_msgs::Quaternion& quat = pose.orientation;
+        curr_loc = pose.position;
+
+        receiveWaypoints();
+
+        if (use_tracker && gotWP)
+        {
+            trackPath(quat);
+        }
+        else if (gotWP)
         {
+            // Acknowledge that we reached the desired waypoint
             if (goalDist(curr_loc, current_waypoint) < EPSILON_RADIUS)
             {
                 waypoints.pop_front(); //delete first element
@@ -131,36 +221,21 @@ void drive()
                 {
                     // tell STARL if waypoint is reached
                     // for now assume we only do that once we reach the final dest
-                    std_msgs::String wp_reached;
-                    wp_reached.data = "TRUE";
-                    gotWP = false;
-                    reached_pub.publish(wp_reached);
-                    
-                    gotWP = false;
-                    speed = 0;
-                    direction = 0;
-                    a_error = 0;
-                    a_integral = 0;
-                    a_prev = 0;
-                    d_target = 0;
-                    d_prev = 0;
-                    d_integral = 0;
+                    reachedGoal();
                 }
                 else
                 {
                     current_waypoint = waypoints.front();
                     //might also need to reset the angle errors
-                    a_integral = 0;
-                    a_prev = 0;
-                    d_integral = 0;
-                    d_prev = 0;
+                    distance_pid.reset();
+                    angle_pid.reset();
                 }
             }
         }
 
         //ROS_INFO("x: %f, y: %f, z: %f\n", curr_loc.x, curr_loc.y, curr_loc.z);
 
-        if (gotWP)
+        if (gotWP && !use_tracker)
         {
             a_error = get_angle_error(curr_loc, current_waypoint, quat);
             //if (a_error > M_PI) a_error -= 2*M_PI;
@@ -187,12 +262,8 @@ void drive()
             
             d_target = sqrt(pow(curr_loc.x - current_waypoint.x,2) + pow(curr_loc.y - current_waypoint.y,2));
             
-            double vel_pid = get_pid_distance(d_target,d_prev);
-            double ang_pid = get_pid_angle(a_error, a_prev);
-            
-            //Update error terms for PID
-            d_prev = d_target;
-            a_prev = a_error;
+            double vel_pid = distance_pid.updateError(d_target);
+            double ang_pid = angle_pid.updateError(a_error);
             
             speed = vel_sign * vel_pid;
             direction = vel_sign * ang_pid;
@@ -216,44 +287,32 @@ void drive()
     drive_pub.publish(drive_msg);
 }
 
-void printToFile()
+void getWP(const geometry_msgs::PoseStamped& stamped_point)
 {
-    std::ofstream positionFile;
-    positionFile.open (dir_path+"/posData_"+time_buffer+".txt", std::ios::app);
-    
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && !isDriving)
+    QueuedWaypoint wp;
+    wp.point = stamped_point.pose.position;
+    wp.last = stamped_point.header.frame_id == "1";
+    if (!wp_queue.push(wp))
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ROS_WARN("Waypoint queue full, dropped x: %f, y: %f", wp.point.x, wp.point.y);
     }
     
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && isDriving)
+    if(!isDriving)
     {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << vicon_position.x << ", " << vicon_position.y << ", " << vicon_position.z << ", ";
-        
-        printrate.sleep();
+        isDriving = true;
     }
-    positionFile.close();
 }
 
-void getWP(const geometry_msgs::PoseStamped& stamped_point)
+// A whole path in one message, drive swaps it in for the waypoints left at once
+void getPath(const nav_msgs::PathConstPtr& path)
 {
-    geometry_msgs::Point point = stamped_point.pose.position;
-    
-    waypoints.push_back(point);
-    
-    // wait until we get the final point
-    if(stamped_point.header.frame_id == "1")
+    if (path->poses.empty())
     {
-        current_waypoint = waypoints.front();
-        gotWP = true;
+        ROS_WARN("Empty path ignored");
+        return;
     }
-    
+    new_path.write(path);
+
     if(!isDriving)
     {
         isDriving = true;
@@ -269,12 +328,41 @@ int main(int argc, char **argv)
     n.param<std::string>("vicon_obj", vicon_obj, "hotdec_car");
 
     std::cout << "Vicon Object: " << vicon_obj << std::endl;
+
+    // pid steers towards one waypoint at a time, pure_pursuit and stanley follow the path through them, see
+    // PathTracker.h
+    std::string controller;
+    n.param<std::string>("controller", controller, "pid");
+    if (controller == "pure_pursuit" || controller == "stanley")
+    {
+        TrackerParams tp;
+        tp.max_steer = MAX_ANGLE;
+        tp.goal_radius = EPSILON_RADIUS;
+        n.param<double>("tracker/wheelbase", tp.wheelbase, tp.wheelbase);
+        n.param<double>("tracker/cruise_speed", tp.cruise_speed, tp.cruise_speed);
+        n.param<double>("tracker/min_speed", tp.min_speed, tp.min_speed);
+        n.param<double>("tracker/decel", tp.decel, tp.decel);
+        n.param<double>("tracker/lateral_accel", tp.lateral_accel, tp.lateral_accel);
+        n.param<double>("tracker/lookahead_min", tp.lookahead_min, tp.lookahead_min);
+        n.param<double>("tracker/lookahead_gain", tp.lookahead_gain, tp.lookahead_gain);
+        n.param<double>("tracker/lookahead_max", tp.lookahead_max, tp.lookahead_max);
+        n.param<double>("tracker/stanley_gain", tp.stanley_gain, tp.stanley_gain);
+        n.param<double>("tracker/stanley_softening", tp.stanley_softening, tp.stanley_softening);
+        tp.cruise_speed = fmin(tp.cruise_speed, MAX_SPEED);
+        tracker.configure(controller == "stanley" ? TRACK_STANLEY : TRACK_PURE_PURSUIT, tp);
+        use_tracker = true;
+    }
+    else if (controller != "pid")
+    {
+        ROS_WARN("Unknown controller %s, using pid", controller.c_str());
+    }
+    std::cout << "Controller: " << (use_tracker ? controller : "pid") << std::endl;
     
     reached_pub = n.advertise<std_msgs::String>("reached", 1);
     drive_pub = n.advertise<ackermann_msgs::AckermannDriveStamped>("/ackermann_cmd", 1);
 
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
     ros::Subscriber waypoint = n.subscribe("waypoint", 50, getWP);  // second parameter is num of buffered messages
+    ros::Subscriber path_sub = n.subscribe("path", 1, getPath);
 
     dir_path = ros::package::getPath("cyphy_car");
     
@@ -284,16 +372,43 @@ int main(int argc, char **argv)
     struct tm * timeinfo;
     timeinfo = localtime(&rawtime);
     strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
-    
+
+    // Every pose while driving, see TrajectoryRecorder
+    bool record_trajectory, compress_trajectory;
+    n.param<bool>("record_trajectory", record_trajectory, false);
+    n.param<bool>("compress_trajectory", compress_trajectory, true);
+    if (record_trajectory)
+    {
+        const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+        trajectory.reset(new TrajectoryRecorder(dir_path+"/posData_"+time_buffer+ext, "cyphy_car/waypoint",
+                                                {"vicon_x", "vicon_y", "vicon_z"}, compress_trajectory));
+    }
+
+    // Lines of the control loops at most once per log_throttle [s] each, and all of them to log_file if set
+    double log_throttle;
+    std::string log_file;
+    n.param<double>("log_throttle", log_throttle, 1.0);
+    n.param<std::string>("log_file", log_file, "");
+    async_log::start(log_throttle, log_file);
+
     std::cout << "Starting waypoint follower" << std::endl;
     
-    drive_thread = std::thread(drive);
-    //print_thread = std::thread(printToFile);
+    // The pose on a queue and thread of their own (sensor_priority, sensor_cpus), so it never waits behind the waypoint
+    // and path callbacks of ros::spin
+    CallbackThread sensors(n, "sensor");
+    ros::Subscriber sub = sensors.node().subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+
+    // SCHED_FIFO priority, CPUs and phase of the drive loop, see RealtimeThread.h
+    n.param<double>("drive_phase", drive_phase, 0.0);
+    lock_memory(n);
+    drive_thread = start_thread("drive", load_thread_config(n, "drive"), drive);
 
     ros::spin();
     
+    sensors.stop();
     drive_thread.join();
-    //print_thread.join();
+    trajectory.reset();
+    async_log::stop();
     
     ackermann_msgs::AckermannDriveStamped drive_msg;
     drive_msg.drive.speed = 0;
@@ -0,0 +1,61 @@
+//
+// First control of the waypoint MPC over a grid of waypoint offsets, solved
+// offline by mpc_table_builder and looked up instead of an online solve.
+//
+
+#ifndef MPC_CONTROL_TABLE_H
+#define MPC_CONTROL_TABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * The cost of the waypoint MPC only depends on where the waypoint lies
+ * relative to the car, so the first steering and speed of its solution are a
+ * function of the waypoint in the car frame (x ahead, y to the left). The
+ * table holds them on a regular nx x ny grid as float pairs and interpolates
+ * bilinearly. A lookup fails, and the caller solves online, outside the grid,
+ * next to a grid point no solve succeeded at, or in a cell whose corners
+ * disagree by more than max_steer_spread or max_speed_spread. Those are the
+ * cells across which the solution jumps, e.g. from driving forward to
+ * reversing, where blending the corners gives neither.
+ *
+ * On disk: "CYMPCTAB", version, nx, ny, the grid bounds, the fingerprint of
+ * the problem it was solved for, then the pairs row by row, all in the byte
+ * order of the host.
+ */
+class ControlTable {
+public:
+    ControlTable();
+    ControlTable(size_t nx, size_t ny, double x_min, double x_max, double y_min, double y_max, uint64_t problem);
+
+    // Corners of a cell further apart than this fall back to the online solve [rad], [m/s]
+    double max_steer_spread;
+    double max_speed_spread;
+
+    size_t size_x() const { return nx; }
+    size_t size_y() const { return ny; }
+    // Offset of grid point i, j [m]
+    double x_at(size_t i) const;
+    double y_at(size_t j) const;
+    // Fingerprint of the problem the table was solved for, see MPC::fingerprint
+    uint64_t problem() const { return problem_id; }
+
+    // Solution at grid point i, j, NaN for none
+    void set(size_t i, size_t j, double delta, double v);
+
+    // Steering and speed for the waypoint at dx, dy in the car frame, false to solve online
+    bool lookup(double dx, double dy, double &delta, double &v) const;
+
+    bool save(const std::string &file) const;
+    bool load(const std::string &file);
+
+private:
+    size_t nx, ny;
+    double x_min, x_max, y_min, y_max;
+    uint64_t problem_id;
+    std::vector<float> values;  // delta, v of each point, row j after row j - 1
+};
+
+#endif //MPC_CONTROL_TABLE_H
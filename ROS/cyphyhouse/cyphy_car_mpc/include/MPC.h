@@ -7,19 +7,69 @@
 #include "geometry_msgs/PointStamped.h"
 #include <vector>
 #include "Eigen/Dense"
+#include "cyphy_control/CarMpc.h"
+#include "cyphy_control/SpeedProfile.h"
+#include "ControlTable.h"
+#include <memory>
 
 using namespace std;
 
-class MPC {
+/*
+ * The CarMpc problem of this package and the weights of its terms: the
+ * distance of every step from one waypoint and the inputs, or with
+ * timed_reference the distance of every step from where a SpeedProfile of
+ * the path puts it at that time (ReferenceCost).
+ */
+struct MpcProblem : CarProblem {
+    //State cost weights
+    double x_weight = 400;
+    double y_weight = 400;
+    bool timed_reference = false;
+    double reference_weight = 80;
+
+    //Input and input derivative cost weights
+    double delta_weight = 200;
+    double delta_rate_weight = 250;
+    double v_weight = 50;
+    double v_rate_weight = 200;
+};
+
+class MPC : public CarMpc {
 public:
-    MPC();
+    // Initial guess of a solve without warm start
+    enum ColdStart {
+        COLD_ZERO,      // all zero but the initial state
+        COLD_STRAIGHT,  // constant speed straight at the waypoint
+        COLD_REVERSE    // constant speed backwards along the heading
+    };
+
+    explicit MPC(const MpcProblem &problem = MpcProblem());
+
+    ColdStart cold_start;
+    // First controls solved offline, looked up before solving online, none if null. Its problem has to match
+    std::shared_ptr<const ControlTable> table;
+    // Solve the model given an initial state into solution, see CarMpc::Solve. A table lookup only sets the first
+    // controls and empties the trajectory
+    void Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint, Solution &solution);
+    // The same into last, returns the steering and speed of the first step
+    vector<double> Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint);
+    // Solve a timed_reference problem given the reference of each step, see references
+    void Solve(const Eigen::VectorXd &state, const std::vector<double> &reference, Solution &solution);
+
+    // Reference of each step of the horizon into reference, the N x then the N y: profile from where the car is
+    // on it. Moves the progress of profile
+    void references(SpeedProfile &profile, const Eigen::VectorXd &state, std::vector<double> &reference) const;
+
+    // Identifies the problem a table is solved for: all of it but the position bounds, which the table ignores
+    static uint64_t fingerprint(const MpcProblem &problem);
 
-    virtual ~MPC();
-    vector<double> x_vals;
-    vector<double> y_vals;
-    // Solve the model given an initial state
-    vector<double> Solve(Eigen::VectorXd state, geometry_msgs::Point waypoint);
+protected:
+    bool cold_guess(double x, double y, double psi, const double *params, Guess &guess) const;
 
+private:
+    MpcProblem problem;
+    // Time of each state of the horizon [s]
+    std::vector<double> step_times;
 };
 
 #endif //MPC_MPC_H
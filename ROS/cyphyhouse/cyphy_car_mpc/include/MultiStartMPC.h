@@ -0,0 +1,70 @@
+//
+// Several starting points of one MPC problem solved in parallel.
+//
+
+#ifndef MPC_MULTI_START_MPC_H
+#define MPC_MULTI_START_MPC_H
+#include "MPC.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * Solves the same problem from the shifted last trajectory, from zero, from a
+ * straight line at the waypoint and from reversing, one MPC (tape and Ipopt
+ * instance) and one worker thread each, and returns the feasible solution of
+ * least cost among those finished by the deadline. A solve that misses it
+ * keeps running and sits out the next ticks until it is done, unless the
+ * candidates are anytime solvers (CarMpc::anytime), which stop at the
+ * deadline with what they have. The best solution becomes the warm start of
+ * the shifted candidate.
+ *
+ * MUMPS, the default linear solver of Ipopt, is not thread-safe: linear_solver
+ * has to name one that is (ma27, ma57 or ma97 of HSL).
+ */
+class MultiStartMPC {
+public:
+    MultiStartMPC(const MpcProblem &problem, const std::string &linear_solver);
+
+    ~MultiStartMPC();
+    // Time [s] a Solve waits for the candidates
+    double deadline;
+    // Candidates stop at the deadline and fall back as CarMpc::anytime describes
+    bool anytime;
+    // Ring every Solve is recorded into as the chosen candidate's solve and the time waited, none if null
+    SolveStats *stats;
+    // Solve the model given an initial state into solution, same result as MPC::Solve
+    void Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint, CarMpc::Solution &solution);
+    // The same for a timed_reference problem given the reference of each step, see MPC::references
+    void Solve(const Eigen::VectorXd &state, const std::vector<double> &reference, CarMpc::Solution &solution);
+
+private:
+    struct Candidate {
+        std::unique_ptr<MPC> mpc;
+        std::thread worker;
+        // Round handed to the worker and the last one it finished
+        unsigned round = 0;
+        unsigned done = 0;
+        Eigen::VectorXd state;
+        geometry_msgs::Point waypoint;
+        std::vector<double> reference;  // Empty to solve for waypoint
+        CarMpc::Solution solution;
+    };
+
+    void work(size_t index);
+    void solveRound(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint,
+                    const std::vector<double> &reference, CarMpc::Solution &solution);
+
+    std::vector<Candidate> candidates;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    unsigned round;
+    bool stop;
+    // Solution of the last round a candidate finished
+    CarMpc::Solution last;
+};
+
+#endif //MPC_MULTI_START_MPC_H
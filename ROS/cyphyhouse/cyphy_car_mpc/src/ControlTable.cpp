@@ -0,0 +1,105 @@
+#include "ControlTable.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static const char MAGIC[8] = {'C', 'Y', 'M', 'P', 'C', 'T', 'A', 'B'};
+static const uint32_t VERSION = 1;
+
+ControlTable::ControlTable() : ControlTable(0, 0, 0, 0, 0, 0, 0) {}
+
+ControlTable::ControlTable(size_t nx, size_t ny, double x_min, double x_max, double y_min, double y_max,
+                           uint64_t problem)
+    : max_steer_spread(0.1), max_speed_spread(0.5), nx(nx), ny(ny), x_min(x_min), x_max(x_max), y_min(y_min),
+      y_max(y_max), problem_id(problem), values(2 * nx * ny, NAN) {}
+
+double ControlTable::x_at(size_t i) const {
+    return nx > 1 ? x_min + (x_max - x_min) * i / (nx - 1) : x_min;
+}
+
+double ControlTable::y_at(size_t j) const {
+    return ny > 1 ? y_min + (y_max - y_min) * j / (ny - 1) : y_min;
+}
+
+void ControlTable::set(size_t i, size_t j, double delta, double v) {
+    values[2 * (j * nx + i)] = static_cast<float>(delta);
+    values[2 * (j * nx + i) + 1] = static_cast<float>(v);
+}
+
+bool ControlTable::lookup(double dx, double dy, double &delta, double &v) const {
+    if (nx < 2 || ny < 2 || !(dx >= x_min && dx <= x_max && dy >= y_min && dy <= y_max)) {
+        return false;
+    }
+    const double gx = (dx - x_min) / (x_max - x_min) * (nx - 1);
+    const double gy = (dy - y_min) / (y_max - y_min) * (ny - 1);
+    const size_t i = std::min(static_cast<size_t>(gx), nx - 2);
+    const size_t j = std::min(static_cast<size_t>(gy), ny - 2);
+    const double u = gx - i, w = gy - j;
+
+    const float *c[4] = {&values[2 * (j * nx + i)], &values[2 * (j * nx + i + 1)], &values[2 * ((j + 1) * nx + i)],
+                         &values[2 * ((j + 1) * nx + i + 1)]};
+    float min_delta = c[0][0], max_delta = c[0][0], min_v = c[0][1], max_v = c[0][1];
+    for (const float *corner : c) {
+        // NaN compares false, so check for it first
+        if (std::isnan(corner[0]) || std::isnan(corner[1])) {
+            return false;
+        }
+        min_delta = std::min(min_delta, corner[0]);
+        max_delta = std::max(max_delta, corner[0]);
+        min_v = std::min(min_v, corner[1]);
+        max_v = std::max(max_v, corner[1]);
+    }
+    if (max_delta - min_delta > max_steer_spread || max_v - min_v > max_speed_spread) {
+        return false;
+    }
+
+    const double k[4] = {(1 - u) * (1 - w), u * (1 - w), (1 - u) * w, u * w};
+    delta = v = 0;
+    for (size_t n = 0; n < 4; ++n) {
+        delta += k[n] * c[n][0];
+        v += k[n] * c[n][1];
+    }
+    return true;
+}
+
+bool ControlTable::save(const std::string &file) const {
+    std::ofstream out(file.c_str(), std::ios::binary);
+    const uint32_t header[3] = {VERSION, static_cast<uint32_t>(nx), static_cast<uint32_t>(ny)};
+    const double bounds[4] = {x_min, x_max, y_min, y_max};
+    out.write(MAGIC, sizeof(MAGIC));
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(bounds), sizeof(bounds));
+    out.write(reinterpret_cast<const char *>(&problem_id), sizeof(problem_id));
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(float));
+    return static_cast<bool>(out);
+}
+
+bool ControlTable::load(const std::string &file) {
+    std::ifstream in(file.c_str(), std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    uint32_t header[3];
+    double bounds[4];
+    uint64_t id;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    in.read(reinterpret_cast<char *>(bounds), sizeof(bounds));
+    in.read(reinterpret_cast<char *>(&id), sizeof(id));
+    if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || header[0] != VERSION) {
+        return false;
+    }
+    std::vector<float> read(2 * static_cast<size_t>(header[1]) * header[2]);
+    in.read(reinterpret_cast<char *>(read.data()), read.size() * sizeof(float));
+    if (!in) {
+        return false;
+    }
+    nx = header[1];
+    ny = header[2];
+    x_min = bounds[0];
+    x_max = bounds[1];
+    y_min = bounds[2];
+    y_max = bounds[3];
+    problem_id = id;
+    values.swap(read);
+    return true;
+}
@@ -1,232 +1,113 @@
 #include "MPC.h"
-#include <cppad/cppad.hpp>
-#include <cppad/ipopt/solve.hpp>
-#include "Eigen/Dense"
+#include "cyphy_control/CostTerms.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-#include "geometry_msgs/PoseStamped.h"
-#include "geometry_msgs/PointStamped.h"
-
-using CppAD::AD;
-
-// Set the timestep length and duration
-size_t N = 10;
-double dt = 0.1;
-
-//Geometric parameters of car
-const double lr = 0.3;
-
-//State and input hard constraints
-const double x_bound = 3.0;
-const double y_bound = 3.0;
-const double dir_bound = 0.35;
-const double vel_bound = 3.0;
-
-//Define target states
-double x_ref, y_ref;
-
-//Initialize
-size_t x_start = 0;
-size_t y_start = x_start + N;
-size_t psi_start = y_start + N;
-size_t v_start = psi_start + N;
-size_t delta_start = v_start + N - 1;
-
-class FG_eval {
-public:
-    FG_eval() = default;
-    typedef CPPAD_TESTVECTOR(AD<double>) ADvector;
-    void operator()(ADvector& fg, const ADvector& vars) {
-        //Initialize cost at 0
-        fg[0] = 0;
-
-        //State cost weights
-        const int x_weight = 400;
-        const int y_weight = 400;
-        
-
-        //Input and input derivative cost weights
-        const double delta_weight = 200;
-        const double delta_rate_weight = 250;
-        const double v_weight = 50;
-        const double v_rate_weight = 200;
-
-        //Set up the cost function
-        for (unsigned int t = 0; t < N; ++t){
-            //Penalize x-distance from waypoint and boundary
-            fg[0] += x_weight * CppAD::pow(vars[x_start + t] - x_ref,2);
-            //Penalize y-distance from waypoint and boundary
-            fg[0] += y_weight * CppAD::pow(vars[y_start + t] - y_ref, 2);
-        }
-
-        //Minimize inputs
-        for (unsigned int t = 0; t < N - 1; ++t) {
-            fg[0] += delta_weight * CppAD::pow(vars[delta_start + t], 2);
-            fg[0] += v_weight * CppAD::pow(vars[v_start + t], 2);
-        }
-
-        //Minimize input derivatives
-        for (unsigned int t = 0; t < N - 2; ++t) {
-            fg[0] += delta_rate_weight * CppAD::pow(vars[delta_start + t + 1] - vars[delta_start + t], 2);
-            fg[0] += v_rate_weight * CppAD::pow(vars[v_start + t + 1] - vars[v_start + t], 2);
-        }
-
-        //Set the constraints at time t=0
-        fg[1 + x_start] = vars[x_start];
-        fg[1 + y_start] = vars[y_start];
-        fg[1 + psi_start] = vars[psi_start];
-
-        for (unsigned int t = 1; t < N; ++t) {
-            //State at time t+1
-            AD<double> x1 = vars[x_start + t];
-            AD<double> y1 = vars[y_start + t];
-            AD<double> psi1 = vars[psi_start + t];
-
-            //State at time t
-            AD<double> x0 = vars[x_start + t - 1];
-            AD<double> y0 = vars[y_start + t - 1];
-            AD<double> psi0 = vars[psi_start + t - 1];
-
-            //Actuations at time, t
-            AD<double> delta0 = vars[delta_start + t - 1];
-            AD<double> v0 = vars[v_start + t - 1];
-
-            //Set up the SS model constraints for time steps [1,N]
-            fg[1 + x_start + t] = x1 - (x0 + v0 * CppAD::cos(psi0) * dt);
-            fg[1 + y_start + t] = y1 - (y0 + v0 * CppAD::sin(psi0) * dt);
-            fg[1 + psi_start + t] = psi1 - (psi0 + v0 * CppAD::tan(delta0) * dt / lr);
-        }
+#include <cstring>
+
+static CarMpc::Terms cost_terms(const MpcProblem &p) {
+    CarMpc::Terms terms;
+    if (p.timed_reference) {
+        terms.emplace_back(new ReferenceCost(p.reference_weight, p.reference_weight));
+    } else {
+        terms.emplace_back(new WaypointCost(p.x_weight, p.y_weight));
     }
-};
+    terms.emplace_back(new InputCost(p.delta_weight, p.delta_rate_weight, p.v_weight, p.v_rate_weight));
+    return terms;
+}
 
 //
 // MPC class definition implementation.
 //
-MPC::MPC() = default;
-MPC::~MPC() = default;
-
-vector<double> MPC::Solve(Eigen::VectorXd state, geometry_msgs::Point waypoint) {
-    bool ok = true;
-    typedef CPPAD_TESTVECTOR(double) Dvector;
-    x_ref = waypoint.x;
-    y_ref = waypoint.y;
-    double x = state[0];
-    double y = state[1];
-    double psi = state[2];
-
-    // Set number of model variables
-    size_t n_vars = N * 3 + (N - 1) * 2; // 3N state elements, 2(N-1) actuators
-    // Set the number of constraints
-    size_t n_constraints = N * 3; // (x, y, psi)
-
-    // Initialize model variables to zero
-    Dvector vars(n_vars);
-    for (unsigned int i = 0; i < n_vars; ++i) {
-        vars[i] = 0;
+MPC::MPC(const MpcProblem &problem)
+    : CarMpc(problem, cost_terms(problem), "cyphy_car_mpc"), cold_start(COLD_ZERO), problem(problem) {
+    for (size_t k = 0; k < problem.N; ++k) {
+        step_times.push_back(problem.time(k));
     }
+}
 
-    //Set the initial state
-    vars[x_start] = x;
-    vars[y_start] = y;
-    vars[psi_start] = psi;
-
-    Dvector vars_lowerbound(n_vars);
-    Dvector vars_upperbound(n_vars);
+vector<double> MPC::Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint) {
+    Solve(state, waypoint, last);
+    return {last.delta, last.v};
+}
 
-    //Define positive and negative infinities
-    for (unsigned int i = 0; i < delta_start; ++i) {
-        vars_lowerbound[i] = -1.0e19;
-        vars_upperbound[i] = 1.0e19;
+void MPC::Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint, Solution &solution) {
+    if (table) {
+        // The waypoint in the car frame, the table holds the solution for it
+        const auto tic = std::chrono::steady_clock::now();
+        const double c = std::cos(state[2]), s = std::sin(state[2]);
+        const double wx = waypoint.x - state[0], wy = waypoint.y - state[1];
+        if (table->lookup(c * wx + s * wy, -s * wx + c * wy, solution.delta, solution.v)) {
+            solution.source = SOLVED;
+            if (stats) {
+                SolveSample sample;
+                sample.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - tic).count();
+                stats->record(sample);
+            }
+            solution.x_vals.clear();
+            solution.y_vals.clear();
+            solution.delta_vals.clear();
+            solution.v_vals.clear();
+            return;
+        }
     }
+    const double params[] = {waypoint.x, waypoint.y};
+    CarMpc::Solve(state[0], state[1], state[2], params, 2, solution);
+}
 
-    //X and Y bounds
-    for (unsigned int i = x_start; i < y_start; ++i) {
-        vars_lowerbound[i] = -x_bound;
-        vars_upperbound[i] = x_bound;
-    }
+void MPC::Solve(const Eigen::VectorXd &state, const std::vector<double> &reference, Solution &solution) {
+    CarMpc::Solve(state[0], state[1], state[2], reference.data(), reference.size(), solution);
+}
 
-    for (unsigned int i = y_start; i < psi_start; ++i) {
-        vars_lowerbound[i] = -y_bound;
-        vars_upperbound[i] = y_bound;
-    }
+void MPC::references(SpeedProfile &profile, const Eigen::VectorXd &state, std::vector<double> &reference) const {
+    reference.resize(2 * problem.N);
+    profile.references(profile.progress(state[0], state[1]), step_times.data(), problem.N, reference.data());
+}
 
-    // Steering angle upper and lower limits [rad]
-    for (unsigned int i = delta_start; i < n_vars; ++i) {
-        vars_lowerbound[i] = -dir_bound;
-        vars_upperbound[i] = dir_bound;
+uint64_t MPC::fingerprint(const MpcProblem &problem) {
+    MpcProblem p = problem;
+    p.x_bound = p.y_bound = 0;
+    // FNV-1a of the plain numbers of the problem, the same in every build of the same layout
+    unsigned char bytes[sizeof(p)];
+    std::memcpy(bytes, &p, sizeof(p));
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char b : bytes) {
+        h = (h ^ b) * 1099511628211ull;
     }
+    return h;
+}
 
-    // Velocity upper and lower limits [m/s]
-    for (unsigned int i = v_start; i < delta_start; ++i) {
-        vars_lowerbound[i] = -vel_bound;
-        vars_upperbound[i] = vel_bound;
+bool MPC::cold_guess(double x, double y, double psi, const double *params, Guess &guess) const {
+    if (problem.timed_reference) {
+        // Along the reference at the speed between two of its steps, the heading kept where it stands still
+        const size_t n = problem.N;
+        guess.x.push_back(x);
+        guess.y.push_back(y);
+        guess.psi.push_back(psi);
+        for (size_t t = 1; t < n; ++t) {
+            const double dx = params[t] - guess.x.back(), dy = params[n + t] - guess.y.back();
+            const double d = std::hypot(dx, dy);
+            guess.v.push_back(std::min(problem.vel_bound, d / problem.step(t - 1)));
+            guess.psi.push_back(d > 1e-3 ? std::atan2(dy, dx) : guess.psi.back());
+            guess.x.push_back(params[t]);
+            guess.y.push_back(params[n + t]);
+        }
+        return true;
     }
-
-    // Lower and upper bounds for hard constraints (0 except for initial states)
-    Dvector constraints_lowerbound(n_constraints);
-    Dvector constraints_upperbound(n_constraints);
-    for (unsigned int i = 0; i < n_constraints; ++i) {
-        constraints_lowerbound[i] = 0.0;
-        constraints_upperbound[i] = 0.0;
+    if (cold_start == COLD_ZERO) {
+        return false;
     }
-
-    //Initial states constrained to last measured value
-    constraints_lowerbound[x_start] = x;
-    constraints_lowerbound[y_start] = y;
-    constraints_lowerbound[psi_start] = psi;
-
-    constraints_upperbound[x_start] = x;
-    constraints_upperbound[y_start] = y;
-    constraints_upperbound[psi_start] = psi;
-
-    // Object that computes objective and constraints
-    FG_eval fg_eval;
-
-    //
-    // NOTE: You don't have to worry about these options
-    //
-    // options for IPOPT solver
-    std::string options;
-    // Uncomment this if you'd like more print information
-    options += "Integer print_level  0\n";
-    // NOTE: Setting sparse to true allows the solver to take advantage
-    // of sparse routines, this makes the computation MUCH FASTER. If you
-    // can uncomment 1 of these and see if it makes a difference or not but
-    // if you uncomment both the computation time should go up in orders of
-    // magnitude.
-    options += "Sparse  true        forward\n";
-    //options += "Sparse  true        reverse\n";
-    // NOTE: Currently the solver has a maximum time limit of 0.5 seconds.
-    // Change this as you see fit.
-    options += "Numeric max_cpu_time          0.099\n";
-
-    // place to return solution
-    CppAD::ipopt::solve_result<Dvector> solution;
-
-    // solve the problem
-    CppAD::ipopt::solve<Dvector, FG_eval>(
-            options, vars, vars_lowerbound, vars_upperbound, constraints_lowerbound,
-            constraints_upperbound, fg_eval, solution);
-
-    // Check some of the solution values
-    ok &= solution.status == CppAD::ipopt::solve_result<Dvector>::success;
-
-    // Cost
-    //auto cost = solution.obj_value;
-    //std::cout << "Cost " << cost << std::endl;
-
-    std::vector<double> result;
-
-    result.push_back(solution.x[delta_start]);
-    result.push_back(solution.x[v_start]);
-
-    //Clear the mpc x & y value vectors
-    this->x_vals.clear();
-    this->y_vals.clear();
-
-    //push back the predicted x,y values into the attributes
-    for (unsigned int i = 1; i < N; ++i){
-        this->x_vals.push_back(solution.x[x_start+i]);
-        this->y_vals.push_back(solution.x[y_start+i]);
+    // Constant speed that covers the distance to the waypoint within the horizon, no steering
+    const double wx = params[0];
+    const double wy = params[1];
+    const double speed = std::min(problem.vel_bound, std::hypot(wx - x, wy - y) / problem.time(problem.N - 1));
+    const double v = (cold_start == COLD_REVERSE) ? -speed : speed;
+    const double heading = (cold_start == COLD_REVERSE) ? psi : std::atan2(wy - y, wx - x);
+    for (unsigned int t = 0; t < problem.N; ++t) {
+        guess.x.push_back(x + v * std::cos(heading) * problem.time(t));
+        guess.y.push_back(y + v * std::sin(heading) * problem.time(t));
+        guess.psi.push_back(heading);
     }
-    return result;
+    guess.v.assign(problem.N - 1, v);
+    return true;
 }
@@ -0,0 +1,138 @@
+#include "MultiStartMPC.h"
+#include <coin/IpReturnCodes.hpp>
+#include <chrono>
+
+MultiStartMPC::MultiStartMPC(const MpcProblem &problem, const std::string &linear_solver)
+    : deadline(0.099), anytime(false), stats(nullptr), candidates(4), round(0), stop(false) {
+    // CppAD has to know the threads before any of them records or evaluates, worker i is thread i + 1
+    CarMpc::parallel_setup(candidates.size() + 1);
+
+    const MPC::ColdStart cold[] = {MPC::COLD_ZERO, MPC::COLD_ZERO, MPC::COLD_STRAIGHT, MPC::COLD_REVERSE};
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        candidates[i].mpc.reset(new MPC(problem));
+        candidates[i].mpc->SetOption("linear_solver", linear_solver);
+        // Candidate 0 starts from the shifted best solution, the others from scratch every time
+        candidates[i].mpc->warm_start = (i == 0);
+        candidates[i].mpc->cold_start = cold[i];
+    }
+    CarMpc::parallel_begin();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        candidates[i].worker = std::thread(&MultiStartMPC::work, this, i);
+    }
+}
+
+MultiStartMPC::~MultiStartMPC() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start_cv.notify_all();
+    for (Candidate &c : candidates) {
+        c.worker.join();
+    }
+    CarMpc::parallel_end();
+}
+
+void MultiStartMPC::work(size_t index) {
+    CarMpc::set_thread(index + 1);
+    Candidate &c = candidates[index];
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        start_cv.wait(lock, [&] { return stop || c.round != c.done; });
+        if (stop) {
+            return;
+        }
+        // The inputs are not touched again before done is set
+        lock.unlock();
+        if (c.reference.empty()) {
+            c.mpc->Solve(c.state, c.waypoint, c.solution);
+        } else {
+            c.mpc->Solve(c.state, c.reference, c.solution);
+        }
+        lock.lock();
+        c.done = c.round;
+        done_cv.notify_all();
+    }
+}
+
+void MultiStartMPC::Solve(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint,
+                          CarMpc::Solution &solution) {
+    static const std::vector<double> none;
+    solveRound(state, waypoint, none, solution);
+}
+
+void MultiStartMPC::Solve(const Eigen::VectorXd &state, const std::vector<double> &reference,
+                          CarMpc::Solution &solution) {
+    solveRound(state, geometry_msgs::Point(), reference, solution);
+}
+
+void MultiStartMPC::solveRound(const Eigen::VectorXd &state, const geometry_msgs::Point &waypoint,
+                               const std::vector<double> &reference, CarMpc::Solution &solution) {
+    const auto tic = std::chrono::steady_clock::now();
+    const auto until = tic + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(deadline));
+    // CarMpc::deadline is on the system clock
+    const double system_until =
+        std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count() + deadline;
+    std::unique_lock<std::mutex> lock(mutex);
+    ++round;
+    for (Candidate &c : candidates) {
+        // One still busy with an earlier round sits this one out
+        if (c.round == c.done) {
+            c.state = state;
+            c.waypoint = waypoint;
+            // Assigned in place, the storage stays once sized
+            c.reference.assign(reference.begin(), reference.end());
+            c.mpc->anytime = anytime;
+            c.mpc->deadline = system_until;
+            c.round = round;
+        }
+    }
+    start_cv.notify_all();
+    done_cv.wait_until(lock, until, [&] {
+        for (const Candidate &c : candidates) {
+            if (c.round == round && c.done != round) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // Least cost of the feasible ones, of all finished ones if none is
+    Candidate *best = nullptr;
+    bool best_feasible = false;
+    for (Candidate &c : candidates) {
+        if (c.done != round) {
+            continue;
+        }
+        const bool feasible = c.mpc->feasible();
+        if (!best || (feasible && !best_feasible) ||
+            (feasible == best_feasible && c.mpc->cost() < best->mpc->cost())) {
+            best = &c;
+            best_feasible = feasible;
+        }
+    }
+    if (stats) {
+        SolveSample sample;
+        if (best) {
+            sample = best->mpc->last_solve();
+        } else {
+            sample.status = Ipopt::Maximum_CpuTime_Exceeded;
+        }
+        sample.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - tic).count();
+        stats->record(sample);
+    }
+    if (!best) {
+        // Nothing finished in time, keep the last command
+        solution = last;
+        return;
+    }
+
+    // A finished candidate stays idle until the next round, its MPC and solution are ours to read
+    last = best->solution;
+    solution = last;
+    Candidate &shifted = candidates[0];
+    if (best != &shifted && shifted.done == round) {
+        shifted.mpc->adopt(*best->mpc);
+    }
+}
@@ -0,0 +1,78 @@
+//
+// mpc_table_builder: solves the waypoint MPC offline for every waypoint of a
+// grid around the car and writes the first controls as a ControlTable.
+//
+
+#include "ControlTable.h"
+#include "MPC.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 8) {
+        std::fprintf(stderr,
+                     "usage: %s <table> [nx ny x_min x_max y_min y_max]\n"
+                     "  the first controls for waypoints at x ahead, y left of the car [m],\n"
+                     "  by default 61 x 61 over -3..3 x -3..3\n",
+                     argv[0]);
+        return 2;
+    }
+    size_t nx = 61, ny = 61;
+    double x_min = -3, x_max = 3, y_min = -3, y_max = 3;
+    if (argc == 8) {
+        nx = std::strtoul(argv[2], nullptr, 10);
+        ny = std::strtoul(argv[3], nullptr, 10);
+        x_min = std::atof(argv[4]);
+        x_max = std::atof(argv[5]);
+        y_min = std::atof(argv[6]);
+        y_max = std::atof(argv[7]);
+    }
+    if (nx < 2 || ny < 2 || x_max <= x_min || y_max <= y_min) {
+        std::fprintf(stderr, "need at least 2 x 2 points over a grid of positive size\n");
+        return 2;
+    }
+
+    // The car starts at the origin, the position bounds must not cut into any trajectory of the grid
+    MpcProblem problem;
+    const uint64_t fingerprint = MPC::fingerprint(problem);
+    problem.x_bound = std::max(std::abs(x_min), std::abs(x_max)) + problem.vel_bound * problem.time(problem.N);
+    problem.y_bound = std::max(std::abs(y_min), std::abs(y_max)) + problem.vel_bound * problem.time(problem.N);
+    MPC mpc(problem);
+    mpc.warm_start = false;
+
+    ControlTable table(nx, ny, x_min, x_max, y_min, y_max, fingerprint);
+    Eigen::VectorXd state(3);
+    state << 0, 0, 0;
+    size_t solved = 0;
+    for (size_t j = 0; j < ny; ++j) {
+        for (size_t i = 0; i < nx; ++i) {
+            geometry_msgs::Point waypoint;
+            waypoint.x = table.x_at(i);
+            waypoint.y = table.y_at(j);
+            waypoint.z = 0;
+
+            // Every cold start, the feasible solution of least cost wins
+            double best = std::numeric_limits<double>::infinity();
+            for (MPC::ColdStart start : {MPC::COLD_ZERO, MPC::COLD_STRAIGHT, MPC::COLD_REVERSE}) {
+                mpc.cold_start = start;
+                const vector<double> solution = mpc.Solve(state, waypoint);
+                if (mpc.feasible() && mpc.cost() < best) {
+                    best = mpc.cost();
+                    table.set(i, j, solution[0], solution[1]);
+                }
+            }
+            solved += best < std::numeric_limits<double>::infinity();
+        }
+        std::fprintf(stderr, "\rrow %zu of %zu", j + 1, ny);
+    }
+    std::fprintf(stderr, "\n%zu of %zu points solved\n", solved, nx * ny);
+
+    if (!table.save(argv[1])) {
+        std::fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
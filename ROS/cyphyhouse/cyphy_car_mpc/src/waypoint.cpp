@@ -6,74 +6,306 @@
 #include <cstdbool>
 #include <fstream>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Geometry>
 #include "MPC.h"
+#include "MultiStartMPC.h"
+#include "cyphy_control/AsyncLog.h"
+#include "cyphy_control/LatestBuffer.h"
+#include "cyphy_control/Metrics.h"
+#include "cyphy_control/MpcGovernor.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/SpeedProfile.h"
+#include "cyphy_control/TrajectoryRecorder.h"
 #include "ros/ros.h"
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include <std_msgs/String.h>
 #include "geometry_msgs/PoseStamped.h"
+#include "nav_msgs/Path.h"
 #include "geometry_msgs/PointStamped.h"
 #include <ackermann_msgs/AckermannDriveStamped.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include "ros/package.h"
 #include <chrono>
 
 #define WP_RATE 50.0 //Hz
-#define PRINT_RATE 50.0 //Hz
 
 #define DELTA_DIRECTION  0.01
 #define DELTA_SPEED      0.25
 #define EPSILON_RADIUS   0.25
 #define EPSILON_ANGLE    0.1
 
+#define WP_QUEUE_SIZE 64 // Must be a power of two
+
 bool starl_flag = false;
-bool isDriving = false;
+std::atomic<bool> isDriving(false);
 bool gotWP = false;
 double speed = 0, direction = 0;
 geometry_msgs::Point prev_loc, curr_loc;
 double curr_ang = 0;
 
 std::string bot_num, vicon_obj;
+// Waypoints still to reach, drive owns them
 std::vector<geometry_msgs::Point> waypoints;
 
+// A waypoint as getWP received it, last if it is the final point of its path
+struct QueuedWaypoint
+{
+    geometry_msgs::Point point;
+    bool last;
+};
+
+// Waypoints from getWP to drive
+SPSCQueue<QueuedWaypoint, WP_QUEUE_SIZE> wp_queue;
+
+// Paths from getPath to drive, a newer one replaces one drive has not taken yet
+LatestBuffer<nav_msgs::PathConstPtr> new_path;
+
 ros::Publisher drive_pub;
 ros::Publisher reached_pub;
-
-geometry_msgs::Point deca_position, vicon_position;
+ros::Publisher diagnostics_pub;
+
+// Log of the drive loop, printed and written by the background thread of async_log
+LogChannel drive_log("drive");
+
+// Telemetry of the solves, recorded by the solver and published by publishDiagnostics
+SolveStats solve_stats;
+SolveWindow solve_window;
+double solve_deadline;
+// Effort level the governor runs the MPC at, for the diagnostics
+std::atomic<unsigned> governor_level(0);
+
+// Wake-up jitter of the drive loop, warns once it exceeds jitter_limit [s]. The loop wakes drive_phase [s] into
+// its period, see PeriodicLoop
+LoopJitter drive_jitter(1.0 / WP_RATE);
+double jitter_limit, drive_phase;
+
+// Served on metrics_port
+MetricHistogram *solve_metric;
+bool metrics_started = false;
+
+// Latest positions, written by their callbacks and read by the threads
+Snapshot<geometry_msgs::Point> deca_position;
+Snapshot<geometry_msgs::Pose> vicon_pose;
 geometry_msgs::Point current_waypoint;  // VICON coords
-geometry_msgs::Quaternion quat; //Get orientation
+
+// Trajectory of the drive, recorded by getViconPosition while driving if record_trajectory is set
+std::unique_ptr<TrajectoryRecorder> trajectory;
 
 std::string dir_path;
 char time_buffer[80];
-std::thread drive_thread, print_thread;
+std::thread drive_thread;
 ros::Time wp_time;
 
+// Cleared to stop the threads, a nodelet outlives ros::ok() when it is unloaded
+std::atomic<bool> running(false);
+
 Eigen::VectorXd state(3);
 
+// With timed_reference the MPC tracks a speed profile through all waypoints, fitted when they change, owned by drive
+bool path_changed = false;
+std::vector<TrackPoint> profile_path;   // Waypoints profile was fitted to
+SpeedProfile profile;
+
 void getDecaPosition(const geometry_msgs::Point& point)
 {
-    deca_position = point;
+    deca_position.store(point);
 }
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
 {
-    vicon_position = pose.pose.position;
-    quat = pose.pose.orientation;
+    vicon_pose.store(pose.pose);
+    if (trajectory && isDriving)
+    {
+        const geometry_msgs::Point deca = deca_position.load();
+        trajectory->record(ros::Time::now().toNSec(), pose.pose.position.x, pose.pose.position.y, pose.pose.position.z,
+                           deca.x, deca.y, deca.z);
+    }
+}
+
+// Takes the waypoints getWP queued, driving starts once the final point of a path is in. A path from getPath
+// replaces the waypoints left
+void receiveWaypoints()
+{
+    QueuedWaypoint wp;
+    while (wp_queue.pop(wp))
+    {
+        if (waypoints.size() == 0)
+        {
+            current_waypoint.x = wp.point.x;
+            current_waypoint.y = wp.point.y;
+            //current_waypoint.z = wp.point.z;
+        }
+
+        waypoints.push_back(wp.point);
+
+        // wait until we get the final point
+        if (wp.last)
+        {
+            gotWP = true;
+            path_changed = true;
+            starl_flag = true;
+            wp_time = ros::Time::now();
+        }
+    }
+
+    nav_msgs::PathConstPtr path;
+    if (new_path.read(path))
+    {
+        waypoints.clear();
+        for (size_t i = 0; i < path->poses.size(); i++)
+        {
+            waypoints.push_back(path->poses[i].pose.position);
+        }
+        current_waypoint.x = waypoints.front().x;
+        current_waypoint.y = waypoints.front().y;
+        gotWP = true;
+        path_changed = true;
+        starl_flag = true;
+        wp_time = ros::Time::now();
+    }
+}
+
+// Fits the profile to the waypoints from where the car is, unless they are the ones it has, then only the final
+// point is left to reach
+void fitProfile(const ProfileLimits& limits)
+{
+    std::vector<TrackPoint> path;
+    path.reserve(waypoints.size());
+    for (const geometry_msgs::Point& p : waypoints)
+    {
+        path.push_back(TrackPoint{p.x, p.y});
+    }
+    const bool same = profile_path.size() == path.size() && !profile.empty() &&
+                      std::equal(path.begin(), path.end(), profile_path.begin(),
+                                 [](const TrackPoint& a, const TrackPoint& b) { return a.x == b.x && a.y == b.y; });
+    if (!same)
+    {
+        profile_path = path;
+        path.insert(path.begin(), TrackPoint{curr_loc.x, curr_loc.y});
+        if (!profile.build(path, limits))
+        {
+            profile_path.clear();
+        }
+        drive_log.info("profile: %zu waypoints, %f m in %f s", waypoints.size(), profile.length(), profile.duration());
+    }
+    current_waypoint = waypoints.back();
+    waypoints.assign(1, current_waypoint);
 }
 
 void drive()
 {
-    ros::Rate r(WP_RATE);
+    PeriodicLoop r(1.0 / WP_RATE, drive_phase, &drive_jitter);
+
+    // Track a speed profile of the path instead of one waypoint at a time, see SpeedProfile.h
+    MpcProblem problem;
+    ProfileLimits limits;
+    ros::param::param<bool>("~timed_reference", problem.timed_reference, false);
+    ros::param::param<double>("~reference_weight", problem.reference_weight, problem.reference_weight);
+    ros::param::param<double>("~profile/max_speed", limits.max_speed, limits.max_speed);
+    ros::param::param<double>("~profile/max_accel", limits.max_accel, limits.max_accel);
+    ros::param::param<double>("~profile/max_decel", limits.max_decel, limits.max_decel);
+    ros::param::param<double>("~profile/lateral_accel", limits.lateral_accel, limits.lateral_accel);
+    ros::param::param<double>("~profile/spacing", limits.spacing, limits.spacing);
+    limits.max_speed = std::min(limits.max_speed, problem.vel_bound);
+    // Reference of each step of the horizon, sized by the first solve
+    std::vector<double> reference;
+
+    MPC mpc(problem);
+    ros::param::param<bool>("~warm_start", mpc.warm_start, true);
+    ros::param::param<double>("~warm_start_max_error", mpc.warm_start_max_error, 0.5);
+    ros::param::param<bool>("~rti", mpc.rti, false);
+    ros::param::param<bool>("~anytime", mpc.anytime, false);
+    // The solve ends this long [s] before the next wake-up of the loop, the time to publish
+    double deadline_margin;
+    ros::param::param<double>("~deadline_margin", deadline_margin, 0.005);
+    mpc.stats = &solve_stats;
+
+    // First controls solved offline by mpc_table_builder, the online solve only where the table has none
+    std::string control_table;
+    ros::param::param<std::string>("~control_table", control_table, "");
+    if (!control_table.empty())
+    {
+        std::shared_ptr<ControlTable> table(new ControlTable);
+        ros::param::param<double>("~table_max_steer_spread", table->max_steer_spread, table->max_steer_spread);
+        ros::param::param<double>("~table_max_speed_spread", table->max_speed_spread, table->max_speed_spread);
+        if (!table->load(control_table))
+        {
+            ROS_WARN("Cannot read control table %s, solving online", control_table.c_str());
+        }
+        else if (table->problem() != MPC::fingerprint(problem))
+        {
+            ROS_WARN("Control table %s is of another problem, solving online", control_table.c_str());
+        }
+        else
+        {
+            mpc.table = table;
+        }
+    }
+
+    // Parallel solves from several starting points instead, needs a thread-safe linear solver
+    bool multi_start;
+    ros::param::param<bool>("~multi_start", multi_start, false);
+    std::unique_ptr<MultiStartMPC> multi;
+    if (multi_start)
+    {
+        std::string linear_solver;
+        ros::param::param<std::string>("~linear_solver", linear_solver, "ma27");
+        multi.reset(new MultiStartMPC(problem, linear_solver));
+        ros::param::param<double>("~multi_start_deadline", multi->deadline, 0.099);
+        multi->anytime = mpc.anytime;
+        multi->stats = &solve_stats;
+    }
 
-    MPC mpc;
+    // Cheaper problems to fall back on when the solves come close to solve_deadline, see MpcGovernor. Not with
+    // the control table or multi_start, which are built for the full problem
+    bool use_governor;
+    ros::param::param<bool>("~governor", use_governor, false);
+    MpcGovernor governor(solve_deadline);
+    ros::param::param<double>("~governor_high", governor.high, governor.high);
+    ros::param::param<double>("~governor_low", governor.low, governor.low);
+    std::vector<std::unique_ptr<MPC> > levels;
+    if (use_governor && !multi && !mpc.table)
+    {
+        for (size_t k = 1; k < MpcGovernor::LEVELS; k++)
+        {
+            bool rti;
+            levels.emplace_back(new MPC(MpcGovernor::level_problem(problem, k, rti)));
+            MPC &level = *levels.back();
+            level.warm_start = mpc.warm_start;
+            level.warm_start_max_error = mpc.warm_start_max_error;
+            level.rti = mpc.rti || rti;
+            level.anytime = mpc.anytime;
+            level.stats = &solve_stats;
+        }
+    }
+
+    // Filled in place by every solve
+    MPC::Solution solution;
 
-    while(ros::ok())
+    while(ros::ok() && running)
     {
 
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        const geometry_msgs::Quaternion& quat = pose.orientation;
         prev_loc = curr_loc;
-        curr_loc = vicon_position;
+        curr_loc = pose.position;
         curr_ang = atan2(2 * (quat.x * quat.y + quat.w * quat.z), pow(quat.w,2) + pow(quat.x,2) - pow(quat.y,2) - pow(quat.z,2));
         state << curr_loc.x, curr_loc.y, curr_ang;
 
+        receiveWaypoints();
+        if (problem.timed_reference && path_changed && gotWP)
+        {
+            fitProfile(limits);
+        }
+        path_changed = false;
+
         // Acknowledge that we reached the desired waypoint
         if (starl_flag)
         {
@@ -93,6 +325,8 @@ void drive()
                     gotWP = false;
                     speed = 0;
                     direction = 0;
+                    profile.clear();
+                    profile_path.clear();
                 }
                 else
                 {
@@ -106,20 +340,54 @@ void drive()
 
         if (gotWP)
         {
-            auto tic = std::chrono::high_resolution_clock::now();
-            vector<double> solution = mpc.Solve(state,current_waypoint);
-            auto toc = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic);
-            std::cout << "MPC time: " << duration.count() / 1000000. << std::endl; //Time in seconds
-            
-            direction = solution.at(0);
-            speed = solution.at(1);
-            ROS_INFO("speed: %f, steering: %f", speed, direction);
+            const ros::WallTime solve_start = ros::WallTime::now();
+            MPC &active = governor.level() == 0 ? mpc : *levels[governor.level() - 1];
+            // Until the next wake-up, none before the first
+            active.deadline = r.deadline() > 0 ? r.deadline() + 1.0 / WP_RATE - deadline_margin : 0.0;
+            if (problem.timed_reference)
+            {
+                active.references(profile, state, reference);
+                if (multi)
+                {
+                    multi->Solve(state, reference, solution);
+                }
+                else
+                {
+                    active.Solve(state, reference, solution);
+                }
+            }
+            else if (multi)
+            {
+                multi->Solve(state, current_waypoint, solution);
+            }
+            else
+            {
+                active.Solve(state, current_waypoint, solution);
+            }
+            solve_metric->record((ros::WallTime::now() - solve_start).toSec());
+            if (!levels.empty())
+            {
+                const size_t level = governor.record(active.last_solve().time);
+                if (level != governor_level)
+                {
+                    drive_log.info("MPC effort level %zu", level);
+                    governor_level = level;
+                }
+            }
+
+            direction = solution.delta;
+            speed = solution.v;
+            if (solution.source >= MPC::SHIFTED)
+            {
+                drive_log.warn("no feasible solve, %s", solution.source == MPC::SHIFTED ? "driving the last plan" : "stopping");
+            }
+            drive_log.info("speed: %f, steering: %f", speed, direction);
         }
 
-        ackermann_msgs::AckermannDriveStamped drive_msg;
-        drive_msg.drive.speed = speed;
-        drive_msg.drive.steering_angle = direction;
+        // A shared pointer, subscribers in the same nodelet manager get it without a copy
+        ackermann_msgs::AckermannDriveStampedPtr drive_msg(new ackermann_msgs::AckermannDriveStamped);
+        drive_msg->drive.speed = speed;
+        drive_msg->drive.steering_angle = direction;
         drive_pub.publish(drive_msg);
         //ROS_INFO("speed: %f, steering: %f",  speed, direction);
         r.sleep();
@@ -131,52 +399,31 @@ void drive()
     drive_pub.publish(drive_msg);
 }
 
-void printToFile()
+void getWP(const geometry_msgs::PoseStamped& stamped_point)
 {
-    std::ofstream positionFile;
-    positionFile.open (dir_path+"/posData_"+time_buffer+".txt", std::ios::app);
-
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && !isDriving)
+    QueuedWaypoint wp;
+    wp.point = stamped_point.pose.position;
+    wp.last = stamped_point.header.frame_id == "1";
+    if (!wp_queue.push(wp))
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ROS_WARN("Waypoint queue full, dropped x: %f, y: %f", wp.point.x, wp.point.y);
     }
 
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && isDriving)
+    if(!isDriving)
     {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << vicon_position.x << ", " << vicon_position.y << ", " << vicon_position.z << ", ";
-        positionFile << deca_position.x << ", " << deca_position.y << ", " << deca_position.z << "\r\n";
-
-        printrate.sleep();
+        isDriving = true;
     }
-    positionFile.close();
 }
 
-void getWP(const geometry_msgs::PoseStamped& stamped_point)
+// A whole path in one message, drive swaps it in for the waypoints left at once
+void getPath(const nav_msgs::PathConstPtr& path)
 {
-    geometry_msgs::Point point = stamped_point.pose.position;
-
-    if (waypoints.size() == 0)
+    if (path->poses.empty())
     {
-        current_waypoint.x = point.x;
-        current_waypoint.y = point.y;
-        //current_waypoint.z = point.z;
-    }
-
-    waypoints.push_back(point);
-
-    // wait until we get the final point
-    if(stamped_point.header.frame_id == "1")
-    {
-        gotWP = true;
-        starl_flag = true;
-        wp_time = ros::Time::now();
+        ROS_WARN("Empty path ignored");
+        return;
     }
+    new_path.write(path);
 
     if(!isDriving)
     {
@@ -184,54 +431,136 @@ void getWP(const geometry_msgs::PoseStamped& stamped_point)
     }
 }
 
-int main(int argc, char **argv)
+void publishDiagnostics(const ros::TimerEvent&)
 {
-    current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
-    ros::init(argc, argv, "waypoint");
-    ros::NodeHandle n("~");
-
-    n.param<std::string>("vicon_obj", vicon_obj, "hotdec_car");
-    n.param<std::string>("bot_num", bot_num, "bot1");
-
-    std::cout << "Vicon Object: " << vicon_obj << ", bot_num: " << bot_num << std::endl;
-
-    reached_pub = n.advertise<std_msgs::String>("reached", 1);
-    drive_pub = n.advertise<ackermann_msgs::AckermannDriveStamped>("/ackermann_cmd", 1);
-
-    ros::Subscriber deca_pos = n.subscribe("decaPos", 1, getDecaPosition);
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
-    ros::Subscriber waypoint = n.subscribe("waypoint", 10, getWP);  // second parameter is num of buffered messages
-
-    dir_path = ros::package::getPath("cyphy_car");
-
-    // Gets the current time so we can add to data output
-    time_t rawtime;
-    time(&rawtime);
-    struct tm * timeinfo;
-    timeinfo = localtime(&rawtime);
-    strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
-
-    prev_loc.x = 0;
-    prev_loc.y = 0;
-    curr_loc.x = 0;
-    curr_loc.y = 0;
-    curr_ang = 0;
+    solve_window.drain(solve_stats, solve_deadline);
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(solve_window.status(ros::this_node::getName() + ": MPC solve", solve_deadline,
+                                             solve_stats.dropped));
+    diagnostic_msgs::KeyValue level;
+    level.key = "governor level";
+    level.value = std::to_string(governor_level.load());
+    msg.status.back().values.push_back(level);
+    msg.status.push_back(drive_jitter.status(ros::this_node::getName() + ": drive loop", jitter_limit));
+    diagnostics_pub.publish(msg);
+}
 
-    std::cout << "Starting waypoint follower" << std::endl;
+namespace cyphy_car_mpc
+{
 
-    drive_thread = std::thread(drive);
-    //print_thread = std::thread(printToFile);
+/*
+ * The waypoint follower as a nodelet, so that the positioning and the
+ * estimator in the same manager hand it their messages as shared pointers
+ * instead of over TCPROS. Its state is global, one per process. mpc_wp_node
+ * loads it into a manager of its own.
+ */
+class WaypointNodelet : public nodelet::Nodelet
+{
+public:
+    ~WaypointNodelet()
+    {
+        // No more poses to record
+        if (sensors)
+        {
+            sensors->stop();
+        }
+        trajectory.reset();
+        running = false;
+        if (drive_thread.joinable())
+        {
+            drive_thread.join();
+            async_log::stop();
+        }
+        if (metrics_started)
+        {
+            stopMetricsServer();
+        }
+    }
 
-    ros::spin();
+private:
+    void onInit()
+    {
+        current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
+        ros::NodeHandle &n = getPrivateNodeHandle();
+
+        n.param<std::string>("vicon_obj", vicon_obj, "hotdec_car");
+        n.param<std::string>("bot_num", bot_num, "bot1");
+
+        NODELET_INFO("Vicon Object: %s, bot_num: %s", vicon_obj.c_str(), bot_num.c_str());
+
+        reached_pub = n.advertise<std_msgs::String>("reached", 1);
+        drive_pub = n.advertise<ackermann_msgs::AckermannDriveStamped>("/ackermann_cmd", 1);
+
+        // Solve time, iterations and status percentiles once a second, solves longer than solve_deadline count as misses
+        n.param<double>("solve_deadline", solve_deadline, 0.099);
+        diagnostics_pub = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+        n.param<double>("jitter_limit", jitter_limit, 0.002);
+        n.param<double>("drive_phase", drive_phase, 0.0);
+        diagnostics_timer = n.createTimer(ros::Duration(1.0), publishDiagnostics);
+        
+        // Solve times and drive loop overruns for scraping, 0 disables
+        int metrics_port;
+        n.param<int>("metrics_port", metrics_port, 0);
+        solve_metric = &MetricsRegistry::instance().histogram("mpc_solve_seconds", "MPC solve of one drive cycle",
+                                                              metricLabel("node", "mpc_wp"));
+        drive_jitter.exportMetrics("mpc_wp_drive");
+        metrics_started = startMetricsServer(metrics_port);
+
+        dir_path = ros::package::getPath("cyphy_car");
+
+        // Gets the current time so we can add to data output
+        time_t rawtime;
+        time(&rawtime);
+        struct tm * timeinfo;
+        timeinfo = localtime(&rawtime);
+        strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
+
+        // Every pose while driving, see TrajectoryRecorder
+        bool record_trajectory, compress_trajectory;
+        n.param<bool>("record_trajectory", record_trajectory, false);
+        n.param<bool>("compress_trajectory", compress_trajectory, true);
+        if (record_trajectory)
+        {
+            const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+            trajectory.reset(new TrajectoryRecorder(dir_path+"/posData_"+time_buffer+ext, "cyphy_car_mpc/waypoint",
+                                                    {"vicon_x", "vicon_y", "vicon_z", "deca_x", "deca_y", "deca_z"}, compress_trajectory));
+        }
 
-    drive_thread.join();
-    //print_thread.join();
+        // The trajectory is in place before the first pose. Poses have a queue and thread of their own
+        // (sensor_priority, sensor_cpus) rather than the one the manager shares with every other nodelet
+        sensors.reset(new CallbackThread(n, "sensor"));
+        deca_pos = sensors->node().subscribe("decaPos", 1, getDecaPosition);
+        sub = sensors->node().subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+        waypoint = n.subscribe("waypoint", 10, getWP);  // second parameter is num of buffered messages
+        path_sub = n.subscribe("path", 1, getPath);
+
+        prev_loc.x = 0;
+        prev_loc.y = 0;
+        curr_loc.x = 0;
+        curr_loc.y = 0;
+        curr_ang = 0;
+
+        // Lines of the control loops at most once per log_throttle [s] each, and all of them to log_file if set
+        double log_throttle;
+        std::string log_file;
+        n.param<double>("log_throttle", log_throttle, 1.0);
+        n.param<std::string>("log_file", log_file, "");
+        async_log::start(log_throttle, log_file);
+
+        NODELET_INFO("Starting waypoint follower");
+
+        // SCHED_FIFO priority and CPUs of the drive thread, see RealtimeThread.h
+        lock_memory(n);
+        running = true;
+        drive_thread = start_thread("drive", load_thread_config(n, "drive"), drive);
+    }
 
-    ackermann_msgs::AckermannDriveStamped drive_msg;
-    drive_msg.drive.speed = 0;
-    drive_msg.drive.steering_angle = 0;
-    drive_pub.publish(drive_msg);
+    std::unique_ptr<CallbackThread> sensors;
+    ros::Timer diagnostics_timer;
+    ros::Subscriber deca_pos, sub, waypoint, path_sub;
+};
 
-    return 0;
 }
 
+PLUGINLIB_EXPORT_CLASS(cyphy_car_mpc::WaypointNodelet, nodelet::Nodelet)
@@ -0,0 +1,93 @@
+//
+// Least squares cubic through the waypoints, for the cross-track MPC.
+//
+
+#ifndef MPC_CUBIC_FIT_H
+#define MPC_CUBIC_FIT_H
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+/*
+ * The points go into fixed arrays and solve forms the normal equations in
+ * one pass: the power sums of x up to x^6 and of x^k * y up to k = 3. Nothing
+ * is allocated, solve is a 4x4 LDLT on the stack. x is scaled by the largest |x| seen, which keeps the Gram matrix of
+ * a path a few metres long well conditioned; the coefficients are scaled
+ * back on the way out. Fewer than four points fit a lower order, the missing
+ * coefficients are zero. Points past the first MAX_POINTS are ignored.
+ */
+class CubicFit {
+public:
+    CubicFit() { clear(); }
+
+    void clear() {
+        n = 0;
+        scale = 0.0;
+    }
+
+    void add(double x, double y) {
+        if (n < MAX_POINTS) {
+            xs[n] = x;
+            ys[n] = y;
+            ++n;
+            scale = std::max(scale, std::fabs(x));
+        }
+    }
+
+    // Coefficients c of y = c0 + c1 x + c2 x^2 + c3 x^3
+    Eigen::Vector4d solve() const {
+        Eigen::Vector4d coeffs = Eigen::Vector4d::Zero();
+        if (n == 0) {
+            return coeffs;
+        }
+        const double s = scale > 0.0 ? scale : 1.0;
+
+        double xp[7] = {0, 0, 0, 0, 0, 0, 0};
+        Eigen::Vector4d b = Eigen::Vector4d::Zero();
+        for (int i = 0; i < n; ++i) {
+            const double t = xs[i] / s;
+            double p = 1.0;
+            for (int k = 0; k < 7; ++k) {
+                xp[k] += p;
+                if (k < 4) {
+                    b[k] += p * ys[i];
+                }
+                p *= t;
+            }
+        }
+
+        const int m = std::min(n, 4);
+        Eigen::Matrix4d A = Eigen::Matrix4d::Identity();
+        for (int r = 0; r < m; ++r) {
+            for (int c = 0; c < m; ++c) {
+                A(r, c) = xp[r + c];
+            }
+        }
+        for (int r = m; r < 4; ++r) {
+            b[r] = 0.0;
+        }
+        coeffs = A.ldlt().solve(b);
+
+        double sk = 1.0;
+        for (int k = 1; k < 4; ++k) {
+            sk *= s;
+            coeffs[k] /= sk;
+        }
+        return coeffs;
+    }
+
+    // Horner evaluation of the cubic at x
+    static double eval(const Eigen::Vector4d &coeffs, double x) {
+        return ((coeffs[3] * x + coeffs[2]) * x + coeffs[1]) * x + coeffs[0];
+    }
+
+private:
+    enum { MAX_POINTS = 256 };
+
+    double xs[MAX_POINTS];
+    double ys[MAX_POINTS];
+    int n;
+    double scale;
+};
+
+#endif //MPC_CUBIC_FIT_H
@@ -7,19 +7,39 @@
 #include "geometry_msgs/PointStamped.h"
 #include <vector>
 #include "Eigen/Dense"
+#include "cyphy_control/CarMpc.h"
 
 using namespace std;
 
-class MPC {
-public:
-    MPC();
+/*
+ * The CarMpc problem of this package and the weights of its terms: the cross
+ * track and heading errors against the fitted cubic, and the inputs.
+ */
+struct MpcProblem : CarProblem {
+    MpcProblem() {
+        // The path is in the frame of the car, the position is not bounded
+        x_bound = 1.0e19;
+        y_bound = 1.0e19;
+    }
+
+    //State cost weights
+    double cte_weight = 1;
+    double epsi_weight = 1;
 
-    virtual ~MPC();
-    vector<double> x_vals;
-    vector<double> y_vals;
-    // Solve the model given an initial state
-    vector<double> Solve(Eigen::VectorXd state, Eigen::VectorXd coeffs);
+    //Input and input derivative cost weights
+    double delta_weight = 200;
+    double delta_rate_weight = 250;
+    double v_weight = 50;
+    double v_rate_weight = 200;
+};
+
+class MPC : public CarMpc {
+public:
+    explicit MPC(const MpcProblem &problem = MpcProblem());
 
+    // Solve the model given an initial state (x, y, psi, cte, epsi) and the coefficients of the path into
+    // solution, see CarMpc::Solve
+    void Solve(const Eigen::VectorXd &state, const Eigen::VectorXd &coeffs, Solution &solution);
 };
 
 #endif //MPC_MPC_H
@@ -2,32 +2,45 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <memory>
 #include <ctime>
 #include <cstdbool>
 #include <fstream>
 #include <vector>
+#include <atomic>
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Geometry>
 #include "MPC.h"
+#include "cyphy_control/AsyncLog.h"
+#include "cyphy_control/LatestBuffer.h"
+#include "cyphy_control/Metrics.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/TrajectoryRecorder.h"
+#include "CubicFit.h"
 #include "ros/ros.h"
 #include <std_msgs/String.h>
 #include "geometry_msgs/PoseStamped.h"
+#include "nav_msgs/Path.h"
 #include "geometry_msgs/PointStamped.h"
 #include <ackermann_msgs/AckermannDriveStamped.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include "ros/package.h"
 #include <chrono>
 
 #define WP_RATE 50.0 //Hz
-#define PRINT_RATE 50.0 //Hz
 
 #define DELTA_DIRECTION  0.01
 #define DELTA_SPEED      0.25
 #define EPSILON_RADIUS   0.25
 #define EPSILON_ANGLE    0.1
 
+#define WP_QUEUE_SIZE 64 // Must be a power of two
+
 bool starl_flag = false;
 bool poly_flag = false;
-bool isDriving = false;
+std::atomic<bool> isDriving(false);
 bool gotWP = false;
 double speed = 0, direction = 0;
 geometry_msgs::Point prev_loc, curr_loc;
@@ -35,81 +48,220 @@ double curr_ang = 0;
 int n_wp;
 
 std::string bot_num, vicon_obj;
+// Waypoints still to reach, drive owns them
 std::vector<geometry_msgs::Point> waypoints;
-std::vector<double> waypoints_x;
-std::vector<double> waypoints_y;
+
+// A waypoint as getWP received it, last if it is the final point of its path
+struct QueuedWaypoint
+{
+    geometry_msgs::Point point;
+    bool last;
+};
+
+// Waypoints from getWP to drive
+SPSCQueue<QueuedWaypoint, WP_QUEUE_SIZE> wp_queue;
+
+// Paths from getPath to drive, a newer one replaces one drive has not taken yet
+LatestBuffer<nav_msgs::PathConstPtr> new_path;
 
 ros::Publisher drive_pub;
 ros::Publisher reached_pub;
+ros::Publisher diagnostics_pub;
+
+// Log of the solver, printed and written by the background thread of async_log
+LogChannel solve_log("solve");
 
-geometry_msgs::Point deca_position, vicon_position;
+// Telemetry of the solves, recorded by the solver and published by publishDiagnostics
+SolveStats solve_stats;
+SolveWindow solve_window;
+double solve_deadline;
+
+// Wake-up jitter of the drive loop, warns once it exceeds jitter_limit [s]. The loop wakes drive_phase [s] into
+// its period, see PeriodicLoop
+LoopJitter drive_jitter(1.0 / WP_RATE);
+
+// Served on metrics_port
+MetricHistogram *solve_metric;
+double jitter_limit, drive_phase;
+
+// Latest positions, written by their callbacks and read by the threads
+Snapshot<geometry_msgs::Point> deca_position;
+Snapshot<geometry_msgs::Pose> vicon_pose;
 geometry_msgs::Point current_waypoint;  // VICON coords
-geometry_msgs::Quaternion quat; //Get orientation
+
+// Trajectory of the drive, recorded by getViconPosition while driving if record_trajectory is set
+std::unique_ptr<TrajectoryRecorder> trajectory;
 
 std::string dir_path;
 char time_buffer[80];
-std::thread drive_thread, print_thread;
+std::thread drive_thread, solve_thread;
 
 Eigen::VectorXd state(5);
 
-// Evaluate a polynomial.
-double polyeval(Eigen::VectorXd coeffs, double x) {
-    double result = 0.0;
-    for (int i = 0; i < coeffs.size(); i++) {
-    result += coeffs[i] * pow(x, i);
-    }
-    return result;
+// State snapshot of the control loop for the solver thread, stamped when it was taken
+struct SolverInput
+{
+    ros::Time stamp;
+    Eigen::VectorXd state;
+    Eigen::Vector4d coeffs;
+};
+
+// Predicted controls of one solve, stamped with the time of the state it started from
+struct ControlPlan
+{
+    ros::Time stamp;
+    std::vector<double> time;   // of each control after the stamp [s]
+    std::vector<double> direction;
+    std::vector<double> speed;
+};
+
+LatestBuffer<SolverInput> solver_input;
+LatestBuffer<ControlPlan> control_plan;
+
+void getDecaPosition(const geometry_msgs::Point& point)
+{
+    deca_position.store(point);
 }
 
-// Fit a polynomial.
-// Adapted from
-// https://github.com/JuliaMath/Polynomials.jl/blob/master/src/Polynomials.jl#L676-L716
-Eigen::VectorXd polyfit(Eigen::VectorXd xvals, Eigen::VectorXd yvals,
-                        int order) {
-    assert(xvals.size() == yvals.size());
-    assert(order >= 1 && order <= xvals.size() - 1);
-    Eigen::MatrixXd A(xvals.size(), order + 1);
-
-    for (int i = 0; i < xvals.size(); i++) {
-    A(i, 0) = 1.0;
+void getViconPosition(const geometry_msgs::PoseStamped& pose)
+{
+    vicon_pose.store(pose.pose);
+    if (trajectory && isDriving)
+    {
+        const geometry_msgs::Point deca = deca_position.load();
+        trajectory->record(ros::Time::now().toNSec(), pose.pose.position.x, pose.pose.position.y, pose.pose.position.z,
+                           deca.x, deca.y, deca.z);
     }
+}
 
-    for (int j = 0; j < xvals.size(); j++) {
-    for (int i = 0; i < order; i++) {
-      A(j, i + 1) = A(j, i) * xvals(j);
+// Control of the plan at now, linear between its steps and held after the horizon
+void interpolate(const ControlPlan& plan, const ros::Time& now, double& dir_out, double& speed_out)
+{
+    const double t = fmax(0.0, (now - plan.stamp).toSec());
+    size_t k = 0;
+    while (k + 1 < plan.time.size() && plan.time[k + 1] <= t)
+    {
+        k++;
     }
+    if (k + 1 >= plan.direction.size())
+    {
+        dir_out = plan.direction.back();
+        speed_out = plan.speed.back();
+        return;
     }
-
-    auto Q = A.householderQr();
-    auto result = Q.solve(yvals);
-    return result;
+    const double f = (t - plan.time[k]) / (plan.time[k + 1] - plan.time[k]);
+    dir_out = (1 - f) * plan.direction[k] + f * plan.direction[k + 1];
+    speed_out = (1 - f) * plan.speed[k] + f * plan.speed[k + 1];
 }
 
-
-void getDecaPosition(const geometry_msgs::Point& point)
+// Solves for each new snapshot of the control loop, so a slow solve never stretches the control period
+void solve()
 {
-    deca_position = point;
+    MPC mpc;
+    ros::param::param<bool>("~warm_start", mpc.warm_start, true);
+    ros::param::param<double>("~warm_start_max_error", mpc.warm_start_max_error, 0.5);
+    ros::param::param<bool>("~rti", mpc.rti, false);
+    ros::param::param<bool>("~anytime", mpc.anytime, false);
+    // The solve ends this long [s] before the drive loop takes the plan
+    double deadline_margin;
+    ros::param::param<double>("~deadline_margin", deadline_margin, 0.005);
+    mpc.stats = &solve_stats;
+
+    // Reused by every solve, which then allocates nothing of its own once they are sized
+    SolverInput input;
+    MPC::Solution solution;
+    ControlPlan plan;
+    while(ros::ok())
+    {
+        if (!solver_input.read(input))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        //Solve MPC problem
+        const ros::WallTime solve_start = ros::WallTime::now();
+        // Done before the drive loop wakes up next, the snapshot was taken at its last wake-up
+        if (mpc.anytime)
+        {
+            mpc.deadline = PeriodicLoop::next_deadline(solve_start.toSec(), 1.0 / WP_RATE, drive_phase) - deadline_margin;
+        }
+        mpc.Solve(input.state, input.coeffs, solution);
+        solve_metric->record((ros::WallTime::now() - solve_start).toSec());
+        solve_log.info("speed: %f, steering: %f", solution.v, solution.delta);
+
+        plan.stamp = input.stamp;
+        plan.direction = solution.delta_vals;
+        plan.time.resize(plan.direction.size());
+        for (size_t k = 0; k < plan.time.size(); k++)
+        {
+            plan.time[k] = mpc.time(k);
+        }
+        plan.speed = solution.v_vals;
+        control_plan.write(plan);
+    }
 }
 
-void getViconPosition(const geometry_msgs::PoseStamped& pose)
+// Takes the waypoints getWP queued, driving starts once the final point of a path is in. A path from getPath
+// replaces the waypoints left
+void receiveWaypoints()
 {
-    vicon_position = pose.pose.position;
-    quat = pose.pose.orientation;
+    QueuedWaypoint wp;
+    while (wp_queue.pop(wp))
+    {
+        if (waypoints.size() == 0)
+        {
+            current_waypoint.x = wp.point.x;
+            current_waypoint.y = wp.point.y;
+            //current_waypoint.z = wp.point.z;
+        }
+
+        waypoints.push_back(wp.point);
+
+        // wait until we get the final point
+        if (wp.last)
+        {
+            gotWP = true;
+            starl_flag = true;
+            poly_flag = true;
+        }
+    }
+
+    nav_msgs::PathConstPtr path;
+    if (new_path.read(path))
+    {
+        waypoints.clear();
+        for (size_t i = 0; i < path->poses.size(); i++)
+        {
+            waypoints.push_back(path->poses[i].pose.position);
+        }
+        current_waypoint.x = waypoints.front().x;
+        current_waypoint.y = waypoints.front().y;
+        gotWP = true;
+        starl_flag = true;
+        poly_flag = true;
+    }
 }
 
 void drive()
 {
-    ros::Rate r(WP_RATE);
+    PeriodicLoop r(1.0 / WP_RATE, drive_phase, &drive_jitter);
 
-    MPC mpc;
+    // Plans stamped before the last snapshot belong to older waypoints
+    ros::Time request_stamp;
+    ControlPlan plan;
 
     while(ros::ok())
     {
 
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        const geometry_msgs::Quaternion& quat = pose.orientation;
         prev_loc = curr_loc;
-        curr_loc = vicon_position;
+        curr_loc = pose.position;
         curr_ang = atan2(2 * (quat.x * quat.y + quat.w * quat.z), pow(quat.w,2) + pow(quat.x,2) - pow(quat.y,2) - pow(quat.z,2));
 
+        receiveWaypoints();
+
         // Acknowledge that we reached the desired waypoint
         if (starl_flag)
         {
@@ -142,38 +294,37 @@ void drive()
         if ((gotWP) && (poly_flag))
         { 
             n_wp = waypoints.size();
+            CubicFit fit;
+            const double c = cos(curr_ang), s = sin(curr_ang);
             for (int i =0; i < n_wp; ++i){
                 //Offset axis origin to car location
                 double shift_x = waypoints[i].x - curr_loc.x;
                 double shift_y = waypoints[i].y - curr_loc.y;
-                //Transform wp coordinates
-                waypoints_x[i] = (shift_x*cos(curr_ang) + shift_y*sin(curr_ang));
-                waypoints_y[i] = (shift_x*cos(curr_ang) + shift_y*sin(curr_ang));
+                //Transform wp coordinates into the car frame
+                fit.add(shift_x*c + shift_y*s, -shift_x*s + shift_y*c);
             }
-            //Convert waypoints to Eigen vector
-            double* wpx = &waypoints_x[0];
-            double* wpy = &waypoints_y[0];
-            Eigen::Map<Eigen::VectorXd> wpx_solve(wpx, n_wp);
-            Eigen::Map<Eigen::VectorXd> wpy_solve(wpy, n_wp);
             //Polynomial fit
-            auto coeffs = polyfit(wpx_solve, wpy_solve, 3);
+            Eigen::Vector4d coeffs = fit.solve();
             //Calculate cross track error and heading error
-            double cte = polyeval(coeffs,0);
+            double cte = CubicFit::eval(coeffs, 0);
             double epsi = -atan(coeffs[1]);
             state << curr_loc.x, curr_loc.y, curr_ang, cte, epsi;
-            auto tic = std::chrono::high_resolution_clock::now();
-            //Solve MPC problem
-            vector<double> solution = mpc.Solve(state,coeffs);
-            auto toc = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic);
-            std::cout << "MPC time: " << duration.count() / 1000000. << std::endl; //Time in seconds
-            //Apply control inputs
-            direction = solution.at(0);
-            speed = solution.at(1);
-            ROS_INFO("speed: %f, steering: %f", speed, direction);
+            //Hand the problem to the solver thread
+            SolverInput input;
+            input.stamp = request_stamp = ros::Time::now();
+            input.state = state;
+            input.coeffs = coeffs;
+            solver_input.write(input);
             poly_flag = false;
         }
 
+        //Apply control inputs of the latest plan at this tick
+        control_plan.read(plan);
+        if (gotWP && !plan.direction.empty() && (plan.stamp >= request_stamp))
+        {
+            interpolate(plan, ros::Time::now(), direction, speed);
+        }
+
         ackermann_msgs::AckermannDriveStamped drive_msg;
         drive_msg.drive.speed = speed;
         drive_msg.drive.steering_angle = direction;
@@ -188,52 +339,31 @@ void drive()
     drive_pub.publish(drive_msg);
 }
 
-void printToFile()
+void getWP(const geometry_msgs::PoseStamped& stamped_point)
 {
-    std::ofstream positionFile;
-    positionFile.open (dir_path+"/posData_"+time_buffer+".txt", std::ios::app);
-
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && !isDriving)
+    QueuedWaypoint wp;
+    wp.point = stamped_point.pose.position;
+    wp.last = stamped_point.header.frame_id == "1";
+    if (!wp_queue.push(wp))
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ROS_WARN("Waypoint queue full, dropped x: %f, y: %f", wp.point.x, wp.point.y);
     }
 
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && isDriving)
+    if(!isDriving)
     {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << vicon_position.x << ", " << vicon_position.y << ", " << vicon_position.z << ", ";
-        positionFile << deca_position.x << ", " << deca_position.y << ", " << deca_position.z << "\r\n";
-
-        printrate.sleep();
+        isDriving = true;
     }
-    positionFile.close();
 }
 
-void getWP(const geometry_msgs::PoseStamped& stamped_point)
+// A whole path in one message, drive swaps it in for the waypoints left at once
+void getPath(const nav_msgs::PathConstPtr& path)
 {
-    geometry_msgs::Point point = stamped_point.pose.position;
-
-    if (waypoints.size() == 0)
+    if (path->poses.empty())
     {
-        current_waypoint.x = point.x;
-        current_waypoint.y = point.y;
-        //current_waypoint.z = point.z;
-    }
-
-    waypoints.push_back(point);
-
-    // wait until we get the final point
-    if(stamped_point.header.frame_id == "1")
-    {
-        gotWP = true;
-        starl_flag = true;
-        poly_flag = true;
+        ROS_WARN("Empty path ignored");
+        return;
     }
+    new_path.write(path);
 
     if(!isDriving)
     {
@@ -241,6 +371,17 @@ void getWP(const geometry_msgs::PoseStamped& stamped_point)
     }
 }
 
+void publishDiagnostics(const ros::TimerEvent&)
+{
+    solve_window.drain(solve_stats, solve_deadline);
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(solve_window.status(ros::this_node::getName() + ": MPC solve", solve_deadline,
+                                             solve_stats.dropped));
+    msg.status.push_back(drive_jitter.status(ros::this_node::getName() + ": drive loop", jitter_limit));
+    diagnostics_pub.publish(msg);
+}
+
 int main(int argc, char **argv)
 {
     current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
@@ -255,9 +396,23 @@ int main(int argc, char **argv)
     reached_pub = n.advertise<std_msgs::String>("reached", 1);
     drive_pub = n.advertise<ackermann_msgs::AckermannDriveStamped>("/ackermann_cmd", 1);
 
-    ros::Subscriber deca_pos = n.subscribe("decaPos", 1, getDecaPosition);
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+    // Solve time, iterations and status percentiles once a second, solves longer than solve_deadline count as misses
+    n.param<double>("solve_deadline", solve_deadline, 0.099);
+    diagnostics_pub = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    n.param<double>("jitter_limit", jitter_limit, 0.002);
+    n.param<double>("drive_phase", drive_phase, 0.0);
+    ros::Timer diagnostics_timer = n.createTimer(ros::Duration(1.0), publishDiagnostics);
+
+    // Solve times and drive loop overruns for scraping, 0 disables
+    int metrics_port;
+    n.param<int>("metrics_port", metrics_port, 0);
+    solve_metric = &MetricsRegistry::instance().histogram("mpc_solve_seconds", "MPC solve of one snapshot of the drive loop",
+                                                          metricLabel("node", "mpc2_wp"));
+    drive_jitter.exportMetrics("mpc2_wp_drive");
+    const bool metrics_started = startMetricsServer(metrics_port);
+
     ros::Subscriber waypoint = n.subscribe("waypoint", 10, getWP);  // second parameter is num of buffered messages
+    ros::Subscriber path_sub = n.subscribe("path", 1, getPath);
 
     dir_path = ros::package::getPath("cyphy_car");
 
@@ -268,21 +423,54 @@ int main(int argc, char **argv)
     timeinfo = localtime(&rawtime);
     strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
 
+    // Every pose while driving, see TrajectoryRecorder
+    bool record_trajectory, compress_trajectory;
+    n.param<bool>("record_trajectory", record_trajectory, false);
+    n.param<bool>("compress_trajectory", compress_trajectory, true);
+    if (record_trajectory)
+    {
+        const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+        trajectory.reset(new TrajectoryRecorder(dir_path+"/posData_"+time_buffer+ext, "cyphy_car_mpc2/waypoint",
+                                                {"vicon_x", "vicon_y", "vicon_z", "deca_x", "deca_y", "deca_z"}, compress_trajectory));
+    }
+
     prev_loc.x = 0;
     prev_loc.y = 0;
     curr_loc.x = 0;
     curr_loc.y = 0;
     curr_ang = 0;
 
+    // Lines of the control loops at most once per log_throttle [s] each, and all of them to log_file if set
+    double log_throttle;
+    std::string log_file;
+    n.param<double>("log_throttle", log_throttle, 1.0);
+    n.param<std::string>("log_file", log_file, "");
+    async_log::start(log_throttle, log_file);
+
     std::cout << "Starting waypoint follower" << std::endl;
 
-    drive_thread = std::thread(drive);
-    //print_thread = std::thread(printToFile);
+    // The positions on a queue and thread of their own (sensor_priority, sensor_cpus), so they never wait behind the
+    // waypoint and path callbacks of ros::spin
+    CallbackThread sensors(n, "sensor");
+    ros::Subscriber deca_pos = sensors.node().subscribe("decaPos", 1, getDecaPosition);
+    ros::Subscriber sub = sensors.node().subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+
+    // SCHED_FIFO priority and CPUs of the threads, see RealtimeThread.h. The solver should stay below the drive loop
+    lock_memory(n);
+    drive_thread = start_thread("drive", load_thread_config(n, "drive"), drive);
+    solve_thread = start_thread("solve", load_thread_config(n, "solve"), solve);
 
     ros::spin();
 
+    sensors.stop();
     drive_thread.join();
-    //print_thread.join();
+    solve_thread.join();
+    trajectory.reset();
+    async_log::stop();
+    if (metrics_started)
+    {
+        stopMetricsServer();
+    }
 
     ackermann_msgs::AckermannDriveStamped drive_msg;
     drive_msg.drive.speed = 0;
@@ -0,0 +1,104 @@
+//
+// Logging from the control loops: a thread only copies a binary record into
+// its own lock-free ring, a background thread formats and prints them and
+// optionally writes them all to a binary file.
+//
+
+#ifndef CYPHY_CONTROL_ASYNC_LOG_H
+#define CYPHY_CONTROL_ASYNC_LOG_H
+
+#include "cyphy_control/SPSCQueue.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#define LOG_MAX_VALUES 6
+#define LOG_QUEUE_SIZE 256 // Must be a power of two
+
+// One log call, format is only kept as a pointer
+struct LogRecord {
+    enum Level : uint8_t { INFO, WARN, ERROR };
+
+    int64_t stamp;          // system clock [ns]
+    const char *format;
+    Level level;
+    uint8_t count;          // values used
+    double values[LOG_MAX_VALUES];
+};
+
+/*
+ * The log of one thread, typically a global next to the thread function. A
+ * call costs a clock read and a copy into the ring, never a lock, a format or
+ * a write; a full ring drops the record and counts it. Only the thread the
+ * channel belongs to may log to it.
+ *
+ * The format has to be a string literal and its conversions doubles (%f, %g,
+ * %e), at most LOG_MAX_VALUES of them: the values are stored as doubles and
+ * formatted later by the background thread.
+ */
+class LogChannel {
+public:
+    // Registers with the background thread, name prefixes its lines and names it in the binary file
+    explicit LogChannel(const char *name);
+    ~LogChannel();
+
+    template <class... Args>
+    void info(const char *format, Args... args) {
+        log(LogRecord::INFO, format, args...);
+    }
+
+    template <class... Args>
+    void warn(const char *format, Args... args) {
+        log(LogRecord::WARN, format, args...);
+    }
+
+    template <class... Args>
+    void error(const char *format, Args... args) {
+        log(LogRecord::ERROR, format, args...);
+    }
+
+    template <class... Args>
+    void log(LogRecord::Level level, const char *format, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_VALUES, "too many values for one log record");
+        const double values[] = {static_cast<double>(args)..., 0.0};
+        LogRecord record;
+        record.stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+        record.format = format;
+        record.level = level;
+        record.count = sizeof...(Args);
+        for (size_t i = 0; i < LOG_MAX_VALUES; ++i) {
+            record.values[i] = i < sizeof...(Args) ? values[i] : 0.0;
+        }
+        queue.push(record);
+    }
+
+private:
+    friend class AsyncLogDrain;
+
+    const char *name;
+    SPSCQueue<LogRecord, LOG_QUEUE_SIZE> queue;
+    // Drops already reported, background thread only
+    uint32_t reported_drops;
+};
+
+/*
+ * The background thread of all channels of the process. Every drain it
+ * prints each format of a channel at most once per throttle [s] through
+ * rosconsole, with the number of lines held back since; warnings and errors
+ * are never held back. With a binary file every record is written to it in
+ * large buffered blocks:
+ *   "CYLOG1\n"
+ *   'F' u16 id, u16 length, "channel: format"   first record of each format
+ *   'R' u16 id, u8 level, u8 count, i64 stamp, count f64 values
+ * in host byte order. Channels can come and go while it runs, start and
+ * stop nest so that every nodelet of a manager can call both.
+ */
+namespace async_log {
+// Starts the thread, no binary file if binary_path is empty
+void start(double throttle, const std::string &binary_path);
+// Drains what is left, closes the file and stops the thread
+void stop();
+}
+
+#endif //CYPHY_CONTROL_ASYNC_LOG_H
@@ -0,0 +1,170 @@
+//
+// Kinematic bicycle MPC of the cars, the solver core of the car controllers.
+//
+
+#ifndef CYPHY_CONTROL_CAR_MPC_H
+#define CYPHY_CONTROL_CAR_MPC_H
+
+#include "cyphy_control/CostTerm.h"
+#include "cyphy_control/SolveStats.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Horizon, model and bounds of one MPC problem, the cost is in the terms.
+ */
+struct CarProblem {
+    // Set the timestep length and duration
+    size_t N = 10;
+    double dt = 0.1;
+    // Step k lasts dt * dt_growth^k, fine near and coarse far: 1.2 stretches the 10 steps of 0.1 s over 2 s
+    double dt_growth = 1.0;
+
+    //Geometric parameters of car
+    double lr = 0.3;
+
+    //State and input hard constraints
+    double x_bound = 3.0;
+    double y_bound = 3.0;
+    double dir_bound = 0.35;
+    double vel_bound = 3.0;
+
+    //Move blocking: the controls hold over blocks of this many steps, e.g. 1, 1, 2, 2, 4, fewer variables for a
+    //longer horizon. The blocks end at the first 0, the last runs to the end of the horizon, all 0 for none
+    static const size_t MAX_BLOCKS = 16;
+    size_t move_blocks[MAX_BLOCKS] = {};
+
+    // Length of step k, from state k to state k + 1 [s]
+    double step(size_t k) const {
+        return dt * std::pow(dt_growth, static_cast<double>(k));
+    }
+
+    // Time from the initial state to state k [s]
+    double time(size_t k) const {
+        return dt_growth == 1.0 ? dt * k : dt * (std::pow(dt_growth, static_cast<double>(k)) - 1.0) / (dt_growth - 1.0);
+    }
+};
+
+/*
+ * Minimizes the sum of the cost terms over the states and actuations of the
+ * horizon, subject to the bicycle model
+ *   x' = x + v cos(psi) dt, y' = y + v sin(psi) dt, psi' = psi + v tan(delta) dt / lr
+ * with dt the length of each step
+ * and the bounds of the problem. The objective and constraints are taped
+ * once per instance, with the parameters of the terms as fixed variables, and
+ * every Solve reuses the tape and the Ipopt instance. Each instance keeps its
+ * own problem, so instances with different problems can coexist and be solved
+ * on separate threads; see parallel_setup.
+ */
+class CarMpc {
+public:
+    typedef std::vector<std::shared_ptr<const CostTerm> > Terms;
+
+    // Where the controls of a solve come from, see anytime
+    enum Source {
+        SOLVED,         // The solver converged
+        BEST_ITERATE,   // The feasible point of least cost the solver reached
+        SHIFTED,        // The last plan driven, one step on
+        STOPPED         // None of those, the car stops
+    };
+
+    // Starting point of a cold start: x, y and psi of each step, v and delta of each step but the last
+    struct Guess {
+        std::vector<double> x, y, psi, v, delta;
+    };
+
+    // Controls of the first step and the predicted trajectory of a solve, owned by the caller. The vectors are sized
+    // by the first solve into it and overwritten in place by the later ones
+    struct Solution {
+        double delta = 0, v = 0;
+        Source source = SOLVED;
+        // Predicted position of each step after the first
+        std::vector<double> x_vals, y_vals;
+        // Predicted steering and speed of each step
+        std::vector<double> delta_vals, v_vals;
+    };
+
+    // Generated code (MPC_CODEGEN) is named after name, the problem and the terms
+    CarMpc(const CarProblem &problem, const Terms &terms, const std::string &name);
+
+    virtual ~CarMpc();
+    // Solution of the last solve through the vector Solve below, the others leave it alone
+    Solution last;
+    // Start each solve from the last trajectory shifted by one step (primal and dual), falling back to
+    // a cold start when the last solve gave none or the car is further than warm_start_max_error [m]
+    // from where it predicted
+    bool warm_start;
+    double warm_start_max_error;
+    // Warm starts take one SQP iteration on a sparse QP (TapedNLP::sqp_step) instead of an Ipopt
+    // solve, cold starts still go to Ipopt
+    bool rti;
+    /*
+     * Anytime solves: Ipopt stops at the first iteration past deadline, and a
+     * solve that did not converge drives the feasible point of least cost
+     * Ipopt evaluated, or else the last plan driven shifted by one step for as
+     * long as it has steps left, or else stops the car. Without it every solve
+     * drives what Ipopt returned, converged or not
+     */
+    bool anytime;
+    // End of the time of the next solves [s of the system clock, as PeriodicLoop::deadline], 0 for none
+    double deadline;
+    // Ring every solve is recorded into (time, iterations, status, cost, violation, source), none if null
+    SolveStats *stats;
+    // Length of the first step of the horizon [s]
+    double timestep() const;
+    // Time from the initial state to state k of the horizon [s], see CarProblem::time
+    double time(size_t k) const;
+    // Objective of the last solve, to pick the best of several candidate problems
+    double cost() const;
+    // Largest constraint violation of the last solution, and whether it is a trajectory to drive
+    double infeasibility() const;
+    bool feasible() const;
+    // Telemetry of the last solve, what stats gets
+    const SolveSample &last_solve() const;
+    // Warm start the next solve from the last solution of other, an MPC of the same problem
+    void adopt(const CarMpc &other);
+    // Ipopt string option of this instance, e.g. the linear_solver of concurrent solves
+    void SetOption(const std::string &name, const std::string &value);
+    // Solve from the initial state (x, y, psi) given the n_params parameters of all terms, in their order, into
+    // solution. Once solution is sized this allocates nothing itself, what Ipopt and CppAD allocate aside
+    void Solve(double x, double y, double psi, const double *params, size_t n_params, Solution &solution);
+    // The same into last, returns the steering and speed of the first step
+    std::vector<double> Solve(double x, double y, double psi, const std::vector<double> &params);
+    // Position of state t of the last trajectory, false if the last solve gave none to drive
+    bool predicted(size_t t, double &x, double &y) const;
+
+    /*
+     * CppAD keeps its memory per thread and has to know the threads before
+     * any of them records or evaluates: parallel_setup with the number of
+     * threads, the calling one included, then construct the instances on the
+     * calling thread, parallel_begin before the other threads start and
+     * set_thread(i), i in 1..threads-1, first thing on each of those.
+     * parallel_end once they have stopped. Concurrent solves also need a
+     * thread-safe Ipopt linear solver, MUMPS is not.
+     */
+    static void parallel_setup(size_t threads);
+    static void parallel_begin();
+    static void set_thread(size_t index);
+    static void parallel_end();
+
+protected:
+    // Starting point of a cold start from (x, y, psi) with params, all zeros if it returns false. guess comes
+    // empty but keeps the storage of the last cold start
+    virtual bool cold_guess(double x, double y, double psi, const double *params, Guess &guess) const;
+
+private:
+    // Tape, Ipopt instance and QP kept across solves
+    struct Solver;
+
+    CarProblem problem;
+    Terms terms;
+    std::unique_ptr<Solver> solver;
+    // solver holds a trajectory to warm start from
+    bool trajectory;
+    double last_infeasibility;
+    SolveSample last_sample;
+};
+
+#endif //CYPHY_CONTROL_CAR_MPC_H
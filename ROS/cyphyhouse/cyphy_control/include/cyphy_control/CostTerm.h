@@ -0,0 +1,132 @@
+//
+// Variable layout of the car MPC and the interface of its cost and constraint terms.
+//
+
+#ifndef CYPHY_CONTROL_COST_TERM_H
+#define CYPHY_CONTROL_COST_TERM_H
+
+#include "cyphy_control/config.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Only the library records and evaluates, its users never see more of CppAD than these names
+namespace CppAD {
+template <class Base>
+class AD;
+#ifdef MPC_CODEGEN
+namespace cg {
+template <class Base>
+class CG;
+}
+#endif
+}
+
+/*
+ * Blocks of the variables of a horizon of N steps: the states x, y and psi
+ * of every step, the speed v and steering delta of every move, then the
+ * parameters of the cost terms, fixed variables so that one tape serves
+ * every solve. Without move blocking every step but the last is a move of
+ * its own, with blocks the controls of a move hold over that many
+ * consecutive steps; v(t) and delta(t) are the variables of step t either
+ * way. The constraints are the model of each state, the initial state first,
+ * then the n_terms inequalities of the terms, each kept at or above 0.
+ */
+struct MpcLayout {
+    // blocks: steps of each move in order, all positive, the last one runs to the end of the horizon. Empty for none
+    MpcLayout(size_t N, size_t n_params, size_t n_terms = 0, const std::vector<size_t> &blocks = std::vector<size_t>())
+        : N(N), move(moves(N, blocks)), n_moves(move.empty() ? 0 : move.back() + 1), x_start(0),
+          y_start(x_start + N), psi_start(y_start + N), v_start(psi_start + N), delta_start(v_start + n_moves),
+          param_start(delta_start + n_moves), n_params(n_params), n_vars(param_start + n_params), term_start(N * 3),
+          n_constraints(term_start + n_terms) {}
+
+    // Speed and steering of step t, 0 to N - 2
+    size_t v(size_t t) const { return v_start + move[t]; }
+    size_t delta(size_t t) const { return delta_start + move[t]; }
+
+    size_t N;
+    std::vector<size_t> move;   // Move of each step but the last
+    size_t n_moves;
+    size_t x_start, y_start, psi_start, v_start, delta_start;
+    size_t param_start, n_params;
+    size_t n_vars;
+    size_t term_start;
+    size_t n_constraints;
+
+private:
+    static std::vector<size_t> moves(size_t N, const std::vector<size_t> &blocks) {
+        std::vector<size_t> move(N > 1 ? N - 1 : 0);
+        size_t m = 0, end = blocks.empty() ? 1 : blocks[0];
+        for (size_t t = 0; t < move.size(); ++t) {
+            if (t == end) {
+                // Next move, the last block runs on to the end
+                if (blocks.empty()) {
+                    ++m;
+                    ++end;
+                } else if (m + 1 < blocks.size()) {
+                    ++m;
+                    end += blocks[m];
+                }
+            }
+            move[t] = m;
+        }
+        return move;
+    }
+};
+
+/*
+ * One term of the objective, or of the constraints. Its parameters
+ * (reference, fitted path, obstacles) follow those of the terms before it,
+ * CarMpc::Solve takes the values of all terms in that order, and so do its
+ * constraints. add and constrain are only called while the tape is recorded,
+ * once per CarMpc.
+ */
+class CostTerm {
+public:
+    typedef CppAD::AD<double> ADdouble;
+    typedef std::vector<ADdouble> ADvector;
+
+    virtual ~CostTerm() {}
+
+    // Number of parameters the term reads over a horizon of N steps
+    virtual size_t parameters(size_t N) const {
+        (void) N;
+        return 0;
+    }
+
+    // Number of constraints g >= 0 the term adds over a horizon of N steps
+    virtual size_t constraints(size_t N) const {
+        (void) N;
+        return 0;
+    }
+
+    // Adds the term at vars to cost, its parameters start at vars[param]
+    virtual void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const = 0;
+
+    // Sets the constraints of the term at vars, g[0] to g[constraints(N) - 1]
+    virtual void constrain(ADdouble *g, const ADvector &vars, const MpcLayout &l, size_t param) const {
+        (void) g;
+        (void) vars;
+        (void) l;
+        (void) param;
+    }
+
+#ifdef MPC_CODEGEN
+    typedef CppAD::AD<CppAD::cg::CG<double> > CGdouble;
+    typedef std::vector<CGdouble> CGvector;
+
+    // The same on the type CppADCodeGen records on
+    virtual void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const = 0;
+    virtual void constrain(CGdouble *g, const CGvector &vars, const MpcLayout &l, size_t param) const {
+        (void) g;
+        (void) vars;
+        (void) l;
+        (void) param;
+    }
+#endif
+
+    // Kind and weights of the term, generated code is named after the keys of the terms
+    virtual std::string key() const = 0;
+};
+
+#endif //CYPHY_CONTROL_COST_TERM_H
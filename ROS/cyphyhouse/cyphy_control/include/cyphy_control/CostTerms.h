@@ -0,0 +1,158 @@
+//
+// Cost and constraint terms of the car controllers.
+//
+
+#ifndef CYPHY_CONTROL_COST_TERMS_H
+#define CYPHY_CONTROL_COST_TERMS_H
+
+#include "cyphy_control/CostTerm.h"
+
+/*
+ * Squared speed and steering of every step, and their squared change from
+ * one step to the next.
+ */
+class InputCost : public CostTerm {
+public:
+    InputCost(double delta_weight, double delta_rate_weight, double v_weight, double v_rate_weight);
+
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l) const;
+
+    double delta_weight, delta_rate_weight, v_weight, v_rate_weight;
+};
+
+/*
+ * Squared distance of every step from one waypoint. Parameters: its x and y.
+ */
+class WaypointCost : public CostTerm {
+public:
+    WaypointCost(double x_weight, double y_weight);
+
+    size_t parameters(size_t N) const;
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l, size_t param) const;
+
+    double x_weight, y_weight;
+};
+
+/*
+ * Squared distance of each step t from its own reference point, weighted by
+ * t + 1 so the end of the horizon counts most. Parameters: the N reference
+ * x, then the N reference y.
+ */
+class ReferenceCost : public CostTerm {
+public:
+    ReferenceCost(double x_weight, double y_weight);
+
+    size_t parameters(size_t N) const;
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l, size_t param) const;
+
+    double x_weight, y_weight;
+};
+
+/*
+ * Squared cross track error cte and heading error epsi of every step against
+ * the cubic y = c0 + c1 x + c2 x^2 + c3 x^3, both propagated along the
+ * predicted states by the error model of the kinematic bicycle, step k
+ * lasting dt * dt_growth^k. Parameters: c0 to c3, then cte and epsi at the
+ * initial state.
+ */
+class CrossTrackCost : public CostTerm {
+public:
+    CrossTrackCost(double cte_weight, double epsi_weight, double dt, double lr, double dt_growth = 1.0);
+
+    size_t parameters(size_t N) const;
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l, size_t param) const;
+
+    double cte_weight, epsi_weight, dt, lr, dt_growth;
+};
+
+/*
+ * Collision constraints against the signed distance field of the arena
+ * (DistanceField): the distance at every step after the first at least
+ * margin. The field enters as the 2 x 2 patch of cell values around where
+ * each step is expected, interpolated bilinearly on the tape, so a step costs
+ * the same few operations however many obstacles the field holds. Parameters:
+ * the resolution of the field, then the DistanceField::PATCH values of the
+ * patch of each step 1 to N - 1.
+ */
+class ObstacleConstraint : public CostTerm {
+public:
+    explicit ObstacleConstraint(double margin);
+
+    size_t parameters(size_t N) const;
+    size_t constraints(size_t N) const;
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+    void constrain(ADdouble *g, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+    void constrain(CGdouble *g, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type *g, const Vector &vars, const MpcLayout &l, size_t param) const;
+
+    double margin;
+};
+
+/*
+ * Separation from other robots: every step after the first at least distance
+ * from where each of robots others is predicted at that step. Parameters: the
+ * predicted x of each other robot at steps 1 to N - 1, then its y, robot after
+ * robot. A slot without a robot holds a point far off.
+ */
+class RobotConstraint : public CostTerm {
+public:
+    RobotConstraint(size_t robots, double distance);
+
+    size_t parameters(size_t N) const;
+    size_t constraints(size_t N) const;
+    void add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const;
+    void constrain(ADdouble *g, const ADvector &vars, const MpcLayout &l, size_t param) const;
+#ifdef MPC_CODEGEN
+    void add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const;
+    void constrain(CGdouble *g, const CGvector &vars, const MpcLayout &l, size_t param) const;
+#endif
+    std::string key() const;
+
+private:
+    template <class Vector>
+    void eval(typename Vector::value_type *g, const Vector &vars, const MpcLayout &l, size_t param) const;
+
+    size_t robots;
+    double distance;
+};
+
+#endif //CYPHY_CONTROL_COST_TERMS_H
@@ -0,0 +1,53 @@
+//
+// Signed distance to the obstacles of the arena on a grid, computed once per
+// map, for the collision constraints of the MPC (ObstacleConstraint).
+//
+
+#ifndef CYPHY_CONTROL_DISTANCE_FIELD_H
+#define CYPHY_CONTROL_DISTANCE_FIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Distance from the centre of every cell of an occupancy grid to the nearest
+ * occupied cell, negative inside obstacles (the distance to the nearest free
+ * cell), by the exact Euclidean distance transform of Felzenszwalb and
+ * Huttenlocher in O(cells) whatever the number of obstacles. Everything
+ * outside the grid counts as occupied, so the arena walls keep the car in.
+ * Between the cell centres the field is bilinear, so one lookup reads four
+ * values, and the 2 x 2 cells around a point make a patch that the MPC
+ * interpolates on its tape.
+ */
+class DistanceField {
+public:
+    // Number of values of a patch: x and y of its lower left centre, then the values at (0, 0), (1, 0), (0, 1), (1, 1)
+    static const size_t PATCH = 6;
+
+    DistanceField();
+
+    // Cell (i, j) of the grid, row-major from origin_x, origin_y [m], is occupied if occupied[j * width + i]
+    DistanceField(double origin_x, double origin_y, double resolution, size_t width, size_t height,
+                  const std::vector<uint8_t> &occupied);
+
+    bool empty() const { return values.empty(); }
+    double resolution() const { return cell; }
+
+    // Signed distance at x, y [m], bilinear between the cell centres and held at the border outside the grid
+    double value(double x, double y) const;
+
+    // The patch around x, y in patch[0] to patch[PATCH - 1]
+    void patch(double x, double y, double *patch) const;
+
+private:
+    // Cell whose centre is the lower left of the four around x, y, within the grid, and where x, y lies from it
+    void corner(double x, double y, size_t &i, size_t &j, double &u, double &w) const;
+    double at(size_t i, size_t j) const { return values[j * width + i]; }
+
+    double origin_x, origin_y, cell;
+    size_t width, height;
+    std::vector<float> values;  // [m]
+};
+
+#endif //CYPHY_CONTROL_DISTANCE_FIELD_H
@@ -0,0 +1,119 @@
+//
+// PIDs of loops running at a fixed rate, e.g. the speed loop of the cars or
+// the position and attitude loops of the quads.
+//
+
+#ifndef CYPHY_CONTROL_FIXED_RATE_PID_H
+#define CYPHY_CONTROL_FIXED_RATE_PID_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Gains of one axis, the integral and derivative gains are per second
+struct PidGains {
+    double kp, ki, kd;
+    double output_limit;
+    // Weight of the newest sample of the derivative, 1 for none
+    double derivative_filter;
+};
+
+/*
+ * N independent PIDs stepped together, e.g. roll, pitch and yaw. The state is
+ * kept per field in arrays so the loop over the axes has no branches and the
+ * compiler can vectorize it; nothing is allocated after construction.
+ *
+ * The integral and the derivative are scaled by the period, so the gains keep
+ * their meaning at any rate. The derivative is taken on the measurement and
+ * low-pass filtered, so setpoint steps do not kick the output and measurement
+ * noise is not amplified by a high rate. The integral winds back by the
+ * amount the output is saturated (back-calculation, tracking gain ki / kp), so
+ * it does not hold the output at its limit once the error changes sign.
+ */
+template <size_t N>
+class PidBank {
+public:
+    PidBank(double rate, const std::array<PidGains, N> &gains) : dt(1.0 / rate) {
+        for (size_t i = 0; i < N; ++i) {
+            kp[i] = gains[i].kp;
+            ki[i] = gains[i].ki;
+            kd[i] = gains[i].kd;
+            output_limit[i] = gains[i].output_limit;
+            alpha[i] = gains[i].derivative_filter;
+            // Without a proportional gain the integral is simply kept off the limit
+            tracking[i] = gains[i].kp > 0 ? gains[i].ki / gains[i].kp : rate;
+        }
+        reset();
+    }
+
+    // Outputs of one period, one setpoint, measurement and output per axis
+    void update(const double *setpoint, const double *measured, double *output) {
+        for (size_t i = 0; i < N; ++i) {
+            const double error = setpoint[i] - measured[i];
+            derivative[i] = weight[i] * (measured[i] - last_measured[i]) / dt + (1 - weight[i]) * derivative[i];
+            last_measured[i] = measured[i];
+            weight[i] = alpha[i];
+
+            const double raw = kp[i] * error + integral[i] - kd[i] * derivative[i];
+            const double limited = std::max(std::min(raw, output_limit[i]), -output_limit[i]);
+            integral[i] += dt * (ki[i] * error + tracking[i] * (limited - raw));
+            output[i] = limited;
+        }
+    }
+
+    // Forgets the integrals and the derivatives, e.g. while the loops are not closed
+    void reset() {
+        for (size_t i = 0; i < N; ++i) {
+            integral[i] = 0;
+            derivative[i] = 0;
+            last_measured[i] = 0;
+            // The first sample after a reset has no derivative
+            weight[i] = 0;
+        }
+    }
+
+    double period() const {
+        return dt;
+    }
+
+private:
+    double dt;
+    std::array<double, N> kp, ki, kd, output_limit, alpha, tracking;
+    // integral is the integral term itself, in units of the output
+    std::array<double, N> integral, derivative, last_measured, weight;
+};
+
+/*
+ * A single PID, e.g. the speed loop of a car.
+ */
+class FixedRatePid {
+public:
+    FixedRatePid(double kp, double ki, double kd, double rate, double output_limit, double derivative_filter = 0.5)
+        : bank(rate, {{{kp, ki, kd, output_limit, derivative_filter}}}) {}
+
+    // Output of one period
+    double update(double setpoint, double measured) {
+        double output;
+        bank.update(&setpoint, &measured, &output);
+        return output;
+    }
+
+    // Output of one period of a loop on an error that is driven to 0, the derivative is taken on the error
+    double updateError(double error) {
+        return update(0.0, -error);
+    }
+
+    // Forgets the integral and the derivative, e.g. while the loop is not closed
+    void reset() {
+        bank.reset();
+    }
+
+    double period() const {
+        return bank.period();
+    }
+
+private:
+    PidBank<1> bank;
+};
+
+#endif //CYPHY_CONTROL_FIXED_RATE_PID_H
@@ -0,0 +1,49 @@
+//
+// Lock-free hand-over of the latest value from one writer thread to one
+// reader thread, used between the control loop and the MPC solver thread.
+//
+
+#ifndef CYPHY_CONTROL_LATEST_BUFFER_H
+#define CYPHY_CONTROL_LATEST_BUFFER_H
+
+#include <atomic>
+
+/*
+ * Double buffer plus the slot in between (triple buffering): the writer
+ * fills its own slot and swaps it with the middle one, the reader swaps the
+ * middle one with its own when the writer has published since. Neither side
+ * ever waits or sees a slot the other is using, a value the reader does not
+ * pick up in time is overwritten by the next one. One thread may write and
+ * one other thread may read.
+ */
+template <class T>
+class LatestBuffer {
+public:
+    LatestBuffer() : write_slot(0), middle(1), read_slot(2) {}
+
+    // Writer side, value is visible to the next read
+    void write(const T &value) {
+        slots[write_slot] = value;
+        write_slot = middle.exchange(write_slot | FRESH, std::memory_order_acq_rel) & SLOT;
+    }
+
+    // Reader side, value is the latest written one. Returns false if nothing was written since the last read
+    bool read(T &value) {
+        const bool fresh = (middle.load(std::memory_order_relaxed) & FRESH) != 0;
+        if (fresh) {
+            read_slot = middle.exchange(read_slot, std::memory_order_acq_rel) & SLOT;
+        }
+        value = slots[read_slot];
+        return fresh;
+    }
+
+private:
+    enum { SLOT = 3, FRESH = 4 };
+
+    T slots[3];
+    unsigned write_slot;
+    std::atomic<unsigned> middle;
+    unsigned read_slot;
+};
+
+#endif //CYPHY_CONTROL_LATEST_BUFFER_H
@@ -0,0 +1,131 @@
+//
+// Counters, gauges and histograms of the nodes, updated lock-free from any
+// thread and served in the Prometheus text format over a small HTTP endpoint
+// (metrics_port of the nodes, 0 disables).
+//
+
+#ifndef CYPHY_CONTROL_METRICS_H
+#define CYPHY_CONTROL_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define METRICS_SUB_BITS 4          // 16 buckets per power of two, a quantile is within 6.25%
+#define METRICS_OCTAVES 40          // Up to 2^40 units, 12 days in us
+#define METRICS_BUCKETS ((METRICS_OCTAVES - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS)
+
+// Monotonic count, e.g. bytes read or frames decoded
+class MetricCounter {
+public:
+    MetricCounter() : count(0) {}
+
+    void add(uint64_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> count;
+};
+
+// Value that goes up and down, e.g. a queue depth
+class MetricGauge {
+public:
+    MetricGauge() : bits(0) {}
+
+    void set(double v) {
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof(b));
+        bits.store(b, std::memory_order_relaxed);
+    }
+    double value() const {
+        const uint64_t b = bits.load(std::memory_order_relaxed);
+        double v;
+        std::memcpy(&v, &b, sizeof(v));
+        return v;
+    }
+
+private:
+    std::atomic<uint64_t> bits;
+};
+
+/*
+ * Log-linear (HDR) histogram of durations or sizes. Values are counted in
+ * units of unit, exact below 2^METRICS_SUB_BITS units and with
+ * 2^METRICS_SUB_BITS buckets per power of two above, so the relative error
+ * of a quantile is bounded whatever the range. Recording is two relaxed
+ * atomic adds and a bucket increment; served as a summary with quantiles.
+ */
+class MetricHistogram {
+public:
+    explicit MetricHistogram(double unit = 1e-6);
+
+    void record(double value);
+
+    uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    double sum() const { return total.load(std::memory_order_relaxed) * unit; }
+    // Upper bound of the bucket holding quantile q of everything recorded, 0 without samples
+    double quantile(double q) const;
+
+    static int bucketOf(uint64_t units);
+    static uint64_t bucketLimit(int bucket);
+
+private:
+    double unit;
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> total;    // In units
+    std::atomic<uint64_t> buckets[METRICS_BUCKETS];
+};
+
+/*
+ * Metrics of the process. Metrics are created on the first request of their
+ * name and labels and live as long as the process, so the references handed
+ * out stay valid and the updates never take a lock; the mutex only guards
+ * creation and a scrape. Labels are given in the exposition syntax, e.g.
+ * "port=\"/dev/ttyACM0\"".
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry &instance();
+
+    MetricCounter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+    MetricGauge &gauge(const std::string &name, const std::string &help, const std::string &labels = "");
+    MetricHistogram &histogram(const std::string &name, const std::string &help, const std::string &labels = "",
+                               double unit = 1e-6);
+
+    // Everything in the Prometheus text format 0.0.4
+    std::string expose() const;
+
+private:
+    enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Metric {
+        Type type;
+        std::string name, help, labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    Metric &find(Type type, const std::string &name, const std::string &help, const std::string &labels);
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Metric> > metrics;
+};
+
+// Label value with the quotes, backslashes and newlines escaped
+std::string metricLabel(const std::string &key, const std::string &value);
+
+/*
+ * Serves the registry on GET /metrics of a TCP port from a thread of its own.
+ * One per process: nodelets loaded into the same manager share the first
+ * port started and the endpoint stays up until the last of them stopped.
+ */
+bool startMetricsServer(int port);
+void stopMetricsServer();
+
+#endif
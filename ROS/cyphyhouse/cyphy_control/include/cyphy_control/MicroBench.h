@@ -0,0 +1,140 @@
+//
+// Microbenchmark harness of the host hot paths, header-only. The results are
+// written in the JSON of Google Benchmark, so its compare.py diffs two runs.
+//
+
+#ifndef CYPHY_CONTROL_MICRO_BENCH_H
+#define CYPHY_CONTROL_MICRO_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * run times a case in batches: the batch doubles until one takes a tenth of
+ * min_time, then batches repeat until min_time has passed. The case gets the
+ * number of the iteration, so it steps through a fixed set of inputs with
+ * i % size and every run sees the same ones. The median of the batch means
+ * is the figure to compare, the mean is what the JSON reports as real_time.
+ */
+class MicroBench {
+public:
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double real_ns;     // Mean per iteration
+        double cpu_ns;      // Mean process CPU time per iteration
+        double median_ns;   // Of the batch means
+        double max_ns;      // Slowest batch mean
+    };
+
+    explicit MicroBench(double min_time = 0.5) : min_time(min_time) {}
+
+    template <class Case>
+    const Result &run(const std::string &name, Case fn) {
+        typedef std::chrono::steady_clock Clock;
+        uint64_t batch = 1, i = 0;
+        for (;;) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t k = 0; k < batch; ++k) {
+                fn(i++);
+            }
+            if (std::chrono::duration<double>(Clock::now() - start).count() >= min_time / 10 || batch >= (1ULL << 40)) {
+                break;
+            }
+            batch *= 2;
+        }
+
+        std::vector<double> batches;
+        double real = 0;
+        const std::clock_t cpu_start = std::clock();
+        while (real < min_time) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t k = 0; k < batch; ++k) {
+                fn(i++);
+            }
+            const double t = std::chrono::duration<double>(Clock::now() - start).count();
+            batches.push_back(t * 1e9 / batch);
+            real += t;
+        }
+        const double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        Result r;
+        r.name = name;
+        r.iterations = batch * batches.size();
+        r.real_ns = real * 1e9 / r.iterations;
+        r.cpu_ns = cpu * 1e9 / r.iterations;
+        r.max_ns = *std::max_element(batches.begin(), batches.end());
+        std::nth_element(batches.begin(), batches.begin() + batches.size() / 2, batches.end());
+        r.median_ns = batches[batches.size() / 2];
+        printf("%-36s %12.1f ns  median %12.1f ns  max %12.1f ns  %12llu iterations\n", r.name.c_str(), r.real_ns,
+               r.median_ns, r.max_ns, (unsigned long long) r.iterations);
+        results_.push_back(r);
+        return results_.back();
+    }
+
+    // Keeps the compiler from dropping a result nothing else reads
+    template <class T>
+    static void keep(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    const std::vector<Result> &results() const {
+        return results_;
+    }
+
+    bool write_json(const std::string &path, const std::string &executable) const {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f) {
+            return false;
+        }
+        char date[32];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        fprintf(f, "{\n  \"context\": {\n");
+        fprintf(f, "    \"date\": \"%s\",\n", date);
+        fprintf(f, "    \"executable\": \"%s\",\n", escape(executable).c_str());
+        fprintf(f, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+        fprintf(f, "    \"min_time\": %g\n", min_time);
+        fprintf(f, "  },\n  \"benchmarks\": [\n");
+        for (size_t k = 0; k < results_.size(); ++k) {
+            const Result &r = results_[k];
+            fprintf(f, "    {\n");
+            fprintf(f, "      \"name\": \"%s\",\n", escape(r.name).c_str());
+            fprintf(f, "      \"run_name\": \"%s\",\n", escape(r.name).c_str());
+            fprintf(f, "      \"run_type\": \"iteration\",\n");
+            fprintf(f, "      \"repetitions\": 1,\n      \"repetition_index\": 0,\n      \"threads\": 1,\n");
+            fprintf(f, "      \"iterations\": %llu,\n", (unsigned long long) r.iterations);
+            fprintf(f, "      \"real_time\": %.3f,\n", r.real_ns);
+            fprintf(f, "      \"cpu_time\": %.3f,\n", r.cpu_ns);
+            fprintf(f, "      \"time_unit\": \"ns\",\n");
+            fprintf(f, "      \"median_ns\": %.3f,\n", r.median_ns);
+            fprintf(f, "      \"max_ns\": %.3f\n", r.max_ns);
+            fprintf(f, "    }%s\n", k + 1 < results_.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        return fclose(f) == 0;
+    }
+
+private:
+    static std::string escape(const std::string &s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+
+    double min_time;    // s per case
+    std::vector<Result> results_;
+};
+
+#endif //CYPHY_CONTROL_MICRO_BENCH_H
@@ -0,0 +1,56 @@
+//
+// Minimum snap trajectories through waypoint lists, for the quadcopters to
+// fly a mission in one continuous motion instead of stopping at each point.
+//
+
+#ifndef CYPHY_CONTROL_MIN_SNAP_H
+#define CYPHY_CONTROL_MIN_SNAP_H
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+#define MIN_SNAP_ORDER 8            // Coefficients of a segment, degree 7
+#define MIN_SNAP_CHECKS 16          // Samples of a segment checked against the limits
+
+struct MinSnapLimits {
+    double max_speed = 1.0;         // m/s
+    double max_accel = 1.0;         // m/s^2
+};
+
+/*
+ * Piecewise polynomial of degree 7 in x, y and z through the points, at rest
+ * at both ends, that minimizes the integral of the squared snap. The optimum
+ * is continuous up to the 6th derivative at every inner point, which with the
+ * positions makes a square linear system of 8 coefficients per segment. Each
+ * segment is written over its normalized time, so the rows of a segment only
+ * involve it and the next: the system is banded and solved by a sparse LU,
+ * once for the three axes.
+ *
+ * Segment times start from a trapezoidal speed profile over each distance;
+ * the normalized polynomials do not change when all times scale together, so
+ * the trajectory is then slowed as a whole until its sampled speed and
+ * acceleration stay within the limits.
+ */
+class MinSnapTrajectory {
+public:
+    // Fits the trajectory, false with fewer than two distinct points or a singular system
+    bool build(const std::vector<Eigen::Vector3d> &points, const MinSnapLimits &limits);
+    void clear();
+
+    bool empty() const { return durations.empty(); }
+    double duration() const { return empty() ? 0.0 : starts.back() + durations.back(); }
+
+    // Position, velocity and acceleration t [s] from the start, held at the ends outside of it
+    void sample(double t, Eigen::Vector3d &position, Eigen::Vector3d &velocity, Eigen::Vector3d &acceleration) const;
+
+private:
+    // Derivative d with respect to normalized time of the polynomial of a segment at tau
+    Eigen::Vector3d derivative(size_t segment, int d, double tau) const;
+
+    std::vector<double> durations;  // s of each segment
+    std::vector<double> starts;     // s from the start to each segment
+    Eigen::MatrixXd coeffs;         // MIN_SNAP_ORDER rows per segment, x, y and z in the columns
+};
+
+#endif //CYPHY_CONTROL_MIN_SNAP_H
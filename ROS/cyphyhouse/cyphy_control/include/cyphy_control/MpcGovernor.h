@@ -0,0 +1,82 @@
+//
+// Compute budget of the MPC: picks how much of the problem the car solves
+// from how long its recent solves took against the controller deadline.
+//
+
+#ifndef CYPHY_CONTROL_MPC_GOVERNOR_H
+#define CYPHY_CONTROL_MPC_GOVERNOR_H
+
+#include "cyphy_control/CarMpc.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Level 0 is the full problem, every level above it a cheaper one (see
+ * level_problem), each solved by its own CarMpc the caller keeps. After
+ * every solve of the current level, record takes its time: once a window of
+ * them is in and the percentile of the window exceeds high * deadline, the
+ * governor steps one level down in effort; once it stays below low * deadline
+ * and hold solves have passed since the last change, one level back up. The
+ * gap between high and low and the hold keep it from flipping between two
+ * levels. A change starts a new window, the times of the old level say
+ * nothing about the new one.
+ */
+class MpcGovernor {
+public:
+    static const size_t LEVELS = 4;
+
+    explicit MpcGovernor(double deadline, size_t levels = LEVELS);
+
+    double deadline;            // s, the time a solve has
+    double percentile = 0.9;
+    double high = 0.8;          // Fractions of the deadline
+    double low = 0.4;
+    size_t window = 20;         // Solves per decision
+    size_t hold = 50;           // Solves at a level before stepping back up
+
+    // Takes the time [s] of a solve at the current level, returns the level of the next solve
+    size_t record(double seconds);
+    size_t level() const { return current; }
+    // Level changes so far, down and up
+    unsigned long changes() const { return changed; }
+
+    /*
+     * The problem of level of full, and whether it runs the RTI backend:
+     *   1  move blocks 1, 1, 2, 2, 4, or each block of full twice as long
+     *   2  the same with real-time iterations (CarMpc::rti)
+     *   3  half the steps (at least 4) over the same time, no move blocks
+     */
+    template <class Problem>
+    static Problem level_problem(const Problem &full, size_t level, bool &rti) {
+        Problem p = full;
+        rti = level >= 2;
+        if (level >= 1 && level < 3) {
+            if (full.move_blocks[0] == 0) {
+                const size_t blocks[] = {1, 1, 2, 2, 4};
+                std::copy(blocks, blocks + 5, p.move_blocks);
+            } else {
+                for (size_t i = 0; i < CarProblem::MAX_BLOCKS && p.move_blocks[i] > 0; ++i) {
+                    p.move_blocks[i] *= 2;
+                }
+            }
+        }
+        if (level >= 3 && full.N > 4) {
+            p.N = std::max<size_t>(full.N / 2, 4);
+            p.dt = full.dt * full.time(full.N - 1) / p.time(p.N - 1);
+            std::fill(p.move_blocks, p.move_blocks + CarProblem::MAX_BLOCKS, 0);
+        }
+        return p;
+    }
+
+private:
+    size_t levels;
+    size_t current;
+    size_t since_change;
+    unsigned long changed;
+    // Times of the window, in the order they came, and sorted for the percentile
+    std::vector<double> times, sorted;
+    size_t next;
+};
+
+#endif //CYPHY_CONTROL_MPC_GOVERNOR_H
@@ -0,0 +1,199 @@
+//
+// Geometric path tracking of the cars, pure pursuit or Stanley: a few
+// trigonometric calls per cycle in place of an MPC solve, for cars whose
+// computer cannot hold the waypoint rate with Ipopt.
+//
+
+#ifndef CYPHY_CONTROL_PATH_TRACKER_H
+#define CYPHY_CONTROL_PATH_TRACKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#define TRACKER_SEARCH_SEGMENTS 8   // Segments past the current one searched for the nearest point each cycle
+
+enum TrackerMode {
+    TRACK_PURE_PURSUIT = 0,     // Steers onto the arc through a point lookahead ahead on the path
+    TRACK_STANLEY,              // Heading error plus the cross track error of the front axle
+};
+
+struct TrackerParams {
+    double wheelbase = 0.33;        // m
+    double max_steer = 0.35;        // rad
+    double cruise_speed = 1.0;      // m/s, on straight path far from the goal
+    double min_speed = 0.2;         // m/s, floor until the goal is reached
+    double decel = 1.0;             // m/s^2, braking towards the goal
+    double lateral_accel = 2.0;     // m/s^2, limits the speed in curves
+    double goal_radius = 0.25;      // m, the goal counts as reached within it
+    // Pure pursuit, lookahead grows with the speed
+    double lookahead_min = 0.5;     // m
+    double lookahead_gain = 0.5;    // s
+    double lookahead_max = 2.0;     // m
+    // Stanley
+    double stanley_gain = 1.5;      // 1/s
+    double stanley_softening = 0.5; // m/s, keeps the gain finite at standstill
+};
+
+struct TrackPoint {
+    double x, y;
+};
+
+/*
+ * Follows a polyline of waypoints. The progress along it only moves forward,
+ * searched over TRACKER_SEARCH_SEGMENTS segments a cycle, so a path that
+ * crosses itself is followed in order. The path starts at the pose of the
+ * first update, so a single waypoint is reached on a straight segment from
+ * there. Drives forward only. Nothing is allocated after setPath.
+ */
+class PathTracker {
+public:
+    PathTracker() : mode(TRACK_PURE_PURSUIT), segment(0), started(false), speed(0) {}
+
+    void configure(TrackerMode tracker_mode, const TrackerParams &tracker_params) {
+        mode = tracker_mode;
+        params = tracker_params;
+    }
+
+    // Replaces the path, the next update starts it at the car
+    void setPath(const std::vector<TrackPoint> &waypoints) {
+        points.clear();
+        points.reserve(waypoints.size() + 1);
+        points.push_back(TrackPoint{0, 0});
+        points.insert(points.end(), waypoints.begin(), waypoints.end());
+        arc.assign(points.size(), 0.0);
+        segment = 0;
+        started = false;
+    }
+
+    void reset() {
+        points.clear();
+        arc.clear();
+        segment = 0;
+        started = false;
+        speed = 0;
+    }
+
+    /*
+     * Speed and steering of one cycle at pose x, y, yaw [rad]. False once the
+     * goal is reached or without a path, the outputs are then zero.
+     */
+    bool update(double x, double y, double yaw, double &speed_out, double &steer_out) {
+        speed_out = steer_out = 0;
+        if (points.size() < 2) {
+            speed = 0;
+            return false;
+        }
+        if (!started) {
+            points[0] = TrackPoint{x, y};
+            for (size_t i = 1; i < points.size(); ++i) {
+                arc[i] = arc[i - 1] + std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y);
+            }
+            started = true;
+        }
+
+        // Stanley tracks the front axle, pure pursuit the pose
+        const double px = mode == TRACK_STANLEY ? x + params.wheelbase * std::cos(yaw) : x;
+        const double py = mode == TRACK_STANLEY ? y + params.wheelbase * std::sin(yaw) : y;
+        const double s = project(px, py);
+        const double remaining = arc.back() - s;
+        const TrackPoint &goal = points.back();
+        if (std::hypot(goal.x - x, goal.y - y) < params.goal_radius) {
+            speed = 0;
+            return false;
+        }
+
+        double steer;
+        if (mode == TRACK_STANLEY) {
+            const TrackPoint &a = points[segment];
+            const TrackPoint &b = points[segment + 1];
+            const double heading = std::atan2(b.y - a.y, b.x - a.x);
+            const double len = std::max(arc[segment + 1] - arc[segment], 1e-9);
+            // Positive with the path to the left of the front axle
+            const double cross = ((b.x - a.x) * (a.y - py) - (b.y - a.y) * (a.x - px)) / len;
+            steer = wrap(heading - yaw) + std::atan2(params.stanley_gain * cross, params.stanley_softening + speed);
+        } else {
+            const double lookahead = std::min(std::max(params.lookahead_min + params.lookahead_gain * speed,
+                                                       params.lookahead_min), params.lookahead_max);
+            const TrackPoint target = pointAt(s + lookahead);
+            const double dx = target.x - x;
+            const double dy = target.y - y;
+            const double dist = std::max(std::hypot(dx, dy), 1e-6);
+            const double alpha = wrap(std::atan2(dy, dx) - yaw);
+            steer = std::atan(2 * params.wheelbase * std::sin(alpha) / dist);
+        }
+        steer = std::max(std::min(steer, params.max_steer), -params.max_steer);
+
+        // Slow for the curvature steered and to stop at the goal
+        const double curvature = std::fabs(std::tan(steer)) / params.wheelbase;
+        double v = params.cruise_speed;
+        if (curvature > 1e-6) {
+            v = std::min(v, std::sqrt(params.lateral_accel / curvature));
+        }
+        v = std::min(v, std::sqrt(2 * params.decel * std::max(remaining, 0.0)));
+        speed = std::max(v, params.min_speed);
+
+        speed_out = speed;
+        steer_out = steer;
+        return true;
+    }
+
+    // Index of the segment the car is on, 0 to the number of waypoints - 1
+    size_t getSegment() const { return segment; }
+
+private:
+    static double wrap(double a) {
+        return std::atan2(std::sin(a), std::cos(a));
+    }
+
+    // Moves segment to the nearest point of the next segments, its arc length
+    double project(double x, double y) {
+        const size_t last = std::min(segment + TRACKER_SEARCH_SEGMENTS, points.size() - 2);
+        double best = INFINITY, best_s = arc[segment];
+        size_t best_segment = segment;
+        for (size_t i = segment; i <= last; ++i) {
+            const TrackPoint &a = points[i];
+            const TrackPoint &b = points[i + 1];
+            const double len = arc[i + 1] - arc[i];
+            double t = 0;
+            if (len > 1e-9) {
+                t = ((x - a.x) * (b.x - a.x) + (y - a.y) * (b.y - a.y)) / (len * len);
+                t = std::max(0.0, std::min(1.0, t));
+            }
+            const double d = std::hypot(a.x + t * (b.x - a.x) - x, a.y + t * (b.y - a.y) - y);
+            if (d < best) {
+                best = d;
+                best_s = arc[i] + t * len;
+                best_segment = i;
+            }
+        }
+        segment = best_segment;
+        return best_s;
+    }
+
+    // Point at arc length s, the end of the path past it
+    TrackPoint pointAt(double s) const {
+        if (s >= arc.back()) {
+            return points.back();
+        }
+        size_t i = segment;
+        while (i + 2 < points.size() && arc[i + 1] < s) {
+            ++i;
+        }
+        const double len = arc[i + 1] - arc[i];
+        const double t = len > 1e-9 ? (s - arc[i]) / len : 0;
+        return TrackPoint{points[i].x + t * (points[i + 1].x - points[i].x),
+                          points[i].y + t * (points[i + 1].y - points[i].y)};
+    }
+
+    TrackerMode mode;
+    TrackerParams params;
+    std::vector<TrackPoint> points;   // The start of the path, then the waypoints
+    std::vector<double> arc;          // Arc length at each point
+    size_t segment;
+    bool started;
+    double speed;                     // Commanded last cycle, the lookahead and softening follow it
+};
+
+#endif
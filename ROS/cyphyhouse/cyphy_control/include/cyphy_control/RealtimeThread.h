@@ -0,0 +1,161 @@
+//
+// Scheduling of the latency-critical threads from ROS parameters: SCHED_FIFO
+// priority, CPU affinity, locked memory and a pre-faulted stack, periodic
+// loops on absolute deadlines with a phase, their wake-up jitter as
+// diagnostics, and callback queues of their own for the sensor callbacks.
+//
+
+#ifndef CYPHY_CONTROL_REALTIME_THREAD_H
+#define CYPHY_CONTROL_REALTIME_THREAD_H
+
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How one thread runs, the defaults leave it as std::thread starts it
+struct ThreadConfig {
+    int priority = 0;           // SCHED_FIFO priority 1..99, 0 stays SCHED_OTHER
+    std::vector<int> cpus;      // CPUs it may run on, empty for all
+    size_t stack_prefault = 0;  // Bytes of stack touched before it starts [B]
+};
+
+/*
+ * ~<name>_priority, ~<name>_cpus and ~<name>_stack_prefault of n, e.g.
+ * drive_priority: 80, drive_cpus: "3" for the drive thread. The CPUs are a
+ * comma separated list of CPUs and ranges, "2,3" or "2-3".
+ */
+ThreadConfig load_thread_config(const ros::NodeHandle &n, const std::string &name);
+
+/*
+ * mlockall of the current and future pages if ~lock_memory of n is set, once
+ * per process, so the loops never wait for a page to come back from disk or
+ * be faulted in. Thread stacks mapped later are locked, and so faulted in, as
+ * a whole. False if locking was asked for and failed.
+ */
+bool lock_memory(const ros::NodeHandle &n);
+
+/*
+ * Names the calling thread (at most 15 characters show) and applies config
+ * to it. What the process may not do, typically SCHED_FIFO without
+ * CAP_SYS_NICE or an rtprio limit, is warned about and left as it was.
+ */
+bool apply_thread_config(const std::string &name, const ThreadConfig &config);
+
+// A thread that applies config to itself, then runs f(args...)
+template <class F, class... Args>
+std::thread start_thread(const std::string &name, const ThreadConfig &config, F f, Args... args) {
+    std::function<void()> body = std::bind(f, args...);
+    return std::thread([name, config, body]() {
+        apply_thread_config(name, config);
+        body();
+    });
+}
+
+/*
+ * A callback queue of its own and the thread serving it, scheduled by
+ * load_thread_config(n, name) like the other threads, e.g. sensor_priority.
+ * Subscriptions and timers made through node() go to this queue instead of
+ * the one ros::spin or the nodelet manager serves, so the high-rate pose and
+ * speed callbacks never wait behind a slow waypoint or map callback: their
+ * delay is bounded by the callbacks of this queue alone. Those still run one
+ * at a time and in order, on another thread than ros::spin though.
+ */
+class CallbackThread {
+public:
+    // A node handle of the namespace of n on the new queue, the thread named name
+    CallbackThread(const ros::NodeHandle &n, const std::string &name);
+    ~CallbackThread();
+
+    ros::NodeHandle &node() { return handle; }
+
+    // Returns once the callback under way, if any, has finished and no other will run, e.g. before the state the
+    // callbacks write is torn down. The destructor stops too
+    void stop();
+
+private:
+    void serve();
+
+    ros::CallbackQueue queue;
+    ros::NodeHandle handle;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+/*
+ * Wake-up jitter of a periodic loop: the loop thread ticks at the top of every
+ * cycle and the deviation of each interval from the period is kept, or a
+ * PeriodicLoop records how late it woke. The diagnostics timer reads and
+ * resets it. No lock, tick costs a clock read and a few relaxed atomics.
+ */
+class MetricCounter;
+class MetricHistogram;
+
+class LoopJitter {
+public:
+    explicit LoopJitter(double period);
+
+    // Also counts overruns and wake-up deviations in the metrics of the process under loop, see Metrics.h
+    void exportMetrics(const std::string &loop);
+
+    // Loop side
+    void tick();
+    void record(int64_t deviation_ns, uint32_t missed);
+
+    // Worst and mean deviation since the last status and the worst ever, WARN once the worst of the window
+    // exceeds limit [s]
+    diagnostic_msgs::DiagnosticStatus status(const std::string &name, double limit);
+
+private:
+    int64_t period_ns;
+    int64_t last_ns;            // Loop thread only, 0 before the first tick
+    std::atomic<int64_t> worst_ns;
+    std::atomic<int64_t> total_ns;
+    std::atomic<uint32_t> cycles;
+    std::atomic<uint32_t> overruns;     // Intervals longer than two periods, or deadlines missed
+    int64_t worst_ever_ns;      // Diagnostics side only
+    MetricCounter *overrun_metric;
+    MetricHistogram *jitter_metric;
+};
+
+/*
+ * The timing of a periodic loop, in place of ros::Rate. The wake-ups are the
+ * absolute deadlines phase + k * period of the system clock, so they do not
+ * drift with the time the loop body takes, and every loop of the same period
+ * wakes at the same instants, in every process and on every host whose clock
+ * is synced. A phase shifts a consumer behind its producer, e.g. the drive
+ * loop 2 ms behind the estimator publishing at phase 0. A cycle that runs past
+ * its next deadline skips to the first one still ahead, so the loop keeps its
+ * phase, and the deadlines skipped count as overruns. Runs on the wall clock
+ * and ignores /use_sim_time.
+ */
+class PeriodicLoop {
+public:
+    // jitter, if given, gets how late every wake-up was and the deadlines missed
+    explicit PeriodicLoop(double period, double phase = 0, LoopJitter *jitter = nullptr);
+
+    // Sleeps until the next deadline, false if a deadline was missed since the last call
+    bool sleep();
+
+    // Deadline of the current cycle [s of the system clock]
+    double deadline() const;
+    uint64_t overruns() const { return missed; }
+
+    // First deadline of period and phase after now [s]
+    static double next_deadline(double now, double period, double phase);
+
+private:
+    int64_t period_ns;
+    int64_t phase_ns;           // In [0, period_ns)
+    int64_t next_ns;            // 0 before the first sleep
+    uint64_t missed;
+    LoopJitter *jitter;
+};
+
+#endif //CYPHY_CONTROL_REALTIME_THREAD_H
@@ -0,0 +1,78 @@
+//
+// Bounded lock-free single-producer/single-consumer ring buffer, hands
+// messages from a callback or a serial thread to a control or estimator
+// thread without either side blocking on the other.
+//
+
+#ifndef CYPHY_CONTROL_SPSC_QUEUE_H
+#define CYPHY_CONTROL_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define SPSC_CACHE_LINE 64
+
+/*
+ * Capacity must be a power of two. Only one thread may call push() and only
+ * one (other) thread may call pop(); the counters can be read from anywhere.
+ * When the queue is full push() drops the new element and counts the drop.
+ */
+template <typename T, size_t Capacity>
+class SPSCQueue {
+    static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0), "SPSC queue capacity must be a power of two");
+
+public:
+    SPSCQueue() : head(0), tail(0), drops(0), maxDepth(0) {}
+
+    // Producer side
+    bool push(const T &item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t depth = h - tail.load(std::memory_order_acquire);
+        if (depth >= Capacity) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        buffer[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        if (depth + 1 > maxDepth.load(std::memory_order_relaxed)) {
+            maxDepth.store(depth + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = buffer[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Monitoring
+    size_t depth() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    uint32_t dropCount() const { return drops.load(std::memory_order_relaxed); }
+    uint32_t maxDepthSeen() const { return maxDepth.load(std::memory_order_relaxed); }
+
+private:
+    // Producer and consumer indices on separate cache lines to avoid false sharing.
+    // Padding rather than alignas, so the queue can live in plain new'ed storage
+    std::atomic<size_t> head;
+    char headPad[SPSC_CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail;
+    char tailPad[SPSC_CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<uint32_t> drops;
+    std::atomic<uint32_t> maxDepth;
+
+    T buffer[Capacity];
+};
+
+#endif //CYPHY_CONTROL_SPSC_QUEUE_H
@@ -0,0 +1,70 @@
+//
+// Lock-free latest value of a small state, e.g. a pose or a twist, written
+// by a ROS callback and read by any number of control threads.
+//
+
+#ifndef CYPHY_CONTROL_SNAPSHOT_H
+#define CYPHY_CONTROL_SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Seqlock: the writer makes the sequence odd, stores the value word by word
+ * and makes it even again, a reader copies the words and retries until it
+ * saw the same even sequence before and after. The writer never waits and a
+ * reader only retries while a store is under way, both are a few word
+ * copies. Unlike LatestBuffer every reader gets the whole latest value, not
+ * only the first one after each write. One thread may write, any number of
+ * threads may read.
+ */
+template <class T>
+class Snapshot {
+    static_assert(std::is_trivially_copyable<T>::value, "Snapshot copies its value word by word");
+
+public:
+    Snapshot() : seq(0) {
+        store(T());
+    }
+
+    // Writer side
+    void store(const T &value) {
+        uint64_t copy[WORDS] = {};
+        std::memcpy(copy, &value, sizeof(T));
+        const unsigned s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i].store(copy[i], std::memory_order_relaxed);
+        }
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Reader side, the value of the last completed store
+    T load() const {
+        uint64_t copy[WORDS];
+        unsigned before, after;
+        do {
+            before = seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i) {
+                copy[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, copy, sizeof(T));
+        return value;
+    }
+
+private:
+    enum { WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t) };
+
+    std::atomic<unsigned> seq;
+    std::atomic<uint64_t> words[WORDS];
+};
+
+#endif //CYPHY_CONTROL_SNAPSHOT_H
@@ -0,0 +1,166 @@
+//
+// Telemetry of the MPC solves: a lock-free ring the solver records into and
+// the rolling summary the node publishes as diagnostics.
+//
+
+#ifndef CYPHY_CONTROL_SOLVE_STATS_H
+#define CYPHY_CONTROL_SOLVE_STATS_H
+
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// One solve of MPC::Solve
+struct SolveSample {
+    double time = 0.0;      // wall time [s]
+    int iterations = 0;     // Ipopt iterations, ADMM iterations of a real-time iteration
+    int status = 0;         // Ipopt::ApplicationReturnStatus
+    double cost = 0.0;
+    double violation = 0.0; // largest constraint violation of the solution
+    int source = 0;         // CarMpc::Source of the controls driven
+};
+
+/*
+ * Single producer, single consumer ring of the latest solves. record never
+ * waits, a full ring drops the sample and counts it in dropped, so the solver
+ * is never held up by a slow reader.
+ */
+class SolveStats {
+public:
+    SolveStats() : dropped(0), head(0), tail(0) {}
+
+    // Solver side
+    void record(const SolveSample &sample) {
+        const unsigned h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[h % SIZE] = sample;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Reader side, false once the ring is empty
+    bool pop(SolveSample &sample) {
+        const unsigned t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        sample = ring[t % SIZE];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::atomic<unsigned> dropped;
+
+private:
+    enum { SIZE = 64 };
+
+    SolveSample ring[SIZE];
+    std::atomic<unsigned> head;
+    std::atomic<unsigned> tail;
+};
+
+/*
+ * The last window solves of a SolveStats, summarized as solve time
+ * percentiles, deadline misses, failures, the solves driven on a fallback
+ * and the worst constraint violation.
+ */
+class SolveWindow {
+public:
+    explicit SolveWindow(size_t window = 500) : window(window), next(0), solves(0), misses(0) {}
+
+    // Moves everything recorded so far into the window
+    void drain(SolveStats &stats, double deadline) {
+        SolveSample sample;
+        while (stats.pop(sample)) {
+            if (samples.size() < window) {
+                samples.push_back(sample);
+            } else {
+                samples[next] = sample;
+            }
+            next = (next + 1) % window;
+            ++solves;
+            if (sample.time > deadline) {
+                ++misses;
+            }
+        }
+    }
+
+    // Status of the window, WARN if a solve of it missed the deadline or failed
+    diagnostic_msgs::DiagnosticStatus status(const std::string &name, double deadline, unsigned dropped) const {
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = name;
+        status.hardware_id = name;
+        if (samples.empty()) {
+            status.level = diagnostic_msgs::DiagnosticStatus::STALE;
+            status.message = "no solves";
+            return status;
+        }
+
+        std::vector<double> times;
+        unsigned window_misses = 0, failures = 0, best_iterates = 0, fallbacks = 0;
+        double iterations = 0.0, violation = 0.0;
+        for (const SolveSample &s : samples) {
+            times.push_back(s.time);
+            window_misses += s.time > deadline;
+            // Solve_Succeeded and Solved_To_Acceptable_Level
+            failures += s.status != 0 && s.status != 1;
+            iterations += s.iterations;
+            violation = std::max(violation, s.violation);
+            // CarMpc::BEST_ITERATE, then SHIFTED and STOPPED
+            best_iterates += s.source == 1;
+            fallbacks += s.source > 1;
+        }
+        std::sort(times.begin(), times.end());
+        const SolveSample &last = samples[(next + samples.size() - 1) % samples.size()];
+
+        status.level = (window_misses || failures) ? diagnostic_msgs::DiagnosticStatus::WARN
+                                                   : diagnostic_msgs::DiagnosticStatus::OK;
+        status.message = window_misses ? "deadline missed" : (failures ? "solve failed" : "ok");
+        add(status, "solves", solves);
+        add(status, "deadline misses", misses);
+        add(status, "dropped samples", dropped);
+        add(status, "window", samples.size());
+        add(status, "window deadline misses", window_misses);
+        add(status, "window failures", failures);
+        add(status, "window best iterates", best_iterates);
+        add(status, "window fallbacks", fallbacks);
+        add(status, "time p50 [s]", percentile(times, 0.5));
+        add(status, "time p90 [s]", percentile(times, 0.9));
+        add(status, "time p99 [s]", percentile(times, 0.99));
+        add(status, "time max [s]", times.back());
+        add(status, "mean iterations", iterations / samples.size());
+        add(status, "max violation", violation);
+        add(status, "last status", last.status);
+        add(status, "last cost", last.cost);
+        return status;
+    }
+
+private:
+    // Nearest rank of sorted
+    static double percentile(const std::vector<double> &sorted, double p) {
+        const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[rank];
+    }
+
+    static void add(diagnostic_msgs::DiagnosticStatus &status, const std::string &key, double value) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%g", value);
+        diagnostic_msgs::KeyValue kv;
+        kv.key = key;
+        kv.value = buf;
+        status.values.push_back(kv);
+    }
+
+    size_t window;
+    size_t next;
+    std::vector<SolveSample> samples;
+    unsigned long solves;
+    unsigned long misses;
+};
+
+#endif //CYPHY_CONTROL_SOLVE_STATS_H
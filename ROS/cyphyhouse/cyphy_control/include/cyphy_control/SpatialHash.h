@@ -0,0 +1,62 @@
+//
+// Uniform grid over the plane for neighbour queries among many moving points,
+// e.g. the robots of a fleet. Rebuilt from scratch every tick, which for a few
+// hundred points costs less than keeping it up to date as they move.
+//
+
+#ifndef CYPHY_CONTROL_SPATIAL_HASH_H
+#define CYPHY_CONTROL_SPATIAL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * The points are binned by the square cell of side cell_size they fall into
+ * and the cells are hashed into a table of at least twice as many buckets as
+ * points. build sorts the points by bucket (counting sort) and keeps their
+ * coordinates in that order, so the points of a cell are contiguous and a
+ * query reads a few cache lines per cell. Cells that share a bucket are told
+ * apart by the cell of each point. The height does not bin, but counts in the
+ * distances. A cell_size around the usual query radius reads the fewest
+ * points.
+ */
+class SpatialHash {
+public:
+    // Index of a point as given to build and its distance to the query point [m]
+    typedef std::pair<uint32_t, double> Neighbour;
+    static const uint32_t NONE = UINT32_MAX;
+
+    explicit SpatialHash(double cell_size);
+
+    // Replaces the points with the n at x[i], y[i], z[i]
+    void build(const double *x, const double *y, const double *z, size_t n);
+
+    // The points within radius of x, y, z, nearest first, leaving out the point exclude
+    void radius(double x, double y, double z, double radius, std::vector<Neighbour> &out,
+                uint32_t exclude = NONE) const;
+
+    // The k points nearest to x, y, z, nearest first, none farther than max_radius (0 for any), leaving out the
+    // point exclude
+    void nearest(double x, double y, double z, size_t k, double max_radius, std::vector<Neighbour> &out,
+                 uint32_t exclude = NONE) const;
+
+    size_t size() const { return index.size(); }
+
+private:
+    int64_t cell_of(double v) const;
+    uint32_t bucket(int64_t cx, int64_t cy) const;
+    // Appends the points of cell cx, cy within squared distance r2 of x, y, z
+    void visit(int64_t cx, int64_t cy, double x, double y, double z, double r2, uint32_t exclude,
+               std::vector<Neighbour> &out) const;
+
+    double cell_size;
+    uint32_t mask;                  // Buckets - 1, a power of two
+    std::vector<uint32_t> start;    // Points of bucket b are start[b] to start[b + 1]
+    std::vector<uint32_t> index;    // Index given to build of each sorted point
+    std::vector<double> px, py, pz; // Coordinates of the sorted points
+    int64_t min_cx, max_cx, min_cy, max_cy; // Cells spanned by the points
+};
+
+#endif //CYPHY_CONTROL_SPATIAL_HASH_H
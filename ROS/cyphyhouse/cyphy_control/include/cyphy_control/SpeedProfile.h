@@ -0,0 +1,74 @@
+//
+// Time parametrization of waypoint paths: a speed profile within the
+// acceleration and lateral acceleration of the car, fitted once per path, so
+// the MPC tracks a timed reference instead of finding the speeds itself.
+//
+
+#ifndef CYPHY_CONTROL_SPEED_PROFILE_H
+#define CYPHY_CONTROL_SPEED_PROFILE_H
+
+#include "cyphy_control/PathTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ProfileLimits {
+    double max_speed = 1.5;         // m/s
+    double max_accel = 1.0;         // m/s^2
+    double max_decel = 1.0;         // m/s^2
+    double lateral_accel = 2.0;     // m/s^2, v^2 * curvature at most
+    double spacing = 0.1;           // m between the samples of the path
+    double start_speed = 0.0;       // m/s at the first point
+    double end_speed = 0.0;         // m/s at the last point
+};
+
+/*
+ * A polyline resampled every spacing with the curvature of each sample, the
+ * speed limit it implies, and a forward pass within max_accel and a backward
+ * pass within max_decel over those limits. Time follows from the speeds,
+ * constant acceleration between samples. build keeps the profile if points
+ * and limits are the ones of the last build, so a path sent again does not
+ * start over; the vectors keep their storage across builds.
+ *
+ * Progress is the arc length of the nearest sample, searched forward from
+ * the last one only: progress never moves back, so the reference never runs
+ * away from a car that falls behind either.
+ */
+class SpeedProfile {
+public:
+    SpeedProfile();
+
+    // Fits the profile to points, false with fewer than two distinct points. True as well if nothing changed
+    bool build(const std::vector<TrackPoint> &points, const ProfileLimits &limits);
+    void clear();
+
+    bool empty() const { return samples.empty(); }
+    double length() const { return empty() ? 0.0 : samples.back().s; }
+    double duration() const { return empty() ? 0.0 : samples.back().t; }
+
+    // Time along the profile of the nearest sample to (x, y), moves the progress forward to it
+    double progress(double x, double y);
+    // Position, heading and speed at time t, clamped to the ends of the profile
+    void sample(double t, double &x, double &y, double &heading, double &speed) const;
+
+    // Reference of each step of a horizon starting at time t0: the n x positions at t0 + times[k], then the n y
+    void references(double t0, const double *times, size_t n, double *out) const;
+
+private:
+    struct Sample {
+        double x, y;
+        double s;       // Arc length [m]
+        double v;       // m/s
+        double t;       // s from the first sample
+    };
+
+    // Sample before time t, searched from the progress
+    size_t before(double t) const;
+
+    std::vector<Sample> samples;
+    std::vector<double> limit;      // Speed limit of each sample from its curvature
+    size_t cursor;                  // Sample of the progress
+    uint64_t fingerprint;           // Of the points and limits of the last build
+};
+
+#endif //CYPHY_CONTROL_SPEED_PROFILE_H
@@ -0,0 +1,74 @@
+//
+// Recording of the trajectory of a robot: fixed-size binary samples handed
+// through a lock-free ring to a thread that writes them in large blocks.
+//
+
+#ifndef CYPHY_CONTROL_TRAJECTORY_RECORDER_H
+#define CYPHY_CONTROL_TRAJECTORY_RECORDER_H
+
+#include "cyphy_control/SPSCQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TRAJECTORY_MAX_VALUES 8
+#define TRAJECTORY_QUEUE_SIZE 1024 // Must be a power of two
+
+// One sample, the values in the order of the fields of the recorder
+struct TrajectorySample {
+    int64_t stamp;          // ROS time [ns]
+    double values[TRAJECTORY_MAX_VALUES];
+};
+
+/*
+ * record costs a copy into the ring, never a lock or a write, a full ring
+ * drops the sample and counts it. Only one thread may record, typically the
+ * callback of the pose. The file is
+ *   "CYTRJ1\n"
+ *   "source: <source>\nstart: <ns>\nfields: stamp,<field>,...\n\n"
+ *   blocks of u32 n, then n samples of i64 stamp and one f64 per field
+ * in host byte order, gzip compressed as a whole if compress is set.
+ */
+class TrajectoryRecorder {
+public:
+    // Creates path and starts writing to it, see ok
+    TrajectoryRecorder(const std::string &path, const std::string &source, const std::vector<std::string> &fields,
+                       bool compress);
+    // Writes what is left and closes the file
+    ~TrajectoryRecorder();
+
+    // False if the file could not be created, record does nothing then
+    bool ok() const;
+    uint32_t dropped() const;
+
+    // One value per field, the fields not given are 0
+    template <class... Values>
+    void record(int64_t stamp, Values... values) {
+        static_assert(sizeof...(Values) <= TRAJECTORY_MAX_VALUES, "too many values for one sample");
+        if (!file) {
+            return;
+        }
+        const double given[] = {static_cast<double>(values)..., 0.0};
+        TrajectorySample sample;
+        sample.stamp = stamp;
+        for (size_t i = 0; i < TRAJECTORY_MAX_VALUES; ++i) {
+            sample.values[i] = i < sizeof...(Values) ? given[i] : 0.0;
+        }
+        queue.push(sample);
+    }
+
+private:
+    void run();
+    // Writes the first n samples of block
+    void write(const std::vector<TrajectorySample> &block, uint32_t n);
+
+    void *file;             // gzFile, zlib stays out of the header
+    size_t n_fields;
+    SPSCQueue<TrajectorySample, TRAJECTORY_QUEUE_SIZE> queue;
+    std::atomic<bool> running;
+    std::thread writer;
+};
+
+#endif //CYPHY_CONTROL_TRAJECTORY_RECORDER_H
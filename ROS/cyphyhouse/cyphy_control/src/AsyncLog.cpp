@@ -0,0 +1,191 @@
+#include "cyphy_control/AsyncLog.h"
+#include <ros/console.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define DRAIN_PERIOD_MS 10
+#define FILE_BUFFER_SIZE (1 << 16)
+
+/*
+ * Registry of the channels and the thread draining them. The mutex is only
+ * taken by the drain and by channels coming and going, never by a log call.
+ */
+class AsyncLogDrain {
+public:
+    static AsyncLogDrain &instance() {
+        static AsyncLogDrain drain;
+        return drain;
+    }
+
+    void add(LogChannel *channel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        channels.push_back(channel);
+    }
+
+    void remove(LogChannel *channel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        channels.erase(std::remove(channels.begin(), channels.end(), channel), channels.end());
+        for (auto it = lines.begin(); it != lines.end();) {
+            it = it->first.first == channel ? lines.erase(it) : std::next(it);
+        }
+    }
+
+    void start(double throttle, const std::string &binary_path) {
+        std::lock_guard<std::mutex> lock(users_mutex);
+        if (users++ > 0) {
+            return;
+        }
+        throttle_ns = static_cast<int64_t>(throttle * 1e9);
+        if (!binary_path.empty()) {
+            file = std::fopen(binary_path.c_str(), "wb");
+            if (file) {
+                std::setvbuf(file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+                std::fputs("CYLOG1\n", file);
+            } else {
+                ROS_WARN("Cannot open the binary log %s", binary_path.c_str());
+            }
+        }
+        running = true;
+        thread = std::thread(&AsyncLogDrain::run, this);
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(users_mutex);
+        if (users == 0 || --users > 0) {
+            return;
+        }
+        running = false;
+        thread.join();
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+private:
+    // Id in the binary file, when it was last printed and the lines held back since
+    struct Line {
+        uint16_t id;
+        int64_t printed;
+        unsigned held;
+    };
+
+    AsyncLogDrain() : running(false), users(0), throttle_ns(0), file(nullptr), next_id(0) {}
+
+    void run() {
+        while (running) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_PERIOD_MS));
+        }
+        drain();
+        if (file) {
+            std::fflush(file);
+        }
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (LogChannel *channel : channels) {
+            LogRecord record;
+            while (channel->queue.pop(record)) {
+                handle(*channel, record);
+            }
+            const uint32_t drops = channel->queue.dropCount();
+            if (drops != channel->reported_drops) {
+                ROS_WARN("[%s] %u log records dropped", channel->name, drops - channel->reported_drops);
+                channel->reported_drops = drops;
+            }
+        }
+    }
+
+    void handle(const LogChannel &channel, const LogRecord &record) {
+        auto found = lines.find(std::make_pair(&channel, record.format));
+        if (found == lines.end()) {
+            Line line = {next_id++, record.stamp - throttle_ns, 0};
+            found = lines.insert(std::make_pair(std::make_pair(&channel, record.format), line)).first;
+            if (file) {
+                const std::string text = std::string(channel.name) + ": " + record.format;
+                const uint16_t length = static_cast<uint16_t>(text.size());
+                std::fputc('F', file);
+                std::fwrite(&line.id, sizeof(line.id), 1, file);
+                std::fwrite(&length, sizeof(length), 1, file);
+                std::fwrite(text.data(), 1, length, file);
+            }
+        }
+        Line &line = found->second;
+
+        if (file) {
+            const uint8_t level = record.level;
+            std::fputc('R', file);
+            std::fwrite(&line.id, sizeof(line.id), 1, file);
+            std::fwrite(&level, sizeof(level), 1, file);
+            std::fwrite(&record.count, sizeof(record.count), 1, file);
+            std::fwrite(&record.stamp, sizeof(record.stamp), 1, file);
+            std::fwrite(record.values, sizeof(double), record.count, file);
+        }
+
+        if (record.level == LogRecord::INFO && record.stamp - line.printed < throttle_ns) {
+            ++line.held;
+            return;
+        }
+
+        char text[256];
+        const double *v = record.values;
+        std::snprintf(text, sizeof(text), record.format, v[0], v[1], v[2], v[3], v[4], v[5]);
+        char held[32] = "";
+        if (line.held) {
+            std::snprintf(held, sizeof(held), " (%u more)", line.held);
+        }
+        switch (record.level) {
+        case LogRecord::INFO:
+            ROS_INFO("[%s] %s%s", channel.name, text, held);
+            break;
+        case LogRecord::WARN:
+            ROS_WARN("[%s] %s%s", channel.name, text, held);
+            break;
+        default:
+            ROS_ERROR("[%s] %s%s", channel.name, text, held);
+            break;
+        }
+        line.printed = record.stamp;
+        line.held = 0;
+    }
+
+    std::mutex mutex;
+    std::vector<LogChannel *> channels;
+    std::map<std::pair<const LogChannel *, const char *>, Line> lines;
+
+    std::mutex users_mutex;
+    std::thread thread;
+    std::atomic<bool> running;
+    unsigned users;
+    int64_t throttle_ns;
+    FILE *file;
+    uint16_t next_id;
+};
+
+LogChannel::LogChannel(const char *name) : name(name), reported_drops(0) {
+    AsyncLogDrain::instance().add(this);
+}
+
+LogChannel::~LogChannel() {
+    AsyncLogDrain::instance().remove(this);
+}
+
+namespace async_log {
+
+void start(double throttle, const std::string &binary_path) {
+    AsyncLogDrain::instance().start(throttle, binary_path);
+}
+
+void stop() {
+    AsyncLogDrain::instance().stop();
+}
+
+}
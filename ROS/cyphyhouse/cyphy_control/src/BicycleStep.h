@@ -0,0 +1,235 @@
+//
+// One step of the kinematic bicycle of the MPC as a CppAD atomic function,
+// so the tape of FG_eval holds one operation per horizon step instead of the
+// cos, sin and tan of each, and the sparse Jacobian and Hessian sweeps go
+// through derivatives and sparsity patterns written out here.
+//
+
+#ifndef CYPHY_CONTROL_BICYCLE_STEP_H
+#define CYPHY_CONTROL_BICYCLE_STEP_H
+
+#include <cppad/cppad.hpp>
+#include <cmath>
+#include <set>
+
+/*
+ * Maps (x, y, psi, v, delta, dt, lr) to the state after the step,
+ *     x + v cos(psi) dt,  y + v sin(psi) dt,  psi + v tan(delta) dt / lr
+ * dt and lr are parameters on the MPC tape but are differentiated like the
+ * others. Forward mode goes to order 1 and reverse mode to order 1 (two
+ * Taylor coefficients), what the sparse Jacobian and Hessian drivers of
+ * TapedNLP use; higher orders fail. Sparsity is the std::set kind that
+ * TapedNLP::sparsity asks for.
+ *
+ * CppAD wants atomic functions constructed while it is not in parallel
+ * mode, the single instance is a global of CarMpc.cpp for that reason.
+ */
+class BicycleStep : public CppAD::atomic_base<double> {
+public:
+    enum Input { X, Y, PSI, V, DELTA, DT, LR, INPUTS };
+    static const size_t OUTPUTS = 3;
+
+    BicycleStep() : CppAD::atomic_base<double>("bicycle_step", CppAD::atomic_base<double>::set_sparsity_enum) {}
+
+    // The state after the step from ax, recorded as one operation
+    template <class ADvector>
+    void step(const ADvector &ax, ADvector &ay) {
+        (*this)(ax, ay);
+    }
+
+private:
+    typedef CppAD::vector<std::set<size_t> > Sets;
+
+    // Inputs each output depends on, the rows of the Jacobian pattern
+    static bool depends(size_t j, size_t i) {
+        static const bool pattern[OUTPUTS][INPUTS] = {
+            {true, false, true, true, false, true, false},
+            {false, true, true, true, false, true, false},
+            {false, false, true, true, true, true, true}};
+        return pattern[j][i];
+    }
+
+    // Pairs of inputs output j is not linear in, the Hessian pattern of that output
+    static bool curved(size_t j, size_t i, size_t k) {
+        if (j < 2) {
+            return (i == PSI || i == V || i == DT) && (k == PSI || k == V || k == DT) && !(i == V && k == V) &&
+                   !(i == DT && k == DT);
+        }
+        return (i == V || i == DELTA || i == DT || i == LR) && (k == V || k == DELTA || k == DT || k == LR) &&
+               !(i == V && k == V) && !(i == DT && k == DT);
+    }
+
+    // Value, Jacobian and Hessians of the step at u
+    static void derivatives(const double *u, double *f, double J[OUTPUTS][INPUTS],
+                            double H[OUTPUTS][INPUTS][INPUTS]) {
+        const double v = u[V], dt = u[DT], lr = u[LR];
+        const double c = std::cos(u[PSI]), s = std::sin(u[PSI]), T = std::tan(u[DELTA]);
+        const double g = 1.0 + T * T;
+        f[0] = u[X] + v * c * dt;
+        f[1] = u[Y] + v * s * dt;
+        f[2] = u[PSI] + v * T * dt / lr;
+        for (size_t j = 0; j < OUTPUTS; ++j) {
+            for (size_t i = 0; i < INPUTS; ++i) {
+                J[j][i] = 0.0;
+                for (size_t k = 0; k < INPUTS; ++k) {
+                    H[j][i][k] = 0.0;
+                }
+            }
+        }
+
+        J[0][X] = 1.0;
+        J[0][PSI] = -v * s * dt;
+        J[0][V] = c * dt;
+        J[0][DT] = v * c;
+        H[0][PSI][PSI] = -v * c * dt;
+        H[0][PSI][V] = H[0][V][PSI] = -s * dt;
+        H[0][PSI][DT] = H[0][DT][PSI] = -v * s;
+        H[0][V][DT] = H[0][DT][V] = c;
+
+        J[1][Y] = 1.0;
+        J[1][PSI] = v * c * dt;
+        J[1][V] = s * dt;
+        J[1][DT] = v * s;
+        H[1][PSI][PSI] = -v * s * dt;
+        H[1][PSI][V] = H[1][V][PSI] = c * dt;
+        H[1][PSI][DT] = H[1][DT][PSI] = v * c;
+        H[1][V][DT] = H[1][DT][V] = s;
+
+        J[2][PSI] = 1.0;
+        J[2][V] = T * dt / lr;
+        J[2][DELTA] = v * g * dt / lr;
+        J[2][DT] = v * T / lr;
+        J[2][LR] = -v * T * dt / (lr * lr);
+        H[2][V][DELTA] = H[2][DELTA][V] = g * dt / lr;
+        H[2][V][DT] = H[2][DT][V] = T / lr;
+        H[2][V][LR] = H[2][LR][V] = -T * dt / (lr * lr);
+        H[2][DELTA][DELTA] = 2.0 * v * T * g * dt / lr;
+        H[2][DELTA][DT] = H[2][DT][DELTA] = v * g / lr;
+        H[2][DELTA][LR] = H[2][LR][DELTA] = -v * g * dt / (lr * lr);
+        H[2][DT][LR] = H[2][LR][DT] = -v * T / (lr * lr);
+        H[2][LR][LR] = 2.0 * v * T * dt / (lr * lr * lr);
+    }
+
+    // Taylor coefficient k of input i out of tx, which holds q + 1 per input
+    static double coefficient(const CppAD::vector<double> &tx, size_t q, size_t i, size_t k) {
+        return tx[i * (q + 1) + k];
+    }
+
+    bool forward(size_t p, size_t q, const CppAD::vector<bool> &vx, CppAD::vector<bool> &vy,
+                 const CppAD::vector<double> &tx, CppAD::vector<double> &ty) {
+        if (q > 1) {
+            return false;
+        }
+        if (vx.size() > 0) {
+            for (size_t j = 0; j < OUTPUTS; ++j) {
+                vy[j] = false;
+                for (size_t i = 0; i < INPUTS; ++i) {
+                    vy[j] = vy[j] || (depends(j, i) && vx[i]);
+                }
+            }
+        }
+
+        double u[INPUTS], f[OUTPUTS], J[OUTPUTS][INPUTS], H[OUTPUTS][INPUTS][INPUTS];
+        for (size_t i = 0; i < INPUTS; ++i) {
+            u[i] = coefficient(tx, q, i, 0);
+        }
+        derivatives(u, f, J, H);
+        for (size_t j = 0; j < OUTPUTS; ++j) {
+            if (p == 0) {
+                ty[j * (q + 1)] = f[j];
+            }
+            if (q == 1) {
+                double d = 0.0;
+                for (size_t i = 0; i < INPUTS; ++i) {
+                    d += J[j][i] * coefficient(tx, q, i, 1);
+                }
+                ty[j * (q + 1) + 1] = d;
+            }
+        }
+        return true;
+    }
+
+    // Order 0: px = J'py. Order 1: the first coefficients also take the change of J along the direction tx1
+    bool reverse(size_t q, const CppAD::vector<double> &tx, const CppAD::vector<double> &,
+                 CppAD::vector<double> &px, const CppAD::vector<double> &py) {
+        if (q > 1) {
+            return false;
+        }
+        double u[INPUTS], f[OUTPUTS], J[OUTPUTS][INPUTS], H[OUTPUTS][INPUTS][INPUTS];
+        for (size_t i = 0; i < INPUTS; ++i) {
+            u[i] = coefficient(tx, q, i, 0);
+        }
+        derivatives(u, f, J, H);
+        for (size_t i = 0; i < INPUTS; ++i) {
+            double p0 = 0.0, p1 = 0.0;
+            for (size_t j = 0; j < OUTPUTS; ++j) {
+                p0 += py[j * (q + 1)] * J[j][i];
+                if (q == 1) {
+                    double dJ = 0.0;
+                    for (size_t k = 0; k < INPUTS; ++k) {
+                        dJ += H[j][i][k] * coefficient(tx, q, k, 1);
+                    }
+                    p0 += py[j * 2 + 1] * dJ;
+                    p1 += py[j * 2 + 1] * J[j][i];
+                }
+            }
+            px[i * (q + 1)] = p0;
+            if (q == 1) {
+                px[i * 2 + 1] = p1;
+            }
+        }
+        return true;
+    }
+
+    bool for_sparse_jac(size_t, const Sets &r, Sets &s) {
+        for (size_t j = 0; j < OUTPUTS; ++j) {
+            s[j].clear();
+            for (size_t i = 0; i < INPUTS; ++i) {
+                if (depends(j, i)) {
+                    s[j].insert(r[i].begin(), r[i].end());
+                }
+            }
+        }
+        return true;
+    }
+
+    bool rev_sparse_jac(size_t, const Sets &rt, Sets &st) {
+        for (size_t i = 0; i < INPUTS; ++i) {
+            st[i].clear();
+            for (size_t j = 0; j < OUTPUTS; ++j) {
+                if (depends(j, i)) {
+                    st[i].insert(rt[j].begin(), rt[j].end());
+                }
+            }
+        }
+        return true;
+    }
+
+    // t: inputs the selected outputs s depend on. v: the pattern u of the outputs carried back through the
+    // Jacobian, plus the forward pattern r of every input a selected output is curved in together with i
+    bool rev_sparse_hes(const CppAD::vector<bool> &, const CppAD::vector<bool> &s, CppAD::vector<bool> &t, size_t,
+                        const Sets &r, const Sets &u, Sets &v) {
+        for (size_t i = 0; i < INPUTS; ++i) {
+            t[i] = false;
+            v[i].clear();
+            for (size_t j = 0; j < OUTPUTS; ++j) {
+                if (!depends(j, i)) {
+                    continue;
+                }
+                t[i] = t[i] || s[j];
+                v[i].insert(u[j].begin(), u[j].end());
+                if (!s[j]) {
+                    continue;
+                }
+                for (size_t k = 0; k < INPUTS; ++k) {
+                    if (curved(j, i, k)) {
+                        v[i].insert(r[k].begin(), r[k].end());
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
+
+#endif
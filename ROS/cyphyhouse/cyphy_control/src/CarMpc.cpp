@@ -0,0 +1,523 @@
+#include "cyphy_control/CarMpc.h"
+#include "TapedNLP.h"
+#ifndef MPC_CODEGEN
+#include "BicycleStep.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+namespace {
+
+// Barrier parameter of a warm start, close to where the last solve ended
+const double warm_mu_init = 1e-4;
+
+// Constraint violation below which a solution counts as feasible
+const double feasibility_tol = 1e-3;
+
+// CppAD keeps its memory per thread, the main thread is 0 and the others set theirs
+thread_local size_t cppad_thread = 0;
+std::atomic<bool> cppad_parallel(false);
+
+bool in_parallel() {
+    return cppad_parallel.load();
+}
+
+size_t thread_num() {
+    return cppad_thread;
+}
+
+// Moves the len values of the block at start one step earlier, the last one stays
+void shift(TapedNLP::Dvector &v, size_t start, size_t len) {
+    for (size_t t = 0; t + 1 < len; ++t) {
+        v[start + t] = v[start + t + 1];
+    }
+}
+
+// Moves the states at start one step of the first length earlier, interpolated where the steps grow
+void shift_states(TapedNLP::Dvector &v, size_t start, const CarProblem &p) {
+    size_t k = 0;
+    for (size_t t = 0; t < p.N; ++t) {
+        const double at = p.time(t) + p.step(0);
+        while (k + 2 < p.N && p.time(k + 1) <= at) {
+            ++k;
+        }
+        const double f = std::min((at - p.time(k)) / p.step(k), 1.0);
+        v[start + t] = k + 1 < p.N ? (1 - f) * v[start + k] + f * v[start + k + 1] : v[start + k];
+    }
+}
+
+// Moves the controls at start one step earlier: each move takes the control of the step after its first one
+void shift_moves(TapedNLP::Dvector &v, size_t start, const MpcLayout &l) {
+    size_t t = 0;
+    for (size_t m = 0; m < l.n_moves; ++m) {
+        while (l.move[t] != m) {
+            ++t;
+        }
+        v[start + m] = v[start + l.move[std::min(t + 1, l.N - 2)]];
+    }
+}
+
+// Solves that end with an iterate worth starting the next one from
+bool usable(Ipopt::ApplicationReturnStatus status) {
+    return status == Ipopt::Solve_Succeeded || status == Ipopt::Solved_To_Acceptable_Level ||
+           status == Ipopt::Feasible_Point_Found || status == Ipopt::Maximum_Iterations_Exceeded ||
+           status == Ipopt::Maximum_CpuTime_Exceeded;
+}
+
+size_t parameters(const CarMpc::Terms &terms, size_t N) {
+    size_t n = 0;
+    for (const auto &term : terms) {
+        n += term->parameters(N);
+    }
+    return n;
+}
+
+size_t constraints(const CarMpc::Terms &terms, size_t N) {
+    size_t n = 0;
+    for (const auto &term : terms) {
+        n += term->constraints(N);
+    }
+    return n;
+}
+
+// The move blocks of the problem up to the first 0
+std::vector<size_t> blocks(const CarProblem &problem) {
+    std::vector<size_t> b;
+    for (size_t i = 0; i < CarProblem::MAX_BLOCKS && problem.move_blocks[i] > 0; ++i) {
+        b.push_back(problem.move_blocks[i]);
+    }
+    return b;
+}
+
+#ifndef MPC_CODEGEN
+// The atomic step of every tape, constructed before parallel_setup can be called
+BicycleStep bicycle_step;
+
+// The state after one step of the model from u, one atomic operation on the tape
+void predict(const CppAD::AD<double> (&u)[BicycleStep::INPUTS], CppAD::AD<double> (&next)[BicycleStep::OUTPUTS]) {
+    CppAD::vector<CppAD::AD<double> > ax(BicycleStep::INPUTS), ay(BicycleStep::OUTPUTS);
+    for (size_t i = 0; i < BicycleStep::INPUTS; ++i) {
+        ax[i] = u[i];
+    }
+    bicycle_step.step(ax, ay);
+    for (size_t j = 0; j < BicycleStep::OUTPUTS; ++j) {
+        next[j] = ay[j];
+    }
+}
+#endif
+
+// The same step written out, for CppADCodeGen whose generated code is straight-line anyway
+template <class ADdouble>
+void predict(const ADdouble (&u)[7], ADdouble (&next)[3]) {
+    next[0] = u[0] + u[3] * CppAD::cos(u[2]) * u[5];
+    next[1] = u[1] + u[3] * CppAD::sin(u[2]) * u[5];
+    next[2] = u[2] + u[3] * CppAD::tan(u[4]) * u[5] / u[6];
+}
+
+// Objective and constraints of the problem: the terms, the model and the constraints of the terms
+class FG_eval : public MpcLayout {
+public:
+    FG_eval(const CarProblem &problem, const CarMpc::Terms &terms)
+        : MpcLayout(problem.N, parameters(terms, problem.N), constraints(terms, problem.N), blocks(problem)), p(problem),
+          terms(terms) {}
+    // A template on the vector type so that MPC_CODEGEN can tape it on CppAD::cg::CG<double>
+    template <class ADvector>
+    void operator()(ADvector& fg, const ADvector& vars) {
+        typedef typename ADvector::value_type ADdouble;
+        //Initialize cost at 0, each term adds its part
+        fg[0] = 0;
+        size_t param = param_start;
+        for (const auto &term : terms) {
+            term->add(fg[0], vars, *this, param);
+            param += term->parameters(N);
+        }
+
+        //Set the constraints at time t=0
+        fg[1 + x_start] = vars[x_start];
+        fg[1 + y_start] = vars[y_start];
+        fg[1 + psi_start] = vars[psi_start];
+
+        for (unsigned int t = 1; t < N; ++t) {
+            //State at time t+1
+            ADdouble x1 = vars[x_start + t];
+            ADdouble y1 = vars[y_start + t];
+            ADdouble psi1 = vars[psi_start + t];
+
+            //State at time t
+            ADdouble x0 = vars[x_start + t - 1];
+            ADdouble y0 = vars[y_start + t - 1];
+            ADdouble psi0 = vars[psi_start + t - 1];
+
+            //Actuations at time, t
+            ADdouble delta0 = vars[delta(t - 1)];
+            ADdouble v0 = vars[v(t - 1)];
+
+            //Set up the SS model constraints for time steps [1,N]
+            const ADdouble u[] = {x0, y0, psi0, v0, delta0, ADdouble(p.step(t - 1)), ADdouble(p.lr)};
+            ADdouble next[3];
+            predict(u, next);
+            fg[1 + x_start + t] = x1 - next[0];
+            fg[1 + y_start + t] = y1 - next[1];
+            fg[1 + psi_start + t] = psi1 - next[2];
+        }
+
+        //Constraints of the terms, in their order after the model
+        size_t row = 1 + term_start;
+        param = param_start;
+        for (const auto &term : terms) {
+            term->constrain(&fg[row], vars, *this, param);
+            row += term->constraints(N);
+            param += term->parameters(N);
+        }
+    }
+
+private:
+    const CarProblem p;
+    const CarMpc::Terms &terms;
+};
+
+// The generated code has the whole problem built in, one library per distinct problem and terms
+std::string codegen_name(const std::string &name, const CarProblem &problem, const CarMpc::Terms &terms) {
+    // CarProblem is plain numbers, its bytes identify it
+    std::string bytes(reinterpret_cast<const char *>(&problem), sizeof(problem));
+    for (const auto &term : terms) {
+        bytes += '\n' + term->key();
+    }
+    std::ostringstream id;
+    id << name << "_" << std::hex << std::hash<std::string>()(bytes);
+    return id.str();
+}
+
+}
+
+struct CarMpc::Solver {
+    Solver(const CarProblem &problem, const Terms &terms, const std::string &name)
+        : layout(problem.N, parameters(terms, problem.N), constraints(terms, problem.N), blocks(problem)) {
+        // Object that computes objective and constraints
+        FG_eval fg_eval(problem, terms);
+        nlp = new TapedNLP(fg_eval, layout.n_vars, layout.n_constraints, codegen_name(name, problem, terms));
+
+        // options for IPOPT solver
+        app = IpoptApplicationFactory();
+        // Raise this if you'd like more print information
+        app->Options()->SetIntegerValue("print_level", 0);
+        app->Options()->SetStringValue("sb", "yes");
+        // NOTE: Currently the solver has a maximum time limit of 0.099 seconds.
+        // Change this as you see fit.
+        app->Options()->SetNumericValue("max_cpu_time", 0.099);
+        // Keep warm started multipliers and iterates where they are
+        app->Options()->SetNumericValue("warm_start_bound_push", 1e-6);
+        app->Options()->SetNumericValue("warm_start_mult_bound_push", 1e-6);
+        app->Initialize();
+
+        bounds(problem);
+    }
+
+    // The bounds that hold for every solve, each solve sets those of the initial state and the parameters
+    void bounds(const CarProblem &problem) {
+        const MpcLayout &l = layout;
+        TapedNLP::Dvector &vars_lowerbound = nlp->xl;
+        TapedNLP::Dvector &vars_upperbound = nlp->xu;
+
+        //Define positive and negative infinities
+        for (unsigned int i = 0; i < l.v_start; ++i) {
+            vars_lowerbound[i] = -1.0e19;
+            vars_upperbound[i] = 1.0e19;
+        }
+
+        //X and Y bounds
+        for (unsigned int i = l.x_start; i < l.y_start; ++i) {
+            vars_lowerbound[i] = -problem.x_bound;
+            vars_upperbound[i] = problem.x_bound;
+        }
+
+        for (unsigned int i = l.y_start; i < l.psi_start; ++i) {
+            vars_lowerbound[i] = -problem.y_bound;
+            vars_upperbound[i] = problem.y_bound;
+        }
+
+        // Velocity upper and lower limits [m/s]
+        for (unsigned int i = l.v_start; i < l.delta_start; ++i) {
+            vars_lowerbound[i] = -problem.vel_bound;
+            vars_upperbound[i] = problem.vel_bound;
+        }
+
+        // Steering angle upper and lower limits [rad]
+        for (unsigned int i = l.delta_start; i < l.param_start; ++i) {
+            vars_lowerbound[i] = -problem.dir_bound;
+            vars_upperbound[i] = problem.dir_bound;
+        }
+
+        // Lower and upper bounds for hard constraints (0 except for initial states), those of the terms only from
+        // below
+        for (unsigned int i = 0; i < l.n_constraints; ++i) {
+            nlp->gl[i] = 0.0;
+            nlp->gu[i] = i < l.term_start ? 0.0 : 1.0e19;
+        }
+    }
+
+    // Ipopt options of a warm or a cold start, set only when they change as every set formats and stores a string
+    void start_options(bool warm) {
+        if (warm_options == static_cast<int>(warm)) {
+            return;
+        }
+        app->Options()->SetStringValue("warm_start_init_point", warm ? "yes" : "no");
+        app->Options()->SetNumericValue("mu_init", warm ? warm_mu_init : 0.1);
+        warm_options = warm;
+    }
+
+    const MpcLayout layout;
+    Ipopt::SmartPtr<TapedNLP> nlp;
+    Ipopt::SmartPtr<Ipopt::IpoptApplication> app;
+    SparseQP qp;
+    // Cold start guess, kept for its storage
+    Guess guess;
+    // Last plan an anytime solve drove and the shifts it has left
+    TapedNLP::Dvector plan;
+    size_t plan_left = 0;
+    // Whether the options are those of a warm start, -1 before the first solve
+    int warm_options = -1;
+};
+
+const size_t CarProblem::MAX_BLOCKS;
+
+//
+// MPC class definition implementation.
+//
+CarMpc::CarMpc(const CarProblem &problem, const Terms &terms, const std::string &name)
+    : warm_start(true), warm_start_max_error(0.5), rti(false), anytime(false), deadline(0.0), stats(nullptr), problem(problem), terms(terms),
+      solver(new Solver(problem, terms, name)), trajectory(false), last_infeasibility(0.0) {}
+
+CarMpc::~CarMpc() = default;
+
+double CarMpc::timestep() const {
+    return problem.dt;
+}
+
+double CarMpc::time(size_t k) const {
+    return problem.time(k);
+}
+
+double CarMpc::cost() const {
+    return solver->nlp->obj_value;
+}
+
+double CarMpc::infeasibility() const {
+    return last_infeasibility;
+}
+
+bool CarMpc::feasible() const {
+    return trajectory && last_infeasibility < feasibility_tol;
+}
+
+const SolveSample &CarMpc::last_solve() const {
+    return last_sample;
+}
+
+void CarMpc::adopt(const CarMpc &other) {
+    TapedNLP &nlp = *solver->nlp;
+    const TapedNLP &from = *other.solver->nlp;
+    nlp.x = from.x;
+    nlp.z_l = from.z_l;
+    nlp.z_u = from.z_u;
+    nlp.lambda = from.lambda;
+    trajectory = other.trajectory;
+}
+
+void CarMpc::SetOption(const std::string &name, const std::string &value) {
+    solver->app->Options()->SetStringValue(name, value);
+}
+
+void CarMpc::parallel_setup(size_t threads) {
+    CppAD::thread_alloc::parallel_setup(threads, in_parallel, thread_num);
+    CppAD::thread_alloc::hold_memory(true);
+    CppAD::parallel_ad<double>();
+}
+
+void CarMpc::parallel_begin() {
+    cppad_parallel = true;
+}
+
+void CarMpc::set_thread(size_t index) {
+    cppad_thread = index;
+}
+
+void CarMpc::parallel_end() {
+    cppad_parallel = false;
+}
+
+bool CarMpc::cold_guess(double, double, double, const double *, Guess &) const {
+    return false;
+}
+
+bool CarMpc::predicted(size_t t, double &x, double &y) const {
+    if (!feasible() || t >= problem.N) {
+        return false;
+    }
+    x = solver->nlp->x[solver->layout.x_start + t];
+    y = solver->nlp->x[solver->layout.y_start + t];
+    return true;
+}
+
+std::vector<double> CarMpc::Solve(double x, double y, double psi, const std::vector<double> &params) {
+    Solve(x, y, psi, params.data(), params.size(), last);
+    return {last.delta, last.v};
+}
+
+void CarMpc::Solve(double x, double y, double psi, const double *params, size_t n_params, Solution &solution) {
+    const auto tic = std::chrono::steady_clock::now();
+    const MpcLayout &l = solver->layout;
+    TapedNLP &nlp = *solver->nlp;
+    typedef TapedNLP::Dvector Dvector;
+
+    Dvector &vars = nlp.x0;
+    const bool warm = warm_start && trajectory &&
+                      std::hypot(x - nlp.x[l.x_start + 1], y - nlp.x[l.y_start + 1]) < warm_start_max_error;
+    if (warm) {
+        // Last trajectory and multipliers one step on, states and their model constraints alike
+        vars = nlp.x;
+        nlp.z_l0 = nlp.z_l;
+        nlp.z_u0 = nlp.z_u;
+        nlp.lambda0 = nlp.lambda;
+        for (size_t start : {l.x_start, l.y_start, l.psi_start}) {
+            shift_states(vars, start, problem);
+            shift(nlp.z_l0, start, l.N);
+            shift(nlp.z_u0, start, l.N);
+            shift(nlp.lambda0, start, l.N);
+        }
+        for (size_t start : {l.v_start, l.delta_start}) {
+            shift_moves(vars, start, l);
+            shift_moves(nlp.z_l0, start, l);
+            shift_moves(nlp.z_u0, start, l);
+        }
+    } else {
+        // Initialize model variables to zero, or to the guess of the subclass
+        for (unsigned int i = 0; i < l.n_vars; ++i) {
+            vars[i] = 0;
+        }
+        Guess &guess = solver->guess;
+        for (std::vector<double> *v : {&guess.x, &guess.y, &guess.psi, &guess.v, &guess.delta}) {
+            v->clear();
+        }
+        if (cold_guess(x, y, psi, params, guess)) {
+            std::copy(guess.x.begin(), guess.x.begin() + std::min(guess.x.size(), l.N), vars.begin() + l.x_start);
+            std::copy(guess.y.begin(), guess.y.begin() + std::min(guess.y.size(), l.N), vars.begin() + l.y_start);
+            std::copy(guess.psi.begin(), guess.psi.begin() + std::min(guess.psi.size(), l.N),
+                      vars.begin() + l.psi_start);
+            // A move starts from the guess of its first step, written last
+            for (size_t t = std::min(guess.v.size(), l.N - 1); t-- > 0;) {
+                vars[l.v(t)] = guess.v[t];
+            }
+            for (size_t t = std::min(guess.delta.size(), l.N - 1); t-- > 0;) {
+                vars[l.delta(t)] = guess.delta[t];
+            }
+        }
+    }
+    solver->start_options(warm);
+
+    //Set the initial state
+    vars[l.x_start] = x;
+    vars[l.y_start] = y;
+    vars[l.psi_start] = psi;
+
+    // Parameters of the terms fixed by equal bounds, the other bounds are set once by the Solver
+    for (unsigned int i = 0; i < l.n_params; ++i) {
+        const size_t k = l.param_start + i;
+        vars[k] = nlp.xl[k] = nlp.xu[k] = i < n_params ? params[i] : 0.0;
+    }
+
+    //Initial states constrained to last measured value
+    Dvector &constraints_lowerbound = nlp.gl;
+    Dvector &constraints_upperbound = nlp.gu;
+    constraints_lowerbound[l.x_start] = x;
+    constraints_lowerbound[l.y_start] = y;
+    constraints_lowerbound[l.psi_start] = psi;
+
+    constraints_upperbound[l.x_start] = x;
+    constraints_upperbound[l.y_start] = y;
+    constraints_upperbound[l.psi_start] = psi;
+
+    // solve the problem, a failed solve leaves nlp.x at the starting point
+    nlp.x = vars;
+    nlp.deadline = anytime ? deadline : 0.0;
+    nlp.track_best = anytime;
+    nlp.best_tol = feasibility_tol;
+    nlp.best_valid = false;
+    Ipopt::ApplicationReturnStatus status;
+    if (rti && warm) {
+        // Real-time iteration around the shifted trajectory, its bound on QP iterations bounds the latency
+        status = nlp.sqp_step(solver->qp) ? Ipopt::Solve_Succeeded : Ipopt::Maximum_Iterations_Exceeded;
+    } else {
+        status = solver->app->OptimizeTNLP(solver->nlp);
+    }
+    nlp.track_best = false;
+    trajectory = usable(status);
+
+    // An anytime solve that did not converge falls back on its best feasible point, then on the last plan
+    Source source = SOLVED;
+    if (anytime && status != Ipopt::Solve_Succeeded && status != Ipopt::Solved_To_Acceptable_Level) {
+        if (nlp.best_valid) {
+            nlp.x = nlp.best_x;
+            nlp.obj_value = nlp.best_obj;
+            source = BEST_ITERATE;
+        } else if (solver->plan_left > 0) {
+            Dvector &plan = solver->plan;
+            for (size_t start : {l.x_start, l.y_start, l.psi_start}) {
+                shift_states(plan, start, problem);
+            }
+            for (size_t start : {l.v_start, l.delta_start}) {
+                shift_moves(plan, start, l);
+            }
+            --solver->plan_left;
+            nlp.x = plan;
+            std::copy(vars.begin() + l.param_start, vars.begin() + l.param_start + l.n_params,
+                      nlp.x.begin() + l.param_start);
+            source = SHIFTED;
+        } else {
+            // Standing still where the car is, which the model allows
+            for (size_t t = 0; t < l.N; ++t) {
+                nlp.x[l.x_start + t] = x;
+                nlp.x[l.y_start + t] = y;
+                nlp.x[l.psi_start + t] = psi;
+            }
+            std::fill(nlp.x.begin() + l.v_start, nlp.x.begin() + l.param_start, 0.0);
+            source = STOPPED;
+        }
+        trajectory = source != STOPPED;
+    }
+    if (anytime && source != SHIFTED && source != STOPPED) {
+        solver->plan = nlp.x;
+        solver->plan_left = l.N > 2 ? l.N - 2 : 0;
+    }
+    last_infeasibility = nlp.infeasibility();
+    last_sample.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - tic).count();
+    last_sample.iterations = nlp.iterations;
+    last_sample.status = status;
+    last_sample.cost = nlp.obj_value;
+    last_sample.violation = last_infeasibility;
+    last_sample.source = source;
+    if (stats) {
+        stats->record(last_sample);
+    }
+
+    const Dvector &solution_x = nlp.x;
+    solution.source = source;
+    solution.delta = solution_x[l.delta_start];
+    solution.v = solution_x[l.v_start];
+
+    //the predicted x,y values and controls, in place
+    solution.x_vals.resize(l.N - 1);
+    solution.y_vals.resize(l.N - 1);
+    solution.delta_vals.resize(l.N - 1);
+    solution.v_vals.resize(l.N - 1);
+    for (unsigned int i = 0; i < l.N - 1; ++i) {
+        solution.x_vals[i] = solution_x[l.x_start + i + 1];
+        solution.y_vals[i] = solution_x[l.y_start + i + 1];
+        solution.delta_vals[i] = solution_x[l.delta(i)];
+        solution.v_vals[i] = solution_x[l.v(i)];
+    }
+}
@@ -0,0 +1,235 @@
+#include "cyphy_control/CostTerms.h"
+#include "cyphy_control/DistanceField.h"
+#ifdef MPC_CODEGEN
+#include <cppad/cg.hpp>
+#else
+#include <cppad/cppad.hpp>
+#endif
+#include <initializer_list>
+#include <sstream>
+
+// Weights as text, for the keys
+static std::string weights(const char *kind, std::initializer_list<double> values) {
+    std::ostringstream key;
+    key.precision(17);
+    key << kind;
+    for (double v : values) {
+        key << ' ' << v;
+    }
+    return key.str();
+}
+
+// Both vector types share the one template, MPC_CODEGEN records the terms on CG<double> as well
+#ifdef MPC_CODEGEN
+#define COST_TERM_ADD(Term, ...)                                                                        \
+    void Term::add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const {      \
+        (void) param;                                                                                   \
+        eval(cost, vars, __VA_ARGS__);                                                                  \
+    }                                                                                                   \
+    void Term::add(CGdouble &cost, const CGvector &vars, const MpcLayout &l, size_t param) const {      \
+        (void) param;                                                                                   \
+        eval(cost, vars, __VA_ARGS__);                                                                  \
+    }
+#else
+#define COST_TERM_ADD(Term, ...)                                                                        \
+    void Term::add(ADdouble &cost, const ADvector &vars, const MpcLayout &l, size_t param) const {      \
+        (void) param;                                                                                   \
+        eval(cost, vars, __VA_ARGS__);                                                                  \
+    }
+#endif
+
+// Terms that only constrain, no cost, and their constraints from the same template
+#ifdef MPC_CODEGEN
+#define CONSTRAINT_TERM(Term)                                                                           \
+    void Term::add(ADdouble &, const ADvector &, const MpcLayout &, size_t) const {}                    \
+    void Term::add(CGdouble &, const CGvector &, const MpcLayout &, size_t) const {}                    \
+    void Term::constrain(ADdouble *g, const ADvector &vars, const MpcLayout &l, size_t param) const {   \
+        eval(g, vars, l, param);                                                                        \
+    }                                                                                                   \
+    void Term::constrain(CGdouble *g, const CGvector &vars, const MpcLayout &l, size_t param) const {   \
+        eval(g, vars, l, param);                                                                        \
+    }
+#else
+#define CONSTRAINT_TERM(Term)                                                                           \
+    void Term::add(ADdouble &, const ADvector &, const MpcLayout &, size_t) const {}                    \
+    void Term::constrain(ADdouble *g, const ADvector &vars, const MpcLayout &l, size_t param) const {   \
+        eval(g, vars, l, param);                                                                        \
+    }
+#endif
+
+InputCost::InputCost(double delta_weight, double delta_rate_weight, double v_weight, double v_rate_weight)
+    : delta_weight(delta_weight), delta_rate_weight(delta_rate_weight), v_weight(v_weight),
+      v_rate_weight(v_rate_weight) {}
+
+template <class Vector>
+void InputCost::eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l) const {
+    //Minimize inputs
+    for (size_t t = 0; t < l.N - 1; ++t) {
+        cost += delta_weight * CppAD::pow(vars[l.delta(t)], 2);
+        cost += v_weight * CppAD::pow(vars[l.v(t)], 2);
+    }
+
+    //Minimize input derivatives
+    for (size_t t = 0; t + 2 < l.N; ++t) {
+        cost += delta_rate_weight * CppAD::pow(vars[l.delta(t + 1)] - vars[l.delta(t)], 2);
+        cost += v_rate_weight * CppAD::pow(vars[l.v(t + 1)] - vars[l.v(t)], 2);
+    }
+}
+
+COST_TERM_ADD(InputCost, l)
+
+std::string InputCost::key() const {
+    return weights("input", {delta_weight, delta_rate_weight, v_weight, v_rate_weight});
+}
+
+WaypointCost::WaypointCost(double x_weight, double y_weight) : x_weight(x_weight), y_weight(y_weight) {}
+
+size_t WaypointCost::parameters(size_t) const {
+    return 2;
+}
+
+template <class Vector>
+void WaypointCost::eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l,
+                        size_t param) const {
+    for (size_t t = 0; t < l.N; ++t) {
+        //Penalize x-distance from waypoint
+        cost += x_weight * CppAD::pow(vars[l.x_start + t] - vars[param], 2);
+        //Penalize y-distance from waypoint
+        cost += y_weight * CppAD::pow(vars[l.y_start + t] - vars[param + 1], 2);
+    }
+}
+
+COST_TERM_ADD(WaypointCost, l, param)
+
+std::string WaypointCost::key() const {
+    return weights("waypoint", {x_weight, y_weight});
+}
+
+ReferenceCost::ReferenceCost(double x_weight, double y_weight) : x_weight(x_weight), y_weight(y_weight) {}
+
+size_t ReferenceCost::parameters(size_t N) const {
+    return 2 * N;
+}
+
+template <class Vector>
+void ReferenceCost::eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l,
+                         size_t param) const {
+    for (size_t t = 0; t < l.N; ++t) {
+        //Penalize distance from the reference of step t, the far end most
+        cost += x_weight * (t + 1) * CppAD::pow(vars[l.x_start + t] - vars[param + t], 2);
+        cost += y_weight * (t + 1) * CppAD::pow(vars[l.y_start + t] - vars[param + l.N + t], 2);
+    }
+}
+
+COST_TERM_ADD(ReferenceCost, l, param)
+
+std::string ReferenceCost::key() const {
+    return weights("reference", {x_weight, y_weight});
+}
+
+CrossTrackCost::CrossTrackCost(double cte_weight, double epsi_weight, double dt, double lr, double dt_growth)
+    : cte_weight(cte_weight), epsi_weight(epsi_weight), dt(dt), lr(lr), dt_growth(dt_growth) {}
+
+size_t CrossTrackCost::parameters(size_t) const {
+    return 6;
+}
+
+template <class Vector>
+void CrossTrackCost::eval(typename Vector::value_type &cost, const Vector &vars, const MpcLayout &l,
+                          size_t param) const {
+    typedef typename Vector::value_type ADdouble;
+    const ADdouble coeffs[4] = {vars[param], vars[param + 1], vars[param + 2], vars[param + 3]};
+    ADdouble cte = vars[param + 4];
+    ADdouble epsi = vars[param + 5];
+    double step = dt;
+    for (size_t t = 0; t < l.N; ++t, step *= dt_growth) {
+        //Penalize cross track error and error in heading
+        cost += cte_weight * CppAD::pow(cte, 2);
+        cost += epsi_weight * CppAD::pow(epsi, 2);
+        if (t + 1 == l.N) {
+            break;
+        }
+
+        //Errors at time t + 1 from the state and actuations at time t
+        const ADdouble x0 = vars[l.x_start + t];
+        const ADdouble x0_2 = x0 * x0;
+        const ADdouble x0_3 = x0_2 * x0;
+        const ADdouble v0 = vars[l.v(t)];
+        const ADdouble delta0 = vars[l.delta(t)];
+        const ADdouble f0 = coeffs[0] + coeffs[1] * x0 + coeffs[2] * x0_2 + coeffs[3] * x0_3;
+        const ADdouble psides0 = CppAD::atan(coeffs[1] + 2 * coeffs[2] * x0 + 3 * coeffs[3] * x0_2);
+        const ADdouble cte1 = (f0 - vars[l.y_start + t]) + v0 * CppAD::sin(epsi) * step;
+        const ADdouble epsi1 = (vars[l.psi_start + t] - psides0) + v0 * delta0 / lr * step;
+        cte = cte1;
+        epsi = epsi1;
+    }
+}
+
+COST_TERM_ADD(CrossTrackCost, l, param)
+
+std::string CrossTrackCost::key() const {
+    return weights("cross_track", {cte_weight, epsi_weight, dt, lr, dt_growth});
+}
+
+ObstacleConstraint::ObstacleConstraint(double margin) : margin(margin) {}
+
+size_t ObstacleConstraint::parameters(size_t N) const {
+    return 1 + DistanceField::PATCH * (N - 1);
+}
+
+size_t ObstacleConstraint::constraints(size_t N) const {
+    return N - 1;
+}
+
+template <class Vector>
+void ObstacleConstraint::eval(typename Vector::value_type *g, const Vector &vars, const MpcLayout &l,
+                              size_t param) const {
+    typedef typename Vector::value_type ADdouble;
+    const ADdouble &resolution = vars[param];
+    for (size_t t = 1; t < l.N; ++t) {
+        //Bilinear in the patch of step t, its corner values weighted by where the step lies in it
+        const size_t p = param + 1 + DistanceField::PATCH * (t - 1);
+        const ADdouble u = (vars[l.x_start + t] - vars[p]) / resolution;
+        const ADdouble w = (vars[l.y_start + t] - vars[p + 1]) / resolution;
+        const ADdouble d = (1 - u) * (1 - w) * vars[p + 2] + u * (1 - w) * vars[p + 3] + (1 - u) * w * vars[p + 4] +
+                           u * w * vars[p + 5];
+        g[t - 1] = d - margin;
+    }
+}
+
+CONSTRAINT_TERM(ObstacleConstraint)
+
+std::string ObstacleConstraint::key() const {
+    return weights("obstacle", {margin});
+}
+
+RobotConstraint::RobotConstraint(size_t robots, double distance) : robots(robots), distance(distance) {}
+
+size_t RobotConstraint::parameters(size_t N) const {
+    return 2 * robots * (N - 1);
+}
+
+size_t RobotConstraint::constraints(size_t N) const {
+    return robots * (N - 1);
+}
+
+template <class Vector>
+void RobotConstraint::eval(typename Vector::value_type *g, const Vector &vars, const MpcLayout &l,
+                           size_t param) const {
+    const size_t steps = l.N - 1;
+    for (size_t k = 0; k < robots; ++k) {
+        const size_t p = param + 2 * steps * k;
+        for (size_t t = 1; t < l.N; ++t) {
+            //Squared distance to robot k at step t at least distance squared
+            g[steps * k + t - 1] = CppAD::pow(vars[l.x_start + t] - vars[p + t - 1], 2) +
+                                   CppAD::pow(vars[l.y_start + t] - vars[p + steps + t - 1], 2) -
+                                   distance * distance;
+        }
+    }
+}
+
+CONSTRAINT_TERM(RobotConstraint)
+
+std::string RobotConstraint::key() const {
+    return weights("robots", {static_cast<double>(robots), distance});
+}
@@ -0,0 +1,139 @@
+#include "cyphy_control/DistanceField.h"
+#include <algorithm>
+#include <cmath>
+
+// Squared distance [cells^2] standing in for no site at all, beyond any in a grid
+static const double FAR = 1e12;
+
+/*
+ * Lower envelope of the parabolas (q - p)^2 + f[p] over the n values of f,
+ * stride apart, into d: the squared distance of every q to the nearest site,
+ * f holding 0 at the sites and FAR elsewhere on the first pass.
+ */
+static void transform(const double *f, double *d, size_t n, size_t stride, std::vector<size_t> &v,
+                      std::vector<double> &z) {
+    v.resize(n);
+    z.resize(n + 1);
+    size_t k = 0;
+    v[0] = 0;
+    z[0] = -INFINITY;
+    z[1] = INFINITY;
+    for (size_t q = 1; q < n; ++q) {
+        // Where the parabola of q overtakes the last one of the envelope, those it hides drop out
+        double s;
+        while (true) {
+            const double p = static_cast<double>(v[k]);
+            s = ((f[q * stride] + double(q) * q) - (f[v[k] * stride] + p * p)) / (2.0 * q - 2.0 * p);
+            if (s > z[k]) {
+                break;
+            }
+            --k;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INFINITY;
+    }
+    k = 0;
+    for (size_t q = 0; q < n; ++q) {
+        while (z[k + 1] < q) {
+            ++k;
+        }
+        const double p = static_cast<double>(v[k]);
+        d[q * stride] = (q - p) * (q - p) + f[v[k] * stride];
+    }
+}
+
+// Squared distance of every cell of the w x h grid to the nearest one where site[c], columns then rows
+static std::vector<double> squared_distance(const std::vector<uint8_t> &site, size_t w, size_t h) {
+    std::vector<double> f(w * h), d(w * h);
+    for (size_t c = 0; c < f.size(); ++c) {
+        f[c] = site[c] ? 0.0 : FAR;
+    }
+    std::vector<size_t> v;
+    std::vector<double> z;
+    for (size_t i = 0; i < w; ++i) {
+        transform(&f[i], &d[i], h, w, v, z);
+    }
+    for (size_t j = 0; j < h; ++j) {
+        transform(&d[j * w], &f[j * w], w, 1, v, z);
+    }
+    return f;
+}
+
+DistanceField::DistanceField() : origin_x(0), origin_y(0), cell(1.0), width(0), height(0) {}
+
+DistanceField::DistanceField(double origin_x, double origin_y, double resolution, size_t width, size_t height,
+                             const std::vector<uint8_t> &occupied)
+    : origin_x(origin_x), origin_y(origin_y), cell(resolution > 0 ? resolution : 1.0), width(width),
+      height(height) {
+    if (width == 0 || height == 0 || occupied.size() < width * height) {
+        this->width = this->height = 0;
+        return;
+    }
+
+    // A ring of occupied cells around the grid stands for the outside
+    const size_t w = width + 2, h = height + 2;
+    std::vector<uint8_t> blocked(w * h, 1), open(w * h, 0);
+    for (size_t j = 0; j < height; ++j) {
+        for (size_t i = 0; i < width; ++i) {
+            const size_t c = (j + 1) * w + i + 1;
+            blocked[c] = occupied[j * width + i] ? 1 : 0;
+            open[c] = !blocked[c];
+        }
+    }
+    const std::vector<double> to_blocked = squared_distance(blocked, w, h);
+    const std::vector<double> to_free = squared_distance(open, w, h);
+
+    // Centre to centre distances less half a cell, so the field changes sign on the cell edges
+    values.resize(width * height);
+    for (size_t j = 0; j < height; ++j) {
+        for (size_t i = 0; i < width; ++i) {
+            const size_t c = (j + 1) * w + i + 1;
+            const double d = blocked[c] ? -std::sqrt(std::min(to_free[c], FAR)) : std::sqrt(to_blocked[c]);
+            values[j * width + i] = static_cast<float>((d - std::copysign(0.5, d)) * cell);
+        }
+    }
+}
+
+void DistanceField::corner(double x, double y, size_t &i, size_t &j, double &u, double &w) const {
+    const double gx = (x - origin_x) / cell - 0.5, gy = (y - origin_y) / cell - 0.5;
+    const double max_i = width > 1 ? width - 2 : 0, max_j = height > 1 ? height - 2 : 0;
+    const double fi = std::min(std::max(std::floor(gx), 0.0), max_i);
+    const double fj = std::min(std::max(std::floor(gy), 0.0), max_j);
+    i = static_cast<size_t>(fi);
+    j = static_cast<size_t>(fj);
+    u = std::min(std::max(gx - fi, 0.0), 1.0);
+    w = std::min(std::max(gy - fj, 0.0), 1.0);
+}
+
+double DistanceField::value(double x, double y) const {
+    if (empty()) {
+        return INFINITY;
+    }
+    size_t i, j;
+    double u, w;
+    corner(x, y, i, j, u, w);
+    const size_t i1 = std::min(i + 1, width - 1), j1 = std::min(j + 1, height - 1);
+    return (1 - u) * (1 - w) * at(i, j) + u * (1 - w) * at(i1, j) + (1 - u) * w * at(i, j1) + u * w * at(i1, j1);
+}
+
+void DistanceField::patch(double x, double y, double *patch) const {
+    if (empty()) {
+        // Flat and far from anything
+        patch[0] = x;
+        patch[1] = y;
+        std::fill(patch + 2, patch + PATCH, 1e3);
+        return;
+    }
+    size_t i, j;
+    double u, w;
+    corner(x, y, i, j, u, w);
+    const size_t i1 = std::min(i + 1, width - 1), j1 = std::min(j + 1, height - 1);
+    patch[0] = origin_x + (i + 0.5) * cell;
+    patch[1] = origin_y + (j + 0.5) * cell;
+    patch[2] = at(i, j);
+    patch[3] = at(i1, j);
+    patch[4] = at(i, j1);
+    patch[5] = at(i1, j1);
+}
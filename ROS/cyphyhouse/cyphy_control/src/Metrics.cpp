@@ -0,0 +1,311 @@
+#include "cyphy_control/Metrics.h"
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ACCEPT_POLL_MS 200      // Between two checks of running
+#define REQUEST_TIMEOUT_MS 500  // A client that sends no request in time is dropped
+#define REQUEST_MAX_SIZE 2048
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+MetricHistogram::MetricHistogram(double unit) : unit(unit), samples(0), total(0) {
+    for (int i = 0; i < METRICS_BUCKETS; ++i) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int MetricHistogram::bucketOf(uint64_t units) {
+    const uint64_t sub = 1u << METRICS_SUB_BITS;
+    units = std::min<uint64_t>(units, (1ull << METRICS_OCTAVES) - 1);
+    if (units < sub) {
+        return static_cast<int>(units);
+    }
+    // Octave of the value past the exact range, then its top METRICS_SUB_BITS + 1 bits
+    const int octave = (63 - __builtin_clzll(units)) - METRICS_SUB_BITS;
+    return static_cast<int>((octave << METRICS_SUB_BITS) + (units >> octave));
+}
+
+uint64_t MetricHistogram::bucketLimit(int bucket) {
+    const int sub = 1 << METRICS_SUB_BITS;
+    if (bucket < sub) {
+        return bucket;
+    }
+    const int octave = bucket / sub - 1;
+    const uint64_t mantissa = bucket % sub + sub;
+    return ((mantissa + 1) << octave) - 1;
+}
+
+void MetricHistogram::record(double value) {
+    const double units = value / unit;
+    const uint64_t u = units > 0 ? static_cast<uint64_t>(std::min(units + 0.5, 1.8e19)) : 0;
+    buckets[bucketOf(u)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(u, std::memory_order_relaxed);
+    samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+double MetricHistogram::quantile(double q) const {
+    // The buckets may move on while they are summed, the quantile is of a slightly newer set then
+    uint64_t counts[METRICS_BUCKETS];
+    uint64_t n = 0;
+    for (int i = 0; i < METRICS_BUCKETS; ++i) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        n += counts[i];
+    }
+    if (n == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * n)));
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return bucketLimit(i) * unit;
+        }
+    }
+    return bucketLimit(METRICS_BUCKETS - 1) * unit;
+}
+
+MetricsRegistry &MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Metric &MetricsRegistry::find(Type type, const std::string &name, const std::string &help,
+                                               const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &m : metrics) {
+        if (m->name == name && m->labels == labels && m->type == type) {
+            return *m;
+        }
+    }
+    std::unique_ptr<Metric> m(new Metric());
+    m->type = type;
+    m->name = name;
+    m->help = help;
+    m->labels = labels;
+    metrics.push_back(std::move(m));
+    return *metrics.back();
+}
+
+MetricCounter &MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels) {
+    Metric &m = find(COUNTER, name, help, labels);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!m.counter) {
+        m.counter.reset(new MetricCounter());
+    }
+    return *m.counter;
+}
+
+MetricGauge &MetricsRegistry::gauge(const std::string &name, const std::string &help, const std::string &labels) {
+    Metric &m = find(GAUGE, name, help, labels);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!m.gauge) {
+        m.gauge.reset(new MetricGauge());
+    }
+    return *m.gauge;
+}
+
+MetricHistogram &MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                            const std::string &labels, double unit) {
+    Metric &m = find(HISTOGRAM, name, help, labels);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!m.histogram) {
+        m.histogram.reset(new MetricHistogram(unit));
+    }
+    return *m.histogram;
+}
+
+// name{labels,extra} value, the braces left out without any label
+static void appendSample(std::string &out, const std::string &name, const std::string &labels,
+                         const std::string &extra, double value) {
+    char buf[64];
+    out += name;
+    if (!labels.empty() || !extra.empty()) {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty()) {
+            out += ',';
+        }
+        out += extra;
+        out += '}';
+    }
+    std::snprintf(buf, sizeof(buf), " %.9g\n", value);
+    out += buf;
+}
+
+std::string MetricsRegistry::expose() const {
+    static const char *const TYPES[] = {"counter", "gauge", "summary"};
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out;
+    std::vector<bool> done(metrics.size(), false);
+    // The samples of a name together under one HELP and TYPE, in the order the names first appeared
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        if (done[i]) {
+            continue;
+        }
+        out += "# HELP " + metrics[i]->name + " " + metrics[i]->help + "\n";
+        out += "# TYPE " + metrics[i]->name + " " + TYPES[metrics[i]->type] + "\n";
+        for (size_t j = i; j < metrics.size(); ++j) {
+            const Metric &m = *metrics[j];
+            if (done[j] || m.name != metrics[i]->name) {
+                continue;
+            }
+            done[j] = true;
+            if (m.counter) {
+                appendSample(out, m.name, m.labels, "", static_cast<double>(m.counter->value()));
+            } else if (m.gauge) {
+                appendSample(out, m.name, m.labels, "", m.gauge->value());
+            } else if (m.histogram) {
+                for (double q : QUANTILES) {
+                    char quantile[32];
+                    std::snprintf(quantile, sizeof(quantile), "quantile=\"%g\"", q);
+                    appendSample(out, m.name, m.labels, quantile, m.histogram->quantile(q));
+                }
+                appendSample(out, m.name + "_sum", m.labels, "", m.histogram->sum());
+                appendSample(out, m.name + "_count", m.labels, "", static_cast<double>(m.histogram->count()));
+            }
+        }
+    }
+    return out;
+}
+
+std::string metricLabel(const std::string &key, const std::string &value) {
+    std::string out = key + "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+/*
+ * The endpoint of the process. Requests are answered one at a time on its
+ * thread, a scrape is a few kB and a scraper polls every few seconds.
+ */
+class MetricsServer {
+public:
+    static MetricsServer &instance() {
+        static MetricsServer server;
+        return server;
+    }
+
+    bool start(int port) {
+        std::lock_guard<std::mutex> lock(users_mutex);
+        if (users > 0) {
+            if (port != bound_port) {
+                ROS_WARN("Metrics are already served on port %d, not on %d", bound_port, port);
+            }
+            ++users;
+            return true;
+        }
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            ROS_ERROR("Cannot create the metrics socket");
+            return false;
+        }
+        const int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+            ROS_ERROR("Cannot listen for metrics on port %d", port);
+            close(fd);
+            fd = -1;
+            return false;
+        }
+        bound_port = port;
+        users = 1;
+        running = true;
+        thread = std::thread(&MetricsServer::run, this);
+        ROS_INFO("Metrics on http://0.0.0.0:%d/metrics", port);
+        return true;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(users_mutex);
+        if (users == 0 || --users > 0) {
+            return;
+        }
+        running = false;
+        thread.join();
+        close(fd);
+        fd = -1;
+    }
+
+private:
+    MetricsServer() : fd(-1), bound_port(0), users(0), running(false) {}
+
+    void run() {
+        while (running) {
+            pollfd p = {fd, POLLIN, 0};
+            if (poll(&p, 1, ACCEPT_POLL_MS) <= 0) {
+                continue;
+            }
+            const int client = accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            timeval timeout = {0, REQUEST_TIMEOUT_MS * 1000};
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            serve(client);
+            close(client);
+        }
+    }
+
+    void serve(int client) {
+        char request[REQUEST_MAX_SIZE];
+        const ssize_t n = recv(client, request, sizeof(request) - 1, 0);
+        if (n <= 0) {
+            return;
+        }
+        request[n] = '\0';
+        std::string status = "200 OK";
+        std::string body;
+        if (std::strncmp(request, "GET /metrics", 12) == 0 || std::strncmp(request, "GET / ", 6) == 0) {
+            body = MetricsRegistry::instance().expose();
+        } else {
+            status = "404 Not Found";
+            body = "Only GET /metrics\n";
+        }
+        char header[160];
+        const int size = std::snprintf(header, sizeof(header),
+                                       "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                       "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                                       status.c_str(), body.size());
+        send(client, header, size, MSG_NOSIGNAL);
+        send(client, body.data(), body.size(), MSG_NOSIGNAL);
+    }
+
+    int fd;
+    int bound_port;
+    int users;
+    std::mutex users_mutex;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+bool startMetricsServer(int port) {
+    return port > 0 && MetricsServer::instance().start(port);
+}
+
+void stopMetricsServer() {
+    MetricsServer::instance().stop();
+}
@@ -0,0 +1,144 @@
+#include "cyphy_control/MinSnap.h"
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
+#include <algorithm>
+#include <cmath>
+
+#define MIN_SNAP_MIN_DISTANCE 1e-3  // m, closer points are one
+
+// k! / (k - d)!, the factor of tau^(k - d) in derivative d of tau^k
+static double falling(int k, int d) {
+    double f = 1;
+    for (int i = 0; i < d; ++i) {
+        f *= k - i;
+    }
+    return f;
+}
+
+// Time of a trapezoidal speed profile from rest to rest over distance
+static double segmentTime(double distance, const MinSnapLimits &limits) {
+    const double v = limits.max_speed, a = limits.max_accel;
+    return distance > v * v / a ? distance / v + v / a : 2 * std::sqrt(distance / a);
+}
+
+void MinSnapTrajectory::clear() {
+    durations.clear();
+    starts.clear();
+    coeffs.resize(0, 3);
+}
+
+bool MinSnapTrajectory::build(const std::vector<Eigen::Vector3d> &input, const MinSnapLimits &limits) {
+    clear();
+    std::vector<Eigen::Vector3d> points;
+    for (const Eigen::Vector3d &p : input) {
+        if (points.empty() || (p - points.back()).norm() > MIN_SNAP_MIN_DISTANCE) {
+            points.push_back(p);
+        }
+    }
+    if (points.size() < 2 || limits.max_speed <= 0 || limits.max_accel <= 0) {
+        return false;
+    }
+    const size_t m = points.size() - 1;
+    const size_t n = MIN_SNAP_ORDER * m;
+    for (size_t i = 0; i < m; ++i) {
+        durations.push_back(segmentTime((points[i + 1] - points[i]).norm(), limits));
+    }
+
+    // Rows of segment i: its two positions, then continuity of derivatives 1 to 6 into segment i + 1 in units of
+    // the normalized time of i. The first segment adds rest at the start, the last rest at the end
+    std::vector<Eigen::Triplet<double> > entries;
+    Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(n, 3);
+    size_t row = 0;
+    for (size_t i = 0; i < m; ++i) {
+        const size_t col = MIN_SNAP_ORDER * i;
+        entries.emplace_back(row, col, 1.0);
+        rhs.row(row++) = points[i].transpose();
+        for (int k = 0; k < MIN_SNAP_ORDER; ++k) {
+            entries.emplace_back(row, col + k, 1.0);
+        }
+        rhs.row(row++) = points[i + 1].transpose();
+        if (i == 0) {
+            for (int d = 1; d <= 3; ++d) {
+                entries.emplace_back(row++, col + d, falling(d, d));
+            }
+        }
+        if (i + 1 < m) {
+            const double ratio = durations[i] / durations[i + 1];
+            for (int d = 1; d <= MIN_SNAP_ORDER - 2; ++d) {
+                for (int k = d; k < MIN_SNAP_ORDER; ++k) {
+                    entries.emplace_back(row, col + k, falling(k, d));
+                }
+                entries.emplace_back(row++, col + MIN_SNAP_ORDER + d, -std::pow(ratio, d) * falling(d, d));
+            }
+        } else {
+            for (int d = 1; d <= 3; ++d) {
+                for (int k = d; k < MIN_SNAP_ORDER; ++k) {
+                    entries.emplace_back(row, col + k, falling(k, d));
+                }
+                ++row;
+            }
+        }
+    }
+
+    Eigen::SparseMatrix<double> a(n, n);
+    a.setFromTriplets(entries.begin(), entries.end());
+    Eigen::SparseLU<Eigen::SparseMatrix<double> > lu;
+    lu.compute(a);
+    if (lu.info() != Eigen::Success) {
+        clear();
+        return false;
+    }
+    coeffs = lu.solve(rhs);
+    if (lu.info() != Eigen::Success || !coeffs.allFinite()) {
+        clear();
+        return false;
+    }
+
+    // Speed scales with 1 / s and acceleration with 1 / s^2 when all times scale by s
+    double scale = 1;
+    for (size_t i = 0; i < m; ++i) {
+        for (int j = 0; j <= MIN_SNAP_CHECKS; ++j) {
+            const double tau = static_cast<double>(j) / MIN_SNAP_CHECKS;
+            const double v = derivative(i, 1, tau).norm() / durations[i];
+            const double acc = derivative(i, 2, tau).norm() / (durations[i] * durations[i]);
+            scale = std::max(scale, v / limits.max_speed);
+            scale = std::max(scale, std::sqrt(acc / limits.max_accel));
+        }
+    }
+    double t = 0;
+    for (size_t i = 0; i < m; ++i) {
+        durations[i] *= scale;
+        starts.push_back(t);
+        t += durations[i];
+    }
+    return true;
+}
+
+Eigen::Vector3d MinSnapTrajectory::derivative(size_t segment, int d, double tau) const {
+    Eigen::Vector3d out = Eigen::Vector3d::Zero();
+    double power = 1;
+    for (int k = d; k < MIN_SNAP_ORDER; ++k, power *= tau) {
+        out += falling(k, d) * power * coeffs.row(MIN_SNAP_ORDER * segment + k).transpose();
+    }
+    return out;
+}
+
+void MinSnapTrajectory::sample(double t, Eigen::Vector3d &position, Eigen::Vector3d &velocity,
+                               Eigen::Vector3d &acceleration) const {
+    position.setZero();
+    velocity.setZero();
+    acceleration.setZero();
+    if (empty()) {
+        return;
+    }
+    if (t >= duration()) {
+        position = derivative(durations.size() - 1, 0, 1.0);
+        return;
+    }
+    t = std::max(t, 0.0);
+    const size_t i = std::upper_bound(starts.begin(), starts.end(), t) - starts.begin() - 1;
+    const double tau = (t - starts[i]) / durations[i];
+    position = derivative(i, 0, tau);
+    velocity = derivative(i, 1, tau) / durations[i];
+    acceleration = derivative(i, 2, tau) / (durations[i] * durations[i]);
+}
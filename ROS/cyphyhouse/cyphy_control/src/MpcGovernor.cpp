@@ -0,0 +1,40 @@
+#include "cyphy_control/MpcGovernor.h"
+
+const size_t MpcGovernor::LEVELS;
+
+MpcGovernor::MpcGovernor(double deadline, size_t levels)
+    : deadline(deadline), levels(std::max<size_t>(levels, 1)), current(0), since_change(0), changed(0), next(0) {}
+
+size_t MpcGovernor::record(double seconds) {
+    if (times.size() < window) {
+        times.push_back(seconds);
+    } else {
+        times[next] = seconds;
+    }
+    next = (next + 1) % window;
+    ++since_change;
+    if (times.size() < window) {
+        return current;
+    }
+
+    // Nearest rank, as SolveWindow
+    sorted.assign(times.begin(), times.end());
+    const size_t rank = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    const double t = sorted[rank];
+
+    size_t level = current;
+    if (t > high * deadline && current + 1 < levels) {
+        ++level;
+    } else if (t < low * deadline && current > 0 && since_change >= hold) {
+        --level;
+    }
+    if (level != current) {
+        current = level;
+        since_change = 0;
+        ++changed;
+        times.clear();
+        next = 0;
+    }
+    return current;
+}
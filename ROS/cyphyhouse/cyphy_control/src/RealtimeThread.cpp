@@ -0,0 +1,260 @@
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Metrics.h"
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
+ThreadConfig load_thread_config(const ros::NodeHandle &n, const std::string &name) {
+    ThreadConfig config;
+    int prefault = 0;
+    std::string cpus;
+    n.param<int>(name + "_priority", config.priority, 0);
+    n.param<std::string>(name + "_cpus", cpus, "");
+    n.param<int>(name + "_stack_prefault", prefault, 0);
+    config.stack_prefault = std::max(prefault, 0);
+
+    std::stringstream list(cpus);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        int first, last;
+        const int fields = std::sscanf(item.c_str(), "%d-%d", &first, &last);
+        if (fields < 1 || first < 0) {
+            ROS_WARN("%s_cpus: ignored \"%s\"", name.c_str(), item.c_str());
+            continue;
+        }
+        for (int cpu = first; cpu <= (fields == 2 ? last : first); ++cpu) {
+            config.cpus.push_back(cpu);
+        }
+    }
+    return config;
+}
+
+bool lock_memory(const ros::NodeHandle &n) {
+    static std::once_flag once;
+    static bool locked = true;
+    bool lock;
+    n.param<bool>("lock_memory", lock, false);
+    if (lock) {
+        std::call_once(once, []() {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+                ROS_WARN("mlockall failed: %s, needs CAP_IPC_LOCK or a memlock limit", std::strerror(errno));
+                locked = false;
+            }
+        });
+    }
+    return !lock || locked;
+}
+
+// Touches bytes of the stack below the caller, so the loop never takes the first fault of a page
+static void __attribute__((noinline)) prefault_stack(size_t bytes) {
+    volatile char *stack = static_cast<volatile char *>(alloca(bytes));
+    const size_t page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += page) {
+        stack[i] = 0;
+    }
+}
+
+bool apply_thread_config(const std::string &name, const ThreadConfig &config) {
+    bool ok = true;
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    if (!config.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : config.cpus) {
+            CPU_SET(cpu, &set);
+        }
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            ROS_WARN("Thread %s: cannot run on the CPUs asked for: %s", name.c_str(), std::strerror(err));
+            ok = false;
+        }
+    }
+
+    if (config.priority > 0) {
+        sched_param param;
+        param.sched_priority = std::min(std::max(config.priority, sched_get_priority_min(SCHED_FIFO)),
+                                        sched_get_priority_max(SCHED_FIFO));
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            ROS_WARN("Thread %s: no SCHED_FIFO priority %d: %s, needs CAP_SYS_NICE or an rtprio limit", name.c_str(),
+                     param.sched_priority, std::strerror(err));
+            ok = false;
+        }
+    }
+
+    if (config.stack_prefault > 0) {
+        prefault_stack(config.stack_prefault);
+    }
+    return ok;
+}
+
+static int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+LoopJitter::LoopJitter(double period)
+    : period_ns(static_cast<int64_t>(period * 1e9)), last_ns(0), worst_ns(0), total_ns(0), cycles(0), overruns(0),
+      worst_ever_ns(0), overrun_metric(nullptr), jitter_metric(nullptr) {}
+
+void LoopJitter::exportMetrics(const std::string &loop) {
+    MetricsRegistry &metrics = MetricsRegistry::instance();
+    const std::string labels = metricLabel("loop", loop);
+    overrun_metric = &metrics.counter("control_loop_overruns_total", "Cycles of the loop missed or twice as long as the period", labels);
+    jitter_metric = &metrics.histogram("control_loop_jitter_seconds", "Deviation of the wake-ups of the loop from its schedule", labels);
+}
+
+void LoopJitter::tick() {
+    const int64_t now = steady_ns();
+    if (last_ns != 0) {
+        const int64_t interval = now - last_ns;
+        record(std::abs(interval - period_ns), interval > 2 * period_ns ? 1 : 0);
+    }
+    last_ns = now;
+}
+
+void LoopJitter::record(int64_t deviation_ns, uint32_t missed) {
+    int64_t worst = worst_ns.load(std::memory_order_relaxed);
+    while (deviation_ns > worst && !worst_ns.compare_exchange_weak(worst, deviation_ns, std::memory_order_relaxed)) {
+    }
+    total_ns.fetch_add(deviation_ns, std::memory_order_relaxed);
+    cycles.fetch_add(1, std::memory_order_relaxed);
+    if (missed != 0) {
+        overruns.fetch_add(missed, std::memory_order_relaxed);
+    }
+    if (jitter_metric) {
+        jitter_metric->record(deviation_ns * 1e-9);
+        if (missed != 0) {
+            overrun_metric->add(missed);
+        }
+    }
+}
+
+static void add(diagnostic_msgs::DiagnosticStatus &status, const std::string &key, double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", value);
+    diagnostic_msgs::KeyValue kv;
+    kv.key = key;
+    kv.value = buf;
+    status.values.push_back(kv);
+}
+
+diagnostic_msgs::DiagnosticStatus LoopJitter::status(const std::string &name, double limit) {
+    const int64_t worst = worst_ns.exchange(0, std::memory_order_relaxed);
+    const int64_t total = total_ns.exchange(0, std::memory_order_relaxed);
+    const uint32_t n = cycles.exchange(0, std::memory_order_relaxed);
+    worst_ever_ns = std::max(worst_ever_ns, worst);
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = name;
+    status.hardware_id = name;
+    if (n == 0) {
+        status.level = diagnostic_msgs::DiagnosticStatus::STALE;
+        status.message = "no cycles";
+        return status;
+    }
+    const bool late = worst * 1e-9 > limit;
+    status.level = late ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = late ? "jitter over limit" : "ok";
+    add(status, "cycles", n);
+    add(status, "period [s]", period_ns * 1e-9);
+    add(status, "jitter mean [s]", total * 1e-9 / n);
+    add(status, "jitter max [s]", worst * 1e-9);
+    add(status, "jitter max ever [s]", worst_ever_ns * 1e-9);
+    add(status, "overruns", overruns.load(std::memory_order_relaxed));
+    return status;
+}
+
+static int64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// First instant phase + k * period after now [ns]
+static int64_t align(int64_t now, int64_t period, int64_t phase) {
+    return phase + ((now - phase) / period + 1) * period;
+}
+
+PeriodicLoop::PeriodicLoop(double period, double phase, LoopJitter *jitter)
+    : period_ns(std::max<int64_t>(static_cast<int64_t>(period * 1e9), 1)), next_ns(0), missed(0), jitter(jitter) {
+    phase_ns = static_cast<int64_t>(phase * 1e9) % period_ns;
+    if (phase_ns < 0) {
+        phase_ns += period_ns;
+    }
+}
+
+bool PeriodicLoop::sleep() {
+    const int64_t now = realtime_ns();
+    uint32_t late_cycles = 0;
+    if (next_ns == 0) {
+        next_ns = align(now, period_ns, phase_ns);
+    } else {
+        next_ns += period_ns;
+        if (next_ns <= now) {
+            // Runs the next deadline still ahead, the ones in between are lost
+            const int64_t ahead = align(now, period_ns, phase_ns);
+            late_cycles = static_cast<uint32_t>((ahead - next_ns) / period_ns);
+            next_ns = ahead;
+        } else if (next_ns - now > period_ns) {
+            // The clock was set back
+            next_ns = align(now, period_ns, phase_ns);
+        }
+    }
+    missed += late_cycles;
+
+    timespec ts;
+    ts.tv_sec = next_ns / 1000000000;
+    ts.tv_nsec = next_ns % 1000000000;
+    while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+
+    if (jitter) {
+        jitter->record(std::max<int64_t>(realtime_ns() - next_ns, 0), late_cycles);
+    }
+    return late_cycles == 0;
+}
+
+double PeriodicLoop::deadline() const {
+    return next_ns * 1e-9;
+}
+
+double PeriodicLoop::next_deadline(double now, double period, double phase) {
+    const double k = std::floor((now - phase) / period) + 1;
+    return phase + k * period;
+}
+
+CallbackThread::CallbackThread(const ros::NodeHandle &n, const std::string &name) : handle(n), running(true) {
+    handle.setCallbackQueue(&queue);
+    thread = start_thread(name, load_thread_config(n, name), &CallbackThread::serve, this);
+}
+
+CallbackThread::~CallbackThread() {
+    stop();
+}
+
+void CallbackThread::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void CallbackThread::serve() {
+    // The timeout only bounds how long stopping takes, a callback runs as soon as it is queued
+    while (running && handle.ok()) {
+        queue.callAvailable(ros::WallDuration(0.01));
+    }
+}
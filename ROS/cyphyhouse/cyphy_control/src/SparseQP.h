@@ -0,0 +1,145 @@
+//
+// Warm-started ADMM solver for the sparse QP of one real-time iteration of
+// the MPC (TapedNLP::sqp_step), the splitting of OSQP without its scaling.
+//
+
+#ifndef CYPHY_CONTROL_SPARSE_QP_H
+#define CYPHY_CONTROL_SPARSE_QP_H
+
+#include "Eigen/Sparse"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+ * Minimizes 1/2 x'Px + q'x subject to l <= Cx <= u. The quasi-definite KKT
+ * matrix [P + sigma I, C'; C, -1/rho] is factored once per solve, every
+ * iteration is one back substitution and a projection of Cx on [l, u]. At
+ * every convergence check rho moves towards the balance of the scaled primal
+ * and dual residuals, refactoring the KKT matrix when it changes more than
+ * fivefold, since the MPC weights leave the problem unscaled. The iteration
+ * count is bounded by max_iter, which bounds the latency; a solve that stops
+ * there still leaves its last iterate in x and y. x, y and rho are kept
+ * between solves as the next starting point as long as the sizes agree.
+ */
+class SparseQP {
+public:
+    typedef Eigen::SparseMatrix<double> Matrix;
+    typedef Eigen::VectorXd Vector;
+
+    SparseQP()
+        : rho(0.1), sigma(1e-6), alpha(1.6), eps_abs(1e-4), eps_rel(1e-4), max_iter(200), check_every(10),
+          iterations(0) {}
+
+    // Step sizes, equality rows (l == u) take 1e3 * rho
+    double rho, sigma, alpha;
+    // Stop once the primal and dual residuals are below eps_abs + eps_rel * their scale
+    double eps_abs, eps_rel;
+    int max_iter, check_every;
+
+    // Primal and constraint dual of the last solve, start of the next one
+    Vector x, y;
+    int iterations;
+
+    // P holds both triangles. Returns true if the residuals converged within max_iter
+    bool solve(const Matrix &P, const Vector &q, const Matrix &C, const Vector &l, const Vector &u) {
+        const Eigen::Index n = P.rows(), m = C.rows();
+        Vector rho_row(m);
+        set_rho(l, u, rho_row);
+
+        std::vector<Eigen::Triplet<double> > t;
+        t.reserve(P.nonZeros() + 2 * C.nonZeros() + n + m);
+        for (Eigen::Index k = 0; k < P.outerSize(); ++k) {
+            for (Matrix::InnerIterator it(P, k); it; ++it) {
+                t.push_back(Eigen::Triplet<double>(it.row(), it.col(), it.value()));
+            }
+        }
+        for (Eigen::Index k = 0; k < C.outerSize(); ++k) {
+            for (Matrix::InnerIterator it(C, k); it; ++it) {
+                t.push_back(Eigen::Triplet<double>(n + it.row(), it.col(), it.value()));
+                t.push_back(Eigen::Triplet<double>(it.col(), n + it.row(), it.value()));
+            }
+        }
+        for (Eigen::Index i = 0; i < n; ++i) {
+            t.push_back(Eigen::Triplet<double>(i, i, sigma));
+        }
+        for (Eigen::Index i = 0; i < m; ++i) {
+            t.push_back(Eigen::Triplet<double>(n + i, n + i, -1.0 / rho_row[i]));
+        }
+        kkt.resize(n + m, n + m);
+        kkt.setFromTriplets(t.begin(), t.end());
+        kkt_ldlt.compute(kkt);
+        if (kkt_ldlt.info() != Eigen::Success) {
+            iterations = 0;
+            return false;
+        }
+
+        if (x.size() != n) {
+            x = Vector::Zero(n);
+        }
+        if (y.size() != m) {
+            y = Vector::Zero(m);
+        }
+        Vector z = (C * x).cwiseMax(l).cwiseMin(u);
+        Vector rhs(n + m), sol(n + m);
+        for (iterations = 1; iterations <= max_iter; ++iterations) {
+            rhs.head(n) = sigma * x - q;
+            rhs.tail(m) = z - y.cwiseQuotient(rho_row);
+            sol = kkt_ldlt.solve(rhs);
+
+            const Vector z_tilde = z + (sol.tail(m) - y).cwiseQuotient(rho_row);
+            x = alpha * sol.head(n) + (1.0 - alpha) * x;
+            const Vector z_relaxed = alpha * z_tilde + (1.0 - alpha) * z;
+            const Vector z_next = (z_relaxed + y.cwiseQuotient(rho_row)).cwiseMax(l).cwiseMin(u);
+            y += rho_row.cwiseProduct(z_relaxed - z_next);
+            z = z_next;
+
+            if (iterations % check_every == 0) {
+                double primal, dual;
+                if (residuals(P, q, C, z, primal, dual)) {
+                    return true;
+                }
+                const double rho_next = std::min(1e6, std::max(1e-6, rho * std::sqrt(primal / std::max(dual, 1e-12))));
+                if (rho_next > 5.0 * rho || rho_next < 0.2 * rho) {
+                    rho = rho_next;
+                    set_rho(l, u, rho_row);
+                    for (Eigen::Index i = 0; i < m; ++i) {
+                        kkt.coeffRef(n + i, n + i) = -1.0 / rho_row[i];
+                    }
+                    kkt_ldlt.factorize(kkt);
+                    if (kkt_ldlt.info() != Eigen::Success) {
+                        return false;
+                    }
+                }
+            }
+        }
+        iterations = max_iter;
+        return false;
+    }
+
+private:
+    void set_rho(const Vector &l, const Vector &u, Vector &rho_row) const {
+        for (Eigen::Index i = 0; i < rho_row.size(); ++i) {
+            rho_row[i] = (u[i] - l[i] < 1e-9) ? 1e3 * rho : rho;
+        }
+    }
+
+    // Primal and dual residuals relative to their tolerance, true if both are within it
+    bool residuals(const Matrix &P, const Vector &q, const Matrix &C, const Vector &z, double &primal,
+                   double &dual) const {
+        const Vector Cx = C * x;
+        const Vector Px = P * x;
+        const Vector Cy = C.transpose() * y;
+        const double primal_scale = std::max(Cx.lpNorm<Eigen::Infinity>(), z.lpNorm<Eigen::Infinity>());
+        const double dual_scale = std::max(std::max(Px.lpNorm<Eigen::Infinity>(), Cy.lpNorm<Eigen::Infinity>()),
+                                           q.lpNorm<Eigen::Infinity>());
+        primal = (Cx - z).lpNorm<Eigen::Infinity>() / (eps_abs + eps_rel * primal_scale);
+        dual = (Px + q + Cy).lpNorm<Eigen::Infinity>() / (eps_abs + eps_rel * dual_scale);
+        return primal <= 1.0 && dual <= 1.0;
+    }
+
+    Matrix kkt;
+    Eigen::SimplicialLDLT<Matrix> kkt_ldlt;
+};
+
+#endif //CYPHY_CONTROL_SPARSE_QP_H
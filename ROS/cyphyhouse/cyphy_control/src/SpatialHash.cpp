@@ -0,0 +1,128 @@
+#include "cyphy_control/SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(double cell_size)
+    : cell_size(cell_size > 0 ? cell_size : 1.0), mask(0), start(2, 0), min_cx(0), max_cx(-1), min_cy(0),
+      max_cy(-1) {}
+
+int64_t SpatialHash::cell_of(double v) const {
+    return static_cast<int64_t>(std::floor(v / cell_size));
+}
+
+uint32_t SpatialHash::bucket(int64_t cx, int64_t cy) const {
+    const uint64_t h = static_cast<uint64_t>(cx) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(cy) * 0xC2B2AE3D27D4EB4Full;
+    return static_cast<uint32_t>(h >> 32) & mask;
+}
+
+void SpatialHash::build(const double *x, const double *y, const double *z, size_t n) {
+    size_t buckets = 1;
+    while (buckets < 2 * n) {
+        buckets <<= 1;
+    }
+    mask = static_cast<uint32_t>(buckets - 1);
+
+    std::vector<uint32_t> of(n);
+    start.assign(buckets + 1, 0);
+    min_cx = min_cy = INT64_MAX;
+    max_cx = max_cy = INT64_MIN;
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t cx = cell_of(x[i]), cy = cell_of(y[i]);
+        min_cx = std::min(min_cx, cx);
+        max_cx = std::max(max_cx, cx);
+        min_cy = std::min(min_cy, cy);
+        max_cy = std::max(max_cy, cy);
+        of[i] = bucket(cx, cy);
+        ++start[of[i] + 1];
+    }
+    for (size_t b = 0; b < buckets; ++b) {
+        start[b + 1] += start[b];
+    }
+
+    index.resize(n);
+    px.resize(n);
+    py.resize(n);
+    pz.resize(n);
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t k = fill[of[i]]++;
+        index[k] = static_cast<uint32_t>(i);
+        px[k] = x[i];
+        py[k] = y[i];
+        pz[k] = z[i];
+    }
+}
+
+void SpatialHash::visit(int64_t cx, int64_t cy, double x, double y, double z, double r2, uint32_t exclude,
+                        std::vector<Neighbour> &out) const {
+    const uint32_t b = bucket(cx, cy);
+    for (uint32_t k = start[b]; k < start[b + 1]; ++k) {
+        const double dx = px[k] - x, dy = py[k] - y, dz = pz[k] - z;
+        const double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 <= r2 && index[k] != exclude && cell_of(px[k]) == cx && cell_of(py[k]) == cy) {
+            out.push_back(Neighbour(index[k], d2));
+        }
+    }
+}
+
+static bool closer(const SpatialHash::Neighbour &a, const SpatialHash::Neighbour &b) {
+    return a.second < b.second || (a.second == b.second && a.first < b.first);
+}
+
+void SpatialHash::radius(double x, double y, double z, double radius, std::vector<Neighbour> &out,
+                         uint32_t exclude) const {
+    out.clear();
+    if (index.empty() || radius < 0) {
+        return;
+    }
+    const int64_t x0 = std::max(cell_of(x - radius), min_cx), x1 = std::min(cell_of(x + radius), max_cx);
+    const int64_t y0 = std::max(cell_of(y - radius), min_cy), y1 = std::min(cell_of(y + radius), max_cy);
+    for (int64_t cx = x0; cx <= x1; ++cx) {
+        for (int64_t cy = y0; cy <= y1; ++cy) {
+            visit(cx, cy, x, y, z, radius * radius, exclude, out);
+        }
+    }
+    std::sort(out.begin(), out.end(), closer);
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i].second = std::sqrt(out[i].second);
+    }
+}
+
+void SpatialHash::nearest(double x, double y, double z, size_t k, double max_radius, std::vector<Neighbour> &out,
+                          uint32_t exclude) const {
+    out.clear();
+    if (index.empty() || k == 0) {
+        return;
+    }
+    const double r2 = max_radius > 0 ? max_radius * max_radius : INFINITY;
+    const int64_t qx = cell_of(x), qy = cell_of(y);
+    // Rings of cells around the one of the query point, ring r is r cells out. A point beyond ring r is at
+    // least r cells away, so the search ends once k points closer than that are in
+    const int64_t last = std::max(std::max(qx - min_cx, max_cx - qx), std::max(qy - min_cy, max_cy - qy));
+    for (int64_t r = 0; r <= last; ++r) {
+        for (int64_t cx = qx - r; cx <= qx + r; ++cx) {
+            const bool edge = (cx == qx - r) || (cx == qx + r);
+            for (int64_t cy = qy - r; cy <= qy + r; cy += edge ? 1 : 2 * std::max<int64_t>(r, 1)) {
+                if (cx >= min_cx && cx <= max_cx && cy >= min_cy && cy <= max_cy) {
+                    visit(cx, cy, x, y, z, r2, exclude, out);
+                }
+            }
+        }
+        if (out.size() >= k) {
+            std::nth_element(out.begin(), out.begin() + (k - 1), out.end(), closer);
+            const double reach = r * cell_size;
+            if (out[k - 1].second <= reach * reach) {
+                break;
+            }
+        }
+        if (r * cell_size > std::sqrt(r2)) {
+            break;
+        }
+    }
+    const size_t n = std::min(k, out.size());
+    std::partial_sort(out.begin(), out.begin() + n, out.end(), closer);
+    out.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        out[i].second = std::sqrt(out[i].second);
+    }
+}
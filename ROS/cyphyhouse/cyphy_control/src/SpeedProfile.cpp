@@ -0,0 +1,151 @@
+#include "cyphy_control/SpeedProfile.h"
+#include <algorithm>
+#include <cmath>
+
+#define PROFILE_SEARCH_SAMPLES 50   // Samples past the progress searched for the nearest one, 5 m at 0.1 m
+
+template <class T>
+static uint64_t fnv1a(uint64_t h, const T *data, size_t count) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < count * sizeof(T); ++i) {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+SpeedProfile::SpeedProfile() : cursor(0), fingerprint(0) {}
+
+void SpeedProfile::clear() {
+    samples.clear();
+    limit.clear();
+    cursor = 0;
+    fingerprint = 0;
+}
+
+bool SpeedProfile::build(const std::vector<TrackPoint> &points, const ProfileLimits &limits) {
+    const uint64_t h = fnv1a(fnv1a(1469598103934665603ull, points.data(), points.size()), &limits, 1);
+    if (h == fingerprint && !samples.empty()) {
+        return true;
+    }
+    clear();
+
+    // Every point, and samples every spacing on the segments between them
+    const double spacing = std::max(limits.spacing, 1e-3);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const TrackPoint &b = points[i];
+        if (samples.empty()) {
+            samples.push_back(Sample{b.x, b.y, 0, 0, 0});
+            continue;
+        }
+        const Sample a = samples.back();
+        const double len = std::hypot(b.x - a.x, b.y - a.y);
+        if (len < 1e-6) {
+            continue;
+        }
+        const size_t steps = static_cast<size_t>(std::ceil(len / spacing));
+        for (size_t k = 1; k <= steps; ++k) {
+            const double f = static_cast<double>(k) / steps;
+            samples.push_back(Sample{a.x + f * (b.x - a.x), a.y + f * (b.y - a.y), a.s + f * len, 0, 0});
+        }
+    }
+    const size_t n = samples.size();
+    if (n < 2) {
+        clear();
+        return false;
+    }
+
+    // Speed limit of the curvature through each sample and its neighbours (circumscribed circle)
+    limit.assign(n, limits.max_speed);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        const Sample &a = samples[i - 1], &b = samples[i], &c = samples[i + 1];
+        const double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+        const double sides = (b.s - a.s) * (c.s - b.s) * std::hypot(c.x - a.x, c.y - a.y);
+        const double curvature = sides > 1e-12 ? 2 * std::fabs(cross) / sides : 0;
+        if (curvature > 1e-6) {
+            limit[i] = std::min(limit[i], std::sqrt(limits.lateral_accel / curvature));
+        }
+    }
+    limit[0] = std::min(limit[0], limits.start_speed);
+    limit[n - 1] = std::min(limit[n - 1], limits.end_speed);
+
+    // Forward within the acceleration, backward within the deceleration
+    samples[0].v = limit[0];
+    for (size_t i = 1; i < n; ++i) {
+        const double ds = samples[i].s - samples[i - 1].s;
+        samples[i].v = std::min(limit[i], std::sqrt(samples[i - 1].v * samples[i - 1].v + 2 * limits.max_accel * ds));
+    }
+    for (size_t i = n - 1; i-- > 0;) {
+        const double ds = samples[i + 1].s - samples[i].s;
+        samples[i].v = std::min(samples[i].v, std::sqrt(samples[i + 1].v * samples[i + 1].v + 2 * limits.max_decel * ds));
+    }
+
+    // Constant acceleration between two samples
+    for (size_t i = 1; i < n; ++i) {
+        const double ds = samples[i].s - samples[i - 1].s;
+        const double vv = samples[i - 1].v + samples[i].v;
+        const double dt = vv > 1e-6 ? 2 * ds / vv : 2 * std::sqrt(ds / std::max(limits.max_accel, 1e-3));
+        samples[i].t = samples[i - 1].t + dt;
+    }
+    fingerprint = h;
+    return true;
+}
+
+double SpeedProfile::progress(double x, double y) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const size_t last = std::min(cursor + PROFILE_SEARCH_SAMPLES, samples.size() - 1);
+    double best = INFINITY;
+    for (size_t i = cursor; i <= last; ++i) {
+        const double d = std::hypot(samples[i].x - x, samples[i].y - y);
+        if (d < best) {
+            best = d;
+            cursor = i;
+        }
+    }
+    return samples[cursor].t;
+}
+
+size_t SpeedProfile::before(double t) const {
+    // First sample after t, from the progress on; a horizon starts at or after it
+    auto first = samples.begin() + cursor;
+    if (first->t > t) {
+        first = samples.begin();
+    }
+    auto after = std::upper_bound(first, samples.end(), t, [](double v, const Sample &s) { return v < s.t; });
+    return static_cast<size_t>(after - samples.begin()) - 1;
+}
+
+void SpeedProfile::sample(double t, double &x, double &y, double &heading, double &speed) const {
+    x = y = heading = speed = 0;
+    if (samples.empty()) {
+        return;
+    }
+    const size_t n = samples.size();
+    if (t >= samples[n - 1].t) {
+        const Sample &a = samples[n - 2], &b = samples[n - 1];
+        x = b.x;
+        y = b.y;
+        heading = std::atan2(b.y - a.y, b.x - a.x);
+        speed = b.v;
+        return;
+    }
+    const size_t i = before(std::max(t, 0.0));
+    const Sample &a = samples[i], &b = samples[i + 1];
+    const double dt = b.t - a.t;
+    const double tau = std::max(t, 0.0) - a.t;
+    const double accel = dt > 1e-9 ? (b.v - a.v) / dt : 0;
+    const double ds = b.s - a.s;
+    const double f = ds > 1e-9 ? std::min((a.v * tau + 0.5 * accel * tau * tau) / ds, 1.0) : 0;
+    x = a.x + f * (b.x - a.x);
+    y = a.y + f * (b.y - a.y);
+    heading = std::atan2(b.y - a.y, b.x - a.x);
+    speed = a.v + accel * tau;
+}
+
+void SpeedProfile::references(double t0, const double *times, size_t n, double *out) const {
+    double heading, speed;
+    for (size_t k = 0; k < n; ++k) {
+        sample(t0 + times[k], out[k], out[n + k], heading, speed);
+    }
+}
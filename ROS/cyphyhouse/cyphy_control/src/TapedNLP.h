@@ -0,0 +1,513 @@
+//
+// Ipopt problem on a CppAD tape that is recorded once and reused by every
+// CarMpc::Solve, instead of CppAD::ipopt::solve taping FG_eval on each call.
+// Built with MPC_CODEGEN the derivatives come from C code CppADCodeGen
+// generates for FG_eval instead of from the tape.
+//
+
+#ifndef CYPHY_CONTROL_TAPED_NLP_H
+#define CYPHY_CONTROL_TAPED_NLP_H
+
+#include "cyphy_control/config.h"
+#ifdef MPC_CODEGEN
+#include <cppad/cg.hpp>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <memory>
+#else
+#include <cppad/cppad.hpp>
+#endif
+#include <coin/IpTNLP.hpp>
+#include <coin/IpIpoptApplication.hpp>
+#include <coin/IpIpoptData.hpp>
+#include "SparseQP.h"
+#include <algorithm>
+#include <ctime>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Minimizes fg[0] subject to gl <= fg[1..m] <= gu and xl <= vars <= xu, with
+ * fg computed by FG_eval exactly as for CppAD::ipopt::solve. The tape is only
+ * valid for every solve if FG_eval takes all that changes between solves
+ * (initial state, reference) from vars: such inputs are variables with equal
+ * lower and upper bounds, which Ipopt removes from the problem
+ * (fixed_variable_treatment make_parameter). The sparsity patterns and the
+ * CppAD sparse Jacobian and Hessian work, which holds their coloring, are
+ * kept across solves.
+ *
+ * With MPC_CODEGEN FG_eval is taped on CppAD::cg::CG<double> instead and
+ * turned into straight-line C for fg, the sparse Jacobian (objective gradient
+ * as its row 0) and the lower triangle of the Lagrangian Hessian, compiled
+ * into <name>_fg.so in the working directory of the node (ROS_HOME) and
+ * loaded from there. The library is generated again when it is missing or
+ * older than the object this code is built into (libcyphy_control), so a
+ * rebuild picks up changes to FG_eval and the cost terms. FG_eval must
+ * therefore be a template on the vector type.
+ *
+ * Ipopt stops at the first iteration past deadline, and with track_best the
+ * feasible point of least objective among all it evaluates is kept, trial
+ * points of the line search included, for a solve that ends unconverged.
+ */
+class TapedNLP : public Ipopt::TNLP {
+public:
+    typedef std::vector<double> Dvector;
+
+    template <class FG_eval>
+    TapedNLP(FG_eval &fg_eval, size_t n_vars, size_t n_constraints, const std::string &name)
+        : x0(n_vars, 0.0), xl(n_vars), xu(n_vars), gl(n_constraints), gu(n_constraints), x(n_vars, 0.0),
+          z_l0(n_vars, 0.0), z_u0(n_vars, 0.0), lambda0(n_constraints, 0.0), z_l(n_vars, 0.0), z_u(n_vars, 0.0),
+          lambda(n_constraints, 0.0), obj_value(0.0), status(Ipopt::INTERNAL_ERROR), iterations(0), n(n_vars), m(n_constraints), xv(n_vars), fgv(n_constraints + 1),
+          gv(n_constraints), fg_weight(n_constraints + 1, 0.0) {
+#ifdef MPC_CODEGEN
+        const std::string lib_file = "./" + name + "_fg" + CppAD::cg::system::SystemInfo<>::DYNAMIC_LIB_EXTENSION;
+        if (stale(lib_file)) {
+            generate(fg_eval, name);
+        }
+        lib.reset(new CppAD::cg::LinuxDynamicLib<double>(lib_file));
+        model = lib->model(name);
+
+        // The objective gradient is row 0 of the generated Jacobian, Ipopt takes the other rows
+        std::vector<size_t> rows, cols;
+        model->JacobianSparsity(rows, cols);
+        for (size_t k = 0; k < rows.size(); ++k) {
+            if (rows[k] == 0) {
+                grad_k.push_back(k);
+            } else {
+                jac_k.push_back(k);
+                jac_row.push_back(rows[k]);
+            }
+        }
+        jac_col = cols;
+        model->HessianSparsity(hes_row, hes_col);
+        fg_jac.resize(rows.size());
+#else
+        (void) name;
+        std::vector<CppAD::AD<double> > avars(n, CppAD::AD<double>(0.0)), afg(m + 1);
+        CppAD::Independent(avars);
+        fg_eval(afg, avars);
+        fun.Dependent(avars, afg);
+        fun.optimize();
+
+        // Ipopt takes the constraint rows of the Jacobian and the lower triangle of the Hessian
+        sparsity(fun, 1);
+#endif
+        jac.resize(jac_row.size());
+        hes.resize(hes_row.size());
+        hes_weight.resize(m + 1);
+    }
+
+    // Starting point and bounds of the next solve, set by the caller
+    Dvector x0, xl, xu, gl, gu;
+
+    // Result of the last solve
+    Dvector x;
+
+    // Bound and constraint multipliers to start from, Ipopt only asks for them with warm_start_init_point
+    Dvector z_l0, z_u0, lambda0;
+
+    // Multipliers, objective, status and iteration count of the last solve
+    Dvector z_l, z_u, lambda;
+    Ipopt::Number obj_value;
+    Ipopt::SolverReturn status;
+    Ipopt::Index iterations;
+
+    // End of the next solves [s of the system clock], 0 for none
+    double deadline = 0.0;
+    // Keep the feasible points evaluated to within best_tol in best_x, the one of least objective best_obj
+    bool track_best = false;
+    double best_tol = 0.0;
+    Dvector best_x;
+    Ipopt::Number best_obj = 0.0;
+    bool best_valid = false;
+
+    bool get_nlp_info(Ipopt::Index &n_out, Ipopt::Index &m_out, Ipopt::Index &nnz_jac_g, Ipopt::Index &nnz_h_lag,
+                      IndexStyleEnum &index_style) {
+        n_out = n;
+        m_out = m;
+        nnz_jac_g = jac_row.size();
+        nnz_h_lag = hes_row.size();
+        index_style = C_STYLE;
+        return true;
+    }
+
+    bool get_bounds_info(Ipopt::Index, Ipopt::Number *x_l, Ipopt::Number *x_u,
+                         Ipopt::Index, Ipopt::Number *g_l, Ipopt::Number *g_u) {
+        for (size_t i = 0; i < n; ++i) {
+            x_l[i] = xl[i];
+            x_u[i] = xu[i];
+        }
+        for (size_t i = 0; i < m; ++i) {
+            g_l[i] = gl[i];
+            g_u[i] = gu[i];
+        }
+        return true;
+    }
+
+    bool get_starting_point(Ipopt::Index, bool init_x, Ipopt::Number *x_init, bool init_z, Ipopt::Number *z_L,
+                            Ipopt::Number *z_U, Ipopt::Index, bool init_lambda, Ipopt::Number *lambda_init) {
+        if (init_x) {
+            for (size_t i = 0; i < n; ++i) {
+                x_init[i] = x0[i];
+            }
+        }
+        if (init_z) {
+            for (size_t i = 0; i < n; ++i) {
+                z_L[i] = z_l0[i];
+                z_U[i] = z_u0[i];
+            }
+        }
+        if (init_lambda) {
+            for (size_t i = 0; i < m; ++i) {
+                lambda_init[i] = lambda0[i];
+            }
+        }
+        return true;
+    }
+
+    bool eval_f(Ipopt::Index, const Ipopt::Number *x_in, bool new_x, Ipopt::Number &obj_value) {
+        evaluate(x_in, new_x);
+        obj_value = fgv[0];
+        return true;
+    }
+
+    bool eval_grad_f(Ipopt::Index, const Ipopt::Number *x_in, bool new_x, Ipopt::Number *grad_f) {
+        evaluate(x_in, new_x);
+#ifdef MPC_CODEGEN
+        jacobian();
+        for (size_t i = 0; i < n; ++i) {
+            grad_f[i] = 0.0;
+        }
+        for (size_t k = 0; k < grad_k.size(); ++k) {
+            grad_f[jac_col[grad_k[k]]] = fg_jac[grad_k[k]];
+        }
+#else
+        // The sparse drivers leave other Taylor coefficients on the tape, reverse mode needs those of x
+        fun.Forward(0, xv);
+        fg_weight[0] = 1.0;
+        const Dvector grad = fun.Reverse(1, fg_weight);
+        for (size_t i = 0; i < n; ++i) {
+            grad_f[i] = grad[i];
+        }
+#endif
+        return true;
+    }
+
+    bool eval_g(Ipopt::Index, const Ipopt::Number *x_in, bool new_x, Ipopt::Index, Ipopt::Number *g) {
+        evaluate(x_in, new_x);
+        for (size_t i = 0; i < m; ++i) {
+            g[i] = fgv[i + 1];
+        }
+        return true;
+    }
+
+    bool eval_jac_g(Ipopt::Index, const Ipopt::Number *x_in, bool new_x, Ipopt::Index, Ipopt::Index,
+                    Ipopt::Index *iRow, Ipopt::Index *jCol, Ipopt::Number *values) {
+        if (values == NULL) {
+            for (size_t k = 0; k < jac_row.size(); ++k) {
+                iRow[k] = jac_row[k] - 1;
+#ifdef MPC_CODEGEN
+                jCol[k] = jac_col[jac_k[k]];
+#else
+                jCol[k] = jac_col[k];
+#endif
+            }
+            return true;
+        }
+        evaluate(x_in, new_x);
+#ifdef MPC_CODEGEN
+        jacobian();
+        for (size_t k = 0; k < jac_k.size(); ++k) {
+            jac[k] = fg_jac[jac_k[k]];
+        }
+#else
+        fun.SparseJacobianForward(xv, jac_pattern, jac_row, jac_col, jac, jac_work);
+#endif
+        for (size_t k = 0; k < jac.size(); ++k) {
+            values[k] = jac[k];
+        }
+        return true;
+    }
+
+    bool eval_h(Ipopt::Index, const Ipopt::Number *x_in, bool new_x, Ipopt::Number obj_factor, Ipopt::Index,
+                const Ipopt::Number *lambda, bool, Ipopt::Index, Ipopt::Index *iRow, Ipopt::Index *jCol,
+                Ipopt::Number *values) {
+        if (values == NULL) {
+            for (size_t k = 0; k < hes_row.size(); ++k) {
+                iRow[k] = hes_row[k];
+                jCol[k] = hes_col[k];
+            }
+            return true;
+        }
+        evaluate(x_in, new_x);
+        hes_weight[0] = obj_factor;
+        for (size_t i = 0; i < m; ++i) {
+            hes_weight[i + 1] = lambda[i];
+        }
+#ifdef MPC_CODEGEN
+        model->SparseHessian(xv, hes_weight, hes, cg_row, cg_col);
+#else
+        fun.SparseHessian(xv, hes_weight, hes_pattern, hes_row, hes_col, hes, hes_work);
+#endif
+        for (size_t k = 0; k < hes.size(); ++k) {
+            values[k] = hes[k];
+        }
+        return true;
+    }
+
+    void finalize_solution(Ipopt::SolverReturn solver_status, Ipopt::Index, const Ipopt::Number *x_out,
+                           const Ipopt::Number *z_L, const Ipopt::Number *z_U, Ipopt::Index, const Ipopt::Number *,
+                           const Ipopt::Number *lambda_out, Ipopt::Number obj, const Ipopt::IpoptData *ip_data,
+                           Ipopt::IpoptCalculatedQuantities *) {
+        status = solver_status;
+        iterations = ip_data ? ip_data->iter_count() : 0;
+        obj_value = obj;
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = x_out[i];
+            z_l[i] = z_L[i];
+            z_u[i] = z_U[i];
+        }
+        for (size_t i = 0; i < m; ++i) {
+            lambda[i] = lambda_out[i];
+        }
+    }
+
+    // Stops the solve once the deadline passed, Ipopt returns User_Requested_Stop with the iterate it is at
+    bool intermediate_callback(Ipopt::AlgorithmMode, Ipopt::Index, Ipopt::Number, Ipopt::Number, Ipopt::Number,
+                               Ipopt::Number, Ipopt::Number, Ipopt::Number, Ipopt::Number, Ipopt::Number,
+                               Ipopt::Index, const Ipopt::IpoptData *, Ipopt::IpoptCalculatedQuantities *) {
+        if (deadline <= 0.0) {
+            return true;
+        }
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9 < deadline;
+    }
+
+    // Largest violation of gl <= g <= gu at x
+    double infeasibility() {
+        eval_g(n, x.data(), true, m, gv.data());
+        double violation = 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            violation = std::max(violation, std::max(gl[i] - gv[i], gv[i] - gu[i]));
+        }
+        return violation;
+    }
+
+    /*
+     * One real-time iteration from x0 instead of an Ipopt solve: qp solves for
+     * the step on the objective Hessian, which needs no multipliers as the MPC
+     * costs are quadratic, and the constraints linearized at x0. The QP starts
+     * from a zero step and the multipliers in lambda0, z_l0 and z_u0. Leaves
+     * x0 plus the step in x and the QP multipliers in lambda, z_l and z_u.
+     * Returns false if the QP did not converge within its iteration bound, x
+     * then holds its last iterate.
+     */
+    bool sqp_step(SparseQP &qp) {
+        const Ipopt::Index nn = n, mm = m, nnz_jac = jac_row.size(), nnz_hes = hes_row.size();
+        std::vector<Ipopt::Index> rows(std::max(nnz_jac, nnz_hes)), cols(rows.size());
+        Dvector values(rows.size()), g(m), grad(n), no_lambda(m, 0.0);
+        std::vector<Eigen::Triplet<double> > t;
+
+        eval_g(nn, x0.data(), true, mm, g.data());
+        eval_grad_f(nn, x0.data(), false, grad.data());
+
+        // Model constraint rows, then one row per variable bound
+        eval_jac_g(nn, NULL, false, mm, nnz_jac, rows.data(), cols.data(), NULL);
+        eval_jac_g(nn, x0.data(), false, mm, nnz_jac, NULL, NULL, values.data());
+        for (Ipopt::Index k = 0; k < nnz_jac; ++k) {
+            t.push_back(Eigen::Triplet<double>(rows[k], cols[k], values[k]));
+        }
+        for (size_t i = 0; i < n; ++i) {
+            t.push_back(Eigen::Triplet<double>(m + i, i, 1.0));
+        }
+        SparseQP::Matrix C(m + n, n);
+        C.setFromTriplets(t.begin(), t.end());
+
+        t.clear();
+        eval_h(nn, NULL, false, 1.0, mm, NULL, false, nnz_hes, rows.data(), cols.data(), NULL);
+        eval_h(nn, x0.data(), false, 1.0, mm, no_lambda.data(), true, nnz_hes, NULL, NULL, values.data());
+        for (Ipopt::Index k = 0; k < nnz_hes; ++k) {
+            t.push_back(Eigen::Triplet<double>(rows[k], cols[k], values[k]));
+            if (rows[k] != cols[k]) {
+                t.push_back(Eigen::Triplet<double>(cols[k], rows[k], values[k]));
+            }
+        }
+        SparseQP::Matrix P(n, n);
+        P.setFromTriplets(t.begin(), t.end());
+
+        SparseQP::Vector q(n), l(m + n), u(m + n);
+        for (size_t i = 0; i < n; ++i) {
+            q[i] = grad[i];
+            l[m + i] = xl[i] - x0[i];
+            u[m + i] = xu[i] - x0[i];
+        }
+        for (size_t i = 0; i < m; ++i) {
+            l[i] = gl[i] - g[i];
+            u[i] = gu[i] - g[i];
+        }
+
+        qp.x.setZero(n);
+        qp.y.resize(m + n);
+        for (size_t i = 0; i < m; ++i) {
+            qp.y[i] = lambda0[i];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            qp.y[m + i] = z_u0[i] - z_l0[i];
+        }
+        const bool converged = qp.solve(P, q, C, l, u);
+
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = x0[i] + qp.x[i];
+            z_l[i] = std::max(0.0, -qp.y[m + i]);
+            z_u[i] = std::max(0.0, qp.y[m + i]);
+        }
+        for (size_t i = 0; i < m; ++i) {
+            lambda[i] = qp.y[i];
+        }
+        eval_f(nn, x.data(), true, obj_value);
+        status = converged ? Ipopt::SUCCESS : Ipopt::MAXITER_EXCEEDED;
+        iterations = qp.iterations;
+        return converged;
+    }
+
+private:
+    // Zero order forward sweep, its fg values serve eval_f and eval_g until x changes
+    void evaluate(const Ipopt::Number *x_in, bool new_x) {
+        if (!new_x) {
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            xv[i] = x_in[i];
+        }
+#ifdef MPC_CODEGEN
+        model->ForwardZero(xv, fgv);
+        jac_current = false;
+#else
+        fgv = fun.Forward(0, xv);
+#endif
+        if (track_best) {
+            keep_best();
+        }
+    }
+
+    // xv into best_x if it is feasible and cheaper than what best_x holds
+    void keep_best() {
+        if (best_valid && fgv[0] >= best_obj) {
+            return;
+        }
+        for (size_t i = 0; i < m; ++i) {
+            if (fgv[i + 1] < gl[i] - best_tol || fgv[i + 1] > gu[i] + best_tol) {
+                return;
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (xv[i] < xl[i] - best_tol || xv[i] > xu[i] + best_tol) {
+                return;
+            }
+        }
+        best_x.assign(xv.begin(), xv.end());
+        best_obj = fgv[0];
+        best_valid = true;
+    }
+
+    /*
+     * Jacobian pattern of fg, then the Hessian pattern of any weighted sum of
+     * its components. Lists the Jacobian entries of rows first_row to m and
+     * the lower triangle of the Hessian.
+     */
+    template <class Base>
+    void sparsity(CppAD::ADFun<Base> &f, size_t first_row) {
+        std::vector<std::set<size_t> > r(n), s(1);
+        for (size_t i = 0; i < n; ++i) {
+            r[i].insert(i);
+        }
+        jac_pattern = f.ForSparseJac(n, r);
+        for (size_t i = 0; i <= m; ++i) {
+            s[0].insert(i);
+        }
+        hes_pattern = f.RevSparseHes(n, s);
+
+        for (size_t i = first_row; i <= m; ++i) {
+            for (std::set<size_t>::const_iterator j = jac_pattern[i].begin(); j != jac_pattern[i].end(); ++j) {
+                jac_row.push_back(i);
+                jac_col.push_back(*j);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            for (std::set<size_t>::const_iterator j = hes_pattern[i].begin(); j != hes_pattern[i].end() && *j <= i; ++j) {
+                hes_row.push_back(i);
+                hes_col.push_back(*j);
+            }
+        }
+    }
+
+    size_t n, m;
+    std::vector<std::set<size_t> > jac_pattern, hes_pattern;
+    std::vector<size_t> jac_row, jac_col, hes_row, hes_col;
+    Dvector xv, fgv, jac, hes, hes_weight;
+    // Constraint values of infeasibility, and the weights of fg whose reverse sweep is the objective gradient
+    Dvector gv, fg_weight;
+#ifdef MPC_CODEGEN
+    // Generated library missing or older than the object FG_eval is built into, whose build may have changed it
+    static bool stale(const std::string &file) {
+        Dl_info info;
+        const char *built = dladdr(reinterpret_cast<void *>(&TapedNLP::stale), &info) && info.dli_fname
+                                ? info.dli_fname
+                                : "/proc/self/exe";
+        struct stat lib_stat, built_stat;
+        return stat(file.c_str(), &lib_stat) != 0 || stat(built, &built_stat) != 0 ||
+               lib_stat.st_mtime < built_stat.st_mtime;
+    }
+
+    // Tapes FG_eval on CG<double> and compiles the C source of its model into <name>_fg
+    template <class FG_eval>
+    void generate(FG_eval &fg_eval, const std::string &name) {
+        typedef CppAD::cg::CG<double> CGdouble;
+        std::vector<CppAD::AD<CGdouble> > avars(n, CppAD::AD<CGdouble>(0.0)), afg(m + 1);
+        CppAD::Independent(avars);
+        fg_eval(afg, avars);
+        CppAD::ADFun<CGdouble> f(avars, afg);
+        f.optimize();
+        sparsity(f, 0);
+
+        CppAD::cg::ModelCSourceGen<double> source(f, name);
+        source.setCreateForwardZero(true);
+        source.setCreateSparseJacobian(true);
+        source.setCustomSparseJacobianElements(jac_row, jac_col);
+        source.setCreateSparseHessian(true);
+        source.setCustomSparseHessianElements(hes_row, hes_col);
+        CppAD::cg::ModelLibraryCSourceGen<double> library(source);
+        CppAD::cg::DynamicModelLibraryProcessor<double> processor(library, name + "_fg");
+        CppAD::cg::GccCompiler<double> compiler;
+        processor.createDynamicLibrary(compiler, false);
+
+        // The loaded model reports the same patterns
+        jac_row.clear();
+        jac_col.clear();
+        hes_row.clear();
+        hes_col.clear();
+    }
+
+    // Sparse Jacobian of fg at xv, objective row included, once per x
+    void jacobian() {
+        if (!jac_current) {
+            model->SparseJacobian(xv, fg_jac, cg_row, cg_col);
+            jac_current = true;
+        }
+    }
+
+    std::unique_ptr<CppAD::cg::DynamicLib<double> > lib;
+    std::unique_ptr<CppAD::cg::GenericModel<double> > model;
+    std::vector<size_t> grad_k, jac_k, cg_row, cg_col;
+    Dvector fg_jac;
+    bool jac_current = false;
+#else
+    CppAD::ADFun<double> fun;
+    CppAD::sparse_jacobian_work jac_work;
+    CppAD::sparse_hessian_work hes_work;
+#endif
+};
+
+#endif //CYPHY_CONTROL_TAPED_NLP_H
@@ -0,0 +1,94 @@
+#include "cyphy_control/TrajectoryRecorder.h"
+#include <ros/console.h>
+#include <ros/time.h>
+#include <zlib.h>
+#include <chrono>
+#include <sstream>
+
+#define BLOCK_SAMPLES 512
+#define WRITE_PERIOD_MS 100
+#define GZ_BUFFER_SIZE (1 << 17)
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string &path, const std::string &source,
+                                       const std::vector<std::string> &fields, bool compress)
+    : file(nullptr), n_fields(fields.size()), running(false) {
+    if (n_fields > TRAJECTORY_MAX_VALUES) {
+        ROS_ERROR("Trajectory %s: %zu fields, at most %d", path.c_str(), n_fields, TRAJECTORY_MAX_VALUES);
+        return;
+    }
+    // Transparent (T) writes the same stream uncompressed
+    gzFile gz = gzopen(path.c_str(), compress ? "wb6" : "wbT");
+    if (!gz) {
+        ROS_WARN("Cannot create the trajectory %s", path.c_str());
+        return;
+    }
+    gzbuffer(gz, GZ_BUFFER_SIZE);
+
+    std::ostringstream header;
+    header << "CYTRJ1\n";
+    header << "source: " << source << "\n";
+    header << "start: " << ros::Time::now().toNSec() << "\n";
+    header << "fields: stamp";
+    for (const std::string &field : fields) {
+        header << "," << field;
+    }
+    header << "\n\n";
+    const std::string text = header.str();
+    gzwrite(gz, text.data(), text.size());
+
+    file = gz;
+    running = true;
+    writer = std::thread(&TrajectoryRecorder::run, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    if (!file) {
+        return;
+    }
+    running = false;
+    writer.join();
+    gzclose(static_cast<gzFile>(file));
+    if (queue.dropCount()) {
+        ROS_WARN("Trajectory: %u samples dropped", queue.dropCount());
+    }
+}
+
+bool TrajectoryRecorder::ok() const {
+    return file != nullptr;
+}
+
+uint32_t TrajectoryRecorder::dropped() const {
+    return queue.dropCount();
+}
+
+void TrajectoryRecorder::run() {
+    std::vector<TrajectorySample> block(BLOCK_SAMPLES);
+    uint32_t n = 0;
+    bool stopping = false;
+    while (!stopping) {
+        stopping = !running;
+        while (queue.pop(block[n])) {
+            if (++n == BLOCK_SAMPLES) {
+                write(block, n);
+                n = 0;
+            }
+        }
+        // A partial block at most every period, so a crash loses little
+        if (n > 0) {
+            write(block, n);
+            n = 0;
+        }
+        if (!stopping) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(WRITE_PERIOD_MS));
+        }
+    }
+}
+
+void TrajectoryRecorder::write(const std::vector<TrajectorySample> &block, uint32_t n) {
+    gzFile gz = static_cast<gzFile>(file);
+    gzwrite(gz, &n, sizeof(n));
+    for (uint32_t i = 0; i < n; ++i) {
+        gzwrite(gz, &block[i].stamp, sizeof(block[i].stamp));
+        gzwrite(gz, block[i].values, n_fields * sizeof(double));
+    }
+}
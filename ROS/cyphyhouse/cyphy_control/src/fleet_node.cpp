@@ -0,0 +1,225 @@
+//
+// fleet_node: the latest position and velocity of every robot of the fleet in
+// one place and, every tick, the nearest robots around each one, so a robot or
+// its planner subscribes to its own neighbour set instead of to every other
+// robot, and predicts where they go from their velocities. The trajectories
+// the robots predict for themselves are relayed to their neighbours the same
+// way, so each MPC avoids the plans of the few robots around it.
+//
+
+#include "cyphy_control/SpatialHash.h"
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/PolygonStamped.h>
+#include <ros/ros.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define FLEET_RATE 20.0         // Hz, default
+#define NEIGHBOUR_FIELDS 7      // index, x, y, z, distance, vx, vy
+#define PREDICTION_POINTS 10    // points of a relayed trajectory
+#define PREDICTION_FIELDS (2 + 3 * PREDICTION_POINTS)   // index, age, then x, y, t of each point
+
+// Topic of robot, pattern with every "{robot}" replaced by its name
+static std::string robot_topic(std::string pattern, const std::string &robot) {
+    const std::string key = "{robot}";
+    for (size_t at = pattern.find(key); at != std::string::npos; at = pattern.find(key, at + robot.size())) {
+        pattern.replace(at, key.size(), robot);
+    }
+    return pattern;
+}
+
+/*
+ * Latest positions by robot, kept as arrays of the coordinates, and the
+ * spatial hash of the live ones rebuilt every tick. The callbacks and the
+ * tick run on the one spinner thread, nothing is locked.
+ */
+class Fleet {
+public:
+    Fleet(ros::NodeHandle &n, const std::vector<std::string> &names) : robots(names), hash(1.0) {
+        double cell_size, rate;
+        std::string position_topic, neighbours_topic, prediction_topic, predictions_topic;
+        n.param<double>("cell_size", cell_size, 1.0);   // m, about neighbour_radius
+        n.param<double>("neighbour_radius", radius, 2.0);   // m, 0 for any distance
+        n.param<int>("max_neighbours", max_neighbours, 8);
+        n.param<double>("stale_timeout", stale_timeout, 0.5);   // s, a robot without a position for longer is left out
+        n.param<double>("velocity_smoothing", smoothing, 0.5);  // Weight of the newest difference of positions, 0..1
+        n.param<double>("rate", rate, FLEET_RATE);
+        n.param<std::string>("position_topic", position_topic, "/{robot}/decaPos");
+        n.param<std::string>("neighbours_topic", neighbours_topic, "/{robot}/neighbours");
+        n.param<std::string>("prediction_topic", prediction_topic, "/{robot}/prediction");
+        n.param<std::string>("neighbour_predictions_topic", predictions_topic, "/{robot}/neighbour_predictions");
+        n.param<double>("prediction_timeout", prediction_timeout, 0.5);  // s, an older trajectory is not relayed
+        hash = SpatialHash(cell_size);
+        max_neighbours = std::max(max_neighbours, 0);
+
+        const size_t count = robots.size();
+        x.assign(count, 0);
+        y.assign(count, 0);
+        z.assign(count, 0);
+        vx.assign(count, 0);
+        vy.assign(count, 0);
+        stamp.assign(count, ros::Time());
+        predicted.assign(count, ros::Time());
+        trajectory.assign(count * 3 * PREDICTION_POINTS, 0.0f);
+        for (size_t i = 0; i < count; ++i) {
+            subs.push_back(n.subscribe<geometry_msgs::Point>(robot_topic(position_topic, robots[i]), 1,
+                                                            [this, i](const geometry_msgs::PointConstPtr &p) {
+                                                                position(i, *p);
+                                                            }));
+            pubs.push_back(n.advertise<std_msgs::Float32MultiArray>(robot_topic(neighbours_topic, robots[i]), 1));
+            subs.push_back(n.subscribe<geometry_msgs::PolygonStamped>(
+                robot_topic(prediction_topic, robots[i]), 1,
+                [this, i](const geometry_msgs::PolygonStampedConstPtr &p) { prediction(i, *p); }));
+            prediction_pubs.push_back(
+                n.advertise<std_msgs::Float32MultiArray>(robot_topic(predictions_topic, robots[i]), 1));
+        }
+        timer = n.createTimer(ros::Duration(1.0 / rate), &Fleet::tick, this);
+    }
+
+private:
+    // Position of robot i, its velocity smoothed from the differences of consecutive positions
+    void position(size_t i, const geometry_msgs::Point &p) {
+        const ros::Time now = ros::Time::now();
+        const double dt = stamp[i].isZero() ? 0 : (now - stamp[i]).toSec();
+        if (dt > 0 && dt <= stale_timeout) {
+            vx[i] += smoothing * ((p.x - x[i]) / dt - vx[i]);
+            vy[i] += smoothing * ((p.y - y[i]) / dt - vy[i]);
+        } else {
+            vx[i] = vy[i] = 0;
+        }
+        x[i] = p.x;
+        y[i] = p.y;
+        z[i] = p.z;
+        stamp[i] = now;
+    }
+
+    /*
+     * Trajectory robot i predicted for itself, points of x, y and the time
+     * after the stamp in z. Kept at PREDICTION_POINTS, a shorter one holding
+     * its last point, so every relayed row has the same size.
+     */
+    void prediction(size_t i, const geometry_msgs::PolygonStamped &p) {
+        if (p.polygon.points.empty()) {
+            return;
+        }
+        float *out = &trajectory[i * 3 * PREDICTION_POINTS];
+        for (size_t k = 0; k < PREDICTION_POINTS; ++k) {
+            const geometry_msgs::Point32 &point = p.polygon.points[std::min(k, p.polygon.points.size() - 1)];
+            out[3 * k] = point.x;
+            out[3 * k + 1] = point.y;
+            out[3 * k + 2] = point.z;
+        }
+        predicted[i] = p.header.stamp;
+    }
+
+    /*
+     * Publishes to every live robot the max_neighbours nearest others within
+     * neighbour_radius, nearest first, one row of index into ~robots, x, y, z,
+     * distance, vx and vy each, and the recent trajectories of those of them
+     * that share one, one row of index, age [s] and the x, y, t points each.
+     */
+    void tick(const ros::TimerEvent &) {
+        const ros::Time now = ros::Time::now();
+        live.clear();
+        lx.clear();
+        ly.clear();
+        lz.clear();
+        for (size_t i = 0; i < robots.size(); ++i) {
+            if (!stamp[i].isZero() && (now - stamp[i]).toSec() <= stale_timeout) {
+                live.push_back(static_cast<uint32_t>(i));
+                lx.push_back(x[i]);
+                ly.push_back(y[i]);
+                lz.push_back(z[i]);
+            }
+        }
+        hash.build(lx.data(), ly.data(), lz.data(), live.size());
+
+        for (size_t j = 0; j < live.size(); ++j) {
+            hash.nearest(lx[j], ly[j], lz[j], max_neighbours, radius, found, static_cast<uint32_t>(j));
+
+            std_msgs::Float32MultiArray msg;
+            msg.layout.dim.resize(2);
+            msg.layout.dim[0].label = "neighbour";
+            msg.layout.dim[0].size = found.size();
+            msg.layout.dim[0].stride = found.size() * NEIGHBOUR_FIELDS;
+            msg.layout.dim[1].label = "index,x,y,z,distance,vx,vy";
+            msg.layout.dim[1].size = NEIGHBOUR_FIELDS;
+            msg.layout.dim[1].stride = NEIGHBOUR_FIELDS;
+            msg.layout.data_offset = 0;
+            msg.data.reserve(found.size() * NEIGHBOUR_FIELDS);
+            for (size_t k = 0; k < found.size(); ++k) {
+                const uint32_t other = found[k].first;
+                msg.data.push_back(live[other]);
+                msg.data.push_back(lx[other]);
+                msg.data.push_back(ly[other]);
+                msg.data.push_back(lz[other]);
+                msg.data.push_back(found[k].second);
+                msg.data.push_back(vx[live[other]]);
+                msg.data.push_back(vy[live[other]]);
+            }
+            pubs[live[j]].publish(msg);
+
+            std_msgs::Float32MultiArray shared;
+            shared.layout.dim.resize(2);
+            shared.layout.dim[0].label = "neighbour";
+            shared.layout.dim[1].label = "index,age,x,y,t...";
+            shared.layout.dim[1].size = PREDICTION_FIELDS;
+            shared.layout.dim[1].stride = PREDICTION_FIELDS;
+            shared.layout.data_offset = 0;
+            for (size_t k = 0; k < found.size(); ++k) {
+                const uint32_t other = live[found[k].first];
+                const double age = (now - predicted[other]).toSec();
+                if (predicted[other].isZero() || age > prediction_timeout) {
+                    continue;
+                }
+                const float *points = &trajectory[other * 3 * PREDICTION_POINTS];
+                shared.data.push_back(other);
+                shared.data.push_back(age);
+                shared.data.insert(shared.data.end(), points, points + 3 * PREDICTION_POINTS);
+            }
+            shared.layout.dim[0].size = shared.data.size() / PREDICTION_FIELDS;
+            shared.layout.dim[0].stride = shared.data.size();
+            prediction_pubs[live[j]].publish(shared);
+        }
+    }
+
+    std::vector<std::string> robots;
+    double radius, stale_timeout, smoothing, prediction_timeout;
+    int max_neighbours;
+
+    // Latest position and velocity of robot i and when the position came
+    std::vector<double> x, y, z, vx, vy;
+    std::vector<ros::Time> stamp;
+    // Latest trajectory of robot i, PREDICTION_POINTS of x, y, t from its start, and when it starts
+    std::vector<float> trajectory;
+    std::vector<ros::Time> predicted;
+
+    // The robots with a fresh position this tick, as indices into robots and their coordinates
+    std::vector<uint32_t> live;
+    std::vector<double> lx, ly, lz;
+    SpatialHash hash;
+    std::vector<SpatialHash::Neighbour> found;
+
+    std::vector<ros::Subscriber> subs;
+    std::vector<ros::Publisher> pubs, prediction_pubs;
+    ros::Timer timer;
+};
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "fleet");
+    ros::NodeHandle n("~");
+
+    std::vector<std::string> robots;
+    n.param("robots", robots, std::vector<std::string>());
+    if (robots.empty()) {
+        ROS_ERROR("No ~robots, nothing to track");
+        return 1;
+    }
+
+    Fleet fleet(n, robots);
+    ROS_INFO("Tracking %zu robots", robots.size());
+    ros::spin();
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*************************************************
+ *
+ *  Health of the anchors of the current cell as one tag sees them, so a
+ *  dead or moved anchor can be taken out of the filter. One fixed entry per
+ *  anchor of the TDMA frame keeps
+ *      - the receive ratio: slots of the anchor (pairs with it as An) per
+ *        window, relative to the best heard anchor
+ *      - the mean normalized innovation squared (NIS) of its pairs, 1 for a
+ *        consistent filter. A pair counts for both of its anchors, a bad
+ *        anchor spoils all of its pairs and its neighbours only some
+ *      - the bias: mean innovation of its pairs in m, signed so that a
+ *        range that is too long is positive (+error as An, -error as Ar)
+ *  All statistics are exponentially weighted per pair. Once per window the
+ *  worst anchor beyond a limit is masked, at most one per window and never
+ *  below ANCHOR_MIN_HEALTHY anchors, a silent anchor always. The pairs of
+ *  a masked anchor are not applied but their innovations are still taken,
+ *  for the masked anchor only, and it is readmitted after
+ *  ANCHOR_READMIT_WINDOWS windows within the readmission limits.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _ANCHOR_HEALTH_h
+#define _ANCHOR_HEALTH_h
+
+#include <cstdint>
+
+#include "tdoa.h"
+
+#define ANCHOR_HEALTH_WINDOW    1.0     // s, between two evaluations
+#define ANCHOR_HEALTH_RATE      0.05f   // Weight of a new pair in the innovation statistics
+#define ANCHOR_MASK_RECEIVE     0.5f    // Receive ratio below which an anchor is silent
+#define ANCHOR_READMIT_RECEIVE  0.8f
+#define ANCHOR_MASK_NIS         9.0f    // Mean NIS that masks, a consistent filter has 1
+#define ANCHOR_READMIT_NIS      3.0f
+#define ANCHOR_MASK_BIAS        0.3f    // m
+#define ANCHOR_READMIT_BIAS     0.1f    // m
+#define ANCHOR_READMIT_WINDOWS  3
+#define ANCHOR_MIN_HEALTHY      4       // Reference plus 3, enough for a position
+
+typedef enum
+{
+    ANCHOR_HEALTHY = 0,
+    ANCHOR_MASKED,
+} anchor_state_t;
+
+// Why an anchor was masked
+typedef enum
+{
+    ANCHOR_REASON_NONE = 0,
+    ANCHOR_REASON_SILENT,
+    ANCHOR_REASON_INNOVATION,
+    ANCHOR_REASON_BIAS,
+} anchor_reason_t;
+
+typedef struct anchor_health_s
+{
+    anchor_state_t state;
+    anchor_reason_t reason;
+    uint32_t received;          // Slots of the current window
+    float receiveRatio;         // Of the last window
+    float nis;
+    float bias;                 // m
+    uint32_t goodWindows;       // Consecutive windows within the readmission limits while masked
+    uint32_t masks;             // Times masked since reset
+}anchor_health_t;
+
+class AnchorHealth
+{
+public:
+
+    AnchorHealth();
+
+    // Forgets everything, e.g. for the anchors of another cell
+    void reset(int anchors);
+
+    /*
+     * A pair received with innovation error and variance HPHR, before it is
+     * applied. Returns false if one of its anchors is masked.
+     */
+    bool addMeasurement(uint8_t Ar, uint8_t An, float error, float HPHR);
+
+    bool isMasked(uint8_t anchor) const;
+
+    // Closes the window once ANCHOR_HEALTH_WINDOW passed since it opened at t, true if an anchor changed state
+    bool evaluate(double t);
+
+    int getAnchorCount() const;
+    const anchor_health_t &get(int anchor) const;
+
+private:
+
+    void mask(int anchor, anchor_reason_t reason);
+    anchor_reason_t fault(const anchor_health_t &a) const;
+    bool recovered(const anchor_health_t &a) const;
+
+    anchor_health_t table[MAX_NR_ANCHORS];
+    int count;
+    double windowStart;
+};
+
+#endif
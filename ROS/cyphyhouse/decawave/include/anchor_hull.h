@@ -0,0 +1,160 @@
+/*************************************************
+ *
+ *  Convex hull of an anchor layout as a table of half-spaces, for the
+ *  containment test the filter runs on every predict step (TDOAFilter::
+ *  setHullMode). TDOA only constrains the position well inside the hull of
+ *  the anchors, outside of it the pairs become nearly parallel.
+ *
+ *  build takes the anchors once, when they are loaded or change: every
+ *  triple of anchors whose plane has all others on one side is a face,
+ *  faces of the same plane are kept once. Anchors all in one plane, e.g.
+ *  all on the ceiling, have no volume, their hull is the prism through the
+ *  polygon they span. The test is then a product of the position with the
+ *  outward normals and the largest excess over the offsets, without a branch:
+ *      distance(x) = max_f (n_f . x - d_f)
+ *  which is below 0 inside, 0 on the hull and the distance to the face
+ *  planes outside (exact on the faces, a lower bound past edges and
+ *  corners). Unused rows have n = 0 and d = FLT_MAX.
+ *
+ *  Header-only, tdoa.cpp uses it and the offline tools link tdoa.cpp alone.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _ANCHOR_HULL_h
+#define _ANCHOR_HULL_h
+
+#include <cmath>
+#include <cfloat>
+#include <Eigen/Dense>
+
+#define HULL_MAX_FACES      32      // 2n-4 triangles of 16 anchors in general position, fewer planes in practice
+#define HULL_EPSILON        1e-3f   // m, anchors this close to a plane lie on it
+
+class AnchorHull
+{
+public:
+
+    typedef Eigen::Array<float, HULL_MAX_FACES, 1> FaceArray;
+
+    AnchorHull() { clear(); }
+
+    void clear()
+    {
+        nx.setZero();
+        ny.setZero();
+        nz.setZero();
+        d.setConstant(FLT_MAX);
+        faces = 0;
+    }
+
+    // Hull of the first count rows of anchors (x, y, z columns). Empty below three anchors off one line
+    template <typename Points>
+    void build(const Points &anchors, int count)
+    {
+        clear();
+        Eigen::Vector3f flat = Eigen::Vector3f::Zero();
+        for (int i = 0; i < count; i++)
+        {
+            const Eigen::Vector3f a = anchors.row(i).template cast<float>().transpose();
+            for (int j = i + 1; j < count; j++)
+            {
+                const Eigen::Vector3f b = anchors.row(j).template cast<float>().transpose();
+                for (int k = j + 1; k < count; k++)
+                {
+                    const Eigen::Vector3f c = anchors.row(k).template cast<float>().transpose();
+                    const Eigen::Vector3f n = (b - a).cross(c - a);
+                    if (n.norm() < HULL_EPSILON)
+                    {
+                        continue;
+                    }
+                    if (!addFace(anchors, count, n.normalized(), a))
+                    {
+                        flat = n.normalized();
+                    }
+                }
+            }
+        }
+        if ((faces > 0) || (flat.squaredNorm() == 0))
+        {
+            return;
+        }
+
+        // All anchors in the plane of normal flat: the sides of their polygon, across the plane
+        for (int i = 0; i < count; i++)
+        {
+            const Eigen::Vector3f a = anchors.row(i).template cast<float>().transpose();
+            for (int j = i + 1; j < count; j++)
+            {
+                const Eigen::Vector3f b = anchors.row(j).template cast<float>().transpose();
+                const Eigen::Vector3f n = (b - a).cross(flat);
+                if (n.norm() >= HULL_EPSILON)
+                {
+                    addFace(anchors, count, n.normalized(), a);
+                }
+            }
+        }
+    }
+
+    // m, below 0 inside. -FLT_MAX without a hull, everything is inside then
+    float distance(float x, float y, float z) const
+    {
+        return (nx*x + ny*y + nz*z - d).maxCoeff();
+    }
+
+    int getFaces() const { return faces; }
+
+private:
+
+    // Face of unit normal n through p if all anchors are on one side of it, false if they all lie on the plane
+    template <typename Points>
+    bool addFace(const Points &anchors, int count, Eigen::Vector3f n, const Eigen::Vector3f &p)
+    {
+        bool above = false, below = false;
+        float offset = n.dot(p);
+        for (int m = 0; m < count; m++)
+        {
+            const float s = n.dot(anchors.row(m).template cast<float>().transpose()) - offset;
+            above = above || (s > HULL_EPSILON);
+            below = below || (s < -HULL_EPSILON);
+        }
+        if (!above && !below)
+        {
+            return false;
+        }
+        if (above && below)
+        {
+            return true;
+        }
+        if (above)
+        {
+            n = -n;
+            offset = -offset;
+        }
+        for (int f = 0; f < faces; f++)
+        {
+            if ((std::fabs(nx(f) - n.x()) + std::fabs(ny(f) - n.y()) + std::fabs(nz(f) - n.z()) < HULL_EPSILON)
+                && (std::fabs(d(f) - offset) < HULL_EPSILON))
+            {
+                return true;
+            }
+        }
+        if (faces < HULL_MAX_FACES)
+        {
+            nx(faces) = n.x();
+            ny(faces) = n.y();
+            nz(faces) = n.z();
+            d(faces) = offset;
+            faces++;
+        }
+        return true;
+    }
+
+    // Outward unit normals and offsets, structure of arrays for the test
+    FaceArray nx, ny, nz, d;
+    int faces;
+};
+
+#endif
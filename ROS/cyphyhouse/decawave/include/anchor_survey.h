@@ -0,0 +1,106 @@
+/*************************************************
+ *
+ *  Anchor positions from the times of flight the anchors measure between
+ *  each other and broadcast in their range packets. The tag forwards them
+ *  in ranges frames (common/tdoa_protocol.h), addRanges averages them per
+ *  pair and solve turns the averages into coordinates:
+ *      - classical MDS of the distance matrix for the start, pairs that were
+ *        never measured are filled in with their shortest path
+ *      - Levenberg-Marquardt on the measured pairs, each weighted by the
+ *        standard error of its mean, plus the known points as priors
+ *      - the frame is set by the known points if a cell has at least 3,
+ *        otherwise by the current layout of the cell, otherwise anchor 0 is
+ *        the origin, anchor 1 on +x and anchor 2 in the xy plane at y > 0
+ *  Every later solve starts from the previous solution of the cell.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _ANCHOR_SURVEY_h
+#define _ANCHOR_SURVEY_h
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_protocol.h"
+
+#define SURVEY_MIN_SAMPLES      10      // Ranges of a pair before it is used
+#define SURVEY_OUTLIER_GATE     0.3     // m, ranges this far from the mean of their pair are dropped once it is used
+#define SURVEY_MIN_RANGE_ERROR  0.02    // m, floor of the standard error of a pair, the bias of the ToF does not average out
+#define SURVEY_KNOWN_STD_DEV    0.01    // m, prior of the known points
+#define SURVEY_ITERATIONS       100
+#define SURVEY_MIN_ANCHORS      3
+
+// Solution of one cell, anchors is empty if the cell could not be solved
+struct SurveyCell
+{
+    int cell;
+    std::vector<vec3d_t> anchors;
+    int pairs;                  // Pairs with enough ranges
+    double rms;                 // m, residual of the pairs
+    double max_residual;        // m
+    std::string problem;        // Why the cell was not solved
+};
+
+/*
+ * Any thread may add ranges, solve is meant for one thread at a time. Known
+ * points and hints are by cell-qualified anchor ID (TDOA_CELL_ID).
+ */
+class AnchorSurvey
+{
+public:
+
+    AnchorSurvey();
+
+    void setKnown(const std::map<int, vec3d_t> &points);
+    // Current layout per cell, used for the frame of cells with fewer than 3 known points
+    void setHint(const std::vector<std::vector<vec3d_t> > &layout);
+
+    void addRanges(const tdoa_ranges_t &ranges);
+    uint32_t getRanges() const;
+    uint32_t getRejected() const;
+
+    // Every cell with ranges, in cell order
+    std::vector<SurveyCell> solve();
+
+private:
+
+    struct PairStats
+    {
+        uint32_t count;
+        double mean;            // m
+        double m2;              // Sum of the squared deviations from mean
+    };
+
+    SurveyCell solveCell(int cell, const std::map<std::pair<int, int>, PairStats> &pairs);
+    void refine(Eigen::Matrix3Xd &X, const std::vector<Eigen::Vector4d> &edges, int cell) const;
+    bool alignFrame(Eigen::Matrix3Xd &X, int cell) const;
+
+    mutable std::mutex mutex;
+    std::map<std::pair<int, int>, PairStats> pairs;     // Cell-qualified IDs, lower first
+    uint32_t ranges;
+    uint32_t rejected;
+
+    std::map<int, vec3d_t> known;
+    std::vector<std::vector<vec3d_t> > hint;
+    std::map<int, Eigen::Matrix3Xd> previous;
+};
+
+/*
+ * Known points, "k: x, y, z" for anchor k of the cell. A line "cell N"
+ * starts the points of cell N as in anchorPos.txt.
+ */
+bool loadKnownAnchors(const std::string &path, std::map<int, vec3d_t> &points);
+
+// layout per cell in the anchorPos.txt format, "cell N" lines included
+bool readAnchorFile(const std::string &path, std::vector<std::vector<vec3d_t> > &layout);
+bool writeAnchorFile(const std::string &path, const std::vector<std::vector<vec3d_t> > &layout);
+
+#endif
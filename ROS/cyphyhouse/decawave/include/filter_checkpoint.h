@@ -0,0 +1,99 @@
+/*************************************************
+ *
+ *  Checkpoints of the tag filters in a small memory mapped file, so a
+ *  restarted decaPos_node resumes from the last estimate instead of
+ *  converging again from initial_covariance.
+ *
+ *  One slot per tag, matched by its port. A slot holds state, covariance
+ *  and time of validity of the filter, in the frame of the cell the tag was
+ *  in, with a hash of the anchors of that cell. The worker of the tag
+ *  rewrites its slot every checkpoint period; a store is a few hundred bytes
+ *  into the mapping, the kernel writes the pages back on its own and keeps
+ *  them across a crash of the node. The sequence of a slot is odd while it
+ *  is written, a slot the node died in the middle of is not taken.
+ *
+ *  A slot is taken on startup if it is younger than the maximum age and the
+ *  anchors of its cell did not change. The filter predicts from the time of
+ *  the slot, so the covariance grows with the time the node was down.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FILTER_CHECKPOINT_h
+#define _FILTER_CHECKPOINT_h
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
+
+#include "tdoa.h"
+
+#define FILTER_CHECKPOINT_MAGIC     0x4b504346  // "FCPK"
+#define FILTER_CHECKPOINT_VERSION   1
+#define FILTER_CHECKPOINT_SLOTS     16          // Tags per file
+#define FILTER_CHECKPOINT_PERIOD    0.1         // s between two checkpoints of a tag, default
+#define FILTER_CHECKPOINT_MAX_AGE   5.0         // s, older checkpoints are not resumed from, default
+
+// Estimate of one tag as the worker last stored it
+typedef struct filter_checkpoint_s
+{
+    double   time;                                  // s, time of validity of state and covariance
+    uint32_t layoutHash;                            // checkpointLayoutHash of the anchors of cell
+    int32_t  cell;
+    float    state[STATE_DIM];                      // Relative to the origin of the cell
+    float    covariance[STATE_DIM * STATE_DIM];     // Row major
+}filter_checkpoint_t;
+
+typedef struct filter_checkpoint_slot_s
+{
+    std::atomic<uint32_t> seq;      // Odd while the slot is written
+    char port[64];                  // Tag the slot belongs to, empty for a free slot
+    filter_checkpoint_t checkpoint;
+}__attribute__((aligned(64))) filter_checkpoint_slot_t;
+
+typedef struct filter_checkpoint_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t slotSize;
+}__attribute__((aligned(64))) filter_checkpoint_header_t;
+
+// FNV-1a of the anchor positions of a cell, changes with any anchor of it
+uint32_t checkpointLayoutHash(const vec3d_t *anchors, size_t count);
+
+class FilterCheckpoint
+{
+public:
+
+    FilterCheckpoint();
+    ~FilterCheckpoint();
+
+    // Maps path, created with free slots if missing or of another layout
+    bool open(const std::string &path, std::string &error);
+    bool isOpen() const { return header != NULL; }
+    void close();
+
+    // Slot of port, a free one if it has none yet. -1 once all slots are taken
+    int slotOf(const std::string &port);
+
+    // Stores the checkpoint of a slot, one writer per slot
+    void save(int slot, const filter_checkpoint_t &checkpoint);
+
+    // Last complete checkpoint of a slot, false if it has none
+    bool load(int slot, filter_checkpoint_t &checkpoint) const;
+
+private:
+
+    FilterCheckpoint(const FilterCheckpoint &) = delete;
+    FilterCheckpoint &operator=(const FilterCheckpoint &) = delete;
+
+    filter_checkpoint_header_t *header;
+    filter_checkpoint_slot_t *slots;
+    size_t mappingSize;
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*************************************************
+ *
+ *  Consistency of the filter of one tag from the normalized innovation
+ *  squared (NIS) error^2/(HPH'+R) of its pairs, which the update computes
+ *  anyway. For a consistent filter each NIS is chi-square with one degree
+ *  of freedom, mean 1. Fixed accumulators, nothing allocated:
+ *      - the mean over a sliding window of the last CONSISTENCY_WINDOW
+ *        innovations of the tag, a ring with its running sum
+ *      - the sum and count of every anchor pair over the current period,
+ *        cleared by each evaluation, the worst pair of the last period kept
+ *  A rejected measurement counts as on the gate. Once per period the
+ *  sliding mean is judged: above the upper bound of a consistent mean the
+ *  filter is suspect, above the limit for lostPeriods periods in a row it
+ *  has lost the tag and must be initialized again.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FILTER_CONSISTENCY_h
+#define _FILTER_CONSISTENCY_h
+
+#include <cstdint>
+
+#include "tdoa.h"
+
+#define CONSISTENCY_WINDOW          64      // Innovations of the sliding mean
+#define CONSISTENCY_MIN_SAMPLES     16      // Innovations before the mean is judged
+#define CONSISTENCY_PERIOD          1.0     // s, between two evaluations
+#define CONSISTENCY_NIS_LIMIT       5.0f    // Sliding mean NIS of a lost filter
+#define CONSISTENCY_LOST_PERIODS    3       // Periods in a row above the limit
+#define CONSISTENCY_PAIR_SAMPLES    4       // Innovations of a pair in a period before it can be the worst
+
+typedef enum
+{
+    CONSISTENCY_OK = 0,
+    CONSISTENCY_SUSPECT,
+    CONSISTENCY_LOST,
+} consistency_state_t;
+
+class FilterConsistency
+{
+public:
+
+    FilterConsistency();
+
+    void setLimits(float nisLimit, int lostPeriods);
+
+    // Forgets the statistics, e.g. after the filter was initialized again. The loss count stays
+    void restart();
+
+    // One innovation of pair Ar, An, on the gate if it was rejected. Inline for the tools that link tdoa.cpp alone
+    inline void addInnovation(uint8_t Ar, uint8_t An, float nis, bool rejected)
+    {
+        if ((Ar >= MAX_NR_ANCHORS) || (An >= MAX_NR_ANCHORS) || !std::isfinite(nis))
+        {
+            return;
+        }
+
+        if (filled == CONSISTENCY_WINDOW)
+        {
+            sum -= ring[head];
+        }
+        else
+        {
+            filled++;
+        }
+        ring[head] = nis;
+        sum += nis;
+        if (++head == CONSISTENCY_WINDOW)
+        {
+            head = 0;
+            sum = 0;
+            for (uint32_t k = 0; k < filled; k++)
+            {
+                sum += ring[k];
+            }
+        }
+
+        pairSum[Ar][An] += nis;
+        if (pairCount[Ar][An] < UINT16_MAX)
+        {
+            pairCount[Ar][An]++;
+        }
+        periodCount++;
+        periodRejected += rejected;
+    }
+
+    // Closes the period once CONSISTENCY_PERIOD passed since it opened at t, true if it did
+    bool evaluate(double t);
+
+    consistency_state_t getState() const { return state; }
+    float getMeanNIS() const;
+    uint32_t getSamples() const { return filled; }
+    // Of the innovations of the last period
+    float getRejectedFraction() const;
+    // Pair with the highest mean NIS of the last period, false if no pair had enough innovations
+    bool getWorstPair(uint8_t &Ar, uint8_t &An, float &nis) const;
+    uint32_t getLosses() const { return losses; }
+
+private:
+
+    float nisLimit;
+    int lostPeriods;
+
+    // Sliding window, sum is recomputed whenever head wraps so the float error does not accumulate
+    float ring[CONSISTENCY_WINDOW];
+    uint32_t head;
+    uint32_t filled;
+    float sum;
+
+    // Current period per pair, row Ar and column An
+    float pairSum[MAX_NR_ANCHORS][MAX_NR_ANCHORS];
+    uint16_t pairCount[MAX_NR_ANCHORS][MAX_NR_ANCHORS];
+    uint32_t periodCount, periodRejected;
+
+    // Last period
+    float rejectedFraction;
+    bool worstValid;
+    uint8_t worstAr, worstAn;
+    float worstNis;
+
+    consistency_state_t state;
+    int periodsAbove;
+    uint32_t losses;
+    double periodStart;
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*************************************************
+ *
+ *  Always-on flight recorder of decaPos_node: the raw measurements, the
+ *  innovations, states and cycle timing of every tag over the last seconds,
+ *  kept in memory and written to disk (.tdfr) only when something went
+ *  wrong, so a divergence seen in the field can be replayed afterwards.
+ *
+ *  Every tag has a ring of fixed records written by its worker alone. The
+ *  writer never waits: each slot carries the sequence number it was written
+ *  for, stored around the payload like the frame ring (seqlock), so a dump
+ *  copying a slot the writer reuses at the same time drops that record
+ *  instead of blocking the estimator. A record is one 48 byte copy, the
+ *  rings are allocated once.
+ *
+ *  Dumps are triggered by a request (the dump_recorder service), by an
+ *  alarm of the estimator (trigger, taken by the thread that dumps a moment
+ *  later so the aftermath is in the file) or by a crash: the crash handler
+ *  writes all rings with open and write only, then lets the previous
+ *  handler end the process.
+ *
+ *  File: flight_recorder_header_t, then the records of tag 0 oldest first,
+ *  those of tag 1 and so on up to the end of the file.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FLIGHT_RECORDER_h
+#define _FLIGHT_RECORDER_h
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <csignal>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+#define FLIGHT_RECORDER_MAGIC       0x52464454  // "TDFR"
+#define FLIGHT_RECORDER_VERSION     1
+#define FLIGHT_RECORDER_RECORDS     131072      // Records per tag, power of two. 60 s of 1000 pairs/s with their innovations
+#define FLIGHT_RECORDER_SECONDS     30.0        // s, span of a dump before its trigger
+#define FLIGHT_RECORDER_AFTER       2.0         // s, an alarm is dumped this much later
+#define FLIGHT_RECORDER_MIN_GAP     30.0        // s, between two dumps of alarms
+#define FLIGHT_RECORDER_MAX_TAGS    8           // Named in the header, records of later tags are kept
+#define FLIGHT_RECORDER_VALUES      9
+#define FLIGHT_RECORDER_CHUNK       256         // Records per write of a dump
+
+typedef enum
+{
+    FLIGHT_RECORD_MEAS = 1,     // Raw pair as read, anchors with their cell: distance difference, variance, read - arrival, tag and USB latency
+    FLIGHT_RECORD_INNOVATION,   // Of the filter the pairs go to, at its state time: error, HPH'+R, NIS, 1 if rejected
+    FLIGHT_RECORD_STATE,        // Position, velocity, position standard deviations
+    FLIGHT_RECORD_CYCLE,        // Worker cycle, Ar is the cell: measurements drained, update s, drain to publication s, bootstrapped
+    FLIGHT_RECORD_EVENT,        // Ar is the flight_event_t, values as the event defines
+} flight_record_type_t;
+
+typedef enum
+{
+    FLIGHT_EVENT_BOOTSTRAP = 1, // Position of the seed
+    FLIGHT_EVENT_LOST,          // Consistency lost: mean NIS, worst pair Ar, An and its NIS, zero without one
+    FLIGHT_EVENT_HANDOVER,      // New cell
+    FLIGHT_EVENT_TRIGGER,       // flight_trigger_t of a dump
+} flight_event_t;
+
+typedef enum
+{
+    FLIGHT_TRIGGER_REQUEST = 1, // dump_recorder service
+    FLIGHT_TRIGGER_ALARM,       // Consistency of a filter lost
+    FLIGHT_TRIGGER_CRASH,       // Fatal signal, the signal number is in triggerTag
+} flight_trigger_t;
+
+typedef struct flight_record_s
+{
+    double t;                   // s, ros::Time the record refers to
+    uint8_t type;               // flight_record_type_t
+    uint8_t tag;                // Index of the tag in the node
+    uint8_t Ar, An;             // Anchors of the cell for pairs, the event of events
+    float v[FLIGHT_RECORDER_VALUES];
+}flight_record_t;
+
+static_assert(sizeof(flight_record_t) == 48, "Flight records are 48 bytes");
+
+typedef struct flight_recorder_header_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t tags;
+    uint32_t trigger;           // flight_trigger_t
+    int32_t  triggerTag;        // Tag of an alarm, signal of a crash, -1 otherwise
+    uint32_t reserved;
+    double dumpTime;            // s, newest record when dumped
+    double seconds;             // s, span before dumpTime, 0 for the whole rings
+    char robotType[24];
+    char tagNames[FLIGHT_RECORDER_MAX_TAGS][24];
+}flight_recorder_header_t;
+
+static_assert(sizeof(flight_recorder_header_t) == 256, "The flight recorder header is 256 bytes");
+
+// Record of type for tag at t, anchors and values zero
+inline flight_record_t flightRecord(flight_record_type_t type, size_t tag, double t)
+{
+    flight_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.t = t;
+    r.type = type;
+    r.tag = (uint8_t)tag;
+    return r;
+}
+
+// One line of comma separated text: t, type, tag, Ar, An and the values
+void formatFlightRecord(const flight_record_t &r, char *buf, size_t size);
+
+/*
+ * The records of one tag. One writer, any number of readers, neither waits
+ * for the other.
+ */
+class FlightRecorderRing
+{
+public:
+
+    FlightRecorderRing();
+
+    // Capacity in records, rounded up to a power of two. Before the writer starts
+    void allocate(size_t capacity);
+
+    // Writer only. A single copy, no allocation. Inline for the tools that link tdoa.cpp alone
+    inline void add(const flight_record_t &r)
+    {
+        if (!slots)
+        {
+            return;
+        }
+        const uint64_t s = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[s & mask];
+
+        // Readers of the previous lap see the sequence change before the record does
+        slot.seq.store((uint32_t)s, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.record, &r, sizeof(r));
+        slot.seq.store((uint32_t)(s + 1), std::memory_order_release);
+        head.store(s + 1, std::memory_order_release);
+    }
+
+    // Records at or after since still in the ring, oldest first
+    void snapshot(double since, std::vector<flight_record_t> &out) const;
+
+    // Time of the newest record, 0 while empty
+    double newest() const;
+
+    // Every record still in the ring into fd through buf, only async-signal-safe calls
+    bool write(int fd, flight_record_t *buf, size_t bufRecords) const;
+
+private:
+
+    struct Slot
+    {
+        std::atomic<uint32_t> seq;  // Low bits of sequence + 1 once written, of the sequence while being written
+        flight_record_t record;
+    };
+
+    // False if the writer took the slot of sequence s meanwhile
+    bool read(uint64_t s, flight_record_t &r) const;
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t mask;
+    std::atomic<uint64_t> head;     // Next sequence to write
+};
+
+class FlightRecorder
+{
+public:
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // One ring per tag. Dumps keep seconds before their trigger and go to directory
+    void configure(const std::vector<std::string> &tagNames, const std::string &robotType, size_t capacity,
+                   double seconds, const std::string &directory);
+
+    FlightRecorderRing &ring(size_t tag) { return rings[tag]; }
+    size_t getTags() const { return tags; }
+
+    // Asks for a dump FLIGHT_RECORDER_AFTER from now, false while one is pending or the last was too recent. Never blocks
+    bool trigger(flight_trigger_t reason, int tag);
+
+    // The trigger pending once it is due, for the thread that dumps
+    bool takeTrigger(flight_trigger_t &reason, int &tag);
+
+    // Writes the rings right away, path is the file written or the error
+    bool dump(flight_trigger_t reason, int tag, std::string &path);
+
+    // SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT write the rings first. One recorder per process
+    void installCrashHandler();
+    void removeCrashHandler();
+
+    uint32_t getDumps() const { return dumps; }
+
+private:
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    void fillHeader(flight_recorder_header_t &h, flight_trigger_t reason, int tag, double dumpTime, double span) const;
+    double newest() const;
+    static void crashHandler(int sig);
+
+    std::unique_ptr<FlightRecorderRing[]> rings;
+    size_t tags;
+    std::vector<std::string> names;
+    std::string robotType;
+    std::string directory;
+    double seconds;
+
+    // Serializes the dumps of triggers and of requests
+    std::mutex dumpMutex;
+    std::atomic<uint32_t> dumps;
+
+    // Pending alarm, due at pendingTime, and the last one taken. Seconds of the steady clock
+    std::atomic<bool> pending;
+    std::atomic<int> pendingReason, pendingTag;
+    std::atomic<double> pendingTime;
+    std::atomic<double> lastAlarm;
+};
+
+#endif
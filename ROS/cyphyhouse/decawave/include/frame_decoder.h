@@ -0,0 +1,366 @@
+/*************************************************
+ *
+ *  Streaming decoder for the TDOA frames sent by the tag over USB.
+ *  The frame layout is defined in common/tdoa_protocol.h.
+ *
+ *  Changelog:
+ *      v0.13 - resync for a port opened again, the counters keep counting
+ *      v0.12 - Raw timestamp frames optionally handed to the caller (TDOARawEngine)
+ *      v0.11 - Sync frames with the tag clock at a USB start of frame
+ *      v0.10 - Ranges frames, passed to an optional second callback
+ *      v0.9 - Version 3 batch frames, the send time of the tag in every record
+ *      v0.8 - Position frames of the on-tag filter
+ *      v0.7 - Skips trace frames
+ *      v0.6 - Telemetry frames
+ *      v0.5 - Version 2 frames, packet losses counted from the anchor packet indices
+ *      v0.4 - Batch frames, sequence gaps counted as lost batches
+ *      v0.3 - Status frames with the loss counters of the tag
+ *      v0.2 - Raw timestamp frames, solved on the host
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FRAME_DECODER_h
+#define _FRAME_DECODER_h
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "tdoa_protocol.h"
+#include "tdoa_raw.h"
+
+#define DECODER_BUF_SIZE 512
+
+/*
+ * Bytes are read straight into the decoder buffer (writePtr/writeSpace), then
+ * commit() scans them in place. A frame that fails its checksum only consumes
+ * its sync byte, so a real frame starting inside the corrupted one is still
+ * found. Less than one frame is left over after each commit and is moved to
+ * the front of the buffer.
+ * Raw timestamp frames are turned into the same tdoa_frame_t by the host clock
+ * model, so callers do not need to know which mode the tag runs in, unless
+ * on_raw of the four argument commit takes them.
+ * Batch frames call on_frame once per record, in the order measured.
+ * Version 2 records also carry the packet index of An, so every packet of An
+ * that never produced a record is counted in getLostPackets.
+ * Status frames only update the tag loss counters returned by getTagStatus,
+ * telemetry frames the counters returned by getTelemetry and position
+ * frames the on-tag estimate returned by getPosition and sync frames the
+ * tag clock returned by getSync.
+ * Ranges frames go to on_ranges of the three argument commit, the others
+ * drop them.
+ */
+class TDOAFrameDecoder
+{
+public:
+
+    TDOAFrameDecoder() : len(0), goodFrames(0), badFrames(0), skippedBytes(0), rawFrames(0),
+                         batches(0), lostBatches(0), lastSeq(0), seqValid(false), lostPackets(0), telemetryFrames(0),
+                         positionFrames(0), rangesFrames(0), syncFrames(0)
+    {
+        tagStatus.rxDropped = 0;
+        tagStatus.outDropped = 0;
+        memset(&telemetry, 0, sizeof(telemetry));
+        memset(&position, 0, sizeof(position));
+        memset(&sync, 0, sizeof(sync));
+        memset(lastIdx, 0, sizeof(lastIdx));
+        memset(seenIdx, 0, sizeof(seenIdx));
+    }
+
+    /*
+     * Forgets the bytes of a partial frame and the sequence numbers and
+     * packet indices so far, after the port was opened again: the tag may
+     * have reset, and a gap is not a loss. The counters and the last
+     * telemetry, position and sync keep their values.
+     */
+    void resync()
+    {
+        len = 0;
+        seqValid = false;
+        memset(seenIdx, 0, sizeof(seenIdx));
+        rawSolver = TDOARawSolver();
+    }
+
+    uint8_t *writePtr() { return &buf[len]; }
+    size_t writeSpace() const { return DECODER_BUF_SIZE - len; }
+
+    // Parses n newly written bytes, calling on_frame(const tdoa_frame_t&) for every valid frame
+    template <typename Callback>
+    void commit(size_t n, Callback on_frame)
+    {
+        commit(n, on_frame, [](const tdoa_ranges_t &) {});
+    }
+
+    // Same, also calling on_ranges(const tdoa_ranges_t&) for every ranges frame
+    template <typename Callback, typename RangesCallback>
+    void commit(size_t n, Callback on_frame, RangesCallback on_ranges)
+    {
+        commit(n, on_frame, on_ranges, [](const tdoa_raw_frame_t &) { return false; });
+    }
+
+    // Same, offering every raw frame to on_raw(const tdoa_raw_frame_t&) first, solved here only if it returns false
+    template <typename Callback, typename RangesCallback, typename RawCallback>
+    void commit(size_t n, Callback on_frame, RangesCallback on_ranges, RawCallback on_raw)
+    {
+        len += n;
+
+        size_t idx = 0;
+        while (len - idx >= TDOA_FRAME_SIZE)
+        {
+            const uint8_t *msg = &buf[idx];
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_RAW_FRAME_SYNC)
+            {
+                if (len - idx < TDOA_RAW_FRAME_SIZE)
+                {
+                    // Wait for the rest of the raw frame
+                    break;
+                }
+                tdoa_raw_frame_t raw;
+                tdoa_frame_t frame;
+                if (!tdoa_raw_frame_decode(msg, &raw))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                rawFrames++;
+                if (!on_raw(raw) && rawSolver.solve(raw, frame))
+                {
+                    on_frame(frame);
+                }
+                idx += TDOA_RAW_FRAME_SIZE;
+                continue;
+            }
+            if ((msg[TDOA_FRAME_TYPE_BYTE] == TDOA_BATCH_FRAME_SYNC) || (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_V2_FRAME_SYNC))
+            {
+                const bool v2 = (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_V2_FRAME_SYNC);
+                const size_t size = v2 ? tdoa_v2_frame_size(msg) : tdoa_batch_frame_size(msg);
+                if ((size != 0) && (len - idx < size))
+                {
+                    break;
+                }
+                tdoa_batch_t batch;
+                if (!(v2 ? tdoa_v2_frame_decode(msg, &batch) : tdoa_batch_frame_decode(msg, &batch)))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                if (seqValid)
+                {
+                    lostBatches += (uint8_t)(batch.seq - lastSeq - 1);
+                }
+                lastSeq = batch.seq;
+                seqValid = true;
+                batches++;
+                for (uint8_t i = 0; i < batch.count; i++)
+                {
+                    goodFrames++;
+                    countLostPackets(batch.frames[i]);
+                    on_frame(batch.frames[i]);
+                }
+                idx += size;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_STATUS_FRAME_SYNC)
+            {
+                if (len - idx < TDOA_STATUS_FRAME_SIZE)
+                {
+                    break;
+                }
+                tdoa_status_t status;
+                if (!tdoa_status_frame_decode(msg, &status))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                tagStatus = status;
+                idx += TDOA_STATUS_FRAME_SIZE;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_TELEMETRY_FRAME_SYNC)
+            {
+                const size_t size = tdoa_telemetry_frame_size(msg);
+                if ((size != 0) && (len - idx < size))
+                {
+                    break;
+                }
+                tdoa_telemetry_t t;
+                if (!tdoa_telemetry_frame_decode(msg, &t))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                telemetry = t;
+                telemetryFrames++;
+                idx += size;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_POSITION_FRAME_SYNC)
+            {
+                if (len - idx < TDOA_POSITION_FRAME_SIZE)
+                {
+                    break;
+                }
+                tdoa_position_t p;
+                if (!tdoa_position_frame_decode(msg, &p))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                position = p;
+                positionFrames++;
+                idx += TDOA_POSITION_FRAME_SIZE;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_SYNC_FRAME_SYNC)
+            {
+                if (len - idx < TDOA_SYNC_FRAME_SIZE)
+                {
+                    break;
+                }
+                tdoa_sync_t t;
+                if (!tdoa_sync_frame_decode(msg, &t))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                sync = t;
+                syncFrames++;
+                idx += TDOA_SYNC_FRAME_SIZE;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_RANGES_FRAME_SYNC)
+            {
+                const size_t size = tdoa_ranges_frame_size(msg);
+                if ((size != 0) && (len - idx < size))
+                {
+                    break;
+                }
+                tdoa_ranges_t r;
+                if (!tdoa_ranges_frame_decode(msg, &r))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                rangesFrames++;
+                on_ranges(r);
+                idx += size;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_TRACE_FRAME_SYNC)
+            {
+                // Firmware built with TDOA_TRACE, the samples are for scripts/trace_histogram.py
+                const size_t size = tdoa_trace_frame_size(msg);
+                if ((size != 0) && (len - idx < size))
+                {
+                    break;
+                }
+                if (!tdoa_trace_frame_valid(msg))
+                {
+                    idx++;
+                    badFrames++;
+                    continue;
+                }
+                idx += size;
+                continue;
+            }
+            if (msg[TDOA_FRAME_TYPE_BYTE] != TDOA_FRAME_SYNC)
+            {
+                idx++;
+                skippedBytes++;
+                continue;
+            }
+
+            tdoa_frame_t frame;
+            if (!tdoa_frame_decode(msg, &frame))
+            {
+                // Resync on the next sync byte inside this frame
+                idx++;
+                badFrames++;
+                continue;
+            }
+
+            goodFrames++;
+            on_frame(frame);
+
+            idx += TDOA_FRAME_SIZE;
+        }
+
+        len -= idx;
+        memmove(buf, &buf[idx], len);
+    }
+
+    uint32_t getGoodFrames() const { return goodFrames; }
+    uint32_t getBadFrames() const { return badFrames; }
+    uint32_t getSkippedBytes() const { return skippedBytes; }
+    uint32_t getRawFrames() const { return rawFrames; }
+    uint32_t getBatches() const { return batches; }
+    // Batches missing from the sequence numbers, a gap of more than 255 is undercounted
+    uint32_t getLostBatches() const { return lostBatches; }
+    // Anchor packets between two records of the same An that gave no record, version 2 only
+    uint32_t getLostPackets() const { return lostPackets; }
+    // Losses on the tag since its power-up, as of the last status frame
+    const tdoa_status_t &getTagStatus() const { return tagStatus; }
+    // Last telemetry frame of the tag, getTelemetryFrames counts them
+    const tdoa_telemetry_t &getTelemetry() const { return telemetry; }
+    uint32_t getTelemetryFrames() const { return telemetryFrames; }
+    // Last estimate of a tag running its own filter, getPositionFrames counts them
+    const tdoa_position_t &getPosition() const { return position; }
+    uint32_t getPositionFrames() const { return positionFrames; }
+    // Tag clock at the USB start of frame of the last sync frame, getSyncFrames counts them
+    const tdoa_sync_t &getSync() const { return sync; }
+    uint32_t getSyncFrames() const { return syncFrames; }
+    // Inter-anchor ranges of the tag for the anchor survey, USB_RANGES_EVERY in its firmware
+    uint32_t getRangesFrames() const { return rangesFrames; }
+
+private:
+
+    // Every anchor sends once per TDMA frame, so the index of An advances by one per packet
+    void countLostPackets(const tdoa_frame_t &frame)
+    {
+        if (!(frame.flags & TDOA_FRAME_HAS_TIME) || (frame.An >= RAW_MAX_ANCHORS))
+        {
+            return;
+        }
+        if (seenIdx[frame.An])
+        {
+            lostPackets += (uint8_t)(frame.idx - lastIdx[frame.An] - 1);
+        }
+        lastIdx[frame.An] = frame.idx;
+        seenIdx[frame.An] = true;
+    }
+
+    uint8_t buf[DECODER_BUF_SIZE];
+    size_t len;
+
+    uint32_t goodFrames;
+    uint32_t badFrames;
+    uint32_t skippedBytes;
+    uint32_t rawFrames;
+    tdoa_status_t tagStatus;
+    uint32_t batches;
+    uint32_t lostBatches;
+    uint8_t lastSeq;
+    bool seqValid;
+    uint32_t lostPackets;
+    tdoa_telemetry_t telemetry;
+    uint32_t telemetryFrames;
+    tdoa_position_t position;
+    uint32_t positionFrames;
+    uint32_t rangesFrames;
+    tdoa_sync_t sync;
+    uint32_t syncFrames;
+    uint8_t lastIdx[RAW_MAX_ANCHORS];
+    bool seenIdx[RAW_MAX_ANCHORS];
+
+    TDOARawSolver rawSolver;
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*************************************************
+ *
+ *  Shared memory ring of the decoded frames of one tag port, so a single
+ *  reader (tag_reader) owns the port and decodes every frame once, and the
+ *  estimator, the capture logger and debug tools all read the same frames.
+ *
+ *  One writer, any number of readers, each with its own cursor. The writer
+ *  never waits on a reader: a reader that falls more than a ring behind
+ *  skips to the oldest entry still there and counts the rest as lost. Every
+ *  entry carries the sequence number it was written for, stored after its
+ *  payload, so a reader copying an entry the writer reuses at the same time
+ *  sees the sequence change and drops it (seqlock). Readers map the ring
+ *  read-write only for the wait counter and the command slots, and poll the
+ *  head in the mapping. Only a reader that found the ring empty sleeps in a
+ *  futex on the head, which the writer wakes when someone waits.
+ *
+ *  Readers have no port to write to, the tag configuration they send goes
+ *  through FRAME_RING_TX_SLOTS command slots the writer sends to the port.
+ *
+ *  The ring is named after the port (frameRingName) and lives in /dev/shm.
+ *  The writer keeps an existing ring of the same layout, so readers survive
+ *  a restart of tag_reader; a new capacity needs the readers restarted.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _FRAME_RING_h
+#define _FRAME_RING_h
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
+
+#include "tdoa_protocol.h"
+
+#define FRAME_RING_MAGIC        0x474e5246  // "FRNG"
+#define FRAME_RING_VERSION      3           // 3: measurement variance of the tag in tdoa_frame_t
+#define FRAME_RING_CAPACITY     4096        // Entries, power of two. 4 s of 1000 frames/s
+#define FRAME_RING_TX_SLOTS     8           // Commands waiting for the port
+#define FRAME_RING_TX_SIZE      512         // Bytes per command, the largest is the anchor frame
+#define FRAME_RING_RETRY_MS     500         // Between two attempts to open a ring not created yet
+
+static_assert(TDOA_ANCHOR_FRAME_MAX_SIZE <= FRAME_RING_TX_SIZE, "Anchor frames must fit a command slot of the frame ring");
+
+typedef enum
+{
+    FRAME_RING_TDOA = 1,        // tdoa_frame_t, raw frames already solved
+    FRAME_RING_RANGES,          // tdoa_ranges_t
+    FRAME_RING_STATUS,          // frame_ring_status_t, whenever a counter moved
+    FRAME_RING_TELEMETRY,       // tdoa_telemetry_t
+    FRAME_RING_POSITION,        // tdoa_position_t
+    FRAME_RING_SYNC,            // tdoa_sync_t
+} frame_ring_type_t;
+
+// Loss counters of the tag and of the decoder
+typedef struct frame_ring_status_s
+{
+    tdoa_status_t tag;
+    uint32_t lostPackets;
+}frame_ring_status_t;
+
+typedef struct frame_ring_entry_s
+{
+    std::atomic<uint32_t> seq;      // Sequence + 1 once written, the sequence while being written
+    uint32_t type;                  // frame_ring_type_t
+    double hostTime;                // s, ros::Time of the read from the port
+    union
+    {
+        tdoa_frame_t frame;
+        tdoa_ranges_t ranges;
+        frame_ring_status_t status;
+        tdoa_telemetry_t telemetry;
+        tdoa_position_t position;
+        tdoa_sync_t sync;
+    };
+}__attribute__((aligned(64))) frame_ring_entry_t;
+
+typedef struct frame_ring_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t entrySize;
+    alignas(64) std::atomic<uint32_t> head;     // Next sequence to write, the futex of waiting readers
+    std::atomic<uint32_t> waiters;              // Readers in the futex
+    alignas(64) std::atomic<uint32_t> txLock;   // Spin lock of the command slots, held for a copy
+    uint32_t txHead, txTail;
+    uint16_t txSize[FRAME_RING_TX_SLOTS];
+    uint8_t  tx[FRAME_RING_TX_SLOTS][FRAME_RING_TX_SIZE];
+}__attribute__((aligned(64))) frame_ring_header_t;
+
+// Ring of a port, "/dev/ttyACM0" -> "/decawave_dev_ttyACM0"
+std::string frameRingName(const std::string &port);
+
+// Mapping shared by the two ends
+class FrameRing
+{
+public:
+
+    FrameRing();
+    ~FrameRing();
+
+    bool isOpen() const { return header != NULL; }
+    void close();
+
+protected:
+
+    bool map(int fd, size_t size, std::string &error);
+
+    frame_ring_header_t *header;
+    frame_ring_entry_t *entries;
+    size_t mappingSize;
+    uint32_t mask;
+
+private:
+
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+};
+
+class FrameRingWriter : public FrameRing
+{
+public:
+
+    // Creates the ring of name, or takes over the one a previous writer left
+    bool create(const std::string &name, uint32_t capacity, std::string &error);
+
+    // Appends an entry, the payload of its type is copied from data
+    void publish(frame_ring_type_t type, double hostTime, const void *data, size_t size);
+
+    // Oldest command of the readers into buf, its size or 0 without one
+    size_t takeCommand(uint8_t *buf);
+};
+
+class FrameRingReader : public FrameRing
+{
+public:
+
+    FrameRingReader();
+
+    // Maps the ring of name, reading starts with the next entry written
+    bool open(const std::string &name, std::string &error);
+
+    // Copies the entry at the cursor and advances, false once the reader caught up with the writer
+    bool next(frame_ring_entry_t &entry);
+
+    // Returns right away if there are entries, otherwise sleeps until one is written or timeoutMs passed
+    bool wait(int timeoutMs);
+
+    // Queues a command for the port, false if the slots are full
+    bool send(const uint8_t *data, size_t size);
+
+    // Entries overwritten before this reader got to them
+    uint64_t getLost() const { return lost; }
+
+private:
+
+    uint32_t cursor;
+    uint64_t lost;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*************************************************
+ *
+ *  Steady-state Kalman gains of the TDOA filter over the tracking volume of
+ *  one cell, for TDOA_COVARIANCE_STEADY. For a tag at rest at a grid node
+ *  the TDMA rotation is periodic: pair (N-1, 0), (0, 1), ... (N-2, N-1),
+ *  one per slot, so the Riccati recursion of the filter converges to a
+ *  periodic covariance. The gain_table tool iterates it at every node until
+ *  the gains stop changing and stores, for every ordered pair (Ar, An), the
+ *  gain and innovation variance the filter would have for that pair in the
+ *  slot of An. A dropped slot only changes which anchor is the reference,
+ *  so the pairs of dropped slots are in the table too.
+ *
+ *  A steady-state update is then the measurement prediction, one innovation
+ *  and 6 multiply-adds, with no covariance to propagate. It matches the
+ *  EKF as long as the tag is near a node (the gain is not relinearized
+ *  between nodes), moves slowly against the process noise the table was
+ *  computed with, and hears the anchors in their TDMA order.
+ *
+ *  File layout, little-endian:
+ *      gain_table_header_t
+ *      nx*ny*nz nodes, x fastest, each GAIN_TABLE_NODE_SIZE(anchors) floats:
+ *          the steady-state covariance after a full rotation, upper triangle
+ *          row by row (21 floats) and 3 padding floats
+ *          anchors*anchors entries of GAIN_TABLE_ENTRY floats, pair
+ *          Ar*anchors + An: the gain of STATE_DIM states, HPH'+R and padding
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _GAIN_TABLE_h
+#define _GAIN_TABLE_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+
+#define GAIN_TABLE_MAGIC        0x42415447  // "GTAB"
+#define GAIN_TABLE_VERSION      1
+#define GAIN_TABLE_STEP         0.5f        // m, default grid spacing
+#define GAIN_TABLE_MARGIN       0.5f        // m, the grid covers the bounding box of the anchors grown by this
+#define GAIN_TABLE_MAX_NODES    (1 << 20)
+#define GAIN_TABLE_MAX_FRAMES   20000       // Rotations of the Riccati recursion before a node is given up
+#define GAIN_TABLE_GAIN_TOL     1e-7        // Largest gain change over a rotation at convergence
+#define GAIN_TABLE_COV_SIZE     24          // Floats of the covariance block, 21 used
+#define GAIN_TABLE_ENTRY        8           // Floats per pair
+#define GAIN_TABLE_S            STATE_DIM   // Entry offset of HPH'+R
+#define GAIN_TABLE_NODE_SIZE(n) (GAIN_TABLE_COV_SIZE + GAIN_TABLE_ENTRY*(n)*(n))
+
+typedef struct gain_table_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t cell;
+    uint32_t anchors;
+    uint32_t nx, ny, nz;
+    uint32_t unconverged;                   // Nodes left at GAIN_TABLE_MAX_FRAMES
+    float    origin[3];                     // m, node (0,0,0)
+    float    step;                          // m
+    float    stdDev;                        // m, pair noise
+    float    slotTime;                      // s, time between two pairs
+    float    transition[STATE_DIM];         // Diagonal of the transition matrix A
+    float    processNoise[STATE_DIM];       // Diagonal of Q per PROCESS_NOISE_STEP
+    float    anchorPos[MAX_NR_ANCHORS][3];  // m
+}gain_table_header_t;
+
+// What the gains are computed for
+typedef struct gain_table_model_s
+{
+    float stdDev;
+    float slotTime;
+    float transition[STATE_DIM];
+    float processNoise[STATE_DIM];
+}gain_table_model_t;
+
+class GainTable
+{
+public:
+
+    GainTable();
+    ~GainTable();
+
+    // Maps the file, false with a message in error if it is not a gain table
+    bool load(const std::string &path, std::string &error);
+
+    /*
+     * Computes the table of the anchors of one cell with grid spacing step
+     * over their bounding box grown by margin and writes it to path.
+     */
+    static bool build(const std::string &path, int cell, const std::vector<vec3d_t> &anchors, const gain_table_model_t &model, float step, float margin);
+
+    /*
+     * Periodic steady state of a tag at rest at p. out gets one node as
+     * stored in the file, false if the recursion did not converge.
+     */
+    static bool steadyState(const std::vector<vec3d_t> &anchors, const gain_table_model_t &model, const Eigen::Vector3d &p, float *out);
+
+    int getCell() const;
+    const gain_table_header_t &getHeader() const;
+
+    // Largest distance between the anchors of the table and anchors, infinite if their number differs
+    float layoutChange(const std::vector<vec3d_t> &anchors) const;
+
+    // Nearest node of the position, the closest face outside the grid
+    inline const float *node(float x, float y, float z) const
+    {
+        const float u[3] = {x, y, z};
+        const int n[3] = {(int)header->nx, (int)header->ny, (int)header->nz};
+        size_t index = 0, stride = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            // NaN ends up at node 0
+            const float c = std::max(0.0f, std::min((u[k] - header->origin[k]) / header->step + 0.5f, (float)(n[k] - 1)));
+            index += (size_t)c * stride;
+            stride *= n[k];
+        }
+        return nodes + index*nodeSize;
+    }
+
+    // The covariance block of a node
+    static inline const float *covariance(const float *node)
+    {
+        return node;
+    }
+
+    // Entry of pair (Ar, An) at a node, NULL for a pair the table does not have
+    inline const float *gain(const float *node, int Ar, int An) const
+    {
+        const int n = header->anchors;
+        if ((Ar == An) || (Ar < 0) || (An < 0) || (Ar >= n) || (An >= n))
+        {
+            return NULL;
+        }
+        return node + GAIN_TABLE_COV_SIZE + GAIN_TABLE_ENTRY*(Ar*n + An);
+    }
+
+private:
+
+    GainTable(const GainTable &) = delete;
+    GainTable &operator=(const GainTable &) = delete;
+
+    void unmap();
+
+    void *mapping;
+    size_t mappingSize;
+    const gain_table_header_t *header;
+    const float *nodes;
+    size_t nodeSize;            // Floats per node
+};
+
+#endif
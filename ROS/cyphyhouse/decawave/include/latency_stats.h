@@ -0,0 +1,143 @@
+/*************************************************
+ *
+ *  Latency of the measurements from the arrival of the anchor packet at the
+ *  tag to the publication of the estimate, split into stages:
+ *      tag      arrival to the USB send of its batch, tag clock
+ *      usb      USB send to the read in serial_comm, see TagClockTracker
+ *      queue    read to the filter update by the worker
+ *      publish  filter update to pub_state
+ *      total    all of the above
+ *  The tag and usb stages need version 3 batch frames (common/tdoa_protocol.h),
+ *  without them only the host stages are measured.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _LATENCY_STATS_h
+#define _LATENCY_STATS_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+#include "cyphy_control/SPSCQueue.h"
+
+#define LATENCY_BINS_PER_OCTAVE  4
+#define LATENCY_BINS             80      // 1 us to 1 s, the last bin also takes everything longer
+#define LATENCY_CLOCK_DRIFT      100e-6  // s/s the tag clock may drift against the host clock
+#define LATENCY_CLOCK_GAP        4.0     // s without a batch after which the tag clock is tracked anew
+#define LATENCY_TRACE_QUEUE_SIZE 4096    // Events per tag waiting for the trace writer, power of two
+
+enum LatencyStage
+{
+    LATENCY_TAG,
+    LATENCY_USB,
+    LATENCY_QUEUE,
+    LATENCY_PUBLISH,
+    LATENCY_TOTAL,
+    LATENCY_STAGES
+};
+
+const char *latencyStageName(int stage);
+
+/*
+ * Counts of one stage in quarter-octave bins, bin b starts at
+ * 2^(b/LATENCY_BINS_PER_OCTAVE) us. One thread records, any thread may take
+ * a snapshot. The counts run since the start, periods are differences of two
+ * snapshots.
+ */
+class LatencyHistogram
+{
+public:
+
+    LatencyHistogram();
+
+    void record(double seconds);
+    void snapshot(uint32_t counts[LATENCY_BINS]) const;
+
+    // s
+    static double binStart(int bin);
+    // Upper edge of the bin of the fraction p of counts, 0 without counts
+    static double percentile(const uint32_t counts[LATENCY_BINS], double p);
+
+private:
+
+    std::atomic<uint32_t> bins[LATENCY_BINS];
+};
+
+/*
+ * USB stage of the batches of one tag. Without synchronized clocks only the
+ * offset read - send is known, which is the transfer time plus the unknown
+ * offset of the clocks. Its running minimum stands for the fastest transfer
+ * and is allowed to rise by LATENCY_CLOCK_DRIFT, so the drift of the tag
+ * crystal is followed. The stage is the excess over the fastest transfer,
+ * the fixed part of the transfer is not observable.
+ */
+class TagClockTracker
+{
+public:
+
+    TagClockTracker();
+
+    // send in the 40-bit tag clock, read in s of host time
+    double usbLatency(uint64_t send, double read);
+
+private:
+
+    bool valid;
+    uint64_t lastSend;
+    double sendTime;        // s of tag clock since the first batch, unwrapped
+    double lastRead;
+    double minOffset;
+};
+
+// One measurement in the trace, stage durations in s, negative if unknown
+typedef struct latency_trace_event_s
+{
+    double read;            // s, host time of the read
+    float  stage[LATENCY_TOTAL];
+    uint8_t Ar;
+    uint8_t An;
+}latency_trace_event_t;
+
+/*
+ * Chrome trace (chrome://tracing, Perfetto) of the stages of every
+ * measurement, one process per tag and one thread per stage. add is called
+ * by the worker of the tag and only copies the event into the queue of the
+ * tag, a thread formats and writes them. A full queue drops the event.
+ */
+class LatencyTrace
+{
+public:
+
+    // Creates path and starts writing to it, see ok
+    LatencyTrace(const std::string &path, const std::vector<std::string> &tags);
+    // Writes what is left and ends the JSON array
+    ~LatencyTrace();
+
+    bool ok() const { return file != nullptr; }
+    uint32_t dropped() const;
+
+    void add(size_t tag, const latency_trace_event_t &event);
+
+private:
+
+    typedef SPSCQueue<latency_trace_event_t, LATENCY_TRACE_QUEUE_SIZE> EventQueue;
+
+    void run();
+    void write(size_t tag, const latency_trace_event_t &event);
+
+    FILE *file;
+    std::vector<std::unique_ptr<EventQueue> > queues;
+    std::atomic<bool> running;
+    std::thread writer;
+};
+
+#endif
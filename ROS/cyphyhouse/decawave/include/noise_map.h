@@ -0,0 +1,157 @@
+/*************************************************
+ *
+ *  Precomputed measurement geometry of one cell over its tracking volume.
+ *  The filter uses a single stdDev for every pair, but how well a pair
+ *  measures depends on where the tag is: the range noise of an anchor grows
+ *  with its distance (timing jitter goes with 1/SNR, the amplitude with
+ *  1/d), and the layout as a whole constrains some directions poorly.
+ *  The noise_map tool fills a grid over the bounding box of the anchors with
+ *      - GDOP: sqrt(trace(J^-1)) of the position, J the information of the
+ *        ranges to all anchors with the unknown emission time removed and
+ *        every anchor weighted by its noise. It is independent of the
+ *        reference anchor and in units of the nominal pair noise
+ *      - per pair, the factor on stdDev: sqrt((f(dr)^2 + f(dn)^2)/2) with
+ *        f(d) = max(1, d/refDist), 1 wherever both anchors are in range
+ *  and writes it to a file that the node maps read-only (mmap). A lookup is
+ *  a trilinear interpolation between the 8 nodes around the position,
+ *  outside the grid the nearest face is used. Within a step of an anchor the
+ *  GDOP changes faster than the grid and the lookup smooths it.
+ *
+ *  File layout, little-endian:
+ *      noise_map_header_t
+ *      planes of nx*ny*nz uint16, x fastest: GDOP in NOISE_MAP_GDOP_LSB,
+ *      then one per pair (Ar < An, pair index An*(An-1)/2 + Ar) in
+ *      NOISE_MAP_SCALE_LSB
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _NOISE_MAP_h
+#define _NOISE_MAP_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+
+#define NOISE_MAP_MAGIC         0x50414d4e  // "NMAP"
+#define NOISE_MAP_VERSION       1
+#define NOISE_MAP_STEP          0.25f       // m, default grid spacing
+#define NOISE_MAP_MARGIN        1.0f        // m, the grid covers the bounding box of the anchors grown by this
+#define NOISE_MAP_REF_DIST      5.0f        // m, range up to which an anchor measures with the nominal noise
+#define NOISE_MAP_MAX_NODES     (1 << 24)   // Per plane
+#define NOISE_MAP_GDOP_LSB      0.01f
+#define NOISE_MAP_SCALE_LSB     (1.0f / 4096)
+#define NOISE_MAP_MAX_SHIFT     0.05f       // m, anchor displacement after which a map no longer describes the layout
+
+typedef struct noise_map_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t cell;
+    uint32_t anchors;                       // Of the cell, positions in anchorPos
+    uint32_t nx, ny, nz;
+    float    origin[3];                     // m, node (0,0,0)
+    float    step;                          // m
+    float    refDist;                       // m
+    float    anchorPos[MAX_NR_ANCHORS][3];  // m
+}noise_map_header_t;
+
+class NoiseMap
+{
+public:
+
+    NoiseMap();
+    ~NoiseMap();
+
+    // Maps the file, false with a message in error if it is not a noise map
+    bool load(const std::string &path, std::string &error);
+
+    /*
+     * Computes the map of the anchors of one cell with grid spacing step over
+     * their bounding box grown by margin and writes it to path.
+     */
+    static bool build(const std::string &path, int cell, const std::vector<vec3d_t> &anchors, float step, float margin, float refDist);
+
+    // GDOP at p and the factors of all pairs of anchors, pairScale[pairIndex(Ar, An)]
+    static float geometry(const std::vector<vec3d_t> &anchors, const Eigen::Vector3f &p, float refDist, float *pairScale);
+
+    static inline int pairIndex(int Ar, int An)
+    {
+        if (Ar > An)
+        {
+            std::swap(Ar, An);
+        }
+        return An*(An - 1)/2 + Ar;
+    }
+
+    int getCell() const;
+    int getAnchorCount() const;
+    const noise_map_header_t &getHeader() const;
+
+    // Largest distance between the anchors of the map and anchors, infinite if their number differs
+    float layoutChange(const std::vector<vec3d_t> &anchors) const;
+
+    inline float gdop(float x, float y, float z) const
+    {
+        return NOISE_MAP_GDOP_LSB * interpolate(0, x, y, z);
+    }
+
+    // Factor on the nominal noise of pair (Ar, An) at the position, 1 for anchors the map does not have
+    inline float pairScale(int Ar, int An, float x, float y, float z) const
+    {
+        if ((Ar == An) || (Ar < 0) || (An < 0) || (Ar >= (int)header->anchors) || (An >= (int)header->anchors))
+        {
+            return 1.0f;
+        }
+        return NOISE_MAP_SCALE_LSB * interpolate(1 + pairIndex(Ar, An), x, y, z);
+    }
+
+private:
+
+    NoiseMap(const NoiseMap &) = delete;
+    NoiseMap &operator=(const NoiseMap &) = delete;
+
+    // Trilinear interpolation of plane in raw units
+    inline float interpolate(int plane, float x, float y, float z) const
+    {
+        const float u[3] = {(x - header->origin[0]) / header->step,
+                            (y - header->origin[1]) / header->step,
+                            (z - header->origin[2]) / header->step};
+        const int n[3] = {(int)header->nx, (int)header->ny, (int)header->nz};
+        int i[3];
+        float f[3];
+        for (int k = 0; k < 3; k++)
+        {
+            // Clamped so the upper node i+1 stays on the grid, NaN ends up at node 0
+            const float c = std::max(0.0f, std::min(u[k], (float)(n[k] - 1)));
+            i[k] = std::min((int)c, std::max(n[k] - 2, 0));
+            f[k] = (n[k] > 1) ? c - i[k] : 0.0f;
+        }
+        const size_t sx = 1, sy = n[0], sz = (size_t)n[0]*n[1];
+        const size_t dx = (n[0] > 1) ? sx : 0, dy = (n[1] > 1) ? sy : 0, dz = (n[2] > 1) ? sz : 0;
+        const uint16_t *v = planes + plane*planeSize + i[0]*sx + i[1]*sy + i[2]*sz;
+
+        const float c00 = v[0]*(1 - f[0])       + v[dx]*f[0];
+        const float c10 = v[dy]*(1 - f[0])      + v[dy + dx]*f[0];
+        const float c01 = v[dz]*(1 - f[0])      + v[dz + dx]*f[0];
+        const float c11 = v[dz + dy]*(1 - f[0]) + v[dz + dy + dx]*f[0];
+        const float c0 = c00*(1 - f[1]) + c10*f[1];
+        const float c1 = c01*(1 - f[1]) + c11*f[1];
+        return c0*(1 - f[2]) + c1*f[2];
+    }
+
+    void unmap();
+
+    void *mapping;
+    size_t mappingSize;
+    const noise_map_header_t *header;
+    const uint16_t *planes;
+    size_t planeSize;           // Nodes per plane
+};
+
+#endif
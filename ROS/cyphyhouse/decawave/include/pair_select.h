@@ -0,0 +1,44 @@
+/*************************************************
+ *
+ *  Independent pairs of a TDMA frame. With TDOA_PAIRS_ALL or
+ *  TDOA_PAIRS_REFERENCE the tag measures An against several anchors per
+ *  packet, so a frame over N anchors holds up to N(N-1)/2 distance
+ *  differences. All of them are differences of the same N arrivals: any
+ *  cycle of pairs sums to zero up to noise, and only N-1 of them carry
+ *  information. Applied as independent measurements they cost a scalar
+ *  update each and count the arrivals they share several times, so the
+ *  filter grows overconfident in the anchors with the most pairs.
+ *
+ *  selectIndependentPairs keeps a spanning forest of the anchors of the
+ *  frame, the pairs that join anchors not yet connected, taken in order of
+ *  increasing variance (Kruskal). The pairs left out are the ones that close
+ *  a cycle, they would only repeat arrivals already in the frame, now with
+ *  the noise of a longer interval. A frame of consecutive pairs is a chain
+ *  and stays as it is.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _PAIR_SELECT_h
+#define _PAIR_SELECT_h
+
+#include <cstddef>
+
+#include "tdoa.h"
+
+#define FRAME_MAX_PAIRS (MAX_NR_ANCHORS * (MAX_NR_ANCHORS - 1) / 2)  // Every pair of one TDMA frame
+
+/*
+ * Compacts meas and variance (m^2, 0 for the filter's own noise, may be
+ * NULL) to the pairs of the spanning forest, in their order. Pairs of
+ * unknown or equal anchors are dropped. A variance of 0 sorts as infinite,
+ * so pairs the tag measured a low variance for are preferred over pairs it
+ * sent none for. Pairs of equal variance are taken in order, so without
+ * variances the earliest pair attaches an anchor.
+ * Returns the number kept, at most MAX_NR_ANCHORS-1.
+ */
+size_t selectIndependentPairs(tdoa_meas_t *meas, float *variance, size_t count);
+
+#endif
@@ -0,0 +1,82 @@
+/*************************************************
+ *
+ *  Rauch-Tung-Striebel smoothing of the TDOA filter estimates. The filter
+ *  states after each cycle of updates are kept with their covariance, the
+ *  prediction between two of them is recomputed from the diagonal motion
+ *  model of the filter (A and Q of the robot type), and the backward pass
+ *      C_k  = P_k F' (F P_k F' + Q)^-1
+ *      xs_k = x_k + C_k (xs_k+1 - F x_k)
+ *      Ps_k = P_k + C_k (Ps_k+1 - F P_k F' - Q) C_k'
+ *  runs from the newest state back. The updates of a cycle count as if they
+ *  were all made at the time of its state, a few ms at the publish rate.
+ *
+ *  Fixed lag: add() every filter state, output() then gives the state lag
+ *  seconds behind the newest one, smoothed with everything after it. Each
+ *  output is one backward pass over the lag, about lag * pub_rate steps.
+ *  smooth() runs the full backward pass over a whole run, for captures.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _RTS_SMOOTHER_h
+#define _RTS_SMOOTHER_h
+
+#include <cstddef>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "Eigen/StdVector"
+#include "state_history.h"
+
+#define RTS_LAG             0.5     // s, default delay of the fixed-lag output
+#define RTS_MAX_SAMPLES     512     // Filter states kept, more than the lag at the publish rate
+#define RTS_MAX_GAP         1.0     // s, a longer gap between two states starts over
+#define RTS_MIN_VARIANCE    1e-12   // Added to the predicted covariance, so states without process noise invert
+
+// Diagonals of the motion model of the filter
+typedef struct rts_model_s
+{
+    double transition[6];       // A over (p, v)
+    double processNoise[6];     // Q per PROCESS_NOISE_STEP
+}rts_model_t;
+
+typedef std::vector<StateSample, Eigen::aligned_allocator<StateSample> > StateSampleVector;
+
+class RTSSmoother
+{
+public:
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    RTSSmoother();
+
+    void setModel(const rts_model_t &model);
+    void setLag(double lag);
+    void reset();
+
+    // Filter state after the updates at its time, in time order
+    void add(const StateSample &filtered);
+
+    // The smoothed state lag behind the newest one, false if no new state passed the lag since the last output
+    bool output(StateSample &smoothed);
+
+    // Full-interval smoothing of the filter states of a run, in time order, in place
+    static void smooth(StateSampleVector &samples, const rts_model_t &model);
+
+    // One backward step: the smoothed state at filtered.t from the smoothed state after it
+    static void backwardStep(const rts_model_t &model, const StateSample &filtered, const StateSample &next, StateSample &smoothed);
+
+private:
+
+    const StateSample &at(size_t i) const { return ring[(head + i) % RTS_MAX_SAMPLES]; }
+
+    StateSample ring[RTS_MAX_SAMPLES];
+    size_t head, count;
+    double lag;
+    double lastOutput;          // s, time of the last smoothed state given out
+    rts_model_t model;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*************************************************
+ *
+ *  Short history of the filter estimates of one tag, for the state at any
+ *  time close to the last measurement. Between two estimates and past the
+ *  newest one the state is propagated with constant velocity from the
+ *  estimate before, the covariance with the cross terms and the process
+ *  noise of the elapsed time.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _STATE_HISTORY_h
+#define _STATE_HISTORY_h
+
+#include <mutex>
+
+#include "Eigen/Dense"
+
+#define STATE_HISTORY_SIZE     256     // Estimates kept, ~2.5 s of updates at 100 Hz
+#define STATE_HISTORY_HORIZON  0.5     // s, longest propagation past the newest estimate
+
+// Position and velocity with their covariance, time in s
+struct StateSample
+{
+    double t;
+    Eigen::Vector3d p;
+    Eigen::Vector3d v;
+    Eigen::Matrix<double, 6, 6> P;     // Over (p, v)
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/*
+ * One thread adds the estimates, any thread may query. The samples must be
+ * added in time order, an older one is dropped.
+ */
+class StateHistory
+{
+public:
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    StateHistory();
+
+    // Process noise added per second of propagation, diagonal over (p, v)
+    void setProcessNoise(const Eigen::Matrix<double, 6, 1> &rate);
+
+    void add(const StateSample &sample);
+    void clear();
+
+    // False before the oldest estimate, past STATE_HISTORY_HORIZON or without estimates
+    bool at(double t, StateSample &out) const;
+
+    // sample propagated to t
+    StateSample propagate(const StateSample &sample, double t) const;
+
+private:
+
+    mutable std::mutex mutex;
+    StateSample ring[STATE_HISTORY_SIZE];
+    size_t head;            // Next slot to write
+    size_t count;
+    Eigen::Matrix<double, 6, 1> noiseRate;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*************************************************
+ *
+ *  Host time of the tag clock, from the sync frames of the tag
+ *  (common/tdoa_protocol.h). A sync frame carries the tag clock at a USB
+ *  start of frame, so its read time minus that clock is the offset of the
+ *  two clocks plus the transfer to the read. The transfer only ever adds,
+ *  the lower envelope of those offsets is the offset plus the fastest
+ *  transfer. The minimum of every CLOCK_SYNC_BLOCK seconds is kept over
+ *  CLOCK_SYNC_BLOCKS blocks, and a line through those minima gives the
+ *  offset and the drift of the tag crystal.
+ *
+ *  The fastest transfer stays in the offset, it is not observable from the
+ *  host. It is the same for every tag on the bus, at most a USB frame.
+ *
+ *  Used by the thread that reads the port only.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TAG_CLOCK_SYNC_h
+#define _TAG_CLOCK_SYNC_h
+
+#include <cstdint>
+#include <cstddef>
+
+#define CLOCK_SYNC_BLOCK        1.0     // s of sync frames per minimum
+#define CLOCK_SYNC_BLOCKS       30      // Minima in the fit
+#define CLOCK_SYNC_GAP          8.0     // s without a sync frame after which the clock is synced anew, the 40-bit clock wraps in 17.2 s
+#define CLOCK_SYNC_STEP         0.1     // s off the fit after which the clock is synced anew
+#define CLOCK_SYNC_MAX_DRIFT    200e-6  // s/s, a steeper fit falls back to the lowest offset
+
+class TagClockSync
+{
+public:
+
+    TagClockSync();
+
+    void reset();
+
+    // tag in the 40-bit tag clock at the start of frame, read in s of host time
+    void addSync(uint64_t tag, double read);
+
+    // Once a sync frame arrived
+    bool valid() const { return synced; }
+    // s of host time of a tag timestamp within 8.6 s of the last sync frame
+    double toHost(uint64_t tag) const;
+
+    // Of the tag crystal against the host clock, 0 until there are two blocks
+    double getDriftPpm() const { return drift * 1e6; }
+    // s the last sync frame was read after the fit, its transfer beyond the fastest one
+    double getExcess() const { return excess; }
+
+private:
+
+    typedef struct clock_block_s
+    {
+        double tag;             // s of tag clock at the lowest offset
+        double offset;          // s, read - tag
+    }clock_block_t;
+
+    void fit();
+
+    bool synced;
+    uint64_t lastTag;
+    double tagTime;             // s of tag clock since the first sync frame, unwrapped
+    double lastRead;
+
+    clock_block_t blocks[CLOCK_SYNC_BLOCKS];
+    size_t head, count;         // blocks[head] is the block being filled
+    double blockStart;          // s of tag clock
+    double aboveSince;          // s of host time of the first read well above the fit, -1 without
+
+    // offset(t) = offset + drift * (t - fitTag)
+    double fitTag, offset, drift;
+    double excess;
+};
+
+#endif
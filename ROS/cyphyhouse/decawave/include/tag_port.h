@@ -0,0 +1,35 @@
+/*************************************************
+ *
+ *  Finds the tty of a tag by a name that survives re-enumeration. A tag
+ *  that resets or drops off the bus comes back as a new device, often under
+ *  another /dev/ttyACM number. A port named "serial:<number>" is the tty
+ *  whose USB device reports that serial number in sysfs, no udev rule
+ *  needed, and a symlink such as /dev/serial/by-id/... is followed to the
+ *  tty it points at now. Any other name is taken as it is.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TAG_PORT_h
+#define _TAG_PORT_h
+
+#include <cstdint>
+#include <string>
+
+#define TAG_PORT_SERIAL_PREFIX  "serial:"
+#define TAG_PORT_SYSFS          "/sys/class/tty"
+#define TAG_PORT_REOPEN_MS      100     // Between two attempts to find and open a tag that went away
+
+// The device path port stands for right now, false with the reason in error if the tag is not there
+bool resolveTagPort(const std::string &port, std::string &device, std::string &error);
+
+/*
+ * Identity of the device node, 0 if there is none. A tty created anew for a
+ * tag that re-enumerated under the same name is a new node, so a reader
+ * compares this to the node it opened to notice a port that went away.
+ */
+uint64_t tagPortNode(const std::string &device);
+
+#endif
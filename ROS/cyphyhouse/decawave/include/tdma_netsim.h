@@ -0,0 +1,301 @@
+/*************************************************
+ *
+ *  Discrete-event emulator of a whole TDOA network: the anchors of one or
+ *  more cells running the TDMA schedule of TREK_TDOA and tags listening to
+ *  them, on a shared simulated radio. For what the schedule does at scale,
+ *  which the anchors on a desk do not show: slot use, collisions between
+ *  cells sharing a radio, sync loss, failover and the pair rate every tag
+ *  gets, at many times real time.
+ *
+ *  The firmware itself does not build for the host (STM32 drivers, a global
+ *  context), so the anchor state machine of tdoa_anc.c is mirrored here
+ *  function by function, with the same names, on the shared TDMA and time
+ *  helpers (common/tdoa_tdma.h, tdoa_time.h, tdoa_phy.h). Keep the two in
+ *  step. The ToF ranging between the anchors and the clock filters of the
+ *  tag are left out, neither changes who transmits when.
+ *
+ *  Radio model:
+ *      - every anchor has its own crystal, a fixed offset plus random walk
+ *      - a frame is received if it starts inside an open receive window,
+ *        ends before it closes and is within range of the sender
+ *      - frames on the channel and preamble code of a receiver that overlap
+ *        at the receiver destroy each other, there is no capture
+ *      - a random loss on top, for fading
+ *      - receive timestamps carry white noise
+ *
+ *  A tag listens to the cell of the anchor nearest to it all the time and
+ *  counts a pair for every frame that follows one of another anchor of the
+ *  same frame, as the tag firmware pairs consecutive anchors.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDMA_NETSIM_h
+#define _TDMA_NETSIM_h
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <random>
+
+#include "tdoa.h"
+#include "tdoa_replay.h"
+#include "tdoa_tdma.h"
+#include "tdoa_phy.h"
+
+// TDMA constants of TREK_TDOA (tdoa_anc.h)
+#define NETSIM_DEFAULT_SLOTS        8           // TDMA_DEFAULT_SLOTS, anchor addresses per cell
+#define NETSIM_GUARD_LENGTH_NS      1000        // TDMA_GUARD_LENGTH_NS
+#define NETSIM_TURNAROUND_NS        80000       // TDMA_TURNAROUND_NS
+#define NETSIM_MARGIN_NS            30000       // TDMA_MARGIN_NS
+#define NETSIM_SYNC_MEAS_NOISE      10.0        // TDMA_SYNC_MEAS_NOISE, ticks
+#define NETSIM_SYNC_DRIFT_NOISE     6.4e3       // TDMA_SYNC_DRIFT_NOISE, ticks/s^2
+#define NETSIM_SYNC_GATE            640000      // TDMA_SYNC_GATE, ticks
+#define NETSIM_SYNC_HOLD_FRAMES     8           // TDMA_SYNC_HOLD_FRAMES
+#define NETSIM_MASTER_FRAMES        2           // TDMA_MASTER_FRAMES
+#define NETSIM_MASTER_LISTEN        32          // TDMA_MASTER_LISTEN
+#define NETSIM_ABSENT_FRAMES        16          // TDMA_ABSENT_FRAMES
+#define NETSIM_JOIN_EVERY           4           // TDMA_JOIN_EVERY
+#define NETSIM_MAC_HEADER_LENGTH    21          // MAC802154_HEADER_LENGTH
+#define NETSIM_FRAME_CRC            2           // FRAME_CRC
+#define NETSIM_TX_OFFSET(LEAD)      (((LEAD) & ~0x1FFLL) + 0x200)  // TDMA_TX_OFFSET
+#define NETSIM_TICKS_PER_S          (499.2e6 * 128)
+#define NETSIM_RX_TIMEOUT_UNIT      (512 / 499.2e6)                 // s, DW1000 receive timeout unit
+
+typedef struct netsim_config_s
+{
+    uint8_t addresses;      // Anchor addresses of the schedule the anchors start with, TDMA_DEFAULT_SLOTS
+    int cells;              // Copies of the layout, anchor i of every copy has address i
+    double cellSpacing;     // m along x between the copies
+    uint8_t phy;            // TDOA_PHY_*
+    uint8_t baseChan;       // Channel of cell 0
+    double clockPpm;        // Standard deviation of the anchor crystal offsets
+    double clockWalkPpm;    // ppm/sqrt(s) random walk of the crystals
+    double rxNoise;         // Ticks, standard deviation of a receive timestamp
+    double lossProb;        // Probability a frame in range is lost anyway
+    double range;           // m, link range
+    double startSpread;     // s, anchors power up at random within it
+    unsigned seed;
+}netsim_config_t;
+
+// An anchor off from time off and, if on > off, back on at on
+typedef struct netsim_outage_s
+{
+    int anchor;
+    double off;             // s
+    double on;              // s
+}netsim_outage_t;
+
+typedef struct netsim_anchor_stats_s
+{
+    uint32_t tx;
+    uint32_t lateTx;        // Transmit time already passed, as a failed delayed TX
+    uint32_t rxOk;
+    uint32_t rxErr;         // Collisions and losses inside a receive window
+    uint32_t rxTimeout;
+    uint32_t syncMissed;
+    uint32_t syncLost;
+    uint32_t failovers;
+    uint32_t resyncs;
+    double syncedTime;      // s synchronized
+}netsim_anchor_stats_t;
+
+typedef struct netsim_tag_stats_s
+{
+    uint32_t rx;
+    uint32_t lost;          // Collisions and losses
+    uint32_t pairs;
+}netsim_tag_stats_t;
+
+typedef struct netsim_cell_stats_s
+{
+    uint32_t tx;
+    double airtime;         // s of frames on the air
+    double slotTime;        // s of the slots those frames went out in
+}netsim_cell_stats_t;
+
+// Defaults: one cell of 8 addresses, standard profile on channel 5, 10 ppm crystals, 1% loss, 30 m range
+netsim_config_t defaultNetSimConfig();
+
+class TDMANetSim
+{
+public:
+
+    TDMANetSim(const anchor_layout_t &layout, const netsim_config_t &config);
+
+    // Tags at random positions in the box of the anchors, at 1 m
+    void addTags(int count);
+    void addOutage(const netsim_outage_t &outage);
+
+    // Runs until time s of simulated time
+    void run(double until);
+    double getTime() const { return now; }
+
+    int getCells() const { return config.cells; }
+    // Slot length of the schedule the anchors start with, s
+    double getSlotTime() const;
+
+    const netsim_anchor_stats_t &getAnchorStats(int a) const { return anchors[a].stats; }
+    bool isSynchronized(int a) const { return anchors[a].powered && anchors[a].synchronized; }
+    bool isMaster(int a) const;
+    int getAnchorCell(int a) const { return anchors[a].cell; }
+    int getAnchorAddress(int a) const { return anchors[a].anchorId; }
+    uint16_t getActive(int a) const { return anchors[a].active; }
+
+    size_t getTagCount() const { return tags.size(); }
+    const netsim_tag_stats_t &getTagStats(int t) const { return tags[t].stats; }
+    int getTagCell(int t) const { return tags[t].cell; }
+
+    const netsim_cell_stats_t &getCellStats(int c) const { return cellStats[c]; }
+
+private:
+
+    enum
+    {
+        EV_POWER_ON,
+        EV_POWER_OFF,
+        EV_TX_DONE,
+        EV_RX_TIMEOUT,
+        EV_ARRIVAL
+    };
+
+    enum
+    {
+        RX_OK,
+        RX_TO,
+        RX_ERR,
+        TX_OK
+    };
+
+    typedef struct event_s
+    {
+        double t;
+        uint64_t seq;           // Keeps events of the same time in order
+        int type;
+        int node;               // Anchor, or anchors.size() + tag for arrivals
+        uint64_t arg;           // Epoch of the radio operation, or packet
+        bool operator>(const struct event_s &e) const { return (t > e.t) || ((t == e.t) && (seq > e.seq)); }
+    }event_t;
+
+    // Range packet on the air, the fields of the header the TDMA handling reads
+    typedef struct packet_s
+    {
+        int sender;             // Anchor of the layout
+        uint8_t addr;
+        int cell;
+        int radio;              // Channel and preamble code
+        double start, airtime;  // s
+        double rmarker;         // s, true time of the transmit timestamp
+        uint8_t idx;
+        uint8_t anchors;
+        uint16_t slotUnits;
+        uint16_t active;
+        uint8_t join;
+        uint16_t entries;       // Anchors the sender heard in its last frame
+    }packet_t;
+
+    // State of tdoa_anc.c, named as in its ctx
+    typedef struct anchor_s
+    {
+        vec3d_t pos;
+        int cell, radio;
+        uint8_t anchorId;
+
+        bool powered;
+        uint64_t epoch;         // Of the pending radio operation, stale events carry older ones
+        bool rxOpen;
+        double rxStart;         // s
+
+        // Crystal, local = clockLocal + (t - clockTrue) * TICKS * (1 + ppm)
+        double clockTrue, clockLocal, ppm;
+
+        bool synchronized;
+        int slotState;          // TX_OK or RX_OK, the operation set up for the next slot
+        uint8_t anchors, nslots, ownSlot, slot, nextSlot, join, lastJoin, idx;
+        uint16_t slotUnits, active, heard, rxValid;
+        int64_t slotLen, frameLen, frameStart;
+        int32_t syncRate, syncAlpha, syncBeta;
+        uint8_t syncCount, syncMisses, masterMisses;
+        uint32_t listenCount, frames;
+        uint8_t absent[TDOA_MAX_ANCHORS];
+        double syncedSince;
+
+        netsim_anchor_stats_t stats;
+    }anchor_t;
+
+    typedef struct tag_s
+    {
+        vec3d_t pos;
+        int cell, radio;
+        int lastSender;
+        double lastRx;
+        netsim_tag_stats_t stats;
+    }tag_t;
+
+    void schedule(double t, int type, int node, uint64_t arg);
+    void handle(const event_t &e);
+
+    // Radio
+    int64_t localAt(const anchor_t &a, double t) const;
+    double trueAt(const anchor_t &a, int64_t local) const;
+    void advanceClock(anchor_t &a);
+    void startTx(int a, int64_t txTime);
+    void startRx(int a, int64_t rxTime, bool immediate);
+    void arrival(int node, uint64_t id);
+    bool collided(const packet_t &p, const vec3d_t &pos, int self, double start, double end) const;
+    double distance(const vec3d_t &a, const vec3d_t &b) const;
+    packet_t *packet(uint64_t id);
+
+    // tdoa_anc.c
+    void powerOn(int a);
+    void setTdmaSchedule(anchor_t &a, uint8_t n, uint16_t slotUnits);
+    void setTdmaSlots(anchor_t &a, uint16_t active, uint8_t join);
+    void syncFilterReset(anchor_t &a, bool fromMaster);
+    void syncMissed(anchor_t &a);
+    void masterMissed(anchor_t &a);
+    void listenOrStart(int a);
+    void syncFilterUpdate(anchor_t &a, int64_t rxTime);
+    void updateMembership(anchor_t &a);
+    void setupTx(int a);
+    void setupRx(int a);
+    void updateSlot(anchor_t &a);
+    void slotStep(int a, int event, const packet_t *p, int64_t rxTime);
+    void rxOk(int a, const packet_t &p, int64_t rxTime);
+    void rxOkUnsynchronized(int a, const packet_t &p, int64_t rxTime);
+    void rxFailed(int a, int event);
+    void txDone(int a);
+    void setSynchronized(anchor_t &a, bool synced);
+
+    void tagRx(tag_t &t, const packet_t &p);
+
+    netsim_config_t config;
+    std::vector<anchor_t> anchors;
+    std::vector<tag_t> tags;
+    std::vector<netsim_cell_stats_t> cellStats;
+
+    // Airtime figures of the profile, tdoa_anc.c
+    int64_t txLead;         // Ticks from the slot start to the RMARKER
+    double preambleTime;    // s
+    double packetKeep;      // s a frame stays in packets after its end
+    uint32_t rxTimeout;     // NETSIM_RX_TIMEOUT_UNIT
+    uint16_t defaultSlotUnits;
+    uint32_t preambleTimeNs() const;
+    uint32_t frameTimeNs(uint16_t length) const;
+    uint16_t tdmaSlotUnits(uint8_t n) const;
+
+    std::priority_queue<event_t, std::vector<event_t>, std::greater<event_t> > events;
+    uint64_t seq;
+    double now;
+
+    std::deque<packet_t> packets;
+    uint64_t packetBase;    // Id of packets.front()
+
+    std::mt19937 gen;
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> uniform;
+};
+
+#endif
@@ -9,6 +9,21 @@
  *  Author: Joao Paulo Jansch Porto <janschp2(at)illinois.edu>
  *
  *  Changelog:
+ *      v0.18 - Convex hull of the active anchors, inflated noise and iterated updates outside of it
+ *      v0.17 - Innovations of every pair to a flight recorder
+ *      v0.16 - Innovations of every pair to a consistency monitor
+ *      v0.15 - Local frame around a double precision origin
+ *      v0.14 - Active anchor set of the tag's zone, pairs outside it are rejected
+ *      v0.13 - Nine state variant with accelerometer bias for the inertial filter
+ *      v0.12 - Pair innovation without an update, for the anchor health
+ *      v0.11 - Steady-state gain mode without covariance propagation
+ *      v0.10 - Position dependent pair noise from a precomputed NoiseMap
+ *      v0.9 - Position update shared with the lanes of TDOAFleet
+ *      v0.8 - State access and innovation likelihood for multiple model estimators
+ *      v0.7 - Per anchor pair adaptive measurement noise
+ *      v0.6 - Iterated EKF linearization option
+ *      v0.5 - Optional UD factorized covariance with Bierman/Thornton updates
+ *      v0.4 - Fixed-size filter templated on state dimension and scalar type
  *      v0.3 - Added extra library functions (06/26/2017)
  *      v0.2 - initial release (06/19/2017)
  *
@@ -23,8 +38,13 @@
 #include <cstring>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 #include <Eigen/Dense>
 
+#include "tdoa_tdma.h"
+#include "tdoa_lanes.h"
+#include "anchor_hull.h"
+
 #define STATE_X   0
 #define STATE_Y   1
 #define STATE_Z   2
@@ -33,11 +53,82 @@
 #define STATE_VZ  5
 #define STATE_DIM 6
 
-#define MAX_NR_ANCHORS 8
+// Accelerometer bias of TDOAInertial, after position and velocity
+#define STATE_BAX 6
+#define STATE_BAY 7
+#define STATE_BAZ 8
+#define INERTIAL_STATE_DIM 9
+
+#define MAX_NR_ANCHORS TDOA_MAX_ANCHORS // Same limit as the anchor and tag firmware
+
+#define PROCESS_NOISE_STEP 0.01 // s, time step the process noise matrix Q is given for
+
+#define BOOTSTRAP_MIN_ANCHORS 5    // Reference plus 4 others, one per unknown of the linear solve
+#define BOOTSTRAP_GN_ITERATIONS 5  // Gauss-Newton refinements of the closed-form solution
+
+#define GEOMETRY_CACHE_TOL 0.01 // m, position change before the anchor geometry is relinearized
+
+#define IEKF_DEFAULT_ITERATIONS 3  // Relinearizations per update in TDOA_LINEARIZE_ITERATED
+#define IEKF_MAX_ITERATIONS 10
+#define IEKF_STEP_TOL 1e-3         // m, iterate change below which the iteration stops
+
+#define ADAPTIVE_NOISE_RATE 0.005    // Default weight of a new innovation in the per-pair noise estimate
+#define ADAPTIVE_NOISE_MIN_STD 0.01  // m, bounds of the estimated per-pair standard deviation
+#define ADAPTIVE_NOISE_MAX_STD 1.0
+
+#define HULL_MARGIN 0.3f          // m, past the anchor hull before the filter switches to the outside mode
+#define HULL_HYSTERESIS 0.2f      // m, closer than the margin by this before it switches back
+#define HULL_NOISE_SCALE 2.0f     // Measurement standard deviations outside the hull, times those inside
 
 #define MAX_COVARIANCE 100
 #define MIN_COVARIANCE 1e-6f
 
+// Covariance update used by scalarTDOADistUpdate
+typedef enum
+{
+    TDOA_UPDATE_GENERAL = 0,    // Full P*H' and (I-K*H)*P + K*R*K' on the whole state
+    TDOA_UPDATE_SPARSE,         // Uses only the position columns of P and a rank-1 update
+} tdoa_update_mode_t;
+
+// Representation of the state covariance
+typedef enum
+{
+    TDOA_COVARIANCE_FULL = 0,   // P stored directly, symmetrized and bounded after every step
+    TDOA_COVARIANCE_UD,         // P = U*D*U' with U unit upper triangular, positive definite by construction
+    TDOA_COVARIANCE_STEADY,     // Not propagated, precomputed steady-state gains of a GainTable
+} tdoa_covariance_mode_t;
+
+// Where the measurement model is linearized
+typedef enum
+{
+    TDOA_LINEARIZE_ONCE = 0,    // At the predicted position (EKF)
+    TDOA_LINEARIZE_ITERATED,    // Relinearized at the updated position, bounded iterations (IEKF)
+} tdoa_linearization_mode_t;
+
+// How batchTDOAUpdate applies the measurements of one TDMA frame
+typedef enum
+{
+    TDOA_BATCH_JOINT = 0,       // Stack all pairs into one vector update
+    TDOA_BATCH_SEQUENTIAL,      // Apply the pairs as consecutive scalar updates
+} tdoa_batch_mode_t;
+
+// Down-weighting of large innovations, applied after gating
+typedef enum
+{
+    TDOA_ROBUST_NONE = 0,
+    TDOA_ROBUST_HUBER,          // Weight k/|r| beyond k normalized innovations
+    TDOA_ROBUST_CAUCHY,         // Weight 1/(1 + (r/k)^2)
+} tdoa_robust_mode_t;
+
+// One TDOA measurement between reference anchor Ar and anchor An
+typedef struct tdoa_meas_s
+{
+    uint8_t Ar;
+    uint8_t An;
+    float   distanceDiff;
+    double  timestamp;      // s, time of validity (0 if unknown)
+}tdoa_meas_t;
+
 typedef struct vec3d_s
 {
     float   x;
@@ -45,59 +136,242 @@ typedef struct vec3d_s
     float   z;
 }vec3d_t;
 
-class TDOA
+/*
+ * All matrices are sized at compile time, so the filter never allocates after
+ * construction and Eigen can fully unroll the 6x6 products.
+ * Definitions live in tdoa.cpp, which instantiates the supported
+ * <NStates, Scalar> combinations (6 states, float and double).
+ */
+class NoiseMap;
+class GainTable;
+class FilterConsistency;
+class FlightRecorderRing;
+
+template <int NStates = STATE_DIM, typename Scalar = float>
+class TDOAFilter
 {
+    static_assert(NStates >= STATE_DIM, "TDOA filter needs at least position and velocity states");
+
 public:
     
+    typedef Eigen::Matrix<Scalar, NStates, 1> StateVector;
+    typedef Eigen::Matrix<Scalar, NStates, NStates> StateMatrix;
+    typedef Eigen::Matrix<Scalar, 1, NStates> MeasurementRow;
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> DynamicMatrix;
+    
     // Contructor
-    TDOA();
-    TDOA(const Eigen::MatrixXf transition_mat, const Eigen::MatrixXf prediction_mat, const Eigen::MatrixXf covariance_mat, const vec3d_t init_pos);
+    TDOAFilter();
+    TDOAFilter(const DynamicMatrix &transition_mat, const DynamicMatrix &prediction_mat, const DynamicMatrix &covariance_mat, const vec3d_t init_pos);
     
     // Set Functions
-    void setTransitionMat(const Eigen::MatrixXf transition_mat);
-    void setPredictionMat(const Eigen::MatrixXf prediction_mat);
-    void setCovarianceMat(const Eigen::MatrixXf covariance_mat);
+    void setTransitionMat(const DynamicMatrix &transition_mat);
+    void setPredictionMat(const DynamicMatrix &prediction_mat);
+    void setCovarianceMat(const DynamicMatrix &covariance_mat);
     
     void setAncPosition(const int anc_num, const vec3d_t anc_pos);
     void setAncPosition(const int anc_num, const float x, const float y, const float z);
+    // Replaces every anchor with the count anchors of the tag's zone (its cell), the slots from count on become
+    // inactive. The pairs of a slot whose anchor moved start over: reject count and adaptive noise
+    void setActiveAnchors(const vec3d_t *anchors, int count);
+    // Runs the filter in a frame centered on origin (site coordinates, e.g. the middle of the tag's cell), so the
+    // float geometry only sees short distances. The estimate keeps its site position. Positions in and out of
+    // the filter stay site coordinates, only getState, setState and the state of initFromFrame are local
+    void setOrigin(const Eigen::Vector3d &origin);
     
     void setInitPos(vec3d_t init_pos);
     
     void setStdDev(float sdev);
+    void setUpdateMode(tdoa_update_mode_t mode);
+    void setCovarianceMode(tdoa_covariance_mode_t mode);
+    void setLinearizationMode(tdoa_linearization_mode_t mode, int iterations = IEKF_DEFAULT_ITERATIONS);
+    void setGateThreshold(float threshold);
+    void setRobustMode(tdoa_robust_mode_t mode, float k);
+    void setAdaptiveNoise(bool enable, float rate = ADAPTIVE_NOISE_RATE);
+    void setLikelihoodTracking(bool enable);
+    // Takes the NIS of every pair the filter screens or applies, NULL for none. Not owned
+    void setConsistencyMonitor(FilterConsistency *monitor);
+    // Records the innovation of every pair as tag into ring, NULL for none. Not owned
+    void setFlightRecorder(FlightRecorderRing *ring, uint8_t tag);
+    // Tests the position against the hull of the active anchors on every predict step. Once it is margin
+    // outside, the pairs get noiseScale times their standard deviation and, with iterate, the iterated
+    // linearization, until the position is back within margin - HULL_HYSTERESIS
+    void setHullMode(bool enable, float margin = HULL_MARGIN, float noiseScale = HULL_NOISE_SCALE, bool iterate = true);
+    // Scales the noise of every pair by the map at the current position, NULL for stdDev everywhere.
+    // The map is not owned and must outlive its use. Adaptive noise takes precedence
+    void setNoiseMap(const NoiseMap *map);
+    // Gains of TDOA_COVARIANCE_STEADY, not owned. Without one that mode ignores the measurements
+    void setGainTable(const GainTable *table);
     
-    // Update functions
-    void scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff);
+    // Replaces state, covariance and state time, e.g. with the mixed estimate of an IMM
+    void setState(const StateVector &state, const StateMatrix &covariance, double t);
+    
+    // Update functions. A variance [m^2] above 0, the one the tag sent with the measurement, replaces the filter's own
+    void scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance = 0);
+    // Everything scalarTDOADistUpdate does before the update itself, false if the measurement was rejected
+    bool prepareScalarUpdate(uint8_t Ar, uint8_t An, float distanceDiff, Eigen::Matrix<Scalar, 3, 1> &h, Scalar &error, Scalar &stdMeasNoise,
+                             float variance = 0);
+    /*
+     * The measurements of one TDMA frame, with the variances of the tag as for
+     * scalarTDOADistUpdate (NULL for none). The joint mode stacks at most
+     * MAX_NR_ANCHORS pairs, a larger frame is applied as consecutive joint
+     * updates of that many pairs, each linearized at its own newest time.
+     */
+    void batchTDOAUpdate(const tdoa_meas_t *meas, size_t count, tdoa_batch_mode_t mode, const float *variance = NULL);
+    bool initFromFrame(const tdoa_meas_t *meas, size_t count);
     void stateEstimatorPredict(const double dt);
     void stateEstimatorFinalize();
     void stateEstimatorAddProcessNoise();
+    void stateEstimatorPredictTo(const double t);
     
     
     // Get functions
     vec3d_t getLocation();
 	vec3d_t getVelocity();
     vec3d_t getAncPosition(const int anc_num);
+    int getAnchorCount() const { return anchorCount; }
+    const Eigen::Vector3d &getOrigin() const { return origin; }
+    double getTime();
+    StateMatrix getCovariance();
+    uint32_t getRejectCount(const int Ar, const int An);
+    // True if the update of scalarTDOADistUpdate is tdoaPositionUpdate, so TDOAFleet can run it
+    bool lockstepCompatible();
+    float getPairStdDev(const int Ar, const int An);
+    // The filter runs in the outside mode of setHullMode, and the distance to the hull at the last predict (m, below 0 inside)
+    bool isOutsideHull() const { return outsideHull; }
+    float getHullDistance() const { return hullDistance; }
+    // Innovation of a pair and its variance HPH'+R at the current state without applying it, false for an invalid pair
+    bool pairInnovation(uint8_t Ar, uint8_t An, float distanceDiff, Scalar &error, Scalar &HPHR);
+    StateVector getState();
+    // Log-likelihood of the innovations since the last call, 0 unless likelihood tracking is on
+    double takeLogLikelihood();
+    
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    
+    // Gathers S and P into its lanes and scatters them back
+    friend class TDOAFleet;
+    // Predicts S and P with the accelerometer and takes the settings of a TDOA
+    friend class TDOAInertial;
+    // Takes the settings and the active anchors of the filter of its first tag
+    friend class TDOAPose;
     
 private:
     
     //variables
     uint32_t tdoaCount;
-    uint32_t nr_states;
-    float stdDev;
+    Scalar stdDev;
+    tdoa_update_mode_t updateMode;
+    tdoa_covariance_mode_t covarianceMode;
+    tdoa_linearization_mode_t linearizationMode;
+    int maxIterations;
+    
+    // Mahalanobis gate on error^2/HPHR (0 disables) and robust reweighting
+    Scalar gateThreshold;
+    tdoa_robust_mode_t robustMode;
+    Scalar robustK;
+    uint32_t rejectCount[MAX_NR_ANCHORS][MAX_NR_ANCHORS];
+    
+    // Exponentially weighted measurement variance per pair, row Ar and column An.
+    // Starts at stdDev^2 and is only used when adaptiveNoise is set
+    bool adaptiveNoise;
+    Scalar adaptiveRate;
+    Eigen::Matrix<Scalar, MAX_NR_ANCHORS, MAX_NR_ANCHORS> pairVariance;
+    
+    const NoiseMap *noiseMap;
+    const GainTable *gainTable;
+    
+    // Sum of the Gaussian log-likelihoods of the innovations, for model probabilities
+    bool likelihoodTracking;
+    double logLikelihood;
     
+    FilterConsistency *consistency;
+    FlightRecorderRing *recorder;
+    uint8_t recorderTag;
+    
+    // Hull of the active anchors in the local frame, rebuilt at the next predict once hullValid is cleared.
+    // hullNoise is the scale of the measurement standard deviations in effect, 1 inside
+    bool hullMode;
+    bool hullValid;
+    bool hullIterate;
+    bool outsideHull;
+    Scalar hullMargin;
+    Scalar hullNoiseScale;
+    Scalar hullNoise;
+    float hullDistance;
+    AnchorHull hull;
+    
+    // Time of validity of the state, set by the first stateEstimatorPredictTo
+    double stateTime;
+    bool stateTimeValid;
+    
+    // Slots 0 to anchorCount-1 are the active anchors, all of them until setActiveAnchors.
+    // Measurements of the other slots are dropped and the geometry cache covers only these
     vec3d_t anchorPosition[MAX_NR_ANCHORS];
+    int anchorCount;
+    // Site coordinates of the zero of the state and anchorSoA
+    Eigen::Vector3d origin;
+    // Same positions relative to origin as structure-of-arrays (one column per axis) for the batch update
+    Eigen::Matrix<Scalar, MAX_NR_ANCHORS, 3> anchorSoA;
+    
+    // Tag-to-anchor distances and unit vectors at the linearization point cachePoint,
+    // filled lazily per anchor (bit k of cacheValid) and columns stored per axis
+    Eigen::Matrix<Scalar, 3, 1> cachePoint;
+    Eigen::Matrix<Scalar, MAX_NR_ANCHORS, 1> cacheDist;
+    Eigen::Matrix<Scalar, MAX_NR_ANCHORS, 3> cacheUnit;
+    uint32_t cacheValid;
     
     // Matrices used by the kalman filter
-    Eigen::VectorXf S;
-    Eigen::MatrixXf P;
-    Eigen::MatrixXf A;
-    Eigen::MatrixXf Q;
+    StateVector S;
+    StateMatrix P;
+    StateMatrix A;
+    StateMatrix Q;
+    // A is the identity but the velocity diagonal and the couplings of propagateState, see predictCovariance
+    bool structuredTransition;
+    
+    // UD factors of P and Q in TDOA_COVARIANCE_UD mode. P is then only a copy
+    // of U*D*U' kept for the gates and getCovariance
+    StateMatrix U;
+    StateVector D;
+    StateMatrix Uq;
+    StateVector Dq;
     
     //Functions
-    void stateEstimatorScalarUpdate(Eigen::RowVectorXf H, float error, float stdMeasNoise);
+    void stateEstimatorScalarUpdate(const MeasurementRow &H, Scalar error, Scalar stdMeasNoise);
+    void stateEstimatorPositionUpdate(const Eigen::Matrix<Scalar, 3, 1> &h, Scalar error, Scalar stdMeasNoise);
+    void steadyStateUpdate(uint8_t Ar, uint8_t An, float distanceDiff);
     
     void PredictionBound();
+    
+    static void factorUD(const StateMatrix &M, StateMatrix &Uf, StateVector &Df, Scalar minPivot);
+    void biermanUpdate(const MeasurementRow &H, Scalar error, Scalar R);
+    void rankOneUpdate(StateVector a, Scalar c);
+    void thorntonPredict(const StateMatrix &Phi, Scalar qScale);
+    void propagateState(const double dt);
+    void checkHull();
+    bool iterated() const { return (linearizationMode == TDOA_LINEARIZE_ITERATED) || (outsideHull && hullIterate); }
+    void predictCovariance();
+    
+    bool activePair(uint8_t Ar, uint8_t An) const { return (Ar < anchorCount) && (An < anchorCount) && (Ar != An); }
+    void resetAnchorPairs(int anc_num);
+    void storeAnchor(int anc_num, const vec3d_t &anc_pos);
+    // Position of the state in site coordinates, for the tables computed on the layout
+    Eigen::Matrix<Scalar, 3, 1> sitePosition() const { return (S.template head<3>().template cast<double>() + origin).template cast<Scalar>(); }
+    void relinearizeGeometry(bool force);
+    void updateAnchorGeometry(int anc_num);
+    void pairGeometry(uint8_t Ar, uint8_t An, const Eigen::Matrix<Scalar, 3, 1> &pos, Eigen::Matrix<Scalar, 3, 1> &h, Scalar &dist);
+    void iterateLinearization(uint8_t Ar, uint8_t An, Scalar measurement, Scalar R, Eigen::Matrix<Scalar, 3, 1> &hp, Scalar &error);
+    
+    bool screenMeasurement(uint8_t Ar, uint8_t An, Scalar error, Scalar HPHR, Scalar &stdMeasNoise);
+    Scalar pairStdDev(uint8_t Ar, uint8_t An);
+    void addLikelihood(Scalar nis, Scalar logDet, int dims);
+    void addInnovation(uint8_t Ar, uint8_t An, Scalar error, Scalar HPHR, bool rejected);
+    void adaptPairNoise(uint8_t Ar, uint8_t An, Scalar error, Scalar HPH);
 
 };
 
+// Default engine used by the ROS nodes
+typedef TDOAFilter<STATE_DIM, float> TDOA;
+// Engine of TDOAInertial
+typedef TDOAFilter<INERTIAL_STATE_DIM, float> TDOAInertialFilter;
+
 #endif
 
@@ -0,0 +1,172 @@
+/*************************************************
+ *
+ *  Compressed columnar archive of a tdoa_node capture (.tdc), for keeping
+ *  and uploading hours of recordings. The records are cut into chunks of
+ *  ARCHIVE_CHUNK_RECORDS, and every chunk stores each column on its own,
+ *  encoded and then deflated (zlib):
+ *      time        zigzag varint of the difference to the previous record
+ *      vicon       per axis, quantized to ARCHIVE_VICON_LSB, varint differences
+ *      valid       varint
+ *      tdoa        per slot, quantized to ARCHIVE_TDOA_LSB, varint differences
+ *                  over the records where the slot is valid
+ *      ref         per slot, one byte where the slot is valid
+ *      arrival     per slot, varint differences where the slot is valid
+ *  Each chunk starts its differences from zero, so chunks decode on their
+ *  own and in parallel, and a reader inflates only the columns it asks for.
+ *  Invalid slots read back as zero, as tdoa_node leaves them. The distance
+ *  differences and Vicon positions are rounded to 0.1 mm, far below their
+ *  noise; everything else is exact.
+ *
+ *  File layout, little-endian:
+ *      tdoa_archive_header_t, with the header of the capture
+ *      chunks, the columns of each one after the other in column order
+ *      index, one tdoa_archive_chunk_t per chunk
+ *      tdoa_archive_footer_t
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_ARCHIVE_h
+#define _TDOA_ARCHIVE_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tdoa_capture.h"
+
+#define TDOA_ARCHIVE_MAGIC      0x52414454 // "TDAR"
+#define TDOA_ARCHIVE_VERSION    1
+
+#define ARCHIVE_CHUNK_RECORDS   4096    // Records per chunk, about 8 min of 8 anchors at 10 Hz rotations
+#define ARCHIVE_TDOA_LSB        1e-4    // m, quantum of the distance differences
+#define ARCHIVE_VICON_LSB       1e-4    // m, quantum of the Vicon positions
+#define ARCHIVE_ZLIB_LEVEL      6
+
+typedef enum
+{
+    ARCHIVE_COL_TIME = 0,
+    ARCHIVE_COL_VICON,
+    ARCHIVE_COL_VALID,
+    ARCHIVE_COL_TDOA,
+    ARCHIVE_COL_REF,
+    ARCHIVE_COL_ARRIVAL,
+    ARCHIVE_COLUMNS
+} tdoa_archive_column_t;
+
+#define ARCHIVE_COLUMN(c)       (1u << (c))
+#define ARCHIVE_ALL_COLUMNS     ((1u << ARCHIVE_COLUMNS) - 1)
+
+typedef struct tdoa_archive_header_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columns;           // ARCHIVE_COLUMNS
+    uint32_t chunkRecords;      // ARCHIVE_CHUNK_RECORDS of the writer, the last chunk may hold fewer
+    uint32_t reserved;
+    double   tdoaLsb;           // m
+    double   viconLsb;          // m
+    tdoa_capture_header_t capture;
+}tdoa_archive_header_t;
+
+typedef struct tdoa_archive_chunk_s
+{
+    uint64_t offset;            // First byte of the chunk in the file
+    uint32_t records;
+    uint32_t reserved;
+    uint64_t firstTimeUs;
+    uint64_t lastTimeUs;
+    uint32_t size[ARCHIVE_COLUMNS];     // Bytes of each column in the file, deflated
+    uint32_t rawSize[ARCHIVE_COLUMNS];  // Bytes of each column once inflated
+}tdoa_archive_chunk_t;
+
+typedef struct tdoa_archive_footer_s
+{
+    uint64_t indexOffset;
+    uint32_t chunks;
+    uint32_t magic;
+}tdoa_archive_footer_t;
+
+static_assert(sizeof(tdoa_archive_header_t) == 32 + TDOA_CAPTURE_HEADER_SIZE, "Archive header layout changed");
+static_assert(sizeof(tdoa_archive_chunk_t) == 32 + 8*ARCHIVE_COLUMNS, "Archive chunk index layout changed");
+static_assert(sizeof(tdoa_archive_footer_t) == 16, "Archive footer layout changed");
+
+/*
+ * Writes an archive in one pass. Records are buffered until a chunk is
+ * full, which is then encoded, deflated and written from the calling
+ * thread, so it is meant for tools and the end of a capture rather than the
+ * serial reader.
+ */
+class TDOAArchiveWriter
+{
+public:
+
+    TDOAArchiveWriter();
+    ~TDOAArchiveWriter();
+
+    // Creates a new file (never an existing one) and writes the header
+    bool open(const std::string &path, const tdoa_capture_header_t &capture);
+    bool append(const tdoa_capture_record_t &record);
+    // Writes the last chunk, the index and the footer. False if any write failed
+    bool close();
+
+    uint64_t getRecordCount() const { return records; }
+    uint64_t getBytes() const { return offset; }
+
+private:
+
+    bool flushChunk();
+    bool write(const void *data, size_t len);
+
+    FILE *file;
+    bool failed;
+    uint64_t offset;
+    uint64_t records;
+    std::vector<tdoa_capture_record_t> chunk;
+    std::vector<tdoa_archive_chunk_t> index;
+};
+
+/*
+ * Reads an archive by chunk. readChunk only reads and inflates the columns
+ * of its mask, the valid column comes along with any of the per slot ones;
+ * the fields of the other columns are zero. Chunks are read with pread, so
+ * any number of threads may read chunks of one reader at once.
+ */
+class TDOAArchiveReader
+{
+public:
+
+    TDOAArchiveReader();
+    ~TDOAArchiveReader();
+
+    // Fails on a missing file, wrong magic or version, or a missing index (a writer that never closed)
+    bool open(const std::string &path);
+    void close();
+
+    const tdoa_archive_header_t &getHeader() const { return header; }
+    size_t getChunkCount() const { return index.size(); }
+    const tdoa_archive_chunk_t &getChunk(size_t c) const { return index[c]; }
+    uint64_t size() const { return count; }
+
+    // The records of chunk c into out, which holds getChunk(c).records
+    bool readChunk(size_t c, uint32_t columns, tdoa_capture_record_t *out) const;
+    // All records in order, the chunks decoded on threads workers (0 for one per hardware thread)
+    bool readAll(uint32_t columns, std::vector<tdoa_capture_record_t> &out, unsigned threads = 0) const;
+
+private:
+
+    TDOAArchiveReader(const TDOAArchiveReader &);
+    TDOAArchiveReader &operator=(const TDOAArchiveReader &);
+
+    int fd;
+    tdoa_archive_header_t header;
+    std::vector<tdoa_archive_chunk_t> index;
+    std::vector<uint64_t> first;    // Record number of the first record of each chunk
+    uint64_t count;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*************************************************
+ *
+ *  Binary append-only capture format for tdoa_node.
+ *  A file is one fixed-size header (anchor layout and session info) followed
+ *  by fixed-size records, all little-endian with natural alignment so a
+ *  record can be read back with a single copy.
+ *
+ *  The writer never touches the disk from the caller's thread: records are
+ *  copied into large page-aligned blocks and a dedicated thread writes full
+ *  blocks out. If the disk falls behind by more than the block pool, new
+ *  records are dropped and counted rather than stalling the serial reader.
+ *
+ *  Changelog:
+ *      v0.3 - Version 2 records keep partial rotations with per-slot validity
+ *      v0.2 - Memory-mapped reader with a sparse time index
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_CAPTURE_h
+#define _TDOA_CAPTURE_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#define TDOA_CAPTURE_MAGIC        0x50434454 // "TDCP"
+#define TDOA_CAPTURE_VERSION      2
+#define TDOA_CAPTURE_MAX_ANCHORS  8
+#define TDOA_CAPTURE_HEADER_SIZE  256
+
+#define CAPTURE_BLOCK_SIZE     65536 // bytes per write
+#define CAPTURE_BLOCK_COUNT    8     // blocks that can wait for the disk
+#define CAPTURE_FLUSH_MS       1000  // longest time a partial block stays in memory
+
+#define CAPTURE_INDEX_STRIDE   1024  // records per entry of the time index
+
+typedef struct tdoa_capture_header_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t anchorCount;
+    uint32_t reserved;
+    int64_t  startTimeUs;       // wall clock at the start of the capture, us since the epoch
+    float    anchorPos[TDOA_CAPTURE_MAX_ANCHORS][3];
+    char     robotType[32];
+    char     viconObj[32];
+    uint8_t  pad[TDOA_CAPTURE_HEADER_SIZE - 24 - TDOA_CAPTURE_MAX_ANCHORS*12 - 64];
+}tdoa_capture_header_t;
+
+/*
+ * One anchor rotation, complete or not. Slot k holds the pair that ended on
+ * anchor k, whatever anchor it started from, and is only meaningful when bit
+ * k of valid is set. A rotation ends when an anchor number repeats or goes
+ * back, so slots lost on the air are simply left invalid.
+ */
+typedef struct tdoa_capture_record_s
+{
+    uint64_t timeUs;            // arrival of the first pair, since the start of the capture
+    float    vicon[3];          // m, last Vicon position when the rotation ended
+    uint32_t valid;             // bit k set if slot k holds a pair
+    float    tdoa[TDOA_CAPTURE_MAX_ANCHORS];      // m, distance difference of the pair (ref[k], k)
+    uint8_t  ref[TDOA_CAPTURE_MAX_ANCHORS];       // reference anchor Ar of slot k
+    uint32_t arrivalUs[TDOA_CAPTURE_MAX_ANCHORS]; // arrival of slot k after timeUs
+}tdoa_capture_record_t;
+
+static_assert(sizeof(tdoa_capture_header_t) == TDOA_CAPTURE_HEADER_SIZE, "Capture header layout changed");
+static_assert(sizeof(tdoa_capture_record_t) == 96, "Capture record layout changed");
+static_assert(CAPTURE_BLOCK_SIZE >= sizeof(tdoa_capture_record_t), "Capture block smaller than a record");
+
+// Header with the magic, version and record size filled in and everything else zeroed
+tdoa_capture_header_t makeCaptureHeader();
+
+/*
+ * Text row of a record: the tdoa_node text log columns (time_us, vicon xyz,
+ * tdoa_0..7) with nan for the invalid slots, followed by ref_0..7 and
+ * arrival_us_0..7. Returns the snprintf length.
+ */
+int formatCaptureRow(const tdoa_capture_record_t &record, char *buf, size_t len);
+
+class TDOACaptureWriter
+{
+public:
+
+    TDOACaptureWriter();
+    ~TDOACaptureWriter();
+
+    // Creates a new file (never an existing one), writes the header and starts the writer thread
+    bool open(const std::string &path, const tdoa_capture_header_t &header);
+    // Writes out everything still buffered and stops the writer thread
+    void close();
+
+    // Called from a single producer thread, never blocks on the disk
+    bool append(const tdoa_capture_record_t &record);
+
+    uint64_t getRecordCount() const { return records.load(std::memory_order_relaxed); }
+    uint64_t getDropCount() const { return drops.load(std::memory_order_relaxed); }
+
+private:
+
+    typedef struct block_s
+    {
+        uint8_t *data;
+        size_t   len;
+    }block_t;
+
+    void writerLoop();
+
+    int fd;
+    bool running;
+    std::thread writer;
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::vector<block_t> freeBlocks;
+    std::deque<block_t> fullBlocks;
+    block_t active;
+
+    std::atomic<uint64_t> records;
+    std::atomic<uint64_t> drops;
+};
+
+// Sequential reader, for tools that go through a capture once
+class TDOACaptureReader
+{
+public:
+
+    TDOACaptureReader();
+    ~TDOACaptureReader();
+
+    // Fails on a missing file, wrong magic or an unknown version/record size
+    bool open(const std::string &path);
+    void close();
+
+    const tdoa_capture_header_t &getHeader() const { return header; }
+    bool next(tdoa_capture_record_t &record);
+
+private:
+
+    FILE *file;
+    tdoa_capture_header_t header;
+};
+
+// Contiguous run of records inside a mapped capture
+typedef struct tdoa_capture_span_s
+{
+    const tdoa_capture_record_t *data;
+    size_t count;
+
+    const tdoa_capture_record_t *begin() const { return data; }
+    const tdoa_capture_record_t *end() const { return data + count; }
+}tdoa_capture_span_t;
+
+/*
+ * Read-only random access to a capture. The file is mapped and records are
+ * used in place, nothing is parsed or copied. The index keeps the time of
+ * every CAPTURE_INDEX_STRIDE-th record, so a time lookup is a binary search
+ * over the index and then over a single stride. Record times are assumed
+ * non-decreasing, which is how tdoa_node writes them.
+ */
+class TDOACaptureMap
+{
+public:
+
+    TDOACaptureMap();
+    ~TDOACaptureMap();
+
+    bool open(const std::string &path);
+    void close();
+
+    const tdoa_capture_header_t &getHeader() const { return *header; }
+    tdoa_capture_span_t records() const;
+    size_t size() const { return count; }
+
+    // Index of the first record at or after timeUs
+    size_t lowerBound(uint64_t timeUs) const;
+    // Records with from <= time < to, in us since the start of the capture
+    tdoa_capture_span_t window(uint64_t fromUs, uint64_t toUs) const;
+
+private:
+
+    TDOACaptureMap(const TDOACaptureMap &);
+    TDOACaptureMap &operator=(const TDOACaptureMap &);
+
+    void *base;
+    size_t mappedLen;
+    const tdoa_capture_header_t *header;
+    const tdoa_capture_record_t *data;
+    size_t count;
+    std::vector<uint64_t> index;
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*************************************************
+ *
+ *  Position updates of many TDOA filters in SIMD lockstep. A 6x6 update is
+ *  too small to fill the vector units on its own, so the states and
+ *  covariances of TDOA_FLEET_LANES filters are interleaved entry by entry
+ *  (array of structures of arrays: one lane per filter for every entry of S
+ *  and P) and tdoa_lanes.h runs on all of them at once. Each filter brings
+ *  its own Jacobian and innovation from prepareScalarUpdate, so the filters
+ *  may be at different anchors and different pairs.
+ *
+ *  The lanes perform the operations of TDOAFilter::scalarTDOADistUpdate in
+ *  the same order, the results are bit-identical to the scalar path.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_FLEET_h
+#define _TDOA_FLEET_h
+
+#include "tdoa.h"
+
+#if defined(__AVX__)
+#define TDOA_FLEET_LANES 8
+#else
+#define TDOA_FLEET_LANES 4  // SSE and NEON
+#endif
+
+typedef Eigen::Array<float, TDOA_FLEET_LANES, 1> FleetLane;
+
+// A measurement update of one filter, h, error and stdMeasNoise as returned by prepareScalarUpdate
+struct FleetUpdate
+{
+    TDOA *filter;
+    Eigen::Vector3f h;
+    float error;
+    float stdMeasNoise;
+};
+
+class TDOAFleet
+{
+public:
+
+    /*
+     * Applies the updates, TDOA_FLEET_LANES at a time. A filter may appear
+     * only once and must be lockstepCompatible.
+     */
+    static void apply(const FleetUpdate *updates, size_t count);
+
+private:
+
+    static void applyBlock(const FleetUpdate *updates, int lanes);
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*************************************************
+ *
+ *  Interacting multiple model estimator on top of the fixed-size TDOA filter.
+ *  Every model is a complete TDOA filter with its own transition and process
+ *  noise, all of them see the same measurements. On every prediction the
+ *  model estimates are mixed with the Markov switching probabilities of the
+ *  elapsed time, and the model probabilities follow the likelihood of the
+ *  innovations each model saw since the last prediction. The output is the
+ *  probability weighted combination of the model estimates.
+ *
+ *  All models share the state [x, y, z, vx, vy, vz], so mixing needs no state
+ *  augmentation and costs a few 6x6 sums per model.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_IMM_h
+#define _TDOA_IMM_h
+
+#include <string>
+
+#include "tdoa.h"
+
+#define IMM_MAX_MODELS          3
+#define IMM_SWITCH_RATE         1.0     // 1/s, default rate of leaving a model
+#define IMM_MIN_PROBABILITY     1e-4    // Floor of a model probability, so every model can come back
+
+// Process noise per PROCESS_NOISE_STEP of the built-in models, on top of the robot model
+#define IMM_STATIONARY_POS_NOISE 1e-7   // m^2, jitter of a robot at rest
+#define IMM_CV_VEL_NOISE         1e-5   // (m/s)^2, slow changes of the velocity
+#define IMM_MANEUVER_VEL_NOISE   1e-3   // (m/s)^2, about 3 m/s^2 of acceleration
+
+typedef enum
+{
+    IMM_MODEL_STATIONARY = 0,   // Velocity held at zero
+    IMM_MODEL_CV,               // Constant velocity
+    IMM_MODEL_MANEUVER,         // Constant velocity with the process noise of an accelerating robot
+} imm_model_t;
+
+class TDOAIMM
+{
+public:
+
+    TDOAIMM();
+
+    /*
+     * Adds a copy of base running type on top of the robot model A and Q.
+     * base carries every other setting (update mode, gates, anchors).
+     * Returns false once IMM_MAX_MODELS models are set.
+     */
+    bool addModel(const TDOA &base, const TDOA::DynamicMatrix &A, const TDOA::DynamicMatrix &Q, imm_model_t type);
+    void setSwitchRate(double rate);
+
+    void setAncPosition(const int anc_num, const vec3d_t anc_pos);
+    void setActiveAnchors(const vec3d_t *anchors, int n);
+    void setOrigin(const Eigen::Vector3d &origin);
+
+    // Same as the TDOA functions, applied to every model
+    bool initFromFrame(const tdoa_meas_t *meas, size_t count);
+    void batchTDOAUpdate(const tdoa_meas_t *meas, size_t count, tdoa_batch_mode_t mode, const float *variance = NULL);
+    void scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance = 0);
+    void stateEstimatorPredictTo(const double t);
+
+    // Writes the combined estimate into out
+    void output(TDOA &out);
+
+    int getModelCount();
+    float getModelProbability(int model);
+    int getMostLikely();
+    TDOA &getModel(int model);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+    void updateProbabilities();
+    void mix(const double dt);
+
+    TDOA models[IMM_MAX_MODELS];
+    int count;
+    double switchRate;
+
+    // Model probabilities, predicted by the last mix and then weighted by the likelihoods
+    double mu[IMM_MAX_MODELS];
+};
+
+// stationary, cv or maneuver
+bool parseIMMModel(const std::string &name, imm_model_t &type);
+
+#endif
@@ -0,0 +1,73 @@
+/*************************************************
+ *
+ *  TDOA filter driven by an accelerometer. The state is position, velocity
+ *  and the bias of the accelerometer, all in the world frame. Every IMU
+ *  sample predicts the state with the acceleration it measured, so between
+ *  the TDOA frames the estimate follows the motion instead of a constant
+ *  velocity, and the TDOA pairs correct it as they arrive.
+ *
+ *  The acceleration comes in rotated to the world frame with gravity
+ *  removed, by the attitude estimate of the flight controller. The bias is
+ *  estimated in the world frame too, which holds while the yaw changes
+ *  slowly compared to the bias.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_INERTIAL_h
+#define _TDOA_INERTIAL_h
+
+#include "tdoa.h"
+
+#define INERTIAL_GRAVITY        9.80665f    // m/s^2
+#define INERTIAL_ACCEL_NOISE    0.5f        // m/s^2/sqrt(Hz), default white noise of the acceleration
+#define INERTIAL_BIAS_NOISE     0.01f       // m/s^2/sqrt(s), default random walk of the bias
+#define INERTIAL_BIAS_STD       0.3f        // m/s^2, standard deviation of the bias when seeded
+#define INERTIAL_MAX_HOLD       0.1         // s, an acceleration older than this is no longer applied
+
+class TDOAInertial
+{
+public:
+
+    TDOAInertial();
+
+    // Takes every setting and the anchors of base. The covariance stays full, UD and steady are 6 state modes
+    void configure(const TDOA &base);
+    void setNoise(float accelNoise, float biasNoise);
+
+    // Starts from the state and covariance of ekf at time t with a zero bias
+    void seed(TDOA &ekf, const double t);
+
+    /*
+     * Acceleration in the world frame without gravity [m/s^2], measured at
+     * t [s]. Predicts to t with the acceleration held so far, then holds
+     * this one. Before seed it is only held.
+     */
+    void addAcceleration(const double t, const Eigen::Vector3f &accel);
+
+    // Predicts to t with the held acceleration, nothing before seed or for a t behind the state
+    void stateEstimatorPredictTo(const double t);
+    void scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance = 0);
+
+    // Writes position, velocity and their covariance into out
+    void output(TDOA &out);
+
+    Eigen::Vector3f getBias();
+    TDOAInertialFilter &getFilter();
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+    void predict(const double dt);
+
+    TDOAInertialFilter filter;
+    Eigen::Vector3f accel;
+    double accelTime;
+    bool accelValid;
+    float accelNoise, biasNoise;
+};
+
+#endif
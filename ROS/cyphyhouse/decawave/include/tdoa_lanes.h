@@ -0,0 +1,131 @@
+/*************************************************
+ *
+ *  Position-only measurement update and covariance bound of the full
+ *  covariance TDOA filter, written once for a scalar and for a pack of SIMD
+ *  lanes. TDOAFilter runs it on its own state with T = Scalar, TDOAFleet on
+ *  the interleaved states of several tags with T = FleetLane. Both perform
+ *  the same IEEE operations in the same order on every lane, so a tag gets
+ *  bit-identical results from either, as long as the compiler does not fuse
+ *  multiply-adds differently in the two (no -ffp-contract=fast with FMA
+ *  targets).
+ *
+ *  P is column-major, entry (i,j) at P[i + j*N] as in an Eigen matrix.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_LANES_h
+#define _TDOA_LANES_h
+
+#include <cmath>
+
+#include "Eigen/Dense"
+
+// Lane helpers, the scalar versions are the plain operations
+template <typename T>
+inline T laneConst(float v)
+{
+    return T::Constant(v);
+}
+template <>
+inline float laneConst<float>(float v)
+{
+    return v;
+}
+template <>
+inline double laneConst<double>(float v)
+{
+    return v;
+}
+
+inline float laneSelect(bool c, float a, float b)
+{
+    return c ? a : b;
+}
+inline double laneSelect(bool c, double a, double b)
+{
+    return c ? a : b;
+}
+template <typename Mask, typename T>
+inline T laneSelect(const Mask &c, const T &a, const T &b)
+{
+    return c.select(a, b);
+}
+
+inline bool laneIsNan(float v)
+{
+    return std::isnan(v);
+}
+inline bool laneIsNan(double v)
+{
+    return std::isnan(v);
+}
+template <typename T>
+inline auto laneIsNan(const T &v) -> decltype(v != v)
+{
+    return v != v;
+}
+
+/*
+ * Update with a measurement that only depends on position, H = [h' 0]:
+ *      PH' = P(:,0:2)*h,  s = h'PH'(0:2) + R
+ *      S += PH' * (error/s)
+ *      P -= (1/s - R/s^2) * PH' * PH''
+ */
+template <int N, typename T>
+inline void tdoaPositionUpdate(T *S, T *P, const T *h, const T &error, const T &R)
+{
+    T PH[N];
+    for (int i = 0; i < N; i++)
+    {
+        PH[i] = P[i]*h[0] + P[i + N]*h[1] + P[i + 2*N]*h[2];
+    }
+    const T HPHR = h[0]*PH[0] + h[1]*PH[1] + h[2]*PH[2] + R;
+
+    const T invHPHR = laneConst<T>(1) / HPHR;
+    const T gain = error * invHPHR;
+    for (int i = 0; i < N; i++)
+    {
+        S[i] += PH[i] * gain;
+    }
+
+    const T c = invHPHR - R*invHPHR*invHPHR;
+    for (int j = 0; j < N; j++)
+    {
+        const T cj = c * PH[j];
+        for (int i = 0; i < N; i++)
+        {
+            P[i + j*N] -= cj * PH[i];
+        }
+    }
+}
+
+/*
+ * Symmetrizes P and bounds its entries: NaN or above maxCov becomes maxCov,
+ * a diagonal entry below minCov becomes minCov.
+ */
+template <int N, typename T>
+inline void tdoaBoundCovariance(T *P, float maxCov, float minCov)
+{
+    const T half = laneConst<T>(0.5f);
+    const T hi = laneConst<T>(maxCov);
+    const T lo = laneConst<T>(minCov);
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = i; j < N; j++)
+        {
+            T p = half*P[i + j*N] + half*P[j + i*N];
+            if (i == j)
+            {
+                p = laneSelect(p < lo, lo, p);
+            }
+            p = laneSelect(laneIsNan(p) || (p > hi), hi, p);
+            P[i + j*N] = p;
+            P[j + i*N] = p;
+        }
+    }
+}
+
+#endif
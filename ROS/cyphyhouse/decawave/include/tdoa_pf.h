@@ -0,0 +1,86 @@
+/*************************************************
+ *
+ *  Particle filter on the tag position for global localization, used until
+ *  the TDOA filter has a position to start from. A single Gaussian cannot
+ *  hold the hyperbolic ambiguity of a few distance differences, the particle
+ *  cloud can, and it is handed to the TDOA filter once it collapsed.
+ *
+ *  Particles are kept as structure-of-arrays, one fixed-size array per axis,
+ *  so Eigen evaluates the distances and weights of a pair over a whole array
+ *  with SSE/AVX or NEON, 4 to 8 particles per instruction. Every frame:
+ *      - diffusion with the longest move since the last frame
+ *      - log-weight of every pair, Gaussian with a floor for outliers
+ *      - systematic resampling and roughening once the effective sample size
+ *        drops below PF_RESAMPLE_RATIO
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_PF_h
+#define _TDOA_PF_h
+
+#include <cstdint>
+#include <random>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+
+#define PF_NUM_PARTICLES    4096    // Multiple of 8, every array is a whole number of SIMD packets
+#define PF_MEAS_STD         0.3f    // m, wider than the TDOA filter so a thin cloud does not starve
+#define PF_OUTLIER_LOGL     8.0f    // Lowest log-weight of one pair, a single bad pair cannot kill a particle
+#define PF_MAX_SPEED        1.0f    // m/s, diffusion between frames
+#define PF_RESAMPLE_RATIO   0.5f    // Of PF_NUM_PARTICLES, effective sample size that triggers resampling
+#define PF_ROUGHENING       0.2f    // Jitter after resampling, relative to the extent of the cloud
+#define PF_MIN_JITTER       0.005f  // m
+#define PF_CONVERGED_STD    0.3f    // m, largest axis standard deviation of a collapsed cloud, the TDOA filter refines it
+#define PF_MIN_FRAMES       5       // Frames before the cloud may hand over
+#define PF_HULL_MARGIN      1.0f    // m, the cloud starts in the bounding box of the anchors grown by this
+
+class TDOAParticleFilter
+{
+public:
+
+    TDOAParticleFilter();
+
+    void setAncPosition(const int anc_num, const vec3d_t anc_pos);
+
+    // Spreads the particles uniformly over the box [lo, hi]
+    void reset(const Eigen::Vector3f &lo, const Eigen::Vector3f &hi);
+
+    // One TDMA frame of the current anchors, the timestamps give the diffusion. Ignored before reset
+    void update(const tdoa_meas_t *meas, size_t count);
+
+    bool converged();
+    void getEstimate(vec3d_t &mean, Eigen::Matrix3f &covariance);
+    uint32_t getFrames();
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+    typedef Eigen::Array<float, PF_NUM_PARTICLES, 1> ParticleArray;
+
+    void anchorDistance(int anc_num);
+    void normalize();
+    void resample();
+    void jitter(float sx, float sy, float sz);
+
+    ParticleArray px, py, pz;
+    ParticleArray logw;
+    ParticleArray w;            // Normalized weights, set by normalize
+
+    vec3d_t anchorPosition[MAX_NR_ANCHORS];
+    // Distance of every particle to every anchor, filled per frame as the pairs need them (bit k of distValid).
+    // Too large for a fixed-size array, allocated once by the constructor
+    Eigen::ArrayXXf dist;
+    uint32_t distValid;
+
+    std::mt19937 rng;
+    double lastTime;
+    uint32_t frames;
+    bool spread;                // Set by reset
+};
+
+#endif
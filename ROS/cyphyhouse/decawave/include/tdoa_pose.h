@@ -0,0 +1,134 @@
+/*************************************************
+ *
+ *  TDOA filter of a body carrying two tags on a rigid baseline. The state is
+ *  position and velocity of the body origin and its yaw and yaw rate, so the
+ *  two tags make one planar pose instead of two positions: tag k is at
+ *  p + R(yaw)*b_k, with b_k its offset in the body frame.
+ *
+ *  The pairs of both tags are applied in one pass. Pairs close in time share
+ *  the prediction and the linearization, the distances and unit vectors from
+ *  both tags to every anchor are computed together on the one anchor table,
+ *  and the pairs are then scalar updates of the 8 states at that point, with
+ *  the innovations corrected for the state change of the updates before.
+ *
+ *  The yaw is only observable as long as the baseline is not vertical, a
+ *  body with its tags above each other gets nothing out of it.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_POSE_h
+#define _TDOA_POSE_h
+
+#include "tdoa.h"
+
+// Yaw and yaw rate, after position and velocity
+#define STATE_YAW       6
+#define STATE_YAW_RATE  7
+#define POSE_STATE_DIM  8
+
+#define POSE_TAGS           2
+#define POSE_ACCEL_NOISE    2.0f    // m/s^2/sqrt(Hz), default white noise of the acceleration
+#define POSE_YAW_NOISE      3.0f    // rad/s^2/sqrt(Hz), default white noise of the yaw acceleration
+#define POSE_YAW_RATE_STD   1.0f    // rad/s, standard deviation of the yaw rate when seeded
+#define POSE_MIN_BASELINE   0.05f   // m, horizontal baseline below which the yaw is not observable
+#define POSE_SEED_TOL       0.3f    // m, distance of the two tag fixes off the baseline before seeding is refused
+#define POSE_BATCH_SPAN     0.02    // s, pairs this close share one prediction and linearization
+#define POSE_MAX_PENDING    1024    // Pairs queued between two updates
+
+// A pair of one of the tags, variance as for TDOAFilter::scalarTDOADistUpdate
+typedef struct pose_meas_s
+{
+    tdoa_meas_t meas;
+    float variance;
+    uint8_t tag;
+}pose_meas_t;
+
+class TDOAPose
+{
+public:
+
+    typedef Eigen::Matrix<float, POSE_STATE_DIM, 1> StateVector;
+    typedef Eigen::Matrix<float, POSE_STATE_DIM, POSE_STATE_DIM> StateMatrix;
+
+    TDOAPose();
+
+    // Offsets of the tags in the body frame [m], x forward. The pose is that of the body origin
+    void setBaseline(const Eigen::Vector3f &tag0, const Eigen::Vector3f &tag1);
+    void setNoise(float accelNoise, float yawNoise);
+
+    /*
+     * Takes the noise, gate and robust settings and the active anchors of
+     * base, the filter of tag 0. A new origin moves the state with it, so
+     * this may be called every cycle to follow the cell of the tag.
+     */
+    void configure(const TDOA &base);
+
+    // Starts from the estimates of the two tags at time t, false if their distance does not fit the baseline
+    bool seed(TDOA &tag0, TDOA &tag1, const double t);
+    void reset();
+    bool isSeeded() const { return seeded; }
+
+    // Queues a pair of tag (0 or 1) in the anchor numbers of configure, applied by update
+    void add(uint8_t tag, const tdoa_meas_t &meas, float variance = 0);
+    // Applies the queued pairs in time order, returns the number applied. Nothing before seed
+    size_t update();
+    // Predicts to t, nothing before seed or for a t behind the state
+    void stateEstimatorPredictTo(const double t);
+
+    // Writes position, velocity and their covariance of tag into out, in the local frame of out
+    void output(uint8_t tag, TDOA &out);
+
+    StateVector getState() const { return S; }
+    StateMatrix getCovariance() const { return P; }
+    double getTime() const { return stateTime; }
+    // Site coordinates of the body origin
+    Eigen::Vector3d getPosition() const { return S.head<3>().cast<double>() + origin; }
+    // rad, in [-pi, pi]
+    float getYaw() const { return S(STATE_YAW); }
+    uint32_t getRejectCount() const { return rejects; }
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+private:
+
+    void predict(const double dt);
+    void applyBatch(const pose_meas_t *batch, size_t count);
+    void linearize();
+    // R(yaw)*b for the yaw of the state
+    Eigen::Vector3f leverArm(int tag) const;
+    void bound();
+
+    StateVector S;
+    StateMatrix P;
+    double stateTime;
+    bool seeded;
+
+    Eigen::Vector3f baseline[POSE_TAGS];
+    float accelNoise, yawNoise;
+
+    // Settings of configure
+    float stdDev;
+    float gateThreshold;
+    tdoa_robust_mode_t robustMode;
+    float robustK;
+
+    // The anchors of tag 0's filter relative to its origin, as its anchorSoA
+    Eigen::Vector3d origin;
+    Eigen::Matrix<float, MAX_NR_ANCHORS, 3> anchorSoA;
+    int anchorCount;
+
+    // Linearization of applyBatch: the state, the lever arms and the distance and unit vector of every anchor per tag
+    StateVector cacheState;
+    Eigen::Vector3f cacheArm[POSE_TAGS];
+    Eigen::Matrix<float, MAX_NR_ANCHORS, POSE_TAGS> cacheDist;
+    Eigen::Matrix<float, MAX_NR_ANCHORS, 3> cacheUnit[POSE_TAGS];
+
+    pose_meas_t pending[POSE_MAX_PENDING];
+    size_t pendingCount;
+    uint32_t rejects;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*************************************************
+ *
+ *  Host side clock model for the raw timestamp frames of the tag.
+ *  Rebuilds the distance differences the tag would have sent, using the same
+ *  clock filter and equations (common/tdoa_clock.h).
+ *
+ *  Changelog:
+ *      v0.4 - Fixed-point clock skew of tdoa_clock.h v0.2
+ *      v0.3 - Anchor state per cell-qualified anchor ID
+ *      v0.2 - Solved frames carry the packet index and tag arrival time
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_RAW_h
+#define _TDOA_RAW_h
+
+#include <cstdint>
+#include <cstring>
+
+#include "tdoa_protocol.h"
+#include "tdoa_clock.h"
+#include "tdoa_tdma.h"
+
+#define RAW_MAX_ANCHORS TDOA_CELL_IDS // Cell-qualified anchor IDs, the tag never pairs anchors of two cells
+
+/*
+ * Keeps per anchor the clock filter, the tag arrival time and the index of the
+ * last packet. A pair is only solved when the packet of Ar belongs to the same
+ * TDMA frame as the one of An, as on the tag.
+ */
+class TDOARawSolver
+{
+public:
+
+    TDOARawSolver() : solvedFrames(0)
+    {
+        for (int i = 0; i < RAW_MAX_ANCHORS; i++)
+        {
+            tdoa_clock_filter_reset(&clock[i]);
+            ratio[i] = 0.0;
+            skew[i] = 0;
+        }
+        memset(lastRx, 0, sizeof(lastRx));
+        memset(lastIdx, 0, sizeof(lastIdx));
+        memset(seen, 0, sizeof(seen));
+    }
+
+    // Returns true and fills frame if the raw frame completes a TDOA pair
+    bool solve(const tdoa_raw_frame_t &raw, tdoa_frame_t &frame)
+    {
+        const uint8_t Ar = raw.Ar;
+        const uint8_t An = raw.An;
+        if ((Ar >= RAW_MAX_ANCHORS) || (An >= RAW_MAX_ANCHORS))
+        {
+            return false;
+        }
+
+        if (tdoa_clock_filter_add(&clock[An], raw.rxAn_by_T, raw.txAn))
+        {
+            ratio[An] = tdoa_clock_filter_ratio(&clock[An]);
+            skew[An] = tdoa_clock_skew(ratio[An]);
+        }
+
+        bool ok = (Ar != An) && seen[Ar] && isSameFrame(Ar, An, raw.idx)
+               && (raw.tofAr_to_An != 0) && (raw.rxAr_by_An != 0) && (ratio[An] != 0.0);
+        if (ok)
+        {
+            frame.Ar = Ar;
+            frame.An = An;
+            frame.distanceDiff = tdoa_clock_distance_diff(lastRx[Ar], raw.rxAn_by_T, raw.rxAr_by_An, raw.txAn,
+                                                          raw.tofAr_to_An, skew[An]);
+            frame.flags = TDOA_FRAME_HAS_TIME;
+            frame.idx = raw.idx;
+            frame.rxTime = raw.rxAn_by_T;
+            solvedFrames++;
+        }
+
+        lastRx[An] = raw.rxAn_by_T;
+        lastIdx[An] = raw.idx;
+        seen[An] = true;
+        return ok;
+    }
+
+    uint32_t getSolvedFrames() const { return solvedFrames; }
+
+private:
+
+    // Anchors transmit in index order, so a lower Ar sent in the same frame and a higher one in the previous
+    bool isSameFrame(uint8_t Ar, uint8_t An, uint8_t idx) const
+    {
+        return (Ar < An) ? (lastIdx[Ar] == idx) : (lastIdx[Ar] == (uint8_t)(idx - 1));
+    }
+
+    tdoa_clock_filter_t clock[RAW_MAX_ANCHORS];
+    double ratio[RAW_MAX_ANCHORS];
+    int32_t skew[RAW_MAX_ANCHORS];
+    uint64_t lastRx[RAW_MAX_ANCHORS];
+    uint8_t lastIdx[RAW_MAX_ANCHORS];
+    bool seen[RAW_MAX_ANCHORS];
+
+    uint32_t solvedFrames;
+};
+
+#endif
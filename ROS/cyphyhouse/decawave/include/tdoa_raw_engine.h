@@ -0,0 +1,145 @@
+/*************************************************
+ *
+ *  Host TDOA engine for the raw timestamp frames of many tags at once,
+ *  the work calcClockCorrection and calcDistanceDiff do on every tag, done
+ *  on the host with shared clock models.
+ *
+ *  The clock skew of anchor An seen by tag T is the skew of An against a
+ *  common reference plus the skew of the reference against T. The first
+ *  part is the same for every tag, so it is fitted once per anchor from
+ *  the fits of all tags, and each tag only adds its own part, the mean
+ *  over all anchors it hears:
+ *      s(T, An) = a(An) + c(T)
+ *      c(T)  = mean over the anchors of T of own(T, An) - a(An)
+ *      a(An) <- a(An) + RAW_ENGINE_ANCHOR_GAIN * (own(T, An) - c(T) - a(An))
+ *  own(T, An) is the least squares fit of the last packets of An at T
+ *  (tdoa_clock.h) the tag would use alone, and stays in use until An has a
+ *  shared skew. The reference is the first anchor fitted, only a + c is
+ *  ever used.
+ *
+ *  The serial thread of each tag queues its raw frames (add). One thread
+ *  runs process: it takes the frames of all tags, updates the clock fits
+ *  and pairs the packets as TDOARawSolver does, updates the shared model
+ *  and then solves every pair of the pass in one vectorized batch, in
+ *  double precision on the 40 bit intervals instead of the fixed-point skew
+ *  of the firmware.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_RAW_ENGINE_h
+#define _TDOA_RAW_ENGINE_h
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <atomic>
+#include <Eigen/Dense>
+
+#include "tdoa_raw.h"
+#include "cyphy_control/SPSCQueue.h"
+
+#define RAW_ENGINE_QUEUE_SIZE   256     // Raw frames per tag between two passes, power of two
+#define RAW_ENGINE_MAX_BATCH    1024    // Pairs solved in one pass, the rest waits for the next
+#define RAW_ENGINE_ANCHOR_GAIN  0.02    // Weight of one tag fit in the shared skew of its anchor
+#define RAW_ENGINE_MIN_PACKETS  4       // Packets in a tag fit before it counts for the shared model
+#define RAW_ENGINE_MIN_SAMPLES  16      // Tag fits of an anchor before its shared skew is used
+
+// A raw frame as read from the port of a tag
+struct RawIngress
+{
+    tdoa_raw_frame_t raw;
+    double read;            // s, host time of the read
+    double stamp;           // s, arrival of the packet of An in host time, the read without a synced clock
+};
+
+// A solved pair of tag, with the times of its raw frame
+struct RawSolved
+{
+    size_t tag;
+    tdoa_frame_t frame;
+    double read;
+    double stamp;
+    bool shared;            // Solved with the shared skew of An
+};
+
+class TDOARawEngine
+{
+public:
+
+    explicit TDOARawEngine(size_t tags);
+
+    // Only the reader thread of tag. False if its queue is full and the frame was dropped
+    bool add(size_t tag, const tdoa_raw_frame_t &raw, double read, double stamp)
+    {
+        RawIngress in;
+        in.raw = raw;
+        in.read = read;
+        in.stamp = stamp;
+        return states[tag].queue.push(in);
+    }
+
+    // Takes the queued frames of all tags, calls out(const RawSolved&) for every pair solved and returns their number
+    template <typename Callback>
+    size_t process(Callback out)
+    {
+        const size_t n = solveBatch();
+        for (size_t k = 0; k < n; k++)
+        {
+            out(solved[k]);
+        }
+        return n;
+    }
+
+    // Any thread
+    uint32_t getRawFrames() const { return rawFrames; }
+    uint32_t getSolvedPairs() const { return solvedPairs; }
+    uint32_t getSharedPairs() const { return sharedPairs; }
+    uint32_t getPasses() const { return passes; }
+    uint32_t getDrops() const;
+    // Anchors whose shared skew is in use
+    uint32_t getModeledAnchors() const { return modeledAnchors; }
+
+private:
+
+    struct TagState
+    {
+        SPSCQueue<RawIngress, RAW_ENGINE_QUEUE_SIZE> queue;
+        tdoa_clock_filter_t clock[RAW_MAX_ANCHORS];
+        double own[RAW_MAX_ANCHORS];        // Ratio - 1 of the fit of the tag, NAN before two packets
+        uint64_t lastRx[RAW_MAX_ANCHORS];
+        uint8_t lastIdx[RAW_MAX_ANCHORS];
+        bool seen[RAW_MAX_ANCHORS];
+        bool fresh[RAW_MAX_ANCHORS];        // Fit moved in this pass
+        double common;                      // c(T)
+        bool commonValid;
+    };
+
+    // Pairs the queued frames, updates the model and fills solved, returns the pairs
+    size_t solveBatch();
+    void pairFrame(size_t t, const RawIngress &in, size_t &n);
+    void updateModel(size_t t);
+
+    std::unique_ptr<TagState[]> states;
+    size_t tags;
+
+    // Shared skew of every cell-qualified anchor and the tag fits it has seen
+    double anchorSkew[RAW_MAX_ANCHORS];
+    uint32_t anchorSamples[RAW_MAX_ANCHORS];
+
+    // The pairs of a pass, structure of arrays for the batch, allocated once
+    Eigen::ArrayXd interval;        // Tag clock ticks from the packet of Ar to the one of An
+    Eigen::ArrayXd skew;
+    Eigen::ArrayXd tof;             // Anchor clock ticks
+    Eigen::ArrayXd delta;           // txAr to txAn in the clock of An
+    uint32_t txAn[RAW_ENGINE_MAX_BATCH];
+    uint32_t rxArByAn[RAW_ENGINE_MAX_BATCH];
+    uint8_t anchorOf[RAW_ENGINE_MAX_BATCH];
+    RawSolved solved[RAW_ENGINE_MAX_BATCH];
+
+    std::atomic<uint32_t> rawFrames, solvedPairs, sharedPairs, passes, modeledAnchors;
+};
+
+#endif
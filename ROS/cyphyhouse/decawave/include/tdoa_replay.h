@@ -0,0 +1,204 @@
+/*************************************************
+ *
+ *  Offline sources of TDOA frames for the replay and benchmark tools:
+ *  anchor layout files, text logs and binary captures written by tdoa_node
+ *  (saveTDOA.cpp) and a simple synthetic trajectory.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_REPLAY_h
+#define _TDOA_REPLAY_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "tdoa.h"
+#include "tdoa_capture.h"
+
+// One complete anchor rotation with optional ground truth
+typedef struct tdoa_frame_record_s
+{
+    double      time;           // s
+    bool        hasTruth;
+    double      truth[3];       // m, Vicon or simulated position
+    size_t      count;
+    tdoa_meas_t meas[MAX_NR_ANCHORS];
+}tdoa_frame_record_t;
+
+typedef struct anchor_layout_s
+{
+    int     count;
+    vec3d_t pos[MAX_NR_ANCHORS];
+}anchor_layout_t;
+
+// Reads an anchorPos_*.txt file, one "x, y, z" line per anchor
+inline bool loadAnchorLayout(const std::string &path, anchor_layout_t &layout)
+{
+    std::ifstream file(path);
+    std::string str;
+    layout.count = 0;
+    while (std::getline(file, str) && (layout.count < MAX_NR_ANCHORS))
+    {
+        vec3d_t &p = layout.pos[layout.count];
+        if (sscanf(str.c_str(), "%f, %f, %f", &p.x, &p.y, &p.z) == 3)
+        {
+            layout.count++;
+        }
+    }
+    return layout.count > 0;
+}
+
+/*
+ * Reads a tdoa_node text log. Each row is
+ *      time_us, vicon_x, vicon_y, vicon_z, tdoa_0, ..., tdoa_7
+ * where tdoa_k is the pair (Ar = k-1, An = k). All pairs of a row get the row time.
+ * Rows converted from a capture (formatCaptureRow) also carry ref_0..7 and
+ * arrival_us_0..7, and nan marks a slot that was not received. Like the
+ * captures the rows only cover anchors 0..TDOA_CAPTURE_MAX_ANCHORS-1.
+ */
+inline bool loadTextLog(const std::string &path, std::vector<tdoa_frame_record_t> &frames)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string str;
+    while (std::getline(file, str))
+    {
+        double t_us, v[3], d[TDOA_CAPTURE_MAX_ANCHORS];
+        unsigned ref[TDOA_CAPTURE_MAX_ANCHORS], arrival[TDOA_CAPTURE_MAX_ANCHORS];
+        int n = sscanf(str.c_str(), "%lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, "
+                       "%u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u",
+                       &t_us, &v[0], &v[1], &v[2], &d[0], &d[1], &d[2], &d[3], &d[4], &d[5], &d[6], &d[7],
+                       &ref[0], &ref[1], &ref[2], &ref[3], &ref[4], &ref[5], &ref[6], &ref[7],
+                       &arrival[0], &arrival[1], &arrival[2], &arrival[3], &arrival[4], &arrival[5], &arrival[6], &arrival[7]);
+        if ((n != 4 + TDOA_CAPTURE_MAX_ANCHORS) && (n != 4 + 3*TDOA_CAPTURE_MAX_ANCHORS))
+        {
+            continue;
+        }
+        bool extended = (n == 4 + 3*TDOA_CAPTURE_MAX_ANCHORS);
+
+        tdoa_frame_record_t rec;
+        rec.time = t_us * 1e-6;
+        rec.hasTruth = (v[0] != 0) || (v[1] != 0) || (v[2] != 0);
+        for (int i = 0; i < 3; i++)
+        {
+            rec.truth[i] = v[i];
+        }
+        rec.count = 0;
+        for (int k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+        {
+            if (!std::isfinite(d[k]) || (extended && (ref[k] >= MAX_NR_ANCHORS)))
+            {
+                continue;
+            }
+            tdoa_meas_t &m = rec.meas[rec.count++];
+            m.Ar = extended ? ref[k] : (k + TDOA_CAPTURE_MAX_ANCHORS - 1) % TDOA_CAPTURE_MAX_ANCHORS;
+            m.An = k;
+            m.distanceDiff = d[k];
+            m.timestamp = extended ? rec.time + arrival[k] * 1e-6 : rec.time;
+        }
+        if (rec.count > 0)
+        {
+            frames.push_back(rec);
+        }
+    }
+    return true;
+}
+
+// Anchor layout stored in a capture header
+inline void captureLayout(const tdoa_capture_header_t &header, anchor_layout_t &layout)
+{
+    layout.count = std::min<int>(header.anchorCount, TDOA_CAPTURE_MAX_ANCHORS);
+    for (int i = 0; i < layout.count; i++)
+    {
+        layout.pos[i].x = header.anchorPos[i][0];
+        layout.pos[i].y = header.anchorPos[i][1];
+        layout.pos[i].z = header.anchorPos[i][2];
+    }
+}
+
+// Views one capture record as a replay frame, keeping only the valid slots in arrival order
+inline void captureToFrame(const tdoa_capture_record_t &r, tdoa_frame_record_t &rec)
+{
+    rec.time = r.timeUs * 1e-6;
+    rec.hasTruth = (r.vicon[0] != 0) || (r.vicon[1] != 0) || (r.vicon[2] != 0);
+    for (int i = 0; i < 3; i++)
+    {
+        rec.truth[i] = r.vicon[i];
+    }
+    rec.count = 0;
+    for (int k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+    {
+        if (!(r.valid & (1u << k)) || (r.ref[k] >= MAX_NR_ANCHORS))
+        {
+            continue;
+        }
+        tdoa_meas_t &m = rec.meas[rec.count++];
+        m.Ar = r.ref[k];
+        m.An = k;
+        m.distanceDiff = r.tdoa[k];
+        m.timestamp = rec.time + r.arrivalUs[k] * 1e-6;
+    }
+}
+
+/*
+ * Tag moving on a slow horizontal circle inside the anchor hull, with white
+ * measurement noise. Pairs are spread over the frame as by the anchor TDMA.
+ */
+inline void simulateCircle(const anchor_layout_t &layout, size_t nframes, double frame_dt, double noise_std,
+                           std::vector<tdoa_frame_record_t> &frames, unsigned seed = 42)
+{
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> noise(0, noise_std);
+
+    double cx = 0, cy = 0, cz = 0;
+    for (int i = 0; i < layout.count; i++)
+    {
+        cx += layout.pos[i].x / layout.count;
+        cy += layout.pos[i].y / layout.count;
+        cz += layout.pos[i].z / layout.count;
+    }
+
+    const int n = layout.count;
+    for (size_t f = 0; f < nframes; f++)
+    {
+        tdoa_frame_record_t rec;
+        rec.count = n;
+        rec.hasTruth = true;
+        for (int k = 0; k < n; k++)
+        {
+            double t = 1.0 + (f*n + k) * (frame_dt / n);
+            double p[3] = {cx + cos(0.2*t), cy + sin(0.2*t), cz};
+
+            int Ar = (k + n - 1) % n;
+            const vec3d_t &an = layout.pos[k], &ar = layout.pos[Ar];
+            double dn = sqrt((p[0]-an.x)*(p[0]-an.x) + (p[1]-an.y)*(p[1]-an.y) + (p[2]-an.z)*(p[2]-an.z));
+            double dr = sqrt((p[0]-ar.x)*(p[0]-ar.x) + (p[1]-ar.y)*(p[1]-ar.y) + (p[2]-ar.z)*(p[2]-ar.z));
+
+            rec.meas[k].Ar = Ar;
+            rec.meas[k].An = k;
+            rec.meas[k].distanceDiff = dn - dr + noise(gen);
+            rec.meas[k].timestamp = t;
+
+            rec.time = t;
+            rec.truth[0] = p[0];
+            rec.truth[1] = p[1];
+            rec.truth[2] = p[2];
+        }
+        frames.push_back(rec);
+    }
+}
+
+#endif
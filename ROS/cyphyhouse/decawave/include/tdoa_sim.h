@@ -0,0 +1,97 @@
+/*************************************************
+ *
+ *  Synthetic TDOA measurement generator.
+ *  Produces the pair stream a tag would send for a given anchor layout and
+ *  trajectory, following the anchor TDMA rotation of TREK_TDOA: one slot of
+ *  TDMA_SLOT_LEN per anchor, anchors 0..N-1 in order. A pair (Ar, An) is
+ *  emitted between the last anchor heard and the current one, so a dropped
+ *  slot produces a non-consecutive pair exactly like the tag firmware.
+ *
+ *  Modelled errors:
+ *      - white measurement noise
+ *      - residual anchor clock drift after the tag's clock correction,
+ *        a per-anchor offset plus random walk (ppm)
+ *      - NLOS, a per-slot probability of an exponential positive range bias
+ *      - dropped slots
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_SIM_h
+#define _TDOA_SIM_h
+
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <string>
+
+#include "tdoa.h"
+#include "tdoa_replay.h"
+
+#define SIM_SLOT_TIME   (134217728.0 / (499.2e6 * 128)) // s, TDMA_SLOT_LEN in TREK_TDOA (~2.1 ms)
+#define SIM_SPEED_OF_LIGHT 299702547.0                  // m/s in air, as in the tag
+
+typedef struct tdoa_sim_config_s
+{
+    double slotTime;        // s
+    double measNoise;       // m, standard deviation per pair
+    double clockDriftPpm;   // standard deviation of the per-anchor residual drift
+    double clockWalkPpm;    // ppm/sqrt(s) random walk of the residual drift
+    double nlosProb;        // probability a slot is received through NLOS
+    double nlosMeanBias;    // m, mean of the exponential NLOS bias
+    double dropProb;        // probability a slot is lost
+    unsigned seed;
+}tdoa_sim_config_t;
+
+typedef struct sim_waypoint_s
+{
+    double t;               // s
+    double pos[3];          // m
+}sim_waypoint_t;
+
+// Defaults: 5 cm noise, 0.02 ppm residual drift (~1.3 cm per pair), 5% NLOS at 0.3 m, 2% drops
+tdoa_sim_config_t defaultSimConfig();
+
+// Reads "t, x, y, z" lines
+bool loadTrajectory(const std::string &path, std::vector<sim_waypoint_t> &traj);
+
+class TDOASimulator
+{
+public:
+
+    TDOASimulator(const anchor_layout_t &layout, const tdoa_sim_config_t &config);
+
+    // Piecewise linear trajectory, held at the last waypoint. Without one the tag circles the hull center
+    void setTrajectory(const std::vector<sim_waypoint_t> &traj);
+
+    // Advances one TDMA slot. Returns true and fills meas/truth if the slot produced a pair
+    bool step(tdoa_meas_t &meas, double truth[3]);
+    double getTime() const;
+
+    // Runs whole rotations and groups their pairs, for the replay tools
+    void generate(size_t nframes, std::vector<tdoa_frame_record_t> &frames);
+
+private:
+
+    void positionAt(double t, double pos[3]) const;
+    double range(int anc, const double pos[3]) const;
+
+    anchor_layout_t layout;
+    tdoa_sim_config_t config;
+    std::vector<sim_waypoint_t> trajectory;
+
+    std::mt19937 gen;
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> uniform;
+
+    double time;
+    int slot;
+    int lastAnchor;
+    double lastRange;       // m, biased and drifted range of lastAnchor
+    double lastRxTime;
+    double driftPpm[MAX_NR_ANCHORS];
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*************************************************
+ *
+ *  Batch least-squares trajectory over a whole capture, for reference
+ *  trajectories where there is no Vicon. Unknowns are the state (p, v) at
+ *  every node, one node per frame, and a constant bias per anchor pair.
+ *  The cost is
+ *      sum over pairs   rho((|p(t) - a_An| - |p(t) - a_Ar| + b - d) / stdDev)
+ *      sum over nodes   e' Q(dt)^-1 e,   e = x_k+1 - F(dt) x_k
+ *      sum over biases  (b / biasStd)^2
+ *  with p(t) = p_k + (t - t_k) v_k for a pair received at t, F and Q the
+ *  constant velocity model under white acceleration of spectral density
+ *  accelNoise, and rho the Huber loss (least squares with huber 0). The
+ *  biases take up the residual clock offsets and antenna delays of the
+ *  anchors; b(An, Ar) is -b(Ar, An).
+ *
+ *  Gauss-Newton with Marquardt damping. The normal equations have the state
+ *  blocks in a block tridiagonal band, since every term but the biases
+ *  touches one node or two neighbours, plus a dense border of the few
+ *  biases. The band is solved by block Cholesky (block tridiagonal
+ *  elimination) and the biases by the Schur complement over it, linear in
+ *  the node count. The assembly splits the nodes over threads; each thread
+ *  writes only the blocks of its own nodes and keeps its own bias sums.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TRAJECTORY_SOLVER_h
+#define _TRAJECTORY_SOLVER_h
+
+#include <cstddef>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "Eigen/StdVector"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+
+#define TRAJECTORY_ACCEL_NOISE      1.0     // m^2/s^3, white acceleration of the motion prior
+#define TRAJECTORY_BIAS_STD         0.3     // m, prior of the pair biases
+#define TRAJECTORY_HUBER            3.0     // Huber threshold in stdDev
+#define TRAJECTORY_MAX_ITERATIONS   20
+#define TRAJECTORY_TOLERANCE        1e-6    // Relative cost decrease that ends the iterations
+#define TRAJECTORY_MIN_DT           1e-4    // s, closer nodes are merged into the first
+#define TRAJECTORY_MIN_VARIANCE     1e-9    // Diagonal floor of the damping
+
+typedef struct trajectory_solver_config_s
+{
+    float stdDev;           // m, pair noise
+    double accelNoise;      // m^2/s^3
+    double biasStd;         // m, 0 keeps the biases at 0
+    double huber;           // In stdDev, 0 for least squares
+    int maxIterations;
+    double tolerance;
+    int threads;            // Assembly threads, 0 for one per core
+}trajectory_solver_config_t;
+
+trajectory_solver_config_t defaultTrajectoryConfig();
+
+typedef struct trajectory_iteration_s
+{
+    double cost;            // After the iteration
+    double stepNorm;        // m and m/s, of the accepted step
+    double lambda;          // Damping of the accepted step
+    double seconds;         // Assembly and solve
+}trajectory_iteration_t;
+
+class TrajectorySolver
+{
+public:
+
+    typedef Eigen::Matrix<double, 6, 1> Vector6d;
+    typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+    TrajectorySolver(const anchor_layout_t &layout, const trajectory_solver_config_t &config);
+
+    /*
+     * Node at time t with the pairs received around it and the initial state,
+     * in time order, e.g. the smoothed filter states. Returns false if it was
+     * merged into the previous node.
+     */
+    bool addNode(double t, const tdoa_meas_t *meas, size_t count, const Eigen::Vector3d &p, const Eigen::Vector3d &v);
+
+    // Iterates until the cost stops decreasing, false if the first step already failed
+    bool solve();
+
+    size_t getNodeCount() const { return times.size(); }
+    double getTime(size_t k) const { return times[k]; }
+    Eigen::Vector3d getPosition(size_t k) const { return states[k].head<3>(); }
+    Eigen::Vector3d getVelocity(size_t k) const { return states[k].tail<3>(); }
+
+    // Pairs that have a bias, Ar < An
+    size_t getPairCount() const { return pairs.size(); }
+    void getPair(size_t i, int &Ar, int &An, double &bias) const;
+    // Residuals per pair after the solve: count, mean and standard deviation in m
+    void getPairResiduals(size_t i, size_t &count, double &mean, double &std) const;
+
+    const std::vector<trajectory_iteration_t> &getIterations() const { return iterations; }
+
+private:
+
+    typedef std::vector<Vector6d, Eigen::aligned_allocator<Vector6d> > StateVector;
+    typedef std::vector<Matrix6d, Eigen::aligned_allocator<Matrix6d> > BlockVector;
+
+    // Per pair of a node, resolved once in addNode
+    typedef struct pair_term_s
+    {
+        double dt;          // s, from the node
+        double distanceDiff;
+        int Ar, An;
+        int bias;           // Index into biases, -1 without
+        double sign;        // Of the bias, -1 for a pair given as (An, Ar)
+    }pair_term_t;
+
+    // Sums of one assembly thread
+    typedef struct thread_sums_s
+    {
+        Eigen::MatrixXd Hbb;
+        Eigen::VectorXd gb;
+        double cost;
+    }thread_sums_t;
+
+    int pairBias(int Ar, int An, double &sign);
+    double pairResidual(const pair_term_t &m, const Vector6d &x, const Eigen::VectorXd &b, Vector6d *J) const;
+    double motionWeight(double dt, Matrix6d &W, Matrix6d &F) const;
+    double robustWeight(double r, double &rho) const;
+
+    // Runs f(begin, end, thread) over the node range split into the threads
+    template<typename Func> void parallelNodes(Func f);
+
+    double cost(const StateVector &x, const Eigen::VectorXd &b);
+    void assemble();
+    bool solveStep(double lambda, StateVector &dx, Eigen::VectorXd &db);
+
+    anchor_layout_t layout;
+    trajectory_solver_config_t config;
+
+    std::vector<double> times;
+    std::vector<size_t> firstTerm;          // Per node, plus one past the last
+    std::vector<pair_term_t> terms;
+    StateVector states;
+    Eigen::VectorXd biases;
+    std::vector<int> pairs;                 // Ar * MAX_NR_ANCHORS + An per bias
+    int pairIndex[MAX_NR_ANCHORS][MAX_NR_ANCHORS];
+
+    // Normal equations: D_k on the band, U_k = H(k, k+1), Hxb the bias border
+    BlockVector D, U;
+    StateVector gx;
+    Eigen::MatrixXd Hxb, Hbb;
+    Eigen::VectorXd gb;
+    double assembledCost;
+
+    std::vector<trajectory_iteration_t> iterations;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*************************************************
+ *
+ *  Position output for consumers without ROS (fleet manager, safety PLC):
+ *  fixed-layout binary records multicast over UDP. Every publish tick each
+ *  worker sends the records of its tags in as few datagrams as fit the
+ *  Ethernet MTU, so one sendto carries up to UDP_OUTPUT_MAX_RECORDS tags.
+ *
+ *  Datagram, little-endian, no padding between the fields below:
+ *      udp_output_header_t
+ *      count udp_position_record_t
+ *  Receivers check magic and version and read count records. The sequence
+ *  of the header counts the datagrams of one sender (worker), the sequence
+ *  of a record the records of one tag, so a gap in either is a lost
+ *  datagram. time is the time of validity of the state (ros::Time, s), the
+ *  state was predicted to it; sendTime is when the datagram left.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _UDP_OUTPUT_h
+#define _UDP_OUTPUT_h
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#include <netinet/in.h>
+
+#include "state_history.h"
+
+#define UDP_OUTPUT_MAGIC        0x534f5044  // "DPOS"
+#define UDP_OUTPUT_VERSION      1
+#define UDP_OUTPUT_MTU          1472        // Largest UDP payload in a 1500 byte Ethernet frame
+#define UDP_OUTPUT_TTL          1           // Hops, the LAN only
+
+// Record flags
+#define UDP_RECORD_VALID        0x01        // The filter was seeded, the state is an estimate
+#define UDP_RECORD_PREDICTED    0x02        // Predicted predict_latency past now, time is in the future
+#define UDP_RECORD_ONBOARD      0x04        // Estimate of the filter on the tag, only the position variances are set
+
+typedef struct udp_output_header_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;         // Records in the datagram
+    uint32_t seq;           // Datagram of the sender
+    uint16_t sender;        // Worker
+    uint16_t recordSize;    // sizeof(udp_position_record_t)
+    double   sendTime;      // s
+}udp_output_header_t;
+
+typedef struct udp_position_record_s
+{
+    uint32_t seq;           // Record of the tag
+    uint16_t tag;           // Index of the tag in deca_ports
+    uint8_t  cell;
+    uint8_t  flags;         // UDP_RECORD_*
+    double   time;          // s, time of validity
+    float    pos[3];        // m
+    float    vel[3];        // m/s
+    float    cov[21];       // Upper triangle of the covariance of (pos, vel), row by row
+    float    reserved;
+}udp_position_record_t;
+
+static_assert(sizeof(udp_output_header_t) == 24, "UDP output header layout");
+static_assert(sizeof(udp_position_record_t) == 128, "UDP position record layout");
+
+#define UDP_OUTPUT_MAX_RECORDS  ((UDP_OUTPUT_MTU - sizeof(udp_output_header_t)) / sizeof(udp_position_record_t))
+
+/*
+ * One per worker, only used by its thread. start() opens a tick, add()
+ * fills the datagram and sends it once full, flush() sends the rest at the
+ * end of the tick.
+ */
+class UdpOutput
+{
+public:
+
+    UdpOutput();
+    ~UdpOutput();
+
+    /*
+     * address is "group:port", e.g. "239.255.0.1:5005", a unicast address
+     * works as well. interface is the IPv4 address of the interface to send
+     * from, empty for the default route.
+     */
+    bool open(const std::string &address, const std::string &interface, int ttl, uint16_t sender, std::string &error);
+    bool isOpen() const { return fd >= 0; }
+
+    void start(double now);
+    void add(uint16_t tag, uint8_t cell, uint8_t flags, uint32_t seq, const StateSample &sample);
+    void flush();
+
+    // Datagrams sendto refused, e.g. without a route
+    uint32_t getSendErrors() const { return sendErrors; }
+
+private:
+
+    UdpOutput(const UdpOutput &) = delete;
+    UdpOutput &operator=(const UdpOutput &) = delete;
+
+    int fd;
+    struct sockaddr_in destination;
+    uint16_t sender;
+    uint32_t seq;
+    uint32_t sendErrors;
+    size_t count;
+    double tickTime;            // s, sendTime of the datagrams of the tick
+    struct
+    {
+        udp_output_header_t header;
+        udp_position_record_t records[UDP_OUTPUT_MAX_RECORDS];
+    } datagram;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*************************************************
+ *
+ *  Reads a tag over libusb instead of the tty layer. The port claims the CDC
+ *  data interface of the tag (the kernel cdc_acm driver lets go of it) and
+ *  keeps USB_TRANSFERS asynchronous bulk IN transfers in flight, so the host
+ *  controller always has a buffer to complete into while the reader decodes
+ *  the last one. Every transfer completes on a short packet, i.e. as soon as
+ *  the tag stops sending, without the buffering and the wake-up of the line
+ *  discipline.
+ *
+ *  The buffers come from libusb_dev_mem_alloc where libusb and the kernel
+ *  have it: memory usbfs maps for the device, which it transfers in place
+ *  instead of copying. Elsewhere they are plain heap buffers.
+ *
+ *  A port is named "usb:<vid>:<pid>[:<serial>]", vendor and product ID in
+ *  hex, the serial number to pick one of several tags. All calls, write
+ *  included, belong to the one thread that reads the port.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _USB_PORT_h
+#define _USB_PORT_h
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#define USB_PORT_PREFIX         "usb:"
+#define USB_TRANSFERS           4       // Bulk IN transfers in flight
+#define USB_TRANSFER_SIZE       512     // Bytes per transfer, a multiple of the packet size
+#define USB_WRITE_TIMEOUT_MS    100     // Longest wait of a command to the tag
+#define USB_RETRY_MS            500     // Between two attempts to open a tag not plugged in
+
+struct libusb_context;
+struct libusb_device_handle;
+struct libusb_transfer;
+
+// True if port names a tag for UsbPort rather than a tty
+bool isUsbPort(const std::string &port);
+
+class UsbPort
+{
+public:
+
+    UsbPort();
+    ~UsbPort();
+
+    // Opens the tag named by port and starts the transfers, false with the reason in error
+    bool open(const std::string &port, std::string &error);
+    void close();
+    bool isOpen() const { return handle != NULL; }
+    // The tag was unplugged, close and open it again
+    bool isGone() const { return gone; }
+
+    // Returns right away if a transfer completed, otherwise handles events until one does or timeoutMs passed
+    bool waitReadable(int timeoutMs);
+
+    // Copies up to size bytes of the completed transfers, a transfer read to its end is submitted again
+    size_t read(uint8_t *data, size_t size);
+
+    // Bulk OUT to the tag, returns the bytes sent
+    size_t write(const uint8_t *data, size_t size);
+
+    // Transfers that completed with an error and were submitted again
+    uint32_t getErrors() const { return errors; }
+
+private:
+
+    struct Slot
+    {
+        UsbPort *port;
+        libusb_transfer *transfer;
+        uint8_t *buffer;
+        bool pinned;            // From libusb_dev_mem_alloc
+        bool pending;           // Submitted and not completed yet
+    };
+
+    static void completed(libusb_transfer *transfer);
+    bool submit(Slot &slot);
+
+    libusb_context *context;
+    libusb_device_handle *handle;
+    int dataInterface, commInterface;
+    uint8_t endpointIn, endpointOut;
+    bool gone;
+    uint32_t errors;
+
+    Slot slots[USB_TRANSFERS];
+    // Completed transfers in the order they completed, offset bytes of the first one were read
+    int done[USB_TRANSFERS];
+    int doneHead, doneCount;
+    size_t offset;
+};
+
+#endif
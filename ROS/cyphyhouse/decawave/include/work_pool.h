@@ -0,0 +1,117 @@
+/*************************************************
+ *
+ *  Small work-stealing pool for batches of independent offline jobs.
+ *  Each worker owns a deque of job indices, takes work from its back and,
+ *  once it runs dry, steals from the front of the others. Jobs are meant to
+ *  be coarse (whole filter runs), so one mutex per deque is plenty.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _WORK_POOL_h
+#define _WORK_POOL_h
+
+#include <cstddef>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <memory>
+
+class WorkStealingPool
+{
+public:
+
+    // 0 workers uses one per hardware thread
+    explicit WorkStealingPool(unsigned workers = 0)
+    {
+        nworkers = (workers > 0) ? workers : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    unsigned size() const { return nworkers; }
+
+    /*
+     * Runs job(index, worker) for every index in [0, count) and returns once
+     * all are done. Indices are dealt round-robin up front, so neighbours in a
+     * sweep (often of similar cost) start on different workers.
+     */
+    template <typename Job>
+    void run(size_t count, Job job)
+    {
+        std::vector<std::unique_ptr<WorkerQueue> > queues;
+        for (unsigned w = 0; w < nworkers; w++)
+        {
+            queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            queues[i % nworkers]->jobs.push_back(i);
+        }
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 1; w < nworkers; w++)
+        {
+            threads.push_back(std::thread([&, w]{ workerLoop(queues, w, job); }));
+        }
+        workerLoop(queues, 0, job);
+
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+    }
+
+private:
+
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<size_t> jobs;
+    };
+
+    template <typename Job>
+    void workerLoop(std::vector<std::unique_ptr<WorkerQueue> > &queues, unsigned w, Job &job)
+    {
+        size_t index;
+        while (popOwn(*queues[w], index) || steal(queues, w, index))
+        {
+            job(index, w);
+        }
+    }
+
+    static bool popOwn(WorkerQueue &q, size_t &index)
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.jobs.empty())
+        {
+            return false;
+        }
+        index = q.jobs.back();
+        q.jobs.pop_back();
+        return true;
+    }
+
+    // No job is ever added once the batch started, so finding every queue empty means we are done
+    bool steal(std::vector<std::unique_ptr<WorkerQueue> > &queues, unsigned w, size_t &index)
+    {
+        for (unsigned k = 1; k < nworkers; k++)
+        {
+            WorkerQueue &victim = *queues[(w + k) % nworkers];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.jobs.empty())
+            {
+                index = victim.jobs.front();
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned nworkers;
+};
+
+#endif
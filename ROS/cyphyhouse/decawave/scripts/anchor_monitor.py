@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+# Live view of the anchor network from the telemetry frames the anchors send
+# over USART2 (ANCHOR_TELEMETRY_MS in TREK_TDOA tdoa_anc.h, frame layout in
+# common/tdoa_protocol.h).
+#
+#   anchor_monitor.py /dev/ttyUSB0 /dev/ttyUSB1 ...   one port per anchor
+#   anchor_monitor.py capture.bin ...                 raw captures, prints the last state
+#
+# Per anchor: TDMA state, slots, rates of the last period (receptions, empty
+# slots, errors, packets sent, late transmits and receives) and the sync
+# events since the monitor started. Then the times of flight each anchor
+# measured to the others, with the pairs whose two directions disagree.
+# Other frames on the same stream (trace frames) are skipped.
+import sys
+import time
+import argparse
+
+FRAME_SYNC = 0xB7
+FRAME_DATA_BYTE = 64
+COUNTERS = 14
+MAX_ANCHORS = 16
+
+COUNTER_NAMES = ['rx', 'empty', 'err', 'tx', 'lateTx', 'lateRx', 'missed', 'lost', 'joins', 'watchdog',
+                 'failovers', 'states', 'isrMin', 'isrMax']
+STATES = ['listen', 'sync', 'synced']
+
+CPU_HZ = 72e6                       # STM32F105 core clock
+TICK_M = 299792458.0 / (499.2e6 * 128)   # m per DW1000 tick
+TOF_MISMATCH_M = 0.3                # Directions of a pair further apart are flagged
+
+
+def fletcher16(data):
+    sum1 = 0xff
+    sum2 = 0xff
+    for b in data:
+        sum1 = (sum1 + b) % 255
+        sum2 = (sum2 + sum1) % 255
+    # The firmware keeps 0xff where the mod-255 loop gives 0, compare both
+    return sum1, sum2
+
+
+def checksum_ok(frame, cs):
+    sum1, sum2 = fletcher16(frame)
+    return ((cs & 0xff) % 255 == sum1) and ((cs >> 8) % 255 == sum2)
+
+
+def get_be(data, offset, size):
+    v = 0
+    for i in range(size):
+        v = (v << 8) | data[offset + i]
+    return v
+
+
+def decode(frame):
+    anchors = frame[2]
+    t = {
+        'anchor': frame[1],
+        'anchors': anchors,
+        'period': get_be(frame, 3, 2),
+        'state': frame[5],
+        'active': get_be(frame, 6, 2),
+        'tof': [get_be(frame, FRAME_DATA_BYTE + 2 * k, 2) for k in range(anchors)],
+        'time': time.time(),
+    }
+    for i, name in enumerate(COUNTER_NAMES):
+        t[name] = get_be(frame, 8 + 4 * i, 4)
+    return t
+
+
+def parse(buf, anchors):
+    """Consumes the complete telemetry frames of buf into anchors, returns the unparsed rest."""
+    idx = 0
+    while len(buf) - idx >= FRAME_DATA_BYTE:
+        if buf[idx] != FRAME_SYNC or buf[idx + 2] > MAX_ANCHORS:
+            idx += 1
+            continue
+        size = FRAME_DATA_BYTE + 2 * buf[idx + 2] + 2
+        if len(buf) - idx < size:
+            break
+        frame = buf[idx:idx + size]
+        if not checksum_ok(frame[:-2], (frame[-2] << 8) | frame[-1]):
+            idx += 1
+            continue
+        t = decode(frame)
+        entry = anchors.setdefault(t['anchor'], {'first': t, 'prev': None, 'last': None})
+        entry['prev'] = entry['last']
+        entry['last'] = t
+        idx += size
+    return buf[idx:]
+
+
+def delta(entry, name, base):
+    return (entry['last'][name] - entry[base][name]) & 0xFFFFFFFF
+
+
+def slots(active):
+    return ','.join('%d' % k for k in range(MAX_ANCHORS) if active & (1 << k)) or '-'
+
+
+def show(anchors):
+    print('%-6s %-7s %-20s %6s %6s %5s %6s %6s %6s | %6s %5s %5s %5s %5s %8s'
+          % ('anchor', 'state', 'slots', 'rx/s', 'empty', 'err', 'tx/s', 'lateTx', 'lateRx',
+             'missed', 'lost', 'joins', 'wdog', 'fail', 'isr max'))
+    for a in sorted(anchors):
+        e = anchors[a]
+        t = e['last']
+        if e['prev'] is not None:
+            s = max(1e-3, t['period'] / 1000.0)
+            rates = [delta(e, n, 'prev') / s for n in ('rx', 'empty', 'err', 'tx')]
+            late = [delta(e, n, 'prev') for n in ('lateTx', 'lateRx')]
+        else:
+            rates = [float('nan')] * 4
+            late = [0, 0]
+        events = [delta(e, n, 'first') for n in ('missed', 'lost', 'joins', 'watchdog', 'failovers')]
+        state = STATES[t['state']] if t['state'] < len(STATES) else '?'
+        print('%d:%-4d %-7s %-20s %6.1f %6.1f %5.1f %6.1f %6d %6d | %6d %5d %5d %5d %5d %6.1fus'
+              % tuple([a // MAX_ANCHORS, a % MAX_ANCHORS, state, slots(t['active'])] + rates + late + events
+                      + [t['isrMax'] * 1e6 / CPU_HZ]))
+
+    # Times of flight, row anchor measured to column anchor, per cell
+    cells = sorted(set(a // MAX_ANCHORS for a in anchors))
+    for cell in cells:
+        rows = dict((a % MAX_ANCHORS, anchors[a]['last']['tof']) for a in anchors if a // MAX_ANCHORS == cell)
+        n = max(len(tof) for tof in rows.values())
+        print('\ncell %d, time of flight [m]' % cell)
+        print('      ' + ''.join('%7d' % k for k in range(n)))
+        mismatches = []
+        for r in sorted(rows):
+            line = '%4d  ' % r
+            for k in range(n):
+                tof = rows[r][k] if k < len(rows[r]) else 0
+                line += '%7.2f' % (tof * TICK_M) if tof else '      -'
+                back = rows.get(k, [])
+                if r < k and tof and k < n and k in rows and r < len(back) and back[r] \
+                        and abs(tof - back[r]) * TICK_M > TOF_MISMATCH_M:
+                    mismatches.append('%d-%d %.2f/%.2f m' % (r, k, tof * TICK_M, back[r] * TICK_M))
+            print(line)
+        if mismatches:
+            print('directions disagree: ' + ', '.join(mismatches))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Live view of the anchor telemetry')
+    parser.add_argument('sources', nargs='+', help='serial devices or capture files')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--interval', type=float, default=1.0, help='refresh period on serial devices, s')
+    args = parser.parse_args()
+
+    anchors = {}
+    files = [s for s in args.sources if not s.startswith('/dev/')]
+    for name in files:
+        with open(name, 'rb') as f:
+            parse(bytearray(f.read()), anchors)
+    if len(files) == len(args.sources):
+        if not anchors:
+            print('No anchor telemetry frames')
+            return 1
+        show(anchors)
+        return 0
+
+    import serial
+    ports = [serial.Serial(s, args.baud, timeout=0) for s in args.sources if s.startswith('/dev/')]
+    bufs = [bytearray() for _ in ports]
+    refresh = time.time()
+    try:
+        while True:
+            for i, port in enumerate(ports):
+                bufs[i] = parse(bufs[i] + bytearray(port.read(4096)), anchors)
+            if time.time() >= refresh:
+                refresh += args.interval
+                sys.stdout.write('\033[2J\033[H')
+                if anchors:
+                    show(anchors)
+                else:
+                    print('Waiting for anchor telemetry on %d ports' % len(ports))
+                sys.stdout.flush()
+            time.sleep(0.01)
+    except KeyboardInterrupt:
+        pass
+    for port in ports:
+        port.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
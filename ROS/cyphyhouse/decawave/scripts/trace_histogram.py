@@ -0,0 +1,126 @@
+#!/usr/bin/env python
+# Per-probe cycle histograms from the trace frames of firmware built with
+# TDOA_TRACE=1 (common/tdoa_trace.h, frame layout in common/tdoa_protocol.h).
+#
+#   trace_histogram.py /dev/ttyACM0 --seconds 10     tag over USB
+#   trace_histogram.py /dev/ttyUSB0 --baud 115200    anchor over USART2
+#   trace_histogram.py capture.bin                   raw capture of either
+#
+# Other frames on the same stream (measurements, status, telemetry) are skipped.
+import sys
+import time
+import argparse
+
+TRACE_FRAME_SYNC = 0xB0
+TRACE_FRAME_DATA_BYTE = 3
+TRACE_SAMPLE_SIZE = 4
+TRACE_FRAME_MAX_SAMPLES = 24
+
+# Same order as tdoa_trace_probe_e
+PROBES = ['dwt_isr', 'slotStep', 'setTxData', 'dwCorrectTimestamp']
+
+CPU_HZ = 72e6   # STM32F105 core clock of both boards
+BUCKETS = 20
+BAR_WIDTH = 40
+
+
+def fletcher16(data):
+    sum1 = 0xff
+    sum2 = 0xff
+    for b in data:
+        sum1 = (sum1 + b) % 255
+        sum2 = (sum2 + sum1) % 255
+    # The firmware keeps 0xff where the mod-255 loop gives 0, compare both
+    return sum1, sum2
+
+
+def checksum_ok(frame, cs):
+    sum1, sum2 = fletcher16(frame)
+    lo = cs & 0xff
+    hi = cs >> 8
+    return (lo % 255 == sum1) and (hi % 255 == sum2)
+
+
+def parse(buf, samples, stats):
+    """Consumes the complete trace frames of buf, returns the unparsed rest."""
+    idx = 0
+    while len(buf) - idx >= TRACE_FRAME_DATA_BYTE:
+        if buf[idx] != TRACE_FRAME_SYNC:
+            idx += 1
+            continue
+        count = buf[idx + 1]
+        if count == 0 or count > TRACE_FRAME_MAX_SAMPLES:
+            idx += 1
+            continue
+        size = TRACE_FRAME_DATA_BYTE + count * TRACE_SAMPLE_SIZE + 2
+        if len(buf) - idx < size:
+            break
+        frame = buf[idx:idx + size]
+        if not checksum_ok(frame[:-2], (frame[-2] << 8) | frame[-1]):
+            idx += 1
+            continue
+        stats['frames'] += 1
+        stats['lost'] += frame[2]
+        for i in range(count):
+            o = TRACE_FRAME_DATA_BYTE + i * TRACE_SAMPLE_SIZE
+            s = (frame[o] << 24) | (frame[o + 1] << 16) | (frame[o + 2] << 8) | frame[o + 3]
+            samples.setdefault(s >> 24, []).append(s & 0xFFFFFF)
+        idx += size
+    return buf[idx:]
+
+
+def percentile(sorted_values, p):
+    return sorted_values[min(len(sorted_values) - 1, int(p * len(sorted_values)))]
+
+
+def print_histogram(probe, values):
+    values.sort()
+    name = PROBES[probe] if probe < len(PROBES) else 'probe%d' % probe
+    lo = values[0]
+    hi = values[-1]
+    print('%s: %d calls, min %d, median %d, p99 %d, max %d cycles (max %.1f us)'
+          % (name, len(values), lo, percentile(values, 0.5), percentile(values, 0.99), hi, hi * 1e6 / CPU_HZ))
+
+    width = max(1, (hi - lo + BUCKETS) // BUCKETS)
+    counts = [0] * BUCKETS
+    for v in values:
+        counts[min(BUCKETS - 1, (v - lo) // width)] += 1
+    peak = max(counts)
+    for i, c in enumerate(counts):
+        if c == 0:
+            continue
+        start = lo + i * width
+        print('  %8d - %8d %7d %s' % (start, start + width - 1, c, '#' * max(1, c * BAR_WIDTH // peak)))
+    print('')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Cycle histograms of the firmware trace probes')
+    parser.add_argument('source', help='serial device or capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--seconds', type=float, default=10.0, help='capture time on a serial device')
+    args = parser.parse_args()
+
+    samples = {}
+    stats = {'frames': 0, 'lost': 0}
+    buf = bytearray()
+
+    if args.source.startswith('/dev/'):
+        import serial
+        port = serial.Serial(args.source, args.baud, timeout=0.1)
+        end = time.time() + args.seconds
+        while time.time() < end:
+            buf = parse(buf + bytearray(port.read(4096)), samples, stats)
+        port.close()
+    else:
+        with open(args.source, 'rb') as f:
+            buf = parse(bytearray(f.read()), samples, stats)
+
+    print('%d trace frames, %d samples lost on the device\n' % (stats['frames'], stats['lost']))
+    for probe in sorted(samples):
+        print_histogram(probe, samples[probe])
+    return 0 if stats['frames'] > 0 else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,180 @@
+/*************************************************
+ *
+ *  Anchor health tracking, see anchor_health.h
+ *
+ *************************************************/
+
+#include "anchor_health.h"
+
+AnchorHealth::AnchorHealth()
+{
+    reset(0);
+}
+
+void AnchorHealth::reset(int anchors)
+{
+    count = std::max(0, std::min(anchors, MAX_NR_ANCHORS));
+    windowStart = 0;
+    for (int k = 0; k < MAX_NR_ANCHORS; k++)
+    {
+        anchor_health_t &a = table[k];
+        a.state = ANCHOR_HEALTHY;
+        a.reason = ANCHOR_REASON_NONE;
+        a.received = 0;
+        a.receiveRatio = 1;
+        a.nis = 1;
+        a.bias = 0;
+        a.goodWindows = 0;
+        a.masks = 0;
+    }
+}
+
+bool AnchorHealth::addMeasurement(uint8_t Ar, uint8_t An, float error, float HPHR)
+{
+    if ((Ar >= count) || (An >= count) || !(HPHR > 0) || !std::isfinite(error))
+    {
+        return true;
+    }
+    table[An].received++;
+
+    const float nis = error*error / HPHR;
+    const bool maskedR = (table[Ar].state == ANCHOR_MASKED), maskedN = (table[An].state == ANCHOR_MASKED);
+    // A masked anchor must not spoil the statistics of its healthy partner
+    if (maskedN || !maskedR)
+    {
+        table[An].nis += ANCHOR_HEALTH_RATE * (nis - table[An].nis);
+        table[An].bias += ANCHOR_HEALTH_RATE * (error - table[An].bias);
+    }
+    if (maskedR || !maskedN)
+    {
+        table[Ar].nis += ANCHOR_HEALTH_RATE * (nis - table[Ar].nis);
+        table[Ar].bias += ANCHOR_HEALTH_RATE * (-error - table[Ar].bias);
+    }
+    return !maskedR && !maskedN;
+}
+
+bool AnchorHealth::isMasked(uint8_t anchor) const
+{
+    return (anchor < count) && (table[anchor].state == ANCHOR_MASKED);
+}
+
+anchor_reason_t AnchorHealth::fault(const anchor_health_t &a) const
+{
+    if (a.receiveRatio < ANCHOR_MASK_RECEIVE)
+    {
+        return ANCHOR_REASON_SILENT;
+    }
+    if (a.nis > ANCHOR_MASK_NIS)
+    {
+        return ANCHOR_REASON_INNOVATION;
+    }
+    if (std::fabs(a.bias) > ANCHOR_MASK_BIAS)
+    {
+        return ANCHOR_REASON_BIAS;
+    }
+    return ANCHOR_REASON_NONE;
+}
+
+bool AnchorHealth::recovered(const anchor_health_t &a) const
+{
+    return (a.receiveRatio >= ANCHOR_READMIT_RECEIVE) && (a.nis < ANCHOR_READMIT_NIS) && (std::fabs(a.bias) < ANCHOR_READMIT_BIAS);
+}
+
+void AnchorHealth::mask(int anchor, anchor_reason_t reason)
+{
+    table[anchor].state = ANCHOR_MASKED;
+    table[anchor].reason = reason;
+    table[anchor].goodWindows = 0;
+    table[anchor].masks++;
+}
+
+bool AnchorHealth::evaluate(double t)
+{
+    if (windowStart == 0)
+    {
+        windowStart = t;
+        return false;
+    }
+    if ((count == 0) || (t - windowStart < ANCHOR_HEALTH_WINDOW))
+    {
+        return false;
+    }
+    windowStart = t;
+
+    // ====== RECEIVE RATIOS ======
+    uint32_t best = 0;
+    for (int k = 0; k < count; k++)
+    {
+        best = std::max(best, table[k].received);
+    }
+    for (int k = 0; k < count; k++)
+    {
+        // Nothing heard at all says nothing about a single anchor
+        table[k].receiveRatio = (best > 0) ? (float)table[k].received / best : 1.0f;
+        table[k].received = 0;
+    }
+
+    // ====== READMISSION ======
+    bool changed = false;
+    int healthy = 0;
+    for (int k = 0; k < count; k++)
+    {
+        anchor_health_t &a = table[k];
+        if (a.state == ANCHOR_MASKED)
+        {
+            a.goodWindows = recovered(a) ? a.goodWindows + 1 : 0;
+            if (a.goodWindows >= ANCHOR_READMIT_WINDOWS)
+            {
+                a.state = ANCHOR_HEALTHY;
+                a.reason = ANCHOR_REASON_NONE;
+                changed = true;
+            }
+        }
+        healthy += (a.state == ANCHOR_HEALTHY);
+    }
+
+    // ====== MASKING ======
+    // Silent anchors only cost their own slots, the worst of the others goes one at a time
+    int worst = -1;
+    float worstScore = 1;
+    for (int k = 0; k < count; k++)
+    {
+        anchor_health_t &a = table[k];
+        if (a.state == ANCHOR_MASKED)
+        {
+            continue;
+        }
+        const anchor_reason_t reason = fault(a);
+        if (reason == ANCHOR_REASON_SILENT)
+        {
+            mask(k, reason);
+            healthy--;
+            changed = true;
+        }
+        else if (reason != ANCHOR_REASON_NONE)
+        {
+            const float score = std::max(a.nis / ANCHOR_MASK_NIS, std::fabs(a.bias) / ANCHOR_MASK_BIAS);
+            if (score > worstScore)
+            {
+                worst = k;
+                worstScore = score;
+            }
+        }
+    }
+    if ((worst >= 0) && (healthy > ANCHOR_MIN_HEALTHY))
+    {
+        mask(worst, fault(table[worst]));
+        changed = true;
+    }
+    return changed;
+}
+
+int AnchorHealth::getAnchorCount() const
+{
+    return count;
+}
+
+const anchor_health_t &AnchorHealth::get(int anchor) const
+{
+    return table[anchor];
+}
@@ -0,0 +1,455 @@
+/*************************************************
+ *
+ *  Anchor self-survey, see anchor_survey.h
+ *
+ *************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <algorithm>
+
+#include "anchor_survey.h"
+#include "tdoa_clock.h"
+
+#define SURVEY_MIN_STEP     1e-7    // m, LM stops once a step moves no coordinate further
+#define SURVEY_MAX_LAMBDA   1e10
+#define SURVEY_COPLANAR     1e-3    // Ratio of the smallest to the largest singular value of a flat reference
+
+AnchorSurvey::AnchorSurvey() : ranges(0), rejected(0)
+{
+}
+
+void AnchorSurvey::setKnown(const std::map<int, vec3d_t> &points)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    known = points;
+}
+
+void AnchorSurvey::setHint(const std::vector<std::vector<vec3d_t> > &layout)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    hint = layout;
+}
+
+void AnchorSurvey::addRanges(const tdoa_ranges_t &r)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint8_t i = 0; i < r.count; i++)
+    {
+        if ((r.Ar[i] == r.An) || (TDOA_CELL_OF(r.Ar[i]) != TDOA_CELL_OF(r.An)))
+        {
+            continue;
+        }
+        // Both directions of a pair measure the same distance
+        PairStats &p = pairs[std::make_pair(std::min(r.Ar[i], r.An), std::max(r.Ar[i], r.An))];
+        const double d = r.tof[i] * TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ;
+        if ((p.count >= SURVEY_MIN_SAMPLES) && (std::fabs(d - p.mean) > SURVEY_OUTLIER_GATE))
+        {
+            rejected++;
+            continue;
+        }
+        // Welford, the variance gives the weight of the pair
+        p.count++;
+        const double delta = d - p.mean;
+        p.mean += delta / p.count;
+        p.m2 += delta * (d - p.mean);
+        ranges++;
+    }
+}
+
+uint32_t AnchorSurvey::getRanges() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return ranges;
+}
+
+uint32_t AnchorSurvey::getRejected() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return rejected;
+}
+
+std::vector<SurveyCell> AnchorSurvey::solve()
+{
+    std::map<std::pair<int, int>, PairStats> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = pairs;
+    }
+
+    std::vector<SurveyCell> cells;
+    for (int c = 0; c < TDOA_MAX_CELLS; c++)
+    {
+        for (auto it = snapshot.begin(); it != snapshot.end(); ++it)
+        {
+            if (TDOA_CELL_OF(it->first.first) == c)
+            {
+                cells.push_back(solveCell(c, snapshot));
+                break;
+            }
+        }
+    }
+    return cells;
+}
+
+SurveyCell AnchorSurvey::solveCell(int cell, const std::map<std::pair<int, int>, PairStats> &stats)
+{
+    SurveyCell result;
+    result.cell = cell;
+    result.pairs = 0;
+    result.rms = 0;
+    result.max_residual = 0;
+
+    // i, j, mean, standard error
+    std::vector<Eigen::Vector4d> edges;
+    int n = 0;
+    for (auto it = stats.begin(); it != stats.end(); ++it)
+    {
+        const PairStats &p = it->second;
+        if ((TDOA_CELL_OF(it->first.first) != cell) || (p.count < SURVEY_MIN_SAMPLES))
+        {
+            continue;
+        }
+        const int i = TDOA_CELL_ANCHOR(it->first.first);
+        const int j = TDOA_CELL_ANCHOR(it->first.second);
+        const double error = std::sqrt(p.m2 / (p.count - 1) / p.count);
+        edges.push_back(Eigen::Vector4d(i, j, p.mean, std::max(error, SURVEY_MIN_RANGE_ERROR)));
+        n = std::max(n, j + 1);
+    }
+    result.pairs = edges.size();
+    if (n < SURVEY_MIN_ANCHORS)
+    {
+        result.problem = "fewer than " + std::to_string(SURVEY_MIN_ANCHORS) + " anchors with ranges";
+        return result;
+    }
+
+    // Every anchor needs 3 distances to be fixed in space, or all it can have in a smaller cell
+    std::vector<int> degree(n, 0);
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        degree[(int)edges[e](0)]++;
+        degree[(int)edges[e](1)]++;
+    }
+    for (int k = 0; k < n; k++)
+    {
+        if (degree[k] < std::min(3, n - 1))
+        {
+            result.problem += (result.problem.empty() ? "too few pairs of anchor " : ", ") + std::to_string(k);
+        }
+    }
+    if (!result.problem.empty())
+    {
+        return result;
+    }
+
+    Eigen::Matrix3Xd X;
+    auto prev = previous.find(cell);
+    if ((prev != previous.end()) && (prev->second.cols() == n))
+    {
+        X = prev->second;
+    }
+    else
+    {
+        // Missing pairs by their shortest path, only for the start
+        Eigen::MatrixXd D = Eigen::MatrixXd::Constant(n, n, std::numeric_limits<double>::infinity());
+        D.diagonal().setZero();
+        for (size_t e = 0; e < edges.size(); e++)
+        {
+            D((int)edges[e](0), (int)edges[e](1)) = D((int)edges[e](1), (int)edges[e](0)) = edges[e](2);
+        }
+        for (int m = 0; m < n; m++)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = 0; j < n; j++)
+                {
+                    D(i, j) = std::min(D(i, j), D(i, m) + D(m, j));
+                }
+            }
+        }
+
+        // Classical MDS, the Gram matrix of the centred points from the squared distances
+        const Eigen::MatrixXd J = Eigen::MatrixXd::Identity(n, n) - Eigen::MatrixXd::Constant(n, n, 1.0 / n);
+        const Eigen::MatrixXd B = -0.5 * J * D.cwiseProduct(D) * J;
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(B);
+        X = Eigen::Matrix3Xd::Zero(3, n);
+        for (int d = 0; d < std::min(3, n); d++)
+        {
+            // Eigenvalues ascending, a flat layout has a zero or slightly negative third one
+            const int col = n - 1 - d;
+            X.row(d) = std::sqrt(std::max(eig.eigenvalues()(col), 0.0)) * eig.eigenvectors().col(col).transpose();
+        }
+    }
+
+    // Into the frame first so the priors of the known points start close
+    alignFrame(X, cell);
+    refine(X, edges, cell);
+    alignFrame(X, cell);
+
+    double sum = 0;
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        const double r = (X.col((int)edges[e](0)) - X.col((int)edges[e](1))).norm() - edges[e](2);
+        sum += r * r;
+        result.max_residual = std::max(result.max_residual, std::fabs(r));
+    }
+    result.rms = std::sqrt(sum / edges.size());
+
+    previous[cell] = X;
+    result.anchors.resize(n);
+    for (int k = 0; k < n; k++)
+    {
+        result.anchors[k].x = X(0, k);
+        result.anchors[k].y = X(1, k);
+        result.anchors[k].z = X(2, k);
+    }
+    return result;
+}
+
+/*
+ * Levenberg-Marquardt over all coordinates. Without 3 known points the
+ * solution may still move rigidly, the damping keeps the steps finite and
+ * alignFrame fixes the frame afterwards.
+ */
+void AnchorSurvey::refine(Eigen::Matrix3Xd &X, const std::vector<Eigen::Vector4d> &edges, int cell) const
+{
+    const int n = X.cols();
+    std::vector<std::pair<int, Eigen::Vector3d> > priors;
+    for (auto it = known.begin(); it != known.end(); ++it)
+    {
+        if ((TDOA_CELL_OF(it->first) == cell) && (TDOA_CELL_ANCHOR(it->first) < n))
+        {
+            priors.push_back(std::make_pair(TDOA_CELL_ANCHOR(it->first), Eigen::Vector3d(it->second.x, it->second.y, it->second.z)));
+        }
+    }
+
+    auto cost = [&](const Eigen::Matrix3Xd &Y)
+    {
+        double c = 0;
+        for (size_t e = 0; e < edges.size(); e++)
+        {
+            const double r = ((Y.col((int)edges[e](0)) - Y.col((int)edges[e](1))).norm() - edges[e](2)) / edges[e](3);
+            c += r * r;
+        }
+        for (size_t k = 0; k < priors.size(); k++)
+        {
+            c += (Y.col(priors[k].first) - priors[k].second).squaredNorm() / (SURVEY_KNOWN_STD_DEV * SURVEY_KNOWN_STD_DEV);
+        }
+        return c;
+    };
+
+    double lambda = 1e-3;
+    double current = cost(X);
+    for (int iter = 0; (iter < SURVEY_ITERATIONS) && (lambda < SURVEY_MAX_LAMBDA); iter++)
+    {
+        // Normal equations straight from the residuals, each touches 3 or 6 coordinates
+        Eigen::MatrixXd H = Eigen::MatrixXd::Zero(3 * n, 3 * n);
+        Eigen::VectorXd g = Eigen::VectorXd::Zero(3 * n);
+        for (size_t e = 0; e < edges.size(); e++)
+        {
+            const int i = edges[e](0), j = edges[e](1);
+            const Eigen::Vector3d diff = X.col(i) - X.col(j);
+            const double dist = std::max(diff.norm(), 1e-6);
+            const double w = 1.0 / (edges[e](3) * edges[e](3));
+            const Eigen::Vector3d u = diff / dist;
+            const double r = dist - edges[e](2);
+            const Eigen::Matrix3d uu = w * u * u.transpose();
+            H.block<3,3>(3*i, 3*i) += uu;
+            H.block<3,3>(3*j, 3*j) += uu;
+            H.block<3,3>(3*i, 3*j) -= uu;
+            H.block<3,3>(3*j, 3*i) -= uu;
+            g.segment<3>(3*i) += w * r * u;
+            g.segment<3>(3*j) -= w * r * u;
+        }
+        const double wk = 1.0 / (SURVEY_KNOWN_STD_DEV * SURVEY_KNOWN_STD_DEV);
+        for (size_t k = 0; k < priors.size(); k++)
+        {
+            const int i = priors[k].first;
+            H.block<3,3>(3*i, 3*i) += wk * Eigen::Matrix3d::Identity();
+            g.segment<3>(3*i) += wk * (X.col(i) - priors[k].second);
+        }
+
+        while (lambda < SURVEY_MAX_LAMBDA)
+        {
+            Eigen::MatrixXd Hd = H;
+            // Marquardt scaling, the small constant covers coordinates no residual touches
+            Hd.diagonal() += lambda * (H.diagonal().array() + 1e-9).matrix();
+            const Eigen::VectorXd step = Hd.ldlt().solve(-g);
+            Eigen::Matrix3Xd Y = X + Eigen::Map<const Eigen::Matrix3Xd>(step.data(), 3, n);
+            const double next = cost(Y);
+            if (next < current)
+            {
+                X = Y;
+                current = next;
+                lambda = std::max(lambda / 10, 1e-9);
+                if (step.cwiseAbs().maxCoeff() < SURVEY_MIN_STEP)
+                {
+                    return;
+                }
+                break;
+            }
+            lambda *= 10;
+        }
+    }
+}
+
+/*
+ * Moves X rigidly into the frame of the reference points, a mirror image is
+ * allowed since MDS does not know the handedness. A flat reference, e.g. 3
+ * known points, fits its mirror image through its plane equally well, then
+ * the one with the anchors higher up on average is taken. The same goes for
+ * the z axis of the frame of anchors 0, 1 and 2.
+ */
+bool AnchorSurvey::alignFrame(Eigen::Matrix3Xd &X, int cell) const
+{
+    const int n = X.cols();
+    std::vector<int> index;
+    std::vector<Eigen::Vector3d> ref;
+    for (auto it = known.begin(); it != known.end(); ++it)
+    {
+        if ((TDOA_CELL_OF(it->first) == cell) && (TDOA_CELL_ANCHOR(it->first) < n))
+        {
+            index.push_back(TDOA_CELL_ANCHOR(it->first));
+            ref.push_back(Eigen::Vector3d(it->second.x, it->second.y, it->second.z));
+        }
+    }
+    if ((index.size() < 3) && (cell < (int)hint.size()) && ((int)hint[cell].size() >= n))
+    {
+        index.clear();
+        ref.clear();
+        for (int k = 0; k < n; k++)
+        {
+            index.push_back(k);
+            ref.push_back(Eigen::Vector3d(hint[cell][k].x, hint[cell][k].y, hint[cell][k].z));
+        }
+    }
+
+    if (index.size() < 3)
+    {
+        const Eigen::Vector3d origin = X.col(0);
+        const Eigen::Vector3d ex = (X.col(1) - origin).normalized();
+        const Eigen::Vector3d v = X.col(2) - origin;
+        const Eigen::Vector3d ey = (v - v.dot(ex) * ex).normalized();
+        Eigen::Matrix3d B;
+        B.row(0) = ex.transpose();
+        B.row(1) = ey.transpose();
+        B.row(2) = ex.cross(ey).transpose();
+        X = B * (X.colwise() - origin);
+        if (X.row(2).sum() < 0)
+        {
+            X.row(2) *= -1;
+        }
+        return false;
+    }
+
+    Eigen::Vector3d cs = Eigen::Vector3d::Zero(), cd = Eigen::Vector3d::Zero();
+    for (size_t k = 0; k < index.size(); k++)
+    {
+        cs += X.col(index[k]);
+        cd += ref[k];
+    }
+    cs /= index.size();
+    cd /= index.size();
+    Eigen::Matrix3d H = Eigen::Matrix3d::Zero();
+    for (size_t k = 0; k < index.size(); k++)
+    {
+        H += (X.col(index[k]) - cs) * (ref[k] - cd).transpose();
+    }
+
+    // Without the determinant correction of Kabsch the best rotation or reflection
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(H, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    const Eigen::Matrix3d R = svd.matrixV() * svd.matrixU().transpose();
+    Eigen::Matrix3Xd Y = (R * (X.colwise() - cs)).colwise() + cd;
+    if (svd.singularValues()(2) < SURVEY_COPLANAR * svd.singularValues()(0))
+    {
+        const Eigen::Matrix3d M = svd.matrixV() * Eigen::Vector3d(1, 1, -1).asDiagonal() * svd.matrixU().transpose();
+        Eigen::Matrix3Xd Z = (M * (X.colwise() - cs)).colwise() + cd;
+        if (Z.row(2).sum() > Y.row(2).sum())
+        {
+            Y = Z;
+        }
+    }
+    X = Y;
+    return true;
+}
+
+bool loadKnownAnchors(const std::string &path, std::map<int, vec3d_t> &points)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    std::string str;
+    int cell = 0;
+    int k;
+    vec3d_t pos;
+    while (std::getline(file, str))
+    {
+        if (sscanf(str.c_str(), " cell %d", &cell) == 1)
+        {
+            continue;
+        }
+        if ((cell >= 0) && (cell < TDOA_MAX_CELLS)
+            && (sscanf(str.c_str(), " %d: %f, %f, %f", &k, &pos.x, &pos.y, &pos.z) == 4) && (k >= 0) && (k < TDOA_MAX_ANCHORS))
+        {
+            points[TDOA_CELL_ID(cell, k)] = pos;
+        }
+    }
+    return true;
+}
+
+bool readAnchorFile(const std::string &path, std::vector<std::vector<vec3d_t> > &layout)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    layout.assign(1, std::vector<vec3d_t>());
+    std::string str;
+    int cell = 0;
+    vec3d_t pos;
+    while (std::getline(file, str))
+    {
+        if (sscanf(str.c_str(), " cell %d", &cell) == 1)
+        {
+            if ((cell >= 0) && (cell < TDOA_MAX_CELLS) && ((int)layout.size() <= cell))
+            {
+                layout.resize(cell + 1);
+            }
+            continue;
+        }
+        if ((cell >= 0) && (cell < TDOA_MAX_CELLS) && (sscanf(str.c_str(), "%f, %f, %f", &pos.x, &pos.y, &pos.z) == 3))
+        {
+            layout[cell].push_back(pos);
+        }
+    }
+    return true;
+}
+
+bool writeAnchorFile(const std::string &path, const std::vector<std::vector<vec3d_t> > &layout)
+{
+    // Written next to the file and renamed, a reader never sees half of it
+    const std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if (f == NULL)
+    {
+        return false;
+    }
+    for (size_t c = 0; c < layout.size(); c++)
+    {
+        if (c > 0)
+        {
+            fprintf(f, "cell %zu\n", c);
+        }
+        for (size_t k = 0; k < layout[c].size(); k++)
+        {
+            fprintf(f, "%.3f, %.3f, %.3f\n", layout[c][k].x, layout[c][k].y, layout[c][k].z);
+        }
+    }
+    const bool ok = (fclose(f) == 0);
+    return ok && (std::rename(tmp.c_str(), path.c_str()) == 0);
+}
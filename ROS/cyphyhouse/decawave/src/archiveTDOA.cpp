@@ -0,0 +1,170 @@
+/*************************************************
+ *
+ *  Packs tdoa_node captures (.tdc) into compressed columnar archives (.tda,
+ *  tdoa_archive.h) for keeping and uploading, and back.
+ *
+ *  Usage: tdoa_archive pack <capture file> [archive file]
+ *         tdoa_archive unpack <archive file> [capture file]
+ *         tdoa_archive info <archive file>
+ *
+ *  unpack writes a capture any tdoa tool reads, with the distance
+ *  differences and Vicon positions rounded to the archive quantum. Neither
+ *  command overwrites an existing file. info prints the chunks and the size
+ *  of each column before and after deflating.
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tdoa_capture.h"
+#include "tdoa_archive.h"
+
+static const char *columnNames[ARCHIVE_COLUMNS] = { "time", "vicon", "valid", "tdoa", "ref", "arrival" };
+
+static std::string replaceExtension(const std::string &path, const char *ext)
+{
+    return path.substr(0, path.find_last_of('.')) + ext;
+}
+
+static int pack(const std::string &in, const std::string &out)
+{
+    TDOACaptureReader reader;
+    if (!reader.open(in))
+    {
+        printf("%s is not a tdoa capture\n", in.c_str());
+        return 1;
+    }
+    TDOAArchiveWriter writer;
+    if (!writer.open(out, reader.getHeader()))
+    {
+        printf("Could not create %s (it may already exist)\n", out.c_str());
+        return 1;
+    }
+
+    tdoa_capture_record_t r;
+    while (reader.next(r))
+    {
+        writer.append(r);
+    }
+    const uint64_t count = writer.getRecordCount();
+    if (!writer.close())
+    {
+        printf("Could not write %s\n", out.c_str());
+        return 1;
+    }
+
+    const double raw = TDOA_CAPTURE_HEADER_SIZE + count * sizeof(tdoa_capture_record_t);
+    printf("%llu records from %s to %s, %.1f kB (%.1fx)\n", (unsigned long long)count, in.c_str(), out.c_str(),
+           writer.getBytes() / 1e3, raw / writer.getBytes());
+    return 0;
+}
+
+static int unpack(const std::string &in, const std::string &out)
+{
+    TDOAArchiveReader reader;
+    if (!reader.open(in))
+    {
+        printf("%s is not a tdoa archive\n", in.c_str());
+        return 1;
+    }
+    std::vector<tdoa_capture_record_t> records;
+    if (!reader.readAll(ARCHIVE_ALL_COLUMNS, records))
+    {
+        printf("%s is damaged\n", in.c_str());
+        return 1;
+    }
+
+    // Written in one go, the capture writer would drop records on a slow disk
+    int fd = open(out.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    FILE *file = (fd < 0) ? NULL : fdopen(fd, "wb");
+    if (file == NULL)
+    {
+        printf("Could not create %s (it may already exist)\n", out.c_str());
+        return 1;
+    }
+    const tdoa_capture_header_t &header = reader.getHeader().capture;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (records.empty() || (fwrite(records.data(), sizeof(tdoa_capture_record_t), records.size(), file) == records.size()));
+    ok = (fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        printf("Could not write %s\n", out.c_str());
+        return 1;
+    }
+
+    printf("%zu records from %s to %s\n", records.size(), in.c_str(), out.c_str());
+    return 0;
+}
+
+static int info(const std::string &in)
+{
+    TDOAArchiveReader reader;
+    if (!reader.open(in))
+    {
+        printf("%s is not a tdoa archive\n", in.c_str());
+        return 1;
+    }
+
+    const tdoa_archive_header_t &header = reader.getHeader();
+    printf("%s: %s, %s, %u anchors, %llu records in %zu chunks\n", in.c_str(), header.capture.robotType,
+           header.capture.viconObj, header.capture.anchorCount, (unsigned long long)reader.size(),
+           reader.getChunkCount());
+
+    uint64_t size[ARCHIVE_COLUMNS] = {}, rawSize[ARCHIVE_COLUMNS] = {};
+    uint64_t total = 0;
+    for (size_t c = 0; c < reader.getChunkCount(); c++)
+    {
+        const tdoa_archive_chunk_t &chunk = reader.getChunk(c);
+        printf("  chunk %zu: %u records, %.3f s to %.3f s\n", c, chunk.records, chunk.firstTimeUs / 1e6,
+               chunk.lastTimeUs / 1e6);
+        for (int col = 0; col < ARCHIVE_COLUMNS; col++)
+        {
+            size[col] += chunk.size[col];
+            rawSize[col] += chunk.rawSize[col];
+            total += chunk.size[col];
+        }
+    }
+    for (int col = 0; col < ARCHIVE_COLUMNS; col++)
+    {
+        printf("  %-8s %10llu B encoded %10llu B deflated\n", columnNames[col], (unsigned long long)rawSize[col],
+               (unsigned long long)size[col]);
+    }
+    const double raw = TDOA_CAPTURE_HEADER_SIZE + reader.size() * sizeof(tdoa_capture_record_t);
+    printf("  %.1f B per record, %.1fx smaller than the capture\n",
+           reader.size() ? (double)total / reader.size() : 0.0, total ? raw / total : 0.0);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: tdoa_archive pack <capture file> [archive file]\n");
+        printf("       tdoa_archive unpack <archive file> [capture file]\n");
+        printf("       tdoa_archive info <archive file>\n");
+        return 1;
+    }
+
+    const std::string action = argv[1];
+    const std::string in = argv[2];
+    if (action == "pack")
+    {
+        return pack(in, (argc > 3) ? argv[3] : replaceExtension(in, ".tda"));
+    }
+    if (action == "unpack")
+    {
+        return unpack(in, (argc > 3) ? argv[3] : replaceExtension(in, ".tdc"));
+    }
+    if (action == "info")
+    {
+        return info(in);
+    }
+    printf("Unknown command %s\n", action.c_str());
+    return 1;
+}
@@ -0,0 +1,118 @@
+/*************************************************
+ *
+ *  Offline benchmark of the TDOA filter for each precision policy.
+ *  Runs the same simulated anchor rotation through the float and double
+ *  filters and reports per-update latency and how far the covariance of
+ *  each policy drifts from the double reference, for the full and the UD
+ *  factorized covariance.
+ *
+ *  Usage: tdoa_benchmark [anchor file] [number of frames]
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+
+#define DEFAULT_FRAMES 20000
+#define FRAME_DT       0.016 // s, one rotation of 8 anchors at ~2 ms
+#define MEAS_NOISE     0.05  // m
+
+typedef struct bench_result_s
+{
+    double ns_per_update;
+    double pos_error;       // m, final distance to the true position
+    double min_eig;         // smallest eigenvalue of P at the end
+    double asym;            // max |P - P'| at the end
+    Eigen::Matrix<double, STATE_DIM, STATE_DIM> P;
+}bench_result_t;
+
+// Lab layout (anchorPos_hotdec.txt), used when no anchor file is given
+static anchor_layout_t layout = {8, {
+    {4.495, 0.600, 2.181}, {0.155, 0.190, 2.190}, {4.498, 4.342, 2.174}, {0.155, 4.240, 2.179},
+    {4.498, 0.670, 0.180}, {0.159, 0.780, 0.175}, {4.500, 4.332, 0.180}, {0.159, 4.360, 0.175}}};
+
+template <typename Scalar>
+static bench_result_t run(const std::vector<tdoa_frame_record_t> &frames, tdoa_update_mode_t mode,
+                          tdoa_covariance_mode_t cov = TDOA_COVARIANCE_FULL)
+{
+    typedef TDOAFilter<STATE_DIM, Scalar> Filter;
+    Filter ekf;
+
+    typename Filter::DynamicMatrix P0 = Filter::DynamicMatrix::Identity(STATE_DIM, STATE_DIM);
+    P0.bottomRightCorner(3, 3) *= 1e-2;
+    typename Filter::DynamicMatrix Q = Filter::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    Q.bottomRightCorner(3, 3).diagonal().setConstant(1e-5);
+    ekf.setPredictionMat(P0);
+    ekf.setCovarianceMat(Q);
+    ekf.setUpdateMode(mode);
+    ekf.setCovarianceMode(cov);
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+    vec3d_t init = {(float)frames[0].truth[0], (float)frames[0].truth[1], (float)frames[0].truth[2]};
+    ekf.setInitPos(init);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        for (size_t k = 0; k < frames[f].count; k++)
+        {
+            const tdoa_meas_t &m = frames[f].meas[k];
+            ekf.stateEstimatorPredictTo(m.timestamp);
+            ekf.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    bench_result_t res;
+    res.ns_per_update = std::chrono::duration<double, std::nano>(stop - start).count() / (frames.size()*layout.count);
+
+    vec3d_t p = ekf.getLocation();
+    const double *truth = frames.back().truth;
+    res.pos_error = (Eigen::Vector3d(p.x, p.y, p.z) - Eigen::Vector3d(truth[0], truth[1], truth[2])).norm();
+
+    res.P = ekf.getCovariance().template cast<double>();
+    res.asym = (res.P - res.P.transpose()).cwiseAbs().maxCoeff();
+    res.min_eig = Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, STATE_DIM, STATE_DIM> >(res.P).eigenvalues().minCoeff();
+    return res;
+}
+
+static void report(const char *name, const bench_result_t &r, const bench_result_t &ref)
+{
+    double drift = (r.P - ref.P).cwiseAbs().maxCoeff() / ref.P.cwiseAbs().maxCoeff();
+    printf("%-16s %10.1f ns/update   pos err %8.4f m   P drift %9.2e   min eig %9.2e   asym %9.2e\n",
+           name, r.ns_per_update, r.pos_error, drift, r.min_eig, r.asym);
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc > 1) && !loadAnchorLayout(argv[1], layout))
+    {
+        printf("Could not read anchors from %s\n", argv[1]);
+        return 1;
+    }
+    size_t frames = (argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_FRAMES;
+
+    std::vector<tdoa_frame_record_t> sim;
+    simulateCircle(layout, frames, FRAME_DT, MEAS_NOISE, sim);
+
+    printf("%zu frames, %zu scalar updates per policy\n", frames, frames*layout.count);
+
+    bench_result_t ref = run<double>(sim, TDOA_UPDATE_GENERAL);
+    report("double general", ref, ref);
+    report("double sparse", run<double>(sim, TDOA_UPDATE_SPARSE), ref);
+    report("float general", run<float>(sim, TDOA_UPDATE_GENERAL), ref);
+    report("float sparse", run<float>(sim, TDOA_UPDATE_SPARSE), ref);
+    report("double UD", run<double>(sim, TDOA_UPDATE_SPARSE, TDOA_COVARIANCE_UD), ref);
+    report("float UD", run<float>(sim, TDOA_UPDATE_SPARSE, TDOA_COVARIANCE_UD), ref);
+
+    return 0;
+}
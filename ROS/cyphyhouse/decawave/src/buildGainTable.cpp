@@ -0,0 +1,373 @@
+/*************************************************
+ *
+ *  Computes the steady-state gain table of one cell of an anchor layout, see
+ *  gain_table.h, and reports how far the steady-state filter is from the
+ *  full EKF: both run on the same simulated pairs of a tag that rests at
+ *  random points and moves slowly between them, and the position errors
+ *  against the truth, the distance between the two estimates and the time
+ *  per update are printed.
+ *
+ *  Usage: gain_table <anchor file> [options]
+ *      --cell <n>            cell of the layout (default 0)
+ *      --step <m>            grid spacing (default 0.5)
+ *      --margin <m>          grid beyond the anchors (default 0.5)
+ *      --std <m>             pair noise of the filter (default 0.15)
+ *      --qpos <v>            position process noise per PROCESS_NOISE_STEP (default 1e-7)
+ *      --qvel <v>            velocity process noise per PROCESS_NOISE_STEP (default 1e-5)
+ *      --robot <type>        car or quadcopter (default), car keeps z fixed
+ *      --out <file>          table to write (default gain_table_<cell>.bin)
+ *      --compare <s>         simulated time of the comparison, 0 skips it (default 300)
+ *      --speed <m/s>         speed between the resting points (default 0.1)
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "anchor_survey.h"
+#include "gain_table.h"
+#include "tdoa_sim.h"
+
+#define COMPARE_REST_TIME   5.0     // s at every point
+#define COMPARE_INSET       1.0     // m, the points stay this far inside the anchors
+
+typedef struct gain_table_options_s
+{
+    std::string anchorFile;
+    int cell;
+    float step;
+    float margin;
+    float stdDev;
+    float qpos;
+    float qvel;
+    std::string robotType;
+    std::string outFile;
+    double compareTime;
+    double speed;
+}gain_table_options_t;
+
+static void usage()
+{
+    printf("Usage: gain_table <anchor file> [options]\n");
+    printf("    --cell <n>            cell of the layout (default 0)\n");
+    printf("    --step <m>            grid spacing (default %.2f)\n", GAIN_TABLE_STEP);
+    printf("    --margin <m>          grid beyond the anchors (default %.2f)\n", GAIN_TABLE_MARGIN);
+    printf("    --std <m>             pair noise of the filter (default 0.15)\n");
+    printf("    --qpos <v>            position process noise per PROCESS_NOISE_STEP (default 1e-7)\n");
+    printf("    --qvel <v>            velocity process noise per PROCESS_NOISE_STEP (default 1e-5)\n");
+    printf("    --robot <type>        car or quadcopter (default), car keeps z fixed\n");
+    printf("    --out <file>          table to write (default gain_table_<cell>.bin)\n");
+    printf("    --compare <s>         simulated time of the comparison, 0 skips it (default 300)\n");
+    printf("    --speed <m/s>         speed between the resting points (default 0.1)\n");
+}
+
+static bool parseArgs(int argc, char *argv[], gain_table_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.cell = 0;
+    opt.step = GAIN_TABLE_STEP;
+    opt.margin = GAIN_TABLE_MARGIN;
+    opt.stdDev = 0.15f;
+    opt.qpos = 1e-7f;
+    opt.qvel = 1e-5f;
+    opt.robotType = "quadcopter";
+    opt.compareTime = 300;
+    opt.speed = 0.1;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--cell")
+        {
+            opt.cell = atoi(val.c_str());
+        }
+        else if (arg == "--step")
+        {
+            opt.step = atof(val.c_str());
+        }
+        else if (arg == "--margin")
+        {
+            opt.margin = atof(val.c_str());
+        }
+        else if (arg == "--std")
+        {
+            opt.stdDev = atof(val.c_str());
+        }
+        else if (arg == "--qpos")
+        {
+            opt.qpos = atof(val.c_str());
+        }
+        else if (arg == "--qvel")
+        {
+            opt.qvel = atof(val.c_str());
+        }
+        else if (arg == "--robot")
+        {
+            opt.robotType = val;
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else if (arg == "--compare")
+        {
+            opt.compareTime = atof(val.c_str());
+        }
+        else if (arg == "--speed")
+        {
+            opt.speed = atof(val.c_str());
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (opt.outFile.empty())
+    {
+        opt.outFile = "gain_table_" + std::to_string(opt.cell) + ".bin";
+    }
+    return (opt.step > 0) && (opt.stdDev > 0) && (opt.qpos >= 0) && (opt.qvel >= 0) && (opt.speed > 0)
+           && ((opt.robotType == "car") || (opt.robotType == "quadcopter"));
+}
+
+// Same diagonal model as the robot type, with the process noise of the options
+static gain_table_model_t makeModel(const gain_table_options_t &opt)
+{
+    gain_table_model_t model;
+    model.stdDev = opt.stdDev;
+    model.slotTime = SIM_SLOT_TIME;
+    for (int j = 0; j < 3; j++)
+    {
+        model.transition[j] = 1;
+        model.transition[j+3] = 1;
+        model.processNoise[j] = opt.qpos;
+        model.processNoise[j+3] = opt.qvel;
+    }
+    if (opt.robotType == "car")
+    {
+        model.transition[STATE_VZ] = 0;
+        model.processNoise[STATE_Z] = 0;
+        model.processNoise[STATE_VZ] = 0;
+    }
+    return model;
+}
+
+static void setupFilter(TDOA &ekf, const gain_table_model_t &model, const anchor_layout_t &layout)
+{
+    TDOA::DynamicMatrix A = TDOA::DynamicMatrix::Identity(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix P = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix Q = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    for (int j = 0; j < STATE_DIM; j++)
+    {
+        A(j,j) = model.transition[j];
+        Q(j,j) = model.processNoise[j];
+    }
+    P.diagonal() << 10000, 10000, (model.processNoise[STATE_Z] > 0) ? 100 : 0, 1e-4, 1e-4, (model.transition[STATE_VZ] > 0) ? 1e-4 : 0;
+    ekf.setTransitionMat(A);
+    ekf.setPredictionMat(P);
+    ekf.setCovarianceMat(Q);
+    ekf.setUpdateMode(TDOA_UPDATE_SPARSE);
+    ekf.setStdDev(model.stdDev);
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+}
+
+/*
+ * Rest at random points inside the anchors, straight lines at speed in
+ * between. The car stays at the height of the anchor centroid.
+ */
+static std::vector<sim_waypoint_t> restTrajectory(const anchor_layout_t &layout, const gain_table_options_t &opt)
+{
+    Eigen::Vector3d lo = Eigen::Vector3d::Constant(INFINITY), hi = Eigen::Vector3d::Constant(-INFINITY), c = Eigen::Vector3d::Zero();
+    for (int i = 0; i < layout.count; i++)
+    {
+        const Eigen::Vector3d a(layout.pos[i].x, layout.pos[i].y, layout.pos[i].z);
+        lo = lo.cwiseMin(a);
+        hi = hi.cwiseMax(a);
+        c += a / layout.count;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        if (hi(k) - lo(k) > 2*COMPARE_INSET)
+        {
+            lo(k) += COMPARE_INSET;
+            hi(k) -= COMPARE_INSET;
+        }
+    }
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> u(0, 1);
+    std::vector<sim_waypoint_t> traj;
+    double t = 0;
+    Eigen::Vector3d last = Eigen::Vector3d::Zero();
+    while (t < opt.compareTime)
+    {
+        Eigen::Vector3d p;
+        for (int k = 0; k < 3; k++)
+        {
+            p(k) = lo(k) + u(gen)*(hi(k) - lo(k));
+        }
+        if (opt.robotType == "car")
+        {
+            p.z() = c.z();
+        }
+        if (!traj.empty())
+        {
+            t += (p - last).norm() / opt.speed;
+        }
+        sim_waypoint_t wp;
+        for (int k = 0; k < 3; k++)
+        {
+            wp.pos[k] = p(k);
+        }
+        wp.t = t;
+        traj.push_back(wp);
+        t += COMPARE_REST_TIME;
+        wp.t = t;
+        traj.push_back(wp);
+        last = p;
+    }
+    return traj;
+}
+
+static void compare(const GainTable &table, const gain_table_model_t &model, const anchor_layout_t &layout, const gain_table_options_t &opt)
+{
+    TDOA full, steady;
+    setupFilter(full, model, layout);
+    setupFilter(steady, model, layout);
+    steady.setCovarianceMode(TDOA_COVARIANCE_STEADY);
+    steady.setGainTable(&table);
+
+    tdoa_sim_config_t config = defaultSimConfig();
+    config.slotTime = model.slotTime;
+    TDOASimulator sim(layout, config);
+    sim.setTrajectory(restTrajectory(layout, opt));
+
+    // Both start from the same closed-form solution of the first frame
+    std::vector<tdoa_frame_record_t> first;
+    while (first.empty() || (first[0].count < BOOTSTRAP_MIN_ANCHORS - 1))
+    {
+        first.clear();
+        sim.generate(1, first);
+    }
+    if (!full.initFromFrame(first[0].meas, first[0].count) || !steady.initFromFrame(first[0].meas, first[0].count))
+    {
+        printf("The first frame does not bootstrap\n");
+        return;
+    }
+    full.stateEstimatorPredictTo(first[0].time);
+    steady.stateEstimatorPredictTo(first[0].time);
+
+    double errFull = 0, errSteady = 0, diff = 0, maxDiff = 0, tFull = 0, tSteady = 0;
+    size_t n = 0, settle = (size_t)(COMPARE_REST_TIME / model.slotTime);
+    tdoa_meas_t meas;
+    double truth[3];
+    while (sim.getTime() < opt.compareTime)
+    {
+        if (!sim.step(meas, truth))
+        {
+            continue;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        full.stateEstimatorPredictTo(meas.timestamp);
+        full.scalarTDOADistUpdate(meas.Ar, meas.An, meas.distanceDiff);
+        auto t1 = std::chrono::steady_clock::now();
+        steady.stateEstimatorPredictTo(meas.timestamp);
+        steady.scalarTDOADistUpdate(meas.Ar, meas.An, meas.distanceDiff);
+        auto t2 = std::chrono::steady_clock::now();
+        tFull += std::chrono::duration<double>(t1 - t0).count();
+        tSteady += std::chrono::duration<double>(t2 - t1).count();
+
+        // The first rest lets the full filter forget its start
+        if (settle > 0)
+        {
+            settle--;
+            continue;
+        }
+        const vec3d_t a = full.getLocation(), b = steady.getLocation();
+        const Eigen::Vector3d pa(a.x, a.y, a.z), pb(b.x, b.y, b.z), pt(truth[0], truth[1], truth[2]);
+        errFull += (pa - pt).squaredNorm();
+        errSteady += (pb - pt).squaredNorm();
+        diff += (pa - pb).squaredNorm();
+        maxDiff = std::max(maxDiff, (pa - pb).norm());
+        n++;
+    }
+    if (n == 0)
+    {
+        return;
+    }
+    const double updates = n + (size_t)(COMPARE_REST_TIME / model.slotTime);
+    printf("\nSimulated %.0f s at %.2f m/s between %.0f s rests, %zu updates\n", opt.compareTime, opt.speed, COMPARE_REST_TIME, n);
+    printf("%-10s %10s %12s\n", "", "RMSE (m)", "update (ns)");
+    printf("%-10s %10.4f %12.1f\n", "full EKF", std::sqrt(errFull / n), 1e9 * tFull / updates);
+    printf("%-10s %10.4f %12.1f\n", "steady", std::sqrt(errSteady / n), 1e9 * tSteady / updates);
+    printf("Steady from full EKF: RMS %.4f m, max %.4f m\n", std::sqrt(diff / n), maxDiff);
+}
+
+int main(int argc, char *argv[])
+{
+    gain_table_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<std::vector<vec3d_t> > layout;
+    if (!readAnchorFile(opt.anchorFile, layout))
+    {
+        printf("Could not read %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+    if ((opt.cell < 0) || (opt.cell >= (int)layout.size()) || (layout[opt.cell].size() < TDOA_MIN_ANCHORS))
+    {
+        printf("Cell %d of %s has fewer than %d anchors\n", opt.cell, opt.anchorFile.c_str(), TDOA_MIN_ANCHORS);
+        return 1;
+    }
+    const std::vector<vec3d_t> &anchors = layout[opt.cell];
+    const gain_table_model_t model = makeModel(opt);
+
+    auto start = std::chrono::steady_clock::now();
+    if (!GainTable::build(opt.outFile, opt.cell, anchors, model, opt.step, opt.margin))
+    {
+        printf("Could not write %s\n", opt.outFile.c_str());
+        return 1;
+    }
+    GainTable table;
+    std::string error;
+    if (!table.load(opt.outFile, error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    const gain_table_header_t &h = table.getHeader();
+    printf("Wrote %s: %u x %u x %u nodes, %zu anchors, %.1f s, %u nodes did not converge\n", opt.outFile.c_str(), h.nx, h.ny, h.nz,
+           anchors.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), h.unconverged);
+
+    if (opt.compareTime > 0)
+    {
+        anchor_layout_t sim_layout;
+        sim_layout.count = anchors.size();
+        for (size_t i = 0; i < anchors.size(); i++)
+        {
+            sim_layout.pos[i] = anchors[i];
+        }
+        compare(table, model, sim_layout, opt);
+    }
+    return 0;
+}
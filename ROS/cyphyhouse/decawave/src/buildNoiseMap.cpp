@@ -0,0 +1,229 @@
+/*************************************************
+ *
+ *  Computes the noise map of one cell of an anchor layout, see noise_map.h,
+ *  and prints how good the geometry is inside the anchors: GDOP percentiles
+ *  per height and optionally a top view of one height, for comparing anchor
+ *  placements before mounting them.
+ *
+ *  Usage: noise_map <anchor file> [options]
+ *      --cell <n>            cell of the layout (default 0)
+ *      --step <m>            grid spacing (default 0.25)
+ *      --margin <m>          grid beyond the anchors (default 1)
+ *      --ref-dist <m>        range with the nominal noise (default 5)
+ *      --out <file>          map to write (default noise_map_<cell>.bin)
+ *      --slice <z>           print the GDOP at height z
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "anchor_survey.h"
+#include "noise_map.h"
+
+typedef struct noise_map_options_s
+{
+    std::string anchorFile;
+    int cell;
+    float step;
+    float margin;
+    float refDist;
+    std::string outFile;
+    bool slice;
+    float sliceZ;
+}noise_map_options_t;
+
+static void usage()
+{
+    printf("Usage: noise_map <anchor file> [options]\n");
+    printf("    --cell <n>            cell of the layout (default 0)\n");
+    printf("    --step <m>            grid spacing (default %.2f)\n", NOISE_MAP_STEP);
+    printf("    --margin <m>          grid beyond the anchors (default %.1f)\n", NOISE_MAP_MARGIN);
+    printf("    --ref-dist <m>        range with the nominal noise (default %.1f)\n", NOISE_MAP_REF_DIST);
+    printf("    --out <file>          map to write (default noise_map_<cell>.bin)\n");
+    printf("    --slice <z>           print the GDOP at height z\n");
+}
+
+static bool parseArgs(int argc, char *argv[], noise_map_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.cell = 0;
+    opt.step = NOISE_MAP_STEP;
+    opt.margin = NOISE_MAP_MARGIN;
+    opt.refDist = NOISE_MAP_REF_DIST;
+    opt.slice = false;
+    opt.sliceZ = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--cell")
+        {
+            opt.cell = atoi(val.c_str());
+        }
+        else if (arg == "--step")
+        {
+            opt.step = atof(val.c_str());
+        }
+        else if (arg == "--margin")
+        {
+            opt.margin = atof(val.c_str());
+        }
+        else if (arg == "--ref-dist")
+        {
+            opt.refDist = atof(val.c_str());
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else if (arg == "--slice")
+        {
+            opt.slice = true;
+            opt.sliceZ = atof(val.c_str());
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (opt.outFile.empty())
+    {
+        opt.outFile = "noise_map_" + std::to_string(opt.cell) + ".bin";
+    }
+    return (opt.step > 0) && (opt.refDist > 0) && (opt.margin >= 0);
+}
+
+static float percentile(std::vector<float> &v, float q)
+{
+    if (v.empty())
+    {
+        return NAN;
+    }
+    const size_t k = std::min(v.size() - 1, (size_t)(q * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// GDOP as one character, '#' where the position is not observable
+static char gdopSymbol(float g)
+{
+    if (!std::isfinite(g) || (g >= 50))
+    {
+        return '#';
+    }
+    const char *scale = " .:-=+*%@";
+    const float edges[] = {1, 1.5f, 2, 3, 5, 8, 13, 21};
+    int k = 0;
+    while ((k < 8) && (g >= edges[k]))
+    {
+        k++;
+    }
+    return scale[k];
+}
+
+int main(int argc, char *argv[])
+{
+    noise_map_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<std::vector<vec3d_t> > layout;
+    if (!readAnchorFile(opt.anchorFile, layout))
+    {
+        printf("Could not read %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+    if ((opt.cell < 0) || (opt.cell >= (int)layout.size()) || (layout[opt.cell].size() < TDOA_MIN_ANCHORS))
+    {
+        printf("Cell %d of %s has fewer than %d anchors\n", opt.cell, opt.anchorFile.c_str(), TDOA_MIN_ANCHORS);
+        return 1;
+    }
+    const std::vector<vec3d_t> &anchors = layout[opt.cell];
+
+    if (!NoiseMap::build(opt.outFile, opt.cell, anchors, opt.step, opt.margin, opt.refDist))
+    {
+        printf("Could not write %s\n", opt.outFile.c_str());
+        return 1;
+    }
+    NoiseMap map;
+    std::string error;
+    if (!map.load(opt.outFile, error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    const noise_map_header_t &h = map.getHeader();
+    printf("Wrote %s: %u x %u x %u nodes, %zu anchors, %zu pairs\n", opt.outFile.c_str(), h.nx, h.ny, h.nz,
+           anchors.size(), anchors.size()*(anchors.size() - 1)/2);
+
+    // ====== SUMMARY ======
+    // Only the nodes inside the anchors, the margin is there for the interpolation
+    const float x0 = h.origin[0] + opt.margin, x1 = h.origin[0] + (h.nx - 1)*h.step - opt.margin;
+    const float y0 = h.origin[1] + opt.margin, y1 = h.origin[1] + (h.ny - 1)*h.step - opt.margin;
+    const float z0 = h.origin[2] + opt.margin, z1 = h.origin[2] + (h.nz - 1)*h.step - opt.margin;
+    printf("\n%8s %8s %8s %8s %10s\n", "z (m)", "GDOP 50%", "90%", "max", "unobserv.");
+    for (float z = z0; z <= z1 + 1e-3f; z += h.step)
+    {
+        std::vector<float> g;
+        size_t unobservable = 0;
+        for (float y = y0; y <= y1 + 1e-3f; y += h.step)
+        {
+            for (float x = x0; x <= x1 + 1e-3f; x += h.step)
+            {
+                const float v = map.gdop(x, y, z);
+                if (v >= 65535*NOISE_MAP_GDOP_LSB)
+                {
+                    unobservable++;
+                }
+                else
+                {
+                    g.push_back(v);
+                }
+            }
+        }
+        const float p50 = percentile(g, 0.5f), p90 = percentile(g, 0.9f);
+        const float max = g.empty() ? NAN : *std::max_element(g.begin(), g.end());
+        printf("%8.2f %8.2f %8.2f %8.2f %10zu\n", z, p50, p90, max, unobservable);
+    }
+
+    if (opt.slice)
+    {
+        printf("\nGDOP at z = %.2f m, x to the right, y up, o anchors within one step\n", opt.sliceZ);
+        printf("' ' < 1 <= '.' < 1.5 <= ':' < 2 <= '-' < 3 <= '=' < 5 <= '+' < 8 <= '*' < 13 <= '%%' < 21 <= '@', '#' unobservable\n");
+        for (int y = h.ny - 1; y >= 0; y--)
+        {
+            std::string row;
+            for (uint32_t x = 0; x < h.nx; x++)
+            {
+                const float px = h.origin[0] + x*h.step, py = h.origin[1] + y*h.step;
+                char c = gdopSymbol(map.gdop(px, py, opt.sliceZ));
+                for (size_t k = 0; k < anchors.size(); k++)
+                {
+                    if ((std::fabs(anchors[k].x - px) <= 0.5f*h.step) && (std::fabs(anchors[k].y - py) <= 0.5f*h.step)
+                        && (std::fabs(anchors[k].z - opt.sliceZ) <= h.step))
+                    {
+                        c = 'o';
+                    }
+                }
+                row += c;
+            }
+            printf("%s\n", row.c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*************************************************
+ *
+ *  Converts a binary tdoa_node capture (.tdc) to comma separated text.
+ *  The first columns are the ones tdoa_node used to write, so existing
+ *  scripts keep working, with nan for slots that were not received. The
+ *  reference anchor and arrival time of each slot follow (formatCaptureRow).
+ *  The anchor layout from the header is written next to it in the
+ *  anchorPos_*.txt format.
+ *
+ *  Usage: tdoa_capture_csv <capture file> [csv file] [anchor file]
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <string>
+
+#include "tdoa_capture.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: tdoa_capture_csv <capture file> [csv file] [anchor file]\n");
+        return 1;
+    }
+
+    TDOACaptureReader reader;
+    if (!reader.open(argv[1]))
+    {
+        printf("%s is not a tdoa capture\n", argv[1]);
+        return 1;
+    }
+
+    std::string in = argv[1];
+    std::string base = in.substr(0, in.find_last_of('.'));
+    std::string csv_path = (argc > 2) ? argv[2] : base + ".txt";
+    std::string anchor_path = (argc > 3) ? argv[3] : base + "_anchors.txt";
+
+    const tdoa_capture_header_t &header = reader.getHeader();
+    FILE *anchors = fopen(anchor_path.c_str(), "w");
+    if (anchors == NULL)
+    {
+        printf("Could not create %s\n", anchor_path.c_str());
+        return 1;
+    }
+    for (uint32_t i = 0; i < header.anchorCount; i++)
+    {
+        fprintf(anchors, "%.8g, %.8g, %.8g\n", header.anchorPos[i][0], header.anchorPos[i][1], header.anchorPos[i][2]);
+    }
+    fclose(anchors);
+
+    FILE *csv = fopen(csv_path.c_str(), "w");
+    if (csv == NULL)
+    {
+        printf("Could not create %s\n", csv_path.c_str());
+        return 1;
+    }
+
+    tdoa_capture_record_t r;
+    size_t count = 0;
+    while (reader.next(r))
+    {
+        char row[512];
+        formatCaptureRow(r, row, sizeof(row));
+        fputs(row, csv);
+        count++;
+    }
+    fclose(csv);
+
+    printf("%s (%s, %s): %zu records to %s, anchors to %s\n", argv[1], header.robotType, header.viconObj,
+           count, csv_path.c_str(), anchor_path.c_str());
+    return 0;
+}
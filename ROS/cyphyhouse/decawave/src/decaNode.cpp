@@ -7,223 +7,3529 @@
 #include <csignal>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <sys/stat.h>
 
 #include "ros/ros.h"
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include "geometry_msgs/Point.h"
+#include "geometry_msgs/PoseWithCovarianceStamped.h"
+#include "geometry_msgs/TwistWithCovarianceStamped.h"
+#include "std_msgs/UInt32.h"
+#include "std_msgs/UInt32MultiArray.h"
+#include "std_msgs/Float32MultiArray.h"
+#include "std_msgs/Time.h"
+#include "sensor_msgs/Imu.h"
+#include "std_srvs/Trigger.h"
+#include "diagnostic_msgs/DiagnosticArray.h"
 #include "ros/package.h"
 
 #include "Eigen/Dense"
+#include "Eigen/StdVector"
 #include "tdoa.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Metrics.h"
 #include "serial/serial.h"
+#include "frame_decoder.h"
+#include "latency_stats.h"
+#include "anchor_survey.h"
+#include "tdoa_clock.h"
+#include "state_history.h"
+#include "tdoa_imm.h"
+#include "tdoa_inertial.h"
+#include "tdoa_pose.h"
+#include "tdoa_pf.h"
+#include "tdoa_fleet.h"
+#include "noise_map.h"
+#include "gain_table.h"
+#include "anchor_health.h"
+#include "pair_select.h"
+#include "frame_ring.h"
+#include "udp_output.h"
+#include "usb_port.h"
+#include "tag_port.h"
+#include "rts_smoother.h"
+#include "tag_clock_sync.h"
+#include "tdoa_phy.h"
+#include "filter_checkpoint.h"
+#include "filter_consistency.h"
+#include "flight_recorder.h"
+#include "tdoa_raw_engine.h"
 
 
 #define DEVICE        "/dev/ttyACM0"
 #define SPEED         115200
-#define MSG_SIZE      9
+#define SERIAL_TIMEOUT_MS 100 // Longest wait for data before rechecking running
 
-#define MSG_TYPE_BYTE 0
-#define ANCR_BYTE     1
-#define ANCN_BYTE     2
-#define DATA_BYTE     3
-#define CS_BYTE       7
+#define PUB_RATE 100 //Hz, default
+#define MAX_PUB_RATE 200 //Hz, default per tag with publish_mode update
 
+#define MEAS_QUEUE_SIZE 256 // Must be a power of two
+#define IMU_QUEUE_SIZE 64   // Must be a power of two, several worker periods of a 200 Hz IMU
+#define QUEUE_STATS_PERIOD 1.0 //s
+#define JITTER_LIMIT 0.002 //s, default
+#define STAMPED_QUEUE_SIZE 50 // Deep enough that a slow subscriber still gets every estimate
+#define UNKNOWN_VARIANCE 1e6  // Orientation and angular rate are not estimated
 
-#define TYPE_TDOA     0xAA
+#define ONBOARD_STD_DEV 0.15f       // m, measurement noise sent to the tag, the TDOA filter default
+#define CONFIG_FRAME_GAP_MS 50      // The tag holds one USB command at a time
+#define SURVEY_SECONDS 20           // s, default period of the anchor survey
+#define SURVEY_MIN_MOVE 0.01        // m, smaller changes of a surveyed layout are not applied
+#define ANCHOR_WATCH_PERIOD 1.0     // s between two checks of anchor_file and the anchors parameter
+#define ANCHOR_MIN_SEPARATION 0.01  // m, two anchors of a cell closer than this are a typo
+#define POSE_QUERY_QUEUE_SIZE 10
+#define PHY_LINK_MARGIN 10.0        // dB over the sensitivity of a profile the weakest anchor needs for its suggestion
 
-#define SERIAL_BUF_SIZE 32
+// A measurement with the latency it had when the serial thread read it
+struct QueuedMeas
+{
+    tdoa_meas_t meas;                   // timestamp is the arrival at the tag in host time (clock_sync), else the read
+    float variance;                     // m^2, the one of the tag (tag_variance), 0 for the filter's own
+    double read;                        // s, host time of the read
+    float tag_latency, usb_latency;     // s, LATENCY_TAG and LATENCY_USB, negative if unknown
+};
+
+// Acceleration of an IMU message in the world frame without gravity
+struct ImuSample
+{
+    double t;               // s, stamp of the message
+    Eigen::Vector3f accel;  // m/s^2
+};
+
+// Anchor positions per cell, cell 0 first. The anchors of a cell are its TDMA slots
+typedef std::vector<std::vector<vec3d_t> > AnchorLayout;
+
+struct PoseChannel;
+
+/*
+ * Everything one tag needs apart from its filter: the serial port, the queue
+ * its reader thread fills, the current TDMA frame and its publishers.
+ */
+struct TagChannel
+{
+    // history holds fixed-size Eigen matrices
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    
+    std::string name;
+    std::string port;
+    std::thread serial_thread;
+    
+    size_t index;
+    
+    // publish_mode update: measurements applied since the last publish, and when that was (wall clock)
+    bool pub_pending;
+    double last_pub;
+    
+    // Decoded measurements from the serial thread, drained by the tag's worker
+    SPSCQueue<QueuedMeas, MEAS_QUEUE_SIZE> meas_queue;
+    // Pairs the raw engine solved from the raw timestamp frames of the tag, drained by the same worker
+    SPSCQueue<QueuedMeas, MEAS_QUEUE_SIZE> raw_queue;
+    
+    // Measurements of the current TDMA frame, applied together once the anchor rotation completes.
+    // Several per packet with the multi-pair modes of the tag, applyFrame keeps the independent ones
+    tdoa_meas_t frame_meas[FRAME_MAX_PAIRS];
+    float frame_variance[FRAME_MAX_PAIRS];
+    size_t frame_count;
+    
+    // Set once the filter was seeded from a closed-form fix
+    bool bootstrapped;
+    
+    // The filter ran in its outside mode at the last cycle (hull)
+    bool outside_hull;
+    
+    // Motion models run in parallel (imm), combined into the filter of the tag after every cycle
+    std::unique_ptr<TDOAIMM> imm;
+    ros::Publisher modelProbability_pub;
+    
+    // Accelerometer of the flight controller predicting between the pairs (imu_topic), combined into the filter of
+    // the tag like imm. Samples come from the IMU callback, imu_next is the first one past the measurements so far
+    std::unique_ptr<TDOAInertial> inertial;
+    SPSCQueue<ImuSample, IMU_QUEUE_SIZE> imu_queue;
+    ImuSample imu_next;
+    bool imu_pending;
+    ros::Subscriber imu_sub;
+    
+    // Filter of the two tags on one body (pose_pairs), shared with the other tag, pose_tag is which of the two this
+    // one is. Once it is seeded the pairs of both tags go to it
+    PoseChannel *pose;
+    uint8_t pose_tag;
+    
+    // Global localization until bootstrapped (particle_filter), restarted when the filter leaves the anchors
+    std::unique_ptr<TDOAParticleFilter> pf;
+    
+    // Cell whose anchors are loaded into the filter, follows the cell of the measurements
+    int cell;
+    // Layout the filter has the anchors of and its anchors_generation, only touched by the worker
+    std::shared_ptr<const AnchorLayout> anchors;
+    uint32_t anchors_seen;
+    
+    // Records of the tag sent by udp_output
+    uint32_t udp_seq;
+    
+    // Slot of the tag in the filter checkpoint (checkpoint), -1 without one, and the time it was last written
+    int checkpoint_slot;
+    double checkpoint_time;
+    
+    // Receive rate and innovations per anchor of the cell (anchor_health), the pairs of masked anchors are not applied
+    AnchorHealth health;
+    ros::Publisher anchorHealth_pub;
+    
+    // NIS statistics of the filter that takes the pairs (consistency), a lost filter is bootstrapped again
+    FilterConsistency consistency;
+    
+    ros::Publisher decaPos_pub, decaVel_pub;
+    ros::Publisher queueDepth_pub, queueDrops_pub;
+    ros::Publisher tagRxDrops_pub, tagQueueDrops_pub, lostPackets_pub;
+    ros::Publisher rejections_pub;
+    ros::Publisher pairNoise_pub;
+    
+    // Estimates at their time of validity, only sent when a measurement moved the state
+    ros::Publisher decaPose_pub, decaTwist_pub;
+    double last_stamp;
+    
+    // Those estimates for the pose at a given time, written by the worker, read by the poseQuery callback
+    StateHistory history;
+    ros::Subscriber poseQuery_sub;
+    ros::Publisher poseQuery_pub;
+    // State predicted to now + predict_latency, with its covariance
+    ros::Publisher decaPosePredicted_pub;
+    // The stamped estimates smoothed smoother_lag behind the newest one (smoother_lag)
+    std::unique_ptr<RTSSmoother> smoother;
+    ros::Publisher decaPoseSmoothed_pub;
+    
+    // Times the serial thread opened the port of the tag again after it went away
+    std::atomic<uint32_t> reconnects;
+    
+    // Loss counters reported by the tag firmware, written by the serial thread
+    std::atomic<uint32_t> tag_rx_drops, tag_queue_drops;
+    // Anchor packets without a measurement, from the packet indices of version 2 frames
+    std::atomic<uint32_t> lost_packets;
+    
+    // Last telemetry frame of the tag, telemetry_frames is 0 until one arrived
+    std::mutex telemetry_mutex;
+    tdoa_telemetry_t telemetry;
+    uint32_t telemetry_frames;
+    
+    // Last estimate of the filter on the tag (onboard_filter), position_frames is 0 until one arrived
+    std::mutex position_mutex;
+    tdoa_position_t position;
+    uint32_t position_frames;
+    double position_stamp;
+    // Written by the worker, the last position frame it published
+    uint32_t published_positions;
+    
+    // The tag and usb stages are recorded by the serial thread, the others by the worker
+    LatencyHistogram latency[LATENCY_STAGES];
+    TagClockTracker tag_clock;
+    // Host time of the tag clock from its sync frames (clock_sync), sync_frames counts them
+    TagClockSync clock_sync;
+    uint32_t sync_frames;
+    std::atomic<float> sync_drift, sync_excess;
+    ros::Publisher clockSync_pub;
+    // Measurements the worker applied in its current cycle, and the counts at the last publication
+    QueuedMeas applied[MEAS_QUEUE_SIZE];
+    size_t applied_count;
+    uint32_t published_latency[LATENCY_STAGES][LATENCY_BINS];
+    ros::Publisher latency_pub;
+    
+    // Served on metrics_port, registered once the port is known. The decoder counts of the last read
+    MetricCounter *bytes_metric, *frames_metric, *checksum_metric;
+    MetricHistogram *update_metric, *update_latency_metric;
+    uint32_t good_frames_seen, bad_frames_seen;
+    
+    TagChannel() : index(0), pub_pending(false), last_pub(0), frame_count(0), bootstrapped(false), outside_hull(false), imu_pending(false), pose(NULL), pose_tag(0), cell(0), anchors_seen(0), udp_seq(0), checkpoint_slot(-1), checkpoint_time(0), last_stamp(0), reconnects(0), tag_rx_drops(0), tag_queue_drops(0), lost_packets(0),
+                   telemetry_frames(0), position_frames(0), position_stamp(0), published_positions(0), sync_frames(0), sync_drift(0), sync_excess(0),
+                   applied_count(0), bytes_metric(NULL), frames_metric(NULL), checksum_metric(NULL), update_metric(NULL),
+                   update_latency_metric(NULL), good_frames_seen(0), bad_frames_seen(0)
+    {
+        memset(&telemetry, 0, sizeof(telemetry));
+        memset(&position, 0, sizeof(position));
+        memset(published_latency, 0, sizeof(published_latency));
+    }
+};
+
+/*
+ * Two tags on a rigid baseline (pose_pairs) and the pose filter of their
+ * body. The worker of the first tag owns the second as well, it drains the
+ * queues of both into the filter.
+ */
+struct PoseChannel
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    
+    size_t tags[POSE_TAGS];
+    TDOAPose filter;
+    // Cell of the first tag the filter has the anchors of
+    int cell;
+    ros::Publisher bodyPose_pub, bodyTwist_pub;
+    double last_stamp;
+    
+    PoseChannel() : cell(0), last_stamp(0)
+    {
+        tags[0] = tags[1] = 0;
+    }
+};
 
-#define SLEEP_TIME_MICROS 10 //us
+// Filter states of all tags, kept contiguous. Index i belongs to channels[i]
+std::vector<TDOA, Eigen::aligned_allocator<TDOA> > filters;
+std::vector<std::unique_ptr<TagChannel> > channels;
+std::vector<std::unique_ptr<PoseChannel> > poses;
+std::vector<std::thread> workers;
+// Worker of every tag and the tags of every worker: tag i goes to worker i % num_workers, the second tag of a pose
+// pair to the worker of the first
+std::vector<int> tag_worker;
+std::vector<std::vector<size_t> > worker_tags;
+ros::Publisher diagnostics_pub;
 
-#define PUB_RATE 100 //Hz
+// Scheduling of the serial threads and the workers, and the wake-up jitter of every worker
+ThreadConfig serial_config, estimator_config;
+std::vector<std::unique_ptr<LoopJitter> > worker_jitter;
+double jitter_limit, estimator_phase;
 
-uint8_t An, Ar, dist_recv;
-float tdoaDistDiff;
+// With publish_mode update a worker sleeps until a measurement of one of its tags is queued
+struct WorkerWake
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool pending;
+    
+    WorkerWake() : pending(false) {}
+};
+std::vector<std::unique_ptr<WorkerWake> > worker_wake;
+bool pub_on_update = false;
+double max_pub_rate;
 
-TDOA deca_ekf;
-std::mutex ekf_mutex;
-std::thread serial_thread;
+// Cleared to stop the threads, a nodelet outlives ros::ok() when it is unloaded
+std::atomic<bool> running(false);
 
 Eigen::MatrixXf P;
 Eigen::MatrixXf A;
 Eigen::MatrixXf Q;
 
-std::string device_port, robot_type;
+std::string device_port, device_ports, tag_names, robot_type, update_mode, covariance_mode, linearization, frame_update, robust_mode, frame_id;
+double pub_rate, gate_threshold, robust_k, adaptive_noise_rate;
+int num_workers, iekf_iterations;
+// A published layout is never changed. A reload or the survey publishes a new one (publishAnchors),
+// readers keep the snapshot they took and the old layout goes with its last reader. The workers
+// take a new snapshot between two cycles once anchors_generation moved
+std::shared_ptr<const AnchorLayout> anchor_layout(new AnchorLayout(1));
+std::atomic<uint32_t> anchors_generation(0);
+std::mutex anchors_write_mutex;     // Serializes the writers, readers never take it
+std::string anchor_file;
+bool use_watch_anchors = true;
+std::thread anchor_watch_thread;
 
-ros::Publisher decaPos_pub, decaVel_pub;
+bool use_frame_update = false;
+bool use_bootstrap = true;
+bool use_adaptive_noise = false;
+bool use_onboard_filter = false;
+bool use_push_anchors = true;
+bool use_latency_stats = true;
+bool use_clock_sync = true;
+int serial_baud = SPEED;
+bool use_tag_variance = true;
+double predict_latency = 0;
+double smoother_lag = 0;
+bool use_imm = false;
+// Comma separated per tag, empty for none
+std::string imu_topics;
+double imu_accel_noise, imu_bias_noise;
+std::string pose_pairs;
+double pose_baseline, pose_accel_noise, pose_yaw_noise;
+bool use_particle_filter = false;
+bool use_lockstep = false;
+bool use_anchor_health = false;
+bool use_consistency = false;
+bool use_hull = false;
+double hull_margin, hull_noise_scale;
+bool hull_iterate = true;
+double consistency_nis;
+int consistency_periods;
+// Rings of the recent measurements, innovations and states of every tag, dumped on request, alarm or crash
+bool use_recorder = true;
+int recorder_records;
+double recorder_seconds;
+std::string recorder_directory;
+std::unique_ptr<FlightRecorder> recorder;
+ros::ServiceServer recorder_service;
+std::thread recorder_thread;
+bool use_raw_engine = true;
+std::string tag_output_mode;
+int tag_output_packets;
+double tag_output_threshold;
+tdoa_output_config_t tag_output = {TDOA_OUTPUT_ALL, 0, 0.0f};
+std::unique_ptr<TDOARawEngine> raw_engine;
+std::thread raw_engine_thread;
+bool use_frame_ring = false;
+std::string udp_output_address, udp_interface;
+int udp_ttl;
+// Indexed by worker, the records of its tags
+std::vector<std::unique_ptr<UdpOutput> > udp_outputs;
+std::string imm_models;
+std::string noise_map_files, gain_table_files;
+// Indexed by cell, mapped once by start and only read afterwards
+std::unique_ptr<NoiseMap> noise_maps[TDOA_MAX_CELLS];
+std::unique_ptr<GainTable> gain_tables[TDOA_MAX_CELLS];
+double imm_switch_rate;
+std::string latency_trace_path;
+std::unique_ptr<LatencyTrace> latency_trace;
+bool use_survey = false;
+double survey_seconds;
+double phy_margin;
+std::string survey_known_path, survey_output_path;
+std::unique_ptr<AnchorSurvey> survey;
+std::thread survey_thread;
+int metrics_port;
+bool metrics_started = false;
+std::string checkpoint_path;
+double checkpoint_period, checkpoint_max_age;
+std::unique_ptr<FilterCheckpoint> checkpoint;
+tdoa_batch_mode_t frame_mode = TDOA_BATCH_JOINT;
 
 //Function prototypes
-void initRobotMatrices(std::string type);
+bool initRobotMatrices(ros::NodeHandle &nh, const std::string &type);
+
+
+std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::shared_ptr<const AnchorLayout> currentAnchors()
+{
+    return std::atomic_load(&anchor_layout);
+}
+
+/*
+ * One "x, y, z" line per anchor. A line "cell N" starts the anchors of cell
+ * N, the lines before the first one belong to cell 0. Empty lines and lines
+ * starting with # are skipped. Anything else, a cell with more than
+ * MAX_NR_ANCHORS or a single anchor, or two anchors at the same place fail
+ * the whole layout, source names it in the warning.
+ */
+bool parseAnchors(std::istream &in, const std::string &source, AnchorLayout &layout)
+{
+    AnchorLayout parsed(1);
+    std::string str;
+    vec3d_t pos;
+    int cell = 0;
+    char rest;
+    for (int line = 1; std::getline(in, str); line++)
+    {
+        const size_t start = str.find_first_not_of(" \t\r");
+        if ((start == std::string::npos) || (str[start] == '#'))
+        {
+            continue;
+        }
+        if (sscanf(str.c_str(), " cell %d %c", &cell, &rest) == 1)
+        {
+            if ((cell < 0) || (cell >= TDOA_MAX_CELLS))
+            {
+                ROS_WARN("%s:%d: cell %d is not below %d\n", source.c_str(), line, cell, TDOA_MAX_CELLS);
+                return false;
+            }
+            if ((int)parsed.size() <= cell)
+            {
+                parsed.resize(cell + 1);
+            }
+            continue;
+        }
+        if ((sscanf(str.c_str(), "%f, %f, %f %c", &pos.x, &pos.y, &pos.z, &rest) != 3)
+            || !std::isfinite(pos.x) || !std::isfinite(pos.y) || !std::isfinite(pos.z))
+        {
+            ROS_WARN("%s:%d: not \"x, y, z\" or \"cell N\": %s\n", source.c_str(), line, str.c_str());
+            return false;
+        }
+        std::vector<vec3d_t> &anchors = parsed[cell];
+        if (anchors.size() == MAX_NR_ANCHORS)
+        {
+            ROS_WARN("%s:%d: more than %d anchors in cell %d\n", source.c_str(), line, MAX_NR_ANCHORS, cell);
+            return false;
+        }
+        for (size_t k = 0; k < anchors.size(); k++)
+        {
+            const float dx = pos.x - anchors[k].x, dy = pos.y - anchors[k].y, dz = pos.z - anchors[k].z;
+            if (std::sqrt(dx*dx + dy*dy + dz*dz) < ANCHOR_MIN_SEPARATION)
+            {
+                ROS_WARN("%s:%d: anchor %zu of cell %d is at anchor %zu\n", source.c_str(), line, anchors.size(), cell, k);
+                return false;
+            }
+        }
+        anchors.push_back(pos);
+    }
+    for (size_t c = 0; c < parsed.size(); c++)
+    {
+        if (parsed[c].size() == 1)
+        {
+            ROS_WARN("%s: cell %zu has a single anchor\n", source.c_str(), c);
+            return false;
+        }
+    }
+    layout.swap(parsed);
+    return true;
+}
+
+// The anchors parameter if it is set, anchor_file otherwise
+bool loadAnchors(ros::NodeHandle &nh, AnchorLayout &layout, std::string &source)
+{
+    std::string text;
+    if (nh.getParam("anchors", text) && !text.empty())
+    {
+        std::istringstream in(text);
+        source = nh.resolveName("anchors");
+        return parseAnchors(in, source, layout);
+    }
+    std::ifstream file(anchor_file);
+    source = anchor_file;
+    if (!file)
+    {
+        ROS_WARN("Cannot read the anchors %s\n", anchor_file.c_str());
+        return false;
+    }
+    return parseAnchors(file, source, layout);
+}
+
+// Largest distance between the anchors of a and b, infinite if a cell differs in size
+float layoutChange(const AnchorLayout &a, const AnchorLayout &b)
+{
+    if (a.size() != b.size())
+    {
+        return INFINITY;
+    }
+    float change = 0;
+    for (size_t c = 0; c < a.size(); c++)
+    {
+        if (a[c].size() != b[c].size())
+        {
+            return INFINITY;
+        }
+        for (size_t k = 0; k < a[c].size(); k++)
+        {
+            const float dx = a[c][k].x - b[c][k].x, dy = a[c][k].y - b[c][k].y, dz = a[c][k].z - b[c][k].z;
+            change = std::max(change, std::sqrt(dx*dx + dy*dy + dz*dz));
+        }
+    }
+    return change;
+}
+
+// Makes layout the current one if it differs, the caller holds anchors_write_mutex
+bool publishAnchors(const AnchorLayout &layout)
+{
+    if (layoutChange(layout, *currentAnchors()) == 0)
+    {
+        return false;
+    }
+    std::atomic_store(&anchor_layout, std::shared_ptr<const AnchorLayout>(new AnchorLayout(layout)));
+    // After the store, a worker that sees the new generation also gets the new layout
+    anchors_generation++;
+    return true;
+}
 
+/*
+ * Maps the files of a comma separated list into tables by their cell
+ * (NoiseMap or GainTable), a file that cannot be used is skipped with a
+ * warning. kind names the tables in the messages.
+ */
+template <typename Table>
+void loadCellTables(const std::string &list, const char *kind, std::unique_ptr<Table> (&tables)[TDOA_MAX_CELLS])
+{
+    std::vector<std::string> files = splitList(list);
+    for (size_t k = 0; k < files.size(); k++)
+    {
+        std::unique_ptr<Table> table(new Table());
+        std::string error;
+        if (!table->load(files[k], error))
+        {
+            ROS_WARN("%s not used, %s\n", kind, error.c_str());
+            continue;
+        }
+        const int cell = table->getCell();
+        if (tables[cell])
+        {
+            ROS_WARN("%s %s not used, cell %d already has one\n", kind, files[k].c_str(), cell);
+            continue;
+        }
+        ROS_INFO("%s %s for cell %d\n", kind, files[k].c_str(), cell);
+        tables[cell] = std::move(table);
+    }
+}
 
-float to_float(uint8_t* buff)
+// The table of cell if it was computed for the current anchors of the cell, NULL otherwise
+template <typename Table>
+const Table *cellTable(const std::unique_ptr<Table> (&tables)[TDOA_MAX_CELLS], const char *kind, const TagChannel &tag, int cell)
 {
-    uint16_t char_for_move[2];
-    char_for_move[1] = (buff[0]<<8) | (buff[1]);
-    char_for_move[0] = (buff[2]<<8) | (buff[3]);
-    return(*(float*)(char_for_move));
+    if ((cell < 0) || (cell >= TDOA_MAX_CELLS) || !tables[cell] || (cell >= (int)tag.anchors->size()))
+    {
+        return NULL;
+    }
+    const float change = tables[cell]->layoutChange((*tag.anchors)[cell]);
+    if (change > NOISE_MAP_MAX_SHIFT)
+    {
+        ROS_WARN_THROTTLE(10, "%s of cell %d is %.2f m off the anchors, not used\n", kind, cell, change);
+        return NULL;
+    }
+    return tables[cell].get();
 }
 
-/* Fletcher checksum, borrowed from wikipedia */
-uint16_t serial_checksum(const uint8_t *data, size_t len)
+// A gain table holds the gains of one motion model, warns if it is not the one of the robot
+void checkGainTables()
 {
-    uint16_t sum1 = 0xff, sum2 = 0xff;
+    for (int c = 0; c < TDOA_MAX_CELLS; c++)
+    {
+        if (!gain_tables[c])
+        {
+            continue;
+        }
+        const gain_table_header_t &h = gain_tables[c]->getHeader();
+        for (int j = 0; j < STATE_DIM; j++)
+        {
+            if ((std::fabs(h.transition[j] - A(j,j)) > 1e-6f) || (std::fabs(h.processNoise[j] - Q(j,j)) > 1e-6f * std::max(1.0f, std::fabs(Q(j,j)))))
+            {
+                ROS_WARN("Gain table of cell %d was computed for another motion model than %s\n", c, robot_type.c_str());
+                break;
+            }
+        }
+    }
+}
 
-    while (len) {
-        unsigned tlen = len > 21 ? 21 : len;
-        len -= tlen;
-        do {
-            sum1 += *data++;
-            sum2 += sum1;
-        } while (--tlen);
-        sum1 = (sum1 & 0xff) + (sum1 >> 8);
-        sum2 = (sum2 & 0xff) + (sum2 >> 8);
+/*
+ * Middle of the anchors of a cell in double precision, the origin of the
+ * filters while the tag is in it. Far from the site origin the float
+ * geometry would otherwise subtract large coordinates.
+ */
+Eigen::Vector3d cellOrigin(const std::vector<vec3d_t> &anchors)
+{
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    for (size_t i = 0; i < anchors.size(); i++)
+    {
+        sum += Eigen::Vector3d(anchors[i].x, anchors[i].y, anchors[i].z);
     }
-    /* Second reduction step to reduce sums to 16 bits */
-    sum1 = (sum1 & 0xff) + (sum1 >> 8);
-    sum2 = (sum2 & 0xff) + (sum2 >> 8);
-    return sum2 << 8 | sum1;
+    return anchors.empty() ? sum : Eigen::Vector3d(sum / anchors.size());
 }
 
-void initAnchors(TDOA &ekf)
+// Loads the anchors of cell into the filters of the tag, the layout itself stays shared
+void setCellAnchors(TDOA &ekf, TagChannel &tag, int cell)
 {
-    std::string path = ros::package::getPath("decawave");
-    std::ifstream file( path+"/config/anchorPos.txt");
-    std::string str;
-    float x, y, z;
-    int i = 0;
-    while (std::getline(file, str))
+    if (cell >= (int)tag.anchors->size())
+    {
+        return;
+    }
+    const std::vector<vec3d_t> &anchors = (*tag.anchors)[cell];
+    tag.health.reset(anchors.size());
+    const NoiseMap *map = cellTable(noise_maps, "Noise map", tag, cell);
+    const GainTable *gains = cellTable(gain_tables, "Gain table", tag, cell);
+    ekf.setNoiseMap(map);
+    ekf.setGainTable(gains);
+    // Only the anchors of the cell are active in the filters, whatever the size of the layout,
+    // and the filters work relative to the middle of the cell
+    const Eigen::Vector3d origin = cellOrigin(anchors);
+    ekf.setOrigin(origin);
+    ekf.setActiveAnchors(anchors.data(), anchors.size());
+    if (tag.imm)
+    {
+        tag.imm->setOrigin(origin);
+        tag.imm->setActiveAnchors(anchors.data(), anchors.size());
+    }
+    if (tag.inertial)
+    {
+        tag.inertial->getFilter().setOrigin(origin);
+        tag.inertial->getFilter().setActiveAnchors(anchors.data(), anchors.size());
+    }
+    for (size_t i = 0; tag.pf && (i < anchors.size()); i++)
+    {
+        tag.pf->setAncPosition(i, anchors[i]);
+    }
+    if (tag.imm)
+    {
+        for (int k = 0; k < tag.imm->getModelCount(); k++)
+        {
+            tag.imm->getModel(k).setNoiseMap(map);
+            tag.imm->getModel(k).setGainTable(gains);
+        }
+    }
+    if (tag.inertial)
+    {
+        // Full covariance, no gain table
+        tag.inertial->getFilter().setNoiseMap(map);
+    }
+}
+
+// Bounding box of the anchors of cell grown by margin, false without enough anchors
+bool cellBounds(const TagChannel &tag, int cell, float margin, Eigen::Vector3f &lo, Eigen::Vector3f &hi)
+{
+    if ((cell >= (int)tag.anchors->size()) || ((*tag.anchors)[cell].size() < TDOA_MIN_ANCHORS))
+    {
+        return false;
+    }
+    const std::vector<vec3d_t> &anchors = (*tag.anchors)[cell];
+    lo.setConstant(INFINITY);
+    hi.setConstant(-INFINITY);
+    for (size_t i = 0; i < anchors.size(); i++)
+    {
+        const Eigen::Vector3f a(anchors[i].x, anchors[i].y, anchors[i].z);
+        lo = lo.cwiseMin(a);
+        hi = hi.cwiseMax(a);
+    }
+    lo.array() -= margin;
+    hi.array() += margin;
+    return true;
+}
+
+// Spreads the particles of the tag over its current cell and drops the filter estimate
+void restartParticles(TagChannel &tag)
+{
+    Eigen::Vector3f lo, hi;
+    if (!tag.pf || !cellBounds(tag, tag.cell, PF_HULL_MARGIN, lo, hi))
+    {
+        return;
+    }
+    tag.pf->reset(lo, hi);
+    tag.bootstrapped = false;
+}
+
+// True if the estimate left the box the particles start in, the filter diverged
+bool outsideAnchors(const TagChannel &tag, const vec3d_t &p)
+{
+    Eigen::Vector3f lo, hi;
+    if (!cellBounds(tag, tag.cell, PF_HULL_MARGIN, lo, hi))
+    {
+        return false;
+    }
+    const Eigen::Vector3f x(p.x, p.y, p.z);
+    return (x.array() < lo.array()).any() || (x.array() > hi.array()).any() || !x.allFinite();
+}
+
+/*
+ * Seeds the filter from the collapsed particle cloud at time t, velocity at
+ * rest with the variance of the robot model.
+ */
+void seedFromParticles(TDOA &ekf, TagChannel &tag, double t)
+{
+    vec3d_t mean;
+    Eigen::Matrix3f cov;
+    tag.pf->getEstimate(mean, cov);
+    
+    // The particles live in site coordinates, the state in the frame of the filter
+    const Eigen::Vector3d &origin = ekf.getOrigin();
+    TDOA::StateVector x = TDOA::StateVector::Zero();
+    x(STATE_X) = mean.x - origin.x();
+    x(STATE_Y) = mean.y - origin.y();
+    x(STATE_Z) = mean.z - origin.z();
+    TDOA::StateMatrix Ps = TDOA::StateMatrix::Zero();
+    Ps.topLeftCorner<3,3>() = cov;
+    Ps.bottomRightCorner<3,3>() = P.bottomRightCorner(3,3);
+    
+    if (tag.imm)
+    {
+        for (int k = 0; k < tag.imm->getModelCount(); k++)
+        {
+            tag.imm->getModel(k).setState(x, Ps, t);
+        }
+    }
+    ekf.setState(x, Ps, t);
+}
+
+// Stores the estimate of a bootstrapped tag once its checkpoint period passed
+void saveCheckpoint(TDOA &ekf, TagChannel &tag, double now)
+{
+    if (!checkpoint || (tag.checkpoint_slot < 0) || !tag.bootstrapped || (now - tag.checkpoint_time < checkpoint_period)
+        || (tag.cell >= (int)tag.anchors->size()))
+    {
+        return;
+    }
+    const std::vector<vec3d_t> &anchors = (*tag.anchors)[tag.cell];
+    filter_checkpoint_t cp;
+    cp.time = ekf.getTime();
+    cp.layoutHash = checkpointLayoutHash(anchors.data(), anchors.size());
+    cp.cell = tag.cell;
+    Eigen::Map<TDOA::StateVector>(cp.state) = ekf.getState();
+    Eigen::Map<Eigen::Matrix<float, STATE_DIM, STATE_DIM, Eigen::RowMajor> >(cp.covariance) = ekf.getCovariance();
+    checkpoint->save(tag.checkpoint_slot, cp);
+    tag.checkpoint_time = now;
+}
+
+/*
+ * Resumes the filter of the tag from its checkpoint if it is at most
+ * checkpoint_max_age old and the anchors of its cell are the same. The
+ * first prediction carries the state from the time of the checkpoint.
+ */
+bool resumeFromCheckpoint(TDOA &ekf, TagChannel &tag, double now)
+{
+    filter_checkpoint_t cp;
+    if (!checkpoint || !checkpoint->load(tag.checkpoint_slot, cp))
+    {
+        return false;
+    }
+    const double age = now - cp.time;
+    if ((cp.cell < 0) || (cp.cell >= (int)tag.anchors->size()) || !(age >= 0) || (age > checkpoint_max_age))
+    {
+        ROS_INFO("%s checkpoint is %.1f s old, starting over\n", tag.port.c_str(), age);
+        return false;
+    }
+    const std::vector<vec3d_t> &anchors = (*tag.anchors)[cp.cell];
+    if (cp.layoutHash != checkpointLayoutHash(anchors.data(), anchors.size()))
+    {
+        ROS_INFO("%s checkpoint has other anchors in cell %d, starting over\n", tag.port.c_str(), cp.cell);
+        return false;
+    }
+    TDOA::StateVector x = Eigen::Map<const TDOA::StateVector>(cp.state);
+    TDOA::StateMatrix Ps = Eigen::Map<const Eigen::Matrix<float, STATE_DIM, STATE_DIM, Eigen::RowMajor> >(cp.covariance);
+    if (!x.allFinite() || !Ps.allFinite())
+    {
+        return false;
+    }
+    
+    setCellAnchors(ekf, tag, cp.cell);
+    tag.cell = cp.cell;
+    if (tag.imm)
+    {
+        for (int k = 0; k < tag.imm->getModelCount(); k++)
+        {
+            tag.imm->getModel(k).setState(x, Ps, cp.time);
+        }
+    }
+    ekf.setState(x, Ps, cp.time);
+    if (tag.inertial)
+    {
+        tag.inertial->seed(ekf, cp.time);
+    }
+    tag.bootstrapped = true;
+    vec3d_t p = ekf.getLocation();
+    ROS_INFO("%s resumed at %.2f, %.2f, %.2f from a checkpoint %.2f s old\n", tag.port.c_str(), p.x, p.y, p.z, age);
+    return true;
+}
+
+// Measurement as read into the flight recorder, its anchors still with their cell
+void recordMeasurement(const TagChannel &tag, const QueuedMeas &queued)
+{
+    flight_record_t r = flightRecord(FLIGHT_RECORD_MEAS, tag.index, queued.meas.timestamp);
+    r.Ar = queued.meas.Ar;
+    r.An = queued.meas.An;
+    r.v[0] = queued.meas.distanceDiff;
+    r.v[1] = queued.variance;
+    r.v[2] = queued.read - queued.meas.timestamp;
+    r.v[3] = queued.tag_latency;
+    r.v[4] = queued.usb_latency;
+    recorder->ring(tag.index).add(r);
+}
+
+void recordEvent(const TagChannel &tag, flight_event_t event, double t, float a = 0, float b = 0, float c = 0, float d = 0)
+{
+    flight_record_t r = flightRecord(FLIGHT_RECORD_EVENT, tag.index, t);
+    r.Ar = event;
+    r.v[0] = a;
+    r.v[1] = b;
+    r.v[2] = c;
+    r.v[3] = d;
+    recorder->ring(tag.index).add(r);
+}
+
+// Anchors in the TDMA frame of cell, all slots if the layout lists too few
+int cellAnchorCount(const TagChannel &tag, int cell)
+{
+    const int count = (cell < (int)tag.anchors->size()) ? (*tag.anchors)[cell].size() : 0;
+    return (count >= TDOA_MIN_ANCHORS) ? count : MAX_NR_ANCHORS;
+}
+
+void applyFrame(TDOA &ekf, TagChannel &tag)
+{
+    if (tag.frame_count == 0)
+    {
+        return;
+    }
+    tag.frame_count = selectIndependentPairs(tag.frame_meas, tag.frame_variance, tag.frame_count);
+    if (tag.frame_count == 0)
+    {
+        return;
+    }
+    
+    if (!tag.bootstrapped && tag.pf)
+    {
+        // Frames go to the particles until their cloud collapsed to one position
+        tag.pf->update(tag.frame_meas, tag.frame_count);
+        if (tag.pf->converged())
+        {
+            seedFromParticles(ekf, tag, tag.frame_meas[tag.frame_count-1].timestamp);
+            tag.bootstrapped = true;
+            if (tag.inertial)
+            {
+                tag.inertial->seed(ekf, tag.frame_meas[tag.frame_count-1].timestamp);
+            }
+            vec3d_t p = ekf.getLocation();
+            ROS_INFO("%s localized at %.2f, %.2f, %.2f after %u frames\n", tag.port.c_str(), p.x, p.y, p.z, tag.pf->getFrames());
+            if (recorder)
+            {
+                recordEvent(tag, FLIGHT_EVENT_BOOTSTRAP, ekf.getTime(), p.x, p.y, p.z);
+            }
+        }
+    }
+    else if (!tag.bootstrapped)
+    {
+        // The first complete frame seeds the filter instead of updating it
+        tag.bootstrapped = tag.imm ? tag.imm->initFromFrame(tag.frame_meas, tag.frame_count) : ekf.initFromFrame(tag.frame_meas, tag.frame_count);
+        if (tag.bootstrapped && tag.inertial)
+        {
+            tag.inertial->seed(ekf, tag.frame_meas[tag.frame_count-1].timestamp);
+        }
+        if (tag.bootstrapped)
+        {
+            vec3d_t p = tag.imm ? tag.imm->getModel(0).getLocation() : ekf.getLocation();
+            ROS_INFO("%s bootstrapped at %.2f, %.2f, %.2f\n", tag.port.c_str(), p.x, p.y, p.z);
+            if (recorder)
+            {
+                recordEvent(tag, FLIGHT_EVENT_BOOTSTRAP, tag.frame_meas[tag.frame_count-1].timestamp, p.x, p.y, p.z);
+            }
+        }
+    }
+    else if (tag.imm)
+    {
+        tag.imm->batchTDOAUpdate(tag.frame_meas, tag.frame_count, frame_mode, tag.frame_variance);
+    }
+    else
+    {
+        ekf.batchTDOAUpdate(tag.frame_meas, tag.frame_count, frame_mode, tag.frame_variance);
+    }
+    
+    tag.frame_count = 0;
+}
+
+// True if meas repeats a pair of the packet of An at the end of the frame, the tag moved on a rotation
+static bool repeatsPair(const TagChannel &tag, const tdoa_meas_t &meas)
+{
+    for (size_t i = tag.frame_count; (i > 0) && (tag.frame_meas[i-1].An == meas.An); i--)
     {
-        sscanf(str.c_str(), "%f, %f, %f", &x,&y,&z);
-        ekf.setAncPosition(i, x, y, z);
-        i++;
+        if (tag.frame_meas[i-1].Ar == meas.Ar)
+        {
+            return true;
+        }
     }
+    return false;
 }
 
-void serial_comm()
+void addFrameMeasurement(TDOA &ekf, TagChannel &tag, const tdoa_meas_t &meas, float variance)
 {
-    uint8_t RX_idx = 0;
-    uint8_t serial_msg[SERIAL_BUF_SIZE];
-    bool ignoring_flag = false;
-    int bytes_avail;
+    if (tag.frame_count > 0)
+    {
+        // A lower anchor number means the previous rotation ended without its last anchor
+        if ((meas.An < tag.frame_meas[tag.frame_count-1].An) || repeatsPair(tag, meas))
+        {
+            applyFrame(ekf, tag);
+        }
+    }
+    
+    tag.frame_meas[tag.frame_count] = meas;
+    tag.frame_variance[tag.frame_count] = variance;
+    tag.frame_count++;
+    
+    if (tag.frame_count == FRAME_MAX_PAIRS)
+    {
+        applyFrame(ekf, tag);
+    }
+}
 
-    serial::Serial my_serial(device_port, SPEED, serial::Timeout::simpleTimeout(1000));
+/*
+ * Applies the frame once its last anchor was measured. Called when the queue
+ * ran empty, the pairs of one packet arrive together, so by then the packet
+ * of the last anchor brought all of them.
+ */
+void completeFrame(TDOA &ekf, TagChannel &tag)
+{
+    if ((tag.frame_count > 0) && (tag.frame_meas[tag.frame_count-1].An == cellAnchorCount(tag, tag.cell) - 1))
+    {
+        applyFrame(ekf, tag);
+    }
+}
 
-    while(ros::ok())
+/*
+ * Turns the cell-qualified anchor IDs of meas into the anchor numbers of the
+ * filter. A measurement of another cell loads the anchors of that cell first,
+ * the tag handed over. False for a cell without anchors in the layout.
+ */
+bool selectCell(TDOA &ekf, TagChannel &tag, tdoa_meas_t &meas)
+{
+    const int cell = TDOA_CELL_OF(meas.An);
+    const AnchorLayout &layout = *tag.anchors;
+    if ((TDOA_CELL_OF(meas.Ar) != cell) || (cell >= (int)layout.size()) || ((cell != 0) && layout[cell].empty()))
     {
-        bytes_avail = my_serial.available();
-        if(bytes_avail > 0)
+        return false;
+    }
+    
+    if (cell != tag.cell)
+    {
+        // The measurements still pending belong to the anchors of the old cell
+        applyFrame(ekf, tag);
+        setCellAnchors(ekf, tag, cell);
+        tag.cell = cell;
+        if (!tag.bootstrapped)
+        {
+            restartParticles(tag);
+        }
+        ROS_INFO("%s handed over to cell %d\n", tag.port.c_str(), cell);
+        if (recorder)
+        {
+            recordEvent(tag, FLIGHT_EVENT_HANDOVER, meas.timestamp, cell);
+        }
+    }
+    
+    meas.Ar = TDOA_CELL_ANCHOR(meas.Ar);
+    meas.An = TDOA_CELL_ANCHOR(meas.An);
+    return true;
+}
+
+/*
+ * Takes the innovation of meas into the anchor health of the tag, false if
+ * one of its anchors is masked and the pair must not be applied. Scalar
+ * updates come here predicted to the measurement, frames at the state of
+ * the last frame, a few ms off for the statistics.
+ */
+bool admitMeasurement(TDOA &ekf, TagChannel &tag, const tdoa_meas_t &meas)
+{
+    if (!use_anchor_health || !tag.bootstrapped)
+    {
+        return true;
+    }
+    TDOA &filter = tag.imm ? tag.imm->getModel(tag.imm->getMostLikely()) : ekf;
+    float error, HPHR;
+    const bool valid = tag.inertial ? tag.inertial->getFilter().pairInnovation(meas.Ar, meas.An, meas.distanceDiff, error, HPHR)
+                                    : filter.pairInnovation(meas.Ar, meas.An, meas.distanceDiff, error, HPHR);
+    if (!valid)
+    {
+        return true;
+    }
+    return tag.health.addMeasurement(meas.Ar, meas.An, error, HPHR);
+}
+
+// Logs the tag leaving and coming back into the hull of its anchors, as the filter that runs it saw it
+void checkHull(TDOA &ekf, TagChannel &tag)
+{
+    TDOA &filter = tag.imm ? tag.imm->getModel(tag.imm->getMostLikely()) : ekf;
+    const bool outside = tag.inertial ? tag.inertial->getFilter().isOutsideHull() : filter.isOutsideHull();
+    if (outside == tag.outside_hull)
+    {
+        return;
+    }
+    tag.outside_hull = outside;
+    const float distance = tag.inertial ? tag.inertial->getFilter().getHullDistance() : filter.getHullDistance();
+    if (outside)
+    {
+        ROS_WARN("%s left the hull of its anchors (%.2f m), conservative updates\n", tag.port.c_str(), distance);
+    }
+    else
+    {
+        ROS_INFO("%s is back inside the hull of its anchors\n", tag.port.c_str());
+    }
+}
+
+/*
+ * Predicts the inertial filter of the tag through the IMU samples up to time
+ * t, the first later one waits in imu_next for the next measurement. Before
+ * the filter is seeded the samples only leave the last acceleration held.
+ */
+void drainImu(TagChannel &tag, double t)
+{
+    while (tag.imu_pending || tag.imu_queue.pop(tag.imu_next))
+    {
+        if (tag.imu_next.t > t)
+        {
+            tag.imu_pending = true;
+            return;
+        }
+        tag.imu_pending = false;
+        tag.inertial->addAcceleration(tag.imu_next.t, tag.imu_next.accel);
+    }
+}
+
+/*
+ * Queues a pair of a tag of a seeded pose filter. The first tag takes the
+ * filter along to its cell, the pairs queued before are applied against the
+ * old anchors first. Pairs of the second tag from another cell are dropped,
+ * their anchor numbers are not those of the filter.
+ */
+void addPoseMeasurement(TagChannel &tag, const tdoa_meas_t &meas, float variance)
+{
+    PoseChannel &pose = *tag.pose;
+    const TagChannel &first = *channels[pose.tags[0]];
+    if (first.cell != pose.cell)
+    {
+        pose.filter.update();
+        pose.filter.configure(filters[pose.tags[0]]);
+        pose.cell = first.cell;
+    }
+    if (tag.cell == pose.cell)
+    {
+        pose.filter.add(tag.pose_tag, meas, variance);
+    }
+}
+
+// Next measurement of the tag, decoded pairs first, then those of the raw engine
+static bool popMeasurement(TagChannel &tag, QueuedMeas &queued)
+{
+    return tag.meas_queue.pop(queued) || tag.raw_queue.pop(queued);
+}
+
+// Applies everything the serial thread queued since the last cycle, returns the number of measurements
+size_t drainMeasurements(TDOA &ekf, TagChannel &tag)
+{
+    size_t count = 0;
+    QueuedMeas queued;
+    while (popMeasurement(tag, queued))
+    {
+        count++;
+        if (recorder)
+        {
+            recordMeasurement(tag, queued);
+        }
+        tdoa_meas_t &meas = queued.meas;
+        if (!selectCell(ekf, tag, meas))
+        {
+            continue;
+        }
+        if (use_latency_stats && (tag.applied_count < MEAS_QUEUE_SIZE))
+        {
+            tag.applied[tag.applied_count++] = queued;
+        }
+        if (tag.pose && tag.bootstrapped && tag.pose->filter.isSeeded())
+        {
+            // Applied together with the pairs of the other tag by drainPose
+            if (admitMeasurement(ekf, tag, meas))
+            {
+                addPoseMeasurement(tag, meas, queued.variance);
+            }
+        }
+        else if ((use_frame_update && !tag.inertial) || !tag.bootstrapped)
+        {
+            if (admitMeasurement(ekf, tag, meas))
+            {
+                addFrameMeasurement(ekf, tag, meas, queued.variance);
+            }
+        }
+        else if (tag.inertial)
+        {
+            // The accelerometer up to the measurement, then the pair
+            drainImu(tag, meas.timestamp);
+            tag.inertial->stateEstimatorPredictTo(meas.timestamp);
+            if (admitMeasurement(ekf, tag, meas))
+            {
+                tag.inertial->scalarTDOADistUpdate(meas.Ar, meas.An, meas.distanceDiff, queued.variance);
+            }
+        }
+        else if (tag.imm)
+        {
+            tag.imm->stateEstimatorPredictTo(meas.timestamp);
+            if (admitMeasurement(ekf, tag, meas))
+            {
+                tag.imm->scalarTDOADistUpdate(meas.Ar, meas.An, meas.distanceDiff, queued.variance);
+            }
+        }
+        else
+        {
+            ekf.stateEstimatorPredictTo(meas.timestamp);
+            if (!admitMeasurement(ekf, tag, meas))
+            {
+                continue;
+            }
+            ekf.scalarTDOADistUpdate(meas.Ar, meas.An, meas.distanceDiff, queued.variance);
+            //ekf.stateEstimatorFinalize(); //Commented out because it doesnt do anything right now
+        }
+    }
+    completeFrame(ekf, tag);
+    if (tag.imm && tag.bootstrapped && (count > 0))
+    {
+        tag.imm->output(ekf);
+    }
+    if (tag.inertial && tag.bootstrapped && (count > 0))
+    {
+        tag.inertial->output(ekf);
+    }
+    return count;
+}
+
+// The tags get configuration frames: anchors, the model of their filter or an output mode
+static bool configuresTag()
+{
+    return use_push_anchors || use_onboard_filter || (tag_output.mode != TDOA_OUTPUT_ALL);
+}
+
+/*
+ * Output mode of the tag (tag_output), the anchor layout of every cell,
+ * which the tag gates its distance differences with, and for the filter of
+ * the tag firmware (TAG_EKF) the motion model. Only the diagonals of A, P
+ * and Q are sent. A tag with the filter streams distance differences until
+ * it has the anchors of its cell. Firmware without these commands ignores
+ * them. Port is a serial::Serial or a RingPort.
+ */
+template <typename Port>
+void sendTagConfig(Port &port)
+{
+    uint8_t msg[TDOA_ANCHOR_FRAME_MAX_SIZE];
+    
+    if (tag_output.mode != TDOA_OUTPUT_ALL)
+    {
+        port.write(msg, tdoa_output_frame_encode(msg, &tag_output));
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_FRAME_GAP_MS));
+    }
+    if (!use_push_anchors && !use_onboard_filter)
+    {
+        return;
+    }
+    
+    if (use_onboard_filter)
+    {
+        tdoa_model_config_t model;
+        for (int i = 0; i < TDOA_MODEL_STATES; i++)
+        {
+            model.transition[i] = A(i,i);
+            model.covariance[i] = P(i,i);
+            model.noise[i] = Q(i,i);
+        }
+        model.stdDev = ONBOARD_STD_DEV;
+        port.write(msg, tdoa_model_frame_encode(msg, &model));
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_FRAME_GAP_MS));
+    }
+    
+    const std::shared_ptr<const AnchorLayout> snapshot = currentAnchors();
+    const AnchorLayout &layout = *snapshot;
+    for (size_t c = 0; c < layout.size(); c++)
+    {
+        tdoa_anchor_config_t anchors;
+        anchors.cell = c;
+        anchors.count = layout[c].size();
+        for (int k = 0; k < anchors.count; k++)
+        {
+            anchors.pos[k][0] = layout[c][k].x;
+            anchors.pos[k][1] = layout[c][k].y;
+            anchors.pos[k][2] = layout[c][k].z;
+        }
+        const size_t size = tdoa_anchor_frame_encode(msg, &anchors);
+        if (size == 0)
+        {
+            continue;
+        }
+        port.write(msg, size);
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_FRAME_GAP_MS));
+    }
+}
+
+// With publish_mode update, wakes the worker of tag after a measurement of it was queued
+void wakeWorker(size_t tag)
+{
+    if (!pub_on_update)
+    {
+        return;
+    }
+    WorkerWake &wake = *worker_wake[tag_worker[tag]];
+    {
+        std::lock_guard<std::mutex> lock(wake.mutex);
+        wake.pending = true;
+    }
+    wake.cv.notify_one();
+}
+
+// Sleeps the worker until a measurement of its tags is queued or until wall clock time until
+void waitForUpdate(WorkerWake &wake, double until)
+{
+    const double seconds = until - ros::WallTime::now().toSec();
+    std::unique_lock<std::mutex> lock(wake.mutex);
+    if (seconds > 0)
+    {
+        wake.cv.wait_for(lock, std::chrono::duration<double>(seconds), [&wake] { return wake.pending; });
+    }
+    wake.pending = false;
+}
+
+// A frame of the tag into the queue of its worker, now is the host time of the read
+void queueFrame(TagChannel *tag, const tdoa_frame_t &frame, double now)
+{
+    QueuedMeas queued;
+    tdoa_meas_t &meas = queued.meas;
+    meas.Ar = frame.Ar;
+    meas.An = frame.An;
+    meas.distanceDiff = frame.distanceDiff;
+    // Host receive time until the tag reports its own timestamps and synced its clock
+    meas.timestamp = now;
+    queued.read = now;
+    queued.variance = (use_tag_variance && (frame.flags & TDOA_FRAME_HAS_VARIANCE)) ? frame.variance : 0;
+    if (use_clock_sync && (frame.flags & TDOA_FRAME_HAS_TIME) && tag->clock_sync.valid())
+    {
+        meas.timestamp = tag->clock_sync.toHost(frame.rxTime);
+    }
+    
+    queued.tag_latency = -1;
+    queued.usb_latency = -1;
+    if (use_latency_stats && (frame.flags & TDOA_FRAME_HAS_TIME) && (frame.flags & TDOA_FRAME_HAS_SEND))
+    {
+        queued.tag_latency = tdoa_time_sub(frame.sendTime, frame.rxTime) / TDOA_TIMESTAMP_FREQ;
+        queued.usb_latency = tag->tag_clock.usbLatency(frame.sendTime, now);
+        tag->latency[LATENCY_TAG].record(queued.tag_latency);
+        tag->latency[LATENCY_USB].record(queued.usb_latency);
+    }
+    
+    // Never waits on the filter, a full queue drops and counts the measurement
+    tag->meas_queue.push(queued);
+    wakeWorker(tag->index);
+}
+
+// A sync frame of the tag, read is the host time of the read
+void syncClock(TagChannel *tag, const tdoa_sync_t &sync, double read)
+{
+    tag->sync_frames++;
+    if (!use_clock_sync)
+    {
+        return;
+    }
+    tag->clock_sync.addSync(sync.sofTime, read);
+    tag->sync_drift.store(tag->clock_sync.getDriftPpm(), std::memory_order_relaxed);
+    tag->sync_excess.store(tag->clock_sync.getExcess(), std::memory_order_relaxed);
+}
+
+// Arrival of the last measurement of a position frame in host time, the read without a synced clock
+static double positionStamp(TagChannel *tag, const tdoa_position_t &position, double read)
+{
+    return (use_clock_sync && tag->clock_sync.valid()) ? tag->clock_sync.toHost(position.rxTime) : read;
+}
+
+/*
+ * Decodes the bytes_read bytes just read into decoder and takes over the
+ * frames and counters of the tag. Shared by the tty and the libusb reader.
+ */
+void decodeRead(TagChannel *tag, TDOAFrameDecoder &decoder, size_t bytes_read)
+{
+    decoder.commit(bytes_read, [tag](const tdoa_frame_t &frame)
+    {
+        queueFrame(tag, frame, ros::Time::now().toSec());
+    }, [](const tdoa_ranges_t &ranges)
+    {
+        if (survey)
+        {
+            survey->addRanges(ranges);
+        }
+    }, [tag](const tdoa_raw_frame_t &raw)
+    {
+        if (!raw_engine)
+        {
+            return false;
+        }
+        // Stamped here, the clock sync of the tag belongs to this thread
+        const double now = ros::Time::now().toSec();
+        const double stamp = (use_clock_sync && tag->clock_sync.valid()) ? tag->clock_sync.toHost(raw.rxAn_by_T) : now;
+        raw_engine->add(tag->index, raw, now, stamp);
+        return true;
+    });
+    
+    tag->bytes_metric->add(bytes_read);
+    tag->frames_metric->add(decoder.getGoodFrames() - tag->good_frames_seen);
+    tag->checksum_metric->add(decoder.getBadFrames() - tag->bad_frames_seen);
+    tag->good_frames_seen = decoder.getGoodFrames();
+    tag->bad_frames_seen = decoder.getBadFrames();
+    
+    tag->tag_rx_drops.store(decoder.getTagStatus().rxDropped, std::memory_order_relaxed);
+    tag->tag_queue_drops.store(decoder.getTagStatus().outDropped, std::memory_order_relaxed);
+    tag->lost_packets.store(decoder.getLostPackets(), std::memory_order_relaxed);
+    
+    if (decoder.getSyncFrames() != tag->sync_frames)
+    {
+        syncClock(tag, decoder.getSync(), ros::Time::now().toSec());
+        tag->sync_frames = decoder.getSyncFrames();
+    }
+    
+    if (decoder.getTelemetryFrames() != tag->telemetry_frames)
+    {
+        std::lock_guard<std::mutex> lock(tag->telemetry_mutex);
+        tag->telemetry = decoder.getTelemetry();
+        tag->telemetry_frames = decoder.getTelemetryFrames();
+    }
+    
+    if (decoder.getPositionFrames() != tag->position_frames)
+    {
+        std::lock_guard<std::mutex> lock(tag->position_mutex);
+        tag->position = decoder.getPosition();
+        tag->position_frames = decoder.getPositionFrames();
+        tag->position_stamp = positionStamp(tag, tag->position, ros::Time::now().toSec());
+    }
+}
+
+/*
+ * After the port of the tag was opened again: the decoder resyncs on the
+ * next frame and the clocks of the tag are learned anew, the tag may have
+ * reset. The filter of the tag is the worker's and keeps its state across
+ * the gap, it predicts through it with the next measurement.
+ */
+void reconnected(TagChannel *tag, TDOAFrameDecoder &decoder, double lost)
+{
+    decoder.resync();
+    tag->clock_sync.reset();
+    tag->tag_clock = TagClockTracker();
+    tag->reconnects++;
+    ROS_INFO("%s reconnected after %.2f s\n", tag->port.c_str(), ros::WallTime::now().toSec() - lost);
+}
+
+/*
+ * Reads a tag through the tty layer. The port is resolved (tag_port.h)
+ * every time it is opened, so a tag named by its serial number or by a
+ * by-id link is found again after it re-enumerated. A read error, or the
+ * tty node going away or being created anew while the line is quiet,
+ * closes the port, and it is looked for every TAG_PORT_REOPEN_MS until the
+ * tag is back. The tag gets its configuration again then.
+ */
+void serial_comm(TagChannel *tag)
+{
+    TDOAFrameDecoder decoder;
+    std::unique_ptr<serial::Serial> my_serial;
+    std::string device, error;
+    uint64_t node = 0;
+    uint32_t config_generation = anchors_generation;
+    // Wall clock time the port went away, 0 before it was first opened
+    double lost = 0;
+
+    while(ros::ok() && running)
+    {
+        try
+        {
+            if (!my_serial)
+            {
+                if (!resolveTagPort(tag->port, device, error))
+                {
+                    ROS_WARN_THROTTLE(10.0, "%s\n", error.c_str());
+                    std::this_thread::sleep_for(std::chrono::milliseconds(TAG_PORT_REOPEN_MS));
+                    continue;
+                }
+                my_serial.reset(new serial::Serial(device, serial_baud, serial::Timeout::simpleTimeout(SERIAL_TIMEOUT_MS)));
+                node = tagPortNode(device);
+                if (lost > 0)
+                {
+                    reconnected(tag, decoder, lost);
+                }
+                config_generation = anchors_generation;
+                if (configuresTag())
+                {
+                    sendTagConfig(*my_serial);
+                }
+            }
+            
+            // The tag gates with the surveyed anchors as well
+            if ((configuresTag()) && (config_generation != anchors_generation))
+            {
+                config_generation = anchors_generation;
+                sendTagConfig(*my_serial);
+            }
+            
+            // Blocks until data arrives or the timeout expires
+            if(!my_serial->waitReadable())
+            {
+                // A dead descriptor of a quiet tag may never report an error
+                if (tagPortNode(device) != node)
+                {
+                    throw std::runtime_error(device + " went away");
+                }
+                continue;
+            }
+            
+            // Read everything that is already waiting in one call
+            size_t bytes_avail = my_serial->available();
+            size_t bytes_read = my_serial->read(decoder.writePtr(), std::max<size_t>(1, std::min(bytes_avail, decoder.writeSpace())));
+            decodeRead(tag, decoder, bytes_read);
+        }
+        catch (const std::exception &e)
+        {
+            if (my_serial)
+            {
+                ROS_WARN("%s disconnected: %s\n", tag->port.c_str(), e.what());
+                lost = ros::WallTime::now().toSec();
+                my_serial.reset();
+            }
+            else
+            {
+                // Listed but not ready yet, udev may still be setting up the node
+                ROS_WARN_THROTTLE(10.0, "Cannot open %s: %s\n", device.c_str(), e.what());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(TAG_PORT_REOPEN_MS));
+        }
+    }
+    
+    my_serial.reset();
+    std::cout << "Closed serial " << tag->port << std::endl;
+}
+
+/*
+ * serial_comm for a port named usb:<vid>:<pid>[:<serial>]: the bulk
+ * transfers of the tag through libusb (usb_port.h), without the tty layer.
+ * A tag that is unplugged is opened again once it is back, and gets its
+ * configuration again.
+ */
+void usb_comm(TagChannel *tag)
+{
+    TDOAFrameDecoder decoder;
+    UsbPort port;
+    std::string error;
+    uint32_t config_generation = anchors_generation;
+    double lost = 0;
+    
+    while (ros::ok() && running)
+    {
+        if (!port.isOpen())
+        {
+            if (!port.open(tag->port, error))
+            {
+                ROS_WARN_THROTTLE(10.0, "%s\n", error.c_str());
+                std::this_thread::sleep_for(std::chrono::milliseconds(USB_RETRY_MS));
+                continue;
+            }
+            if (lost > 0)
+            {
+                reconnected(tag, decoder, lost);
+            }
+            config_generation = anchors_generation;
+            if (configuresTag())
+            {
+                sendTagConfig(port);
+            }
+        }
+        
+        if ((configuresTag()) && (config_generation != anchors_generation))
+        {
+            config_generation = anchors_generation;
+            sendTagConfig(port);
+        }
+        
+        // Handles the USB events until a transfer completed or the timeout expires
+        if (!port.waitReadable(SERIAL_TIMEOUT_MS))
+        {
+            if (port.isGone())
+            {
+                ROS_WARN("%s was unplugged\n", tag->port.c_str());
+                lost = ros::WallTime::now().toSec();
+                port.close();
+            }
+            continue;
+        }
+        
+        size_t bytes_read;
+        while ((bytes_read = port.read(decoder.writePtr(), decoder.writeSpace())) > 0)
+        {
+            decodeRead(tag, decoder, bytes_read);
+        }
+        if (port.getErrors() > 0)
+        {
+            ROS_WARN_THROTTLE(10.0, "%s: %u failed USB transfers\n", tag->port.c_str(), port.getErrors());
+        }
+    }
+    
+    port.close();
+    std::cout << "Closed USB " << tag->port << std::endl;
+}
+
+// Commands for the tag through the ring of its port, tag_reader sends them
+struct RingPort
+{
+    FrameRingReader &ring;
+    
+    size_t write(const uint8_t *data, size_t size)
+    {
+        while (!ring.send(data, size) && running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_FRAME_GAP_MS));
+        }
+        return size;
+    }
+};
+
+/*
+ * serial_comm for frame_ring: the frames tag_reader decoded from the port,
+ * read from its shared memory ring. The entries carry the host time of the
+ * read from the port, so the latencies include the hop through the ring.
+ */
+void ring_comm(TagChannel *tag)
+{
+    FrameRingReader ring;
+    std::string error;
+    while (ros::ok() && running && !ring.open(frameRingName(tag->port), error))
+    {
+        ROS_WARN_THROTTLE(10.0, "%s\n", error.c_str());
+        std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_RING_RETRY_MS));
+    }
+    
+    RingPort port = {ring};
+    uint32_t config_generation = anchors_generation;
+    if (ring.isOpen() && (configuresTag()))
+    {
+        sendTagConfig(port);
+    }
+    
+    uint64_t lost = 0;
+    frame_ring_entry_t entry;
+    while (ros::ok() && running)
+    {
+        if ((configuresTag()) && (config_generation != anchors_generation))
+        {
+            config_generation = anchors_generation;
+            sendTagConfig(port);
+        }
+        
+        if (!ring.wait(SERIAL_TIMEOUT_MS))
+        {
+            continue;
+        }
+        while (ring.next(entry))
+        {
+            // tag_reader counts the bytes and the checksums of the port
+            tag->frames_metric->add();
+            switch (entry.type)
+            {
+            case FRAME_RING_TDOA:
+                queueFrame(tag, entry.frame, entry.hostTime);
+                break;
+            case FRAME_RING_RANGES:
+                if (survey)
+                {
+                    survey->addRanges(entry.ranges);
+                }
+                break;
+            case FRAME_RING_STATUS:
+                tag->tag_rx_drops.store(entry.status.tag.rxDropped, std::memory_order_relaxed);
+                tag->tag_queue_drops.store(entry.status.tag.outDropped, std::memory_order_relaxed);
+                tag->lost_packets.store(entry.status.lostPackets, std::memory_order_relaxed);
+                break;
+            case FRAME_RING_TELEMETRY:
+            {
+                std::lock_guard<std::mutex> lock(tag->telemetry_mutex);
+                tag->telemetry = entry.telemetry;
+                tag->telemetry_frames++;
+                break;
+            }
+            case FRAME_RING_POSITION:
+            {
+                std::lock_guard<std::mutex> lock(tag->position_mutex);
+                tag->position = entry.position;
+                tag->position_frames++;
+                tag->position_stamp = positionStamp(tag, entry.position, entry.hostTime);
+                break;
+            }
+            case FRAME_RING_SYNC:
+                syncClock(tag, entry.sync, entry.hostTime);
+                break;
+            default:
+                break;
+            }
+        }
+        if (ring.getLost() != lost)
+        {
+            lost = ring.getLost();
+            ROS_WARN_THROTTLE(1.0, "%s fell behind its frame ring, %lu entries lost\n", tag->port.c_str(), (unsigned long)lost);
+        }
+    }
+    std::cout << "Closed frame ring " << tag->port << std::endl;
+}
+
+void pub_state(const TagChannel &tag, const vec3d_t p, const vec3d_t v)
+{
+    // Published as shared pointers, subscribers in the same nodelet manager get them without a copy
+    geometry_msgs::PointPtr pos_msg(new geometry_msgs::Point), vel_msg(new geometry_msgs::Point);
+    pos_msg->x = p.x;
+    pos_msg->y = p.y;
+    pos_msg->z = p.z;
+    tag.decaPos_pub.publish(pos_msg);
+    
+    vel_msg->x = v.x;
+    vel_msg->y = v.y;
+    vel_msg->z = v.z;
+    tag.decaVel_pub.publish(vel_msg);
+}
+
+// Filter state over (p, v) with its covariance
+StateSample state_sample(TDOA &ekf)
+{
+    vec3d_t p = ekf.getLocation();
+    vec3d_t v = ekf.getVelocity();
+    TDOA::StateMatrix P = ekf.getCovariance();
+    
+    StateSample sample;
+    sample.t = ekf.getTime();
+    sample.p << p.x, p.y, p.z;
+    sample.v << v.x, v.y, v.z;
+    sample.P = P.topLeftCorner<6, 6>().cast<double>();
+    return sample;
+}
+
+// State at the time of the last measurement with its covariance, for consumers doing their own latency compensation
+void pub_stamped_state(TagChannel &tag, TDOA &ekf)
+{
+    double t = ekf.getTime();
+    if (!tag.bootstrapped || (t <= tag.last_stamp))
+    {
+        return;
+    }
+    tag.last_stamp = t;
+    
+    vec3d_t p = ekf.getLocation();
+    vec3d_t v = ekf.getVelocity();
+    TDOA::StateMatrix P = ekf.getCovariance();
+    
+    geometry_msgs::PoseWithCovarianceStampedPtr pose_msg(new geometry_msgs::PoseWithCovarianceStamped);
+    pose_msg->header.stamp = ros::Time(t);
+    pose_msg->header.frame_id = frame_id;
+    pose_msg->pose.pose.position.x = p.x;
+    pose_msg->pose.pose.position.y = p.y;
+    pose_msg->pose.pose.position.z = p.z;
+    pose_msg->pose.pose.orientation.w = 1;
+    
+    geometry_msgs::TwistWithCovarianceStampedPtr twist_msg(new geometry_msgs::TwistWithCovarianceStamped);
+    twist_msg->header = pose_msg->header;
+    twist_msg->twist.twist.linear.x = v.x;
+    twist_msg->twist.twist.linear.y = v.y;
+    twist_msg->twist.twist.linear.z = v.z;
+    
+    // Row-major 6x6 over (x, y, z, rot x, rot y, rot z)
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            pose_msg->pose.covariance[i*6 + j] = P(STATE_X + i, STATE_X + j);
+            twist_msg->twist.covariance[i*6 + j] = P(STATE_VX + i, STATE_VX + j);
+        }
+        pose_msg->pose.covariance[(i+3)*7] = UNKNOWN_VARIANCE;
+        twist_msg->twist.covariance[(i+3)*7] = UNKNOWN_VARIANCE;
+    }
+    
+    tag.decaPose_pub.publish(pose_msg);
+    tag.decaTwist_pub.publish(twist_msg);
+    
+    StateSample sample = state_sample(ekf);
+    tag.history.add(sample);
+    if (tag.smoother)
+    {
+        tag.smoother->add(sample);
+    }
+}
+
+// State after a cycle that moved it and the timing of the cycle into the flight recorder
+void recordCycle(const TagChannel &tag, TDOA &ekf, double t, size_t drained, double update, double cycle)
+{
+    FlightRecorderRing &ring = recorder->ring(tag.index);
+    if ((drained > 0) && tag.bootstrapped)
+    {
+        const vec3d_t p = ekf.getLocation();
+        const vec3d_t v = ekf.getVelocity();
+        const TDOA::StateMatrix P = ekf.getCovariance();
+        flight_record_t r = flightRecord(FLIGHT_RECORD_STATE, tag.index, ekf.getTime());
+        r.v[0] = p.x;
+        r.v[1] = p.y;
+        r.v[2] = p.z;
+        r.v[3] = v.x;
+        r.v[4] = v.y;
+        r.v[5] = v.z;
+        for (int k = 0; k < 3; k++)
+        {
+            r.v[6 + k] = std::sqrt(std::max(P(STATE_X + k, STATE_X + k), 0.0f));
+        }
+        ring.add(r);
+    }
+    flight_record_t c = flightRecord(FLIGHT_RECORD_CYCLE, tag.index, t);
+    c.Ar = tag.cell;
+    c.v[0] = drained;
+    c.v[1] = update;
+    c.v[2] = cycle;
+    c.v[3] = tag.bootstrapped;
+    ring.add(c);
+}
+
+void pub_pose_sample(const ros::Publisher &pub, const StateSample &sample)
+{
+    geometry_msgs::PoseWithCovarianceStampedPtr pose_msg(new geometry_msgs::PoseWithCovarianceStamped);
+    pose_msg->header.stamp = ros::Time(sample.t);
+    pose_msg->header.frame_id = frame_id;
+    pose_msg->pose.pose.position.x = sample.p.x();
+    pose_msg->pose.pose.position.y = sample.p.y();
+    pose_msg->pose.pose.position.z = sample.p.z();
+    pose_msg->pose.pose.orientation.w = 1;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            pose_msg->pose.covariance[i*6 + j] = sample.P(STATE_X + i, STATE_X + j);
+        }
+        pose_msg->pose.covariance[(i+3)*7] = UNKNOWN_VARIANCE;
+    }
+    pub.publish(pose_msg);
+}
+
+// Pose of the body of a pose pair at the time of its last pair, the yaw as a rotation about z
+void pub_body_pose(PoseChannel &pose)
+{
+    const double t = pose.filter.getTime();
+    if (t <= pose.last_stamp)
+    {
+        return;
+    }
+    pose.last_stamp = t;
+    
+    const TDOAPose::StateVector S = pose.filter.getState();
+    const TDOAPose::StateMatrix P = pose.filter.getCovariance();
+    const Eigen::Vector3d p = pose.filter.getPosition();
+    const float yaw = pose.filter.getYaw();
+    
+    geometry_msgs::PoseWithCovarianceStampedPtr pose_msg(new geometry_msgs::PoseWithCovarianceStamped);
+    pose_msg->header.stamp = ros::Time(t);
+    pose_msg->header.frame_id = frame_id;
+    pose_msg->pose.pose.position.x = p.x();
+    pose_msg->pose.pose.position.y = p.y();
+    pose_msg->pose.pose.position.z = p.z();
+    pose_msg->pose.pose.orientation.z = std::sin(0.5f*yaw);
+    pose_msg->pose.pose.orientation.w = std::cos(0.5f*yaw);
+    
+    geometry_msgs::TwistWithCovarianceStampedPtr twist_msg(new geometry_msgs::TwistWithCovarianceStamped);
+    twist_msg->header = pose_msg->header;
+    twist_msg->twist.twist.linear.x = S(STATE_VX);
+    twist_msg->twist.twist.linear.y = S(STATE_VY);
+    twist_msg->twist.twist.linear.z = S(STATE_VZ);
+    twist_msg->twist.twist.angular.z = S(STATE_YAW_RATE);
+    
+    // Row-major 6x6 over (x, y, z, rot x, rot y, rot z), roll and pitch are not estimated
+    const int pose_state[6] = {STATE_X, STATE_Y, STATE_Z, -1, -1, STATE_YAW};
+    const int twist_state[6] = {STATE_VX, STATE_VY, STATE_VZ, -1, -1, STATE_YAW_RATE};
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            const bool known = (pose_state[i] >= 0) && (pose_state[j] >= 0);
+            pose_msg->pose.covariance[i*6 + j] = known ? P(pose_state[i], pose_state[j]) : (i == j) ? UNKNOWN_VARIANCE : 0;
+            twist_msg->twist.covariance[i*6 + j] = known ? P(twist_state[i], twist_state[j]) : (i == j) ? UNKNOWN_VARIANCE : 0;
+        }
+    }
+    
+    pose.bodyPose_pub.publish(pose_msg);
+    pose.bodyTwist_pub.publish(twist_msg);
+}
+
+/*
+ * Pose of the tag at the requested time, propagated from the estimate before
+ * it. Times before the history or too far past the last estimate get no reply.
+ */
+void pose_query(TagChannel &tag, const std_msgs::TimeConstPtr &msg)
+{
+    StateSample sample;
+    if (!tag.history.at(msg->data.toSec(), sample))
+    {
+        ROS_WARN_THROTTLE(1.0, "No pose of %s at %.3f\n", tag.port.c_str(), msg->data.toSec());
+        return;
+    }
+    pub_pose_sample(tag.poseQuery_pub, sample);
+}
+
+/*
+ * Queues the acceleration of a flight controller IMU message for the worker
+ * of the tag. linear_acceleration is the specific force in the body frame,
+ * rotated to the world by the attitude of the message and less gravity.
+ */
+void imu_sample(TagChannel &tag, const sensor_msgs::ImuConstPtr &msg)
+{
+    const Eigen::Quaternionf attitude(msg->orientation.w, msg->orientation.x, msg->orientation.y, msg->orientation.z);
+    const Eigen::Vector3f force(msg->linear_acceleration.x, msg->linear_acceleration.y, msg->linear_acceleration.z);
+    
+    ImuSample sample;
+    sample.t = msg->header.stamp.isZero() ? ros::Time::now().toSec() : msg->header.stamp.toSec();
+    sample.accel = attitude.normalized() * force - Eigen::Vector3f(0, 0, INERTIAL_GRAVITY);
+    if (!tag.imu_queue.push(sample))
+    {
+        ROS_WARN_THROTTLE(10.0, "%s dropped IMU samples, its worker is behind\n", tag.port.c_str());
+    }
+}
+
+/*
+ * Publishes the estimate of the filter on the tag in place of the host filter.
+ * Stamped with the host receive time, only the position variances are known.
+ * Returns false until the tag sent a position.
+ */
+// Adds the state the tag published this tick to the udp_output datagram of its worker
+void udp_record(UdpOutput *udp, TagChannel &tag, uint8_t flags, const StateSample &sample)
+{
+    if (udp)
+    {
+        udp->add(tag.index, tag.cell, flags, tag.udp_seq++, sample);
+    }
+}
+
+bool pub_onboard_state(TagChannel &tag, UdpOutput *udp)
+{
+    tdoa_position_t p;
+    uint32_t frames;
+    double stamp;
+    {
+        std::lock_guard<std::mutex> lock(tag.position_mutex);
+        p = tag.position;
+        frames = tag.position_frames;
+        stamp = tag.position_stamp;
+    }
+    if (frames == 0)
+    {
+        return false;
+    }
+    
+    vec3d_t pos = {p.pos[0], p.pos[1], p.pos[2]};
+    vec3d_t vel = {p.vel[0], p.vel[1], p.vel[2]};
+    pub_state(tag, pos, vel);
+    if (udp)
+    {
+        StateSample sample;
+        sample.t = stamp;
+        sample.p << pos.x, pos.y, pos.z;
+        sample.v << vel.x, vel.y, vel.z;
+        sample.P.setZero();
+        for (int i = 0; i < 3; i++)
+        {
+            sample.P(i,i) = p.var[i];
+        }
+        udp_record(udp, tag, UDP_RECORD_VALID | UDP_RECORD_ONBOARD, sample);
+    }
+    if (frames == tag.published_positions)
+    {
+        return true;
+    }
+    tag.published_positions = frames;
+    
+    geometry_msgs::PoseWithCovarianceStampedPtr pose_msg(new geometry_msgs::PoseWithCovarianceStamped);
+    pose_msg->header.stamp = ros::Time(stamp);
+    pose_msg->header.frame_id = frame_id;
+    pose_msg->pose.pose.position.x = pos.x;
+    pose_msg->pose.pose.position.y = pos.y;
+    pose_msg->pose.pose.position.z = pos.z;
+    pose_msg->pose.pose.orientation.w = 1;
+    for (int i = 0; i < 3; i++)
+    {
+        pose_msg->pose.covariance[i*7] = p.var[i];
+        pose_msg->pose.covariance[(i+3)*7] = UNKNOWN_VARIANCE;
+    }
+    tag.decaPose_pub.publish(pose_msg);
+    return true;
+}
+
+void pub_queue_stats(const TagChannel &tag)
+{
+    std_msgs::UInt32 depth_msg, drops_msg;
+    depth_msg.data = tag.meas_queue.maxDepthSeen();
+    drops_msg.data = tag.meas_queue.dropCount();
+    tag.queueDepth_pub.publish(depth_msg);
+    tag.queueDrops_pub.publish(drops_msg);
+    
+    // Same counts on the tag itself, its receive ring and its USB output queue
+    std_msgs::UInt32 tag_rx_msg, tag_queue_msg;
+    tag_rx_msg.data = tag.tag_rx_drops.load(std::memory_order_relaxed);
+    tag_queue_msg.data = tag.tag_queue_drops.load(std::memory_order_relaxed);
+    tag.tagRxDrops_pub.publish(tag_rx_msg);
+    tag.tagQueueDrops_pub.publish(tag_queue_msg);
+    
+    std_msgs::UInt32 lost_msg;
+    lost_msg.data = tag.lost_packets.load(std::memory_order_relaxed);
+    tag.lostPackets_pub.publish(lost_msg);
+    
+    // Drift of the tag clock in ppm and the excess transfer of the last sync frame in s
+    if (use_clock_sync)
+    {
+        std_msgs::Float32MultiArray sync_msg;
+        sync_msg.data.push_back(tag.sync_drift.load(std::memory_order_relaxed));
+        sync_msg.data.push_back(tag.sync_excess.load(std::memory_order_relaxed));
+        tag.clockSync_pub.publish(sync_msg);
+    }
+}
+
+static void addKeyValue(diagnostic_msgs::DiagnosticStatus &status, const std::string &key, double value)
+{
+    diagnostic_msgs::KeyValue kv;
+    kv.key = key;
+    std::ostringstream ss;
+    ss << value;
+    kv.value = ss.str();
+    status.values.push_back(kv);
+}
+
+static void addKeyValue(diagnostic_msgs::DiagnosticStatus &status, const std::string &key, const std::string &value)
+{
+    diagnostic_msgs::KeyValue kv;
+    kv.key = key;
+    kv.value = value;
+    status.values.push_back(kv);
+}
+
+/*
+ * Firmware counters of the last telemetry frame of every tag, one status per
+ * tag. Counts are per telemetry period, the anchor rates in packets per second.
+ *
+ * The receive power of an anchor does not depend on the PHY profile, so its
+ * margin over the sensitivity of every profile is known from any of them.
+ * The suggested profile is the shortest one (tdoa_phy.h) that leaves
+ * phy_margin for the weakest anchor the tag hears. A first path ratio well
+ * below -6 dB marks an anchor without line of sight.
+ */
+void pub_diagnostics()
+{
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        TagChannel &tag = *channels[i];
+        tdoa_telemetry_t t;
+        uint32_t frames;
+        {
+            std::lock_guard<std::mutex> lock(tag.telemetry_mutex);
+            t = tag.telemetry;
+            frames = tag.telemetry_frames;
+        }
+        
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "decawave: " + (tag.name.empty() ? tag.port : tag.name);
+        status.hardware_id = tag.port;
+        addKeyValue(status, "reconnects", tag.reconnects.load());
+        if (frames == 0)
+        {
+            status.level = diagnostic_msgs::DiagnosticStatus::STALE;
+            status.message = "No telemetry";
+            msg.status.push_back(status);
+            continue;
+        }
+        
+        const bool errors = (t.rxErrors != 0) || (t.ringDrops != 0) || (t.rxOverruns != 0);
+        status.level = errors ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+        status.message = errors ? "Receive errors" : "OK";
+        
+        addKeyValue(status, "period_ms", t.periodMs);
+        addKeyValue(status, "rx_good", t.rxGood);
+        addKeyValue(status, "rx_timeouts", t.rxTimeouts);
+        addKeyValue(status, "rx_errors", t.rxErrors);
+        addKeyValue(status, "ring_drops", t.ringDrops);
+        addKeyValue(status, "rx_overruns", t.rxOverruns);
+        addKeyValue(status, "clock_rejects", t.clockRejects);
+        addKeyValue(status, "isr_min_cycles", t.isrMinCycles);
+        addKeyValue(status, "isr_max_cycles", t.isrMaxCycles);
+        addKeyValue(status, "nlos_drops", t.nlosDrops);
+        const bool knownProfile = t.profile < TDOA_PHY_PROFILES;
+        addKeyValue(status, "phy_profile", knownProfile ? TDOA_PHY_TABLE[t.profile].name : "scanning");
+        double weakest = 0;
+        bool heard = false;
+        for (uint8_t k = 0; k < t.anchors; k++)
+        {
+            const std::string anchor = "anchor" + std::to_string(k);
+            const double rate = (t.periodMs != 0) ? t.anchorPackets[k] * 1000.0 / t.periodMs : 0.0;
+            addKeyValue(status, anchor + "_rate", rate);
+            if (t.anchorPower[k] == TDOA_TELEMETRY_NO_POWER)
+            {
+                continue;
+            }
+
+            const double power = t.anchorPower[k] / 64.0;
+            addKeyValue(status, anchor + "_power", power);
+            addKeyValue(status, anchor + "_fp_ratio", t.anchorFpRatio[k] / 64.0);
+            if (knownProfile)
+            {
+                addKeyValue(status, anchor + "_margin", power - TDOA_PHY_TABLE[t.profile].sensitivity);
+            }
+            weakest = heard ? std::min(weakest, power) : power;
+            heard = true;
+        }
+        if (heard)
+        {
+            int p = 0;
+            while ((p < TDOA_PHY_PROFILES - 1) && (weakest - TDOA_PHY_TABLE[p].sensitivity < phy_margin))
+            {
+                p++;
+            }
+            addKeyValue(status, "phy_suggested", TDOA_PHY_TABLE[p].name);
+        }
+        msg.status.push_back(status);
+    }
+    
+    for (size_t w = 0; w < worker_jitter.size(); w++)
+    {
+        msg.status.push_back(worker_jitter[w]->status("decawave: estimator" + std::to_string(w), jitter_limit));
+    }
+    
+    if (raw_engine)
+    {
+        diagnostic_msgs::DiagnosticStatus status;
+        status.name = "decawave: raw engine";
+        const uint32_t drops = raw_engine->getDrops();
+        status.level = drops ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+        status.message = drops ? "Raw frames dropped" : "OK";
+        addKeyValue(status, "raw_frames", raw_engine->getRawFrames());
+        addKeyValue(status, "solved_pairs", raw_engine->getSolvedPairs());
+        addKeyValue(status, "shared_pairs", raw_engine->getSharedPairs());
+        addKeyValue(status, "modeled_anchors", raw_engine->getModeledAnchors());
+        addKeyValue(status, "passes", raw_engine->getPasses());
+        addKeyValue(status, "drops", drops);
+        msg.status.push_back(status);
+    }
+    
+    diagnostics_pub.publish(msg);
+}
+
+// Rejected measurements per anchor pair, row Ar and column An
+template <typename Filter>
+void pub_rejections(const TagChannel &tag, Filter &ekf)
+{
+    std_msgs::UInt32MultiArray msg;
+    msg.layout.dim.resize(2);
+    msg.layout.dim[0].label = "Ar";
+    msg.layout.dim[0].size = MAX_NR_ANCHORS;
+    msg.layout.dim[0].stride = MAX_NR_ANCHORS*MAX_NR_ANCHORS;
+    msg.layout.dim[1].label = "An";
+    msg.layout.dim[1].size = MAX_NR_ANCHORS;
+    msg.layout.dim[1].stride = MAX_NR_ANCHORS;
+    msg.layout.data_offset = 0;
+    
+    msg.data.resize(MAX_NR_ANCHORS*MAX_NR_ANCHORS);
+    for (int Ar = 0; Ar < MAX_NR_ANCHORS; Ar++)
+    {
+        for (int An = 0; An < MAX_NR_ANCHORS; An++)
+        {
+            msg.data[Ar*MAX_NR_ANCHORS + An] = ekf.getRejectCount(Ar, An);
+        }
+    }
+    tag.rejections_pub.publish(msg);
+}
+
+// Probability of every IMM model, in the order of imm_models
+void pub_model_probability(const TagChannel &tag)
+{
+    std_msgs::Float32MultiArray msg;
+    msg.layout.dim.resize(1);
+    msg.layout.dim[0].label = "model";
+    msg.layout.dim[0].size = tag.imm->getModelCount();
+    msg.layout.dim[0].stride = tag.imm->getModelCount();
+    msg.layout.data_offset = 0;
+    
+    for (int k = 0; k < tag.imm->getModelCount(); k++)
+    {
+        msg.data.push_back(tag.imm->getModelProbability(k));
+    }
+    tag.modelProbability_pub.publish(msg);
+}
+
+// Estimated measurement standard deviation per anchor pair, same layout as the rejections
+template <typename Filter>
+void pub_pair_noise(const TagChannel &tag, Filter &ekf)
+{
+    std_msgs::Float32MultiArray msg;
+    msg.layout.dim.resize(2);
+    msg.layout.dim[0].label = "Ar";
+    msg.layout.dim[0].size = MAX_NR_ANCHORS;
+    msg.layout.dim[0].stride = MAX_NR_ANCHORS*MAX_NR_ANCHORS;
+    msg.layout.dim[1].label = "An";
+    msg.layout.dim[1].size = MAX_NR_ANCHORS;
+    msg.layout.dim[1].stride = MAX_NR_ANCHORS;
+    msg.layout.data_offset = 0;
+    
+    msg.data.resize(MAX_NR_ANCHORS*MAX_NR_ANCHORS);
+    for (int Ar = 0; Ar < MAX_NR_ANCHORS; Ar++)
+    {
+        for (int An = 0; An < MAX_NR_ANCHORS; An++)
+        {
+            msg.data[Ar*MAX_NR_ANCHORS + An] = ekf.getPairStdDev(Ar, An);
+        }
+    }
+    tag.pairNoise_pub.publish(msg);
+}
+
+// Per anchor of the cell: masked, anchor_reason_t, receive ratio, mean NIS and bias in m
+void pub_anchor_health(const TagChannel &tag)
+{
+    const int fields = 5;
+    const int count = tag.health.getAnchorCount();
+    std_msgs::Float32MultiArray msg;
+    msg.layout.dim.resize(2);
+    msg.layout.dim[0].label = "anchor";
+    msg.layout.dim[0].size = count;
+    msg.layout.dim[0].stride = count*fields;
+    msg.layout.dim[1].label = "masked,reason,receive,nis,bias";
+    msg.layout.dim[1].size = fields;
+    msg.layout.dim[1].stride = fields;
+    msg.layout.data_offset = 0;
+    
+    msg.data.reserve(count*fields);
+    for (int k = 0; k < count; k++)
+    {
+        const anchor_health_t &a = tag.health.get(k);
+        msg.data.push_back(a.state == ANCHOR_MASKED);
+        msg.data.push_back(a.reason);
+        msg.data.push_back(a.receiveRatio);
+        msg.data.push_back(a.nis);
+        msg.data.push_back(a.bias);
+    }
+    tag.anchorHealth_pub.publish(msg);
+}
+
+// Closes the health window of the tag, reports and publishes the anchors that were masked or readmitted
+void checkAnchorHealth(TagChannel &tag, double t)
+{
+    static const char *reasons[] = {"", "silent", "innovations", "bias"};
+    
+    anchor_state_t before[MAX_NR_ANCHORS];
+    for (int k = 0; k < tag.health.getAnchorCount(); k++)
+    {
+        before[k] = tag.health.get(k).state;
+    }
+    if (!tag.health.evaluate(t))
+    {
+        return;
+    }
+    for (int k = 0; k < tag.health.getAnchorCount(); k++)
+    {
+        const anchor_health_t &a = tag.health.get(k);
+        if (a.state == before[k])
+        {
+            continue;
+        }
+        if (a.state == ANCHOR_MASKED)
+        {
+            ROS_WARN("%s masked anchor %d of cell %d: %s (receive %.2f, nis %.1f, bias %.2f m)\n", tag.port.c_str(), k, tag.cell,
+                     reasons[a.reason], a.receiveRatio, a.nis, a.bias);
+        }
+        else
+        {
+            ROS_INFO("%s readmitted anchor %d of cell %d\n", tag.port.c_str(), k, tag.cell);
+        }
+    }
+    pub_anchor_health(tag);
+}
+
+/*
+ * Closes the consistency period of the tag. A filter that lost the tag
+ * starts over from the next complete frame, with the multilateration
+ * bootstrap or the particles, and the anchor health it judged goes with it.
+ */
+void checkConsistency(TagChannel &tag, double t)
+{
+    if (!tag.consistency.evaluate(t) || (tag.consistency.getState() != CONSISTENCY_LOST))
+    {
+        return;
+    }
+    uint8_t Ar, An;
+    float pair_nis;
+    if (tag.consistency.getWorstPair(Ar, An, pair_nis))
+    {
+        ROS_WARN("%s lost filter consistency (mean NIS %.1f, worst pair %d-%d at %.1f), bootstrapping again\n", tag.port.c_str(),
+                 tag.consistency.getMeanNIS(), Ar, An, pair_nis);
+    }
+    else
+    {
+        ROS_WARN("%s lost filter consistency (mean NIS %.1f), bootstrapping again\n", tag.port.c_str(), tag.consistency.getMeanNIS());
+    }
+    if (recorder)
+    {
+        const bool worst = tag.consistency.getWorstPair(Ar, An, pair_nis);
+        recordEvent(tag, FLIGHT_EVENT_LOST, t, tag.consistency.getMeanNIS(), worst ? Ar : 0, worst ? An : 0, worst ? pair_nis : 0);
+        if (recorder->trigger(FLIGHT_TRIGGER_ALARM, tag.index))
+        {
+            ROS_INFO("%s flight recorder dumps in %.0f s\n", tag.port.c_str(), FLIGHT_RECORDER_AFTER);
+        }
+    }
+    tag.frame_count = 0;
+    tag.bootstrapped = false;
+    tag.outside_hull = false;
+    restartParticles(tag);
+    tag.health.reset(tag.health.getAnchorCount());
+    tag.consistency.restart();
+}
+
+// Consistency of the filter of the tag over the last window and period as a diagnostic status
+void pub_consistency(TagChannel &tag)
+{
+    static const char *states[] = {"OK", "Innovations above a consistent filter", "Lost"};
+    
+    diagnostic_msgs::DiagnosticArray diag;
+    diag.header.stamp = ros::Time::now();
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "decawave consistency: " + (tag.name.empty() ? tag.port : tag.name);
+    status.hardware_id = tag.port;
+    const consistency_state_t state = tag.consistency.getState();
+    if (!tag.bootstrapped)
+    {
+        status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+        status.message = "Bootstrapping";
+    }
+    else
+    {
+        status.level = (state == CONSISTENCY_OK) ? diagnostic_msgs::DiagnosticStatus::OK : diagnostic_msgs::DiagnosticStatus::WARN;
+        status.message = states[state];
+    }
+    
+    addKeyValue(status, "mean_nis", tag.consistency.getMeanNIS());
+    addKeyValue(status, "samples", tag.consistency.getSamples());
+    addKeyValue(status, "rejected_fraction", tag.consistency.getRejectedFraction());
+    uint8_t Ar, An;
+    float pair_nis;
+    if (tag.consistency.getWorstPair(Ar, An, pair_nis))
+    {
+        addKeyValue(status, "worst_pair", std::to_string(Ar) + "-" + std::to_string(An));
+        addKeyValue(status, "worst_pair_nis", pair_nis);
+    }
+    addKeyValue(status, "reinitializations", tag.consistency.getLosses());
+    
+    diag.status.push_back(status);
+    diagnostics_pub.publish(diag);
+}
+
+/*
+ * Host stages of the measurements the worker applied this cycle: updated is
+ * when the filter had them, published when pub_state returned. The
+ * measurements of a TDMA frame (frame_update) count as updated once drained,
+ * the wait for the rest of their frame is not measured.
+ */
+void recordLatency(TagChannel &tag, double updated, double published)
+{
+    for (size_t i = 0; i < tag.applied_count; i++)
+    {
+        const QueuedMeas &q = tag.applied[i];
+        const double read = q.read;
+        tag.update_latency_metric->record(updated - read);
+        tag.latency[LATENCY_QUEUE].record(updated - read);
+        tag.latency[LATENCY_PUBLISH].record(published - updated);
+        if (q.tag_latency >= 0)
+        {
+            tag.latency[LATENCY_TOTAL].record(q.tag_latency + q.usb_latency + (published - read));
+        }
+        
+        if (latency_trace)
+        {
+            latency_trace_event_t event;
+            event.read = read;
+            event.stage[LATENCY_TAG] = q.tag_latency;
+            event.stage[LATENCY_USB] = q.usb_latency;
+            event.stage[LATENCY_QUEUE] = updated - read;
+            event.stage[LATENCY_PUBLISH] = published - updated;
+            event.Ar = q.meas.Ar;
+            event.An = q.meas.An;
+            latency_trace->add(tag.index, event);
+        }
+    }
+    tag.applied_count = 0;
+}
+
+/*
+ * Latency histograms of the last stats period, row stage (LatencyStage) and
+ * column bin (LatencyHistogram), and their percentiles as a diagnostic status.
+ */
+void pub_latency(TagChannel &tag)
+{
+    std_msgs::UInt32MultiArray msg;
+    msg.layout.dim.resize(2);
+    msg.layout.dim[0].label = "stage";
+    msg.layout.dim[0].size = LATENCY_STAGES;
+    msg.layout.dim[0].stride = LATENCY_STAGES*LATENCY_BINS;
+    msg.layout.dim[1].label = "bin";
+    msg.layout.dim[1].size = LATENCY_BINS;
+    msg.layout.dim[1].stride = LATENCY_BINS;
+    msg.layout.data_offset = 0;
+    msg.data.resize(LATENCY_STAGES*LATENCY_BINS);
+    
+    diagnostic_msgs::DiagnosticArray diag;
+    diag.header.stamp = ros::Time::now();
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "decawave latency: " + (tag.name.empty() ? tag.port : tag.name);
+    status.hardware_id = tag.port;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "OK";
+    
+    for (int s = 0; s < LATENCY_STAGES; s++)
+    {
+        uint32_t counts[LATENCY_BINS];
+        uint32_t period[LATENCY_BINS];
+        uint64_t total = 0;
+        tag.latency[s].snapshot(counts);
+        for (int b = 0; b < LATENCY_BINS; b++)
+        {
+            period[b] = counts[b] - tag.published_latency[s][b];
+            tag.published_latency[s][b] = counts[b];
+            msg.data[s*LATENCY_BINS + b] = period[b];
+            total += period[b];
+        }
+        
+        const std::string stage = std::string("latency_") + latencyStageName(s);
+        addKeyValue(status, stage + "_count", total);
+        addKeyValue(status, stage + "_p50_ms", LatencyHistogram::percentile(period, 0.5) * 1e3);
+        addKeyValue(status, stage + "_p99_ms", LatencyHistogram::percentile(period, 0.99) * 1e3);
+        addKeyValue(status, stage + "_max_ms", LatencyHistogram::percentile(period, 1.0) * 1e3);
+    }
+    if (latency_trace)
+    {
+        addKeyValue(status, "trace_drops", latency_trace->dropped());
+    }
+    
+    tag.latency_pub.publish(msg);
+    diag.status.push_back(status);
+    diagnostics_pub.publish(diag);
+}
+
+// Writes the flight recorder at once, the file or the error in the message
+bool dump_recorder(std_srvs::Trigger::Request &, std_srvs::Trigger::Response &res)
+{
+    std::string path;
+    res.success = recorder->dump(FLIGHT_TRIGGER_REQUEST, -1, path);
+    res.message = path;
+    return true;
+}
+
+// Writes the dumps the workers triggered once they are due
+void recorder_worker()
+{
+    while (ros::ok() && running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SERIAL_TIMEOUT_MS));
+        flight_trigger_t reason;
+        int tag;
+        if (!recorder->takeTrigger(reason, tag))
+        {
+            continue;
+        }
+        std::string path;
+        if (recorder->dump(reason, tag, path))
+        {
+            ROS_WARN("Flight recorder written to %s\n", path.c_str());
+        }
+        else
+        {
+            ROS_ERROR("%s\n", path.c_str());
+        }
+    }
+}
+
+/*
+ * Solves the raw timestamp frames of all tags together and hands the pairs
+ * to the workers of their tags. Waits a millisecond after a pass without
+ * frames, the serial threads read every SERIAL_TIMEOUT_MS at the latest.
+ */
+void raw_engine_worker()
+{
+    while (ros::ok() && running)
+    {
+        const size_t solved = raw_engine->process([](const RawSolved &r)
+        {
+            QueuedMeas queued;
+            queued.meas.Ar = r.frame.Ar;
+            queued.meas.An = r.frame.An;
+            queued.meas.distanceDiff = r.frame.distanceDiff;
+            queued.meas.timestamp = r.stamp;
+            queued.read = r.read;
+            queued.variance = 0;
+            queued.tag_latency = -1;
+            queued.usb_latency = -1;
+            channels[r.tag]->raw_queue.push(queued);
+            wakeWorker(r.tag);
+        });
+        if (solved == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+/*
+ * Solves the anchor layout every survey_seconds from all ranges so far, the
+ * ranges keep coming from the serial threads, so every solve refines the
+ * last one. A solved cell replaces its anchors in the filters and the tags
+ * and the whole layout is written to survey_output_path.
+ */
+void survey_worker()
+{
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(survey_seconds));
+    auto next = std::chrono::steady_clock::now() + period;
+    while (ros::ok() && running)
+    {
+        if (std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SERIAL_TIMEOUT_MS));
+            continue;
+        }
+        next += period;
+        
+        std::vector<SurveyCell> cells = survey->solve();
+        AnchorLayout layout;
+        {
+            std::lock_guard<std::mutex> lock(anchors_write_mutex);
+            const std::shared_ptr<const AnchorLayout> current = currentAnchors();
+            layout = *current;
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                const SurveyCell &c = cells[i];
+                if (c.anchors.empty())
+                {
+                    ROS_WARN("Survey of cell %d: %d pairs, %s\n", c.cell, c.pairs, c.problem.c_str());
+                    continue;
+                }
+                ROS_INFO("Survey of cell %d: %zu anchors, %d pairs, residual rms %.3f m, max %.3f m\n", c.cell,
+                         c.anchors.size(), c.pairs, c.rms, c.max_residual);
+                if ((int)layout.size() <= c.cell)
+                {
+                    layout.resize(c.cell + 1);
+                }
+                layout[c.cell].assign(c.anchors.begin(), c.anchors.begin() + std::min<size_t>(c.anchors.size(), MAX_NR_ANCHORS));
+            }
+            // Every change makes the tags resend their layout, small ones are left for the next solve
+            if ((layoutChange(layout, *current) <= SURVEY_MIN_MOVE) || !publishAnchors(layout))
+            {
+                continue;
+            }
+        }
+        if (!writeAnchorFile(survey_output_path, layout))
+        {
+            ROS_WARN("Cannot write the surveyed anchors to %s\n", survey_output_path.c_str());
+        }
+    }
+}
+
+// Modification time and size of path, zero if it does not exist
+static std::pair<int64_t, int64_t> fileStamp(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return std::make_pair(0, 0);
+    }
+    return std::make_pair((int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec, (int64_t)st.st_size);
+}
+
+/*
+ * Reloads the anchors once anchor_file or the anchors parameter changed. A
+ * file is only read after it kept its time and size for one period, so an
+ * editor is done writing it. The workers and the serial threads pick the
+ * new layout up between two cycles, the filters keep their state. An
+ * invalid layout is reported and the current one kept.
+ */
+void anchor_watch_worker(ros::NodeHandle nh)
+{
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(ANCHOR_WATCH_PERIOD));
+    auto next = std::chrono::steady_clock::now() + period;
+    std::pair<int64_t, int64_t> loaded = fileStamp(anchor_file), pending = loaded;
+    std::string loaded_param;
+    nh.getParam("anchors", loaded_param);
+    
+    while (ros::ok() && running)
+    {
+        if (std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SERIAL_TIMEOUT_MS));
+            continue;
+        }
+        next += period;
+        
+        std::string param;
+        nh.getParam("anchors", param);
+        const std::pair<int64_t, int64_t> stamp = fileStamp(anchor_file);
+        bool reload = false;
+        if (param != loaded_param)
+        {
+            loaded_param = param;
+            reload = true;
+        }
+        else if (param.empty() && (stamp != loaded))
+        {
+            reload = (stamp == pending);
+            pending = stamp;
+        }
+        if (!reload)
+        {
+            continue;
+        }
+        loaded = stamp;
+        
+        AnchorLayout layout;
+        std::string source;
+        if (!loadAnchors(nh, layout, source))
+        {
+            ROS_WARN("Keeping the current anchors\n");
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(anchors_write_mutex);
+        if (publishAnchors(layout))
+        {
+            ROS_INFO("Anchors reloaded from %s\n", source.c_str());
+        }
+    }
+}
+
+// Takes the anchor layout published since the last cycle
+void refreshAnchors(TDOA &ekf, TagChannel &tag)
+{
+    const uint32_t generation = anchors_generation;
+    if (tag.anchors_seen != generation)
+    {
+        // The measurements still pending were taken against the old anchors
+        applyFrame(ekf, tag);
+        tag.anchors = currentAnchors();
+        tag.anchors_seen = generation;
+        setCellAnchors(ekf, tag, tag.cell);
+        if (!tag.bootstrapped)
+        {
+            restartParticles(tag);
+        }
+    }
+}
+
+// Tags whose scalar updates can run in the lanes of TDOAFleet
+bool lockstepEligible(TDOA &ekf, const TagChannel &tag)
+{
+    return use_lockstep && tag.bootstrapped && !tag.imm && !tag.inertial && !tag.pose && !use_frame_update && !use_onboard_filter && ekf.lockstepCompatible();
+}
+
+/*
+ * drainMeasurements for the lockstep tags of worker w together. Every round
+ * each tag predicts and prepares its next accepted measurement on its own,
+ * then the updates of the round run through the lanes of TDOAFleet. drained
+ * gets the measurements taken from each queue.
+ */
+void drainLockstep(int w, const std::vector<bool> &lockstep, std::vector<size_t> &drained, std::vector<FleetUpdate> &round)
+{
+    bool more = true;
+    while (more)
+    {
+        more = false;
+        round.clear();
+        for (size_t i : worker_tags[w])
+        {
+            if (!lockstep[i])
+            {
+                continue;
+            }
+            TDOA &ekf = filters[i];
+            TagChannel &tag = *channels[i];
+            QueuedMeas queued;
+            while (popMeasurement(tag, queued))
+            {
+                drained[i]++;
+                if (recorder)
+                {
+                    recordMeasurement(tag, queued);
+                }
+                tdoa_meas_t &meas = queued.meas;
+                if (!selectCell(ekf, tag, meas))
+                {
+                    continue;
+                }
+                if (use_latency_stats && (tag.applied_count < MEAS_QUEUE_SIZE))
+                {
+                    tag.applied[tag.applied_count++] = queued;
+                }
+                ekf.stateEstimatorPredictTo(meas.timestamp);
+                if (!admitMeasurement(ekf, tag, meas))
+                {
+                    continue;
+                }
+                FleetUpdate update;
+                update.filter = &ekf;
+                if (ekf.prepareScalarUpdate(meas.Ar, meas.An, meas.distanceDiff, update.h, update.error, update.stdMeasNoise,
+                                            queued.variance))
+                {
+                    round.push_back(update);
+                    more = true;
+                    break;
+                }
+            }
+        }
+        TDOAFleet::apply(round.data(), round.size());
+    }
+}
+
+/*
+ * Brings the estimate of the tag up to now and publishes it, and the stamped
+ * state at the last measurement if fresh ones were applied since the last
+ * call. The cycle took count measurements at updated_time.
+ */
+void publishEstimate(TDOA &ekf, TagChannel &tag, UdpOutput *udp, bool fresh, size_t count, double updated_time,
+                     double update_seconds, double drain_start)
+{
+    if (fresh)
+    {
+        pub_stamped_state(tag, ekf);
+        StateSample smoothed;
+        if (tag.smoother && tag.smoother->output(smoothed))
+        {
+            pub_pose_sample(tag.decaPoseSmoothed_pub, smoothed);
+        }
+    }
+    
+    // Measurements predict to their own receive time, we only bring the state up to now
+    if (tag.inertial)
+    {
+        // Through every IMU sample so far, the output moves with the accelerometer between the pairs
+        const double now = ros::Time::now().toSec();
+        drainImu(tag, now);
+        if (tag.bootstrapped)
+        {
+            tag.inertial->stateEstimatorPredictTo(now);
+            tag.inertial->output(ekf);
+        }
+        else
+        {
+            ekf.stateEstimatorPredictTo(now);
+        }
+    }
+    else if (tag.imm)
+    {
+        tag.imm->stateEstimatorPredictTo(ros::Time::now().toSec());
+        tag.imm->output(ekf);
+        ekf.stateEstimatorFinalize();
+    }
+    else
+    {
+        // Bounds P itself, no stateEstimatorFinalize after it
+        ekf.stateEstimatorPredictTo(ros::Time::now().toSec());
+    }
+    
+    if ((predict_latency > 0) && tag.bootstrapped)
+    {
+        // Where the tag will be once the consumer acts on the estimate
+        StateSample now = state_sample(ekf);
+        StateSample predicted = tag.history.propagate(now, now.t + predict_latency);
+        vec3d_t p = {(float)predicted.p.x(), (float)predicted.p.y(), (float)predicted.p.z()};
+        vec3d_t v = {(float)predicted.v.x(), (float)predicted.v.y(), (float)predicted.v.z()};
+        pub_state(tag, p, v);
+        pub_pose_sample(tag.decaPosePredicted_pub, predicted);
+        udp_record(udp, tag, UDP_RECORD_VALID | UDP_RECORD_PREDICTED, predicted);
+    }
+    else
+    {
+        pub_state(tag, ekf.getLocation(), ekf.getVelocity());
+        if (udp)
+        {
+            udp_record(udp, tag, tag.bootstrapped ? UDP_RECORD_VALID : 0, state_sample(ekf));
+        }
+    }
+    if (use_latency_stats)
+    {
+        recordLatency(tag, updated_time, ros::Time::now().toSec());
+    }
+    saveCheckpoint(ekf, tag, updated_time);
+    if (recorder)
+    {
+        recordCycle(tag, ekf, updated_time, count, update_seconds, ros::WallTime::now().toSec() - drain_start);
+    }
+}
+
+/*
+ * drainMeasurements for the two tags of pose. Until the pose filter is
+ * seeded the tags run their own filters, once both are bootstrapped in the
+ * same cell they seed it. From then on the pairs of both tags go to it in
+ * one update per cycle, and the filters of the tags are set to where the
+ * pose puts them, so everything that publishes a tag works as before.
+ * drained gets the measurements taken from each queue.
+ */
+void drainPose(PoseChannel &pose, std::vector<size_t> &drained)
+{
+    TagChannel &first = *channels[pose.tags[0]];
+    TagChannel &second = *channels[pose.tags[1]];
+    for (int k = 0; k < POSE_TAGS; k++)
+    {
+        refreshAnchors(filters[pose.tags[k]], *channels[pose.tags[k]]);
+    }
+    // The anchors may have been reloaded, nothing is pending at this point
+    pose.filter.configure(filters[pose.tags[0]]);
+    pose.cell = first.cell;
+    
+    const double before = pose.filter.getTime();
+    for (int k = 0; k < POSE_TAGS; k++)
+    {
+        drained[pose.tags[k]] = drainMeasurements(filters[pose.tags[k]], *channels[pose.tags[k]]);
+    }
+    
+    const bool bootstrapped = first.bootstrapped && second.bootstrapped;
+    if (!pose.filter.isSeeded())
+    {
+        if (bootstrapped && (first.cell == second.cell))
+        {
+            pose.filter.configure(filters[pose.tags[0]]);
+            pose.cell = first.cell;
+            TDOA &ekf0 = filters[pose.tags[0]], &ekf1 = filters[pose.tags[1]];
+            if (pose.filter.seed(ekf0, ekf1, std::max(ekf0.getTime(), ekf1.getTime())))
+            {
+                const Eigen::Vector3d p = pose.filter.getPosition();
+                ROS_INFO("%s and %s seeded their pose at %.2f, %.2f, yaw %.2f\n", first.port.c_str(), second.port.c_str(), p.x(), p.y(),
+                         pose.filter.getYaw());
+            }
+        }
+        return;
+    }
+    if (!bootstrapped)
+    {
+        ROS_WARN("%s and %s lost their pose, seeding it again once both tags are bootstrapped\n", first.port.c_str(),
+                 second.port.c_str());
+        pose.filter.reset();
+        return;
+    }
+    
+    pose.filter.update();
+    if (pose.filter.getTime() > before)
+    {
+        for (int k = 0; k < POSE_TAGS; k++)
+        {
+            pose.filter.output(k, filters[pose.tags[k]]);
+        }
+        pub_body_pose(pose);
+    }
+}
+
+/*
+ * Worker w owns the tags of worker_tags[w] and the pose filters of their
+ * pairs, so every filter is only ever touched by one thread and needs no
+ * locking. It cycles at pub_rate, or with
+ * publish_mode update whenever measurements of its tags arrive, and at
+ * pub_rate for the statistics when none do.
+ */
+void estimator_worker(int w)
+{
+    PeriodicLoop r(1.0 / pub_rate, estimator_phase, worker_jitter[w].get());
+    ros::Time last_stats = ros::Time::now();
+    
+    // Sized once, for drainLockstep
+    std::vector<bool> lockstep(filters.size(), false);
+    std::vector<size_t> drained(filters.size(), 0);
+    std::vector<FleetUpdate> round;
+    round.reserve(filters.size());
+    UdpOutput *udp = ((size_t)w < udp_outputs.size()) ? udp_outputs[w].get() : NULL;
+    uint32_t udp_errors = 0;
+
+    while(ros::ok() && running)
+    {
+        bool pub_stats = (ros::Time::now() - last_stats).toSec() >= QUEUE_STATS_PERIOD;
+        // Wall clock time of the next cycle with publish_mode update, earlier for a tag held back by max_pub_rate
+        double next_pub = ros::WallTime::now().toSec() + 1.0 / pub_rate;
+        if (udp)
+        {
+            udp->start(ros::Time::now().toSec());
+        }
+        
+        if (use_lockstep)
+        {
+            for (size_t i : worker_tags[w])
+            {
+                refreshAnchors(filters[i], *channels[i]);
+                lockstep[i] = lockstepEligible(filters[i], *channels[i]);
+                drained[i] = 0;
+            }
+            drainLockstep(w, lockstep, drained, round);
+        }
+        
+        for (size_t k = 0; k < poses.size(); k++)
+        {
+            if (tag_worker[poses[k]->tags[0]] == w)
+            {
+                drainPose(*poses[k], drained);
+            }
+        }
+        
+        for (size_t i : worker_tags[w])
         {
-            my_serial.read(&serial_msg[RX_idx], 1);
-            if(RX_idx == MSG_TYPE_BYTE)
+            TDOA &ekf = filters[i];
+            TagChannel &tag = *channels[i];
+            
+            refreshAnchors(ekf, tag);
+            
+            // The host filter keeps running on the distance differences until the tag sends positions
+            if (use_onboard_filter && pub_onboard_state(tag, udp))
+            {
+                QueuedMeas queued;
+                while (popMeasurement(tag, queued)) {}
+                ImuSample sample;
+                while (tag.imu_queue.pop(sample)) {}
+            }
+            else
             {
-                if((serial_msg[0] == TYPE_TDOA))
+                const double drain_start = ros::WallTime::now().toSec();
+                const size_t count = (lockstep[i] || tag.pose) ? drained[i] : drainMeasurements(ekf, tag);
+                const bool updated = count > 0;
+                const double updated_time = ros::Time::now().toSec();
+                const double update_seconds = ros::WallTime::now().toSec() - drain_start;
+                if (updated && !lockstep[i] && !tag.pose)
                 {
-                    ignoring_flag = false;
+                    tag.update_metric->record(update_seconds);
                 }
-                else
+                if (use_anchor_health && tag.bootstrapped)
+                {
+                    checkAnchorHealth(tag, updated_time);
+                }
+                if (use_consistency && tag.bootstrapped)
+                {
+                    checkConsistency(tag, updated_time);
+                }
+                if (use_hull && tag.bootstrapped)
+                {
+                    checkHull(ekf, tag);
+                }
+                if (tag.pf && tag.bootstrapped && outsideAnchors(tag, ekf.getLocation()))
+                {
+                    ROS_WARN("%s left the anchors, localizing again\n", tag.port.c_str());
+                    restartParticles(tag);
+                }
+                // publish_mode update publishes right after the measurements, at most at max_pub_rate per tag. A tag
+                // with an IMU moves with every sample and still publishes every cycle
+                tag.pub_pending = tag.pub_pending || updated;
+                if (!pub_on_update || tag.inertial || (tag.pub_pending && (drain_start - tag.last_pub >= 1.0 / max_pub_rate)))
+                {
+                    publishEstimate(ekf, tag, udp, tag.pub_pending, count, updated_time, update_seconds, drain_start);
+                    tag.pub_pending = false;
+                    tag.last_pub = drain_start;
+                }
+                else if (tag.pub_pending)
                 {
-                    ignoring_flag = true;
-                    RX_idx = 0;
+                    next_pub = std::min(next_pub, tag.last_pub + 1.0 / max_pub_rate);
                 }
             }
-
-            if(ignoring_flag == false)
+            
+            if (pub_stats)
             {
-                RX_idx++;
-                if(RX_idx == MSG_SIZE)
+                pub_queue_stats(tag);
+                if (use_latency_stats)
+                {
+                    pub_latency(tag);
+                }
+                // With imm the gates and noise estimates of the most likely model, with an IMU those of its filter
+                if (tag.inertial)
                 {
-                    uint16_t cs = (serial_msg[MSG_SIZE-2] << 8) | serial_msg[MSG_SIZE-1];
-                    if(cs == serial_checksum(serial_msg, MSG_SIZE-2))
+                    pub_rejections(tag, tag.inertial->getFilter());
+                    if (use_adaptive_noise)
                     {
-                        Ar = serial_msg[ANCR_BYTE];
-                        An = serial_msg[ANCN_BYTE];
-                        tdoaDistDiff = to_float(&serial_msg[DATA_BYTE]);
-
-			            ekf_mutex.lock();
-			            deca_ekf.scalarTDOADistUpdate(Ar, An, tdoaDistDiff);
-                        //deca_ekf.stateEstimatorFinalize(); //Commented out because it doesnt do anything right now
-			            ekf_mutex.unlock();
-
-		            }
-                    RX_idx = 0;
+                        pub_pair_noise(tag, tag.inertial->getFilter());
+                    }
+                }
+                else
+                {
+                    TDOA &stats_filter = tag.imm ? tag.imm->getModel(tag.imm->getMostLikely()) : ekf;
+                    pub_rejections(tag, stats_filter);
+                    if (use_adaptive_noise)
+                    {
+                        pub_pair_noise(tag, stats_filter);
+                    }
+                }
+                if (use_anchor_health)
+                {
+                    pub_anchor_health(tag);
+                }
+                if (use_consistency)
+                {
+                    pub_consistency(tag);
+                }
+                if (tag.imm)
+                {
+                    pub_model_probability(tag);
                 }
             }
         }
+        
+        // The records of all tags of the tick in as few datagrams as fit
+        if (udp)
+        {
+            udp->flush();
+            if (udp->getSendErrors() != udp_errors)
+            {
+                udp_errors = udp->getSendErrors();
+                ROS_WARN_THROTTLE(10.0, "udp_output could not send %u datagrams\n", udp_errors);
+            }
+        }
+        
+        if (pub_stats)
+        {
+            // All tags in one array, sent by the first worker only
+            if (w == 0)
+            {
+                pub_diagnostics();
+            }
+            last_stats = ros::Time::now();
+        }
+        
+        if (pub_on_update)
+        {
+            waitForUpdate(*worker_wake[w], next_pub);
+        }
         else
         {
-            std::this_thread::sleep_for(std::chrono::microseconds(SLEEP_TIME_MICROS));
+            r.sleep();
         }
-            
     }
-    
-    my_serial.close();
-    std::cout << "Closed serial" << std::endl;
 }
 
-void pub_state(const vec3d_t p, const vec3d_t v)
+// Reads the parameters of nh, opens the tags and starts their threads
+bool start(ros::NodeHandle &nh)
 {
-    geometry_msgs::Point pos_msg, vel_msg;
-    pos_msg.x = p.x;
-    pos_msg.y = p.y;
-    pos_msg.z = p.z;
-    decaPos_pub.publish(pos_msg);
-    
-    vel_msg.x = v.x;
-    vel_msg.y = v.y;
-    vel_msg.z = v.z;
-    decaVel_pub.publish(vel_msg);
-}
 
-int main(int argc, char *argv[])
-{   
-    ros::init(argc, argv, "decaNode");
-    ros::NodeHandle nh("~");
-    decaPos_pub = nh.advertise<geometry_msgs::Point>("decaPos", 1);
-	decaVel_pub = nh.advertise<geometry_msgs::Point>("decaVel", 1);
-    
     nh.param<std::string>("deca_port", device_port, "/dev/ttyACM0");
+    nh.param<std::string>("deca_ports", device_ports, device_port); // Comma separated, one tag per port, serial:<number> for a tag by its USB serial number
+    nh.param<int>("baud", serial_baud, SPEED); // Line rate of tags on a serial line (TAG_OUTPUT_USART), USB ports ignore it
+    nh.param<std::string>("tag_names", tag_names, "");              // Comma separated, namespaces the topics of each tag
     nh.param<std::string>("robot_type", robot_type, "quadcopter");
+    nh.param<std::string>("update_mode", update_mode, "sparse");
+    nh.param<std::string>("covariance_mode", covariance_mode, "full"); // full, ud or steady
+    nh.param<std::string>("linearization", linearization, "once"); // Comma separated per tag, once or iterated
+    nh.param<int>("iekf_iterations", iekf_iterations, IEKF_DEFAULT_ITERATIONS);
+    nh.param<std::string>("frame_update", frame_update, "none"); // none, joint or sequential
+    nh.param<double>("pub_rate", pub_rate, PUB_RATE);
+    std::string publish_mode;
+    nh.param<std::string>("publish_mode", publish_mode, "rate"); // rate: every tag at pub_rate, update: after each batch of measurements
+    nh.param<double>("max_pub_rate", max_pub_rate, MAX_PUB_RATE); // Hz, per tag with publish_mode update
+    pub_on_update = (publish_mode == "update");
+    if (!pub_on_update && (publish_mode != "rate"))
+    {
+        ROS_WARN("Unknown publish_mode %s, publishing at pub_rate\n", publish_mode.c_str());
+    }
+    nh.param<int>("num_workers", num_workers, 1);
+    nh.param<bool>("bootstrap", use_bootstrap, true);
+    nh.param<double>("gate_threshold", gate_threshold, 0.0); // Chi-square gate on the normalized innovation, 0 disables
+    nh.param<std::string>("robust_mode", robust_mode, "none"); // none, huber or cauchy
+    nh.param<double>("robust_k", robust_k, 1.345);
+    nh.param<bool>("adaptive_noise", use_adaptive_noise, false); // Per anchor pair noise estimate, best combined with the gate
+    nh.param<double>("adaptive_noise_rate", adaptive_noise_rate, ADAPTIVE_NOISE_RATE);
+    nh.param<std::string>("frame_id", frame_id, "world"); // Frame of the stamped pose and twist
+    nh.param<bool>("onboard_filter", use_onboard_filter, false); // Tag firmware built with TAG_EKF runs the filter
+    nh.param<bool>("push_anchors", use_push_anchors, true); // Send anchorPos.txt to the tags when the port opens
+    nh.param<std::string>("tag_output", tag_output_mode, "all"); // Distance differences the tags send: all, average, decimate or change
+    nh.param<int>("tag_output_packets", tag_output_packets, 10); // Per pair: averaged or decimated over, at most without a measurement in change
+    nh.param<double>("tag_output_threshold", tag_output_threshold, 0.05); // m, change of a pair the change mode sends
+    nh.param<bool>("latency_stats", use_latency_stats, true); // Histograms of the stages from the tag to pub_state
+    nh.param<bool>("clock_sync", use_clock_sync, true); // Stamp measurements with the tag clock synced by its sync frames
+    nh.param<bool>("tag_variance", use_tag_variance, true); // Measurement noise of each pair from the variance its tag sent, if any
+    nh.param<std::string>("latency_trace", latency_trace_path, ""); // Chrome trace of every measurement, empty disables
+    nh.param<double>("predict_latency", predict_latency, 0.0); // s, decaPos and decaVel predicted this far past now, 0 disables
+    nh.param<double>("smoother_lag", smoother_lag, 0.0); // s, delay of the smoothed decaPoseSmoothed, 0 disables
+    nh.param<bool>("imm", use_imm, false); // Run imm_models in parallel and combine them
+    nh.param<std::string>("imu_topic", imu_topics, ""); // Comma separated per tag, sensor_msgs/Imu predicting the filter, empty for none
+    nh.param<double>("imu_accel_noise", imu_accel_noise, INERTIAL_ACCEL_NOISE); // m/s^2/sqrt(Hz)
+    nh.param<double>("imu_bias_noise", imu_bias_noise, INERTIAL_BIAS_NOISE); // m/s^2/sqrt(s)
+    nh.param<std::string>("pose_pairs", pose_pairs, ""); // Comma separated first:second tag numbers of tags on one body, empty for none
+    nh.param<double>("pose_baseline", pose_baseline, 0.3); // m, distance of the tags of a pose pair, the first in front
+    nh.param<double>("pose_accel_noise", pose_accel_noise, POSE_ACCEL_NOISE); // m/s^2/sqrt(Hz)
+    nh.param<double>("pose_yaw_noise", pose_yaw_noise, POSE_YAW_NOISE); // rad/s^2/sqrt(Hz)
+    nh.param<bool>("particle_filter", use_particle_filter, false); // Localize with particles in place of the closed-form bootstrap
+    nh.param<bool>("lockstep", use_lockstep, false); // Update the tags of a worker together in SIMD lanes
+    nh.param<bool>("anchor_health", use_anchor_health, false); // Mask anchors that went silent or whose pairs disagree with the filter
+    nh.param<bool>("hull", use_hull, false); // Inflate the noise and iterate the updates while a tag is outside the hull of its anchors
+    nh.param<double>("hull_margin", hull_margin, HULL_MARGIN); // m outside the hull before the filter switches
+    nh.param<double>("hull_noise_scale", hull_noise_scale, HULL_NOISE_SCALE); // Measurement standard deviations outside, times those inside
+    nh.param<bool>("hull_iterate", hull_iterate, true); // Iterated updates outside the hull
+    nh.param<bool>("consistency", use_consistency, false); // Watch the innovations of the filters and bootstrap a tag again once they lost it
+    nh.param<double>("consistency_nis", consistency_nis, CONSISTENCY_NIS_LIMIT); // Mean NIS of a lost filter, a consistent one has 1
+    nh.param<int>("consistency_periods", consistency_periods, CONSISTENCY_LOST_PERIODS); // Seconds in a row above consistency_nis
+    nh.param<bool>("recorder", use_recorder, true); // Keep the last measurements, innovations and states in memory for dumps
+    nh.param<int>("recorder_records", recorder_records, FLIGHT_RECORDER_RECORDS); // Per tag, rounded up to a power of two
+    nh.param<double>("recorder_seconds", recorder_seconds, FLIGHT_RECORDER_SECONDS); // s before the trigger a dump keeps, 0 for the whole rings
+    nh.param<std::string>("recorder_directory", recorder_directory, "/tmp"); // Where the dumps (.tdfr) are written
+    nh.param<bool>("raw_engine", use_raw_engine, true); // Solve the raw timestamp frames of all tags on the host with shared anchor clocks
+    nh.param<bool>("frame_ring", use_frame_ring, false); // Read the frames tag_reader decoded from the ports instead of the ports
+    nh.param<std::string>("udp_output", udp_output_address, ""); // group:port for binary position records, empty disables
+    nh.param<std::string>("udp_interface", udp_interface, ""); // IPv4 address of the interface udp_output leaves by
+    nh.param<int>("udp_ttl", udp_ttl, UDP_OUTPUT_TTL);
+    nh.param<std::string>("noise_map", noise_map_files, ""); // Comma separated noise_map files, at most one per cell
+    nh.param<std::string>("gain_table", gain_table_files, ""); // Comma separated gain_table files for covariance_mode steady
+    nh.param<std::string>("imm_models", imm_models, "stationary,cv,maneuver");
+    nh.param<double>("imm_switch_rate", imm_switch_rate, IMM_SWITCH_RATE); // 1/s, rate of leaving a model
+    nh.param<std::string>("anchor_file", anchor_file, ros::package::getPath("decawave") + "/config/anchorPos.txt");
+    nh.param<bool>("watch_anchors", use_watch_anchors, true); // Reload anchor_file or the anchors parameter once they change
+    nh.param<bool>("survey", use_survey, false); // Solve the anchors from the ranges frames of the tags and keep refining them
+    nh.param<double>("survey_seconds", survey_seconds, SURVEY_SECONDS);
+    nh.param<double>("phy_margin", phy_margin, PHY_LINK_MARGIN); // dB, link margin of the suggested PHY profile
+    nh.param<std::string>("survey_known", survey_known_path, ""); // "k: x, y, z" known anchor positions
+    nh.param<std::string>("survey_output", survey_output_path, ros::package::getPath("decawave") + "/config/anchorPos_survey.txt");
+    nh.param<double>("jitter_limit", jitter_limit, JITTER_LIMIT); // s, worker wake-up jitter that warns in /diagnostics
+    nh.param<double>("estimator_phase", estimator_phase, 0.0); // s, offset of the worker cycles into their period
+    nh.param<int>("metrics_port", metrics_port, 0); // Prometheus endpoint of the process, 0 disables
+    nh.param<std::string>("checkpoint", checkpoint_path, ""); // File the filters are checkpointed to and resumed from, empty disables
+    nh.param<double>("checkpoint_period", checkpoint_period, FILTER_CHECKPOINT_PERIOD); // s
+    nh.param<double>("checkpoint_max_age", checkpoint_max_age, FILTER_CHECKPOINT_MAX_AGE); // s, older checkpoints are not resumed from
+    serial_config = load_thread_config(nh, "serial");
+    estimator_config = load_thread_config(nh, "estimator");
+    lock_memory(nh);
 
+    if (!initRobotMatrices(nh, robot_type))
+    {
+        return false;
+    }
     
-
-    initRobotMatrices(robot_type);
+    use_frame_update = (frame_update == "joint") || (frame_update == "sequential");
+    frame_mode = (frame_update == "sequential") ? TDOA_BATCH_SEQUENTIAL : TDOA_BATCH_JOINT;
+    
+    std::vector<std::string> ports = splitList(device_ports);
+    std::vector<std::string> names = splitList(tag_names);
+    std::vector<std::string> linearizations = splitList(linearization);
+    std::vector<std::string> imus = splitList(imu_topics);
+    if (!imus.empty() && use_imm)
+    {
+        ROS_WARN("imu_topic is ignored with imm\n");
+        imus.clear();
+    }
+    std::vector<imm_model_t> imm_types;
+    if (use_imm)
+    {
+        std::vector<std::string> model_names = splitList(imm_models);
+        for (size_t k = 0; k < model_names.size(); k++)
+        {
+            imm_model_t type;
+            if (!parseIMMModel(model_names[k], type))
+            {
+                ROS_ERROR("Unknown IMM model %s, expected stationary, cv or maneuver\n", model_names[k].c_str());
+                return false;
+            }
+            imm_types.push_back(type);
+        }
+        if (imm_types.empty() || (imm_types.size() > IMM_MAX_MODELS))
+        {
+            ROS_ERROR("imm_models lists %zu models, expected 1 to %d\n", imm_types.size(), IMM_MAX_MODELS);
+            return false;
+        }
+    }
+    if (ports.empty())
+    {
+        ports.push_back(device_port);
+    }
+    
+    AnchorLayout layout;
+    std::string source;
+    if (loadAnchors(nh, layout, source))
+    {
+        std::lock_guard<std::mutex> lock(anchors_write_mutex);
+        publishAnchors(layout);
+    }
+    
+    loadCellTables(noise_map_files, "Noise map", noise_maps);
+    loadCellTables(gain_table_files, "Gain table", gain_tables);
+    checkGainTables();
+    if ((covariance_mode == "steady") && gain_table_files.empty())
+    {
+        ROS_WARN("covariance_mode steady without a gain_table ignores the measurements\n");
+    }
     
-    vec3d_t initial_position = {0,0,0};
+    if (use_survey)
+    {
+        survey.reset(new AnchorSurvey());
+        // Without 3 known points in a cell the survey keeps the frame of the loaded anchors
+        survey->setHint(*currentAnchors());
+        std::map<int, vec3d_t> known;
+        if (!survey_known_path.empty() && !loadKnownAnchors(survey_known_path, known))
+        {
+            ROS_WARN("Cannot read the known anchors %s\n", survey_known_path.c_str());
+        }
+        survey->setKnown(known);
+    }
     
-    //TDOA deca_ekf(A, P, Q, initial_position);
-    deca_ekf.setPredictionMat(P);
-    deca_ekf.setTransitionMat(A);
-    deca_ekf.setCovarianceMat(Q);
+    if (!checkpoint_path.empty())
+    {
+        std::string error;
+        checkpoint.reset(new FilterCheckpoint());
+        if (!checkpoint->open(checkpoint_path, error))
+        {
+            ROS_WARN("%s, the filters start cold\n", error.c_str());
+            checkpoint.reset();
+        }
+    }
     
-    initAnchors(deca_ekf);
+    if (use_recorder)
+    {
+        std::vector<std::string> recorded;
+        for (size_t i = 0; i < ports.size(); i++)
+        {
+            recorded.push_back((i < names.size()) ? names[i] : ports[i]);
+        }
+        recorder.reset(new FlightRecorder());
+        recorder->configure(recorded, robot_type, std::max(recorder_records, 1), recorder_seconds, recorder_directory);
+        recorder->installCrashHandler();
+        recorder_service = nh.advertiseService("dump_recorder", dump_recorder);
+    }
     
-    serial_thread = std::thread(serial_comm);
+    static const char *output_modes[TDOA_OUTPUT_MODES] = {"all", "average", "decimate", "change"};
+    const char **mode = std::find(output_modes, output_modes + TDOA_OUTPUT_MODES, tag_output_mode);
+    if (mode == output_modes + TDOA_OUTPUT_MODES)
+    {
+        ROS_WARN("Unknown tag_output %s, the tags send all distance differences\n", tag_output_mode.c_str());
+        mode = output_modes;
+    }
+    tag_output.mode = mode - output_modes;
+    tag_output.packets = std::min(std::max(tag_output_packets, 0), 255);
+    tag_output.threshold = tag_output_threshold;
     
-    ros::Rate r(PUB_RATE);
-
-    while(ros::ok())
+    if (use_raw_engine)
+    {
+        raw_engine.reset(new TDOARawEngine(ports.size()));
+    }
+    
+    // Sized once, the pool never reallocates
+    filters.resize(ports.size());
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        TDOA &ekf = filters[i];
+        ekf.setPredictionMat(P);
+        ekf.setTransitionMat(A);
+        ekf.setCovarianceMat(Q);
+        ekf.setUpdateMode(update_mode == "general" ? TDOA_UPDATE_GENERAL : TDOA_UPDATE_SPARSE);
+        ekf.setCovarianceMode((covariance_mode == "ud") ? TDOA_COVARIANCE_UD : (covariance_mode == "steady") ? TDOA_COVARIANCE_STEADY : TDOA_COVARIANCE_FULL);
+        ekf.setGateThreshold(gate_threshold);
+        // Tags without their own entry take the last one, so a single value applies to all
+        const std::string &lin = linearizations.empty() ? linearization : linearizations[std::min(i, linearizations.size() - 1)];
+        ekf.setLinearizationMode(lin == "iterated" ? TDOA_LINEARIZE_ITERATED : TDOA_LINEARIZE_ONCE, iekf_iterations);
+        ekf.setRobustMode((robust_mode == "huber") ? TDOA_ROBUST_HUBER : (robust_mode == "cauchy") ? TDOA_ROBUST_CAUCHY : TDOA_ROBUST_NONE, robust_k);
+        ekf.setAdaptiveNoise(use_adaptive_noise, adaptive_noise_rate);
+        ekf.setHullMode(use_hull, hull_margin, hull_noise_scale, hull_iterate);
+        
+        channels.push_back(std::unique_ptr<TagChannel>(new TagChannel()));
+        TagChannel &tag = *channels.back();
+        tag.port = ports[i];
+        tag.index = i;
+        MetricsRegistry &metrics = MetricsRegistry::instance();
+        const std::string labels = metricLabel("port", tag.port);
+        tag.bytes_metric = &metrics.counter("decawave_serial_bytes_total", "Bytes read from the tag", labels);
+        tag.frames_metric = &metrics.counter("decawave_frames_total", "Frames decoded from the tag", labels);
+        tag.checksum_metric = &metrics.counter("decawave_checksum_errors_total", "Frames of the tag that failed their checksum", labels);
+        tag.update_metric = &metrics.histogram("decawave_update_seconds", "Filter update of the measurements of one worker cycle", labels);
+        tag.update_latency_metric = &metrics.histogram("decawave_update_latency_seconds", "Read of a measurement to its filter update", labels);
+        tag.anchors = currentAnchors();
+        tag.anchors_seen = anchors_generation;
+        if (use_imm)
+        {
+            // Copies of the configured filter, so the models share every setting but the motion model
+            tag.imm.reset(new TDOAIMM());
+            tag.imm->setSwitchRate(imm_switch_rate);
+            for (size_t k = 0; k < imm_types.size(); k++)
+            {
+                tag.imm->addModel(ekf, A, Q, imm_types[k]);
+            }
+        }
+        if ((i < imus.size()) && !imus[i].empty())
+        {
+            // A copy of the settings of the configured filter, its motion model is the accelerometer
+            tag.inertial.reset(new TDOAInertial());
+            tag.inertial->configure(ekf);
+            tag.inertial->setNoise(imu_accel_noise, imu_bias_noise);
+        }
+        if (use_particle_filter)
+        {
+            tag.pf.reset(new TDOAParticleFilter());
+        }
+        if (use_consistency)
+        {
+            // The filter the pairs go to, with imm its first model
+            tag.consistency.setLimits(consistency_nis, consistency_periods);
+            if (tag.inertial)
+            {
+                tag.inertial->getFilter().setConsistencyMonitor(&tag.consistency);
+            }
+            else if (tag.imm)
+            {
+                tag.imm->getModel(0).setConsistencyMonitor(&tag.consistency);
+            }
+            else
+            {
+                ekf.setConsistencyMonitor(&tag.consistency);
+            }
+        }
+        if (recorder)
+        {
+            // Innovations of the same filter as the consistency
+            if (tag.inertial)
+            {
+                tag.inertial->getFilter().setFlightRecorder(&recorder->ring(i), i);
+            }
+            else if (tag.imm)
+            {
+                tag.imm->getModel(0).setFlightRecorder(&recorder->ring(i), i);
+            }
+            else
+            {
+                ekf.setFlightRecorder(&recorder->ring(i), i);
+            }
+        }
+        setCellAnchors(ekf, tag, 0);
+        tag.bootstrapped = !use_bootstrap;
+        restartParticles(tag);
+        if (checkpoint)
+        {
+            tag.checkpoint_slot = checkpoint->slotOf(tag.port);
+            resumeFromCheckpoint(ekf, tag, ros::Time::now().toSec());
+        }
+        
+        // Per second of propagation, Q is given per PROCESS_NOISE_STEP
+        Eigen::Matrix<double, 6, 1> noise_rate;
+        for (int k = 0; k < 6; k++)
+        {
+            noise_rate(k) = Q(k, k) / PROCESS_NOISE_STEP;
+        }
+        tag.history.setProcessNoise(noise_rate);
+        
+        if (smoother_lag > 0)
+        {
+            // With imm the model of robot_type, the combined estimate moves between the models
+            rts_model_t model;
+            for (int k = 0; k < 6; k++)
+            {
+                model.transition[k] = A(k, k);
+                model.processNoise[k] = Q(k, k);
+            }
+            tag.smoother.reset(new RTSSmoother());
+            tag.smoother->setModel(model);
+            tag.smoother->setLag(smoother_lag);
+        }
+        
+        // A single unnamed tag keeps the original topic names
+        if (i < names.size())
+        {
+            tag.name = names[i];
+        }
+        else if (ports.size() > 1)
+        {
+            tag.name = "tag" + std::to_string(i);
+        }
+        std::string prefix = tag.name.empty() ? "" : tag.name + "/";
+        
+        tag.decaPos_pub = nh.advertise<geometry_msgs::Point>(prefix + "decaPos", 1);
+        tag.decaVel_pub = nh.advertise<geometry_msgs::Point>(prefix + "decaVel", 1);
+        tag.queueDepth_pub = nh.advertise<std_msgs::UInt32>(prefix + "queueMaxDepth", 1);
+        tag.queueDrops_pub = nh.advertise<std_msgs::UInt32>(prefix + "queueDrops", 1);
+        tag.tagRxDrops_pub = nh.advertise<std_msgs::UInt32>(prefix + "tagRxDrops", 1);
+        tag.tagQueueDrops_pub = nh.advertise<std_msgs::UInt32>(prefix + "tagQueueDrops", 1);
+        tag.lostPackets_pub = nh.advertise<std_msgs::UInt32>(prefix + "lostPackets", 1);
+        tag.clockSync_pub = nh.advertise<std_msgs::Float32MultiArray>(prefix + "clockSync", 1);
+        tag.rejections_pub = nh.advertise<std_msgs::UInt32MultiArray>(prefix + "rejections", 1);
+        tag.pairNoise_pub = nh.advertise<std_msgs::Float32MultiArray>(prefix + "pairNoise", 1);
+        tag.anchorHealth_pub = nh.advertise<std_msgs::Float32MultiArray>(prefix + "anchorHealth", 1);
+        tag.decaPose_pub = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(prefix + "decaPose", STAMPED_QUEUE_SIZE);
+        tag.decaTwist_pub = nh.advertise<geometry_msgs::TwistWithCovarianceStamped>(prefix + "decaTwist", STAMPED_QUEUE_SIZE);
+        tag.latency_pub = nh.advertise<std_msgs::UInt32MultiArray>(prefix + "latency", 1);
+        tag.modelProbability_pub = nh.advertise<std_msgs::Float32MultiArray>(prefix + "modelProbability", 1);
+        tag.decaPosePredicted_pub = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(prefix + "decaPosePredicted", 1);
+        tag.decaPoseSmoothed_pub = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(prefix + "decaPoseSmoothed", STAMPED_QUEUE_SIZE);
+        tag.poseQuery_pub = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(prefix + "decaPoseQuery", POSE_QUERY_QUEUE_SIZE);
+        tag.poseQuery_sub = nh.subscribe<std_msgs::Time>(prefix + "poseQuery", POSE_QUERY_QUEUE_SIZE,
+                                                         [&tag](const std_msgs::TimeConstPtr &msg) { pose_query(tag, msg); });
+        if (tag.inertial)
+        {
+            tag.imu_sub = nh.subscribe<sensor_msgs::Imu>(imus[i], IMU_QUEUE_SIZE,
+                                                         [&tag](const sensor_msgs::ImuConstPtr &msg) { imu_sample(tag, msg); });
+        }
+    }
+    
+    for (const std::string &pair : splitList(pose_pairs))
     {
-        ekf_mutex.lock();
-        deca_ekf.stateEstimatorPredict(1./PUB_RATE);
-        deca_ekf.stateEstimatorAddProcessNoise();
-        deca_ekf.stateEstimatorFinalize();
-		
-        vec3d_t pos = deca_ekf.getLocation();
-        vec3d_t vel = deca_ekf.getVelocity();
-        ekf_mutex.unlock();
+        size_t a, b;
+        char colon;
+        std::istringstream in(pair);
+        if (!(in >> a >> colon >> b) || (colon != ':') || (a >= channels.size()) || (b >= channels.size()) || (a == b) ||
+            channels[a]->pose || channels[b]->pose)
+        {
+            ROS_WARN("Ignoring pose pair %s, expected first:second of two unpaired tags\n", pair.c_str());
+            continue;
+        }
+        if (channels[a]->imm || channels[a]->inertial || channels[b]->imm || channels[b]->inertial)
+        {
+            ROS_WARN("Ignoring pose pair %s, its tags run imm or an IMU\n", pair.c_str());
+            continue;
+        }
         
-        pub_state(pos, vel);
+        poses.push_back(std::unique_ptr<PoseChannel>(new PoseChannel()));
+        PoseChannel &pose = *poses.back();
+        pose.tags[0] = a;
+        pose.tags[1] = b;
+        // Both on the x axis of the body, its origin between them
+        pose.filter.setBaseline(Eigen::Vector3f(0.5f*pose_baseline, 0, 0), Eigen::Vector3f(-0.5f*pose_baseline, 0, 0));
+        pose.filter.setNoise(pose_accel_noise, pose_yaw_noise);
+        pose.filter.configure(filters[a]);
+        pose.cell = channels[a]->cell;
+        channels[a]->pose = &pose;
+        channels[a]->pose_tag = 0;
+        channels[b]->pose = &pose;
+        channels[b]->pose_tag = 1;
         
-        r.sleep();
+        std::string prefix = channels[a]->name.empty() ? "" : channels[a]->name + "/";
+        pose.bodyPose_pub = nh.advertise<geometry_msgs::PoseWithCovarianceStamped>(prefix + "decaBodyPose", STAMPED_QUEUE_SIZE);
+        pose.bodyTwist_pub = nh.advertise<geometry_msgs::TwistWithCovarianceStamped>(prefix + "decaBodyTwist", STAMPED_QUEUE_SIZE);
+    }
+    
+    // Latency stats of every tag and the firmware diagnostics share the topic
+    diagnostics_pub = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", channels.size() + 1);
+    
+    if (use_latency_stats && !latency_trace_path.empty())
+    {
+        std::vector<std::string> trace_names;
+        for (size_t i = 0; i < channels.size(); i++)
+        {
+            trace_names.push_back(channels[i]->name.empty() ? channels[i]->port : channels[i]->name);
+        }
+        latency_trace.reset(new LatencyTrace(latency_trace_path, trace_names));
+        if (!latency_trace->ok())
+        {
+            ROS_WARN("Cannot create the latency trace %s\n", latency_trace_path.c_str());
+            latency_trace.reset();
+        }
+    }
+    
+    metrics_started = startMetricsServer(metrics_port);
+    
+    running = true;
+    num_workers = std::max(1, std::min(num_workers, (int)filters.size()));
+    tag_worker.resize(channels.size());
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        tag_worker[i] = i % num_workers;
+    }
+    for (size_t k = 0; k < poses.size(); k++)
+    {
+        tag_worker[poses[k]->tags[1]] = tag_worker[poses[k]->tags[0]];
+    }
+    worker_tags.assign(num_workers, std::vector<size_t>());
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        worker_tags[tag_worker[i]].push_back(i);
+    }
+    for (int w = 0; w < num_workers; w++)
+    {
+        worker_wake.push_back(std::unique_ptr<WorkerWake>(new WorkerWake()));
+    }
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        channels[i]->serial_thread = start_thread("serial" + std::to_string(i), serial_config,
+                                                  use_frame_ring ? ring_comm : isUsbPort(channels[i]->port) ? usb_comm : serial_comm,
+                                                  channels[i].get());
     }
     
-    serial_thread.join();
+    if (!udp_output_address.empty())
+    {
+        for (int w = 0; w < num_workers; w++)
+        {
+            std::string error;
+            udp_outputs.push_back(std::unique_ptr<UdpOutput>(new UdpOutput()));
+            if (!udp_outputs.back()->open(udp_output_address, udp_interface, udp_ttl, w, error))
+            {
+                ROS_ERROR("%s\n", error.c_str());
+                udp_outputs.clear();
+                break;
+            }
+        }
+    }
+    for (int w = 0; w < num_workers; w++)
+    {
+        worker_jitter.push_back(std::unique_ptr<LoopJitter>(new LoopJitter(1.0 / pub_rate)));
+        worker_jitter.back()->exportMetrics("decawave_estimator" + std::to_string(w));
+    }
+    for (int w = 0; w < num_workers; w++)
+    {
+        workers.push_back(start_thread("estimator" + std::to_string(w), estimator_config, estimator_worker, w));
+    }
+    if (survey)
+    {
+        survey_thread = std::thread(survey_worker);
+    }
+    if (use_watch_anchors)
+    {
+        anchor_watch_thread = std::thread(anchor_watch_worker, nh);
+    }
+    if (recorder)
+    {
+        recorder_thread = std::thread(recorder_worker);
+    }
+    if (raw_engine)
+    {
+        raw_engine_thread = std::thread(raw_engine_worker);
+    }
+    return true;
+}
+
+// Stops and joins the threads of start
+void stop()
+{
+    running = false;
+    for (size_t w = 0; w < workers.size(); w++)
+    {
+        workers[w].join();
+    }
+    workers.clear();
+    worker_jitter.clear();
+    if (survey_thread.joinable())
+    {
+        survey_thread.join();
+    }
+    if (anchor_watch_thread.joinable())
+    {
+        anchor_watch_thread.join();
+    }
+    if (recorder_thread.joinable())
+    {
+        recorder_thread.join();
+    }
+    if (raw_engine_thread.joinable())
+    {
+        raw_engine_thread.join();
+    }
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        channels[i]->serial_thread.join();
+    }
+    // Once no serial thread adds to it
+    raw_engine.reset();
+    worker_wake.clear();
+    // Ends the trace once no worker adds to it
+    latency_trace.reset();
+    udp_outputs.clear();
+    checkpoint.reset();
+    recorder_service.shutdown();
+    recorder.reset();
+    if (metrics_started)
+    {
+        stopMetricsServer();
+        metrics_started = false;
+    }
+    survey.reset();
+    for (int c = 0; c < TDOA_MAX_CELLS; c++)
+    {
+        noise_maps[c].reset();
+        gain_tables[c].reset();
+    }
+}
+
+namespace decawave
+{
+
+/*
+ * The positioning node as a nodelet: estimators and controllers loaded into
+ * the same manager get its messages as shared pointers, without serializing
+ * them. Its state is global, one per process. decaPos_node loads it into a
+ * manager of its own.
+ */
+class PositioningNodelet : public nodelet::Nodelet
+{
+public:
+    ~PositioningNodelet()
+    {
+        stop();
+    }
+
+private:
+    void onInit()
+    {
+        // initRobotMatrices reports why it did not start
+        start(getPrivateNodeHandle());
+    }
+};
+
 }
 
-void initRobotMatrices(std::string type)
+PLUGINLIB_EXPORT_CLASS(decawave::PositioningNodelet, nodelet::Nodelet)
+
+// Compiled-in car and quadcopter models, used when the parameter server has no definition for them
+bool setBuiltinModel(const std::string &type)
 {
     if (type == "car")
     {
@@ -239,6 +3545,7 @@ void initRobotMatrices(std::string type)
         P(5,5) = 0;
         
         Q.setZero(6,6);
+        return true;
     }
     else if (type == "quadcopter")
     {
@@ -253,20 +3560,80 @@ void initRobotMatrices(std::string type)
         P(5,5) = 1e-4;
         
         Q.setZero(6,6);
+        return true;
+    }
+    
+    // Neutral starting point for models that only exist on the parameter server
+    A.setIdentity(STATE_DIM, STATE_DIM);
+    P.setIdentity(STATE_DIM, STATE_DIM);
+    Q.setZero(STATE_DIM, STATE_DIM);
+    return false;
+}
+
+// A list of STATE_DIM values sets the diagonal, STATE_DIM^2 values the full matrix (row-major). Missing keeps M
+bool loadMatrixParam(ros::NodeHandle &nh, const std::string &key, Eigen::MatrixXf &M)
+{
+    std::vector<double> v;
+    if (!nh.getParam(key, v))
+    {
+        return true;
+    }
+    
+    if (v.size() == STATE_DIM)
+    {
+        M.setZero(STATE_DIM, STATE_DIM);
+        for (int i = 0; i < STATE_DIM; i++)
+        {
+            M(i,i) = v[i];
+        }
+    }
+    else if (v.size() == STATE_DIM*STATE_DIM)
+    {
+        M.resize(STATE_DIM, STATE_DIM);
+        for (int i = 0; i < STATE_DIM*STATE_DIM; i++)
+        {
+            M(i / STATE_DIM, i % STATE_DIM) = v[i];
+        }
     }
     else
     {
-        A.setIdentity(6,6);
-        
-        P.setZero(6,6);
-        P(0,0) = 10000;
-        P(1,1) = 10000;
-        P(2,2) = 100;
-        P(3,3) = 1e-4;
-        P(4,4) = 1e-4;
-        P(5,5) = 1e-4;
-        
-        Q.setZero(6,6);
+        ROS_ERROR("%s has %zu values, expected %d or %d\n", key.c_str(), v.size(), STATE_DIM, STATE_DIM*STATE_DIM);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Motion model of the robot type, from robot_models/<type> (config/robot_models.yaml)
+ * on top of the built-in values. The matrices are copied into the fixed-size
+ * filter, so every model runs on the same unrolled STATE_DIM path.
+ */
+bool initRobotMatrices(ros::NodeHandle &nh, const std::string &type)
+{
+    bool builtin = setBuiltinModel(type);
+    
+    std::string ns = "robot_models/" + type;
+    if (!nh.hasParam(ns))
+    {
+        if (!builtin)
+        {
+            ROS_ERROR("Unknown robot type %s, add it to robot_models\n", type.c_str());
+            return false;
+        }
+        ROS_WARN("No robot_models/%s parameters, using the built-in model\n", type.c_str());
+        return true;
     }
+    
+    int state_dim = STATE_DIM;
+    nh.getParam(ns + "/state_dim", state_dim);
+    if (state_dim != STATE_DIM)
+    {
+        ROS_ERROR("Robot model %s has %d states, the filter is built for %d\n", type.c_str(), state_dim, STATE_DIM);
+        return false;
+    }
+    
+    return loadMatrixParam(nh, ns + "/transition", A)
+        && loadMatrixParam(nh, ns + "/initial_covariance", P)
+        && loadMatrixParam(nh, ns + "/process_noise", Q);
 }
 
@@ -0,0 +1,153 @@
+/*************************************************
+ *
+ *  Memory mapped filter checkpoints, see filter_checkpoint.h
+ *
+ *************************************************/
+
+#include "filter_checkpoint.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t checkpointSize()
+{
+    return sizeof(filter_checkpoint_header_t) + FILTER_CHECKPOINT_SLOTS * sizeof(filter_checkpoint_slot_t);
+}
+
+uint32_t checkpointLayoutHash(const vec3d_t *anchors, size_t count)
+{
+    uint32_t h = 2166136261u;
+    const uint8_t *bytes = (const uint8_t *)anchors;
+    for (size_t i = 0; i < count * sizeof(vec3d_t); i++)
+    {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+    return h;
+}
+
+FilterCheckpoint::FilterCheckpoint() : header(NULL), slots(NULL), mappingSize(0)
+{
+}
+
+FilterCheckpoint::~FilterCheckpoint()
+{
+    close();
+}
+
+void FilterCheckpoint::close()
+{
+    if (header != NULL)
+    {
+        munmap(header, mappingSize);
+    }
+    header = NULL;
+    slots = NULL;
+    mappingSize = 0;
+}
+
+bool FilterCheckpoint::open(const std::string &path, std::string &error)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        error = "cannot open the filter checkpoint " + path;
+        return false;
+    }
+
+    const size_t size = checkpointSize();
+    struct stat st;
+    const bool sized = (fstat(fd, &st) == 0) && ((size_t)st.st_size == size);
+    if (!sized && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0))
+    {
+        ::close(fd);
+        error = "cannot size the filter checkpoint " + path;
+        return false;
+    }
+
+    void *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED)
+    {
+        error = "cannot map the filter checkpoint " + path;
+        return false;
+    }
+    header = (filter_checkpoint_header_t *)m;
+    slots = (filter_checkpoint_slot_t *)((char *)m + sizeof(filter_checkpoint_header_t));
+    mappingSize = size;
+
+    // A file of another build starts over with free slots
+    if ((header->magic != FILTER_CHECKPOINT_MAGIC) || (header->version != FILTER_CHECKPOINT_VERSION)
+        || (header->slots != FILTER_CHECKPOINT_SLOTS) || (header->slotSize != sizeof(filter_checkpoint_slot_t)))
+    {
+        memset(m, 0, size);
+        header->slots = FILTER_CHECKPOINT_SLOTS;
+        header->slotSize = sizeof(filter_checkpoint_slot_t);
+        header->version = FILTER_CHECKPOINT_VERSION;
+        header->magic = FILTER_CHECKPOINT_MAGIC;
+    }
+    return true;
+}
+
+int FilterCheckpoint::slotOf(const std::string &port)
+{
+    if (header == NULL)
+    {
+        return -1;
+    }
+    int free_slot = -1;
+    for (int i = 0; i < FILTER_CHECKPOINT_SLOTS; i++)
+    {
+        if (strncmp(slots[i].port, port.c_str(), sizeof(slots[i].port)) == 0)
+        {
+            return i;
+        }
+        if ((free_slot < 0) && (slots[i].port[0] == '\0'))
+        {
+            free_slot = i;
+        }
+    }
+    if (free_slot >= 0)
+    {
+        // Odd sequence, nothing to load until the first save
+        filter_checkpoint_slot_t &s = slots[free_slot];
+        s.seq.store(1, std::memory_order_relaxed);
+        strncpy(s.port, port.c_str(), sizeof(s.port) - 1);
+        s.port[sizeof(s.port) - 1] = '\0';
+    }
+    return free_slot;
+}
+
+void FilterCheckpoint::save(int slot, const filter_checkpoint_t &checkpoint)
+{
+    if ((header == NULL) || (slot < 0) || (slot >= FILTER_CHECKPOINT_SLOTS))
+    {
+        return;
+    }
+    filter_checkpoint_slot_t &s = slots[slot];
+    const uint32_t seq = s.seq.load(std::memory_order_relaxed) | 1;
+    s.seq.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&s.checkpoint, &checkpoint, sizeof(checkpoint));
+    s.seq.store(seq + 1, std::memory_order_release);
+}
+
+bool FilterCheckpoint::load(int slot, filter_checkpoint_t &checkpoint) const
+{
+    if ((header == NULL) || (slot < 0) || (slot >= FILTER_CHECKPOINT_SLOTS))
+    {
+        return false;
+    }
+    const filter_checkpoint_slot_t &s = slots[slot];
+    const uint32_t seq = s.seq.load(std::memory_order_acquire);
+    if ((seq == 0) || (seq & 1))
+    {
+        return false;
+    }
+    memcpy(&checkpoint, &s.checkpoint, sizeof(checkpoint));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == seq;
+}
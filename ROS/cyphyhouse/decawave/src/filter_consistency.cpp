@@ -0,0 +1,120 @@
+/*************************************************
+ *
+ *  Filter consistency monitoring, see filter_consistency.h
+ *
+ *************************************************/
+
+#include "filter_consistency.h"
+
+FilterConsistency::FilterConsistency()
+{
+    nisLimit = CONSISTENCY_NIS_LIMIT;
+    lostPeriods = CONSISTENCY_LOST_PERIODS;
+    losses = 0;
+    restart();
+}
+
+void FilterConsistency::setLimits(float limit, int periods)
+{
+    nisLimit = limit;
+    lostPeriods = std::max(periods, 1);
+}
+
+void FilterConsistency::restart()
+{
+    head = 0;
+    filled = 0;
+    sum = 0;
+    memset(pairSum, 0, sizeof(pairSum));
+    memset(pairCount, 0, sizeof(pairCount));
+    periodCount = 0;
+    periodRejected = 0;
+    rejectedFraction = 0;
+    worstValid = false;
+    worstAr = worstAn = 0;
+    worstNis = 0;
+    state = CONSISTENCY_OK;
+    periodsAbove = 0;
+    periodStart = 0;
+}
+
+float FilterConsistency::getMeanNIS() const
+{
+    return (filled > 0) ? sum / filled : 0.0f;
+}
+
+float FilterConsistency::getRejectedFraction() const
+{
+    return rejectedFraction;
+}
+
+bool FilterConsistency::getWorstPair(uint8_t &Ar, uint8_t &An, float &nis) const
+{
+    Ar = worstAr;
+    An = worstAn;
+    nis = worstNis;
+    return worstValid;
+}
+
+bool FilterConsistency::evaluate(double t)
+{
+    if (periodStart == 0)
+    {
+        periodStart = t;
+        return false;
+    }
+    if (t - periodStart < CONSISTENCY_PERIOD)
+    {
+        return false;
+    }
+    periodStart = t;
+
+    // ====== PAIRS ======
+    rejectedFraction = (periodCount > 0) ? (float)periodRejected / periodCount : 0.0f;
+    worstValid = false;
+    for (int r = 0; r < MAX_NR_ANCHORS; r++)
+    {
+        for (int n = 0; n < MAX_NR_ANCHORS; n++)
+        {
+            if (pairCount[r][n] < CONSISTENCY_PAIR_SAMPLES)
+            {
+                continue;
+            }
+            const float mean = pairSum[r][n] / pairCount[r][n];
+            if (!worstValid || (mean > worstNis))
+            {
+                worstValid = true;
+                worstAr = r;
+                worstAn = n;
+                worstNis = mean;
+            }
+        }
+    }
+    memset(pairSum, 0, sizeof(pairSum));
+    memset(pairCount, 0, sizeof(pairCount));
+    periodCount = 0;
+    periodRejected = 0;
+
+    // ====== TAG ======
+    if (filled < CONSISTENCY_MIN_SAMPLES)
+    {
+        return true;
+    }
+    // The mean of filled chi-square(1) samples has variance 2/filled, suspect beyond 3 standard deviations
+    const float mean = getMeanNIS();
+    const float bound = 1.0f + 3.0f * std::sqrt(2.0f / filled);
+    periodsAbove = (mean > nisLimit) ? periodsAbove + 1 : 0;
+    if (periodsAbove >= lostPeriods)
+    {
+        if (state != CONSISTENCY_LOST)
+        {
+            losses++;
+        }
+        state = CONSISTENCY_LOST;
+    }
+    else
+    {
+        state = (mean > bound) ? CONSISTENCY_SUSPECT : CONSISTENCY_OK;
+    }
+    return true;
+}
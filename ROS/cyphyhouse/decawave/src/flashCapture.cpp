@@ -0,0 +1,136 @@
+/*************************************************
+ *
+ *  Controls the flash capture of a tag (TREK_TAG tag_capture.h) and turns
+ *  the CAPTURE.BIN it exports into comma separated text.
+ *
+ *  Usage: tag_flash_capture <port> start|stop|export
+ *         tag_flash_capture <CAPTURE.BIN> [csv file]
+ *
+ *  start erases the capture and records from then on, export restarts the
+ *  tag as a USB drive with CAPTURE.BIN, until its next reset. One line per
+ *  record, oldest first: page, Ar, An, packet index, arrival at the tag,
+ *  transmit time of An, arrival of Ar at An, time of flight Ar to An (all
+ *  clock ticks), receive power [dBm], first path gap [dB], quality bits and
+ *  the anchors of the schedule. The clock model is left to the reader, as
+ *  for the raw frames.
+ *
+ *************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "serial/serial.h"
+#include "tdoa_flash_capture.h"
+#include "tdoa_rxpower.h"
+
+#define SPEED         115200
+
+// TDOA_CAPTURE_* of an action name, 0 for none
+static uint8_t parseAction(const char *name)
+{
+    if (strcmp(name, "start") == 0)
+    {
+        return TDOA_CAPTURE_START;
+    }
+    if (strcmp(name, "stop") == 0)
+    {
+        return TDOA_CAPTURE_STOP;
+    }
+    if (strcmp(name, "export") == 0)
+    {
+        return TDOA_CAPTURE_EXPORT;
+    }
+    return 0;
+}
+
+static int command(const std::string &port, uint8_t action)
+{
+    uint8_t msg[TDOA_CAPTURE_FRAME_SIZE];
+    const size_t size = tdoa_capture_frame_encode(msg, action);
+    try
+    {
+        serial::Serial port_serial(port, SPEED, serial::Timeout::simpleTimeout(100));
+        if (port_serial.write(msg, size) != size)
+        {
+            printf("Could not write to %s\n", port.c_str());
+            return 1;
+        }
+    }
+    catch (std::exception &e)
+    {
+        printf("Could not open %s: %s\n", port.c_str(), e.what());
+        return 1;
+    }
+    return 0;
+}
+
+static int convert(const std::string &in, const std::string &out)
+{
+    FILE *file = fopen(in.c_str(), "rb");
+    if (file == NULL)
+    {
+        printf("Could not open %s\n", in.c_str());
+        return 1;
+    }
+    FILE *csv = fopen(out.c_str(), "w");
+    if (csv == NULL)
+    {
+        printf("Could not create %s\n", out.c_str());
+        fclose(file);
+        return 1;
+    }
+
+    std::vector<uint8_t> page(TDOA_CAPTURE_PAGE_SIZE);
+    size_t pages = 0, count = 0;
+    while (fread(page.data(), 1, page.size(), file) == page.size())
+    {
+        uint32_t seq;
+        if (!tdoa_capture_header_decode(page.data(), &seq))
+        {
+            break;
+        }
+        pages++;
+
+        tdoa_capture_rec_t r;
+        for (int k = 0; k < TDOA_CAPTURE_PAGE_RECORDS; k++)
+        {
+            if (!tdoa_capture_rec_decode(&page[TDOA_CAPTURE_HEADER_SIZE + k*TDOA_CAPTURE_RECORD_SIZE], &r))
+            {
+                break;
+            }
+            const float power = (r.rxPower == TDOA_RX_POWER_INVALID) ? NAN : TDOA_RX_POWER_DBM(r.rxPower);
+            fprintf(csv, "%u, %u, %u, %u, %llu, %u, %u, %u, %.2f, %.2f, %u, %u\n", seq, r.Ar, r.An, r.idx,
+                    (unsigned long long)r.rxAn_by_T, r.txAn, r.rxAr_by_An, r.tofAr_to_An, power,
+                    TDOA_RX_POWER_DBM(r.fpGap), r.quality, r.slots);
+            count++;
+        }
+    }
+    fclose(file);
+    fclose(csv);
+
+    printf("%zu records of %zu pages written to %s\n", count, pages, out.c_str());
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: tag_flash_capture <port> start|stop|export\n");
+        printf("       tag_flash_capture <CAPTURE.BIN> [csv file]\n");
+        return 1;
+    }
+
+    const std::string first = argv[1];
+    const uint8_t action = (argc == 3) ? parseAction(argv[2]) : 0;
+    if (action != 0)
+    {
+        return command(first, action);
+    }
+
+    const std::string base = first.substr(0, first.find_last_of('.'));
+    return convert(first, (argc > 2) ? argv[2] : base + ".txt");
+}
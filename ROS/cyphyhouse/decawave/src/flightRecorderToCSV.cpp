@@ -0,0 +1,74 @@
+/*************************************************
+ *
+ *  Converts a flight recorder dump of decaPos_node (.tdfr) to comma
+ *  separated text, one record per line in the order of the file: t, type,
+ *  tag, Ar, An and the values of the type (formatFlightRecord). The header
+ *  goes to the console.
+ *
+ *  Usage: flight_recorder_csv <dump file> [csv file]
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <string>
+
+#include "flight_recorder.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: flight_recorder_csv <dump file> [csv file]\n");
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL)
+    {
+        printf("Could not open %s\n", argv[1]);
+        return 1;
+    }
+    flight_recorder_header_t header;
+    if ((fread(&header, sizeof(header), 1, in) != 1) || (header.magic != FLIGHT_RECORDER_MAGIC) ||
+        (header.version != FLIGHT_RECORDER_VERSION) || (header.recordSize != sizeof(flight_record_t)))
+    {
+        printf("%s is not a flight recorder dump\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+
+    std::string path = argv[1];
+    std::string csv_path = (argc > 2) ? argv[2] : path.substr(0, path.find_last_of('.')) + ".txt";
+    FILE *csv = fopen(csv_path.c_str(), "w");
+    if (csv == NULL)
+    {
+        printf("Could not create %s\n", csv_path.c_str());
+        fclose(in);
+        return 1;
+    }
+
+    flight_record_t r;
+    size_t count = 0;
+    while (fread(&r, sizeof(r), 1, in) == 1)
+    {
+        char row[256];
+        formatFlightRecord(r, row, sizeof(row));
+        fputs(row, csv);
+        count++;
+    }
+    fclose(csv);
+    fclose(in);
+
+    static const char *triggers[] = {"", "request", "alarm", "crash"};
+    printf("%s (%s, %s", argv[1], header.robotType, (header.trigger <= FLIGHT_TRIGGER_CRASH) ? triggers[header.trigger] : "unknown");
+    if (header.triggerTag >= 0)
+    {
+        printf(" %s %d", (header.trigger == FLIGHT_TRIGGER_CRASH) ? "signal" : "tag", header.triggerTag);
+    }
+    printf(" at %.3f s): %zu records to %s\n", header.dumpTime, count, csv_path.c_str());
+    for (uint32_t k = 0; (k < header.tags) && (k < FLIGHT_RECORDER_MAX_TAGS); k++)
+    {
+        printf("  tag %u: %.24s\n", k, header.tagNames[k]);
+    }
+    return 0;
+}
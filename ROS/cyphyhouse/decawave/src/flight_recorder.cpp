@@ -0,0 +1,357 @@
+/*************************************************
+ *
+ *  Flight recorder of decaPos_node, see flight_recorder.h
+ *
+ *************************************************/
+
+#include "flight_recorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const int crashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#define CRASH_SIGNALS ((int)(sizeof(crashSignals) / sizeof(crashSignals[0])))
+
+// Everything the crash handler needs is prepared by installCrashHandler, it only fills in the trigger
+static std::atomic<FlightRecorder *> crashRecorder(NULL);
+static struct sigaction crashPrevious[CRASH_SIGNALS];
+static char crashPath[512];
+static flight_recorder_header_t crashHeader;
+static flight_record_t crashBuffer[FLIGHT_RECORDER_CHUNK];
+
+static const char *triggerName(flight_trigger_t reason)
+{
+    switch (reason)
+    {
+        case FLIGHT_TRIGGER_REQUEST:
+            return "request";
+        case FLIGHT_TRIGGER_ALARM:
+            return "alarm";
+        default:
+            return "crash";
+    }
+}
+
+static double steadyNow()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Local wall clock for file names, to the millisecond
+static std::string timeStamp()
+{
+    const auto now = std::chrono::system_clock::now();
+    const time_t t = std::chrono::system_clock::to_time_t(now);
+    const int ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char buf[32];
+    size_t n = strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &tm);
+    snprintf(buf + n, sizeof(buf) - n, ".%03d", ms);
+    return buf;
+}
+
+void formatFlightRecord(const flight_record_t &r, char *buf, size_t size)
+{
+    int n = snprintf(buf, size, "%.6f, %d, %d, %d, %d", r.t, r.type, r.tag, r.Ar, r.An);
+    for (int k = 0; (k < FLIGHT_RECORDER_VALUES) && (n > 0) && ((size_t)n < size); k++)
+    {
+        n += snprintf(buf + n, size - n, ", %.7g", r.v[k]);
+    }
+    if ((n > 0) && ((size_t)n + 1 < size))
+    {
+        buf[n] = '\n';
+        buf[n + 1] = '\0';
+    }
+}
+
+// ====== RING ======
+
+FlightRecorderRing::FlightRecorderRing() : mask(0), head(0)
+{
+}
+
+void FlightRecorderRing::allocate(size_t capacity)
+{
+    size_t n = 1;
+    while (n < capacity)
+    {
+        n <<= 1;
+    }
+    slots.reset(new Slot[n]);
+    for (size_t k = 0; k < n; k++)
+    {
+        slots[k].seq.store(0, std::memory_order_relaxed);
+    }
+    mask = n - 1;
+    head.store(0, std::memory_order_release);
+}
+
+bool FlightRecorderRing::read(uint64_t s, flight_record_t &r) const
+{
+    const Slot &slot = slots[s & mask];
+    const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq != (uint32_t)(s + 1))
+    {
+        return false;
+    }
+    memcpy(&r, &slot.record, sizeof(r));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+void FlightRecorderRing::snapshot(double since, std::vector<flight_record_t> &out) const
+{
+    if (!slots)
+    {
+        return;
+    }
+    const uint64_t end = head.load(std::memory_order_acquire);
+    const uint64_t capacity = (uint64_t)mask + 1;
+    flight_record_t r;
+    for (uint64_t s = (end > capacity) ? end - capacity : 0; s < end; s++)
+    {
+        // The oldest slots may already hold the next lap
+        if (read(s, r) && (r.t >= since))
+        {
+            out.push_back(r);
+        }
+    }
+}
+
+double FlightRecorderRing::newest() const
+{
+    const uint64_t end = slots ? head.load(std::memory_order_acquire) : 0;
+    flight_record_t r;
+    return ((end > 0) && read(end - 1, r)) ? r.t : 0.0;
+}
+
+bool FlightRecorderRing::write(int fd, flight_record_t *buf, size_t bufRecords) const
+{
+    if (!slots)
+    {
+        return true;
+    }
+    const uint64_t end = head.load(std::memory_order_acquire);
+    const uint64_t capacity = (uint64_t)mask + 1;
+    size_t n = 0;
+    for (uint64_t s = (end > capacity) ? end - capacity : 0; s < end; s++)
+    {
+        if (read(s, buf[n]))
+        {
+            n++;
+        }
+        if ((n == bufRecords) || ((s + 1 == end) && (n > 0)))
+        {
+            const ssize_t size = n * sizeof(flight_record_t);
+            if (::write(fd, buf, size) != size)
+            {
+                return false;
+            }
+            n = 0;
+        }
+    }
+    return true;
+}
+
+// ====== RECORDER ======
+
+FlightRecorder::FlightRecorder() : tags(0), seconds(FLIGHT_RECORDER_SECONDS), dumps(0), pending(false), pendingReason(0),
+                                   pendingTag(-1), pendingTime(0), lastAlarm(-INFINITY)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    removeCrashHandler();
+}
+
+void FlightRecorder::configure(const std::vector<std::string> &tagNames, const std::string &robot, size_t capacity,
+                               double span, const std::string &dir)
+{
+    tags = tagNames.size();
+    rings.reset(new FlightRecorderRing[tags]);
+    for (size_t k = 0; k < tags; k++)
+    {
+        rings[k].allocate(capacity);
+    }
+    names = tagNames;
+    robotType = robot;
+    seconds = span;
+    directory = dir;
+}
+
+void FlightRecorder::fillHeader(flight_recorder_header_t &h, flight_trigger_t reason, int tag, double dumpTime, double span) const
+{
+    memset(&h, 0, sizeof(h));
+    h.magic = FLIGHT_RECORDER_MAGIC;
+    h.version = FLIGHT_RECORDER_VERSION;
+    h.recordSize = sizeof(flight_record_t);
+    h.tags = tags;
+    h.trigger = reason;
+    h.triggerTag = tag;
+    h.dumpTime = dumpTime;
+    h.seconds = span;
+    strncpy(h.robotType, robotType.c_str(), sizeof(h.robotType) - 1);
+    for (size_t k = 0; (k < names.size()) && (k < FLIGHT_RECORDER_MAX_TAGS); k++)
+    {
+        strncpy(h.tagNames[k], names[k].c_str(), sizeof(h.tagNames[k]) - 1);
+    }
+}
+
+double FlightRecorder::newest() const
+{
+    double t = 0;
+    for (size_t k = 0; k < tags; k++)
+    {
+        t = std::max(t, rings[k].newest());
+    }
+    return t;
+}
+
+bool FlightRecorder::trigger(flight_trigger_t reason, int tag)
+{
+    const double now = steadyNow();
+    if (now - lastAlarm.load() < FLIGHT_RECORDER_MIN_GAP)
+    {
+        return false;
+    }
+    bool expected = false;
+    if (!pending.compare_exchange_strong(expected, true))
+    {
+        return false;
+    }
+    lastAlarm = now;
+    pendingReason = reason;
+    pendingTag = tag;
+    // Last, takeTrigger waits for it
+    pendingTime.store(now + FLIGHT_RECORDER_AFTER, std::memory_order_release);
+    return true;
+}
+
+bool FlightRecorder::takeTrigger(flight_trigger_t &reason, int &tag)
+{
+    const double due = pendingTime.load(std::memory_order_acquire);
+    if ((due == 0) || (steadyNow() < due))
+    {
+        return false;
+    }
+    reason = (flight_trigger_t)pendingReason.load();
+    tag = pendingTag;
+    pendingTime = 0;
+    pending = false;
+    return true;
+}
+
+bool FlightRecorder::dump(flight_trigger_t reason, int tag, std::string &path)
+{
+    std::lock_guard<std::mutex> lock(dumpMutex);
+    const double end = newest();
+    const double since = ((seconds > 0) && (end > 0)) ? end - seconds : -INFINITY;
+
+    path = directory + "/flight_" + timeStamp() + "_" + triggerName(reason) + ".tdfr";
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == NULL)
+    {
+        path = "Could not create " + path;
+        return false;
+    }
+    flight_recorder_header_t h;
+    fillHeader(h, reason, tag, end, (seconds > 0) ? seconds : 0);
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    std::vector<flight_record_t> records;
+    for (size_t k = 0; ok && (k < tags); k++)
+    {
+        records.clear();
+        rings[k].snapshot(since, records);
+        ok = records.empty() || (fwrite(records.data(), sizeof(flight_record_t), records.size(), f) == records.size());
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok)
+    {
+        path = "Could not write " + path;
+        return false;
+    }
+    dumps++;
+    return true;
+}
+
+// ====== CRASH ======
+
+void FlightRecorder::crashHandler(int sig)
+{
+    // A fault in here goes straight on to the previous handler
+    FlightRecorder *recorder = crashRecorder.exchange(NULL);
+    if (recorder)
+    {
+        const int fd = open(crashPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            crashHeader.triggerTag = sig;
+            crashHeader.dumpTime = recorder->newest();
+            bool ok = ::write(fd, &crashHeader, sizeof(crashHeader)) == (ssize_t)sizeof(crashHeader);
+            for (size_t k = 0; ok && (k < recorder->tags); k++)
+            {
+                ok = recorder->rings[k].write(fd, crashBuffer, FLIGHT_RECORDER_CHUNK);
+            }
+            close(fd);
+            static const char msg[] = "Flight recorder written to ";
+            ssize_t written = ::write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            written = ::write(STDERR_FILENO, crashPath, strlen(crashPath));
+            written = ::write(STDERR_FILENO, ok ? "\n" : " (incomplete)\n", ok ? 1 : 14);
+            (void)written;
+        }
+    }
+
+    // Blocked until this handler returns: a fault repeats with the previous handler, abort raises again itself
+    for (int k = 0; k < CRASH_SIGNALS; k++)
+    {
+        if (crashSignals[k] == sig)
+        {
+            sigaction(sig, &crashPrevious[k], NULL);
+        }
+    }
+    raise(sig);
+}
+
+void FlightRecorder::installCrashHandler()
+{
+    FlightRecorder *expected = NULL;
+    if (!crashRecorder.compare_exchange_strong(expected, this))
+    {
+        return;
+    }
+    char pid[16];
+    snprintf(pid, sizeof(pid), "%d", (int)getpid());
+    snprintf(crashPath, sizeof(crashPath), "%s/flight_%s_crash_%s.tdfr", directory.c_str(), timeStamp().c_str(), pid);
+    fillHeader(crashHeader, FLIGHT_TRIGGER_CRASH, -1, 0, 0);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = crashHandler;
+    sigemptyset(&action.sa_mask);
+    for (int k = 0; k < CRASH_SIGNALS; k++)
+    {
+        sigaction(crashSignals[k], &action, &crashPrevious[k]);
+    }
+}
+
+void FlightRecorder::removeCrashHandler()
+{
+    FlightRecorder *expected = this;
+    if (!crashRecorder.compare_exchange_strong(expected, NULL))
+    {
+        return;
+    }
+    for (int k = 0; k < CRASH_SIGNALS; k++)
+    {
+        sigaction(crashSignals[k], &crashPrevious[k], NULL);
+    }
+}
@@ -0,0 +1,304 @@
+/*************************************************
+ *
+ *  Shared memory frame ring, see frame_ring.h
+ *
+ *************************************************/
+
+#include "frame_ring.h"
+
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex is the head of the ring");
+
+// Everything of an entry after its sequence, copied as one block
+#define ENTRY_BODY_OFFSET   offsetof(frame_ring_entry_t, type)
+#define ENTRY_BODY_SIZE     (sizeof(frame_ring_entry_t) - ENTRY_BODY_OFFSET)
+
+static size_t ringSize(uint32_t capacity)
+{
+    return sizeof(frame_ring_header_t) + (size_t)capacity * sizeof(frame_ring_entry_t);
+}
+
+static long futex(std::atomic<uint32_t> *addr, int op, uint32_t val, const struct timespec *timeout)
+{
+    // Not FUTEX_PRIVATE_FLAG, the waiters are in other processes
+    return syscall(SYS_futex, (uint32_t *)addr, op, val, timeout, NULL, 0);
+}
+
+std::string frameRingName(const std::string &port)
+{
+    std::string name = "/decawave" + port;
+    std::replace(name.begin() + 1, name.end(), '/', '_');
+    return name;
+}
+
+FrameRing::FrameRing() : header(NULL), entries(NULL), mappingSize(0), mask(0)
+{
+}
+
+FrameRing::~FrameRing()
+{
+    close();
+}
+
+void FrameRing::close()
+{
+    if (header != NULL)
+    {
+        munmap(header, mappingSize);
+    }
+    header = NULL;
+    entries = NULL;
+    mappingSize = 0;
+    mask = 0;
+}
+
+bool FrameRing::map(int fd, size_t size, std::string &error)
+{
+    void *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping keeps the object, the descriptor is not needed anymore
+    ::close(fd);
+    if (m == MAP_FAILED)
+    {
+        error = "cannot map the frame ring";
+        return false;
+    }
+    header = (frame_ring_header_t *)m;
+    entries = (frame_ring_entry_t *)((char *)m + sizeof(frame_ring_header_t));
+    mappingSize = size;
+    return true;
+}
+
+bool FrameRingWriter::create(const std::string &name, uint32_t capacity, std::string &error)
+{
+    close();
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0))
+    {
+        error = "frame ring capacity must be a power of two";
+        return false;
+    }
+
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+    {
+        error = "cannot create " + name;
+        return false;
+    }
+    const size_t size = ringSize(capacity);
+    struct stat st;
+    const bool reuse = (fstat(fd, &st) == 0) && ((size_t)st.st_size == size);
+    if (!reuse && (ftruncate(fd, size) != 0))
+    {
+        ::close(fd);
+        error = "cannot size " + name;
+        return false;
+    }
+    if (!map(fd, size, error))
+    {
+        return false;
+    }
+    mask = capacity - 1;
+
+    frame_ring_header_t *h = header;
+    if (!reuse || (h->magic != FRAME_RING_MAGIC) || (h->version != FRAME_RING_VERSION) || (h->capacity != capacity)
+        || (h->entrySize != sizeof(frame_ring_entry_t)))
+    {
+        // The readers only check the header when they open, so it is written last
+        memset((void *)h, 0, size);
+        h->capacity = capacity;
+        h->entrySize = sizeof(frame_ring_entry_t);
+        h->version = FRAME_RING_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        h->magic = FRAME_RING_MAGIC;
+    }
+    // A writer that died in the middle of a command copy left the lock taken
+    h->txLock.store(0, std::memory_order_release);
+    return true;
+}
+
+void FrameRingWriter::publish(frame_ring_type_t type, double hostTime, const void *data, size_t size)
+{
+    const uint32_t s = header->head.load(std::memory_order_relaxed);
+    frame_ring_entry_t &e = entries[s & mask];
+
+    // Readers of the previous lap see the sequence change before the payload does
+    e.seq.store(s, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.type = type;
+    e.hostTime = hostTime;
+    memcpy(&e.frame, data, std::min(size, sizeof(frame_ring_entry_t) - offsetof(frame_ring_entry_t, frame)));
+    e.seq.store(s + 1, std::memory_order_release);
+
+    // Sequentially consistent with the waiters of wait, a reader is either seen here or sees the new head
+    header->head.store(s + 1, std::memory_order_seq_cst);
+    if (header->waiters.load(std::memory_order_seq_cst) > 0)
+    {
+        futex(&header->head, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+size_t FrameRingWriter::takeCommand(uint8_t *buf)
+{
+    size_t size = 0;
+    uint32_t expected = 0;
+    if (!header->txLock.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+    {
+        // A reader is queueing one, it is taken on the next call
+        return 0;
+    }
+    if (header->txTail != header->txHead)
+    {
+        const uint32_t slot = header->txTail % FRAME_RING_TX_SLOTS;
+        size = header->txSize[slot];
+        memcpy(buf, header->tx[slot], size);
+        header->txTail++;
+    }
+    header->txLock.store(0, std::memory_order_release);
+    return size;
+}
+
+FrameRingReader::FrameRingReader() : cursor(0), lost(0)
+{
+}
+
+bool FrameRingReader::open(const std::string &name, std::string &error)
+{
+    close();
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        error = name + " does not exist, is tag_reader running?";
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(frame_ring_header_t)))
+    {
+        ::close(fd);
+        error = name + " is too short";
+        return false;
+    }
+    if (!map(fd, st.st_size, error))
+    {
+        return false;
+    }
+
+    const frame_ring_header_t *h = header;
+    const uint32_t capacity = h->capacity;
+    if ((h->magic != FRAME_RING_MAGIC) || (h->version != FRAME_RING_VERSION) || (h->entrySize != sizeof(frame_ring_entry_t))
+        || (capacity == 0) || ((capacity & (capacity - 1)) != 0) || (ringSize(capacity) != (size_t)st.st_size))
+    {
+        close();
+        error = name + " is not a frame ring of this version";
+        return false;
+    }
+    mask = capacity - 1;
+    cursor = h->head.load(std::memory_order_acquire);
+    lost = 0;
+    return true;
+}
+
+bool FrameRingReader::next(frame_ring_entry_t &entry)
+{
+    for (;;)
+    {
+        const uint32_t head = header->head.load(std::memory_order_acquire);
+        if (head == cursor)
+        {
+            return false;
+        }
+        if (head - cursor > mask + 1)
+        {
+            lost += head - cursor - (mask + 1);
+            cursor = head - (mask + 1);
+        }
+
+        const frame_ring_entry_t &e = entries[cursor & mask];
+        const uint32_t seq = e.seq.load(std::memory_order_acquire);
+        if (seq == cursor + 1)
+        {
+            memcpy((char *)&entry + ENTRY_BODY_OFFSET, (const char *)&e + ENTRY_BODY_OFFSET, ENTRY_BODY_SIZE);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (e.seq.load(std::memory_order_relaxed) == seq)
+            {
+                entry.seq.store(seq, std::memory_order_relaxed);
+                cursor++;
+                return true;
+            }
+        }
+        // The writer took the slot for a later lap
+        lost++;
+        cursor++;
+    }
+}
+
+bool FrameRingReader::wait(int timeoutMs)
+{
+    if (header->head.load(std::memory_order_acquire) != cursor)
+    {
+        return true;
+    }
+    struct timespec now, deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    header->waiters.fetch_add(1, std::memory_order_seq_cst);
+    // A wake meant for an earlier entry, or a signal, ends the futex with the head unchanged
+    while (header->head.load(std::memory_order_seq_cst) == cursor)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        struct timespec timeout;
+        timeout.tv_sec = deadline.tv_sec - now.tv_sec;
+        timeout.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+        if (timeout.tv_nsec < 0)
+        {
+            timeout.tv_sec--;
+            timeout.tv_nsec += 1000000000;
+        }
+        if (timeout.tv_sec < 0)
+        {
+            break;
+        }
+        // Returns at once if the head already moved past the cursor
+        futex(&header->head, FUTEX_WAIT, cursor, &timeout);
+    }
+    header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return header->head.load(std::memory_order_acquire) != cursor;
+}
+
+bool FrameRingReader::send(const uint8_t *data, size_t size)
+{
+    if (size > FRAME_RING_TX_SIZE)
+    {
+        return false;
+    }
+    uint32_t expected = 0;
+    while (!header->txLock.compare_exchange_weak(expected, 1, std::memory_order_acquire))
+    {
+        expected = 0;
+    }
+    const bool room = (header->txHead - header->txTail < FRAME_RING_TX_SLOTS);
+    if (room)
+    {
+        const uint32_t slot = header->txHead % FRAME_RING_TX_SLOTS;
+        memcpy(header->tx[slot], data, size);
+        header->txSize[slot] = size;
+        header->txHead++;
+    }
+    header->txLock.store(0, std::memory_order_release);
+    return room;
+}
@@ -0,0 +1,301 @@
+/*************************************************
+ *
+ *  Steady-state gain table, see gain_table.h
+ *
+ *************************************************/
+
+#include "gain_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef Eigen::Matrix<double, STATE_DIM, STATE_DIM> GainMatrix;
+typedef Eigen::Matrix<double, STATE_DIM, 1> GainVector;
+
+GainTable::GainTable() : mapping(NULL), mappingSize(0), header(NULL), nodes(NULL), nodeSize(0)
+{
+}
+
+GainTable::~GainTable()
+{
+    unmap();
+}
+
+void GainTable::unmap()
+{
+    if (mapping != NULL)
+    {
+        munmap(mapping, mappingSize);
+    }
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    nodes = NULL;
+    nodeSize = 0;
+}
+
+bool GainTable::load(const std::string &path, std::string &error)
+{
+    unmap();
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(gain_table_header_t)))
+    {
+        close(fd);
+        error = path + " is too short";
+        return false;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file, the descriptor is not needed anymore
+    close(fd);
+    if (m == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    const gain_table_header_t *h = (const gain_table_header_t *)m;
+    const size_t count = (size_t)h->nx * h->ny * h->nz;
+    const size_t size = GAIN_TABLE_NODE_SIZE((size_t)h->anchors);
+    if ((h->magic != GAIN_TABLE_MAGIC) || (h->version != GAIN_TABLE_VERSION))
+    {
+        error = path + " is not a gain table of this version";
+    }
+    else if ((h->anchors < TDOA_MIN_ANCHORS) || (h->anchors > MAX_NR_ANCHORS) || (h->cell >= TDOA_MAX_CELLS)
+             || (h->nx == 0) || (h->ny == 0) || (h->nz == 0) || (count > GAIN_TABLE_MAX_NODES)
+             || !(h->step > 0) || !std::isfinite(h->origin[0]) || !std::isfinite(h->origin[1]) || !std::isfinite(h->origin[2]))
+    {
+        error = path + " has an invalid header";
+    }
+    else if ((size_t)st.st_size != sizeof(gain_table_header_t) + count * size * sizeof(float))
+    {
+        error = path + " does not match the size of its grid";
+    }
+    else
+    {
+        mapping = m;
+        mappingSize = st.st_size;
+        header = h;
+        nodes = (const float *)((const char *)m + sizeof(gain_table_header_t));
+        nodeSize = size;
+        return true;
+    }
+    munmap(m, st.st_size);
+    return false;
+}
+
+/*
+ * One rotation is N slots of slotTime, slot k predicts and updates with the
+ * pair (k-1, k), wrapping at 0. prior[k] keeps the covariance before the
+ * update of slot k, the gain of any pair (Ar, k) follows from it.
+ */
+bool GainTable::steadyState(const std::vector<vec3d_t> &anchors, const gain_table_model_t &model, const Eigen::Vector3d &p, float *out)
+{
+    const int n = anchors.size();
+    const double dt = model.slotTime;
+    const double R = (double)model.stdDev * model.stdDev;
+
+    Eigen::Matrix<double, 3, MAX_NR_ANCHORS> unit;
+    for (int i = 0; i < n; i++)
+    {
+        const Eigen::Vector3d d = p - Eigen::Vector3d(anchors[i].x, anchors[i].y, anchors[i].z);
+        const double r = d.norm();
+        unit.col(i) = (r > 0) ? Eigen::Vector3d(d / r) : Eigen::Vector3d::Zero();
+    }
+
+    GainMatrix F = GainMatrix::Identity(), Qslot = GainMatrix::Zero(), P = GainMatrix::Zero();
+    for (int j = 0; j < STATE_DIM; j++)
+    {
+        F(j,j) = model.transition[j];
+        Qslot(j,j) = model.processNoise[j] * dt / PROCESS_NOISE_STEP;
+    }
+    // An axis without process noise is known and stays so, like z of the car model.
+    // Starting it with a variance would only decay as 1/t and never converge
+    for (int j = 0; j < 3; j++)
+    {
+        F(j, j+3) = dt * model.transition[j+3];
+        const bool velocity = (model.transition[j+3] > 0) && (model.processNoise[j+3] > 0);
+        P(j,j) = (velocity || (model.processNoise[j] > 0)) ? 1.0 : 0.0;
+        P(j+3,j+3) = velocity ? 1.0 : 0.0;
+    }
+
+    GainVector state = GainVector::Zero();
+    std::vector<GainMatrix, Eigen::aligned_allocator<GainMatrix> > prior(n);
+    std::vector<GainVector, Eigen::aligned_allocator<GainVector> > gains(n), last(n);
+    bool converged = false;
+    for (int frame = 0; (frame < GAIN_TABLE_MAX_FRAMES) && !converged; frame++)
+    {
+        double change = 0;
+        for (int k = 0; k < n; k++)
+        {
+            P = F * P * F.transpose() + Qslot;
+            prior[k] = P;
+
+            const Eigen::Vector3d h = unit.col(k) - unit.col((k + n - 1) % n);
+            const GainVector PH = P.leftCols<3>() * h;
+            gains[k] = PH / (h.dot(PH.head<3>()) + R);
+            // The covariance update of the filter itself, so the recursion ends where the EKF does
+            tdoaPositionUpdate<STATE_DIM, double>(state.data(), P.data(), h.data(), 0.0, R);
+            P = 0.5 * (P + P.transpose());
+
+            if (frame > 0)
+            {
+                change = std::max(change, (gains[k] - last[k]).cwiseAbs().maxCoeff());
+            }
+            last[k] = gains[k];
+        }
+        converged = (frame > 0) && (change < GAIN_TABLE_GAIN_TOL);
+    }
+    if (!P.allFinite())
+    {
+        return false;
+    }
+
+    // ====== NODE ======
+    memset(out, 0, GAIN_TABLE_NODE_SIZE(n) * sizeof(float));
+    int c = 0;
+    for (int i = 0; i < STATE_DIM; i++)
+    {
+        for (int j = i; j < STATE_DIM; j++)
+        {
+            out[c++] = P(i,j);
+        }
+    }
+    for (int Ar = 0; Ar < n; Ar++)
+    {
+        for (int An = 0; An < n; An++)
+        {
+            if (Ar == An)
+            {
+                continue;
+            }
+            const Eigen::Vector3d h = unit.col(An) - unit.col(Ar);
+            const GainVector PH = prior[An].leftCols<3>() * h;
+            const double s = h.dot(PH.head<3>()) + R;
+            float *entry = out + GAIN_TABLE_COV_SIZE + GAIN_TABLE_ENTRY*(Ar*n + An);
+            for (int j = 0; j < STATE_DIM; j++)
+            {
+                entry[j] = PH(j) / s;
+            }
+            entry[GAIN_TABLE_S] = s;
+        }
+    }
+    return converged;
+}
+
+bool GainTable::build(const std::string &path, int cell, const std::vector<vec3d_t> &anchors, const gain_table_model_t &model, float step, float margin)
+{
+    const int n = anchors.size();
+    if ((n < TDOA_MIN_ANCHORS) || (n > MAX_NR_ANCHORS) || (cell < 0) || (cell >= TDOA_MAX_CELLS) || !(step > 0)
+        || !(model.stdDev > 0) || !(model.slotTime > 0))
+    {
+        return false;
+    }
+
+    gain_table_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = GAIN_TABLE_MAGIC;
+    h.version = GAIN_TABLE_VERSION;
+    h.cell = cell;
+    h.anchors = n;
+    h.step = step;
+    h.stdDev = model.stdDev;
+    h.slotTime = model.slotTime;
+    memcpy(h.transition, model.transition, sizeof(h.transition));
+    memcpy(h.processNoise, model.processNoise, sizeof(h.processNoise));
+
+    Eigen::Vector3f lo = Eigen::Vector3f::Constant(INFINITY), hi = Eigen::Vector3f::Constant(-INFINITY);
+    for (int i = 0; i < n; i++)
+    {
+        const Eigen::Vector3f a(anchors[i].x, anchors[i].y, anchors[i].z);
+        lo = lo.cwiseMin(a);
+        hi = hi.cwiseMax(a);
+        h.anchorPos[i][0] = a.x();
+        h.anchorPos[i][1] = a.y();
+        h.anchorPos[i][2] = a.z();
+    }
+    lo.array() -= margin;
+    hi.array() += margin;
+    uint32_t *count[3] = {&h.nx, &h.ny, &h.nz};
+    for (int k = 0; k < 3; k++)
+    {
+        h.origin[k] = lo(k);
+        *count[k] = (uint32_t)std::ceil((hi(k) - lo(k)) / step) + 1;
+    }
+    const size_t total = (size_t)h.nx * h.ny * h.nz;
+    if (total > GAIN_TABLE_MAX_NODES)
+    {
+        return false;
+    }
+
+    // ====== GRID ======
+    const size_t size = GAIN_TABLE_NODE_SIZE(n);
+    std::vector<float> data(total * size);
+    size_t node = 0;
+    for (uint32_t z = 0; z < h.nz; z++)
+    {
+        for (uint32_t y = 0; y < h.ny; y++)
+        {
+            for (uint32_t x = 0; x < h.nx; x++, node++)
+            {
+                const Eigen::Vector3d p(h.origin[0] + x*step, h.origin[1] + y*step, h.origin[2] + z*step);
+                if (!steadyState(anchors, model, p, &data[node * size]))
+                {
+                    h.unconverged++;
+                }
+            }
+        }
+    }
+
+    // ====== WRITE ======
+    // Written next to the file and renamed, a node mapping the old one keeps it
+    const std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL)
+    {
+        return false;
+    }
+    bool ok = (fwrite(&h, sizeof(h), 1, f) == 1) && (fwrite(data.data(), sizeof(float), data.size(), f) == data.size());
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || (rename(tmp.c_str(), path.c_str()) != 0))
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+int GainTable::getCell() const
+{
+    return header ? header->cell : -1;
+}
+
+const gain_table_header_t &GainTable::getHeader() const
+{
+    return *header;
+}
+
+float GainTable::layoutChange(const std::vector<vec3d_t> &anchors) const
+{
+    if (!header || (anchors.size() != header->anchors))
+    {
+        return INFINITY;
+    }
+    float change = 0;
+    for (size_t k = 0; k < anchors.size(); k++)
+    {
+        const float dx = anchors[k].x - header->anchorPos[k][0];
+        const float dy = anchors[k].y - header->anchorPos[k][1];
+        const float dz = anchors[k].z - header->anchorPos[k][2];
+        change = std::max(change, std::sqrt(dx*dx + dy*dy + dz*dz));
+    }
+    return change;
+}
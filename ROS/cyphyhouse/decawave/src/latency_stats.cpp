@@ -0,0 +1,200 @@
+/*************************************************
+ *
+ *  Latency histograms and trace, see latency_stats.h
+ *
+ *************************************************/
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include "latency_stats.h"
+#include "tdoa_time.h"
+#include "tdoa_clock.h"
+
+#define TRACE_WRITE_PERIOD_MS 100
+#define TRACE_FILE_BUFFER_SIZE (1 << 16)
+
+static const char *STAGE_NAMES[LATENCY_STAGES] = {"tag", "usb", "queue", "publish", "total"};
+
+const char *latencyStageName(int stage)
+{
+    return ((stage >= 0) && (stage < LATENCY_STAGES)) ? STAGE_NAMES[stage] : "unknown";
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (int b = 0; b < LATENCY_BINS; b++)
+    {
+        bins[b].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(double seconds)
+{
+    const double us = seconds * 1e6;
+    int b = (us > 1.0) ? (int)(std::log2(us) * LATENCY_BINS_PER_OCTAVE) : 0;
+    b = std::min(b, LATENCY_BINS - 1);
+    // Single writer, a plain increment is enough
+    bins[b].store(bins[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::snapshot(uint32_t counts[LATENCY_BINS]) const
+{
+    for (int b = 0; b < LATENCY_BINS; b++)
+    {
+        counts[b] = bins[b].load(std::memory_order_relaxed);
+    }
+}
+
+double LatencyHistogram::binStart(int bin)
+{
+    return std::exp2((double)bin / LATENCY_BINS_PER_OCTAVE) * 1e-6;
+}
+
+double LatencyHistogram::percentile(const uint32_t counts[LATENCY_BINS], double p)
+{
+    uint64_t total = 0;
+    for (int b = 0; b < LATENCY_BINS; b++)
+    {
+        total += counts[b];
+    }
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    const double rank = p * total;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BINS; b++)
+    {
+        seen += counts[b];
+        if ((seen > 0) && (seen >= rank))
+        {
+            return binStart(b + 1);
+        }
+    }
+    return binStart(LATENCY_BINS);
+}
+
+TagClockTracker::TagClockTracker() : valid(false), lastSend(0), sendTime(0), lastRead(0), minOffset(0)
+{
+}
+
+double TagClockTracker::usbLatency(uint64_t send, double read)
+{
+    // Longer gaps may hide a wrap of the 40-bit clock
+    if (!valid || (read - lastRead > LATENCY_CLOCK_GAP))
+    {
+        valid = true;
+        sendTime = 0;
+        minOffset = read;
+    }
+    else
+    {
+        sendTime += tdoa_time_sub(send, lastSend) / TDOA_TIMESTAMP_FREQ;
+        minOffset = std::min(read - sendTime, minOffset + LATENCY_CLOCK_DRIFT * (read - lastRead));
+    }
+    lastSend = send;
+    lastRead = read;
+    return read - sendTime - minOffset;
+}
+
+LatencyTrace::LatencyTrace(const std::string &path, const std::vector<std::string> &tags) : file(nullptr), running(false)
+{
+    FILE *f = std::fopen(path.c_str(), "w");
+    if (!f)
+    {
+        return;
+    }
+    std::setvbuf(f, nullptr, _IOFBF, TRACE_FILE_BUFFER_SIZE);
+
+    // The JSON array format, a trace cut short by a crash still loads
+    std::fputs("[\n", f);
+    for (size_t t = 0; t < tags.size(); t++)
+    {
+        std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%zu,\"args\":{\"name\":\"%s\"}},\n", t, tags[t].c_str());
+        for (int s = 0; s < LATENCY_TOTAL; s++)
+        {
+            std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%zu,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n", t, s,
+                         latencyStageName(s));
+        }
+        queues.push_back(std::unique_ptr<EventQueue>(new EventQueue()));
+    }
+
+    file = f;
+    running = true;
+    writer = std::thread(&LatencyTrace::run, this);
+}
+
+LatencyTrace::~LatencyTrace()
+{
+    if (!file)
+    {
+        return;
+    }
+    running = false;
+    writer.join();
+    // Every event ends with a comma, one more without keeps the array valid JSON
+    std::fputs("{\"name\":\"trace_end\",\"ph\":\"M\",\"pid\":0,\"args\":{}}\n]\n", file);
+    std::fclose(file);
+}
+
+uint32_t LatencyTrace::dropped() const
+{
+    uint32_t drops = 0;
+    for (size_t t = 0; t < queues.size(); t++)
+    {
+        drops += queues[t]->dropCount();
+    }
+    return drops;
+}
+
+void LatencyTrace::add(size_t tag, const latency_trace_event_t &event)
+{
+    if (file && (tag < queues.size()))
+    {
+        queues[tag]->push(event);
+    }
+}
+
+void LatencyTrace::run()
+{
+    bool stopping = false;
+    while (!stopping)
+    {
+        stopping = !running;
+        for (size_t t = 0; t < queues.size(); t++)
+        {
+            latency_trace_event_t event;
+            while (queues[t]->pop(event))
+            {
+                write(t, event);
+            }
+        }
+        if (!stopping)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_WRITE_PERIOD_MS));
+        }
+    }
+}
+
+// One complete event per known stage, laid out back to back around the read
+void LatencyTrace::write(size_t tag, const latency_trace_event_t &event)
+{
+    double start[LATENCY_TOTAL];
+    start[LATENCY_USB] = event.read - event.stage[LATENCY_USB];
+    start[LATENCY_TAG] = start[LATENCY_USB] - event.stage[LATENCY_TAG];
+    start[LATENCY_QUEUE] = event.read;
+    start[LATENCY_PUBLISH] = event.read + event.stage[LATENCY_QUEUE];
+
+    for (int s = 0; s < LATENCY_TOTAL; s++)
+    {
+        if ((event.stage[s] < 0) || ((s == LATENCY_TAG) && (event.stage[LATENCY_USB] < 0)))
+        {
+            continue;
+        }
+        std::fprintf(file, "{\"name\":\"%d-%d\",\"ph\":\"X\",\"pid\":%zu,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f},\n",
+                     event.Ar, event.An, tag, s, start[s] * 1e6, event.stage[s] * 1e6);
+    }
+}
@@ -0,0 +1,195 @@
+/*************************************************
+ *
+ *  Microbenchmarks of the hot paths of the tag link: the steps of the TDOA
+ *  filter, the frame checksum and the frame decoder. The measurements are
+ *  those of a capture or text log, or of a simulated circle without one, and
+ *  the decoder parses them encoded as the tag sends them. Same harness and
+ *  JSON as cyphyhouse_bench of cyphy_car, which covers the car stack.
+ *
+ *  Usage: tdoa_microbench [capture or log] [--anchors <file>] [--json <file>] [--min-time <s>]
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tdoa.h"
+#include "tdoa_capture.h"
+#include "tdoa_replay.h"
+#include "frame_decoder.h"
+#include "cyphy_control/MicroBench.h"
+
+#define SIM_FRAMES      512
+#define FRAME_DT        0.016   // s, one rotation of 8 anchors at ~2 ms
+#define MEAS_NOISE      0.05    // m
+#define MAX_MEAS        4096    // Measurements the cases step through, a multiple of USB_READ
+#define USB_READ        64      // Bytes per read of the serial port
+
+// Lab layout (anchorPos_hotdec.txt), used when neither a capture nor an anchor file gives one
+static anchor_layout_t layout = {8, {
+    {4.495, 0.600, 2.181}, {0.155, 0.190, 2.190}, {4.498, 4.342, 2.174}, {0.155, 4.240, 2.179},
+    {4.498, 0.670, 0.180}, {0.159, 0.780, 0.175}, {4.500, 4.332, 0.180}, {0.159, 4.360, 0.175}}};
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+    return (s.size() >= suffix.size()) && (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+static void usage()
+{
+    printf("Usage: tdoa_microbench [capture or log] [--anchors file] [--json file] [--min-time s]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::string inputFile, anchorFile, jsonFile;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--anchors") && (i + 1 < argc))
+        {
+            anchorFile = argv[++i];
+        }
+        else if ((arg == "--json") && (i + 1 < argc))
+        {
+            jsonFile = argv[++i];
+        }
+        else if ((arg == "--min-time") && (i + 1 < argc))
+        {
+            minTime = atof(argv[++i]);
+        }
+        else if ((arg[0] != '-') && inputFile.empty())
+        {
+            inputFile = arg;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (!anchorFile.empty() && !loadAnchorLayout(anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", anchorFile.c_str());
+        return 1;
+    }
+
+    std::vector<tdoa_frame_record_t> frames;
+    if (inputFile.empty())
+    {
+        simulateCircle(layout, SIM_FRAMES, FRAME_DT, MEAS_NOISE, frames);
+    }
+    else if (endsWith(inputFile, ".tdc"))
+    {
+        TDOACaptureReader reader;
+        if (!reader.open(inputFile))
+        {
+            printf("Could not read capture %s\n", inputFile.c_str());
+            return 1;
+        }
+        captureLayout(reader.getHeader(), layout);
+        tdoa_capture_record_t r;
+        while ((frames.size() * MAX_NR_ANCHORS < MAX_MEAS) && reader.next(r))
+        {
+            frames.push_back(tdoa_frame_record_t());
+            captureToFrame(r, frames.back());
+        }
+    }
+    else if (!loadTextLog(inputFile, frames))
+    {
+        printf("Could not read log %s\n", inputFile.c_str());
+        return 1;
+    }
+
+    // The measurements in order, whole USB reads of them, from the first one with a timestamp
+    std::vector<tdoa_meas_t> meas;
+    for (size_t f = 0; (f < frames.size()) && (meas.size() < MAX_MEAS); f++)
+    {
+        for (size_t k = 0; (k < frames[f].count) && (meas.size() < MAX_MEAS); k++)
+        {
+            if ((frames[f].meas[k].timestamp > 0) || !meas.empty())
+            {
+                meas.push_back(frames[f].meas[k]);
+            }
+        }
+    }
+    meas.resize(meas.size() - meas.size() % USB_READ);
+    if (meas.empty())
+    {
+        printf("Fewer than %d measurements\n", USB_READ);
+        return 1;
+    }
+    printf("%zu measurements of %s\n", meas.size(), inputFile.empty() ? "a simulated circle" : inputFile.c_str());
+    // Each pass over the measurements continues in time where the last one ended
+    const double span = meas.back().timestamp - meas.front().timestamp + FRAME_DT / MAX_NR_ANCHORS;
+
+    std::vector<uint8_t> stream(meas.size() * TDOA_FRAME_SIZE);
+    for (size_t i = 0; i < meas.size(); i++)
+    {
+        tdoa_frame_encode(&stream[i * TDOA_FRAME_SIZE], meas[i].Ar, meas[i].An, meas[i].distanceDiff);
+    }
+
+    MicroBench bench(minTime);
+
+    TDOA ekf;
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+    bench.run("TDOA::stateEstimatorPredict", [&](uint64_t) {
+        ekf.stateEstimatorPredict(FRAME_DT / MAX_NR_ANCHORS);
+    });
+    // Transition, process noise and bound in one pass, as the node predicts to every measurement
+    bench.run("TDOA::stateEstimatorPredictTo", [&](uint64_t i) {
+        ekf.stateEstimatorPredictTo(i * FRAME_DT / MAX_NR_ANCHORS);
+    });
+    // PredictionBound is private, stateEstimatorFinalize is only it
+    bench.run("TDOA::PredictionBound", [&](uint64_t) {
+        ekf.stateEstimatorFinalize();
+    });
+
+    // The loop of the node: prediction to the time of the measurement, then the update
+    TDOA replay;
+    for (int i = 0; i < layout.count; i++)
+    {
+        replay.setAncPosition(i, layout.pos[i]);
+    }
+    replay.initFromFrame(frames[0].meas, frames[0].count);
+    bench.run("TDOA::scalarTDOADistUpdate", [&](uint64_t i) {
+        const tdoa_meas_t &m = meas[i % meas.size()];
+        replay.stateEstimatorPredictTo(m.timestamp + span * (i / meas.size()));
+        replay.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+    });
+    MicroBench::keep(replay.getLocation());
+
+    bench.run("tdoa_fletcher16", [&](uint64_t i) {
+        MicroBench::keep(tdoa_fletcher16(&stream[(i % meas.size()) * TDOA_FRAME_SIZE], TDOA_FRAME_CS_BYTE));
+    });
+    bench.run("tdoa_frame_checksum", [&](uint64_t i) {
+        MicroBench::keep(tdoa_frame_checksum(&stream[(i % meas.size()) * TDOA_FRAME_SIZE]));
+    });
+
+    TDOAFrameDecoder decoder;
+    float sum = 0;
+    const size_t reads = stream.size() / USB_READ;
+    bench.run("TDOAFrameDecoder::commit/64B", [&](uint64_t i) {
+        memcpy(decoder.writePtr(), &stream[(i % reads) * USB_READ], USB_READ);
+        decoder.commit(USB_READ, [&](const tdoa_frame_t &frame) { sum += frame.distanceDiff; });
+    });
+    MicroBench::keep(sum);
+    if (decoder.getBadFrames() > 0)
+    {
+        printf("Decoder: %u bad frames of the benchmark stream\n", decoder.getBadFrames());
+    }
+
+    if (!jsonFile.empty() && !bench.write_json(jsonFile, argv[0]))
+    {
+        printf("Could not write %s\n", jsonFile.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+/*************************************************
+ *
+ *  TDMA network emulator. Runs the anchors of an anchor file, in one or more
+ *  cells, and tags on a simulated radio (tdma_netsim.h) and reports the slot
+ *  use and airtime of every cell, sync loss and failover of every anchor and
+ *  the pair rate of every tag.
+ *
+ *  Usage: tdma_netsim <anchor file> [options]
+ *      --duration <s>        simulated time (default 60)
+ *      --tags <n>            tags at random positions (default 4)
+ *      --cells <n>           copies of the layout side by side (default 1)
+ *      --spacing <m>         between the copies, default the width of the layout plus 2 m
+ *      --addresses <n>       anchor addresses of the schedule (default 8, at least the anchors of the file)
+ *      --phy <name>          short, standard, medium or long
+ *      --chan <n>            channel of cell 0 (default 5)
+ *      --ppm <x>             standard deviation of the crystal offsets
+ *      --walk <x>            crystal random walk, ppm/sqrt(s)
+ *      --loss <p>            frame loss probability
+ *      --range <m>           link range
+ *      --fail <a>@<t>[:<t2>] anchor a of the run (cell * anchors + address) off at t s, back on at t2
+ *      --seed <n>
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "tdma_netsim.h"
+
+typedef struct netsim_options_s
+{
+    std::string anchorFile;
+    double duration;
+    int tags;
+    bool addresses;             // Set on the command line
+    netsim_config_t config;
+    std::vector<netsim_outage_t> outages;
+}netsim_options_t;
+
+static void usage()
+{
+    printf("Usage: tdma_netsim <anchor file> [--duration s] [--tags n] [--cells n] [--spacing m] [--addresses n]\n"
+           "                   [--phy short|standard|medium|long] [--chan n] [--ppm x] [--walk x] [--loss p]\n"
+           "                   [--range m] [--fail a@t[:t2]] [--seed n]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], netsim_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.duration = 60;
+    opt.tags = 4;
+    opt.addresses = false;
+    opt.config = defaultNetSimConfig();
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--duration")
+        {
+            opt.duration = atof(val.c_str());
+        }
+        else if (arg == "--tags")
+        {
+            opt.tags = atoi(val.c_str());
+        }
+        else if (arg == "--cells")
+        {
+            opt.config.cells = atoi(val.c_str());
+        }
+        else if (arg == "--spacing")
+        {
+            opt.config.cellSpacing = atof(val.c_str());
+        }
+        else if (arg == "--addresses")
+        {
+            opt.config.addresses = atoi(val.c_str());
+            opt.addresses = true;
+        }
+        else if (arg == "--phy")
+        {
+            uint8_t p;
+            for (p = 0; (p < TDOA_PHY_PROFILES) && (val != TDOA_PHY_TABLE[p].name); p++);
+            if (p == TDOA_PHY_PROFILES)
+            {
+                return false;
+            }
+            opt.config.phy = p;
+        }
+        else if (arg == "--chan")
+        {
+            opt.config.baseChan = atoi(val.c_str());
+        }
+        else if (arg == "--ppm")
+        {
+            opt.config.clockPpm = atof(val.c_str());
+        }
+        else if (arg == "--walk")
+        {
+            opt.config.clockWalkPpm = atof(val.c_str());
+        }
+        else if (arg == "--loss")
+        {
+            opt.config.lossProb = atof(val.c_str());
+        }
+        else if (arg == "--range")
+        {
+            opt.config.range = atof(val.c_str());
+        }
+        else if (arg == "--fail")
+        {
+            netsim_outage_t outage;
+            outage.on = -1;
+            if (sscanf(val.c_str(), "%d@%lf:%lf", &outage.anchor, &outage.off, &outage.on) < 2)
+            {
+                return false;
+            }
+            opt.outages.push_back(outage);
+        }
+        else if (arg == "--seed")
+        {
+            opt.config.seed = strtoul(val.c_str(), NULL, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return (opt.duration > 0) && (opt.config.cells >= 1) && (opt.config.cells <= TDOA_MAX_CELLS);
+}
+
+int main(int argc, char *argv[])
+{
+    netsim_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    anchor_layout_t layout;
+    if (!loadAnchorLayout(opt.anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+    if (!opt.addresses)
+    {
+        opt.config.addresses = std::max(opt.config.addresses, (uint8_t)layout.count);
+    }
+    if (!tdoa_tdma_valid(opt.config.addresses, TDOA_MIN_SLOT_UNITS))
+    {
+        printf("%d anchor addresses, the schedule has %d to %d\n", opt.config.addresses, TDOA_MIN_ANCHORS, TDOA_MAX_ANCHORS);
+        return 1;
+    }
+
+    TDMANetSim sim(layout, opt.config);
+    sim.addTags(opt.tags);
+    const int anchors = layout.count * opt.config.cells;
+    for (size_t i = 0; i < opt.outages.size(); i++)
+    {
+        if ((opt.outages[i].anchor < 0) || (opt.outages[i].anchor >= anchors))
+        {
+            printf("No anchor %d, the run has %d\n", opt.outages[i].anchor, anchors);
+            return 1;
+        }
+        sim.addOutage(opt.outages[i]);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    sim.run(opt.duration);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Simulated %.1f s in %.2f s, %.0fx real time\n", opt.duration, wall, opt.duration / std::max(wall, 1e-6));
+    printf("%d cells of %d anchors, %d addresses, profile %s, slot %.3f ms\n\n", opt.config.cells, layout.count,
+           opt.config.addresses, TDOA_PHY_TABLE[opt.config.phy].name, sim.getSlotTime() * 1e3);
+
+    // Slot use: time of the slots packets went out in, airtime: of the packets themselves
+    printf("cell  tx/s     slot use  airtime\n");
+    for (int c = 0; c < sim.getCells(); c++)
+    {
+        const netsim_cell_stats_t &s = sim.getCellStats(c);
+        printf("%-4d  %-7.1f  %5.1f %%  %5.1f %%\n", c, s.tx / opt.duration, 100.0 * s.slotTime / opt.duration,
+               100.0 * s.airtime / opt.duration);
+    }
+
+    printf("\nanchor  cell  addr  state    synced   tx/s     late  rx ok    rx err  rx to    missed  lost  failovers  resyncs\n");
+    for (int a = 0; a < anchors; a++)
+    {
+        const netsim_anchor_stats_t &s = sim.getAnchorStats(a);
+        const char *state = sim.isMaster(a) ? "master" : (sim.isSynchronized(a) ? "synced" : "listen");
+        printf("%-6d  %-4d  %-4d  %-7s  %5.1f %%  %-7.1f  %-4u  %-7u  %-6u  %-7u  %-6u  %-4u  %-9u  %u\n", a, sim.getAnchorCell(a),
+               sim.getAnchorAddress(a), state, 100.0 * s.syncedTime / opt.duration, s.tx / opt.duration, s.lateTx, s.rxOk,
+               s.rxErr, s.rxTimeout, s.syncMissed, s.syncLost, s.failovers, s.resyncs);
+    }
+
+    printf("\ntag  cell  rx/s     lost    pairs/s\n");
+    for (size_t t = 0; t < sim.getTagCount(); t++)
+    {
+        const netsim_tag_stats_t &s = sim.getTagStats(t);
+        printf("%-3zu  %-4d  %-7.1f  %-6u  %.1f\n", t, sim.getTagCell(t), s.rx / opt.duration, s.lost, s.pairs / opt.duration);
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*************************************************
+ *
+ *  Precomputed measurement geometry, see noise_map.h
+ *
+ *************************************************/
+
+#include "noise_map.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NoiseMap::NoiseMap() : mapping(NULL), mappingSize(0), header(NULL), planes(NULL), planeSize(0)
+{
+}
+
+NoiseMap::~NoiseMap()
+{
+    unmap();
+}
+
+void NoiseMap::unmap()
+{
+    if (mapping != NULL)
+    {
+        munmap(mapping, mappingSize);
+    }
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    planes = NULL;
+    planeSize = 0;
+}
+
+bool NoiseMap::load(const std::string &path, std::string &error)
+{
+    unmap();
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(noise_map_header_t)))
+    {
+        close(fd);
+        error = path + " is too short";
+        return false;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file, the descriptor is not needed anymore
+    close(fd);
+    if (m == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    const noise_map_header_t *h = (const noise_map_header_t *)m;
+    const size_t nodes = (size_t)h->nx * h->ny * h->nz;
+    const size_t pairs = (size_t)h->anchors * (h->anchors - 1) / 2;
+    if ((h->magic != NOISE_MAP_MAGIC) || (h->version != NOISE_MAP_VERSION))
+    {
+        error = path + " is not a noise map of this version";
+    }
+    else if ((h->anchors < TDOA_MIN_ANCHORS) || (h->anchors > MAX_NR_ANCHORS) || (h->cell >= TDOA_MAX_CELLS)
+             || (h->nx == 0) || (h->ny == 0) || (h->nz == 0) || (nodes > NOISE_MAP_MAX_NODES)
+             || !(h->step > 0) || !std::isfinite(h->origin[0]) || !std::isfinite(h->origin[1]) || !std::isfinite(h->origin[2]))
+    {
+        error = path + " has an invalid header";
+    }
+    else if ((size_t)st.st_size != sizeof(noise_map_header_t) + (1 + pairs) * nodes * sizeof(uint16_t))
+    {
+        error = path + " does not match the size of its grid";
+    }
+    else
+    {
+        mapping = m;
+        mappingSize = st.st_size;
+        header = h;
+        planes = (const uint16_t *)((const char *)m + sizeof(noise_map_header_t));
+        planeSize = nodes;
+        return true;
+    }
+    munmap(m, st.st_size);
+    return false;
+}
+
+/*
+ * Ranges r_i = |p - a_i| + c*t0 with unknown emission time t0 and standard
+ * deviation f(d_i), unit vectors u_i. Eliminating t0 from the information
+ * of (p, t0) leaves for p
+ *      J = U'WU - (U'W1)(1'WU)/(1'W1),  W = diag(1/f(d_i)^2)
+ * which is what any set of range differences to one reference carries.
+ */
+float NoiseMap::geometry(const std::vector<vec3d_t> &anchors, const Eigen::Vector3f &p, float refDist, float *pairScale)
+{
+    const int n = anchors.size();
+    float f[MAX_NR_ANCHORS];
+    Eigen::Matrix3d UWU = Eigen::Matrix3d::Zero();
+    Eigen::Vector3d UW1 = Eigen::Vector3d::Zero();
+    double W1 = 0;
+    for (int i = 0; i < n; i++)
+    {
+        const Eigen::Vector3f a(anchors[i].x, anchors[i].y, anchors[i].z);
+        const float d = (p - a).norm();
+        f[i] = std::max(1.0f, d / refDist);
+        const double w = 1.0 / (f[i]*f[i]);
+        const Eigen::Vector3d u = (d > 0) ? Eigen::Vector3d(((p - a) / d).cast<double>()) : Eigen::Vector3d::Zero();
+        UWU += w * u * u.transpose();
+        UW1 += w * u;
+        W1 += w;
+    }
+    for (int An = 1; An < n; An++)
+    {
+        for (int Ar = 0; Ar < An; Ar++)
+        {
+            pairScale[pairIndex(Ar, An)] = std::sqrt(0.5f * (f[Ar]*f[Ar] + f[An]*f[An]));
+        }
+    }
+
+    const Eigen::Matrix3d J = UWU - UW1 * UW1.transpose() / W1;
+    Eigen::LDLT<Eigen::Matrix3d> ldlt(J);
+    if ((ldlt.info() != Eigen::Success) || !ldlt.isPositive() || (ldlt.vectorD().minCoeff() <= 1e-12 * ldlt.vectorD().maxCoeff()))
+    {
+        return INFINITY;
+    }
+    const double trace = ldlt.solve(Eigen::Matrix3d::Identity()).trace();
+    return (trace > 0) ? std::sqrt(trace) : INFINITY;
+}
+
+static uint16_t quantize(float v, float lsb)
+{
+    const float q = std::round(v / lsb);
+    return (!(q < 65535.0f)) ? 65535 : (q < 0 ? 0 : (uint16_t)q);
+}
+
+bool NoiseMap::build(const std::string &path, int cell, const std::vector<vec3d_t> &anchors, float step, float margin, float refDist)
+{
+    const int n = anchors.size();
+    if ((n < TDOA_MIN_ANCHORS) || (n > MAX_NR_ANCHORS) || (cell < 0) || (cell >= TDOA_MAX_CELLS) || !(step > 0) || !(refDist > 0))
+    {
+        return false;
+    }
+
+    noise_map_header_t h;
+    memset(&h, 0, sizeof(h));
+    h.magic = NOISE_MAP_MAGIC;
+    h.version = NOISE_MAP_VERSION;
+    h.cell = cell;
+    h.anchors = n;
+    h.step = step;
+    h.refDist = refDist;
+
+    Eigen::Vector3f lo = Eigen::Vector3f::Constant(INFINITY), hi = Eigen::Vector3f::Constant(-INFINITY);
+    for (int i = 0; i < n; i++)
+    {
+        const Eigen::Vector3f a(anchors[i].x, anchors[i].y, anchors[i].z);
+        lo = lo.cwiseMin(a);
+        hi = hi.cwiseMax(a);
+        h.anchorPos[i][0] = a.x();
+        h.anchorPos[i][1] = a.y();
+        h.anchorPos[i][2] = a.z();
+    }
+    lo.array() -= margin;
+    hi.array() += margin;
+    uint32_t *count[3] = {&h.nx, &h.ny, &h.nz};
+    for (int k = 0; k < 3; k++)
+    {
+        h.origin[k] = lo(k);
+        *count[k] = (uint32_t)std::ceil((hi(k) - lo(k)) / step) + 1;
+    }
+    const size_t nodes = (size_t)h.nx * h.ny * h.nz;
+    if (nodes > NOISE_MAP_MAX_NODES)
+    {
+        return false;
+    }
+
+    // ====== GRID ======
+    const int pairs = n*(n - 1)/2;
+    std::vector<uint16_t> data((1 + pairs) * nodes);
+    float scale[MAX_NR_ANCHORS*(MAX_NR_ANCHORS - 1)/2];
+    size_t node = 0;
+    for (uint32_t z = 0; z < h.nz; z++)
+    {
+        for (uint32_t y = 0; y < h.ny; y++)
+        {
+            for (uint32_t x = 0; x < h.nx; x++, node++)
+            {
+                const Eigen::Vector3f p(h.origin[0] + x*step, h.origin[1] + y*step, h.origin[2] + z*step);
+                data[node] = quantize(geometry(anchors, p, refDist, scale), NOISE_MAP_GDOP_LSB);
+                for (int k = 0; k < pairs; k++)
+                {
+                    data[(1 + k)*nodes + node] = quantize(scale[k], NOISE_MAP_SCALE_LSB);
+                }
+            }
+        }
+    }
+
+    // ====== WRITE ======
+    // Written next to the file and renamed, a node mapping the old one keeps it
+    const std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL)
+    {
+        return false;
+    }
+    bool ok = (fwrite(&h, sizeof(h), 1, f) == 1) && (fwrite(data.data(), sizeof(uint16_t), data.size(), f) == data.size());
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || (rename(tmp.c_str(), path.c_str()) != 0))
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+int NoiseMap::getCell() const
+{
+    return header ? header->cell : -1;
+}
+
+int NoiseMap::getAnchorCount() const
+{
+    return header ? header->anchors : 0;
+}
+
+const noise_map_header_t &NoiseMap::getHeader() const
+{
+    return *header;
+}
+
+float NoiseMap::layoutChange(const std::vector<vec3d_t> &anchors) const
+{
+    if (!header || (anchors.size() != header->anchors))
+    {
+        return INFINITY;
+    }
+    float change = 0;
+    for (size_t k = 0; k < anchors.size(); k++)
+    {
+        const float dx = anchors[k].x - header->anchorPos[k][0];
+        const float dy = anchors[k].y - header->anchorPos[k][1];
+        const float dz = anchors[k].z - header->anchorPos[k][2];
+        change = std::max(change, std::sqrt(dx*dx + dy*dy + dz*dz));
+    }
+    return change;
+}
@@ -0,0 +1,75 @@
+/*************************************************
+ *
+ *  Independent pairs of a TDMA frame, see pair_select.h
+ *
+ *************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include "pair_select.h"
+
+// Root of anchor a, halving the path on the way
+static uint8_t findRoot(uint8_t *parent, uint8_t a)
+{
+    while (parent[a] != a)
+    {
+        parent[a] = parent[parent[a]];
+        a = parent[a];
+    }
+    return a;
+}
+
+size_t selectIndependentPairs(tdoa_meas_t *meas, float *variance, size_t count)
+{
+    count = std::min(count, (size_t)FRAME_MAX_PAIRS);
+
+    uint8_t order[FRAME_MAX_PAIRS];
+    for (size_t i = 0; i < count; i++)
+    {
+        order[i] = (uint8_t)i;
+    }
+    if (variance)
+    {
+        // A pair without a variance from the tag comes after every measured one
+        auto key = [variance](uint8_t i) { return (variance[i] > 0) ? variance[i] : std::numeric_limits<float>::infinity(); };
+        std::stable_sort(order, order + count, [&key](uint8_t a, uint8_t b) { return key(a) < key(b); });
+    }
+
+    uint8_t parent[MAX_NR_ANCHORS];
+    for (int k = 0; k < MAX_NR_ANCHORS; k++)
+    {
+        parent[k] = (uint8_t)k;
+    }
+    bool keep[FRAME_MAX_PAIRS] = {};
+    for (size_t j = 0; j < count; j++)
+    {
+        const tdoa_meas_t &m = meas[order[j]];
+        if ((m.Ar >= MAX_NR_ANCHORS) || (m.An >= MAX_NR_ANCHORS))
+        {
+            continue;
+        }
+        const uint8_t ra = findRoot(parent, m.Ar);
+        const uint8_t rn = findRoot(parent, m.An);
+        if (ra != rn)
+        {
+            parent[rn] = ra;
+            keep[order[j]] = true;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (keep[i])
+        {
+            meas[kept] = meas[i];
+            if (variance)
+            {
+                variance[kept] = variance[i];
+            }
+            kept++;
+        }
+    }
+    return kept;
+}
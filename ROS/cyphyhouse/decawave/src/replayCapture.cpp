@@ -0,0 +1,380 @@
+/*************************************************
+ *
+ *  Replays a capture (.tdc, tdoa_capture.h, or .tda, tdoa_archive.h) in
+ *  place of the tag and Vicon, to load the nodes downstream without
+ *  hardware. The distance differences go into the frame ring of deca_port
+ *  as tag_reader writes them, so decaPos_node reads them with
+ *  frame_ring:=true, and the Vicon positions of the capture are published
+ *  as the pose of vicon_obj for the estimator, the MPC nodes and posHold.
+ *
+ *  Usage: rosrun decawave tdoa_replay _capture:=<file> [_speed:=1,10,0] [_step_s:=10]
+ *             [_consumers:=decaPos=/decaPose,estimator=/carPose,posHold=/mavros/setpoint_attitude/cmd_vel@poses]
+ *
+ *  Every pair keeps its arrival time in the capture, scaled by the speed:
+ *  1 is real time, 10 ten times faster, 0 as fast as the node can publish.
+ *  With several speeds each runs for step_s seconds, the capture starting
+ *  over as often as needed; a single speed runs through the capture once,
+ *  or forever with loop.
+ *
+ *  Each consumer is an output topic of a node under test, counted against
+ *  the frames it is fed by (or the poses, with @poses). Once a second the
+ *  node logs the input rates and, per consumer, its output rate and the
+ *  ratio of the two. A consumer drops once its ratio falls below
+ *  1 - drop_tolerance of the best one it reached; at the end the node
+ *  reports the highest input rate each consumer sustained before that.
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+#include "ros/ros.h"
+#include "geometry_msgs/PoseStamped.h"
+#include "topic_tools/shape_shifter.h"
+
+#include "frame_ring.h"
+#include "tdoa_capture.h"
+#include "tdoa_archive.h"
+
+#define REPLAY_DEVICE       "/dev/replay0"  // Names the ring, decaPos_node takes it as its deca_port
+#define POSE_SLOT           0xFF            // replay_event_t of a Vicon position
+#define CONSUMER_QUEUE_SIZE 1000            // Deep enough that the count does not drop what the consumer sent
+
+typedef struct replay_event_s
+{
+    uint64_t timeUs;        // Since the start of the capture
+    uint32_t record;
+    uint8_t  slot;          // Pair of the record, POSE_SLOT for its Vicon position
+}replay_event_t;
+
+typedef struct consumer_s
+{
+    std::string name;
+    std::string topic;
+    bool poses;                         // Fed by the poses, not the frames
+    ros::Subscriber sub;
+    std::atomic<uint64_t> count;
+    uint64_t lastCount;
+    double bestRatio;                   // Output per input, best window so far
+    double sustained;                   // Highest input rate of a window before the first drop, 1/s
+    double dropRate;                    // Input rate of the first window it dropped in, 0 while it keeps up
+    double dropSpeed;
+}consumer_t;
+
+static std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+    return (s.size() >= suffix.size()) && (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+// All records of a capture or an archive, with its header
+static bool loadCapture(const std::string &path, tdoa_capture_header_t &header, std::vector<tdoa_capture_record_t> &records)
+{
+    if (endsWith(path, ".tda"))
+    {
+        TDOAArchiveReader reader;
+        if (!reader.open(path) || !reader.readAll(ARCHIVE_ALL_COLUMNS, records))
+        {
+            return false;
+        }
+        header = reader.getHeader().capture;
+        return true;
+    }
+
+    TDOACaptureReader reader;
+    if (!reader.open(path))
+    {
+        return false;
+    }
+    header = reader.getHeader();
+    tdoa_capture_record_t r;
+    while (reader.next(r))
+    {
+        records.push_back(r);
+    }
+    return true;
+}
+
+// Every pair at its arrival and every Vicon position at the end of its rotation, in time order
+static std::vector<replay_event_t> buildEvents(const std::vector<tdoa_capture_record_t> &records)
+{
+    std::vector<replay_event_t> events;
+    events.reserve(records.size() * (TDOA_CAPTURE_MAX_ANCHORS + 1));
+    for (uint32_t i = 0; i < records.size(); i++)
+    {
+        const tdoa_capture_record_t &r = records[i];
+        uint32_t last = 0;
+        for (uint8_t k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+        {
+            if ((r.valid >> k) & 1)
+            {
+                events.push_back({r.timeUs + r.arrivalUs[k], i, k});
+                last = std::max(last, r.arrivalUs[k]);
+            }
+        }
+        events.push_back({r.timeUs + last, i, POSE_SLOT});
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const replay_event_t &a, const replay_event_t &b) { return a.timeUs < b.timeUs; });
+    return events;
+}
+
+// "name=topic" or "name=topic@poses"
+static bool parseConsumer(const std::string &spec, consumer_t &c)
+{
+    const size_t eq = spec.find('=');
+    if ((eq == std::string::npos) || (eq == 0) || (eq + 1 == spec.size()))
+    {
+        return false;
+    }
+    c.name = spec.substr(0, eq);
+    c.topic = spec.substr(eq + 1);
+    c.poses = endsWith(c.topic, "@poses");
+    if (c.poses)
+    {
+        c.topic.erase(c.topic.size() - 6);
+    }
+    c.count.store(0);
+    c.lastCount = 0;
+    c.bestRatio = 0.0;
+    c.sustained = 0.0;
+    c.dropRate = 0.0;
+    c.dropSpeed = 0.0;
+    return true;
+}
+
+static std::string speedName(double speed)
+{
+    char buf[32];
+    if (speed > 0.0)
+    {
+        snprintf(buf, sizeof(buf), "%gx", speed);
+    }
+    else
+    {
+        snprintf(buf, sizeof(buf), "max");
+    }
+    return buf;
+}
+
+// One report window of dt seconds at speed
+static void report(std::vector<std::unique_ptr<consumer_t>> &consumers, double speed, double dt,
+                   uint64_t frames, uint64_t poses, double tolerance)
+{
+    const double frameRate = frames / dt;
+    const double poseRate = poses / dt;
+    std::string line;
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s: %.0f frames/s, %.0f poses/s", speedName(speed).c_str(), frameRate, poseRate);
+    line = buf;
+
+    for (auto &c : consumers)
+    {
+        const uint64_t count = c->count.load(std::memory_order_relaxed);
+        const double outRate = (count - c->lastCount) / dt;
+        const double inRate = c->poses ? poseRate : frameRate;
+        c->lastCount = count;
+        if (inRate <= 0.0)
+        {
+            continue;
+        }
+
+        const double ratio = outRate / inRate;
+        c->bestRatio = std::max(c->bestRatio, ratio);
+        const bool dropping = (c->bestRatio > 0.0) && (ratio < (1.0 - tolerance) * c->bestRatio);
+        if (dropping && (c->dropRate == 0.0))
+        {
+            c->dropRate = inRate;
+            c->dropSpeed = speed;
+        }
+        else if (!dropping && (c->dropRate == 0.0))
+        {
+            c->sustained = std::max(c->sustained, inRate);
+        }
+        snprintf(buf, sizeof(buf), ", %s %.0f/s (%.2f%s)", c->name.c_str(), outRate, ratio, dropping ? " dropping" : "");
+        line += buf;
+    }
+    ROS_INFO("%s\n", line.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+    ros::init(argc, argv, "tdoa_replay");
+    ros::NodeHandle nh("~");
+
+    std::string capture_path, device_port, vicon_obj, speed_list, consumer_list;
+    int ring_capacity;
+    double step_s, report_s, drop_tolerance;
+    bool loop;
+    nh.param<std::string>("capture", capture_path, "");
+    nh.param<std::string>("deca_port", device_port, REPLAY_DEVICE);
+    nh.param<int>("ring_capacity", ring_capacity, FRAME_RING_CAPACITY);
+    nh.param<std::string>("vicon_obj", vicon_obj, ""); // Empty takes the one of the capture
+    nh.param<std::string>("speed", speed_list, "1"); // Comma separated, 0 as fast as possible
+    nh.param<double>("step_s", step_s, 10.0); // Wall time per speed when there are several
+    nh.param<bool>("loop", loop, false);
+    nh.param<std::string>("consumers", consumer_list, "");
+    nh.param<double>("report_s", report_s, 1.0);
+    nh.param<double>("drop_tolerance", drop_tolerance, 0.1);
+
+    tdoa_capture_header_t header;
+    std::vector<tdoa_capture_record_t> records;
+    if (!loadCapture(capture_path, header, records) || records.empty())
+    {
+        ROS_ERROR("%s is not a tdoa capture or archive with records\n", capture_path.c_str());
+        return 1;
+    }
+    const std::vector<replay_event_t> events = buildEvents(records);
+
+    std::vector<double> speeds;
+    for (const std::string &s : splitList(speed_list))
+    {
+        speeds.push_back(std::max(0.0, atof(s.c_str())));
+    }
+    if (speeds.empty())
+    {
+        speeds.push_back(1.0);
+    }
+
+    FrameRingWriter ring;
+    std::string error;
+    if (!ring.create(frameRingName(device_port), ring_capacity, error))
+    {
+        ROS_ERROR("%s\n", error.c_str());
+        return 1;
+    }
+    if (vicon_obj.empty())
+    {
+        vicon_obj = std::string(header.viconObj, strnlen(header.viconObj, sizeof(header.viconObj)));
+    }
+    ros::Publisher pose_pub = nh.advertise<geometry_msgs::PoseStamped>("/vrpn_client_node/" + vicon_obj + "/pose", 10);
+
+    std::vector<std::unique_ptr<consumer_t>> consumers;
+    for (const std::string &spec : splitList(consumer_list))
+    {
+        std::unique_ptr<consumer_t> c(new consumer_t);
+        if (!parseConsumer(spec, *c))
+        {
+            ROS_WARN("Consumer %s is not name=topic[@poses], ignored\n", spec.c_str());
+            continue;
+        }
+        consumer_t *counted = c.get();
+        c->sub = nh.subscribe<topic_tools::ShapeShifter>(c->topic, CONSUMER_QUEUE_SIZE,
+            [counted](const topic_tools::ShapeShifter::ConstPtr &) { counted->count.fetch_add(1, std::memory_order_relaxed); });
+        consumers.push_back(std::move(c));
+    }
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    ROS_INFO("%s: %zu records, %zu events -> %s and %s\n", capture_path.c_str(), records.size(), events.size(),
+             frameRingName(device_port).c_str(), pose_pub.getTopic().c_str());
+
+    typedef std::chrono::steady_clock clock;
+    const bool stepped = speeds.size() > 1;
+    size_t next = 0;
+    uint64_t frames = 0, poses = 0, reportedFrames = 0, reportedPoses = 0;
+    for (size_t step = 0; (step < speeds.size()) && ros::ok(); step++)
+    {
+        const double speed = speeds[step];
+        const clock::time_point stepEnd = clock::now() + std::chrono::microseconds((int64_t)(step_s * 1e6));
+        clock::time_point wallStart = clock::now();
+        clock::time_point lastReport = wallStart;
+        uint64_t captureStart = events[next].timeUs;
+
+        while (ros::ok() && (!stepped || (clock::now() < stepEnd)))
+        {
+            if (next == events.size())
+            {
+                if (!stepped && !loop)
+                {
+                    break;
+                }
+                next = 0;
+                wallStart = clock::now();
+                captureStart = events[0].timeUs;
+            }
+
+            // Absolute schedule, a late event does not delay the ones after it
+            const replay_event_t &e = events[next++];
+            if (speed > 0.0)
+            {
+                std::this_thread::sleep_until(wallStart + std::chrono::microseconds((int64_t)((e.timeUs - captureStart) / speed)));
+            }
+
+            const tdoa_capture_record_t &r = records[e.record];
+            const double now = ros::Time::now().toSec();
+            if (e.slot == POSE_SLOT)
+            {
+                geometry_msgs::PoseStamped pose;
+                pose.header.stamp = ros::Time(now);
+                pose.pose.position.x = r.vicon[0];
+                pose.pose.position.y = r.vicon[1];
+                pose.pose.position.z = r.vicon[2];
+                pose.pose.orientation.w = 1.0;
+                pose_pub.publish(pose);
+                poses++;
+            }
+            else
+            {
+                tdoa_frame_t frame;
+                memset(&frame, 0, sizeof(frame));
+                frame.Ar = r.ref[e.slot];
+                frame.An = e.slot;
+                frame.distanceDiff = r.tdoa[e.slot];
+                ring.publish(FRAME_RING_TDOA, now, &frame, sizeof(frame));
+                frames++;
+            }
+
+            const clock::time_point t = clock::now();
+            const double dt = std::chrono::duration<double>(t - lastReport).count();
+            if (dt >= report_s)
+            {
+                report(consumers, speed, dt, frames - reportedFrames, poses - reportedPoses, drop_tolerance);
+                reportedFrames = frames;
+                reportedPoses = poses;
+                lastReport = t;
+            }
+        }
+    }
+
+    for (const auto &c : consumers)
+    {
+        if (c->dropRate > 0.0)
+        {
+            ROS_INFO("%s sustained %.0f %s/s, dropped from %.0f/s at %s\n", c->name.c_str(), c->sustained,
+                     c->poses ? "poses" : "frames", c->dropRate, speedName(c->dropSpeed).c_str());
+        }
+        else
+        {
+            ROS_INFO("%s sustained %.0f %s/s without dropping\n", c->name.c_str(), c->sustained, c->poses ? "poses" : "frames");
+        }
+    }
+    ROS_INFO("Replayed %llu frames and %llu poses\n", (unsigned long long)frames, (unsigned long long)poses);
+    spinner.stop();
+    return 0;
+}
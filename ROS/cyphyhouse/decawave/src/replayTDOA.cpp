@@ -0,0 +1,325 @@
+/*************************************************
+ *
+ *  Offline replay harness for the TDOA estimator.
+ *  Streams a tdoa_node log (or synthetic frames) through the filter as fast as
+ *  possible and reports throughput, per-update latency percentiles and RMSE
+ *  against the Vicon ground truth recorded next to the measurements.
+ *
+ *  Usage: tdoa_bench <anchor file> [options]
+ *      --log <file>          tdoa_node text log (tdoaData_*.txt)
+ *      --capture <file>      tdoa_node binary capture (tdoaData_*.tdc), uses its anchor layout
+ *                            and ignores the anchor file
+ *      --from <s> --to <s>   time window of the capture to replay
+ *      --synthetic <frames>  simulated circle instead of a log
+ *      --sim <frames>        TDOASimulator stream (drift, NLOS, drops) instead of a log
+ *      --update <mode>       sparse (default) or general
+ *      --covariance <mode>   full (default) or ud
+ *      --linearization <mode> once (default, EKF) or iterated (IEKF)
+ *      --iterations <n>      IEKF iteration bound
+ *      --frame <mode>        none (default), joint or sequential
+ *      --gate <threshold>    innovation gate, 0 disables
+ *      --std <m>             measurement standard deviation
+ *      --adaptive <rate>     per-pair adaptive measurement noise, 0 (default) disables
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+#include "tdoa_sim.h"
+
+#define SYNTH_FRAME_DT   0.016 // s
+#define SYNTH_NOISE      0.05  // m
+
+typedef struct replay_options_s
+{
+    std::string anchorFile;
+    std::string logFile;
+    std::string captureFile;
+    double fromTime;
+    double toTime;
+    size_t synthFrames;
+    size_t simFrames;
+    tdoa_update_mode_t updateMode;
+    tdoa_covariance_mode_t covarianceMode;
+    tdoa_linearization_mode_t linearizationMode;
+    int iterations;
+    bool useFrames;
+    tdoa_batch_mode_t frameMode;
+    float gate;
+    float stdDev;
+    float adaptiveRate;
+}replay_options_t;
+
+static void usage()
+{
+    printf("Usage: tdoa_bench <anchor file> [--log file | --capture file [--from s] [--to s] | --synthetic frames | --sim frames]\n"
+           "                  [--update sparse|general] [--covariance full|ud] [--frame none|joint|sequential] [--gate threshold] [--std m]\n"
+           "                  [--linearization once|iterated] [--iterations n] [--adaptive rate]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], replay_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.fromTime = 0;
+    opt.toTime = 1e12;
+    opt.synthFrames = 0;
+    opt.simFrames = 0;
+    opt.updateMode = TDOA_UPDATE_SPARSE;
+    opt.covarianceMode = TDOA_COVARIANCE_FULL;
+    opt.linearizationMode = TDOA_LINEARIZE_ONCE;
+    opt.iterations = IEKF_DEFAULT_ITERATIONS;
+    opt.useFrames = false;
+    opt.frameMode = TDOA_BATCH_JOINT;
+    opt.gate = 0;
+    opt.stdDev = 0.15f;
+    opt.adaptiveRate = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--log")
+        {
+            opt.logFile = val;
+        }
+        else if (arg == "--capture")
+        {
+            opt.captureFile = val;
+        }
+        else if (arg == "--from")
+        {
+            opt.fromTime = atof(val.c_str());
+        }
+        else if (arg == "--to")
+        {
+            opt.toTime = atof(val.c_str());
+        }
+        else if (arg == "--synthetic")
+        {
+            opt.synthFrames = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--sim")
+        {
+            opt.simFrames = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--update")
+        {
+            opt.updateMode = (val == "general") ? TDOA_UPDATE_GENERAL : TDOA_UPDATE_SPARSE;
+        }
+        else if (arg == "--covariance")
+        {
+            opt.covarianceMode = (val == "ud") ? TDOA_COVARIANCE_UD : TDOA_COVARIANCE_FULL;
+        }
+        else if (arg == "--linearization")
+        {
+            opt.linearizationMode = (val == "iterated") ? TDOA_LINEARIZE_ITERATED : TDOA_LINEARIZE_ONCE;
+        }
+        else if (arg == "--iterations")
+        {
+            opt.iterations = atoi(val.c_str());
+        }
+        else if (arg == "--frame")
+        {
+            opt.useFrames = (val == "joint") || (val == "sequential");
+            opt.frameMode = (val == "sequential") ? TDOA_BATCH_SEQUENTIAL : TDOA_BATCH_JOINT;
+        }
+        else if (arg == "--gate")
+        {
+            opt.gate = atof(val.c_str());
+        }
+        else if (arg == "--std")
+        {
+            opt.stdDev = atof(val.c_str());
+        }
+        else if (arg == "--adaptive")
+        {
+            opt.adaptiveRate = atof(val.c_str());
+        }
+        else
+        {
+            return false;
+        }
+    }
+    int sources = !opt.logFile.empty() + !opt.captureFile.empty() + (opt.synthFrames > 0) + (opt.simFrames > 0);
+    return sources == 1;
+}
+
+typedef struct replay_stats_s
+{
+    std::vector<double> latency_ns;
+    double sq_err;
+    size_t n_err;
+    size_t n_frames;
+    size_t n_updates;
+    bool bootstrapped;
+}replay_stats_t;
+
+static void replayFrame(TDOA &ekf, const tdoa_frame_record_t &rec, const replay_options_t &opt, replay_stats_t &stats)
+{
+    stats.n_frames++;
+    if (!stats.bootstrapped)
+    {
+        stats.bootstrapped = ekf.initFromFrame(rec.meas, rec.count);
+        ekf.stateEstimatorPredictTo(rec.time);
+        return;
+    }
+
+    if (opt.useFrames)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        ekf.batchTDOAUpdate(rec.meas, rec.count, opt.frameMode);
+        auto t1 = std::chrono::steady_clock::now();
+        stats.latency_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+        stats.n_updates += rec.count;
+    }
+    else
+    {
+        for (size_t k = 0; k < rec.count; k++)
+        {
+            const tdoa_meas_t &m = rec.meas[k];
+            auto t0 = std::chrono::steady_clock::now();
+            ekf.stateEstimatorPredictTo(m.timestamp);
+            ekf.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+            auto t1 = std::chrono::steady_clock::now();
+            stats.latency_ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+            stats.n_updates++;
+        }
+    }
+
+    if (rec.hasTruth)
+    {
+        vec3d_t p = ekf.getLocation();
+        double ex = p.x - rec.truth[0], ey = p.y - rec.truth[1], ez = p.z - rec.truth[2];
+        stats.sq_err += ex*ex + ey*ey + ez*ez;
+        stats.n_err++;
+    }
+}
+
+static double percentile(std::vector<double> &v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    size_t idx = std::min(v.size() - 1, (size_t)(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+int main(int argc, char *argv[])
+{
+    replay_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    anchor_layout_t layout;
+    if (opt.captureFile.empty() && !loadAnchorLayout(opt.anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+
+    // Captures are replayed straight from the mapping, the other sources are generated up front
+    TDOACaptureMap capture;
+    tdoa_capture_span_t span = {NULL, 0};
+    std::vector<tdoa_frame_record_t> frames;
+    if (opt.synthFrames > 0)
+    {
+        simulateCircle(layout, opt.synthFrames, SYNTH_FRAME_DT, SYNTH_NOISE, frames);
+    }
+    else if (opt.simFrames > 0)
+    {
+        TDOASimulator sim(layout, defaultSimConfig());
+        sim.generate(opt.simFrames, frames);
+    }
+    else if (!opt.captureFile.empty())
+    {
+        if (!capture.open(opt.captureFile))
+        {
+            printf("Could not read capture %s\n", opt.captureFile.c_str());
+            return 1;
+        }
+        captureLayout(capture.getHeader(), layout);
+        span = capture.window((uint64_t)(opt.fromTime * 1e6), (uint64_t)(std::min(opt.toTime, 1e12) * 1e6));
+    }
+    else if (!loadTextLog(opt.logFile, frames))
+    {
+        printf("Could not read log %s\n", opt.logFile.c_str());
+        return 1;
+    }
+    if (frames.empty() && (span.count == 0))
+    {
+        printf("No frames to replay\n");
+        return 1;
+    }
+
+    TDOA ekf;
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+    ekf.setUpdateMode(opt.updateMode);
+    ekf.setCovarianceMode(opt.covarianceMode);
+    ekf.setLinearizationMode(opt.linearizationMode, opt.iterations);
+    ekf.setGateThreshold(opt.gate);
+    ekf.setStdDev(opt.stdDev);
+    ekf.setAdaptiveNoise(opt.adaptiveRate > 0, opt.adaptiveRate);
+
+    replay_stats_t stats;
+    stats.latency_ns.reserve((frames.size() + span.count) * MAX_NR_ANCHORS);
+    stats.sq_err = 0;
+    stats.n_err = 0;
+    stats.n_frames = 0;
+    stats.n_updates = 0;
+    stats.bootstrapped = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        replayFrame(ekf, frames[f], opt, stats);
+    }
+    for (const tdoa_capture_record_t &r : span)
+    {
+        tdoa_frame_record_t rec;
+        captureToFrame(r, rec);
+        replayFrame(ekf, rec, opt, stats);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(stop - start).count();
+
+    std::vector<double> &latency_ns = stats.latency_ns;
+    printf("%zu frames, %zu measurement updates in %.3f s\n", stats.n_frames, stats.n_updates, elapsed);
+    printf("Throughput: %.0f updates/s\n", stats.n_updates / elapsed);
+    printf("Latency per %s (ns): p50 %.0f  p90 %.0f  p99 %.0f  max %.0f\n", opt.useFrames ? "frame" : "update",
+           percentile(latency_ns, 0.5), percentile(latency_ns, 0.9), percentile(latency_ns, 0.99), percentile(latency_ns, 1.0));
+    if (stats.n_err > 0)
+    {
+        printf("RMSE vs ground truth: %.4f m over %zu frames\n", sqrt(stats.sq_err / stats.n_err), stats.n_err);
+    }
+    else
+    {
+        printf("No ground truth in the input, RMSE not available\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*************************************************
+ *
+ *  Fixed-lag and full-interval RTS smoother, see rts_smoother.h
+ *
+ *************************************************/
+
+#include "rts_smoother.h"
+
+#include <algorithm>
+
+#include "tdoa.h"
+
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+RTSSmoother::RTSSmoother() : head(0), count(0), lag(RTS_LAG), lastOutput(-1)
+{
+    for (int j = 0; j < 6; j++)
+    {
+        model.transition[j] = 1;
+        model.processNoise[j] = 0;
+    }
+}
+
+void RTSSmoother::setModel(const rts_model_t &m)
+{
+    model = m;
+}
+
+void RTSSmoother::setLag(double l)
+{
+    lag = std::max(0.0, l);
+}
+
+void RTSSmoother::reset()
+{
+    head = 0;
+    count = 0;
+    lastOutput = -1;
+}
+
+void RTSSmoother::add(const StateSample &filtered)
+{
+    if ((count > 0) && (filtered.t <= at(count-1).t))
+    {
+        return;
+    }
+    if ((count > 0) && (filtered.t - at(count-1).t > RTS_MAX_GAP))
+    {
+        // The filter restarted, nothing before it is related anymore
+        reset();
+    }
+    if (count == RTS_MAX_SAMPLES)
+    {
+        head = (head + 1) % RTS_MAX_SAMPLES;
+        count--;
+    }
+    ring[(head + count) % RTS_MAX_SAMPLES] = filtered;
+    count++;
+}
+
+/*
+ * Same transition as TDOAFilter::stateEstimatorPredictTo: the velocities
+ * scaled by their diagonal entry of A and added to the positions, the
+ * process noise scaled by the time step.
+ */
+void RTSSmoother::backwardStep(const rts_model_t &m, const StateSample &filtered, const StateSample &next, StateSample &smoothed)
+{
+    const double dt = next.t - filtered.t;
+    Matrix6d F = Matrix6d::Zero(), Q = Matrix6d::Zero();
+    for (int j = 0; j < 6; j++)
+    {
+        F(j,j) = m.transition[j];
+        Q(j,j) = m.processNoise[j] * dt / PROCESS_NOISE_STEP + RTS_MIN_VARIANCE;
+    }
+    for (int j = 0; j < 3; j++)
+    {
+        F(j, j+3) = dt * m.transition[j+3];
+    }
+
+    Vector6d x, xs;
+    x << filtered.p, filtered.v;
+    xs << next.p, next.v;
+    const Vector6d xPred = F * x;
+    const Matrix6d PF = F * filtered.P;
+    const Matrix6d PPred = PF * F.transpose() + Q;
+
+    // C' = PPred^-1 F P, PPred is symmetric
+    const Matrix6d C = PPred.ldlt().solve(PF).transpose();
+    const Vector6d xOut = x + C * (xs - xPred);
+    const Matrix6d POut = filtered.P + C * (next.P - PPred) * C.transpose();
+
+    smoothed.t = filtered.t;
+    smoothed.p = xOut.head<3>();
+    smoothed.v = xOut.tail<3>();
+    smoothed.P = 0.5 * (POut + POut.transpose());
+}
+
+bool RTSSmoother::output(StateSample &smoothed)
+{
+    if (count < 2)
+    {
+        return false;
+    }
+    const double target = at(count-1).t - lag;
+    if (at(0).t > target)
+    {
+        return false;
+    }
+    // Newest state at or before the target
+    size_t k = count - 1;
+    while ((k > 0) && (at(k).t > target))
+    {
+        k--;
+    }
+    if (at(k).t <= lastOutput)
+    {
+        return false;
+    }
+
+    smoothed = at(count-1);
+    for (size_t i = count - 1; i > k; i--)
+    {
+        StateSample previous;
+        backwardStep(model, at(i-1), smoothed, previous);
+        smoothed = previous;
+    }
+    lastOutput = smoothed.t;
+    return true;
+}
+
+void RTSSmoother::smooth(StateSampleVector &samples, const rts_model_t &model)
+{
+    for (size_t i = samples.size() - 1; (i > 0) && (i < samples.size()); i--)
+    {
+        // A gap restarts the filter as in add, the run before it is smoothed on its own
+        if (samples[i].t - samples[i-1].t > RTS_MAX_GAP)
+        {
+            continue;
+        }
+        StateSample previous;
+        backwardStep(model, samples[i-1], samples[i], previous);
+        samples[i-1] = previous;
+    }
+}
@@ -9,6 +9,7 @@
 #include <fstream>
 #include <chrono>
 #include <thread>
+#include <algorithm>
 #include <mutex>
 
 #include "ros/ros.h"
@@ -18,154 +19,161 @@
 
 
 #include "serial/serial.h"
+#include "frame_decoder.h"
+#include "frame_ring.h"
+#include "tdoa_capture.h"
+#include "cyphy_control/Metrics.h"
 
 
 #define DEVICE        "/dev/ttyACM0"
 #define SPEED         1152000
-#define MSG_SIZE      9
+#define SERIAL_TIMEOUT_MS 100 // Longest wait for data before rechecking ros::ok()
 
-#define MSG_TYPE_BYTE 0
-#define ANCR_BYTE     1
-#define ANCN_BYTE     2
-#define DATA_BYTE     3
-#define CS_BYTE       7
-
-
-#define TYPE_TDOA     0xAA
-
-#define SERIAL_BUF_SIZE 32
-
-#define SLEEP_TIME_MICROS 10 //us
-
-bool is_init;
-uint8_t An, Ar, tdoa_recv;
-float tdoaDistDiff;
-float tdoaVec[8];
+// Rotation being filled, written out once an anchor number repeats or goes back
+tdoa_capture_record_t rotation;
+int last_anc;
+uint64_t lost_pairs;
 
 std::thread serial_thread;
 
-std::ofstream positionFile;
+TDOACaptureWriter captureFile;
 ros::Time time_start;
 
 std::string device_port, robot_type, vicon_obj;
+bool use_frame_ring;
 
 geometry_msgs::Point vicon_position;
 
-//Function prototypes
+// Served on metrics_port
+MetricCounter *bytes_metric, *frames_metric, *checksum_metric, *records_metric;
 
+//Function prototypes
 
-float to_float(uint8_t* buff)
+void flushRotation()
 {
-    uint16_t char_for_move[2];
-    char_for_move[1] = (buff[0]<<8) | (buff[1]);
-    char_for_move[0] = (buff[2]<<8) | (buff[3]);
-    return(*(float*)(char_for_move));
+    if (rotation.valid == 0)
+    {
+        return;
+    }
+    rotation.vicon[0] = vicon_position.x;
+    rotation.vicon[1] = vicon_position.y;
+    rotation.vicon[2] = vicon_position.z;
+    captureFile.append(rotation); // Only copies, the writer thread does the disk access
+    records_metric->add();
+    memset(&rotation, 0, sizeof(rotation));
 }
 
-/* Fletcher checksum, borrowed from wikipedia */
-uint16_t serial_checksum(const uint8_t *data, size_t len)
+
+// Adds a frame read at now_us to the rotation
+void addFrame(const tdoa_frame_t &frame, uint64_t now_us)
 {
-    uint16_t sum1 = 0xff, sum2 = 0xff;
-
-    while (len) {
-        unsigned tlen = len > 21 ? 21 : len;
-        len -= tlen;
-        do {
-            sum1 += *data++;
-            sum2 += sum1;
-        } while (--tlen);
-        sum1 = (sum1 & 0xff) + (sum1 >> 8);
-        sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    uint8_t Ar = frame.Ar; //prev_anc
+    uint8_t An = frame.An; //curr_anc
+    if ((Ar >= TDOA_CAPTURE_MAX_ANCHORS) || (An >= TDOA_CAPTURE_MAX_ANCHORS))
+    {
+        return;
     }
-    /* Second reduction step to reduce sums to 16 bits */
-    sum1 = (sum1 & 0xff) + (sum1 >> 8);
-    sum2 = (sum2 & 0xff) + (sum2 >> 8);
-    return sum2 << 8 | sum1;
+    
+    if (An <= last_anc)
+    {
+        flushRotation();
+    }
+    if (rotation.valid == 0)
+    {
+        rotation.timeUs = now_us;
+    }
+    
+    // Non-sequential pairs are kept with their real reference, the skipped slots stay invalid
+    if (((Ar+1) & 0x7) != An)
+    {
+        lost_pairs++;
+    }
+    rotation.valid |= 1u << An;
+    rotation.tdoa[An] = frame.distanceDiff;
+    rotation.ref[An] = Ar;
+    rotation.arrivalUs[An] = now_us - rotation.timeUs;
+    last_anc = An;
 }
 
 void serial_comm()
 {
-    uint8_t RX_idx = 0;
-    uint8_t serial_msg[SERIAL_BUF_SIZE];
-    bool ignoring_flag = false;
-    int bytes_avail;
+    TDOAFrameDecoder decoder;
 
-    serial::Serial my_serial(device_port, SPEED, serial::Timeout::simpleTimeout(1000));
+    serial::Serial my_serial(device_port, SPEED, serial::Timeout::simpleTimeout(SERIAL_TIMEOUT_MS));
 
     while(ros::ok())
     {
-        bytes_avail = my_serial.available();
-        if(bytes_avail > 0)
+        // Blocks until data arrives or the timeout expires
+        if(!my_serial.waitReadable())
         {
-            //std::cout << bytes_avail << std::endl;
-            my_serial.read(&serial_msg[RX_idx], 1);
-            if(RX_idx == MSG_TYPE_BYTE)
-            {
-                if((serial_msg[0] == TYPE_TDOA))
-                {
-                    ignoring_flag = false;
-                }
-                else
-                {
-                    ignoring_flag = true;
-                    RX_idx = 0;
-                }
-            }
+            continue;
+        }
+        
+        // Read everything that is already waiting in one call
+        size_t bytes_avail = my_serial.available();
+        size_t bytes_read = my_serial.read(decoder.writePtr(), std::max<size_t>(1, std::min(bytes_avail, decoder.writeSpace())));
+        
+        const uint32_t good = decoder.getGoodFrames(), bad = decoder.getBadFrames();
+        decoder.commit(bytes_read, [](const tdoa_frame_t &frame)
+        {
+            addFrame(frame, (ros::Time::now() - time_start).toNSec() / 1000);
+        });
+        bytes_metric->add(bytes_read);
+        frames_metric->add(decoder.getGoodFrames() - good);
+        checksum_metric->add(decoder.getBadFrames() - bad);
+    }
+    
+    my_serial.close();
+    std::cout << "Closed serial" << std::endl;
+}
 
-            if(ignoring_flag == false)
+// serial_comm for frame_ring, the frames tag_reader decoded from the port, next to decaPos_node
+void ring_comm()
+{
+    FrameRingReader ring;
+    std::string error;
+    while (ros::ok() && !ring.open(frameRingName(device_port), error))
+    {
+        ROS_WARN_THROTTLE(10.0, "%s\n", error.c_str());
+        std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_RING_RETRY_MS));
+    }
+    
+    frame_ring_entry_t entry;
+    while (ros::ok())
+    {
+        if (!ring.wait(SERIAL_TIMEOUT_MS))
+        {
+            continue;
+        }
+        while (ring.next(entry))
+        {
+            frames_metric->add();
+            if ((entry.type == FRAME_RING_TDOA) && (entry.hostTime >= time_start.toSec()))
             {
-                RX_idx++;
-                if(RX_idx == MSG_SIZE)
-                {
-                    uint16_t cs = (serial_msg[MSG_SIZE-2] << 8) | serial_msg[MSG_SIZE-1];
-                    if(cs == serial_checksum(serial_msg, MSG_SIZE-2))
-                    {
-                        Ar = serial_msg[ANCR_BYTE]; //prev_anc
-                        An = serial_msg[ANCN_BYTE]; //curr_anc
-                        tdoaDistDiff = to_float(&serial_msg[DATA_BYTE]);
-                        
-                        
-                        if (!is_init && (An == 0))
-                        {
-                            is_init = true;
-                        }
-                        
-                        if (is_init)
-                        {
-                            if (((Ar+1) & 0x7) == An)  //Check if sequential
-                            {
-                                tdoaVec[An] = tdoaDistDiff;
-                                if(An == 7) //got last anchor
-                                {
-                                    ros::Duration time_since_start = ros::Time::now() - time_start;
-                                    positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-                                    positionFile << std::setprecision(8) << vicon_position.x << ", " << vicon_position.y << ", " << vicon_position.z << ", ";
-                                    positionFile << std::setprecision(8) << tdoaVec[0] << ", " << tdoaVec[1] << ", " <<  tdoaVec[2] << ", " <<  tdoaVec[3] << ", " <<  tdoaVec[4] << ", " <<  tdoaVec[5] << ", " <<  tdoaVec[6] << ", " <<  tdoaVec[7] << "\r\n";
-                                }
-                            }
-                            else
-                            {
-                                //Lost a package, delete all data so far
-                                memset(tdoaVec, 0, sizeof(tdoaVec));
-                                is_init = false;
-                                std::cout << "Lost package " << +Ar << ", " << +An << std::endl;
-                            }
-                        }
-			            
-		            }
-                    RX_idx = 0;
-                }
+                addFrame(entry.frame, (entry.hostTime - time_start.toSec()) * 1e6);
             }
         }
-        else
+    }
+    std::cout << "Closed frame ring, " << ring.getLost() << " entries lost" << std::endl;
+}
+
+// Anchor layout stored in the capture header, same file as decaPos_node
+void initAnchors(tdoa_capture_header_t &header)
+{
+    std::string path = ros::package::getPath("decawave");
+    std::ifstream file( path+"/config/anchorPos.txt");
+    std::string str;
+    float x, y, z;
+    while (std::getline(file, str) && (header.anchorCount < TDOA_CAPTURE_MAX_ANCHORS))
+    {
+        if (sscanf(str.c_str(), "%f, %f, %f", &x,&y,&z) == 3)
         {
-            std::this_thread::sleep_for(std::chrono::microseconds(SLEEP_TIME_MICROS));
+            header.anchorPos[header.anchorCount][0] = x;
+            header.anchorPos[header.anchorCount][1] = y;
+            header.anchorPos[header.anchorCount][2] = z;
+            header.anchorCount++;
         }
-            
     }
-    
-    my_serial.close();
-    std::cout << "Closed serial" << std::endl;
 }
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
@@ -182,6 +190,17 @@ int main(int argc, char *argv[])
     nh.param<std::string>("deca_port", device_port, "/dev/ttyACM0");
     nh.param<std::string>("robot_type", robot_type, "quadcopter");
     nh.param<std::string>("vicon_obj", vicon_obj, "cyphyhousecopter");
+    nh.param<bool>("frame_ring", use_frame_ring, false); // Record from the ring of tag_reader, the port stays with decaPos_node
+    int metrics_port;
+    nh.param<int>("metrics_port", metrics_port, 0); // Prometheus endpoint, 0 disables
+
+    MetricsRegistry &metrics = MetricsRegistry::instance();
+    const std::string labels = metricLabel("port", device_port);
+    bytes_metric = &metrics.counter("tdoa_capture_serial_bytes_total", "Bytes read from the tag", labels);
+    frames_metric = &metrics.counter("tdoa_capture_frames_total", "Frames decoded from the tag", labels);
+    checksum_metric = &metrics.counter("tdoa_capture_checksum_errors_total", "Frames of the tag that failed their checksum", labels);
+    records_metric = &metrics.counter("tdoa_capture_records_total", "Rotations appended to the capture", labels);
+    const bool metrics_started = startMetricsServer(metrics_port);
 
     ros::Subscriber sub = nh.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
     
@@ -193,19 +212,39 @@ int main(int argc, char *argv[])
     timeinfo = localtime(&rawtime);
     strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
     
-    is_init = false;
+    memset(&rotation, 0, sizeof(rotation));
+    last_anc = TDOA_CAPTURE_MAX_ANCHORS;
+    lost_pairs = 0;
 
     std::cout << "Starting" << std::endl;
 
-    positionFile.open (std::string("/home/pi/tdoaData_")+time_buffer+".txt", std::ios::app);
+    tdoa_capture_header_t header = makeCaptureHeader();
+    initAnchors(header);
+    strncpy(header.robotType, robot_type.c_str(), sizeof(header.robotType) - 1);
+    strncpy(header.viconObj, vicon_obj.c_str(), sizeof(header.viconObj) - 1);
+    header.startTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    std::string capture_path = std::string("/home/pi/tdoaData_")+time_buffer+".tdc";
+    if (!captureFile.open(capture_path, header))
+    {
+        std::cout << "Could not create " << capture_path << std::endl;
+        return 1;
+    }
     time_start = ros::Time::now();
     
-    serial_thread = std::thread(serial_comm);
+    serial_thread = std::thread(use_frame_ring ? ring_comm : serial_comm);
     
     ros::spin();
     
     serial_thread.join();
+    if (metrics_started)
+    {
+        stopMetricsServer();
+    }
     
-    positionFile.close();
+    flushRotation();
+    captureFile.close();
+    std::cout << "Wrote " << captureFile.getRecordCount() << " records, dropped " << captureFile.getDropCount()
+              << ", " << lost_pairs << " non-sequential pairs" << std::endl;
 }
 
@@ -0,0 +1,329 @@
+/*************************************************
+ *
+ *  Synthetic TDOA stream generator for scale testing.
+ *  Either writes a tdoa_node style capture (.tdc) or text log for tdoa_bench, or opens one
+ *  pseudo terminal per simulated tag and streams encoded frames on it in real
+ *  time, so decaPos_node can be pointed at the printed device names.
+ *
+ *  Usage: tdoa_sim <anchor file> [options]
+ *      --out <file>          write a log instead of streaming, binary capture if it ends in .tdc
+ *      --tags <n>            number of fake serial devices (default 1)
+ *      --traj <file>         "t, x, y, z" trajectory, default is a circle
+ *      --duration <s>        simulated time (default 60)
+ *      --noise <m>           measurement noise
+ *      --drift <ppm>         residual anchor clock drift
+ *      --nlos <p>            NLOS probability per slot
+ *      --drop <p>            dropped slot probability
+ *      --seed <n>
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tdoa_protocol.h"
+#include "tdoa_sim.h"
+#include "tdoa_capture.h"
+
+#define SIM_CAPTURE_WAIT_MS 1000    // A rotation the capture writer has no room for this long is dropped
+
+typedef struct sim_options_s
+{
+    std::string anchorFile;
+    std::string outFile;
+    std::string trajFile;
+    int tags;
+    double duration;
+    tdoa_sim_config_t config;
+}sim_options_t;
+
+static void usage()
+{
+    printf("Usage: tdoa_sim <anchor file> [--out file | --tags n] [--traj file] [--duration s]\n"
+           "                [--noise m] [--drift ppm] [--nlos p] [--drop p] [--seed n]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], sim_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.tags = 1;
+    opt.duration = 60;
+    opt.config = defaultSimConfig();
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else if (arg == "--tags")
+        {
+            opt.tags = atoi(val.c_str());
+        }
+        else if (arg == "--traj")
+        {
+            opt.trajFile = val;
+        }
+        else if (arg == "--duration")
+        {
+            opt.duration = atof(val.c_str());
+        }
+        else if (arg == "--noise")
+        {
+            opt.config.measNoise = atof(val.c_str());
+        }
+        else if (arg == "--drift")
+        {
+            opt.config.clockDriftPpm = atof(val.c_str());
+        }
+        else if (arg == "--nlos")
+        {
+            opt.config.nlosProb = atof(val.c_str());
+        }
+        else if (arg == "--drop")
+        {
+            opt.config.dropProb = atof(val.c_str());
+        }
+        else if (arg == "--seed")
+        {
+            opt.config.seed = strtoul(val.c_str(), NULL, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return opt.tags > 0;
+}
+
+// Groups the pairs into rotations like tdoa_node and writes them as a .tdc capture or, for any other name, as text rows
+static int writeLog(TDOASimulator &sim, const anchor_layout_t &layout, const sim_options_t &opt)
+{
+    bool binary = (opt.outFile.size() > 4) && (opt.outFile.compare(opt.outFile.size() - 4, 4, ".tdc") == 0);
+
+    TDOACaptureWriter capture;
+    std::ofstream text;
+    if (binary)
+    {
+        tdoa_capture_header_t header = makeCaptureHeader();
+        header.anchorCount = layout.count;
+        for (int i = 0; i < layout.count; i++)
+        {
+            header.anchorPos[i][0] = layout.pos[i].x;
+            header.anchorPos[i][1] = layout.pos[i].y;
+            header.anchorPos[i][2] = layout.pos[i].z;
+        }
+        strncpy(header.robotType, "sim", sizeof(header.robotType) - 1);
+        if (!capture.open(opt.outFile, header))
+        {
+            printf("Could not create %s\n", opt.outFile.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        text.open(opt.outFile);
+        if (!text.is_open())
+        {
+            printf("Could not open %s\n", opt.outFile.c_str());
+            return 1;
+        }
+    }
+
+    tdoa_capture_record_t rotation;
+    memset(&rotation, 0, sizeof(rotation));
+    size_t rows = 0, dropped = 0;
+    // Writes the rotation being collected, if any, and starts the next one
+    auto flush = [&]() {
+        if (rotation.valid == 0)
+        {
+            return;
+        }
+        bool written;
+        if (binary)
+        {
+            // The writer drops when the disk falls behind, give it time as tdoa_node would
+            int waited = 0;
+            while (!(written = capture.append(rotation)) && (waited++ < SIM_CAPTURE_WAIT_MS))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        else
+        {
+            char row[512];
+            formatCaptureRow(rotation, row, sizeof(row));
+            written = (bool)(text << row);
+        }
+        if (written)
+        {
+            rows++;
+        }
+        else
+        {
+            dropped++;
+        }
+        memset(&rotation, 0, sizeof(rotation));
+    };
+
+    int last_anc = MAX_NR_ANCHORS;
+    double truth[3] = {0, 0, 0};
+    while (sim.getTime() < opt.duration)
+    {
+        tdoa_meas_t meas;
+        if (!sim.step(meas, truth))
+        {
+            continue;
+        }
+
+        uint64_t now_us = meas.timestamp * 1e6;
+        if (meas.An <= last_anc)
+        {
+            flush();
+        }
+        if (rotation.valid == 0)
+        {
+            rotation.timeUs = now_us;
+        }
+        rotation.valid |= 1u << meas.An;
+        rotation.tdoa[meas.An] = meas.distanceDiff;
+        rotation.ref[meas.An] = meas.Ar;
+        rotation.arrivalUs[meas.An] = now_us - rotation.timeUs;
+        for (int k = 0; k < 3; k++)
+        {
+            rotation.vicon[k] = truth[k];
+        }
+        last_anc = meas.An;
+    }
+    // The last rotation is cut by the end of the run, written partial as saveTDOA does on shutdown
+    flush();
+    capture.close();
+    text.close();
+
+    // The writer's own drop count also counts the attempts waited out above, so these are the rotations lost
+    printf("Wrote %zu rotations to %s, dropped %zu\n", rows, opt.outFile.c_str(), dropped);
+    return 0;
+}
+
+static int openFakeSerial(std::string &name)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0))
+    {
+        return -1;
+    }
+    name = ptsname(fd);
+    return fd;
+}
+
+// One simulator per tag, all stepped from this thread at the TDMA slot rate
+static int streamFrames(std::vector<TDOASimulator> &sims, const sim_options_t &opt)
+{
+    std::vector<int> fds;
+    for (size_t i = 0; i < sims.size(); i++)
+    {
+        std::string name;
+        int fd = openFakeSerial(name);
+        if (fd < 0)
+        {
+            printf("Could not open a pseudo terminal\n");
+            return 1;
+        }
+        fds.push_back(fd);
+        printf("tag%zu: %s\n", i, name.c_str());
+    }
+    fflush(stdout);
+
+    uint64_t sent = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t slot = 1; slot * opt.config.slotTime < opt.duration; slot++)
+    {
+        for (size_t i = 0; i < sims.size(); i++)
+        {
+            tdoa_meas_t meas;
+            double truth[3];
+            if (sims[i].step(meas, truth))
+            {
+                uint8_t msg[TDOA_FRAME_SIZE];
+                tdoa_frame_encode(msg, meas.Ar, meas.An, meas.distanceDiff);
+                // Nobody reading the slave yet is not an error, the frame is just lost like on a real port
+                if (write(fds[i], msg, TDOA_FRAME_SIZE) == TDOA_FRAME_SIZE)
+                {
+                    sent++;
+                }
+            }
+        }
+        std::this_thread::sleep_until(start + std::chrono::duration<double>(slot * opt.config.slotTime));
+    }
+    printf("Sent %llu frames\n", (unsigned long long)sent);
+
+    for (size_t i = 0; i < fds.size(); i++)
+    {
+        close(fds[i]);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    sim_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    anchor_layout_t layout;
+    if (!loadAnchorLayout(opt.anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+    if (layout.count > TDOA_CAPTURE_MAX_ANCHORS)
+    {
+        // The rotations are written in the capture layout
+        printf("Simulating the first %d of %d anchors\n", TDOA_CAPTURE_MAX_ANCHORS, layout.count);
+        layout.count = TDOA_CAPTURE_MAX_ANCHORS;
+    }
+
+    std::vector<sim_waypoint_t> traj;
+    if (!opt.trajFile.empty() && !loadTrajectory(opt.trajFile, traj))
+    {
+        printf("Could not read trajectory from %s\n", opt.trajFile.c_str());
+        return 1;
+    }
+
+    std::vector<TDOASimulator> sims;
+    for (int i = 0; i < (opt.outFile.empty() ? opt.tags : 1); i++)
+    {
+        tdoa_sim_config_t config = opt.config;
+        config.seed += i;
+        sims.push_back(TDOASimulator(layout, config));
+        sims.back().setTrajectory(traj);
+    }
+
+    if (!opt.outFile.empty())
+    {
+        return writeLog(sims[0], layout, opt);
+    }
+    return streamFrames(sims, opt);
+}
@@ -0,0 +1,383 @@
+/*************************************************
+ *
+ *  Post-processing of a run: streams a tdoa_node capture or log (or
+ *  simulated frames) through the filter as fast as possible, keeps the state
+ *  after every frame and smooths the whole run with the RTS backward pass,
+ *  see rts_smoother.h. Reports the position RMSE against the ground truth of
+ *  the filter, of the fixed-lag output decaPos_node gives with smoother_lag
+ *  and of the full smoother, and how many times faster than real time the
+ *  run was processed.
+ *
+ *  Usage: tdoa_smooth <anchor file> [options]
+ *      --log <file>          tdoa_node text log (tdoaData_*.txt)
+ *      --capture <file>      tdoa_node binary capture (tdoaData_*.tdc), uses its anchor layout
+ *                            and ignores the anchor file
+ *      --from <s> --to <s>   time window of the capture
+ *      --sim <frames>        TDOASimulator stream instead of a log
+ *      --std <m>             measurement standard deviation (default 0.15)
+ *      --qpos <v>            position process noise per PROCESS_NOISE_STEP (default 1e-7)
+ *      --qvel <v>            velocity process noise per PROCESS_NOISE_STEP (default 1e-5)
+ *      --robot <type>        car or quadcopter (default), car keeps z fixed
+ *      --lag <s>             delay of the fixed-lag output (default 0.5)
+ *      --out <file>          CSV of time, filtered and smoothed position and their standard deviations
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+#include "tdoa_sim.h"
+#include "rts_smoother.h"
+
+typedef struct smooth_options_s
+{
+    std::string anchorFile;
+    std::string logFile;
+    std::string captureFile;
+    std::string outFile;
+    std::string robotType;
+    double fromTime;
+    double toTime;
+    size_t simFrames;
+    float stdDev;
+    float qpos;
+    float qvel;
+    double lag;
+}smooth_options_t;
+
+static void usage()
+{
+    printf("Usage: tdoa_smooth <anchor file> [--log file | --capture file [--from s] [--to s] | --sim frames]\n"
+           "                   [--std m] [--qpos v] [--qvel v] [--robot car|quadcopter] [--lag s] [--out file]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], smooth_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.robotType = "quadcopter";
+    opt.fromTime = 0;
+    opt.toTime = 1e12;
+    opt.simFrames = 0;
+    opt.stdDev = 0.15f;
+    opt.qpos = 1e-7f;
+    opt.qvel = 1e-5f;
+    opt.lag = RTS_LAG;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--log")
+        {
+            opt.logFile = val;
+        }
+        else if (arg == "--capture")
+        {
+            opt.captureFile = val;
+        }
+        else if (arg == "--from")
+        {
+            opt.fromTime = atof(val.c_str());
+        }
+        else if (arg == "--to")
+        {
+            opt.toTime = atof(val.c_str());
+        }
+        else if (arg == "--sim")
+        {
+            opt.simFrames = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--std")
+        {
+            opt.stdDev = atof(val.c_str());
+        }
+        else if (arg == "--qpos")
+        {
+            opt.qpos = atof(val.c_str());
+        }
+        else if (arg == "--qvel")
+        {
+            opt.qvel = atof(val.c_str());
+        }
+        else if (arg == "--robot")
+        {
+            opt.robotType = val;
+        }
+        else if (arg == "--lag")
+        {
+            opt.lag = atof(val.c_str());
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    int sources = !opt.logFile.empty() + !opt.captureFile.empty() + (opt.simFrames > 0);
+    return (sources == 1) && (opt.stdDev > 0) && (opt.qpos >= 0) && (opt.qvel >= 0) && (opt.lag >= 0);
+}
+
+// Same diagonal model as the robot type, with the process noise of the options
+static rts_model_t makeModel(const smooth_options_t &opt)
+{
+    rts_model_t model;
+    for (int j = 0; j < 3; j++)
+    {
+        model.transition[j] = 1;
+        model.transition[j+3] = 1;
+        model.processNoise[j] = opt.qpos;
+        model.processNoise[j+3] = opt.qvel;
+    }
+    if (opt.robotType == "car")
+    {
+        model.transition[STATE_VZ] = 0;
+        model.processNoise[STATE_Z] = 0;
+        model.processNoise[STATE_VZ] = 0;
+    }
+    return model;
+}
+
+static void setupFilter(TDOA &ekf, const rts_model_t &model, const smooth_options_t &opt, const anchor_layout_t &layout)
+{
+    TDOA::DynamicMatrix A = TDOA::DynamicMatrix::Identity(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix Q = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    for (int j = 0; j < STATE_DIM; j++)
+    {
+        A(j,j) = model.transition[j];
+        Q(j,j) = model.processNoise[j];
+    }
+    ekf.setTransitionMat(A);
+    ekf.setCovarianceMat(Q);
+    ekf.setUpdateMode(TDOA_UPDATE_SPARSE);
+    ekf.setStdDev(opt.stdDev);
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+}
+
+typedef struct smooth_run_s
+{
+    StateSampleVector states;           // After each frame once bootstrapped
+    std::vector<Eigen::Vector3d> truth; // Per state, NaN without ground truth
+    size_t n_frames;
+    size_t n_updates;
+    bool bootstrapped;
+}smooth_run_t;
+
+static void filterFrame(TDOA &ekf, const tdoa_frame_record_t &rec, smooth_run_t &run)
+{
+    run.n_frames++;
+    if (!run.bootstrapped)
+    {
+        run.bootstrapped = ekf.initFromFrame(rec.meas, rec.count);
+        ekf.stateEstimatorPredictTo(rec.time);
+        return;
+    }
+    for (size_t k = 0; k < rec.count; k++)
+    {
+        const tdoa_meas_t &m = rec.meas[k];
+        ekf.stateEstimatorPredictTo(m.timestamp);
+        ekf.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+        run.n_updates++;
+    }
+    if ((rec.count == 0) || (run.states.size() > 0 && ekf.getTime() <= run.states.back().t))
+    {
+        return;
+    }
+
+    vec3d_t p = ekf.getLocation();
+    vec3d_t v = ekf.getVelocity();
+    StateSample sample;
+    sample.t = ekf.getTime();
+    sample.p << p.x, p.y, p.z;
+    sample.v << v.x, v.y, v.z;
+    sample.P = ekf.getCovariance().topLeftCorner<6, 6>().cast<double>();
+    run.states.push_back(sample);
+    run.truth.push_back(rec.hasTruth ? Eigen::Vector3d(rec.truth[0], rec.truth[1], rec.truth[2]) : Eigen::Vector3d::Constant(NAN));
+}
+
+typedef struct rmse_s
+{
+    double sq_err;
+    size_t n;
+}rmse_t;
+
+static void addError(rmse_t &e, const Eigen::Vector3d &p, const Eigen::Vector3d &truth)
+{
+    if (!std::isnan(truth.x()))
+    {
+        e.sq_err += (p - truth).squaredNorm();
+        e.n++;
+    }
+}
+
+static void printRMSE(const char *name, const rmse_t &e)
+{
+    printf("%-10s RMSE %.4f m over %zu states\n", name, (e.n > 0) ? sqrt(e.sq_err / e.n) : 0.0, e.n);
+}
+
+int main(int argc, char *argv[])
+{
+    smooth_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    anchor_layout_t layout;
+    if (opt.captureFile.empty() && !loadAnchorLayout(opt.anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+
+    TDOACaptureMap capture;
+    tdoa_capture_span_t span = {NULL, 0};
+    std::vector<tdoa_frame_record_t> frames;
+    if (opt.simFrames > 0)
+    {
+        TDOASimulator sim(layout, defaultSimConfig());
+        sim.generate(opt.simFrames, frames);
+    }
+    else if (!opt.captureFile.empty())
+    {
+        if (!capture.open(opt.captureFile))
+        {
+            printf("Could not read capture %s\n", opt.captureFile.c_str());
+            return 1;
+        }
+        captureLayout(capture.getHeader(), layout);
+        span = capture.window((uint64_t)(opt.fromTime * 1e6), (uint64_t)(std::min(opt.toTime, 1e12) * 1e6));
+    }
+    else if (!loadTextLog(opt.logFile, frames))
+    {
+        printf("Could not read log %s\n", opt.logFile.c_str());
+        return 1;
+    }
+    if (frames.empty() && (span.count == 0))
+    {
+        printf("No frames to smooth\n");
+        return 1;
+    }
+
+    const rts_model_t model = makeModel(opt);
+    TDOA ekf;
+    setupFilter(ekf, model, opt, layout);
+
+    smooth_run_t run;
+    run.states.reserve(frames.size() + span.count);
+    run.truth.reserve(frames.size() + span.count);
+    run.n_frames = 0;
+    run.n_updates = 0;
+    run.bootstrapped = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        filterFrame(ekf, frames[f], run);
+    }
+    for (const tdoa_capture_record_t &r : span)
+    {
+        tdoa_frame_record_t rec;
+        captureToFrame(r, rec);
+        filterFrame(ekf, rec, run);
+    }
+    auto filtered = std::chrono::steady_clock::now();
+    if (run.states.size() < 2)
+    {
+        printf("The filter never got going, nothing to smooth\n");
+        return 1;
+    }
+
+    // Fixed lag as decaPos_node runs it, one output per state that passed the lag
+    RTSSmoother fixedLag;
+    fixedLag.setModel(model);
+    fixedLag.setLag(opt.lag);
+    rmse_t lagError = {0, 0};
+    size_t next = 0;
+    for (size_t k = 0; k < run.states.size(); k++)
+    {
+        fixedLag.add(run.states[k]);
+        StateSample out;
+        if (fixedLag.output(out))
+        {
+            // Outputs keep the time of a state, find its truth
+            while ((next < run.states.size()) && (run.states[next].t < out.t))
+            {
+                next++;
+            }
+            addError(lagError, out.p, run.truth[next]);
+        }
+    }
+    auto lagged = std::chrono::steady_clock::now();
+
+    StateSampleVector smoothed = run.states;
+    RTSSmoother::smooth(smoothed, model);
+    auto stop = std::chrono::steady_clock::now();
+
+    rmse_t filterError = {0, 0}, smoothError = {0, 0};
+    for (size_t k = 0; k < run.states.size(); k++)
+    {
+        addError(filterError, run.states[k].p, run.truth[k]);
+        addError(smoothError, smoothed[k].p, run.truth[k]);
+    }
+
+    const double span_s = run.states.back().t - run.states.front().t;
+    const double filter_s = std::chrono::duration<double>(filtered - start).count();
+    const double lag_s = std::chrono::duration<double>(lagged - filtered).count();
+    const double smooth_s = std::chrono::duration<double>(stop - lagged).count();
+    printf("%zu frames, %zu measurement updates, %zu states over %.1f s\n", run.n_frames, run.n_updates, run.states.size(), span_s);
+    printf("Filter %.3f s, fixed lag %.3f s, full smoother %.3f s: %.0fx real time\n", filter_s, lag_s, smooth_s,
+           span_s / (filter_s + smooth_s));
+    if (filterError.n > 0)
+    {
+        printRMSE("filtered", filterError);
+        printRMSE("fixed lag", lagError);
+        printRMSE("smoothed", smoothError);
+    }
+    else
+    {
+        printf("No ground truth in the input, RMSE not available\n");
+    }
+
+    if (!opt.outFile.empty())
+    {
+        FILE *out = fopen(opt.outFile.c_str(), "w");
+        if (out == NULL)
+        {
+            printf("Could not write %s\n", opt.outFile.c_str());
+            return 1;
+        }
+        fprintf(out, "time, x, y, z, sx, sy, sz, smoothed_x, smoothed_y, smoothed_z, smoothed_sx, smoothed_sy, smoothed_sz\n");
+        for (size_t k = 0; k < run.states.size(); k++)
+        {
+            const StateSample &f = run.states[k], &s = smoothed[k];
+            fprintf(out, "%.6f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f\n", f.t,
+                    f.p.x(), f.p.y(), f.p.z(), sqrt(f.P(0,0)), sqrt(f.P(1,1)), sqrt(f.P(2,2)),
+                    s.p.x(), s.p.y(), s.p.z(), sqrt(s.P(0,0)), sqrt(s.P(1,1)), sqrt(s.P(2,2)));
+        }
+        fclose(out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,348 @@
+/*************************************************
+ *
+ *  Reference trajectory of a capture without Vicon: the batch least-squares
+ *  solver of trajectory_solver.h over all pairs of the capture, started from
+ *  the filter estimate smoothed by the RTS backward pass. Prints the cost per
+ *  iteration, the bias of every anchor pair and, where the input has ground
+ *  truth, the position RMSE of the filter, the smoother and the solution.
+ *
+ *  Usage: tdoa_trajectory <anchor file> [options]
+ *      --log <file>          tdoa_node text log (tdoaData_*.txt)
+ *      --capture <file>      tdoa_node binary capture (tdoaData_*.tdc), uses its anchor layout
+ *                            and ignores the anchor file
+ *      --from <s> --to <s>   time window of the capture
+ *      --sim <frames>        TDOASimulator stream instead of a log
+ *      --std <m>             pair noise, of the filter and the solver (default 0.15)
+ *      --accel <q>           white acceleration of the motion prior, m^2/s^3 (default 1)
+ *      --bias <m>            prior of the pair biases, 0 solves without biases (default 0.3)
+ *      --huber <k>           Huber threshold in stdDev, 0 for least squares (default 3)
+ *      --iterations <n>      Gauss-Newton iteration bound (default 20)
+ *      --threads <n>         assembly threads, 0 for one per core (default)
+ *      --out <file>          CSV of time, position and velocity of the solution
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+#include "tdoa_sim.h"
+#include "rts_smoother.h"
+#include "trajectory_solver.h"
+
+#define FILTER_QPOS     1e-7    // Process noise of the filter that seeds the solver
+#define FILTER_QVEL     1e-5
+
+typedef struct trajectory_options_s
+{
+    std::string anchorFile;
+    std::string logFile;
+    std::string captureFile;
+    std::string outFile;
+    double fromTime;
+    double toTime;
+    size_t simFrames;
+    trajectory_solver_config_t solver;
+}trajectory_options_t;
+
+static void usage()
+{
+    printf("Usage: tdoa_trajectory <anchor file> [--log file | --capture file [--from s] [--to s] | --sim frames]\n"
+           "                       [--std m] [--accel q] [--bias m] [--huber k] [--iterations n] [--threads n] [--out file]\n");
+}
+
+static bool parseArgs(int argc, char *argv[], trajectory_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.fromTime = 0;
+    opt.toTime = 1e12;
+    opt.simFrames = 0;
+    opt.solver = defaultTrajectoryConfig();
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--log")
+        {
+            opt.logFile = val;
+        }
+        else if (arg == "--capture")
+        {
+            opt.captureFile = val;
+        }
+        else if (arg == "--from")
+        {
+            opt.fromTime = atof(val.c_str());
+        }
+        else if (arg == "--to")
+        {
+            opt.toTime = atof(val.c_str());
+        }
+        else if (arg == "--sim")
+        {
+            opt.simFrames = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--std")
+        {
+            opt.solver.stdDev = atof(val.c_str());
+        }
+        else if (arg == "--accel")
+        {
+            opt.solver.accelNoise = atof(val.c_str());
+        }
+        else if (arg == "--bias")
+        {
+            opt.solver.biasStd = atof(val.c_str());
+        }
+        else if (arg == "--huber")
+        {
+            opt.solver.huber = atof(val.c_str());
+        }
+        else if (arg == "--iterations")
+        {
+            opt.solver.maxIterations = atoi(val.c_str());
+        }
+        else if (arg == "--threads")
+        {
+            opt.solver.threads = atoi(val.c_str());
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    int sources = !opt.logFile.empty() + !opt.captureFile.empty() + (opt.simFrames > 0);
+    return (sources == 1) && (opt.solver.stdDev > 0) && (opt.solver.accelNoise > 0) && (opt.solver.biasStd >= 0);
+}
+
+// A frame the filter produced a state for, with the pairs that went into it
+typedef struct trajectory_frame_s
+{
+    tdoa_frame_record_t rec;
+    StateSample state;
+}trajectory_frame_t;
+
+typedef std::vector<trajectory_frame_t, Eigen::aligned_allocator<trajectory_frame_t> > FrameVector;
+
+static void filterFrame(TDOA &ekf, const tdoa_frame_record_t &rec, bool &bootstrapped, FrameVector &out)
+{
+    if (!bootstrapped)
+    {
+        bootstrapped = ekf.initFromFrame(rec.meas, rec.count);
+        ekf.stateEstimatorPredictTo(rec.time);
+        return;
+    }
+    for (size_t k = 0; k < rec.count; k++)
+    {
+        ekf.stateEstimatorPredictTo(rec.meas[k].timestamp);
+        ekf.scalarTDOADistUpdate(rec.meas[k].Ar, rec.meas[k].An, rec.meas[k].distanceDiff);
+    }
+    if ((rec.count == 0) || (!out.empty() && (ekf.getTime() <= out.back().state.t)))
+    {
+        return;
+    }
+    trajectory_frame_t f;
+    f.rec = rec;
+    vec3d_t p = ekf.getLocation();
+    vec3d_t v = ekf.getVelocity();
+    f.state.t = ekf.getTime();
+    f.state.p << p.x, p.y, p.z;
+    f.state.v << v.x, v.y, v.z;
+    f.state.P = ekf.getCovariance().topLeftCorner<6, 6>().cast<double>();
+    out.push_back(f);
+}
+
+typedef struct rmse_s
+{
+    double sq_err;
+    size_t n;
+}rmse_t;
+
+static void addError(rmse_t &e, const Eigen::Vector3d &p, const tdoa_frame_record_t &rec)
+{
+    if (rec.hasTruth)
+    {
+        e.sq_err += (p - Eigen::Vector3d(rec.truth[0], rec.truth[1], rec.truth[2])).squaredNorm();
+        e.n++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    trajectory_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    anchor_layout_t layout;
+    if (opt.captureFile.empty() && !loadAnchorLayout(opt.anchorFile, layout))
+    {
+        printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+        return 1;
+    }
+
+    TDOACaptureMap capture;
+    tdoa_capture_span_t span = {NULL, 0};
+    std::vector<tdoa_frame_record_t> frames;
+    if (opt.simFrames > 0)
+    {
+        TDOASimulator sim(layout, defaultSimConfig());
+        sim.generate(opt.simFrames, frames);
+    }
+    else if (!opt.captureFile.empty())
+    {
+        if (!capture.open(opt.captureFile))
+        {
+            printf("Could not read capture %s\n", opt.captureFile.c_str());
+            return 1;
+        }
+        captureLayout(capture.getHeader(), layout);
+        span = capture.window((uint64_t)(opt.fromTime * 1e6), (uint64_t)(std::min(opt.toTime, 1e12) * 1e6));
+    }
+    else if (!loadTextLog(opt.logFile, frames))
+    {
+        printf("Could not read log %s\n", opt.logFile.c_str());
+        return 1;
+    }
+
+    // Seed: the filter over the whole input, smoothed
+    rts_model_t model;
+    TDOA::DynamicMatrix A = TDOA::DynamicMatrix::Identity(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix Q = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    for (int j = 0; j < 3; j++)
+    {
+        model.transition[j] = model.transition[j+3] = 1;
+        model.processNoise[j] = Q(j,j) = FILTER_QPOS;
+        model.processNoise[j+3] = Q(j+3,j+3) = FILTER_QVEL;
+    }
+    TDOA ekf;
+    ekf.setTransitionMat(A);
+    ekf.setCovarianceMat(Q);
+    ekf.setUpdateMode(TDOA_UPDATE_SPARSE);
+    ekf.setStdDev(opt.solver.stdDev);
+    for (int i = 0; i < layout.count; i++)
+    {
+        ekf.setAncPosition(i, layout.pos[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    FrameVector seeded;
+    seeded.reserve(frames.size() + span.count);
+    bool bootstrapped = false;
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        filterFrame(ekf, frames[f], bootstrapped, seeded);
+    }
+    for (const tdoa_capture_record_t &r : span)
+    {
+        tdoa_frame_record_t rec;
+        captureToFrame(r, rec);
+        filterFrame(ekf, rec, bootstrapped, seeded);
+    }
+    if (seeded.size() < 2)
+    {
+        printf("The filter never got going, nothing to solve\n");
+        return 1;
+    }
+    StateSampleVector smoothed(seeded.size());
+    for (size_t k = 0; k < seeded.size(); k++)
+    {
+        smoothed[k] = seeded[k].state;
+    }
+    RTSSmoother::smooth(smoothed, model);
+    auto seededTime = std::chrono::steady_clock::now();
+
+    TrajectorySolver solver(layout, opt.solver);
+    std::vector<size_t> nodeOf(seeded.size());
+    for (size_t k = 0; k < seeded.size(); k++)
+    {
+        solver.addNode(smoothed[k].t, seeded[k].rec.meas, seeded[k].rec.count, smoothed[k].p, smoothed[k].v);
+        nodeOf[k] = solver.getNodeCount() - 1;
+    }
+    const bool solved = solver.solve();
+    auto stop = std::chrono::steady_clock::now();
+
+    const double span_s = smoothed.back().t - smoothed.front().t;
+    printf("%zu nodes, %zu anchor pairs over %.1f s\n", solver.getNodeCount(), solver.getPairCount(), span_s);
+    const std::vector<trajectory_iteration_t> &iterations = solver.getIterations();
+    for (size_t i = 0; i < iterations.size(); i++)
+    {
+        printf("  iteration %2zu: cost %.1f  step %.4f  lambda %.0e  %.3f s\n", i + 1, iterations[i].cost,
+               iterations[i].stepNorm, iterations[i].lambda, iterations[i].seconds);
+    }
+    if (!solved)
+    {
+        printf("No step lowered the cost, the seed is kept\n");
+    }
+    printf("Seed %.3f s, solve %.3f s\n", std::chrono::duration<double>(seededTime - start).count(),
+           std::chrono::duration<double>(stop - seededTime).count());
+
+    for (size_t i = 0; i < solver.getPairCount(); i++)
+    {
+        int Ar, An;
+        double bias, mean, std;
+        size_t count;
+        solver.getPair(i, Ar, An, bias);
+        solver.getPairResiduals(i, count, mean, std);
+        printf("  pair %d-%d: bias %+.4f m, %zu residuals, mean %+.4f std %.4f m\n", Ar, An, bias, count, mean, std);
+    }
+
+    rmse_t filterError = {0, 0}, smoothError = {0, 0}, solveError = {0, 0};
+    for (size_t k = 0; k < seeded.size(); k++)
+    {
+        addError(filterError, seeded[k].state.p, seeded[k].rec);
+        addError(smoothError, smoothed[k].p, seeded[k].rec);
+        // Merged frames take the position of their node
+        addError(solveError, solver.getPosition(nodeOf[k]), seeded[k].rec);
+    }
+    if (filterError.n > 0)
+    {
+        printf("filtered   RMSE %.4f m\n", sqrt(filterError.sq_err / filterError.n));
+        printf("smoothed   RMSE %.4f m\n", sqrt(smoothError.sq_err / smoothError.n));
+        printf("batch      RMSE %.4f m over %zu frames\n", sqrt(solveError.sq_err / solveError.n), solveError.n);
+    }
+    else
+    {
+        printf("No ground truth in the input, RMSE not available\n");
+    }
+
+    if (!opt.outFile.empty())
+    {
+        FILE *out = fopen(opt.outFile.c_str(), "w");
+        if (out == NULL)
+        {
+            printf("Could not write %s\n", opt.outFile.c_str());
+            return 1;
+        }
+        fprintf(out, "time, x, y, z, vx, vy, vz\n");
+        for (size_t k = 0; k < solver.getNodeCount(); k++)
+        {
+            const Eigen::Vector3d p = solver.getPosition(k), v = solver.getVelocity(k);
+            fprintf(out, "%.6f, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f\n", solver.getTime(k), p.x(), p.y(), p.z(), v.x(), v.y(), v.z());
+        }
+        fclose(out);
+    }
+
+    return 0;
+}
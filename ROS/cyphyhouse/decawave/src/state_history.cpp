@@ -0,0 +1,81 @@
+/*************************************************
+ *
+ *  State history, see state_history.h
+ *
+ *************************************************/
+
+#include <cmath>
+
+#include "state_history.h"
+
+StateHistory::StateHistory() : head(0), count(0)
+{
+    noiseRate.setZero();
+}
+
+void StateHistory::setProcessNoise(const Eigen::Matrix<double, 6, 1> &rate)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    noiseRate = rate;
+}
+
+void StateHistory::add(const StateSample &sample)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((count > 0) && (sample.t <= ring[(head + STATE_HISTORY_SIZE - 1) % STATE_HISTORY_SIZE].t))
+    {
+        return;
+    }
+    ring[head] = sample;
+    head = (head + 1) % STATE_HISTORY_SIZE;
+    if (count < STATE_HISTORY_SIZE)
+    {
+        count++;
+    }
+}
+
+void StateHistory::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    count = 0;
+}
+
+bool StateHistory::at(double t, StateSample &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // Newest first, a query is usually close to now
+    for (size_t n = 1; n <= count; n++)
+    {
+        const StateSample &s = ring[(head + STATE_HISTORY_SIZE - n) % STATE_HISTORY_SIZE];
+        if (s.t <= t)
+        {
+            if ((n == 1) && (t - s.t > STATE_HISTORY_HORIZON))
+            {
+                return false;
+            }
+            out = propagate(s, t);
+            return true;
+        }
+    }
+    return false;
+}
+
+StateSample StateHistory::propagate(const StateSample &sample, double t) const
+{
+    const double dt = t - sample.t;
+    Eigen::Matrix<double, 6, 6> F = Eigen::Matrix<double, 6, 6>::Identity();
+    F.block<3,3>(0, 3) = dt * Eigen::Matrix3d::Identity();
+
+    StateSample out;
+    out.t = t;
+    out.p = sample.p + dt * sample.v;
+    out.v = sample.v;
+    out.P = F * sample.P * F.transpose();
+    out.P.diagonal() += std::fabs(dt) * noiseRate;
+    return out;
+}
@@ -0,0 +1,182 @@
+/*************************************************
+ *
+ *  Surveys the anchors from the ranges frames of a tag (USB_RANGES_EVERY in
+ *  its firmware), see anchor_survey.h. Listens for the given time, solves
+ *  and writes the layout in the anchorPos.txt format. Cells that cannot be
+ *  solved keep the layout of the hint file.
+ *
+ *  Usage: anchor_survey <port> [options]
+ *      --seconds <s>         listening time (default 20)
+ *      --out <file>          layout to write (default anchorPos_survey.txt)
+ *      --known <file>        "k: x, y, z" known anchor positions, "cell N" lines as in anchorPos.txt
+ *      --hint <file>         current layout, sets the frame of cells with fewer than 3 known points
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "serial/serial.h"
+#include "frame_decoder.h"
+#include "anchor_survey.h"
+
+#define SPEED         115200
+#define SERIAL_TIMEOUT_MS 100
+
+typedef struct survey_options_s
+{
+    std::string port;
+    double seconds;
+    std::string outFile;
+    std::string knownFile;
+    std::string hintFile;
+}survey_options_t;
+
+static void usage()
+{
+    printf("Usage: anchor_survey <port> [options]\n");
+    printf("    --seconds <s>         listening time (default 20)\n");
+    printf("    --out <file>          layout to write (default anchorPos_survey.txt)\n");
+    printf("    --known <file>        \"k: x, y, z\" known anchor positions\n");
+    printf("    --hint <file>         current layout, sets the frame of cells with fewer than 3 known points\n");
+}
+
+static bool parseArgs(int argc, char *argv[], survey_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.port = argv[1];
+    opt.seconds = 20;
+    opt.outFile = "anchorPos_survey.txt";
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        if (arg == "--seconds")
+        {
+            opt.seconds = atof(val.c_str());
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else if (arg == "--known")
+        {
+            opt.knownFile = val;
+        }
+        else if (arg == "--hint")
+        {
+            opt.hintFile = val;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    survey_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    AnchorSurvey survey;
+    std::vector<std::vector<vec3d_t> > layout(1);
+    if (!opt.knownFile.empty())
+    {
+        std::map<int, vec3d_t> known;
+        if (!loadKnownAnchors(opt.knownFile, known))
+        {
+            printf("Could not read %s\n", opt.knownFile.c_str());
+            return 1;
+        }
+        printf("%zu known points\n", known.size());
+        survey.setKnown(known);
+    }
+    if (!opt.hintFile.empty())
+    {
+        if (!readAnchorFile(opt.hintFile, layout))
+        {
+            printf("Could not read %s\n", opt.hintFile.c_str());
+            return 1;
+        }
+        survey.setHint(layout);
+    }
+
+    TDOAFrameDecoder decoder;
+    serial::Serial port(opt.port, SPEED, serial::Timeout::simpleTimeout(SERIAL_TIMEOUT_MS));
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration<double>(opt.seconds);
+    printf("Listening on %s for %.0f s\n", opt.port.c_str(), opt.seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        if (!port.waitReadable())
+        {
+            continue;
+        }
+        const size_t bytes_avail = port.available();
+        const size_t bytes_read = port.read(decoder.writePtr(), std::max<size_t>(1, std::min(bytes_avail, decoder.writeSpace())));
+        decoder.commit(bytes_read, [](const tdoa_frame_t &) {}, [&survey](const tdoa_ranges_t &ranges)
+        {
+            survey.addRanges(ranges);
+        });
+    }
+    port.close();
+
+    printf("%u ranges frames, %u ranges, %u outliers\n", decoder.getRangesFrames(), survey.getRanges(), survey.getRejected());
+    if (decoder.getRangesFrames() == 0)
+    {
+        printf("No ranges frames, is the tag firmware built with USB_RANGES_EVERY?\n");
+        return 1;
+    }
+
+    bool solved = false;
+    std::vector<SurveyCell> cells = survey.solve();
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        const SurveyCell &c = cells[i];
+        if (c.anchors.empty())
+        {
+            printf("cell %d: %d pairs, not solved, %s\n", c.cell, c.pairs, c.problem.c_str());
+            continue;
+        }
+        printf("cell %d: %zu anchors, %d pairs, residual rms %.3f m, max %.3f m\n", c.cell, c.anchors.size(), c.pairs,
+               c.rms, c.max_residual);
+        for (size_t k = 0; k < c.anchors.size(); k++)
+        {
+            printf("    %zu: %.3f, %.3f, %.3f\n", k, c.anchors[k].x, c.anchors[k].y, c.anchors[k].z);
+        }
+        if ((int)layout.size() <= c.cell)
+        {
+            layout.resize(c.cell + 1);
+        }
+        layout[c.cell] = c.anchors;
+        solved = true;
+    }
+    if (!solved)
+    {
+        return 1;
+    }
+
+    if (!writeAnchorFile(opt.outFile, layout))
+    {
+        printf("Could not write %s\n", opt.outFile.c_str());
+        return 1;
+    }
+    printf("Layout written to %s\n", opt.outFile.c_str());
+    return 0;
+}
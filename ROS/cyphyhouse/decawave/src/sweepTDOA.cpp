@@ -0,0 +1,430 @@
+/*************************************************
+ *
+ *  Parameter sweep for tuning the TDOA filter on recorded data.
+ *  Every parameter set is an independent job with its own filter; jobs run
+ *  on a work-stealing pool across all cores and only read the (shared,
+ *  memory-mapped) input. Results are ranked by RMSE against the Vicon column.
+ *
+ *  Usage: tdoa_sweep <anchor file> [options]
+ *      --capture <file> | --log <file> | --sim <frames>   input, as in tdoa_bench
+ *      --std <spec>          measurement standard deviation (m)
+ *      --qpos <spec>         position process noise per PROCESS_NOISE_STEP
+ *      --qvel <spec>         velocity process noise per PROCESS_NOISE_STEP
+ *      --pvel <spec>         initial velocity variance
+ *      --gate <spec>         innovation gate, 0 disables
+ *      --adapt <spec>        rate of the per-pair adaptive noise, 0 disables
+ *      --robot <type>        car or quadcopter (default), as initRobotMatrices
+ *      --random <n>          n random samples instead of the full grid
+ *      --threads <n>         default one per hardware thread
+ *      --top <n>             rows to print (default 10)
+ *      --out <file>          write every result as CSV
+ *
+ *  A spec is a value, min:max (two grid points) or min:max:n; random samples
+ *  only use the range. Spacing is geometric when both ends are positive and
+ *  linear otherwise, for the grid and the random samples alike.
+ *
+ *************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+
+#include "Eigen/Dense"
+#include "tdoa.h"
+#include "tdoa_replay.h"
+#include "tdoa_sim.h"
+#include "tdoa_capture.h"
+#include "work_pool.h"
+
+#define SWEEP_NPARAMS 6
+
+enum
+{
+    SWEEP_STD = 0,
+    SWEEP_QPOS,
+    SWEEP_QVEL,
+    SWEEP_PVEL,
+    SWEEP_GATE,
+    SWEEP_ADAPT,
+};
+
+static const char *param_names[SWEEP_NPARAMS] = {"std", "qpos", "qvel", "pvel", "gate", "adapt"};
+
+typedef struct range_spec_s
+{
+    double min;
+    double max;
+    int    n;
+}range_spec_t;
+
+typedef struct sweep_options_s
+{
+    std::string anchorFile;
+    std::string captureFile;
+    std::string logFile;
+    std::string outFile;
+    std::string robotType;
+    size_t simFrames;
+    range_spec_t spec[SWEEP_NPARAMS];
+    size_t randomSamples;
+    unsigned threads;
+    size_t top;
+}sweep_options_t;
+
+typedef struct sweep_result_s
+{
+    double param[SWEEP_NPARAMS];
+    double rmse;            // m, inf if the filter never bootstrapped or diverged
+    size_t frames;
+    uint32_t rejects;
+}sweep_result_t;
+
+// Input shared read-only by all jobs
+typedef struct sweep_input_s
+{
+    anchor_layout_t layout;
+    std::vector<tdoa_frame_record_t> frames;
+    tdoa_capture_span_t span;
+}sweep_input_t;
+
+static void usage()
+{
+    printf("Usage: tdoa_sweep <anchor file> [--capture file | --log file | --sim frames]\n"
+           "                  [--std spec] [--qpos spec] [--qvel spec] [--pvel spec] [--gate spec] [--adapt spec] [--robot type]\n"
+           "                  [--random n] [--threads n] [--top n] [--out file]\n"
+           "       spec is a value, min:max or min:max:n\n");
+}
+
+static bool parseSpec(const std::string &val, range_spec_t &spec)
+{
+    int fields = sscanf(val.c_str(), "%lf:%lf:%d", &spec.min, &spec.max, &spec.n);
+    if (fields == 1)
+    {
+        spec.max = spec.min;
+        spec.n = 1;
+    }
+    else if (fields == 2)
+    {
+        spec.n = 2;
+    }
+    return (fields >= 1) && (spec.n > 0);
+}
+
+static bool parseArgs(int argc, char *argv[], sweep_options_t &opt)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    opt.anchorFile = argv[1];
+    opt.robotType = "quadcopter";
+    opt.simFrames = 0;
+    opt.randomSamples = 0;
+    opt.threads = 0;
+    opt.top = 10;
+
+    // Defaults are the values decaPos_node ships with
+    range_spec_t defaults[SWEEP_NPARAMS] = {{0.15, 0.15, 1}, {0, 0, 1}, {0, 0, 1}, {1e-4, 1e-4, 1}, {0, 0, 1}, {0, 0, 1}};
+    memcpy(opt.spec, defaults, sizeof(defaults));
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        std::string arg = argv[i], val = argv[++i];
+        bool ok = true;
+        if (arg == "--capture")
+        {
+            opt.captureFile = val;
+        }
+        else if (arg == "--log")
+        {
+            opt.logFile = val;
+        }
+        else if (arg == "--sim")
+        {
+            opt.simFrames = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--robot")
+        {
+            opt.robotType = val;
+        }
+        else if (arg == "--random")
+        {
+            opt.randomSamples = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--threads")
+        {
+            opt.threads = atoi(val.c_str());
+        }
+        else if (arg == "--top")
+        {
+            opt.top = strtoul(val.c_str(), NULL, 10);
+        }
+        else if (arg == "--out")
+        {
+            opt.outFile = val;
+        }
+        else
+        {
+            ok = false;
+            for (int p = 0; p < SWEEP_NPARAMS; p++)
+            {
+                if (arg == std::string("--") + param_names[p])
+                {
+                    ok = parseSpec(val, opt.spec[p]);
+                }
+            }
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    int sources = !opt.captureFile.empty() + !opt.logFile.empty() + (opt.simFrames > 0);
+    return sources == 1;
+}
+
+static bool geometric(const range_spec_t &s)
+{
+    return (s.min > 0) && (s.max > 0);
+}
+
+static double gridValue(const range_spec_t &s, int k)
+{
+    if (s.n == 1)
+    {
+        return s.min;
+    }
+    double w = (double)k / (s.n - 1);
+    return geometric(s) ? s.min * pow(s.max / s.min, w) : s.min + w * (s.max - s.min);
+}
+
+static void buildJobs(const sweep_options_t &opt, std::vector<sweep_result_t> &jobs)
+{
+    if (opt.randomSamples > 0)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        for (size_t i = 0; i < opt.randomSamples; i++)
+        {
+            sweep_result_t job;
+            for (int p = 0; p < SWEEP_NPARAMS; p++)
+            {
+                const range_spec_t &s = opt.spec[p];
+                double w = uniform(gen);
+                job.param[p] = geometric(s) ? s.min * pow(s.max / s.min, w) : s.min + w * (s.max - s.min);
+            }
+            jobs.push_back(job);
+        }
+        return;
+    }
+
+    size_t total = 1;
+    for (int p = 0; p < SWEEP_NPARAMS; p++)
+    {
+        total *= opt.spec[p].n;
+    }
+    for (size_t i = 0; i < total; i++)
+    {
+        sweep_result_t job;
+        size_t rem = i;
+        for (int p = 0; p < SWEEP_NPARAMS; p++)
+        {
+            job.param[p] = gridValue(opt.spec[p], rem % opt.spec[p].n);
+            rem /= opt.spec[p].n;
+        }
+        jobs.push_back(job);
+    }
+}
+
+// Same bootstrap-then-update loop as tdoa_bench, one scalar update per pair
+static void runJob(const sweep_input_t &in, const std::string &robot, sweep_result_t &job)
+{
+    TDOA ekf;
+    TDOA::DynamicMatrix A = TDOA::DynamicMatrix::Identity(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix P = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    TDOA::DynamicMatrix Q = TDOA::DynamicMatrix::Zero(STATE_DIM, STATE_DIM);
+    P(0,0) = 10000;
+    P(1,1) = 10000;
+    P(2,2) = (robot == "car") ? 0 : 100;
+    P.bottomRightCorner(3, 3).diagonal().setConstant(job.param[SWEEP_PVEL]);
+    Q.topLeftCorner(3, 3).diagonal().setConstant(job.param[SWEEP_QPOS]);
+    Q.bottomRightCorner(3, 3).diagonal().setConstant(job.param[SWEEP_QVEL]);
+    if (robot == "car")
+    {
+        A(5,5) = 0; //No z velocity
+        P(5,5) = 0;
+        Q(2,2) = 0;
+        Q(5,5) = 0;
+    }
+    ekf.setTransitionMat(A);
+    ekf.setPredictionMat(P);
+    ekf.setCovarianceMat(Q);
+    ekf.setUpdateMode(TDOA_UPDATE_SPARSE);
+    ekf.setStdDev(job.param[SWEEP_STD]);
+    ekf.setGateThreshold(job.param[SWEEP_GATE]);
+    ekf.setAdaptiveNoise(job.param[SWEEP_ADAPT] > 0, job.param[SWEEP_ADAPT]);
+    for (int i = 0; i < in.layout.count; i++)
+    {
+        ekf.setAncPosition(i, in.layout.pos[i]);
+    }
+
+    double sq_err = 0;
+    size_t n_err = 0;
+    bool bootstrapped = false;
+    auto step = [&](const tdoa_frame_record_t &rec)
+    {
+        if (!bootstrapped)
+        {
+            bootstrapped = ekf.initFromFrame(rec.meas, rec.count);
+            ekf.stateEstimatorPredictTo(rec.time);
+            return;
+        }
+        for (size_t k = 0; k < rec.count; k++)
+        {
+            const tdoa_meas_t &m = rec.meas[k];
+            ekf.stateEstimatorPredictTo(m.timestamp);
+            ekf.scalarTDOADistUpdate(m.Ar, m.An, m.distanceDiff);
+        }
+        if (rec.hasTruth)
+        {
+            vec3d_t p = ekf.getLocation();
+            double ex = p.x - rec.truth[0], ey = p.y - rec.truth[1], ez = p.z - rec.truth[2];
+            sq_err += ex*ex + ey*ey + ez*ez;
+            n_err++;
+        }
+    };
+
+    for (size_t f = 0; f < in.frames.size(); f++)
+    {
+        step(in.frames[f]);
+    }
+    for (const tdoa_capture_record_t &r : in.span)
+    {
+        tdoa_frame_record_t rec;
+        captureToFrame(r, rec);
+        step(rec);
+    }
+
+    job.frames = n_err;
+    job.rmse = (n_err > 0) ? sqrt(sq_err / n_err) : INFINITY;
+    if (!std::isfinite(job.rmse))
+    {
+        job.rmse = INFINITY;
+    }
+    job.rejects = 0;
+    for (int i = 0; i < MAX_NR_ANCHORS; i++)
+    {
+        for (int j = 0; j < MAX_NR_ANCHORS; j++)
+        {
+            job.rejects += ekf.getRejectCount(i, j);
+        }
+    }
+}
+
+static void printRow(const sweep_result_t &r)
+{
+    for (int p = 0; p < SWEEP_NPARAMS; p++)
+    {
+        printf("%10.3e ", r.param[p]);
+    }
+    printf("%10.4f %8zu %8u\n", r.rmse, r.frames, r.rejects);
+}
+
+int main(int argc, char *argv[])
+{
+    sweep_options_t opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage();
+        return 1;
+    }
+
+    sweep_input_t in;
+    in.span.data = NULL;
+    in.span.count = 0;
+    TDOACaptureMap capture;
+    if (!opt.captureFile.empty())
+    {
+        if (!capture.open(opt.captureFile))
+        {
+            printf("Could not read capture %s\n", opt.captureFile.c_str());
+            return 1;
+        }
+        captureLayout(capture.getHeader(), in.layout);
+        in.span = capture.records();
+    }
+    else
+    {
+        if (!loadAnchorLayout(opt.anchorFile, in.layout))
+        {
+            printf("Could not read anchors from %s\n", opt.anchorFile.c_str());
+            return 1;
+        }
+        if (opt.simFrames > 0)
+        {
+            TDOASimulator sim(in.layout, defaultSimConfig());
+            sim.generate(opt.simFrames, in.frames);
+        }
+        else if (!loadTextLog(opt.logFile, in.frames))
+        {
+            printf("Could not read log %s\n", opt.logFile.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<sweep_result_t> jobs;
+    buildJobs(opt, jobs);
+
+    WorkStealingPool pool(opt.threads);
+    printf("%zu parameter sets on %zu frames, %u threads\n", jobs.size(), in.frames.size() + in.span.count, pool.size());
+
+    auto start = std::chrono::steady_clock::now();
+    pool.run(jobs.size(), [&](size_t i, unsigned)
+    {
+        runJob(in, opt.robotType, jobs[i]);
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Done in %.2f s\n\n", elapsed);
+
+    std::sort(jobs.begin(), jobs.end(), [](const sweep_result_t &a, const sweep_result_t &b){ return a.rmse < b.rmse; });
+
+    for (int p = 0; p < SWEEP_NPARAMS; p++)
+    {
+        printf("%10s ", param_names[p]);
+    }
+    printf("%10s %8s %8s\n", "rmse", "frames", "rejects");
+    for (size_t i = 0; i < std::min(opt.top, jobs.size()); i++)
+    {
+        printRow(jobs[i]);
+    }
+
+    if (!opt.outFile.empty())
+    {
+        FILE *out = fopen(opt.outFile.c_str(), "w");
+        if (out == NULL)
+        {
+            printf("Could not create %s\n", opt.outFile.c_str());
+            return 1;
+        }
+        fprintf(out, "std, qpos, qvel, pvel, gate, adapt, rmse, frames, rejects\n");
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            const sweep_result_t &r = jobs[i];
+            fprintf(out, "%.6g, %.6g, %.6g, %.6g, %.6g, %.6g, %.6g, %zu, %u\n", r.param[0], r.param[1], r.param[2],
+                    r.param[3], r.param[4], r.param[5], r.rmse, r.frames, r.rejects);
+        }
+        fclose(out);
+    }
+
+    return 0;
+}
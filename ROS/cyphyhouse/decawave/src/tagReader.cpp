@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "ros/ros.h"
+
+#include "serial/serial.h"
+#include "frame_decoder.h"
+#include "frame_ring.h"
+#include "tag_port.h"
+
+/*
+ * tag_reader owns the tag ports and decodes their frames once into the
+ * shared memory ring of each port (frame_ring.h). decaPos_node and tdoa_node
+ * with frame_ring set, and any tool with a FrameRingReader, read the rings
+ * in place of the ports, side by side.
+ */
+
+#define DEVICE        "/dev/ttyACM0"
+#define SPEED         115200
+#define SERIAL_TIMEOUT_MS 100       // Longest wait for data before rechecking ros::ok()
+#define COMMAND_GAP_MS 50           // The tag holds one USB command at a time
+
+std::string device_port, device_ports;
+int ring_capacity;
+int serial_baud;
+
+std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Decodes one port into its ring until the node shuts down
+void read_port(const std::string &port)
+{
+    FrameRingWriter ring;
+    std::string error;
+    if (!ring.create(frameRingName(port), ring_capacity, error))
+    {
+        ROS_ERROR("%s\n", error.c_str());
+        return;
+    }
+    ROS_INFO("%s -> %s\n", port.c_str(), frameRingName(port).c_str());
+
+    // Wall clock time the port went away, 0 before it was first opened
+    double lost = 0;
+    while (ros::ok())
+    {
+        // The ring keeps the name of the port, the tty it resolves to may change (tag_port.h)
+        TDOAFrameDecoder decoder;
+        std::unique_ptr<serial::Serial> my_serial;
+        std::string device;
+        uint64_t node = 0;
+        try
+        {
+            if (!resolveTagPort(port, device, error))
+            {
+                ROS_WARN_THROTTLE(10.0, "%s\n", error.c_str());
+                std::this_thread::sleep_for(std::chrono::milliseconds(TAG_PORT_REOPEN_MS));
+                continue;
+            }
+            my_serial.reset(new serial::Serial(device, serial_baud, serial::Timeout::simpleTimeout(SERIAL_TIMEOUT_MS)));
+            node = tagPortNode(device);
+        }
+        catch (const std::exception &e)
+        {
+            ROS_WARN_THROTTLE(10.0, "Cannot open %s: %s\n", device.c_str(), e.what());
+            std::this_thread::sleep_for(std::chrono::milliseconds(TAG_PORT_REOPEN_MS));
+            continue;
+        }
+        if (lost > 0)
+        {
+            ROS_INFO("%s reconnected after %.2f s\n", port.c_str(), ros::WallTime::now().toSec() - lost);
+        }
+
+        frame_ring_status_t status;
+        memset(&status, 0, sizeof(status));
+        uint32_t telemetry_frames = 0, position_frames = 0, sync_frames = 0;
+        uint8_t command[FRAME_RING_TX_SIZE];
+        auto next_command = std::chrono::steady_clock::now();
+
+        try
+        {
+            while (ros::ok())
+            {
+                // Commands of the readers, one per gap like sendTagConfig
+                if (std::chrono::steady_clock::now() >= next_command)
+                {
+                    const size_t size = ring.takeCommand(command);
+                    if (size > 0)
+                    {
+                        my_serial->write(command, size);
+                        next_command = std::chrono::steady_clock::now() + std::chrono::milliseconds(COMMAND_GAP_MS);
+                    }
+                }
+
+                // Blocks until data arrives or the timeout expires
+                if (!my_serial->waitReadable())
+                {
+                    // A dead descriptor of a quiet tag may never report an error
+                    if (tagPortNode(device) != node)
+                    {
+                        throw std::runtime_error(device + " went away");
+                    }
+                    continue;
+                }
+
+                // Read everything that is already waiting in one call
+                size_t bytes_avail = my_serial->available();
+                size_t bytes_read = my_serial->read(decoder.writePtr(), std::max<size_t>(1, std::min(bytes_avail, decoder.writeSpace())));
+                const double now = ros::Time::now().toSec();
+
+                decoder.commit(bytes_read, [&ring, now](const tdoa_frame_t &frame)
+                {
+                    ring.publish(FRAME_RING_TDOA, now, &frame, sizeof(frame));
+                }, [&ring, now](const tdoa_ranges_t &ranges)
+                {
+                    ring.publish(FRAME_RING_RANGES, now, &ranges, sizeof(ranges));
+                });
+
+                if ((decoder.getTagStatus().rxDropped != status.tag.rxDropped) || (decoder.getTagStatus().outDropped != status.tag.outDropped)
+                    || (decoder.getLostPackets() != status.lostPackets))
+                {
+                    status.tag = decoder.getTagStatus();
+                    status.lostPackets = decoder.getLostPackets();
+                    ring.publish(FRAME_RING_STATUS, now, &status, sizeof(status));
+                }
+                if (decoder.getTelemetryFrames() != telemetry_frames)
+                {
+                    telemetry_frames = decoder.getTelemetryFrames();
+                    ring.publish(FRAME_RING_TELEMETRY, now, &decoder.getTelemetry(), sizeof(tdoa_telemetry_t));
+                }
+                if (decoder.getPositionFrames() != position_frames)
+                {
+                    position_frames = decoder.getPositionFrames();
+                    ring.publish(FRAME_RING_POSITION, now, &decoder.getPosition(), sizeof(tdoa_position_t));
+                }
+                if (decoder.getSyncFrames() != sync_frames)
+                {
+                    sync_frames = decoder.getSyncFrames();
+                    ring.publish(FRAME_RING_SYNC, now, &decoder.getSync(), sizeof(tdoa_sync_t));
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // Unplugged, the readers keep their ring and see the frames again once it is back
+            ROS_WARN("%s: %s\n", port.c_str(), e.what());
+            lost = ros::WallTime::now().toSec();
+        }
+        my_serial->close();
+    }
+    std::cout << "Closed serial " << port << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    ros::init(argc, argv, "tag_reader");
+    ros::NodeHandle nh("~");
+
+    nh.param<std::string>("deca_port", device_port, DEVICE);
+    nh.param<std::string>("deca_ports", device_ports, device_port); // Comma separated, one ring per port, serial:<number> for a tag by its USB serial number
+    nh.param<int>("ring_capacity", ring_capacity, FRAME_RING_CAPACITY); // Entries per ring, power of two
+    nh.param<int>("baud", serial_baud, SPEED); // Line rate of tags on a serial line (TAG_OUTPUT_USART), USB ports ignore it
+
+    std::vector<std::thread> readers;
+    for (const std::string &port : splitList(device_ports))
+    {
+        readers.push_back(std::thread(read_port, port));
+    }
+
+    ros::spin();
+
+    for (size_t i = 0; i < readers.size(); i++)
+    {
+        readers[i].join();
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*************************************************
+ *
+ *  Host time of the tag clock, see tag_clock_sync.h
+ *
+ *************************************************/
+
+#include <cmath>
+
+#include "tag_clock_sync.h"
+#include "tdoa_time.h"
+#include "tdoa_clock.h"
+
+TagClockSync::TagClockSync()
+{
+    reset();
+}
+
+void TagClockSync::reset()
+{
+    synced = false;
+    lastTag = 0;
+    tagTime = 0;
+    lastRead = 0;
+    head = 0;
+    count = 0;
+    blockStart = 0;
+    aboveSince = -1;
+    fitTag = 0;
+    offset = 0;
+    drift = 0;
+    excess = 0;
+}
+
+void TagClockSync::addSync(uint64_t tag, double read)
+{
+    // Longer gaps may hide a wrap of the 40-bit clock
+    if (synced && (read - lastRead > CLOCK_SYNC_GAP))
+    {
+        reset();
+    }
+    if (!synced)
+    {
+        synced = true;
+        lastTag = tag;
+        lastRead = read;
+        blocks[0].tag = 0;
+        blocks[0].offset = read;
+        count = 1;
+        fitTag = 0;
+        offset = read;
+        return;
+    }
+
+    tagTime += tdoa_time_sub(tag, lastTag) / TDOA_TIMESTAMP_FREQ;
+    lastTag = tag;
+    lastRead = read;
+
+    // A transfer is never faster than the fit, an offset well below it is a restarted tag
+    const double o = read - tagTime;
+    const double predicted = offset + drift * (tagTime - fitTag);
+    if (o < predicted - CLOCK_SYNC_STEP)
+    {
+        reset();
+        addSync(tag, read);
+        return;
+    }
+    // Slow reads are normal, a whole block of them is not
+    if (o > predicted + CLOCK_SYNC_STEP)
+    {
+        if (aboveSince < 0)
+        {
+            aboveSince = read;
+        }
+        else if (read - aboveSince > CLOCK_SYNC_BLOCK)
+        {
+            reset();
+            addSync(tag, read);
+            return;
+        }
+    }
+    else
+    {
+        aboveSince = -1;
+    }
+
+    if (tagTime - blockStart >= CLOCK_SYNC_BLOCK)
+    {
+        head = (head + 1) % CLOCK_SYNC_BLOCKS;
+        count = (count < CLOCK_SYNC_BLOCKS) ? count + 1 : count;
+        blocks[head].tag = tagTime;
+        blocks[head].offset = o;
+        blockStart = tagTime;
+    }
+    else if (o < blocks[head].offset)
+    {
+        blocks[head].tag = tagTime;
+        blocks[head].offset = o;
+    }
+
+    fit();
+    excess = o - (offset + drift * (tagTime - fitTag));
+}
+
+/*
+ * Least squares line through the minima of the completed blocks. The block
+ * being filled has not seen its fastest transfer yet and only counts while
+ * it is the single one.
+ */
+void TagClockSync::fit()
+{
+    size_t lowest = head;
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t b = (head + CLOCK_SYNC_BLOCKS - i) % CLOCK_SYNC_BLOCKS;
+        if (blocks[b].offset < blocks[lowest].offset)
+        {
+            lowest = b;
+        }
+    }
+
+    drift = 0;
+    if (count >= 3)
+    {
+        double st = 0, so = 0;
+        for (size_t i = 1; i < count; i++)
+        {
+            const size_t b = (head + CLOCK_SYNC_BLOCKS - i) % CLOCK_SYNC_BLOCKS;
+            st += blocks[b].tag;
+            so += blocks[b].offset;
+        }
+        const double n = count - 1;
+        const double meanTag = st / n, meanOffset = so / n;
+        double stt = 0, sto = 0;
+        for (size_t i = 1; i < count; i++)
+        {
+            const size_t b = (head + CLOCK_SYNC_BLOCKS - i) % CLOCK_SYNC_BLOCKS;
+            stt += (blocks[b].tag - meanTag) * (blocks[b].tag - meanTag);
+            sto += (blocks[b].tag - meanTag) * (blocks[b].offset - meanOffset);
+        }
+        if ((stt > 0) && (std::fabs(sto / stt) <= CLOCK_SYNC_MAX_DRIFT))
+        {
+            fitTag = meanTag;
+            offset = meanOffset;
+            drift = sto / stt;
+            return;
+        }
+    }
+
+    fitTag = blocks[lowest].tag;
+    offset = blocks[lowest].offset;
+}
+
+double TagClockSync::toHost(uint64_t tag) const
+{
+    const double t = tagTime + tdoa_time_sub(tag, lastTag) / TDOA_TIMESTAMP_FREQ;
+    return t + offset + drift * (t - fitTag);
+}
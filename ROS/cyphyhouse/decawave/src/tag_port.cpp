@@ -0,0 +1,102 @@
+/*************************************************
+ *
+ *  Stable names of tag ports, see tag_port.h
+ *
+ *************************************************/
+
+#include "tag_port.h"
+
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*
+ * Serial number of the USB device of tty. For ttyACM the device of the tty
+ * is the USB interface, for ttyUSB the port of the usb-serial driver below
+ * it, so the path is walked up to the first directory with an idVendor,
+ * the USB device that holds the serial attribute.
+ */
+static std::string usbSerial(const std::string &tty)
+{
+    char path[PATH_MAX];
+    if (!realpath((std::string(TAG_PORT_SYSFS) + "/" + tty + "/device").c_str(), path))
+    {
+        return "";
+    }
+    std::string dir = path;
+    struct stat st;
+    while (stat((dir + "/idVendor").c_str(), &st) != 0)
+    {
+        const size_t slash = dir.find_last_of('/');
+        if ((slash == std::string::npos) || (slash == 0))
+        {
+            return "";
+        }
+        dir.erase(slash);
+    }
+    std::ifstream in(dir + "/serial");
+    std::string serial;
+    std::getline(in, serial);
+    serial.erase(serial.find_last_not_of(" \t\r\n") + 1);
+    return serial;
+}
+
+static bool isTagTty(const std::string &name)
+{
+    return (name.compare(0, 6, "ttyACM") == 0) || (name.compare(0, 6, "ttyUSB") == 0);
+}
+
+bool resolveTagPort(const std::string &port, std::string &device, std::string &error)
+{
+    const std::string prefix = TAG_PORT_SERIAL_PREFIX;
+    if (port.compare(0, prefix.size(), prefix) == 0)
+    {
+        const std::string wanted = port.substr(prefix.size());
+        DIR *dir = opendir(TAG_PORT_SYSFS);
+        if (!dir)
+        {
+            error = "Cannot list " TAG_PORT_SYSFS " for " + port;
+            return false;
+        }
+        bool found = false;
+        while (struct dirent *entry = readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (isTagTty(name) && (usbSerial(name) == wanted))
+            {
+                device = "/dev/" + name;
+                found = true;
+                break;
+            }
+        }
+        closedir(dir);
+        if (!found)
+        {
+            error = "No tag with serial number " + wanted;
+        }
+        return found;
+    }
+
+    // The node a by-id link points at now, the link itself moves with the tag
+    char path[PATH_MAX];
+    if (!realpath(port.c_str(), path))
+    {
+        error = port + " does not exist";
+        return false;
+    }
+    device = path;
+    return true;
+}
+
+uint64_t tagPortNode(const std::string &device)
+{
+    struct stat st;
+    if (stat(device.c_str(), &st) != 0)
+    {
+        return 0;
+    }
+    // The inode changes when the node is created anew, the device number when the name goes to another tty
+    return ((uint64_t)st.st_ino << 20) ^ (uint64_t)st.st_rdev;
+}
@@ -0,0 +1,870 @@
+/*************************************************
+ *
+ *  Discrete-event emulator of a TDOA network, see tdma_netsim.h
+ *
+ *************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "tdma_netsim.h"
+#include "tdoa_time.h"
+#include "tdoa_clock.h"
+
+// Frame of a range packet of n anchor addresses with e entries, RANGE_FRAME_LENGTH of tdoa_anc.h
+static inline uint16_t rangeFrameLength(uint8_t n, uint8_t e)
+{
+    return NETSIM_MAC_HEADER_LENGTH + TDOA_RANGE_PAYLOAD_SIZE(n, e) + NETSIM_FRAME_CRC;
+}
+
+// The local clocks here do not wrap, this is the rounding of tdoa_time_delayed_tx on their low 40 bits
+static inline int64_t delayedTx(int64_t t)
+{
+    const int64_t tx = (t & ~(int64_t)TDOA_TIME_MASK) + (int64_t)tdoa_time_delayed_tx(t & TDOA_TIME_MASK);
+    return (tx < t) ? tx + (1LL << TDOA_TIME_BITS) : tx;
+}
+
+netsim_config_t defaultNetSimConfig()
+{
+    netsim_config_t config;
+    config.addresses = NETSIM_DEFAULT_SLOTS;
+    config.cells = 1;
+    config.cellSpacing = 0;
+    config.phy = TDOA_PHY_STANDARD;
+    config.baseChan = 5;
+    config.clockPpm = 10;
+    config.clockWalkPpm = 0.01;
+    config.rxNoise = NETSIM_SYNC_MEAS_NOISE;
+    config.lossProb = 0.01;
+    config.range = 30;
+    config.startSpread = 1;
+    config.seed = 42;
+    return config;
+}
+
+/*
+ * Copies of the layout along x, a spacing of 0 puts them side by side 2 m
+ * apart. Every cell gets the radio of tdoa_cell_radio, the anchors power up
+ * at random within startSpread with a random clock.
+ */
+TDMANetSim::TDMANetSim(const anchor_layout_t &layout, const netsim_config_t &config)
+    : config(config), gen(config.seed), normal(0, 1), uniform(0, 1)
+{
+    seq = 0;
+    now = 0;
+    packetBase = 0;
+
+    // tdoa_init
+    txLead = (int64_t)(NETSIM_GUARD_LENGTH_NS * 499.2e-3 * 128) + (int64_t)(preambleTimeNs() * (499.2 * 128) / 1000);
+    preambleTime = preambleTimeNs() * 1e-9;
+    const uint32_t window = (NETSIM_GUARD_LENGTH_NS + frameTimeNs(rangeFrameLength(TDOA_MAX_ANCHORS, TDOA_MAX_ANCHORS - 1)) + NETSIM_MARGIN_NS) * 39ull / 40000 + 1;
+    rxTimeout = (window > 0xFFFF) ? 0xFFFF : window;
+    // A frame only collides with frames ending after it started, so it is kept for the longest frame after its end
+    packetKeep = frameTimeNs(rangeFrameLength(TDOA_MAX_ANCHORS, TDOA_MAX_ANCHORS - 1)) * 1e-9 + 1e-6;
+    defaultSlotUnits = tdmaSlotUnits(config.addresses);
+
+    float xmin = layout.pos[0].x, xmax = layout.pos[0].x;
+    for (int i = 1; i < layout.count; i++)
+    {
+        xmin = std::min(xmin, layout.pos[i].x);
+        xmax = std::max(xmax, layout.pos[i].x);
+    }
+    const double spacing = (config.cellSpacing > 0) ? config.cellSpacing : (xmax - xmin + 2.0);
+
+    for (int c = 0; c < config.cells; c++)
+    {
+        uint8_t chan, code;
+        tdoa_cell_radio(c, config.baseChan, TDOA_PHY_TABLE[config.phy].prf64, &chan, &code);
+
+        for (int i = 0; i < layout.count; i++)
+        {
+            anchor_t a;
+            memset(&a, 0, sizeof(a));
+            a.pos = layout.pos[i];
+            a.pos.x += c * spacing;
+            a.cell = c;
+            a.radio = (chan << 8) | code;
+            a.anchorId = i;
+            a.clockLocal = uniform(gen) * TDOA_TIME_MASK;
+            a.ppm = config.clockPpm * normal(gen);
+            anchors.push_back(a);
+            schedule(config.startSpread * uniform(gen), EV_POWER_ON, anchors.size() - 1, 0);
+        }
+    }
+
+    netsim_cell_stats_t empty;
+    memset(&empty, 0, sizeof(empty));
+    cellStats.assign(config.cells, empty);
+}
+
+void TDMANetSim::addTags(int count)
+{
+    vec3d_t lo = anchors[0].pos, hi = anchors[0].pos;
+    for (size_t i = 1; i < anchors.size(); i++)
+    {
+        lo.x = std::min(lo.x, anchors[i].pos.x);
+        lo.y = std::min(lo.y, anchors[i].pos.y);
+        hi.x = std::max(hi.x, anchors[i].pos.x);
+        hi.y = std::max(hi.y, anchors[i].pos.y);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        tag_t t;
+        memset(&t, 0, sizeof(t));
+        t.pos.x = lo.x + (hi.x - lo.x) * uniform(gen);
+        t.pos.y = lo.y + (hi.y - lo.y) * uniform(gen);
+        t.pos.z = 1.0f;
+        t.lastSender = -1;
+
+        size_t nearest = 0;
+        for (size_t a = 1; a < anchors.size(); a++)
+        {
+            if (distance(anchors[a].pos, t.pos) < distance(anchors[nearest].pos, t.pos))
+            {
+                nearest = a;
+            }
+        }
+        t.cell = anchors[nearest].cell;
+        t.radio = anchors[nearest].radio;
+        tags.push_back(t);
+    }
+}
+
+void TDMANetSim::addOutage(const netsim_outage_t &outage)
+{
+    schedule(outage.off, EV_POWER_OFF, outage.anchor, 0);
+    if (outage.on > outage.off)
+    {
+        schedule(outage.on, EV_POWER_ON, outage.anchor, 0);
+    }
+}
+
+void TDMANetSim::run(double until)
+{
+    while (!events.empty() && (events.top().t <= until))
+    {
+        const event_t e = events.top();
+        events.pop();
+        now = e.t;
+        handle(e);
+    }
+    now = until;
+
+    // Synchronized time up to here, the anchors go on from it in the next run
+    for (size_t a = 0; a < anchors.size(); a++)
+    {
+        if (anchors[a].synchronized)
+        {
+            anchors[a].stats.syncedTime += now - anchors[a].syncedSince;
+            anchors[a].syncedSince = now;
+        }
+    }
+}
+
+double TDMANetSim::getSlotTime() const
+{
+    return (double)((uint64_t)defaultSlotUnits << TDOA_SLOT_UNIT_SHIFT) / NETSIM_TICKS_PER_S;
+}
+
+bool TDMANetSim::isMaster(int a) const
+{
+    return anchors[a].powered && anchors[a].synchronized && (anchors[a].ownSlot == 0);
+}
+
+void TDMANetSim::schedule(double t, int type, int node, uint64_t arg)
+{
+    event_t e;
+    e.t = t;
+    e.seq = seq++;
+    e.type = type;
+    e.node = node;
+    e.arg = arg;
+    events.push(e);
+}
+
+void TDMANetSim::handle(const event_t &e)
+{
+    if (e.type == EV_ARRIVAL)
+    {
+        arrival(e.node, e.arg);
+        return;
+    }
+
+    anchor_t &a = anchors[e.node];
+    switch (e.type)
+    {
+        case EV_POWER_ON:
+            powerOn(e.node);
+            break;
+        case EV_POWER_OFF:
+            setSynchronized(a, false);
+            a.powered = false;
+            a.rxOpen = false;
+            a.epoch++;
+            break;
+        case EV_TX_DONE:
+            if (a.powered && (e.arg == a.epoch))
+            {
+                advanceClock(a);
+                txDone(e.node);
+            }
+            break;
+        case EV_RX_TIMEOUT:
+            if (a.powered && a.rxOpen && (e.arg == a.epoch))
+            {
+                advanceClock(a);
+                a.rxOpen = false;
+                a.stats.rxTimeout++;
+                rxFailed(e.node, RX_TO);
+            }
+            break;
+    }
+}
+
+int64_t TDMANetSim::localAt(const anchor_t &a, double t) const
+{
+    return (int64_t)llround(a.clockLocal + (t - a.clockTrue) * NETSIM_TICKS_PER_S * (1 + a.ppm * 1e-6));
+}
+
+double TDMANetSim::trueAt(const anchor_t &a, int64_t local) const
+{
+    return a.clockTrue + (local - a.clockLocal) / (NETSIM_TICKS_PER_S * (1 + a.ppm * 1e-6));
+}
+
+// Moves the clock reference of an anchor up to now and lets its crystal wander since the last one
+void TDMANetSim::advanceClock(anchor_t &a)
+{
+    const double dt = now - a.clockTrue;
+    if (dt <= 0)
+    {
+        return;
+    }
+    a.clockLocal += dt * NETSIM_TICKS_PER_S * (1 + a.ppm * 1e-6);
+    a.clockTrue = now;
+    a.ppm += config.clockWalkPpm * sqrt(dt) * normal(gen);
+}
+
+double TDMANetSim::distance(const vec3d_t &a, const vec3d_t &b) const
+{
+    const double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+TDMANetSim::packet_t *TDMANetSim::packet(uint64_t id)
+{
+    if ((id < packetBase) || (id - packetBase >= packets.size()))
+    {
+        return NULL;
+    }
+    return &packets[id - packetBase];
+}
+
+/*
+ * Delayed transmission of the range packet of anchor a with its RMARKER at
+ * the local time txTime. A time already passed fails as dwt_starttx does and
+ * the anchor listens instead. Every receiver on the radio of the cell within
+ * range gets an arrival at the end of the frame.
+ */
+void TDMANetSim::startTx(int a, int64_t txTime)
+{
+    anchor_t &an = anchors[a];
+    const double rmarker = trueAt(an, txTime);
+
+    if (rmarker - preambleTime < now)
+    {
+        an.stats.lateTx++;
+        startRx(a, 0, true);
+        return;
+    }
+
+    while (!packets.empty() && (packets.front().start + packets.front().airtime + packetKeep < now))
+    {
+        packets.pop_front();
+        packetBase++;
+    }
+
+    packet_t p;
+    p.sender = a;
+    p.addr = an.anchorId;
+    p.cell = an.cell;
+    p.radio = an.radio;
+    p.rmarker = rmarker;
+    p.start = rmarker - preambleTime;
+    p.idx = an.idx;
+    p.anchors = an.anchors;
+    p.slotUnits = an.slotUnits;
+    p.active = an.active;
+    p.join = an.join;
+    p.entries = an.rxValid & ~(1u << an.anchorId) & ((1u << an.anchors) - 1);
+    p.airtime = frameTimeNs(rangeFrameLength(p.anchors, __builtin_popcount(p.entries))) * 1e-9;
+    packets.push_back(p);
+    const uint64_t id = packetBase + packets.size() - 1;
+
+    an.stats.tx++;
+    cellStats[an.cell].tx++;
+    cellStats[an.cell].airtime += p.airtime;
+    cellStats[an.cell].slotTime += an.slotLen / NETSIM_TICKS_PER_S;
+
+    an.rxOpen = false;
+    schedule(p.start + p.airtime, EV_TX_DONE, a, ++an.epoch);
+
+    for (size_t b = 0; b < anchors.size(); b++)
+    {
+        const double d = distance(an.pos, anchors[b].pos);
+        if (((int)b != a) && (anchors[b].radio == p.radio) && (d <= config.range))
+        {
+            schedule(p.start + d / TDOA_SPEED_OF_LIGHT + p.airtime, EV_ARRIVAL, b, id);
+        }
+    }
+    for (size_t t = 0; t < tags.size(); t++)
+    {
+        const double d = distance(an.pos, tags[t].pos);
+        if ((tags[t].radio == p.radio) && (d <= config.range))
+        {
+            schedule(p.start + d / TDOA_SPEED_OF_LIGHT + p.airtime, EV_ARRIVAL, anchors.size() + t, id);
+        }
+    }
+}
+
+// Receive window of rxTimeout from the local time rxTime, from now if immediate or if rxTime passed already
+void TDMANetSim::startRx(int a, int64_t rxTime, bool immediate)
+{
+    anchor_t &an = anchors[a];
+    const double open = immediate ? now : std::max(now, trueAt(an, rxTime));
+
+    an.rxOpen = true;
+    an.rxStart = open;
+    schedule(open + rxTimeout * NETSIM_RX_TIMEOUT_UNIT, EV_RX_TIMEOUT, a, ++an.epoch);
+}
+
+// Another frame on the radio of p overlapping it at pos from start to end
+bool TDMANetSim::collided(const packet_t &p, const vec3d_t &pos, int self, double start, double end) const
+{
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        const packet_t &q = packets[i];
+        if ((&q == &p) || (q.radio != p.radio) || (q.sender == self))
+        {
+            continue;
+        }
+        const double d = distance(anchors[q.sender].pos, pos);
+        const double qs = q.start + d / TDOA_SPEED_OF_LIGHT;
+        if ((d <= config.range) && (qs < end) && (qs + q.airtime > start))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// End of frame id at a receiver, the frame is received if the window was open from its start on
+void TDMANetSim::arrival(int node, uint64_t id)
+{
+    const packet_t *found = packet(id);
+    if (found == NULL)
+    {
+        return;
+    }
+    // Transmissions below may drop old packets from the queue
+    const packet_t p = *found;
+
+    if (node >= (int)anchors.size())
+    {
+        tagRx(tags[node - anchors.size()], *found);
+        return;
+    }
+
+    anchor_t &an = anchors[node];
+    const double d = distance(anchors[p.sender].pos, an.pos);
+    const double start = p.start + d / TDOA_SPEED_OF_LIGHT;
+    if (!an.powered || !an.rxOpen || (start < an.rxStart))
+    {
+        return;
+    }
+
+    advanceClock(an);
+    an.rxOpen = false;
+    an.epoch++;
+    if (collided(*found, an.pos, node, start, start + p.airtime) || (uniform(gen) < config.lossProb))
+    {
+        an.stats.rxErr++;
+        rxFailed(node, RX_ERR);
+        return;
+    }
+
+    an.stats.rxOk++;
+    rxOk(node, p, localAt(an, p.rmarker + d / TDOA_SPEED_OF_LIGHT) + llround(config.rxNoise * normal(gen)));
+}
+
+/*
+ * The tag counts a pair for a frame that follows a frame of another anchor
+ * of its cell within a TDMA frame. Frames of other cells on the same radio
+ * only get in the way.
+ */
+void TDMANetSim::tagRx(tag_t &t, const packet_t &p)
+{
+    const double d = distance(anchors[p.sender].pos, t.pos);
+    const double start = p.start + d / TDOA_SPEED_OF_LIGHT;
+
+    if (p.cell != t.cell)
+    {
+        return;
+    }
+    if (collided(p, t.pos, -1, start, start + p.airtime) || (uniform(gen) < config.lossProb))
+    {
+        t.stats.lost++;
+        return;
+    }
+
+    t.stats.rx++;
+    const double frameTime = tdoa_tdma_slots(p.active, p.join) * (double)((uint64_t)p.slotUnits << TDOA_SLOT_UNIT_SHIFT) / NETSIM_TICKS_PER_S;
+    if ((t.lastSender >= 0) && (t.lastSender != p.addr) && (start - t.lastRx < frameTime))
+    {
+        t.stats.pairs++;
+    }
+    t.lastSender = p.addr;
+    t.lastRx = start;
+}
+
+// Airtime of the profile, as preambleTimeNs, frameTimeNs and tdmaSlotUnits of tdoa_anc.c
+uint32_t TDMANetSim::preambleTimeNs() const
+{
+    const tdoa_phy_profile_t &profile = TDOA_PHY_TABLE[config.phy];
+    uint32_t symbols = profile.preamble;
+
+    if (profile.rateKbps == 110) symbols += 64;
+    else if (profile.nsSFD && (profile.rateKbps == 850)) symbols += 16;
+    else symbols += 8;
+
+    return (symbols * (profile.prf64 ? 101763ull : 99359ull) + 99) / 100;
+}
+
+uint32_t TDMANetSim::frameTimeNs(uint16_t length) const
+{
+    const tdoa_phy_profile_t &profile = TDOA_PHY_TABLE[config.phy];
+    const uint32_t bits = 8*length + 48*((8*length + 329) / 330);
+    uint64_t bitPs;
+    uint32_t phrNs;
+
+    if (profile.rateKbps == 110)
+    {
+        bitPs = 8205128;
+        phrNs = 172308;
+    }
+    else
+    {
+        bitPs = (profile.rateKbps == 850) ? 1025641 : 128205;
+        phrNs = 21538;
+    }
+    return preambleTimeNs() + phrNs + (uint32_t)((bits * bitPs + 999) / 1000);
+}
+
+uint16_t TDMANetSim::tdmaSlotUnits(uint8_t n) const
+{
+    const uint32_t slotNs = NETSIM_GUARD_LENGTH_NS + frameTimeNs(rangeFrameLength(n, n - 1)) + NETSIM_TURNAROUND_NS + NETSIM_MARGIN_NS;
+    const uint32_t units = (slotNs * 78ull + 9999) / 10000;
+
+    if (units < TDOA_MIN_SLOT_UNITS) return TDOA_MIN_SLOT_UNITS;
+    if (units > TDOA_MAX_SLOT_UNITS) return TDOA_MAX_SLOT_UNITS;
+    return units;
+}
+
+void TDMANetSim::setSynchronized(anchor_t &a, bool synced)
+{
+    if (synced && !a.synchronized)
+    {
+        a.syncedSince = now;
+    }
+    else if (!synced && a.synchronized)
+    {
+        a.stats.syncedTime += now - a.syncedSince;
+    }
+    a.synchronized = synced;
+}
+
+// tdoa_init, the receiver starts listening right away
+void TDMANetSim::powerOn(int a)
+{
+    anchor_t &an = anchors[a];
+    if (an.powered)
+    {
+        return;
+    }
+
+    advanceClock(an);
+    an.powered = true;
+    setSynchronized(an, false);
+    setTdmaSchedule(an, config.addresses, defaultSlotUnits);
+    an.slot = an.nslots - 1;
+    an.nextSlot = 0;
+    an.idx = 0;
+    an.syncCount = 0;
+    an.syncMisses = 0;
+    an.syncRate = 0;
+    an.rxValid = 0;
+    memset(an.absent, 0, sizeof(an.absent));
+    an.heard = 0;
+    an.masterMisses = 0;
+    an.listenCount = 0;
+    an.frames = 0;
+    an.lastJoin = 0;
+
+    startRx(a, 0, true);
+}
+
+void TDMANetSim::setTdmaSchedule(anchor_t &a, uint8_t n, uint16_t slotUnits)
+{
+    a.anchors = n;
+    a.slotUnits = slotUnits;
+    a.slotLen = (int64_t)slotUnits << TDOA_SLOT_UNIT_SHIFT;
+    setTdmaSlots(a, (uint16_t)((1u << n) - 1), TDOA_NO_JOIN);
+}
+
+void TDMANetSim::setTdmaSlots(anchor_t &a, uint16_t active, uint8_t join)
+{
+    const int64_t frameLen = a.frameLen;
+
+    a.active = active;
+    a.join = join;
+    a.nslots = tdoa_tdma_slots(active, join);
+    a.ownSlot = tdoa_tdma_slot_of(active, join, a.anchorId);
+    a.frameLen = a.nslots * a.slotLen;
+    if (frameLen != 0)
+    {
+        a.syncRate = (int32_t)((int64_t)a.syncRate * a.frameLen / frameLen);
+    }
+
+    const float T = (float)a.frameLen / (float)NETSIM_TICKS_PER_S;
+    const float lambda = (float)NETSIM_SYNC_DRIFT_NOISE * T * T / (float)NETSIM_SYNC_MEAS_NOISE;
+    const float r = (4.0f + lambda - sqrtf(8.0f*lambda + lambda*lambda)) / 4.0f;
+    const float alpha = 1.0f - r*r;
+    const float beta = 2.0f*(2.0f - alpha) - 4.0f*sqrtf(1.0f - alpha);
+    a.syncAlpha = (int32_t)(alpha * 65536.0f);
+    a.syncBeta = (int32_t)(beta * 65536.0f);
+}
+
+void TDMANetSim::syncFilterReset(anchor_t &a, bool fromMaster)
+{
+    a.syncRate = 0;
+    a.syncCount = fromMaster ? 1 : 0;
+    a.syncMisses = 0;
+}
+
+void TDMANetSim::syncMissed(anchor_t &a)
+{
+    a.stats.syncMissed++;
+    if (++a.syncMisses > NETSIM_SYNC_HOLD_FRAMES)
+    {
+        a.stats.syncLost++;
+        setSynchronized(a, false);
+        a.listenCount = 0;
+    }
+}
+
+void TDMANetSim::masterMissed(anchor_t &a)
+{
+    const uint8_t master = tdoa_tdma_anchor_of(a.active, a.join, 0);
+
+    if ((master >= TDOA_MAX_ANCHORS) || ((a.heard >> master) & 1))
+    {
+        a.masterMisses = 0;
+        return;
+    }
+    if (++a.masterMisses < NETSIM_MASTER_FRAMES)
+    {
+        return;
+    }
+
+    a.masterMisses = 0;
+    a.syncMisses = 0;
+    a.stats.failovers++;
+    a.frameStart += a.slotLen;
+    setTdmaSlots(a, a.active & ~(1u << master), a.join);
+    a.nextSlot = 0;
+}
+
+void TDMANetSim::listenOrStart(int a)
+{
+    anchor_t &an = anchors[a];
+
+    if ((an.anchorId >= an.anchors) || (++an.listenCount < (an.anchorId + 1u) * NETSIM_MASTER_LISTEN))
+    {
+        startRx(a, 0, true);
+        return;
+    }
+
+    an.listenCount = 0;
+    setTdmaSlots(an, ((1u << an.anchors) - 1) & ~((1u << an.anchorId) - 1), TDOA_NO_JOIN);
+    syncFilterReset(an, false);
+    an.nextSlot = 0;
+
+    an.frameStart = (localAt(an, now) & ~(int64_t)(TDOA_SLOT_UNIT - 1)) + 2*an.frameLen;
+    setSynchronized(an, true);
+    setupTx(a);
+
+    an.slotState = TX_OK;
+    updateSlot(an);
+}
+
+void TDMANetSim::syncFilterUpdate(anchor_t &a, int64_t rxTime)
+{
+    const int64_t e = rxTime - NETSIM_TX_OFFSET(txLead) - a.frameStart;
+
+    a.syncMisses = 0;
+    if ((a.syncCount == 0) || (e > NETSIM_SYNC_GATE) || (e < -NETSIM_SYNC_GATE))
+    {
+        a.frameStart += e;
+        syncFilterReset(a, true);
+    }
+    else if (a.syncCount == 1)
+    {
+        a.frameStart += e;
+        a.syncRate = (int32_t)e << 8;
+        a.syncCount = 2;
+    }
+    else
+    {
+        a.frameStart += (a.syncAlpha * e) >> 16;
+        a.syncRate += (int32_t)((a.syncBeta * e) >> 8);
+    }
+}
+
+void TDMANetSim::updateMembership(anchor_t &a)
+{
+    uint16_t active = a.active;
+    uint8_t join = TDOA_NO_JOIN;
+
+    for (uint8_t k = 0; k < a.anchors; k++)
+    {
+        if (k == a.anchorId)
+        {
+            continue;
+        }
+        if ((a.heard >> k) & 1)
+        {
+            a.absent[k] = 0;
+            active |= 1u << k;
+        }
+        else if (((active >> k) & 1) && (++a.absent[k] >= NETSIM_ABSENT_FRAMES))
+        {
+            active &= ~(1u << k);
+        }
+    }
+    a.heard = 0;
+
+    if (((++a.frames % NETSIM_JOIN_EVERY) == 0) || (__builtin_popcount(active) < TDOA_MIN_ANCHORS))
+    {
+        for (uint8_t k = 1; k <= a.anchors; k++)
+        {
+            const uint8_t candidate = (a.lastJoin + k) % a.anchors;
+            if ((candidate != a.anchorId) && !((active >> candidate) & 1))
+            {
+                join = candidate;
+                a.lastJoin = candidate;
+                break;
+            }
+        }
+    }
+
+    if ((active != a.active) || (join != a.join))
+    {
+        setTdmaSlots(a, active, join);
+    }
+}
+
+void TDMANetSim::setupTx(int a)
+{
+    anchor_t &an = anchors[a];
+
+    if (an.nextSlot == 0)
+    {
+        an.idx++;
+        updateMembership(an);
+    }
+    startTx(a, delayedTx(an.frameStart + an.nextSlot*an.slotLen + txLead));
+}
+
+void TDMANetSim::setupRx(int a)
+{
+    anchor_t &an = anchors[a];
+    startRx(a, an.frameStart + an.nextSlot*an.slotLen, false);
+}
+
+void TDMANetSim::updateSlot(anchor_t &a)
+{
+    a.slot = a.nextSlot;
+    a.nextSlot = a.nextSlot + 1;
+    if (a.nextSlot >= a.nslots)
+    {
+        a.nextSlot = 0;
+    }
+    if (a.nextSlot == 0)
+    {
+        a.frameStart += a.frameLen + (a.syncRate >> 8);
+    }
+}
+
+// p and rxTime only for RX_OK
+void TDMANetSim::slotStep(int a, int event, const packet_t *p, int64_t rxTime)
+{
+    anchor_t &an = anchors[a];
+
+    if (an.slotState == RX_OK)
+    {
+        const uint8_t sender = tdoa_tdma_anchor_of(an.active, an.join, an.slot);
+        const packet_t *range = NULL;
+
+        // A packet from another anchor than that of the slot, or without this anchor, belongs to another schedule
+        if ((event == RX_OK) && (p->cell == an.cell) && (p->addr == sender) && (sender < p->anchors) && (an.anchorId < p->anchors))
+        {
+            range = p;
+        }
+
+        if (range == NULL)
+        {
+            if (sender < TDOA_MAX_ANCHORS)
+            {
+                an.rxValid &= ~(1u << sender);
+            }
+            if (an.slot == 0)
+            {
+                syncMissed(an);
+                masterMissed(an);
+                an.heard = 0;
+            }
+        }
+        else
+        {
+            an.rxValid |= 1u << sender;
+            if (an.slot == 0)
+            {
+                syncFilterUpdate(an, rxTime);
+                an.idx = range->idx;
+                an.masterMisses = 0;
+                an.heard = 0;
+
+                if ((range->anchors != an.anchors) || (range->slotUnits != an.slotUnits))
+                {
+                    setTdmaSchedule(an, range->anchors, range->slotUnits);
+                    setTdmaSlots(an, range->active, range->join);
+                    syncFilterReset(an, true);
+                }
+                else if ((range->active != an.active) || (range->join != an.join))
+                {
+                    setTdmaSlots(an, range->active, range->join);
+                }
+            }
+            an.heard |= 1u << sender;
+        }
+
+        if (an.nextSlot == an.ownSlot)
+        {
+            setupTx(a);
+            an.slotState = TX_OK;
+        }
+        else
+        {
+            setupRx(a);
+            an.slotState = RX_OK;
+        }
+
+        // The anchors the sender heard are present too, read after the next slot is set up as on the anchor
+        if (range != NULL)
+        {
+            for (uint8_t k = 0; k < range->anchors; k++)
+            {
+                if ((range->entries >> k) & 1)
+                {
+                    an.heard |= 1u << k;
+                }
+            }
+        }
+    }
+    else
+    {
+        setupRx(a);
+        an.slotState = RX_OK;
+    }
+
+    updateSlot(an);
+}
+
+// rx_ok_cb
+void TDMANetSim::rxOk(int a, const packet_t &p, int64_t rxTime)
+{
+    if (anchors[a].synchronized)
+    {
+        slotStep(a, RX_OK, &p, rxTime);
+    }
+    else
+    {
+        rxOkUnsynchronized(a, p, rxTime);
+    }
+}
+
+// Joins on the packet of any anchor with a slot in a schedule with this anchor's address
+void TDMANetSim::rxOkUnsynchronized(int a, const packet_t &p, int64_t rxTime)
+{
+    anchor_t &an = anchors[a];
+    const bool range = (p.cell == an.cell);
+    const uint8_t sender = p.addr;
+    const uint8_t slot = range ? tdoa_tdma_slot_of(p.active, p.join, sender) : 0;
+
+    if (!range || (sender >= p.anchors) || (sender == an.anchorId) || (an.anchorId >= p.anchors)
+        || (slot >= tdoa_tdma_slots(p.active, p.join)))
+    {
+        listenOrStart(a);
+        return;
+    }
+
+    setTdmaSchedule(an, p.anchors, p.slotUnits);
+    setTdmaSlots(an, p.active, p.join);
+    an.frameStart = rxTime - NETSIM_TX_OFFSET(txLead) - slot*an.slotLen;
+    syncFilterReset(an, slot == 0);
+    an.stats.resyncs++;
+    an.idx = p.idx;
+    an.rxValid = 1u << sender;
+
+    an.nextSlot = slot;
+    updateSlot(an);
+    setSynchronized(an, true);
+    if (an.nextSlot == an.ownSlot)
+    {
+        setupTx(a);
+        an.slotState = TX_OK;
+    }
+    else
+    {
+        setupRx(a);
+        an.slotState = RX_OK;
+    }
+    updateSlot(an);
+}
+
+// rx_to_cb and rx_err_cb
+void TDMANetSim::rxFailed(int a, int event)
+{
+    if (anchors[a].synchronized)
+    {
+        slotStep(a, event, NULL, 0);
+    }
+    else
+    {
+        listenOrStart(a);
+    }
+}
+
+// tx_conf_cb
+void TDMANetSim::txDone(int a)
+{
+    if (anchors[a].synchronized)
+    {
+        slotStep(a, TX_OK, NULL, 0);
+    }
+    else
+    {
+        listenOrStart(a);
+    }
+}
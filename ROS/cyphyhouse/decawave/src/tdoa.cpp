@@ -9,6 +9,21 @@
  *  Author: Joao Paulo Jansch Porto <janschp2(at)illinois.edu>
  *
  *  Changelog:
+ *      v0.18 - Convex hull of the active anchors, inflated noise and iterated updates outside of it
+ *      v0.17 - Innovations of every pair to a flight recorder
+ *      v0.16 - Innovations of every pair to a consistency monitor
+ *      v0.15 - Local frame around a double precision origin
+ *      v0.14 - Active anchor set of the tag's zone, pairs outside it are rejected
+ *      v0.13 - Nine state variant with accelerometer bias for the inertial filter
+ *      v0.12 - Pair innovation without an update, for the anchor health
+ *      v0.11 - Steady-state gain mode without covariance propagation
+ *      v0.10 - Position dependent pair noise from a precomputed NoiseMap
+ *      v0.9 - Position update shared with the lanes of TDOAFleet
+ *      v0.8 - State access and innovation likelihood for multiple model estimators
+ *      v0.7 - Per anchor pair adaptive measurement noise
+ *      v0.6 - Iterated EKF linearization option
+ *      v0.5 - Optional UD factorized covariance with Bierman/Thornton updates
+ *      v0.4 - Fixed-size filter templated on state dimension and scalar type
  *      v0.3 - Added extra library functions (06/26/2017)
  *      v0.2 - initial release (06/19/2017)
  *
@@ -16,15 +31,19 @@
 
 
 #include "tdoa.h"
+#include "noise_map.h"
+#include "gain_table.h"
+#include "filter_consistency.h"
+#include "flight_recorder.h"
 
-TDOA::TDOA(void)
+template <int NStates, typename Scalar>
+TDOAFilter<NStates, Scalar>::TDOAFilter(void)
 {
     tdoaCount = 0;
-    nr_states = STATE_DIM;
     
-    S.setZero(STATE_DIM);
+    S.setZero();
 
-    P.setZero(STATE_DIM, STATE_DIM);
+    P.setZero();
     P(STATE_X, STATE_X) = powf(100,2);
     P(STATE_Y, STATE_Y) = powf(100,2);
     P(STATE_Z, STATE_Z) = powf(100,2);
@@ -32,81 +51,160 @@ TDOA::TDOA(void)
     P(STATE_VY, STATE_VY) = powf(0.01,2);
     P(STATE_VZ, STATE_VZ) = powf(0.01,2);
     
-    A.setIdentity(STATE_DIM,STATE_DIM);
+    A.setIdentity();
+    structuredTransition = true;
     
-    Q.setZero(STATE_DIM, STATE_DIM);
+    Q.setZero();
+    
+    U.setIdentity();
+    D = P.diagonal();
+    Uq.setIdentity();
+    Dq.setZero();
     
     stdDev = 0.15f;
+    updateMode = TDOA_UPDATE_GENERAL;
+    covarianceMode = TDOA_COVARIANCE_FULL;
+    linearizationMode = TDOA_LINEARIZE_ONCE;
+    maxIterations = IEKF_DEFAULT_ITERATIONS;
+    
+    gateThreshold = 0;
+    robustMode = TDOA_ROBUST_NONE;
+    robustK = 1.345f;
+    memset(rejectCount, 0, sizeof(rejectCount));
+    
+    adaptiveNoise = false;
+    adaptiveRate = ADAPTIVE_NOISE_RATE;
+    pairVariance.setConstant(stdDev*stdDev);
+    noiseMap = NULL;
+    gainTable = NULL;
+    
+    likelihoodTracking = false;
+    logLikelihood = 0;
+    
+    consistency = NULL;
+    recorder = NULL;
+    recorderTag = 0;
+    
+    hullMode = false;
+    hullValid = false;
+    hullIterate = true;
+    outsideHull = false;
+    hullMargin = HULL_MARGIN;
+    hullNoiseScale = HULL_NOISE_SCALE;
+    hullNoise = 1;
+    hullDistance = -INFINITY;
+    
+    stateTime = 0;
+    stateTimeValid = false;
+    
+    memset(anchorPosition, 0, sizeof(anchorPosition));
+    anchorCount = MAX_NR_ANCHORS;
+    origin.setZero();
+    anchorSoA.setZero();
+    
+    cachePoint.setZero();
+    cacheDist.setZero();
+    cacheUnit.setZero();
+    cacheValid = 0;
 }
 
-TDOA::TDOA(const Eigen::MatrixXf transition_mat, const Eigen::MatrixXf prediction_mat, const Eigen::MatrixXf covariance_mat, const vec3d_t init_pos)
+template <int NStates, typename Scalar>
+TDOAFilter<NStates, Scalar>::TDOAFilter(const DynamicMatrix &transition_mat, const DynamicMatrix &prediction_mat, const DynamicMatrix &covariance_mat, const vec3d_t init_pos)
+    : TDOAFilter()
 {
-    tdoaCount = 0;
-    nr_states = transition_mat.rows();
-    
     setPredictionMat(prediction_mat);
     setTransitionMat(transition_mat);
     setCovarianceMat(covariance_mat);
     
-    S.setZero(nr_states);
     setInitPos(init_pos);
     
     stdDev = 0.15f;
 }
 
-void TDOA::setInitPos(const vec3d_t init_pos)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setInitPos(const vec3d_t init_pos)
 {
-    S(0) = init_pos.x;
-    S(1) = init_pos.y;
-    S(2) = init_pos.z;
+    S(0) = init_pos.x - origin.x();
+    S(1) = init_pos.y - origin.y();
+    S(2) = init_pos.z - origin.z();
 }
 
-void TDOA::setTransitionMat(const Eigen::MatrixXf transition_mat)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setTransitionMat(const DynamicMatrix &transition_mat)
 {
-    if( (transition_mat.rows() != nr_states) || (transition_mat.cols() != nr_states) )
+    if( (transition_mat.rows() != NStates) || (transition_mat.cols() != NStates) )
     {
         // If provided transition_mat is of wrong size, ignore input
         return;
     }
 
     A = transition_mat;
-
+    
+    // propagateState writes the couplings, everything else must be the identity but the velocity diagonal
+    structuredTransition = true;
+    for (int r = 0; r < NStates; r++)
+    {
+        for (int c = 0; c < NStates; c++)
+        {
+            const bool coupling = (c == r + STATE_VX - STATE_X) && (r <= STATE_Z);
+            const bool velocity = (r == c) && (r >= STATE_VX) && (r <= STATE_VZ);
+            if (!coupling && !velocity && (A(r,c) != ((r == c) ? 1 : 0)))
+            {
+                structuredTransition = false;
+            }
+        }
+    }
 }
 
-void TDOA::setPredictionMat(const Eigen::MatrixXf prediction_mat)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setPredictionMat(const DynamicMatrix &prediction_mat)
 {
-    if( (prediction_mat.rows() != nr_states) || (prediction_mat.cols() != nr_states) )
+    if( (prediction_mat.rows() != NStates) || (prediction_mat.cols() != NStates) )
     {
         // If provided transition_mat is of wrong size, ignore input
         return;
     }
 
     P = prediction_mat;
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        factorUD(P, U, D, MIN_COVARIANCE);
+        PredictionBound();
+    }
 }
 
-void TDOA::setCovarianceMat(const Eigen::MatrixXf covariance_mat)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setCovarianceMat(const DynamicMatrix &covariance_mat)
 {
-    if( (covariance_mat.rows() != nr_states) || (covariance_mat.cols() != nr_states) )
+    if( (covariance_mat.rows() != NStates) || (covariance_mat.cols() != NStates) )
     {
         // If provided transition_mat is of wrong size, ignore input
         return;
     }
 
     Q = covariance_mat;
+    // Q is only positive semi-definite, zero pivots stay zero
+    factorUD(Q, Uq, Dq, 0);
 }
 
-void TDOA::setAncPosition(const int anc_num, const vec3d_t anc_pos)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setAncPosition(const int anc_num, const vec3d_t anc_pos)
 {
-    if( (anc_num < 0) || (anc_num > MAX_NR_ANCHORS) )
+    if( (anc_num < 0) || (anc_num >= MAX_NR_ANCHORS) )
     {
         //invalid anchor number
         return;
     }
 
-    anchorPosition[anc_num] = anc_pos;
+    storeAnchor(anc_num, anc_pos);
+    anchorCount = std::max(anchorCount, anc_num + 1);
+    
+    cacheValid &= ~(1u << anc_num);
+    hullValid = false;
 }
 
-void TDOA::setAncPosition(const int anc_num, const float x, const float y, const float z)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setAncPosition(const int anc_num, const float x, const float y, const float z)
 {
     vec3d_t temp;
     temp.x = x;
@@ -115,58 +213,770 @@ void TDOA::setAncPosition(const int anc_num, const float x, const float y, const
     setAncPosition(anc_num, temp);
 }
 
-void TDOA::setStdDev(const float sdev)
+/*
+ * Called on a handover with the anchors of the new cell. The statistics of a
+ * slot that kept its anchor stay, so a cell listed twice or a tag that comes
+ * back keeps them. Inactive slots are zeroed and not part of the cache.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setActiveAnchors(const vec3d_t *anchors, int count)
+{
+    count = std::max(0, std::min(count, MAX_NR_ANCHORS));
+    for (int k = 0; k < MAX_NR_ANCHORS; k++)
+    {
+        vec3d_t pos = {0, 0, 0};
+        if (k < count)
+        {
+            pos = anchors[k];
+        }
+        const bool moved = (k >= anchorCount) || (k >= count) || (pos.x != anchorPosition[k].x)
+                           || (pos.y != anchorPosition[k].y) || (pos.z != anchorPosition[k].z);
+        if (moved)
+        {
+            resetAnchorPairs(k);
+        }
+        storeAnchor(k, pos);
+    }
+    anchorCount = count;
+    cacheValid = 0;
+    hullValid = false;
+}
+
+/*
+ * The state moves by the change of origin and the covariance stays as it
+ * is. Anchors are rebuilt from their site positions in double precision
+ * rather than shifted, so their rounding does not depend on earlier origins.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setOrigin(const Eigen::Vector3d &o)
+{
+    const Eigen::Matrix<Scalar, 3, 1> shift = (origin - o).template cast<Scalar>();
+    S.template head<3>() += shift;
+    cachePoint += shift;
+    origin = o;
+    for (int k = 0; k < MAX_NR_ANCHORS; k++)
+    {
+        storeAnchor(k, anchorPosition[k]);
+    }
+    cacheValid = 0;
+    hullValid = false;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::storeAnchor(int anc_num, const vec3d_t &anc_pos)
+{
+    anchorPosition[anc_num] = anc_pos;
+    anchorSoA(anc_num, 0) = (Scalar)(anc_pos.x - origin.x());
+    anchorSoA(anc_num, 1) = (Scalar)(anc_pos.y - origin.y());
+    anchorSoA(anc_num, 2) = (Scalar)(anc_pos.z - origin.z());
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::resetAnchorPairs(int anc_num)
+{
+    for (int k = 0; k < MAX_NR_ANCHORS; k++)
+    {
+        rejectCount[anc_num][k] = 0;
+        rejectCount[k][anc_num] = 0;
+    }
+    pairVariance.row(anc_num).setConstant(stdDev*stdDev);
+    pairVariance.col(anc_num).setConstant(stdDev*stdDev);
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setStdDev(const float sdev)
 {
     stdDev = sdev;
+    pairVariance.setConstant(stdDev*stdDev);
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setUpdateMode(const tdoa_update_mode_t mode)
+{
+    updateMode = mode;
+}
+
+/*
+ * Switching to the UD mode factors the current P, switching back keeps the
+ * last U*D*U' as the full covariance.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setCovarianceMode(const tdoa_covariance_mode_t mode)
+{
+    if ((mode == TDOA_COVARIANCE_UD) && (covarianceMode != TDOA_COVARIANCE_UD))
+    {
+        factorUD(P, U, D, MIN_COVARIANCE);
+    }
+    covarianceMode = mode;
+    PredictionBound();
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setLinearizationMode(const tdoa_linearization_mode_t mode, const int iterations)
+{
+    linearizationMode = mode;
+    maxIterations = std::max(1, std::min(iterations, IEKF_MAX_ITERATIONS));
 }
 
-vec3d_t TDOA::getAncPosition(const int anc_num)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setGateThreshold(const float threshold)
+{
+    gateThreshold = threshold;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setRobustMode(const tdoa_robust_mode_t mode, const float k)
+{
+    robustMode = mode;
+    robustK = k;
+}
+
+/*
+ * Estimates the measurement variance of every anchor pair from its innovations
+ * instead of using stdDev for all of them. Enabling restarts all pairs at stdDev.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setAdaptiveNoise(const bool enable, const float rate)
+{
+    if (enable && !adaptiveNoise)
+    {
+        pairVariance.setConstant(stdDev*stdDev);
+    }
+    adaptiveNoise = enable;
+    adaptiveRate = std::max(0.0f, std::min(rate, 1.0f));
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setNoiseMap(const NoiseMap *map)
+{
+    noiseMap = map;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setGainTable(const GainTable *table)
+{
+    gainTable = table;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setLikelihoodTracking(const bool enable)
+{
+    likelihoodTracking = enable;
+    logLikelihood = 0;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setConsistencyMonitor(FilterConsistency *monitor)
+{
+    consistency = monitor;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setFlightRecorder(FlightRecorderRing *ring, uint8_t tag)
+{
+    recorder = ring;
+    recorderTag = tag;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setHullMode(const bool enable, const float margin, const float noiseScale, const bool iterate)
+{
+    hullMode = enable;
+    hullMargin = margin;
+    hullNoiseScale = std::max(noiseScale, 1.0f);
+    hullIterate = iterate;
+    hullValid = false;
+    outsideHull = false;
+    hullNoise = 1;
+    hullDistance = -INFINITY;
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::setState(const StateVector &state, const StateMatrix &covariance, const double t)
+{
+    S = state;
+    P = covariance;
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        factorUD(P, U, D, MIN_COVARIANCE);
+    }
+    PredictionBound();
+    
+    stateTime = t;
+    stateTimeValid = true;
+}
+
+template <int NStates, typename Scalar>
+float TDOAFilter<NStates, Scalar>::getPairStdDev(const int Ar, const int An)
+{
+    if( (Ar < 0) || (Ar >= MAX_NR_ANCHORS) || (An < 0) || (An >= MAX_NR_ANCHORS) )
+    {
+        return stdDev;
+    }
+    return pairStdDev(Ar, An);
+}
+
+template <int NStates, typename Scalar>
+bool TDOAFilter<NStates, Scalar>::pairInnovation(uint8_t Ar, uint8_t An, float distanceDiff, Scalar &error, Scalar &HPHR)
+{
+    if (!activePair(Ar, An))
+    {
+        return false;
+    }
+    
+    if (covarianceMode == TDOA_COVARIANCE_STEADY)
+    {
+        const Eigen::Matrix<Scalar, 3, 1> site = sitePosition();
+        const float *gain = gainTable ? gainTable->gain(gainTable->node(site(0), site(1), site(2)), Ar, An) : NULL;
+        if (!gain)
+        {
+            return false;
+        }
+        const Eigen::Matrix<Scalar, 3, 1> pos = S.template head<3>();
+        error = distanceDiff - ((pos - anchorSoA.row(An).transpose()).norm() - (pos - anchorSoA.row(Ar).transpose()).norm());
+        HPHR = gain[GAIN_TABLE_S];
+        return true;
+    }
+    
+    // Same prediction as prepareScalarUpdate, the geometry stays cached for the update that may follow
+    relinearizeGeometry(false);
+    updateAnchorGeometry(An);
+    updateAnchorGeometry(Ar);
+    const Eigen::Matrix<Scalar, 3, 1> hp = (cacheUnit.row(An) - cacheUnit.row(Ar)).transpose();
+    const Eigen::Matrix<Scalar, 3, 1> offset = S.template head<3>() - cachePoint;
+    error = distanceDiff - (cacheDist(An) - cacheDist(Ar) + hp.dot(offset));
+    const Scalar stdMeasNoise = pairStdDev(Ar, An);
+    HPHR = hp.dot(P.template topLeftCorner<3,3>() * hp) + stdMeasNoise*stdMeasNoise;
+    return true;
+}
+
+template <int NStates, typename Scalar>
+bool TDOAFilter<NStates, Scalar>::lockstepCompatible()
+{
+    return (updateMode == TDOA_UPDATE_SPARSE) && (covarianceMode == TDOA_COVARIANCE_FULL);
+}
+
+template <int NStates, typename Scalar>
+uint32_t TDOAFilter<NStates, Scalar>::getRejectCount(const int Ar, const int An)
+{
+    if( (Ar < 0) || (Ar >= MAX_NR_ANCHORS) || (An < 0) || (An >= MAX_NR_ANCHORS) )
+    {
+        return 0;
+    }
+    return rejectCount[Ar][An];
+}
+
+template <int NStates, typename Scalar>
+vec3d_t TDOAFilter<NStates, Scalar>::getAncPosition(const int anc_num)
 {
     return anchorPosition[anc_num];
 }
 
-void TDOA::scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff)
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance)
 {
+    // The steady-state gains were computed for stdDev, a variance of the tag cannot change them
+    if (covarianceMode == TDOA_COVARIANCE_STEADY)
+    {
+        steadyStateUpdate(Ar, An, distanceDiff);
+        return;
+    }
+    
+    Eigen::Matrix<Scalar, 3, 1> hp;
+    Scalar error, stdMeasNoise;
+    if (!prepareScalarUpdate(Ar, An, distanceDiff, hp, error, stdMeasNoise, variance))
+    {
+        return;
+    }
 
-    float measurement = distanceDiff;
+    if (updateMode == TDOA_UPDATE_SPARSE)
+    {
+        stateEstimatorPositionUpdate(hp, error, stdMeasNoise);
+    }
+    else
+    {
+        MeasurementRow h = MeasurementRow::Zero();
+        h.template head<3>() = hp.transpose();
+
+        stateEstimatorScalarUpdate(h, error, stdMeasNoise);
+    }
+}
 
-    // predict based on current state
-    float x = S(STATE_X);
-    float y = S(STATE_Y);
-    float z = S(STATE_Z);
+template <int NStates, typename Scalar>
+bool TDOAFilter<NStates, Scalar>::prepareScalarUpdate(uint8_t Ar, uint8_t An, float distanceDiff, Eigen::Matrix<Scalar, 3, 1> &hp, Scalar &error, Scalar &stdMeasNoise,
+                                                      float variance)
+{
+    if (!activePair(Ar, An))
+    {
+        return false;
+    }
+    Scalar measurement = distanceDiff;
+
+    // predict based on current state, through the anchor geometry at the linearization point
+    relinearizeGeometry(false);
+    updateAnchorGeometry(An);
+    updateAnchorGeometry(Ar);
+
+    // Only the position entries of the Jacobian are non-zero
+    hp = (cacheUnit.row(An) - cacheUnit.row(Ar)).transpose();
+
+    // First order correction for the distance moved since the geometry was computed
+    const Eigen::Matrix<Scalar, 3, 1> offset = S.template head<3>() - cachePoint;
+    Scalar predicted = cacheDist(An) - cacheDist(Ar) + hp.dot(offset);
+    error = measurement - predicted;
+
+    // The tag saw the receive power, first path and clock fit of this very packet
+    stdMeasNoise = ((variance > 0) ? std::sqrt((Scalar)variance) : pairStdDev(Ar, An)) * hullNoise;
+    const bool screen = (gateThreshold > 0) || (robustMode != TDOA_ROBUST_NONE);
+    if (screen || adaptiveNoise || likelihoodTracking || consistency || recorder)
+    {
+        const Scalar HPH = hp.dot(P.template topLeftCorner<3,3>() * hp);
+        const Scalar HPHR = HPH + stdMeasNoise*stdMeasNoise;
+        if (screen && !screenMeasurement(Ar, An, error, HPHR, stdMeasNoise))
+        {
+            // A rejected measurement still counts against the model, as if it was on the gate
+            addLikelihood(gateThreshold, std::log(HPHR), 1);
+            addInnovation(Ar, An, error, HPHR, true);
+            return false;
+        }
+        adaptPairNoise(Ar, An, error, HPH);
+        addLikelihood(error*error / HPHR, std::log(HPHR), 1);
+        addInnovation(Ar, An, error, HPHR, false);
+    }
+
+    if (iterated())
+    {
+        iterateLinearization(Ar, An, measurement, stdMeasNoise*stdMeasNoise, hp, error);
+    }
+    return true;
+}
 
-    float x1 = anchorPosition[An].x, y1 = anchorPosition[An].y, z1 = anchorPosition[An].z;
-    float x0 = anchorPosition[Ar].x, y0 = anchorPosition[Ar].y, z0 = anchorPosition[Ar].z;
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::batchTDOAUpdate(const tdoa_meas_t *meas, size_t count, tdoa_batch_mode_t mode, const float *variance)
+{
+    // The steady-state gains are only known for single pairs
+    if ((mode == TDOA_BATCH_SEQUENTIAL) || (covarianceMode == TDOA_COVARIANCE_STEADY))
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (meas[i].timestamp > 0)
+            {
+                stateEstimatorPredictTo(meas[i].timestamp);
+            }
+            scalarTDOADistUpdate(meas[i].Ar, meas[i].An, meas[i].distanceDiff, variance ? variance[i] : 0);
+        }
+        return;
+    }
 
-    float d1 = sqrtf(powf(x - x1, 2) + powf(y - y1, 2) + powf(z - z1, 2));
-    float d0 = sqrtf(powf(x - x0, 2) + powf(y - y0, 2) + powf(z - z0, 2));
+    if (count == 0)
+    {
+        return;
+    }
+    if (count > MAX_NR_ANCHORS)
+    {
+        // The stacked sizes are fixed at MAX_NR_ANCHORS rows, a larger frame goes in consecutive blocks
+        for (size_t first = 0; first < count; first += MAX_NR_ANCHORS)
+        {
+            const size_t n = std::min(count - first, (size_t)MAX_NR_ANCHORS);
+            batchTDOAUpdate(meas + first, n, mode, variance ? variance + first : NULL);
+        }
+        return;
+    }
+    const int m = count;
+    
+    // The whole frame is linearized at the time of its newest measurement
+    if (meas[m-1].timestamp > 0)
+    {
+        stateEstimatorPredictTo(meas[m-1].timestamp);
+    }
 
-    float predicted = d1 - d0;
-    float error = measurement - predicted;
+    // Fixed maximum sizes keep the joint update off the heap
+    typedef Eigen::Array<Scalar, MAX_NR_ANCHORS, 1> AnchorArray;
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 1, 0, MAX_NR_ANCHORS, 1> BatchVector;
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 3, 0, MAX_NR_ANCHORS, 3> BatchJacobian;
+    typedef Eigen::Matrix<Scalar, NStates, Eigen::Dynamic, 0, NStates, MAX_NR_ANCHORS> BatchGain;
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, 0, MAX_NR_ANCHORS, MAX_NR_ANCHORS> BatchCovariance;
 
-    Eigen::RowVectorXf h = Eigen::RowVectorXf::Constant(STATE_DIM, 0);
+    // Distances and unit vectors from the current position to all anchors at once
+    relinearizeGeometry(true);
+    const AnchorArray dx = cacheUnit.col(0).array();
+    const AnchorArray dy = cacheUnit.col(1).array();
+    const AnchorArray dz = cacheUnit.col(2).array();
+    const AnchorArray d = cacheDist.array();
 
-    h(STATE_X) = ((x - x1) / d1 - (x - x0) / d0);
-    h(STATE_Y) = ((y - y1) / d1 - (y - y0) / d0);
-    h(STATE_Z) = ((z - z1) / d1 - (z - z0) / d0);
+    // Stack the measurements of the frame (only position columns of H are non-zero)
+    const bool screen = (gateThreshold > 0) || (robustMode != TDOA_ROBUST_NONE);
+    BatchJacobian H(m, 3);
+    BatchVector error(m);
+    BatchVector Rvec(m);
+    int used[MAX_NR_ANCHORS];
+    int rows = 0;
+    for (int i = 0; i < m; i++)
+    {
+        const uint8_t Ar = meas[i].Ar;
+        const uint8_t An = meas[i].An;
+        if (!activePair(Ar, An))
+        {
+            continue;
+        }
 
-    stateEstimatorScalarUpdate(h, error, stdDev);
+        H(rows, 0) = dx(An) - dx(Ar);
+        H(rows, 1) = dy(An) - dy(Ar);
+        H(rows, 2) = dz(An) - dz(Ar);
+        error(rows) = meas[i].distanceDiff - (d(An) - d(Ar));
 
+        // Gate each pair on its own innovation variance
+        Scalar stdMeasNoise = ((variance && (variance[i] > 0)) ? std::sqrt((Scalar)variance[i]) : pairStdDev(Ar, An)) * hullNoise;
+        if (screen || adaptiveNoise || consistency || recorder)
+        {
+            const Eigen::Matrix<Scalar, 3, 1> h = H.row(rows).transpose();
+            const Scalar HPH = h.dot(P.template topLeftCorner<3,3>() * h);
+            if (screen && !screenMeasurement(Ar, An, error(rows), HPH + stdMeasNoise*stdMeasNoise, stdMeasNoise))
+            {
+                addLikelihood(gateThreshold, std::log(HPH + stdMeasNoise*stdMeasNoise), 1);
+                addInnovation(Ar, An, error(rows), HPH + stdMeasNoise*stdMeasNoise, true);
+                continue;
+            }
+            adaptPairNoise(Ar, An, error(rows), HPH);
+            // Each row on its own, its marginal is chi-square(1) as well
+            addInnovation(Ar, An, error(rows), HPH + stdMeasNoise*stdMeasNoise, false);
+        }
+        Rvec(rows) = stdMeasNoise*stdMeasNoise;
+        used[rows] = i;
+        rows++;
+    }
+    if (rows == 0)
+    {
+        return;
+    }
+    H.conservativeResize(rows, 3);
+    error.conservativeResize(rows);
+    Rvec.conservativeResize(rows);
+
+    if (iterated())
+    {
+        // Gauss-Newton on the position: relinearize all pairs at the updated
+        // position x_i and recompute the stacked innovation against the prior x0
+        const Eigen::Matrix<Scalar, 3, 1> x0 = S.template head<3>();
+        Eigen::Matrix<Scalar, 3, 1> xi = x0;
+        for (int it = 0; it < maxIterations; it++)
+        {
+            const Eigen::Matrix<Scalar, 3, Eigen::Dynamic, 0, 3, MAX_NR_ANCHORS> PHp = P.template topLeftCorner<3,3>() * H.transpose();
+            BatchCovariance HPHRi = H * PHp;
+            HPHRi.diagonal() += Rvec;
+            const Eigen::Matrix<Scalar, 3, 1> next = x0 + PHp * HPHRi.ldlt().solve(error);
+            if ((next - xi).squaredNorm() < (Scalar)(IEKF_STEP_TOL*IEKF_STEP_TOL))
+            {
+                break;
+            }
+            xi = next;
+            for (int i = 0; i < rows; i++)
+            {
+                const tdoa_meas_t &mi = meas[used[i]];
+                Eigen::Matrix<Scalar, 3, 1> h;
+                Scalar dist;
+                pairGeometry(mi.Ar, mi.An, xi, h, dist);
+                H.row(i) = h.transpose();
+                error(i) = mi.distanceDiff - dist - h.dot(x0 - xi);
+            }
+        }
+    }
+
+    if (likelihoodTracking)
+    {
+        // Joint density of the stacked innovations under the prior covariance
+        BatchCovariance HPHRl = H * P.template topLeftCorner<3,3>() * H.transpose();
+        HPHRl.diagonal() += Rvec;
+        const Eigen::LDLT<BatchCovariance> ldlt(HPHRl);
+        addLikelihood(error.dot(ldlt.solve(error)), ldlt.vectorD().array().log().sum(), rows);
+    }
+
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        // R is diagonal, so the stacked update is exactly a chain of scalar updates
+        // at the common linearization point (innovations corrected for the state change)
+        const Eigen::Matrix<Scalar, 3, 1> pos0 = S.template head<3>();
+        for (int i = 0; i < rows; i++)
+        {
+            MeasurementRow h = MeasurementRow::Zero();
+            h.template head<3>() = H.row(i);
+            const Scalar e = error(i) - H.row(i).dot(S.template head<3>() - pos0);
+            biermanUpdate(h, e, Rvec(i));
+        }
+        PredictionBound();
+        return;
+    }
+
+    // ====== INNOVATION COVARIANCE ======
+    const BatchGain PHTm = P.template leftCols<3>() * H.transpose(); // PH'
+    BatchCovariance HPHR = H * PHTm.template topRows<3>(); // HPH' + R
+    HPHR.diagonal() += Rvec;
+
+    // ====== MEASUREMENT UPDATE ======
+    const BatchGain K = HPHR.ldlt().solve(PHTm.transpose()).transpose();
+    S.noalias() += K*error;
+
+    // ====== COVARIANCE UPDATE ======
+    // (I-K*H)*P + K*R*K', with H*P = (PH')'
+    P.noalias() -= K*PHTm.transpose();
+    P.noalias() += K*Rvec.asDiagonal()*K.transpose();
+    PredictionBound();
 }
 
-void TDOA::stateEstimatorScalarUpdate(Eigen::RowVectorXf H, float error, float stdMeasNoise)
+/*
+ * Seeds position and covariance from one frame of TDOA pairs.
+ * The pairs are chained into range differences delta_i = r_i - r_ref to the
+ * first reference anchor. Subtracting the reference from |x - a_i|^2 = (r_ref + delta_i)^2
+ * gives the linear system
+ *      2(a_i - a_ref)'x + 2 delta_i r_ref = |a_i|^2 - |a_ref|^2 - delta_i^2
+ * in (x, y, z, r_ref). This is solved in least squares and then refined with a
+ * few Gauss-Newton steps on the TDOA equations themselves, which also give the
+ * position covariance. Returns false, leaving the filter untouched, if the
+ * frame does not constrain the position.
+ */
+template <int NStates, typename Scalar>
+bool TDOAFilter<NStates, Scalar>::initFromFrame(const tdoa_meas_t *meas, size_t count)
 {
+    if (count == 0)
+    {
+        return false;
+    }
+    
+    // Range difference of every anchor to the reference, resolved along the chain of pairs
+    double delta[MAX_NR_ANCHORS];
+    bool known[MAX_NR_ANCHORS] = {false};
+    const int ref = meas[0].Ar;
+    if (ref >= anchorCount)
+    {
+        return false;
+    }
+    delta[ref] = 0;
+    known[ref] = true;
+    
+    int nKnown = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        const int Ar = meas[i].Ar, An = meas[i].An;
+        if ((Ar >= anchorCount) || (An >= anchorCount) || !known[Ar] || known[An])
+        {
+            continue;
+        }
+        delta[An] = delta[Ar] + meas[i].distanceDiff;
+        known[An] = true;
+        nKnown++;
+    }
+    if (nKnown < BOOTSTRAP_MIN_ANCHORS)
+    {
+        return false;
+    }
+    
+    // ====== CLOSED-FORM SOLUTION ======
+    const Eigen::Vector3d aRef = anchorSoA.row(ref).transpose().template cast<double>();
+    Eigen::Matrix<double, Eigen::Dynamic, 4, 0, MAX_NR_ANCHORS, 4> M(nKnown-1, 4);
+    Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MAX_NR_ANCHORS, 1> b(nKnown-1);
+    int row = 0;
+    for (int i = 0; i < MAX_NR_ANCHORS; i++)
+    {
+        if (!known[i] || (i == ref))
+        {
+            continue;
+        }
+        const Eigen::Vector3d ai = anchorSoA.row(i).transpose().template cast<double>();
+        M.row(row).template head<3>() = 2*(ai - aRef).transpose();
+        M(row, 3) = 2*delta[i];
+        b(row) = ai.squaredNorm() - aRef.squaredNorm() - delta[i]*delta[i];
+        row++;
+    }
+    
+    Eigen::ColPivHouseholderQR<Eigen::Matrix<double, Eigen::Dynamic, 4, 0, MAX_NR_ANCHORS, 4> > qr(M);
+    if (qr.rank() < 4)
+    {
+        return false;
+    }
+    Eigen::Vector3d x = qr.solve(b).template head<3>();
+    
+    // ====== GAUSS-NEWTON REFINEMENT ======
+    Eigen::Matrix3d JtJ;
+    for (int iter = 0; iter < BOOTSTRAP_GN_ITERATIONS; iter++)
+    {
+        const Eigen::Vector3d uRef = (x - aRef).normalized();
+        const double dRef = (x - aRef).norm();
+        
+        JtJ.setZero();
+        Eigen::Vector3d Jtr = Eigen::Vector3d::Zero();
+        for (int i = 0; i < MAX_NR_ANCHORS; i++)
+        {
+            if (!known[i] || (i == ref))
+            {
+                continue;
+            }
+            const Eigen::Vector3d ai = anchorSoA.row(i).transpose().template cast<double>();
+            const Eigen::Vector3d h = (x - ai).normalized() - uRef;
+            const double r = delta[i] - ((x - ai).norm() - dRef);
+            JtJ += h*h.transpose();
+            Jtr += h*r;
+        }
+        
+        Eigen::LDLT<Eigen::Matrix3d> ldlt(JtJ);
+        if (ldlt.info() != Eigen::Success)
+        {
+            break;
+        }
+        x += ldlt.solve(Jtr);
+    }
+    
+    if (!x.allFinite())
+    {
+        return false;
+    }
+    
+    // ====== SEED STATE AND COVARIANCE ======
+    // Range differences to the reference are correlated, stdDev per pair is a
+    // conservative scale for the position covariance
+    Eigen::Matrix3d Ppos = (double)(stdDev*stdDev) * JtJ.inverse();
+    if (!Ppos.allFinite())
+    {
+        return false;
+    }
+    
+    S.template head<3>() = x.template cast<Scalar>();
+    S.template segment<3>(STATE_VX).setZero();
+    P.template topRows<3>().setZero();
+    P.template leftCols<3>().setZero();
+    P.template topLeftCorner<3,3>() = Ppos.template cast<Scalar>();
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        factorUD(P, U, D, MIN_COVARIANCE);
+    }
+    PredictionBound();
+    
+    return true;
+}
+
+/*
+ * Rejects the measurement if its normalized innovation error^2/HPHR exceeds the
+ * gate, otherwise inflates stdMeasNoise by the robust weight of |error|/sqrt(HPHR).
+ * Returns false for a rejected measurement.
+ */
+template <int NStates, typename Scalar>
+bool TDOAFilter<NStates, Scalar>::screenMeasurement(uint8_t Ar, uint8_t An, Scalar error, Scalar HPHR, Scalar &stdMeasNoise)
+{
+    const Scalar nis = error*error / HPHR;
+    if ((gateThreshold > 0) && !(nis <= gateThreshold))
+    {
+        if ((Ar < MAX_NR_ANCHORS) && (An < MAX_NR_ANCHORS))
+        {
+            rejectCount[Ar][An]++;
+        }
+        return false;
+    }
+
+    const Scalar r = std::sqrt(nis);
+    Scalar w = 1;
+    if ((robustMode == TDOA_ROBUST_HUBER) && (r > robustK))
+    {
+        w = robustK / r;
+    }
+    else if (robustMode == TDOA_ROBUST_CAUCHY)
+    {
+        w = 1 / (1 + (r/robustK)*(r/robustK));
+    }
+    stdMeasNoise /= std::sqrt(w);
+
+    return true;
+}
+
+template <int NStates, typename Scalar>
+Scalar TDOAFilter<NStates, Scalar>::pairStdDev(uint8_t Ar, uint8_t An)
+{
+    if ((Ar >= MAX_NR_ANCHORS) || (An >= MAX_NR_ANCHORS))
+    {
+        return stdDev;
+    }
+    if (adaptiveNoise)
+    {
+        return std::sqrt(pairVariance(Ar, An));
+    }
+    if (noiseMap)
+    {
+        const Eigen::Matrix<Scalar, 3, 1> site = sitePosition();
+        return stdDev * noiseMap->pairScale(Ar, An, site(0), site(1), site(2));
+    }
+    return stdDev;
+}
+
+// Gaussian log-likelihood of dims innovations with normalized square nis and log|HPH'+R| logDet
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::addLikelihood(Scalar nis, Scalar logDet, int dims)
+{
+    if (likelihoodTracking)
+    {
+        logLikelihood -= 0.5 * ((double)nis + (double)logDet + dims * std::log(2 * M_PI));
+    }
+}
+
+// Innovation of a pair to the consistency monitor and the flight recorder, the NIS of a rejected one is the gate
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::addInnovation(uint8_t Ar, uint8_t An, Scalar error, Scalar HPHR, bool rejected)
+{
+    const Scalar nis = rejected ? (Scalar)gateThreshold : error*error / HPHR;
+    if (consistency)
+    {
+        consistency->addInnovation(Ar, An, (float)nis, rejected);
+    }
+    if (recorder)
+    {
+        flight_record_t r = flightRecord(FLIGHT_RECORD_INNOVATION, recorderTag, stateTime);
+        r.Ar = Ar;
+        r.An = An;
+        r.v[0] = error;
+        r.v[1] = HPHR;
+        r.v[2] = nis;
+        r.v[3] = rejected;
+        recorder->add(r);
+    }
+}
+
+/*
+ * Innovation based noise estimate: E[error^2] = HPH' + R, so error^2 - HPH'
+ * is a one-sample estimate of R. It is averaged with weight adaptiveRate and
+ * bounded to [ADAPTIVE_NOISE_MIN_STD, ADAPTIVE_NOISE_MAX_STD]. Only accepted
+ * measurements are used, before their own update.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::adaptPairNoise(uint8_t Ar, uint8_t An, Scalar error, Scalar HPH)
+{
+    if (!adaptiveNoise || (Ar >= MAX_NR_ANCHORS) || (An >= MAX_NR_ANCHORS))
+    {
+        return;
+    }
+    
+    Scalar &v = pairVariance(Ar, An);
+    v += adaptiveRate * (error*error - HPH - v);
+    v = std::max((Scalar)(ADAPTIVE_NOISE_MIN_STD*ADAPTIVE_NOISE_MIN_STD), std::min(v, (Scalar)(ADAPTIVE_NOISE_MAX_STD*ADAPTIVE_NOISE_MAX_STD)));
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorScalarUpdate(const MeasurementRow &H, Scalar error, Scalar stdMeasNoise)
+{
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        biermanUpdate(H, error, stdMeasNoise*stdMeasNoise);
+        PredictionBound();
+        return;
+    }
+    
     // The Kalman gain as a column vector
-    static Eigen::VectorXf K(nr_states);
+    StateVector K;
 
     // Temporary matrices for the covariance updates
-    static Eigen::VectorXf PHTm(nr_states);
-    static Eigen::MatrixXf I = Eigen::MatrixXf::Identity(nr_states, nr_states);
+    StateVector PHTm;
+    const StateMatrix I = StateMatrix::Identity();
 
     // ====== INNOVATION COVARIANCE ======
     PHTm = P*H.transpose(); // PH'
-    float R = stdMeasNoise*stdMeasNoise;
-    float HPHR = H*PHTm + R; // HPH' + R
+    Scalar R = stdMeasNoise*stdMeasNoise;
+    Scalar HPHR = H.dot(PHTm) + R; // HPH' + R
 
     // ====== MEASUREMENT UPDATE ======
     // Calculate the Kalman gain and perform the state update
@@ -179,21 +989,162 @@ void TDOA::stateEstimatorScalarUpdate(Eigen::RowVectorXf H, float error, float s
     PredictionBound();
 }
 
-void TDOA::stateEstimatorPredict(const double dt)
+/*
+ * TDOA_COVARIANCE_STEADY: the gain of the pair at the nearest node of the
+ * gain table, S += K*error. The gate uses the steady-state HPH'+R of the
+ * node, the robust weights and the adaptive noise are not applied.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::steadyStateUpdate(uint8_t Ar, uint8_t An, float distanceDiff)
+{
+    if (!gainTable || !activePair(Ar, An))
+    {
+        return;
+    }
+    const Eigen::Matrix<Scalar, 3, 1> site = sitePosition();
+    const float *gain = gainTable->gain(gainTable->node(site(0), site(1), site(2)), Ar, An);
+    if (!gain)
+    {
+        return;
+    }
+    
+    const Eigen::Matrix<Scalar, 3, 1> pos = S.template head<3>();
+    const Scalar predicted = (pos - anchorSoA.row(An).transpose()).norm() - (pos - anchorSoA.row(Ar).transpose()).norm();
+    const Scalar error = distanceDiff - predicted;
+    const Scalar s = gain[GAIN_TABLE_S];
+    if ((gateThreshold > 0) && !(error*error <= gateThreshold*s))
+    {
+        rejectCount[Ar][An]++;
+        addLikelihood(gateThreshold, std::log(s), 1);
+        addInnovation(Ar, An, error, s, true);
+        return;
+    }
+    addLikelihood(error*error / s, std::log(s), 1);
+    addInnovation(Ar, An, error, s, false);
+    
+    for (int i = 0; i < STATE_DIM; i++)
+    {
+        S(i) += gain[i] * error;
+    }
+}
+
+/*
+ * Same update as stateEstimatorScalarUpdate for a measurement that only depends
+ * on position (H = [h' 0]). With PH' = P(:,0:2)*h and K = PH'/s, the covariance
+ * update (I-K*H)*P + K*R*K' reduces to P - (1/s - R/s^2)*PH'*PH', so only the
+ * 6x3 position block of P is read and the update is a symmetric rank-1 term.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorPositionUpdate(const Eigen::Matrix<Scalar, 3, 1> &h, Scalar error, Scalar stdMeasNoise)
+{
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        MeasurementRow H = MeasurementRow::Zero();
+        H.template head<3>() = h.transpose();
+        biermanUpdate(H, error, stdMeasNoise*stdMeasNoise);
+        PredictionBound();
+        return;
+    }
+    
+    // Written out in tdoa_lanes.h, TDOAFleet runs the same operations on several filters at once
+    const Scalar R = stdMeasNoise*stdMeasNoise;
+    tdoaPositionUpdate<NStates, Scalar>(S.data(), P.data(), h.data(), error, R);
+    PredictionBound();
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorPredict(const double dt)
+{
+    propagateState(dt);
+    
+    // Covariance update
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        thorntonPredict(A, 0);
+        PredictionBound();
+    }
+    else
+    {
+        predictCovariance();
+    }
+}
+
+/*
+ * P = A*P*A' for the A of propagateState without the dense product: A*P adds
+ * the coupling times the velocity row to each position row and scales the
+ * velocity rows, and the same on the columns completes the product, about
+ * 70 flops instead of 430. Any other A takes the dense product.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::predictCovariance()
+{
+    if (!structuredTransition)
+    {
+        P = A*P*A.transpose();
+        return;
+    }
+    
+    for (int i = 0; i < 3; i++)
+    {
+        const int p = STATE_X + i, v = STATE_VX + i;
+        P.row(p) += A(p,v) * P.row(v);
+        P.row(v) *= A(v,v);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        const int p = STATE_X + i, v = STATE_VX + i;
+        P.col(p) += A(p,v) * P.col(v);
+        P.col(v) *= A(v,v);
+    }
+}
+
+/*
+ * Writes the position/velocity coupling of A for a step of dt and moves the
+ * state forward with it. The velocities are scaled by the diagonal of A, so
+ * a velocity with a zero transition stays at zero like its covariance.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::propagateState(const double dt)
 {
     A(STATE_X,STATE_VX) = dt*A(STATE_VX,STATE_VX);
     A(STATE_Y,STATE_VY) = dt*A(STATE_VY,STATE_VY);
     A(STATE_Z,STATE_VZ) = dt*A(STATE_VZ,STATE_VZ);
-    // Covariance update
-    P = A*P*A.transpose();
     
     // If we had info from IMU, we would add it here
     S[STATE_X] += S[STATE_VX] * dt * A(STATE_VX,STATE_VX);
     S[STATE_Y] += S[STATE_VY] * dt * A(STATE_VY,STATE_VY);
     S[STATE_Z] += S[STATE_VZ] * dt * A(STATE_VZ,STATE_VZ);
+    S[STATE_VX] *= A(STATE_VX,STATE_VX);
+    S[STATE_VY] *= A(STATE_VY,STATE_VY);
+    S[STATE_VZ] *= A(STATE_VZ,STATE_VZ);
+    
+    if (hullMode)
+    {
+        checkHull();
+    }
+}
+
+/*
+ * The containment test of every predict step. The hull is rebuilt here
+ * after the anchors or the origin changed, in the local frame of the state.
+ * Leaving and coming back use margins HULL_HYSTERESIS apart, so a tag on
+ * the hull does not switch on every step.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::checkHull()
+{
+    if (!hullValid)
+    {
+        hull.build(anchorSoA, anchorCount);
+        hullValid = true;
+    }
+    hullDistance = hull.distance(S[STATE_X], S[STATE_Y], S[STATE_Z]);
+    outsideHull = hullDistance > (outsideHull ? hullMargin - (Scalar)HULL_HYSTERESIS : hullMargin);
+    hullNoise = outsideHull ? hullNoiseScale : (Scalar)1;
 }
 
-void TDOA::stateEstimatorFinalize()
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorFinalize()
 {
     // So far nothing happens here
     // Placeholder for future function
@@ -201,44 +1152,359 @@ void TDOA::stateEstimatorFinalize()
     PredictionBound();
 }
 
-void TDOA::stateEstimatorAddProcessNoise()
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorAddProcessNoise()
 {
     // Covariance update
-    P += Q;
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        thorntonPredict(StateMatrix::Identity(), 1);
+    }
+    else
+    {
+        P += Q;
+    }
     
     PredictionBound();
 }
 
-void TDOA::PredictionBound()
+/*
+ * Predicts the state forward to time t (in seconds). Process noise is scaled by
+ * the elapsed time relative to PROCESS_NOISE_STEP. Measurements older than the
+ * current state time are applied without predicting backwards.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::stateEstimatorPredictTo(const double t)
 {
-    //Ensure boundedness and symmetry of Prediction Matrix
-    for (int i=0; i<nr_states; i++) 
+    if (!stateTimeValid)
+    {
+        stateTime = t;
+        stateTimeValid = true;
+        return;
+    }
+    
+    const double dt = t - stateTime;
+    if (dt <= 0)
+    {
+        return;
+    }
+    
+    const Scalar qScale = (Scalar)(dt / PROCESS_NOISE_STEP);
+    if (covarianceMode == TDOA_COVARIANCE_STEADY)
+    {
+        // The gain table already holds the effect of the prediction on P
+        propagateState(dt);
+        stateTime = t;
+        return;
+    }
+    else if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        // Transition and process noise in a single Thornton pass
+        propagateState(dt);
+        thorntonPredict(A, qScale);
+    }
+    else
+    {
+        // Transition and process noise, bounded once below
+        propagateState(dt);
+        predictCovariance();
+        P.noalias() += qScale * Q;
+    }
+    PredictionBound();
+    
+    stateTime = t;
+}
+
+/*
+ * Moves the linearization point to the current position if it drifted more than
+ * GEOMETRY_CACHE_TOL (second order error below 1e-4 m at room scale), or always
+ * when forced. A forced relinearization fills every active anchor in one vector pass.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::relinearizeGeometry(bool force)
+{
+    const Eigen::Matrix<Scalar, 3, 1> pos = S.template head<3>();
+    if (!force && ((pos - cachePoint).squaredNorm() <= (Scalar)(GEOMETRY_CACHE_TOL*GEOMETRY_CACHE_TOL)))
+    {
+        return;
+    }
+    
+    cachePoint = pos;
+    cacheValid = 0;
+    
+    if (force)
+    {
+        const int n = anchorCount;
+        cacheUnit.topRows(n) = (-anchorSoA.topRows(n)).rowwise() + pos.transpose();
+        cacheDist.head(n) = cacheUnit.topRows(n).rowwise().norm();
+        cacheUnit.topRows(n).array().colwise() /= cacheDist.head(n).array();
+        cacheValid = (1u << n) - 1;
+    }
+}
+
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::updateAnchorGeometry(int anc_num)
+{
+    if (cacheValid & (1u << anc_num))
     {
-        for (int j=i; j<nr_states; j++) 
+        return;
+    }
+    
+    const Eigen::Matrix<Scalar, 1, 3> diff = cachePoint.transpose() - anchorSoA.row(anc_num);
+    cacheDist(anc_num) = diff.norm();
+    cacheUnit.row(anc_num) = diff / cacheDist(anc_num);
+    cacheValid |= (1u << anc_num);
+}
+
+/*
+ * Range difference |pos - a_An| - |pos - a_Ar| and its position gradient h,
+ * computed directly rather than through the geometry cache.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::pairGeometry(uint8_t Ar, uint8_t An, const Eigen::Matrix<Scalar, 3, 1> &pos, Eigen::Matrix<Scalar, 3, 1> &h, Scalar &dist)
+{
+    const Eigen::Matrix<Scalar, 3, 1> dn = pos - anchorSoA.row(An).transpose();
+    const Eigen::Matrix<Scalar, 3, 1> dr = pos - anchorSoA.row(Ar).transpose();
+    const Scalar rn = dn.norm();
+    const Scalar rr = dr.norm();
+    h = dn/rn - dr/rr;
+    dist = rn - rr;
+}
+
+/*
+ * Iterated EKF for one pair. Starting from the EKF linearization (hp, error) at
+ * the prior position x0, the position the update would reach is computed and the
+ * measurement relinearized there, with error = z - h(x_i) - hp'(x0 - x_i), until the
+ * iterate moves less than IEKF_STEP_TOL or maxIterations is reached. The caller
+ * then applies the final (hp, error) as a normal update, so the covariance uses
+ * the Jacobian at the last iterate.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::iterateLinearization(uint8_t Ar, uint8_t An, Scalar measurement, Scalar R, Eigen::Matrix<Scalar, 3, 1> &hp, Scalar &error)
+{
+    const Eigen::Matrix<Scalar, 3, 1> x0 = S.template head<3>();
+    Eigen::Matrix<Scalar, 3, 1> xi = x0;
+    for (int it = 0; it < maxIterations; it++)
+    {
+        // Only the position part of the gain moves the linearization point
+        const Eigen::Matrix<Scalar, 3, 1> PHp = P.template topLeftCorner<3,3>() * hp;
+        const Scalar HPHR = hp.dot(PHp) + R;
+        const Eigen::Matrix<Scalar, 3, 1> next = x0 + PHp * (error / HPHR);
+        if ((next - xi).squaredNorm() < (Scalar)(IEKF_STEP_TOL*IEKF_STEP_TOL))
         {
-            float p = 0.5f*P(i,j) + 0.5f*P(j,i);
-            if (std::isnan(p) || (p > MAX_COVARIANCE) ) 
-            {
-                P(i,j) = P(j,i) = MAX_COVARIANCE;
-            } 
-            else if ( (i==j) && (p < MIN_COVARIANCE) ) 
+            break;
+        }
+        xi = next;
+        
+        Scalar dist;
+        pairGeometry(Ar, An, xi, hp, dist);
+        error = measurement - dist - hp.dot(x0 - xi);
+    }
+}
+
+/*
+ * In the full mode P is symmetrized and its entries bounded. In the UD mode the
+ * factors already keep P symmetric positive definite, so P is only refreshed
+ * from U*D*U'.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::PredictionBound()
+{
+    if (covarianceMode == TDOA_COVARIANCE_UD)
+    {
+        P.noalias() = U * D.asDiagonal() * U.transpose();
+        // Same variance floor as the full mode, added as positive rank-1 terms
+        for (int i = 0; i < NStates; i++)
+        {
+            if (P(i,i) < MIN_COVARIANCE)
             {
-                P(i,j) = P(j,i) = MIN_COVARIANCE;
-            } 
-            else 
+                rankOneUpdate(StateVector::Unit(i), MIN_COVARIANCE - P(i,i));
+                P.noalias() = U * D.asDiagonal() * U.transpose();
+            }
+        }
+        return;
+    }
+    
+    //Ensure boundedness and symmetry of Prediction Matrix
+    tdoaBoundCovariance<NStates, Scalar>(P.data(), MAX_COVARIANCE, MIN_COVARIANCE);
+}
+
+/*
+ * UD factorization M = Uf*diag(Df)*Uf' of the upper triangle of M, from the last
+ * column backwards. Pivots below minPivot are raised to it; if minPivot is 0 a
+ * zero pivot leaves its column of Uf empty, as for the unexcited states of Q.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::factorUD(const StateMatrix &M, StateMatrix &Uf, StateVector &Df, Scalar minPivot)
+{
+    Uf.setIdentity();
+    for (int j = NStates-1; j >= 0; j--)
+    {
+        Scalar d = M(j,j);
+        for (int k = j+1; k < NStates; k++)
+        {
+            d -= Uf(j,k)*Uf(j,k)*Df(k);
+        }
+        if (!(d > minPivot))
+        {
+            d = minPivot;
+        }
+        Df(j) = d;
+        if (d <= 0)
+        {
+            continue;
+        }
+        
+        for (int i = 0; i < j; i++)
+        {
+            Scalar m = M(i,j);
+            for (int k = j+1; k < NStates; k++)
             {
-                P(i,j) = P(j,i) = p;
+                m -= Uf(i,k)*Uf(j,k)*Df(k);
             }
+            Uf(i,j) = m / d;
         }
     }
 }
 
-vec3d_t TDOA::getLocation()
+/*
+ * Bierman scalar measurement update of U, D and the state. With f = U'*H' and
+ * v = D*f the innovation variance is accumulated one state at a time, so every
+ * D(j) is scaled by a ratio of two positive variances and cannot turn negative.
+ * This gives (I-K*H)*P; the K*R*K' term of the full mode is then added as a
+ * rank-1 update so both modes run the same filter.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::biermanUpdate(const MeasurementRow &H, Scalar error, Scalar R)
+{
+    const StateVector f = U.transpose() * H.transpose();
+    const StateVector v = D.cwiseProduct(f);
+    
+    // Unnormalized gain, K = b/alpha once all states are folded in
+    StateVector b = StateVector::Zero();
+    Scalar alpha = R + v(0)*f(0);
+    D(0) *= R / alpha;
+    b(0) = v(0);
+    for (int j = 1; j < NStates; j++)
+    {
+        const Scalar beta = alpha;
+        alpha += v(j)*f(j);
+        const Scalar lambda = -f(j) / beta;
+        D(j) *= beta / alpha;
+        for (int i = 0; i < j; i++)
+        {
+            const Scalar u = U(i,j);
+            U(i,j) = u + b(i)*lambda;
+            b(i) += v(j)*u;
+        }
+        b(j) = v(j);
+    }
+    
+    S += b * (error / alpha);
+    
+    // K*R*K' with K = b/alpha
+    rankOneUpdate(b, R / (alpha*alpha));
+}
+
+/*
+ * Agee-Turner update of the factors to U*D*U' + c*a*a' for c >= 0. Each D(j)
+ * only grows, so the factors stay positive definite.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::rankOneUpdate(StateVector a, Scalar c)
+{
+    for (int j = NStates-1; j > 0; j--)
+    {
+        const Scalar s = a(j);
+        const Scalar d = D(j) + c*s*s;
+        if (!(d > 0))
+        {
+            continue;
+        }
+        const Scalar beta = c*s / d;
+        c *= D(j) / d;
+        D(j) = d;
+        for (int i = 0; i < j; i++)
+        {
+            a(i) -= s*U(i,j);
+            U(i,j) += beta*a(i);
+        }
+    }
+    D(0) += c*a(0)*a(0);
+}
+
+/*
+ * Thornton time update P = Phi*P*Phi' + qScale*Q on the factors. The columns of
+ * W = [Phi*U  Uq] are weighted by [D  qScale*Dq] and made orthogonal with modified
+ * weighted Gram-Schmidt from the last row up, which gives the new U and D directly.
+ */
+template <int NStates, typename Scalar>
+void TDOAFilter<NStates, Scalar>::thorntonPredict(const StateMatrix &Phi, Scalar qScale)
+{
+    Eigen::Matrix<Scalar, NStates, 2*NStates> W;
+    W.template leftCols<NStates>().noalias() = Phi * U;
+    W.template rightCols<NStates>() = Uq;
+    Eigen::Matrix<Scalar, 2*NStates, 1> Dw;
+    Dw.template head<NStates>() = D;
+    Dw.template tail<NStates>() = qScale * Dq;
+    
+    for (int j = NStates-1; j >= 0; j--)
+    {
+        const Eigen::Matrix<Scalar, 1, 2*NStates> wd = W.row(j).cwiseProduct(Dw.transpose());
+        const Scalar sigma = wd.dot(W.row(j));
+        
+        U.col(j).setZero();
+        U(j,j) = 1;
+        D(j) = sigma;
+        if (!(sigma > 0))
+        {
+            D(j) = 0;
+            continue;
+        }
+        
+        for (int i = 0; i < j; i++)
+        {
+            U(i,j) = W.row(i).dot(wd) / sigma;
+            W.row(i) -= U(i,j) * W.row(j);
+        }
+    }
+}
+
+template <int NStates, typename Scalar>
+double TDOAFilter<NStates, Scalar>::getTime()
+{
+    return stateTime;
+}
+
+template <int NStates, typename Scalar>
+typename TDOAFilter<NStates, Scalar>::StateMatrix TDOAFilter<NStates, Scalar>::getCovariance()
+{
+    if ((covarianceMode != TDOA_COVARIANCE_STEADY) || !gainTable)
+    {
+        return P;
+    }
+    
+    // Steady-state covariance of the nearest node, only looked up when asked for
+    StateMatrix C = P;
+    const Eigen::Matrix<Scalar, 3, 1> site = sitePosition();
+    const float *c = GainTable::covariance(gainTable->node(site(0), site(1), site(2)));
+    for (int i = 0; i < STATE_DIM; i++)
+    {
+        for (int j = i; j < STATE_DIM; j++)
+        {
+            C(i,j) = C(j,i) = *c++;
+        }
+    }
+    return C;
+}
+
+template <int NStates, typename Scalar>
+vec3d_t TDOAFilter<NStates, Scalar>::getLocation()
 {
     vec3d_t pos;
-    pos.x = S(STATE_X);
-    pos.y = S(STATE_Y);
-    pos.z = S(STATE_Z);
+    pos.x = S(STATE_X) + origin.x();
+    pos.y = S(STATE_Y) + origin.y();
+    pos.z = S(STATE_Z) + origin.z();
     
     //For debugging purposes:
 //    std::cout << S.transpose() << std::endl;
@@ -246,7 +1512,22 @@ vec3d_t TDOA::getLocation()
     return pos;
 }
 
-vec3d_t TDOA::getVelocity()
+template <int NStates, typename Scalar>
+typename TDOAFilter<NStates, Scalar>::StateVector TDOAFilter<NStates, Scalar>::getState()
+{
+    return S;
+}
+
+template <int NStates, typename Scalar>
+double TDOAFilter<NStates, Scalar>::takeLogLikelihood()
+{
+    const double ll = logLikelihood;
+    logLikelihood = 0;
+    return ll;
+}
+
+template <int NStates, typename Scalar>
+vec3d_t TDOAFilter<NStates, Scalar>::getVelocity()
 {
     vec3d_t vel;
     vel.x = S(STATE_VX);
@@ -256,4 +1537,7 @@ vec3d_t TDOA::getVelocity()
     return vel;
 }
 
-
+// Supported filter configurations
+template class TDOAFilter<STATE_DIM, float>;
+template class TDOAFilter<STATE_DIM, double>;
+template class TDOAFilter<INERTIAL_STATE_DIM, float>;
@@ -0,0 +1,456 @@
+/*************************************************
+ *
+ *  Columnar capture archive, see tdoa_archive.h
+ *
+ *************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <climits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "tdoa_archive.h"
+#include "work_pool.h"
+
+#define ARCHIVE_NAN_CODE    ((int64_t)INT32_MIN)    // Quantized code of a value that is not finite
+
+static void putVarint(std::vector<uint8_t> &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static void putSigned(std::vector<uint8_t> &out, int64_t v)
+{
+    putVarint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+// Sequential decoding of one inflated column, reads past the end return zero and set bad
+struct ColumnCursor
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    bool bad;
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (p >= end)
+            {
+                bad = true;
+                return 0;
+            }
+            const uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+            {
+                return v;
+            }
+        }
+        bad = true;
+        return v;
+    }
+
+    int64_t signedVarint()
+    {
+        const uint64_t z = varint();
+        return (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+    }
+
+    uint8_t byte()
+    {
+        if (p >= end)
+        {
+            bad = true;
+            return 0;
+        }
+        return *p++;
+    }
+};
+
+static int64_t quantize(float value, double lsb)
+{
+    if (!std::isfinite(value))
+    {
+        return ARCHIVE_NAN_CODE;
+    }
+    const double q = std::round(value / lsb);
+    return (int64_t)std::max((double)(INT32_MIN + 1), std::min(q, (double)INT32_MAX));
+}
+
+static float dequantize(int64_t code, double lsb)
+{
+    return (code == ARCHIVE_NAN_CODE) ? NAN : (float)(code * lsb);
+}
+
+// The columns of records, before deflating
+static void encodeColumns(const std::vector<tdoa_capture_record_t> &records, std::vector<uint8_t> *col)
+{
+    uint64_t time = 0;
+    for (const tdoa_capture_record_t &r : records)
+    {
+        putSigned(col[ARCHIVE_COL_TIME], (int64_t)(r.timeUs - time));
+        time = r.timeUs;
+    }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        int64_t last = 0;
+        for (const tdoa_capture_record_t &r : records)
+        {
+            const int64_t q = quantize(r.vicon[axis], ARCHIVE_VICON_LSB);
+            putSigned(col[ARCHIVE_COL_VICON], q - last);
+            last = q;
+        }
+    }
+
+    for (const tdoa_capture_record_t &r : records)
+    {
+        putVarint(col[ARCHIVE_COL_VALID], r.valid);
+    }
+
+    for (int k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+    {
+        int64_t lastTdoa = 0, lastArrival = 0;
+        for (const tdoa_capture_record_t &r : records)
+        {
+            if (!(r.valid & (1u << k)))
+            {
+                continue;
+            }
+            const int64_t q = quantize(r.tdoa[k], ARCHIVE_TDOA_LSB);
+            putSigned(col[ARCHIVE_COL_TDOA], q - lastTdoa);
+            lastTdoa = q;
+            col[ARCHIVE_COL_REF].push_back(r.ref[k]);
+            putSigned(col[ARCHIVE_COL_ARRIVAL], (int64_t)r.arrivalUs[k] - lastArrival);
+            lastArrival = r.arrivalUs[k];
+        }
+    }
+}
+
+// Fills the fields of the columns in mask, valid must be decoded before the per slot ones
+static bool decodeColumn(int c, const std::vector<uint8_t> &raw, tdoa_capture_record_t *out, size_t n)
+{
+    ColumnCursor in = { raw.data(), raw.data() + raw.size(), false };
+    switch (c)
+    {
+    case ARCHIVE_COL_TIME:
+    {
+        uint64_t time = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            time += (uint64_t)in.signedVarint();
+            out[i].timeUs = time;
+        }
+        break;
+    }
+    case ARCHIVE_COL_VICON:
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int64_t q = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                q += in.signedVarint();
+                out[i].vicon[axis] = dequantize(q, ARCHIVE_VICON_LSB);
+            }
+        }
+        break;
+    case ARCHIVE_COL_VALID:
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i].valid = (uint32_t)in.varint();
+        }
+        break;
+    default:
+        for (int k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+        {
+            int64_t q = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (!(out[i].valid & (1u << k)))
+                {
+                    continue;
+                }
+                if (c == ARCHIVE_COL_TDOA)
+                {
+                    q += in.signedVarint();
+                    out[i].tdoa[k] = dequantize(q, ARCHIVE_TDOA_LSB);
+                }
+                else if (c == ARCHIVE_COL_REF)
+                {
+                    out[i].ref[k] = in.byte();
+                }
+                else
+                {
+                    q += in.signedVarint();
+                    out[i].arrivalUs[k] = (uint32_t)q;
+                }
+            }
+        }
+        break;
+    }
+    return !in.bad && (in.p == in.end);
+}
+
+TDOAArchiveWriter::TDOAArchiveWriter() : file(NULL), failed(false), offset(0), records(0)
+{
+}
+
+TDOAArchiveWriter::~TDOAArchiveWriter()
+{
+    close();
+}
+
+bool TDOAArchiveWriter::open(const std::string &path, const tdoa_capture_header_t &capture)
+{
+    close();
+
+    // O_EXCL so an existing archive is never overwritten
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    file = fdopen(fd, "wb");
+    if (file == NULL)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    tdoa_archive_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TDOA_ARCHIVE_MAGIC;
+    header.version = TDOA_ARCHIVE_VERSION;
+    header.columns = ARCHIVE_COLUMNS;
+    header.chunkRecords = ARCHIVE_CHUNK_RECORDS;
+    header.tdoaLsb = ARCHIVE_TDOA_LSB;
+    header.viconLsb = ARCHIVE_VICON_LSB;
+    header.capture = capture;
+
+    failed = false;
+    offset = 0;
+    records = 0;
+    chunk.clear();
+    chunk.reserve(ARCHIVE_CHUNK_RECORDS);
+    index.clear();
+    return write(&header, sizeof(header));
+}
+
+bool TDOAArchiveWriter::write(const void *data, size_t len)
+{
+    if (failed || (fwrite(data, 1, len, file) != len))
+    {
+        failed = true;
+        return false;
+    }
+    offset += len;
+    return true;
+}
+
+bool TDOAArchiveWriter::append(const tdoa_capture_record_t &record)
+{
+    if ((file == NULL) || failed)
+    {
+        return false;
+    }
+    chunk.push_back(record);
+    records++;
+    return (chunk.size() < ARCHIVE_CHUNK_RECORDS) || flushChunk();
+}
+
+bool TDOAArchiveWriter::flushChunk()
+{
+    if (chunk.empty())
+    {
+        return true;
+    }
+
+    tdoa_archive_chunk_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = offset;
+    entry.records = chunk.size();
+    entry.firstTimeUs = chunk.front().timeUs;
+    entry.lastTimeUs = chunk.back().timeUs;
+
+    std::vector<uint8_t> col[ARCHIVE_COLUMNS];
+    encodeColumns(chunk, col);
+    for (int c = 0; c < ARCHIVE_COLUMNS; c++)
+    {
+        uLongf len = compressBound(col[c].size());
+        std::vector<uint8_t> packed(len);
+        if (compress2(packed.data(), &len, col[c].data(), col[c].size(), ARCHIVE_ZLIB_LEVEL) != Z_OK)
+        {
+            failed = true;
+            return false;
+        }
+        entry.size[c] = len;
+        entry.rawSize[c] = col[c].size();
+        if (!write(packed.data(), len))
+        {
+            return false;
+        }
+    }
+    index.push_back(entry);
+    chunk.clear();
+    return true;
+}
+
+bool TDOAArchiveWriter::close()
+{
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    flushChunk();
+    tdoa_archive_footer_t footer;
+    footer.indexOffset = offset;
+    footer.chunks = index.size();
+    footer.magic = TDOA_ARCHIVE_MAGIC;
+    if (!index.empty())
+    {
+        write(index.data(), index.size() * sizeof(tdoa_archive_chunk_t));
+    }
+    write(&footer, sizeof(footer));
+
+    const bool ok = !failed && (fclose(file) == 0);
+    file = NULL;
+    return ok;
+}
+
+// Reads all of len at offset, retrying short reads
+static bool readAt(int fd, void *data, size_t len, uint64_t offset)
+{
+    uint8_t *p = (uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = pread(fd, p, len, offset);
+        if (n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+TDOAArchiveReader::TDOAArchiveReader() : fd(-1), count(0)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+TDOAArchiveReader::~TDOAArchiveReader()
+{
+    close();
+}
+
+bool TDOAArchiveReader::open(const std::string &path)
+{
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    const off_t len = lseek(fd, 0, SEEK_END);
+    tdoa_archive_footer_t footer;
+    if ((len < (off_t)(sizeof(header) + sizeof(footer))) || !readAt(fd, &header, sizeof(header), 0)
+        || !readAt(fd, &footer, sizeof(footer), len - sizeof(footer))
+        || (header.magic != TDOA_ARCHIVE_MAGIC) || (header.version != TDOA_ARCHIVE_VERSION)
+        || (header.columns != ARCHIVE_COLUMNS) || (footer.magic != TDOA_ARCHIVE_MAGIC)
+        || (footer.indexOffset + (uint64_t)footer.chunks * sizeof(tdoa_archive_chunk_t) + sizeof(footer) != (uint64_t)len))
+    {
+        close();
+        return false;
+    }
+
+    index.resize(footer.chunks);
+    if (!index.empty() && !readAt(fd, index.data(), index.size() * sizeof(tdoa_archive_chunk_t), footer.indexOffset))
+    {
+        close();
+        return false;
+    }
+    first.resize(index.size());
+    count = 0;
+    for (size_t c = 0; c < index.size(); c++)
+    {
+        first[c] = count;
+        count += index[c].records;
+    }
+    return true;
+}
+
+void TDOAArchiveReader::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    index.clear();
+    first.clear();
+    count = 0;
+}
+
+bool TDOAArchiveReader::readChunk(size_t c, uint32_t columns, tdoa_capture_record_t *out) const
+{
+    if ((fd < 0) || (c >= index.size()))
+    {
+        return false;
+    }
+    const tdoa_archive_chunk_t &entry = index[c];
+    if (columns & (ARCHIVE_COLUMN(ARCHIVE_COL_TDOA) | ARCHIVE_COLUMN(ARCHIVE_COL_REF) | ARCHIVE_COLUMN(ARCHIVE_COL_ARRIVAL)))
+    {
+        columns |= ARCHIVE_COLUMN(ARCHIVE_COL_VALID);
+    }
+    memset(out, 0, entry.records * sizeof(tdoa_capture_record_t));
+
+    // Columns lie in order, so valid is decoded before the per slot ones
+    uint64_t at = entry.offset;
+    std::vector<uint8_t> packed, raw;
+    for (int col = 0; col < ARCHIVE_COLUMNS; col++)
+    {
+        const uint64_t start = at;
+        at += entry.size[col];
+        if (!(columns & ARCHIVE_COLUMN(col)))
+        {
+            continue;
+        }
+        packed.resize(entry.size[col]);
+        raw.resize(entry.rawSize[col]);
+        uLongf rawLen = raw.size();
+        if (!readAt(fd, packed.data(), packed.size(), start)
+            || (uncompress(raw.data(), &rawLen, packed.data(), packed.size()) != Z_OK) || (rawLen != raw.size())
+            || !decodeColumn(col, raw, out, entry.records))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TDOAArchiveReader::readAll(uint32_t columns, std::vector<tdoa_capture_record_t> &out, unsigned threads) const
+{
+    out.resize(count);
+    std::vector<uint8_t> ok(index.size(), 0);
+    WorkStealingPool pool(threads);
+    pool.run(index.size(), [&](size_t c, unsigned)
+    {
+        ok[c] = readChunk(c, columns, out.data() + first[c]);
+    });
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
@@ -0,0 +1,347 @@
+/*************************************************
+ *
+ *  Binary capture writer and reader, see tdoa_capture.h
+ *
+ *************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tdoa_capture.h"
+
+#define CAPTURE_BLOCK_ALIGN 4096
+
+tdoa_capture_header_t makeCaptureHeader()
+{
+    tdoa_capture_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TDOA_CAPTURE_MAGIC;
+    header.version = TDOA_CAPTURE_VERSION;
+    header.recordSize = sizeof(tdoa_capture_record_t);
+    return header;
+}
+
+int formatCaptureRow(const tdoa_capture_record_t &r, char *buf, size_t len)
+{
+    float d[TDOA_CAPTURE_MAX_ANCHORS];
+    for (int k = 0; k < TDOA_CAPTURE_MAX_ANCHORS; k++)
+    {
+        d[k] = (r.valid & (1u << k)) ? r.tdoa[k] : NAN;
+    }
+    return snprintf(buf, len, "%llu, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, %.8g, "
+                    "%u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u, %u\r\n",
+                    (unsigned long long)r.timeUs, r.vicon[0], r.vicon[1], r.vicon[2],
+                    d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7],
+                    r.ref[0], r.ref[1], r.ref[2], r.ref[3], r.ref[4], r.ref[5], r.ref[6], r.ref[7],
+                    r.arrivalUs[0], r.arrivalUs[1], r.arrivalUs[2], r.arrivalUs[3],
+                    r.arrivalUs[4], r.arrivalUs[5], r.arrivalUs[6], r.arrivalUs[7]);
+}
+
+// Writes all of len, retrying short writes
+static bool writeAll(int fd, const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+TDOACaptureWriter::TDOACaptureWriter() : fd(-1), running(false), records(0), drops(0)
+{
+    active.data = NULL;
+    active.len = 0;
+}
+
+TDOACaptureWriter::~TDOACaptureWriter()
+{
+    close();
+}
+
+bool TDOACaptureWriter::open(const std::string &path, const tdoa_capture_header_t &header)
+{
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (!writeAll(fd, (const uint8_t *)&header, sizeof(header)))
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    for (int i = 0; i < CAPTURE_BLOCK_COUNT; i++)
+    {
+        block_t block;
+        if (posix_memalign((void **)&block.data, CAPTURE_BLOCK_ALIGN, CAPTURE_BLOCK_SIZE) != 0)
+        {
+            close();
+            return false;
+        }
+        block.len = 0;
+        freeBlocks.push_back(block);
+    }
+    active = freeBlocks.back();
+    freeBlocks.pop_back();
+
+    running = true;
+    writer = std::thread(&TDOACaptureWriter::writerLoop, this);
+    return true;
+}
+
+void TDOACaptureWriter::close()
+{
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            running = false;
+        }
+        ready.notify_one();
+        writer.join();
+    }
+
+    // The writer thread has drained everything that was queued, only the active block is left
+    if ((fd >= 0) && (active.data != NULL) && (active.len > 0))
+    {
+        writeAll(fd, active.data, active.len);
+    }
+    if (fd >= 0)
+    {
+        fsync(fd);
+        ::close(fd);
+        fd = -1;
+    }
+
+    free(active.data);
+    active.data = NULL;
+    active.len = 0;
+    for (size_t i = 0; i < freeBlocks.size(); i++)
+    {
+        free(freeBlocks[i].data);
+    }
+    freeBlocks.clear();
+}
+
+bool TDOACaptureWriter::append(const tdoa_capture_record_t &record)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    if (active.data == NULL)
+    {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (active.len + sizeof(record) > CAPTURE_BLOCK_SIZE)
+    {
+        if (freeBlocks.empty())
+        {
+            // Disk is behind by the whole pool
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        fullBlocks.push_back(active);
+        active = freeBlocks.back();
+        freeBlocks.pop_back();
+        active.len = 0;
+        guard.unlock();
+        ready.notify_one();
+        guard.lock();
+    }
+
+    memcpy(active.data + active.len, &record, sizeof(record));
+    active.len += sizeof(record);
+    records.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TDOACaptureWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (running || !fullBlocks.empty())
+    {
+        if (fullBlocks.empty())
+        {
+            bool woken = ready.wait_for(guard, std::chrono::milliseconds(CAPTURE_FLUSH_MS),
+                                        [this]{ return !running || !fullBlocks.empty(); });
+
+            // Nothing filled up for a while, push out the partial block so a crash loses little
+            if (!woken && (active.len > 0) && !freeBlocks.empty())
+            {
+                fullBlocks.push_back(active);
+                active = freeBlocks.back();
+                freeBlocks.pop_back();
+                active.len = 0;
+            }
+            continue;
+        }
+
+        block_t block = fullBlocks.front();
+        fullBlocks.pop_front();
+
+        guard.unlock();
+        writeAll(fd, block.data, block.len);
+        guard.lock();
+
+        block.len = 0;
+        freeBlocks.push_back(block);
+    }
+}
+
+TDOACaptureReader::TDOACaptureReader() : file(NULL)
+{
+    memset(&header, 0, sizeof(header));
+}
+
+TDOACaptureReader::~TDOACaptureReader()
+{
+    close();
+}
+
+bool TDOACaptureReader::open(const std::string &path)
+{
+    close();
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    if ((fread(&header, sizeof(header), 1, file) != 1) || (header.magic != TDOA_CAPTURE_MAGIC)
+        || (header.version != TDOA_CAPTURE_VERSION) || (header.recordSize != sizeof(tdoa_capture_record_t)))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TDOACaptureReader::close()
+{
+    if (file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+bool TDOACaptureReader::next(tdoa_capture_record_t &record)
+{
+    // A record cut short by a crash is ignored
+    return (file != NULL) && (fread(&record, sizeof(record), 1, file) == 1);
+}
+
+TDOACaptureMap::TDOACaptureMap() : base(MAP_FAILED), mappedLen(0), header(NULL), data(NULL), count(0)
+{
+}
+
+TDOACaptureMap::~TDOACaptureMap()
+{
+    close();
+}
+
+bool TDOACaptureMap::open(const std::string &path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(tdoa_capture_header_t)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    mappedLen = st.st_size;
+    base = mmap(NULL, mappedLen, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (base == MAP_FAILED)
+    {
+        mappedLen = 0;
+        return false;
+    }
+
+    header = (const tdoa_capture_header_t *)base;
+    if ((header->magic != TDOA_CAPTURE_MAGIC) || (header->version != TDOA_CAPTURE_VERSION)
+        || (header->recordSize != sizeof(tdoa_capture_record_t)))
+    {
+        close();
+        return false;
+    }
+
+    // A record cut short by a crash is left out
+    data = (const tdoa_capture_record_t *)((const uint8_t *)base + sizeof(tdoa_capture_header_t));
+    count = (mappedLen - sizeof(tdoa_capture_header_t)) / sizeof(tdoa_capture_record_t);
+    madvise(base, mappedLen, MADV_SEQUENTIAL);
+
+    index.reserve(count / CAPTURE_INDEX_STRIDE + 1);
+    for (size_t i = 0; i < count; i += CAPTURE_INDEX_STRIDE)
+    {
+        index.push_back(data[i].timeUs);
+    }
+    return true;
+}
+
+void TDOACaptureMap::close()
+{
+    if (base != MAP_FAILED)
+    {
+        munmap(base, mappedLen);
+    }
+    base = MAP_FAILED;
+    mappedLen = 0;
+    header = NULL;
+    data = NULL;
+    count = 0;
+    index.clear();
+}
+
+tdoa_capture_span_t TDOACaptureMap::records() const
+{
+    tdoa_capture_span_t span = {data, count};
+    return span;
+}
+
+size_t TDOACaptureMap::lowerBound(uint64_t timeUs) const
+{
+    // Last stride starting before timeUs, the answer is inside it or at the start of the next one
+    size_t stride = std::lower_bound(index.begin(), index.end(), timeUs) - index.begin();
+    if (stride == 0)
+    {
+        return 0;
+    }
+    size_t first = (stride - 1) * CAPTURE_INDEX_STRIDE;
+    size_t last = std::min(count, first + CAPTURE_INDEX_STRIDE);
+
+    const tdoa_capture_record_t *it = std::lower_bound(data + first, data + last, timeUs,
+        [](const tdoa_capture_record_t &r, uint64_t t){ return r.timeUs < t; });
+    return it - data;
+}
+
+tdoa_capture_span_t TDOACaptureMap::window(uint64_t fromUs, uint64_t toUs) const
+{
+    size_t first = lowerBound(fromUs);
+    size_t last = std::max(first, lowerBound(toUs));
+    tdoa_capture_span_t span = {data + first, last - first};
+    return span;
+}
@@ -0,0 +1,81 @@
+/*************************************************
+ *
+ *  Lockstep filter updates, see tdoa_fleet.h
+ *
+ *************************************************/
+
+#include "tdoa_fleet.h"
+
+void TDOAFleet::apply(const FleetUpdate *updates, size_t count)
+{
+    for (size_t i = 0; i < count; i += TDOA_FLEET_LANES)
+    {
+        applyBlock(updates + i, std::min(count - i, (size_t)TDOA_FLEET_LANES));
+    }
+}
+
+/*
+ * Lanes past the last update get a null measurement (h = 0, R = 1) and are
+ * not written back.
+ */
+void TDOAFleet::applyBlock(const FleetUpdate *updates, int lanes)
+{
+    const int N = STATE_DIM;
+    FleetLane S[N], P[N*N], h[3];
+    FleetLane error, R;
+
+    // ====== GATHER ======
+    for (int l = 0; l < TDOA_FLEET_LANES; l++)
+    {
+        if (l >= lanes)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                S[i](l) = 0;
+            }
+            for (int i = 0; i < N*N; i++)
+            {
+                P[i](l) = (i % (N+1) == 0) ? 1 : 0;
+            }
+            h[0](l) = h[1](l) = h[2](l) = 0;
+            error(l) = 0;
+            R(l) = 1;
+            continue;
+        }
+        const FleetUpdate &u = updates[l];
+        const float *s = u.filter->S.data();
+        const float *p = u.filter->P.data();
+        for (int i = 0; i < N; i++)
+        {
+            S[i](l) = s[i];
+        }
+        for (int i = 0; i < N*N; i++)
+        {
+            P[i](l) = p[i];
+        }
+        h[0](l) = u.h.x();
+        h[1](l) = u.h.y();
+        h[2](l) = u.h.z();
+        error(l) = u.error;
+        R(l) = u.stdMeasNoise*u.stdMeasNoise;
+    }
+
+    // ====== UPDATE ======
+    tdoaPositionUpdate<N, FleetLane>(S, P, h, error, R);
+    tdoaBoundCovariance<N, FleetLane>(P, MAX_COVARIANCE, MIN_COVARIANCE);
+
+    // ====== SCATTER ======
+    for (int l = 0; l < lanes; l++)
+    {
+        float *s = updates[l].filter->S.data();
+        float *p = updates[l].filter->P.data();
+        for (int i = 0; i < N; i++)
+        {
+            s[i] = S[i](l);
+        }
+        for (int i = 0; i < N*N; i++)
+        {
+            p[i] = P[i](l);
+        }
+    }
+}
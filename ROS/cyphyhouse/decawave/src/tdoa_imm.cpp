@@ -0,0 +1,308 @@
+/*************************************************
+ *
+ *  IMM estimator, see tdoa_imm.h
+ *
+ *************************************************/
+
+#include "tdoa_imm.h"
+
+TDOAIMM::TDOAIMM() : count(0), switchRate(IMM_SWITCH_RATE)
+{
+    for (int k = 0; k < IMM_MAX_MODELS; k++)
+    {
+        mu[k] = 0;
+    }
+}
+
+/*
+ * Noise is only added on the axes the robot model lets move (non-zero
+ * velocity transition), a car keeps its fixed height in every model.
+ */
+bool TDOAIMM::addModel(const TDOA &base, const TDOA::DynamicMatrix &A, const TDOA::DynamicMatrix &Q, imm_model_t type)
+{
+    if (count >= IMM_MAX_MODELS)
+    {
+        return false;
+    }
+
+    TDOA::DynamicMatrix Am = A, Qm = Q;
+    for (int i = 0; i < 3; i++)
+    {
+        if (A(STATE_VX + i, STATE_VX + i) == 0)
+        {
+            continue;
+        }
+        switch (type)
+        {
+            case IMM_MODEL_STATIONARY:
+                Am(STATE_VX + i, STATE_VX + i) = 0;
+                Qm(STATE_X + i, STATE_X + i) += IMM_STATIONARY_POS_NOISE;
+                break;
+            case IMM_MODEL_CV:
+                Qm(STATE_VX + i, STATE_VX + i) += IMM_CV_VEL_NOISE;
+                break;
+            case IMM_MODEL_MANEUVER:
+                Qm(STATE_VX + i, STATE_VX + i) += IMM_MANEUVER_VEL_NOISE;
+                break;
+        }
+    }
+
+    TDOA &m = models[count];
+    m = base;
+    m.setTransitionMat(Am);
+    m.setCovarianceMat(Qm);
+    m.setLikelihoodTracking(true);
+    count++;
+
+    for (int k = 0; k < count; k++)
+    {
+        mu[k] = 1.0 / count;
+    }
+    return true;
+}
+
+void TDOAIMM::setSwitchRate(double rate)
+{
+    switchRate = rate;
+}
+
+void TDOAIMM::setAncPosition(const int anc_num, const vec3d_t anc_pos)
+{
+    for (int k = 0; k < count; k++)
+    {
+        models[k].setAncPosition(anc_num, anc_pos);
+    }
+}
+
+void TDOAIMM::setActiveAnchors(const vec3d_t *anchors, int n)
+{
+    for (int k = 0; k < count; k++)
+    {
+        models[k].setActiveAnchors(anchors, n);
+    }
+}
+
+void TDOAIMM::setOrigin(const Eigen::Vector3d &origin)
+{
+    for (int k = 0; k < count; k++)
+    {
+        models[k].setOrigin(origin);
+    }
+}
+
+bool TDOAIMM::initFromFrame(const tdoa_meas_t *meas, size_t n)
+{
+    // Same anchors and measurements, so every model gets the same seed
+    bool ok = true;
+    for (int k = 0; k < count; k++)
+    {
+        ok = models[k].initFromFrame(meas, n) && ok;
+    }
+    return ok;
+}
+
+void TDOAIMM::batchTDOAUpdate(const tdoa_meas_t *meas, size_t n, tdoa_batch_mode_t mode, const float *variance)
+{
+    // The sequential mode predicts to every measurement, the joint one to the newest
+    if (n > 0)
+    {
+        stateEstimatorPredictTo((mode == TDOA_BATCH_SEQUENTIAL) ? meas[0].timestamp : meas[n-1].timestamp);
+    }
+    for (int k = 0; k < count; k++)
+    {
+        models[k].batchTDOAUpdate(meas, n, mode, variance);
+    }
+}
+
+void TDOAIMM::scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance)
+{
+    for (int k = 0; k < count; k++)
+    {
+        models[k].scalarTDOADistUpdate(Ar, An, distanceDiff, variance);
+    }
+}
+
+void TDOAIMM::stateEstimatorPredictTo(const double t)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Models predict as one, mixing is skipped where they do not move
+    const double dt = t - models[0].getTime();
+    if ((t > 0) && (dt > 0))
+    {
+        updateProbabilities();
+        mix(dt);
+    }
+    for (int k = 0; k < count; k++)
+    {
+        models[k].stateEstimatorPredictTo(t);
+    }
+}
+
+/*
+ * mu_k *= exp(log-likelihood of model k since the last call), normalized.
+ * Models without measurements keep their predicted probabilities.
+ */
+void TDOAIMM::updateProbabilities()
+{
+    double ll[IMM_MAX_MODELS];
+    double maxLL = -INFINITY;
+    for (int k = 0; k < count; k++)
+    {
+        ll[k] = models[k].takeLogLikelihood();
+        maxLL = std::max(maxLL, ll[k]);
+    }
+
+    double sum = 0;
+    for (int k = 0; k < count; k++)
+    {
+        mu[k] *= std::exp(ll[k] - maxLL);
+        sum += mu[k];
+    }
+
+    double floored = 0;
+    for (int k = 0; k < count; k++)
+    {
+        mu[k] = std::max(mu[k] / sum, IMM_MIN_PROBABILITY);
+        floored += mu[k];
+    }
+    for (int k = 0; k < count; k++)
+    {
+        mu[k] /= floored;
+    }
+}
+
+/*
+ * Interaction step. Over dt a model is left with probability
+ * 1 - exp(-switchRate*dt), evenly towards the others. Model j restarts from
+ *      c_j = sum_i Pi_ij mu_i,  w_ij = Pi_ij mu_i / c_j
+ *      x_j = sum_i w_ij x_i,    P_j = sum_i w_ij (P_i + (x_i - x_j)(x_i - x_j)')
+ * and c_j becomes its probability.
+ */
+void TDOAIMM::mix(const double dt)
+{
+    if (count < 2)
+    {
+        return;
+    }
+
+    const double leave = 1 - std::exp(-switchRate * dt);
+    double Pi[IMM_MAX_MODELS][IMM_MAX_MODELS];
+    for (int i = 0; i < count; i++)
+    {
+        for (int j = 0; j < count; j++)
+        {
+            Pi[i][j] = (i == j) ? (1 - leave) : leave / (count - 1);
+        }
+    }
+
+    TDOA::StateVector x[IMM_MAX_MODELS];
+    TDOA::StateMatrix P[IMM_MAX_MODELS];
+    for (int i = 0; i < count; i++)
+    {
+        x[i] = models[i].getState();
+        P[i] = models[i].getCovariance();
+    }
+
+    double c[IMM_MAX_MODELS];
+    for (int j = 0; j < count; j++)
+    {
+        c[j] = 0;
+        for (int i = 0; i < count; i++)
+        {
+            c[j] += Pi[i][j] * mu[i];
+        }
+
+        TDOA::StateVector xj = TDOA::StateVector::Zero();
+        for (int i = 0; i < count; i++)
+        {
+            xj += (float)(Pi[i][j] * mu[i] / c[j]) * x[i];
+        }
+        TDOA::StateMatrix Pj = TDOA::StateMatrix::Zero();
+        for (int i = 0; i < count; i++)
+        {
+            const TDOA::StateVector d = x[i] - xj;
+            Pj += (float)(Pi[i][j] * mu[i] / c[j]) * (P[i] + d * d.transpose());
+        }
+        models[j].setState(xj, Pj, models[j].getTime());
+    }
+
+    for (int j = 0; j < count; j++)
+    {
+        mu[j] = c[j];
+    }
+}
+
+void TDOAIMM::output(TDOA &out)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    updateProbabilities();
+
+    TDOA::StateVector x = TDOA::StateVector::Zero();
+    for (int k = 0; k < count; k++)
+    {
+        x += (float)mu[k] * models[k].getState();
+    }
+    TDOA::StateMatrix P = TDOA::StateMatrix::Zero();
+    for (int k = 0; k < count; k++)
+    {
+        const TDOA::StateVector d = models[k].getState() - x;
+        P += (float)mu[k] * (models[k].getCovariance() + d * d.transpose());
+    }
+    out.setState(x, P, models[0].getTime());
+}
+
+int TDOAIMM::getModelCount()
+{
+    return count;
+}
+
+float TDOAIMM::getModelProbability(int model)
+{
+    return mu[model];
+}
+
+int TDOAIMM::getMostLikely()
+{
+    int best = 0;
+    for (int k = 1; k < count; k++)
+    {
+        if (mu[k] > mu[best])
+        {
+            best = k;
+        }
+    }
+    return best;
+}
+
+TDOA &TDOAIMM::getModel(int model)
+{
+    return models[model];
+}
+
+bool parseIMMModel(const std::string &name, imm_model_t &type)
+{
+    if (name == "stationary")
+    {
+        type = IMM_MODEL_STATIONARY;
+    }
+    else if (name == "cv")
+    {
+        type = IMM_MODEL_CV;
+    }
+    else if (name == "maneuver")
+    {
+        type = IMM_MODEL_MANEUVER;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+/*************************************************
+ *
+ *  Accelerometer driven TDOA filter, see tdoa_inertial.h
+ *
+ *************************************************/
+
+#include "tdoa_inertial.h"
+
+TDOAInertial::TDOAInertial() : accel(Eigen::Vector3f::Zero()), accelTime(0), accelValid(false),
+                               accelNoise(INERTIAL_ACCEL_NOISE), biasNoise(INERTIAL_BIAS_NOISE)
+{
+}
+
+void TDOAInertial::configure(const TDOA &base)
+{
+    filter.stdDev = base.stdDev;
+    filter.updateMode = base.updateMode;
+    filter.linearizationMode = base.linearizationMode;
+    filter.maxIterations = base.maxIterations;
+    filter.gateThreshold = base.gateThreshold;
+    filter.robustMode = base.robustMode;
+    filter.robustK = base.robustK;
+    filter.adaptiveNoise = base.adaptiveNoise;
+    filter.adaptiveRate = base.adaptiveRate;
+    filter.noiseMap = base.noiseMap;
+    filter.setHullMode(base.hullMode, base.hullMargin, base.hullNoiseScale, base.hullIterate);
+    // Same frame, the states are exchanged as they are. The anchors restart the pairs that moved, their noise is copied after
+    filter.setOrigin(base.origin);
+    filter.setActiveAnchors(base.anchorPosition, base.anchorCount);
+    filter.pairVariance = base.pairVariance;
+}
+
+void TDOAInertial::setNoise(float accel_noise, float bias_noise)
+{
+    accelNoise = accel_noise;
+    biasNoise = bias_noise;
+}
+
+void TDOAInertial::seed(TDOA &ekf, const double t)
+{
+    TDOAInertialFilter::StateVector x = TDOAInertialFilter::StateVector::Zero();
+    x.head<STATE_DIM>() = ekf.getState();
+    TDOAInertialFilter::StateMatrix P = TDOAInertialFilter::StateMatrix::Zero();
+    P.topLeftCorner<STATE_DIM, STATE_DIM>() = ekf.getCovariance();
+    P.bottomRightCorner<3, 3>() = (INERTIAL_BIAS_STD*INERTIAL_BIAS_STD) * Eigen::Matrix3f::Identity();
+    filter.setState(x, P, t);
+}
+
+void TDOAInertial::addAcceleration(const double t, const Eigen::Vector3f &a)
+{
+    stateEstimatorPredictTo(t);
+    accel = a;
+    accelTime = t;
+    accelValid = true;
+}
+
+void TDOAInertial::stateEstimatorPredictTo(const double t)
+{
+    if (!filter.stateTimeValid)
+    {
+        return;
+    }
+    const double dt = t - filter.stateTime;
+    if (dt <= 0)
+    {
+        return;
+    }
+    predict(dt);
+    filter.stateTime = t;
+}
+
+/*
+ * One step of the constant acceleration model with the held acceleration
+ * less the bias. F is the identity but dt from velocity to position and
+ * -dt^2/2, -dt from the bias to position and velocity, so F*P*F' is done on
+ * the rows and columns of each axis, position first so it reads the
+ * velocity before that changes. The noise is white acceleration noise on
+ * position and velocity and a random walk of the bias. Without a recent
+ * acceleration the step is one of constant velocity and the bias is left
+ * alone.
+ */
+void TDOAInertial::predict(const double dt)
+{
+    Eigen::Matrix<float, INERTIAL_STATE_DIM, 1> &S = filter.S;
+    Eigen::Matrix<float, INERTIAL_STATE_DIM, INERTIAL_STATE_DIM> &P = filter.P;
+
+    const bool held = accelValid && (filter.stateTime + dt - accelTime <= INERTIAL_MAX_HOLD);
+    const float h = (float)dt;
+    const float kv = held ? -h : 0.0f;
+    const float kp = held ? -0.5f*h*h : 0.0f;
+    const float q = accelNoise*accelNoise;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const int p = STATE_X + i, v = STATE_VX + i, b = STATE_BAX + i;
+        const float a = held ? accel(i) - S(b) : 0.0f;
+        S(p) += S(v)*h + 0.5f*a*h*h;
+        S(v) += a*h;
+
+        P.row(p) += h*P.row(v) + kp*P.row(b);
+        P.row(v) += kv*P.row(b);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        const int p = STATE_X + i, v = STATE_VX + i, b = STATE_BAX + i;
+        P.col(p) += h*P.col(v) + kp*P.col(b);
+        P.col(v) += kv*P.col(b);
+
+        P(p,p) += q*h*h*h/3;
+        P(p,v) += q*h*h/2;
+        P(v,p) += q*h*h/2;
+        P(v,v) += q*h;
+        P(b,b) += biasNoise*biasNoise*h;
+    }
+    filter.PredictionBound();
+}
+
+void TDOAInertial::scalarTDOADistUpdate(uint8_t Ar, uint8_t An, float distanceDiff, float variance)
+{
+    filter.scalarTDOADistUpdate(Ar, An, distanceDiff, variance);
+}
+
+void TDOAInertial::output(TDOA &out)
+{
+    if (!filter.stateTimeValid)
+    {
+        return;
+    }
+    out.setState(filter.S.head<STATE_DIM>(), filter.P.topLeftCorner<STATE_DIM, STATE_DIM>(), filter.stateTime);
+}
+
+Eigen::Vector3f TDOAInertial::getBias()
+{
+    return filter.S.segment<3>(STATE_BAX);
+}
+
+TDOAInertialFilter &TDOAInertial::getFilter()
+{
+    return filter;
+}
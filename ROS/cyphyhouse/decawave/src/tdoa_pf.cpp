@@ -0,0 +1,190 @@
+/*************************************************
+ *
+ *  Particle filter for global localization, see tdoa_pf.h
+ *
+ *************************************************/
+
+#include "tdoa_pf.h"
+
+TDOAParticleFilter::TDOAParticleFilter() : dist(PF_NUM_PARTICLES, MAX_NR_ANCHORS), distValid(0), rng(1), lastTime(0), frames(0), spread(false)
+{
+    memset(anchorPosition, 0, sizeof(anchorPosition));
+    px.setZero();
+    py.setZero();
+    pz.setZero();
+    logw.setZero();
+    w.setConstant(1.0f / PF_NUM_PARTICLES);
+}
+
+void TDOAParticleFilter::setAncPosition(const int anc_num, const vec3d_t anc_pos)
+{
+    if ((anc_num < 0) || (anc_num >= MAX_NR_ANCHORS))
+    {
+        return;
+    }
+    anchorPosition[anc_num] = anc_pos;
+    distValid = 0;
+}
+
+void TDOAParticleFilter::reset(const Eigen::Vector3f &lo, const Eigen::Vector3f &hi)
+{
+    std::uniform_real_distribution<float> ux(lo.x(), hi.x()), uy(lo.y(), hi.y()), uz(lo.z(), hi.z());
+    for (int i = 0; i < PF_NUM_PARTICLES; i++)
+    {
+        px(i) = ux(rng);
+        py(i) = uy(rng);
+        pz(i) = uz(rng);
+    }
+    logw.setZero();
+    w.setConstant(1.0f / PF_NUM_PARTICLES);
+    distValid = 0;
+    lastTime = 0;
+    frames = 0;
+    spread = true;
+}
+
+// Fills column anc_num of dist, one vectorized pass over the particles
+void TDOAParticleFilter::anchorDistance(int anc_num)
+{
+    if (distValid & (1u << anc_num))
+    {
+        return;
+    }
+    const vec3d_t &a = anchorPosition[anc_num];
+    dist.col(anc_num) = ((px - a.x).square() + (py - a.y).square() + (pz - a.z).square()).sqrt();
+    distValid |= 1u << anc_num;
+}
+
+void TDOAParticleFilter::update(const tdoa_meas_t *meas, size_t count)
+{
+    if (!spread || (count == 0))
+    {
+        return;
+    }
+
+    // ====== DIFFUSION ======
+    const double t = meas[count-1].timestamp;
+    if ((lastTime > 0) && (t > lastTime))
+    {
+        const float s = std::max(PF_MAX_SPEED * (float)(t - lastTime), PF_MIN_JITTER);
+        jitter(s, s, s);
+    }
+    if (t > 0)
+    {
+        lastTime = t;
+    }
+
+    // ====== WEIGHTS ======
+    distValid = 0;
+    const float scale = -0.5f / (PF_MEAS_STD*PF_MEAS_STD);
+    for (size_t k = 0; k < count; k++)
+    {
+        const int Ar = meas[k].Ar, An = meas[k].An;
+        if ((Ar >= MAX_NR_ANCHORS) || (An >= MAX_NR_ANCHORS))
+        {
+            continue;
+        }
+        anchorDistance(Ar);
+        anchorDistance(An);
+        const ParticleArray e = meas[k].distanceDiff - (dist.col(An) - dist.col(Ar));
+        logw += (scale * e.square()).max(-PF_OUTLIER_LOGL);
+    }
+    frames++;
+
+    // ====== RESAMPLING ======
+    normalize();
+    const float ess = 1.0f / w.square().sum();
+    if (ess < PF_RESAMPLE_RATIO * PF_NUM_PARTICLES)
+    {
+        resample();
+    }
+}
+
+// w from logw, shifted so the largest log-weight is 0 and nothing underflows
+void TDOAParticleFilter::normalize()
+{
+    logw -= logw.maxCoeff();
+    w = logw.exp();
+    w /= w.sum();
+}
+
+/*
+ * Systematic resampling: one uniform offset, then N evenly spaced points on
+ * the cumulative weights. Duplicates are spread by a jitter of PF_ROUGHENING
+ * times the extent of the cloud per N^(1/3) (Gordon's roughening).
+ */
+void TDOAParticleFilter::resample()
+{
+    std::uniform_real_distribution<float> u(0, 1.0f / PF_NUM_PARTICLES);
+    const float start = u(rng);
+
+    ParticleArray nx, ny, nz;
+    float cumulative = w(0);
+    int j = 0;
+    for (int i = 0; i < PF_NUM_PARTICLES; i++)
+    {
+        const float point = start + (float)i / PF_NUM_PARTICLES;
+        while ((point > cumulative) && (j < PF_NUM_PARTICLES - 1))
+        {
+            j++;
+            cumulative += w(j);
+        }
+        nx(i) = px(j);
+        ny(i) = py(j);
+        nz(i) = pz(j);
+    }
+    px = nx;
+    py = ny;
+    pz = nz;
+    logw.setZero();
+    w.setConstant(1.0f / PF_NUM_PARTICLES);
+
+    const float k = PF_ROUGHENING / std::cbrt((float)PF_NUM_PARTICLES);
+    jitter(std::max(k * (px.maxCoeff() - px.minCoeff()), PF_MIN_JITTER),
+           std::max(k * (py.maxCoeff() - py.minCoeff()), PF_MIN_JITTER),
+           std::max(k * (pz.maxCoeff() - pz.minCoeff()), PF_MIN_JITTER));
+}
+
+void TDOAParticleFilter::jitter(float sx, float sy, float sz)
+{
+    std::normal_distribution<float> n(0, 1);
+    for (int i = 0; i < PF_NUM_PARTICLES; i++)
+    {
+        px(i) += sx * n(rng);
+        py(i) += sy * n(rng);
+        pz(i) += sz * n(rng);
+    }
+    distValid = 0;
+}
+
+bool TDOAParticleFilter::converged()
+{
+    if (frames < PF_MIN_FRAMES)
+    {
+        return false;
+    }
+    vec3d_t mean;
+    Eigen::Matrix3f cov;
+    getEstimate(mean, cov);
+    return cov.diagonal().maxCoeff() < PF_CONVERGED_STD*PF_CONVERGED_STD;
+}
+
+void TDOAParticleFilter::getEstimate(vec3d_t &mean, Eigen::Matrix3f &covariance)
+{
+    mean.x = (w * px).sum();
+    mean.y = (w * py).sum();
+    mean.z = (w * pz).sum();
+
+    const ParticleArray dx = px - mean.x, dy = py - mean.y, dz = pz - mean.z;
+    covariance(0,0) = (w * dx * dx).sum();
+    covariance(1,1) = (w * dy * dy).sum();
+    covariance(2,2) = (w * dz * dz).sum();
+    covariance(0,1) = covariance(1,0) = (w * dx * dy).sum();
+    covariance(0,2) = covariance(2,0) = (w * dx * dz).sum();
+    covariance(1,2) = covariance(2,1) = (w * dy * dz).sum();
+}
+
+uint32_t TDOAParticleFilter::getFrames()
+{
+    return frames;
+}
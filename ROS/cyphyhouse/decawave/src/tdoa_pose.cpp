@@ -0,0 +1,314 @@
+/*************************************************
+ *
+ *  Two tag pose filter, see tdoa_pose.h
+ *
+ *************************************************/
+
+#include "tdoa_pose.h"
+
+TDOAPose::TDOAPose() : stateTime(0), seeded(false), accelNoise(POSE_ACCEL_NOISE), yawNoise(POSE_YAW_NOISE),
+                       stdDev(0.15f), gateThreshold(0), robustMode(TDOA_ROBUST_NONE), robustK(1.345f),
+                       anchorCount(0), pendingCount(0), rejects(0)
+{
+    S.setZero();
+    P.setZero();
+    baseline[0].setZero();
+    baseline[1].setZero();
+    origin.setZero();
+    anchorSoA.setZero();
+    cacheState.setZero();
+    cacheDist.setZero();
+    for (int k = 0; k < POSE_TAGS; k++)
+    {
+        cacheArm[k].setZero();
+        cacheUnit[k].setZero();
+    }
+}
+
+void TDOAPose::setBaseline(const Eigen::Vector3f &tag0, const Eigen::Vector3f &tag1)
+{
+    baseline[0] = tag0;
+    baseline[1] = tag1;
+}
+
+void TDOAPose::setNoise(float accel_noise, float yaw_noise)
+{
+    accelNoise = accel_noise;
+    yawNoise = yaw_noise;
+}
+
+void TDOAPose::configure(const TDOA &base)
+{
+    stdDev = base.stdDev;
+    gateThreshold = base.gateThreshold;
+    robustMode = base.robustMode;
+    robustK = base.robustK;
+
+    if (seeded && (base.origin != origin))
+    {
+        // Same site position in the new frame
+        S.head<3>() += (origin - base.origin).cast<float>();
+    }
+    origin = base.origin;
+    anchorSoA = base.anchorSoA;
+    anchorCount = base.anchorCount;
+}
+
+/*
+ * The yaw is the heading of the line from tag 1 to tag 0 less that of the
+ * baseline, the body origin the mean of the two fixes less their lever
+ * arms. The fixes are independent, so the position and velocity covariance
+ * is a quarter of their sum, and the yaw variance their horizontal variance
+ * over the baseline squared.
+ */
+bool TDOAPose::seed(TDOA &tag0, TDOA &tag1, const double t)
+{
+    const Eigen::Vector3d site0 = tag0.getState().head<3>().cast<double>() + tag0.getOrigin();
+    const Eigen::Vector3d site1 = tag1.getState().head<3>().cast<double>() + tag1.getOrigin();
+    const Eigen::Vector2f seen = (site0 - site1).head<2>().cast<float>();
+    const Eigen::Vector2f body = (baseline[0] - baseline[1]).head<2>();
+    if (body.norm() < POSE_MIN_BASELINE)
+    {
+        return false;
+    }
+
+    const TDOA::StateMatrix P0 = tag0.getCovariance();
+    const TDOA::StateMatrix P1 = tag1.getCovariance();
+    const float planar = P0(STATE_X,STATE_X) + P0(STATE_Y,STATE_Y) + P1(STATE_X,STATE_X) + P1(STATE_Y,STATE_Y);
+    if (std::fabs(seen.norm() - body.norm()) > POSE_SEED_TOL + 3*std::sqrt(planar))
+    {
+        return false;
+    }
+
+    S.setZero();
+    S(STATE_YAW) = std::atan2(seen.y(), seen.x()) - std::atan2(body.y(), body.x());
+    S(STATE_YAW) = std::atan2(std::sin(S(STATE_YAW)), std::cos(S(STATE_YAW)));
+    const Eigen::Vector3d mean = 0.5*((site0 - leverArm(0).cast<double>()) + (site1 - leverArm(1).cast<double>()));
+    S.head<3>() = (mean - origin).cast<float>();
+    S.segment<3>(STATE_VX) = 0.5f*(tag0.getState().segment<3>(STATE_VX) + tag1.getState().segment<3>(STATE_VX));
+
+    P.setZero();
+    P.topLeftCorner<STATE_DIM, STATE_DIM>() = 0.25f*(P0 + P1);
+    P(STATE_YAW, STATE_YAW) = planar / body.squaredNorm();
+    P(STATE_YAW_RATE, STATE_YAW_RATE) = POSE_YAW_RATE_STD*POSE_YAW_RATE_STD;
+    bound();
+
+    stateTime = t;
+    seeded = true;
+    pendingCount = 0;
+    return true;
+}
+
+void TDOAPose::reset()
+{
+    seeded = false;
+    pendingCount = 0;
+}
+
+void TDOAPose::add(uint8_t tag, const tdoa_meas_t &meas, float variance)
+{
+    if (pendingCount == POSE_MAX_PENDING)
+    {
+        update();
+    }
+    pose_meas_t &m = pending[pendingCount++];
+    m.meas = meas;
+    m.variance = variance;
+    m.tag = tag;
+}
+
+size_t TDOAPose::update()
+{
+    const size_t count = pendingCount;
+    pendingCount = 0;
+    if (!seeded || (count == 0))
+    {
+        return 0;
+    }
+
+    // Each tag's pairs come in order, the two tags interleave
+    std::stable_sort(pending, pending + count, [](const pose_meas_t &a, const pose_meas_t &b) {
+        return a.meas.timestamp < b.meas.timestamp;
+    });
+
+    size_t applied = 0;
+    for (size_t first = 0; first < count; )
+    {
+        size_t last = first + 1;
+        while ((last < count) && (pending[last].meas.timestamp - pending[first].meas.timestamp <= POSE_BATCH_SPAN))
+        {
+            last++;
+        }
+        applyBatch(pending + first, last - first);
+        applied += last - first;
+        first = last;
+    }
+    return applied;
+}
+
+void TDOAPose::stateEstimatorPredictTo(const double t)
+{
+    if (!seeded)
+    {
+        return;
+    }
+    const double dt = t - stateTime;
+    if (dt <= 0)
+    {
+        return;
+    }
+    predict(dt);
+    stateTime = t;
+}
+
+/*
+ * Constant velocity on the three axes and constant rate on the yaw, each a
+ * pair of states with white noise on its derivative. F is the identity but
+ * dt from each rate to its state, so F*P*F' is done on the rows and columns
+ * of each pair as in TDOAInertial.
+ */
+void TDOAPose::predict(const double dt)
+{
+    const float h = (float)dt;
+    const int state[4] = {STATE_X, STATE_Y, STATE_Z, STATE_YAW};
+    const int rate[4] = {STATE_VX, STATE_VY, STATE_VZ, STATE_YAW_RATE};
+
+    for (int i = 0; i < 4; i++)
+    {
+        S(state[i]) += S(rate[i])*h;
+        P.row(state[i]) += h*P.row(rate[i]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        const int p = state[i], v = rate[i];
+        const float q = (i < 3) ? accelNoise*accelNoise : yawNoise*yawNoise;
+        P.col(p) += h*P.col(v);
+
+        P(p,p) += q*h*h*h/3;
+        P(p,v) += q*h*h/2;
+        P(v,p) += q*h*h/2;
+        P(v,v) += q*h;
+    }
+    S(STATE_YAW) = std::atan2(std::sin(S(STATE_YAW)), std::cos(S(STATE_YAW)));
+    bound();
+}
+
+Eigen::Vector3f TDOAPose::leverArm(int tag) const
+{
+    const float c = std::cos(S(STATE_YAW)), s = std::sin(S(STATE_YAW));
+    const Eigen::Vector3f &b = baseline[tag];
+    return Eigen::Vector3f(c*b.x() - s*b.y(), s*b.x() + c*b.y(), b.z());
+}
+
+// Distances and unit vectors from both tags to all anchors at once, at the current state
+void TDOAPose::linearize()
+{
+    const int n = anchorCount;
+    cacheState = S;
+    for (int k = 0; k < POSE_TAGS; k++)
+    {
+        cacheArm[k] = leverArm(k);
+        const Eigen::Vector3f at = S.head<3>() + cacheArm[k];
+        cacheUnit[k].topRows(n) = (-anchorSoA.topRows(n)).rowwise() + at.transpose();
+        cacheDist.col(k).head(n) = cacheUnit[k].topRows(n).rowwise().norm();
+        cacheUnit[k].topRows(n).array().colwise() /= cacheDist.col(k).head(n).array();
+    }
+}
+
+/*
+ * The pairs of one batch at the linearization of its newest time. For tag k
+ * the range difference has the gradient h = u_An - u_Ar at the tag, on the
+ * position directly and on the yaw through d(R*b_k)/dyaw = (-r_y, r_x, 0)
+ * for the lever arm r. The innovation is taken against the linearization
+ * plus H times the change of the updates before, as batchTDOAUpdate does
+ * with its UD chain, and the scalar update is the rank-1 form of
+ * (I-K*H)*P. Gating and robust weights are those of TDOAFilter.
+ */
+void TDOAPose::applyBatch(const pose_meas_t *batch, size_t count)
+{
+    if (batch[count-1].meas.timestamp > 0)
+    {
+        stateEstimatorPredictTo(batch[count-1].meas.timestamp);
+    }
+    linearize();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const tdoa_meas_t &m = batch[i].meas;
+        const int k = batch[i].tag;
+        if ((m.Ar >= anchorCount) || (m.An >= anchorCount) || (m.Ar == m.An) || (k >= POSE_TAGS))
+        {
+            continue;
+        }
+
+        const Eigen::Vector3f hp = (cacheUnit[k].row(m.An) - cacheUnit[k].row(m.Ar)).transpose();
+        StateVector H = StateVector::Zero();
+        H.head<3>() = hp;
+        H(STATE_YAW) = hp.x()*(-cacheArm[k].y()) + hp.y()*cacheArm[k].x();
+
+        StateVector change = S - cacheState;
+        change(STATE_YAW) = std::atan2(std::sin(change(STATE_YAW)), std::cos(change(STATE_YAW)));
+        const float error = m.distanceDiff - (cacheDist(m.An, k) - cacheDist(m.Ar, k)) - H.dot(change);
+
+        float R = (batch[i].variance > 0) ? batch[i].variance : stdDev*stdDev;
+        const StateVector PH = P*H;
+        float HPHR = H.dot(PH) + R;
+        const float nis = error*error / HPHR;
+        if ((gateThreshold > 0) && !(nis <= gateThreshold))
+        {
+            rejects++;
+            continue;
+        }
+        const float r = std::sqrt(nis);
+        if ((robustMode == TDOA_ROBUST_HUBER) && (r > robustK))
+        {
+            R *= r / robustK;
+        }
+        else if (robustMode == TDOA_ROBUST_CAUCHY)
+        {
+            R *= 1 + (r/robustK)*(r/robustK);
+        }
+        HPHR = H.dot(PH) + R;
+
+        S.noalias() += PH * (error / HPHR);
+        P.noalias() -= PH * PH.transpose() / HPHR;
+    }
+    S(STATE_YAW) = std::atan2(std::sin(S(STATE_YAW)), std::cos(S(STATE_YAW)));
+    bound();
+}
+
+/*
+ * Tag k moves with the body and with the yaw rate around its origin:
+ * position p + r and velocity v + w*(-r_y, r_x, 0) for the lever arm r.
+ * The covariance goes through the Jacobian of that map.
+ */
+void TDOAPose::output(uint8_t tag, TDOA &out)
+{
+    if (!seeded || (tag >= POSE_TAGS))
+    {
+        return;
+    }
+    const Eigen::Vector3f r = leverArm(tag);
+    const float w = S(STATE_YAW_RATE);
+
+    TDOA::StateVector x;
+    x.head<3>() = S.head<3>() + r + (origin - out.getOrigin()).cast<float>();
+    x.segment<3>(STATE_VX) = S.segment<3>(STATE_VX) + w*Eigen::Vector3f(-r.y(), r.x(), 0);
+
+    Eigen::Matrix<float, STATE_DIM, POSE_STATE_DIM> J = Eigen::Matrix<float, STATE_DIM, POSE_STATE_DIM>::Zero();
+    J.leftCols<STATE_DIM>().setIdentity();
+    J(STATE_X, STATE_YAW) = -r.y();
+    J(STATE_Y, STATE_YAW) = r.x();
+    J(STATE_VX, STATE_YAW) = -w*r.x();
+    J(STATE_VY, STATE_YAW) = -w*r.y();
+    J(STATE_VX, STATE_YAW_RATE) = -r.y();
+    J(STATE_VY, STATE_YAW_RATE) = r.x();
+
+    out.setState(x, J*P*J.transpose(), stateTime);
+}
+
+// The bounds of TDOAFilter::PredictionBound
+void TDOAPose::bound()
+{
+    tdoaBoundCovariance<POSE_STATE_DIM, float>(P.data(), MAX_COVARIANCE, MIN_COVARIANCE);
+}
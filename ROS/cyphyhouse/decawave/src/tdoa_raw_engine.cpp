@@ -0,0 +1,216 @@
+/*************************************************
+ *
+ *  Host TDOA engine for raw timestamp frames, see tdoa_raw_engine.h
+ *
+ *************************************************/
+
+#include "tdoa_raw_engine.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// Largest skew a fit may have, the one tdoa_clock_skew limits the firmware to
+static const double maxSkew = (double)TDOA_CLOCK_MAX_SKEW / (double)(1LL << TDOA_CLOCK_SKEW_SHIFT);
+
+TDOARawEngine::TDOARawEngine(size_t count) : tags(count), rawFrames(0), solvedPairs(0), sharedPairs(0), passes(0),
+                                             modeledAnchors(0)
+{
+    states.reset(new TagState[tags]);
+    for (size_t t = 0; t < tags; t++)
+    {
+        TagState &s = states[t];
+        for (int k = 0; k < RAW_MAX_ANCHORS; k++)
+        {
+            tdoa_clock_filter_reset(&s.clock[k]);
+            s.own[k] = NAN;
+        }
+        memset(s.lastRx, 0, sizeof(s.lastRx));
+        memset(s.lastIdx, 0, sizeof(s.lastIdx));
+        memset(s.seen, 0, sizeof(s.seen));
+        memset(s.fresh, 0, sizeof(s.fresh));
+        s.common = 0;
+        s.commonValid = false;
+    }
+    for (int k = 0; k < RAW_MAX_ANCHORS; k++)
+    {
+        anchorSkew[k] = 0;
+        anchorSamples[k] = 0;
+    }
+    interval.resize(RAW_ENGINE_MAX_BATCH);
+    skew.resize(RAW_ENGINE_MAX_BATCH);
+    tof.resize(RAW_ENGINE_MAX_BATCH);
+    delta.resize(RAW_ENGINE_MAX_BATCH);
+}
+
+uint32_t TDOARawEngine::getDrops() const
+{
+    uint32_t drops = 0;
+    for (size_t t = 0; t < tags; t++)
+    {
+        drops += states[t].queue.dropCount();
+    }
+    return drops;
+}
+
+/*
+ * What TDOARawSolver::solve does for one frame, up to the distance
+ * difference: the clock fit of An and, if the packet of Ar belongs to the
+ * same TDMA frame, the pair into slot n of the batch.
+ */
+void TDOARawEngine::pairFrame(size_t t, const RawIngress &in, size_t &n)
+{
+    const tdoa_raw_frame_t &raw = in.raw;
+    const uint8_t Ar = raw.Ar;
+    const uint8_t An = raw.An;
+    if ((Ar >= RAW_MAX_ANCHORS) || (An >= RAW_MAX_ANCHORS))
+    {
+        return;
+    }
+    TagState &s = states[t];
+
+    if (tdoa_clock_filter_add(&s.clock[An], raw.rxAn_by_T, raw.txAn))
+    {
+        const double ratio = tdoa_clock_filter_ratio(&s.clock[An]);
+        s.own[An] = ((ratio != 0.0) && (std::fabs(ratio - 1.0) < maxSkew)) ? ratio - 1.0 : NAN;
+        s.fresh[An] = true;
+    }
+
+    // Anchors transmit in index order, so a lower Ar sent in the same frame and a higher one in the previous
+    const bool sameFrame = (Ar < An) ? (s.lastIdx[Ar] == raw.idx) : (s.lastIdx[Ar] == (uint8_t)(raw.idx - 1));
+    if ((Ar != An) && s.seen[Ar] && sameFrame && (raw.tofAr_to_An != 0) && (raw.rxAr_by_An != 0) && std::isfinite(s.own[An]))
+    {
+        interval(n) = (double)tdoa_time_sub(raw.rxAn_by_T, s.lastRx[Ar]);
+        tof(n) = raw.tofAr_to_An;
+        txAn[n] = raw.txAn;
+        rxArByAn[n] = raw.rxAr_by_An;
+        anchorOf[n] = An;
+
+        RawSolved &r = solved[n];
+        memset(&r.frame, 0, sizeof(r.frame));
+        r.tag = t;
+        r.frame.Ar = Ar;
+        r.frame.An = An;
+        r.frame.flags = TDOA_FRAME_HAS_TIME;
+        r.frame.idx = raw.idx;
+        r.frame.rxTime = raw.rxAn_by_T;
+        r.read = in.read;
+        r.stamp = in.stamp;
+        n++;
+    }
+
+    s.lastRx[An] = raw.rxAn_by_T;
+    s.lastIdx[An] = raw.idx;
+    s.seen[An] = true;
+}
+
+// c(T) from the anchors of the tag that have a shared skew, then the shared skews from the fits of the tag
+void TDOARawEngine::updateModel(size_t t)
+{
+    TagState &s = states[t];
+    double sum = 0;
+    int count = 0;
+    int first = -1;
+    for (int k = 0; k < RAW_MAX_ANCHORS; k++)
+    {
+        if (!s.fresh[k] || (s.clock[k].count < RAW_ENGINE_MIN_PACKETS) || !std::isfinite(s.own[k]))
+        {
+            s.fresh[k] = false;
+            continue;
+        }
+        if (anchorSamples[k] > 0)
+        {
+            sum += s.own[k] - anchorSkew[k];
+            count++;
+        }
+        else if (first < 0)
+        {
+            first = k;
+        }
+    }
+    if (count > 0)
+    {
+        s.common = sum / count;
+        s.commonValid = true;
+    }
+    else if (!s.commonValid && (first >= 0))
+    {
+        // No anchor of the tag is known yet, the first one becomes the reference of its anchors
+        s.common = s.own[first];
+        s.commonValid = true;
+    }
+    if (!s.commonValid)
+    {
+        return;
+    }
+
+    for (int k = 0; k < RAW_MAX_ANCHORS; k++)
+    {
+        if (!s.fresh[k])
+        {
+            continue;
+        }
+        s.fresh[k] = false;
+        // A running mean until the gain takes over, so the first fits do not start from 0
+        const double gain = std::max(1.0 / (anchorSamples[k] + 1), RAW_ENGINE_ANCHOR_GAIN);
+        anchorSkew[k] += gain * (s.own[k] - s.common - anchorSkew[k]);
+        if (anchorSamples[k] < UINT32_MAX)
+        {
+            anchorSamples[k]++;
+        }
+        if (anchorSamples[k] == RAW_ENGINE_MIN_SAMPLES)
+        {
+            modeledAnchors++;
+        }
+    }
+}
+
+size_t TDOARawEngine::solveBatch()
+{
+    size_t n = 0;
+    RawIngress in;
+    // Starting from another tag every pass, so a full batch does not always leave out the same tags
+    const size_t first = passes % std::max<size_t>(tags, 1);
+    for (size_t i = 0; i < tags; i++)
+    {
+        const size_t t = (first + i) % tags;
+        while ((n < RAW_ENGINE_MAX_BATCH) && states[t].queue.pop(in))
+        {
+            rawFrames++;
+            pairFrame(t, in, n);
+        }
+        updateModel(t);
+    }
+    passes++;
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint32_t shared = 0;
+    for (size_t k = 0; k < n; k++)
+    {
+        const TagState &s = states[solved[k].tag];
+        const uint8_t An = anchorOf[k];
+        solved[k].shared = s.commonValid && (anchorSamples[An] >= RAW_ENGINE_MIN_SAMPLES);
+        skew(k) = solved[k].shared ? s.common + anchorSkew[An] : s.own[An];
+        shared += solved[k].shared;
+    }
+
+    // tdoa_clock_distance_diff for the whole batch: the tag interval in the clock of An, less the anchor interval
+    // from txAr to txAn, which is unwrapped against it
+    delta.head(n) = interval.head(n) * (1.0 + skew.head(n)) - tof.head(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        delta(k) = tof(k) + (double)tdoa_time_unwrap32(txAn[k], rxArByAn[k], (int64_t)std::llround(delta(k)));
+    }
+    interval.head(n) = (interval.head(n) * (1.0 + skew.head(n)) - delta.head(n)) * (TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ);
+    for (size_t k = 0; k < n; k++)
+    {
+        solved[k].frame.distanceDiff = (float)interval(k);
+    }
+
+    solvedPairs += n;
+    sharedPairs += shared;
+    return n;
+}
@@ -0,0 +1,176 @@
+/*************************************************
+ *
+ *  Synthetic TDOA measurement generator, see tdoa_sim.h
+ *
+ *************************************************/
+
+#include <cmath>
+#include <fstream>
+
+#include "tdoa_sim.h"
+
+tdoa_sim_config_t defaultSimConfig()
+{
+    tdoa_sim_config_t config;
+    config.slotTime = SIM_SLOT_TIME;
+    config.measNoise = 0.05;
+    config.clockDriftPpm = 0.02;
+    config.clockWalkPpm = 0.001;
+    config.nlosProb = 0.05;
+    config.nlosMeanBias = 0.3;
+    config.dropProb = 0.02;
+    config.seed = 42;
+    return config;
+}
+
+bool loadTrajectory(const std::string &path, std::vector<sim_waypoint_t> &traj)
+{
+    std::ifstream file(path);
+    std::string str;
+    while (std::getline(file, str))
+    {
+        sim_waypoint_t wp;
+        if (sscanf(str.c_str(), "%lf, %lf, %lf, %lf", &wp.t, &wp.pos[0], &wp.pos[1], &wp.pos[2]) == 4)
+        {
+            traj.push_back(wp);
+        }
+    }
+    return !traj.empty();
+}
+
+TDOASimulator::TDOASimulator(const anchor_layout_t &layout, const tdoa_sim_config_t &config)
+    : layout(layout), config(config), gen(config.seed), normal(0, 1), uniform(0, 1)
+{
+    time = 0;
+    slot = -1;
+    lastAnchor = -1;
+    lastRange = 0;
+    lastRxTime = 0;
+
+    for (int i = 0; i < MAX_NR_ANCHORS; i++)
+    {
+        driftPpm[i] = config.clockDriftPpm * normal(gen);
+    }
+}
+
+void TDOASimulator::setTrajectory(const std::vector<sim_waypoint_t> &traj)
+{
+    trajectory = traj;
+}
+
+double TDOASimulator::getTime() const
+{
+    return time;
+}
+
+void TDOASimulator::positionAt(double t, double pos[3]) const
+{
+    if (trajectory.empty())
+    {
+        double c[3] = {0, 0, 0};
+        for (int i = 0; i < layout.count; i++)
+        {
+            c[0] += layout.pos[i].x / layout.count;
+            c[1] += layout.pos[i].y / layout.count;
+            c[2] += layout.pos[i].z / layout.count;
+        }
+        pos[0] = c[0] + cos(0.2*t);
+        pos[1] = c[1] + sin(0.2*t);
+        pos[2] = c[2];
+        return;
+    }
+
+    size_t i = 0;
+    while ((i + 1 < trajectory.size()) && (trajectory[i+1].t <= t))
+    {
+        i++;
+    }
+    if ((i + 1 >= trajectory.size()) || (t <= trajectory[i].t))
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            pos[k] = trajectory[i].pos[k];
+        }
+        return;
+    }
+
+    const sim_waypoint_t &a = trajectory[i], &b = trajectory[i+1];
+    double w = (t - a.t) / (b.t - a.t);
+    for (int k = 0; k < 3; k++)
+    {
+        pos[k] = a.pos[k] + w*(b.pos[k] - a.pos[k]);
+    }
+}
+
+double TDOASimulator::range(int anc, const double pos[3]) const
+{
+    const vec3d_t &a = layout.pos[anc];
+    return sqrt((pos[0]-a.x)*(pos[0]-a.x) + (pos[1]-a.y)*(pos[1]-a.y) + (pos[2]-a.z)*(pos[2]-a.z));
+}
+
+bool TDOASimulator::step(tdoa_meas_t &meas, double truth[3])
+{
+    slot = (slot + 1) % layout.count;
+    time += config.slotTime;
+
+    // Residual clock drift wanders slowly
+    for (int i = 0; i < layout.count; i++)
+    {
+        driftPpm[i] += config.clockWalkPpm * sqrt(config.slotTime) * normal(gen);
+    }
+
+    if (uniform(gen) < config.dropProb)
+    {
+        return false;
+    }
+
+    positionAt(time, truth);
+    double r = range(slot, truth);
+    if (uniform(gen) < config.nlosProb)
+    {
+        std::exponential_distribution<double> nlos(1.0 / config.nlosMeanBias);
+        r += nlos(gen);
+    }
+
+    bool emit = (lastAnchor >= 0) && (lastAnchor != slot);
+    if (emit)
+    {
+        // Clock error of the current anchor scales the time between the two arrivals
+        double drift = driftPpm[slot] * 1e-6 * (time - lastRxTime) * SIM_SPEED_OF_LIGHT;
+
+        meas.Ar = lastAnchor;
+        meas.An = slot;
+        meas.distanceDiff = r - lastRange + drift + config.measNoise * normal(gen);
+        meas.timestamp = time;
+    }
+
+    lastAnchor = slot;
+    lastRange = r;
+    lastRxTime = time;
+    return emit;
+}
+
+void TDOASimulator::generate(size_t nframes, std::vector<tdoa_frame_record_t> &frames)
+{
+    for (size_t f = 0; f < nframes; f++)
+    {
+        tdoa_frame_record_t rec;
+        rec.count = 0;
+        rec.hasTruth = true;
+        for (int k = 0; k < layout.count; k++)
+        {
+            tdoa_meas_t meas;
+            double truth[3];
+            if (step(meas, truth))
+            {
+                rec.meas[rec.count++] = meas;
+            }
+            positionAt(time, rec.truth);
+        }
+        rec.time = time;
+        if (rec.count > 0)
+        {
+            frames.push_back(rec);
+        }
+    }
+}
@@ -0,0 +1,448 @@
+/*************************************************
+ *
+ *  Batch least-squares trajectory solver, see trajectory_solver.h
+ *
+ *************************************************/
+
+#include "trajectory_solver.h"
+
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+trajectory_solver_config_t defaultTrajectoryConfig()
+{
+    trajectory_solver_config_t config;
+    config.stdDev = 0.15f;
+    config.accelNoise = TRAJECTORY_ACCEL_NOISE;
+    config.biasStd = TRAJECTORY_BIAS_STD;
+    config.huber = TRAJECTORY_HUBER;
+    config.maxIterations = TRAJECTORY_MAX_ITERATIONS;
+    config.tolerance = TRAJECTORY_TOLERANCE;
+    config.threads = 0;
+    return config;
+}
+
+TrajectorySolver::TrajectorySolver(const anchor_layout_t &l, const trajectory_solver_config_t &c) : layout(l), config(c), assembledCost(0)
+{
+    if (config.threads <= 0)
+    {
+        config.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < MAX_NR_ANCHORS; i++)
+    {
+        for (int j = 0; j < MAX_NR_ANCHORS; j++)
+        {
+            pairIndex[i][j] = -1;
+        }
+    }
+    firstTerm.push_back(0);
+}
+
+int TrajectorySolver::pairBias(int Ar, int An, double &sign)
+{
+    sign = (Ar < An) ? 1 : -1;
+    if (config.biasStd <= 0)
+    {
+        return -1;
+    }
+    const int lo = std::min(Ar, An), hi = std::max(Ar, An);
+    if (pairIndex[lo][hi] < 0)
+    {
+        pairIndex[lo][hi] = pairs.size();
+        pairs.push_back(lo * MAX_NR_ANCHORS + hi);
+    }
+    return pairIndex[lo][hi];
+}
+
+bool TrajectorySolver::addNode(double t, const tdoa_meas_t *meas, size_t count, const Eigen::Vector3d &p, const Eigen::Vector3d &v)
+{
+    const bool merge = !times.empty() && (t - times.back() < TRAJECTORY_MIN_DT);
+    if (!merge)
+    {
+        Vector6d x;
+        x << p, v;
+        times.push_back(t);
+        states.push_back(x);
+        firstTerm.push_back(terms.size());
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const tdoa_meas_t &m = meas[i];
+        if ((m.Ar >= layout.count) || (m.An >= layout.count) || (m.Ar == m.An) || !std::isfinite(m.distanceDiff))
+        {
+            continue;
+        }
+        pair_term_t term;
+        term.dt = (m.timestamp > 0) ? m.timestamp - times.back() : 0;
+        term.distanceDiff = m.distanceDiff;
+        term.Ar = m.Ar;
+        term.An = m.An;
+        term.bias = pairBias(m.Ar, m.An, term.sign);
+        terms.push_back(term);
+    }
+    firstTerm.back() = terms.size();
+    return !merge;
+}
+
+void TrajectorySolver::getPair(size_t i, int &Ar, int &An, double &bias) const
+{
+    Ar = pairs[i] / MAX_NR_ANCHORS;
+    An = pairs[i] % MAX_NR_ANCHORS;
+    bias = (i < (size_t)biases.size()) ? biases(i) : 0;
+}
+
+void TrajectorySolver::getPairResiduals(size_t i, size_t &count, double &mean, double &std) const
+{
+    double sum = 0, sq = 0;
+    count = 0;
+    for (size_t k = 0; k < times.size(); k++)
+    {
+        for (size_t j = firstTerm[k]; j < firstTerm[k+1]; j++)
+        {
+            if (terms[j].bias == (int)i)
+            {
+                // In the direction of the pair with the bias, Ar < An
+                const double r = terms[j].sign * pairResidual(terms[j], states[k], biases, NULL);
+                sum += r;
+                sq += r*r;
+                count++;
+            }
+        }
+    }
+    mean = (count > 0) ? sum / count : 0;
+    std = (count > 1) ? sqrt(std::max(0.0, sq / count - mean*mean)) : 0;
+}
+
+// Residual of a pair and, if J is set, its Jacobian over the state of its node
+double TrajectorySolver::pairResidual(const pair_term_t &m, const Vector6d &x, const Eigen::VectorXd &b, Vector6d *J) const
+{
+    const Eigen::Vector3d p = x.head<3>() + m.dt * x.tail<3>();
+    const vec3d_t &an = layout.pos[m.An], &ar = layout.pos[m.Ar];
+    const Eigen::Vector3d dn = p - Eigen::Vector3d(an.x, an.y, an.z);
+    const Eigen::Vector3d dr = p - Eigen::Vector3d(ar.x, ar.y, ar.z);
+    const double nn = std::max(dn.norm(), 1e-6), nr = std::max(dr.norm(), 1e-6);
+    double predicted = nn - nr;
+    if (m.bias >= 0)
+    {
+        predicted += m.sign * b(m.bias);
+    }
+    if (J != NULL)
+    {
+        const Eigen::Vector3d hp = dn / nn - dr / nr;
+        *J << hp, m.dt * hp;
+    }
+    return predicted - m.distanceDiff;
+}
+
+/*
+ * Inverse of the white acceleration process noise over dt, per axis
+ *      Q = q [dt^3/3  dt^2/2; dt^2/2  dt]
+ *      Q^-1 = 1/q [12/dt^3  -6/dt^2; -6/dt^2  4/dt]
+ * and the constant velocity transition. Returns dt.
+ */
+double TrajectorySolver::motionWeight(double dt, Matrix6d &W, Matrix6d &F) const
+{
+    dt = std::max(dt, TRAJECTORY_MIN_DT);
+    const double q = config.accelNoise;
+    W.setZero();
+    F.setIdentity();
+    for (int j = 0; j < 3; j++)
+    {
+        W(j, j) = 12 / (q * dt*dt*dt);
+        W(j, j+3) = W(j+3, j) = -6 / (q * dt*dt);
+        W(j+3, j+3) = 4 / (q * dt);
+        F(j, j+3) = dt;
+    }
+    return dt;
+}
+
+// Huber loss of a residual in stdDev units and its IRLS weight
+double TrajectorySolver::robustWeight(double r, double &rho) const
+{
+    const double u = std::abs(r) / config.stdDev;
+    if ((config.huber <= 0) || (u <= config.huber))
+    {
+        rho = u*u;
+        return 1;
+    }
+    rho = 2*config.huber*u - config.huber*config.huber;
+    return config.huber / u;
+}
+
+template<typename Func>
+void TrajectorySolver::parallelNodes(Func f)
+{
+    const size_t n = times.size();
+    const int threads = std::max(1, std::min<int>(config.threads, n / 64));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+    {
+        workers.push_back(std::thread(f, n * i / threads, n * (i+1) / threads, i));
+    }
+    f(0, n / threads, 0);
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+double TrajectorySolver::cost(const StateVector &x, const Eigen::VectorXd &b)
+{
+    std::vector<double> sums(config.threads, 0.0);
+    parallelNodes([&](size_t begin, size_t end, int thread)
+    {
+        double c = 0;
+        Matrix6d W, F;
+        for (size_t k = begin; k < end; k++)
+        {
+            for (size_t j = firstTerm[k]; j < firstTerm[k+1]; j++)
+            {
+                double rho;
+                robustWeight(pairResidual(terms[j], x[k], b, NULL), rho);
+                c += rho;
+            }
+            if (k + 1 < times.size())
+            {
+                motionWeight(times[k+1] - times[k], W, F);
+                const Vector6d e = x[k+1] - F * x[k];
+                c += e.dot(W * e);
+            }
+        }
+        sums[thread] = c;
+    });
+    double c = 0;
+    for (size_t i = 0; i < sums.size(); i++)
+    {
+        c += sums[i];
+    }
+    if (config.biasStd > 0)
+    {
+        c += b.squaredNorm() / (config.biasStd * config.biasStd);
+    }
+    return c;
+}
+
+/*
+ * Normal equations at the current estimate, H dx = -g with H = J' W J and
+ * g = J' W r, the Huber weights fixed at the current residuals. Each node
+ * gets its pairs and both motion terms around it, so the blocks written by
+ * a thread are its own; the motion cost is counted by the earlier node.
+ */
+void TrajectorySolver::assemble()
+{
+    const size_t n = times.size(), nb = pairs.size();
+    const double w0 = 1.0 / (config.stdDev * config.stdDev);
+    D.resize(n);
+    U.resize(n);
+    gx.resize(n);
+    Hxb.setZero(6*n, nb);
+
+    std::vector<thread_sums_t> sums(config.threads);
+    parallelNodes([&](size_t begin, size_t end, int thread)
+    {
+        thread_sums_t &s = sums[thread];
+        s.Hbb.setZero(nb, nb);
+        s.gb.setZero(nb);
+        s.cost = 0;
+        Matrix6d W, F;
+        Vector6d J;
+        for (size_t k = begin; k < end; k++)
+        {
+            Matrix6d &Dk = D[k];
+            Vector6d &gk = gx[k];
+            Dk.setZero();
+            gk.setZero();
+            U[k].setZero();
+
+            for (size_t j = firstTerm[k]; j < firstTerm[k+1]; j++)
+            {
+                const pair_term_t &m = terms[j];
+                const double r = pairResidual(m, states[k], biases, &J);
+                double rho;
+                const double w = w0 * robustWeight(r, rho);
+                s.cost += rho;
+                Dk.noalias() += w * J * J.transpose();
+                gk += w * r * J;
+                if (m.bias >= 0)
+                {
+                    Hxb.block(6*k, m.bias, 6, 1) += w * m.sign * J;
+                    s.Hbb(m.bias, m.bias) += w;
+                    s.gb(m.bias) += w * m.sign * r;
+                }
+            }
+            if (k > 0)
+            {
+                motionWeight(times[k] - times[k-1], W, F);
+                const Vector6d e = states[k] - F * states[k-1];
+                Dk += W;
+                gk += W * e;
+            }
+            if (k + 1 < n)
+            {
+                motionWeight(times[k+1] - times[k], W, F);
+                const Vector6d e = states[k+1] - F * states[k];
+                const Matrix6d FW = F.transpose() * W;
+                Dk.noalias() += FW * F;
+                gk -= FW * e;
+                U[k] = -FW;
+                s.cost += e.dot(W * e);
+            }
+        }
+    });
+
+    Hbb.setZero(nb, nb);
+    gb.setZero(nb);
+    assembledCost = 0;
+    for (size_t i = 0; i < sums.size(); i++)
+    {
+        if (sums[i].Hbb.size() > 0)
+        {
+            Hbb += sums[i].Hbb;
+            gb += sums[i].gb;
+            assembledCost += sums[i].cost;
+        }
+    }
+    if (config.biasStd > 0)
+    {
+        const double wb = 1.0 / (config.biasStd * config.biasStd);
+        Hbb.diagonal().array() += wb;
+        gb += wb * biases;
+        assembledCost += wb * biases.squaredNorm();
+    }
+}
+
+/*
+ * Damped step from the assembled equations. Block tridiagonal elimination
+ * of the band for the gradient and the bias border together,
+ *      S_k = D_k - U_k-1' S_k-1^-1 U_k-1,   Y_k = R_k - C_k-1' Y_k-1
+ * with C_k-1 = S_k-1^-1 U_k-1, then back substitution. The biases follow
+ * from the Schur complement Hbb - Hxb' H^-1 Hxb, the states from the band.
+ */
+bool TrajectorySolver::solveStep(double lambda, StateVector &dx, Eigen::VectorXd &db)
+{
+    const size_t n = times.size(), nb = pairs.size();
+    const size_t m = 1 + nb;
+
+    std::vector<Eigen::LLT<Matrix6d>, Eigen::aligned_allocator<Eigen::LLT<Matrix6d> > > S(n);
+    BlockVector C(n);
+    Eigen::MatrixXd Y(6*n, m);
+    for (size_t k = 0; k < n; k++)
+    {
+        Matrix6d Sk = D[k];
+        Sk.diagonal() += lambda * D[k].diagonal().cwiseMax(TRAJECTORY_MIN_VARIANCE);
+        Y.block(6*k, 0, 6, 1) = gx[k];
+        Y.block(6*k, 1, 6, nb) = Hxb.block(6*k, 0, 6, nb);
+        if (k > 0)
+        {
+            Sk.noalias() -= U[k-1].transpose() * C[k-1];
+            Y.block(6*k, 0, 6, m) -= C[k-1].transpose() * Y.block(6*(k-1), 0, 6, m);
+        }
+        S[k].compute(Sk);
+        if (S[k].info() != Eigen::Success)
+        {
+            return false;
+        }
+        C[k] = S[k].solve(U[k]);
+    }
+    Eigen::MatrixXd X(6*n, m);
+    for (size_t k = n; k-- > 0;)
+    {
+        Eigen::MatrixXd R = Y.block(6*k, 0, 6, m);
+        if (k + 1 < n)
+        {
+            R.noalias() -= U[k] * X.block(6*(k+1), 0, 6, m);
+        }
+        X.block(6*k, 0, 6, m) = S[k].solve(R);
+    }
+
+    db.setZero(nb);
+    if (nb > 0)
+    {
+        Eigen::MatrixXd Sb = Hbb - Hxb.transpose() * X.rightCols(nb);
+        Sb.diagonal() += lambda * Hbb.diagonal();
+        const Eigen::VectorXd rb = gb - Hxb.transpose() * X.col(0);
+        Eigen::LDLT<Eigen::MatrixXd> ldlt(Sb);
+        if (ldlt.info() != Eigen::Success)
+        {
+            return false;
+        }
+        db = -ldlt.solve(rb);
+    }
+    const Eigen::VectorXd dxAll = -(X.col(0) + X.rightCols(nb) * db);
+    dx.resize(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        dx[k] = dxAll.segment<6>(6*k);
+    }
+    return dxAll.allFinite() && db.allFinite();
+}
+
+bool TrajectorySolver::solve()
+{
+    iterations.clear();
+    if (times.size() < 2)
+    {
+        return false;
+    }
+    if (biases.size() != (int)pairs.size())
+    {
+        biases.setZero(pairs.size());
+    }
+
+    double lambda = 1e-6;
+    for (int it = 0; it < config.maxIterations; it++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        assemble();
+        const double before = assembledCost;
+
+        // Marquardt: a step that does not lower the cost is retried with more damping
+        StateVector dx, x(states.size());
+        Eigen::VectorXd db;
+        double after = before;
+        int retry = 0;
+        for (; retry < 10; retry++)
+        {
+            if (solveStep(lambda, dx, db))
+            {
+                for (size_t k = 0; k < states.size(); k++)
+                {
+                    x[k] = states[k] + dx[k];
+                }
+                after = cost(x, biases + db);
+                if (after < before)
+                {
+                    break;
+                }
+            }
+            lambda *= 10;
+        }
+        if (retry == 10)
+        {
+            return it > 0;
+        }
+        states.swap(x);
+        biases += db;
+
+        double stepNorm = db.squaredNorm();
+        for (size_t k = 0; k < dx.size(); k++)
+        {
+            stepNorm += dx[k].squaredNorm();
+        }
+        trajectory_iteration_t iteration;
+        iteration.cost = after;
+        iteration.stepNorm = sqrt(stepNorm);
+        iteration.lambda = lambda;
+        iteration.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        iterations.push_back(iteration);
+        lambda = std::max(lambda / 10, 1e-9);
+
+        if (before - after < config.tolerance * before)
+        {
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+/*************************************************
+ *
+ *  UDP multicast position output, see udp_output.h
+ *
+ *************************************************/
+
+#include "udp_output.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpOutput::UdpOutput() : fd(-1), sender(0), seq(0), sendErrors(0), count(0), tickTime(0)
+{
+    memset(&destination, 0, sizeof(destination));
+    memset(&datagram, 0, sizeof(datagram));
+}
+
+UdpOutput::~UdpOutput()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool UdpOutput::open(const std::string &address, const std::string &interface, int ttl, uint16_t sender_id, std::string &error)
+{
+    const size_t colon = address.rfind(':');
+    const int port = (colon == std::string::npos) ? 0 : atoi(address.c_str() + colon + 1);
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(port);
+    if ((port <= 0) || (port > 65535) || (inet_pton(AF_INET, address.substr(0, colon).c_str(), &destination.sin_addr) != 1))
+    {
+        error = "udp_output " + address + " is not group:port";
+        return false;
+    }
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        error = "cannot create a UDP socket";
+        return false;
+    }
+    if (IN_MULTICAST(ntohl(destination.sin_addr.s_addr)))
+    {
+        const unsigned char hops = ttl;
+        // Consumers on the same host get the datagrams too
+        const unsigned char loop = 1;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        if (!interface.empty())
+        {
+            struct in_addr local;
+            if ((inet_pton(AF_INET, interface.c_str(), &local) != 1)
+                || (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &local, sizeof(local)) != 0))
+            {
+                close(fd);
+                fd = -1;
+                error = "cannot send udp_output from interface " + interface;
+                return false;
+            }
+        }
+    }
+
+    sender = sender_id;
+    datagram.header.magic = UDP_OUTPUT_MAGIC;
+    datagram.header.version = UDP_OUTPUT_VERSION;
+    datagram.header.sender = sender;
+    datagram.header.recordSize = sizeof(udp_position_record_t);
+    return true;
+}
+
+void UdpOutput::start(double now)
+{
+    tickTime = now;
+}
+
+void UdpOutput::add(uint16_t tag, uint8_t cell, uint8_t flags, uint32_t record_seq, const StateSample &sample)
+{
+    udp_position_record_t &r = datagram.records[count];
+    r.seq = record_seq;
+    r.tag = tag;
+    r.cell = cell;
+    r.flags = flags;
+    r.time = sample.t;
+    int c = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        r.pos[i] = sample.p(i);
+        r.vel[i] = sample.v(i);
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = i; j < 6; j++)
+        {
+            r.cov[c++] = sample.P(i,j);
+        }
+    }
+    r.reserved = 0;
+
+    if (++count == UDP_OUTPUT_MAX_RECORDS)
+    {
+        flush();
+    }
+}
+
+void UdpOutput::flush()
+{
+    if ((count == 0) || (fd < 0))
+    {
+        count = 0;
+        return;
+    }
+    datagram.header.count = count;
+    datagram.header.seq = seq++;
+    datagram.header.sendTime = tickTime;
+    const size_t size = sizeof(udp_output_header_t) + count * sizeof(udp_position_record_t);
+    // Never blocks the worker, a full socket buffer drops the datagram
+    if (sendto(fd, &datagram, size, MSG_DONTWAIT, (const struct sockaddr *)&destination, sizeof(destination)) != (ssize_t)size)
+    {
+        sendErrors++;
+    }
+    count = 0;
+}
@@ -0,0 +1,375 @@
+/*************************************************
+ *
+ *  libusb reader of a tag, see usb_port.h
+ *
+ *************************************************/
+
+#include "usb_port.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <libusb-1.0/libusb.h>
+
+#define CDC_SET_CONTROL_LINE_STATE  0x22
+#define CDC_LINE_DTR_RTS            0x03    // The tag firmware starts sending once the host raised DTR
+#define USB_CLOSE_TIMEOUT_MS        10      // Per round of events while the cancelled transfers come back
+
+bool isUsbPort(const std::string &port)
+{
+    return port.compare(0, strlen(USB_PORT_PREFIX), USB_PORT_PREFIX) == 0;
+}
+
+// "<vid>:<pid>[:<serial>]" after the prefix
+static bool parsePort(const std::string &port, uint16_t &vid, uint16_t &pid, std::string &serial)
+{
+    const std::string spec = port.substr(strlen(USB_PORT_PREFIX));
+    const size_t first = spec.find(':');
+    if (first == std::string::npos)
+    {
+        return false;
+    }
+    const size_t second = spec.find(':', first + 1);
+    char *end;
+    vid = (uint16_t)strtoul(spec.substr(0, first).c_str(), &end, 16);
+    if ((first == 0) || (*end != '\0'))
+    {
+        return false;
+    }
+    const std::string product = spec.substr(first + 1, (second == std::string::npos) ? std::string::npos : second - first - 1);
+    pid = (uint16_t)strtoul(product.c_str(), &end, 16);
+    if (product.empty() || (*end != '\0'))
+    {
+        return false;
+    }
+    serial = (second == std::string::npos) ? "" : spec.substr(second + 1);
+    return true;
+}
+
+UsbPort::UsbPort() : context(NULL), handle(NULL), dataInterface(-1), commInterface(-1), endpointIn(0), endpointOut(0),
+                     gone(false), errors(0), doneHead(0), doneCount(0), offset(0)
+{
+    memset(slots, 0, sizeof(slots));
+}
+
+UsbPort::~UsbPort()
+{
+    close();
+}
+
+bool UsbPort::open(const std::string &port, std::string &error)
+{
+    close();
+
+    uint16_t vid, pid;
+    std::string serial;
+    if (!parsePort(port, vid, pid, serial))
+    {
+        error = port + " is not usb:<vid>:<pid>[:<serial>]";
+        return false;
+    }
+    if (libusb_init(&context) != 0)
+    {
+        context = NULL;
+        error = "Cannot initialize libusb";
+        return false;
+    }
+
+    // The first tag with the IDs, and the serial number if one is given
+    libusb_device **list = NULL;
+    const ssize_t count = libusb_get_device_list(context, &list);
+    libusb_device *device = NULL;
+    for (ssize_t i = 0; (i < count) && !handle; i++)
+    {
+        libusb_device_descriptor desc;
+        if ((libusb_get_device_descriptor(list[i], &desc) != 0) || (desc.idVendor != vid) || (desc.idProduct != pid))
+        {
+            continue;
+        }
+        if (libusb_open(list[i], &handle) != 0)
+        {
+            handle = NULL;
+            continue;
+        }
+        unsigned char number[256];
+        if (!serial.empty() && ((libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, number, sizeof(number)) < 0) ||
+                                (serial != (const char *)number)))
+        {
+            libusb_close(handle);
+            handle = NULL;
+            continue;
+        }
+        device = list[i];
+    }
+
+    // The data interface has the bulk endpoints, the communication interface takes the line state
+    libusb_config_descriptor *config = NULL;
+    if (device && (libusb_get_active_config_descriptor(device, &config) == 0))
+    {
+        for (int i = 0; i < config->bNumInterfaces; i++)
+        {
+            if (config->interface[i].num_altsetting < 1)
+            {
+                continue;
+            }
+            const libusb_interface_descriptor &alt = config->interface[i].altsetting[0];
+            if ((alt.bInterfaceClass == LIBUSB_CLASS_COMM) && (commInterface < 0))
+            {
+                commInterface = alt.bInterfaceNumber;
+            }
+            if ((alt.bInterfaceClass != LIBUSB_CLASS_DATA) || (dataInterface >= 0))
+            {
+                continue;
+            }
+            uint8_t in = 0, out = 0;
+            for (int e = 0; e < alt.bNumEndpoints; e++)
+            {
+                const libusb_endpoint_descriptor &ep = alt.endpoint[e];
+                if ((ep.bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) != LIBUSB_TRANSFER_TYPE_BULK)
+                {
+                    continue;
+                }
+                ((ep.bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK) == LIBUSB_ENDPOINT_IN ? in : out) = ep.bEndpointAddress;
+            }
+            if (in && out)
+            {
+                dataInterface = alt.bInterfaceNumber;
+                endpointIn = in;
+                endpointOut = out;
+            }
+        }
+        libusb_free_config_descriptor(config);
+    }
+    libusb_free_device_list(list, 1);
+
+    if (!handle || (dataInterface < 0))
+    {
+        error = handle ? port + " has no CDC data interface" : "No tag " + port;
+        close();
+        return false;
+    }
+
+    // cdc_acm lets go of the interfaces and takes them back on release
+    libusb_set_auto_detach_kernel_driver(handle, 1);
+    if ((commInterface >= 0) && (libusb_claim_interface(handle, commInterface) != 0))
+    {
+        commInterface = -1;
+    }
+    if (libusb_claim_interface(handle, dataInterface) != 0)
+    {
+        error = "Cannot claim the data interface of " + port;
+        close();
+        return false;
+    }
+    if (commInterface >= 0)
+    {
+        libusb_control_transfer(handle, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE, CDC_SET_CONTROL_LINE_STATE,
+                                CDC_LINE_DTR_RTS, commInterface, NULL, 0, USB_WRITE_TIMEOUT_MS);
+    }
+
+    for (int i = 0; i < USB_TRANSFERS; i++)
+    {
+        Slot &slot = slots[i];
+        slot.port = this;
+        slot.transfer = libusb_alloc_transfer(0);
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+        slot.buffer = libusb_dev_mem_alloc(handle, USB_TRANSFER_SIZE);
+#endif
+        slot.pinned = (slot.buffer != NULL);
+        if (!slot.pinned)
+        {
+            slot.buffer = (uint8_t *)malloc(USB_TRANSFER_SIZE);
+        }
+        if (!slot.transfer || !slot.buffer)
+        {
+            error = "Out of memory for the transfers of " + port;
+            close();
+            return false;
+        }
+        libusb_fill_bulk_transfer(slot.transfer, handle, endpointIn, slot.buffer, USB_TRANSFER_SIZE, completed, &slot, 0);
+    }
+    for (int i = 0; i < USB_TRANSFERS; i++)
+    {
+        if (!submit(slots[i]))
+        {
+            error = "Cannot start the transfers of " + port;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void UsbPort::close()
+{
+    if (context && handle)
+    {
+        // A transfer can only be freed once its cancellation came back
+        for (int i = 0; i < USB_TRANSFERS; i++)
+        {
+            if (slots[i].pending)
+            {
+                libusb_cancel_transfer(slots[i].transfer);
+            }
+        }
+        for (int round = 0; round < 100; round++)
+        {
+            bool pending = false;
+            for (int i = 0; i < USB_TRANSFERS; i++)
+            {
+                pending = pending || slots[i].pending;
+            }
+            if (!pending)
+            {
+                break;
+            }
+            timeval tv = {0, USB_CLOSE_TIMEOUT_MS * 1000};
+            libusb_handle_events_timeout_completed(context, &tv, NULL);
+        }
+    }
+    for (int i = 0; i < USB_TRANSFERS; i++)
+    {
+        Slot &slot = slots[i];
+        if (slot.pending)
+        {
+            // Still owned by libusb, leaked rather than freed under it
+            continue;
+        }
+        if (slot.transfer)
+        {
+            libusb_free_transfer(slot.transfer);
+        }
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+        if (slot.pinned)
+        {
+            libusb_dev_mem_free(handle, slot.buffer, USB_TRANSFER_SIZE);
+        }
+#endif
+        if (!slot.pinned)
+        {
+            free(slot.buffer);
+        }
+    }
+    memset(slots, 0, sizeof(slots));
+
+    if (handle)
+    {
+        if (dataInterface >= 0)
+        {
+            libusb_release_interface(handle, dataInterface);
+        }
+        if (commInterface >= 0)
+        {
+            libusb_release_interface(handle, commInterface);
+        }
+        libusb_close(handle);
+        handle = NULL;
+    }
+    if (context)
+    {
+        libusb_exit(context);
+        context = NULL;
+    }
+    dataInterface = commInterface = -1;
+    endpointIn = endpointOut = 0;
+    gone = false;
+    doneHead = doneCount = 0;
+    offset = 0;
+}
+
+bool UsbPort::submit(Slot &slot)
+{
+    if (libusb_submit_transfer(slot.transfer) != 0)
+    {
+        return false;
+    }
+    slot.pending = true;
+    return true;
+}
+
+/*
+ * Runs inside libusb_handle_events of the reading thread. Data goes to the
+ * completed list, an empty or failed transfer goes straight back.
+ */
+void UsbPort::completed(libusb_transfer *transfer)
+{
+    Slot &slot = *(Slot *)transfer->user_data;
+    UsbPort &port = *slot.port;
+    slot.pending = false;
+
+    switch (transfer->status)
+    {
+    case LIBUSB_TRANSFER_COMPLETED:
+        if (transfer->actual_length > 0)
+        {
+            port.done[(port.doneHead + port.doneCount) % USB_TRANSFERS] = (int)(&slot - port.slots);
+            port.doneCount++;
+            return;
+        }
+        break;
+    case LIBUSB_TRANSFER_CANCELLED:
+        return;
+    case LIBUSB_TRANSFER_NO_DEVICE:
+        port.gone = true;
+        return;
+    default:
+        port.errors++;
+        break;
+    }
+    if (!port.submit(slot))
+    {
+        port.gone = true;
+    }
+}
+
+bool UsbPort::waitReadable(int timeoutMs)
+{
+    if (!handle || gone)
+    {
+        return false;
+    }
+    if (doneCount == 0)
+    {
+        timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        libusb_handle_events_timeout_completed(context, &tv, NULL);
+    }
+    return doneCount > 0;
+}
+
+size_t UsbPort::read(uint8_t *data, size_t size)
+{
+    size_t copied = 0;
+    while ((copied < size) && (doneCount > 0))
+    {
+        Slot &slot = slots[done[doneHead]];
+        const size_t length = slot.transfer->actual_length;
+        const size_t n = std::min(size - copied, length - offset);
+        memcpy(data + copied, slot.buffer + offset, n);
+        copied += n;
+        offset += n;
+        if (offset < length)
+        {
+            break;
+        }
+
+        offset = 0;
+        doneHead = (doneHead + 1) % USB_TRANSFERS;
+        doneCount--;
+        if (!submit(slot))
+        {
+            gone = true;
+        }
+    }
+    return copied;
+}
+
+size_t UsbPort::write(const uint8_t *data, size_t size)
+{
+    if (!handle || gone)
+    {
+        return 0;
+    }
+    int sent = 0;
+    libusb_bulk_transfer(handle, endpointOut, const_cast<uint8_t *>(data), (int)size, &sent, USB_WRITE_TIMEOUT_MS);
+    return (size_t)sent;
+}
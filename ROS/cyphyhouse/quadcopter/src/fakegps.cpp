@@ -2,13 +2,21 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <memory>
 #include <csignal>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <chrono>
 #include <atomic>
+#include <string>
 
-#include <GeographicLib/Geocentric.hpp>
-#include <GeographicLib/LocalCartesian.hpp>
+#include <boost/bind.hpp>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
 
 #include <eigen_conversions/eigen_msg.h>
 #include <mavros/mavros_plugin.h>
@@ -19,17 +27,29 @@
 #include <mavros_msgs/CommandBool.h>
 #include <mavros_msgs/CommandHome.h>
 #include <mavros_msgs/SetMode.h>
+#include <mavros_msgs/PositionTarget.h>
 #include <std_msgs/String.h>
 
 #include "ros/ros.h"
 #include "geometry_msgs/PoseStamped.h"
 #include "geometry_msgs/TwistStamped.h"
+#include "geometry_msgs/PoseWithCovarianceStamped.h"
+#include "geometry_msgs/TwistWithCovarianceStamped.h"
 #include "geometry_msgs/PointStamped.h"
+#include "nav_msgs/Path.h"
 #include "ros/package.h"
+#include "cyphy_control/AsyncLog.h"
+#include "cyphy_control/Metrics.h"
+#include "cyphy_control/MinSnap.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/TrajectoryRecorder.h"
 
 #define GPS_RATE 10 //Hz
-#define WP_RATE 10 //Hz
-#define PRINT_RATE 100 //Hz
+#define VICON_ATT_VARIANCE 1e-4 //rad^2
+#define UNKNOWN_VARIANCE 1e6  // Orientation of the decawave EKF, not estimated
+#define FCU_PORT 14550  // UDP port of the first vehicle, SITL instances are FCU_PORT_STEP apart
+#define FCU_PORT_STEP 10
 
 #define WP_RADIUS 0.3 //m
 #define TAKEOFF_H 0.5 //m
@@ -38,86 +58,335 @@
 #define LAND_TIMEOUT 10.0 //s
 #define GOTO_TIMEOUT 5.0 //s
 #define VICON_TIMEOUT 3.0 //s
+#define RETRY_DELAY 0.1 //s, before a failed takeoff or land is sent again
+#define IDLE_WAIT 0.5 //s, longest sendWP sleeps without an event
+#define PRINT_PERIOD 1.0 //s
+#define SETPOINT_RATE 50.0 //Hz, of the setpoints along a smooth path
 
 const double lat0 = 40.116, lon0 = -88.224;  // IRL GPS coords
-std::atomic<bool> gotWP_flag (false);
 
-enum Stage { ground, takeoff, flight, land, landing };
-std::atomic<Stage> quad_state (ground);
+// takeoff_cmd and land_cmd wait for the MAVROS calls of takeoff and land
+enum Stage { ground, takeoff_cmd, takeoff, flight, land, land_cmd, landing };
+
+// A smooth path as sendSetpoints streams it, from start on
+struct StreamedPath
+{
+    MinSnapTrajectory trajectory;
+    ros::Time start;
+};
+
+// The latest pose as the vision feed sends it, in the VICON frame
+struct VisionPose
+{
+    ros::Time stamp;
+    geometry_msgs::Point position;
+    geometry_msgs::Quaternion orientation;
+    bool has_orientation;
+    double position_cov[9];     // row-major over x, y, z
+};
 
-ros::ServiceClient arming_client, takeoff_client, land_client, mode_client, sethome_client;
-ros::Publisher postarget_pub, reached_pub;
+/*
+ * One quadcopter of the process: its topics, MAVROS services and MAVLink
+ * link, its latest position and its mission. The vehicles sit in one array
+ * and share the projection, the service worker and the threads, so a swarm
+ * costs a few threads in all rather than a few per vehicle.
+ */
+struct Vehicle
+{
+    Vehicle() : fcu_system_id(1), gotWP_flag(false), quad_state(ground), path_changed(false), takeoff_flag(false),
+                event_pending(false), call_finished(false), call_ok(false), emergency_flag(false) {}
 
-geometry_msgs::Point current_pos, current_waypoint, takeoff_pos;
-geometry_msgs::Twist current_vel;
+    // Prefixes the lines of the vehicle, empty for the single vehicle of a plain configuration
+    std::string name;
 
-std::vector<geometry_msgs::Point> waypoints;
+    ros::ServiceClient arming_client, takeoff_client, land_client, mode_client, sethome_client;
+    ros::Publisher postarget_pub, setpoint_pub, reached_pub;
+    ros::Subscriber pos_sub, vel_sub, wp_sub, path_sub;
+    mavconn::MAVConnInterface::Ptr link;
+    int fcu_system_id;
 
-mavconn::MAVConnInterface::Ptr ardupilot_link;
+    // Latest position and velocity and when the position came, written by their callbacks and read by the threads
+    Snapshot<geometry_msgs::Point> current_pos;
+    Snapshot<geometry_msgs::Twist> current_vel;
+    Snapshot<ros::Time> pos_time;
+    Snapshot<VisionPose> vision_pose;
+    // Trajectory of the flight, recorded by the position callback off the ground if record_trajectory is set
+    std::unique_ptr<TrajectoryRecorder> trajectory;
 
-GeographicLib::Geoid egm96_5("egm96-5", "", true, true);
-GeographicLib::Geocentric earth(GeographicLib::Constants::WGS84_a(), GeographicLib::Constants::WGS84_f());
-GeographicLib::LocalCartesian proj(lat0, lon0, 0, earth);
+    std::atomic<bool> gotWP_flag;
+    std::atomic<Stage> quad_state;
+    // Guards waypoints and current_waypoint, which getWP changes on a new path
+    std::mutex wp_mutex;
+    std::vector<geometry_msgs::Point> waypoints;
+    // A new path came in, flown from where the quad is with smooth_paths
+    bool path_changed;
+    geometry_msgs::Point current_waypoint, takeoff_pos;
+    bool takeoff_flag;
+    // sendWP only
+    ros::Time stage_time, retry_time;
+    // The feed only, the last pose sent in vision mode
+    ros::Time sent_stamp;
 
-std::thread gps_thread, print_thread, pos_thread, wp_thread;
-std::mutex wp_mutex;
+    // Under event_mutex: an event to step on, and the result of the service call the mission waits for
+    bool event_pending;
+    bool call_finished, call_ok;
+    // Set by emergencyLand, sendWP lands in its place
+    std::atomic<bool> emergency_flag;
 
-ros::Time pos_time;
+    // Swapped whole by sendWP (std::atomic_store) and read by sendSetpoints, null while there is nothing to stream
+    std::shared_ptr<const StreamedPath> streamed;
+};
 
-void emergencyLand()
+// All vehicles of the process, contiguous and never moved once set up
+std::unique_ptr<Vehicle[]> vehicles;
+size_t n_vehicles = 0;
+
+// Stream VISION_POSITION_ESTIMATE at vision_rate instead of HIL_GPS at GPS_RATE
+bool use_vision;
+double vision_rate;
+double feed_phase;     // s, offset of the feed into its period, see PeriodicLoop
+// Wake-ups and overruns of the feed and the positions it sent, served on metrics_port
+std::unique_ptr<LoopJitter> feed_jitter;
+MetricCounter *feed_metric;
+// Variance [m^2] of a VICON position
+double vicon_variance;
+
+// Fly the waypoints of a path up to a landing point as one minimum snap trajectory, its position, velocity and
+// acceleration streamed at SETPOINT_RATE, instead of stopping at each of them
+bool smooth_paths;
+MinSnapLimits snap_limits;
+
+/*
+ * East, north, up around (lat0, lon0, 0) to WGS84 latitude, longitude and
+ * height. The arena is a few metres across, so the tangent plane is expanded
+ * to second order around the origin with its radii of curvature computed
+ * once: under 0.1 mm off the exact conversion within 100 m, far below the
+ * 1e-7 degree resolution of the messages.
+ */
+class LocalTangentPlane
 {
-    std::cout << "Emergency Land" << std::endl;
-    quad_state = land;
-    wp_mutex.lock();
-    current_waypoint = current_pos;
-    wp_mutex.unlock();
-    gotWP_flag = true;
+public:
+    LocalTangentPlane(double lat, double lon) : lat0(lat * M_PI / 180), lon0(lon * M_PI / 180)
+    {
+        const double a = 6378137.0, f = 1 / 298.257223563;
+        const double e2 = f * (2 - f);
+        const double s = sin(lat0);
+        const double w = 1 - e2 * s * s;
+        n_radius = a / sqrt(w);
+        m_radius = a * (1 - e2) / (w * sqrt(w));
+        tan_lat = tan(lat0);
+        cos_lat = cos(lat0);
+    }
+
+    // lat and lon in degrees, h in metres
+    void reverse(double east, double north, double up, double& lat, double& lon, double& h) const
+    {
+        lat = lat0 + north / m_radius - tan_lat * east * east / (2 * m_radius * n_radius);
+        lon = lon0 + east / (n_radius * cos_lat) * (1 + north * tan_lat / m_radius);
+        h = up + east * east / (2 * n_radius) + north * north / (2 * m_radius);
+        lat *= 180 / M_PI;
+        lon *= 180 / M_PI;
+    }
+
+private:
+    double lat0, lon0;
+    // Prime vertical and meridian radii of curvature at the origin
+    double n_radius, m_radius;
+    double tan_lat, cos_lat;
+};
+
+const LocalTangentPlane proj(lat0, lon0);
+
+std::thread feed_thread, wp_thread, setpoint_thread;
+// Log of the waypoint loop, printed and written by the background thread of async_log
+LogChannel wp_log("sendWP");
+
+// Wakes sendWP: a waypoint, a position, a finished service call or an emergency of any vehicle
+std::mutex event_mutex;
+std::condition_variable event_cv;
+
+void notifyWP(Vehicle& v)
+{
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        v.event_pending = true;
+    }
+    event_cv.notify_one();
 }
 
-void getPosition(const geometry_msgs::PoseStamped& posestamped)
+void finishCall(Vehicle& v, bool ok)
 {
-    current_pos = posestamped.pose.position;
-    pos_time = ros::Time::now();
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        v.call_finished = true;
+        v.call_ok = ok;
+        v.event_pending = true;
+    }
+    event_cv.notify_one();
 }
 
-void getVelocity(const geometry_msgs::TwistStamped& twiststamped)
+/*
+ * Runs the MAVROS service calls of sendWP one after the other on a thread of
+ * its own, so the state machine never waits for their round-trips. A call
+ * returns whether it succeeded and done gets that, on the worker thread.
+ */
+class ServiceWorker
 {
-    current_vel = twiststamped.twist;
+public:
+    ServiceWorker() : running(false) {}
+
+    void start()
+    {
+        running = true;
+        thread = std::thread(&ServiceWorker::run, this);
+    }
+
+    // Finishes the calls posted so far
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    void post(std::function<bool()> call, std::function<void(bool)> done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.emplace_back(std::move(call), std::move(done));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            cv.wait(lock, [this] { return !running || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+            std::pair<std::function<bool()>, std::function<void(bool)>> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job.second(job.first());
+            lock.lock();
+        }
+    }
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<std::function<bool()>, std::function<void(bool)>>> jobs;
+    bool running;
+};
+
+ServiceWorker service_worker;
+
+void emergencyLand(Vehicle& v)
+{
+    v.emergency_flag = true;
+    notifyWP(v);
+}
+
+void storePosition(Vehicle& v, const geometry_msgs::Point& p, const ros::Time& now)
+{
+    v.current_pos.store(p);
+    v.pos_time.store(now);
+    if (v.trajectory && v.quad_state != ground)
+    {
+        v.trajectory->record(now.toNSec(), p.x, p.y, p.z);
+    }
+    notifyWP(v);
+}
+
+void getPosition(Vehicle& v, const geometry_msgs::PoseStampedConstPtr& posestamped)
+{
+    const ros::Time now = ros::Time::now();
+    storePosition(v, posestamped->pose.position, now);
+
+    VisionPose pose = {};
+    pose.stamp = now;
+    pose.position = posestamped->pose.position;
+    pose.orientation = posestamped->pose.orientation;
+    pose.has_orientation = true;
+    for (int i = 0; i < 3; i++)
+    {
+        pose.position_cov[i*4] = vicon_variance;
+    }
+    v.vision_pose.store(pose);
+}
+
+void getVelocity(Vehicle& v, const geometry_msgs::TwistStampedConstPtr& twiststamped)
+{
+    v.current_vel.store(twiststamped->twist);
+}
+
+// The decawave EKF, with the covariance of its position
+void getDecaPose(Vehicle& v, const geometry_msgs::PoseWithCovarianceStampedConstPtr& posestamped)
+{
+    const ros::Time now = ros::Time::now();
+    storePosition(v, posestamped->pose.pose.position, now);
+
+    VisionPose pose = {};
+    pose.stamp = now;
+    pose.position = posestamped->pose.pose.position;
+    pose.orientation.w = 1;
+    pose.has_orientation = false;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            pose.position_cov[i*3 + j] = posestamped->pose.covariance[i*6 + j];
+        }
+    }
+    v.vision_pose.store(pose);
+}
+
+void getDecaTwist(Vehicle& v, const geometry_msgs::TwistWithCovarianceStampedConstPtr& twiststamped)
+{
+    v.current_vel.store(twiststamped->twist.twist);
 }
 
-bool takeoff_seq(const geometry_msgs::Point point)
+bool takeoff_seq(Vehicle& v, const geometry_msgs::Point point)
 {
-    static bool takeoff_flag = false;
+    const char *name = v.name.c_str();
     mavros_msgs::SetMode mode_msg;
     mode_msg.request.base_mode = 0;
     mode_msg.request.custom_mode = "GUIDED";
-    mode_client.call(mode_msg);
+    v.mode_client.call(mode_msg);
 
     double lat, lon, h;
-    proj.Reverse(point.y, -point.x, point.z, lat, lon, h);
+    proj.reverse(point.y, -point.x, point.z, lat, lon, h);
 
     mavros_msgs::CommandBool arming_msg;
     mavros_msgs::CommandTOL takeoff_msg;
     arming_msg.request.value = true;
-    if (arming_client.call(arming_msg)) {
-        ROS_INFO("arming cmd success");
+    if (v.arming_client.call(arming_msg)) {
+        ROS_INFO("%s arming cmd success", name);
     }
     else {
-        ROS_INFO("arming cmd failed");
+        ROS_INFO("%s arming cmd failed", name);
         return false;
     }
-        
+
     takeoff_msg.request.min_pitch = 0; //have no idea about this
     takeoff_msg.request.yaw = 0;
     takeoff_msg.request.latitude = lat; // This is either the first waypoint or whatever the initial position is
     takeoff_msg.request.longitude = lon;
     takeoff_msg.request.altitude = h;
 
-    if (takeoff_client.call(takeoff_msg)) {
-        ROS_INFO("takeoff cmd success");
+    if (v.takeoff_client.call(takeoff_msg)) {
+        ROS_INFO("%s takeoff cmd success", name);
     }
     else {
-        ROS_INFO("takeoff cmd failed");
+        ROS_INFO("%s takeoff cmd failed", name);
         return false;
     }
 
@@ -126,22 +395,24 @@ bool takeoff_seq(const geometry_msgs::Point point)
     sethome_msg.request.latitude = lat0;
     sethome_msg.request.longitude = lon0;
     sethome_msg.request.altitude = 0;
-    sethome_client.call(sethome_msg);
+    v.sethome_client.call(sethome_msg);
 
-    if (takeoff_flag == false)
+    // The local frame of ArduPilot starts where GPS arms it, with vision it is the VICON frame itself
+    if (v.takeoff_flag == false && !use_vision)
     {
-        takeoff_pos = current_pos;
-        takeoff_flag = true;
+        v.takeoff_pos = v.current_pos.load();
+        v.takeoff_flag = true;
     }
 
     return true;
 }
 
-bool land_seq(const geometry_msgs::Point point)
+bool land_seq(Vehicle& v, const geometry_msgs::Point point)
 {
+    const char *name = v.name.c_str();
     double lat, lon, h;
-    proj.Reverse(point.y, -point.x, point.z, lat, lon, h);
-    
+    proj.reverse(point.y, -point.x, point.z, lat, lon, h);
+
     mavros_msgs::CommandBool arming_msg;
     mavros_msgs::CommandTOL land_msg;
     land_msg.request.min_pitch = 0;
@@ -149,381 +420,831 @@ bool land_seq(const geometry_msgs::Point point)
     land_msg.request.latitude = lat;
     land_msg.request.longitude = lon;
     land_msg.request.altitude = 0;
-    if (land_client.call(land_msg)) {
-        ROS_INFO("landing cmd success");
+    if (v.land_client.call(land_msg)) {
+        ROS_INFO("%s landing cmd success", name);
     }
     else {
-        ROS_INFO("landing cmd failed");
+        ROS_INFO("%s landing cmd failed", name);
         return false;
     }
-     
+
     arming_msg.request.value = false;
-    if (arming_client.call(arming_msg)) {
-        ROS_INFO("disarming cmd success");
+    if (v.arming_client.call(arming_msg)) {
+        ROS_INFO("%s disarming cmd success", name);
     }
     else {
-        ROS_INFO("disarming cmd failed");
+        ROS_INFO("%s disarming cmd failed", name);
         return false;
     }
-    
+
     return true;
 }
 
-void sendPosition(const geometry_msgs::Point point)
+void sendPosition(Vehicle& v, const geometry_msgs::Point point)
 {
     geometry_msgs::PoseStamped postarget_msg;
     postarget_msg.header.stamp = ros::Time::now();
     postarget_msg.header.frame_id = '0';
-    postarget_msg.pose.position.x = point.y - takeoff_pos.y;
-    postarget_msg.pose.position.y = -(point.x - takeoff_pos.x);
-    postarget_msg.pose.position.z = (point.z - takeoff_pos.z);
-    postarget_pub.publish(postarget_msg);
-    
-    std::cout << "Publishing point x: " << point.x << ", y: " << point.y << ", z: " << point.z << std::endl;                    
+    postarget_msg.pose.position.x = point.y - v.takeoff_pos.y;
+    postarget_msg.pose.position.y = -(point.x - v.takeoff_pos.x);
+    postarget_msg.pose.position.z = (point.z - v.takeoff_pos.z);
+    v.postarget_pub.publish(postarget_msg);
+
+    wp_log.info("Publishing point x: %f, y: %f, z: %f", point.x, point.y, point.z);
 }
 
-inline double goalDist(const geometry_msgs::Point point)
+void stopStreaming(Vehicle& v)
 {
-    return sqrt(pow(current_pos.x - point.x,2) + pow(current_pos.y - point.y,2) + pow(current_pos.z - point.z,2));
+    std::atomic_store(&v.streamed, std::shared_ptr<const StreamedPath>());
 }
 
-void printPos()
+/*
+ * One trajectory from where v is through current_waypoint and the waypoints
+ * after it up to a landing point, streamed by sendSetpoints from now on.
+ * Its end becomes current_waypoint, so the mission sees one long leg. Falls
+ * back to a position target at current_waypoint if it cannot be fitted.
+ */
+void startStreaming(Vehicle& v, const ros::Time& now)
 {
-    ros::Rate pr(1);
-    while(ros::ok())
+    std::vector<Eigen::Vector3d> points;
+    const geometry_msgs::Point pos = v.current_pos.load();
+    points.emplace_back(pos.x, pos.y, pos.z);
+
+    v.wp_mutex.lock();
+    points.emplace_back(v.current_waypoint.x, v.current_waypoint.y, v.current_waypoint.z);
+    size_t taken = 0;
+    while ((taken < v.waypoints.size()) && (v.waypoints[taken].z > 0.0))
+    {
+        points.emplace_back(v.waypoints[taken].x, v.waypoints[taken].y, v.waypoints[taken].z);
+        taken++;
+    }
+    if (taken > 0)
+    {
+        v.current_waypoint = v.waypoints[taken - 1];
+        v.waypoints.erase(v.waypoints.begin(), v.waypoints.begin() + taken);
+    }
+    v.path_changed = false;
+    v.wp_mutex.unlock();
+
+    std::shared_ptr<StreamedPath> path(new StreamedPath);
+    if (!path->trajectory.build(points, snap_limits))
+    {
+        stopStreaming(v);
+        sendPosition(v, v.current_waypoint);
+        return;
+    }
+    path->start = now;
+    std::atomic_store(&v.streamed, std::shared_ptr<const StreamedPath>(path));
+    wp_log.info("%s trajectory through %zu points in %f s", v.name.c_str(), points.size(), path->trajectory.duration());
+}
+
+// Sets off to current_waypoint, smoothly on through the waypoints after it with smooth_paths
+void goToWaypoint(Vehicle& v, const ros::Time& now)
+{
+    if (smooth_paths)
+    {
+        startStreaming(v, now);
+    }
+    else
+    {
+        sendPosition(v, v.current_waypoint);
+    }
+}
+
+inline double goalDist(Vehicle& v, const geometry_msgs::Point point)
+{
+    const geometry_msgs::Point pos = v.current_pos.load();
+    return sqrt(pow(pos.x - point.x,2) + pow(pos.y - point.y,2) + pow(pos.z - point.z,2));
+}
+
+// Lands if the position stopped coming in flight
+void checkPositionTimeout(Vehicle& v)
+{
+    if (((ros::Time::now() - v.pos_time.load()).toSec() > VICON_TIMEOUT) && (v.quad_state == flight))
     {
-        ROS_INFO("x: %f, y: %f, z: %f\n", current_pos.x, current_pos.y, current_pos.z);
-        pr.sleep();
+        emergencyLand(v);
     }
-    std::cout << "Done print loop" << std::endl;
 }
 
-void sendFakeGPS()
+void sendFakeGPS(Vehicle& v)
 {
     mavlink::common::msg::HIL_GPS fix {};
-    ros::Rate r(GPS_RATE);
 
-    while(ros::ok())
+    geometry_msgs::Point point = v.current_pos.load();
+    const geometry_msgs::Vector3 vel = v.current_vel.load().linear;
+
+    double lat, lon, h;
+    //ROS_INFO("x: %f, y: %f, z: %f\n", point.x, point.y, point.z);
+    proj.reverse(point.y, -point.x, point.z, lat, lon, h);
+    //ROS_INFO("latitude: %f, longitude: %f, altitude: %f", lat, lon, h);
+
+    // compute course over ground (borrowed from mavros)
+    double cog;
+    if (vel.x == 0 && vel.y == 0) {
+        cog = 0;
+    }
+    else if (vel.x >= 0 && vel.y < 0) {
+        cog = M_PI * 5 / 2 - atan2(vel.x, vel.y);
+    }
+    else {
+        cog = M_PI / 2 - atan2(vel.x, vel.y);
+    }
+
+    // populate GPS message
+    fix.time_usec = ros::Time::now().toNSec() / 1000;
+    fix.lat = lat * 1e7;
+    fix.lon = lon * 1e7;
+    fix.alt = h * 1e3;
+    fix.vel = sqrt(pow(vel.x, 2) + pow(vel.y, 2) + pow(vel.z, 2)) * 100;
+    fix.vn = -vel.x * 100;
+    fix.ve = vel.y * 100;
+    fix.vd = -vel.z * 100;
+    fix.cog = cog * 1e2;
+    fix.eph = 1;
+    fix.epv = 1;
+    fix.fix_type = 3;
+    fix.satellites_visible = 6;
+
+    // send it
+    v.link->send_message_ignore_drop(fix);
+}
+
+// Index of (i, j), i <= j, in the upper triangle of a 6x6 covariance stored row by row
+inline int upperIndex(int i, int j)
+{
+    return i*6 - i*(i-1)/2 + (j - i);
+}
+
+/*
+ * Sends the pose to ArduPilot as an external navigation source, in the NED
+ * frame of the arena (north = -x, east = y, down = -z of VICON), so no GPS
+ * and no geodetic conversion is involved. Each pose is sent once.
+ */
+void sendVisionPosition(Vehicle& v)
+{
+    const double flip[3] = {-1, 1, -1};
+    // VICON to NED, and the FLU body of VICON to the FRD body of ArduPilot
+    static const Eigen::Matrix3d world_ned = Eigen::Vector3d(-1, 1, -1).asDiagonal();
+    static const Eigen::Matrix3d body_frd = Eigen::Vector3d(1, -1, -1).asDiagonal();
+
+    const VisionPose pose = v.vision_pose.load();
+    if (pose.stamp == v.sent_stamp)
     {
-    
-        if (((ros::Time::now() - pos_time).toSec() > VICON_TIMEOUT) && (quad_state == flight))
+        return;
+    }
+    v.sent_stamp = pose.stamp;
+
+    mavlink::common::msg::VISION_POSITION_ESTIMATE estimate {};
+    estimate.usec = pose.stamp.toNSec() / 1000;
+    estimate.x = -pose.position.x;
+    estimate.y = pose.position.y;
+    estimate.z = -pose.position.z;
+
+    const geometry_msgs::Quaternion& q = pose.orientation;
+    const Eigen::Matrix3d rot = world_ned * Eigen::Quaterniond(q.w, q.x, q.y, q.z).toRotationMatrix() * body_frd;
+    estimate.roll = atan2(rot(2, 1), rot(2, 2));
+    estimate.pitch = -asin(fmax(fmin(rot(2, 0), 1.0), -1.0));
+    estimate.yaw = atan2(rot(1, 0), rot(0, 0));
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = i; j < 3; j++)
         {
-            emergencyLand();
+            estimate.covariance[upperIndex(i, j)] = flip[i] * flip[j] * pose.position_cov[i*3 + j];
         }
-       
-       	geometry_msgs::Point point = current_pos;
-         
-        double lat, lon, h;
-        //ROS_INFO("x: %f, y: %f, z: %f\n", point.x, point.y, point.z);
-        proj.Reverse(point.y, -point.x, point.z, lat, lon, h);
-        //ROS_INFO("latitude: %f, longitude: %f, altitude: %f", lat, lon, h);
-
-        // compute course over ground (borrowed from mavros)
-        double cog;
-        if (current_vel.linear.x == 0 && current_vel.linear.y == 0) {
-            cog = 0;
-        }
-        else if (current_vel.linear.x >= 0 && current_vel.linear.y < 0) {
-            cog = M_PI * 5 / 2 - atan2(current_vel.linear.x, current_vel.linear.y);
+        estimate.covariance[upperIndex(i + 3, i + 3)] = pose.has_orientation ? VICON_ATT_VARIANCE : UNKNOWN_VARIANCE;
+    }
+
+    v.link->send_message_ignore_drop(estimate);
+}
+
+// Origin of the EKF of ArduPilot, which has no GPS to take it from in vision mode
+void sendGlobalOrigin(Vehicle& v)
+{
+    mavlink::common::msg::SET_GPS_GLOBAL_ORIGIN origin {};
+    origin.target_system = v.fcu_system_id;
+    origin.latitude = lat0 * 1e7;
+    origin.longitude = lon0 * 1e7;
+    origin.altitude = 0;
+    origin.time_usec = ros::Time::now().toNSec() / 1000;
+    v.link->send_message_ignore_drop(origin);
+}
+
+/*
+ * The position feed of every vehicle on one timer: HIL_GPS at GPS_RATE or
+ * VISION_POSITION_ESTIMATE at vision_rate, each over the link of its vehicle.
+ * Prints the positions every PRINT_PERIOD.
+ */
+void sendFeed()
+{
+    PeriodicLoop r(1.0 / (use_vision ? vision_rate : GPS_RATE), feed_phase, feed_jitter.get());
+    ros::Time printed;
+
+    while(ros::ok())
+    {
+        const ros::Time now = ros::Time::now();
+        const bool print = (now - printed).toSec() >= PRINT_PERIOD;
+        if (print)
+        {
+            printed = now;
         }
-        else {
-            cog = M_PI / 2 - atan2(current_vel.linear.x, current_vel.linear.y);
+
+        for (size_t i = 0; i < n_vehicles; i++)
+        {
+            Vehicle& v = vehicles[i];
+            checkPositionTimeout(v);
+            if (use_vision)
+            {
+                sendVisionPosition(v);
+            }
+            else
+            {
+                sendFakeGPS(v);
+            }
+            feed_metric->add();
+
+            if (print)
+            {
+                const geometry_msgs::Point pos = v.current_pos.load();
+                ROS_INFO("%s x: %f, y: %f, z: %f\n", v.name.c_str(), pos.x, pos.y, pos.z);
+            }
         }
 
-        // populate GPS message
-        fix.time_usec = ros::Time::now().toNSec() / 1000;
-        fix.lat = lat * 1e7;
-        fix.lon = lon * 1e7;
-        fix.alt = h * 1e3;
-        fix.vel = sqrt(pow(current_vel.linear.x, 2) + pow(current_vel.linear.y, 2) + pow(current_vel.linear.z, 2)) * 100;
-        fix.vn = -current_vel.linear.x * 100;
-        fix.ve = current_vel.linear.y * 100;
-        fix.vd = -current_vel.linear.z * 100;
-        fix.cog = cog * 1e2;
-        fix.eph = 1;
-        fix.epv = 1;
-        fix.fix_type = 3;
-        fix.satellites_visible = 6;
-
-        // send it
-        ardupilot_link.get()->send_message_ignore_drop(fix);
-        
         r.sleep();
     }
-    std::cout << "Done GPS loop" << std::endl;
+    std::cout << "Done feed loop" << std::endl;
 }
 
-void sendWP()
+// When the stage of v times out, zero if it has nothing to time out
+ros::Time stageDeadline(const Vehicle& v)
+{
+    if (!v.gotWP_flag)
+    {
+        return ros::Time();
+    }
+    switch(v.quad_state)
+    {
+        case ground: case land: return v.retry_time;
+        case takeoff: return v.stage_time + ros::Duration(TAKEOFF_TIMEOUT);
+        case flight: return v.stage_time + ros::Duration(GOTO_TIMEOUT);
+        case landing: return v.stage_time + ros::Duration(LAND_TIMEOUT);
+        default: return ros::Time();
+    }
+}
+
+// One step of the mission of v, finished and ok are the result of the service call it waits for
+void stepMission(Vehicle& v, bool finished, bool ok)
 {
-    ros::Time stage_time;
-    ros::Rate r(WP_RATE);
+    if (v.emergency_flag.exchange(false) && v.quad_state == flight)
+    {
+        std::cout << v.name << " Emergency Land" << std::endl;
+        v.wp_mutex.lock();
+        v.current_waypoint = v.current_pos.load();
+        v.wp_mutex.unlock();
+        v.gotWP_flag = true;
+        v.quad_state = land;
+        stopStreaming(v);
+    }
 
-    while(ros::ok())
+    if (!v.gotWP_flag)
+    {
+        return;
+    }
+
+    const ros::Time now = ros::Time::now();
+    switch(v.quad_state)
     {
-        if (gotWP_flag)
+        case ground: // currently not flying, takeoff
         {
-            switch(quad_state)
+            if (now < v.retry_time)
             {
-                case ground: // currently not flying, takeoff
-                {
-                    wp_mutex.lock();
-                    current_waypoint = waypoints.front(); // Read first point, but only remove it once we tookoff
-                    wp_mutex.unlock();
-                    
-                    if (takeoff_seq(current_waypoint))
-                    {
-                        quad_state = takeoff;
-                        std::cout << "Takeoff stage" << std::endl;
-                        stage_time = ros::Time::now();
-                    }
-                    
-                    break;
-                }
-                case takeoff:
+                break;
+            }
+            v.wp_mutex.lock();
+            v.current_waypoint = v.waypoints.front(); // Read first point, but only remove it once we tookoff
+            v.wp_mutex.unlock();
+
+            Vehicle *vehicle = &v;
+            const geometry_msgs::Point point = v.current_waypoint;
+            service_worker.post([vehicle, point] { return takeoff_seq(*vehicle, point); },
+                                [vehicle](bool ok) { finishCall(*vehicle, ok); });
+            v.quad_state = takeoff_cmd;
+            break;
+        }
+        case takeoff_cmd:
+        {
+            if (!finished)
+            {
+                break;
+            }
+            if (ok)
+            {
+                v.quad_state = takeoff;
+                std::cout << v.name << " Takeoff stage" << std::endl;
+                v.stage_time = now;
+            }
+            else
+            {
+                v.quad_state = ground;
+                v.retry_time = now + ros::Duration(RETRY_DELAY);
+            }
+            break;
+        }
+        case takeoff:
+        {
+            if (v.current_pos.load().z >= TAKEOFF_H)
+            {
+                // Successfully tookoff, resend first point
+                v.wp_mutex.lock();
+                v.waypoints.erase(v.waypoints.begin()); //delete first element
+                v.wp_mutex.unlock();
+                goToWaypoint(v, now);
+
+                std::cout << v.name << " Flight stage" << std::endl;
+                v.quad_state = flight;
+                v.stage_time = now;
+            }
+            else if ( (now - v.stage_time).toSec() >= TAKEOFF_TIMEOUT )
+            {
+                // took too long to takeoff, try resending takeoff cmd
+                std::cout << v.name << " Didn't takeoff, retrying" << std::endl;
+                v.quad_state = ground;
+                std::cout << v.name << " Flight Ground" << std::endl;
+            }
+            break;
+        }
+        case flight:
+        {
+            if (smooth_paths)
+            {
+                // A path that came in flight, flown from here
+                v.wp_mutex.lock();
+                const bool changed = v.path_changed;
+                v.wp_mutex.unlock();
+                if (changed)
                 {
-                    if (current_pos.z >= TAKEOFF_H)
-                    {
-                        // Successfully tookoff, resend first point
-                        wp_mutex.lock();
-                        waypoints.erase(waypoints.begin()); //delete first element
-                        wp_mutex.unlock();
-                        sendPosition(current_waypoint);
-                      
-                        std::cout << "Flight stage" << std::endl;
-                        quad_state = flight;
-                        
-                    }
-                    else if ( (ros::Time::now() - stage_time).toSec() >= TAKEOFF_TIMEOUT )
-                    {
-                        // took too long to takeoff, try resending takeoff cmd
-                        std::cout << "Didn't takeoff, retrying" << std::endl;
-                        quad_state = ground;
-                        std::cout << "Flight Ground" << std::endl;
-                    }
-                    
-                    break;
+                    startStreaming(v, now);
+                    v.stage_time = now;
                 }
-                case flight:
+            }
+
+            if (goalDist(v, v.current_waypoint) < WP_RADIUS)
+            {
+                double wp_length;
+                v.wp_mutex.lock();
+                wp_length = v.waypoints.size();
+                v.wp_mutex.unlock();
+                if(wp_length == 0) //reached last point
                 {
-                    if (goalDist(current_waypoint) < WP_RADIUS)
-                    {
-                        double wp_length;
-                        wp_mutex.lock();
-                        wp_length = waypoints.size();
-                        wp_mutex.unlock();
-                        if(wp_length == 0) //reached last point
-                        {
-                            // tell CyPyHous3 if waypoint is reached
-                            // for now we only do that once we reach the final dest
-                            std_msgs::String wp_reached;
-                            wp_reached.data = "TRUE";
-                            reached_pub.publish(wp_reached);
-                            
-                            gotWP_flag = false;
-                            quad_state = flight;
-                            std::cout << "******************** End Path **********************" << std::endl;
-                        }
-                        else
-                        {
-                            std::cout << "Reached Midpoint" << std::endl;
-                            wp_mutex.lock();
-                            current_waypoint = waypoints.front();
-                            waypoints.erase(waypoints.begin()); //delete first element
-                            wp_mutex.unlock();
-                            
-                            if (current_waypoint.z <= 0.0)
-                            {
-                                quad_state = land;
-                                std::cout << "Land stage" << std::endl;
-                            }
-                            else
-                            {
-                                sendPosition(current_waypoint);
-                                quad_state = flight;
-                                stage_time = ros::Time::now();
-                            }
-                        }
-                    }
-                    
-                    if ( (ros::Time::now() - stage_time).toSec() >= GOTO_TIMEOUT )
+                    // tell CyPyHous3 if waypoint is reached
+                    // for now we only do that once we reach the final dest
+                    std_msgs::String wp_reached;
+                    wp_reached.data = "TRUE";
+                    v.reached_pub.publish(wp_reached);
+
+                    // Holds the end of the path from here on
+                    if (std::atomic_load(&v.streamed))
                     {
-                        sendPosition(current_waypoint);
-                        stage_time = ros::Time::now();
-                    }
-                    
-                    break;
-                }
-                case land:
-                {
-                    if (land_seq(current_waypoint)) {
-                        quad_state = landing;
-                        std::cout << "Landing stage" << std::endl;
-                        stage_time = ros::Time::now();
+                        stopStreaming(v);
+                        sendPosition(v, v.current_waypoint);
                     }
-                    
-                    break;
+                    v.gotWP_flag = false;
+                    v.quad_state = flight;
+                    std::cout << v.name << " ******************** End Path **********************" << std::endl;
                 }
-                case landing:
+                else
                 {
-                    if (current_pos.z <= LAND_H)
-                    {
-                        std_msgs::String wp_reached;
-                        wp_reached.data = "TRUE";
-                        reached_pub.publish(wp_reached);
-                        
-                        quad_state = ground;
-                        std::cout << "Ground stage" << std::endl;
-                        gotWP_flag = false;
-                        wp_mutex.lock();
-                        waypoints.clear();
-                        wp_mutex.unlock();
-                    }
-                    else if ( (ros::Time::now() - stage_time).toSec() >= LAND_TIMEOUT )
+                    std::cout << v.name << " Reached Midpoint" << std::endl;
+                    v.wp_mutex.lock();
+                    v.current_waypoint = v.waypoints.front();
+                    v.waypoints.erase(v.waypoints.begin()); //delete first element
+                    v.wp_mutex.unlock();
+
+                    if (v.current_waypoint.z <= 0.0)
                     {
-                         // took too long to land, try resending land cmd
-                         std::cout << "Didn't land, retrying" << std::endl;
-                         quad_state = land;
-                         std::cout << "Land stage" << std::endl;
+                        stopStreaming(v);
+                        v.quad_state = land;
+                        std::cout << v.name << " Land stage" << std::endl;
+                        break;
                     }
-                    
-                    break;
+                    goToWaypoint(v, now);
+                    v.quad_state = flight;
+                    v.stage_time = now;
                 }
             }
+
+            // A streamed path needs no resend
+            if (((now - v.stage_time).toSec() >= GOTO_TIMEOUT) && !std::atomic_load(&v.streamed))
+            {
+                sendPosition(v, v.current_waypoint);
+                v.stage_time = now;
+            }
+            break;
+        }
+        case land:
+        {
+            if (now < v.retry_time)
+            {
+                break;
+            }
+            Vehicle *vehicle = &v;
+            const geometry_msgs::Point point = v.current_waypoint;
+            service_worker.post([vehicle, point] { return land_seq(*vehicle, point); },
+                                [vehicle](bool ok) { finishCall(*vehicle, ok); });
+            v.quad_state = land_cmd;
+            break;
+        }
+        case land_cmd:
+        {
+            if (!finished)
+            {
+                break;
+            }
+            if (ok)
+            {
+                v.quad_state = landing;
+                std::cout << v.name << " Landing stage" << std::endl;
+                v.stage_time = now;
+            }
+            else
+            {
+                v.quad_state = land;
+                v.retry_time = now + ros::Duration(RETRY_DELAY);
+            }
+            break;
+        }
+        case landing:
+        {
+            if (v.current_pos.load().z <= LAND_H)
+            {
+                std_msgs::String wp_reached;
+                wp_reached.data = "TRUE";
+                v.reached_pub.publish(wp_reached);
+
+                v.quad_state = ground;
+                std::cout << v.name << " Ground stage" << std::endl;
+                v.gotWP_flag = false;
+                v.wp_mutex.lock();
+                v.waypoints.clear();
+                v.wp_mutex.unlock();
+            }
+            else if ( (now - v.stage_time).toSec() >= LAND_TIMEOUT )
+            {
+                 // took too long to land, try resending land cmd
+                 std::cout << v.name << " Didn't land, retrying" << std::endl;
+                 v.quad_state = land;
+                 std::cout << v.name << " Land stage" << std::endl;
+            }
+            break;
         }
-        
-        r.sleep();
     }
-    std::cout << "Done WP loop" << std::endl;
 }
 
-void printToFile()
+// True if any vehicle has an event, under event_mutex
+bool eventPending()
+{
+    for (size_t i = 0; i < n_vehicles; i++)
+    {
+        if (vehicles[i].event_pending)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * The missions as state machines stepped on events rather than at a fixed
+ * rate: a waypoint, a position, a finished service call or an emergency of a
+ * vehicle steps it at once, the timeout of its stage otherwise. Takeoff and
+ * landing run their MAVROS calls on service_worker and wait in takeoff_cmd
+ * and land_cmd for the result, so no mission ever blocks on a round-trip.
+ */
+void sendWP()
 {
-    // TODO: look into getcwd() to get current directory
-    std::ofstream positionFile;
-    positionFile.open ("/home/pi/copterpos.txt", std::ios::app);
-    
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && (quad_state == ground))
+    std::vector<char> due(n_vehicles), finished(n_vehicles), ok(n_vehicles);
+
+    while(ros::ok())
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Timeouts that passed were handled by the last step, one in the past has nothing left to do
+        ros::Time now = ros::Time::now();
+        ros::Time deadline = now + ros::Duration(IDLE_WAIT);
+        for (size_t i = 0; i < n_vehicles; i++)
+        {
+            const ros::Time stage_deadline = stageDeadline(vehicles[i]);
+            if (stage_deadline > now && stage_deadline < deadline)
+            {
+                deadline = stage_deadline;
+            }
+        }
+        const double wait = fmax((deadline - now).toSec(), 0.0);
+
+        {
+            std::unique_lock<std::mutex> lock(event_mutex);
+            event_cv.wait_for(lock, std::chrono::nanoseconds(static_cast<int64_t>(wait * 1e9)), eventPending);
+            now = ros::Time::now();
+            for (size_t i = 0; i < n_vehicles; i++)
+            {
+                Vehicle& v = vehicles[i];
+                const ros::Time stage_deadline = stageDeadline(v);
+                due[i] = v.event_pending || (!stage_deadline.isZero() && stage_deadline <= now);
+                finished[i] = v.call_finished;
+                ok[i] = v.call_ok;
+                v.event_pending = false;
+                v.call_finished = false;
+            }
+        }
+
+        for (size_t i = 0; i < n_vehicles; i++)
+        {
+            if (due[i])
+            {
+                stepMission(vehicles[i], finished[i], ok[i]);
+            }
+        }
     }
-    
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && (quad_state != ground))
+    std::cout << "Done WP loop" << std::endl;
+}
+
+/*
+ * The setpoints of the streamed paths at SETPOINT_RATE: position, velocity
+ * and acceleration of the trajectory now, in the frame of sendPosition, so
+ * the flight controller tracks the motion rather than chasing a jump.
+ */
+void sendSetpoints()
+{
+    PeriodicLoop r(1.0 / SETPOINT_RATE);
+
+    while(ros::ok())
     {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << current_pos.x << ", " << current_pos.y << ", " << current_pos.z << "\r\n";
-        
-        printrate.sleep();
+        const ros::Time now = ros::Time::now();
+        for (size_t i = 0; i < n_vehicles; i++)
+        {
+            Vehicle& v = vehicles[i];
+            const std::shared_ptr<const StreamedPath> path = std::atomic_load(&v.streamed);
+            if (!path)
+            {
+                continue;
+            }
+            Eigen::Vector3d p, vel, acc;
+            path->trajectory.sample((now - path->start).toSec(), p, vel, acc);
+
+            mavros_msgs::PositionTarget target;
+            target.header.stamp = now;
+            target.coordinate_frame = mavros_msgs::PositionTarget::FRAME_LOCAL_NED;
+            target.type_mask = mavros_msgs::PositionTarget::IGNORE_YAW | mavros_msgs::PositionTarget::IGNORE_YAW_RATE;
+            target.position.x = p.y() - v.takeoff_pos.y;
+            target.position.y = -(p.x() - v.takeoff_pos.x);
+            target.position.z = p.z() - v.takeoff_pos.z;
+            target.velocity.x = vel.y();
+            target.velocity.y = -vel.x();
+            target.velocity.z = vel.z();
+            target.acceleration_or_force.x = acc.y();
+            target.acceleration_or_force.y = -acc.x();
+            target.acceleration_or_force.z = acc.z();
+            v.setpoint_pub.publish(target);
+        }
+        r.sleep();
     }
-    positionFile.close();
-    std::cout << "Done save loop" << std::endl;
+    std::cout << "Done setpoint loop" << std::endl;
 }
 
-void getWP(const geometry_msgs::PoseStamped& stamped_point)
+void getWP(Vehicle& v, const geometry_msgs::PoseStampedConstPtr& stamped_point)
 {
-    geometry_msgs::Point point = stamped_point.pose.position;
-    std::string stamp = stamped_point.header.frame_id;
-    
-    std::cout << "Got point x: " << point.x << ", y: " << point.y << ", z: " << point.z << std::endl;
-    
+    geometry_msgs::Point point = stamped_point->pose.position;
+    std::string stamp = stamped_point->header.frame_id;
+
+    std::cout << v.name << " Got point x: " << point.x << ", y: " << point.y << ", z: " << point.z << std::endl;
+
     if (stamp == "2")
     {
-        wp_mutex.lock();
-        waypoints.clear();
-        if (quad_state == flight)
+        v.wp_mutex.lock();
+        v.waypoints.clear();
+        if (v.quad_state == flight)
         {
-            current_waypoint = current_pos;
-            waypoints.push_back(current_pos);
+            v.current_waypoint = v.current_pos.load();
+            v.waypoints.push_back(v.current_waypoint);
         }
-        wp_mutex.unlock();
+        v.wp_mutex.unlock();
     }
-    else if ((point.z <= 0.0) && (quad_state == ground))
+    else if ((point.z <= 0.0) && (v.quad_state == ground))
     {
         //ignore, already landed
         return;
     }
     else
     {
-        wp_mutex.lock();
-        waypoints.push_back(point);
-        wp_mutex.unlock();
+        v.wp_mutex.lock();
+        v.waypoints.push_back(point);
+        v.wp_mutex.unlock();
 
         if (stamp == "1")
         {
-            gotWP_flag = true;
-            std::cout << "Doing path" << std::endl;
+            v.wp_mutex.lock();
+            v.path_changed = true;
+            v.wp_mutex.unlock();
+            v.gotWP_flag = true;
+            std::cout << v.name << " Doing path" << std::endl;
         }
     }
-    
+    notifyWP(v);
 }
 
-int main(int argc, char **argv)
+/*
+ * A whole path in one message, swapped in for the waypoints at once, as a
+ * "2", its points and a "1" to getWP. In flight it starts where the quad is,
+ * on the ground points at or below the floor are left out.
+ */
+void getPath(Vehicle& v, const nav_msgs::PathConstPtr& path)
 {
-    ros::init(argc, argv, "fakeGPS");
-    ardupilot_link = mavconn::MAVConnInterface::open_url("udp://127.0.0.1:14550@");
-    ros::NodeHandle n("~");
-   
-    std::string wp_topic, reached_topic, pos_topic, vicon_obj;
-    bool use_deca;
+    const bool flying = v.quad_state == flight;
+    std::vector<geometry_msgs::Point> points;
+    points.reserve(path->poses.size() + 1);
+    if (flying)
+    {
+        points.push_back(v.current_pos.load());
+    }
+    for (size_t i = 0; i < path->poses.size(); i++)
+    {
+        const geometry_msgs::Point& point = path->poses[i].pose.position;
+        if ((point.z > 0.0) || (v.quad_state != ground))
+        {
+            points.push_back(point);
+        }
+    }
+    if (points.size() == (flying ? 1 : 0))
+    {
+        return;
+    }
+
+    std::cout << v.name << " Got path of " << path->poses.size() << " points" << std::endl;
+    v.wp_mutex.lock();
+    v.waypoints.swap(points);
+    if (flying)
+    {
+        v.current_waypoint = v.waypoints.front();
+    }
+    v.path_changed = true;
+    v.wp_mutex.unlock();
+
+    v.gotWP_flag = true;
+    std::cout << v.name << " Doing path" << std::endl;
+    notifyWP(v);
+}
+
+/*
+ * Sets up v from the parameters under vn: the private handle itself for the
+ * single vehicle of a plain configuration, ~<name> for each of vehicles.
+ * index picks the default UDP port of its link.
+ */
+void setupVehicle(Vehicle& v, ros::NodeHandle& vn, const std::string& name, size_t index, bool use_deca)
+{
+    std::string wp_topic, path_topic, reached_topic, pos_topic, vicon_obj, mavros_ns, fcu_url;
     int queue_size;
-    
-    n.param<bool>("use_deca", use_deca, false);
-    
-    n.param<std::string>("device/bot_name", vicon_obj, "cph");
-    n.param<std::string>("device/waypoint_topic/topic", wp_topic, "waypoint");
-    n.param<std::string>("device/reached_topic/topic", reached_topic, "reached");
-    n.param<std::string>("device/positioning_topic/topic", pos_topic, "/vrpn_client_node/");
-    n.param<int>("device/queue_size", queue_size, 10);
-
-
-    arming_client = n.serviceClient<mavros_msgs::CommandBool>("/mavros/cmd/arming");
-    takeoff_client = n.serviceClient<mavros_msgs::CommandTOL>("/mavros/cmd/takeoff");
-    land_client = n.serviceClient<mavros_msgs::CommandTOL>("/mavros/cmd/land");
-    mode_client = n.serviceClient<mavros_msgs::SetMode>("/mavros/set_mode");
-
-    postarget_pub = n.advertise<geometry_msgs::PoseStamped>("/mavros/setpoint_position/local", 10);
-    reached_pub = n.advertise<std_msgs::String>(reached_topic, 1);
-    
-    pos_time = ros::Time::now();
-    ros::Subscriber pos_sub, vel_sub;
+
+    v.name = name;
+    vn.param<std::string>("device/bot_name", vicon_obj, name.empty() ? "cph" : name);
+    vn.param<std::string>("device/waypoint_topic/topic", wp_topic, "waypoint");
+    vn.param<std::string>("device/path_topic/topic", path_topic, "path");
+    vn.param<std::string>("device/reached_topic/topic", reached_topic, "reached");
+    vn.param<std::string>("device/positioning_topic/topic", pos_topic, "/vrpn_client_node/");
+    vn.param<int>("device/queue_size", queue_size, 10);
+    vn.param<std::string>("mavros_ns", mavros_ns, name.empty() ? "/mavros" : "/" + name + "/mavros");
+    vn.param<std::string>("fcu_url", fcu_url, "udp://127.0.0.1:" + std::to_string(FCU_PORT + FCU_PORT_STEP * index) + "@");
+    vn.param<int>("fcu_system_id", v.fcu_system_id, 1);
+
+    v.link = mavconn::MAVConnInterface::open_url(fcu_url);
+
+    v.arming_client = vn.serviceClient<mavros_msgs::CommandBool>(mavros_ns + "/cmd/arming");
+    v.takeoff_client = vn.serviceClient<mavros_msgs::CommandTOL>(mavros_ns + "/cmd/takeoff");
+    v.land_client = vn.serviceClient<mavros_msgs::CommandTOL>(mavros_ns + "/cmd/land");
+    v.mode_client = vn.serviceClient<mavros_msgs::SetMode>(mavros_ns + "/set_mode");
+    v.sethome_client = vn.serviceClient<mavros_msgs::CommandHome>(mavros_ns + "/cmd/set_home");
+
+    v.postarget_pub = vn.advertise<geometry_msgs::PoseStamped>(mavros_ns + "/setpoint_position/local", 10);
+    v.setpoint_pub = vn.advertise<mavros_msgs::PositionTarget>(mavros_ns + "/setpoint_raw/local", 10);
+    v.reached_pub = vn.advertise<std_msgs::String>(reached_topic, 1);
+
+    std::string trajectory_file;
+    vn.param<std::string>("trajectory_file", trajectory_file, name.empty() ? "/home/pi/copterpos" : "/home/pi/copterpos_" + name);
+    // Every pose off the ground, see TrajectoryRecorder
+    bool record_trajectory, compress_trajectory;
+    vn.param<bool>("record_trajectory", record_trajectory, false);
+    vn.param<bool>("compress_trajectory", compress_trajectory, true);
+    if (record_trajectory)
+    {
+        const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+        v.trajectory.reset(new TrajectoryRecorder(trajectory_file+ext, "quadcopter/fakegps",
+                                                  {"x", "y", "z"}, compress_trajectory));
+    }
+
+    v.pos_time.store(ros::Time::now());
     if (!use_deca)
     {
-        pos_sub = n.subscribe(pos_topic+vicon_obj+"/pose", 1, getPosition);
-        vel_sub = n.subscribe(pos_topic+vicon_obj+"/twist", 1, getVelocity);
+        v.pos_sub = vn.subscribe<geometry_msgs::PoseStamped>(pos_topic+vicon_obj+"/pose", 1,
+                                                             boost::bind(getPosition, boost::ref(v), _1));
+        v.vel_sub = vn.subscribe<geometry_msgs::TwistStamped>(pos_topic+vicon_obj+"/twist", 1,
+                                                              boost::bind(getVelocity, boost::ref(v), _1));
     }
     else
     {
-        pos_sub = n.subscribe("decaPos", 1, getPosition);
-        vel_sub = n.subscribe("decaVel", 1, getVelocity);
+        v.pos_sub = vn.subscribe<geometry_msgs::PoseWithCovarianceStamped>("decaPose", 1,
+                                                                           boost::bind(getDecaPose, boost::ref(v), _1));
+        v.vel_sub = vn.subscribe<geometry_msgs::TwistWithCovarianceStamped>("decaTwist", 1,
+                                                                            boost::bind(getDecaTwist, boost::ref(v), _1));
     }
-    
-    ros::Subscriber waypoint = n.subscribe(wp_topic, queue_size, getWP);
-    
-    sethome_client = n.serviceClient<mavros_msgs::CommandHome>("/mavros/cmd/set_home");
+
+    v.wp_sub = vn.subscribe<geometry_msgs::PoseStamped>(wp_topic, queue_size, boost::bind(getWP, boost::ref(v), _1));
+    v.path_sub = vn.subscribe<nav_msgs::Path>(path_topic, 1, boost::bind(getPath, boost::ref(v), _1));
+
     mavros_msgs::CommandHome sethome_msg;
     sethome_msg.request.current_gps = false;
     sethome_msg.request.latitude = lat0;
     sethome_msg.request.longitude = lon0;
     sethome_msg.request.altitude = 0;
-    sethome_client.call(sethome_msg);
-    
-    gps_thread = std::thread(sendFakeGPS);
-    pos_thread = std::thread(printPos);
+    v.sethome_client.call(sethome_msg);
+    if (use_vision)
+    {
+        sendGlobalOrigin(v);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "fakeGPS");
+    ros::NodeHandle n("~");
+
+    bool use_deca;
+    n.param<bool>("use_deca", use_deca, false);
+    // Position feed of ArduPilot, "gps" for HIL_GPS at GPS_RATE or "vision" for VISION_POSITION_ESTIMATE at vision_rate
+    std::string position_feed;
+    n.param<std::string>("position_feed", position_feed, "gps");
+    n.param<double>("vision_rate", vision_rate, 50.0);
+    n.param<double>("feed_phase", feed_phase, 0.0);
+    double vicon_stddev;
+    n.param<double>("vicon_stddev", vicon_stddev, 0.005);
+    vicon_variance = vicon_stddev * vicon_stddev;
+    use_vision = position_feed == "vision";
+
+    // Minimum snap trajectories through the waypoints instead of one position target each
+    n.param<bool>("smooth_paths", smooth_paths, false);
+    n.param<double>("max_speed", snap_limits.max_speed, snap_limits.max_speed);
+    n.param<double>("max_accel", snap_limits.max_accel, snap_limits.max_accel);
+
+    int metrics_port;
+    n.param<int>("metrics_port", metrics_port, 0); // Prometheus endpoint, 0 disables
+    feed_jitter.reset(new LoopJitter(1.0 / (use_vision ? vision_rate : GPS_RATE)));
+    feed_jitter->exportMetrics("fakegps_feed");
+    feed_metric = &MetricsRegistry::instance().counter("fakegps_positions_total", "Positions sent to the flight controllers");
+    const bool metrics_started = startMetricsServer(metrics_port);
+
+    // Lines of the control loops at most once per log_throttle [s] each, and all of them to log_file if set
+    double log_throttle;
+    std::string log_file;
+    n.param<double>("log_throttle", log_throttle, 1.0);
+    n.param<std::string>("log_file", log_file, "");
+    async_log::start(log_throttle, log_file);
+
+    // Names of the vehicles of a swarm, each configured under ~<name>; without it one vehicle configured under ~
+    std::vector<std::string> names;
+    n.param("vehicles", names, std::vector<std::string>());
+    n_vehicles = names.empty() ? 1 : names.size();
+    vehicles.reset(new Vehicle[n_vehicles]);
+    if (names.empty())
+    {
+        setupVehicle(vehicles[0], n, "", 0, use_deca);
+    }
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        ros::NodeHandle vn(n, names[i]);
+        setupVehicle(vehicles[i], vn, names[i], i, use_deca);
+    }
+
+    service_worker.start();
+    feed_thread = std::thread(sendFeed);
     wp_thread = std::thread(sendWP);
-    //print_thread = std::thread(printToFile);
+    if (smooth_paths)
+    {
+        setpoint_thread = std::thread(sendSetpoints);
+    }
 
     ros::spin();
-    
-    gps_thread.join();
-    pos_thread.join();
+
+    event_cv.notify_one();
+    feed_thread.join();
     wp_thread.join();
-    //print_thread.join();
-    
+    if (setpoint_thread.joinable())
+    {
+        setpoint_thread.join();
+    }
+    service_worker.stop();
+    vehicles.reset();
+    async_log::stop();
+    if (metrics_started)
+    {
+        stopMetricsServer();
+    }
+
     std::cout << "Joined all threads" << std::endl;
     return 0;
 }
-
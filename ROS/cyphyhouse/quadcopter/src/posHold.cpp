@@ -3,10 +3,13 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <memory>
+#include <atomic>
 
 
 #include <eigen_conversions/eigen_msg.h>
 #include <mavros/mavros_plugin.h>
+#include <mavconn/interface.h>
 
 #include <mavros_msgs/CommandTOL.h>
 #include <mavros_msgs/CommandBool.h>
@@ -15,22 +18,33 @@
 #include <std_msgs/String.h>
 
 #include "ros/ros.h"
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include "geometry_msgs/PoseStamped.h"
 #include "geometry_msgs/TwistStamped.h"
 #include "geometry_msgs/PointStamped.h"
 #include "ros/package.h"
+#include "cyphy_control/FixedRatePid.h"
+#include "cyphy_control/Metrics.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/TrajectoryRecorder.h"
 
 #include <Eigen/Eigen>
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 
 #define GPS_RATE 10 //Hz
-#define PRINT_RATE 100 //Hz
-#define CONTROLLER_RATE 100 // Hz
+#define CONTROLLER_RATE 100 // Hz, default of controller_rate
+#define MAX_CONTROLLER_RATE 250 // Hz
+#define IGNORE_ATTITUDE (1 << 7) // type_mask of SET_ATTITUDE_TARGET, rates and thrust only
+
+#define WP_QUEUE_SIZE 16 // Must be a power of two
 
 bool takeoff_flag = false;
 bool starl_flag = false;
-bool isFlying = false;
+std::atomic<bool> isFlying(false);
 
 std::string bot_num, vicon_obj;
 bool use_deca;
@@ -39,98 +53,86 @@ ros::ServiceClient arming_client;
 ros::ServiceClient mode_client;
 
 ros::Publisher atttarget_pub, thrusttarget_pub;
+
+// Rate [Hz] of sendAttitude and its PIDs
+double controller_rate = CONTROLLER_RATE;
+double attitude_phase;     // s, offset of the attitude loop into its period, see PeriodicLoop
+// Wake-ups and overruns of the attitude loop and its setpoints, served on metrics_port
+std::unique_ptr<LoopJitter> attitude_jitter;
+MetricCounter *setpoint_metric;
+bool metrics_started = false;
+// Straight to the FCU if set, rates and thrust in one SET_ATTITUDE_TARGET instead of two mavros topics
+mavconn::MAVConnInterface::Ptr fcu_link;
+int fcu_system_id, fcu_component_id;
 ros::Publisher reached_pub;
 
-geometry_msgs::Pose vicon_pose;
-geometry_msgs::Twist vicon_vel;
+// Latest VICON pose and velocity, written by their callbacks and read by the threads
+Snapshot<geometry_msgs::Pose> vicon_pose;
+Snapshot<geometry_msgs::Twist> vicon_vel;
 geometry_msgs::Point current_waypoint;  // VICON coords
 
+// A waypoint as sendWP received it, takeoff and land hold the position of the quad at its height
+struct QueuedWaypoint
+{
+    geometry_msgs::Point point;
+    bool hold;
+};
 
-std::thread gps_thread, print_thread, pos_thread;
+// Waypoints from sendWP to sendAttitude, which owns the PIDs and current_waypoint
+SPSCQueue<QueuedWaypoint, WP_QUEUE_SIZE> wp_queue;
 
-class PID
-{
-public:
-    // Contructor
-    PID(double Kp, double Ki, double Kd, double Rate, double outLimit)
-    {
-        kp = Kp;
-        ki = Ki;
-        kd = Kd;
-        dt = 1/Rate;
-        samplingRate = Rate;
-        integralLimit = outLimit / ki;
-        outputLimit = outLimit;
-        lastMeasured = 0;
-        integ = 0;
-        deriv = 0;
-    }
-    
-    double pidUpdate(double measured)
-    {
-        error = setpoint - measured;
-        double dInput = (measured - lastMeasured)/dt;
-        lastMeasured = measured;
-	deriv = 0.9 * dInput + 0.1 * deriv;
-        integ += error*dt;
-        integ = fmax(fmin(integ, integralLimit), -integralLimit);
-        
-        output = kp*error + kd*dInput + ki*integ;
-        return fmax(fmin(output, outputLimit), -outputLimit);
-    }
-    
-    void setSetpoint(double _setpoint)
-    {
-        setpoint = _setpoint;
-    }
-    
-    void reset()
-    {
-        integ = 0;
-        deriv = 0;
-    }
-    
-    double getSetpoint() { return setpoint; }
-    double getError() { return error; }
-    double getOutput() { return output; }
-    double getInteg() { return integ; }
-    double getDeriv() { return deriv; }
-    double getKP() { return kp; }
 
-private:
-    //variables
-    double kp, ki, kd, dt, samplingRate, integralLimit, outputLimit;
-    double lastMeasured, integ, deriv, setpoint, error, output;
-};
+std::thread gps_thread, pos_thread;
 
-// For now, x&y PIDs generate desired roll and pitch, in the future they will generate desired velocities, which in turn generate desired roll/pitch
-PID pidX(1, 0, 0, CONTROLLER_RATE, 0.3); // Generate desired pitch
-PID pidY(1, 0, 0, CONTROLLER_RATE, 0.3); // Generate desired roll
+// Trajectory of the flight, recorded by getViconPosition while flying if record_trajectory is set
+std::unique_ptr<TrajectoryRecorder> trajectory;
 
-PID pidZ(1, 0.5, 0, CONTROLLER_RATE, 1); // Generate desired thrust
+// Cleared to stop the threads, a nodelet outlives ros::ok() when it is unloaded
+std::atomic<bool> running(false);
 
-PID pidRoll(0.15, 0.1, 0.004, CONTROLLER_RATE, 100.0); // Generate desired Roll rate
-PID pidPitch(0.15, 0.1, 0.004, CONTROLLER_RATE, 100.0); // Generate desired Pitch rate
-PID pidYaw(0.2, 0.1, 0.004, CONTROLLER_RATE, 100.0); // Generate desired Yaw rate
+// For now, x&y PIDs generate desired roll and pitch, in the future they will generate desired velocities, which in turn generate desired roll/pitch
+// x, y, z: desired pitch, desired roll, desired thrust
+const std::array<PidGains, 3> position_gains = {{
+    {1, 0, 0, 0.3, 1},
+    {1, 0, 0, 0.3, 1},
+    {1, 0.5, 0, 1, 1},
+}};
+PidBank<3> position_pid(CONTROLLER_RATE, position_gains);
+
+// Roll, pitch, yaw: desired roll, pitch and yaw rates
+const std::array<PidGains, 3> attitude_gains = {{
+    {0.15, 0.1, 0.004, 100.0, 0.9},
+    {0.15, 0.1, 0.004, 100.0, 0.9},
+    {0.2, 0.1, 0.004, 100.0, 0.9},
+}};
+PidBank<3> attitude_pid(CONTROLLER_RATE, attitude_gains);
+
+// x, y, z setpoint of position_pid, owned by sendAttitude
+double position_setpoint[3] = {0, 0, 0};
 
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
 {
-    vicon_pose = pose.pose;
+    vicon_pose.store(pose.pose);
+    if (trajectory && isFlying)
+    {
+        trajectory->record(ros::Time::now().toNSec(), pose.pose.position.x, pose.pose.position.y, pose.pose.position.z);
+    }
 }
 
 void getViconVelocity(const geometry_msgs::TwistStamped& twist)
 {
-    vicon_vel = twist.twist;
+    vicon_vel.store(twist.twist);
 }
 
 void printPos()
 {
-    ros::Rate pr(1);
-    while(ros::ok())
+    PeriodicLoop pr(1.0);
+    while(ros::ok() && running)
     {
-        ROS_INFO("x: %f, y: %f, z: %f\n", vicon_pose.position.x, vicon_pose.position.y, vicon_pose.position.z);
-        Eigen::Quaterniond q = Eigen::Quaterniond(vicon_pose.orientation.w, vicon_pose.orientation.x, vicon_pose.orientation.y, vicon_pose.orientation.z);
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        ROS_INFO("x: %f, y: %f, z: %f\n", pose.position.x, pose.position.y, pose.position.z);
+        Eigen::Quaterniond q = Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
         Eigen::Vector3d rpy = q.toRotationMatrix().eulerAngles(0, 1, 2);
 	//if (rpy(0) > M_PI) rpy(0) -= 2*M_PI;
 	//if (rpy(1) > M_PI) rpy(1) -= 2*M_PI; 
@@ -146,19 +148,79 @@ void printPos()
     }
 }
 
+// Moves the setpoints to the waypoints sendWP queued
+void applyWaypoints(const geometry_msgs::Point& point)
+{
+    QueuedWaypoint wp;
+    while (wp_queue.pop(wp))
+    {
+        starl_flag = true;
+        if (wp.hold)
+        {
+            position_setpoint[0] = point.x;
+            position_setpoint[1] = point.y;
+        }
+        else
+        {
+            position_setpoint[0] = wp.point.x;
+            position_setpoint[1] = wp.point.y;
+        }
+        position_setpoint[2] = wp.point.z;
+
+        position_pid.reset();
+
+        current_waypoint = wp.point;
+    }
+}
+
+// Body rates [rad/s] in the FLU frame of ROS and thrust [0, 1]
+void sendSetpoint(const geometry_msgs::Vector3& rates, double thrust)
+{
+    if (fcu_link)
+    {
+        // FRD body of MAVLink, as mavros would have turned it
+        mavlink::common::msg::SET_ATTITUDE_TARGET target {};
+        target.time_boot_ms = ros::Time::now().toNSec() / 1000000;
+        target.target_system = fcu_system_id;
+        target.target_component = fcu_component_id;
+        target.type_mask = IGNORE_ATTITUDE;
+        target.q = {1, 0, 0, 0};
+        target.body_roll_rate = rates.x;
+        target.body_pitch_rate = -rates.y;
+        target.body_yaw_rate = -rates.z;
+        target.thrust = thrust;
+        fcu_link->send_message_ignore_drop(target);
+        return;
+    }
+
+    geometry_msgs::TwistStamped velmsg;
+    velmsg.header.stamp = ros::Time::now();
+    velmsg.header.frame_id = "map";
+    velmsg.twist.angular = rates;
+    atttarget_pub.publish(velmsg);
+
+    mavros_msgs::Thrust thrustmsg;
+    thrustmsg.header = velmsg.header;
+    thrustmsg.thrust = thrust;
+    thrusttarget_pub.publish(thrustmsg);
+}
+
 void sendAttitude()
 {
-    ros::Rate r(CONTROLLER_RATE);
+    PeriodicLoop r(1.0 / controller_rate, attitude_phase, attitude_jitter.get());
 
-    while(ros::ok())
+    while(ros::ok() && running)
     {
-        geometry_msgs::Point point = vicon_pose.position;
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        geometry_msgs::Point point = pose.position;
+
+        applyWaypoints(point);
         
         // Resent first point after takeoff
         if (takeoff_flag && sqrt(pow(point.z - current_waypoint.z, 2)) < 0.3)
         {
-            pidX.setSetpoint(point.x);
-            pidY.setSetpoint(point.y);
+            position_setpoint[0] = point.x;
+            position_setpoint[1] = point.y;
             takeoff_flag = false;
         }
 
@@ -177,76 +239,51 @@ void sendAttitude()
 
         if(isFlying)
         {
-            Eigen::Quaterniond q = Eigen::Quaterniond(vicon_pose.orientation.w, vicon_pose.orientation.x, vicon_pose.orientation.y, vicon_pose.orientation.z);
+            Eigen::Quaterniond q = Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
             Eigen::Vector3d rpyVicon = q.toRotationMatrix().eulerAngles(0, 1, 2);
             
             geometry_msgs::Vector3 rpySetpoint, rpyRateSetpoint, rpyBody;
-            double thrust;
-            rpySetpoint.x = pidX.pidUpdate(vicon_pose.position.x);
-            rpySetpoint.y = pidY.pidUpdate(vicon_pose.position.y);
-            
-            thrust = pidZ.pidUpdate(vicon_pose.position.z);
+            const double position[3] = {pose.position.x, pose.position.y, pose.position.z};
+            double position_out[3];
+            position_pid.update(position_setpoint, position, position_out);
+            rpySetpoint.x = position_out[0];
+            rpySetpoint.y = position_out[1];
+            const double thrust = position_out[2];
             
             rpyBody.x = -(rpySetpoint.y * cos(rpyVicon(2))) + (rpySetpoint.x * sin(rpyVicon(2)));
             rpyBody.y = -(rpySetpoint.x * cos(rpyVicon(2))) - (rpySetpoint.y * sin(rpyVicon(2)));
             
-            pidRoll.setSetpoint(rpyBody.y);
-            pidPitch.setSetpoint(rpyBody.x);
-            pidYaw.setSetpoint(0);
-            
-            rpyRateSetpoint.x = pidRoll.pidUpdate(rpyVicon(0));
-            rpyRateSetpoint.y = pidPitch.pidUpdate(rpyVicon(1));
-            rpyRateSetpoint.z = pidYaw.pidUpdate(rpyVicon(2));
+            const double attitude_setpoint[3] = {rpyBody.y, rpyBody.x, 0};
+            const double attitude[3] = {rpyVicon(0), rpyVicon(1), rpyVicon(2)};
+            double rate_out[3];
+            attitude_pid.update(attitude_setpoint, attitude, rate_out);
+            rpyRateSetpoint.x = rate_out[0];
+            rpyRateSetpoint.y = rate_out[1];
+            rpyRateSetpoint.z = rate_out[2];
             
-            geometry_msgs::TwistStamped velmsg;
-            velmsg.header.stamp = ros::Time::now();
-	    velmsg.header.frame_id = "map";
-            velmsg.twist.angular = rpyRateSetpoint;
-            atttarget_pub.publish(velmsg);
-            
-            mavros_msgs::Thrust thrustmsg;
-            thrustmsg.header.stamp = ros::Time::now();
-	    thrustmsg.header.frame_id = "map";
-            thrustmsg.thrust = thrust;
-            thrusttarget_pub.publish(thrustmsg);
-	    //ROS_INFO("Thrust: %f, T setpoint: %f, Error: %f, Output: %f\n", thrust, pidZ.getSetpoint(), pidZ.getError(), pidZ.getOutput());
+            sendSetpoint(rpyRateSetpoint, thrust);
+            setpoint_metric->add();
+	    //ROS_INFO("Thrust: %f, T setpoint: %f\n", thrust, position_setpoint[2]);
         }
         
         r.sleep();
     }
 }
 
-void printToFile()
-{
-    // TODO: look into getcwd() to get current directory
-    std::ofstream positionFile;
-    positionFile.open ("/home/pi/copterpos.txt", std::ios::app);
-    
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && !isFlying)
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && isFlying)
-    {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << vicon_pose.position.x << ", " << vicon_pose.position.y << ", " << vicon_pose.position.z << "\r\n";
-        
-        printrate.sleep();
-    }
-    positionFile.close();
-}
-
 void sendWP(const geometry_msgs::PoseStamped& stamped_point)
 {
     geometry_msgs::Point point = stamped_point.pose.position;
     std::string stamp = stamped_point.header.frame_id;
-    starl_flag = true;
+
+    // Queued before isFlying is set, so sendAttitude has the setpoints before its first update
+    QueuedWaypoint wp;
+    wp.point = point;
+    wp.hold = stamp == "0" || stamp == "2";
+    if (!wp_queue.push(wp))
+    {
+        ROS_WARN("Waypoint queue full, dropped x: %f, y: %f, z: %f", point.x, point.y, point.z);
+    }
+
     std::cout << "Going to point x: " << point.x << ", y: " << point.y << ", z: " << point.z << std::endl;
     if (stamp == "0")    // takeoff
     {
@@ -258,10 +295,6 @@ void sendWP(const geometry_msgs::PoseStamped& stamped_point)
             ROS_INFO("arming failed");
             
         isFlying = true;
-        
-        pidX.setSetpoint(vicon_pose.position.x);
-        pidY.setSetpoint(vicon_pose.position.y);
-        pidZ.setSetpoint(point.z);
     }
     else if (stamp == "2")   // land
     {
@@ -271,56 +304,124 @@ void sendWP(const geometry_msgs::PoseStamped& stamped_point)
             ROS_INFO("disarming success");
         else
             ROS_INFO("disarming failed");
-        
-        pidX.setSetpoint(vicon_pose.position.x);
-        pidY.setSetpoint(vicon_pose.position.y);
-        pidZ.setSetpoint(point.z);
     }
-    else
-    {
-            pidX.setSetpoint(point.x);
-            pidY.setSetpoint(point.y);
-            pidZ.setSetpoint(point.z);
-    }
-    
-    pidX.reset();
-    pidY.reset();
-    pidZ.reset();
-    
-    current_waypoint.x = point.x;
-    current_waypoint.y = point.y;
-    current_waypoint.z = point.z;
 }
 
-int main(int argc, char **argv)
+namespace quadcopter
+{
+
+/*
+ * The position hold as a nodelet, so that the positioning in the same
+ * manager hands it its messages as shared pointers instead of over TCPROS.
+ * Its state is global, one per process. posHold_node loads it into a manager
+ * of its own.
+ */
+class PosHoldNodelet : public nodelet::Nodelet
 {
-    current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
-    ros::init(argc, argv, "posHold");
-    ros::NodeHandle n("~");
-    
-    n.param<std::string>("vicon_obj", vicon_obj, "cyphyhousecopter");
-    n.param<bool>("use_deca", use_deca, false);
-
-    arming_client = n.serviceClient<mavros_msgs::CommandBool>("/mavros/cmd/arming");
-    mode_client = n.serviceClient<mavros_msgs::SetMode>("/mavros/set_mode");
-
-    atttarget_pub = n.advertise<geometry_msgs::TwistStamped>("/mavros/setpoint_attitude/cmd_vel", 1);
-    thrusttarget_pub = n.advertise<mavros_msgs::Thrust>("/mavros/setpoint_attitude/thrust", 1);
-    reached_pub = n.advertise<std_msgs::String>("reached", 1);
- 
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
-    ros::Subscriber vel_sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/twist", 1, getViconVelocity);
-    
-    ros::Subscriber waypoint = n.subscribe("waypoint", 1, sendWP);
-    
-    gps_thread = std::thread(sendAttitude);
-    pos_thread = std::thread(printPos);
-    //print_thread = std::thread(printToFile);
-
-    ros::spin();
-    
-    gps_thread.join();
-    pos_thread.join();
-    //print_thread.join();
-    return 0;
+public:
+    ~PosHoldNodelet()
+    {
+        // No more poses to record
+        if (sensors)
+        {
+            sensors->stop();
+        }
+        trajectory.reset();
+        running = false;
+        if (gps_thread.joinable())
+        {
+            gps_thread.join();
+            pos_thread.join();
+        }
+        fcu_link.reset();
+        if (metrics_started)
+        {
+            stopMetricsServer();
+            metrics_started = false;
+        }
+    }
+
+private:
+    void onInit()
+    {
+        current_waypoint.x = current_waypoint.y = current_waypoint.z = 0;
+        ros::NodeHandle &n = getPrivateNodeHandle();
+
+        n.param<std::string>("vicon_obj", vicon_obj, "cyphyhousecopter");
+        n.param<bool>("use_deca", use_deca, false);
+
+        n.param<double>("controller_rate", controller_rate, CONTROLLER_RATE);
+        if (controller_rate <= 0 || controller_rate > MAX_CONTROLLER_RATE)
+        {
+            NODELET_WARN("controller_rate %f out of (0, %d], using %d Hz", controller_rate, MAX_CONTROLLER_RATE, CONTROLLER_RATE);
+            controller_rate = CONTROLLER_RATE;
+        }
+        position_pid = PidBank<3>(controller_rate, position_gains);
+        attitude_jitter.reset(new LoopJitter(1.0 / controller_rate));
+        attitude_jitter->exportMetrics("poshold_attitude");
+        setpoint_metric = &MetricsRegistry::instance().counter("poshold_setpoints_total", "Attitude setpoints sent to the flight controller");
+        int metrics_port;
+        n.param<int>("metrics_port", metrics_port, 0); // Prometheus endpoint of the process, 0 disables
+        metrics_started = startMetricsServer(metrics_port);
+        attitude_pid = PidBank<3>(controller_rate, attitude_gains);
+
+        // e.g. "udp://127.0.0.1:14551@", empty to go through mavros
+        std::string fcu_url;
+        n.param<std::string>("fcu_url", fcu_url, "");
+        n.param<int>("fcu_system_id", fcu_system_id, 1);
+        n.param<int>("fcu_component_id", fcu_component_id, 1);
+        if (!fcu_url.empty())
+        {
+            try
+            {
+                fcu_link = mavconn::MAVConnInterface::open_url(fcu_url);
+            }
+            catch (const mavconn::DeviceError& e)
+            {
+                NODELET_ERROR("Cannot open %s, setpoints go through mavros: %s", fcu_url.c_str(), e.what());
+            }
+        }
+
+        arming_client = n.serviceClient<mavros_msgs::CommandBool>("/mavros/cmd/arming");
+        mode_client = n.serviceClient<mavros_msgs::SetMode>("/mavros/set_mode");
+
+        atttarget_pub = n.advertise<geometry_msgs::TwistStamped>("/mavros/setpoint_attitude/cmd_vel", 1);
+        thrusttarget_pub = n.advertise<mavros_msgs::Thrust>("/mavros/setpoint_attitude/thrust", 1);
+        reached_pub = n.advertise<std_msgs::String>("reached", 1);
+
+        std::string trajectory_file;
+        n.param<std::string>("trajectory_file", trajectory_file, "/home/pi/copterpos");
+        // Every pose while flying, see TrajectoryRecorder
+        bool record_trajectory, compress_trajectory;
+        n.param<bool>("record_trajectory", record_trajectory, false);
+        n.param<bool>("compress_trajectory", compress_trajectory, true);
+        if (record_trajectory)
+        {
+            const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+            trajectory.reset(new TrajectoryRecorder(trajectory_file+ext, "quadcopter/posHold",
+                                                    {"vicon_x", "vicon_y", "vicon_z"}, compress_trajectory));
+        }
+
+        // The trajectory is in place before the first pose. Pose and twist have a queue and thread of their own
+        // (sensor_priority, sensor_cpus) rather than the one the manager shares with every other nodelet
+        sensors.reset(new CallbackThread(n, "sensor"));
+        sub = sensors->node().subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+        vel_sub = sensors->node().subscribe("/vrpn_client_node/"+vicon_obj+"/twist", 1, getViconVelocity);
+
+        waypoint = n.subscribe("waypoint", 1, sendWP);
+
+        // SCHED_FIFO priority and CPUs of the attitude loop, see RealtimeThread.h. printPos stays as it is
+        n.param<double>("attitude_phase", attitude_phase, 0.0);
+        lock_memory(n);
+        running = true;
+        gps_thread = start_thread("attitude", load_thread_config(n, "attitude"), sendAttitude);
+        pos_thread = std::thread(printPos);
+    }
+
+    std::unique_ptr<CallbackThread> sensors;
+    ros::Subscriber sub, vel_sub, waypoint;
+};
+
 }
+
+PLUGINLIB_EXPORT_CLASS(quadcopter::PosHoldNodelet, nodelet::Nodelet)
@@ -0,0 +1,113 @@
+//
+// 2-d tree over the planner's tree nodes, for nearest and radius lookups.
+//
+
+#ifndef RRT_KD_TREE_H
+#define RRT_KD_TREE_H
+#include <cstddef>
+#include <vector>
+
+/*
+ * Points are inserted one at a time as the RRT grows, splitting on x and y
+ * by depth. Uniformly sampled points keep it balanced in expectation, so
+ * lookups take O(log n) without ever rebuilding; clear and reinsert after
+ * the planner drops nodes. Each entry carries the id of its planner node.
+ */
+class KdTree {
+public:
+    void clear() {
+        entries.clear();
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    void insert(double x, double y, int id) {
+        Entry e = {{x, y}, id, -1, -1};
+        entries.push_back(e);
+        const int added = static_cast<int>(entries.size()) - 1;
+        if (added == 0) {
+            return;
+        }
+        int i = 0, axis = 0;
+        while (true) {
+            int &child = entries[added].p[axis] < entries[i].p[axis] ? entries[i].left : entries[i].right;
+            if (child < 0) {
+                child = added;
+                return;
+            }
+            i = child;
+            axis ^= 1;
+        }
+    }
+
+    // Id of the entry closest to (x, y), -1 if empty
+    int nearest(double x, double y) const {
+        if (entries.empty()) {
+            return -1;
+        }
+        const double q[2] = {x, y};
+        int best = -1;
+        double best_d2 = 0.0;
+        nearest(0, 0, q, best, best_d2);
+        return entries[best].id;
+    }
+
+    // Ids of the entries within r of (x, y)
+    void within(double x, double y, double r, std::vector<int> &ids) const {
+        ids.clear();
+        if (entries.empty()) {
+            return;
+        }
+        const double q[2] = {x, y};
+        within(0, 0, q, r * r, ids);
+    }
+
+private:
+    struct Entry {
+        double p[2];
+        int id;
+        int left, right;
+    };
+
+    void nearest(int i, int axis, const double q[2], int &best, double &best_d2) const {
+        const Entry &e = entries[i];
+        const double dx = q[0] - e.p[0], dy = q[1] - e.p[1];
+        const double d2 = dx * dx + dy * dy;
+        if (best < 0 || d2 < best_d2) {
+            best = i;
+            best_d2 = d2;
+        }
+        const double diff = q[axis] - e.p[axis];
+        const int near = diff < 0 ? e.left : e.right;
+        const int far = diff < 0 ? e.right : e.left;
+        if (near >= 0) {
+            nearest(near, axis ^ 1, q, best, best_d2);
+        }
+        if (far >= 0 && diff * diff < best_d2) {
+            nearest(far, axis ^ 1, q, best, best_d2);
+        }
+    }
+
+    void within(int i, int axis, const double q[2], double r2, std::vector<int> &ids) const {
+        const Entry &e = entries[i];
+        const double dx = q[0] - e.p[0], dy = q[1] - e.p[1];
+        if (dx * dx + dy * dy <= r2) {
+            ids.push_back(e.id);
+        }
+        const double diff = q[axis] - e.p[axis];
+        const int near = diff < 0 ? e.left : e.right;
+        const int far = diff < 0 ? e.right : e.left;
+        if (near >= 0) {
+            within(near, axis ^ 1, q, r2, ids);
+        }
+        if (far >= 0 && diff * diff <= r2) {
+            within(far, axis ^ 1, q, r2, ids);
+        }
+    }
+
+    std::vector<Entry> entries;
+};
+
+#endif //RRT_KD_TREE_H
@@ -7,18 +7,76 @@
 #include "geometry_msgs/PointStamped.h"
 #include <deque>
 #include "Eigen/Dense"
+#include "cyphy_control/CarMpc.h"
+#include "cyphy_control/DistanceField.h"
+#include <memory>
+#include <vector>
 
+class PrimitiveLattice;
 
-class MPC {
+
+/*
+ * The CarMpc problem of this package and the weights of its terms: the
+ * distance of each step from its own waypoint and the inputs, and the
+ * collision constraints if asked for.
+ */
+struct MpcProblem : CarProblem {
+    MpcProblem() {
+        lr = 0.33;
+    }
+
+    //State cost weights
+    double x_weight = 50;
+    double y_weight = 50;
+
+    //Input and input derivative cost weights
+    double delta_weight = 10;
+    double delta_rate_weight = 25;
+    double v_weight = 5;
+    double v_rate_weight = 20;
+
+    //Obstacles of the map at least obstacle_margin [m] away (ObstacleConstraint), and the nearest
+    //avoid_robots other robots at least robot_distance [m] (RobotConstraint)
+    bool avoid_obstacles = false;
+    double obstacle_margin = 0.25;
+    size_t avoid_robots = 0;
+    double robot_distance = 0.6;
+};
+
+// Another robot where the fleet last saw it and its velocity, and the trajectory its own MPC predicted if it shares
+// one. The MPC follows the trajectory, extended along its end segments, or else predicts at constant velocity
+struct OtherRobot {
+    double x, y, vx, vy;
+    // Times [s] after the state of the solve, ascending, and positions of the shared trajectory, none if empty
+    std::vector<double> t, px, py;
+};
+
+class MPC : public CarMpc {
 public:
-    MPC();
+    explicit MPC(const MpcProblem &problem = MpcProblem());
+
+    // Cold starts begin from the primitive closest to the waypoints instead of all zeros, none if null
+    const PrimitiveLattice *primitives;
+    // Signed distance to the obstacles, nothing to avoid while null
+    std::shared_ptr<const DistanceField> field;
+    // Solve the model given an initial state and the waypoint of each step, at least one, keeping clear of the
+    // nearest others, nearest first, as they are age [s] before the state, into solution (see CarMpc::Solve)
+    void Solve(const Eigen::VectorXd &state, const std::deque<geometry_msgs::Point> &waypoints,
+               const std::vector<OtherRobot> &others, double age, Solution &solution);
+
+    // The trajectory of solution from x, y resampled at points times from 0 to the end of the horizon, as x, y and
+    // the time [s] after its state, for the other robots to avoid. False if it holds none
+    bool prediction(const Solution &solution, double x, double y, size_t points, std::vector<float> &out) const;
 
-    virtual ~MPC();
-    std::deque<double> x_vals;
-    std::deque<double> y_vals;
-    // Solve the model given an initial state
-    std::deque<double> Solve(Eigen::VectorXd state, std::deque<geometry_msgs::Point> waypoints);
+protected:
+    bool cold_guess(double x, double y, double psi, const double *params, Guess &guess) const;
 
+private:
+    MpcProblem problem;
+    // Waypoints of the solve under way, what the primitives are matched to
+    const std::deque<geometry_msgs::Point> *waypoints;
+    // Parameters of the terms and where each step is expected, kept across solves for their storage
+    std::vector<double> params, ex, ey;
 };
 
 #endif //MPC_MPC_H
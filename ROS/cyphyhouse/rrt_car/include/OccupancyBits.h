@@ -0,0 +1,100 @@
+//
+// Occupancy grid packed one bit per cell, for the planner's collision checks.
+//
+
+#ifndef RRT_OCCUPANCY_BITS_H
+#define RRT_OCCUPANCY_BITS_H
+#include "nav_msgs/OccupancyGrid.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Row-major bitset of the blocked cells, obstacles grown by the car's radius
+ * so the planner can treat the car as a point. A cell is one bit of a 64 bit
+ * word, a 10 m x 10 m map at 5 cm fits in 5 KB and stays in cache while a
+ * replan checks thousands of segments. Everything outside the map is
+ * blocked. Unknown cells count as blocked unless unknown_free.
+ */
+class OccupancyBits {
+public:
+    OccupancyBits() : width(0), height(0), resolution(1.0), origin_x(0.0), origin_y(0.0) {}
+
+    void assign(const nav_msgs::OccupancyGrid &grid, int threshold, double inflation, bool unknown_free) {
+        width = grid.info.width;
+        height = grid.info.height;
+        resolution = grid.info.resolution;
+        origin_x = grid.info.origin.position.x;
+        origin_y = grid.info.origin.position.y;
+        bits.assign((static_cast<size_t>(width) * height + 63) / 64, 0);
+
+        const int r = static_cast<int>(std::ceil(inflation / resolution));
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const int8_t v = grid.data[static_cast<size_t>(y) * width + x];
+                if (v >= threshold || (v < 0 && !unknown_free)) {
+                    block(x, y, r);
+                }
+            }
+        }
+    }
+
+    bool empty() const {
+        return bits.empty();
+    }
+
+    bool blocked(double x, double y) const {
+        const int cx = static_cast<int>(std::floor((x - origin_x) / resolution));
+        const int cy = static_cast<int>(std::floor((y - origin_y) / resolution));
+        if (cx < 0 || cy < 0 || cx >= width || cy >= height) {
+            return true;
+        }
+        const size_t i = static_cast<size_t>(cy) * width + cx;
+        return (bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    // Segment a-b clear of obstacles, checked every half cell
+    bool free(double ax, double ay, double bx, double by) const {
+        const double len = std::hypot(bx - ax, by - ay);
+        const int steps = static_cast<int>(std::ceil(len / (0.5 * resolution)));
+        for (int k = 0; k <= steps; ++k) {
+            const double f = steps > 0 ? static_cast<double>(k) / steps : 0.0;
+            if (blocked(ax + f * (bx - ax), ay + f * (by - ay))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bounds of the map [m]
+    double min_x() const { return origin_x; }
+    double min_y() const { return origin_y; }
+    double max_x() const { return origin_x + width * resolution; }
+    double max_y() const { return origin_y + height * resolution; }
+
+private:
+    // Blocks the disc of radius r cells around cell (x, y)
+    void block(int x, int y, int r) {
+        for (int dy = -r; dy <= r; ++dy) {
+            const int yy = y + dy;
+            if (yy < 0 || yy >= height) {
+                continue;
+            }
+            for (int dx = -r; dx <= r; ++dx) {
+                const int xx = x + dx;
+                if (xx < 0 || xx >= width || dx * dx + dy * dy > r * r) {
+                    continue;
+                }
+                const size_t i = static_cast<size_t>(yy) * width + xx;
+                bits[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+        }
+    }
+
+    int width, height;
+    double resolution;
+    double origin_x, origin_y;
+    std::vector<uint64_t> bits;
+};
+
+#endif //RRT_OCCUPANCY_BITS_H
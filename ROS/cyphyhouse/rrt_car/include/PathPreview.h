@@ -0,0 +1,102 @@
+//
+// Reference of the MPC horizon from a waypoint path, by arc length.
+//
+
+#ifndef MPC_PATH_PREVIEW_H
+#define MPC_PATH_PREVIEW_H
+#include "geometry_msgs/Point.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+/*
+ * The path as a polyline parametrized by arc length, and how far along it the
+ * car is. advance projects the car onto the segments from the current one on
+ * and only ever moves forward, so it costs a few segments per tick and a
+ * crossing or doubling back path cannot pull the reference backwards. The
+ * preview samples the path at given arc lengths ahead of there, holding the
+ * end of the path once it runs past it.
+ */
+class PathPreview {
+public:
+    PathPreview() : segment(0), progress(0.0) {}
+
+    // New path, progress from its start
+    void reset(const std::deque<geometry_msgs::Point> &path) {
+        points.assign(path.begin(), path.end());
+        length.assign(1, 0.0);
+        for (size_t i = 1; i < points.size(); ++i) {
+            length.push_back(length.back() + std::hypot(points[i].x - points[i - 1].x, points[i].y - points[i - 1].y));
+        }
+        segment = 0;
+        progress = 0.0;
+    }
+
+    void clear() {
+        reset(std::deque<geometry_msgs::Point>());
+    }
+
+    bool empty() const {
+        return points.empty();
+    }
+
+    // Path length left ahead of the car [m]
+    double remaining() const {
+        return empty() ? 0.0 : length.back() - progress;
+    }
+
+    // Moves the progress to the projection of pos, searching lookahead segments ahead of the current one
+    void advance(const geometry_msgs::Point &pos, size_t lookahead = 5) {
+        const size_t last = std::min(points.size() - 1, segment + 1 + lookahead);
+        double best = -1.0, best_s = progress;
+        for (size_t i = segment; i + 1 <= last; ++i) {
+            const geometry_msgs::Point &a = points[i], &b = points[i + 1];
+            const double seg = length[i + 1] - length[i];
+            double f = 0.0;
+            if (seg > 0.0) {
+                f = ((pos.x - a.x) * (b.x - a.x) + (pos.y - a.y) * (b.y - a.y)) / (seg * seg);
+                f = std::max(0.0, std::min(1.0, f));
+            }
+            const double d = std::hypot(a.x + f * (b.x - a.x) - pos.x, a.y + f * (b.y - a.y) - pos.y);
+            if (best < 0.0 || d < best) {
+                best = d;
+                best_s = length[i] + f * seg;
+            }
+        }
+        progress = std::max(progress, best_s);
+        while (segment + 2 < points.size() && length[segment + 1] <= progress) {
+            ++segment;
+        }
+    }
+
+    // The points offsets [m] ahead of the progress, ascending
+    std::deque<geometry_msgs::Point> sample(const std::vector<double> &offsets) const {
+        std::deque<geometry_msgs::Point> preview;
+        size_t i = segment;
+        for (size_t k = 0; k < offsets.size(); ++k) {
+            const double s = std::min(length.back(), progress + offsets[k]);
+            while (i + 2 < points.size() && length[i + 1] < s) {
+                ++i;
+            }
+            geometry_msgs::Point p = points[i];
+            if (i + 1 < points.size() && length[i + 1] > length[i]) {
+                const double f = (s - length[i]) / (length[i + 1] - length[i]);
+                p.x += f * (points[i + 1].x - points[i].x);
+                p.y += f * (points[i + 1].y - points[i].y);
+            }
+            preview.push_back(p);
+        }
+        return preview;
+    }
+
+private:
+    std::vector<geometry_msgs::Point> points;
+    // Arc length at each point
+    std::vector<double> length;
+    // Segment of the progress, points[segment] to points[segment + 1]
+    size_t segment;
+    double progress;
+};
+
+#endif //MPC_PATH_PREVIEW_H
@@ -0,0 +1,59 @@
+//
+// Precomputed motion primitives of the MPC's bicycle model.
+//
+
+#ifndef MPC_PRIMITIVES_H
+#define MPC_PRIMITIVES_H
+#include "geometry_msgs/Point.h"
+#include "MPC.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/*
+ * One primitive is a constant steering and speed held over the MPC horizon,
+ * an arc of the model of FG_eval stepped at its step lengths, forwards or in reverse
+ * (the arcs of Dubins and Reeds-Shepp paths). Trajectories start at the
+ * origin with the heading at the centre of their heading bin, are stored
+ * as floats for all bins and steps in one array, and are found by heading
+ * bin, so neither the planner nor the MPC integrate the model online.
+ */
+class PrimitiveLattice {
+public:
+    struct Primitive {
+        float delta, v;
+        // Heading bin it ends in
+        uint16_t end_bin;
+        // Steps N - 1 of the trajectory, 3 floats (x, y, psi) each, start at offset of the states
+        uint32_t offset;
+    };
+
+    // Steering and speed levels across [-dir_bound, dir_bound] and [-vel_bound, vel_bound], zero speed left out
+    explicit PrimitiveLattice(const MpcProblem &problem, size_t heading_bins = 16, size_t steer_levels = 5,
+                              size_t speed_levels = 4);
+
+    size_t bins() const;
+    size_t bin(double psi) const;
+    // Heading at the centre of bin b
+    double heading(size_t b) const;
+    // The primitives starting in bin b
+    const Primitive *begin(size_t b) const;
+    const Primitive *end(size_t b) const;
+    // State k in [1, N) of p, relative to its start
+    const float *state(const Primitive &p, size_t k) const;
+
+    // The primitive from (x, y, psi) closest to waypoints, with the tracking weights of ReferenceCost
+    const Primitive &closest(double x, double y, double psi, const std::deque<geometry_msgs::Point> &waypoints) const;
+    // State k of p started at (x, y, psi), rotated by psi off its bin's centre so it is exactly the model's
+    void place(const Primitive &p, size_t k, double x, double y, double psi, double &xk, double &yk,
+               double &psik) const;
+
+private:
+    MpcProblem problem;
+    size_t heading_bins;
+    size_t per_bin;
+    std::vector<Primitive> primitives;
+    std::vector<float> states;
+};
+
+#endif //MPC_PRIMITIVES_H
@@ -0,0 +1,86 @@
+//
+// Informed RRT* over an occupancy grid, kept between replans.
+//
+
+#ifndef RRT_RRT_STAR_H
+#define RRT_RRT_STAR_H
+#include "geometry_msgs/Point.h"
+#include "KdTree.h"
+#include "OccupancyBits.h"
+#include <random>
+#include <vector>
+
+/*
+ * Tree parameters. The defaults suit the lab arena, a few metres across.
+ */
+struct RRTParams {
+    // Longest edge [m]
+    double step = 0.5;
+    // Rewiring radius gamma * sqrt(log(n) / n), capped at step
+    double gamma = 4.0;
+    // Chance of sampling the car's position instead of the free space
+    double start_bias = 0.05;
+    // A full tree drops the nodes that cannot shorten the path, or starts over from the path
+    size_t max_nodes = 4000;
+    // A goal further than this [m] from the last one starts a new tree
+    double goal_tolerance = 0.05;
+};
+
+/*
+ * The tree is rooted at the goal and grows towards the car, so the car
+ * moving does not invalidate any of it: every replan only has to connect
+ * the car's current position to a nearby node and follow parents down to
+ * the goal. A new map drops the subtrees whose edge into them is now
+ * blocked and keeps the rest. Once there is a path, samples are drawn from
+ * the ellipse of points that could still shorten it (informed RRT*).
+ */
+class RRTStar {
+public:
+    explicit RRTStar(const RRTParams &params = RRTParams());
+
+    // Moves the goal, starting a new tree when it moved more than goal_tolerance
+    void setGoal(double x, double y);
+    // New obstacles, prunes the subtrees they block
+    void setMap(const OccupancyBits &grid);
+    // Grows the tree for budget [s] and returns the path from (x, y) to the goal, false if there is none yet
+    bool plan(double x, double y, double budget, std::vector<geometry_msgs::Point> &path);
+    // Length through the tree of the last successful plan, before shortcuts [m]
+    double cost() const;
+    size_t size() const;
+
+private:
+    struct Node {
+        double x, y;
+        // Path length to the goal
+        double cost;
+        int parent;
+        std::vector<int> children;
+    };
+
+    void reset();
+    // Drops the nodes whose edge from their parent is blocked or that cannot lie on a path from
+    // (sx, sy) shorter than c_best, with their subtrees
+    void compact(double sx, double sy, double c_best);
+    // Keeps only the path from node via to the goal, only the goal if via is -1
+    void restart(int via);
+    // Straight segments over the nodes of the path that see each other
+    void shortcut(std::vector<geometry_msgs::Point> &path) const;
+    void grow(double sx, double sy, double c_best);
+    void sample(double sx, double sy, double c_best, double &x, double &y);
+    // Best free edge from (x, y) into the tree, -1 if none within reach
+    int connect(double x, double y, double &total);
+    void reparent(int n, int parent, double cost);
+    double radius() const;
+
+    RRTParams params;
+    OccupancyBits grid;
+    std::vector<Node> nodes;
+    KdTree index;
+    bool has_goal;
+    double last_cost;
+    std::mt19937 rng;
+    std::vector<int> near;
+    std::vector<int> stack;
+};
+
+#endif //RRT_RRT_STAR_H
@@ -1,238 +1,143 @@
 #include "MPC.h"
-#include <cppad/cppad.hpp>
-#include <cppad/ipopt/solve.hpp>
-#include "Eigen/Dense"
-#include <cmath>
-#include "geometry_msgs/PoseStamped.h"
-#include "geometry_msgs/PointStamped.h"
-
-using CppAD::AD;
-
-// Set the timestep length and duration
-const size_t N = 10;
-const double dt = 0.1;
-
-//Geometric parameters of car
-const double lr = 0.33;
-
-//State and input hard constraints
-const double x_bound = 3.0;
-const double y_bound = 3.0;
-const double dir_bound = 0.35;
-const double vel_bound = 3.0;
-
-//Define target states
-double x_ref[10], y_ref[10];
-
-//Initialize
-size_t x_start = 0;
-size_t y_start = x_start + N;
-size_t psi_start = y_start + N;
-size_t v_start = psi_start + N;
-size_t delta_start = v_start + N - 1;
-
-//State cost weights
-const double x_weight = 50;
-const double y_weight = 50;
-
-//Input and input derivative cost weights
-const double delta_weight = 10;
-const double delta_rate_weight = 25;
-const double v_weight = 5;
-const double v_rate_weight = 20;
-
-class FG_eval {
-public:
-    FG_eval() = default;
-    typedef CPPAD_TESTVECTOR(AD<double>) ADvector;
-    void operator()(ADvector& fg, const ADvector& vars) {
-        //Initialize cost at 0
-        fg[0] = 0;
-
-        
-
-        //Set up the cost function
-        for (unsigned int t = 0; t < N; ++t){
-            //Penalize x-distance from waypoint and boundary
-            fg[0] += x_weight * (t + 1) * CppAD::pow(vars[x_start + t] - x_ref[t], 2);
-            //Penalize y-distance from waypoint and boundary
-            fg[0] += y_weight * (t + 1) * CppAD::pow(vars[y_start + t] - y_ref[t], 2);
-        }
-
-        //Minimize inputs
-        for (unsigned int t = 0; t < N - 1; ++t) {
-            fg[0] += delta_weight * CppAD::pow(vars[delta_start + t], 2);
-            fg[0] += v_weight * CppAD::pow(vars[v_start + t], 2);
-        }
-        
-        //Minimize input derivatives
-        for (unsigned int t = 0; t < N - 2; ++t) {
-            fg[0] += delta_rate_weight * CppAD::pow(vars[delta_start + t + 1] - vars[delta_start + t], 2);
-            fg[0] += v_rate_weight * CppAD::pow(vars[v_start + t + 1] - vars[v_start + t], 2);
-        }
-
-        //Set the constraints at time t=0
-        fg[1 + x_start] = vars[x_start];
-        fg[1 + y_start] = vars[y_start];
-        fg[1 + psi_start] = vars[psi_start];
-
-        for (unsigned int t = 1; t < N; ++t) {
-            //State at time t+1
-            AD<double> x1 = vars[x_start + t];
-            AD<double> y1 = vars[y_start + t];
-            AD<double> psi1 = vars[psi_start + t];
-
-            //State at time t
-            AD<double> x0 = vars[x_start + t - 1];
-            AD<double> y0 = vars[y_start + t - 1];
-            AD<double> psi0 = vars[psi_start + t - 1];
-
-            //Actuations at time, t
-            AD<double> delta0 = vars[delta_start + t - 1];
-            AD<double> v0 = vars[v_start + t - 1];
+#include "Primitives.h"
+#include "cyphy_control/CostTerms.h"
+#include <algorithm>
+
+// Offset [m] of the other robots of empty slots, far enough to leave their constraints inactive
+#define FAR_AWAY 100.0
+
+static CarMpc::Terms cost_terms(const MpcProblem &p) {
+    CarMpc::Terms terms;
+    terms.emplace_back(new ReferenceCost(p.x_weight, p.y_weight));
+    terms.emplace_back(new InputCost(p.delta_weight, p.delta_rate_weight, p.v_weight, p.v_rate_weight));
+    if (p.avoid_obstacles) {
+        terms.emplace_back(new ObstacleConstraint(p.obstacle_margin));
+    }
+    if (p.avoid_robots > 0) {
+        terms.emplace_back(new RobotConstraint(p.avoid_robots, p.robot_distance));
+    }
+    return terms;
+}
 
-            //Set up the SS model constraints for time steps [1,N]
-            fg[1 + x_start + t] = x1 - (x0 + v0 * CppAD::cos(psi0) * dt);
-            fg[1 + y_start + t] = y1 - (y0 + v0 * CppAD::sin(psi0) * dt);
-            fg[1 + psi_start + t] = psi1 - (psi0 + v0 * CppAD::tan(delta0) * dt / lr);
-        }
+// Position of other at time [s] on its shared trajectory, linear along the end segments outside it
+static void follow(const OtherRobot &other, double time, double &x, double &y) {
+    const size_t last = other.t.size() - 1;
+    size_t i = 0;
+    while (i + 1 < last && other.t[i + 1] <= time) {
+        ++i;
     }
-};
+    const double span = other.t[i + 1] - other.t[i];
+    const double f = span > 0 ? (time - other.t[i]) / span : 0;
+    x = other.px[i] + f * (other.px[i + 1] - other.px[i]);
+    y = other.py[i] + f * (other.py[i + 1] - other.py[i]);
+}
 
 //
 // MPC class definition implementation.
 //
-MPC::MPC() = default;
-MPC::~MPC() = default;
+MPC::MPC(const MpcProblem &problem)
+    : CarMpc(problem, cost_terms(problem), "rrt_car"), primitives(nullptr), problem(problem), waypoints(nullptr) {}
 
-std::deque<double> MPC::Solve(Eigen::VectorXd state, std::deque<geometry_msgs::Point> waypoints) 
+void MPC::Solve(const Eigen::VectorXd &state, const std::deque<geometry_msgs::Point> &waypoints,
+                const std::vector<OtherRobot> &others, double age, Solution &solution)
 {
-    bool ok = true;
-    typedef CPPAD_TESTVECTOR(double) Dvector;
     double x = state[0];
     double y = state[1];
     double psi = state[2];
-    
-    for (int i = 0; i < N; i++)
-    {
-        x_ref[i] = waypoints[i].x;
-        y_ref[i] = waypoints[i].y;
-    }
-
-    // Set number of model variables
-    size_t n_vars = N * 3 + (N - 1) * 2; // 3N state elements, 2(N-1) actuators
-    // Set the number of constraints
-    size_t n_constraints = N * 3; // (x, y, psi)
 
-    // Initialize model variables to zero
-    Dvector vars(n_vars);
-    for (unsigned int i = 0; i < n_vars; ++i) {
-        vars[i] = 0;
+    // Waypoint x of each step then y, a shorter preview holds its last point
+    params.resize(2 * problem.N);
+    for (size_t i = 0; i < problem.N; ++i) {
+        const geometry_msgs::Point &wp = waypoints[std::min<size_t>(i, waypoints.size() - 1)];
+        params[i] = wp.x;
+        params[problem.N + i] = wp.y;
     }
 
-    //Set the initial state
-    vars[x_start] = x;
-    vars[y_start] = y;
-    vars[psi_start] = psi;
-
-    Dvector vars_lowerbound(n_vars);
-    Dvector vars_upperbound(n_vars);
-
-    //Define positive and negative infinities
-    for (unsigned int i = 0; i < delta_start; ++i) {
-        vars_lowerbound[i] = -1.0e19;
-        vars_upperbound[i] = 1.0e19;
+    // Where each step after the first is expected: one step on along the last trajectory, or its waypoint
+    const size_t N = problem.N;
+    ex.resize(N);
+    ey.resize(N);
+    for (size_t t = 1; t < N; ++t) {
+        if (!predicted(std::min(t + 1, N - 1), ex[t], ey[t])) {
+            ex[t] = params[t];
+            ey[t] = params[N + t];
+        }
     }
 
-    //X and Y bounds
-    for (unsigned int i = x_start; i < y_start; ++i) {
-        vars_lowerbound[i] = -x_bound;
-        vars_upperbound[i] = x_bound;
+    // The patch of the distance field around each, interpolated on the tape
+    if (problem.avoid_obstacles) {
+        double patch[DistanceField::PATCH];
+        params.push_back(field ? field->resolution() : 1.0);
+        for (size_t t = 1; t < N; ++t) {
+            if (field) {
+                field->patch(ex[t], ey[t], patch);
+            } else {
+                DistanceField().patch(ex[t], ey[t], patch);
+            }
+            params.insert(params.end(), patch, patch + DistanceField::PATCH);
+        }
     }
 
-    for (unsigned int i = y_start; i < psi_start; ++i) {
-        vars_lowerbound[i] = -y_bound;
-        vars_upperbound[i] = y_bound;
+    // The other robots at each step after the first, empty slots far off
+    for (size_t k = 0; k < problem.avoid_robots; ++k) {
+        const size_t at = params.size();
+        params.resize(at + 2 * (N - 1));
+        for (size_t t = 1; t < N; ++t) {
+            if (k < others.size() && others[k].t.size() > 1) {
+                follow(others[k], problem.time(t), params[at + t - 1], params[at + N - 1 + t - 1]);
+            } else if (k < others.size()) {
+                const double ahead = age + problem.time(t);
+                params[at + t - 1] = others[k].x + others[k].vx * ahead;
+                params[at + N - 1 + t - 1] = others[k].y + others[k].vy * ahead;
+            } else {
+                params[at + t - 1] = ex[t] + FAR_AWAY;
+                params[at + N - 1 + t - 1] = ey[t] + FAR_AWAY;
+            }
+        }
     }
 
-    // Steering angle upper and lower limits [rad]
-    for (unsigned int i = delta_start; i < n_vars; ++i) {
-        vars_lowerbound[i] = -dir_bound;
-        vars_upperbound[i] = dir_bound;
-    }
+    this->waypoints = &waypoints;
+    CarMpc::Solve(x, y, psi, params.data(), params.size(), solution);
+    this->waypoints = nullptr;
+}
 
-    // Velocity upper and lower limits [m/s]
-    for (unsigned int i = v_start; i < delta_start; ++i) {
-        vars_lowerbound[i] = -vel_bound;
-        vars_upperbound[i] = vel_bound;
+bool MPC::prediction(const Solution &solution, double x, double y, size_t points, std::vector<float> &out) const {
+    const size_t N = problem.N;
+    const std::vector<double> &x_vals = solution.x_vals, &y_vals = solution.y_vals;
+    if (x_vals.size() != N - 1 || points < 2) {
+        return false;
     }
-
-    // Lower and upper bounds for hard constraints (0 except for initial states)
-    Dvector constraints_lowerbound(n_constraints);
-    Dvector constraints_upperbound(n_constraints);
-    for (unsigned int i = 0; i < n_constraints; ++i) {
-        constraints_lowerbound[i] = 0.0;
-        constraints_upperbound[i] = 0.0;
+    out.clear();
+    const double horizon = problem.time(N - 1);
+    size_t k = 0;
+    for (size_t j = 0; j < points; ++j) {
+        // Between step k and k + 1, the state x, y being step 0
+        const double t = horizon * j / (points - 1);
+        while (k + 2 < N && problem.time(k + 1) <= t) {
+            ++k;
+        }
+        const double x0 = k ? x_vals[k - 1] : x, y0 = k ? y_vals[k - 1] : y;
+        const double f = (t - problem.time(k)) / (problem.time(k + 1) - problem.time(k));
+        out.push_back(static_cast<float>(x0 + f * (x_vals[k] - x0)));
+        out.push_back(static_cast<float>(y0 + f * (y_vals[k] - y0)));
+        out.push_back(static_cast<float>(t));
     }
+    return true;
+}
 
-    //Initial states constrained to last measured value
-    constraints_lowerbound[x_start] = x;
-    constraints_lowerbound[y_start] = y;
-    constraints_lowerbound[psi_start] = psi;
-
-    constraints_upperbound[x_start] = x;
-    constraints_upperbound[y_start] = y;
-    constraints_upperbound[psi_start] = psi;
-
-    // Object that computes objective and constraints
-    FG_eval fg_eval;
-
-    //
-    // NOTE: You don't have to worry about these options
-    //
-    // options for IPOPT solver
-    std::string options;
-    // Uncomment this if you'd like more print information
-    options += "Integer print_level  0\n";
-    // NOTE: Setting sparse to true allows the solver to take advantage
-    // of sparse routines, this makes the computation MUCH FASTER. If you
-    // can uncomment 1 of these and see if it makes a difference or not but
-    // if you uncomment both the computation time should go up in orders of
-    // magnitude.
-    options += "Sparse  true        forward\n";
-    //options += "Sparse  true        reverse\n";
-    // NOTE: Currently the solver has a maximum time limit of 0.5 seconds.
-    // Change this as you see fit.
-    options += "Numeric max_cpu_time          0.099\n";
-
-    // place to return solution
-    CppAD::ipopt::solve_result<Dvector> solution;
-
-    // solve the problem
-    CppAD::ipopt::solve<Dvector, FG_eval>(
-            options, vars, vars_lowerbound, vars_upperbound, constraints_lowerbound,
-            constraints_upperbound, fg_eval, solution);
-
-    // Check some of the solution values
-    ok &= solution.status == CppAD::ipopt::solve_result<Dvector>::success;
-
-    // Cost
-    //auto cost = solution.obj_value;
-    //std::cout << "Cost " << cost << std::endl;
-
-    std::deque<double> result;
-
-    result.push_back(solution.x[delta_start]);
-    result.push_back(solution.x[v_start]);
-
-    //Clear the mpc x & y value vectors
-    this->x_vals.clear();
-    this->y_vals.clear();
-
-    //push back the predicted x,y values into the attributes
-    for (unsigned int i = 1; i < N; ++i){
-        this->x_vals.push_back(solution.x[x_start+i]);
-        this->y_vals.push_back(solution.x[y_start+i]);
+bool MPC::cold_guess(double x, double y, double psi, const double *, Guess &guess) const {
+    if (!primitives || !waypoints) {
+        return false;
+    }
+    // The trajectory of the closest primitive satisfies the model constraints already
+    const PrimitiveLattice::Primitive &p = primitives->closest(x, y, psi, *waypoints);
+    guess.x.assign(problem.N, x);
+    guess.y.assign(problem.N, y);
+    guess.psi.assign(problem.N, psi);
+    for (size_t t = 1; t < problem.N; ++t) {
+        primitives->place(p, t, x, y, psi, guess.x[t], guess.y[t], guess.psi[t]);
     }
-    return result;
+    guess.delta.assign(problem.N - 1, p.delta);
+    guess.v.assign(problem.N - 1, p.v);
+    return true;
 }
@@ -0,0 +1,107 @@
+#include "Primitives.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PrimitiveLattice::PrimitiveLattice(const MpcProblem &problem, size_t heading_bins, size_t steer_levels,
+                                   size_t speed_levels)
+    : problem(problem), heading_bins(std::max<size_t>(heading_bins, 1)) {
+    // Levels evenly across the bounds, an odd steer count has straight ahead and an even speed count skips 0
+    std::vector<double> steer, speed;
+    for (size_t i = 0; i < steer_levels; ++i) {
+        steer.push_back(steer_levels > 1 ? problem.dir_bound * (2.0 * i / (steer_levels - 1) - 1.0) : 0.0);
+    }
+    for (size_t i = 0; i < speed_levels; ++i) {
+        const double v = speed_levels > 1 ? problem.vel_bound * (2.0 * i / (speed_levels - 1) - 1.0) : problem.vel_bound;
+        if (std::fabs(v) > 1e-9) {
+            speed.push_back(v);
+        }
+    }
+    per_bin = steer.size() * speed.size();
+
+    const size_t steps = problem.N - 1;
+    primitives.reserve(this->heading_bins * per_bin);
+    states.reserve(this->heading_bins * per_bin * steps * 3);
+    for (size_t b = 0; b < this->heading_bins; ++b) {
+        for (double v : speed) {
+            for (double delta : steer) {
+                Primitive p;
+                p.delta = static_cast<float>(delta);
+                p.v = static_cast<float>(v);
+                p.offset = static_cast<uint32_t>(states.size());
+                // The discrete model of FG_eval, from the origin
+                double x = 0, y = 0, psi = heading(b);
+                for (size_t k = 0; k < steps; ++k) {
+                    const double dt = problem.step(k);
+                    const double x1 = x + v * std::cos(psi) * dt;
+                    const double y1 = y + v * std::sin(psi) * dt;
+                    psi += v * std::tan(delta) * dt / problem.lr;
+                    x = x1;
+                    y = y1;
+                    states.push_back(static_cast<float>(x));
+                    states.push_back(static_cast<float>(y));
+                    states.push_back(static_cast<float>(psi));
+                }
+                p.end_bin = static_cast<uint16_t>(bin(psi));
+                primitives.push_back(p);
+            }
+        }
+    }
+}
+
+size_t PrimitiveLattice::bins() const {
+    return heading_bins;
+}
+
+size_t PrimitiveLattice::bin(double psi) const {
+    const long n = static_cast<long>(heading_bins);
+    const long b = std::lround(psi * n / (2 * M_PI));
+    return static_cast<size_t>((b % n + n) % n);
+}
+
+double PrimitiveLattice::heading(size_t b) const {
+    return b * 2 * M_PI / heading_bins;
+}
+
+const PrimitiveLattice::Primitive *PrimitiveLattice::begin(size_t b) const {
+    return primitives.data() + b * per_bin;
+}
+
+const PrimitiveLattice::Primitive *PrimitiveLattice::end(size_t b) const {
+    return primitives.data() + (b + 1) * per_bin;
+}
+
+const float *PrimitiveLattice::state(const Primitive &p, size_t k) const {
+    return &states[p.offset + (k - 1) * 3];
+}
+
+void PrimitiveLattice::place(const Primitive &p, size_t k, double x, double y, double psi, double &xk, double &yk,
+                             double &psik) const {
+    const float *s = state(p, k);
+    const double off = psi - heading(bin(psi));
+    const double c = std::cos(off), sn = std::sin(off);
+    xk = x + c * s[0] - sn * s[1];
+    yk = y + sn * s[0] + c * s[1];
+    psik = s[2] + off;
+}
+
+const PrimitiveLattice::Primitive &PrimitiveLattice::closest(double x, double y, double psi,
+                                                             const std::deque<geometry_msgs::Point> &waypoints) const {
+    const size_t b = bin(psi);
+    const Primitive *best = begin(b);
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (const Primitive *p = begin(b); p != end(b); ++p) {
+        double cost = 0;
+        for (size_t k = 1; k < problem.N; ++k) {
+            double xk, yk, psik;
+            place(*p, k, x, y, psi, xk, yk, psik);
+            const geometry_msgs::Point &wp = waypoints[std::min(k, waypoints.size() - 1)];
+            cost += (k + 1) * (problem.x_weight * (xk - wp.x) * (xk - wp.x) + problem.y_weight * (yk - wp.y) * (yk - wp.y));
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = p;
+        }
+    }
+    return *best;
+}
@@ -0,0 +1,271 @@
+#include "RRTStar.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+const double INF = std::numeric_limits<double>::infinity();
+}
+
+RRTStar::RRTStar(const RRTParams &params) : params(params), has_goal(false), last_cost(INF), rng(std::random_device()()) {}
+
+void RRTStar::reset() {
+    nodes.clear();
+    index.clear();
+    last_cost = INF;
+}
+
+void RRTStar::setGoal(double x, double y) {
+    if (has_goal && std::hypot(x - nodes[0].x, y - nodes[0].y) <= params.goal_tolerance) {
+        return;
+    }
+    reset();
+    Node root = {x, y, 0.0, -1, std::vector<int>()};
+    nodes.push_back(root);
+    index.insert(x, y, 0);
+    has_goal = true;
+}
+
+void RRTStar::setMap(const OccupancyBits &map) {
+    grid = map;
+    if (has_goal) {
+        compact(0.0, 0.0, INF);
+    }
+    last_cost = INF;
+}
+
+void RRTStar::compact(double sx, double sy, double c_best) {
+    // Keep what is still reachable from the goal over free edges, renumbered in the order it is found
+    std::vector<Node> kept;
+    std::vector<int> id(nodes.size(), -1);
+    stack.assign(1, 0);
+    while (!stack.empty()) {
+        const int n = stack.back();
+        stack.pop_back();
+        id[n] = static_cast<int>(kept.size());
+        Node node = nodes[n];
+        node.parent = node.parent < 0 ? -1 : id[node.parent];
+        node.children.clear();
+        kept.push_back(node);
+        for (int c : nodes[n].children) {
+            const Node &child = nodes[c];
+            if (child.cost + std::hypot(sx - child.x, sy - child.y) <= c_best + 1e-6 &&
+                grid.free(child.x, child.y, nodes[n].x, nodes[n].y)) {
+                stack.push_back(c);
+            }
+        }
+    }
+    nodes.swap(kept);
+    index.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].parent >= 0) {
+            nodes[nodes[i].parent].children.push_back(static_cast<int>(i));
+        }
+        index.insert(nodes[i].x, nodes[i].y, static_cast<int>(i));
+    }
+}
+
+void RRTStar::restart(int via) {
+    std::vector<Node> path;
+    for (int n = via; n >= 0; n = nodes[n].parent) {
+        path.push_back(nodes[n]);
+    }
+    if (path.empty()) {
+        path.push_back(nodes[0]);
+    }
+    nodes.assign(path.rbegin(), path.rend());
+    index.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].parent = static_cast<int>(i) - 1;
+        nodes[i].children.clear();
+        if (i + 1 < nodes.size()) {
+            nodes[i].children.push_back(static_cast<int>(i) + 1);
+        }
+        index.insert(nodes[i].x, nodes[i].y, static_cast<int>(i));
+    }
+}
+
+bool RRTStar::plan(double x, double y, double budget, std::vector<geometry_msgs::Point> &path) {
+    path.clear();
+    if (!has_goal || grid.empty()) {
+        return false;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(budget);
+    double c_best = INF;
+    int via = connect(x, y, c_best);
+    for (int k = 1; std::chrono::steady_clock::now() < deadline; ++k) {
+        if (nodes.size() >= params.max_nodes) {
+            // Make room by dropping the nodes that cannot be on a path shorter than the one there is. If
+            // that is all of them the tree starts over from that path alone, or from the goal if the tree
+            // does not reach the car
+            if (via >= 0) {
+                compact(x, y, c_best);
+                via = connect(x, y, c_best);
+            }
+            if (nodes.size() >= params.max_nodes) {
+                restart(via);
+                via = connect(x, y, c_best);
+            }
+        }
+        grow(x, y, c_best);
+        // Rewiring keeps lowering costs near the car, look for a better connection now and then
+        if (k % 32 == 0) {
+            via = connect(x, y, c_best);
+        }
+    }
+    via = connect(x, y, c_best);
+    if (via < 0) {
+        last_cost = INF;
+        return false;
+    }
+
+    geometry_msgs::Point p;
+    p.x = x;
+    p.y = y;
+    path.push_back(p);
+    for (int n = via; n >= 0; n = nodes[n].parent) {
+        p.x = nodes[n].x;
+        p.y = nodes[n].y;
+        path.push_back(p);
+    }
+    shortcut(path);
+    last_cost = c_best;
+    return true;
+}
+
+void RRTStar::shortcut(std::vector<geometry_msgs::Point> &path) const {
+    // Each point is followed by the furthest one it sees, the rest of the zigzag between them goes
+    size_t kept = 0;
+    for (size_t i = 0; i + 1 < path.size();) {
+        size_t j = path.size() - 1;
+        while (j > i + 1 && !grid.free(path[i].x, path[i].y, path[j].x, path[j].y)) {
+            --j;
+        }
+        path[++kept] = path[j];
+        i = j;
+    }
+    path.resize(std::min(path.size(), kept + 1));
+}
+
+double RRTStar::cost() const {
+    return last_cost;
+}
+
+size_t RRTStar::size() const {
+    return nodes.size();
+}
+
+double RRTStar::radius() const {
+    const double n = static_cast<double>(nodes.size() + 1);
+    return std::min(params.step, params.gamma * std::sqrt(std::log(n) / n));
+}
+
+void RRTStar::sample(double sx, double sy, double c_best, double &x, double &y) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    if (unit(rng) < params.start_bias) {
+        x = sx;
+        y = sy;
+        return;
+    }
+    const double gx = nodes[0].x, gy = nodes[0].y;
+    const double c_min = std::hypot(sx - gx, sy - gy);
+    if (c_best < INF && c_best > c_min) {
+        // Uniform in the ellipse with foci car and goal whose points are c_best from both together
+        const double a = 0.5 * c_best, b = 0.5 * std::sqrt(c_best * c_best - c_min * c_min);
+        const double r = std::sqrt(unit(rng)), t = 2.0 * M_PI * unit(rng);
+        const double ex = a * r * std::cos(t), ey = b * r * std::sin(t);
+        const double c = c_min > 0.0 ? (gx - sx) / c_min : 1.0, s = c_min > 0.0 ? (gy - sy) / c_min : 0.0;
+        x = 0.5 * (sx + gx) + c * ex - s * ey;
+        y = 0.5 * (sy + gy) + s * ex + c * ey;
+        return;
+    }
+    x = grid.min_x() + unit(rng) * (grid.max_x() - grid.min_x());
+    y = grid.min_y() + unit(rng) * (grid.max_y() - grid.min_y());
+}
+
+void RRTStar::grow(double sx, double sy, double c_best) {
+    double x, y;
+    sample(sx, sy, c_best, x, y);
+
+    // Steer from the nearest node at most one step towards the sample
+    const int nn = index.nearest(x, y);
+    const double d = std::hypot(x - nodes[nn].x, y - nodes[nn].y);
+    if (d < 1e-6) {
+        return;
+    }
+    if (d > params.step) {
+        x = nodes[nn].x + (x - nodes[nn].x) * params.step / d;
+        y = nodes[nn].y + (y - nodes[nn].y) * params.step / d;
+    }
+    if (grid.blocked(x, y)) {
+        return;
+    }
+
+    // Cheapest free parent among the nodes around, the nearest one included
+    index.within(x, y, radius(), near);
+    if (std::find(near.begin(), near.end(), nn) == near.end()) {
+        near.push_back(nn);
+    }
+    int parent = -1;
+    double cost = INF;
+    for (int n : near) {
+        const double c = nodes[n].cost + std::hypot(x - nodes[n].x, y - nodes[n].y);
+        if (c < cost && grid.free(nodes[n].x, nodes[n].y, x, y)) {
+            parent = n;
+            cost = c;
+        }
+    }
+    if (parent < 0) {
+        return;
+    }
+
+    const int added = static_cast<int>(nodes.size());
+    Node node = {x, y, cost, parent, std::vector<int>()};
+    nodes.push_back(node);
+    nodes[parent].children.push_back(added);
+    index.insert(x, y, added);
+
+    // Rewire the neighbours that are closer to the goal through the new node
+    for (int n : near) {
+        if (n == parent) {
+            continue;
+        }
+        const double c = cost + std::hypot(x - nodes[n].x, y - nodes[n].y);
+        if (c < nodes[n].cost && grid.free(x, y, nodes[n].x, nodes[n].y)) {
+            reparent(n, added, c);
+        }
+    }
+}
+
+int RRTStar::connect(double x, double y, double &total) {
+    index.within(x, y, params.step, near);
+    int best = -1;
+    total = INF;
+    for (int n : near) {
+        const double c = nodes[n].cost + std::hypot(x - nodes[n].x, y - nodes[n].y);
+        if (c < total && grid.free(x, y, nodes[n].x, nodes[n].y)) {
+            best = n;
+            total = c;
+        }
+    }
+    return best;
+}
+
+void RRTStar::reparent(int n, int parent, double cost) {
+    std::vector<int> &siblings = nodes[nodes[n].parent].children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), n));
+    nodes[n].parent = parent;
+    nodes[parent].children.push_back(n);
+
+    // The whole subtree gets closer to the goal by the same amount
+    const double delta = cost - nodes[n].cost;
+    stack.assign(1, n);
+    while (!stack.empty()) {
+        const int m = stack.back();
+        stack.pop_back();
+        nodes[m].cost += delta;
+        stack.insert(stack.end(), nodes[m].children.begin(), nodes[m].children.end());
+    }
+}
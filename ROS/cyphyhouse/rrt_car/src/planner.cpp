@@ -0,0 +1,176 @@
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "RRTStar.h"
+#include "OccupancyBits.h"
+#include "cyphy_control/LatestBuffer.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "ros/ros.h"
+#include "geometry_msgs/PoseStamped.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "nav_msgs/Path.h"
+
+#define PLAN_RATE 10.0 //Hz, the rate of the MPC
+
+std::string vicon_obj;
+
+ros::Publisher path_pub;
+
+geometry_msgs::Point vicon_position;
+
+// Obstacles and goal from the callbacks, picked up by plan at its next tick
+LatestBuffer<OccupancyBits> new_map;
+LatestBuffer<geometry_msgs::Point> new_goal;
+
+// Occupancy at or above threshold [%] blocks a cell, obstacles grow by inflation [m], the car's radius
+int threshold;
+double inflation;
+bool unknown_free;
+
+std::thread plan_thread;
+
+void getViconPosition(const geometry_msgs::PoseStamped& pose)
+{
+    vicon_position = pose.pose.position;
+}
+
+void getMap(const nav_msgs::OccupancyGrid& grid)
+{
+    OccupancyBits bits;
+    bits.assign(grid, threshold, inflation, unknown_free);
+    new_map.write(bits);
+}
+
+void getGoal(const geometry_msgs::PoseStamped& goal)
+{
+    new_goal.write(goal.pose.position);
+}
+
+double pathLength(const std::vector<geometry_msgs::Point>& path)
+{
+    double length = 0;
+    for (size_t i = 1; i < path.size(); ++i)
+    {
+        length += std::hypot(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+    }
+    return length;
+}
+
+// Sends the path in one message, getPath of the waypoint node swaps it in whole
+void publishPath(const std::vector<geometry_msgs::Point>& path)
+{
+    nav_msgs::PathPtr msg(new nav_msgs::Path);
+    msg->header.stamp = ros::Time::now();
+    msg->header.frame_id = "world";
+    msg->poses.resize(path.size());
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        msg->poses[i].header = msg->header;
+        msg->poses[i].pose.position = path[i];
+        msg->poses[i].pose.orientation.w = 1;
+    }
+    path_pub.publish(msg);
+}
+
+// Grows the tree for most of each period and sends the path when the one being driven got blocked
+// or a shorter one turned up
+void plan()
+{
+    RRTParams params;
+    ros::param::param<double>("~step", params.step, params.step);
+    ros::param::param<double>("~gamma", params.gamma, params.gamma);
+    ros::param::param<double>("~start_bias", params.start_bias, params.start_bias);
+    int max_nodes;
+    ros::param::param<int>("~max_nodes", max_nodes, params.max_nodes);
+    params.max_nodes = std::max(max_nodes, 2);
+    // Share of the period spent growing the tree, a replan needs a path shorter by replan_gain to be sent
+    double budget, replan_gain, goal_radius;
+    ros::param::param<double>("~budget", budget, 0.7);
+    ros::param::param<double>("~replan_gain", replan_gain, 0.05);
+    ros::param::param<double>("~goal_radius", goal_radius, 0.25);
+
+    RRTStar rrt(params);
+    OccupancyBits map;
+    geometry_msgs::Point goal;
+    bool has_goal = false;
+    std::vector<geometry_msgs::Point> path, sent;
+
+    PeriodicLoop r(1.0 / PLAN_RATE);
+    while(ros::ok())
+    {
+        bool changed = false;
+        if (new_map.read(map))
+        {
+            rrt.setMap(map);
+            changed = true;
+        }
+        if (new_goal.read(goal))
+        {
+            rrt.setGoal(goal.x, goal.y);
+            has_goal = true;
+            sent.clear();
+        }
+
+        const geometry_msgs::Point car = vicon_position;
+        if (has_goal && std::hypot(car.x - goal.x, car.y - goal.y) < goal_radius)
+        {
+            // The waypoint node stops there by itself
+            has_goal = false;
+        }
+
+        if (has_goal && rrt.plan(car.x, car.y, budget / PLAN_RATE, path))
+        {
+            // What is left of the path being driven, from the car
+            bool blocked = sent.empty();
+            double left = 0;
+            if (!sent.empty())
+            {
+                std::vector<geometry_msgs::Point> rest(sent.begin() + 1, sent.end());
+                rest.insert(rest.begin(), car);
+                left = pathLength(rest);
+                for (size_t i = 1; changed && !blocked && i < rest.size(); ++i)
+                {
+                    blocked = !map.free(rest[i - 1].x, rest[i - 1].y, rest[i].x, rest[i].y);
+                }
+            }
+            if (blocked || pathLength(path) < (1 - replan_gain) * left)
+            {
+                publishPath(path);
+                sent = path;
+                ROS_INFO("RRT* path of %zu points, %f m, %zu nodes", path.size(), pathLength(path), rrt.size());
+            }
+        }
+        r.sleep();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "planner");
+    ros::NodeHandle n("~");
+
+    n.param<std::string>("vicon_obj", vicon_obj, "hotdec_car");
+    n.param<int>("threshold", threshold, 50);
+    n.param<double>("inflation", inflation, 0.25);
+    n.param<bool>("unknown_free", unknown_free, false);
+
+    std::cout << "Vicon Object: " << vicon_obj << std::endl;
+
+    // Whole paths go out at once, only the latest one matters
+    path_pub = n.advertise<nav_msgs::Path>("path", 1);
+
+    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+    ros::Subscriber map_sub = n.subscribe("/map", 1, getMap);
+    ros::Subscriber goal_sub = n.subscribe("goal", 1, getGoal);
+
+    std::cout << "Starting RRT* planner" << std::endl;
+
+    plan_thread = std::thread(plan);
+
+    ros::spin();
+
+    plan_thread.join();
+
+    return 0;
+}
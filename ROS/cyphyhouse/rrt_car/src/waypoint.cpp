@@ -2,69 +2,191 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <memory>
 #include <ctime>
 #include <cstdbool>
 #include <fstream>
 #include <deque>
+#include <algorithm>
+#include <atomic>
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Geometry>
 #include "MPC.h"
+#include "cyphy_control/AsyncLog.h"
+#include "cyphy_control/FixedRatePid.h"
+#include "cyphy_control/LatestBuffer.h"
+#include "cyphy_control/RealtimeThread.h"
+#include "cyphy_control/Snapshot.h"
+#include "cyphy_control/SPSCQueue.h"
+#include "cyphy_control/TrajectoryRecorder.h"
+#include "PathPreview.h"
+#include "Primitives.h"
 #include "ros/ros.h"
+#include <std_msgs/Float32MultiArray.h>
 #include <std_msgs/String.h>
 #include "geometry_msgs/PoseStamped.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "nav_msgs/Path.h"
 #include "geometry_msgs/PointStamped.h"
+#include "geometry_msgs/PolygonStamped.h"
 #include "geometry_msgs/TwistStamped.h"
 #include <ackermann_msgs/AckermannDriveStamped.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include "ros/package.h"
 #include <chrono>
 
 #define WP_RATE 10.0 //Hz
-#define PRINT_RATE 50.0 //Hz
 
 #define DELTA_DIRECTION  0.01
 #define DELTA_SPEED      0.25
 #define EPSILON_RADIUS   0.25
 #define EPSILON_ANGLE    0.1
 
-bool isDriving = false;
-bool gotWP = false;
+#define WP_QUEUE_SIZE 256 // Must be a power of two
+
+#define NEIGHBOUR_FIELDS 7 // index, x, y, z, distance, vx, vy of the fleet node
+#define PREDICTION_POINTS 10 // points of a shared trajectory, as the fleet node relays them
+#define PREDICTION_FIELDS (2 + 3 * PREDICTION_POINTS) // index, age, then x, y, t of each point
+
+std::atomic<bool> isDriving(false);
+std::atomic<bool> gotWP(false);
+// Commands of drive_cmd, it owns them
 double speed = 0, direction = 0;
 geometry_msgs::Point curr_loc;
 double curr_ang = 0;
 
 std::string bot_num, vicon_obj;
+// A waypoint as getWP received it, last if it is the final point of its path
+struct QueuedWaypoint
+{
+    geometry_msgs::Point point;
+    bool last;
+};
+
+// Waypoints from getWP to drive, which owns the path being received and starts on it once its final point is in
+SPSCQueue<QueuedWaypoint, WP_QUEUE_SIZE> wp_queue;
+
+// Paths from getPath to drive, a newer one replaces one drive has not taken yet
+LatestBuffer<nav_msgs::PathConstPtr> new_path;
 std::deque<geometry_msgs::Point> waypoints;
 
 ros::Publisher drive_pub;
 ros::Publisher reached_pub;
+ros::Publisher diagnostics_pub;
+ros::Publisher prediction_pub;
 
-geometry_msgs::Point vicon_position;
+// Log of the solver and the command loop, printed and written by the background thread of async_log
+LogChannel solve_log("solve"), cmd_log("drive_cmd");
+
+// Telemetry of the solves, recorded by the solver and published by publishDiagnostics
+SolveStats solve_stats;
+SolveWindow solve_window;
+double solve_deadline;
+
+// Wake-up jitter of the drive and the command loop, warns once it exceeds jitter_limit [s]. The loops wake
+// drive_phase and cmd_phase [s] into their periods, see PeriodicLoop
+LoopJitter drive_jitter(1.0 / WP_RATE);
+std::unique_ptr<LoopJitter> cmd_jitter;
+double jitter_limit, drive_phase, cmd_phase;
+
+// Latest VICON pose, written by getViconPosition and read by every thread
+Snapshot<geometry_msgs::Pose> vicon_pose;
+
+// Forward speed of the car EKF (the cyphy_car estimator) and the time it is of
+struct SpeedEstimate
+{
+    double speed;
+    ros::Time stamp;
+};
+
+// Latest speed of the EKF, written by getSpeed and read by drive_cmd
+Snapshot<SpeedEstimate> speed_estimate;
 geometry_msgs::Point current_waypoint;  // VICON coords
-geometry_msgs::Quaternion quat; //Get orientation
-geometry_msgs::Vector3 vicon_vel;
+
+// Trajectory of the drive, recorded by getViconPosition while driving if record_trajectory is set
+std::unique_ptr<TrajectoryRecorder> trajectory;
 
 std::string dir_path;
 char time_buffer[80];
-std::thread drive_thread, print_thread, cmd_thread;
+std::thread drive_thread, solve_thread, cmd_thread;
 ros::Time wp_time;
 
 Eigen::Vector3d state;
 
-Eigen::Quaterniond quat_eig;
-Eigen::Vector3d vel_eig, vel_tf;
-double vel_error_int = 0, vel_error_deriv = 0;
-const double Kp = 2.0, Ki = 5.0; Kd = 0.1;
+// Horizon and timestep of the MPC, and the speed [m/s] its reference moves along the path at
+MpcProblem problem;
+double ref_speed;
+// Arc length of the reference of each step ahead of the car, ref_speed times the time to the step [m]
+std::vector<double> ref_offsets;
+// Reference of the path, drive owns it
+PathPreview preview;
+
+// State snapshot of the control loop for the solver thread, stamped when it was taken
+struct SolverInput
+{
+    ros::Time stamp;
+    Eigen::VectorXd state;
+    std::deque<geometry_msgs::Point> waypoints;
+};
+
+// Predicted controls of one solve, stamped with the time of the state it started from
+struct ControlPlan
+{
+    ros::Time stamp;
+    std::vector<double> time;   // of each control after the stamp [s]
+    std::vector<double> direction;
+    std::vector<double> speed;
+};
+
+LatestBuffer<SolverInput> solver_input;
+LatestBuffer<ControlPlan> control_plan;
+
+// The other robots nearest to this one as the fleet node last reported them, their indices in the fleet, and when
+struct NeighbourSet
+{
+    ros::Time stamp;
+    std::vector<OtherRobot> robots;
+    std::vector<uint32_t> index;
+};
+
+// Trajectories the neighbours predicted for themselves, as relayed by the fleet node: robot, the time each starts
+// at, then PREDICTION_POINTS x, y and t [s] after that for each
+struct PredictionSet
+{
+    std::vector<uint32_t> index;
+    std::vector<ros::Time> stamp;
+    std::vector<float> points;
+};
+
+// Distance field of the latest map from getMap and the latest neighbours from getNeighbours, for solve. Occupancy
+// at or above map_threshold [%] is an obstacle, unknown cells too unless unknown_free. Neighbours older than
+// neighbour_timeout [s] are ignored
+LatestBuffer<std::shared_ptr<const DistanceField> > new_field;
+LatestBuffer<NeighbourSet> new_neighbours;
+LatestBuffer<PredictionSet> new_predictions;
+int map_threshold;
+bool unknown_free;
+double neighbour_timeout;
+
+// Rate [Hz] and gains of the speed loop, and the age [s] of the speed estimate it stops the car at
+double cmd_rate, vel_kp, vel_ki, vel_kd, speed_timeout;
 const double vel_bound = 4.0;
 
 void getViconPosition(const geometry_msgs::PoseStamped& pose)
 {
-    vicon_position = pose.pose.position;
-    quat = pose.pose.orientation;
+    vicon_pose.store(pose.pose);
+    if (trajectory && isDriving)
+    {
+        trajectory->record(ros::Time::now().toNSec(), pose.pose.position.x, pose.pose.position.y, pose.pose.position.z);
+    }
 }
 
-void getViconVel(const geometry_msgs::TwistStamped& data)
+void getSpeed(const geometry_msgs::TwistStamped& data)
 {
-    vicon_vel = data.twist.linear;
+    SpeedEstimate estimate;
+    estimate.speed = data.twist.linear.x;
+    estimate.stamp = data.header.stamp;
+    speed_estimate.store(estimate);
 }
 
 inline double goalDist(const geometry_msgs::Point pos, const geometry_msgs::Point goal)
@@ -72,19 +194,189 @@ inline double goalDist(const geometry_msgs::Point pos, const geometry_msgs::Poin
     return sqrt(pow(pos.x - goal.x, 2) + pow(pos.y - goal.y, 2));
 }
 
-void drive()
+// Control of the plan at now, linear between its steps and held after the horizon
+void interpolate(const ControlPlan& plan, const ros::Time& now, double& dir_out, double& speed_out)
 {
-    ros::Rate r(WP_RATE);
+    const double t = fmax(0.0, (now - plan.stamp).toSec());
+    size_t k = 0;
+    while (k + 1 < plan.time.size() && plan.time[k + 1] <= t)
+    {
+        k++;
+    }
+    if (k + 1 >= plan.direction.size())
+    {
+        dir_out = plan.direction.back();
+        speed_out = plan.speed.back();
+        return;
+    }
+    const double f = (t - plan.time[k]) / (plan.time[k + 1] - plan.time[k]);
+    dir_out = (1 - f) * plan.direction[k] + f * plan.direction[k + 1];
+    speed_out = (1 - f) * plan.speed[k] + f * plan.speed[k + 1];
+}
 
-    MPC mpc;
+// The shared trajectories of the neighbours onto them, in time after stamp. A neighbour without one started less than
+// neighbour_timeout before stamp keeps being predicted at constant velocity
+void attachPredictions(const NeighbourSet& neighbours, const PredictionSet& predictions, const ros::Time& stamp,
+                       std::vector<OtherRobot>& others)
+{
+    for (size_t k = 0; k < others.size(); k++)
+    {
+        for (size_t j = 0; j < predictions.index.size(); j++)
+        {
+            const double shift = (predictions.stamp[j] - stamp).toSec();
+            if (predictions.index[j] != neighbours.index[k] || -shift >= neighbour_timeout)
+            {
+                continue;
+            }
+            const float* p = &predictions.points[3 * PREDICTION_POINTS * j];
+            for (size_t i = 0; i < PREDICTION_POINTS; i++)
+            {
+                others[k].px.push_back(p[3 * i]);
+                others[k].py.push_back(p[3 * i + 1]);
+                others[k].t.push_back(shift + p[3 * i + 2]);
+            }
+            break;
+        }
+    }
+}
 
+// Solves for each new snapshot of the control loop, so a slow solve never stretches the control period
+void solve()
+{
+    MPC mpc(problem);
+    ros::param::param<bool>("~warm_start", mpc.warm_start, true);
+    ros::param::param<double>("~warm_start_max_error", mpc.warm_start_max_error, 0.5);
+    ros::param::param<bool>("~rti", mpc.rti, false);
+    ros::param::param<bool>("~anytime", mpc.anytime, false);
+    // The solve ends this long [s] before the drive loop takes the plan
+    double deadline_margin;
+    ros::param::param<double>("~deadline_margin", deadline_margin, 0.005);
+    mpc.stats = &solve_stats;
+    // Cold starts from the closest constant steering and speed arc
+    PrimitiveLattice lattice(problem);
+    bool primitive_start;
+    ros::param::param<bool>("~primitive_start", primitive_start, true);
+    mpc.primitives = primitive_start ? &lattice : nullptr;
+
+    // Reused by every solve, which then allocates nothing of its own once they are sized
+    SolverInput input;
+    NeighbourSet neighbours;
+    PredictionSet predictions;
+    std::vector<OtherRobot> others;
+    MPC::Solution solution;
+    ControlPlan plan;
+    geometry_msgs::PolygonStamped shared;
+    std::vector<float> predicted;
     while(ros::ok())
     {
+        if (!solver_input.read(input))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Obstacles and robots to keep clear of, the constraints leave out what is not there
+        new_field.read(mpc.field);
+        new_neighbours.read(neighbours);
+        new_predictions.read(predictions);
+        const double age = (input.stamp - neighbours.stamp).toSec();
+        const bool fresh = !neighbours.stamp.isZero() && age < neighbour_timeout;
+        if (fresh)
+        {
+            others = neighbours.robots;
+            attachPredictions(neighbours, predictions, input.stamp, others);
+        }
+        else
+        {
+            others.clear();
+        }
+
+        // Done before the drive loop wakes up next, the snapshot was taken at its last wake-up
+        if (mpc.anytime)
+        {
+            mpc.deadline = PeriodicLoop::next_deadline(ros::WallTime::now().toSec(), 1.0 / WP_RATE, drive_phase) - deadline_margin;
+        }
+        mpc.Solve(input.state, input.waypoints, others, age, solution);
+        solve_log.info("MPC speed: %f, steering: %f", solution.v, solution.delta);
+
+        // What this car is going to do, for the MPCs of the others in the next round
+        if (prediction_pub && mpc.prediction(solution, input.state[0], input.state[1], PREDICTION_POINTS, predicted))
+        {
+            shared.header.stamp = input.stamp;
+            shared.polygon.points.resize(PREDICTION_POINTS);
+            for (size_t j = 0; j < PREDICTION_POINTS; j++)
+            {
+                shared.polygon.points[j].x = predicted[3 * j];
+                shared.polygon.points[j].y = predicted[3 * j + 1];
+                shared.polygon.points[j].z = predicted[3 * j + 2];
+            }
+            prediction_pub.publish(shared);
+        }
+
+        plan.stamp = input.stamp;
+        plan.direction = solution.delta_vals;
+        plan.time.resize(plan.direction.size());
+        for (size_t k = 0; k < plan.time.size(); k++)
+        {
+            plan.time[k] = mpc.time(k);
+        }
+        plan.speed = solution.v_vals;
+        control_plan.write(plan);
+    }
+}
+
+// Takes the waypoints getWP queued, a path starts where the car is and replaces the driven one once complete.
+// A path from getPath replaces it at once
+void receiveWaypoints()
+{
+    QueuedWaypoint wp;
+    while (wp_queue.pop(wp))
+    {
+        if (waypoints.size() == 0) waypoints.push_back(curr_loc);
+
+        waypoints.push_back(wp.point);
+
+        // wait until we get the final point
+        if (wp.last)
+        {
+            preview.reset(waypoints);
+            waypoints.clear();
+            current_waypoint = wp.point;
+            gotWP = true;
+            slow_time = ros::Time::now();
+        }
+    }
+
+    nav_msgs::PathConstPtr path;
+    if (new_path.read(path))
+    {
+        std::deque<geometry_msgs::Point> points(1, curr_loc);
+        for (size_t i = 0; i < path->poses.size(); i++)
+        {
+            points.push_back(path->poses[i].pose.position);
+        }
+        preview.reset(points);
+        waypoints.clear();
+        current_waypoint = points.back();
+        gotWP = true;
+        slow_time = ros::Time::now();
+    }
+}
+
+void drive()
+{
+    PeriodicLoop r(1.0 / WP_RATE, drive_phase, &drive_jitter);
 
-        curr_loc = vicon_position;
+    while(ros::ok())
+    {
+        const geometry_msgs::Pose pose = vicon_pose.load();
+        const geometry_msgs::Quaternion& quat = pose.orientation;
+        curr_loc = pose.position;
         curr_ang = atan2(2 * (quat.x * quat.y + quat.w * quat.z), pow(quat.w,2) + pow(quat.x,2) - pow(quat.y,2) - pow(quat.z,2));
         state << curr_loc.x, curr_loc.y, curr_ang;
 
+        receiveWaypoints();
+
         // Acknowledge that we reached the desired waypoint
         if (gotWP)
         {
@@ -100,31 +392,21 @@ void drive()
                 //ROS_INFO("Goal dist: %f", goalDist(curr_loc, current_waypoint));
                 // Stop moving
                 gotWP = false;
-                speed = 0;
-                direction = 0;
                 
-                waypoints.clear();
+                preview.clear();
             }
             else
             {
-                while (waypoints.size() < 10)
-                {
-                    // Pad vector with last element if smaller than 10
-                    // Last element should be equal to current_waypoint
-                    waypoints.push_back(waypoints.back());
-                }
-                
-                //auto tic = std::chrono::high_resolution_clock::now();
-                std::vector<double> solution = mpc.Solve(state, waypoints);
-                //auto toc = std::chrono::high_resolution_clock::now();
-                //auto duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic);
-                //std::cout << "MPC time: " << duration.count() / 1000000. << std::endl; //Time in seconds
-                
-                direction = solution.at(0);
-                speed = solution.at(1);
-                ROS_INFO("MPC speed: %f, steering: %f", speed, direction);
+                // A new path, from the planner's replans too, replaced the one being driven. Its reference
+                // advances with the car from then on
+                preview.advance(curr_loc);
                 
-                waypoints.pop_front(); //delete first element
+                //Hand the problem to the solver thread, drive_cmd applies its plan
+                SolverInput input;
+                input.stamp = ros::Time::now();
+                input.state = state;
+                input.waypoints = preview.sample(ref_offsets);
+                solver_input.write(input);
             }
         }
         r.sleep();
@@ -134,40 +416,54 @@ void drive()
 
 void drive_cmd()
 {   
-    ros::Rate r(100);
+    PeriodicLoop r(1.0 / cmd_rate, cmd_phase, cmd_jitter.get());
     
-    double vel_error = 0;
-    double prev_vel = 0;
+    FixedRatePid vel_pid(vel_kp, vel_ki, vel_kd, cmd_rate, vel_bound);
+    bool stale = false;
+    ControlPlan plan;
     
     while (ros::ok())
     {
-        quat_eig = Eigen::Quaterniond(quat.w, quat.x, quat.y, quat.z);
-        vel_eig << vicon_vel.x, vicon_vel.y, vicon_vel.z;
-        
-        vel_tf = vel_eig.rotate(quat_eig);
-        double car_vel = vel_tf(0);
-        
-        std::cout << "Original vel x: " << vel_eig(0) << ", y: " << vel_eig(1) << "; ";
-        std::cout << "Rotate vel x: " << vel_tf(0) << ", y: " << vel_tf(1) << std::endl;
-        
-        if (fabs(car_vel) < 0.001) car_vel = 0; //Vicon noise...
-        
-        vel_error = speed - car_vel;
-        vel_error_int += vel_error;
-        vel_error_int = fmax(fmin(vel_error_int, vel_bound), -vel_bound);
-        vel_error_deriv = 0.9 * vel_error + 0.1 * vel_error_deriv;
+        //Speed and steering of the latest plan at this tick
+        control_plan.read(plan);
+        if (!gotWP)
+        {
+            // Stop moving
+            speed = 0;
+            direction = 0;
+        }
+        else if (!plan.direction.empty())
+        {
+            interpolate(plan, ros::Time::now(), direction, speed);
+        }
         
-        double vel_cmd = Kp * vel_error + Ki * vel_error_int + Kd * vel_error_deriv;
-        vel_cmd = fmax(fmin(vel_cmd, vel_bound), -vel_bound);
+        // Close the loop on the filtered speed of the EKF, stop the car while it is not coming in
+        const SpeedEstimate estimate = speed_estimate.load();
+        const double age = (ros::Time::now() - estimate.stamp).toSec();
+        double vel_cmd = 0;
+        if (age > speed_timeout)
+        {
+            if (!stale)
+            {
+                cmd_log.warn("No speed estimate for %f s, stopping", age);
+            }
+            stale = true;
+            vel_pid.reset();
+        }
+        else
+        {
+            stale = false;
+            vel_cmd = vel_pid.update(speed, estimate.speed);
+        }
         
         ackermann_msgs::AckermannDriveStamped drive_msg;
         drive_msg.drive.speed = vel_cmd;
         drive_msg.drive.steering_angle = direction;
         drive_pub.publish(drive_msg);
         
-        ROS_INFO("Vicon Speed: %f, Ackermann speed: %f", car_vel, vel_cmd);
+        cmd_log.info("EKF speed: %f, Ackermann speed: %f", estimate.speed, vel_cmd);
         
-        r.sleep()
+        r.sleep();
     }
     
     ackermann_msgs::AckermannDriveStamped drive_msg;
@@ -176,52 +472,98 @@ void drive_cmd()
     drive_pub.publish(drive_msg);
 }
 
-void printToFile()
+void getWP(const geometry_msgs::PoseStamped& stamped_point)
 {
-    std::ofstream positionFile;
-    positionFile.open (dir_path+"/posData_"+time_buffer+".txt", std::ios::app);
+    QueuedWaypoint wp;
+    wp.point = stamped_point.pose.position;
+    wp.last = stamped_point.header.frame_id == "1";
+    if (!wp_queue.push(wp))
+    {
+        ROS_WARN("Waypoint queue full, dropped x: %f, y: %f", wp.point.x, wp.point.y);
+    }
+    std::cout << "Got Point x: " << wp.point.x << ", y: " << wp.point.y << std::endl;
 
-    // Sleep and don't print anything while we are not flying
-    while(ros::ok() && !isDriving)
+    if(!isDriving)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        isDriving = true;
     }
+}
 
-    // Once we send the takeoff command, start printing
-    ros::Rate printrate(PRINT_RATE);
-    ros::Time time_start = ros::Time::now();
-    while(ros::ok() && isDriving)
+// A whole path in one message, drive swaps it in for the waypoints left at once
+void getPath(const nav_msgs::PathConstPtr& path)
+{
+    if (path->poses.empty())
     {
-        ros::Duration time_since_start = ros::Time::now() - time_start;
-        positionFile << time_since_start.toNSec() / 1000 << ", "; //Print time in useconds
-        positionFile << vicon_position.x << ", " << vicon_position.y << ", " << vicon_position.z << "\r\n ";
+        ROS_WARN("Empty path ignored");
+        return;
+    }
+    new_path.write(path);
 
-        printrate.sleep();
+    if(!isDriving)
+    {
+        isDriving = true;
     }
-    positionFile.close();
 }
 
-void getWP(const geometry_msgs::PoseStamped& stamped_point)
+// Signed distance field of a new map, computed here once so a solve only reads it
+void getMap(const nav_msgs::OccupancyGrid& grid)
 {
-    geometry_msgs::Point point = stamped_point.pose.position;
-    
-    if (waypoints.size() == 0) waypoints.push_back(vicon_position);
+    std::vector<uint8_t> occupied(grid.data.size());
+    for (size_t i = 0; i < grid.data.size(); i++)
+    {
+        occupied[i] = grid.data[i] >= map_threshold || (grid.data[i] < 0 && !unknown_free);
+    }
+    new_field.write(std::make_shared<const DistanceField>(grid.info.origin.position.x, grid.info.origin.position.y,
+                                                          grid.info.resolution, grid.info.width, grid.info.height,
+                                                          occupied));
+}
 
-    waypoints.push_back(point);
-    std::cout << "Got Point x: " << point.x << ", y: " << point.y << std::endl;
+// Neighbours from the fleet node, nearest first
+void getNeighbours(const std_msgs::Float32MultiArray& msg)
+{
+    NeighbourSet set;
+    set.stamp = ros::Time::now();
+    for (size_t k = 0; k + NEIGHBOUR_FIELDS <= msg.data.size() && set.robots.size() < problem.avoid_robots;
+         k += NEIGHBOUR_FIELDS)
+    {
+        OtherRobot other;
+        other.x = msg.data[k + 1];
+        other.y = msg.data[k + 2];
+        other.vx = msg.data[k + 5];
+        other.vy = msg.data[k + 6];
+        set.robots.push_back(other);
+        set.index.push_back(static_cast<uint32_t>(msg.data[k]));
+    }
+    new_neighbours.write(set);
+}
 
-    // wait until we get the final point
-    if(stamped_point.header.frame_id == "1")
+// Trajectories of the neighbours from the fleet node, one row of PREDICTION_FIELDS each
+void getPredictions(const std_msgs::Float32MultiArray& msg)
+{
+    PredictionSet set;
+    const ros::Time now = ros::Time::now();
+    for (size_t k = 0; k + PREDICTION_FIELDS <= msg.data.size(); k += PREDICTION_FIELDS)
     {
-        current_waypoint = point;
-        gotWP = true;
-        slow_time = ros::Time::now();
+        set.index.push_back(static_cast<uint32_t>(msg.data[k]));
+        set.stamp.push_back(now - ros::Duration(msg.data[k + 1]));
+        set.points.insert(set.points.end(), msg.data.begin() + k + 2, msg.data.begin() + k + PREDICTION_FIELDS);
     }
+    new_predictions.write(set);
+}
 
-    if(!isDriving)
+void publishDiagnostics(const ros::TimerEvent&)
+{
+    solve_window.drain(solve_stats, solve_deadline);
+    diagnostic_msgs::DiagnosticArray msg;
+    msg.header.stamp = ros::Time::now();
+    msg.status.push_back(solve_window.status(ros::this_node::getName() + ": MPC solve", solve_deadline,
+                                             solve_stats.dropped));
+    msg.status.push_back(drive_jitter.status(ros::this_node::getName() + ": drive loop", jitter_limit));
+    if (cmd_jitter)
     {
-        isDriving = true;
+        msg.status.push_back(cmd_jitter->status(ros::this_node::getName() + ": command loop", jitter_limit));
     }
+    diagnostics_pub.publish(msg);
 }
 
 int main(int argc, char **argv)
@@ -232,14 +574,85 @@ int main(int argc, char **argv)
 
     n.param<std::string>("vicon_obj", vicon_obj, "hotdec_car");
 
+    // Horizon of the MPC and the arc length between its reference points, dt * ref_speed. Steps growing by
+    // dt_growth look further ahead with as many steps, e.g. 1.2 for 2 s over 10 steps from dt 0.1
+    int horizon;
+    n.param<int>("horizon", horizon, problem.N);
+    problem.N = std::max(horizon, 3);
+    n.param<double>("dt", problem.dt, problem.dt);
+    n.param<double>("dt_growth", problem.dt_growth, problem.dt_growth);
+    problem.dt_growth = std::max(problem.dt_growth, 0.5);
+    n.param<double>("ref_speed", ref_speed, 1.0);
+    for (size_t k = 0; k < problem.N; k++)
+    {
+        ref_offsets.push_back(problem.time(k) * ref_speed);
+    }
+
+    // Steps the MPC holds each of its controls over, e.g. [1, 1, 2, 2, 4], for a longer horizon at the same cost
+    std::vector<int> move_blocks;
+    n.param("move_blocks", move_blocks, std::vector<int>());
+    if (move_blocks.size() > CarProblem::MAX_BLOCKS)
+    {
+        ROS_WARN("Only the first %zu move blocks are used", CarProblem::MAX_BLOCKS);
+    }
+    for (size_t i = 0; i < move_blocks.size() && i < CarProblem::MAX_BLOCKS; i++)
+    {
+        problem.move_blocks[i] = std::max(move_blocks[i], 0);
+    }
+
+    // Collision constraints of the MPC: the obstacles of map, and the avoid_robots nearest robots the fleet node
+    // publishes on neighbours
+    int avoid_robots;
+    n.param<bool>("avoid_obstacles", problem.avoid_obstacles, false);
+    n.param<double>("obstacle_margin", problem.obstacle_margin, problem.obstacle_margin);
+    n.param<int>("map_threshold", map_threshold, 50);
+    n.param<bool>("unknown_free", unknown_free, false);
+    n.param<int>("avoid_robots", avoid_robots, 0);
+    problem.avoid_robots = std::max(avoid_robots, 0);
+    n.param<double>("robot_distance", problem.robot_distance, problem.robot_distance);
+    n.param<double>("neighbour_timeout", neighbour_timeout, 0.5);
+    // The trajectory of every solve on prediction, for the fleet node to relay to the robots around
+    bool share_prediction;
+    n.param<bool>("share_prediction", share_prediction, false);
+
     std::cout << "Vicon Object: " << vicon_obj << std::endl;
 
     reached_pub = n.advertise<std_msgs::String>("reached", 1);
+    if (share_prediction)
+    {
+        prediction_pub = n.advertise<geometry_msgs::PolygonStamped>("prediction", 1);
+    }
     drive_pub = n.advertise<ackermann_msgs::AckermannDriveStamped>("/ackermann_cmd", 1);
 
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
-    ros::Subscriber sub = n.subscribe("/vrpn_client_node/"+vicon_obj+"/twist", 1, getViconVel);
+    // Solve time, iterations and status percentiles once a second, solves longer than solve_deadline count as misses
+    n.param<double>("solve_deadline", solve_deadline, 0.099);
+    diagnostics_pub = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    n.param<double>("jitter_limit", jitter_limit, 0.002);
+    n.param<double>("drive_phase", drive_phase, 0.0);
+    n.param<double>("cmd_phase", cmd_phase, 0.0);
+    ros::Timer diagnostics_timer = n.createTimer(ros::Duration(1.0), publishDiagnostics);
+
+    // Speed loop at cmd_rate, closed on the speed the car EKF publishes on speed_topic
+    std::string speed_topic;
+    n.param<double>("cmd_rate", cmd_rate, 200.0);
+    n.param<double>("vel_kp", vel_kp, 2.0);
+    n.param<double>("vel_ki", vel_ki, 5.0);
+    n.param<double>("vel_kd", vel_kd, 0.1);
+    n.param<double>("speed_timeout", speed_timeout, 0.1);
+    n.param<std::string>("speed_topic", speed_topic, "/carVel");
+
     ros::Subscriber waypoint = n.subscribe("waypoint", 50, getWP);  // second parameter is num of buffered messages
+    ros::Subscriber path_sub = n.subscribe("path", 1, getPath);
+    ros::Subscriber map_sub, neighbours_sub, predictions_sub;
+    if (problem.avoid_obstacles)
+    {
+        map_sub = n.subscribe("/map", 1, getMap);
+    }
+    if (problem.avoid_robots > 0)
+    {
+        neighbours_sub = n.subscribe("neighbours", 1, getNeighbours);
+        predictions_sub = n.subscribe("neighbour_predictions", 1, getPredictions);
+    }
 
     dir_path = ros::package::getPath("rrt_car");
 
@@ -250,17 +663,48 @@ int main(int argc, char **argv)
     timeinfo = localtime(&rawtime);
     strftime(time_buffer, 80, "%G%m%dT%H%M%S", timeinfo);
 
+    // Every pose while driving, see TrajectoryRecorder
+    bool record_trajectory, compress_trajectory;
+    n.param<bool>("record_trajectory", record_trajectory, false);
+    n.param<bool>("compress_trajectory", compress_trajectory, true);
+    if (record_trajectory)
+    {
+        const std::string ext = compress_trajectory ? ".traj.gz" : ".traj";
+        trajectory.reset(new TrajectoryRecorder(dir_path+"/posData_"+time_buffer+ext, "rrt_car/waypoint",
+                                                {"vicon_x", "vicon_y", "vicon_z"}, compress_trajectory));
+    }
+
+    // Lines of the control loops at most once per log_throttle [s] each, and all of them to log_file if set
+    double log_throttle;
+    std::string log_file;
+    n.param<double>("log_throttle", log_throttle, 1.0);
+    n.param<std::string>("log_file", log_file, "");
+    async_log::start(log_throttle, log_file);
+
     std::cout << "Starting waypoint follower" << std::endl;
 
-    drive_thread = std::thread(drive);
-    cmd_thread = std::thread(drive_cmd);
-    //print_thread = std::thread(printToFile);
+    // Pose and speed on a queue and thread of their own (sensor_priority, sensor_cpus), so they never wait behind the
+    // waypoint, path and map callbacks of ros::spin
+    CallbackThread sensors(n, "sensor");
+    ros::Subscriber sub = sensors.node().subscribe("/vrpn_client_node/"+vicon_obj+"/pose", 1, getViconPosition);
+    ros::Subscriber speed_sub = sensors.node().subscribe(speed_topic, 1, getSpeed);
+
+    // SCHED_FIFO priority and CPUs of the threads, see RealtimeThread.h. The command loop is the one to keep on time,
+    // the solver should stay below it
+    lock_memory(n);
+    cmd_jitter.reset(new LoopJitter(1.0 / cmd_rate));
+    drive_thread = start_thread("drive", load_thread_config(n, "drive"), drive);
+    solve_thread = start_thread("solve", load_thread_config(n, "solve"), solve);
+    cmd_thread = start_thread("cmd", load_thread_config(n, "cmd"), drive_cmd);
 
     ros::spin();
 
+    sensors.stop();
     drive_thread.join();
+    solve_thread.join();
     cmd_thread.join();
-    //print_thread.join();
+    trajectory.reset();
+    async_log::stop();
 
     ackermann_msgs::AckermannDriveStamped drive_msg;
     drive_msg.drive.speed = 0;
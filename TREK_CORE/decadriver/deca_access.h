@@ -0,0 +1,106 @@
+/*! ----------------------------------------------------------------------------
+ * @file    deca_access.h
+ * @brief   Register access with the SPI header built at compile time
+ *
+ * dwt_readfromdevice() and dwt_writetodevice() compose the 1 to 3 byte SPI header from the register file ID and index
+ * on every call. The accessors below are always inlined, so with a constant register file ID and index, as on the
+ * interrupt path, the header folds into constants and a register access is only the SPI transfer. The encoding is
+ * the one of dwt_readfromdevice(), see there.
+ */
+
+#ifndef _DECA_ACCESS_H_
+#define _DECA_ACCESS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "deca_types.h"
+#include "deca_device_api.h"
+
+// Length of the header for a sub-index of index
+#define DWT_HEADER_LEN(index)               (((index) == 0) ? 1 : (((index) <= 127) ? 2 : 3))
+// Header bytes, bit-7 of the first one selects a write, bit-6 a sub-index, bits 5-0 the register file ID
+#define DWT_HEADER0(regFileID, index, wr)   ((uint8)(((wr) ? 0x80 : 0) | (((index) == 0) ? 0 : 0x40) | (regFileID)))
+#define DWT_HEADER1(index)                  ((uint8)(((index) <= 127) ? (index) : (0x80 | ((index) & 0x7F))))
+#define DWT_HEADER2(index)                  ((uint8)((index) >> 7))
+
+#define DWT_ACCESS_INLINE                   static inline __attribute__((always_inline))
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn dwt_readfast()
+ *
+ * @brief Same as dwt_readfromdevice(), inlined
+ *
+ * input parameters:
+ * @param regFileID - ID of register file or buffer being accessed
+ * @param index     - byte index into register file or buffer being accessed
+ * @param length    - number of bytes being read
+ * @param buffer    - pointer to buffer in which to return the read data
+ *
+ * no return value
+ */
+DWT_ACCESS_INLINE void dwt_readfast(uint16 regFileID, uint16 index, uint32 length, uint8 *buffer)
+{
+    const uint8 header[3] = {DWT_HEADER0(regFileID, index, 0), DWT_HEADER1(index), DWT_HEADER2(index)};
+
+    readfromspi(DWT_HEADER_LEN(index), header, length, buffer);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn dwt_writefast()
+ *
+ * @brief Same as dwt_writetodevice(), inlined
+ *
+ * input parameters:
+ * @param regFileID - ID of register file or buffer being accessed
+ * @param index     - byte index into register file or buffer being accessed
+ * @param length    - number of bytes being written
+ * @param buffer    - pointer to buffer containing the 'length' bytes to be written
+ *
+ * no return value
+ */
+DWT_ACCESS_INLINE void dwt_writefast(uint16 regFileID, uint16 index, uint32 length, const uint8 *buffer)
+{
+    const uint8 header[3] = {DWT_HEADER0(regFileID, index, 1), DWT_HEADER1(index), DWT_HEADER2(index)};
+
+    writetospi(DWT_HEADER_LEN(index), header, length, buffer);
+}
+
+// Same as dwt_read32bitoffsetreg(), inlined
+DWT_ACCESS_INLINE uint32 dwt_read32fast(uint16 regFileID, uint16 index)
+{
+    uint8 buffer[4];
+
+    dwt_readfast(regFileID, index, 4, buffer);
+    return ((uint32)buffer[3] << 24) | ((uint32)buffer[2] << 16) | ((uint32)buffer[1] << 8) | buffer[0];
+}
+
+// Same as dwt_read16bitoffsetreg(), inlined
+DWT_ACCESS_INLINE uint16 dwt_read16fast(uint16 regFileID, uint16 index)
+{
+    uint8 buffer[2];
+
+    dwt_readfast(regFileID, index, 2, buffer);
+    return (uint16)((buffer[1] << 8) | buffer[0]);
+}
+
+// Same as dwt_write32bitoffsetreg(), inlined
+DWT_ACCESS_INLINE void dwt_write32fast(uint16 regFileID, uint16 index, uint32 regval)
+{
+    const uint8 buffer[4] = {(uint8)regval, (uint8)(regval >> 8), (uint8)(regval >> 16), (uint8)(regval >> 24)};
+
+    dwt_writefast(regFileID, index, 4, buffer);
+}
+
+// Same as dwt_write8bitoffsetreg(), inlined
+DWT_ACCESS_INLINE void dwt_write8fast(uint16 regFileID, uint16 index, uint8 regval)
+{
+    dwt_writefast(regFileID, index, 1, &regval);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DECA_ACCESS_H_ */
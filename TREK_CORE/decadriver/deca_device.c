@@ -16,6 +16,8 @@
 #include "deca_param_types.h"
 #include "deca_regs.h"
 #include "deca_device_api.h"
+#include "deca_access.h"
+#include "port_deca.h"
 
 // Defines for enable_clocks function
 #define FORCE_SYS_XTI  0
@@ -871,7 +873,7 @@ void dwt_readsystime(uint8 * timestamp)
  *
  * no return value
  */
-void dwt_writetodevice
+PORT_RAMFUNC void dwt_writetodevice
 (
     uint16      recordNumber,
     uint16      index,
@@ -935,7 +937,7 @@ void dwt_writetodevice
  *
  * no return value
  */
-void dwt_readfromdevice
+PORT_RAMFUNC void dwt_readfromdevice
 (
     uint16  recordNumber,
     uint16  index,
@@ -2119,9 +2121,9 @@ uint8 dwt_checkirq(void)
  *
  * no return value
  */
-void dwt_isr(void)
+PORT_RAMFUNC void dwt_isr(void)
 {
-    uint32 status = dw1000local.cbData.status = dwt_read32bitreg(SYS_STATUS_ID); // Read status register low 32bits
+    uint32 status = dw1000local.cbData.status = dwt_read32fast(SYS_STATUS_ID, 0); // Read status register low 32bits
 
     // Handle RX good frame event
     if(status & SYS_STATUS_RXFCG)
@@ -2129,12 +2131,12 @@ void dwt_isr(void)
         uint16 finfo16;
         uint16 len;
 
-        dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_ALL_RX_GOOD); // Clear all receive status bits
+        dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_GOOD); // Clear all receive status bits
 
         dw1000local.cbData.rx_flags = 0;
 
         // Read frame info - Only the first two bytes of the register are used here.
-        finfo16 = dwt_read16bitoffsetreg(RX_FINFO_ID, RX_FINFO_OFFSET);
+        finfo16 = dwt_read16fast(RX_FINFO_ID, RX_FINFO_OFFSET);
 
         // Report frame length - Standard frame length up to 127, extended frame length up to 1023 bytes
         len = finfo16 & RX_FINFO_RXFL_MASK_1023;
@@ -2151,7 +2153,7 @@ void dwt_isr(void)
         }
 
         // Report frame control - First bytes of the received frame.
-        dwt_readfromdevice(RX_BUFFER_ID, 0, FCTRL_LEN_MAX, dw1000local.cbData.fctrl);
+        dwt_readfast(RX_BUFFER_ID, 0, FCTRL_LEN_MAX, dw1000local.cbData.fctrl);
 
         // Because of a previous frame not being received properly, AAT bit can be set upon the proper reception of a frame not requesting for
         // acknowledgement (ACK frame is not actually sent though). If the AAT bit is set, check ACK request bit in frame control to confirm (this
@@ -2159,7 +2161,7 @@ void dwt_isr(void)
         // This issue is not documented at the time of writing this code. It should be in next release of DW1000 User Manual (v2.09, from July 2016).
         if((status & SYS_STATUS_AAT) && ((dw1000local.cbData.fctrl[0] & FCTRL_ACK_REQ_MASK) == 0))
         {
-            dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_AAT); // Clear AAT status bit in register
+            dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_AAT); // Clear AAT status bit in register
             dw1000local.cbData.status &= ~SYS_STATUS_AAT; // Clear AAT status bit in callback data register copy
             dw1000local.wait4resp = 0;
         }
@@ -2173,14 +2175,14 @@ void dwt_isr(void)
         if (dw1000local.dblbuffon)
         {
             // Toggle the Host side Receive Buffer Pointer
-            dwt_write8bitoffsetreg(SYS_CTRL_ID, SYS_CTRL_HRBT_OFFSET, 1);
+            dwt_write8fast(SYS_CTRL_ID, SYS_CTRL_HRBT_OFFSET, 1);
         }
     }
 
     // Handle TX confirmation event
     if(status & SYS_STATUS_TXFRS)
     {
-        dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_ALL_TX); // Clear TX event bits
+        dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_ALL_TX); // Clear TX event bits
 
         // In the case where this TXFRS interrupt is due to the automatic transmission of an ACK solicited by a response (with ACK request bit set)
         // that we receive through using wait4resp to a previous TX (and assuming that the IRQ processing of that TX has already been handled), then
@@ -2203,7 +2205,7 @@ void dwt_isr(void)
     // Handle frame reception/preamble detect timeout events
     if(status & SYS_STATUS_ALL_RX_TO)
     {
-        dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_RXRFTO); // Clear RX timeout event bits
+        dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_RXRFTO); // Clear RX timeout event bits
 
         dw1000local.wait4resp = 0;
 
@@ -2223,7 +2225,7 @@ void dwt_isr(void)
     // Handle RX errors events
     if(status & SYS_STATUS_ALL_RX_ERR)
     {
-        dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_ALL_RX_ERR); // Clear RX error event bits
+        dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_ERR); // Clear RX error event bits
 
         dw1000local.wait4resp = 0;
 
@@ -48,9 +48,18 @@
  *
  * returns the state of the DW1000 interrupt
  */
-decaIrqStatus_t decamutexon(void)           
+PORT_RAMFUNC decaIrqStatus_t decamutexon(void)
 {
-	decaIrqStatus_t s = port_GetEXT_IRQStatus();
+	decaIrqStatus_t s;
+
+	// The DW1000 interrupt has the lowest priority (15) and cannot preempt any handler, dwt_isr and everything
+	// else in handler mode runs its SPI accesses without touching the EXTI and NVIC registers
+	if (port_GetActiveException() != 0)
+	{
+		return 0;
+	}
+
+	s = port_GetEXT_IRQStatus();
 
 	if(s) {
 		port_DisableEXT_IRQ(); //disable the external interrupt line
@@ -73,7 +82,7 @@ decaIrqStatus_t decamutexon(void)
  *
  * returns the state of the DW1000 interrupt
  */
-void decamutexoff(decaIrqStatus_t s)        // put a function here that re-enables the interrupt at the end of the critical section
+PORT_RAMFUNC void decamutexoff(decaIrqStatus_t s)        // put a function here that re-enables the interrupt at the end of the critical section
 {
 	if(s) { //need to check the port state as we can't use level sensitive interrupt on the STM ARM
 		port_EnableEXT_IRQ();
@@ -0,0 +1,221 @@
+/*! ----------------------------------------------------------------------------
+ * @file	deca_spi.c
+ * @brief	SPI access functions
+ *
+ * @attention
+ *
+ * Copyright 2013 (c) DecaWave Ltd, Dublin, Ireland.
+ *
+ * All rights reserved.
+ *
+ * @author DecaWave
+ */
+#include <string.h>
+
+#include "deca_spi.h"
+#include "deca_device_api.h"
+#include "port_deca.h"
+
+// Bodies shorter than this are sent polled, setting up the DMA costs about as much
+#define SPI_DMA_MIN_LENGTH		8
+
+// Read started by readfromspi_async() and not completed yet
+static decaIrqStatus_t asyncStat;
+static spi_done_cb_t asyncDone = NULL;
+
+/*
+ * Sends the header with chip select already low. The received bytes are read
+ * and dropped so RXNE is clear when a DMA body follows.
+ */
+#pragma GCC optimize ("O3")
+static PORT_RAMFUNC void spi_send_header(uint16 headerLength, const uint8 *headerBuffer)
+{
+	int i;
+
+	for(i=0; i<headerLength; i++)
+	{
+		SPIx->DR = headerBuffer[i];
+
+		while ((SPIx->SR & SPI_I2S_FLAG_RXNE) == (uint16_t)RESET);
+
+		SPIx->DR ;
+	}
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: openspi()
+ *
+ * Low level abstract function to open and initialise access to the SPI device.
+ * returns 0 for success, or -1 for error
+ */
+int openspi(/*SPI_TypeDef* SPIx*/)
+{
+	// done by port.c, default SPI used is SPI1
+
+	return 0;
+
+} // end openspi()
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: closespi()
+ *
+ * Low level abstract function to close the the SPI device.
+ * returns 0 for success, or -1 for error
+ */
+int closespi(void)
+{
+	while (port_SPIx_busy_sending()); //wait for tx buffer to empty
+
+	port_SPIx_disable();
+
+	return 0;
+
+} // end closespi()
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: writetospi()
+ *
+ * Low level abstract function to write to the SPI
+ * Takes two separate byte buffers for write header and write data
+ * returns 0 for success, or -1 for error
+ */
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC int writetospi(uint16 headerLength, const uint8 *headerBuffer, uint32 bodylength, const uint8 *bodyBuffer)
+{
+
+	int i=0;
+
+    decaIrqStatus_t  stat ;
+
+    // An asynchronous read may still hold the bus
+    port_SPIx_DMA_wait();
+
+    stat = decamutexon() ;
+
+    SPIx_CS_GPIO->BRR = SPIx_CS;
+
+    spi_send_header(headerLength, headerBuffer);
+
+    if (bodylength >= SPI_DMA_MIN_LENGTH)
+    {
+    	// The body follows the header within the same chip select, back to back
+    	port_SPIx_DMA_start(bodyBuffer, NULL, bodylength, NULL);
+    	port_SPIx_DMA_wait();
+    }
+    else
+    {
+    	for(i=0; i<bodylength; i++)
+    	{
+    		SPIx->DR = bodyBuffer[i];
+
+    		while((SPIx->SR & SPI_I2S_FLAG_RXNE) == (uint16_t)RESET);
+
+    		SPIx->DR ;
+    	}
+    }
+
+    SPIx_CS_GPIO->BSRR = SPIx_CS;
+
+    decamutexoff(stat) ;
+
+    return 0;
+} // end writetospi()
+
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: readfromspi()
+ *
+ * Low level abstract function to read from the SPI
+ * Takes two separate byte buffers for write header and read data
+ * returns the offset into read buffer where first byte of read data may be found,
+ * or returns -1 if there was an error
+ */
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC int readfromspi(uint16 headerLength, const uint8 *headerBuffer, uint32 readlength, uint8 *readBuffer)
+{
+
+	int i=0;
+
+    decaIrqStatus_t  stat ;
+
+    port_SPIx_DMA_wait();
+
+    stat = decamutexon() ;
+
+    /* Wait for SPIx Tx buffer empty */
+    //while (port_SPIx_busy_sending());
+
+    SPIx_CS_GPIO->BRR = SPIx_CS;
+
+    spi_send_header(headerLength, headerBuffer);
+
+    if (readlength >= SPI_DMA_MIN_LENGTH)
+    {
+    	port_SPIx_DMA_start(NULL, readBuffer, readlength, NULL);
+    	port_SPIx_DMA_wait();
+    }
+    else
+    {
+    	for(i=0; i<readlength; i++)
+    	{
+    		SPIx->DR = 0;  // Dummy write as we read the message body
+
+    		while((SPIx->SR & SPI_I2S_FLAG_RXNE) == (uint16_t)RESET);
+
+    		readBuffer[i] = SPIx->DR ;//port_SPIx_receive_data(); //this clears RXNE bit
+    	}
+    }
+
+    SPIx_CS_GPIO->BSRR = SPIx_CS;
+
+    decamutexoff(stat) ;
+
+    return 0;
+} // end readfromspi()
+
+#pragma GCC optimize ("O3")
+static void readfromspi_async_end(void)
+{
+	spi_done_cb_t done = asyncDone;
+
+	SPIx_CS_GPIO->BSRR = SPIx_CS;
+
+	decamutexoff(asyncStat) ;
+
+	asyncDone = NULL;
+	if (done != NULL)
+	{
+		done();
+	}
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: readfromspi_async()
+ *
+ * Same as readfromspi() but returns once the header is sent, the body is read by DMA.
+ * The DW1000 interrupt stays masked until the read completes, then done is called from the DMA interrupt.
+ * Started from a handler it is not masked (decamutexon()), a DW1000 interrupt after it waits for the read.
+ * Any other access to the device waits for the read first.
+ * returns 0 for success, or -1 for error
+ */
+#pragma GCC optimize ("O3")
+int readfromspi_async(uint16 headerLength, const uint8 *headerBuffer, uint32 readlength, uint8 *readBuffer, spi_done_cb_t done)
+{
+    if ((readlength == 0) || (readlength > 0xFFFF))
+    {
+    	return -1;
+    }
+
+    port_SPIx_DMA_wait();
+
+    asyncStat = decamutexon() ;
+    asyncDone = done;
+
+    SPIx_CS_GPIO->BRR = SPIx_CS;
+
+    spi_send_header(headerLength, headerBuffer);
+
+    port_SPIx_DMA_start(NULL, readBuffer, (uint16)readlength, &readfromspi_async_end);
+
+    return 0;
+} // end readfromspi_async()
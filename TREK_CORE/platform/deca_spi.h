@@ -38,6 +38,15 @@ int openspi(void) ;
  */
 int closespi(void) ;
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * Function: readfromspi_async()
+ *
+ * Starts a DMA read of the device and returns, done() is called from the DMA interrupt once readBuffer is filled.
+ * returns 0 for success, or -1 for error
+ */
+typedef void (*spi_done_cb_t)(void);
+int readfromspi_async(uint16 headerLength, const uint8 *headerBuffer, uint32 readlength, uint8 *readBuffer, spi_done_cb_t done) ;
+
 #ifdef __cplusplus
 }
 #endif
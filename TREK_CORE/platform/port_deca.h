@@ -28,6 +28,31 @@ extern "C" {
 
 void printf2(const char *format, ...);
 
+// Flash runs with two wait states at 72 MHz. Functions on the path from the DW1000 interrupt to the next RX enable
+// are linked into SRAM (.ramfunc in the linker script) and copied there by the startup code with .data
+#define PORT_RAMFUNC				__attribute__((section(".ramfunc"), noinline))
+
+// RAM the startup code neither copies nor clears (.noinit in the linker script). It keeps its contents across a
+// watchdog or software reset, not across a power cycle, see common/tdoa_retain.h
+#define PORT_NOINIT					__attribute__((section(".noinit")))
+
+// Independent watchdog, clocked by the LSI RC oscillator: 40 kHz nominal, 30 to 60 kHz over parts and temperature,
+// so a timeout comes after 2/3 to 4/3 of the one asked for. Divided by 32 one reload step is 0.8 ms, at most ~3.3 s
+#define PORT_IWDG_LSI_HZ			40000
+#define PORT_IWDG_PRESCALER			3		// IWDG_PR, divide by 32
+#define PORT_IWDG_DIVIDER			32
+
+// Causes of the last reset, see port_reset_cause
+#define PORT_RESET_POWER			0		// Power-on or brown-out, .noinit holds garbage
+#define PORT_RESET_PIN				1		// NRST, the reset button or a debugger
+#define PORT_RESET_WATCHDOG			2
+#define PORT_RESET_SOFTWARE			3		// NVIC_SystemReset
+
+// Run the exception vectors from the copy in SRAM, set to 0 to keep them in flash
+#ifndef PORT_VECTORS_IN_RAM
+#define PORT_VECTORS_IN_RAM			1
+#endif
+
 typedef enum
 {
     LED_PC6,
@@ -61,6 +86,13 @@ typedef enum
 #define SPIx_MISO					GPIO_Pin_6
 #define SPIx_MOSI					GPIO_Pin_7
 
+// DMA1 request mapping of SPI1, the receive channel completes last and ends a transfer
+#define SPIx_DMA_RX_CHANNEL			DMA1_Channel2
+#define SPIx_DMA_TX_CHANNEL			DMA1_Channel3
+#define SPIx_DMA_RX_IRQn			DMA1_Channel2_IRQn
+#define SPIx_DMA_RX_TC_FLAG			DMA1_FLAG_TC2
+#define SPIx_DMA_FLAGS				(DMA1_FLAG_GL2 | DMA1_FLAG_GL3)
+
 #define DW1000_RSTn					GPIO_Pin_0
 #define DW1000_RSTn_GPIO			GPIOA
 
@@ -109,6 +141,12 @@ int is_switch_on(uint16_t GPIOpin);
 #define port_USARTx_send_data(x)	USART_SendData((USARTx),(uint8_t)(x))
 #define port_USARTx_receive_data()	USART_ReceiveData(USARTx)
 
+// DMA1 request mapping of USART2 transmit, for the DMA output of the tag
+#define USARTx_DMA_TX_CHANNEL		DMA1_Channel7
+#define USARTx_DMA_TX_IRQn			DMA1_Channel7_IRQn
+#define USARTx_DMA_TX_FLAGS			DMA1_FLAG_GL7
+#define USARTx_DMA_TX_SIZE			1024	// Bytes of the transmit ring, power of two
+
 #define port_SPIx_busy_sending()		(SPI_I2S_GetFlagStatus((SPIx),(SPI_I2S_FLAG_TXE))==(RESET))
 #define port_SPIx_no_data()				(SPI_I2S_GetFlagStatus((SPIx),(SPI_I2S_FLAG_RXNE))==(RESET))
 #define port_SPIx_send_data(x)			SPI_I2S_SendData((SPIx),(x))
@@ -141,6 +179,15 @@ ITStatus EXTI_GetITEnStatus(uint32_t x);
 #define port_DisableEXT_IRQ()               NVIC_DisableIRQ(DECAIRQ_EXTI_IRQn)
 #define port_EnableEXT_IRQ()                NVIC_EnableIRQ(DECAIRQ_EXTI_IRQn)
 #define port_CheckEXT_IRQ()                 GPIO_ReadInputDataBit(DECAIRQ_GPIO, DECAIRQ)
+
+// Number of the active exception from IPSR, 0 in thread mode. A core register, no bus access
+static inline uint32_t port_GetActiveException(void)
+{
+	uint32_t ipsr;
+
+	__ASM volatile ("MRS %0, ipsr" : "=r" (ipsr));
+	return ipsr & 0x1FF;
+}
 int NVIC_DisableDECAIRQ(void);
 
 //define LCD functions
@@ -178,6 +225,82 @@ extern port_deca_isr_t port_deca_isr;
 void peripherals_init (void);
 void clock_init(void);
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_vector_table_to_ram()
+ *
+ * @brief Copies the vector table to the .ram_vector section of the linker script and points VTOR at it, so exception
+ *        entry fetches its vector without flash wait states. Called before any interrupt is enabled.
+ *
+ * @param none
+ *
+ * @return none
+ */
+static inline void port_vector_table_to_ram(void)
+{
+#if PORT_VECTORS_IN_RAM
+	extern const uint32_t g_pfnVectors[];
+	extern uint32_t _sram_vector[], _eram_vector[];
+	uint32_t i;
+
+	for (i = 0; i < (uint32_t)(_eram_vector - _sram_vector); i++)
+	{
+		_sram_vector[i] = g_pfnVectors[i];
+	}
+	SCB->VTOR = (uint32_t)_sram_vector;
+	__DSB();
+#endif
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_iwdg_start()
+ *
+ * @brief Starts the independent watchdog, it resets the MCU unless port_iwdg_kick() comes within ms. Once started
+ *        only a reset stops it. It stops while a debugger halts the core.
+ *
+ * @param ms  nominal timeout, see PORT_IWDG_LSI_HZ
+ *
+ * @return none
+ */
+static inline void port_iwdg_start(uint32_t ms)
+{
+	uint32_t reload = ms * (PORT_IWDG_LSI_HZ / 1000) / PORT_IWDG_DIVIDER;
+
+	if (reload < 1) reload = 1;
+	if (reload > 0xFFF) reload = 0xFFF;
+	DBGMCU->CR |= DBGMCU_CR_DBG_IWDG_STOP;
+	IWDG->KR = 0x5555;				// Unlock PR and RLR
+	IWDG->PR = PORT_IWDG_PRESCALER;
+	IWDG->RLR = reload;
+	IWDG->KR = 0xAAAA;
+	IWDG->KR = 0xCCCC;				// Start
+}
+
+static inline void port_iwdg_kick(void)
+{
+	IWDG->KR = 0xAAAA;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_reset_cause()
+ *
+ * @brief Cause of the last reset from the flags of RCC_CSR, which are then cleared. Call it once after a reset, the
+ *        flags of earlier resets add up until they are cleared.
+ *
+ * @param none
+ *
+ * @return PORT_RESET_*
+ */
+static inline uint8_t port_reset_cause(void)
+{
+	const uint32_t csr = RCC->CSR;
+
+	RCC->CSR |= RCC_CSR_RMVF;
+	if (csr & (RCC_CSR_PORRSTF | RCC_CSR_LPWRRSTF)) return PORT_RESET_POWER;
+	if (csr & (RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF)) return PORT_RESET_WATCHDOG;
+	if (csr & RCC_CSR_SFTRSTF) return PORT_RESET_SOFTWARE;
+	return PORT_RESET_PIN;
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @fn port_set_deca_isr()
  *
@@ -197,6 +320,62 @@ void port_set_deca_isr(port_deca_isr_t deca_isr);
 void SPI_ChangeRate(uint16_t scalingfactor);
 void SPI_ConfigFastRate(uint16_t scalingfactor);
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_SPIx_DMA_start()
+ *
+ * @brief Starts a full-duplex DMA transfer of length bytes on SPIx. The caller owns chip select.
+ *
+ * @param tx     bytes to send, NULL sends zeros
+ * @param rx     buffer for the received bytes, NULL discards them
+ * @param length number of bytes
+ * @param done   called from the DMA interrupt once the last byte is in, NULL to complete with port_SPIx_DMA_wait()
+ *
+ * @return none
+ */
+typedef void (*port_spi_done_t)(void);
+void port_SPIx_DMA_start(const uint8_t *tx, uint8_t *rx, uint16_t length, port_spi_done_t done);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_SPIx_DMA_wait()
+ *
+ * @brief Waits until no DMA transfer is pending on SPIx. Must not be called from a context that preempts the DMA
+ *        interrupt while a transfer with a done callback is in progress.
+ *
+ * @param none
+ *
+ * @return none
+ */
+void port_SPIx_DMA_wait(void);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_USARTx_DMA_init()
+ *
+ * @brief Sets up USARTx at baud (8N1) for DMA transmission from a ring of USARTx_DMA_TX_SIZE bytes. Tag only.
+ *
+ * @param baud line rate, up to 2250000 on the 36 MHz APB1
+ *
+ * @return none
+ */
+void port_USARTx_DMA_init(uint32_t baud);
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn port_USARTx_DMA_send()
+ *
+ * @brief Queues a frame for transmission and starts the DMA if it is idle. The frame goes out whole or not at all.
+ *        Must not be called from an interrupt.
+ *
+ * @param data   bytes of the frame
+ * @param length number of bytes
+ *
+ * @return 1 if the frame was queued, 0 if the ring had no room for it (counted in port_USARTx_DMA_overflows())
+ */
+int port_USARTx_DMA_send(const uint8_t *data, uint16_t length);
+
+// Free bytes of the transmit ring, nonzero once everything was sent, and frames refused for lack of room
+uint16_t port_USARTx_DMA_space(void);
+int port_USARTx_DMA_idle(void);
+uint32_t port_USARTx_DMA_overflows(void);
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @fn spi_set_rate_low()
  *
@@ -220,7 +399,7 @@ void spi_set_rate_low (void);
 void spi_set_rate_high (void);
 
 unsigned long portGetTickCnt(void);
-unsigned long portGetLastEvent(void);
+unsigned long portGetLastEvent(void);	// Tick of the last DW1000 interrupt, TREK_TDOA only
 
 #define portGetTickCount() 			portGetTickCnt()
 
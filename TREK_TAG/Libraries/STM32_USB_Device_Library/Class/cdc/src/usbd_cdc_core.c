@@ -134,6 +134,9 @@ static uint8_t  *USBD_cdc_GetOtherCfgDesc (uint8_t speed, uint16_t *length);
   * @{
   */ 
 extern CDC_IF_Prop_TypeDef  APP_FOPS;
+/* IN path of the application (deca_usb.c) */
+extern void DW_VCP_SOF(void);
+extern uint32_t DW_VCP_TxSwap(uint8_t **buffer);
 extern uint8_t USBD_DeviceDesc   [USB_SIZ_DEVICE_DESC];
 
 #ifdef USB_OTG_HS_INTERNAL_DMA_ENABLED
@@ -164,14 +167,6 @@ __ALIGN_BEGIN static __IO uint32_t  usbd_cdc_AltSet  __ALIGN_END = 0;
 #endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
 __ALIGN_BEGIN uint8_t USB_Rx_Buffer   [CDC_DATA_MAX_PACKET_SIZE] __ALIGN_END ;
 
-#ifdef USB_OTG_HS_INTERNAL_DMA_ENABLED
-  #if defined ( __ICCARM__ ) /*!< IAR Compiler */
-    #pragma data_alignment=4   
-  #endif
-#endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
-__ALIGN_BEGIN uint8_t APP_Rx_Buffer   [APP_RX_DATA_SIZE] __ALIGN_END ; 
-
-
 #ifdef USB_OTG_HS_INTERNAL_DMA_ENABLED
   #if defined ( __ICCARM__ ) /*!< IAR Compiler */
     #pragma data_alignment=4   
@@ -179,11 +174,9 @@ __ALIGN_BEGIN uint8_t APP_Rx_Buffer   [APP_RX_DATA_SIZE] __ALIGN_END ;
 #endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
 __ALIGN_BEGIN uint8_t CmdBuff[CDC_CMD_PACKET_SZE] __ALIGN_END ;
 
-uint32_t APP_Rx_ptr_in  = 0;
-uint32_t APP_Rx_ptr_out = 0;
-uint32_t APP_Rx_length  = 0;
-
 uint8_t  USB_Tx_State = 0;
+/* The transfer in flight is whole packets, a zero length packet ends it */
+static uint8_t USB_Tx_Zlp = 0;
 
 static uint32_t cdcCmd = 0xFF;
 static uint32_t cdcLen = 0;
@@ -623,43 +616,19 @@ static uint8_t  usbd_cdc_EP0_RxReady (void  *pdev)
   */
 static uint8_t  usbd_cdc_DataIn (void *pdev, uint8_t epnum)
 {
-  uint16_t USB_Tx_ptr;
-  uint16_t USB_Tx_length;
-
   if (USB_Tx_State == 1)
   {
-    if (APP_Rx_length == 0) 
+    if (USB_Tx_Zlp)
     {
-      USB_Tx_State = 0;
-    }
-    else 
-    {
-      if (APP_Rx_length > CDC_DATA_IN_PACKET_SIZE){
-        USB_Tx_ptr = APP_Rx_ptr_out;
-        USB_Tx_length = CDC_DATA_IN_PACKET_SIZE;
-        
-        APP_Rx_ptr_out += CDC_DATA_IN_PACKET_SIZE;
-        APP_Rx_length -= CDC_DATA_IN_PACKET_SIZE;    
-      }
-      else 
-      {
-        USB_Tx_ptr = APP_Rx_ptr_out;
-        USB_Tx_length = APP_Rx_length;
-        
-        APP_Rx_ptr_out += APP_Rx_length;
-        APP_Rx_length = 0;
-
-        //ZS - data smaller than 64 bytes - don't increment pointers...
-        APP_Rx_ptr_out = 0;
-        APP_Rx_ptr_in = 0;
-      }
-      
-      /* Prepare the available data buffer to be sent on IN endpoint */
-      DCD_EP_Tx (pdev,
-                 CDC_IN_EP,
-                 (uint8_t*)&APP_Rx_Buffer[USB_Tx_ptr],
-                 USB_Tx_length);
+      /* Otherwise the host waits for more data before completing its read */
+      USB_Tx_Zlp = 0;
+      DCD_EP_Tx (pdev, CDC_IN_EP, NULL, 0);
+      return USBD_OK;
     }
+    
+    /* The buffer just sent is free, the other one goes out back to back */
+    USB_Tx_State = 0;
+    Handle_USBAsynchXfer(pdev);
   }  
   
   return USBD_OK;
@@ -708,6 +677,9 @@ static uint8_t  usbd_cdc_SOF (void *pdev)
     /* Reset the frame counter */
     FrameCount = 0;
     
+    /* Clock sync frame of the tag, stamped at this SOF */
+    DW_VCP_SOF();
+    
     /* Check the data to be sent through IN pipe */
     Handle_USBAsynchXfer(pdev);
   }
@@ -723,61 +695,25 @@ static uint8_t  usbd_cdc_SOF (void *pdev)
   */
 static void Handle_USBAsynchXfer (void *pdev)
 {
-  uint16_t USB_Tx_ptr;
-  uint16_t USB_Tx_length;
+  uint8_t *USB_Tx_buffer;
+  uint32_t USB_Tx_length;
   
   if(USB_Tx_State != 1)
   {
-    if (APP_Rx_ptr_out == APP_RX_DATA_SIZE)
-    {
-      APP_Rx_ptr_out = 0;
-    }
-    
-    if(APP_Rx_ptr_out == APP_Rx_ptr_in) 
+    /* Swaps the double buffer of the application, see DW_VCP_TxSwap */
+    USB_Tx_length = DW_VCP_TxSwap(&USB_Tx_buffer);
+    if(USB_Tx_length == 0) 
     {
       USB_Tx_State = 0; 
       return;
     }
-    
-    if(APP_Rx_ptr_out > APP_Rx_ptr_in) /* rollback */
-    { 
-      APP_Rx_length = APP_RX_DATA_SIZE - APP_Rx_ptr_out;
-    
-    }
-    else 
-    {
-      APP_Rx_length = APP_Rx_ptr_in - APP_Rx_ptr_out;
-     
-    }
-#ifdef USB_OTG_HS_INTERNAL_DMA_ENABLED
-     APP_Rx_length &= ~0x03;
-#endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
-    
-    if (APP_Rx_length > CDC_DATA_IN_PACKET_SIZE)
-    {
-      USB_Tx_ptr = APP_Rx_ptr_out;
-      USB_Tx_length = CDC_DATA_IN_PACKET_SIZE;
-      
-      APP_Rx_ptr_out += CDC_DATA_IN_PACKET_SIZE;	
-      APP_Rx_length -= CDC_DATA_IN_PACKET_SIZE;
-    }
-    else
-    {
-      USB_Tx_ptr = APP_Rx_ptr_out;
-      USB_Tx_length = APP_Rx_length;
-      
-      APP_Rx_ptr_out += APP_Rx_length;
-      APP_Rx_length = 0;
-
-      //ZS - data smaller than 64 bytes - don't increment pointers...
-      APP_Rx_ptr_out = 0;
-      APP_Rx_ptr_in = 0;
-    }
+    USB_Tx_Zlp = ((USB_Tx_length % CDC_DATA_IN_PACKET_SIZE) == 0);
     USB_Tx_State = 1; 
 
+    /* The whole buffer in one transfer, split into packets by the driver */
     DCD_EP_Tx (pdev,
                CDC_IN_EP,
-               (uint8_t*)&APP_Rx_Buffer[USB_Tx_ptr],
+               USB_Tx_buffer,
                USB_Tx_length);
   }  
   
@@ -0,0 +1,46 @@
+/*
+ * Flash capture of the tag (TAG_CAPTURE). On a capture frame of the host the
+ * tag records every pair of every received packet, raw timestamps and
+ * receive diagnostics, into a ring of pages of internal flash at the rate
+ * the radio delivers them, independent of the USB link. Exported, the tag
+ * restarts as a read-only USB drive holding the capture as CAPTURE.BIN, in
+ * the layout of common/tdoa_flash_capture.h.
+ *
+ * The capture lies in the top of the flash, above the firmware image. The
+ * pages are erased when a capture starts, so recording only programs half
+ * words. A wrapping ring erases its oldest page on the way, which holds the
+ * flash for a page erase and can cost the packets of that time.
+ */
+#ifndef _TAG_CAPTURE_H_
+#define _TAG_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "deca_types.h"
+#include <stdint.h>
+#include "tdoa_flash_capture.h"
+
+#define CAPTURE_FLASH_START		0x08020000	// Top 128 KB of the 256 KB flash
+#define CAPTURE_PAGES			64			// Of TDOA_CAPTURE_PAGE_SIZE bytes, 5440 records
+#define CAPTURE_WRAP			0			// 1 keeps the latest records in a ring, 0 stops once full
+#define CAPTURE_BKP_REGISTER	BKP_DR1		// Survives the reset into the export
+#define CAPTURE_EXPORT_KEY		0xCA97
+
+void tag_capture_init(void);
+void tag_capture_command(uint8_t action);
+uint8 tag_capture_active(void);
+void tag_capture_record(const tdoa_capture_rec_t *rec);
+uint32_t tag_capture_records(void);
+
+// Export, see usbd_storage_capture.c
+uint8 tag_capture_export_pending(void);
+uint8 tag_capture_scan(void);
+const uint8 *tag_capture_page(uint8 k);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
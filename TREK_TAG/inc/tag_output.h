@@ -0,0 +1,38 @@
+/*
+ * Output modes of the tag (output frame of common/tdoa_protocol.h). A slow
+ * asset does not need every distance difference, the host reads, parses and
+ * filters each one. Per pair Ar, An the tag can instead send
+ *   - the mean of every packets measurements, with the variance of the mean
+ *     in place of the one of a single packet (TDOA_OUTPUT_AVERAGE),
+ *   - every packets-th measurement (TDOA_OUTPUT_DECIMATE),
+ *   - a measurement once it moved by threshold from the last one sent, and
+ *     at least every packets (TDOA_OUTPUT_CHANGE).
+ * The mode holds until the next output frame and across a watchdog reset,
+ * a power cycle starts with TDOA_OUTPUT_ALL.
+ *
+ * Runs in the main loop, from tdoa_process and the USB receive path.
+ */
+#ifndef _TAG_OUTPUT_H_
+#define _TAG_OUTPUT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tdoa_tag.h"
+
+#define OUTPUT_PAIRS		(RX_MAX_PAIRS + 1)	// Pairs kept per anchor An: the Ar the pair mode measures it against and one after a missed packet
+
+void tag_output_configure(const tdoa_output_config_t *config);
+const tdoa_output_config_t *tag_output_config(void);
+
+// Takes the measurement msg, 1 if it is to be sent now as msg holds it then, 0 if held back
+uint8 tag_output_filter(usb_msg_t *msg);
+
+extern uint32_t statsOutputHeld;	// Measurements held back or averaged into a later one
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
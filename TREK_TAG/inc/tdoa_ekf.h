@@ -0,0 +1,35 @@
+/*
+ * Position filter of the tag (TAG_EKF), the 6 state TDOA filter of the host
+ * (decawave tdoa.cpp) in single precision for the STM32. Takes the distance
+ * differences of tdoa_process, the anchor layout of tdoa_get_anchors and the
+ * motion model the host sends over USB.
+ */
+#ifndef _TDOA_EKF_H_
+#define _TDOA_EKF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "deca_types.h"
+#include <stdint.h>
+#include "tdoa_protocol.h"
+
+#define EKF_MAX_COVARIANCE		100.0f		// Same bounds as PredictionBound of the host
+#define EKF_MIN_COVARIANCE		1e-6f
+#define EKF_MIN_DISTANCE		1e-3f		// m, closer to an anchor the direction is undefined
+#define EKF_MAX_DT				1.0f		// s, longer gaps predict this far only
+#define EKF_SEED_MIN_PAIRS		4			// Pairs of one TDMA frame needed to seed the position
+#define EKF_SEED_ITERATIONS		10			// Gauss-Newton steps of the seed from the anchor centroid
+
+void tdoa_ekf_init(void);
+void tdoa_ekf_set_model(const tdoa_model_config_t *model);
+void tdoa_ekf_update(uint8 cell, uint8 Ar, uint8 An, float distanceDiff, uint64_t rxTime, float varianceScale);
+uint8 tdoa_ekf_updates(void);
+void tdoa_ekf_get(tdoa_position_t *position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,19 +11,113 @@ extern "C" {
 #include "deca_types.h"
 #include "deca_device_api.h"
 #include "deca_regs.h"
+#include "deca_access.h"
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
 #include "port_deca.h"
+#include "tdoa_protocol.h"
+#include "tdoa_phy.h"
+#include "tdoa_clock.h"
+#include "tdoa_retain.h"
+#include "tdoa_rxpower.h"
+#include "tdoa_tdma.h"
+#include "tdoa_trace.h"
 
-#define NR_OF_ANCHORS        8
+#define NR_OF_ANCHORS        TDOA_MAX_ANCHORS   // Largest schedule, the one in use comes with every range packet
 #define SPEED_OF_LIGHT      (299702547.0)     // in m/s in air
 #define MASK_40BIT          (0x00FFFFFFFFFFUL)  // DW1000 counter is 40 bits
 #define MASK_TXDTS          (0x00FFFFFFFE00UL)  //The TX timestamp will snap to 8 ns resolution - mask lower 9 bits.
-#define PACKET_TYPE_RANGE    0x21
-#define MAX_DISTANCE_DIFF   (10.0f)
+#define PACKET_TYPE_RANGE    TDOA_RANGE_PACKET_TYPE
+#define MAX_DISTANCE_DIFF_MARGIN (0.5f)  // m, noise and multipath allowed over the baseline |An - Ar| of a pair
 #define LOCODECK_TS_FREQ    (499.2e6 * 128)
 
+#define SWS1_RAW_MODE       0x80    // S1 switch 8: stream raw timestamps, the host solves the clock model
+
+// Values of usb_out_t.type
+#define USB_DATA_TDOA       1       // tdoa holds a distance difference
+#define USB_DATA_RAW        2       // raw holds the timestamps of one packet
+#define USB_DATA_POSITION   3       // position holds the estimate of the on-tag filter
+#define USB_DATA_RANGES     4       // ranges holds the inter-anchor times of flight of one packet
+
+// Pairs a received packet of An is measured against, see tdoa_process. Raw mode always sends the consecutive pair
+#define TDOA_PAIRS_CONSECUTIVE	0	// The anchor received right before An
+#define TDOA_PAIRS_REFERENCE	1	// TDOA_REFERENCE_ANCHOR, one measurement per packet of any other anchor
+#define TDOA_PAIRS_ALL			2	// Every anchor received since the last packet of An, up to slots-1 measurements
+#define TDOA_PAIRS				TDOA_PAIRS_CONSECUTIVE
+#define TDOA_REFERENCE_ANCHOR	0
+
+#if TDOA_PAIRS == TDOA_PAIRS_ALL
+#define RX_MAX_PAIRS        (NR_OF_ANCHORS - 1)
+#else
+#define RX_MAX_PAIRS        1
+#endif
+
+// Pairing of a measurement with the packet of Ar it refers to, see matchArrival
+#define TAG_PAIR_HISTORY		4			// Arrivals kept per anchor, a power of two
+#define TAG_PAIR_MATCH_TICKS	638976		// ~10 us, largest difference of the tag and anchor intervals Ar to An
+
+#define RX_RING_SIZE        8       // Frames buffered between rx_ok_cb and tdoa_process, power of two
+#if TDOA_PAIRS == TDOA_PAIRS_ALL
+#define OUT_QUEUE_SIZE      64      // Measurements waiting for the USB, power of two, a frame may bring several
+#else
+#define OUT_QUEUE_SIZE      16      // Measurements waiting for the USB, power of two
+#endif
+#define USB_BATCH_FRAMES    1       // Send distance differences in batch frames, 0 for one frame each
+#define USB_RANGES_EVERY    32      // Packets of an anchor per ranges frame of it for the anchor survey, 0 for none
+#define USB_FRAME_VERSION   2       // Batch format, 2 adds timestamps, RX quality, the send time and the variance, 1 for older hosts
+#define USB_TELEMETRY_MS    1000    // Period of the telemetry frame, 0 disables it
+#define USB_SYNC_MS         100     // Period of the clock sync frame, 0 disables it
+#define TDOA_FAST_ISR       1       // Install tdoa_isr instead of the generic dwt_isr
+#define TDOA_DOUBLE_BUFFER  1       // Double-buffered receive, needs TDOA_FAST_ISR
+#define TAG_EKF             0       // Position filter on the tag once the host sent the anchors (tdoa_ekf.c)
+#define TAG_NLOS_DROP       1       // Drop distance differences of packets with a blocked first path (TDOA_QUALITY_NLOS)
+#define TAG_NLOS_VARIANCE   4.0f    // Variance scale for an attenuated first path (TDOA_QUALITY_NLOS_SUSPECT), squared for TDOA_QUALITY_NLOS
+#define TAG_VARIANCE_BASE   0.0225f // m^2, distance difference of a clean packet, (0.15 m)^2 as the host default stdDev
+#define TAG_VARIANCE_POWER_REF  (-85 * TDOA_RX_POWER_ONE)  // Receive power below which the variance grows
+#define TAG_VARIANCE_POWER_STEP (10 * TDOA_RX_POWER_ONE)   // Below it, one more TAG_VARIANCE_BASE per step
+#define TAG_VARIANCE_BIAS   2.0f    // Variance scale outside of the range bias table (TDOA_QUALITY_LOW_POWER, HIGH_POWER)
+#define TAG_VARIANCE_CLOCK  2.0f    // Variance scale while the clock fit of An is not settled
+#define TAG_VARIANCE_PAIR   2.0f    // Variance scale of a pair whose Ar is not the previous packet, or after a missed one
+#define TAG_CAPTURE         1       // Flash capture of every pair on the capture frame of the host (tag_capture.c)
+#define TAG_FRAME_FILTER    1       // DW1000 frame filter, only data frames to the range packet address with the PAN ID of the cell
+#define FAST_BOOT           1       // Start tracking right after the radio is up, without the splash delays and LED blinks
+#define TAG_OUTPUT_USART    0       // Frames to the host on USART2 by DMA instead of the USB virtual COM port
+#define TAG_USART_BAUD      921600  // Line rate of TAG_OUTPUT_USART, about 90 kB/s
+#define TAG_IWDG_MS         100     // Independent watchdog kicked by the main loop, above a flash page erase. 0 disables it
+#define TAG_RETAIN_MS       100     // Period of tdoa_save_state, the state a watchdog reset keeps
+
+#if TDOA_DOUBLE_BUFFER && !TDOA_FAST_ISR
+#error "TDOA_DOUBLE_BUFFER is only handled by tdoa_isr"
+#endif
+
+// Cell selection, see tdoa_cell_task. The tag starts in cell 0 and visits the others now and then
+#define TAG_CELLS				1		// Cells 0..TAG_CELLS-1 of the site, 1 disables the scan
+#define TAG_CELL_SCAN_MS		1000	// Between two visits of another cell
+#define TAG_CELL_DWELL_MS		20		// Visit of another cell, at least one of its TDMA frames
+#define TAG_CELL_LOST_MS		200		// Without a packet of the current cell the tag scans continuously
+#define TAG_CELL_MIN_PACKETS	2		// Packets of a visit needed to compare its power
+#define TAG_CELL_HYSTERESIS		(3 * TDOA_RX_POWER_ONE)	// Mean power another cell needs above the current one
+#define TAG_CELL_POWER_SHIFT	4		// Weight of a packet in the mean power of the current cell
+
+// PHY profile scan, see tdoa_phy_task. The tag starts on the profile and channel of its switches
+#define TAG_PHY_SCAN			1		// Scan the profiles of tdoa_phy.h on channels 2 and 5 while nothing is received
+#define TAG_PHY_LOST_MS			500		// Without a packet of any cell the tag scans
+#define TAG_PHY_DWELL_MS		(150 + TAG_CELLS * TAG_CELL_DWELL_MS)	// Per profile, a frame of the longest one and a visit of every cell
+
+// TDMA aware receive, see sniffPacket. Once the packets of the cell keep to the slot grid of their schedule the
+// receiver only opens around each expected slot, and listens continuously again while it acquires the grid
+#define TAG_SNIFF				1		// 0 listens continuously
+#define TAG_SNIFF_LOCK_PACKETS	4		// Packets in a row on the slot grid before the windows start
+#define TAG_SNIFF_SYMBOL_TICKS	65024	// DW1000 ticks per preamble symbol at 64 MHz PRF (~1.018 us), those of 16 MHz are shorter
+#define TAG_SNIFF_TOLERANCE		(8 * TAG_SNIFF_SYMBOL_TICKS)	// A packet this far off the grid still counts as on it
+#define TAG_SNIFF_GUARD			16		// Symbols a window opens before the preamble of its slot
+
+#if (TAG_CELLS < 1) || (TAG_CELLS > TDOA_MAX_CELLS)
+#error "TAG_CELLS must be 1 to TDOA_MAX_CELLS"
+#endif
+
 typedef union dwTime_u {
 	uint8 raw[5];
 	uint64_t full;
@@ -41,13 +135,36 @@ typedef struct {
 	uint8 prevAnc;
 	uint8 currAnc;
 	float distanceDiff;
+	uint8 idx;				// Packet index of currAnc
+	uint64_t rxTime;		// Corrected arrival of the packet of currAnc
+	int16_t rxPower;		// 1/64 dBm (TDOA_RX_POWER_SHIFT)
+	uint8 quality;			// TDOA_QUALITY_* bits
+	float variance;			// m^2, of distanceDiff (measurementVariance)
 } usb_msg_t;
 
+// One entry of the USB output queue
+typedef struct {
+	uint8 type;
+	union {
+		usb_msg_t tdoa;
+		tdoa_raw_frame_t raw;
+		tdoa_position_t position;
+#if USB_RANGES_EVERY
+		tdoa_ranges_t ranges;
+#endif
+	};
+} usb_out_t;
+
+// Fixed part of the range packet with room for the largest entry bitmap, followed by the entries of tdoa_tdma.h
 typedef struct rangePacket_s {
 	uint8 type;
 	uint8 Idx;				//TX time at master
-	uint32_t timestamps[NR_OF_ANCHORS];	//Relevant time for anchors
-	uint16_t distances[NR_OF_ANCHORS];
+	uint8 anchors;			//TDMA schedule of anchor 0
+	uint16_t slotUnits;
+	uint32_t txTime;		//TX time of the sender
+	uint16_t active;		//Slots of the frame, from anchor 0
+	uint8 join;
+	uint8 bitmap[TDOA_RANGE_BITMAP_SIZE(NR_OF_ANCHORS)];
 }__attribute__((packed)) rangePacket_t;
 
 typedef struct packet_s {
@@ -71,28 +188,110 @@ typedef struct packet_s {
 	uint8_t destAddress[8];
 	uint8_t sourceAddress[8];
 
-	uint8_t payload[64];
+	uint8_t payload[TDOA_RANGE_PAYLOAD_MAX_SIZE];
 } __attribute__((packed)) packet_t;
 
-uint8 anc_prf, anc_chan;
-uint32 tx_failed_count;
+// Offsets of the fields rx_ok_cb reads from the receive buffer
+#define RX_PAN_OFFSET			offsetof(packet_t, pan)
+#define RX_SOURCE_OFFSET		offsetof(packet_t, sourceAddress)
+#define RX_RANGE_OFFSET			offsetof(packet_t, payload)
+#define RX_ENTRY_OFFSET(n, i)	(RX_RANGE_OFFSET + TDOA_RANGE_ENTRY_OFFSET(n, i))
+#define RX_RANGE_PACKET_LEN(n, e)	(RX_RANGE_OFFSET + TDOA_RANGE_PAYLOAD_SIZE(n, e))
+
+#define RX_TIME_FP_LEN			(RX_TIME_FP_AMPL1_OFFSET + 2)	// RX_TIME up to FP_AMPL1
+
+// Receive registers of one good frame, read in the interrupt before the frame itself
+typedef struct tdoa_rx_regs_s {
+	uint32 status;						// SYS_STATUS, low 32 bits
+	uint8 finfo[RX_FINFO_LEN];
+	uint8 fqual[RX_FQUAL_LEN];
+	uint8 rxTime[RX_TIME_FP_LEN];		// Adjusted arrival time, FP_AMPL1 at RX_TIME_FP_AMPL1_OFFSET
+} tdoa_rx_regs_t;
 
-usb_msg_t usbData;
-volatile uint8 usbDataReady;
+// Entry of one anchor Ar in a range packet of An
+typedef struct rx_pair_s {
+	uint8 Ar;
+	uint16_t tofAr_to_An;
+	uint32_t rxAr_by_An;				// Decoded from the entry of Ar, 0 without one
+} rx_pair_t;
+
+// Last TAG_PAIR_HISTORY arrival times of the packets of one anchor, tag clock
+typedef struct rx_history_s {
+	uint64_t arrival[TAG_PAIR_HISTORY];
+	uint8 head;							// Next entry to write
+	uint8 count;
+} rx_history_t;
+
+// What rx_ok_cb keeps of one received range packet of An
+typedef struct rx_frame_s {
+	dwTime_t arrival;					// Uncorrected arrival time
+	uint16 cirPower;					// CIR_PWR of RX_FQUAL
+	uint16 fpAmpl[3];					// FP_AMPL1 of RX_TIME, FP_AMPL2 and 3 of RX_FQUAL
+	uint8 rxFrameInfo[RX_FINFO_LEN];
+	uint8 Ar;							// Anchor received before An
+	uint8 An;
+	uint8 Idx;
+	uint8 slots;						// Anchor addresses in the TDMA schedule of the packet
+	uint16 active;						// Those with a slot in its frame
+	uint8 join;							// Anchor of the join slot, TDOA_NO_JOIN without
+	uint8 cell;							// Cell the receiver was tuned to
+	uint32_t txAn;						// Transmit time of the packet
+	uint8 pairs;						// Used entries of pair
+	rx_pair_t pair[RX_MAX_PAIRS];		// Anchors to measure An against, see TDOA_PAIRS
+#if USB_RANGES_EVERY
+	uint8 ranges;						// Used entries of rangeAr and rangeTof, 0 if not due
+	uint8 rangeAr[NR_OF_ANCHORS - 1];
+	uint16_t rangeTof[NR_OF_ANCHORS - 1];	// Ar to An, anchor clock ticks
+#endif
+} rx_frame_t;
+
+// State kept across a watchdog or software reset (common/tdoa_retain.h), taken back by tdoa_init with the same
+// switches: the cell and PHY profile the tag had found, the clock ratios to its anchors and the output mode. The arrival times
+// are on the clock of the DW1000, which the reset restarts, so they start over
+typedef struct tag_retain_s {
+	tdoa_retain_header_t header;
+	uint8 s1switch;
+	uint8 cell;							// tagCell
+	uint8 phyProfile;
+	uint8 chan;							// Of cell 0
+	double clockCorrection[NR_OF_ANCHORS];
+	int32_t clockSkew[NR_OF_ANCHORS];
+	uint8 clockValid[NR_OF_ANCHORS];
+	tdoa_output_config_t output;		// Output mode of the host (tag_output.h)
+} tag_retain_t;
+
+uint32 tx_failed_count;
 
 void tdoa_init(uint8 s1switch, dwt_config_t *config);
+uint8 tdoa_process(void);
+uint8 tdoa_rx_pending(void);
+void tdoa_cell_task(unsigned long now);
+void tdoa_phy_task(unsigned long now);
+void tdoa_save_state(void);
+
+usb_out_t *tdoa_out_peek(void);
+void tdoa_out_pop(void);
+uint8 tdoa_out_count(void);
+void tdoa_get_status(tdoa_status_t *status);
+void tdoa_usb_command(const uint8_t *msg, int len);
+const tdoa_anchor_config_t *tdoa_get_anchors(uint8 cell);
+void tdoa_get_telemetry(tdoa_telemetry_t *telemetry);
+uint64_t tdoa_sys_time(void);
+void tdoa_sync_arm(void);
+size_t tdoa_sync_sof(uint8_t *msg);
 
+void tdoa_isr(void);
 void rx_ok_cb(const dwt_cb_data_t *cb_data);
 void rx_to_cb(const dwt_cb_data_t *cb_data);
 void rx_err_cb(const dwt_cb_data_t *cb_data);
 
 
+#define FP_AMPL2_OFFSET	0x02
+#define FP_AMPL3_OFFSET	0x04
 #define CIR_PWR_OFFSET	0x06
-#define TWOPOWER17		131072.0f // 2^17
-#define DISTANCE_OF_RADIO_INV 213.139451293f
-void dwCorrectTimestamp(dwTime_t* timestamp);
-float dwGetReceivePower(void);
-float calculatePower(float base, float N);
+void dwCorrectTimestamp(dwTime_t* timestamp, int16 rxPower);
+int16 dwGetReceivePower(uint16 cirPower, const uint8 *rxFrameInfo);
+int16 dwGetFirstPathPower(const uint16 *fpAmpl, const uint8 *rxFrameInfo);
 
 #ifdef __cplusplus
 }
@@ -14,6 +14,8 @@
 #include "lcd.h"
 #include "port_deca.h"
 
+#include <string.h>
+
 #define rcc_init(x)					RCC_Configuration(x)
 #define systick_init(x)				SysTick_Configuration(x)
 #define rtc_init(x)					RTC_Configuration(x)
@@ -38,6 +40,20 @@ extern __IO unsigned long time32_incr;
 /* Internal functions prototypes. */
 static void LCD_Configuration(void);
 static void spi_peripheral_init(void);
+static void SPIx_DMA_Configuration(void);
+
+/* State of the SPIx DMA transfer in progress. */
+static volatile uint8_t spiDmaBusy = 0;
+static port_spi_done_t spiDmaDone = NULL;
+static uint8_t spiDmaDummy = 0;
+
+/* Transmit ring of the USARTx DMA output. The main loop writes at head, the DMA sends the
+ * chunk from tail and its interrupt moves tail past it. */
+static uint8_t usartTxRing[USARTx_DMA_TX_SIZE];
+static volatile uint16_t usartTxHead = 0;
+static volatile uint16_t usartTxTail = 0;
+static volatile uint16_t usartTxChunk = 0;	// Bytes of the transfer in progress, 0 when idle
+static uint32_t usartTxOverflows = 0;
 
 int No_Configuration(void)
 {
@@ -286,6 +302,9 @@ int RCC_Configuration(void)
 	/* Enable SPI1 clock */
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
 
+	/* Enable DMA1 clock, used for SPI1 */
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
 	/* Enable SPI2 clock */
 	RCC_APB1PeriphClockCmd(RCC_APB1Periph_SPI2, ENABLE);
 
@@ -971,6 +990,7 @@ static void LCD_Configuration(void)
 static void spi_peripheral_init(void)
 {
     spi_init();
+    SPIx_DMA_Configuration();
 
     // Initialise SPI2 peripheral for LCD control
     SPI2_Configuration();
@@ -981,6 +1001,221 @@ static void spi_peripheral_init(void)
     sleep_ms(10);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn SPIx_DMA_Configuration()
+ *
+ * @brief Enables the completion interrupt of the SPIx receive DMA channel. The channels themselves are programmed per
+ *        transfer, and the SPI DMA requests are only enabled during one, so SPI_ConfigFastRate() may reset SPIx.
+ *
+ * @param none
+ *
+ * @return none
+ */
+static void SPIx_DMA_Configuration(void)
+{
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	SPIx_DMA_RX_CHANNEL->CCR = 0;
+	SPIx_DMA_TX_CHANNEL->CCR = 0;
+	DMA1->IFCR = SPIx_DMA_FLAGS;
+
+	// Above the DW1000 IRQ (15), so a read started from its handler can complete
+	NVIC_InitStructure.NVIC_IRQChannel = SPIx_DMA_RX_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 10;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+}
+
+#pragma GCC optimize ("O3")
+static PORT_RAMFUNC void SPIx_DMA_stop(void)
+{
+	SPIx->CR2 &= (uint16_t)~(SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx);
+	SPIx_DMA_RX_CHANNEL->CCR = 0;
+	SPIx_DMA_TX_CHANNEL->CCR = 0;
+	DMA1->IFCR = SPIx_DMA_FLAGS;
+	spiDmaBusy = 0;
+}
+
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC void port_SPIx_DMA_start(const uint8_t *tx, uint8_t *rx, uint16_t length, port_spi_done_t done)
+{
+	spiDmaDone = done;
+	spiDmaBusy = 1;
+
+	SPIx_DMA_RX_CHANNEL->CPAR = (uint32_t)&SPIx->DR;
+	SPIx_DMA_RX_CHANNEL->CMAR = (uint32_t)(rx ? rx : &spiDmaDummy);
+	SPIx_DMA_RX_CHANNEL->CNDTR = length;
+	SPIx_DMA_TX_CHANNEL->CPAR = (uint32_t)&SPIx->DR;
+	SPIx_DMA_TX_CHANNEL->CMAR = (uint32_t)(tx ? tx : &spiDmaDummy);
+	SPIx_DMA_TX_CHANNEL->CNDTR = length;
+
+	// Without a buffer the channel stays on the dummy byte. Receive has the higher priority so it never overruns
+	spiDmaDummy = 0;
+	SPIx_DMA_RX_CHANNEL->CCR = DMA_Priority_VeryHigh | (rx ? DMA_MemoryInc_Enable : 0) | (done ? DMA_IT_TC : 0) | DMA_CCR1_EN;
+	SPIx_DMA_TX_CHANNEL->CCR = DMA_Priority_High | DMA_DIR_PeripheralDST | (tx ? DMA_MemoryInc_Enable : 0) | DMA_CCR1_EN;
+
+	SPIx->CR2 |= SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx;
+}
+
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC void port_SPIx_DMA_wait(void)
+{
+	while (spiDmaBusy)
+	{
+		// Transfers without a callback are completed here, the others by the interrupt
+		if ((spiDmaDone == NULL) && (DMA1->ISR & SPIx_DMA_RX_TC_FLAG))
+		{
+			SPIx_DMA_stop();
+		}
+	}
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn DMA1_Channel2_IRQHandler()
+ *
+ * @brief Completion of an SPIx DMA transfer started with a done callback.
+ *
+ * @param none
+ *
+ * @return none
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+	port_spi_done_t done = spiDmaDone;
+
+	SPIx_DMA_stop();
+
+	if (done != NULL)
+	{
+		done();
+	}
+}
+
+void port_USARTx_DMA_init(uint32_t baud)
+{
+	USART_InitTypeDef USART_InitStructure;
+	GPIO_InitTypeDef GPIO_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	// USART2 on PA2 (TX) and PA3 (RX) as on the EVB1000, DMA1 is already clocked for SPI1
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA | RCC_APB2Periph_AFIO, ENABLE);
+	GPIO_PinRemapConfig(GPIO_Remap_USART2, DISABLE);
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART2, ENABLE);
+
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_2;
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_Init(GPIOA, &GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_3;
+	GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+	USART_InitStructure.USART_BaudRate = baud;
+	USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+	USART_InitStructure.USART_StopBits = USART_StopBits_1;
+	USART_InitStructure.USART_Parity = USART_Parity_No;
+	USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+	USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
+	USART_Init(USARTx, &USART_InitStructure);
+
+	USARTx_DMA_TX_CHANNEL->CCR = 0;
+	USARTx_DMA_TX_CHANNEL->CPAR = (uint32_t)&USARTx->DR;
+	DMA1->IFCR = USARTx_DMA_TX_FLAGS;
+	usartTxHead = usartTxTail = usartTxChunk = 0;
+
+	// Same level as the DW1000 IRQ, neither preempts the other and both are short
+	NVIC_InitStructure.NVIC_IRQChannel = USARTx_DMA_TX_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 15;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	USART_DMACmd(USARTx, USART_DMAReq_Tx, ENABLE);
+	USART_Cmd(USARTx, ENABLE);
+}
+
+/*
+ * Starts the transfer of the bytes from tail, up to head or the end of the
+ * ring, the rest follows from the completion interrupt. Called with that
+ * interrupt masked or from it.
+ */
+#pragma GCC optimize ("O3")
+static void USARTx_DMA_next(void)
+{
+	const uint16_t head = usartTxHead;
+	const uint16_t tail = usartTxTail;
+
+	USARTx_DMA_TX_CHANNEL->CCR = 0;
+	if (head == tail)
+	{
+		usartTxChunk = 0;
+		return;
+	}
+	usartTxChunk = (head > tail) ? (head - tail) : (USARTx_DMA_TX_SIZE - tail);
+	USARTx_DMA_TX_CHANNEL->CMAR = (uint32_t)&usartTxRing[tail];
+	USARTx_DMA_TX_CHANNEL->CNDTR = usartTxChunk;
+	USARTx_DMA_TX_CHANNEL->CCR = DMA_Priority_Low | DMA_DIR_PeripheralDST | DMA_MemoryInc_Enable | DMA_IT_TC | DMA_CCR1_EN;
+}
+
+#pragma GCC optimize ("O3")
+int port_USARTx_DMA_send(const uint8_t *data, uint16_t length)
+{
+	if (length > port_USARTx_DMA_space())
+	{
+		usartTxOverflows++;
+		return 0;
+	}
+
+	// Only the main loop moves head, the copy may wrap around the end of the ring
+	uint16_t head = usartTxHead;
+	const uint16_t first = (length < (USARTx_DMA_TX_SIZE - head)) ? length : (USARTx_DMA_TX_SIZE - head);
+	memcpy(&usartTxRing[head], data, first);
+	memcpy(usartTxRing, data + first, length - first);
+	head = (head + length) & (USARTx_DMA_TX_SIZE - 1);
+	usartTxHead = head;
+
+	NVIC_DisableIRQ(USARTx_DMA_TX_IRQn);
+	if (usartTxChunk == 0)
+	{
+		USARTx_DMA_next();
+	}
+	NVIC_EnableIRQ(USARTx_DMA_TX_IRQn);
+	return 1;
+}
+
+uint16_t port_USARTx_DMA_space(void)
+{
+	// One byte stays free, so a full ring is told apart from an empty one
+	return USARTx_DMA_TX_SIZE - 1 - ((usartTxHead - usartTxTail) & (USARTx_DMA_TX_SIZE - 1));
+}
+
+int port_USARTx_DMA_idle(void)
+{
+	return (usartTxChunk == 0) && (usartTxHead == usartTxTail);
+}
+
+uint32_t port_USARTx_DMA_overflows(void)
+{
+	return usartTxOverflows;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn DMA1_Channel7_IRQHandler()
+ *
+ * @brief Completion of a USARTx DMA chunk, starts the next one if the ring holds more.
+ *
+ * @param none
+ *
+ * @return none
+ */
+void DMA1_Channel7_IRQHandler(void)
+{
+	DMA1->IFCR = USARTx_DMA_TX_FLAGS;
+	usartTxTail = (usartTxTail + usartTxChunk) & (USARTx_DMA_TX_SIZE - 1);
+	USARTx_DMA_next();
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @fn peripherals_init()
  *
@@ -993,6 +1228,7 @@ static void spi_peripheral_init(void)
 
 void peripherals_init (void)
 {
+	port_vector_table_to_ram();
 	rcc_init();
 	gpio_init();
 	interrupt_init();
@@ -24,7 +24,7 @@
 #include "stm32f10x_it.h"
 #include "port_deca.h"
 
-#ifdef USB_SUPPORT //this is set in the port_deca.h file
+#ifdef USB_SUPPORT //this is set in TREK_TAG.coproj
 
 #include "usb_core.h"
 #include "usbd_core.h"
@@ -242,7 +242,7 @@ void SysTick_Handler(void)
   * @retval None
   */
 
-void EXTI9_5_IRQHandler(void)
+PORT_RAMFUNC PORT_RAMFUNC void EXTI9_5_IRQHandler(void)
 {
     do
     {
@@ -253,7 +253,7 @@ void EXTI9_5_IRQHandler(void)
 }
 
 
-#ifdef USB_SUPPORT //this is set in the port_deca.h file
+#ifdef USB_SUPPORT //this is set in TREK_TAG.coproj
 
 #ifdef USE_USB_OTG_FS
 void OTG_FS_WKUP_IRQHandler(void)
@@ -19,12 +19,14 @@
 #include "deca_spi.h"
 
 #include "usbd_cdc_core.h"
+#include "usbd_msc_core.h"
 #include "usbd_usr.h"
 #include "usb_conf.h"
 #include "usbd_desc.h"
 
 #include "string.h"
 #include "sleep.h"
+#include "tdoa_protocol.h"
 
 /** @defgroup USB_VCP_Private_Variables
   * @{
@@ -43,14 +45,26 @@ __ALIGN_BEGIN USB_OTG_CORE_HANDLE    USB_OTG_dev __ALIGN_END ;
 int local_buff_length = 0;
 uint8_t local_buff[512];
 uint16_t local_buff_offset = 0;
-int tx_buff_length = 0;
-uint8_t tx_buff[64];
 uint8_t local_have_data = 0;
 
+// IN path, double buffered: DW_VCP_DataTx appends to usbTx[usbTxFill] while
+// the CDC core sends the other one, DW_VCP_TxSwap exchanges them once the
+// transfer completed
+#ifdef USB_OTG_HS_INTERNAL_DMA_ENABLED
+  #if defined ( __ICCARM__ ) /*!< IAR Compiler */
+    #pragma data_alignment=4
+  #endif
+#endif /* USB_OTG_HS_INTERNAL_DMA_ENABLED */
+__ALIGN_BEGIN static uint8_t usbTx[2][CDC_IN_BUFFER_SIZE] __ALIGN_END;
+static volatile uint16_t usbTxLength[2];
+static volatile uint8_t usbTxFill = 0;
+static volatile uint8_t usbTxWriting = 0;	// DW_VCP_DataTx is copying into usbTx[usbTxFill]
+static uint32_t usbTxOverflows = 0;		// Messages refused for lack of space
+
 int version_size;
 uint8* version;
 int s1configswitch;
-extern uint32_t APP_Rx_length;
+extern uint8_t  USB_Tx_State;
 
 
 uint16_t DW_VCP_Init     (void) { return USBD_OK; }
@@ -77,31 +91,59 @@ uint16_t DW_VCP_Ctrl (uint32_t Cmd, uint8_t* Buf, uint32_t Len)
   *         this function.
   * @param  Buf: Buffer of data to be sent
   * @param  Len: Number of data to be sent (in bytes)
-  * @retval Result of the operation: USBD_OK if all operations are OK else VCP_FAIL
+  * @retval Result of the operation: USBD_OK if all operations are OK else
+  *         USBD_FAIL, the message does not fit and nothing was written
   */
 #pragma GCC optimize ("O3")
 uint16_t DW_VCP_DataTx (uint8_t* Buf, uint32_t Len)
 {
-	int i = 0;
+	// Keeps DW_VCP_TxSwap from sending the buffer half written
+	usbTxWriting = 1;
+	const uint8_t b = usbTxFill;
+	const uint32_t used = usbTxLength[b];
+
+	if((used + Len) > CDC_IN_BUFFER_SIZE)
+	{
+		usbTxWriting = 0;
+		usbTxOverflows++;
+		return USBD_FAIL;
+	}
+	memcpy(&usbTx[b][used], Buf, Len);
+	usbTxLength[b] = used + Len;
+	usbTxWriting = 0;
+
+	return USBD_OK;
+}
 
-	i = APP_Rx_ptr_in ;
+/*
+ * CDC core, SOF and transfer complete interrupts, only while no IN transfer
+ * is pending: the buffer sent last is free again and becomes the one filled,
+ * the filled one is returned for the next transfer. Returns its length, 0
+ * if there is nothing to send or DW_VCP_DataTx is writing to it.
+ */
+uint32_t DW_VCP_TxSwap(uint8_t **buffer)
+{
+	const uint8_t b = usbTxFill;
 
-	if ((APP_Rx_length+Len) < APP_RX_DATA_SIZE)
+	if(usbTxWriting || (usbTxLength[b] == 0))
 	{
-		int l;
-		/* Get the data to be sent */
-		for (l = 0; l < Len; l++)
-		{
-			APP_Rx_Buffer[i++] = Buf[l];
-			/* Increment the in pointer */
-			if (i>=APP_RX_DATA_SIZE)
-				i=0;
-		}
+		return 0;
 	}
+	usbTxLength[b ^ 1] = 0;
+	usbTxFill = b ^ 1;
+	*buffer = usbTx[b];
+	return usbTxLength[b];
+}
 
-	APP_Rx_ptr_in = i;
+// Bytes DW_VCP_DataTx takes now, only grows until the caller writes
+uint16_t usb_tx_space(void)
+{
+	return CDC_IN_BUFFER_SIZE - usbTxLength[usbTxFill];
+}
 
-	return USBD_OK;
+uint32_t usb_tx_overflows(void)
+{
+	return usbTxOverflows;
 }
 
 
@@ -185,25 +227,20 @@ uint16_t DW_VCP_DataRx (uint8_t* Buf, uint32_t Len)
   return USBD_OK;
 }
 
+extern void tdoa_usb_command(const uint8_t *msg, int len);
+
 #pragma GCC optimize ("O3")
 int process_usbmessage(void)
 {
 	int result = 0;
+	tdoa_usb_command(local_buff, local_buff_length);
 	return result;
 }
+// Nonzero if the message was queued for the IN endpoint, see usb_tx_space for backpressure
 #pragma GCC optimize ("O3")
-void send_usbmessage(uint8 *string, int len)
+int send_usbmessage(uint8 *string, int len)
 {
-	if(local_have_data == 0)
-	{
-		memcpy(&tx_buff[0], string, len);
-//		tx_buff[len] = '\r';
-//		tx_buff[len+1] = '\n';
-//		tx_buff_length = len + 2;
-		tx_buff_length = len;
-
-		local_have_data = 2;
-	}
+	return DW_VCP_DataTx(string, len) == USBD_OK;
 }
 /**
 **===========================================================================
@@ -225,6 +262,23 @@ int usb_init(void)
     return 0;
 }
 
+// The tag as the read-only USB drive of its flash capture instead of the virtual COM port
+int usb_init_msc(void)
+{
+	led_off(LED_ALL);
+
+	USBD_USR_SetMassStorage();
+	USBD_Init(&USB_OTG_dev,USB_OTG_FS_CORE_ID,&USR_desc,&USBD_MSC_cb,&USR_cb);
+
+	return 0;
+}
+
+// Nonzero once everything written by DW_VCP_DataTx has left on the IN endpoint
+int usb_tx_idle(void)
+{
+	return (USB_Tx_State == 0) && (usbTxLength[usbTxFill] == 0);
+}
+
 #pragma GCC optimize ("O3")
 void usb_run(void)
 {
@@ -234,10 +288,23 @@ void usb_run(void)
 	{
 		local_have_data = process_usbmessage();
 	}
-	else if(local_have_data == 2) //have data to send (over USB)
+}
+
+extern size_t tdoa_sync_sof(uint8_t *msg);
+
+// SOF interrupt, before the IN transfer of the frame is set up: the clock sync frame of the tag goes out in it
+void DW_VCP_SOF(void)
+{
+	uint8_t msg[TDOA_SYNC_FRAME_SIZE];
+
+	// A frame half written by the main loop would be split, the sync waits for the next SOF
+	if(!usbTxWriting)
 	{
-		DW_VCP_DataTx(tx_buff, tx_buff_length);
-		local_have_data = 0;
+		const size_t len = tdoa_sync_sof(msg);
+		if(len > 0)
+		{
+			DW_VCP_DataTx(msg, len);
+		}
 	}
 }
 
@@ -24,17 +24,10 @@ extern uint8_t local_have_data;
 extern uint16_t local_buff_offset;
 
 
-//library data
-/* These are external variables imported from CDC core to be used for IN
-   transfer management. */
-extern uint8_t  APP_Rx_Buffer []; /* Write CDC received data in this buffer.
-                                     These data will be sent over USB IN endpoint
-                                     in the CDC core functions. */
-extern uint32_t APP_Rx_ptr_in;    /* Increment this pointer or roll it back to
-                                     start address when writing received data
-                                     in the buffer APP_Rx_Buffer. */
-extern uint32_t APP_Rx_length;
-
+//IN path: DW_VCP_DataTx appends to one buffer while the CDC core sends the other
+uint32_t DW_VCP_TxSwap   (uint8_t **buffer);
+uint16_t usb_tx_space    (void);
+uint32_t usb_tx_overflows(void);
 
 
 /* Private function prototypes -----------------------------------------------*/
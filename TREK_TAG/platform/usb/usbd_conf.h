@@ -55,21 +55,24 @@
  #define CDC_CMD_PACKET_SZE             8    /* Control Endpoint Packet size */
 
  #define CDC_IN_FRAME_INTERVAL          40   /* Number of micro-frames between IN transfers */
- #define APP_RX_DATA_SIZE               2048 /* Total size of IN buffer: 
-                                                APP_RX_DATA_SIZE*8/MAX_BAUDARATE*1000 should be > CDC_IN_FRAME_INTERVAL*8 */
+ #define CDC_IN_BUFFER_SIZE             2048 /* Bytes of each of the two IN buffers, a transfer sends one of them */
 #else
  #define CDC_DATA_MAX_PACKET_SIZE       64   /* Endpoint IN & OUT Packet size */
  #define CDC_CMD_PACKET_SZE             8    /* Control Endpoint Packet size */
 
  #define CDC_IN_FRAME_INTERVAL          (1)   //ZS change 5 to 1 /* Number of frames between IN transfers */
-//ZS - need to make buffer larger to handle Accumulator data (largest data here is 1016*4+1 = 4065 + 3 control messages from PC VCP driver)
-//#define APP_RX_DATA_SIZE               2048 /* Total size of IN buffer:
-#define APP_RX_DATA_SIZE               (2048*2) /* Total size of IN buffer:
-                                                APP_RX_DATA_SIZE*8/MAX_BAUDARATE*1000 should be > CDC_IN_FRAME_INTERVAL */
+ #define CDC_IN_BUFFER_SIZE             512  /* Bytes of each of the two IN buffers, a transfer sends one of them.
+                                                At most 19 packets of 64 bytes fit a full speed frame */
 #endif /* USE_USB_OTG_HS */
 
 #define APP_FOPS                        VCP_fops
 
+/* Mass storage of the flash capture (tag_capture.h), the same endpoints as CDC, only one class runs */
+#define MSC_IN_EP                       0x81
+#define MSC_OUT_EP                      0x01
+#define MSC_MAX_PACKET                  64
+#define MSC_MEDIA_PACKET                512   /* Bytes the SCSI layer reads per call, one block */
+
 #define USBD_EP0_MAX_PACKET_SIZE   64
 
 /**
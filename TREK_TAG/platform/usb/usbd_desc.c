@@ -56,6 +56,7 @@
 #define USBD_VID                        0x0483
 
 #define USBD_PID                        0x5740
+#define USBD_MSC_PID                    0x5720  /* Mass storage while the tag exports its flash capture */
 
 /** @defgroup USB_String_Descriptors
   * @{
@@ -74,6 +75,8 @@
 
 #define USBD_CONFIGURATION_FS_STRING    ((uint8_t *)"VCP Config")
 #define USBD_INTERFACE_FS_STRING        ((uint8_t *)"VCP Interface")
+
+#define USBD_PRODUCT_MSC_STRING         ((uint8_t *)"TREK Tag Capture")
 /**
   * @}
   */ 
@@ -164,6 +167,8 @@ __ALIGN_BEGIN uint8_t USBD_LangIDDesc[USB_SIZ_STRING_LANGID] __ALIGN_END =
      LOBYTE(USBD_LANGID_STRING),
      HIBYTE(USBD_LANGID_STRING), 
 };
+
+static uint8_t massStorage = 0;  /* Set by USBD_USR_SetMassStorage */
 /**
   * @}
   */ 
@@ -208,6 +213,19 @@ uint8_t *  USBD_USR_LangIDStrDescriptor( uint8_t speed , uint16_t *length)
 }
 
 
+/**
+* @brief  USBD_USR_SetMassStorage
+*         describes the tag as the mass storage device of its flash capture,
+*         before USBD_Init with the MSC class
+* @retval None
+*/
+void USBD_USR_SetMassStorage(void)
+{
+  massStorage = 1;
+  USBD_DeviceDesc[10] = LOBYTE(USBD_MSC_PID);
+  USBD_DeviceDesc[11] = HIBYTE(USBD_MSC_PID);
+}
+
 /**
 * @brief  USBD_USR_ProductStrDescriptor 
 *         return the product string descriptor
@@ -219,7 +237,11 @@ uint8_t *  USBD_USR_ProductStrDescriptor( uint8_t speed , uint16_t *length)
 {
  
   
-  if(speed == 0)
+  if(massStorage)
+  {
+    USBD_GetString (USBD_PRODUCT_MSC_STRING, USBD_StrDesc, length);
+  }
+  else if(speed == 0)
   {   
     USBD_GetString (USBD_PRODUCT_HS_STRING, USBD_StrDesc, length);
   }
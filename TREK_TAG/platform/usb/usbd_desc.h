@@ -99,6 +99,7 @@ uint8_t *     USBD_USR_ProductStrDescriptor ( uint8_t speed , uint16_t *length);
 uint8_t *     USBD_USR_SerialStrDescriptor( uint8_t speed , uint16_t *length);
 uint8_t *     USBD_USR_ConfigStrDescriptor( uint8_t speed , uint16_t *length);
 uint8_t *     USBD_USR_InterfaceStrDescriptor( uint8_t speed , uint16_t *length);
+void          USBD_USR_SetMassStorage(void);
 
 #ifdef USB_SUPPORT_USER_STRING_DESC
 uint8_t *     USBD_USR_USRStringDesc (uint8_t speed, uint8_t idx , uint16_t *length);  
@@ -0,0 +1,210 @@
+/*! ----------------------------------------------------------------------------
+ * @file	usbd_storage_capture.c
+ * @brief	Storage of the MSC class while the tag exports its flash capture
+ *
+ * A read-only FAT12 disk made up on the fly: boot block, two copies of a one
+ * block FAT, a one block root directory with the file CAPTURE.BIN, then one
+ * cluster per capture page. The file clusters are the capture pages in the
+ * order of tag_capture_scan, read straight from flash, nothing is copied
+ * into RAM beyond the block the SCSI layer asks for.
+ */
+
+#include "usbd_msc_mem.h"
+#include "tag_capture.h"
+
+#include <string.h>
+
+#define DISK_BLOCK_SIZE			512
+#define DISK_CLUSTER_BLOCKS		(TDOA_CAPTURE_PAGE_SIZE / DISK_BLOCK_SIZE)	// One capture page per cluster
+#define DISK_FATS				2
+#define DISK_FAT_BLOCK			1
+#define DISK_ROOT_BLOCK			(DISK_FAT_BLOCK + DISK_FATS)
+#define DISK_ROOT_ENTRIES		(DISK_BLOCK_SIZE / 32)
+#define DISK_DATA_BLOCK			(DISK_ROOT_BLOCK + 1)
+#define DISK_BLOCKS				(DISK_DATA_BLOCK + CAPTURE_PAGES * DISK_CLUSTER_BLOCKS)
+#define DISK_MEDIA				0xF8
+#define DISK_FAT_END			0xFFF
+
+#if (CAPTURE_PAGES + 2) > (DISK_BLOCK_SIZE * 2 / 3)
+#error "The FAT of the capture needs more than one block"
+#endif
+
+static uint8 pages;
+
+int8_t STORAGE_Init (uint8_t lun);
+int8_t STORAGE_GetCapacity (uint8_t lun, uint32_t *block_num, uint32_t *block_size);
+int8_t STORAGE_IsReady (uint8_t lun);
+int8_t STORAGE_IsWriteProtected (uint8_t lun);
+int8_t STORAGE_Read (uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t STORAGE_Write (uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+int8_t STORAGE_GetMaxLun (void);
+
+/* USB Mass storage Standard Inquiry Data */
+const int8_t STORAGE_Inquirydata[] = {//36
+	0x00,
+	0x80,		// Removable
+	0x02,
+	0x02,
+	(USBD_STD_INQUIRY_LENGTH - 5),
+	0x00,
+	0x00,
+	0x00,
+	'D', 'E', 'C', 'A', 'W', 'A', 'V', 'E', /* Manufacturer : 8 bytes */
+	'T', 'R', 'E', 'K', ' ', 'C', 'a', 'p', /* Product      : 16 Bytes */
+	't', 'u', 'r', 'e', ' ', ' ', ' ', ' ',
+	'0', '.', '0', '1',                     /* Version      : 4 Bytes */
+};
+
+USBD_STORAGE_cb_TypeDef USBD_CAPTURE_fops =
+{
+	STORAGE_Init,
+	STORAGE_GetCapacity,
+	STORAGE_IsReady,
+	STORAGE_IsWriteProtected,
+	STORAGE_Read,
+	STORAGE_Write,
+	STORAGE_GetMaxLun,
+	(int8_t *)STORAGE_Inquirydata,
+};
+
+USBD_STORAGE_cb_TypeDef *USBD_STORAGE_fops = &USBD_CAPTURE_fops;
+
+static void put16(uint8_t *b, uint16_t value)
+{
+	b[0] = (uint8_t)value;
+	b[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *b, uint32_t value)
+{
+	put16(b, (uint16_t)value);
+	put16(b + 2, (uint16_t)(value >> 16));
+}
+
+static void bootBlock(uint8_t *b)
+{
+	memcpy(&b[0], "\xEB\x3C\x90" "TREKTAG ", 11);
+	put16(&b[11], DISK_BLOCK_SIZE);
+	b[13] = DISK_CLUSTER_BLOCKS;
+	put16(&b[14], DISK_FAT_BLOCK);			// Reserved blocks, the boot block
+	b[16] = DISK_FATS;
+	put16(&b[17], DISK_ROOT_ENTRIES);
+	put16(&b[19], DISK_BLOCKS);
+	b[21] = DISK_MEDIA;
+	put16(&b[22], 1);						// Blocks per FAT
+	put16(&b[24], 1);						// Blocks per track
+	put16(&b[26], 1);						// Heads
+	b[36] = 0x80;							// Drive number
+	b[38] = 0x29;							// Extended boot signature
+	put32(&b[39], TDOA_CAPTURE_MAGIC);		// Volume ID
+	memcpy(&b[43], "TAG CAPTUREFAT12   ", 19);
+	b[510] = 0x55;
+	b[511] = 0xAA;
+}
+
+// 12 bit entry of cluster
+static void fatSet(uint8_t *b, uint16_t cluster, uint16_t value)
+{
+	const uint16_t i = cluster + cluster / 2;
+
+	if (cluster & 1)
+	{
+		b[i] = (uint8_t)((b[i] & 0x0F) | (value << 4));
+		b[i+1] = (uint8_t)(value >> 4);
+	}
+	else
+	{
+		b[i] = (uint8_t)value;
+		b[i+1] = (uint8_t)((b[i+1] & 0xF0) | ((value >> 8) & 0x0F));
+	}
+}
+
+// The file is one chain from cluster 2
+static void fatBlock(uint8_t *b)
+{
+	uint16_t k;
+
+	fatSet(b, 0, 0xF00 | DISK_MEDIA);
+	fatSet(b, 1, DISK_FAT_END);
+	for (k = 0; k < pages; k++)
+	{
+		fatSet(b, 2 + k, (k + 1 < pages) ? 3 + k : DISK_FAT_END);
+	}
+}
+
+static void rootBlock(uint8_t *b)
+{
+	memcpy(&b[0], "TAG CAPTURE", 11);
+	b[11] = 0x08;							// Volume label
+	memcpy(&b[32], TDOA_CAPTURE_FILE_NAME, 11);
+	b[32 + 11] = 0x01;						// Read only
+	put16(&b[32 + 26], pages ? 2 : 0);		// First cluster
+	put32(&b[32 + 28], (uint32_t)pages * TDOA_CAPTURE_PAGE_SIZE);
+}
+
+int8_t STORAGE_Init (uint8_t lun)
+{
+	pages = tag_capture_scan();
+	return 0;
+}
+
+int8_t STORAGE_GetCapacity (uint8_t lun, uint32_t *block_num, uint32_t *block_size)
+{
+	*block_num = DISK_BLOCKS;
+	*block_size = DISK_BLOCK_SIZE;
+	return 0;
+}
+
+int8_t STORAGE_IsReady (uint8_t lun)
+{
+	return 0;
+}
+
+int8_t STORAGE_IsWriteProtected (uint8_t lun)
+{
+	return 1;
+}
+
+int8_t STORAGE_Read (uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	for (; blk_len > 0; blk_len--, blk_addr++, buf += DISK_BLOCK_SIZE)
+	{
+		memset(buf, 0, DISK_BLOCK_SIZE);
+		if (blk_addr == 0)
+		{
+			bootBlock(buf);
+		}
+		else if (blk_addr < DISK_ROOT_BLOCK)
+		{
+			fatBlock(buf);
+		}
+		else if (blk_addr == DISK_ROOT_BLOCK)
+		{
+			rootBlock(buf);
+		}
+		else if (blk_addr < DISK_BLOCKS)
+		{
+			const uint32_t block = blk_addr - DISK_DATA_BLOCK;
+			const uint32_t k = block / DISK_CLUSTER_BLOCKS;
+			if (k < pages)
+			{
+				memcpy(buf, tag_capture_page((uint8)k) + (block % DISK_CLUSTER_BLOCKS) * DISK_BLOCK_SIZE, DISK_BLOCK_SIZE);
+			}
+		}
+		else
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int8_t STORAGE_Write (uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+	return -1;
+}
+
+int8_t STORAGE_GetMaxLun (void)
+{
+	return 0;
+}
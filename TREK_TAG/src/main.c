@@ -8,17 +8,44 @@
 #include "lcd.h"
 #include "deca_spi.h"
 #include "tdoa_tag.h"
+#include "tdoa_protocol.h"
+#include "tag_capture.h"
 
 
 
 extern void usb_run(void);
 extern int usb_init(void);
+extern int usb_init_msc(void);
 extern void usb_printconfig(int, uint8*, int);
-extern void send_usbmessage(uint8*, int);
+extern int send_usbmessage(uint8*, int);
+extern int usb_tx_idle(void);
+extern uint16_t usb_tx_space(void);
+extern uint32_t usb_tx_overflows(void);
+
+// Room the output buffer needs before an entry of the output queue is taken, its largest frame
+#define USB_OUT_FRAME_MAX_SIZE	TDOA_V2_FRAME_MAX_SIZE
+
+/*
+ * Output of the frames to the host, the USB virtual COM port or with
+ * TAG_OUTPUT_USART the DMA ring of USART2. Both take whole frames or refuse
+ * them, and neither costs the CPU per byte. usb_run stays, host commands
+ * still come over the USB port
+ */
+#if TAG_OUTPUT_USART
+#define out_send(frame, len)	port_USARTx_DMA_send((frame), (len))
+#define out_space()				port_USARTx_DMA_space()
+#define out_idle()				port_USARTx_DMA_idle()
+#define out_overflows()			port_USARTx_DMA_overflows()
+#else
+#define out_send(frame, len)	send_usbmessage((frame), (len))
+#define out_space()				usb_tx_space()
+#define out_idle()				usb_tx_idle()
+#define out_overflows()			usb_tx_overflows()
+#endif
 
 #define SWS1_SHF_MODE 0x02	//short frame mode (6.81M)
 #define SWS1_CH5_MODE 0x04	//channel 5 mode
-#define SWS1_ANC_MODE 0x08  //anchor mode
+#define SWS1_PHY_MODE 0x08  //850k and 64-symbol 6.81M profiles instead of 110k and 128-symbol 6.81M
 #define SWS1_A1A_MODE 0x10  //anchor/tag address A1
 #define SWS1_A2A_MODE 0x20  //anchor/tag address A2
 #define SWS1_A3A_MODE 0x40  //anchor/tag address A3
@@ -44,6 +71,7 @@ typedef struct
 
 
 //Configuration for DecaRangeRTLS TREK Modes (4 default use cases selected by the switch S1 [2,3] on EVB1000, indexed 0 to 3 )
+//Only the channel is used, tdoa_phy_config sets rate, PRF, preamble and SFD of the profile
 dwt_config_t chConfig[4] ={
 	//mode 1 - S1: 2 off, 3 off
 	{
@@ -115,12 +143,16 @@ void initLCD(void)
 }
 
 
-uint32 init_deca(uint8 s1switch)
+uint32 init_deca(uint8 sw_mode)
 {
     uint32 devID ;
 
     /* Install DW1000 IRQ handler. */
+#if TDOA_FAST_ISR
+    port_set_deca_isr(tdoa_isr);
+#else
     port_set_deca_isr(dwt_isr);
+#endif
 
 	//reset the DW1000 by driving the RSTn line low
     reset_DW1000();
@@ -145,7 +177,6 @@ uint32 init_deca(uint8 s1switch)
 
     //instance_anchaddr = (((s1switch & SWS1_A1A_MODE) << 2) + (s1switch & SWS1_A2A_MODE) + ((s1switch & SWS1_A3A_MODE) >> 2)) >> 4;
 
-    int sw_mode = 1;
 	dwt_configure(&chConfig[sw_mode]);
 
 	dwt_setleds(1);
@@ -153,27 +184,33 @@ uint32 init_deca(uint8 s1switch)
     return devID;
 }
 
-uint16_t serial_checksum(uint8_t* data, int len)
+/*
+ * Sleeps the core until the next interrupt, the DW1000, USB or the 1 ms
+ * SysTick, unless a received frame already waits. Interrupts stay masked
+ * from the check to the WFI, a frame arriving in between still wakes it.
+ */
+static void waitForInterrupt(void)
 {
-	uint16 sum1 = 0xFF, sum2 = 0xFF;
-
-	while (len)
+	__disable_irq();
+	if(!tdoa_rx_pending())
 	{
-		unsigned tlen = len > 21 ? 21 : len;
-		len -= tlen;
-		do {
-			sum1 += *data++;
-			sum2 += sum1;
-		} while (--tlen);
-		sum1 = (sum1 & 0xff) + (sum1 >> 8);
-		sum2 = (sum2 & 0xff) + (sum2 >> 8);
+		__WFI();
 	}
-	/* Second reduction step to reduce sums to 16 bits */
-	sum1 = (sum1 & 0xFF) + (sum1 >> 8);
-	sum2 = (sum2 & 0xFF) + (sum2 >> 8);
-	return sum2 << 8 | sum1;
+	__enable_irq();
 }
 
+/*
+ * Pause of the start sequence, for reading the LCD. None with FAST_BOOT,
+ * tracking then starts as soon as the radio is up
+ */
+static void bootDelay(unsigned int ms)
+{
+#if FAST_BOOT
+	(void)ms;
+#else
+	sleep_ms(ms);
+#endif
+}
 
 /**
 **===========================================================================
@@ -192,8 +229,6 @@ uint16_t serial_checksum(uint8_t* data, int len)
 //#pragma GCC optimize ("O3")
 int main(void)
 {
-	int i;
-
 	led_off(LED_ALL); //turn off all the LEDs
 
 	peripherals_init();
@@ -204,11 +239,28 @@ int main(void)
 	memcpy(dataseq, (const uint8 *) "TDOA TAG        ", 16); // Also set at line #26 (Should make this from single value !!!)
 	writetoLCD( 16, 1, dataseq); //send some data
 
-	sleep_ms(1000);
+	bootDelay(1000);
+
+#if TAG_CAPTURE
+	// Reset into the export of the flash capture, a USB drive until the next reset
+	tag_capture_init();
+	if(tag_capture_export_pending())
+	{
+		lcd_display_str("CAPTURE EXPORT");
+		usb_init_msc();
+		while(1)
+		{
+			__WFI();
+		}
+	}
+#endif
 
 	usb_init();
+#if TAG_OUTPUT_USART
+	port_USARTx_DMA_init(TAG_USART_BAUD);
+#endif
 
-	sleep_ms(1000);
+	bootDelay(1000);
 
 	s1switch = is_button_low(0) << 1 // is_switch_on(TA_SW1_2) << 2
 			| is_switch_on(TA_SW1_3) << 2
@@ -220,12 +272,23 @@ int main(void)
 
 	port_DisableEXT_IRQ(); //disable ScenSor IRQ until we configure the device
 
+	// PHY profile and channel the tag starts on, the switches of the anchors. Without
+	// packets tdoa_phy_task scans the other profiles and channels
+	uint8 profile;
+	if(s1switch & SWS1_PHY_MODE) profile = (s1switch & SWS1_SHF_MODE) ? TDOA_PHY_SHORT : TDOA_PHY_MEDIUM;
+	else profile = (s1switch & SWS1_SHF_MODE) ? TDOA_PHY_STANDARD : TDOA_PHY_LONG;
+	int sw_mode = (s1switch & SWS1_CH5_MODE) ? 2 : 0;
+	dwt_config_t *config = &chConfig[sw_mode];
+	tdoa_phy_config(profile, config);
+	tdoa_cell_radio(0, config->chan, config->prf == DWT_PRF_64M, &config->chan, &config->txCode);
+	config->rxCode = config->txCode;
+
 
     //run TDOA application for TREK
 
 	led_off(LED_ALL);
 
-	if(init_deca(s1switch) == (uint32)-1)
+	if(init_deca(sw_mode) == (uint32)-1)
 	{
 		led_on(LED_ALL); //to display error....
 		lcd_display_str("  INIT FAIL ");
@@ -237,13 +300,13 @@ int main(void)
 	lcd_str[15] = ((((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2)) >> 4) + 0x30; //converts to ASCII number
 	lcd_display_str(lcd_str);
 
-	sleep_ms(1000);
+	bootDelay(1000);
 
-	int sw_mode = 1;
-	tdoa_init(s1switch, &chConfig[sw_mode]);
+	tdoa_init(s1switch, config);
 
+#if !FAST_BOOT
 	//sleep for 5 seconds displaying last LCD message and flashing LEDs
-	i=30;
+	int i=30;
 	while(i--)
 	{
 		if (i & 1) led_off(LED_ALL);
@@ -251,35 +314,187 @@ int main(void)
 
 		sleep_ms(200);
 	}
-	i = 0;
+#endif
 	led_off(LED_ALL);
 
 	port_EnableEXT_IRQ(); //enable ScenSor IRQ before starting
 
     // Enable RX so we can start receiving messages
     dwt_rxenable(DWT_START_RX_IMMEDIATE);
+#if TAG_IWDG_MS
+    // A stuck interrupt or SPI transfer starves the loop below, the tag then resets and keeps tdoa_save_state
+    port_iwdg_start(TAG_IWDG_MS);
+#endif
+
+    tdoa_status_t status, sentStatus = {0, 0};
+    uint8 batchSeq = 0;
+    unsigned long lastTelemetry = portGetTickCnt();
+    unsigned long lastRetain = lastTelemetry;
+#if USB_SYNC_MS && !TAG_OUTPUT_USART
+    unsigned long lastSync = lastTelemetry;
+#endif
 
     // main loop
 	while(1)
 	{
+		// Process the frames buffered by the receive interrupt
+		while(tdoa_process());
+		const unsigned long now = portGetTickCnt();
+		tdoa_cell_task(now);
+		tdoa_phy_task(now);
+#if TAG_IWDG_MS
+		port_iwdg_kick();
+#endif
+		if((now - lastRetain) >= TAG_RETAIN_MS)
+		{
+			tdoa_save_state();
+			lastRetain = now;
+		}
+
+		// Report new losses before the measurements that follow them, frames the
+		// output buffer refused count as output losses. Retried until it is sent
+		tdoa_get_status(&status);
+		status.outDropped += out_overflows();
+		if((status.rxDropped != sentStatus.rxDropped) || (status.outDropped != sentStatus.outDropped))
+		{
+			uint8 str_to_send[TDOA_STATUS_FRAME_SIZE];
+			tdoa_status_frame_encode(str_to_send, &status);
+			if(out_send(str_to_send, TDOA_STATUS_FRAME_SIZE))
+			{
+				sentStatus = status;
+			}
+			usb_run();
+		}
+
+#if USB_TELEMETRY_MS
+		// Waits for room, taking the telemetry restarts its ISR statistics
+		if(((now - lastTelemetry) >= USB_TELEMETRY_MS) && (out_space() >= TDOA_TELEMETRY_FRAME_MAX_SIZE))
+		{
+			tdoa_telemetry_t telemetry;
+			uint8 str_to_send[TDOA_TELEMETRY_FRAME_MAX_SIZE];
+			tdoa_get_telemetry(&telemetry);
+			telemetry.periodMs = (uint16_t)(now - lastTelemetry);
+			out_send(str_to_send, tdoa_telemetry_frame_encode(str_to_send, &telemetry));
+			usb_run();
+			lastTelemetry = now;
+		}
+#endif
+
+#if USB_SYNC_MS && !TAG_OUTPUT_USART
+		// Sent by the next SOF interrupt, see tdoa_sync_sof
+		if((now - lastSync) >= USB_SYNC_MS)
+		{
+			tdoa_sync_arm();
+			lastSync = now;
+		}
+#endif
+
+#if TDOA_TRACE
+		// Samples wait in RAM while a transfer is pending, a busy send would drop them
+		if(out_idle())
+		{
+			uint8 str_to_send[TDOA_TRACE_FRAME_MAX_SIZE];
+			const size_t len = tdoa_trace_frame(str_to_send);
+			if(len > 0)
+			{
+				out_send(str_to_send, len);
+				usb_run();
+			}
+		}
+#endif
+
 		// Check if we have data ready
-		if(usbDataReady == 1)
+		usb_out_t *out = tdoa_out_peek();
+		if(out == NULL)
+		{
+			waitForInterrupt();
+			continue;
+		}
+
+		// Backpressure: the entry stays queued until the output buffer has room for
+		// its frame, a full queue then counts the losses in outDropped
+		if(out_space() < USB_OUT_FRAME_MAX_SIZE)
+		{
+			waitForInterrupt();
+			continue;
+		}
+
+		if(out->type == USB_DATA_TDOA)
 		{
-			uint8 str_to_send[9];
-			str_to_send[0] = 0xAA;
-			str_to_send[1] = usbData.prevAnc;
-			str_to_send[2] = usbData.currAnc;
-			uint32_t asInt = *((int32_t*)&usbData.distanceDiff);
-			str_to_send[3] = (asInt>>24);
-			str_to_send[4] = (asInt>>16);
-			str_to_send[5] = (asInt>>8);
-			str_to_send[6] = (asInt);
- 			uint16_t cs = serial_checksum(&str_to_send[0], 7);
-			str_to_send[7] = (cs>>8);
-			str_to_send[8] = (cs);
-			send_usbmessage(str_to_send, 9);
+#if USB_BATCH_FRAMES
+			// Measurements accumulate while the previous transfer is pending,
+			// then all of them go out together
+			if(!out_idle() && (tdoa_out_count() < TDOA_BATCH_MAX_RECORDS))
+			{
+				waitForInterrupt();
+				continue;
+			}
+
+			tdoa_batch_t batch;
+			batch.seq = batchSeq++;
+			batch.count = 0;
+			while((out != NULL) && (out->type == USB_DATA_TDOA) && (batch.count < TDOA_BATCH_MAX_RECORDS))
+			{
+				tdoa_frame_t *f = &batch.frames[batch.count++];
+				f->Ar = out->tdoa.prevAnc;
+				f->An = out->tdoa.currAnc;
+				f->distanceDiff = out->tdoa.distanceDiff;
+				f->flags = TDOA_FRAME_HAS_TIME | TDOA_FRAME_HAS_QUALITY | TDOA_FRAME_HAS_VARIANCE;
+				f->idx = out->tdoa.idx;
+				f->rxTime = out->tdoa.rxTime;
+				f->rxPower = TDOA_RX_POWER_DBM(out->tdoa.rxPower);
+				f->quality = out->tdoa.quality;
+				f->variance = out->tdoa.variance;
+				tdoa_out_pop();
+				out = tdoa_out_peek();
+			}
+
+#if USB_FRAME_VERSION >= 2
+			uint8 str_to_send[TDOA_V2_FRAME_MAX_SIZE];
+			// The host takes the age of the records from it, tdoa_sys_time is the clock of rxTime
+			batch.sendTime = tdoa_sys_time();
+			out_send(str_to_send, tdoa_v2_frame_encode(str_to_send, &batch));
+#else
+			uint8 str_to_send[TDOA_BATCH_FRAME_MAX_SIZE];
+			out_send(str_to_send, tdoa_batch_frame_encode(str_to_send, &batch));
+#endif
 			usb_run();
-			usbDataReady = 0;
+#else
+			uint8 str_to_send[TDOA_FRAME_SIZE];
+			tdoa_frame_encode(str_to_send, out->tdoa.prevAnc, out->tdoa.currAnc, out->tdoa.distanceDiff);
+			out_send(str_to_send, TDOA_FRAME_SIZE);
+			usb_run();
+			tdoa_out_pop();
+#endif
+		}
+		else if(out->type == USB_DATA_POSITION)
+		{
+			uint8 str_to_send[TDOA_POSITION_FRAME_SIZE];
+			tdoa_position_frame_encode(str_to_send, &out->position);
+			out_send(str_to_send, TDOA_POSITION_FRAME_SIZE);
+			usb_run();
+			tdoa_out_pop();
+		}
+#if USB_RANGES_EVERY
+		else if(out->type == USB_DATA_RANGES)
+		{
+			uint8 str_to_send[TDOA_RANGES_FRAME_MAX_SIZE];
+			out_send(str_to_send, tdoa_ranges_frame_encode(str_to_send, &out->ranges));
+			usb_run();
+			tdoa_out_pop();
+		}
+#endif
+		else if(out->type == USB_DATA_RAW)
+		{
+			uint8 str_to_send[TDOA_RAW_FRAME_SIZE];
+			tdoa_raw_frame_encode(str_to_send, &out->raw);
+			out_send(str_to_send, TDOA_RAW_FRAME_SIZE);
+			usb_run();
+			tdoa_out_pop();
+		}
+		else
+		{
+			tdoa_out_pop();
 		}
 	}
 
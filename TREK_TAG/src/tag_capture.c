@@ -0,0 +1,230 @@
+/*
+ * Flash capture, see tag_capture.h. Runs in the main loop only: the capture
+ * frame arrives through usb_run and the records come from tdoa_process, so
+ * the flash is never programmed from an interrupt.
+ */
+#include "tdoa_tag.h"
+#include "tag_capture.h"
+
+#define PAGE_ADDR(p)	(CAPTURE_FLASH_START + (uint32_t)(p) * TDOA_CAPTURE_PAGE_SIZE)
+
+#if (CAPTURE_FLASH_START + CAPTURE_PAGES * TDOA_CAPTURE_PAGE_SIZE) > (0x08000000 + 0x40000)
+#error "The capture does not fit the flash"
+#endif
+
+// Linker script symbols, the image ends with the initial values of .data
+extern uint32_t _sidata, _sdata, _edata;
+
+static uint8 available;				// The capture lies above the image
+static uint8 capturing;
+static uint8 page;					// Page being written
+static uint32_t pageSeq;			// Its sequence number, pages written before it in this capture
+static uint16 pageRecords;			// Records in it
+static uint32_t records;
+
+// Export, pages in file order
+static uint8 order[CAPTURE_PAGES];
+static uint8 orderCount;
+
+void tag_capture_init(void)
+{
+	const uint32_t imageEnd = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+
+	available = (imageEnd <= CAPTURE_FLASH_START);
+	capturing = 0;
+	records = 0;
+}
+
+// len bytes at addr, even, in half words as they lie in memory
+static uint8 program(uint32_t addr, const uint8 *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i += 2)
+	{
+		if (FLASH_ProgramHalfWord(addr + i, (uint16_t)(data[i] | (data[i+1] << 8))) != FLASH_COMPLETE)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Header of the next page, after erasing it once the ring wrapped
+static uint8 startPage(void)
+{
+	uint8 header[TDOA_CAPTURE_HEADER_SIZE];
+
+	if (pageSeq >= CAPTURE_PAGES)
+	{
+		if (!CAPTURE_WRAP || (FLASH_ErasePage(PAGE_ADDR(page)) != FLASH_COMPLETE))
+		{
+			return 0;
+		}
+	}
+	tdoa_capture_header_encode(header, pageSeq);
+	pageRecords = 0;
+	return program(PAGE_ADDR(page), header, sizeof(header));
+}
+
+static void stop(void)
+{
+	if (capturing)
+	{
+		capturing = 0;
+		FLASH_Lock();
+	}
+}
+
+/*
+ * Erasing every page takes a second or two, before the first record. The
+ * receive interrupt runs from RAM, but its vector is fetched from flash, so
+ * packets of that time are lost. The watchdog is kicked page by page.
+ */
+static void start(void)
+{
+	uint8 p;
+
+	stop();
+	if (!available)
+	{
+		return;
+	}
+
+	FLASH_Unlock();
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+	for (p = 0; p < CAPTURE_PAGES; p++)
+	{
+		port_iwdg_kick();
+		if (FLASH_ErasePage(PAGE_ADDR(p)) != FLASH_COMPLETE)
+		{
+			FLASH_Lock();
+			return;
+		}
+	}
+
+	page = 0;
+	pageSeq = 0;
+	records = 0;
+	capturing = startPage();
+	if (!capturing)
+	{
+		FLASH_Lock();
+	}
+}
+
+// Stops and resets into the export, main reads the key before the USB starts
+static void exportCapture(void)
+{
+	stop();
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR | RCC_APB1Periph_BKP, ENABLE);
+	PWR_BackupAccessCmd(ENABLE);
+	BKP_WriteBackupRegister(CAPTURE_BKP_REGISTER, CAPTURE_EXPORT_KEY);
+	NVIC_SystemReset();
+}
+
+void tag_capture_command(uint8_t action)
+{
+	switch (action)
+	{
+	case TDOA_CAPTURE_START:
+		start();
+		break;
+	case TDOA_CAPTURE_STOP:
+		stop();
+		break;
+	case TDOA_CAPTURE_EXPORT:
+		exportCapture();
+		break;
+	default:
+		break;
+	}
+}
+
+uint8 tag_capture_active(void)
+{
+	return capturing;
+}
+
+// About 12 half word writes, each holds the core on the flash for some 50 us
+void tag_capture_record(const tdoa_capture_rec_t *rec)
+{
+	uint8 msg[TDOA_CAPTURE_RECORD_SIZE];
+
+	if (!capturing)
+	{
+		return;
+	}
+	if (pageRecords == TDOA_CAPTURE_PAGE_RECORDS)
+	{
+		page = (page + 1) % CAPTURE_PAGES;
+		pageSeq++;
+		if (!startPage())
+		{
+			stop();
+			return;
+		}
+	}
+
+	tdoa_capture_rec_encode(msg, rec);
+	if (!program(PAGE_ADDR(page) + TDOA_CAPTURE_HEADER_SIZE + (uint32_t)pageRecords * TDOA_CAPTURE_RECORD_SIZE, msg, sizeof(msg)))
+	{
+		stop();
+		return;
+	}
+	pageRecords++;
+	records++;
+}
+
+uint32_t tag_capture_records(void)
+{
+	return records;
+}
+
+// Reads and clears the export key, nonzero if the last reset was the one of export
+uint8 tag_capture_export_pending(void)
+{
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR | RCC_APB1Periph_BKP, ENABLE);
+	PWR_BackupAccessCmd(ENABLE);
+	const uint8 pending = (BKP_ReadBackupRegister(CAPTURE_BKP_REGISTER) == CAPTURE_EXPORT_KEY);
+	BKP_WriteBackupRegister(CAPTURE_BKP_REGISTER, 0);
+	return pending;
+}
+
+// Orders the written pages by sequence number, the oldest first. Returns their count
+uint8 tag_capture_scan(void)
+{
+	uint32_t seqs[CAPTURE_PAGES];
+	uint8 p;
+
+	orderCount = 0;
+	if (!available)
+	{
+		return 0;
+	}
+	for (p = 0; p < CAPTURE_PAGES; p++)
+	{
+		uint32_t seq;
+		uint8 k;
+
+		if (!tdoa_capture_header_decode((const uint8 *)PAGE_ADDR(p), &seq))
+		{
+			continue;
+		}
+		for (k = orderCount; (k > 0) && (seqs[k-1] > seq); k--)
+		{
+			seqs[k] = seqs[k-1];
+			order[k] = order[k-1];
+		}
+		seqs[k] = seq;
+		order[k] = p;
+		orderCount++;
+	}
+	return orderCount;
+}
+
+// Page k of the file, k below the count of tag_capture_scan
+const uint8 *tag_capture_page(uint8 k)
+{
+	return (const uint8 *)PAGE_ADDR(order[k]);
+}
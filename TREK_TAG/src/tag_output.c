@@ -0,0 +1,126 @@
+/*
+ * Output modes, see tag_output.h. Every pair keeps its own count, so a pair
+ * the tag hears less often is not held back by the others.
+ */
+#include "tdoa_tag.h"
+#include "tag_output.h"
+
+typedef struct {
+	uint8 used;
+	uint8 Ar;				// Cell-qualified, as in the measurements
+	uint8 stamp;			// useCount of its last measurement
+	uint8 count;			// Measurements since the last one sent
+	uint8 sent;				// last is valid
+	uint8 quality;			// TDOA_QUALITY_* of the measurements averaged so far
+	float mean;				// m, running mean and sum of squared deviations (Welford)
+	float m2;
+	float variance;			// m^2, sum of the variances of the measurements averaged so far
+	float last;				// m, distance difference last sent
+} output_pair_t;
+
+static tdoa_output_config_t config;		// Zero, TDOA_OUTPUT_ALL, until the host sends one
+static output_pair_t pairs[NR_OF_ANCHORS][OUTPUT_PAIRS];
+static uint8 useCount;
+uint32_t statsOutputHeld = 0;
+
+void tag_output_configure(const tdoa_output_config_t *c)
+{
+	config = *c;
+	memset(pairs, 0, sizeof(pairs));
+}
+
+const tdoa_output_config_t *tag_output_config(void)
+{
+	return &config;
+}
+
+// Entry of the pair of msg. A new Ar takes a free entry or the one of An used longest ago, after a cell change all go
+static output_pair_t *findPair(const usb_msg_t *msg)
+{
+	output_pair_t *row = pairs[TDOA_CELL_ANCHOR(msg->currAnc)];
+	output_pair_t *p = NULL;
+	uint8 k;
+
+	useCount++;
+	for (k = 0; k < OUTPUT_PAIRS; k++)
+	{
+		if (row[k].used && (row[k].Ar == msg->prevAnc))
+		{
+			row[k].stamp = useCount;
+			return &row[k];
+		}
+		if ((p == NULL) || !row[k].used || (p->used && ((uint8)(useCount - row[k].stamp) > (uint8)(useCount - p->stamp))))
+		{
+			p = &row[k];
+		}
+	}
+	memset(p, 0, sizeof(*p));
+	p->used = 1;
+	p->Ar = msg->prevAnc;
+	p->stamp = useCount;
+	return p;
+}
+
+// Mean of the packets measurements, variance of the mean from the larger of their scatter and their own variances
+static uint8 average(output_pair_t *p, usb_msg_t *msg)
+{
+	const float d = msg->distanceDiff - p->mean;
+
+	p->count++;
+	p->mean += d / p->count;
+	p->m2 += d * (msg->distanceDiff - p->mean);
+	p->variance += msg->variance;
+	p->quality |= msg->quality;
+	if (p->count < config.packets)
+	{
+		return 0;
+	}
+
+	const float n = (float)p->count;
+	const float scatter = p->m2 / (n - 1.0f);
+	const float model = p->variance / n;
+	msg->distanceDiff = p->mean;
+	msg->variance = ((scatter > model) ? scatter : model) / n;
+	msg->quality = p->quality;
+	p->count = 0;
+	p->mean = 0.0f;
+	p->m2 = 0.0f;
+	p->variance = 0.0f;
+	p->quality = 0;
+	return 1;
+}
+
+uint8 tag_output_filter(usb_msg_t *msg)
+{
+	if ((config.mode == TDOA_OUTPUT_ALL) || ((config.packets <= 1) && (config.mode != TDOA_OUTPUT_CHANGE)))
+	{
+		return 1;
+	}
+
+	output_pair_t *p = findPair(msg);
+	uint8 send;
+	switch (config.mode)
+	{
+	case TDOA_OUTPUT_AVERAGE:
+		send = average(p, msg);
+		break;
+	case TDOA_OUTPUT_DECIMATE:
+		send = (++p->count >= config.packets);
+		break;
+	default:
+		p->count++;
+		send = !p->sent || (fabsf(msg->distanceDiff - p->last) >= config.threshold)
+		       || ((config.packets != 0) && (p->count >= config.packets));
+		break;
+	}
+
+	if (!send)
+	{
+		statsOutputHeld++;
+		return 0;
+	}
+	p->count = 0;
+	p->sent = 1;
+	p->last = msg->distanceDiff;
+	return 1;
+}
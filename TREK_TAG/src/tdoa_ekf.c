@@ -0,0 +1,352 @@
+/*
+ * On-tag TDOA filter, see tdoa_ekf.h. Follows the full covariance path of the
+ * host filter: diagonal transition with the velocity coupling of
+ * propagateState, process noise scaled by the elapsed time and the position
+ * only rank-1 update of stateEstimatorPositionUpdate. Without an FPU every
+ * multiply is a library call, so the products skip the zero blocks of the
+ * transition and measurement matrices.
+ */
+#include "tdoa_tag.h"
+#include "tdoa_ekf.h"
+
+#define N	TDOA_MODEL_STATES
+
+static float S[N];
+static float P[N][N];
+static tdoa_model_config_t model;
+static uint8 running;			// State seeded from the anchors of the first cell used
+static uint64_t lastTime;		// Arrival of the last measurement, 40-bit tag clock
+static uint8 updates;
+
+// Pairs of the current TDMA frame, kept until the state is seeded
+static struct
+{
+	uint8 Ar, An;
+	float distanceDiff;
+} seed[TDOA_MAX_ANCHORS];
+static uint8 seedCount;
+static uint8 seedCell;
+
+// Host defaults of the TDOA constructor, used until a model frame arrives
+static const tdoa_model_config_t defaultModel = {
+	{1, 1, 1, 1, 1, 1},
+	{100*100, 100*100, 100*100, 0.01f*0.01f, 0.01f*0.01f, 0.01f*0.01f},
+	{0, 0, 0, 0, 0, 0},
+	0.15f
+};
+
+void tdoa_ekf_init(void)
+{
+	model = defaultModel;
+	running = 0;
+	updates = 0;
+	seedCount = 0;
+}
+
+// A new model restarts the filter from its initial covariance
+void tdoa_ekf_set_model(const tdoa_model_config_t *m)
+{
+	model = *m;
+	running = 0;
+	seedCount = 0;
+}
+
+// Symmetry and bounds of PredictionBound
+static void boundCovariance(void)
+{
+	for (int i = 0; i < N; i++)
+	{
+		for (int j = i; j < N; j++)
+		{
+			float p = 0.5f*P[i][j] + 0.5f*P[j][i];
+			if (isnan(p) || (p > EKF_MAX_COVARIANCE))
+			{
+				p = EKF_MAX_COVARIANCE;
+			}
+			else if ((i == j) && (p < EKF_MIN_COVARIANCE))
+			{
+				p = EKF_MIN_COVARIANCE;
+			}
+			P[i][j] = P[j][i] = p;
+		}
+	}
+}
+
+// Inverse of the symmetric 3x3 matrix M, returns 0 if it is singular
+static uint8 invert3(const float M[3][3], float inv[3][3])
+{
+	inv[0][0] = M[1][1]*M[2][2] - M[1][2]*M[2][1];
+	inv[0][1] = M[0][2]*M[2][1] - M[0][1]*M[2][2];
+	inv[0][2] = M[0][1]*M[1][2] - M[0][2]*M[1][1];
+	const float det = M[0][0]*inv[0][0] + M[1][0]*inv[0][1] + M[2][0]*inv[0][2];
+	if (!(fabsf(det) > 1e-9f))
+	{
+		return 0;
+	}
+	inv[1][1] = M[0][0]*M[2][2] - M[0][2]*M[2][0];
+	inv[1][2] = M[0][2]*M[1][0] - M[0][0]*M[1][2];
+	inv[2][2] = M[0][0]*M[1][1] - M[0][1]*M[1][0];
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = i; j < 3; j++)
+		{
+			inv[i][j] /= det;
+			inv[j][i] = inv[i][j];
+		}
+	}
+	return 1;
+}
+
+/*
+ * Seeds the position from the pairs of one TDMA frame, the role of the host
+ * bootstrap initFromFrame: a single pair from a state metres away moves it
+ * far along a wrong linearisation. Gauss-Newton from the anchor centroid,
+ * position covariance stdDev^2 * (J'J)^-1, no velocity. Returns 0 and leaves
+ * the filter stopped if the pairs do not constrain the position.
+ */
+static uint8 start(uint8 cell, uint64_t rxTime)
+{
+	const tdoa_anchor_config_t *layout = tdoa_get_anchors(cell);
+	const float (*pos)[3] = layout->pos;
+	float x[3] = {0.0f, 0.0f, 0.0f};
+	float JtJ[3][3], inv[3][3];
+
+	for (int k = 0; k < layout->count; k++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			x[j] += pos[k][j];
+		}
+	}
+	for (int j = 0; j < 3; j++)
+	{
+		x[j] /= layout->count;
+	}
+
+	for (int iter = 0; iter < EKF_SEED_ITERATIONS; iter++)
+	{
+		float Jtr[3] = {0.0f, 0.0f, 0.0f};
+		memset(JtJ, 0, sizeof(JtJ));
+		for (int k = 0; k < seedCount; k++)
+		{
+			const float *pn = pos[seed[k].An];
+			const float *pr = pos[seed[k].Ar];
+			float dn[3], dr[3], h[3];
+			float dAn = 0.0f, dAr = 0.0f;
+			for (int j = 0; j < 3; j++)
+			{
+				dn[j] = x[j] - pn[j];
+				dr[j] = x[j] - pr[j];
+				dAn += dn[j]*dn[j];
+				dAr += dr[j]*dr[j];
+			}
+			dAn = sqrtf(dAn);
+			dAr = sqrtf(dAr);
+			if ((dAn < EKF_MIN_DISTANCE) || (dAr < EKF_MIN_DISTANCE))
+			{
+				continue;
+			}
+			const float r = seed[k].distanceDiff - (dAn - dAr);
+			for (int j = 0; j < 3; j++)
+			{
+				h[j] = dn[j]/dAn - dr[j]/dAr;
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				Jtr[i] += h[i]*r;
+				for (int j = 0; j < 3; j++)
+				{
+					JtJ[i][j] += h[i]*h[j];
+				}
+			}
+		}
+		if (!invert3(JtJ, inv))
+		{
+			return 0;
+		}
+		for (int i = 0; i < 3; i++)
+		{
+			x[i] += inv[i][0]*Jtr[0] + inv[i][1]*Jtr[1] + inv[i][2]*Jtr[2];
+		}
+	}
+	if (!invert3(JtJ, inv) || isnan(x[0] + x[1] + x[2]))
+	{
+		return 0;
+	}
+
+	memset(S, 0, sizeof(S));
+	memset(P, 0, sizeof(P));
+	const float R = model.stdDev * model.stdDev;
+	for (int i = 0; i < 3; i++)
+	{
+		S[i] = x[i];
+		for (int j = 0; j < 3; j++)
+		{
+			P[i][j] = R * inv[i][j];
+		}
+	}
+	for (int i = 3; i < N; i++)
+	{
+		P[i][i] = model.covariance[i];
+	}
+	boundCovariance();
+	lastTime = rxTime;
+	running = 1;
+	return 1;
+}
+
+/*
+ * P = A*P*A' + Q*dt/step with A = [diag(a0..a2) dt*diag(a3..a5); 0 diag(a3..a5)],
+ * each product row or column has at most two non-zero terms.
+ */
+static void predict(float dt)
+{
+	const float *a = model.transition;
+	float AP[N][N];
+
+	for (int j = 0; j < 3; j++)
+	{
+		S[j] += S[j+3] * dt * a[j+3];
+		S[j+3] *= a[j+3];
+	}
+
+	for (int i = 0; i < N; i++)
+	{
+		for (int k = 0; k < N; k++)
+		{
+			AP[i][k] = a[i]*P[i][k] + ((i < 3) ? dt*a[i+3]*P[i+3][k] : 0.0f);
+		}
+	}
+	const float qScale = dt * (1000.0f / TDOA_MODEL_NOISE_STEP_MS);
+	for (int i = 0; i < N; i++)
+	{
+		for (int j = 0; j < N; j++)
+		{
+			P[i][j] = AP[i][j]*a[j] + ((j < 3) ? AP[i][j+3]*dt*a[j+3] : 0.0f);
+		}
+		P[i][i] += model.noise[i] * qScale;
+	}
+	boundCovariance();
+}
+
+/*
+ * Applies the distance difference |p - An| - |p - Ar| measured at rxTime,
+ * after predicting to it. Ar and An are the anchors of the cell, both must
+ * have a position. The measurement variance of the model is scaled by
+ * varianceScale, above 1 for a packet of doubtful quality.
+ */
+void tdoa_ekf_update(uint8 cell, uint8 Ar, uint8 An, float distanceDiff, uint64_t rxTime, float varianceScale)
+{
+	const tdoa_anchor_config_t *layout = tdoa_get_anchors(cell);
+	if ((layout == NULL) || (Ar >= layout->count) || (An >= layout->count))
+	{
+		return;
+	}
+	if (!running)
+	{
+		// Anchors transmit in index order, a lower An than the last pair starts the next frame
+		if ((seedCount > 0) && ((cell != seedCell) || (An <= seed[seedCount-1].An)))
+		{
+			if ((cell == seedCell) && (seedCount >= EKF_SEED_MIN_PAIRS))
+			{
+				start(cell, rxTime);
+			}
+			seedCount = 0;
+		}
+		if (!running)
+		{
+			if (seedCount < TDOA_MAX_ANCHORS)
+			{
+				seed[seedCount].Ar = Ar;
+				seed[seedCount].An = An;
+				seed[seedCount].distanceDiff = distanceDiff;
+				seedCount++;
+			}
+			seedCell = cell;
+			return;
+		}
+	}
+
+	float dt = (float)((rxTime - lastTime) & MASK_40BIT) * (float)(1.0 / TDOA_TIMESTAMP_FREQ);
+	if (dt > EKF_MAX_DT)
+	{
+		dt = EKF_MAX_DT;
+	}
+	if (dt > 0.0f)
+	{
+		predict(dt);
+	}
+	lastTime = rxTime;
+
+	const float *pn = layout->pos[An];
+	const float *pr = layout->pos[Ar];
+	float dn[3], dr[3];
+	float dAn = 0.0f, dAr = 0.0f;
+	for (int j = 0; j < 3; j++)
+	{
+		dn[j] = S[j] - pn[j];
+		dr[j] = S[j] - pr[j];
+		dAn += dn[j]*dn[j];
+		dAr += dr[j]*dr[j];
+	}
+	dAn = sqrtf(dAn);
+	dAr = sqrtf(dAr);
+	if ((dAn < EKF_MIN_DISTANCE) || (dAr < EKF_MIN_DISTANCE))
+	{
+		return;
+	}
+
+	float h[3];
+	for (int j = 0; j < 3; j++)
+	{
+		h[j] = dn[j]/dAn - dr[j]/dAr;
+	}
+	const float error = distanceDiff - (dAn - dAr);
+
+	// PH' from the position columns of P, HPH' + R from its position rows
+	float PH[N];
+	for (int i = 0; i < N; i++)
+	{
+		PH[i] = P[i][0]*h[0] + P[i][1]*h[1] + P[i][2]*h[2];
+	}
+	const float R = model.stdDev * model.stdDev * varianceScale;
+	const float invHPHR = 1.0f / (h[0]*PH[0] + h[1]*PH[1] + h[2]*PH[2] + R);
+
+	const float gain = error * invHPHR;
+	const float c = invHPHR - R*invHPHR*invHPHR;
+	for (int i = 0; i < N; i++)
+	{
+		S[i] += PH[i] * gain;
+		const float cPH = c * PH[i];
+		for (int j = i; j < N; j++)
+		{
+			P[i][j] -= cPH * PH[j];
+			P[j][i] = P[i][j];
+		}
+	}
+	boundCovariance();
+
+	if (updates < 0xFF)
+	{
+		updates++;
+	}
+}
+
+uint8 tdoa_ekf_updates(void)
+{
+	return updates;
+}
+
+// Fills everything but the sequence number and restarts the update count
+void tdoa_ekf_get(tdoa_position_t *position)
+{
+	for (int j = 0; j < 3; j++)
+	{
+		position->pos[j] = S[j];
+		position->vel[j] = S[j+3];
+		position->var[j] = P[j][j];
+	}
+	position->updates = updates;
+	position->rxTime = lastTime;
+	updates = 0;
+}
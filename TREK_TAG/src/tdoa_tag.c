@@ -3,6 +3,9 @@
  *
  */
 #include "tdoa_tag.h"
+#include "tdoa_ekf.h"
+#include "tag_capture.h"
+#include "tag_output.h"
 
 
 uint32_t statsReceivedPackets = 0;
@@ -12,12 +15,134 @@ uint32_t statsAcceptedPackets = 0;
 //float uwbTdoaDistDiff[NR_OF_ANCHORS][256];
 //uint8_t num = 0;
 
-uint8 previousAnchor;
-rangePacket_t rxPacketBuffer[NR_OF_ANCHORS];
-dwTime_t arrivals[NR_OF_ANCHORS];
-static uint8_t sequenceNrs[NR_OF_ANCHORS];
+uint8 previousAnchor;		// Last anchor stored by rx_ok_cb
+static rx_history_t history[NR_OF_ANCHORS];		// Arrivals of the last packets, see matchArrival
+uint32_t statsUnmatchedPairs = 0;				// Entries whose packet of Ar is not in the history
 
 double clockCorrection_T_To_A[NR_OF_ANCHORS];
+static int32_t clockSkew[NR_OF_ANCHORS];			// tdoa_clock_skew of clockCorrection_T_To_A
+static uint8 clockValid[NR_OF_ANCHORS];				// clockCorrection_T_To_A is nonzero, tested without a double compare
+static tdoa_clock_filter_t clockFilters[NR_OF_ANCHORS];
+static float clockJitter[NR_OF_ANCHORS];				// m^2, residual variance of the clock fit
+static uint8 rawMode;
+static uint8 pairMode;								// TDOA_PAIRS, consecutive in raw mode
+static const tdoa_rx_correction_t *rxCorrection;	// Power and bias tables of the configured channel and PRF
+
+// Cell selection, see tdoa_cell_task. tagCell only changes with the DW1000
+// interrupt disabled, rxCell differs from it while another cell is visited
+static dwt_config_t baseConfig;						// Radio settings of cell 0
+static uint8 tagCell;								// Cell the measurements come from
+static volatile uint8 rxCell;						// Cell the receiver is tuned to
+static int32_t cellPower[TAG_CELLS];				// 1/64 dBm, running mean for tagCell, sum over the visit for the others
+static uint16 cellPackets[TAG_CELLS];
+static unsigned long lastCellRx;					// Tick of the last packet of tagCell
+static unsigned long visitStart;
+static unsigned long lastVisit;
+static uint8 visitCell;
+uint32_t statsCellHandovers = 0;
+
+// State kept across a watchdog reset, see tdoa_save_state
+static tag_retain_t retained PORT_NOINIT;
+static uint8 switches;								// s1switch of tdoa_init
+
+// PHY profile scan, see tdoa_phy_task
+static uint8 phyProfile;							// TDOA_PHY_* of baseConfig
+static uint8 phyFirst;								// Profile and channel tdoa_init was given
+static uint8 phyChan;
+static uint8 phyScan;								// Step of the scan, the other channel from TDOA_PHY_PROFILES on
+static unsigned long lastPhyRx;						// Tick of the last packet of any cell
+static unsigned long phyStep;
+
+#if TAG_SNIFF
+// TDMA aware receive, see sniffPacket. Written by the ISR, reset with the DW1000 interrupt disabled
+static uint8 sniffLocked;							// Receiver opens around the expected slots, continuously otherwise
+static uint8 sniffOnGrid;							// Packets in a row on the slot grid of the previous one
+static uint8 sniffMisses;							// Windows in a row without a packet
+static uint8 sniffSlots;							// Of the frame of the last packet
+static uint16 sniffSlotUnits;
+static uint64_t sniffLast;							// Arrival of the last packet of tagCell, 0 for none
+static uint64_t sniffNext;							// Expected arrival of the next slot
+static uint32_t sniffLead;							// Ticks a window opens before the expected arrival
+uint32_t statsSniffLocks = 0;
+uint32_t statsSniffMisses = 0;						// Windows without a packet
+uint32_t statsSniffLate = 0;						// Windows opened after their start
+#endif
+
+// Frames received by rx_ok_cb and not yet processed by tdoa_process. The ISR
+// only writes rxRingHead and the main loop only writes rxRingTail, the
+// indices run freely and are masked on access.
+static rx_frame_t rxRing[RX_RING_SIZE];
+static volatile uint8 rxRingHead;
+static volatile uint8 rxRingTail;
+uint32_t statsDroppedFrames = 0;
+uint32_t statsRxOverruns = 0;		// Both DW1000 receive buffers full, at least one frame lost
+
+// Measurements for the USB, filled by tdoa_process and sent by the main loop.
+// Same index scheme as rxRing, a full queue drops the new measurement.
+static usb_out_t outQueue[OUT_QUEUE_SIZE];
+static volatile uint8 outQueueHead;
+static volatile uint8 outQueueTail;
+uint32_t statsOutputOverflows = 0;
+
+// Telemetry, see tdoa_get_telemetry. The DW1000 event counters are 12 bits
+// wide and are accumulated from their differences between two reads
+uint32_t statsClockRejects = 0;		// Distance differences without a clock ratio of An
+uint32_t statsGateRejects = 0;		// Distance differences longer than the baseline of their pair
+uint32_t statsNlosDrops = 0;		// Distance differences dropped for a blocked first path (TAG_NLOS_DROP)
+static uint32_t isrMinCycles = 0xFFFFFFFF;
+static uint32_t isrMaxCycles = 0;
+#if TDOA_TRACE
+tdoa_trace_t tdoaTrace;
+#endif
+
+#if TAG_EKF
+static uint8 positionSeq;
+#endif
+
+#if USB_SYNC_MS
+// Clock sync, see tdoa_sync_sof. The SOF interrupt only reads the reference once syncArmed is set
+static volatile uint8 syncArmed;
+static uint64_t syncRefTime;		// DW1000 system time
+static uint32_t syncRefCycles;		// CPU cycle counter right after it
+static uint32_t syncTicksPerCycle;	// DW1000 ticks per CPU cycle, 16.16 fixed point
+static uint8 syncSeq;
+#endif
+
+// Anchor layout per cell from the host, count is 0 until it arrived
+static tdoa_anchor_config_t cellAnchors[TAG_CELLS];
+static uint16 anchorPackets[NR_OF_ANCHORS];
+static int32_t anchorPowerSum[NR_OF_ANCHORS];		// 1/64 dBm, packets with both powers in the period
+static int32_t anchorFpSum[NR_OF_ANCHORS];			// 1/64 dB, first path power minus receive power
+static uint16 anchorPowerCount[NR_OF_ANCHORS];
+static uint8 lastSlots;
+#if USB_RANGES_EVERY
+static uint8 rangesCountdown[NR_OF_ANCHORS];		// Packets of each anchor until its next ranges frame
+#endif
+static dwt_deviceentcnts_t lastEvents;
+static tdoa_telemetry_t telemetryTotals;
+
+static void restoreState(void);
+static void sniffReset(void);
+
+// Forgets the anchors of the previous cell, their numbers are reused by the next one
+static void resetAnchors(void)
+{
+	int i;
+
+	previousAnchor = 0;
+	for (i = 0; i < NR_OF_ANCHORS; i++) {
+		tdoa_clock_filter_reset(&clockFilters[i]);
+		clockCorrection_T_To_A[i] = 0.0;
+		clockSkew[i] = 0;
+		clockValid[i] = 0;
+		clockJitter[i] = 0.0f;
+	}
+	memset(history, 0, sizeof(history));
+#if USB_RANGES_EVERY
+	// The first packet of every anchor is reported right away
+	memset(rangesCountdown, 1, sizeof(rangesCountdown));
+#endif
+}
 
 void tdoa_init(uint8 s1switch, dwt_config_t *config)
 {
@@ -31,20 +156,70 @@ void tdoa_init(uint8 s1switch, dwt_config_t *config)
 
 	dwt_setrxtimeout(10000);
 
-	//memset(uwbTdoaDistDiff, 0, sizeof(uwbTdoaDistDiff));
-	previousAnchor = 0;
+#if TAG_FRAME_FILTER
+	// Frames of other networks and cells are dropped by the receiver, without an interrupt. AFFREJ stays
+	// masked, the DW1000 goes back to preamble search on its own after a rejected frame
+	static uint8 rangeDest[] = TDOA_RANGE_DEST_ADDRESS;
+	dwt_seteui(rangeDest);
+	dwt_setpanid(TDOA_CELL_PAN(0));
+	dwt_enableframefilter(DWT_FF_DATA_EN);
+#endif
 
-	anc_prf = config->prf;
-	anc_chan = config->chan;
-	usbDataReady = 0;
-}
+#if TDOA_DOUBLE_BUFFER
+	dwt_setinterrupt(DWT_INT_RXOVRR, 1);
+	dwt_setdblrxbuffmode(1);
+#endif
 
-static uint64_t truncateToLocalTimeStamp(uint64_t fullTimeStamp) {
-	return fullTimeStamp & 0x00FFFFFFFFul;
-}
+	//memset(uwbTdoaDistDiff, 0, sizeof(uwbTdoaDistDiff));
+	resetAnchors();
+	rawMode = (s1switch & SWS1_RAW_MODE) != 0;
+	pairMode = rawMode ? TDOA_PAIRS_CONSECUTIVE : TDOA_PAIRS;
+#if TAG_EKF
+	tdoa_ekf_init();
+	positionSeq = 0;
+#endif
+
+	dwt_configeventcounters(1);
+	memset(&lastEvents, 0, sizeof(lastEvents));
+	memset(&telemetryTotals, 0, sizeof(telemetryTotals));
+	memset(anchorPackets, 0, sizeof(anchorPackets));
+	memset(anchorPowerSum, 0, sizeof(anchorPowerSum));
+	memset(anchorFpSum, 0, sizeof(anchorFpSum));
+	memset(anchorPowerCount, 0, sizeof(anchorPowerCount));
+	lastSlots = 0;
+#if USB_SYNC_MS
+	syncArmed = 0;
+	syncSeq = 0;
+	syncTicksPerCycle = (uint32_t)(LOCODECK_TS_FREQ * 65536.0 / SystemCoreClock);
+#endif
+#if TDOA_TRACE
+	tdoa_trace_init();
+#else
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	TDOA_DWT_CYCCNT = 0;
+	TDOA_DWT_CTRL |= TDOA_DWT_CTRL_CYCCNTENA;
+#endif
 
-static uint64_t truncateToAnchorTimeStamp(uint64_t fullTimeStamp) {
-	return fullTimeStamp & 0x00FFFFFFFFul;
+	rxCorrection = tdoa_rx_correction_select(config->chan, config->prf == DWT_PRF_64M);
+	baseConfig = *config;
+	phyProfile = tdoa_phy_of(config);
+	phyFirst = (phyProfile == TDOA_PHY_UNKNOWN) ? 0 : phyProfile;
+	phyChan = config->chan;
+	phyScan = 0;
+	lastPhyRx = portGetTickCnt();
+	phyStep = lastPhyRx;
+	tagCell = 0;
+	rxCell = 0;
+	visitCell = 0;
+	memset(cellPower, 0, sizeof(cellPower));
+	memset(cellPackets, 0, sizeof(cellPackets));
+	rxRingHead = 0;
+	rxRingTail = 0;
+	outQueueHead = 0;
+	outQueueTail = 0;
+	switches = s1switch;
+	sniffReset();
+	restoreState();
 }
 
 // The default receive time in the anchors for messages from other anchors is 0
@@ -54,243 +229,1260 @@ static uint8 isValidTimeStamp(const int64_t anchorRxTime) {
 	return anchorRxTime != 0;
 }
 
-static uint8 isSeqNrConsecutive(uint8_t prevSeqNr, uint8_t currentSeqNr) {
-	return (currentSeqNr == ((prevSeqNr + 1) & 0xFF));
-}
+/*
+ * Arrival at the tag of the packet of Ar the entry of the pair refers to.
+ * Between that packet and the one of An both the anchor and the tag clock
+ * ran for about the same time, so the packet is the one in the history of
+ * Ar whose interval to the arrival of An matches the anchor interval to
+ * within TAG_PAIR_MATCH_TICKS, while packets of other frames are at least
+ * a frame off. Unlike comparing packet indices this also pairs across lost
+ * packets, join slots and a change of master, and never pairs with the
+ * wrong frame.
+ */
+static uint8 matchArrival(uint64_t *rxAr_by_T, const rx_pair_t *pair, uint32_t txAn, uint64_t rxAn_by_T) {
+	const rx_history_t *h = &history[pair->Ar];
+	uint8 i;
 
-static uint8 isSameFrame(const uint8_t Ar, const uint8_t An, const uint8_t packetIdx) {
-    if (Ar < An)
-    {
-      return (rxPacketBuffer[Ar].Idx == packetIdx);
-    }
-    else
-    {
-      return (rxPacketBuffer[Ar].Idx == (packetIdx - 1));
-    }
-}
+	for (i = 0; i < h->count; i++) {
+		const uint64_t arrival = h->arrival[(h->head - 1 - i) & (TAG_PAIR_HISTORY - 1)];
+		const int64_t interval_in_cl_T = tdoa_time_sub(rxAn_by_T, arrival);
+		const int64_t interval_in_cl_An = tdoa_time_unwrap32(txAn, pair->rxAr_by_An, interval_in_cl_T);
+		const int64_t mismatch = interval_in_cl_T - interval_in_cl_An;
 
-static uint8 calcClockCorrection(double* clockCorrection, const uint8_t anchor, const rangePacket_t* packet, const dwTime_t* arrival) {
-	if (! isSeqNrConsecutive(rxPacketBuffer[anchor].Idx, packet->Idx)) {
-		return 0;
+		if ((interval_in_cl_T > 0) && (mismatch <= TAG_PAIR_MATCH_TICKS) && (mismatch >= -TAG_PAIR_MATCH_TICKS)) {
+			*rxAr_by_T = arrival;
+			return 1;
+		}
 	}
+	return 0;
+}
 
-	const int64_t previous_txAn_in_cl_An = rxPacketBuffer[anchor].timestamps[anchor];
-	const int64_t rxAn_by_T_in_cl_T = arrival->full;
-	const int64_t txAn_in_cl_An = packet->timestamps[anchor];
-	const int64_t previous_rxAn_by_T_in_cl_T = arrivals[anchor].full;
-	const double frameTime_in_cl_An = truncateToAnchorTimeStamp(txAn_in_cl_An - previous_txAn_in_cl_An);
-	const double frameTime_in_T = truncateToLocalTimeStamp(rxAn_by_T_in_cl_T - previous_rxAn_by_T_in_cl_T);
+static void pushArrival(uint8 anchor, uint64_t arrival) {
+	rx_history_t *h = &history[anchor];
 
-	*clockCorrection = frameTime_in_cl_An / frameTime_in_T;
-	return 1;
+	h->arrival[h->head] = arrival;
+	h->head = (h->head + 1) & (TAG_PAIR_HISTORY - 1);
+	if (h->count < TAG_PAIR_HISTORY) {
+		h->count++;
+	}
 }
 
-static uint8 calcDistanceDiff(float* tdoaDistDiff, const uint8_t previousAnchor, const uint8_t anchor, const rangePacket_t* packet, const dwTime_t* arrival) {
-	if (! isSameFrame(previousAnchor, anchor, packet->Idx))
-	{
+// Least squares clock ratio over the last TDOA_CLOCK_FILTER_LEN packets of the anchor
+// instead of the ratio of the last two, which passed the timestamp jitter straight on
+static uint8 calcClockCorrection(double* clockCorrection, const rx_frame_t* frame, const dwTime_t* arrival) {
+	if (! tdoa_clock_filter_add(&clockFilters[frame->An], arrival->full, frame->txAn)) {
 		return 0;
 	}
 
+	*clockCorrection = tdoa_clock_filter_ratio(&clockFilters[frame->An]);
+	clockSkew[frame->An] = tdoa_clock_skew(*clockCorrection);
+	clockValid[frame->An] = (*clockCorrection != 0.0);
+	clockJitter[frame->An] = (float)(tdoa_clock_filter_residual(&clockFilters[frame->An])
+	                                 * (TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ) * (TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ));
+	return 1;
+}
+
+static uint8 calcDistanceDiff(float* tdoaDistDiff, const rx_frame_t* frame, const rx_pair_t* pair, const dwTime_t* arrival) {
+	const uint8_t anchor = frame->An;
 	const int64_t rxAn_by_T_in_cl_T  = arrival->full;
-	const int64_t rxAr_by_An_in_cl_An = packet->timestamps[previousAnchor];
-	const int64_t tof_Ar_to_An_in_cl_An = packet->distances[previousAnchor];
-	const double clockCorrection = clockCorrection_T_To_A[anchor];
+	const int64_t rxAr_by_An_in_cl_An = pair->rxAr_by_An;
+	const int64_t tof_Ar_to_An_in_cl_An = pair->tofAr_to_An;
 
 	const uint8 isAnchorDistanceOk = isValidTimeStamp(tof_Ar_to_An_in_cl_An);
 	const uint8 isRxTimeInTagOk = isValidTimeStamp(rxAr_by_An_in_cl_An);
-	const uint8 isClockCorrectionOk = (clockCorrection != 0.0);
+	const uint8 isClockCorrectionOk = clockValid[anchor];
 
 	if (! (isAnchorDistanceOk && isRxTimeInTagOk && isClockCorrectionOk)) {
+		if (! isClockCorrectionOk) {
+			statsClockRejects++;
+		}
 		return 0;
 	}
 
-	const int64_t txAn_in_cl_An = packet->timestamps[anchor];
-	const int64_t rxAr_by_T_in_cl_T = arrivals[previousAnchor].full;
+	const int64_t txAn_in_cl_An = frame->txAn;
+	uint64_t rxAr_by_T_in_cl_T;
 
-	const int64_t delta_txAr_to_txAn_in_cl_An = (tof_Ar_to_An_in_cl_An + truncateToAnchorTimeStamp(txAn_in_cl_An - rxAr_by_An_in_cl_An));
-	const int64_t timeDiffOfArrival_in_cl_An =  truncateToAnchorTimeStamp(rxAn_by_T_in_cl_T - rxAr_by_T_in_cl_T) * clockCorrection - delta_txAr_to_txAn_in_cl_An;
+	if (! matchArrival(&rxAr_by_T_in_cl_T, pair, frame->txAn, arrival->full)) {
+		statsUnmatchedPairs++;
+		return 0;
+	}
 
-	*tdoaDistDiff = SPEED_OF_LIGHT * timeDiffOfArrival_in_cl_An / LOCODECK_TS_FREQ;
+	// Same computation as the host uses for raw timestamp frames, integer up to the result
+	*tdoaDistDiff = tdoa_clock_distance_diff(rxAr_by_T_in_cl_T, rxAn_by_T_in_cl_T, rxAr_by_An_in_cl_An, txAn_in_cl_An,
+	                                         tof_Ar_to_An_in_cl_An, clockSkew[anchor]);
 
 	return 1;
 }
 
-#pragma GCC optimize ("O3")
-void rx_ok_cb(const dwt_cb_data_t *rxd)
+// TDOA_QUALITY_* bits of a measurement, the power limits are those of dwCorrectTimestamp.
+// previousAnchor is the anchor received before An, whatever the pair of the measurement
+static uint8 rxQuality(const int16 rxPower, const uint8_t previousAnchor, const uint8_t anchor, const uint16 active, const uint8 join)
 {
-	statsReceivedPackets++;
+	const uint8 slots = tdoa_tdma_slots(active, join);
 
-	packet_t rxPacket;
+	uint8 quality = 0;
 
-	dwTime_t arrival = {.full = 0};
-	dwt_readrxtimestamp(arrival.raw);
-	dwCorrectTimestamp(&arrival);
+	if (rxPower < -95 * TDOA_RX_POWER_ONE)
+	{
+		quality |= TDOA_QUALITY_LOW_POWER;
+	}
+	else if (rxPower > TDOA_BIAS_TOP)
+	{
+		quality |= TDOA_QUALITY_HIGH_POWER;
+	}
+	if (clockFilters[anchor].count == TDOA_CLOCK_FILTER_LEN)
+	{
+		quality |= TDOA_QUALITY_CLOCK_SETTLED;
+	}
+	if (((tdoa_tdma_slot_of(active, join, previousAnchor) + 1) % slots) != tdoa_tdma_slot_of(active, join, anchor))
+	{
+		quality |= TDOA_QUALITY_ANCHOR_SKIPPED;
+	}
+	return quality;
+}
 
-	dwt_readrxdata((uint8 *)&rxPacket, rxd->datalength, 0);  // Read Data Frame
+/*
+ * Variance of a distance difference in m^2, for the host filter and the one
+ * on the tag. TAG_VARIANCE_BASE grows below TAG_VARIANCE_POWER_REF, outside
+ * of the bias table, with an attenuated first path, an unsettled clock fit
+ * and for a pair that is not the previous packet of the TDMA frame, then the
+ * jitter the clock fit of An left is added. firstTry is nonzero for the pair
+ * of the anchor received right before An.
+ */
+static float measurementVariance(const int16 rxPower, const uint8 quality, const uint8_t anchor, const uint8 firstTry)
+{
+	float variance = TAG_VARIANCE_BASE;
 
-	const uint8_t anchor = rxPacket.sourceAddress[0] & 0xFF;
+	if ((rxPower != TDOA_RX_POWER_INVALID) && (rxPower < TAG_VARIANCE_POWER_REF))
+	{
+		variance *= 1.0f + (float)(TAG_VARIANCE_POWER_REF - rxPower) * (1.0f / TAG_VARIANCE_POWER_STEP);
+	}
+	if (quality & (TDOA_QUALITY_LOW_POWER | TDOA_QUALITY_HIGH_POWER))
+	{
+		variance *= TAG_VARIANCE_BIAS;
+	}
+	if (quality & (TDOA_QUALITY_NLOS_SUSPECT | TDOA_QUALITY_NLOS))
+	{
+		variance *= (quality & TDOA_QUALITY_NLOS) ? TAG_NLOS_VARIANCE * TAG_NLOS_VARIANCE : TAG_NLOS_VARIANCE;
+	}
+	if (!(quality & TDOA_QUALITY_CLOCK_SETTLED))
+	{
+		variance *= TAG_VARIANCE_CLOCK;
+	}
+	if (!firstTry || (quality & TDOA_QUALITY_ANCHOR_SKIPPED))
+	{
+		variance *= TAG_VARIANCE_PAIR;
+	}
+	return variance + clockJitter[anchor];
+}
 
-	if (anchor < NR_OF_ANCHORS)
+// Next free output entry, NULL and counted as an overflow if the queue is full
+static usb_out_t *outQueueReserve(void)
+{
+	const uint8 head = outQueueHead;
+	if ((uint8)(head - outQueueTail) >= OUT_QUEUE_SIZE)
 	{
-		const rangePacket_t* packet = (rangePacket_t*)rxPacket.payload;
+		statsOutputOverflows++;
+		return NULL;
+	}
+	return &outQueue[head & (OUT_QUEUE_SIZE - 1)];
+}
 
-		calcClockCorrection(&clockCorrection_T_To_A[anchor], anchor, packet, &arrival);
+// Publishes the entry returned by outQueueReserve
+static void outQueueCommit(void)
+{
+	__asm volatile ("" ::: "memory");
+	outQueueHead = outQueueHead + 1;
+}
 
-		if (anchor != previousAnchor)
-		{
-			float tdoaDistDiff = 0.0f;
+// Oldest measurement not sent yet, NULL if there is none
+usb_out_t *tdoa_out_peek(void)
+{
+	const uint8 tail = outQueueTail;
+	if (tail == outQueueHead)
+	{
+		return NULL;
+	}
+	return &outQueue[tail & (OUT_QUEUE_SIZE - 1)];
+}
 
-			if (calcDistanceDiff(&tdoaDistDiff, previousAnchor, anchor, packet, &arrival))
-			{
-				statsAcceptedAnchorDataPackets++;
+// Releases the entry returned by tdoa_out_peek
+void tdoa_out_pop(void)
+{
+	__asm volatile ("" ::: "memory");
+	outQueueTail = outQueueTail + 1;
+}
 
-				usbData.distanceDiff = tdoaDistDiff;
-				usbData.prevAnc = previousAnchor;
-				usbData.currAnc = anchor;
-				usbDataReady = 1;
+uint8 tdoa_out_count(void)
+{
+	return (uint8)(outQueueHead - outQueueTail);
+}
 
-			}
+void tdoa_get_status(tdoa_status_t *status)
+{
+	status->rxDropped = statsDroppedFrames + statsRxOverruns;
+	status->outDropped = statsOutputOverflows;
+}
+
+/*
+ * Complete command of the USB receive path (process_usbmessage). The anchor
+ * and model frames of the on-tag filter, the capture and the output frame
+ * are handled, anything else is ignored.
+ */
+void tdoa_usb_command(const uint8_t *msg, int len)
+{
+	static tdoa_anchor_config_t anchors;
+	tdoa_output_config_t output;
+
+	if (tdoa_anchor_frame_decode(msg, len, &anchors))
+	{
+		if (anchors.cell < TAG_CELLS)
+		{
+			cellAnchors[anchors.cell] = anchors;
 		}
+	}
+	else if (tdoa_output_frame_decode(msg, len, &output))
+	{
+		tag_output_configure(&output);
+	}
+#if TAG_CAPTURE
+	else if (msg[0] == TDOA_CAPTURE_FRAME_SYNC)
+	{
+		uint8_t action;
+		if (tdoa_capture_frame_decode(msg, len, &action))
+		{
+			tag_capture_command(action);
+		}
+	}
+#endif
+#if TAG_EKF
+	else
+	{
+		tdoa_model_config_t model;
+		if (tdoa_model_frame_decode(msg, len, &model))
+		{
+			tdoa_ekf_set_model(&model);
+		}
+	}
+#endif
+}
 
-		arrivals[anchor].full = arrival.full;
-		memcpy(&rxPacketBuffer[anchor], rxPacket.payload, sizeof(rangePacket_t));
-		sequenceNrs[anchor] = packet->Idx;
+// Anchor layout of cell, NULL until the host sent it
+const tdoa_anchor_config_t *tdoa_get_anchors(uint8 cell)
+{
+	return ((cell < TAG_CELLS) && (cellAnchors[cell].count != 0)) ? &cellAnchors[cell] : NULL;
+}
 
-		previousAnchor = anchor;
+/*
+ * A distance difference can not exceed the distance of its two anchors, so
+ * larger values come from a bad timestamp. The distance is taken from the
+ * anchor layout once the host sent it, otherwise from the time of flight An
+ * measured to Ar, which every measurement carries. Compared squared to skip
+ * the square root, rejects are counted in statsGateRejects.
+ */
+static uint8 distanceDiffPlausible(float distanceDiff, const uint8 An, const rx_pair_t *pair)
+{
+	const float excess = fabsf(distanceDiff) - MAX_DISTANCE_DIFF_MARGIN;
+	if (excess <= 0.0f)
+	{
+		return 1;
 	}
 
-	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+	const uint8 Ar = pair->Ar;
+	const tdoa_anchor_config_t *layout = tdoa_get_anchors(tagCell);
+	float baseline = 0.0f;
+	if ((layout != NULL) && (Ar < layout->count) && (An < layout->count))
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			const float d = layout->pos[An][j] - layout->pos[Ar][j];
+			baseline += d*d;
+		}
+	}
+	else
+	{
+		const float d = pair->tofAr_to_An * (float)(TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ);
+		baseline = d*d;
+	}
+
+	if ((excess*excess) > baseline)
+	{
+		statsGateRejects++;
+		return 0;
+	}
+	return 1;
 }
 
-void rx_to_cb(const dwt_cb_data_t *cb_data)
+/*
+ * Fills the telemetry frame, all but periodMs, and starts the next period.
+ * The DW1000 interrupt is held off while its event counters are read over
+ * the shared SPI.
+ */
+void tdoa_get_telemetry(tdoa_telemetry_t *telemetry)
 {
-	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+	dwt_deviceentcnts_t events;
+	int i;
+
+	port_DisableEXT_IRQ();
+	dwt_readeventcounters(&events);
+	telemetry->isrMinCycles = (isrMinCycles == 0xFFFFFFFF) ? 0 : isrMinCycles;
+	telemetry->isrMaxCycles = isrMaxCycles;
+	isrMinCycles = 0xFFFFFFFF;
+	isrMaxCycles = 0;
+	port_EnableEXT_IRQ();
+
+	telemetryTotals.rxGood += (events.CRCG - lastEvents.CRCG) & 0xFFF;
+	telemetryTotals.rxTimeouts += ((events.PTO - lastEvents.PTO) & 0xFFF) + ((events.SFDTO - lastEvents.SFDTO) & 0xFFF)
+	                            + ((events.RTO - lastEvents.RTO) & 0xFFF);
+	telemetryTotals.rxErrors += ((events.PHE - lastEvents.PHE) & 0xFFF) + ((events.RSL - lastEvents.RSL) & 0xFFF)
+	                          + ((events.CRCB - lastEvents.CRCB) & 0xFFF);
+	lastEvents = events;
+
+	telemetry->rxGood = telemetryTotals.rxGood;
+	telemetry->rxTimeouts = telemetryTotals.rxTimeouts;
+	telemetry->rxErrors = telemetryTotals.rxErrors;
+	telemetry->ringDrops = statsDroppedFrames;
+	telemetry->rxOverruns = statsRxOverruns;
+	telemetry->clockRejects = statsClockRejects;
+	telemetry->nlosDrops = statsNlosDrops;
+	telemetry->anchors = lastSlots;
+	telemetry->profile = ((portGetTickCnt() - lastPhyRx) > TAG_PHY_LOST_MS) ? TDOA_PHY_UNKNOWN : phyProfile;
+	memcpy(telemetry->anchorPackets, anchorPackets, sizeof(anchorPackets));
+	for (i = 0; i < NR_OF_ANCHORS; i++) {
+		telemetry->anchorPower[i] = anchorPowerCount[i] ? (int16_t)(anchorPowerSum[i] / anchorPowerCount[i]) : TDOA_TELEMETRY_NO_POWER;
+		telemetry->anchorFpRatio[i] = anchorPowerCount[i] ? (int16_t)(anchorFpSum[i] / anchorPowerCount[i]) : 0;
+	}
+	memset(anchorPackets, 0, sizeof(anchorPackets));
+	memset(anchorPowerSum, 0, sizeof(anchorPowerSum));
+	memset(anchorFpSum, 0, sizeof(anchorFpSum));
+	memset(anchorPowerCount, 0, sizeof(anchorPowerCount));
 }
 
-void rx_err_cb(const dwt_cb_data_t *cb_data)
+// DW1000 system time, the clock of the arrival times. Read with the interrupt held off, it shares the SPI
+uint64_t tdoa_sys_time(void)
 {
-	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+	dwTime_t now;
+
+	now.full = 0;
+	port_DisableEXT_IRQ();
+	dwt_readsystime(now.raw);
+	port_EnableEXT_IRQ();
+	return now.full;
 }
 
+#if USB_SYNC_MS
+// Main loop: takes the reference pair for the next SOF, both read back to back
+void tdoa_sync_arm(void)
+{
+	dwTime_t now;
 
-static const uint8_t BIAS_500_16_ZERO = 10;
-static const uint8_t BIAS_500_64_ZERO = 8;
-static const uint8_t BIAS_900_16_ZERO = 7;
-static const uint8_t BIAS_900_64_ZERO = 7;
+	if(syncArmed)
+	{
+		return;
+	}
+	now.full = 0;
+	port_DisableEXT_IRQ();
+	dwt_readsystime(now.raw);
+	syncRefCycles = TDOA_DWT_CYCCNT;
+	port_EnableEXT_IRQ();
+	syncRefTime = now.full;
+	syncArmed = 1;
+}
+
+/*
+ * USB SOF interrupt, right before the IN transfer of the frame is set up.
+ * The DW1000 cannot be read here, the main loop may be in the middle of an
+ * SPI transfer, so the system time at the SOF is the armed reference moved
+ * on by the CPU cycles since. Within a ms of arming the two crystals differ
+ * by some ns. Writes the sync frame to msg, returns its size or 0 when not
+ * armed.
+ */
+size_t tdoa_sync_sof(uint8_t *msg)
+{
+	tdoa_sync_t sync;
 
-// range bias tables (500 MHz in [mm] and 900 MHz in [2mm] - to fit into bytes)
-static const uint8_t BIAS_500_16[] = {198, 187, 179, 163, 143, 127, 109, 84, 59, 31,   0,  36,  65,  84,  97, 106, 110, 112};
-static const uint8_t BIAS_500_64[] = {110, 105, 100,  93,  82,  69,  51, 27,  0, 21,  35,  42,  49,  62,  71,  76,  81,  86};
-static const uint8_t BIAS_900_16[] = {137, 122, 105, 88, 69,  47,  25,  0, 21, 48, 79, 105, 127, 147, 160, 169, 178, 197};
-static const uint8_t BIAS_900_64[] = {147, 133, 117, 99, 75, 50, 29, 0, 24, 45, 63, 76, 87, 98, 116, 122, 132, 142};
+	if(!syncArmed)
+	{
+		return 0;
+	}
+	const uint32_t cycles = TDOA_DWT_CYCCNT - syncRefCycles;
+	sync.seq = syncSeq++;
+	sync.sofTime = tdoa_time_add(syncRefTime, (int64_t)(((uint64_t)cycles * syncTicksPerCycle) >> 16));
+	syncArmed = 0;
+	tdoa_sync_frame_encode(msg, &sync);
+	return TDOA_SYNC_FRAME_SIZE;
+}
+#else
+void tdoa_sync_arm(void)
+{
+}
 
+size_t tdoa_sync_sof(uint8_t *msg)
+{
+	return 0;
+}
+#endif
+
+/*
+ * Runs in the DW1000 interrupt with the receive registers already read. Only
+ * copies what is lost once the receive buffer is reused into the ring: arrival
+ * time, frame quality registers and, from the frame, the source address and
+ * the fields of the range packet that belong to the sender An and to the
+ * anchors of the pairs of TDOA_PAIRS. The computations are done by
+ * tdoa_process in the main loop.
+ */
 #pragma GCC optimize ("O3")
-void dwCorrectTimestamp(dwTime_t* timestamp)
+
+// Decodes the entry of Ar in a range packet of An, relative to the slots of its frame
+static inline void rxPair(rx_pair_t *pair, uint8 Ar, const uint8 *entry, const rangePacket_t *packet, uint8 An)
 {
-	// base line dBm, which is -61, 2 dBm steps, total 18 data points (down to -95 dBm)
-	float rxPowerBase = -(dwGetReceivePower() + 61.0f) * 0.5f;
-	if (!isfinite(rxPowerBase)) {
-		return;
+	const uint8 slotAn = tdoa_tdma_slot_of(packet->active, packet->join, An);
+	const uint8 slotAr = tdoa_tdma_slot_of(packet->active, packet->join, Ar);
+
+	pair->Ar = Ar;
+	pair->rxAr_by_An = tdoa_range_entry_rx(entry, tdoa_range_expected_rx(packet->txTime, slotAn, slotAr,
+			tdoa_tdma_slots(packet->active, packet->join), packet->slotUnits));
+	pair->tofAr_to_An = tdoa_range_entry_distance(entry);
+}
+
+#if TDOA_PAIRS == TDOA_PAIRS_ALL
+// All entries of the packet in one read, the anchors of the current TDMA frame are picked by tdoa_process
+static inline void rxAllPairs(rx_frame_t *frame, const rangePacket_t *packet, uint8 An)
+{
+	uint8 entries[RX_MAX_PAIRS * TDOA_RANGE_ENTRY_SIZE];
+	const uint8 slots = packet->anchors;
+	uint8 count = tdoa_range_entry_index(packet->bitmap, slots);
+	uint8 k, n;
+
+	if (count > RX_MAX_PAIRS)
+	{
+		count = RX_MAX_PAIRS;
 	}
-	int rxPowerBaseLow = (int)rxPowerBase;
-	int rxPowerBaseHigh = rxPowerBaseLow + 1;
-	if(rxPowerBaseLow < 0)
+	if (count > 0)
 	{
-		rxPowerBaseLow = 0;
-		rxPowerBaseHigh = 0;
+		dwt_readrxdata(entries, count * TDOA_RANGE_ENTRY_SIZE, RX_ENTRY_OFFSET(slots, 0));
 	}
-	else if(rxPowerBaseHigh > 17)
+	for (k = 0, n = 0; (k < slots) && (n < count); k++)
 	{
-		rxPowerBaseLow = 17;
-		rxPowerBaseHigh = 17;
+		if (tdoa_range_has_entry(packet->bitmap, k))
+		{
+			if (k != An)
+			{
+				rxPair(&frame->pair[frame->pairs++], k, &entries[n * TDOA_RANGE_ENTRY_SIZE], packet, An);
+			}
+			n++;
+		}
 	}
-	// select range low/high values from corresponding table
-	int rangeBiasHigh = 0;
-	int rangeBiasLow = 0;
-	if(anc_chan == 4 || anc_chan == 7)
+}
+#endif
+
+#if USB_RANGES_EVERY
+// Times of flight of all entries of the packet in one read, for the ranges frame of the host anchor survey
+static inline void rxRanges(rx_frame_t *frame, const rangePacket_t *packet, uint8 An)
+{
+	uint8 entries[(NR_OF_ANCHORS - 1) * TDOA_RANGE_ENTRY_SIZE];
+	const uint8 slots = packet->anchors;
+	uint8 count = tdoa_range_entry_index(packet->bitmap, slots);
+	uint8 k, n;
+
+	if (count > NR_OF_ANCHORS - 1)
+	{
+		count = NR_OF_ANCHORS - 1;
+	}
+	if (count > 0)
 	{
-		// 900 MHz receiver bandwidth
-		if(anc_prf == DWT_PRF_16M)
+		dwt_readrxdata(entries, count * TDOA_RANGE_ENTRY_SIZE, RX_ENTRY_OFFSET(slots, 0));
+	}
+	for (k = 0, n = 0; (k < slots) && (n < count); k++)
+	{
+		if (tdoa_range_has_entry(packet->bitmap, k))
 		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_900_16_ZERO ? -BIAS_900_16[rxPowerBaseHigh] : BIAS_900_16[rxPowerBaseHigh]);
-			rangeBiasHigh <<= 1;
-			rangeBiasLow = (rxPowerBaseLow < BIAS_900_16_ZERO ? -BIAS_900_16[rxPowerBaseLow] : BIAS_900_16[rxPowerBaseLow]);
-			rangeBiasLow <<= 1;
-		} else if(anc_prf == DWT_PRF_64M)
+			const uint16_t tof = tdoa_range_entry_distance(&entries[n * TDOA_RANGE_ENTRY_SIZE]);
+			if ((k != An) && (tof != 0))
+			{
+				frame->rangeAr[frame->ranges] = k;
+				frame->rangeTof[frame->ranges++] = tof;
+			}
+			n++;
+		}
+	}
+}
+#endif
+
+#if TAG_SNIFF
+// Back to continuous listen, the grid is learned again from the next packets
+static void sniffReset(void)
+{
+	if (sniffLocked)
+	{
+		dwt_setpreambledetecttimeout(0);
+	}
+	sniffLocked = 0;
+	sniffOnGrid = 0;
+	sniffMisses = 0;
+	sniffLast = 0;
+}
+
+/*
+ * A packet of tagCell whose RMARKER arrived at arrival. The interval to the
+ * previous one has to be a whole number of slots to within
+ * TAG_SNIFF_TOLERANCE: the drift of the tag clock over a few slots and the
+ * distances to the anchors stay far below it, lost packets and join slots
+ * only skip slots. After TAG_SNIFF_LOCK_PACKETS such intervals each window
+ * opens TAG_SNIFF_GUARD symbols before the preamble of the next slot, and
+ * the preamble timeout closes it TAG_SNIFF_GUARD symbols into the preamble.
+ */
+static void sniffPacket(uint64_t arrival, uint8 slots, uint16 slotUnits)
+{
+	const uint64_t slotTicks = (uint64_t)slotUnits << TDOA_SLOT_UNIT_SHIFT;
+
+	if ((sniffLast != 0) && (slotUnits == sniffSlotUnits))
+	{
+		const uint64_t interval = (arrival - sniffLast) & MASK_40BIT;
+		const uint32_t d = ((uint32_t)(interval >> TDOA_SLOT_UNIT_SHIFT) + slotUnits / 2) / slotUnits;
+		const int64_t residual = (int64_t)interval - (int64_t)(d * slotTicks);
+
+		if ((d > 0) && (d <= 2 * TDOA_MAX_ANCHORS) && (residual <= TAG_SNIFF_TOLERANCE) && (residual >= -TAG_SNIFF_TOLERANCE))
+		{
+			if (sniffOnGrid < 0xFF)
+			{
+				sniffOnGrid++;
+			}
+		}
+		else
 		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_900_64_ZERO ? -BIAS_900_64[rxPowerBaseHigh] : BIAS_900_64[rxPowerBaseHigh]);
-			rangeBiasHigh <<= 1;
-			rangeBiasLow = (rxPowerBaseLow < BIAS_900_64_ZERO ? -BIAS_900_64[rxPowerBaseLow] : BIAS_900_64[rxPowerBaseLow]);
-			rangeBiasLow <<= 1;
-		} else {
-			// TODO proper error handling
+			sniffOnGrid = 0;
 		}
 	}
 	else
 	{
-		// 500 MHz receiver bandwidth
-		if(anc_prf == DWT_PRF_16M)
+		sniffOnGrid = 0;
+	}
+	sniffLast = arrival;
+	sniffSlots = slots;
+	sniffSlotUnits = slotUnits;
+	sniffNext = arrival + slotTicks;
+	sniffMisses = 0;
+
+	if (sniffLocked || (sniffOnGrid < TAG_SNIFF_LOCK_PACKETS) || (phyProfile == TDOA_PHY_UNKNOWN))
+	{
+		return;
+	}
+	// Preamble and SFD come before the RMARKER, the SFD timeout is their length + 1 - PAC
+	const uint8 pac = TDOA_PHY_TABLE[phyProfile].pac;
+	const uint32_t symbols = baseConfig.sfdTO + pac - 1 + TAG_SNIFF_GUARD;
+	if ((uint64_t)(symbols + TAG_SNIFF_GUARD) * TAG_SNIFF_SYMBOL_TICKS >= slotTicks)
+	{
+		// A window would cover the whole slot
+		return;
+	}
+	sniffLead = symbols * TAG_SNIFF_SYMBOL_TICKS;
+	dwt_setpreambledetecttimeout(2 * TAG_SNIFF_GUARD / pac + 1);
+	sniffLocked = 1;
+	statsSniffLocks++;
+}
+
+/*
+ * Enables the receiver after an event, missed for a timeout or a receive
+ * error. While sniffing that is the window of the next slot, a frame
+ * without a packet in any of its windows falls back to continuous listen.
+ * A late window starts right away.
+ */
+static void sniffRearm(int mode, uint8 missed)
+{
+	if (sniffLocked && missed)
+	{
+		statsSniffMisses++;
+		sniffNext += (uint64_t)sniffSlotUnits << TDOA_SLOT_UNIT_SHIFT;
+		if (++sniffMisses >= sniffSlots)
 		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_500_16_ZERO ? -BIAS_500_16[rxPowerBaseHigh] : BIAS_500_16[rxPowerBaseHigh]);
-			rangeBiasLow = (rxPowerBaseLow < BIAS_500_16_ZERO ? -BIAS_500_16[rxPowerBaseLow] : BIAS_500_16[rxPowerBaseLow]);
+			sniffReset();
 		}
-		else if(anc_prf == DWT_PRF_64M)
+	}
+	if (sniffLocked)
+	{
+		dwt_write32fast(DX_TIME_ID, 1, (uint32)(((sniffNext - sniffLead) & MASK_40BIT) >> 8));
+		if (dwt_rxenable(mode | DWT_START_RX_DELAYED))
 		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_500_64_ZERO ? -BIAS_500_64[rxPowerBaseHigh] : BIAS_500_64[rxPowerBaseHigh]);
-			rangeBiasLow = (rxPowerBaseLow < BIAS_500_64_ZERO ? -BIAS_500_64[rxPowerBaseLow] : BIAS_500_64[rxPowerBaseLow]);
+			// The receiver is on right away, the preamble timeout ends the window
+			statsSniffLate++;
 		}
-		else
+		return;
+	}
+	dwt_rxenable(mode);
+}
+#else
+static void sniffReset(void)
+{
+}
+
+static void sniffRearm(int mode, uint8 missed)
+{
+	(void)missed;
+	dwt_rxenable(mode);
+}
+#endif
+
+static void tdoa_rx_frame(const tdoa_rx_regs_t *regs)
+{
+	const uint16 length = regs->finfo[0] & RX_FINFO_RXFLEN_MASK;
+
+	statsReceivedPackets++;
+
+	const uint8 head = rxRingHead;
+	if ((uint8)(head - rxRingTail) >= RX_RING_SIZE)
+	{
+		statsDroppedFrames++;
+	}
+	else if (length >= RX_RANGE_PACKET_LEN(TDOA_MIN_ANCHORS, 0))
+	{
+		rx_frame_t *frame = &rxRing[head & (RX_RING_SIZE - 1)];
+		const uint8 cell = rxCell;
+		uint8 header[RX_SOURCE_OFFSET + 1 - RX_PAN_OFFSET];
+		rangePacket_t packet;
+
+		// PAN ID to source address in one read, anchors of another cell may share the preamble code and channel
+		packet.type = 0;
+		dwt_readrxdata(header, sizeof(header), RX_PAN_OFFSET);
+		const uint16 pan = header[0] | (header[1] << 8);
+		const uint8 source = header[sizeof(header) - 1];
+		if ((pan == TDOA_CELL_PAN(cell)) && (source < NR_OF_ANCHORS))
 		{
-			// TODO proper error handling
+			// Header and bitmap in one read, bytes past a short bitmap are not used
+			dwt_readrxdata((uint8 *)&packet, sizeof(packet), RX_RANGE_OFFSET);
+		}
+		const uint8 slots = packet.anchors;
+
+		// The sender has to hold a slot of the frame it announces
+		if ((packet.type == PACKET_TYPE_RANGE) && (slots >= TDOA_MIN_ANCHORS) && (slots <= NR_OF_ANCHORS) && (source < slots)
+		    && (tdoa_tdma_slot_of(packet.active, packet.join, source) < tdoa_tdma_slots(packet.active, packet.join))
+		    && (length >= RX_RANGE_PACKET_LEN(slots, tdoa_range_entry_index(packet.bitmap, slots))))
+		{
+			// Packets of a visited cell only count for its power, Ar = An gives them no entry
+			const uint8 Ar = (cell == tagCell) ? previousAnchor : source;
+
+			frame->arrival.full = 0;
+			memcpy(frame->arrival.raw, regs->rxTime, RX_TIME_RX_STAMP_LEN);
+			frame->cirPower = (uint16)(regs->fqual[CIR_PWR_OFFSET] | (regs->fqual[CIR_PWR_OFFSET+1] << 8));
+			frame->fpAmpl[0] = (uint16)(regs->rxTime[RX_TIME_FP_AMPL1_OFFSET] | (regs->rxTime[RX_TIME_FP_AMPL1_OFFSET+1] << 8));
+			frame->fpAmpl[1] = (uint16)(regs->fqual[FP_AMPL2_OFFSET] | (regs->fqual[FP_AMPL2_OFFSET+1] << 8));
+			frame->fpAmpl[2] = (uint16)(regs->fqual[FP_AMPL3_OFFSET] | (regs->fqual[FP_AMPL3_OFFSET+1] << 8));
+			memcpy(frame->rxFrameInfo, regs->finfo, RX_FINFO_LEN);
+
+			frame->Ar = Ar;
+			frame->An = source;
+			frame->Idx = packet.Idx;
+			frame->slots = slots;
+			frame->active = packet.active;
+			frame->join = packet.join;
+			frame->cell = cell;
+			frame->txAn = packet.txTime;
+			frame->pairs = 0;
+#if USB_RANGES_EVERY
+			frame->ranges = 0;
+#endif
+
+			if (cell == tagCell)
+			{
+#if TAG_SNIFF
+				sniffPacket(frame->arrival.full, tdoa_tdma_slots(packet.active, packet.join), packet.slotUnits);
+#endif
+#if TDOA_PAIRS == TDOA_PAIRS_ALL
+				if (pairMode == TDOA_PAIRS_ALL)
+				{
+					rxAllPairs(frame, &packet, source);
+				}
+				else
+#endif
+				{
+					const uint8 Aref = (pairMode == TDOA_PAIRS_REFERENCE) ? TDOA_REFERENCE_ANCHOR : Ar;
+
+					// The consecutive pair is always kept for raw mode, an Ar without an entry, also beyond
+					// a shrunk schedule, stays zero and fails the checks of calcDistanceDiff
+					if ((pairMode == TDOA_PAIRS_CONSECUTIVE) || (Aref != source))
+					{
+						rx_pair_t *pair = &frame->pair[frame->pairs++];
+
+						pair->Ar = Aref;
+						pair->rxAr_by_An = 0;
+						pair->tofAr_to_An = 0;
+						if ((Aref < slots) && tdoa_range_has_entry(packet.bitmap, Aref))
+						{
+							uint8 entry[TDOA_RANGE_ENTRY_SIZE];
+
+							dwt_readrxdata(entry, sizeof(entry), RX_ENTRY_OFFSET(slots, tdoa_range_entry_index(packet.bitmap, Aref)));
+							rxPair(pair, Aref, entry, &packet, source);
+						}
+					}
+				}
+#if USB_RANGES_EVERY
+				if (--rangesCountdown[source] == 0)
+				{
+					rangesCountdown[source] = USB_RANGES_EVERY;
+					rxRanges(frame, &packet, source);
+				}
+#endif
+				previousAnchor = source;
+			}
+
+			// Publish the slot only once it is complete
+			__asm volatile ("" ::: "memory");
+			rxRingHead = head + 1;
 		}
 	}
-	// linear interpolation of bias values
-	float rangeBias = rangeBiasLow + (rxPowerBase - rxPowerBaseLow) * (rangeBiasHigh - rangeBiasLow);
-	// range bias [mm] to timestamp modification value conversion
-	dwTime_t adjustmentTime;
-	adjustmentTime.full = (int)(rangeBias * DISTANCE_OF_RADIO_INV * 0.001f);
-	// apply correction
-	timestamp->full += adjustmentTime.full;
 }
 
+// Good frame callback of dwt_isr, reads the registers tdoa_isr gets in its fused pass
 #pragma GCC optimize ("O3")
-float dwGetReceivePower(void)
+PORT_RAMFUNC void rx_ok_cb(const dwt_cb_data_t *rxd)
 {
-	uint8 rxFrameInfo[RX_FINFO_LEN];
-	float C = (float)dwt_read16bitoffsetreg(RX_FQUAL_ID, CIR_PWR_OFFSET);
-	dwt_readfromdevice(RX_FINFO_ID,RX_FINFO_OFFSET,RX_FINFO_LEN,rxFrameInfo);
-	float N = (float)((((unsigned int)rxFrameInfo[2] >> 4) & 0xFF) | ((unsigned int)rxFrameInfo[3] << 4));
+	tdoa_rx_regs_t regs;
+
+	regs.status = rxd->status;
+	dwt_readfast(RX_FINFO_ID, RX_FINFO_OFFSET, RX_FINFO_LEN, regs.finfo);
+	dwt_readfast(RX_FQUAL_ID, 0, RX_FQUAL_LEN, regs.fqual);
+	dwt_readfast(RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, RX_TIME_FP_LEN, regs.rxTime);
 
-	return calculatePower(C * TWOPOWER17, N);
+	tdoa_rx_frame(&regs);
+
+	sniffRearm(DWT_START_RX_IMMEDIATE, 0);
 }
 
+/*
+ * Replaces dwt_isr on the tag (TDOA_FAST_ISR). Reads the status and then each
+ * receive register the TDOA path needs exactly once, one full-register read
+ * per register file, without the frame control read and acknowledgement
+ * handling of dwt_isr. The tag never transmits, TX events are not handled.
+ *
+ * With TDOA_DOUBLE_BUFFER the receiver is re-armed into the IC side buffer
+ * before the host side one is read, and the host side buffer is handed back by
+ * toggling HRBPT once its frame is copied. The pointers must stay as they are
+ * across that re-enable (DWT_NO_SYNC_PTRS). A frame already waiting in the
+ * other buffer keeps the IRQ line high and is read by the next pass of
+ * EXTI9_5_IRQHandler.
+ */
 #pragma GCC optimize ("O3")
-float calculatePower(float base, float N)
+static PORT_RAMFUNC void tdoa_isr_events(void)
 {
-	float A, corrFac;
+	tdoa_rx_regs_t regs;
+
+	regs.status = dwt_read32fast(SYS_STATUS_ID, 0);
+
+#if TDOA_DOUBLE_BUFFER
+	// A frame arrived with both buffers full, their contents can no longer be
+	// trusted. dwt_forcetrxoff clears the events and realigns the buffer pointers
+	if (regs.status & SYS_STATUS_RXOVRR)
+	{
+		statsRxOverruns++;
+
+		dwt_forcetrxoff();
+		dwt_rxreset();
+
+		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+		return;
+	}
+#endif
+
+	if (regs.status & SYS_STATUS_RXFCG)
+	{
+#if TDOA_DOUBLE_BUFFER
+		// While sniffing the next slot is far enough off to re-arm once the frame is read
+#if TAG_SNIFF
+		const uint8 sniffing = sniffLocked;
+#else
+		const uint8 sniffing = 0;
+#endif
+		if (!sniffing)
+		{
+			dwt_rxenable(DWT_START_RX_IMMEDIATE | DWT_NO_SYNC_PTRS);
+		}
+#endif
+		dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_GOOD);
+
+		dwt_readfast(RX_FINFO_ID, RX_FINFO_OFFSET, RX_FINFO_LEN, regs.finfo);
+		dwt_readfast(RX_FQUAL_ID, 0, RX_FQUAL_LEN, regs.fqual);
+		dwt_readfast(RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, RX_TIME_FP_LEN, regs.rxTime);
+
+		tdoa_rx_frame(&regs);
+
+#if TDOA_DOUBLE_BUFFER
+		dwt_write8fast(SYS_CTRL_ID, SYS_CTRL_HRBT_OFFSET, 1);
+		if (sniffing)
+		{
+			sniffRearm(DWT_START_RX_IMMEDIATE | DWT_NO_SYNC_PTRS, 0);
+		}
+#else
+		sniffRearm(DWT_START_RX_IMMEDIATE, 0);
+#endif
+	}
+
+	// Same recovery as dwt_isr, the RX reset keeps the next timestamp valid. An empty sniff window ends here as well
+	if (regs.status & (SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR))
+	{
+		dwt_write32fast(SYS_STATUS_ID, 0, SYS_STATUS_ALL_RX_TO | SYS_STATUS_ALL_RX_ERR);
+
+		dwt_forcetrxoff();
+		dwt_rxreset();
 
-	if(DWT_PRF_16M == anc_prf)
+		sniffRearm(DWT_START_RX_IMMEDIATE, 1);
+	}
+}
+
+// Power of a packet of cell, invalid powers are left out
+static void addCellPower(uint8 cell, int16 rxPower)
+{
+	if ((rxPower == TDOA_RX_POWER_INVALID) || (cell >= TAG_CELLS))
+	{
+		return;
+	}
+	if (cell != tagCell)
 	{
-		A = 115.72f;
-		corrFac = 2.3334f;
+		cellPower[cell] += rxPower;
+	}
+	else if (cellPackets[cell] == 0)
+	{
+		cellPower[cell] = rxPower;
 	}
 	else
 	{
-		A = 121.74f;
-		corrFac = 1.1667f;
+		cellPower[cell] += (rxPower - cellPower[cell]) >> TAG_CELL_POWER_SHIFT;
+	}
+	if (cellPackets[cell] < 0xFFFF)
+	{
+		cellPackets[cell]++;
 	}
+}
+
+// DW1000 interrupt of TDOA_FAST_ISR, timed with the cycle counter for the telemetry
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC void tdoa_isr(void)
+{
+	const uint32_t start = TDOA_DWT_CYCCNT;
 
-	float estFpPwr = 10.0f * log10f(base / (N * N)) - A;
+	tdoa_isr_events();
+
+	const uint32_t cycles = TDOA_DWT_CYCCNT - start;
+	if (cycles < isrMinCycles) isrMinCycles = cycles;
+	if (cycles > isrMaxCycles) isrMaxCycles = cycles;
+#if TDOA_TRACE
+	tdoa_trace_add(TDOA_TRACE_DWT_ISR, cycles);
+#endif
+}
 
-	if(estFpPwr <= -88)
+#if TAG_CAPTURE
+// One flash record per pair of the frame, a packet without a pair gives one with Ar = An for its timestamps
+static void captureFrame(const rx_frame_t *frame, const dwTime_t *arrival, int16 rxPower, int16 fpGap, uint8 nlos)
+{
+	tdoa_capture_rec_t rec;
+	uint8 p = 0;
+
+	rec.quality = rxQuality(rxPower, frame->Ar, frame->An, frame->active, frame->join) | nlos;
+	rec.An = TDOA_CELL_ID(tagCell, frame->An);
+	rec.idx = frame->Idx;
+	rec.rxAn_by_T = arrival->full & MASK_40BIT;
+	rec.txAn = frame->txAn;
+	rec.rxPower = rxPower;
+	rec.fpGap = fpGap;
+	rec.slots = frame->slots;
+	do
+	{
+		const rx_pair_t *pair = (p < frame->pairs) ? &frame->pair[p] : NULL;
+
+		rec.Ar = TDOA_CELL_ID(tagCell, pair ? pair->Ar : frame->An);
+		rec.rxAr_by_An = pair ? pair->rxAr_by_An : 0;
+		rec.tofAr_to_An = pair ? pair->tofAr_to_An : 0;
+		tag_capture_record(&rec);
+	} while (++p < frame->pairs);
+}
+#endif
+
+/*
+ * Processes the oldest received frame, if any, and queues its result for the
+ * USB. Returns 1 if a frame was consumed.
+ */
+#pragma GCC optimize ("O3")
+uint8 tdoa_process(void)
+{
+	const uint8 tail = rxRingTail;
+	if (tail == rxRingHead)
 	{
-		return estFpPwr;
+		return 0;
+	}
+
+	rx_frame_t *frame = &rxRing[tail & (RX_RING_SIZE - 1)];
+	dwTime_t arrival = frame->arrival;
+	const int16 rxPower = dwGetReceivePower(frame->cirPower, frame->rxFrameInfo);
+	dwCorrectTimestamp(&arrival, rxPower);
+
+	lastPhyRx = portGetTickCnt();
+	addCellPower(frame->cell, rxPower);
+	if (frame->cell != tagCell)
+	{
+		__asm volatile ("" ::: "memory");
+		rxRingTail = tail + 1;
+		return 1;
+	}
+	lastCellRx = lastPhyRx;
+
+	const uint8_t previous = frame->Ar;
+	const uint8_t anchor = frame->An;
+	anchorPackets[anchor]++;
+	int16 fpGap = 0;
+	if (rxPower != TDOA_RX_POWER_INVALID)
+	{
+		const int16 fpPower = dwGetFirstPathPower(frame->fpAmpl, frame->rxFrameInfo);
+		if (fpPower != TDOA_RX_POWER_INVALID)
+		{
+			fpGap = tdoa_fp_gap(rxPower, fpPower);
+			anchorPowerSum[anchor] += rxPower;
+			anchorFpSum[anchor] -= fpGap;
+			anchorPowerCount[anchor]++;
+		}
+	}
+	// The arrival of a packet with a weak first path is that of a reflection, late by the detour
+	const uint8 nlos = (fpGap > TDOA_NLOS_LIKELY) ? TDOA_QUALITY_NLOS : (fpGap > TDOA_NLOS_SUSPECT) ? TDOA_QUALITY_NLOS_SUSPECT : 0;
+	lastSlots = frame->slots;
+
+#if TAG_CAPTURE
+	if (tag_capture_active())
+	{
+		captureFrame(frame, &arrival, rxPower, fpGap, nlos);
+	}
+#endif
+
+	if (rawMode)
+	{
+		usb_out_t *out = outQueueReserve();
+		if (out)
+		{
+			out->type = USB_DATA_RAW;
+			out->raw.Ar = TDOA_CELL_ID(tagCell, previous);
+			out->raw.An = TDOA_CELL_ID(tagCell, anchor);
+			out->raw.idx = frame->Idx;
+			out->raw.rxAn_by_T = arrival.full & MASK_40BIT;
+			out->raw.txAn = frame->txAn;
+			out->raw.rxAr_by_An = frame->pair[0].rxAr_by_An;
+			out->raw.tofAr_to_An = frame->pair[0].tofAr_to_An;
+			outQueueCommit();
+		}
 	}
 	else
 	{
-		// approximation of Fig. 22 in user manual for dbm correction
-		estFpPwr += (estFpPwr + 88) * corrFac;
+		calcClockCorrection(&clockCorrection_T_To_A[anchor], frame, &arrival);
+	}
+
+	if (!rawMode)
+	{
+		uint8 p;
+#if TAG_EKF
+		// Once provisioned the tag sends one estimate per TDMA frame instead of the measurements
+		const uint8 onTagFilter = (tdoa_get_anchors(tagCell) != NULL);
+
+		if (onTagFilter && (anchor < previous) && (tdoa_ekf_updates() > 0))
+		{
+			usb_out_t *out = outQueueReserve();
+			if (out)
+			{
+				out->type = USB_DATA_POSITION;
+				tdoa_ekf_get(&out->position);
+				out->position.seq = positionSeq++;
+				outQueueCommit();
+			}
+		}
+#endif
+
+		for (p = 0; p < frame->pairs; p++)
+		{
+			const rx_pair_t *pair = &frame->pair[p];
+			float tdoaDistDiff = 0.0f;
+
+			if ((pair->Ar == anchor) || !calcDistanceDiff(&tdoaDistDiff, frame, pair, &arrival)
+			    || !distanceDiffPlausible(tdoaDistDiff, anchor, pair))
+			{
+				continue;
+			}
+			if (TAG_NLOS_DROP && (nlos & TDOA_QUALITY_NLOS))
+			{
+				statsNlosDrops++;
+				continue;
+			}
+			statsAcceptedAnchorDataPackets++;
+
+			const uint8 quality = rxQuality(rxPower, previous, anchor, frame->active, frame->join) | nlos;
+			const float variance = measurementVariance(rxPower, quality, anchor, pair->Ar == previous);
+#if TAG_EKF
+			if (onTagFilter)
+			{
+				tdoa_ekf_update(tagCell, pair->Ar, anchor, tdoaDistDiff, arrival.full & MASK_40BIT,
+				                variance * (1.0f / TAG_VARIANCE_BASE));
+			}
+			else
+#endif
+			{
+				usb_msg_t msg;
+				msg.distanceDiff = tdoaDistDiff;
+				msg.prevAnc = TDOA_CELL_ID(tagCell, pair->Ar);
+				msg.currAnc = TDOA_CELL_ID(tagCell, anchor);
+				msg.idx = frame->Idx;
+				msg.rxTime = arrival.full & MASK_40BIT;
+				msg.rxPower = rxPower;
+				msg.quality = quality;
+				msg.variance = variance;
+				if (tag_output_filter(&msg))
+				{
+					usb_out_t *out = outQueueReserve();
+					if (out)
+					{
+						out->type = USB_DATA_TDOA;
+						out->tdoa = msg;
+						outQueueCommit();
+					}
+				}
+			}
+		}
+	}
+
+#if USB_RANGES_EVERY
+	if (frame->ranges > 0)
+	{
+		usb_out_t *out = outQueueReserve();
+		if (out)
+		{
+			uint8 r;
+
+			out->type = USB_DATA_RANGES;
+			out->ranges.An = TDOA_CELL_ID(tagCell, anchor);
+			out->ranges.slots = frame->slots;
+			out->ranges.count = frame->ranges;
+			for (r = 0; r < frame->ranges; r++)
+			{
+				out->ranges.Ar[r] = TDOA_CELL_ID(tagCell, frame->rangeAr[r]);
+				out->ranges.tof[r] = frame->rangeTof[r];
+			}
+			outQueueCommit();
+		}
+	}
+#endif
+
+	pushArrival(anchor, arrival.full);
+
+	// Hand the slot back to the ISR
+	__asm volatile ("" ::: "memory");
+	rxRingTail = tail + 1;
+	return 1;
+}
+
+#if (TAG_CELLS > 1) || TAG_PHY_SCAN
+// Configures the DW1000 for the preamble code and channel of cell, with the receiver off
+static void configureCell(uint8 cell)
+{
+	dwt_config_t config = baseConfig;
+
+	tdoa_cell_radio(cell, baseConfig.chan, baseConfig.prf == DWT_PRF_64M, &config.chan, &config.txCode);
+	config.rxCode = config.txCode;
+
+	dwt_configure(&config);
+#if TAG_FRAME_FILTER
+	dwt_setpanid(TDOA_CELL_PAN(cell));
+#endif
+	rxCell = cell;
+}
+
+// Retunes the receiver to the preamble code and channel of cell
+static void tuneCell(uint8 cell)
+{
+	port_DisableEXT_IRQ();
+	dwt_forcetrxoff();
+	dwt_rxreset();
+	sniffReset();
+	configureCell(cell);
+	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+	port_EnableEXT_IRQ();
+}
+#endif
+
+/*
+ * End of tdoa_init, before the receiver starts. After a watchdog or
+ * software reset with the same switches the tag goes back to the cell and
+ * PHY profile it had found, instead of scanning for them again, and takes
+ * the clock ratios of its anchors: the first packet of an anchor measures
+ * against it while the clock fit fills up again. The output mode the host
+ * set stays, the host does not know the tag was reset.
+ */
+static void restoreState(void)
+{
+	const uint8 cause = port_reset_cause();
+
+	if (((cause != PORT_RESET_WATCHDOG) && (cause != PORT_RESET_SOFTWARE))
+	    || !tdoa_retain_valid(&retained.header, TDOA_RETAIN_TAG_MAGIC, sizeof(retained))
+	    || (retained.s1switch != switches) || (retained.cell >= TAG_CELLS) || (retained.phyProfile >= TDOA_PHY_PROFILES)) {
+		tdoa_retain_clear(&retained.header);
+		return;
+	}
+
+	retained.header.resets++;
+#if TAG_PHY_SCAN
+	if ((retained.phyProfile != phyProfile) || (retained.chan != baseConfig.chan)) {
+		phyProfile = retained.phyProfile;
+		phyScan = (phyProfile + TDOA_PHY_PROFILES - phyFirst) % TDOA_PHY_PROFILES
+		          + ((retained.chan != phyChan) ? TDOA_PHY_PROFILES : 0);
+		tdoa_phy_config(phyProfile, &baseConfig);
+		baseConfig.chan = retained.chan;
+		rxCorrection = tdoa_rx_correction_select(baseConfig.chan, baseConfig.prf == DWT_PRF_64M);
+	}
+#endif
+#if (TAG_CELLS > 1) || TAG_PHY_SCAN
+	tagCell = retained.cell;
+	configureCell(tagCell);
+#endif
+	if ((tagCell == retained.cell) && (phyProfile == retained.phyProfile) && (baseConfig.chan == retained.chan)) {
+		memcpy(clockCorrection_T_To_A, retained.clockCorrection, sizeof(clockCorrection_T_To_A));
+		memcpy(clockSkew, retained.clockSkew, sizeof(clockSkew));
+		memcpy(clockValid, retained.clockValid, sizeof(clockValid));
+	}
+	if (retained.output.mode < TDOA_OUTPUT_MODES) {
+		tag_output_configure(&retained.output);
+	}
+}
+
+/*
+ * Called from the main loop every TAG_RETAIN_MS. The clock ratios, the
+ * cell and the profile only change in the main loop, so the copy is
+ * consistent without masking the receive interrupt.
+ */
+void tdoa_save_state(void)
+{
+	retained.s1switch = switches;
+	retained.cell = tagCell;
+	retained.phyProfile = phyProfile;
+	retained.chan = baseConfig.chan;
+	memcpy(retained.clockCorrection, clockCorrection_T_To_A, sizeof(retained.clockCorrection));
+	memcpy(retained.clockSkew, clockSkew, sizeof(retained.clockSkew));
+	memcpy(retained.clockValid, clockValid, sizeof(retained.clockValid));
+	retained.output = *tag_output_config();
+	tdoa_retain_seal(&retained.header, TDOA_RETAIN_TAG_MAGIC, sizeof(retained));
+}
+
+/*
+ * Called from the main loop once the receive ring is drained. Every
+ * TAG_CELL_SCAN_MS the receiver visits the next other cell for
+ * TAG_CELL_DWELL_MS and the mean power of its packets is compared to the
+ * running mean of the current cell. The tag hands over to a cell stronger by
+ * TAG_CELL_HYSTERESIS, or to any cell heard once the current one is lost,
+ * and starts over with its anchors. Measurements pause during a visit.
+ */
+void tdoa_cell_task(unsigned long now)
+{
+#if TAG_CELLS > 1
+	const uint8 lost = (now - lastCellRx) > TAG_CELL_LOST_MS;
+
+	if (rxCell == tagCell)
+	{
+		if (lost || ((now - lastVisit) > TAG_CELL_SCAN_MS))
+		{
+			visitCell = (visitCell + 1) % TAG_CELLS;
+			if (visitCell == tagCell)
+			{
+				visitCell = (visitCell + 1) % TAG_CELLS;
+			}
+			cellPower[visitCell] = 0;
+			cellPackets[visitCell] = 0;
+			visitStart = now;
+			tuneCell(visitCell);
+		}
+		return;
+	}
+
+	if ((now - visitStart) <= TAG_CELL_DWELL_MS)
+	{
+		return;
 	}
 
-	return estFpPwr;
+	lastVisit = now;
+	if (cellPackets[visitCell] >= TAG_CELL_MIN_PACKETS)
+	{
+		const int32_t power = cellPower[visitCell] / cellPackets[visitCell];
+		if (lost || (power > cellPower[tagCell] + TAG_CELL_HYSTERESIS))
+		{
+			// The ring may still hold packets of the old cell, tdoa_process drops them
+			port_DisableEXT_IRQ();
+			tagCell = visitCell;
+			resetAnchors();
+			port_EnableEXT_IRQ();
+			cellPower[tagCell] = power;
+			lastCellRx = now;
+			statsCellHandovers++;
+		}
+	}
+	tuneCell(tagCell);
+#else
+	(void)now;
+#endif
+}
+
+/*
+ * Called from the main loop next to tdoa_cell_task. Once no cell was heard
+ * for TAG_PHY_LOST_MS the receiver steps through the PHY profiles, first on
+ * the channel it started on and then on the other one, TAG_PHY_DWELL_MS each
+ * until packets arrive again. The power and bias tables follow the PRF and
+ * the anchors start over, their clock ratios were measured on another frame.
+ */
+void tdoa_phy_task(unsigned long now)
+{
+#if TAG_PHY_SCAN
+	if (((now - lastPhyRx) <= TAG_PHY_LOST_MS) || ((now - phyStep) <= TAG_PHY_DWELL_MS))
+	{
+		return;
+	}
+
+	phyStep = now;
+	phyScan = (phyScan + 1) % (2 * TDOA_PHY_PROFILES);
+	phyProfile = (phyFirst + phyScan) % TDOA_PHY_PROFILES;
+	tdoa_phy_config(phyProfile, &baseConfig);
+	baseConfig.chan = ((phyScan >= TDOA_PHY_PROFILES) && ((phyChan == 2) || (phyChan == 5))) ? 7 - phyChan : phyChan;
+	rxCorrection = tdoa_rx_correction_select(baseConfig.chan, baseConfig.prf == DWT_PRF_64M);
+
+	port_DisableEXT_IRQ();
+	resetAnchors();
+	port_EnableEXT_IRQ();
+	tuneCell(rxCell);
+#else
+	(void)now;
+#endif
+}
+
+// Received frames tdoa_process has not consumed yet
+uint8 tdoa_rx_pending(void)
+{
+	return rxRingHead != rxRingTail;
+}
+
+void rx_to_cb(const dwt_cb_data_t *cb_data)
+{
+	sniffRearm(DWT_START_RX_IMMEDIATE, 1);
+}
+
+void rx_err_cb(const dwt_cb_data_t *cb_data)
+{
+	sniffRearm(DWT_START_RX_IMMEDIATE, 1);
+}
+
+
+#pragma GCC optimize ("O3")
+void dwCorrectTimestamp(dwTime_t* timestamp, int16 rxPower)
+{
+	TDOA_TRACE_ENTER(TDOA_TRACE_CORRECT_TIMESTAMP);
+	timestamp->full += tdoa_rx_bias(rxCorrection, rxPower);
+	TDOA_TRACE_EXIT(TDOA_TRACE_CORRECT_TIMESTAMP);
+}
+
+#pragma GCC optimize ("O3")
+int16 dwGetReceivePower(uint16 cirPower, const uint8 *rxFrameInfo)
+{
+	return tdoa_rx_power(rxCorrection, cirPower, rxFrameInfo);
+}
+
+int16 dwGetFirstPathPower(const uint16 *fpAmpl, const uint8 *rxFrameInfo)
+{
+	return tdoa_fp_power(rxCorrection, fpAmpl, rxFrameInfo);
 }
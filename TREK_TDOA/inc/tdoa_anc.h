@@ -11,37 +11,99 @@ extern "C" {
 #include "deca_types.h"
 #include "deca_device_api.h"
 #include "deca_regs.h"
+#include "deca_access.h"
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "port_deca.h"
+#include "tdoa_phy.h"
+#include "tdoa_retain.h"
+#include "tdoa_rxpower.h"
+#include "tdoa_tdma.h"
+#include "tdoa_time.h"
+#include "tdoa_trace.h"
+
+// Schedule announced by the master, the other anchors take theirs from its packets
+#define TDMA_DEFAULT_SLOTS		8		// Anchor addresses, the frame only has slots for those present
+#define TDMA_DEFAULT_SLOT_UNITS	0		// 0 derives the slot length from the airtime of the channel configuration
+
+// Start the TDMA right after the radio is up, without the splash delay and LED blinks. After a brown-out or
+// watchdog reset the anchor is back within TDMA_ABSENT_FRAMES, still has its slot and joins on the first packet
+#define FAST_BOOT				1
+
+// Independent watchdog, see main. A stuck interrupt or SPI transfer starves the main loop, which kicks it, and a
+// DW1000 still silent ANCHOR_IWDG_SILENCE_MS after the receiver restarts of tdoa_watchdog stops the kicks. The
+// anchor then resets, keeps the state of tdoa_save_state and is back within TDMA_ABSENT_FRAMES. 0 disables it
+#define ANCHOR_IWDG_MS			50
+#define ANCHOR_IWDG_SILENCE_MS	1000
+#define ANCHOR_RETAIN_MS		100		// Period of tdoa_save_state
+
+// Period of the anchor telemetry frame on USART2 (common/tdoa_protocol.h), 0 disables it
+#define ANCHOR_TELEMETRY_MS		1000
+
+// Cell of the anchor, selects its PAN ID, preamble code and channel (common/tdoa_tdma.h)
+#ifndef ANCHOR_CELL
+#define ANCHOR_CELL				0
+#endif
+#if ANCHOR_CELL >= TDOA_MAX_CELLS
+#error "ANCHOR_CELL must be below TDOA_MAX_CELLS"
+#endif
 
-#define NSLOTS			8
-#define TDMA_SLOT_BITS	26
-#define TDMA_NSLOT_BITS 3
+// Frames of a master that starts a schedule begin on the slot unit grid
+#define TDMA_ALIGN(NOW) ((NOW) & ~(TDOA_SLOT_UNIT-1))
 
-#define TDMA_FRAME_BITS (TDMA_SLOT_BITS + TDMA_NSLOT_BITS)
-#define TDMA_SLOT_LEN	(1ull<<(TDMA_SLOT_BITS+1))
-#define TDMA_FRAME_LEN	(1ull<<(TDMA_FRAME_BITS+1))
+#define TDMA_GUARD_LENGTH_NS	1000
+#define TDMA_GUARD_LENGTH		(uint64_t)(TDMA_GUARD_LENGTH_NS * 499.2e-3 * 128)
 
-#define TDMA_LAST_FRAME(NOW) (NOW & ~(TDMA_FRAME_LEN-1))
+// Slot time after the end of a frame: RX done interrupt to the next delayed RX or TX programmed, plus margin for its jitter.
+// slotStep programs the next slot from the fixed fields of the packet, its entries are read afterwards
+#define TDMA_TURNAROUND_NS		80000
+#define TDMA_MARGIN_NS			30000
 
-#define PREAMBLE_LENGTH_S (128 * 1017.63e-9)
-#define PREAMBLE_LENGTH	  (uint64_t)(PREAMBLE_LENGTH_S * 499.2e6 * 128)
+// Preamble detect timeout of a slot receive window: an empty slot ends once no preamble started within the guard, the
+// phase error the sync filter tolerates (TDMA_SYNC_GATE) and the PACs the receiver needs to detect one
+#define TDMA_PREAMBLE_MARGIN_NS	10000
+#define TDMA_PREAMBLE_DETECT_PACS	4
 
-#define TDMA_GUARD_LENGTH_S (1e-6)
-#define TDMA_GUARD_LENGTH	(uint64_t)(TDMA_GUARD_LENGTH_S * 499.2e6 * 128)
+// Transmit time after the start of a slot on the 512 tick TX grid, as computed by transmitTimeForSlot
+#define TDMA_TX_OFFSET(LEAD)	(((LEAD) & ~0x1FFull) + 0x200)
 
-#define RECEIVE_TIMEOUT		250
+#define TICKS_PER_US			(499.2 * 128)
 
 #define MASK_TXDTS			(0x00FFFFFFFE00)  //The TX timestamp will snap to 8 ns resolution - mask lower 9 bits.
 #define MASK_40BIT			(0x00FFFFFFFFFF)  // DW1000 counter is 40 bits
 
-#define KF_SYNC             10
+// Phase filter on the master packets, see setTdmaSlots
+#define TDMA_SYNC_MEAS_NOISE	10.0f		// Ticks (~0.16 ns), arrival time noise of a master packet
+#define TDMA_SYNC_DRIFT_NOISE	6.4e3f		// Ticks/s^2 (0.1 ppm/s), clock frequency wander between anchors
+#define TDMA_SYNC_GATE			640000		// Ticks (~10 us), a larger innovation restarts the filter
+#define TDMA_SYNC_HOLD_FRAMES	8			// Missed master packets the anchor keeps its slots for (holdover)
+
+// The master is the anchor of slot 0, the lowest address with a slot, see masterMissed and listenOrStart
+#define TDMA_MASTER_FRAMES		2			// Frames nobody heard the master before the next lowest address takes slot 0
+#define TDMA_MASTER_LISTEN		32			// Receive windows per address an unsynchronized anchor listens before it starts a schedule
+
+// Slots of the present anchors only, the master decides in updateMembership
+#define TDMA_ABSENT_FRAMES		16			// Frames nobody in the cell heard an anchor before its slot is dropped
+#define TDMA_JOIN_EVERY			4			// Frames between join slots for the anchors without a slot
+
+// Silence of the DW1000 after which tdoa_watchdog restarts the receiver
+#define TDMA_WATCHDOG_FRAMES	4
+#define TDMA_WATCHDOG_MIN_MS	20
+
+// Inter-anchor time of flight filter, see calculateDistance
+#define TOF_FRAC_BITS			4			// Filtered ToF in 1/16 ticks
+#define TOF_FILTER_WEIGHT		64			// Exchanges averaged once settled, the first ones are averaged equally
+#define TOF_MAX					0xFFFF		// Ticks (~300 m), distance field of the range packet
+#define TOF_GATE				64			// Ticks (~30 cm) from the filtered value, larger exchanges are outliers
+#define TOF_MAX_OUTLIERS		8			// Outliers in a row after which the filter restarts
+#define TOF_HOLD_EXCHANGES		2			// Lost exchanges the filtered value is still sent for
 #define TS_TX_SIZE          4
 
 #define MAC802154_HEADER_LENGTH 21
+#define RANGE_HEADER_LENGTH		(MAC802154_HEADER_LENGTH + TDOA_RANGE_BITMAP_OFFSET)	// MAC header and the fixed fields of a range packet
 #define FRAME_CRC               2
 
 typedef union dwTime_u {
@@ -57,11 +119,11 @@ typedef union dwTime_u {
 	}__attribute__((packed));
 } dwTime_t;
 
-//FSM states
+//FSM states, sent as TDOA_ANCHOR_STATE_* of the telemetry
 enum state_e {
-	syncTdmaState = 0, //Anchor 1 to 5 starts here and rise up to synchronizedState
+	syncTdmaState = 0, //Every anchor starts here and joins a schedule it hears, or starts one as its master
 	syncTimeState,
-	synchronizedState, //Anchor 0 is always here
+	synchronizedState,
 };
 
 enum slotState_e {
@@ -76,9 +138,60 @@ typedef enum {
 	TX_OK,
 } eventState_e;
 
+// Counters since power-up for the LCD and the telemetry, wrap around
+typedef struct tdmaStats_s {
+	uint32 rxGood;				// Receptions with a good CRC
+	uint32 rxTimeouts;			// Receive timeouts, empty slots
+	uint32 rxErrors;
+	uint32 txGood;				// Range packets sent
+	uint32 lateTx;				// Delayed transmits programmed too late, the slot is lost
+	uint32 lateRx;				// Delayed receives programmed too late, opened immediately
+	uint32 syncMissed;			// Master packets missed while synchronized
+	uint32 syncLost;			// Holdovers that ran out, back to syncTdmaState
+	uint32 resyncs;				// Schedule joins, from any anchor's packet
+	uint32 watchdogResets;		// Receiver restarts of tdoa_watchdog
+	uint32 failovers;			// Masters dropped from slot 0
+	uint32 stateChanges;		// Changes of ctx.state
+} tdmaStats_t;
+
+// Time of flight to one neighbour anchor
+typedef struct tofFilter_s {
+	int32_t tof;				// 1/16 ticks, 0 until the first exchange
+	uint8 count;				// Exchanges averaged, up to TOF_FILTER_WEIGHT
+	uint8 outliers;
+	uint8 misses;
+} tofFilter_t;
+
+// Previous exchange with one neighbour anchor, kept for calculateDistance while the next slot is set up
+typedef struct tofExchange_s {
+	uint8_t id;					// Index of its previous packet
+	uint32_t remoteTx;			// Transmit time of that packet, low 32 bits of its clock
+	tdoa_time_t rxTime;			// Arrival of that packet, local 40 bits
+	tdoa_time_t txTime;			// Own transmit that followed it
+} tofExchange_t;
+
+// State kept across a watchdog or software reset (common/tdoa_retain.h), taken back by tdoa_init of the same
+// anchor and cell. The frame start is on the clock of the DW1000, which tdoa_init resets, so the anchor
+// still joins on the first packet it hears; it then goes on with the drift and distances it had
+typedef struct anchorRetain_s {
+	tdoa_retain_header_t header;
+	uint8 anchorId;
+	uint8 cell;
+	uint8 anchors;				// Schedule of the master
+	uint8 join;
+	uint16 active;
+	uint16 slotUnits;
+	uint64_t frameLen;			// Frame syncRate is per, 0 without a drift estimate
+	int32_t syncRate;
+	uint16_t distances[TDOA_MAX_ANCHORS];
+	tofFilter_t tofFilters[TDOA_MAX_ANCHORS];
+	tdmaStats_t stats;
+} anchorRetain_t;
+
 //This context struct contains all the required global values of the algorithm
 struct ctx_s {
 	uint8 anchorId;
+	uint8 cell;
 	enum state_e state;
 	enum slotState_e slotState;
 	
@@ -91,26 +204,67 @@ struct ctx_s {
 	// TDMA start of frame in local clock
 	dwTime_t tdmaFrameStart;
 
+	// TDMA schedule: anchor addresses, slots of the current frame, slot and frame length in device ticks
+	uint8 anchors;
+	uint16 active;				// Anchors with a slot, in address order
+	uint8 join;					// Anchor of the join slot after them, TDOA_NO_JOIN without
+	uint8 nslots;
+	uint8 ownSlot;				// nslots while this anchor has none
+	uint16 slotUnits;
+	uint64_t slotLen;
+	uint64_t frameLen;
+
+	// Anchors heard in the cell since slot 0, master: frames each was not, join rotation
+	uint16 heard;
+	uint8 absent[TDOA_MAX_ANCHORS];
+	uint8 frames;
+	uint8 lastJoin;
+
+	// Frames nobody heard the master, receive events while unsynchronized
+	uint8 masterMisses;
+	uint16 listenCount;
+
+	// Airtime of the channel configuration: slot start to RMARKER in device ticks, RX window in 512/499.2 us units
+	uint64_t txLead;
+	uint16 rxTimeout;
+	uint16 preambleTimeout;		// PACs, preamble detect timeout of the slot windows
 	
-	uint8_t packetIds[NSLOTS];
-	uint32_t rxTimestamps[NSLOTS];
-	uint32_t txTimestamps[NSLOTS];
-	uint16_t distances[NSLOTS];
-
-	//Kalman Filter vars
-	double xhat[2];
-	uint8_t A0_sync;
+	// Per anchor address
+	uint8_t packetIds[TDOA_MAX_ANCHORS];
+	tdoa_time_t rxTimestamps[TDOA_MAX_ANCHORS];	// Arrival of the last packet of each anchor, local 40 bits
+	uint32_t txTimestamps[TDOA_MAX_ANCHORS];	// Its transmit time, low 32 bits of the anchor clock
+	tdoa_time_t txTime;							// Own last transmit, local 40 bits
+	uint16_t distances[TDOA_MAX_ANCHORS];
+	tofFilter_t tofFilters[TDOA_MAX_ANCHORS];
+
+	// Master phase filter, frame start drift per frame in 1/256 ticks and Q16 gains
+	int32_t syncRate;
+	int32_t syncAlpha;
+	int32_t syncBeta;
+	uint8_t syncCount;
+	uint8_t syncMisses;
+
+	uint32 watchdogMs;
+	tdmaStats_t stats;
 } ctx;
 
-#define PACKET_TYPE_RANGE 0x21
+#define PACKET_TYPE_RANGE TDOA_RANGE_PACKET_TYPE
 
+// Fixed part of the range packet, followed by the entry bitmap and the entries of tdoa_tdma.h
 typedef struct rangePacket_s {
 	uint8_t type;
 	uint8_t idx;				//index at master
-	uint8_t timestamps[NSLOTS][TS_TX_SIZE];	//Relevant time for anchors
-	uint16_t distances[NSLOTS];
+	uint8_t anchors;			//TDMA schedule of the master
+	uint16_t slotUnits;
+	uint32_t txTime;			//TX time of the sender
+	uint16_t active;			//Slots of the frame, from the master
+	uint8_t join;
 }__attribute__((packed)) rangePacket_t;
 
+#define RANGE_BITMAP(PKT)			(&((uint8_t *)(PKT))[TDOA_RANGE_BITMAP_OFFSET])
+#define RANGE_ENTRY(PKT, N, I)		(&((uint8_t *)(PKT))[TDOA_RANGE_ENTRY_OFFSET(N, I)])
+#define RANGE_FRAME_LENGTH(N, E)	(MAC802154_HEADER_LENGTH + TDOA_RANGE_PAYLOAD_SIZE(N, E) + FRAME_CRC)
+
 typedef struct packet_s {
 	union {
 		uint16_t fcf;
@@ -132,25 +286,36 @@ typedef struct packet_s {
 	uint8_t destAddress[8];
 	uint8_t sourceAddress[8];
 
-	uint8_t payload[64];
+	uint8_t payload[TDOA_RANGE_PAYLOAD_MAX_SIZE];
 } __attribute__((packed)) packet_t;
 
-uint8 anc_prf, anc_chan;
 uint32 tx_failed_count;
 
 void tdoa_init(uint8 s1switch, dwt_config_t *config);
+void setTdmaSchedule(uint8 anchors, uint16 slotUnits);
+void setTdmaSlots(uint16 active, uint8 join);
+void tdoa_watchdog(unsigned long now, unsigned long lastEvent);
+void tdoa_save_state(void);
+uint16 tdmaSlotUnits(const dwt_config_t *config, uint8 anchors);
 
 void setupTx(void);
 void setupRx(void);
 void updateSlot(void);
 
-void setTxData(void);
+uint16 setTxData(void);
 
 uint32 adjustRxTime(dwTime_t *time);
 dwTime_t transmitTimeForSlot(int slot);
 
 void handleRxPacket(void);
 
+#if TDOA_TRACE || ANCHOR_TELEMETRY_MS
+void tdoa_isr(void);
+#endif
+#if ANCHOR_TELEMETRY_MS
+void tdoa_get_telemetry(tdoa_anchor_telemetry_t *telemetry);
+#endif
+
 void rx_ok_cb(const dwt_cb_data_t *cb_data);
 void rx_to_cb(const dwt_cb_data_t *cb_data);
 void rx_err_cb(const dwt_cb_data_t *cb_data);
@@ -158,11 +323,8 @@ void tx_conf_cb(const dwt_cb_data_t *cb_data);
 
 
 #define CIR_PWR_OFFSET	0x06
-#define TWOPOWER17		131072.0f // 2^17
-#define DISTANCE_OF_RADIO_INV 213.139451293f
 void dwCorrectTimestamp(dwTime_t* timestamp);
-float dwGetReceivePower(void);
-float calculatePower(float base, float N);
+int16 dwGetReceivePower(void);
 
 #ifdef __cplusplus
 }
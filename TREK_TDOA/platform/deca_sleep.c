@@ -1,30 +0,0 @@
-/*! ----------------------------------------------------------------------------
- * @file    deca_sleep.c
- * @brief   platform dependent sleep implementation
- *
- * @attention
- *
- * Copyright 2015 (c) DecaWave Ltd, Dublin, Ireland.
- *
- * All rights reserved.
- *
- * @author DecaWave
- */
-
-#include "deca_device_api.h"
-#include "sleep.h"
-#include "port_deca.h"
-
-/* Wrapper function to be used by decadriver. Declared in deca_device_api.h */
-void deca_sleep(unsigned int time_ms)
-{
-    sleep_ms(time_ms);
-}
-
-void sleep_ms(unsigned int time_ms)
-{
-    /* This assumes that the tick has a period of exactly one millisecond. See CLOCKS_PER_SEC define. */
-    unsigned long end = portGetTickCount() + time_ms;
-    while ((signed long)(portGetTickCount() - end) <= 0)
-        ;
-}
@@ -1,45 +0,0 @@
-/*! ----------------------------------------------------------------------------
- * @file	deca_spi.h
- * @brief	SPI access functions
- *
- * @attention
- *
- * Copyright 2013 (c) DecaWave Ltd, Dublin, Ireland.
- *
- * All rights reserved.
- *
- * @author DecaWave
- */
-
-#ifndef _DECA_SPI_H_
-#define _DECA_SPI_H_
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#include "deca_types.h"
-
-#define DECA_MAX_SPI_HEADER_LENGTH      (3)                     // max number of bytes in header (for formating & sizing)
-
-/*! ------------------------------------------------------------------------------------------------------------------
- * Function: openspi()
- *
- * Low level abstract function to open and initialise access to the SPI device.
- * returns 0 for success, or -1 for error
- */
-int openspi(void) ;
-
-/*! ------------------------------------------------------------------------------------------------------------------
- * Function: closespi()
- *
- * Low level abstract function to close the the SPI device.
- * returns 0 for success, or -1 for error
- */
-int closespi(void) ;
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif /* _DECA_SPI_H_ */
@@ -27,7 +27,8 @@
 #define lcd_init(x)					LCD_Configuration(x)
 #define touch_screen_init(x)		No_Configuration(x)
 
-//#define USART_SUPPORT
+// Telemetry (ANCHOR_TELEMETRY_MS, on by default) and trace frames go out on USART2
+#define USART_SUPPORT
 
 /* DW1000 IRQ handler definition. */
 port_deca_isr_t port_deca_isr = NULL;
@@ -40,6 +41,12 @@ extern __IO unsigned long last_event;
 /* Internal functions prototypes. */
 static void LCD_Configuration(void);
 static void spi_peripheral_init(void);
+static void SPIx_DMA_Configuration(void);
+
+/* State of the SPIx DMA transfer in progress. */
+static volatile uint8_t spiDmaBusy = 0;
+static port_spi_done_t spiDmaDone = NULL;
+static uint8_t spiDmaDummy = 0;
 
 int No_Configuration(void)
 {
@@ -293,6 +300,9 @@ int RCC_Configuration(void)
 	/* Enable SPI1 clock */
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
 
+	/* Enable DMA1 clock, used for SPI1 */
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
 	/* Enable SPI2 clock */
 	RCC_APB1PeriphClockCmd(RCC_APB1Periph_SPI2, ENABLE);
 
@@ -978,6 +988,7 @@ static void LCD_Configuration(void)
 static void spi_peripheral_init(void)
 {
     spi_init();
+    SPIx_DMA_Configuration();
 
     // Initialise SPI2 peripheral for LCD control
     SPI2_Configuration();
@@ -988,6 +999,97 @@ static void spi_peripheral_init(void)
     sleep_ms(10);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn SPIx_DMA_Configuration()
+ *
+ * @brief Enables the completion interrupt of the SPIx receive DMA channel. The channels themselves are programmed per
+ *        transfer, and the SPI DMA requests are only enabled during one, so SPI_ConfigFastRate() may reset SPIx.
+ *
+ * @param none
+ *
+ * @return none
+ */
+static void SPIx_DMA_Configuration(void)
+{
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	SPIx_DMA_RX_CHANNEL->CCR = 0;
+	SPIx_DMA_TX_CHANNEL->CCR = 0;
+	DMA1->IFCR = SPIx_DMA_FLAGS;
+
+	// Above the DW1000 IRQ (15), so a read started from its handler can complete
+	NVIC_InitStructure.NVIC_IRQChannel = SPIx_DMA_RX_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 10;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+}
+
+#pragma GCC optimize ("O3")
+static PORT_RAMFUNC void SPIx_DMA_stop(void)
+{
+	SPIx->CR2 &= (uint16_t)~(SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx);
+	SPIx_DMA_RX_CHANNEL->CCR = 0;
+	SPIx_DMA_TX_CHANNEL->CCR = 0;
+	DMA1->IFCR = SPIx_DMA_FLAGS;
+	spiDmaBusy = 0;
+}
+
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC void port_SPIx_DMA_start(const uint8_t *tx, uint8_t *rx, uint16_t length, port_spi_done_t done)
+{
+	spiDmaDone = done;
+	spiDmaBusy = 1;
+
+	SPIx_DMA_RX_CHANNEL->CPAR = (uint32_t)&SPIx->DR;
+	SPIx_DMA_RX_CHANNEL->CMAR = (uint32_t)(rx ? rx : &spiDmaDummy);
+	SPIx_DMA_RX_CHANNEL->CNDTR = length;
+	SPIx_DMA_TX_CHANNEL->CPAR = (uint32_t)&SPIx->DR;
+	SPIx_DMA_TX_CHANNEL->CMAR = (uint32_t)(tx ? tx : &spiDmaDummy);
+	SPIx_DMA_TX_CHANNEL->CNDTR = length;
+
+	// Without a buffer the channel stays on the dummy byte. Receive has the higher priority so it never overruns
+	spiDmaDummy = 0;
+	SPIx_DMA_RX_CHANNEL->CCR = DMA_Priority_VeryHigh | (rx ? DMA_MemoryInc_Enable : 0) | (done ? DMA_IT_TC : 0) | DMA_CCR1_EN;
+	SPIx_DMA_TX_CHANNEL->CCR = DMA_Priority_High | DMA_DIR_PeripheralDST | (tx ? DMA_MemoryInc_Enable : 0) | DMA_CCR1_EN;
+
+	SPIx->CR2 |= SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx;
+}
+
+#pragma GCC optimize ("O3")
+PORT_RAMFUNC void port_SPIx_DMA_wait(void)
+{
+	while (spiDmaBusy)
+	{
+		// Transfers without a callback are completed here, the others by the interrupt
+		if ((spiDmaDone == NULL) && (DMA1->ISR & SPIx_DMA_RX_TC_FLAG))
+		{
+			SPIx_DMA_stop();
+		}
+	}
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @fn DMA1_Channel2_IRQHandler()
+ *
+ * @brief Completion of an SPIx DMA transfer started with a done callback.
+ *
+ * @param none
+ *
+ * @return none
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+	port_spi_done_t done = spiDmaDone;
+
+	SPIx_DMA_stop();
+
+	if (done != NULL)
+	{
+		done();
+	}
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @fn peripherals_init()
  *
@@ -1000,6 +1102,7 @@ static void spi_peripheral_init(void)
 
 void peripherals_init (void)
 {
+	port_vector_table_to_ram();
 	rcc_init();
 	gpio_init();
 	interrupt_init();
@@ -42,7 +42,7 @@ void SysTick_Handler(void)
  *
  * @return none
  */
-void EXTI9_5_IRQHandler(void)
+PORT_RAMFUNC PORT_RAMFUNC void EXTI9_5_IRQHandler(void)
 {
 	last_event = time32_incr;
     do
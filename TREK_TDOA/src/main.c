@@ -31,10 +31,11 @@
 
 #define SWS1_SHF_MODE 0x02	//short frame mode (6.81M)
 #define SWS1_CH5_MODE 0x04	//channel 5 mode
-#define SWS1_ANC_MODE 0x08  //anchor mode
+#define SWS1_PHY_MODE 0x08  //850k and 64-symbol 6.81M profiles instead of 110k and 128-symbol 6.81M
 #define SWS1_A1A_MODE 0x10  //anchor/tag address A1
 #define SWS1_A2A_MODE 0x20  //anchor/tag address A2
 #define SWS1_A3A_MODE 0x40  //anchor/tag address A3
+#define SWS1_A4A_MODE 0x80  //anchor address A4, anchors 8 to 15
 
 #define LCD_BUFF_LEN (80)
 uint8 dataseq[LCD_BUFF_LEN];
@@ -45,6 +46,7 @@ int chan, tagaddr, ancaddr;
 
 
 //Configuration for DecaRangeRTLS TREK Modes (4 default use cases selected by the switch S1 [2,3] on EVB1000, indexed 0 to 3 )
+//Only the channel is used, tdoa_phy_config sets rate, PRF, preamble and SFD of the profile
 dwt_config_t chConfig[4] ={
 	//mode 1 - S1: 2 off, 3 off
 	{
@@ -105,7 +107,11 @@ uint32 init_deca(uint8 sw_mode)
     uint32 devID ;
 
     /* Install DW1000 IRQ handler. */
+#if TDOA_TRACE || ANCHOR_TELEMETRY_MS
+    port_set_deca_isr(tdoa_isr);
+#else
     port_set_deca_isr(dwt_isr);
+#endif
 
 	//reset the DW1000 by driving the RSTn line low
     reset_DW1000();
@@ -143,16 +149,91 @@ uint32 init_deca(uint8 sw_mode)
 */
 
 
+#define LCD_STATS_PERIOD_MS 1000
+
+// Writes the last DIGITS decimal digits of value to str
+static void lcd_put_dec(char *str, int digits, unsigned int value)
+{
+	while(digits--)
+	{
+		str[digits] = '0' + (value % 10);
+		value /= 10;
+	}
+}
+
+/*
+ * Shows the sync counters on the second LCD line, as
+ * M<missed> L<lost> R<resyncs> W<watchdog resets> F<failovers>
+ */
+static void lcd_display_stats(void)
+{
+	uint8 command = 0xC0; //DDRAM address of the second line
+	char lcd_str[16] = "M00 L0 R00 W0 F0";
+
+	lcd_put_dec(&lcd_str[1], 2, ctx.stats.syncMissed);
+	lcd_put_dec(&lcd_str[5], 1, ctx.stats.syncLost);
+	lcd_put_dec(&lcd_str[8], 2, ctx.stats.resyncs);
+	lcd_put_dec(&lcd_str[12], 1, ctx.stats.watchdogResets);
+	lcd_put_dec(&lcd_str[15], 1, ctx.stats.failovers);
+
+	writetoLCD(1, 0, &command);
+	writetoLCD(16, 1, (const uint8 *) lcd_str);
+}
+
+#if TDOA_TRACE || ANCHOR_TELEMETRY_MS
+// Sends a frame over USART2, busy-waiting, the DW1000 interrupt keeps running meanwhile
+static void usart_send(const uint8 *frame, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+	{
+		while(port_USARTx_busy_sending());
+		port_USARTx_send_data(frame[i]);
+	}
+}
+#endif
+
+#if TDOA_TRACE
+/*
+ * Sends the buffered trace samples over USART2, one frame at a time.
+ * Samples beyond the buffer are counted as lost.
+ */
+static void trace_send(void)
+{
+	uint8 frame[TDOA_TRACE_FRAME_MAX_SIZE];
+	size_t len;
+
+	while((len = tdoa_trace_frame(frame)) > 0)
+	{
+		usart_send(frame, len);
+	}
+}
+#endif
+
+#if ANCHOR_TELEMETRY_MS
+// Sends the anchor telemetry frame over USART2, about 9 ms at 115200 baud
+static void telemetry_send(unsigned long periodMs)
+{
+	tdoa_anchor_telemetry_t telemetry;
+	uint8 frame[TDOA_ANCHOR_TELEMETRY_FRAME_MAX_SIZE];
+
+	tdoa_get_telemetry(&telemetry);
+	telemetry.periodMs = (periodMs > 0xFFFF) ? 0xFFFF : (uint16_t)periodMs;
+	usart_send(frame, tdoa_anchor_telemetry_frame_encode(frame, &telemetry));
+}
+#endif
+
 /*
  * @fn      main()
  * @brief   main entry point
 **/
-long dt;
+unsigned long lastStats;
+unsigned long lastRetain;
+#if ANCHOR_TELEMETRY_MS
+unsigned long lastTelemetry;
+#endif
 //#pragma GCC optimize ("O3")
 int main()
 {
-    int i;
-
     led_off(LED_ALL); //turn off all the LEDs
 
     peripherals_init();
@@ -169,14 +250,23 @@ int main()
 
     port_DisableEXT_IRQ(); //disable ScenSor IRQ until we configure the device
 
-    int sw_mode = 0;
-	if(s1switch & SWS1_SHF_MODE) sw_mode = 1;
-	if(s1switch & SWS1_CH5_MODE) sw_mode += 2;
+    // PHY profile of the site (tdoa_phy.h), the same on every anchor. S1-4 off keeps the
+    // original modes, 110k or with S1-2 the 128-symbol 6.81M one, S1-3 selects channel 5
+    uint8 profile;
+	if(s1switch & SWS1_PHY_MODE) profile = (s1switch & SWS1_SHF_MODE) ? TDOA_PHY_SHORT : TDOA_PHY_MEDIUM;
+	else profile = (s1switch & SWS1_SHF_MODE) ? TDOA_PHY_STANDARD : TDOA_PHY_LONG;
+    int sw_mode = (s1switch & SWS1_CH5_MODE) ? 2 : 0;
 
     //run TDOA application for TREK
 
 	led_off(LED_ALL);
 
+	// Radio settings of the cell, cell 0 keeps those of the switches
+	dwt_config_t *config = &chConfig[sw_mode];
+	tdoa_phy_config(profile, config);
+	tdoa_cell_radio(ANCHOR_CELL, config->chan, config->prf == DWT_PRF_64M, &config->chan, &config->txCode);
+	config->rxCode = config->txCode;
+
 	if(init_deca(sw_mode) == (uint32)-1)
 	{
 		led_on(LED_ALL); //to display error....
@@ -188,28 +278,17 @@ int main()
 	//char lcd_str[16];
 	//sprintf(lcd_str, "TDOA v0.51 Anc:%d", (((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2)) >> 4);
 	//char lcd_str[16] = {'T','D','O','A',' ','v','0','.','5','2',' ','A','n','c',':','9'};
-	char lcd_str[16] = "TDOA v0.84 Anc:x";
-	lcd_str[15] = ((((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2)) >> 4) + 0x30; //converts to ASCII number
+	char lcd_str[16] = "TDOA 0.85 Cx A:x";
+	int anc_addr = (((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2) + (s1switch & 0x80)) >> 4;
+	lcd_str[11] = '0' + ANCHOR_CELL;
+	lcd_str[15] = "0123456789ABCDEF"[anc_addr]; //converts to ASCII hex digit
 	//lcd_display_str(lcd_str);
 	memset(dataseq, 0, LCD_BUFF_LEN);
 	memcpy(dataseq, (const uint8 *) lcd_str, 16);
 	writetoLCD(40, 1, dataseq);
 	char lcd_str2[16] = "Mode:xxxx Chan:x";
 	lcd_str2[15] = chConfig[sw_mode].chan + 0x30;
-	if(chConfig[sw_mode].dataRate == DWT_BR_6M8)
-	{
-		lcd_str2[5] = '6';
-		lcd_str2[6] = '.';
-		lcd_str2[7] = '8';
-		lcd_str2[8] = 'M';
-	}
-	else
-	{
-		lcd_str2[5] = '1';
-		lcd_str2[6] = '1';
-		lcd_str2[7] = '0';
-		lcd_str2[8] = 'k';
-	}
+	memcpy(&lcd_str2[5], &"6M64" "6.8M" "850k" "110k"[4 * profile], 4);
 	memcpy(dataseq, (const uint8 *) lcd_str2, 16);
 	writetoLCD(16, 1, dataseq);
 
@@ -217,8 +296,9 @@ int main()
 
 	tdoa_init(s1switch, &chConfig[sw_mode]);
 
+#if !FAST_BOOT
 	//sleep for 5 seconds displaying last LCD message and flashing LEDs
-	i=30;
+	int i=30;
 	while(i--)
 	{
 		if (i & 1) led_off(LED_ALL);
@@ -226,23 +306,52 @@ int main()
 
 		sleep_ms(200);
 	}
-	i = 0;
+#endif
 	led_off(LED_ALL);
 
     port_EnableEXT_IRQ(); //enable ScenSor IRQ before starting
 
 
 	dwt_rxenable(DWT_START_RX_IMMEDIATE);
+#if ANCHOR_IWDG_MS
+	port_iwdg_start(ANCHOR_IWDG_MS);
+#endif
 
     // main loop
     while(1)
     {
 		//Do something
-    	dt = (portGetTickCnt() - portGetLastEvent());
-    	if(dt > 10000)
+    	unsigned long now = portGetTickCnt();
+    	tdoa_watchdog(now, portGetLastEvent());
+#if ANCHOR_IWDG_MS
+    	if((now - portGetLastEvent()) < ANCHOR_IWDG_SILENCE_MS)
+    	{
+    		port_iwdg_kick();
+    	}
+#endif
+    	if((now - lastRetain) >= ANCHOR_RETAIN_MS)
     	{
-    		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+    		tdoa_save_state();
+    		lastRetain = now;
     	}
+    	if((now - lastStats) > LCD_STATS_PERIOD_MS)
+    	{
+    		lcd_display_stats();
+    		lastStats = now;
+    	}
+#if TDOA_TRACE
+    	trace_send();
+#endif
+#if ANCHOR_TELEMETRY_MS
+    	if((now - lastTelemetry) >= ANCHOR_TELEMETRY_MS)
+    	{
+    		telemetry_send(now - lastTelemetry);
+    		lastTelemetry = now;
+    	}
+#endif
+
+    	// The TDMA runs in the DW1000 interrupt, the 1 ms SysTick wakes the checks above
+    	__WFI();
     }
 
     return 0;
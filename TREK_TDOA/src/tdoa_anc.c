@@ -5,6 +5,24 @@
 #include "tdoa_anc.h"
 
 const uint8_t base_address[] = {0,0,0,0,0,0,0xcf,0xbc};
+static const uint8_t range_dest_address[] = TDOA_RANGE_DEST_ADDRESS;
+static const tdoa_rx_correction_t *rxCorrection;	// Power and bias tables of the configured channel and PRF
+#if TDOA_TRACE
+tdoa_trace_t tdoaTrace;
+#endif
+static anchorRetain_t retained PORT_NOINIT;
+static int32_t warmSyncRate;				// Drift estimate from before a reset, see syncFilterReset
+static uint64_t warmFrameLen;				// Its frame length, 0 once taken or without one
+#if ANCHOR_TELEMETRY_MS
+static uint32_t isrMinCycles = 0xFFFFFFFF;	// DW1000 interrupt of the telemetry period, see tdoa_get_telemetry
+static uint32_t isrMaxCycles;
+#endif
+
+static uint32 preambleTimeNs(const dwt_config_t *config);
+static uint32 frameTimeNs(const dwt_config_t *config, uint16 length);
+static uint16 preambleDetectPacs(const dwt_config_t *config);
+static void rxImmediate(void);
+static void restoreState(void);
 
 void tdoa_init(uint8 s1switch, dwt_config_t *config)
 {
@@ -17,83 +35,527 @@ void tdoa_init(uint8 s1switch, dwt_config_t *config)
 	dwt_setsmarttxpower(1);
 
 	dwt_setleds(1);
-	dwt_setrxtimeout(RECEIVE_TIMEOUT);
 
-	int anc_addr = (((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2)) >> 4;
+	// The receiver opens at the start of a slot and has to see the whole frame
+	ctx.txLead = TDMA_GUARD_LENGTH + (uint64_t)preambleTimeNs(config) * TICKS_PER_US / 1000;
+	uint32 window = (TDMA_GUARD_LENGTH_NS + frameTimeNs(config, RANGE_FRAME_LENGTH(TDOA_MAX_ANCHORS, TDOA_MAX_ANCHORS-1)) + TDMA_MARGIN_NS) * 39ull / 40000 + 1;
+	ctx.rxTimeout = (window > 0xFFFF) ? 0xFFFF : window;
+	ctx.preambleTimeout = preambleDetectPacs(config);
+	dwt_setrxtimeout(ctx.rxTimeout);
+
+	int anc_addr = (((s1switch & 0x10) << 2) + (s1switch & 0x20) + ((s1switch & 0x40) >> 2) + (s1switch & 0x80)) >> 4;
 	ctx.anchorId = anc_addr;
+	ctx.cell = ANCHOR_CELL;
 	ctx.state = syncTdmaState;
-	ctx.slot = NSLOTS-1;
+	setTdmaSchedule(TDMA_DEFAULT_SLOTS, TDMA_DEFAULT_SLOT_UNITS ? TDMA_DEFAULT_SLOT_UNITS : tdmaSlotUnits(config, TDMA_DEFAULT_SLOTS));
+	ctx.slot = ctx.nslots-1;
 	ctx.nextSlot = 0;
 	ctx.msg_index = 0;
-	ctx.A0_sync = 0;
+	ctx.syncCount = 0;
+	ctx.syncMisses = 0;
+	ctx.syncRate = 0;
 	memset(ctx.rxTimestamps, 0, sizeof(ctx.rxTimestamps));
 	memset(ctx.txTimestamps, 0, sizeof(ctx.txTimestamps));
 	memset(ctx.distances, 0, sizeof(ctx.distances));
 	memset(ctx.packetIds, 0, sizeof(ctx.packetIds));
+	memset(ctx.tofFilters, 0, sizeof(ctx.tofFilters));
+	memset(ctx.absent, 0, sizeof(ctx.absent));
+	ctx.heard = 0;
+	ctx.masterMisses = 0;
+	ctx.listenCount = 0;
+	ctx.frames = 0;
+	ctx.lastJoin = 0;
+	memset(&ctx.stats, 0, sizeof(ctx.stats));
+	warmFrameLen = 0;
+	restoreState();
 
-	anc_prf = config->prf;
-	anc_chan = config->chan;
+	rxCorrection = tdoa_rx_correction_select(config->chan, config->prf == DWT_PRF_64M);
+#if TDOA_TRACE
+	tdoa_trace_init();
+#elif ANCHOR_TELEMETRY_MS
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	TDOA_DWT_CYCCNT = 0;
+	TDOA_DWT_CTRL |= TDOA_DWT_CTRL_CYCCNTENA;
+#endif
 }
 
-void txKalman(dwTime_t *time)
+// Anchor addresses and slot length of the TDMA schedule, the master announces its own in every packet. All of them start with a slot
+void setTdmaSchedule(uint8 anchors, uint16 slotUnits)
 {
-	double xhat_temp[2];
-	dwTime_t xout = { .full = 0 };
+	ctx.anchors = anchors;
+	ctx.slotUnits = slotUnits;
+	ctx.slotLen = (uint64_t)slotUnits << TDOA_SLOT_UNIT_SHIFT;
+	setTdmaSlots((uint16)((1u << anchors) - 1), TDOA_NO_JOIN);
+}
 
-	xout.full = 0.495122939878641*ctx.xhat[0] + 0.504877060121359*(double)time->full;
+/*
+ * Slots of the frame: the active anchors in address order, then the join
+ * slot. Takes effect from the next slot on, the frame start advances by the
+ * new frame length at the end of the frame. The drift estimate is per frame
+ * and is scaled along, the phase filter keeps running.
+ */
+void setTdmaSlots(uint16 active, uint8 join)
+{
+	const uint64_t frameLen = ctx.frameLen;
 
-	xhat_temp[0] = 0.490151653861331*ctx.xhat[0] + 0.002100512820513*ctx.xhat[1] + 0.509848346138669*(double)time->full;
-	xhat_temp[1] = 2.366701106873675*((double)time->full - ctx.xhat[0]) + ctx.xhat[1];
+	ctx.active = active;
+	ctx.join = join;
+	ctx.nslots = tdoa_tdma_slots(active, join);
+	ctx.ownSlot = tdoa_tdma_slot_of(active, join, ctx.anchorId);
+	ctx.frameLen = ctx.nslots * ctx.slotLen;
+	if(frameLen != 0)
+	{
+		ctx.syncRate = (int32_t)((int64_t)ctx.syncRate * (int64_t)ctx.frameLen / (int64_t)frameLen);
+	}
+
+	// Steady state alpha-beta gains of the master phase filter for one update per frame (Kalata)
+	const float T = (float)ctx.frameLen / (TICKS_PER_US * 1e6f);
+	const float lambda = TDMA_SYNC_DRIFT_NOISE * T * T / TDMA_SYNC_MEAS_NOISE;
+	const float r = (4.0f + lambda - sqrtf(8.0f*lambda + lambda*lambda)) / 4.0f;
+	const float alpha = 1.0f - r*r;
+	const float beta = 2.0f*(2.0f - alpha) - 4.0f*sqrtf(1.0f - alpha);
+	ctx.syncAlpha = (int32_t)(alpha * 65536.0f);
+	ctx.syncBeta = (int32_t)(beta * 65536.0f);
 
-	ctx.xhat[0] = (uint64_t)xhat_temp[0] & MASK_40BIT;
-	ctx.xhat[1] = xhat_temp[1];
+	ctx.watchdogMs = TDMA_WATCHDOG_FRAMES * ctx.frameLen / (uint64_t)(TICKS_PER_US * 1000);
+	if(ctx.watchdogMs < TDMA_WATCHDOG_MIN_MS) ctx.watchdogMs = TDMA_WATCHDOG_MIN_MS;
+}
 
-	if ((ctx.A0_sync == 0) && (abs(((int64_t)time->full - (int64_t)xout.full)) < KF_SYNC))
+// Anchor of a slot of the current frame
+static inline uint8 slotAnchor(uint8 slot)
+{
+	return tdoa_tdma_anchor_of(ctx.active, ctx.join, slot);
+}
+
+// Moves the TDMA state machine, counting the changes for the telemetry
+static inline void enterState(enum state_e state)
+{
+	if(ctx.state != state)
 	{
-		ctx.A0_sync = 1;
+		ctx.state = state;
+		ctx.stats.stateChanges++;
 	}
-	else if (ctx.A0_sync)
+}
+
+/*
+ * Restarts the phase filter, the frame start is taken as is. A frame start
+ * from another anchor's packet is off by that anchor's offset to the
+ * master, so the next master packet only corrects the phase.
+ */
+static void syncFilterReset(uint8 fromMaster)
+{
+	ctx.syncRate = 0;
+	ctx.syncCount = fromMaster ? 1 : 0;
+	ctx.syncMisses = 0;
+
+	// The first master packet after a watchdog reset goes on with the drift from before it, the crystals did not change
+	if(fromMaster && (warmFrameLen != 0))
 	{
-		time->full = xout.full;
+		ctx.syncRate = (int32_t)((int64_t)warmSyncRate * (int64_t)ctx.frameLen / (int64_t)warmFrameLen);
+		ctx.syncCount = 2;
 	}
+	warmFrameLen = 0;
+}
 
+/*
+ * Holdover: after a missed master packet the anchor keeps transmitting on
+ * the schedule predicted by the phase filter, for TDMA_SYNC_HOLD_FRAMES
+ * frames.
+ */
+static void syncMissed(void)
+{
+	ctx.stats.syncMissed++;
+	if(++ctx.syncMisses > TDMA_SYNC_HOLD_FRAMES)
+	{
+		ctx.stats.syncLost++;
+		enterState(syncTdmaState);
+		ctx.listenCount = 0;
+	}
 }
 
-void calculateDistance(uint8_t slot, uint8_t newId, uint32_t remoteTx, uint32_t remoteRx, uint32_t ts)
+/*
+ * Failover. The master is the anchor of slot 0, the lowest address with a
+ * slot. Once neither this anchor nor any anchor whose packets it received
+ * heard the master for TDMA_MASTER_FRAMES frames, it is dropped from the
+ * slots, as on every other anchor that lost it in the same frame, and the
+ * next lowest address holds slot 0. That slot follows right away: the frame
+ * start moves up by one slot, so the frames go on on the timeline of the old
+ * master that the phase filters tracked, and the new master holds it with
+ * its drift estimate. Called on a missed master packet, before the next slot
+ * is set up.
+ */
+static void masterMissed(void)
 {
-	// Check that the 2 last packets are consecutive packets
-	if (ctx.packetIds[slot] == (newId-1))
+	const uint8 master = slotAnchor(0);
+
+	if((ctx.heard >> master) & 1)
 	{
-		int64_t tround1 = remoteRx - ctx.txTimestamps[ctx.slot];
-		int64_t treply1 = ctx.txTimestamps[ctx.anchorId] - ctx.rxTimestamps[ctx.slot];
-		int64_t tround2 = ts - ctx.txTimestamps[ctx.anchorId];
-		int64_t treply2 = remoteTx - remoteRx;
+		ctx.masterMisses = 0;
+		return;
+	}
+	if(++ctx.masterMisses < TDMA_MASTER_FRAMES)
+	{
+		return;
+	}
 
-		uint32_t distance = ((tround2 * tround1)-(treply1 * treply2)) / (2*(treply1 + tround2));
-		ctx.distances[slot] = distance & 0xFFFFUL;
+	ctx.masterMisses = 0;
+	ctx.syncMisses = 0;
+	ctx.stats.failovers++;
+	ctx.tdmaFrameStart.full += ctx.slotLen;
+	setTdmaSlots(ctx.active & ~(1 << master), ctx.join);
+	ctx.nextSlot = 0;
+}
+
+/*
+ * Unsynchronized, after a receive event without a schedule to join. Anchor k
+ * starts a schedule of its own as its master after (k+1)*TDMA_MASTER_LISTEN
+ * receive windows, with slots for itself and the addresses above it, so the
+ * lowest address that is up starts first and the others join it. Lower
+ * addresses that come up later get their slots through the join slot and
+ * take slot 0 over from it.
+ */
+static void listenOrStart(void)
+{
+	if((ctx.anchorId >= ctx.anchors) || (++ctx.listenCount < (ctx.anchorId + 1) * TDMA_MASTER_LISTEN))
+	{
+		// Start the receiver waiting for a packet of the schedule
+		rxImmediate();
+		return;
+	}
+
+	ctx.listenCount = 0;
+	setTdmaSlots(((1u << ctx.anchors) - 1) & ~((1u << ctx.anchorId) - 1), TDOA_NO_JOIN);
+	syncFilterReset(0);
+	ctx.nextSlot = 0;
+
+	dwt_readsystime(ctx.tdmaFrameStart.raw);
+	ctx.tdmaFrameStart.full = TDMA_ALIGN(ctx.tdmaFrameStart.full) + 2*ctx.frameLen;
+	enterState(synchronizedState);
+	setupTx();
+
+	ctx.slotState = slotTxDone;
+	updateSlot();
+}
+
+/*
+ * Corrects the frame start with the arrival time of the master packet of
+ * this frame. The second packet after a reset takes the whole innovation
+ * as drift, later ones the steady state gains.
+ */
+static void syncFilterUpdate(const dwTime_t *rxTime)
+{
+	int64_t e = (rxTime->full - TDMA_TX_OFFSET(ctx.txLead) - ctx.tdmaFrameStart.full) & MASK_40BIT;
+	if(e & (1ull << 39)) e -= 1ll << 40;
+
+	ctx.syncMisses = 0;
+	if((ctx.syncCount == 0) || (e > TDMA_SYNC_GATE) || (e < -TDMA_SYNC_GATE))
+	{
+		ctx.tdmaFrameStart.full += e;
+		syncFilterReset(1);
+	}
+	else if(ctx.syncCount == 1)
+	{
+		ctx.tdmaFrameStart.full += e;
+		ctx.syncRate = (int32_t)e << 8;
+		ctx.syncCount = 2;
+	}
+	else
+	{
+		ctx.tdmaFrameStart.full += (ctx.syncAlpha * e) >> 16;
+		ctx.syncRate += (int32_t)((ctx.syncBeta * e) >> 8);
+	}
+}
+
+/*
+ * Preamble and SFD of the configuration in ns, the time from the start of
+ * the transmission to the RMARKER (IEEE 802.15.4a symbol times).
+ */
+static uint32 preambleTimeNs(const dwt_config_t *config)
+{
+	uint32 symbols;
+	switch(config->txPreambLength)
+	{
+		case DWT_PLEN_64:   symbols = 64;   break;
+		case DWT_PLEN_128:  symbols = 128;  break;
+		case DWT_PLEN_256:  symbols = 256;  break;
+		case DWT_PLEN_512:  symbols = 512;  break;
+		case DWT_PLEN_1024: symbols = 1024; break;
+		case DWT_PLEN_1536: symbols = 1536; break;
+		case DWT_PLEN_2048: symbols = 2048; break;
+		default:            symbols = 4096; break;
+	}
+
+	// The Decawave SFD is 16 symbols at 850 kbps and the standard one 8, both are 64 at 110 kbps
+	if(config->dataRate == DWT_BR_110K) symbols += 64;
+	else if(config->nsSFD && (config->dataRate == DWT_BR_850K)) symbols += 16;
+	else symbols += 8;
+
+	// Preamble symbol of 993.59 ns at 16 MHz PRF, 1017.63 ns at 64 MHz
+	return (symbols * ((config->prf == DWT_PRF_64M) ? 101763ull : 99359ull) + 99) / 100;
+}
+
+/*
+ * Airtime in ns of a frame of length bytes including the CRC. The PHR is
+ * sent at 850 kbps except in 110 kbps mode, the data carries 48 Reed-Solomon
+ * parity bits per 330 bit block.
+ */
+static uint32 frameTimeNs(const dwt_config_t *config, uint16 length)
+{
+	const uint32 bits = 8*length + 48*((8*length + 329) / 330);
+	uint64_t bitPs;		// One data bit
+	uint32 phrNs;
+
+	if(config->dataRate == DWT_BR_110K)
+	{
+		bitPs = 8205128;
+		phrNs = 172308;
 	}
 	else
 	{
-		ctx.distances[slot] = 0;
+		bitPs = (config->dataRate == DWT_BR_850K) ? 1025641 : 128205;
+		phrNs = 21538;
+	}
+	return preambleTimeNs(config) + phrNs + (uint32)((bits * bitPs + 999) / 1000);
+}
+
+/*
+ * Preamble detect timeout of a slot window in PACs, as dwt_setpreambledetecttimeout
+ * takes it (the DW1000 adds one). The preamble starts TDMA_GUARD_LENGTH_NS after
+ * the window opens, give or take the propagation and the phase error.
+ */
+static uint16 preambleDetectPacs(const dwt_config_t *config)
+{
+	uint32 pac;
+	switch(config->rxPAC)
+	{
+		case DWT_PAC8:  pac = 8;  break;
+		case DWT_PAC16: pac = 16; break;
+		case DWT_PAC32: pac = 32; break;
+		default:        pac = 64; break;
 	}
+
+	const uint32 pacNs = pac * ((config->prf == DWT_PRF_64M) ? 101763ul : 99359ul) / 100;
+	const uint32 pacs = (TDMA_GUARD_LENGTH_NS + TDMA_PREAMBLE_MARGIN_NS + pacNs - 1) / pacNs + TDMA_PREAMBLE_DETECT_PACS;
+	return (pacs > 0xFFFF) ? 0xFFFF : (uint16)(pacs - 1);
+}
+
+// Slot length in TDOA_SLOT_UNIT ticks (1/7.8 us) for the packet of a schedule of anchors addresses, the guard and the turnaround
+uint16 tdmaSlotUnits(const dwt_config_t *config, uint8 anchors)
+{
+	const uint32 slotNs = TDMA_GUARD_LENGTH_NS + frameTimeNs(config, RANGE_FRAME_LENGTH(anchors, anchors-1)) + TDMA_TURNAROUND_NS + TDMA_MARGIN_NS;
+	const uint32 units = (slotNs * 78ull + 9999) / 10000;
+
+	if(units < TDOA_MIN_SLOT_UNITS) return TDOA_MIN_SLOT_UNITS;
+	if(units > TDOA_MAX_SLOT_UNITS) return TDOA_MAX_SLOT_UNITS;
+	return units;
+}
+
+/*
+ * Reads the MAC header and the fixed fields of a received frame, all the
+ * slot handling needs before the next slot is set up. Returns its range
+ * packet or NULL if it is not one of this cell.
+ */
+static rangePacket_t *readRangeHeader(packet_t *rxPacket, uint16 length)
+{
+	if (length < RANGE_FRAME_LENGTH(TDOA_MIN_ANCHORS, 0))
+	{
+		return NULL;
+	}
+	dwt_readrxdata((uint8*)rxPacket, RANGE_HEADER_LENGTH, 0);
+
+	// Anchors of other cells may share the preamble code and channel
+	rangePacket_t *rangePacket = (rangePacket_t *)rxPacket->payload;
+	if ((rxPacket->pan != TDOA_CELL_PAN(ctx.cell)) || (rangePacket->type != PACKET_TYPE_RANGE) || !tdoa_tdma_valid(rangePacket->anchors, rangePacket->slotUnits)
+	    || (length < RANGE_FRAME_LENGTH(rangePacket->anchors, 0)))
+	{
+		return NULL;
+	}
+	return rangePacket;
+}
+
+// Reads the bitmap and the entries after readRangeHeader, nonzero if the frame holds all of them
+static int readRangeEntries(packet_t *rxPacket, uint16 length)
+{
+	const uint16 size = (length < sizeof(packet_t)) ? length : sizeof(packet_t);
+	rangePacket_t *rangePacket = (rangePacket_t *)rxPacket->payload;
+
+	dwt_readrxdata((uint8*)rxPacket + RANGE_HEADER_LENGTH, size - RANGE_HEADER_LENGTH, RANGE_HEADER_LENGTH);
+	return length >= RANGE_FRAME_LENGTH(rangePacket->anchors, tdoa_range_entry_index(RANGE_BITMAP(rangePacket), rangePacket->anchors));
+}
+
+// Reads a received frame, returns its range packet or NULL if it is not a complete one
+static rangePacket_t *readRangePacket(packet_t *rxPacket, uint16 length)
+{
+	rangePacket_t *rangePacket = readRangeHeader(rxPacket, length);
+
+	if ((rangePacket == NULL) || !readRangeEntries(rxPacket, length))
+	{
+		return NULL;
+	}
+	return rangePacket;
+}
+
+/*
+ * Lost exchange with an anchor: the filtered ToF is kept, and still sent,
+ * for TOF_HOLD_EXCHANGES exchanges.
+ */
+static void tofMissed(uint8_t anchor)
+{
+	tofFilter_t *f = &ctx.tofFilters[anchor];
+
+	if(f->misses < TOF_HOLD_EXCHANGES)
+	{
+		f->misses++;
+	}
+	else
+	{
+		ctx.distances[anchor] = 0;
+	}
+}
+
+/*
+ * Master, at the start of each of its frames. Drops the slots of the
+ * anchors nobody in the cell heard for TDMA_ABSENT_FRAMES frames, either
+ * itself or in the entries of the packets it received, and gives the slot
+ * back once an anchor is heard again. That happens in the join slot at the
+ * end of the frame, which every TDMA_JOIN_EVERY frames goes to the next of
+ * the anchors without a slot, and every frame while too few are left to
+ * range. The frame shrinks and grows with the anchors present.
+ */
+static void updateMembership(void)
+{
+	uint16 active = ctx.active;
+	uint8 join = TDOA_NO_JOIN;
+	uint8 k;
+
+	for(k = 0; k < ctx.anchors; k++)
+	{
+		if(k == ctx.anchorId)
+		{
+			continue;
+		}
+		if((ctx.heard >> k) & 1)
+		{
+			ctx.absent[k] = 0;
+			active |= 1 << k;
+		}
+		else if(((active >> k) & 1) && (++ctx.absent[k] >= TDMA_ABSENT_FRAMES))
+		{
+			active &= ~(1 << k);
+		}
+	}
+	ctx.heard = 0;
+
+	if(((++ctx.frames % TDMA_JOIN_EVERY) == 0) || (__builtin_popcount(active) < TDOA_MIN_ANCHORS))
+	{
+		for(k = 1; k <= ctx.anchors; k++)
+		{
+			const uint8 candidate = (ctx.lastJoin + k) % ctx.anchors;
+			if((candidate != ctx.anchorId) && !((active >> candidate) & 1))
+			{
+				join = candidate;
+				ctx.lastJoin = candidate;
+				break;
+			}
+		}
+	}
+
+	if((active != ctx.active) || (join != ctx.join))
+	{
+		setTdmaSlots(active, join);
+	}
+}
+
+/*
+ * Double-sided two-way ranging with an anchor over its previous
+ * packet and our last packet (last), and its current one. The local intervals come from
+ * the 40-bit clock, the remote ones carry only 32 bits and are unwrapped
+ * against the local interval they differ from by twice the ToF, so frames
+ * longer than the ~67 ms 32-bit wrap do not alias (tdoa_time_tof).
+ *
+ * Anchors do not move, so the ToF is averaged: equally over the first
+ * TOF_FILTER_WEIGHT exchanges, then exponentially with that weight.
+ * Exchanges more than TOF_GATE off are outliers until TOF_MAX_OUTLIERS of
+ * them in a row restart the filter.
+ */
+void calculateDistance(uint8_t anchor, const tofExchange_t *last, uint8_t newId, uint32_t remoteTx, uint32_t remoteRx, tdoa_time_t ts)
+{
+	tofFilter_t *f = &ctx.tofFilters[anchor];
+
+	// Check that the 2 last packets are consecutive packets
+	if (last->id != (uint8_t)(newId-1))
+	{
+		tofMissed(anchor);
+		return;
+	}
+
+	const int64_t treply1 = tdoa_time_sub(last->txTime, last->rxTime);
+	const int64_t tround2 = tdoa_time_sub(ts, last->txTime);
+	const int64_t tround1 = tdoa_time_unwrap32(remoteRx, last->remoteTx, treply1);
+	const int64_t treply2 = tdoa_time_unwrap32(remoteTx, remoteRx, tround2);
+
+	int32_t tof;
+
+	if(!tdoa_time_tof(tround1, treply1, tround2, treply2, TOF_FRAC_BITS, TOF_MAX, &tof))
+	{
+		tofMissed(anchor);
+		return;
+	}
+
+	const int32_t error = tof - f->tof;
+	if((f->count > 0) && ((error > (TOF_GATE << TOF_FRAC_BITS)) || (error < -(TOF_GATE << TOF_FRAC_BITS))))
+	{
+		if(++f->outliers < TOF_MAX_OUTLIERS)
+		{
+			tofMissed(anchor);
+			return;
+		}
+		f->count = 0;
+	}
+
+	if(f->count < TOF_FILTER_WEIGHT)
+	{
+		f->count++;
+	}
+	f->tof = (f->count == 1) ? tof : f->tof + error / f->count;
+	f->outliers = 0;
+	f->misses = 0;
+
+	ctx.distances[anchor] = (f->tof + (1 << (TOF_FRAC_BITS - 1))) >> TOF_FRAC_BITS;
+}
+
+/*
+ * Receiver on right away for the whole rxTimeout. The frame may already be
+ * on the air, or come at any time while unsynchronized, so the preamble
+ * detect timeout of the slot windows is off.
+ */
+static void rxImmediate(void)
+{
+	dwt_setpreambledetecttimeout(0);
+	dwt_setrxtimeout(ctx.rxTimeout);
+	dwt_rxenable(DWT_START_RX_IMMEDIATE);
 }
 
 void setupTx()
 {
-	if(ctx.anchorId == 0) ctx.msg_index++;
+	// Slot 0 starts every frame of the master
+	if(ctx.nextSlot == 0)
+	{
+		ctx.msg_index++;
+		updateMembership();
+	}
 
 	dwTime_t txTime = transmitTimeForSlot(ctx.nextSlot);
-	ctx.txTimestamps[ctx.anchorId] = txTime.low32;
+	ctx.txTime = txTime.full & TDOA_TIME_MASK;
 
-	setTxData();
-	dwt_writetxfctrl(MAC802154_HEADER_LENGTH + sizeof(rangePacket_t) + FRAME_CRC, 0, 0);
+	dwt_writetxfctrl(setTxData(), 0, 0);
 
 	dwt_setdelayedtrxtime(txTime.high32);
 	if(dwt_starttx(DWT_START_TX_DELAYED)) //delayed tx
 	{
 		//if the delayed TX failed then go back to listening
-		dwt_setrxtimeout(RECEIVE_TIMEOUT); //reconfigure the timeout before enable
-		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+		ctx.stats.lateTx++;
+		rxImmediate();
 	}
 }
 
@@ -102,17 +564,18 @@ void setupRx()
 	dwTime_t receiveTime = { .full = 0 };
 	
 	// Calculate start of the slot
-	receiveTime.full = ctx.tdmaFrameStart.full + ctx.nextSlot*TDMA_SLOT_LEN;
+	receiveTime.full = ctx.tdmaFrameStart.full + ctx.nextSlot*ctx.slotLen;
 	
-	dwt_setrxtimeout(RECEIVE_TIMEOUT);
+	dwt_setrxtimeout(ctx.rxTimeout);
+	// An empty slot ends once no preamble started in time, a received frame still gets the whole window
+	dwt_setpreambledetecttimeout(ctx.preambleTimeout);
 
 	dwt_setdelayedtrxtime(receiveTime.high32);
 	if(dwt_rxenable(DWT_START_RX_DELAYED)) //delayed rx
 	{
 		//if the delayed RX failed - time has passed - do immediate enable
-		dwt_setrxtimeout(RECEIVE_TIMEOUT); //reconfigure the timeout before enable
-		//longer timeout as we cannot do delayed receive... so receiver needs to stay on for longer
-		dwt_rxenable(DWT_START_RX_IMMEDIATE);
+		ctx.stats.lateRx++;
+		rxImmediate();
 	}
 }
 
@@ -120,23 +583,53 @@ void updateSlot()
 {
 	ctx.slot = ctx.nextSlot;
 	ctx.nextSlot = ctx.nextSlot + 1;
-	if(ctx.nextSlot >= NSLOTS) 
+	if(ctx.nextSlot >= ctx.nslots) 
 	{
 		ctx.nextSlot = 0;
 	}
 	
 	// If the next slot is 0, the next schedule has to be in the same frame!
+	// The drift estimate keeps the frames on the master across missed packets
 	if(ctx.nextSlot == 0)
 	{
-		ctx.tdmaFrameStart.full += TDMA_FRAME_LEN;
+		ctx.tdmaFrameStart.full += ctx.frameLen + (ctx.syncRate >> 8);
 	}
 }
 
+// Copies a field into the TX buffer image and widens the span [*lo, *hi) to upload by its changed bytes
+static void updateTxField(uint8 *image, uint16 offset, const uint8 *data, uint16 size, uint16 *lo, uint16 *hi)
+{
+	uint16 first = 0;
+	uint16 last = size;
+
+	while((first < size) && (image[offset + first] == data[first])) first++;
+	if(first == size) return;
+	while(image[offset + last - 1] == data[last - 1]) last--;
+
+	memcpy(&image[offset + first], &data[first], last - first);
+	if(offset + first < *lo) *lo = offset + first;
+	if(offset + last > *hi) *hi = offset + last;
+}
+
+/*
+ * Builds the payload, the receive times of the last frame as entries
+ * relative to the TX time, and returns the frame length. txPacket mirrors
+ * the DW1000 TX buffer: the MAC header and packet type are uploaded with the
+ * first packet, later packets only write the span from the first to the last
+ * changed payload byte.
+ */
 //#pragma GCC optimize ("O1")
-void setTxData()
+uint16 setTxData()
 {
 	static packet_t txPacket;
 	static uint8 firstEntry = 1;
+	uint8 *image = (uint8 *)&txPacket;
+	uint16 lo = sizeof(packet_t);
+	uint16 hi = 0;
+	uint8 payload[TDOA_RANGE_PAYLOAD_MAX_SIZE];
+	rangePacket_t *rangePacket = (rangePacket_t *)payload;
+	uint8 entries = 0;
+	TDOA_TRACE_ENTER(TDOA_TRACE_SET_TX_DATA);
 	
 	if(firstEntry)
 	{
@@ -148,29 +641,53 @@ void setTxData()
 		txPacket.fcf_s.destAddrMode = 3;
 		txPacket.fcf_s.version = 1;
 		txPacket.fcf_s.srcAddrMode = 3;
+		txPacket.pan = TDOA_CELL_PAN(ctx.cell);
 
 		memcpy(txPacket.sourceAddress, base_address, 8);
 		txPacket.sourceAddress[0] = ctx.anchorId;
-		memcpy(txPacket.destAddress, base_address, 8);
-		txPacket.destAddress[0] = 0xFF;
+		memcpy(txPacket.destAddress, range_dest_address, 8);
 		
 		txPacket.payload[0] = PACKET_TYPE_RANGE;
 		
+		// The TX buffer holds no known content yet, upload all of it
+		lo = 0;
+		hi = sizeof(packet_t);
 		firstEntry = 0;
 	}
 	
-	rangePacket_t *rangePacket = (rangePacket_t *)txPacket.payload;
-	
+	const uint32_t txTime = (uint32_t)ctx.txTime;
+	uint8 *bitmap = RANGE_BITMAP(rangePacket);
+
+	rangePacket->type = PACKET_TYPE_RANGE;
 	rangePacket->idx = ctx.msg_index;
-	for(int i=0; i<NSLOTS; i++)
+	rangePacket->anchors = ctx.anchors;
+	rangePacket->slotUnits = ctx.slotUnits;
+	rangePacket->txTime = txTime;
+	rangePacket->active = ctx.active;
+	rangePacket->join = ctx.join;
+	memset(bitmap, 0, TDOA_RANGE_BITMAP_SIZE(ctx.anchors));
+	for(int i=0; i<ctx.anchors; i++)
 	{
-		memcpy(rangePacket->timestamps[i], &ctx.rxTimestamps[i], TS_TX_SIZE);
+		// A slot that failed has no receive time, one off the schedule does not fit a residual.
+		// Anchors without a slot in this frame have none
+		const uint8 slot = tdoa_tdma_slot_of(ctx.active, ctx.join, i);
+		const uint32_t expected = tdoa_range_expected_rx(txTime, ctx.ownSlot, slot, ctx.nslots, ctx.slotUnits);
+		if((i != ctx.anchorId) && (slot < ctx.nslots) && (ctx.rxTimestamps[i] != 0)
+		   && tdoa_range_put_entry(RANGE_ENTRY(rangePacket, ctx.anchors, entries), (uint32_t)ctx.rxTimestamps[i], expected, ctx.distances[i]))
+		{
+			bitmap[i >> 3] |= 1 << (i & 7);
+			entries++;
+		}
 	}
-	memcpy(rangePacket->timestamps[ctx.anchorId], &ctx.txTimestamps[ctx.anchorId], TS_TX_SIZE);
-	memcpy(rangePacket->distances, ctx.distances, sizeof(ctx.distances));
 
-	//dwSetData
-	dwt_writetxdata(MAC802154_HEADER_LENGTH + sizeof(rangePacket_t) + FRAME_CRC, (uint8*)&txPacket, 0);
+	//dwSetData, the length includes the CRC the DW1000 appends
+	updateTxField(image, MAC802154_HEADER_LENGTH, payload, TDOA_RANGE_PAYLOAD_SIZE(ctx.anchors, entries), &lo, &hi);
+	if(hi > lo)
+	{
+		dwt_writetxdata(hi - lo + FRAME_CRC, &image[lo], lo);
+	}
+	TDOA_TRACE_EXIT(TDOA_TRACE_SET_TX_DATA);
+	return RANGE_FRAME_LENGTH(ctx.anchors, entries);
 }
 
 //#pragma GCC optimize ("O1")
@@ -178,94 +695,95 @@ dwTime_t transmitTimeForSlot(int slot)
 {
 	dwTime_t transmitTime = { .full = 0 };
 	
-	//calculate start of the slot
-	transmitTime.full = ctx.tdmaFrameStart.full + slot*TDMA_SLOT_LEN;
-	// Add guard and preamble time
-	transmitTime.full += TDMA_GUARD_LENGTH;
-	transmitTime.full += PREAMBLE_LENGTH;
-	
-	// DW1000 can only schedule time with 9 LSB at 0, adjust for it
-	transmitTime.low32 = (transmitTime.low32 & ~((1<<9)-1)) + (1<<9);
+	// Start of the slot plus guard, preamble and SFD time, on the 9 LSB the DW1000 can schedule
+	transmitTime.full = tdoa_time_delayed_tx(ctx.tdmaFrameStart.full + (uint64_t)slot*ctx.slotLen + ctx.txLead);
 	
 	return transmitTime;
 }
 
 //#pragma GCC optimize ("O1")
-void slotStep(const dwt_cb_data_t *cb_data, eventState_e event)
+PORT_RAMFUNC void slotStep(const dwt_cb_data_t *cb_data, eventState_e event)
 {
+	TDOA_TRACE_ENTER(TDOA_TRACE_SLOT_STEP);
+
 	switch (ctx.slotState) {
 		case slotRxDone:
+		{
+			static packet_t rxPacket;
+			dwTime_t rxTime = { .full = 0 };
+			rangePacket_t *rangePacket = NULL;
+			const uint8 sender = slotAnchor(ctx.slot);
+
 			if (event == RX_OK)
 			{
 				// start of handleRxPacket(dev)
-				static packet_t rxPacket;
-				dwTime_t rxTime = { .full = 0 };
-
-				dwt_readrxtimestamp(rxTime.raw);
+				dwt_readfast(RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, RX_TIME_RX_STAMP_LEN, rxTime.raw);
 				dwCorrectTimestamp(&rxTime);
 
-				dwt_readrxdata((uint8*)&rxPacket, cb_data->datalength, 0);
+				rangePacket = readRangeHeader(&rxPacket, cb_data->datalength);
 
-				if(cb_data->datalength == 0 || rxPacket.payload[0] != PACKET_TYPE_RANGE || rxPacket.sourceAddress[0] != ctx.slot)
+				// A packet from another anchor than that of the slot, or without this anchor, belongs to another schedule
+				if(rangePacket != NULL && (rxPacket.sourceAddress[0] != sender
+				   || sender >= rangePacket->anchors || ctx.anchorId >= rangePacket->anchors))
 				{
-					//start of handleFailedRx
-					ctx.rxTimestamps[ctx.slot] = 0;
-					ctx.distances[ctx.slot] = 0;
-
-					// Failed TDMA sync, keeps track of the number of fail so that the TDMA
-					// watchdog can take decision as of TDMA resynchronisation
-					if (ctx.slot == 0)
-					{
-						ctx.state = syncTdmaState;
-					}
-					//end of handleFailedRx
+					rangePacket = NULL;
 				}
-				else
-				{
-					rangePacket_t * rangePacket = (rangePacket_t *)rxPacket.payload;
-
-					uint32_t remoteTx, remoteRx;
-					memcpy(&remoteTx, rangePacket->timestamps[ctx.slot], TS_TX_SIZE);
-					memcpy(&remoteRx, rangePacket->timestamps[ctx.anchorId], TS_TX_SIZE);
-
-					calculateDistance(ctx.slot, rangePacket->idx, remoteTx, remoteRx, rxTime.low32);
-
-					ctx.packetIds[ctx.slot] = rangePacket->idx;
-					ctx.rxTimestamps[ctx.slot] = rxTime.low32;
-					memcpy(&ctx.txTimestamps[ctx.slot], &rangePacket->timestamps[ctx.slot], TS_TX_SIZE);
-
-					// Resync and save useful anchor 0 information
-					if(ctx.slot == 0)
-					{
-						//txKalman(&rxTime);
+			}
 
-						//Resync local frame start to packet from anchor 0
-						dwTime_t pkTxTime = { .full = 0 };
-						memcpy(&pkTxTime, rangePacket->timestamps[ctx.slot], TS_TX_SIZE); //ctx.slot = 0
-						ctx.tdmaFrameStart.full = rxTime.full - (pkTxTime.full - TDMA_LAST_FRAME(pkTxTime.full));
+			// The exchange the entries of this packet complete, setupTx moves txTime on
+			const tofExchange_t last = { ctx.packetIds[sender], ctx.txTimestamps[sender], ctx.rxTimestamps[sender], ctx.txTime };
 
-						ctx.msg_index = rangePacket->idx;
-					}
-				}
-				// end of handleRxPacket
-			}
-			else
+			if(rangePacket == NULL)
 			{
 				//start of handleFailedRx
-				ctx.rxTimestamps[ctx.slot] = 0;
-				ctx.distances[ctx.slot] = 0;
+				ctx.rxTimestamps[sender] = 0;
+				tofMissed(sender);
 
 				// Failed TDMA sync, keeps track of the number of fail so that the TDMA
 				// watchdog can take decision as of TDMA resynchronisation
 				if (ctx.slot == 0)
 				{
-					ctx.state = syncTdmaState;
+					syncMissed();
+					masterMissed();
+					ctx.heard = 0;
 				}
 				//end of handleFailedRx
 			}
+			else
+			{
+				ctx.packetIds[sender] = rangePacket->idx;
+				ctx.rxTimestamps[sender] = rxTime.full & TDOA_TIME_MASK;
+				ctx.txTimestamps[sender] = rangePacket->txTime;
 
-			// Quickly setup transfer to next slot
-			if (ctx.nextSlot == ctx.anchorId)
+				// Resync and save useful master information
+				if(ctx.slot == 0)
+				{
+					//Resync local frame start to packet from the master, which transmits TDMA_TX_OFFSET into its slot
+					syncFilterUpdate(&rxTime);
+
+					ctx.msg_index = rangePacket->idx;
+					ctx.masterMisses = 0;
+					ctx.heard = 0;
+
+					// Follow a schedule change of the master from the next slot on, the slots of
+					// its frame take effect in this one. The master keeps slot 0 and this frame
+					// has at least one more slot after it, so the next slot stays in the frame
+					if((rangePacket->anchors != ctx.anchors) || (rangePacket->slotUnits != ctx.slotUnits))
+					{
+						setTdmaSchedule(rangePacket->anchors, rangePacket->slotUnits);
+						setTdmaSlots(rangePacket->active, rangePacket->join);
+						syncFilterReset(1);
+					}
+					else if((rangePacket->active != ctx.active) || (rangePacket->join != ctx.join))
+					{
+						setTdmaSlots(rangePacket->active, rangePacket->join);
+					}
+				}
+				ctx.heard |= 1 << sender;
+			}
+
+			// Quickly setup transfer to next slot, only the fixed fields were read so far
+			if (ctx.nextSlot == ctx.ownSlot)
 			{
 				setupTx();
 				ctx.slotState = slotTxDone;
@@ -276,7 +794,49 @@ void slotStep(const dwt_cb_data_t *cb_data, eventState_e event)
 				ctx.slotState = slotRxDone;
 			}
 
+			// The radio waits for the next slot on its own meanwhile. A packet
+			// right before our own slot has its ToF sent one frame later
+			if(rangePacket != NULL)
+			{
+				const uint8 *bitmap = RANGE_BITMAP(rangePacket);
+				const uint32_t remoteTx = rangePacket->txTime;
+
+				const uint8 complete = readRangeEntries(&rxPacket, cb_data->datalength);
+				uint8 k;
+
+				// The anchors the sender heard are present too, the master may not hear them itself
+				if(complete)
+				{
+					for(k = 0; k < rangePacket->anchors; k++)
+					{
+						if(tdoa_range_has_entry(bitmap, k))
+						{
+							ctx.heard |= 1 << k;
+						}
+					}
+				}
+
+				// Without our last packet in the entries of the sender there is no round trip. The
+				// entries are relative to the slots of the packet, which may differ from ours
+				if(complete && tdoa_range_has_entry(bitmap, ctx.anchorId))
+				{
+					const uint8 *entry = RANGE_ENTRY(rangePacket, rangePacket->anchors, tdoa_range_entry_index(bitmap, ctx.anchorId));
+					const uint32_t remoteRx = tdoa_range_entry_rx(entry,
+							tdoa_range_expected_rx(remoteTx, tdoa_tdma_slot_of(rangePacket->active, rangePacket->join, sender),
+									tdoa_tdma_slot_of(rangePacket->active, rangePacket->join, ctx.anchorId),
+									tdoa_tdma_slots(rangePacket->active, rangePacket->join), rangePacket->slotUnits));
+
+					calculateDistance(sender, &last, rangePacket->idx, remoteTx, remoteRx, rxTime.full & TDOA_TIME_MASK);
+				}
+				else
+				{
+					tofMissed(sender);
+				}
+			}
+			// end of handleRxPacket
+
 			break;
+		}
 		case slotTxDone:
 			// We send one packet per slot so after sending we setup the next receive
 			setupRx();
@@ -285,10 +845,70 @@ void slotStep(const dwt_cb_data_t *cb_data, eventState_e event)
 	}
 
 	updateSlot();
+	TDOA_TRACE_EXIT(TDOA_TRACE_SLOT_STEP);
+}
+
+#if TDOA_TRACE || ANCHOR_TELEMETRY_MS
+// dwt_isr with a probe and the telemetry cycle count around it, installed instead of it
+void tdoa_isr(void)
+{
+	TDOA_TRACE_ENTER(TDOA_TRACE_DWT_ISR);
+#if ANCHOR_TELEMETRY_MS
+	const uint32_t start = TDOA_DWT_CYCCNT;
+#endif
+	dwt_isr();
+#if ANCHOR_TELEMETRY_MS
+	const uint32_t cycles = TDOA_DWT_CYCCNT - start;
+	if(cycles < isrMinCycles) isrMinCycles = cycles;
+	if(cycles > isrMaxCycles) isrMaxCycles = cycles;
+#endif
+	TDOA_TRACE_EXIT(TDOA_TRACE_DWT_ISR);
+}
+#endif
+
+#if ANCHOR_TELEMETRY_MS
+/*
+ * Counters and times of flight for the telemetry frame, the period fields
+ * are left to the caller. Restarts the interrupt cycle statistics.
+ */
+void tdoa_get_telemetry(tdoa_anchor_telemetry_t *telemetry)
+{
+	uint8 k;
+
+	__disable_irq();
+	const tdmaStats_t stats = ctx.stats;
+	telemetry->isrMinCycles = (isrMinCycles == 0xFFFFFFFF) ? 0 : isrMinCycles;
+	telemetry->isrMaxCycles = isrMaxCycles;
+	isrMinCycles = 0xFFFFFFFF;
+	isrMaxCycles = 0;
+	telemetry->anchors = ctx.anchors;
+	telemetry->state = (uint8_t)ctx.state;
+	telemetry->active = (ctx.state == synchronizedState) ? ctx.active : 0;
+	for(k = 0; k < ctx.anchors; k++)
+	{
+		telemetry->tof[k] = ctx.distances[k];
+	}
+	__enable_irq();
+
+	telemetry->anchor = TDOA_CELL_ID(ctx.cell, ctx.anchorId);
+	telemetry->rxGood = stats.rxGood;
+	telemetry->rxTimeouts = stats.rxTimeouts;
+	telemetry->rxErrors = stats.rxErrors;
+	telemetry->txGood = stats.txGood;
+	telemetry->lateTx = stats.lateTx;
+	telemetry->lateRx = stats.lateRx;
+	telemetry->syncMissed = stats.syncMissed;
+	telemetry->syncLost = stats.syncLost;
+	telemetry->resyncs = stats.resyncs;
+	telemetry->watchdogResets = stats.watchdogResets;
+	telemetry->failovers = stats.failovers;
+	telemetry->stateChanges = stats.stateChanges;
 }
+#endif
 
-void rx_ok_cb(const dwt_cb_data_t *cb_data)
+PORT_RAMFUNC void rx_ok_cb(const dwt_cb_data_t *cb_data)
 {
+	ctx.stats.rxGood++;
 	led_off(LED_ALL);
 	led_on(LED_PC7);
 	if(ctx.state == synchronizedState)
@@ -297,56 +917,58 @@ void rx_ok_cb(const dwt_cb_data_t *cb_data)
 	}
 	else
 	{
-		if(ctx.anchorId == 0)
-		{
-			dwt_readsystime(ctx.tdmaFrameStart.raw);
-			ctx.tdmaFrameStart.full = TDMA_LAST_FRAME(ctx.tdmaFrameStart.full) + 2*TDMA_FRAME_LEN;
-			ctx.state = synchronizedState;
-			setupTx();
-			
-			ctx.slotState = slotTxDone;
-			updateSlot();
-		}
-		else
-		{
-			static packet_t rxPacket;
-			dwTime_t rxTime = { .full = 0 };
-			dwt_readrxtimestamp(rxTime.raw);
-			dwCorrectTimestamp(&rxTime);
-			dwt_readrxdata((uint8*)&rxPacket, cb_data->datalength, 0);
-			
-			if((rxPacket.sourceAddress[0] == 0) && (rxPacket.payload[0] == PACKET_TYPE_RANGE))
-			{
-				rangePacket_t * rangePacket = (rangePacket_t *)rxPacket.payload;
+		static packet_t rxPacket;
+		dwTime_t rxTime = { .full = 0 };
+		dwt_readfast(RX_TIME_ID, RX_TIME_RX_STAMP_OFFSET, RX_TIME_RX_STAMP_LEN, rxTime.raw);
+		dwCorrectTimestamp(&rxTime);
+		rangePacket_t *rangePacket = readRangePacket(&rxPacket, cb_data->datalength);
+		
+		const uint8 sender = rxPacket.sourceAddress[0];
+		const uint8 slot = (rangePacket != NULL) ? tdoa_tdma_slot_of(rangePacket->active, rangePacket->join, sender) : 0;
 
-				//txKalman(&rxTime);
+		// Joins on the packet of any anchor with a slot in a schedule with this anchor's address, all of them carry the
+		// schedule of the master. Without a slot of its own the anchor listens until the master gives it the join slot.
+		// With slot 0, after a quick restart of the master, it goes on as the master
+		if((rangePacket != NULL) && (sender < rangePacket->anchors) && (sender != ctx.anchorId) && (ctx.anchorId < rangePacket->anchors)
+		   && (slot < tdoa_tdma_slots(rangePacket->active, rangePacket->join)))
+		{
+			setTdmaSchedule(rangePacket->anchors, rangePacket->slotUnits);
+			setTdmaSlots(rangePacket->active, rangePacket->join);
+			ctx.tdmaFrameStart.full = rxTime.full - TDMA_TX_OFFSET(ctx.txLead) - slot*ctx.slotLen;
+			syncFilterReset(slot == 0);
+			ctx.stats.resyncs++;
 
-				dwTime_t pkTxTime = { .full = 0 };
-				memcpy(&pkTxTime, rangePacket->timestamps[0], TS_TX_SIZE);
-				ctx.tdmaFrameStart.full = rxTime.full - (pkTxTime.full - TDMA_LAST_FRAME(pkTxTime.full));
-				
-				ctx.tdmaFrameStart.full += TDMA_FRAME_LEN;
-				
-				ctx.msg_index = rangePacket->idx; //last sync index
+			ctx.msg_index = rangePacket->idx; //last sync index
+			ctx.packetIds[sender] = rangePacket->idx;
+			ctx.rxTimestamps[sender] = rxTime.full & TDOA_TIME_MASK;
+			ctx.txTimestamps[sender] = rangePacket->txTime;
 
+			// Continue as slotStep does after the slot of the sender
+			ctx.nextSlot = slot;
+			updateSlot();
+			enterState(synchronizedState);
+			if (ctx.nextSlot == ctx.ownSlot)
+			{
 				setupTx();
-
-				ctx.slotState = slotRxDone;
-				ctx.state = synchronizedState;
-				updateSlot();
+				ctx.slotState = slotTxDone;
 			}
 			else
 			{
-				// Start the receiver waiting for a packet from anchor 0
-				dwt_setrxtimeout(RECEIVE_TIMEOUT);
-				dwt_rxenable(DWT_START_RX_IMMEDIATE);
+				setupRx();
+				ctx.slotState = slotRxDone;
 			}
+			updateSlot();
+		}
+		else
+		{
+			listenOrStart();
 		}
 	}
 }
 
 void rx_to_cb(const dwt_cb_data_t *cb_data)
 {
+	ctx.stats.rxTimeouts++;
 	led_off(LED_ALL);
 	led_on(LED_PC6);
 	if(ctx.state == synchronizedState)
@@ -355,54 +977,26 @@ void rx_to_cb(const dwt_cb_data_t *cb_data)
 	}
 	else
 	{
-		if(ctx.anchorId == 0)
-		{
-			dwt_readsystime(ctx.tdmaFrameStart.raw);
-			ctx.tdmaFrameStart.full = TDMA_LAST_FRAME(ctx.tdmaFrameStart.full) + 2*TDMA_FRAME_LEN;
-			ctx.state = synchronizedState;
-			setupTx();
-			
-			ctx.slotState = slotTxDone;
-			updateSlot();
-		}
-		else
-		{
-			// Start the receiver waiting for a packet from anchor 0
-			dwt_setrxtimeout(RECEIVE_TIMEOUT);
-			dwt_rxenable(DWT_START_RX_IMMEDIATE);
-		}
+		listenOrStart();
 	}
 }
 
 void rx_err_cb(const dwt_cb_data_t *cb_data)
 {
+	ctx.stats.rxErrors++;
 	if(ctx.state == synchronizedState)
 	{
 		slotStep(cb_data, RX_ERR);
 	}
 	else
 	{
-		if(ctx.anchorId == 0)
-		{
-			dwt_readsystime(ctx.tdmaFrameStart.raw);
-			ctx.tdmaFrameStart.full = TDMA_LAST_FRAME(ctx.tdmaFrameStart.full) + 2*TDMA_FRAME_LEN;
-			ctx.state = synchronizedState;
-			setupTx();
-			
-			ctx.slotState = slotTxDone;
-			updateSlot();
-		}
-		else
-		{
-			// Start the receiver waiting for a packet from anchor 0
-			dwt_setrxtimeout(RECEIVE_TIMEOUT);
-			dwt_rxenable(DWT_START_RX_IMMEDIATE);
-		}
+		listenOrStart();
 	}
 }
 
 void tx_conf_cb(const dwt_cb_data_t *cb_data)
 {
+	ctx.stats.txGood++;
 	led_off(LED_ALL);
 	led_on(LED_PC9);
 	if(ctx.state == synchronizedState)
@@ -411,143 +1005,101 @@ void tx_conf_cb(const dwt_cb_data_t *cb_data)
 	}
 	else
 	{
-		if(ctx.anchorId == 0)
-		{
-			dwt_readsystime(ctx.tdmaFrameStart.raw);
-			ctx.tdmaFrameStart.full = TDMA_LAST_FRAME(ctx.tdmaFrameStart.full) + 2*TDMA_FRAME_LEN;
-			ctx.state = synchronizedState;
-			setupTx();
-			
-			ctx.slotState = slotTxDone;
-			updateSlot();
-		}
-		else
-		{
-			// Start the receiver waiting for a packet from anchor 0
-			dwt_setrxtimeout(RECEIVE_TIMEOUT);
-			dwt_rxenable(DWT_START_RX_IMMEDIATE);
-		}
+		listenOrStart();
 	}
 }
 
-
-static const uint8_t BIAS_500_16_ZERO = 10;
-static const uint8_t BIAS_500_64_ZERO = 8;
-static const uint8_t BIAS_900_16_ZERO = 7;
-static const uint8_t BIAS_900_64_ZERO = 7;
-
-// range bias tables (500 MHz in [mm] and 900 MHz in [2mm] - to fit into bytes)
-static const uint8_t BIAS_500_16[] = {198, 187, 179, 163, 143, 127, 109, 84, 59, 31,   0,  36,  65,  84,  97, 106, 110, 112};
-static const uint8_t BIAS_500_64[] = {110, 105, 100,  93,  82,  69,  51, 27,  0, 21,  35,  42,  49,  62,  71,  76,  81,  86};
-static const uint8_t BIAS_900_16[] = {137, 122, 105, 88, 69,  47,  25,  0, 21, 48, 79, 105, 127, 147, 160, 169, 178, 197};
-static const uint8_t BIAS_900_64[] = {147, 133, 117, 99, 75, 50, 29, 0, 24, 45, 63, 76, 87, 98, 116, 122, 132, 142};
-
-void dwCorrectTimestamp(dwTime_t* timestamp)
+/*
+ * After a watchdog or software reset, takes back what tdoa_save_state kept
+ * if it is of this anchor and cell: the schedule, the drift to the master
+ * for the first master packet and the distances to the other anchors. The
+ * counters go on from where they were, so the telemetry rates stay right.
+ */
+static void restoreState(void)
 {
-	// base line dBm, which is -61, 2 dBm steps, total 18 data points (down to -95 dBm)
-	float rxPowerBase = -(dwGetReceivePower() + 61.0f) * 0.5f;
-	if (!isfinite(rxPowerBase)) {
-		return;
-	}
-	int rxPowerBaseLow = (int)rxPowerBase;
-	int rxPowerBaseHigh = rxPowerBaseLow + 1;
-	if(rxPowerBaseLow < 0)
-	{
-		rxPowerBaseLow = 0;
-		rxPowerBaseHigh = 0;
-	}
-	else if(rxPowerBaseHigh > 17)
-	{
-		rxPowerBaseLow = 17;
-		rxPowerBaseHigh = 17;
-	}
-	// select range low/high values from corresponding table
-	int rangeBiasHigh = 0;
-	int rangeBiasLow = 0;
-	if(anc_chan == 4 || anc_chan == 7)
-	{
-		// 900 MHz receiver bandwidth
-		if(anc_prf == DWT_PRF_16M)
-		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_900_16_ZERO ? -BIAS_900_16[rxPowerBaseHigh] : BIAS_900_16[rxPowerBaseHigh]);
-			rangeBiasHigh <<= 1;
-			rangeBiasLow = (rxPowerBaseLow < BIAS_900_16_ZERO ? -BIAS_900_16[rxPowerBaseLow] : BIAS_900_16[rxPowerBaseLow]);
-			rangeBiasLow <<= 1;
-		} else if(anc_prf == DWT_PRF_64M)
-		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_900_64_ZERO ? -BIAS_900_64[rxPowerBaseHigh] : BIAS_900_64[rxPowerBaseHigh]);
-			rangeBiasHigh <<= 1;
-			rangeBiasLow = (rxPowerBaseLow < BIAS_900_64_ZERO ? -BIAS_900_64[rxPowerBaseLow] : BIAS_900_64[rxPowerBaseLow]);
-			rangeBiasLow <<= 1;
-		} else {
-			// TODO proper error handling
-		}
-	}
-	else
+	const uint8 cause = port_reset_cause();
+
+	if(((cause != PORT_RESET_WATCHDOG) && (cause != PORT_RESET_SOFTWARE))
+	   || !tdoa_retain_valid(&retained.header, TDOA_RETAIN_ANCHOR_MAGIC, sizeof(retained))
+	   || (retained.anchorId != ctx.anchorId) || (retained.cell != ctx.cell)
+	   || !tdoa_tdma_valid(retained.anchors, retained.slotUnits))
 	{
-		// 500 MHz receiver bandwidth
-		if(anc_prf == DWT_PRF_16M)
-		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_500_16_ZERO ? -BIAS_500_16[rxPowerBaseHigh] : BIAS_500_16[rxPowerBaseHigh]);
-			rangeBiasLow = (rxPowerBaseLow < BIAS_500_16_ZERO ? -BIAS_500_16[rxPowerBaseLow] : BIAS_500_16[rxPowerBaseLow]);
-		}
-		else if(anc_prf == DWT_PRF_64M)
-		{
-			rangeBiasHigh = (rxPowerBaseHigh < BIAS_500_64_ZERO ? -BIAS_500_64[rxPowerBaseHigh] : BIAS_500_64[rxPowerBaseHigh]);
-			rangeBiasLow = (rxPowerBaseLow < BIAS_500_64_ZERO ? -BIAS_500_64[rxPowerBaseLow] : BIAS_500_64[rxPowerBaseLow]);
-		}
-		else
-		{
-			// TODO proper error handling
-		}
+		tdoa_retain_clear(&retained.header);
+		return;
 	}
-	// linear interpolation of bias values
-	float rangeBias = rangeBiasLow + (rxPowerBase - rxPowerBaseLow) * (rangeBiasHigh - rangeBiasLow);
-	// range bias [mm] to timestamp modification value conversion
-	dwTime_t adjustmentTime;
-//	float rangecalc = (rangeBias * DISTANCE_OF_RADIO_INV * 0.001f);
-//	int rangecheck = (int)rangecalc;
-	adjustmentTime.full = (int)(rangeBias * DISTANCE_OF_RADIO_INV * 0.001f);
-	// apply correction
-	timestamp->full += adjustmentTime.full;
+
+	retained.header.resets++;
+	setTdmaSchedule(retained.anchors, retained.slotUnits);
+	setTdmaSlots(retained.active, retained.join);
+	ctx.slot = ctx.nslots-1;
+	warmSyncRate = retained.syncRate;
+	warmFrameLen = retained.frameLen;
+	memcpy(ctx.distances, retained.distances, sizeof(ctx.distances));
+	memcpy(ctx.tofFilters, retained.tofFilters, sizeof(ctx.tofFilters));
+	ctx.stats = retained.stats;
 }
 
-float dwGetReceivePower(void)
+/*
+ * Called from the main loop every ANCHOR_RETAIN_MS. Copies the state
+ * restoreState takes back into the .noinit block, with the DW1000 interrupt
+ * off for a consistent copy, and seals it.
+ */
+void tdoa_save_state(void)
 {
-	uint8 rxFrameInfo[RX_FINFO_LEN];
-	float C = (float)dwt_read16bitoffsetreg(RX_FQUAL_ID, CIR_PWR_OFFSET);
-	dwt_readfromdevice(RX_FINFO_ID,RX_FINFO_OFFSET,RX_FINFO_LEN,rxFrameInfo);
-	float N = (float)((((unsigned int)rxFrameInfo[2] >> 4) & 0xFF) | ((unsigned int)rxFrameInfo[3] << 4));
+	port_DisableEXT_IRQ();
+	retained.anchorId = ctx.anchorId;
+	retained.cell = ctx.cell;
+	retained.anchors = ctx.anchors;
+	retained.join = ctx.join;
+	retained.active = ctx.active;
+	retained.slotUnits = ctx.slotUnits;
+	retained.frameLen = ((ctx.state == synchronizedState) && (ctx.syncCount >= 2)) ? ctx.frameLen : 0;
+	retained.syncRate = ctx.syncRate;
+	memcpy(retained.distances, ctx.distances, sizeof(retained.distances));
+	memcpy(retained.tofFilters, ctx.tofFilters, sizeof(retained.tofFilters));
+	retained.stats = ctx.stats;
+	port_EnableEXT_IRQ();
 
-	return calculatePower(C * TWOPOWER17, N);
+	tdoa_retain_seal(&retained.header, TDOA_RETAIN_ANCHOR_MAGIC, sizeof(retained));
 }
 
-float calculatePower(float base, float N)
+/*
+ * Called from the main loop. Events stop only if the DW1000 got stuck, as
+ * the receiver always runs with a timeout, so after watchdogMs without one
+ * the receiver is restarted and the anchor synchronizes again, at most once
+ * per watchdogMs.
+ */
+void tdoa_watchdog(unsigned long now, unsigned long lastEvent)
 {
-	float A, corrFac;
+	static unsigned long lastReset;
 
-	if(DWT_PRF_16M == anc_prf)
+	if(((now - lastEvent) > ctx.watchdogMs) && ((now - lastReset) > ctx.watchdogMs))
 	{
-		A = 115.72f;
-		corrFac = 2.3334f;
-	}
-	else
-	{
-		A = 121.74f;
-		corrFac = 1.1667f;
+		port_DisableEXT_IRQ();
+		dwt_forcetrxoff();
+		dwt_rxreset();
+		enterState(syncTdmaState);
+		ctx.listenCount = 0;
+		ctx.stats.watchdogResets++;
+		rxImmediate();
+		port_EnableEXT_IRQ();
+		lastReset = now;
 	}
+}
 
-	float estFpPwr = 10.0f * log10f(base / (N * N)) - A;
+void dwCorrectTimestamp(dwTime_t* timestamp)
+{
+	TDOA_TRACE_ENTER(TDOA_TRACE_CORRECT_TIMESTAMP);
+	timestamp->full += tdoa_rx_bias(rxCorrection, dwGetReceivePower());
+	TDOA_TRACE_EXIT(TDOA_TRACE_CORRECT_TIMESTAMP);
+}
 
-	if(estFpPwr <= -88)
-	{
-		return estFpPwr;
-	}
-	else
-	{
-		// approximation of Fig. 22 in user manual for dbm correction
-		estFpPwr += (estFpPwr + 88) * corrFac;
-	}
+// First path power of the last frame in 1/64 dBm (TDOA_RX_POWER_SHIFT)
+int16 dwGetReceivePower(void)
+{
+	uint8 rxFrameInfo[RX_FINFO_LEN];
+	const uint16 C = dwt_read16fast(RX_FQUAL_ID, CIR_PWR_OFFSET);
+	dwt_readfast(RX_FINFO_ID, RX_FINFO_OFFSET, RX_FINFO_LEN, rxFrameInfo);
 
-	return estFpPwr;
+	return tdoa_rx_power(rxCorrection, C, rxFrameInfo);
 }
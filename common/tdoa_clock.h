@@ -0,0 +1,232 @@
+/*************************************************
+ *
+ *  Tag-to-anchor clock correction and TDOA distance difference, shared by the
+ *  tag firmware (TREK_TAG) and the host side solver for raw timestamp frames
+ *  (decawave). Header-only, compiles as C99 and C++11.
+ *
+ *  The clock ratio of each anchor is the slope of its transmit times (anchor
+ *  clock) over their arrival times at the tag (tag clock), fitted by least
+ *  squares over the last TDOA_CLOCK_FILTER_LEN packets. Sums are accumulated in
+ *  64-bit integers on the deviation from a ratio of 1, so only the final
+ *  division is done in floating point. The distance difference itself is
+ *  integer arithmetic on 40-bit intervals (tdoa_time.h) up to the conversion
+ *  to metres, with the ratio as a fixed-point skew.
+ *
+ *  Changelog:
+ *      v0.3 - Residual variance of the clock fit
+ *      v0.2 - 40-bit tag intervals, anchor intervals unwrapped against them, fixed-point skew
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_CLOCK_H_
+#define _TDOA_CLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tdoa_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_CLOCK_FILTER_LEN   8                   // Packets per anchor in the regression, power of two
+#define TDOA_CLOCK_FILTER_SHIFT 12                  // Right shift of the tag time deltas before the products
+#define TDOA_CLOCK_MAX_SPAN     (1LL << 36)         // Tag ticks (~1.1 s), older packets leave the regression
+#define TDOA_CLOCK_TAG_MASK     TDOA_TIME_MASK      // DW1000 counter of the tag, 40 bits
+#define TDOA_CLOCK_ANCHOR_MASK  TDOA_TIME_SHORT_MASK // Anchor timestamps in the range packet, 32 bits
+#define TDOA_CLOCK_SKEW_SHIFT   40                  // Fixed point of the skew, ratio - 1
+#define TDOA_CLOCK_MAX_SKEW     (1L << 28)          // ~244 ppm, far beyond two crystals
+
+#define TDOA_SPEED_OF_LIGHT     (299702547.0)       // m/s in air
+#define TDOA_TIMESTAMP_FREQ     (499.2e6 * 128)     // DW1000 ticks per second
+
+/*
+ * Both times are kept unwrapped relative to the first packet after a reset.
+ * The anchor timestamps wrap every 67 ms, so their wrap count is recovered
+ * from the tag time elapsed over the same interval.
+ */
+typedef struct tdoa_clock_filter_s
+{
+    int64_t tag[TDOA_CLOCK_FILTER_LEN];
+    int64_t anchor[TDOA_CLOCK_FILTER_LEN];
+    uint64_t lastTagRaw;
+    uint32_t lastAnchorRaw;
+    uint8_t head;           // Next slot to write
+    uint8_t count;
+}tdoa_clock_filter_t;
+
+static inline void tdoa_clock_filter_reset(tdoa_clock_filter_t *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+/*
+ * Adds the arrival time at the tag and the transmit time in the anchor clock
+ * of one packet. A gap longer than TDOA_CLOCK_MAX_SPAN, or an anchor interval
+ * that cannot be unwrapped, restarts the regression. Returns nonzero once
+ * there are two packets to fit.
+ */
+static inline int tdoa_clock_filter_add(tdoa_clock_filter_t *f, uint64_t tagRx, uint32_t anchorTx)
+{
+    const uint8_t mask = TDOA_CLOCK_FILTER_LEN - 1;
+    const int64_t dTag = (int64_t)((tagRx - f->lastTagRaw) & TDOA_CLOCK_TAG_MASK);
+    const int64_t d32 = (int64_t)((anchorTx - f->lastAnchorRaw) & TDOA_CLOCK_ANCHOR_MASK);
+    const int64_t slip = dTag - d32;
+
+    if ((f->count > 0) && ((dTag > TDOA_CLOCK_MAX_SPAN) || (slip < -(1LL << 31))))
+    {
+        f->count = 0;
+    }
+
+    int64_t tagTime = 0;
+    int64_t anchorTime = 0;
+    if (f->count > 0)
+    {
+        const uint8_t newest = (f->head - 1) & mask;
+        tagTime = f->tag[newest] + dTag;
+        anchorTime = f->anchor[newest] + tdoa_time_unwrap32(anchorTx, f->lastAnchorRaw, dTag);
+    }
+
+    f->tag[f->head] = tagTime;
+    f->anchor[f->head] = anchorTime;
+    f->head = (f->head + 1) & mask;
+    if (f->count < TDOA_CLOCK_FILTER_LEN)
+    {
+        f->count++;
+    }
+    f->lastTagRaw = tagRx;
+    f->lastAnchorRaw = anchorTx;
+
+    // Keep the tag deltas below 2^36 so the shifted products fit in 64 bits
+    while ((f->count > 2) && ((tagTime - f->tag[(f->head - f->count) & mask]) > TDOA_CLOCK_MAX_SPAN))
+    {
+        f->count--;
+    }
+
+    return f->count >= 2;
+}
+
+/*
+ * Anchor clock ticks per tag clock tick, 0 with fewer than two packets. With
+ * x = tag delta to the newest packet and r = anchor delta - tag delta, the
+ * slope is 1 + Sxr/Sxx on the centered sums.
+ */
+static inline double tdoa_clock_filter_ratio(const tdoa_clock_filter_t *f)
+{
+    const uint8_t mask = TDOA_CLOCK_FILTER_LEN - 1;
+    if (f->count < 2)
+    {
+        return 0.0;
+    }
+
+    const uint8_t newest = (f->head - 1) & mask;
+    const int64_t n = f->count;
+    int64_t sx = 0, sr = 0, sxx = 0, sxr = 0;
+    for (uint8_t k = 1; k <= f->count; k++)
+    {
+        const uint8_t i = (f->head - k) & mask;
+        const int64_t dt = f->tag[newest] - f->tag[i];
+        const int64_t x = dt >> TDOA_CLOCK_FILTER_SHIFT;
+        const int64_t r = (f->anchor[newest] - f->anchor[i]) - dt;
+        sx += x;
+        sr += r;
+        sxx += x*x;
+        sxr += x*r;
+    }
+
+    const int64_t Sxx = n*sxx - sx*sx;
+    const int64_t Sxr = n*sxr - sx*sr;
+    if (Sxx <= 0)
+    {
+        return 0.0;
+    }
+    return 1.0 + (double)Sxr / ((double)Sxx * (double)(1LL << TDOA_CLOCK_FILTER_SHIFT));
+}
+
+/*
+ * Variance of the anchor times about the fitted line, in anchor clock ticks
+ * squared: the timestamp jitter of the packets of the anchor as the tag saw
+ * them. 0 with fewer than three packets, when two always fit exactly.
+ */
+static inline double tdoa_clock_filter_residual(const tdoa_clock_filter_t *f)
+{
+    const uint8_t mask = TDOA_CLOCK_FILTER_LEN - 1;
+    if (f->count < 3)
+    {
+        return 0.0;
+    }
+
+    const uint8_t newest = (f->head - 1) & mask;
+    const int64_t n = f->count;
+    int64_t sx = 0, sr = 0, sxx = 0, sxr = 0, srr = 0;
+    for (uint8_t k = 1; k <= f->count; k++)
+    {
+        const uint8_t i = (f->head - k) & mask;
+        const int64_t dt = f->tag[newest] - f->tag[i];
+        const int64_t x = dt >> TDOA_CLOCK_FILTER_SHIFT;
+        const int64_t r = (f->anchor[newest] - f->anchor[i]) - dt;
+        sx += x;
+        sr += r;
+        sxx += x*x;
+        sxr += x*r;
+        srr += r*r;
+    }
+
+    const int64_t Sxx = n*sxx - sx*sx;
+    const double Sxr = (double)(n*sxr - sx*sr);
+    const double Srr = (double)(n*srr - sr*sr);
+    if (Sxx <= 0)
+    {
+        return 0.0;
+    }
+    const double sse = (Srr - Sxr*Sxr / (double)Sxx) / (double)n;
+    return (sse > 0.0) ? sse / (double)(n - 2) : 0.0;
+}
+
+/*
+ * (ratio - 1) * 2^TDOA_CLOCK_SKEW_SHIFT of a tdoa_clock_filter_ratio, limited
+ * to TDOA_CLOCK_MAX_SKEW so the products of tdoa_clock_distance_diff fit in
+ * 64 bits for intervals up to 2^34 ticks (~270 ms).
+ */
+static inline int32_t tdoa_clock_skew(double ratio)
+{
+    const double skew = (ratio - 1.0) * (double)(1LL << TDOA_CLOCK_SKEW_SHIFT);
+    if (skew > TDOA_CLOCK_MAX_SKEW)
+    {
+        return TDOA_CLOCK_MAX_SKEW;
+    }
+    if (skew < -TDOA_CLOCK_MAX_SKEW)
+    {
+        return -TDOA_CLOCK_MAX_SKEW;
+    }
+    return (int32_t)skew;
+}
+
+/*
+ * Distance difference of the packets of Ar and An as seen by the tag, in m.
+ * rxAr_by_T and rxAn_by_T are the tag arrival times, rxAr_by_An the arrival of
+ * the packet of Ar at An and txAn the transmit time of An (anchor clock), and
+ * tofAr_to_An the time of flight between them in An clock ticks. skew is the
+ * tdoa_clock_skew of An. The anchor interval is unwrapped against the tag
+ * interval, so both may span any TDMA frame length.
+ */
+static inline float tdoa_clock_distance_diff(uint64_t rxAr_by_T, uint64_t rxAn_by_T, uint32_t rxAr_by_An, uint32_t txAn,
+                                             uint16_t tofAr_to_An, int32_t skew)
+{
+    const int64_t rxInterval_in_cl_T = tdoa_time_sub(rxAn_by_T, rxAr_by_T);
+    const int64_t rxInterval_in_cl_An = rxInterval_in_cl_T
+        + ((rxInterval_in_cl_T * skew + (1LL << (TDOA_CLOCK_SKEW_SHIFT - 1))) >> TDOA_CLOCK_SKEW_SHIFT);
+    const int64_t delta_txAr_to_txAn_in_cl_An = tofAr_to_An
+        + tdoa_time_unwrap32(txAn, rxAr_by_An, rxInterval_in_cl_An - tofAr_to_An);
+    const int64_t timeDiffOfArrival_in_cl_An = rxInterval_in_cl_An - delta_txAr_to_txAn_in_cl_An;
+
+    return (float)timeDiffOfArrival_in_cl_An * (float)(TDOA_SPEED_OF_LIGHT / TDOA_TIMESTAMP_FREQ);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
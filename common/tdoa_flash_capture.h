@@ -0,0 +1,120 @@
+/*************************************************
+ *
+ *  Layout of the flash capture of the tag (TREK_TAG tag_capture.c), the
+ *  file CAPTURE.BIN the tag exports as a USB mass storage device.
+ *  Header-only, compiles as C99 and C++11.
+ *
+ *  The capture is a ring of flash pages of TDOA_CAPTURE_PAGE_SIZE bytes,
+ *  the file holds the written pages oldest first. Each page starts with a
+ *  header and is followed by records, erased flash (0xFF) ends the records
+ *  of a page. All fields big-endian:
+ *      Page header, TDOA_CAPTURE_HEADER_SIZE bytes:
+ *      [0-3]   TDOA_CAPTURE_MAGIC
+ *      [4-7]   page sequence number, 0 for the first page of a capture
+ *
+ *      Record, TDOA_CAPTURE_RECORD_SIZE bytes, one per pair of a received
+ *      packet (TDOA_PAIRS of the tag, consecutive in raw mode):
+ *      [0]     TDOA_QUALITY_* bits, the top bit is clear
+ *      [1]     anchor Ar, cell-qualified (TDOA_CELL_ID)
+ *      [2]     anchor An that sent the packet, cell-qualified
+ *      [3]     packet index of An
+ *      [4-8]   arrival of the packet at the tag, corrected, 40-bit tag clock
+ *      [9-12]  transmit time of An, anchor clock
+ *      [13-16] arrival of the last packet of Ar at An, anchor clock, 0 without
+ *      [17-18] time of flight Ar to An, anchor clock
+ *      [19-20] receive power, signed 1/64 dBm, TDOA_RX_POWER_INVALID without
+ *      [21-22] first path power minus receive power, signed 1/64 dB
+ *      [23]    anchors in the TDMA schedule of the packet
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_FLASH_CAPTURE_H_
+#define _TDOA_FLASH_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tdoa_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_CAPTURE_PAGE_SIZE      2048            // STM32F105 flash page
+#define TDOA_CAPTURE_MAGIC          0x54434150      // "TCAP"
+#define TDOA_CAPTURE_HEADER_SIZE    8
+#define TDOA_CAPTURE_RECORD_SIZE    24
+#define TDOA_CAPTURE_PAGE_RECORDS   ((TDOA_CAPTURE_PAGE_SIZE - TDOA_CAPTURE_HEADER_SIZE) / TDOA_CAPTURE_RECORD_SIZE)
+#define TDOA_CAPTURE_FILE_NAME      "CAPTURE BIN"   // 8.3 directory entry
+
+typedef struct tdoa_capture_rec_s
+{
+    uint8_t  quality;       // TDOA_QUALITY_* bits
+    uint8_t  Ar;
+    uint8_t  An;
+    uint8_t  idx;
+    uint64_t rxAn_by_T;     // 40 bits
+    uint32_t txAn;
+    uint32_t rxAr_by_An;
+    uint16_t tofAr_to_An;
+    int16_t  rxPower;       // 1/64 dBm
+    int16_t  fpGap;         // 1/64 dB
+    uint8_t  slots;
+}tdoa_capture_rec_t;
+
+static inline void tdoa_capture_header_encode(uint8_t *msg, uint32_t seq)
+{
+    tdoa_put_be(&msg[0], TDOA_CAPTURE_MAGIC, 4);
+    tdoa_put_be(&msg[4], seq, 4);
+}
+
+// Nonzero for a page written by a capture, with its sequence number in seq
+static inline int tdoa_capture_header_decode(const uint8_t *msg, uint32_t *seq)
+{
+    *seq = (uint32_t)tdoa_get_be(&msg[4], 4);
+    return tdoa_get_be(&msg[0], 4) == TDOA_CAPTURE_MAGIC;
+}
+
+static inline void tdoa_capture_rec_encode(uint8_t *msg, const tdoa_capture_rec_t *r)
+{
+    msg[0] = r->quality & 0x7F;
+    msg[1] = r->Ar;
+    msg[2] = r->An;
+    msg[3] = r->idx;
+    tdoa_put_be(&msg[4], r->rxAn_by_T, 5);
+    tdoa_put_be(&msg[9], r->txAn, 4);
+    tdoa_put_be(&msg[13], r->rxAr_by_An, 4);
+    tdoa_put_be(&msg[17], r->tofAr_to_An, 2);
+    tdoa_put_be(&msg[19], (uint16_t)r->rxPower, 2);
+    tdoa_put_be(&msg[21], (uint16_t)r->fpGap, 2);
+    msg[23] = r->slots;
+}
+
+// Zero for erased flash, the end of the records of a page
+static inline int tdoa_capture_rec_decode(const uint8_t *msg, tdoa_capture_rec_t *r)
+{
+    if (msg[0] & 0x80) {
+        return 0;
+    }
+    r->quality = msg[0];
+    r->Ar = msg[1];
+    r->An = msg[2];
+    r->idx = msg[3];
+    r->rxAn_by_T = tdoa_get_be(&msg[4], 5);
+    r->txAn = (uint32_t)tdoa_get_be(&msg[9], 4);
+    r->rxAr_by_An = (uint32_t)tdoa_get_be(&msg[13], 4);
+    r->tofAr_to_An = (uint16_t)tdoa_get_be(&msg[17], 2);
+    r->rxPower = (int16_t)tdoa_get_be(&msg[19], 2);
+    r->fpGap = (int16_t)tdoa_get_be(&msg[21], 2);
+    r->slots = msg[23];
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+/*************************************************
+ *
+ *  PHY profiles of the DW1000, shared by the anchor (TREK_TDOA) and tag
+ *  (TREK_TAG) firmware and the host (decawave). Header-only, compiles as
+ *  C99 and C++11.
+ *
+ *  A profile fixes the data rate, PRF, preamble and SFD of a site, channel
+ *  and preamble code stay with the cell (tdoa_cell_radio). The profiles are
+ *  in order of airtime: a short preamble at 6.8 Mbps keeps the TDMA frame
+ *  short for small rooms, the long ones buy receiver sensitivity for large
+ *  halls at the cost of the update rate. The anchors take theirs from the
+ *  S1 switches and derive the slot length from it, the tag finds it by
+ *  scanning and reports it in the telemetry frame, and the host compares
+ *  the receive power of every anchor to the sensitivity of the profile to
+ *  suggest the shortest one with enough link margin.
+ *
+ *  The sensitivities are approximate figures of the data sheet class, the
+ *  host only uses them to rank the profiles.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_PHY_H_
+#define _TDOA_PHY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_PHY_SHORT          0       // 6.8 Mbps, 64 MHz PRF, 64 symbols
+#define TDOA_PHY_STANDARD       1       // 6.8 Mbps, 64 MHz PRF, 128 symbols
+#define TDOA_PHY_MEDIUM         2       // 850 kbps, 64 MHz PRF, 512 symbols
+#define TDOA_PHY_LONG           3       // 110 kbps, 16 MHz PRF, 1024 symbols
+#define TDOA_PHY_PROFILES       4
+#define TDOA_PHY_UNKNOWN        0xFF    // Tag still scanning
+
+typedef struct tdoa_phy_profile_s
+{
+    uint16_t preamble;          // Symbols
+    uint16_t rateKbps;
+    uint8_t prf64;              // 64 MHz PRF, 16 MHz otherwise
+    uint8_t pac;                // Preamble acquisition chunk, symbols
+    uint8_t nsSFD;              // Decawave SFD
+    int8_t sensitivity;         // dBm, approximate
+    const char *name;
+}tdoa_phy_profile_t;
+
+static const tdoa_phy_profile_t TDOA_PHY_TABLE[TDOA_PHY_PROFILES] = {
+    {64,   6800, 1, 8,  0, -91,  "short"},
+    {128,  6800, 1, 8,  0, -93,  "standard"},
+    {512,  850,  1, 16, 1, -101, "medium"},
+    {1024, 110,  0, 32, 1, -106, "long"},
+};
+
+#ifdef DWT_PRF_64M
+/*
+ * Rate, PRF, preamble, PAC, SFD and SFD timeout of profile p in config, the
+ * channel and preamble codes are left as they are.
+ */
+static inline void tdoa_phy_config(uint8_t p, dwt_config_t *config)
+{
+    const tdoa_phy_profile_t *profile = &TDOA_PHY_TABLE[p];
+    uint16_t sfd;
+
+    switch (profile->preamble)
+    {
+        case 64:   config->txPreambLength = DWT_PLEN_64;   break;
+        case 128:  config->txPreambLength = DWT_PLEN_128;  break;
+        case 512:  config->txPreambLength = DWT_PLEN_512;  break;
+        default:   config->txPreambLength = DWT_PLEN_1024; break;
+    }
+    switch (profile->pac)
+    {
+        case 8:    config->rxPAC = DWT_PAC8;  break;
+        case 16:   config->rxPAC = DWT_PAC16; break;
+        default:   config->rxPAC = DWT_PAC32; break;
+    }
+    if (profile->rateKbps == 110)
+    {
+        config->dataRate = DWT_BR_110K;
+        sfd = 64;
+    }
+    else
+    {
+        config->dataRate = (profile->rateKbps == 850) ? DWT_BR_850K : DWT_BR_6M8;
+        sfd = (profile->nsSFD && (profile->rateKbps == 850)) ? 16 : 8;
+    }
+    config->prf = profile->prf64 ? DWT_PRF_64M : DWT_PRF_16M;
+    config->nsSFD = profile->nsSFD;
+    config->phrMode = DWT_PHRMODE_STD;
+    // Preamble length + 1 + SFD length - PAC size
+    config->sfdTO = (uint16_t)(profile->preamble + 1 + sfd - profile->pac);
+}
+
+// Profile of the rate and preamble of config, TDOA_PHY_UNKNOWN for none of the table
+static inline uint8_t tdoa_phy_of(const dwt_config_t *config)
+{
+    uint8_t p;
+
+    for (p = 0; p < TDOA_PHY_PROFILES; p++)
+    {
+        dwt_config_t c = *config;
+        tdoa_phy_config(p, &c);
+        if ((c.dataRate == config->dataRate) && (c.txPreambLength == config->txPreambLength) && (c.prf == config->prf))
+        {
+            return p;
+        }
+    }
+    return TDOA_PHY_UNKNOWN;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1374 @@
+/*************************************************
+ *
+ *  TDOA serial protocol between the tag firmware and the ROS nodes.
+ *  Header-only, compiles as C99 (TREK_TAG) and C++11 (decawave package).
+ *
+ *  Frame layout, TDOA_FRAME_SIZE bytes:
+ *      [0]    TDOA_FRAME_SYNC
+ *      [1]    reference anchor Ar
+ *      [2]    anchor An
+ *      [3-6]  distance difference, IEEE-754 float, big-endian
+ *      [7-8]  Fletcher-16 checksum of bytes 0-6, high byte first
+ *
+ *  Raw timestamp frame, TDOA_RAW_FRAME_SIZE bytes, sent instead in the raw mode
+ *  of the tag so the host solves the clock model (all fields big-endian):
+ *      [0]     TDOA_RAW_FRAME_SYNC
+ *      [1]     previous anchor Ar
+ *      [2]     anchor An that sent the packet
+ *      [3]     packet index of An
+ *      [4-8]   arrival of the packet at the tag, 40-bit tag clock
+ *      [9-12]  transmit time of An, anchor clock
+ *      [13-16] arrival of the last packet of Ar at An, anchor clock
+ *      [17-18] time of flight Ar to An, anchor clock
+ *      [19-20] Fletcher-16 checksum of bytes 0-18
+ *
+ *  Status frame, TDOA_STATUS_FRAME_SIZE bytes, sent by the tag when one of its
+ *  loss counters changed (counters big-endian, totals since power-up):
+ *      [0]     TDOA_STATUS_FRAME_SYNC
+ *      [1-4]   received frames dropped because the receive ring was full
+ *      [5-8]   measurements dropped because the USB output queue was full
+ *      [9-10]  Fletcher-16 checksum of bytes 0-8
+ *
+ *  Batch frame, TDOA_BATCH_FRAME_SIZE(count) bytes, carries all distance
+ *  differences the tag measured since its previous USB IN transfer:
+ *      [0]     TDOA_BATCH_FRAME_SYNC
+ *      [1]     batch sequence number, incremented per batch
+ *      [2]     record count, 1 to TDOA_BATCH_MAX_RECORDS
+ *      [3-]    count records of 6 bytes: Ar, An, distance difference (float, big-endian)
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Version 2 frame, TDOA_V2_FRAME_SIZE(count) bytes, a batch whose records also
+ *  carry when and how each packet of An was received:
+ *      [0]     TDOA_V2_FRAME_SYNC
+ *      [1]     protocol version, TDOA_PROTOCOL_VERSION
+ *      [2]     batch sequence number
+ *      [3]     record count, 1 to TDOA_BATCH_MAX_RECORDS
+ *      [4-8]   tag clock when the batch was handed to the USB, 40 bits (version 3
+ *              on, version 2 frames have no such field and start the records here)
+ *      [9-]    count records of 15 bytes (14 up to version 3):
+ *                  [0]     Ar
+ *                  [1]     An
+ *                  [2]     packet index of An
+ *                  [3-7]   arrival of the packet of An, 40-bit tag clock
+ *                  [8-11]  distance difference, float
+ *                  [12]    RX power of the packet, -0.5 dBm steps
+ *                  [13]    TDOA_QUALITY_* bits
+ *                  [14]    variance of the distance difference estimated by the
+ *                          tag, tdoa_encode_variance (version 4 on)
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Telemetry frame, TDOA_TELEMETRY_FRAME_SIZE(anchors) bytes, sent by the tag
+ *  every few hundred ms (all fields big-endian, counters totals since
+ *  power-up unless noted):
+ *      [0]     TDOA_TELEMETRY_FRAME_SYNC
+ *      [1]     anchors, 0 to TDOA_MAX_ANCHORS
+ *      [2-3]   period the per-period fields cover, ms
+ *      [4-7]   frames received with a good CRC (DW1000 event counter)
+ *      [8-11]  receive timeouts: preamble, SFD and frame wait
+ *      [12-15] receive errors: PHY header, sync loss and bad CRC
+ *      [16-19] frames dropped because the receive ring was full
+ *      [20-23] DW1000 receive buffer overruns
+ *      [24-27] distance differences rejected without a clock ratio of An
+ *      [28-31] shortest DW1000 interrupt of the period, CPU cycles
+ *      [32-35] longest DW1000 interrupt of the period, CPU cycles
+ *      [36-39] distance differences dropped as NLOS (TDOA_QUALITY_NLOS)
+ *      [40]    PHY profile the tag receives on (common/tdoa_phy.h), TDOA_PHY_UNKNOWN while it scans
+ *      [41-]   anchors times 4 bytes, per anchor over the period:
+ *                  [0-1]   packets
+ *                  [2]     mean receive power in -0.5 dBm steps, 0 without a measurement
+ *                  [3]     mean first path power minus receive power, signed, 0.25 dB steps
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Trace frame, TDOA_TRACE_FRAME_SIZE(count) bytes, only sent by firmware
+ *  built with TDOA_TRACE (common/tdoa_trace.h):
+ *      [0]     TDOA_TRACE_FRAME_SYNC
+ *      [1]     count, 1 to TDOA_TRACE_FRAME_MAX_SAMPLES
+ *      [2]     samples lost to a full trace buffer since the last frame, saturates at 255
+ *      [3-]    count times 4 bytes, big-endian: probe in the top byte, CPU
+ *              cycles from entry to exit in the low 24 bits
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Position frame, TDOA_POSITION_FRAME_SIZE bytes, sent instead of the
+ *  measurements by a tag running its own filter (TAG_EKF), once per TDMA
+ *  frame. Floats are IEEE-754, big-endian:
+ *      [0]     TDOA_POSITION_FRAME_SYNC
+ *      [1]     sequence number
+ *      [2]     measurements applied since the previous frame
+ *      [3-7]   arrival of the last of them, 40-bit tag clock
+ *      [8-19]  position x, y, z, m
+ *      [20-31] velocity x, y, z, m/s
+ *      [32-43] position variance x, y, z, m^2
+ *      [44-45] Fletcher-16 checksum of all previous bytes
+ *
+ *  Ranges frame, TDOA_RANGES_FRAME_SIZE(count) bytes, the inter-anchor times of
+ *  flight one range packet of An carried, for the anchor survey. Sent for
+ *  every few packets of each anchor:
+ *      [0]     TDOA_RANGES_FRAME_SYNC
+ *      [1]     anchor An, cell-qualified (TDOA_CELL_ID)
+ *      [2]     anchors in the TDMA schedule of the packet
+ *      [3]     count, 1 to TDOA_MAX_ANCHORS-1
+ *      [4-]    count times 3 bytes: anchor Ar (cell-qualified), time of flight
+ *              Ar to An measured by An, 16 bits big-endian, anchor clock ticks
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Sync frame, TDOA_SYNC_FRAME_SIZE bytes, the tag clock at a USB start of
+ *  frame. The tag stamps it in the SOF interrupt that starts the IN transfer
+ *  carrying it, so the host reads it one USB frame later plus its own
+ *  latency. Sent every USB_SYNC_MS:
+ *      [0]     TDOA_SYNC_FRAME_SYNC
+ *      [1]     sequence number
+ *      [2-6]   DW1000 system time at the SOF, 40-bit tag clock, big-endian
+ *      [7-8]   Fletcher-16 checksum of bytes 0-6
+ *
+ *  Configuration frames, host to tag. Bytes 2-3 hold the frame size, little
+ *  endian, as the DecaRanging USB commands, which is how the USB receive path
+ *  of the tag finds their end:
+ *      Anchor frame, TDOA_ANCHOR_FRAME_SIZE(count) bytes, positions of the
+ *      anchors of one cell:
+ *      [0]     TDOA_ANCHOR_FRAME_SYNC
+ *      [1]     count, 1 to TDOA_MAX_ANCHORS
+ *      [2-3]   frame size
+ *      [4]     cell
+ *      [5-]    count times x, y, z, floats big-endian, m
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *      Model frame, TDOA_MODEL_FRAME_SIZE bytes, motion model of the filter:
+ *      [0]     TDOA_MODEL_FRAME_SYNC
+ *      [1]     0
+ *      [2-3]   frame size
+ *      [4-27]  transition matrix diagonal, 6 floats
+ *      [28-51] initial covariance diagonal, 6 floats
+ *      [52-75] process noise diagonal per TDOA_MODEL_NOISE_STEP_MS, 6 floats
+ *      [76-79] TDOA measurement standard deviation, m
+ *      [80-81] Fletcher-16 checksum of all previous bytes
+ *
+ *      Capture frame, TDOA_CAPTURE_FRAME_SIZE bytes, controls the flash
+ *      capture of the tag (common/tdoa_flash_capture.h):
+ *      [0]     TDOA_CAPTURE_FRAME_SYNC
+ *      [1]     TDOA_CAPTURE_* action
+ *      [2-3]   frame size
+ *      [4-5]   Fletcher-16 checksum of all previous bytes
+ *
+ *      Output frame, TDOA_OUTPUT_FRAME_SIZE bytes, which distance
+ *      differences the tag sends (tag_output.h), kept until the next one:
+ *      [0]     TDOA_OUTPUT_FRAME_SYNC
+ *      [1]     TDOA_OUTPUT_* mode
+ *      [2-3]   frame size
+ *      [4]     packets per pair: averaged or decimated over, or at most
+ *              without a measurement in the change mode (0 for no limit)
+ *      [5-8]   change a pair needs to be sent again, float big-endian, m
+ *      [9-10]  Fletcher-16 checksum of all previous bytes
+ *
+ *  Anchor telemetry frame, TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(anchors) bytes,
+ *  sent by an anchor (TREK_TDOA) over USART2 every ANCHOR_TELEMETRY_MS. All
+ *  fields big-endian, counters totals since power-up unless noted:
+ *      [0]     TDOA_ANCHOR_TELEMETRY_FRAME_SYNC
+ *      [1]     anchor, cell-qualified (TDOA_CELL_ID)
+ *      [2]     anchors of its schedule, 0 to TDOA_MAX_ANCHORS
+ *      [3-4]   period the per-period fields cover, ms
+ *      [5]     TDOA_ANCHOR_STATE_*
+ *      [6-7]   anchors with a slot in the current frame, bit k for anchor k
+ *      [8-11]  slot receptions with a good CRC
+ *      [12-15] slot receive timeouts, slots nobody transmitted in
+ *      [16-19] slot receive errors
+ *      [20-23] range packets sent
+ *      [24-27] delayed transmits that were late, the slot was lost
+ *      [28-31] delayed receives that were late, opened immediately
+ *      [32-35] master packets missed while synchronized
+ *      [36-39] holdovers that ran out
+ *      [40-43] schedule joins
+ *      [44-47] receiver restarts of the watchdog
+ *      [48-51] masters dropped from slot 0
+ *      [52-55] changes of the TDMA state
+ *      [56-59] shortest DW1000 interrupt of the period, CPU cycles
+ *      [60-63] longest DW1000 interrupt of the period, CPU cycles
+ *      [64-]   anchors times 2 bytes, filtered time of flight to anchor k,
+ *              DW1000 ticks, 0 without one
+ *      [last 2] Fletcher-16 checksum of all previous bytes
+ *
+ *  Changelog:
+ *      v0.17 - Output frame selecting averaged, decimated or change-driven distance differences
+ *      v0.16 - Anchor telemetry frame with the TDMA counters and times of flight
+ *      v0.15 - Version 4 of the batch frame with the measurement variance of the tag
+ *      v0.14 - Capture frame for the flash capture of the tag
+ *      v0.13 - NLOS quality bits, telemetry counter of the distance differences dropped as NLOS
+ *      v0.12 - Telemetry frame with the PHY profile and the receive and first path power per anchor
+ *      v0.11 - Sync frame with the tag clock at a USB start of frame
+ *      v0.10 - Ranges frame with the inter-anchor times of flight
+ *      v0.9 - Version 3 of the batch frame with the send time of the tag
+ *      v0.8 - Position frame of the on-tag filter, anchor and model configuration frames
+ *      v0.7 - Trace frame with the cycle counts of the firmware probes
+ *      v0.6 - Telemetry frame with receive counters, interrupt cycles and per anchor packets
+ *      v0.5 - Version 2 frame with tag timestamps, packet index and RX quality
+ *      v0.4 - Batch frame with several distance differences
+ *      v0.3 - Status frame with the tag loss counters
+ *      v0.2 - Raw timestamp frame
+ *      v0.1 - initial release, shared by TREK_TAG and decawave
+ *
+ *************************************************/
+
+#ifndef _TDOA_PROTOCOL_H_
+#define _TDOA_PROTOCOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "tdoa_tdma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_FRAME_SYNC         0xAA
+
+#define TDOA_FRAME_TYPE_BYTE    0
+#define TDOA_FRAME_ANCR_BYTE    1
+#define TDOA_FRAME_ANCN_BYTE    2
+#define TDOA_FRAME_DATA_BYTE    3
+#define TDOA_FRAME_CS_BYTE      7
+#define TDOA_FRAME_SIZE         9
+
+#define TDOA_RAW_FRAME_SYNC         0xAB
+#define TDOA_RAW_FRAME_IDX_BYTE     3
+#define TDOA_RAW_FRAME_RX_BYTE      4
+#define TDOA_RAW_FRAME_TX_BYTE      9
+#define TDOA_RAW_FRAME_RXAR_BYTE    13
+#define TDOA_RAW_FRAME_TOF_BYTE     17
+#define TDOA_RAW_FRAME_CS_BYTE      19
+#define TDOA_RAW_FRAME_SIZE         21
+
+#define TDOA_STATUS_FRAME_SYNC          0xAC
+#define TDOA_STATUS_FRAME_RXDROP_BYTE   1
+#define TDOA_STATUS_FRAME_OUTDROP_BYTE  5
+#define TDOA_STATUS_FRAME_CS_BYTE       9
+#define TDOA_STATUS_FRAME_SIZE          11
+
+#define TDOA_BATCH_FRAME_SYNC       0xAD
+#define TDOA_BATCH_FRAME_SEQ_BYTE   1
+#define TDOA_BATCH_FRAME_COUNT_BYTE 2
+#define TDOA_BATCH_FRAME_DATA_BYTE  3
+#define TDOA_BATCH_RECORD_SIZE      6
+#define TDOA_BATCH_MAX_RECORDS      8       // One anchor rotation, the largest frame fits a 64-byte USB packet
+#define TDOA_BATCH_FRAME_SIZE(count) (TDOA_BATCH_FRAME_DATA_BYTE + (count)*TDOA_BATCH_RECORD_SIZE + 2)
+#define TDOA_BATCH_FRAME_MAX_SIZE   TDOA_BATCH_FRAME_SIZE(TDOA_BATCH_MAX_RECORDS)
+
+#define TDOA_PROTOCOL_VERSION       4
+#define TDOA_V2_FRAME_SYNC          0xAE
+#define TDOA_V2_FRAME_VERSION_BYTE  1
+#define TDOA_V2_FRAME_SEQ_BYTE      2
+#define TDOA_V2_FRAME_COUNT_BYTE    3
+#define TDOA_V2_FRAME_SEND_BYTE     4
+#define TDOA_V2_FRAME_DATA_BYTE     9
+#define TDOA_V2_FRAME_DATA_BYTE_V2  4       // Version 2 frames, still decoded
+#define TDOA_V2_RECORD_SIZE         15
+#define TDOA_V2_RECORD_SIZE_V3      14      // Version 2 and 3 frames, still decoded
+#define TDOA_V2_FRAME_SIZE(count)   (TDOA_V2_FRAME_DATA_BYTE + (count)*TDOA_V2_RECORD_SIZE + 2)
+#define TDOA_V2_FRAME_MAX_SIZE      TDOA_V2_FRAME_SIZE(TDOA_BATCH_MAX_RECORDS)
+
+#define TDOA_TELEMETRY_FRAME_SYNC           0xAF
+#define TDOA_TELEMETRY_FRAME_ANCHORS_BYTE   1
+#define TDOA_TELEMETRY_FRAME_PERIOD_BYTE    2
+#define TDOA_TELEMETRY_FRAME_COUNTERS_BYTE  4
+#define TDOA_TELEMETRY_COUNTERS             9
+#define TDOA_TELEMETRY_FRAME_PROFILE_BYTE  (TDOA_TELEMETRY_FRAME_COUNTERS_BYTE + 4*TDOA_TELEMETRY_COUNTERS)
+#define TDOA_TELEMETRY_FRAME_DATA_BYTE      (TDOA_TELEMETRY_FRAME_PROFILE_BYTE + 1)
+#define TDOA_TELEMETRY_ANCHOR_SIZE          4
+#define TDOA_TELEMETRY_FRAME_SIZE(anchors)  (TDOA_TELEMETRY_FRAME_DATA_BYTE + TDOA_TELEMETRY_ANCHOR_SIZE*(anchors) + 2)
+#define TDOA_TELEMETRY_NO_POWER             INT16_MIN   // anchorPower without a measurement, as TDOA_RX_POWER_INVALID
+#define TDOA_TELEMETRY_FRAME_MAX_SIZE       TDOA_TELEMETRY_FRAME_SIZE(TDOA_MAX_ANCHORS)
+
+#define TDOA_ANCHOR_TELEMETRY_FRAME_SYNC          0xB7
+#define TDOA_ANCHOR_TELEMETRY_FRAME_ANCHOR_BYTE   1
+#define TDOA_ANCHOR_TELEMETRY_FRAME_ANCHORS_BYTE  2
+#define TDOA_ANCHOR_TELEMETRY_FRAME_PERIOD_BYTE   3
+#define TDOA_ANCHOR_TELEMETRY_FRAME_STATE_BYTE    5
+#define TDOA_ANCHOR_TELEMETRY_FRAME_ACTIVE_BYTE   6
+#define TDOA_ANCHOR_TELEMETRY_FRAME_COUNTERS_BYTE 8
+#define TDOA_ANCHOR_TELEMETRY_COUNTERS            14
+#define TDOA_ANCHOR_TELEMETRY_FRAME_DATA_BYTE     (TDOA_ANCHOR_TELEMETRY_FRAME_COUNTERS_BYTE + 4*TDOA_ANCHOR_TELEMETRY_COUNTERS)
+#define TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(anchors) (TDOA_ANCHOR_TELEMETRY_FRAME_DATA_BYTE + 2*(anchors) + 2)
+#define TDOA_ANCHOR_TELEMETRY_FRAME_MAX_SIZE      TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(TDOA_MAX_ANCHORS)
+
+#define TDOA_ANCHOR_STATE_LISTEN        0       // Unsynchronized, waiting for a schedule to join or to start one
+#define TDOA_ANCHOR_STATE_SYNC          1
+#define TDOA_ANCHOR_STATE_SYNCHRONIZED  2       // In the TDMA, with a slot or waiting for the join slot
+
+#define TDOA_TRACE_FRAME_SYNC           0xB0
+#define TDOA_TRACE_FRAME_COUNT_BYTE     1
+#define TDOA_TRACE_FRAME_LOST_BYTE      2
+#define TDOA_TRACE_FRAME_DATA_BYTE      3
+#define TDOA_TRACE_SAMPLE_SIZE          4
+#define TDOA_TRACE_FRAME_MAX_SAMPLES    24
+#define TDOA_TRACE_FRAME_SIZE(count)    (TDOA_TRACE_FRAME_DATA_BYTE + (count)*TDOA_TRACE_SAMPLE_SIZE + 2)
+#define TDOA_TRACE_FRAME_MAX_SIZE       TDOA_TRACE_FRAME_SIZE(TDOA_TRACE_FRAME_MAX_SAMPLES)
+#define TDOA_TRACE_SAMPLE(probe, cycles)    (((uint32_t)(probe) << 24) | ((cycles) > 0xFFFFFF ? 0xFFFFFF : (cycles)))
+#define TDOA_TRACE_SAMPLE_PROBE(s)          ((uint8_t)((s) >> 24))
+#define TDOA_TRACE_SAMPLE_CYCLES(s)         ((s) & 0xFFFFFF)
+
+#define TDOA_POSITION_FRAME_SYNC        0xB1
+#define TDOA_POSITION_FRAME_SEQ_BYTE    1
+#define TDOA_POSITION_FRAME_UPDATES_BYTE 2
+#define TDOA_POSITION_FRAME_RX_BYTE     3
+#define TDOA_POSITION_FRAME_POS_BYTE    8
+#define TDOA_POSITION_FRAME_VEL_BYTE    20
+#define TDOA_POSITION_FRAME_VAR_BYTE    32
+#define TDOA_POSITION_FRAME_CS_BYTE     44
+#define TDOA_POSITION_FRAME_SIZE        46
+
+#define TDOA_RANGES_FRAME_SYNC          0xB4
+#define TDOA_RANGES_FRAME_AN_BYTE       1
+#define TDOA_RANGES_FRAME_SLOTS_BYTE    2
+#define TDOA_RANGES_FRAME_COUNT_BYTE    3
+#define TDOA_RANGES_FRAME_DATA_BYTE     4
+#define TDOA_RANGES_FRAME_SIZE(count)   (TDOA_RANGES_FRAME_DATA_BYTE + (count)*3 + 2)
+#define TDOA_RANGES_FRAME_MAX_SIZE      TDOA_RANGES_FRAME_SIZE(TDOA_MAX_ANCHORS - 1)
+
+#define TDOA_SYNC_FRAME_SYNC            0xB5
+#define TDOA_SYNC_FRAME_SEQ_BYTE        1
+#define TDOA_SYNC_FRAME_TIME_BYTE       2
+#define TDOA_SYNC_FRAME_CS_BYTE         7
+#define TDOA_SYNC_FRAME_SIZE            9
+
+#define TDOA_CONFIG_FRAME_SIZE_BYTE     2       // Little endian, see the configuration frames above
+
+#define TDOA_ANCHOR_FRAME_SYNC          0xB2
+#define TDOA_ANCHOR_FRAME_COUNT_BYTE    1
+#define TDOA_ANCHOR_FRAME_CELL_BYTE     4
+#define TDOA_ANCHOR_FRAME_DATA_BYTE     5
+#define TDOA_ANCHOR_FRAME_SIZE(count)   (TDOA_ANCHOR_FRAME_DATA_BYTE + (count)*12 + 2)
+#define TDOA_ANCHOR_FRAME_MAX_SIZE      TDOA_ANCHOR_FRAME_SIZE(TDOA_MAX_ANCHORS)
+
+#define TDOA_MODEL_FRAME_SYNC           0xB3
+#define TDOA_MODEL_STATES               6       // x, y, z, vx, vy, vz as STATE_* of the host filter
+#define TDOA_MODEL_FRAME_DATA_BYTE      4
+#define TDOA_MODEL_FRAME_CS_BYTE        (TDOA_MODEL_FRAME_DATA_BYTE + 4*(3*TDOA_MODEL_STATES + 1))
+#define TDOA_MODEL_FRAME_SIZE           (TDOA_MODEL_FRAME_CS_BYTE + 2)
+#define TDOA_MODEL_NOISE_STEP_MS        10      // Time step of the process noise, PROCESS_NOISE_STEP of the host
+
+#define TDOA_CAPTURE_FRAME_SYNC         0xB6
+#define TDOA_CAPTURE_FRAME_ACTION_BYTE  1
+#define TDOA_CAPTURE_FRAME_SIZE         6
+
+#define TDOA_OUTPUT_FRAME_SYNC          0xB8
+#define TDOA_OUTPUT_FRAME_MODE_BYTE     1
+#define TDOA_OUTPUT_FRAME_PACKETS_BYTE  4
+#define TDOA_OUTPUT_FRAME_THRESHOLD_BYTE 5
+#define TDOA_OUTPUT_FRAME_SIZE          11
+
+// Actions of the capture frame
+#define TDOA_CAPTURE_START      1       // Erase the capture and record from now on
+#define TDOA_CAPTURE_STOP       2       // Stop recording, the records stay
+#define TDOA_CAPTURE_EXPORT     3       // Stop and restart as a USB mass storage device holding the capture
+
+// Modes of the output frame
+#define TDOA_OUTPUT_ALL         0       // Every distance difference
+#define TDOA_OUTPUT_AVERAGE     1       // The mean of every packets of a pair, with the variance of the mean
+#define TDOA_OUTPUT_DECIMATE    2       // Every packets-th distance difference of a pair
+#define TDOA_OUTPUT_CHANGE      3       // A pair once it moved by threshold since it was last sent
+#define TDOA_OUTPUT_MODES       4
+
+// Which optional fields of tdoa_frame_t are set
+#define TDOA_FRAME_HAS_TIME     0x01    // idx and rxTime
+#define TDOA_FRAME_HAS_QUALITY  0x02    // rxPower and quality
+#define TDOA_FRAME_HAS_SEND     0x04    // sendTime
+#define TDOA_FRAME_HAS_VARIANCE 0x08    // variance
+
+// Quality bits of a version 2 record
+#define TDOA_QUALITY_LOW_POWER      0x01    // Below the range bias table (-95 dBm), arrival not corrected
+#define TDOA_QUALITY_HIGH_POWER     0x02    // Above the range bias table (-61 dBm), correction saturated
+#define TDOA_QUALITY_CLOCK_SETTLED  0x04    // Clock ratio of An fitted over a full filter window
+#define TDOA_QUALITY_ANCHOR_SKIPPED 0x08    // The anchor received before An is not the one right before it, a packet was missed
+#define TDOA_QUALITY_NLOS_SUSPECT   0x10    // First path attenuated, receive above first path power by TDOA_NLOS_SUSPECT
+#define TDOA_QUALITY_NLOS           0x20    // First path blocked, above by TDOA_NLOS_LIKELY, the tag may drop these
+
+// Variance byte of a version 4 record, see tdoa_encode_variance
+#define TDOA_VARIANCE_NONE          0       // The tag did not estimate one
+#define TDOA_VARIANCE_MIN_EXP       (-12)   // Code 1 is 2^-12 m^2, (16 mm)^2
+
+typedef struct tdoa_frame_s
+{
+    uint8_t Ar;
+    uint8_t An;
+    float   distanceDiff;
+    uint8_t flags;          // TDOA_FRAME_HAS_* bits, the fields below are only valid when set
+    uint8_t idx;            // Packet index of An
+    uint64_t rxTime;        // Arrival of the packet of An, 40-bit tag clock
+    float   rxPower;        // dBm
+    uint8_t quality;        // TDOA_QUALITY_* bits
+    uint64_t sendTime;      // Tag clock when the batch of the record was handed to the USB, 40 bits
+    float   variance;       // m^2, of distanceDiff as estimated by the tag
+}tdoa_frame_t;
+
+typedef struct tdoa_raw_frame_s
+{
+    uint8_t  Ar;
+    uint8_t  An;
+    uint8_t  idx;
+    uint64_t rxAn_by_T;     // 40 bits
+    uint32_t txAn;
+    uint32_t rxAr_by_An;
+    uint16_t tofAr_to_An;
+}tdoa_raw_frame_t;
+
+typedef struct tdoa_status_s
+{
+    uint32_t rxDropped;
+    uint32_t outDropped;
+}tdoa_status_t;
+
+// Estimate of the on-tag filter
+typedef struct tdoa_position_s
+{
+    uint8_t  seq;
+    uint8_t  updates;       // Measurements applied since the previous frame
+    uint64_t rxTime;        // Arrival of the last of them, 40-bit tag clock
+    float    pos[3];        // m
+    float    vel[3];        // m/s
+    float    var[3];        // Position variance, m^2
+}tdoa_position_t;
+
+// Tag clock at a USB start of frame
+typedef struct tdoa_sync_s
+{
+    uint8_t  seq;
+    uint64_t sofTime;       // 40-bit tag clock
+}tdoa_sync_t;
+
+// Inter-anchor times of flight of one range packet
+typedef struct tdoa_ranges_s
+{
+    uint8_t  An;                            // Cell-qualified
+    uint8_t  slots;
+    uint8_t  count;
+    uint8_t  Ar[TDOA_MAX_ANCHORS - 1];      // Cell-qualified
+    uint16_t tof[TDOA_MAX_ANCHORS - 1];     // Ar to An, anchor clock ticks
+}tdoa_ranges_t;
+
+typedef struct tdoa_anchor_config_s
+{
+    uint8_t cell;
+    uint8_t count;
+    float   pos[TDOA_MAX_ANCHORS][3];   // m, anchor k of the cell in row k
+}tdoa_anchor_config_t;
+
+// Diagonal motion model, the velocity entries of transition also scale the position step
+typedef struct tdoa_model_config_s
+{
+    float transition[TDOA_MODEL_STATES];
+    float covariance[TDOA_MODEL_STATES];    // Initial state covariance
+    float noise[TDOA_MODEL_STATES];         // Process noise per TDOA_MODEL_NOISE_STEP_MS
+    float stdDev;                           // m
+}tdoa_model_config_t;
+
+// Distance differences the tag sends, see the output frame
+typedef struct tdoa_output_config_s
+{
+    uint8_t mode;                           // TDOA_OUTPUT_*
+    uint8_t packets;
+    float   threshold;                      // m, TDOA_OUTPUT_CHANGE
+}tdoa_output_config_t;
+
+// Counters in the order of the telemetry frame
+typedef struct tdoa_telemetry_s
+{
+    uint8_t  anchors;
+    uint16_t periodMs;
+    uint32_t rxGood;
+    uint32_t rxTimeouts;
+    uint32_t rxErrors;
+    uint32_t ringDrops;
+    uint32_t rxOverruns;
+    uint32_t clockRejects;
+    uint32_t isrMinCycles;
+    uint32_t isrMaxCycles;
+    uint32_t nlosDrops;
+    uint8_t  profile;                           // TDOA_PHY_*
+    uint16_t anchorPackets[TDOA_MAX_ANCHORS];
+    int16_t  anchorPower[TDOA_MAX_ANCHORS];     // 1/64 dBm, mean receive power, TDOA_TELEMETRY_NO_POWER without
+    int16_t  anchorFpRatio[TDOA_MAX_ANCHORS];   // 1/64 dB, mean first path power minus receive power
+}tdoa_telemetry_t;
+
+// Counters in the order of the anchor telemetry frame
+typedef struct tdoa_anchor_telemetry_s
+{
+    uint8_t  anchor;                            // TDOA_CELL_ID
+    uint8_t  anchors;
+    uint16_t periodMs;
+    uint8_t  state;                             // TDOA_ANCHOR_STATE_*
+    uint16_t active;
+    uint32_t rxGood;
+    uint32_t rxTimeouts;
+    uint32_t rxErrors;
+    uint32_t txGood;
+    uint32_t lateTx;
+    uint32_t lateRx;
+    uint32_t syncMissed;
+    uint32_t syncLost;
+    uint32_t resyncs;
+    uint32_t watchdogResets;
+    uint32_t failovers;
+    uint32_t stateChanges;
+    uint32_t isrMinCycles;
+    uint32_t isrMaxCycles;
+    uint16_t tof[TDOA_MAX_ANCHORS];             // Ticks, 0 without one
+}tdoa_anchor_telemetry_t;
+
+typedef struct tdoa_batch_s
+{
+    uint8_t seq;
+    uint8_t count;
+    uint64_t sendTime;      // Version 3 frames, see tdoa_frame_t
+    tdoa_frame_t frames[TDOA_BATCH_MAX_RECORDS];
+}tdoa_batch_t;
+
+/*
+ * Fletcher-16, same result as the original mod-255 loop. Up to 21 bytes the
+ * sums cannot overflow 16 bits, so a frame needs no reduction inside the
+ * loop and the two folding steps at the end are the only ones.
+ */
+static inline uint16_t tdoa_fletcher16(const uint8_t *data, size_t len)
+{
+    uint16_t sum1 = 0xff, sum2 = 0xff;
+
+    while (len) {
+        size_t tlen = len > 21 ? 21 : len;
+        len -= tlen;
+        do {
+            sum1 += *data++;
+            sum2 += sum1;
+        } while (--tlen);
+        sum1 = (sum1 & 0xff) + (sum1 >> 8);
+        sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    }
+    /* Second reduction step to reduce sums to 16 bits */
+    sum1 = (sum1 & 0xff) + (sum1 >> 8);
+    sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    return (uint16_t)(sum2 << 8 | sum1);
+}
+
+// Checksum of the fixed 7-byte frame header, fully unrolled
+static inline uint16_t tdoa_frame_checksum(const uint8_t *msg)
+{
+    uint16_t sum1 = 0xff + msg[0];
+    uint16_t sum2 = 0xff + sum1;
+    sum1 += msg[1]; sum2 += sum1;
+    sum1 += msg[2]; sum2 += sum1;
+    sum1 += msg[3]; sum2 += sum1;
+    sum1 += msg[4]; sum2 += sum1;
+    sum1 += msg[5]; sum2 += sum1;
+    sum1 += msg[6]; sum2 += sum1;
+
+    sum1 = (sum1 & 0xff) + (sum1 >> 8);
+    sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    sum1 = (sum1 & 0xff) + (sum1 >> 8);
+    sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    return (uint16_t)(sum2 << 8 | sum1);
+}
+
+static inline void tdoa_frame_encode(uint8_t *msg, uint8_t Ar, uint8_t An, float distanceDiff)
+{
+    uint32_t word;
+    memcpy(&word, &distanceDiff, sizeof(word));
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_FRAME_SYNC;
+    msg[TDOA_FRAME_ANCR_BYTE] = Ar;
+    msg[TDOA_FRAME_ANCN_BYTE] = An;
+    msg[TDOA_FRAME_DATA_BYTE]   = (uint8_t)(word >> 24);
+    msg[TDOA_FRAME_DATA_BYTE+1] = (uint8_t)(word >> 16);
+    msg[TDOA_FRAME_DATA_BYTE+2] = (uint8_t)(word >> 8);
+    msg[TDOA_FRAME_DATA_BYTE+3] = (uint8_t)(word);
+
+    uint16_t cs = tdoa_frame_checksum(msg);
+    msg[TDOA_FRAME_CS_BYTE]   = (uint8_t)(cs >> 8);
+    msg[TDOA_FRAME_CS_BYTE+1] = (uint8_t)(cs);
+}
+
+/*
+ * Decodes one frame starting at msg. Always fills frame and returns nonzero
+ * only if the sync byte and checksum match, so the caller branches once.
+ */
+static inline int tdoa_frame_decode(const uint8_t *msg, tdoa_frame_t *frame)
+{
+    uint32_t word = ((uint32_t)msg[TDOA_FRAME_DATA_BYTE] << 24) | ((uint32_t)msg[TDOA_FRAME_DATA_BYTE+1] << 16)
+                  | ((uint32_t)msg[TDOA_FRAME_DATA_BYTE+2] << 8) | (uint32_t)msg[TDOA_FRAME_DATA_BYTE+3];
+    uint16_t cs = (uint16_t)((msg[TDOA_FRAME_CS_BYTE] << 8) | msg[TDOA_FRAME_CS_BYTE+1]);
+
+    frame->Ar = msg[TDOA_FRAME_ANCR_BYTE];
+    frame->An = msg[TDOA_FRAME_ANCN_BYTE];
+    memcpy(&frame->distanceDiff, &word, sizeof(word));
+    frame->flags = 0;
+
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_FRAME_SYNC) & (cs == tdoa_frame_checksum(msg));
+}
+
+static inline void tdoa_put_be(uint8_t *msg, uint64_t value, int bytes)
+{
+    while (bytes--) {
+        msg[bytes] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+static inline uint64_t tdoa_get_be(const uint8_t *msg, int bytes)
+{
+    uint64_t value = 0;
+    int i;
+    for (i = 0; i < bytes; i++) {
+        value = (value << 8) | msg[i];
+    }
+    return value;
+}
+
+static inline void tdoa_raw_frame_encode(uint8_t *msg, const tdoa_raw_frame_t *raw)
+{
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_RAW_FRAME_SYNC;
+    msg[TDOA_FRAME_ANCR_BYTE] = raw->Ar;
+    msg[TDOA_FRAME_ANCN_BYTE] = raw->An;
+    msg[TDOA_RAW_FRAME_IDX_BYTE] = raw->idx;
+    tdoa_put_be(&msg[TDOA_RAW_FRAME_RX_BYTE], raw->rxAn_by_T, 5);
+    tdoa_put_be(&msg[TDOA_RAW_FRAME_TX_BYTE], raw->txAn, 4);
+    tdoa_put_be(&msg[TDOA_RAW_FRAME_RXAR_BYTE], raw->rxAr_by_An, 4);
+    tdoa_put_be(&msg[TDOA_RAW_FRAME_TOF_BYTE], raw->tofAr_to_An, 2);
+
+    uint16_t cs = tdoa_fletcher16(msg, TDOA_RAW_FRAME_CS_BYTE);
+    msg[TDOA_RAW_FRAME_CS_BYTE]   = (uint8_t)(cs >> 8);
+    msg[TDOA_RAW_FRAME_CS_BYTE+1] = (uint8_t)(cs);
+}
+
+// Same contract as tdoa_frame_decode
+static inline int tdoa_raw_frame_decode(const uint8_t *msg, tdoa_raw_frame_t *raw)
+{
+    uint16_t cs = (uint16_t)((msg[TDOA_RAW_FRAME_CS_BYTE] << 8) | msg[TDOA_RAW_FRAME_CS_BYTE+1]);
+
+    raw->Ar = msg[TDOA_FRAME_ANCR_BYTE];
+    raw->An = msg[TDOA_FRAME_ANCN_BYTE];
+    raw->idx = msg[TDOA_RAW_FRAME_IDX_BYTE];
+    raw->rxAn_by_T = tdoa_get_be(&msg[TDOA_RAW_FRAME_RX_BYTE], 5);
+    raw->txAn = (uint32_t)tdoa_get_be(&msg[TDOA_RAW_FRAME_TX_BYTE], 4);
+    raw->rxAr_by_An = (uint32_t)tdoa_get_be(&msg[TDOA_RAW_FRAME_RXAR_BYTE], 4);
+    raw->tofAr_to_An = (uint16_t)tdoa_get_be(&msg[TDOA_RAW_FRAME_TOF_BYTE], 2);
+
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_RAW_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, TDOA_RAW_FRAME_CS_BYTE));
+}
+
+static inline void tdoa_status_frame_encode(uint8_t *msg, const tdoa_status_t *status)
+{
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_STATUS_FRAME_SYNC;
+    tdoa_put_be(&msg[TDOA_STATUS_FRAME_RXDROP_BYTE], status->rxDropped, 4);
+    tdoa_put_be(&msg[TDOA_STATUS_FRAME_OUTDROP_BYTE], status->outDropped, 4);
+
+    uint16_t cs = tdoa_fletcher16(msg, TDOA_STATUS_FRAME_CS_BYTE);
+    msg[TDOA_STATUS_FRAME_CS_BYTE]   = (uint8_t)(cs >> 8);
+    msg[TDOA_STATUS_FRAME_CS_BYTE+1] = (uint8_t)(cs);
+}
+
+// Same contract as tdoa_frame_decode
+static inline int tdoa_status_frame_decode(const uint8_t *msg, tdoa_status_t *status)
+{
+    uint16_t cs = (uint16_t)((msg[TDOA_STATUS_FRAME_CS_BYTE] << 8) | msg[TDOA_STATUS_FRAME_CS_BYTE+1]);
+
+    status->rxDropped = (uint32_t)tdoa_get_be(&msg[TDOA_STATUS_FRAME_RXDROP_BYTE], 4);
+    status->outDropped = (uint32_t)tdoa_get_be(&msg[TDOA_STATUS_FRAME_OUTDROP_BYTE], 4);
+
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_STATUS_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, TDOA_STATUS_FRAME_CS_BYTE));
+}
+
+// Returns the number of bytes written, TDOA_BATCH_FRAME_SIZE(batch->count)
+static inline size_t tdoa_batch_frame_encode(uint8_t *msg, const tdoa_batch_t *batch)
+{
+    uint8_t *rec = &msg[TDOA_BATCH_FRAME_DATA_BYTE];
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_BATCH_FRAME_SYNC;
+    msg[TDOA_BATCH_FRAME_SEQ_BYTE] = batch->seq;
+    msg[TDOA_BATCH_FRAME_COUNT_BYTE] = batch->count;
+    for (i = 0; i < batch->count; i++) {
+        uint32_t word;
+        memcpy(&word, &batch->frames[i].distanceDiff, sizeof(word));
+        rec[0] = batch->frames[i].Ar;
+        rec[1] = batch->frames[i].An;
+        tdoa_put_be(&rec[2], word, 4);
+        rec += TDOA_BATCH_RECORD_SIZE;
+    }
+
+    const size_t csByte = (size_t)(rec - msg);
+    uint16_t cs = tdoa_fletcher16(msg, csByte);
+    msg[csByte]   = (uint8_t)(cs >> 8);
+    msg[csByte+1] = (uint8_t)(cs);
+    return csByte + 2;
+}
+
+/*
+ * Size of the batch frame starting at msg, read from its count byte (msg needs
+ * TDOA_BATCH_FRAME_DATA_BYTE bytes). 0 if the count is out of range.
+ */
+static inline size_t tdoa_batch_frame_size(const uint8_t *msg)
+{
+    const uint8_t count = msg[TDOA_BATCH_FRAME_COUNT_BYTE];
+    return ((count == 0) || (count > TDOA_BATCH_MAX_RECORDS)) ? 0 : TDOA_BATCH_FRAME_SIZE(count);
+}
+
+// Same contract as tdoa_frame_decode, msg must hold tdoa_batch_frame_size(msg) bytes
+static inline int tdoa_batch_frame_decode(const uint8_t *msg, tdoa_batch_t *batch)
+{
+    const size_t size = tdoa_batch_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    const uint8_t *rec = &msg[TDOA_BATCH_FRAME_DATA_BYTE];
+    uint8_t i;
+
+    batch->seq = msg[TDOA_BATCH_FRAME_SEQ_BYTE];
+    batch->count = msg[TDOA_BATCH_FRAME_COUNT_BYTE];
+    for (i = 0; i < batch->count; i++) {
+        uint32_t word = (uint32_t)tdoa_get_be(&rec[2], 4);
+        batch->frames[i].Ar = rec[0];
+        batch->frames[i].An = rec[1];
+        memcpy(&batch->frames[i].distanceDiff, &word, sizeof(word));
+        batch->frames[i].flags = 0;
+        rec += TDOA_BATCH_RECORD_SIZE;
+    }
+
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_BATCH_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, size - 2));
+}
+
+// RX power in the -0.5 dBm steps of the version 2 record, clamped to 0 to -127.5 dBm
+static inline uint8_t tdoa_encode_rx_power(float dBm)
+{
+    const float steps = -2.0f * dBm + 0.5f;
+    return (steps <= 0.0f) ? 0 : ((steps >= 255.0f) ? 255 : (uint8_t)steps);
+}
+
+/*
+ * Variance in m^2 as the byte of the version 4 record, 16 steps per octave
+ * from 2^TDOA_VARIANCE_MIN_EXP m^2 (code 1) to 15 m^2 (code 255), clamped.
+ * The code is the exponent and the top 4 mantissa bits of the float, so the
+ * tag needs no logarithm. TDOA_VARIANCE_NONE for zero or not a number.
+ */
+static inline uint8_t tdoa_encode_variance(float m2)
+{
+    uint32_t bits;
+    if (!(m2 > 0.0f)) {
+        return TDOA_VARIANCE_NONE;
+    }
+    memcpy(&bits, &m2, sizeof(bits));
+    const int32_t code = (int32_t)(bits >> 19) - ((127 + TDOA_VARIANCE_MIN_EXP) << 4) + 1;
+    return (code < 1) ? 1 : ((code > 255) ? 255 : (uint8_t)code);
+}
+
+// Middle of the step of a tdoa_encode_variance code, 0 for TDOA_VARIANCE_NONE
+static inline float tdoa_decode_variance(uint8_t code)
+{
+    if (code == TDOA_VARIANCE_NONE) {
+        return 0.0f;
+    }
+    const uint32_t bits = ((uint32_t)(code - 1 + ((127 + TDOA_VARIANCE_MIN_EXP) << 4)) << 19) | (1u << 18);
+    float m2;
+    memcpy(&m2, &bits, sizeof(m2));
+    return m2;
+}
+
+// Version 2 batch, every record needs all the optional fields of tdoa_frame_t but the variance
+static inline size_t tdoa_v2_frame_encode(uint8_t *msg, const tdoa_batch_t *batch)
+{
+    uint8_t *rec = &msg[TDOA_V2_FRAME_DATA_BYTE];
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_V2_FRAME_SYNC;
+    msg[TDOA_V2_FRAME_VERSION_BYTE] = TDOA_PROTOCOL_VERSION;
+    msg[TDOA_V2_FRAME_SEQ_BYTE] = batch->seq;
+    msg[TDOA_V2_FRAME_COUNT_BYTE] = batch->count;
+    tdoa_put_be(&msg[TDOA_V2_FRAME_SEND_BYTE], batch->sendTime, 5);
+    for (i = 0; i < batch->count; i++) {
+        const tdoa_frame_t *f = &batch->frames[i];
+        uint32_t word;
+        memcpy(&word, &f->distanceDiff, sizeof(word));
+        rec[0] = f->Ar;
+        rec[1] = f->An;
+        rec[2] = f->idx;
+        tdoa_put_be(&rec[3], f->rxTime, 5);
+        tdoa_put_be(&rec[8], word, 4);
+        rec[12] = tdoa_encode_rx_power(f->rxPower);
+        rec[13] = f->quality;
+        rec[14] = (f->flags & TDOA_FRAME_HAS_VARIANCE) ? tdoa_encode_variance(f->variance) : TDOA_VARIANCE_NONE;
+        rec += TDOA_V2_RECORD_SIZE;
+    }
+
+    const size_t csByte = (size_t)(rec - msg);
+    uint16_t cs = tdoa_fletcher16(msg, csByte);
+    msg[csByte]   = (uint8_t)(cs >> 8);
+    msg[csByte+1] = (uint8_t)(cs);
+    return csByte + 2;
+}
+
+// First record of a version 2 to 4 frame, 0 for a version this decoder does not know
+static inline size_t tdoa_v2_frame_data_byte(const uint8_t *msg)
+{
+    switch (msg[TDOA_V2_FRAME_VERSION_BYTE]) {
+    case 2:
+        return TDOA_V2_FRAME_DATA_BYTE_V2;
+    case 3:
+    case TDOA_PROTOCOL_VERSION:
+        return TDOA_V2_FRAME_DATA_BYTE;
+    default:
+        return 0;
+    }
+}
+
+// Record size of a frame tdoa_v2_frame_data_byte knows
+static inline size_t tdoa_v2_record_size(const uint8_t *msg)
+{
+    return (msg[TDOA_V2_FRAME_VERSION_BYTE] < 4) ? TDOA_V2_RECORD_SIZE_V3 : TDOA_V2_RECORD_SIZE;
+}
+
+// Same as tdoa_batch_frame_size, 0 also for a version this decoder does not know
+static inline size_t tdoa_v2_frame_size(const uint8_t *msg)
+{
+    const uint8_t count = msg[TDOA_V2_FRAME_COUNT_BYTE];
+    const size_t data = tdoa_v2_frame_data_byte(msg);
+    if ((data == 0) || (count == 0) || (count > TDOA_BATCH_MAX_RECORDS)) {
+        return 0;
+    }
+    return data + (size_t)count*tdoa_v2_record_size(msg) + 2;
+}
+
+// Same contract as tdoa_batch_frame_decode
+static inline int tdoa_v2_frame_decode(const uint8_t *msg, tdoa_batch_t *batch)
+{
+    const size_t size = tdoa_v2_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    const uint8_t *rec = &msg[tdoa_v2_frame_data_byte(msg)];
+    const uint8_t hasSend = (rec != &msg[TDOA_V2_FRAME_DATA_BYTE_V2]);
+    const size_t recSize = tdoa_v2_record_size(msg);
+    uint8_t i;
+
+    batch->seq = msg[TDOA_V2_FRAME_SEQ_BYTE];
+    batch->count = msg[TDOA_V2_FRAME_COUNT_BYTE];
+    batch->sendTime = hasSend ? tdoa_get_be(&msg[TDOA_V2_FRAME_SEND_BYTE], 5) : 0;
+    for (i = 0; i < batch->count; i++) {
+        tdoa_frame_t *f = &batch->frames[i];
+        uint32_t word = (uint32_t)tdoa_get_be(&rec[8], 4);
+        f->Ar = rec[0];
+        f->An = rec[1];
+        f->idx = rec[2];
+        f->rxTime = tdoa_get_be(&rec[3], 5);
+        memcpy(&f->distanceDiff, &word, sizeof(word));
+        f->rxPower = -0.5f * rec[12];
+        f->quality = rec[13];
+        f->sendTime = batch->sendTime;
+        f->variance = (recSize > TDOA_V2_RECORD_SIZE_V3) ? tdoa_decode_variance(rec[14]) : 0.0f;
+        f->flags = TDOA_FRAME_HAS_TIME | TDOA_FRAME_HAS_QUALITY | (hasSend ? TDOA_FRAME_HAS_SEND : 0)
+                 | ((f->variance > 0.0f) ? TDOA_FRAME_HAS_VARIANCE : 0);
+        rec += recSize;
+    }
+
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_V2_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, size - 2));
+}
+
+// Returns the number of bytes written, TDOA_TELEMETRY_FRAME_SIZE(telemetry->anchors)
+static inline size_t tdoa_telemetry_frame_encode(uint8_t *msg, const tdoa_telemetry_t *t)
+{
+    const uint32_t counters[TDOA_TELEMETRY_COUNTERS] = {t->rxGood, t->rxTimeouts, t->rxErrors, t->ringDrops,
+                                                        t->rxOverruns, t->clockRejects, t->isrMinCycles, t->isrMaxCycles,
+                                                        t->nlosDrops};
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_TELEMETRY_FRAME_SYNC;
+    msg[TDOA_TELEMETRY_FRAME_ANCHORS_BYTE] = t->anchors;
+    tdoa_put_be(&msg[TDOA_TELEMETRY_FRAME_PERIOD_BYTE], t->periodMs, 2);
+    for (i = 0; i < TDOA_TELEMETRY_COUNTERS; i++) {
+        tdoa_put_be(&msg[TDOA_TELEMETRY_FRAME_COUNTERS_BYTE + 4*i], counters[i], 4);
+    }
+    msg[TDOA_TELEMETRY_FRAME_PROFILE_BYTE] = t->profile;
+    for (i = 0; i < t->anchors; i++) {
+        uint8_t *a = &msg[TDOA_TELEMETRY_FRAME_DATA_BYTE + TDOA_TELEMETRY_ANCHOR_SIZE*i];
+        const int32_t power = t->anchorPower[i];
+        const int32_t ratio = t->anchorFpRatio[i] / 16;
+
+        tdoa_put_be(a, t->anchorPackets[i], 2);
+        // 1/64 dBm to -0.5 dBm steps, above -0.5 dBm and below -127.5 dBm saturate
+        a[2] = (power == TDOA_TELEMETRY_NO_POWER) ? 0 : (uint8_t)((power >= -32) ? 1 : (power <= -255*32) ? 255 : -power / 32);
+        a[3] = (uint8_t)(int8_t)((ratio < -128) ? -128 : (ratio > 127) ? 127 : ratio);
+    }
+
+    const size_t csByte = TDOA_TELEMETRY_FRAME_DATA_BYTE + TDOA_TELEMETRY_ANCHOR_SIZE*t->anchors;
+    uint16_t cs = tdoa_fletcher16(msg, csByte);
+    msg[csByte]   = (uint8_t)(cs >> 8);
+    msg[csByte+1] = (uint8_t)(cs);
+    return csByte + 2;
+}
+
+// Same as tdoa_batch_frame_size, 0 if the anchor count is out of range
+static inline size_t tdoa_telemetry_frame_size(const uint8_t *msg)
+{
+    const uint8_t anchors = msg[TDOA_TELEMETRY_FRAME_ANCHORS_BYTE];
+    return (anchors > TDOA_MAX_ANCHORS) ? 0 : TDOA_TELEMETRY_FRAME_SIZE(anchors);
+}
+
+// Same contract as tdoa_batch_frame_decode
+static inline int tdoa_telemetry_frame_decode(const uint8_t *msg, tdoa_telemetry_t *t)
+{
+    const size_t size = tdoa_telemetry_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    uint32_t counters[TDOA_TELEMETRY_COUNTERS];
+    uint8_t i;
+
+    t->anchors = msg[TDOA_TELEMETRY_FRAME_ANCHORS_BYTE];
+    t->periodMs = (uint16_t)tdoa_get_be(&msg[TDOA_TELEMETRY_FRAME_PERIOD_BYTE], 2);
+    for (i = 0; i < TDOA_TELEMETRY_COUNTERS; i++) {
+        counters[i] = (uint32_t)tdoa_get_be(&msg[TDOA_TELEMETRY_FRAME_COUNTERS_BYTE + 4*i], 4);
+    }
+    t->rxGood = counters[0];
+    t->rxTimeouts = counters[1];
+    t->rxErrors = counters[2];
+    t->ringDrops = counters[3];
+    t->rxOverruns = counters[4];
+    t->clockRejects = counters[5];
+    t->isrMinCycles = counters[6];
+    t->isrMaxCycles = counters[7];
+    t->nlosDrops = counters[8];
+    t->profile = msg[TDOA_TELEMETRY_FRAME_PROFILE_BYTE];
+    memset(t->anchorPackets, 0, sizeof(t->anchorPackets));
+    memset(t->anchorFpRatio, 0, sizeof(t->anchorFpRatio));
+    for (i = 0; i < TDOA_MAX_ANCHORS; i++) {
+        t->anchorPower[i] = TDOA_TELEMETRY_NO_POWER;
+    }
+    for (i = 0; i < t->anchors; i++) {
+        const uint8_t *a = &msg[TDOA_TELEMETRY_FRAME_DATA_BYTE + TDOA_TELEMETRY_ANCHOR_SIZE*i];
+
+        t->anchorPackets[i] = (uint16_t)tdoa_get_be(a, 2);
+        if (a[2] != 0) {
+            t->anchorPower[i] = (int16_t)(-32 * a[2]);
+        }
+        t->anchorFpRatio[i] = (int16_t)(16 * (int8_t)a[3]);
+    }
+
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_TELEMETRY_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, size - 2));
+}
+
+static inline void tdoa_put_float(uint8_t *msg, float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    tdoa_put_be(msg, word, 4);
+}
+
+static inline float tdoa_get_float(const uint8_t *msg)
+{
+    const uint32_t word = (uint32_t)tdoa_get_be(msg, 4);
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+// Writes the checksum after size - 2 bytes of a variable length frame
+static inline size_t tdoa_frame_finish(uint8_t *msg, size_t size)
+{
+    uint16_t cs = tdoa_fletcher16(msg, size - 2);
+    msg[size-2] = (uint8_t)(cs >> 8);
+    msg[size-1] = (uint8_t)(cs);
+    return size;
+}
+
+static inline int tdoa_frame_checksum_ok(const uint8_t *msg, size_t size)
+{
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    return cs == tdoa_fletcher16(msg, size - 2);
+}
+
+static inline void tdoa_position_frame_encode(uint8_t *msg, const tdoa_position_t *p)
+{
+    int i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_POSITION_FRAME_SYNC;
+    msg[TDOA_POSITION_FRAME_SEQ_BYTE] = p->seq;
+    msg[TDOA_POSITION_FRAME_UPDATES_BYTE] = p->updates;
+    tdoa_put_be(&msg[TDOA_POSITION_FRAME_RX_BYTE], p->rxTime, 5);
+    for (i = 0; i < 3; i++) {
+        tdoa_put_float(&msg[TDOA_POSITION_FRAME_POS_BYTE + 4*i], p->pos[i]);
+        tdoa_put_float(&msg[TDOA_POSITION_FRAME_VEL_BYTE + 4*i], p->vel[i]);
+        tdoa_put_float(&msg[TDOA_POSITION_FRAME_VAR_BYTE + 4*i], p->var[i]);
+    }
+    tdoa_frame_finish(msg, TDOA_POSITION_FRAME_SIZE);
+}
+
+// Same contract as tdoa_frame_decode
+static inline int tdoa_position_frame_decode(const uint8_t *msg, tdoa_position_t *p)
+{
+    int i;
+
+    p->seq = msg[TDOA_POSITION_FRAME_SEQ_BYTE];
+    p->updates = msg[TDOA_POSITION_FRAME_UPDATES_BYTE];
+    p->rxTime = tdoa_get_be(&msg[TDOA_POSITION_FRAME_RX_BYTE], 5);
+    for (i = 0; i < 3; i++) {
+        p->pos[i] = tdoa_get_float(&msg[TDOA_POSITION_FRAME_POS_BYTE + 4*i]);
+        p->vel[i] = tdoa_get_float(&msg[TDOA_POSITION_FRAME_VEL_BYTE + 4*i]);
+        p->var[i] = tdoa_get_float(&msg[TDOA_POSITION_FRAME_VAR_BYTE + 4*i]);
+    }
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_POSITION_FRAME_SYNC) & tdoa_frame_checksum_ok(msg, TDOA_POSITION_FRAME_SIZE);
+}
+
+static inline void tdoa_sync_frame_encode(uint8_t *msg, const tdoa_sync_t *sync)
+{
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_SYNC_FRAME_SYNC;
+    msg[TDOA_SYNC_FRAME_SEQ_BYTE] = sync->seq;
+    tdoa_put_be(&msg[TDOA_SYNC_FRAME_TIME_BYTE], sync->sofTime, 5);
+    tdoa_frame_finish(msg, TDOA_SYNC_FRAME_SIZE);
+}
+
+// Same contract as tdoa_frame_decode
+static inline int tdoa_sync_frame_decode(const uint8_t *msg, tdoa_sync_t *sync)
+{
+    sync->seq = msg[TDOA_SYNC_FRAME_SEQ_BYTE];
+    sync->sofTime = tdoa_get_be(&msg[TDOA_SYNC_FRAME_TIME_BYTE], 5);
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_SYNC_FRAME_SYNC) & tdoa_frame_checksum_ok(msg, TDOA_SYNC_FRAME_SIZE);
+}
+
+// Returns the frame size, 0 without entries
+static inline size_t tdoa_ranges_frame_encode(uint8_t *msg, const tdoa_ranges_t *r)
+{
+    if ((r->count == 0) || (r->count > TDOA_MAX_ANCHORS - 1)) {
+        return 0;
+    }
+
+    uint8_t *entry = &msg[TDOA_RANGES_FRAME_DATA_BYTE];
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_RANGES_FRAME_SYNC;
+    msg[TDOA_RANGES_FRAME_AN_BYTE] = r->An;
+    msg[TDOA_RANGES_FRAME_SLOTS_BYTE] = r->slots;
+    msg[TDOA_RANGES_FRAME_COUNT_BYTE] = r->count;
+    for (i = 0; i < r->count; i++) {
+        entry[0] = r->Ar[i];
+        tdoa_put_be(&entry[1], r->tof[i], 2);
+        entry += 3;
+    }
+    return tdoa_frame_finish(msg, TDOA_RANGES_FRAME_SIZE(r->count));
+}
+
+// Same as tdoa_batch_frame_size
+static inline size_t tdoa_ranges_frame_size(const uint8_t *msg)
+{
+    const uint8_t count = msg[TDOA_RANGES_FRAME_COUNT_BYTE];
+    return ((count == 0) || (count > TDOA_MAX_ANCHORS - 1)) ? 0 : TDOA_RANGES_FRAME_SIZE(count);
+}
+
+// Same contract as tdoa_batch_frame_decode
+static inline int tdoa_ranges_frame_decode(const uint8_t *msg, tdoa_ranges_t *r)
+{
+    const size_t size = tdoa_ranges_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    const uint8_t *entry = &msg[TDOA_RANGES_FRAME_DATA_BYTE];
+    uint8_t i;
+
+    r->An = msg[TDOA_RANGES_FRAME_AN_BYTE];
+    r->slots = msg[TDOA_RANGES_FRAME_SLOTS_BYTE];
+    r->count = msg[TDOA_RANGES_FRAME_COUNT_BYTE];
+    for (i = 0; i < r->count; i++) {
+        r->Ar[i] = entry[0];
+        r->tof[i] = (uint16_t)tdoa_get_be(&entry[1], 2);
+        entry += 3;
+    }
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_RANGES_FRAME_SYNC) & tdoa_frame_checksum_ok(msg, size);
+}
+
+// Returns the frame size, 0 if the anchor count is out of range
+static inline size_t tdoa_anchor_frame_encode(uint8_t *msg, const tdoa_anchor_config_t *a)
+{
+    if ((a->count == 0) || (a->count > TDOA_MAX_ANCHORS)) {
+        return 0;
+    }
+
+    const size_t size = TDOA_ANCHOR_FRAME_SIZE(a->count);
+    int i, j;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_ANCHOR_FRAME_SYNC;
+    msg[TDOA_ANCHOR_FRAME_COUNT_BYTE] = a->count;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE] = (uint8_t)size;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE+1] = (uint8_t)(size >> 8);
+    msg[TDOA_ANCHOR_FRAME_CELL_BYTE] = a->cell;
+    for (i = 0; i < a->count; i++) {
+        for (j = 0; j < 3; j++) {
+            tdoa_put_float(&msg[TDOA_ANCHOR_FRAME_DATA_BYTE + 12*i + 4*j], a->pos[i][j]);
+        }
+    }
+    return tdoa_frame_finish(msg, size);
+}
+
+// Decodes len received bytes, nonzero only for a complete frame with a good checksum
+static inline int tdoa_anchor_frame_decode(const uint8_t *msg, size_t len, tdoa_anchor_config_t *a)
+{
+    if ((len < TDOA_ANCHOR_FRAME_SIZE(1)) || (msg[TDOA_FRAME_TYPE_BYTE] != TDOA_ANCHOR_FRAME_SYNC)) {
+        return 0;
+    }
+    const uint8_t count = msg[TDOA_ANCHOR_FRAME_COUNT_BYTE];
+    if ((count == 0) || (count > TDOA_MAX_ANCHORS) || (len != (size_t)TDOA_ANCHOR_FRAME_SIZE(count))
+        || !tdoa_frame_checksum_ok(msg, len)) {
+        return 0;
+    }
+
+    int i, j;
+    a->count = count;
+    a->cell = msg[TDOA_ANCHOR_FRAME_CELL_BYTE];
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < 3; j++) {
+            a->pos[i][j] = tdoa_get_float(&msg[TDOA_ANCHOR_FRAME_DATA_BYTE + 12*i + 4*j]);
+        }
+    }
+    return 1;
+}
+
+static inline size_t tdoa_model_frame_encode(uint8_t *msg, const tdoa_model_config_t *m)
+{
+    const float *fields[3] = {m->transition, m->covariance, m->noise};
+    int i, k;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_MODEL_FRAME_SYNC;
+    msg[1] = 0;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE] = TDOA_MODEL_FRAME_SIZE;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE+1] = 0;
+    for (k = 0; k < 3; k++) {
+        for (i = 0; i < TDOA_MODEL_STATES; i++) {
+            tdoa_put_float(&msg[TDOA_MODEL_FRAME_DATA_BYTE + 4*(k*TDOA_MODEL_STATES + i)], fields[k][i]);
+        }
+    }
+    tdoa_put_float(&msg[TDOA_MODEL_FRAME_CS_BYTE - 4], m->stdDev);
+    return tdoa_frame_finish(msg, TDOA_MODEL_FRAME_SIZE);
+}
+
+// Same contract as tdoa_anchor_frame_decode
+static inline int tdoa_model_frame_decode(const uint8_t *msg, size_t len, tdoa_model_config_t *m)
+{
+    if ((len != TDOA_MODEL_FRAME_SIZE) || (msg[TDOA_FRAME_TYPE_BYTE] != TDOA_MODEL_FRAME_SYNC)
+        || !tdoa_frame_checksum_ok(msg, len)) {
+        return 0;
+    }
+
+    float *fields[3] = {m->transition, m->covariance, m->noise};
+    int i, k;
+    for (k = 0; k < 3; k++) {
+        for (i = 0; i < TDOA_MODEL_STATES; i++) {
+            fields[k][i] = tdoa_get_float(&msg[TDOA_MODEL_FRAME_DATA_BYTE + 4*(k*TDOA_MODEL_STATES + i)]);
+        }
+    }
+    m->stdDev = tdoa_get_float(&msg[TDOA_MODEL_FRAME_CS_BYTE - 4]);
+    return 1;
+}
+
+static inline size_t tdoa_capture_frame_encode(uint8_t *msg, uint8_t action)
+{
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_CAPTURE_FRAME_SYNC;
+    msg[TDOA_CAPTURE_FRAME_ACTION_BYTE] = action;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE] = TDOA_CAPTURE_FRAME_SIZE;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE+1] = 0;
+    return tdoa_frame_finish(msg, TDOA_CAPTURE_FRAME_SIZE);
+}
+
+// Same contract as tdoa_anchor_frame_decode
+static inline int tdoa_capture_frame_decode(const uint8_t *msg, size_t len, uint8_t *action)
+{
+    if ((len != TDOA_CAPTURE_FRAME_SIZE) || (msg[TDOA_FRAME_TYPE_BYTE] != TDOA_CAPTURE_FRAME_SYNC)
+        || !tdoa_frame_checksum_ok(msg, len)) {
+        return 0;
+    }
+    *action = msg[TDOA_CAPTURE_FRAME_ACTION_BYTE];
+    return 1;
+}
+
+static inline size_t tdoa_output_frame_encode(uint8_t *msg, const tdoa_output_config_t *o)
+{
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_OUTPUT_FRAME_SYNC;
+    msg[TDOA_OUTPUT_FRAME_MODE_BYTE] = o->mode;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE] = TDOA_OUTPUT_FRAME_SIZE;
+    msg[TDOA_CONFIG_FRAME_SIZE_BYTE+1] = 0;
+    msg[TDOA_OUTPUT_FRAME_PACKETS_BYTE] = o->packets;
+    tdoa_put_float(&msg[TDOA_OUTPUT_FRAME_THRESHOLD_BYTE], o->threshold);
+    return tdoa_frame_finish(msg, TDOA_OUTPUT_FRAME_SIZE);
+}
+
+// Same contract as tdoa_anchor_frame_decode, an unknown mode fails as well
+static inline int tdoa_output_frame_decode(const uint8_t *msg, size_t len, tdoa_output_config_t *o)
+{
+    if ((len != TDOA_OUTPUT_FRAME_SIZE) || (msg[TDOA_FRAME_TYPE_BYTE] != TDOA_OUTPUT_FRAME_SYNC)
+        || (msg[TDOA_OUTPUT_FRAME_MODE_BYTE] >= TDOA_OUTPUT_MODES) || !tdoa_frame_checksum_ok(msg, len)) {
+        return 0;
+    }
+    o->mode = msg[TDOA_OUTPUT_FRAME_MODE_BYTE];
+    o->packets = msg[TDOA_OUTPUT_FRAME_PACKETS_BYTE];
+    o->threshold = tdoa_get_float(&msg[TDOA_OUTPUT_FRAME_THRESHOLD_BYTE]);
+    return 1;
+}
+
+// Returns the number of bytes written, TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(t->anchors)
+static inline size_t tdoa_anchor_telemetry_frame_encode(uint8_t *msg, const tdoa_anchor_telemetry_t *t)
+{
+    const uint32_t counters[TDOA_ANCHOR_TELEMETRY_COUNTERS] = {t->rxGood, t->rxTimeouts, t->rxErrors, t->txGood, t->lateTx,
+                                                               t->lateRx, t->syncMissed, t->syncLost, t->resyncs,
+                                                               t->watchdogResets, t->failovers, t->stateChanges,
+                                                               t->isrMinCycles, t->isrMaxCycles};
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_ANCHOR_TELEMETRY_FRAME_SYNC;
+    msg[TDOA_ANCHOR_TELEMETRY_FRAME_ANCHOR_BYTE] = t->anchor;
+    msg[TDOA_ANCHOR_TELEMETRY_FRAME_ANCHORS_BYTE] = t->anchors;
+    tdoa_put_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_PERIOD_BYTE], t->periodMs, 2);
+    msg[TDOA_ANCHOR_TELEMETRY_FRAME_STATE_BYTE] = t->state;
+    tdoa_put_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_ACTIVE_BYTE], t->active, 2);
+    for (i = 0; i < TDOA_ANCHOR_TELEMETRY_COUNTERS; i++) {
+        tdoa_put_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_COUNTERS_BYTE + 4*i], counters[i], 4);
+    }
+    for (i = 0; i < t->anchors; i++) {
+        tdoa_put_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_DATA_BYTE + 2*i], t->tof[i], 2);
+    }
+
+    const size_t csByte = TDOA_ANCHOR_TELEMETRY_FRAME_DATA_BYTE + 2*t->anchors;
+    uint16_t cs = tdoa_fletcher16(msg, csByte);
+    msg[csByte]   = (uint8_t)(cs >> 8);
+    msg[csByte+1] = (uint8_t)(cs);
+    return csByte + 2;
+}
+
+// Same as tdoa_batch_frame_size, 0 if the anchor count is out of range
+static inline size_t tdoa_anchor_telemetry_frame_size(const uint8_t *msg)
+{
+    const uint8_t anchors = msg[TDOA_ANCHOR_TELEMETRY_FRAME_ANCHORS_BYTE];
+    return (anchors > TDOA_MAX_ANCHORS) ? 0 : TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(anchors);
+}
+
+// Same contract as tdoa_batch_frame_decode
+static inline int tdoa_anchor_telemetry_frame_decode(const uint8_t *msg, tdoa_anchor_telemetry_t *t)
+{
+    const size_t size = tdoa_anchor_telemetry_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    if ((msg[TDOA_FRAME_TYPE_BYTE] != TDOA_ANCHOR_TELEMETRY_FRAME_SYNC) || (cs != tdoa_fletcher16(msg, size - 2))) {
+        return 0;
+    }
+
+    uint32_t counters[TDOA_ANCHOR_TELEMETRY_COUNTERS];
+    uint8_t i;
+
+    t->anchor = msg[TDOA_ANCHOR_TELEMETRY_FRAME_ANCHOR_BYTE];
+    t->anchors = msg[TDOA_ANCHOR_TELEMETRY_FRAME_ANCHORS_BYTE];
+    t->periodMs = (uint16_t)tdoa_get_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_PERIOD_BYTE], 2);
+    t->state = msg[TDOA_ANCHOR_TELEMETRY_FRAME_STATE_BYTE];
+    t->active = (uint16_t)tdoa_get_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_ACTIVE_BYTE], 2);
+    for (i = 0; i < TDOA_ANCHOR_TELEMETRY_COUNTERS; i++) {
+        counters[i] = (uint32_t)tdoa_get_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_COUNTERS_BYTE + 4*i], 4);
+    }
+    t->rxGood = counters[0];
+    t->rxTimeouts = counters[1];
+    t->rxErrors = counters[2];
+    t->txGood = counters[3];
+    t->lateTx = counters[4];
+    t->lateRx = counters[5];
+    t->syncMissed = counters[6];
+    t->syncLost = counters[7];
+    t->resyncs = counters[8];
+    t->watchdogResets = counters[9];
+    t->failovers = counters[10];
+    t->stateChanges = counters[11];
+    t->isrMinCycles = counters[12];
+    t->isrMaxCycles = counters[13];
+    memset(t->tof, 0, sizeof(t->tof));
+    for (i = 0; i < t->anchors; i++) {
+        t->tof[i] = (uint16_t)tdoa_get_be(&msg[TDOA_ANCHOR_TELEMETRY_FRAME_DATA_BYTE + 2*i], 2);
+    }
+    return 1;
+}
+
+// Packs count samples of TDOA_TRACE_SAMPLE, returns the frame size
+static inline size_t tdoa_trace_frame_encode(uint8_t *msg, const uint32_t *samples, uint8_t count, uint8_t lost)
+{
+    uint8_t i;
+
+    msg[TDOA_FRAME_TYPE_BYTE] = TDOA_TRACE_FRAME_SYNC;
+    msg[TDOA_TRACE_FRAME_COUNT_BYTE] = count;
+    msg[TDOA_TRACE_FRAME_LOST_BYTE] = lost;
+    for (i = 0; i < count; i++) {
+        tdoa_put_be(&msg[TDOA_TRACE_FRAME_DATA_BYTE + TDOA_TRACE_SAMPLE_SIZE*i], samples[i], TDOA_TRACE_SAMPLE_SIZE);
+    }
+
+    const size_t csByte = TDOA_TRACE_FRAME_DATA_BYTE + TDOA_TRACE_SAMPLE_SIZE*count;
+    uint16_t cs = tdoa_fletcher16(msg, csByte);
+    msg[csByte]   = (uint8_t)(cs >> 8);
+    msg[csByte+1] = (uint8_t)(cs);
+    return csByte + 2;
+}
+
+// Same as tdoa_batch_frame_size, 0 if the sample count is out of range
+static inline size_t tdoa_trace_frame_size(const uint8_t *msg)
+{
+    const uint8_t count = msg[TDOA_TRACE_FRAME_COUNT_BYTE];
+    return ((count == 0) || (count > TDOA_TRACE_FRAME_MAX_SAMPLES)) ? 0 : TDOA_TRACE_FRAME_SIZE(count);
+}
+
+// Checks a trace frame, the host only skips them (scripts/trace_histogram.py reads the samples)
+static inline int tdoa_trace_frame_valid(const uint8_t *msg)
+{
+    const size_t size = tdoa_trace_frame_size(msg);
+    if (size == 0) {
+        return 0;
+    }
+
+    uint16_t cs = (uint16_t)((msg[size-2] << 8) | msg[size-1]);
+    return (msg[TDOA_FRAME_TYPE_BYTE] == TDOA_TRACE_FRAME_SYNC) & (cs == tdoa_fletcher16(msg, size - 2));
+}
+
+#ifdef __cplusplus
+}
+
+// Compile-time description of the frame for the C++ side
+struct TDOAFrameLayout
+{
+    static constexpr uint8_t sync = TDOA_FRAME_SYNC;
+    static constexpr size_t size = TDOA_FRAME_SIZE;
+    static constexpr size_t ancrByte = TDOA_FRAME_ANCR_BYTE;
+    static constexpr size_t ancnByte = TDOA_FRAME_ANCN_BYTE;
+    static constexpr size_t dataByte = TDOA_FRAME_DATA_BYTE;
+    static constexpr size_t csByte = TDOA_FRAME_CS_BYTE;
+    static constexpr size_t payloadSize = csByte;
+};
+
+static_assert(TDOAFrameLayout::dataByte + sizeof(float) == TDOAFrameLayout::csByte, "TDOA frame payload must end at the checksum");
+static_assert(TDOAFrameLayout::csByte + sizeof(uint16_t) == TDOAFrameLayout::size, "TDOA frame checksum must end the frame");
+static_assert(TDOA_RAW_FRAME_TOF_BYTE + sizeof(uint16_t) == TDOA_RAW_FRAME_CS_BYTE, "TDOA raw frame payload must end at the checksum");
+static_assert(TDOA_RAW_FRAME_CS_BYTE + sizeof(uint16_t) == TDOA_RAW_FRAME_SIZE, "TDOA raw frame checksum must end the frame");
+static_assert(TDOA_STATUS_FRAME_CS_BYTE + sizeof(uint16_t) == TDOA_STATUS_FRAME_SIZE, "TDOA status frame checksum must end the frame");
+static_assert(TDOA_BATCH_FRAME_MAX_SIZE <= 64, "TDOA batch frame must fit one full-speed USB packet");
+static_assert(TDOA_BATCH_FRAME_SIZE(1) >= TDOA_FRAME_SIZE, "TDOA batch frame must not be shorter than a single frame");
+static_assert(TDOA_V2_FRAME_MAX_SIZE <= 256, "TDOA version 2 frame must fit the USB transmit buffer of the tag");
+static_assert(TDOA_V2_FRAME_SIZE(1) >= TDOA_FRAME_SIZE, "TDOA version 2 frame must not be shorter than a single frame");
+static_assert(TDOA_TELEMETRY_FRAME_MAX_SIZE <= 128, "TDOA telemetry frame must fit the USB transmit buffer of the tag");
+static_assert(TDOA_TELEMETRY_FRAME_SIZE(0) >= TDOA_FRAME_SIZE, "TDOA telemetry frame must not be shorter than a single frame");
+static_assert(TDOA_ANCHOR_TELEMETRY_FRAME_SIZE(0) >= TDOA_FRAME_SIZE, "TDOA anchor telemetry frame must not be shorter than a single frame");
+static_assert(TDOA_POSITION_FRAME_VAR_BYTE + 12 == TDOA_POSITION_FRAME_CS_BYTE, "TDOA position frame payload must end at the checksum");
+static_assert(TDOA_POSITION_FRAME_SIZE <= 128, "TDOA position frame must fit the USB transmit buffer of the tag");
+static_assert(TDOA_SYNC_FRAME_TIME_BYTE + 5 == TDOA_SYNC_FRAME_CS_BYTE, "TDOA sync frame payload must end at the checksum");
+static_assert(TDOA_SYNC_FRAME_CS_BYTE + sizeof(uint16_t) == TDOA_SYNC_FRAME_SIZE, "TDOA sync frame checksum must end the frame");
+static_assert(TDOA_SYNC_FRAME_SIZE >= TDOA_FRAME_SIZE, "TDOA sync frame must not be shorter than a single frame");
+static_assert(TDOA_ANCHOR_FRAME_MAX_SIZE <= 512, "TDOA anchor frame must fit the USB receive buffer of the tag");
+static_assert(TDOA_RANGES_FRAME_MAX_SIZE <= 128, "TDOA ranges frame must fit the USB transmit buffer of the tag");
+static_assert(TDOA_RANGES_FRAME_SIZE(1) >= TDOA_FRAME_SIZE, "TDOA ranges frame must not be shorter than a single frame");
+static_assert(TDOA_TRACE_FRAME_MAX_SIZE <= 128, "TDOA trace frame must fit the USB transmit buffer of the tag");
+static_assert(TDOA_TRACE_FRAME_SIZE(1) >= TDOA_FRAME_SIZE, "TDOA trace frame must not be shorter than a single frame");
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+/*************************************************
+ *
+ *  State the anchor (TREK_TDOA) and tag (TREK_TAG) firmware keep across a
+ *  watchdog or software reset, in RAM of the .noinit section (PORT_NOINIT).
+ *  Header-only, compiles as C99 and C++11.
+ *
+ *  The startup code neither copies nor clears .noinit, after a power cycle
+ *  it holds whatever the RAM came up with. A block is a header followed by
+ *  the state of one firmware: the magic tells the firmware apart, size the
+ *  layout of its build, and the Fletcher-16 over the state catches a block
+ *  that was only half written when the reset came. The firmware takes the
+ *  state only after a reset that kept the RAM (port_reset_cause).
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_RETAIN_H_
+#define _TDOA_RETAIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tdoa_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_RETAIN_ANCHOR_MAGIC    0x524E4341      // "ACNR"
+#define TDOA_RETAIN_TAG_MAGIC       0x52474154      // "TAGR"
+
+typedef struct tdoa_retain_header_s
+{
+    uint32_t magic;
+    uint16_t size;          // Bytes of the whole block, header included
+    uint16_t check;         // Fletcher-16 of the bytes after the header
+    uint32_t resets;        // Resets the block was taken over, the firmware counts them
+}tdoa_retain_header_t;
+
+static inline uint16_t tdoa_retain_checksum(const tdoa_retain_header_t *block, uint16_t size)
+{
+    return tdoa_fletcher16((const uint8_t *)block + sizeof(*block), size - sizeof(*block));
+}
+
+// Marks the state after the header as complete, called after every update of it
+static inline void tdoa_retain_seal(tdoa_retain_header_t *block, uint32_t magic, uint16_t size)
+{
+    block->magic = magic;
+    block->size = size;
+    block->check = tdoa_retain_checksum(block, size);
+}
+
+static inline int tdoa_retain_valid(const tdoa_retain_header_t *block, uint32_t magic, uint16_t size)
+{
+    return (block->magic == magic) && (block->size == size) && (block->check == tdoa_retain_checksum(block, size));
+}
+
+// Invalidates the block, the next reset starts cold
+static inline void tdoa_retain_clear(tdoa_retain_header_t *block)
+{
+    block->magic = 0;
+    block->resets = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+/*************************************************
+ *
+ *  DW1000 first path receive power estimate and range bias correction in
+ *  fixed point, shared by the tag (TREK_TAG) and anchor (TREK_TDOA) firmware.
+ *  Header-only, compiles as C99 and C++11.
+ *
+ *  Follows the user manual estimate 10*log10(C*2^17/N^2) - A with the
+ *  correction of Fig. 22 above -88 dBm, with the logarithm taken as an integer
+ *  log2. The bias tables are those of the manual converted to DW1000 ticks at
+ *  compile time, one per receiver bandwidth and PRF, so the firmware selects
+ *  its table once in tdoa_init.
+ *
+ *  The first path power 10*log10((F1^2+F2^2+F3^2)/N^2) - A of the same
+ *  section is within a few dB of the receive power when the direct path
+ *  dominates and well below it when the first path is attenuated, the
+ *  difference is a quality measure of the link. Per packet, a gap above
+ *  TDOA_NLOS_SUSPECT marks an attenuated first path and one above
+ *  TDOA_NLOS_LIKELY a blocked one, the arrival is then that of a reflection.
+ *
+ *  Changelog:
+ *      v0.3 - NLOS classes of the first path gap
+ *      v0.2 - First path power
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_RXPOWER_H_
+#define _TDOA_RXPOWER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_RX_POWER_SHIFT     6                   // Receive power in 1/64 dBm
+#define TDOA_RX_POWER_ONE       (1 << TDOA_RX_POWER_SHIFT)
+#define TDOA_RX_POWER_INVALID   INT16_MIN           // No CIR power or preamble count, no correction applied
+#define TDOA_RX_POWER_DBM(p)    ((float)(p) * (1.0f / TDOA_RX_POWER_ONE))
+
+#define TDOA_NLOS_SUSPECT       (6 * TDOA_RX_POWER_ONE)     // Receive above first path power, first path attenuated
+#define TDOA_NLOS_LIKELY        (10 * TDOA_RX_POWER_ONE)    // Receive above first path power, first path blocked
+
+#define TDOA_BIAS_STEPS         18                  // 2 dB steps from -61 dBm down to -95 dBm
+#define TDOA_BIAS_TOP           (-61 * TDOA_RX_POWER_ONE)
+#define TDOA_BIAS_STEP_SHIFT    (TDOA_RX_POWER_SHIFT + 1)
+#define TDOA_BIAS_FRAC_BITS     4                   // Bias tables in 1/16 ticks
+
+// Range bias in mm to 1/16 DW1000 ticks (213.139451293 ticks per m), rounded
+#define TDOA_BIAS_Q4(mm)        ((int16_t)((mm) * (0.213139451293 * (1 << TDOA_BIAS_FRAC_BITS)) + (((mm) < 0) ? -0.5 : 0.5)))
+
+typedef struct tdoa_rx_correction_s
+{
+    int16_t bias[TDOA_BIAS_STEPS];  // 1/16 ticks added to the timestamp, from -61 dBm in 2 dB steps
+    int16_t offset;                 // A of the power estimate, 1/64 dB
+    int16_t slope;                  // Fig. 22 correction factor above -88 dBm, Q12
+}tdoa_rx_correction_t;
+
+// Range bias of the user manual, negative below the zero point of each table
+static const tdoa_rx_correction_t TDOA_RX_CORRECTION_500_16 = {{
+    TDOA_BIAS_Q4(-198), TDOA_BIAS_Q4(-187), TDOA_BIAS_Q4(-179), TDOA_BIAS_Q4(-163), TDOA_BIAS_Q4(-143), TDOA_BIAS_Q4(-127),
+    TDOA_BIAS_Q4(-109), TDOA_BIAS_Q4(-84),  TDOA_BIAS_Q4(-59),  TDOA_BIAS_Q4(-31),  TDOA_BIAS_Q4(0),    TDOA_BIAS_Q4(36),
+    TDOA_BIAS_Q4(65),   TDOA_BIAS_Q4(84),   TDOA_BIAS_Q4(97),   TDOA_BIAS_Q4(106),  TDOA_BIAS_Q4(110),  TDOA_BIAS_Q4(112)},
+    7406, 9558};    // 115.72 dB, 2.3334
+
+static const tdoa_rx_correction_t TDOA_RX_CORRECTION_500_64 = {{
+    TDOA_BIAS_Q4(-110), TDOA_BIAS_Q4(-105), TDOA_BIAS_Q4(-100), TDOA_BIAS_Q4(-93),  TDOA_BIAS_Q4(-82),  TDOA_BIAS_Q4(-69),
+    TDOA_BIAS_Q4(-51),  TDOA_BIAS_Q4(-27),  TDOA_BIAS_Q4(0),    TDOA_BIAS_Q4(21),   TDOA_BIAS_Q4(35),   TDOA_BIAS_Q4(42),
+    TDOA_BIAS_Q4(49),   TDOA_BIAS_Q4(62),   TDOA_BIAS_Q4(71),   TDOA_BIAS_Q4(76),   TDOA_BIAS_Q4(81),   TDOA_BIAS_Q4(86)},
+    7791, 4779};    // 121.74 dB, 1.1667
+
+static const tdoa_rx_correction_t TDOA_RX_CORRECTION_900_16 = {{
+    TDOA_BIAS_Q4(-274), TDOA_BIAS_Q4(-244), TDOA_BIAS_Q4(-210), TDOA_BIAS_Q4(-176), TDOA_BIAS_Q4(-138), TDOA_BIAS_Q4(-94),
+    TDOA_BIAS_Q4(-50),  TDOA_BIAS_Q4(0),    TDOA_BIAS_Q4(42),   TDOA_BIAS_Q4(96),   TDOA_BIAS_Q4(158),  TDOA_BIAS_Q4(210),
+    TDOA_BIAS_Q4(254),  TDOA_BIAS_Q4(294),  TDOA_BIAS_Q4(320),  TDOA_BIAS_Q4(338),  TDOA_BIAS_Q4(356),  TDOA_BIAS_Q4(394)},
+    7406, 9558};
+
+static const tdoa_rx_correction_t TDOA_RX_CORRECTION_900_64 = {{
+    TDOA_BIAS_Q4(-294), TDOA_BIAS_Q4(-266), TDOA_BIAS_Q4(-234), TDOA_BIAS_Q4(-198), TDOA_BIAS_Q4(-150), TDOA_BIAS_Q4(-100),
+    TDOA_BIAS_Q4(-58),  TDOA_BIAS_Q4(0),    TDOA_BIAS_Q4(48),   TDOA_BIAS_Q4(90),   TDOA_BIAS_Q4(126),  TDOA_BIAS_Q4(152),
+    TDOA_BIAS_Q4(174),  TDOA_BIAS_Q4(196),  TDOA_BIAS_Q4(232),  TDOA_BIAS_Q4(244),  TDOA_BIAS_Q4(264),  TDOA_BIAS_Q4(284)},
+    7791, 4779};
+
+// Channels 4 and 7 use the 900 MHz receiver bandwidth
+static inline const tdoa_rx_correction_t *tdoa_rx_correction_select(uint8_t chan, int prf64)
+{
+    if ((chan == 4) || (chan == 7))
+    {
+        return prf64 ? &TDOA_RX_CORRECTION_900_64 : &TDOA_RX_CORRECTION_900_16;
+    }
+    return prf64 ? &TDOA_RX_CORRECTION_500_64 : &TDOA_RX_CORRECTION_500_16;
+}
+
+// log2(x) in Q16 for x > 0, mantissa interpolated in 1/32 octave steps (error below 2e-4)
+static inline int32_t tdoa_log2_q16(uint32_t x)
+{
+    static const int32_t LOG2_MANTISSA[33] = {
+            0,  2909,  5732,  8473, 11136, 13727, 16248, 18704,
+        21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+        38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207,
+        52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+        65536};
+
+    const int32_t msb = 31 - __builtin_clz(x);
+    const uint32_t norm = x << (31 - msb);          // Leading one at bit 31
+    const uint32_t idx = (norm >> 26) & 0x1F;
+    const int32_t frac = (int32_t)((norm >> 10) & 0xFFFF);
+    const int32_t lo = LOG2_MANTISSA[idx];
+
+    return (msb << 16) + lo + (((LOG2_MANTISSA[idx + 1] - lo) * frac) >> 16);
+}
+
+// Preamble accumulation count N, RX_FINFO bits 20..31
+static inline uint32_t tdoa_rx_preamble_count(const uint8_t *rxFrameInfo)
+{
+    return ((rxFrameInfo[2] >> 4) & 0x0F) | ((uint32_t)rxFrameInfo[3] << 4);
+}
+
+/*
+ * Receive power in 1/64 dBm from the CIR_PWR register and the preamble
+ * accumulation count, TDOA_RX_POWER_INVALID if either is zero.
+ */
+static inline int16_t tdoa_rx_power(const tdoa_rx_correction_t *c, uint16_t cirPower, const uint8_t *rxFrameInfo)
+{
+    const uint32_t N = tdoa_rx_preamble_count(rxFrameInfo);
+    if ((cirPower == 0) || (N == 0))
+    {
+        return TDOA_RX_POWER_INVALID;
+    }
+
+    // log2(C*2^17/N^2) times 10*log10(2) in 1/64 dB (192.659 * 2^16)
+    const int32_t log2q = tdoa_log2_q16(cirPower) + (17 << 16) - 2*tdoa_log2_q16(N);
+    int32_t power = (int32_t)(((int64_t)log2q * 12626046) >> 32) - c->offset;
+
+    if (power > -88 * TDOA_RX_POWER_ONE)
+    {
+        power += ((power + 88 * TDOA_RX_POWER_ONE) * c->slope) >> 12;
+    }
+    return (int16_t)power;
+}
+
+/*
+ * First path power in 1/64 dBm from FP_AMPL1..3 (RX_TIME and RX_FQUAL) and
+ * the preamble accumulation count, TDOA_RX_POWER_INVALID without either.
+ */
+static inline int16_t tdoa_fp_power(const tdoa_rx_correction_t *c, const uint16_t *fpAmpl, const uint8_t *rxFrameInfo)
+{
+    const uint32_t N = tdoa_rx_preamble_count(rxFrameInfo);
+    const uint64_t sum = (uint64_t)fpAmpl[0] * fpAmpl[0] + (uint64_t)fpAmpl[1] * fpAmpl[1] + (uint64_t)fpAmpl[2] * fpAmpl[2];
+    if ((sum == 0) || (N == 0))
+    {
+        return TDOA_RX_POWER_INVALID;
+    }
+
+    // The sum stays below 2^34, shifted into the 32 bits of tdoa_log2_q16
+    const int shift = (sum >> 32) ? 2 : 0;
+    const int32_t log2q = tdoa_log2_q16((uint32_t)(sum >> shift)) + (shift << 16) - 2*tdoa_log2_q16(N);
+    return (int16_t)((((int64_t)log2q * 12626046) >> 32) - c->offset);
+}
+
+// Receive power above first path power in 1/64 dB, 0 if either is TDOA_RX_POWER_INVALID
+static inline int16_t tdoa_fp_gap(int16_t rxPower, int16_t fpPower)
+{
+    if ((rxPower == TDOA_RX_POWER_INVALID) || (fpPower == TDOA_RX_POWER_INVALID))
+    {
+        return 0;
+    }
+    return (int16_t)(rxPower - fpPower);
+}
+
+// Range bias in DW1000 ticks for a power of tdoa_rx_power, interpolated between the 2 dB steps
+static inline int32_t tdoa_rx_bias(const tdoa_rx_correction_t *c, int16_t power)
+{
+    if (power == TDOA_RX_POWER_INVALID)
+    {
+        return 0;
+    }
+
+    const int32_t below = TDOA_BIAS_TOP - power;     // Distance below -61 dBm, 1/64 dB
+    int32_t bias;
+    if (below <= 0)
+    {
+        bias = c->bias[0];
+    }
+    else
+    {
+        const int32_t step = below >> TDOA_BIAS_STEP_SHIFT;
+        if (step >= TDOA_BIAS_STEPS - 1)
+        {
+            bias = c->bias[TDOA_BIAS_STEPS - 1];
+        }
+        else
+        {
+            const int32_t frac = below & ((1 << TDOA_BIAS_STEP_SHIFT) - 1);
+            bias = c->bias[step] + (((c->bias[step + 1] - c->bias[step]) * frac) >> TDOA_BIAS_STEP_SHIFT);
+        }
+    }
+    return (bias + (1 << (TDOA_BIAS_FRAC_BITS - 1))) >> TDOA_BIAS_FRAC_BITS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*************************************************
+ *
+ *  TDMA schedule limits and range packet layout, shared by the anchor
+ *  (TREK_TDOA) and tag (TREK_TAG) firmware and the host (decawave).
+ *  Header-only, compiles as C99 and C++11.
+ *
+ *  The master, the anchor in slot 0, owns the schedule. That is anchor 0
+ *  while it is up, otherwise the lowest address with a slot. Its range
+ *  packet carries the number of anchor addresses, the slot length and the
+ *  anchors that hold a slot, the other anchors adopt them when they
+ *  synchronize to the master and the tags read them from every packet. The
+ *  frame only has slots for the active anchors, in address order, so absent
+ *  anchors cost no airtime. The master drops an anchor nobody in the cell
+ *  heard for a while, and every few frames adds a join slot at the end of
+ *  the frame for one of the others, so an anchor that comes back gets its
+ *  slot again. Once nobody hears the master itself the other anchors drop
+ *  it the same way and the next address takes slot 0 (see tdoa_anc.c).
+ *
+ *  Range packet payload (little endian):
+ *      0   type (TDOA_RANGE_PACKET_TYPE)
+ *      1   idx, packet index of the master
+ *      2   anchors, addresses 0..anchors-1 of the schedule
+ *      3   slot length in TDOA_SLOT_UNIT ticks, 2 bytes
+ *      5   transmit time of the sender, low 32 bits of its clock
+ *      9   bitmap of the active anchors, 2 bytes
+ *      11  anchor of the join slot, TDOA_NO_JOIN for a frame without one
+ *      12  bitmap of the anchors with an entry, (anchors+7)/8 bytes
+ *          one entry per bit set, in anchor order:
+ *              receive time residual, 3 bytes signed
+ *              distance, 2 bytes
+ *
+ *  An entry holds the arrival time at the sender of the last packet of
+ *  anchor k, as the residual to the time that packet is expected at,
+ *  d = (slot of sender - slot of k) mod slots slots before the transmit time.
+ *  Only anchors heard in the last frame are sent, and never the sender
+ *  itself.
+ *
+ *  Cells: larger sites run several schedules side by side, one per cell of
+ *  up to TDOA_MAX_ANCHORS anchors, each with its own anchor 0. The frames of
+ *  cell c carry the PAN ID TDOA_CELL_PAN(c) and go out on the preamble code
+ *  and channel of tdoa_cell_radio, cells sharing both are also told apart
+ *  by the PAN ID. Tags report anchor c:k as TDOA_CELL_ID(c, k), so cell 0
+ *  keeps the plain anchor numbers.
+ *
+ *  Every range packet goes to the 64-bit address TDOA_RANGE_DEST_ADDRESS
+ *  with the PAN ID of its cell, so a receiver can leave other traffic to
+ *  the frame filter of the DW1000. TDOA_SITE_PAN moves the PAN IDs of all
+ *  cells away from other networks, tags and anchors have to agree on it.
+ *
+ *  Changelog:
+ *      v0.5 - Site PAN ID and the destination address of the range packets
+ *      v0.4 - Slots only for the active anchors, join slot
+ *      v0.3 - Cells with their own PAN ID, preamble code and channel
+ *      v0.2 - Receive times delta-encoded against the transmit time, entries only for valid slots
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_TDMA_H_
+#define _TDOA_TDMA_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_MAX_ANCHORS            16                  // Anchor addresses 0..15, at most one slot each per TDMA frame
+#define TDOA_MIN_ANCHORS            2
+
+#define TDOA_SLOT_UNIT_SHIFT        13                  // Slot length unit, 2^13 DW1000 ticks (~128 ns)
+#define TDOA_SLOT_UNIT              (1ULL << TDOA_SLOT_UNIT_SHIFT)
+#define TDOA_MIN_SLOT_UNITS         1024                // ~131 us
+#define TDOA_MAX_SLOT_UNITS         0xFFFF              // ~8.4 ms
+
+#define TDOA_RANGE_PACKET_TYPE      0x23                // 0x22 had a slot for every address, 0x21 full timestamps
+#define TDOA_RANGE_HEADER_SIZE      5                   // Type, idx and schedule
+#define TDOA_RANGE_TX_TIME_OFFSET   5
+#define TDOA_RANGE_ACTIVE_OFFSET    9
+#define TDOA_RANGE_JOIN_OFFSET      11
+#define TDOA_RANGE_BITMAP_OFFSET    12
+#define TDOA_NO_JOIN                0xFF
+#define TDOA_RANGE_ENTRY_SIZE       5
+#define TDOA_RANGE_RESIDUAL_MAX     0x7FFFFF            // Ticks (~131 us), later receive times are left out
+#define TDOA_RANGE_DEST_ADDRESS     { 0xFF, 0, 0, 0, 0, 0, 0xcf, 0xbc }    // 64-bit destination of range packets, in frame (little-endian) order
+
+#define TDOA_MAX_CELLS              8                   // 4 preamble codes times 2 channels at 64 MHz PRF
+#define TDOA_CELL_IDS               (TDOA_MAX_CELLS * TDOA_MAX_ANCHORS)
+#ifndef TDOA_SITE_PAN
+#define TDOA_SITE_PAN               0                   // PAN ID of cell 0, 0 keeps the one of the single schedule
+#endif
+#define TDOA_CELL_PAN(c)            ((uint16_t)(TDOA_SITE_PAN + (c)))
+#define TDOA_CELL_ID(c, k)          ((uint8_t)((c) * TDOA_MAX_ANCHORS + (k)))
+#define TDOA_CELL_OF(id)            ((id) / TDOA_MAX_ANCHORS)
+#define TDOA_CELL_ANCHOR(id)        ((id) % TDOA_MAX_ANCHORS)
+
+#define TDOA_RANGE_BITMAP_SIZE(n)           (((n) + 7) / 8)
+#define TDOA_RANGE_ENTRY_OFFSET(n, i)       (TDOA_RANGE_BITMAP_OFFSET + TDOA_RANGE_BITMAP_SIZE(n) + (i)*TDOA_RANGE_ENTRY_SIZE)
+#define TDOA_RANGE_PAYLOAD_SIZE(n, entries) TDOA_RANGE_ENTRY_OFFSET(n, entries)
+#define TDOA_RANGE_PAYLOAD_MAX_SIZE         TDOA_RANGE_PAYLOAD_SIZE(TDOA_MAX_ANCHORS, TDOA_MAX_ANCHORS - 1)
+
+// Schedule a master may announce
+static inline int tdoa_tdma_valid(uint8_t anchors, uint16_t slotUnits)
+{
+    return (anchors >= TDOA_MIN_ANCHORS) && (anchors <= TDOA_MAX_ANCHORS) && (slotUnits >= TDOA_MIN_SLOT_UNITS);
+}
+
+// Slots of a frame: one per active anchor, then the join slot if there is one
+static inline uint8_t tdoa_tdma_slots(uint16_t active, uint8_t join)
+{
+    return (uint8_t)(__builtin_popcount(active) + (join != TDOA_NO_JOIN));
+}
+
+// Slot of anchor k in the frame, tdoa_tdma_slots if it has none
+static inline uint8_t tdoa_tdma_slot_of(uint16_t active, uint8_t join, uint8_t k)
+{
+    if ((active >> k) & 1)
+    {
+        return (uint8_t)__builtin_popcount(active & ((1u << k) - 1));
+    }
+    return (k == join) ? (uint8_t)__builtin_popcount(active) : tdoa_tdma_slots(active, join);
+}
+
+// Anchor of slot s of the frame, TDOA_NO_JOIN past the last slot
+static inline uint8_t tdoa_tdma_anchor_of(uint16_t active, uint8_t join, uint8_t s)
+{
+    uint8_t k;
+
+    for (k = 0; k < TDOA_MAX_ANCHORS; k++)
+    {
+        if (((active >> k) & 1) && (s-- == 0))
+        {
+            return k;
+        }
+    }
+    return (s == 0) ? join : TDOA_NO_JOIN;
+}
+
+/*
+ * Channel and preamble code of cell c, from those of cell 0 (baseChan and
+ * the PRF of the configuration in use). Cells step through the preamble
+ * codes of the PRF first, then move from channel 2 to 5 or back, and repeat
+ * beyond that, so the same radio settings come back every 4 cells at
+ * 16 MHz PRF and every 8 at 64 MHz.
+ */
+static inline void tdoa_cell_radio(uint8_t c, uint8_t baseChan, int prf64, uint8_t *chan, uint8_t *code)
+{
+    static const uint8_t CODES_16M[] = {4, 3};
+    static const uint8_t CODES_64M[] = {9, 10, 11, 12};
+    const uint8_t ncodes = prf64 ? 4 : 2;
+    const int otherChan = ((c / ncodes) & 1) && ((baseChan == 2) || (baseChan == 5));
+
+    *code = prf64 ? CODES_64M[c % ncodes] : CODES_16M[c % ncodes];
+    *chan = otherChan ? (uint8_t)(7 - baseChan) : baseChan;
+}
+
+static inline int tdoa_range_has_entry(const uint8_t *bitmap, uint8_t k)
+{
+    return (bitmap[k >> 3] >> (k & 7)) & 1;
+}
+
+// Entries before the one of anchor k, or all entries for k = slots
+static inline uint8_t tdoa_range_entry_index(const uint8_t *bitmap, uint8_t k)
+{
+    const uint32_t bits = bitmap[0] | ((k > 8) ? ((uint32_t)bitmap[1] << 8) : 0);
+    return (uint8_t)__builtin_popcount(bits & ((1u << k) - 1));
+}
+
+/*
+ * Time the last packet of anchor k is expected at the sender, with both on
+ * the same TDMA schedule. sender and k are their slots (tdoa_tdma_slot_of),
+ * slots those of the frame.
+ */
+static inline uint32_t tdoa_range_expected_rx(uint32_t txTime, uint8_t sender, uint8_t k, uint8_t slots, uint16_t slotUnits)
+{
+    const uint32_t d = (uint32_t)(sender + slots - k) % slots;
+    return txTime - (uint32_t)(((uint64_t)d * slotUnits) << TDOA_SLOT_UNIT_SHIFT);
+}
+
+// Writes an entry, returns 0 if the receive time is too far from the expected one to fit
+static inline int tdoa_range_put_entry(uint8_t *entry, uint32_t rxTime, uint32_t expected, uint16_t distance)
+{
+    const int32_t residual = (int32_t)(rxTime - expected);
+    if ((residual > TDOA_RANGE_RESIDUAL_MAX) || (residual < -TDOA_RANGE_RESIDUAL_MAX))
+    {
+        return 0;
+    }
+    entry[0] = (uint8_t)residual;
+    entry[1] = (uint8_t)(residual >> 8);
+    entry[2] = (uint8_t)(residual >> 16);
+    entry[3] = (uint8_t)distance;
+    entry[4] = (uint8_t)(distance >> 8);
+    return 1;
+}
+
+static inline uint32_t tdoa_range_entry_rx(const uint8_t *entry, uint32_t expected)
+{
+    const uint32_t raw = entry[0] | ((uint32_t)entry[1] << 8) | ((uint32_t)entry[2] << 16);
+    return expected + (uint32_t)((int32_t)(raw << 8) >> 8);
+}
+
+static inline uint16_t tdoa_range_entry_distance(const uint8_t *entry)
+{
+    return (uint16_t)(entry[3] | (entry[4] << 8));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+/*************************************************
+ *
+ *  Wrap-safe DW1000 time arithmetic, shared by the tag (TREK_TAG) and anchor
+ *  (TREK_TDOA) firmware and the host (decawave). Header-only, compiles as C99
+ *  and C++11.
+ *
+ *  The DW1000 counts 40 bits at TDOA_TIMESTAMP_FREQ and wraps every ~17.2 s.
+ *  Timestamps of the local clock are kept as all 40 bits in a tdoa_time_t,
+ *  intervals between them as signed 64-bit ticks. The range packets only
+ *  carry the low 32 bits of the anchor clock, which wrap every ~67 ms, less
+ *  than the longest TDMA frame (16 slots of TDOA_MAX_SLOT_UNITS, ~134 ms). An
+ *  interval between two of those is unwrapped against an estimate of the same
+ *  interval from a 40-bit clock, any estimate within ~33 ms will do.
+ *
+ *  The time of flight between anchors and the delayed transmit time of a
+ *  slot are here as well, so all the timestamp math of the firmware builds
+ *  and runs on the host too.
+ *
+ *  Changelog:
+ *      v0.2 - Double-sided two-way ranging and delayed transmit time
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_TIME_H_
+#define _TDOA_TIME_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TDOA_TIME_BITS          40
+#define TDOA_TIME_MASK          0xFFFFFFFFFFULL     // DW1000 system time and timestamps
+#define TDOA_TIME_SHORT_MASK    0xFFFFFFFFULL       // Anchor timestamps in the range packet
+#define TDOA_TIME_TX_BITS       9                   // Low bits of a delayed transmit time the DW1000 ignores
+
+typedef uint64_t tdoa_time_t;                       // 40-bit DW1000 timestamp, upper bits ignored
+
+// a - b, correct across a wrap as long as the interval is shorter than 2^39 ticks (~8.6 s)
+static inline int64_t tdoa_time_sub(tdoa_time_t a, tdoa_time_t b)
+{
+    return (int64_t)(((a - b) & TDOA_TIME_MASK) << (64 - TDOA_TIME_BITS)) >> (64 - TDOA_TIME_BITS);
+}
+
+static inline tdoa_time_t tdoa_time_add(tdoa_time_t t, int64_t interval)
+{
+    return (t + (uint64_t)interval) & TDOA_TIME_MASK;
+}
+
+/*
+ * Interval from b to a, both low 32 bits of the same clock, as the one of all
+ * a - b + k*2^32 closest to estimate.
+ */
+static inline int64_t tdoa_time_unwrap32(uint32_t a, uint32_t b, int64_t estimate)
+{
+    const int64_t d = (int64_t)(uint32_t)(a - b);
+    const int64_t wraps = (estimate - d + (1LL << 31)) >> 32;
+    return d + wraps * (1LL << 32);
+}
+
+/*
+ * First time after t a delayed transmission can start at, a multiple of
+ * 2^TDOA_TIME_TX_BITS ticks. Rounds on all 40 bits, the carry out of the low
+ * 32 reaches the high byte.
+ */
+static inline tdoa_time_t tdoa_time_delayed_tx(tdoa_time_t t)
+{
+    return ((t | ((1ULL << TDOA_TIME_TX_BITS) - 1)) + 1) & TDOA_TIME_MASK;
+}
+
+/*
+ * Time of flight in 1/2^fracBits ticks of the asymmetric double-sided
+ * exchange: round 1 and reply 2 on one clock, reply 1 and round 2 on the
+ * other. The products are taken as unsigned 64-bit values, whose difference
+ * is exact modulo 2^64 and small, so they never overflow for any frame
+ * length. Returns 0 for a time of flight that is not positive or above
+ * maxTicks.
+ */
+static inline int tdoa_time_tof(int64_t tround1, int64_t treply1, int64_t tround2, int64_t treply2,
+                                int fracBits, int64_t maxTicks, int32_t *tof)
+{
+    const int64_t num = (int64_t)((uint64_t)tround1*(uint64_t)tround2 - (uint64_t)treply1*(uint64_t)treply2);
+    const int64_t den = 2*(treply1 + tround2);
+
+    if ((num <= 0) || (den <= 0) || (num / den > maxTicks))
+    {
+        return 0;
+    }
+    *tof = (int32_t)((num << fracBits) / den);
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
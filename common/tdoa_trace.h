@@ -0,0 +1,135 @@
+/*************************************************
+ *
+ *  Cycle count tracing of the DW1000 interrupt path, shared by the tag
+ *  (TREK_TAG) and anchor (TREK_TDOA) firmware. Header-only C99, include
+ *  after the CMSIS core header.
+ *
+ *  Compiled in with -DTDOA_TRACE=1 for every source of the firmware,
+ *  otherwise the probes expand to nothing. A TDOA_TRACE_ENTER and
+ *  TDOA_TRACE_EXIT pair stores one sample per call, the DWT cycle count
+ *  from entry to exit, in the RAM buffer tdoaTrace. The main loop drains it
+ *  into trace frames (common/tdoa_protocol.h), the tag over USB and the
+ *  anchor over USART2, and scripts/trace_histogram.py of the decawave
+ *  package turns them into per-probe histograms.
+ *
+ *  Samples include the time spent in interrupts that preempt the probed
+ *  function, so on the tag the probes of the main loop can show the DW1000
+ *  interrupt in their tail.
+ *
+ *  Changelog:
+ *      v0.1 - initial release
+ *
+ *************************************************/
+
+#ifndef _TDOA_TRACE_H_
+#define _TDOA_TRACE_H_
+
+#include <stdint.h>
+
+#include "tdoa_protocol.h"
+
+#ifndef TDOA_TRACE
+#define TDOA_TRACE              0
+#endif
+
+// Cortex-M3 DWT cycle counter, not part of the CMSIS V1.30 core header
+#define TDOA_DWT_CTRL           (*(volatile uint32_t *)0xE0001000)
+#define TDOA_DWT_CYCCNT         (*(volatile uint32_t *)0xE0001004)
+#define TDOA_DWT_CTRL_CYCCNTENA 0x00000001
+
+#define TDOA_TRACE_LEN          256                 // Samples in the buffer, power of two
+
+// Probe numbers, also in scripts/trace_histogram.py
+typedef enum
+{
+    TDOA_TRACE_DWT_ISR = 0,                         // DW1000 interrupt, dwt_isr or tdoa_isr
+    TDOA_TRACE_SLOT_STEP,                           // Anchor TDMA state machine
+    TDOA_TRACE_SET_TX_DATA,                         // Anchor range packet upload
+    TDOA_TRACE_CORRECT_TIMESTAMP,                   // Receive power and range bias correction
+    TDOA_TRACE_PROBES
+} tdoa_trace_probe_e;
+
+typedef struct tdoa_trace_s
+{
+    uint32_t samples[TDOA_TRACE_LEN];              // TDOA_TRACE_SAMPLE of probe and cycles
+    volatile uint16_t head;                         // Written by the probes
+    volatile uint16_t tail;                         // Written by tdoa_trace_frame
+    volatile uint8_t lost;                          // Samples dropped on a full buffer since the last frame
+} tdoa_trace_t;
+
+#if TDOA_TRACE
+
+// Defined by the firmware next to its DW1000 handlers
+extern tdoa_trace_t tdoaTrace;
+
+#define TDOA_TRACE_ENTER(probe)     const uint32_t tdoaTraceStart_##probe = TDOA_DWT_CYCCNT
+#define TDOA_TRACE_EXIT(probe)      tdoa_trace_add((probe), TDOA_DWT_CYCCNT - tdoaTraceStart_##probe)
+
+// Starts the cycle counter and empties the buffer
+static inline void tdoa_trace_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    TDOA_DWT_CYCCNT = 0;
+    TDOA_DWT_CTRL |= TDOA_DWT_CTRL_CYCCNTENA;
+    tdoaTrace.head = 0;
+    tdoaTrace.tail = 0;
+    tdoaTrace.lost = 0;
+}
+
+// Probes run in and out of interrupts, the short write is done with them masked
+static inline void tdoa_trace_add(uint8_t probe, uint32_t cycles)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint16_t head = tdoaTrace.head;
+    if ((uint16_t)(head - tdoaTrace.tail) < TDOA_TRACE_LEN)
+    {
+        tdoaTrace.samples[head & (TDOA_TRACE_LEN - 1)] = TDOA_TRACE_SAMPLE(probe, cycles);
+        tdoaTrace.head = head + 1;
+    }
+    else if (tdoaTrace.lost < 0xFF)
+    {
+        tdoaTrace.lost++;
+    }
+    __set_PRIMASK(primask);
+}
+
+/*
+ * Moves up to TDOA_TRACE_FRAME_MAX_SAMPLES samples into a trace frame of
+ * TDOA_TRACE_FRAME_MAX_SIZE bytes. Returns the frame size, 0 if the buffer
+ * is empty. Only called from the main loop.
+ */
+static inline size_t tdoa_trace_frame(uint8_t *msg)
+{
+    uint32_t samples[TDOA_TRACE_FRAME_MAX_SAMPLES];
+    uint16_t tail = tdoaTrace.tail;
+    uint16_t avail = (uint16_t)(tdoaTrace.head - tail);
+    uint8_t count = (avail > TDOA_TRACE_FRAME_MAX_SAMPLES) ? TDOA_TRACE_FRAME_MAX_SAMPLES : (uint8_t)avail;
+    uint8_t i;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        samples[i] = tdoaTrace.samples[(tail + i) & (TDOA_TRACE_LEN - 1)];
+    }
+
+    __disable_irq();
+    const uint8_t lost = tdoaTrace.lost;
+    tdoaTrace.lost = 0;
+    tdoaTrace.tail = tail + count;
+    __enable_irq();
+
+    return tdoa_trace_frame_encode(msg, samples, count, lost);
+}
+
+#else
+
+#define TDOA_TRACE_ENTER(probe)
+#define TDOA_TRACE_EXIT(probe)
+
+#endif
+
+#endif